@@ -20,7 +20,9 @@
 
 #include "ImageView.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include <QAction>
 #include <QBitmap>
@@ -78,9 +80,58 @@ namespace cove {
   Rectangle that is displayed when doing zoom-in operation.
 */
 
+/*! \var std::vector<QImage> ImageWidget::pyramid
+  Reduced copies of dispImage.  Level n is scaled by 2^-n, level 0 is unused.
+  \sa pyramidLevel
+*/
+
+/*! \var QCache<quint64, Tile> ImageWidget::tiles
+  Scaled pieces of the image for the current magnification.
+  \sa tile
+*/
+
+namespace {
+
+//! Size of the tiles in widget pixels.
+constexpr int tileSize = 256;
+
+//! Maximum number of pixels in the tile cache.
+constexpr int maxTilePixels = 8 * 1024 * 1024;
+
+//! Converts the colors of the image to gray.
+void grayOut(QImage& image)
+{
+	// image = image.convertToFormat(image.format(),
+	// Qt::MonoOnly|Qt::AvoidDither);
+	// Qt 4 workaround - MonoOnly doesn't work
+	if (image.depth() == 32)
+	{
+		int p = image.width() * image.height();
+		QRgb* b = reinterpret_cast<QRgb*>(image.bits());
+		while (p--)
+		{
+			int I = qGray(*b);
+			*b++ = qRgb(I, I, I);
+		}
+	}
+	else
+	{
+		QVector<QRgb> ct = image.colorTable();
+		for (auto& color : ct)
+		{
+			auto const gray = qGray(color);
+			color = qRgb(gray, gray, gray);
+		}
+		image.setColorTable(ct);
+	}
+}
+
+}  // namespace
+
 //! Default constructor.
 ImageWidget::ImageWidget(QWidget* parent)
 	: QWidget(parent)
+	, tiles(maxTilePixels)
 {}
 
 //! Destructor.
@@ -91,11 +142,19 @@ void ImageWidget::paintEvent(QPaintEvent* pe)
 {
 	if (!dispRealPaintEnabled) return;
 	QPainter p(this);
-	QRect r = pe->rect();
+	QRect r = pe->rect().intersected(rect());
 
 	// if there is an dispImage and is not a null dispImage draw it
-	if (dispImage && !dispImage->isNull())
+	if (dispImage && !dispImage->isNull() && !r.isEmpty())
 	{
+		// The image may have been modified since the tiles were made.
+		if (dispImage->cacheKey() != tilesImageKey)
+		{
+			pyramid.clear();
+			clearTiles();
+			tilesImageKey = dispImage->cacheKey();
+		}
+
 		// 1-bit deep dispImages are drawn in different way by painter.  Their
 		// native
 		// colors are ignored.
@@ -105,61 +164,13 @@ void ImageWidget::paintEvent(QPaintEvent* pe)
 			p.setPen(dispImage->color(1));
 		}
 
-		// adjust coordinates
-		int w = int(std::ceil(r.width() / dispMagnification)) + 1,
-			h = int(std::ceil(r.height() / dispMagnification)) + 1,
-			x = int(std::floor(r.x() / dispMagnification)),
-			y = int(std::floor(r.y() / dispMagnification));
-
-		// create cut of the original dispImage
-		// Workaround Qt4 bug in copy(QRect(...))
-		if (y + h > dispImage->height()) h = dispImage->height() - y;
-		QImage copy = dispImage->copy(QRect(x, y, w, h));
-
-		if (!copy.isNull())
+		for (int row = r.top() / tileSize; row <= r.bottom() / tileSize; ++row)
 		{
-			// Gray out the image when widget is disabled.
-			if (!isEnabled())
+			for (int column = r.left() / tileSize; column <= r.right() / tileSize; ++column)
 			{
-				// copy = copy.convertToFormat(copy.format(),
-				// Qt::MonoOnly|Qt::AvoidDither);
-				// Qt 4 workaround - MonoOnly doesn't work
-				if (copy.depth() == 32)
-				{
-					int p = copy.width() * copy.height();
-					QRgb* b = reinterpret_cast<QRgb*>(copy.bits());
-					while (p--)
-					{
-						int I = qGray(*b);
-						*b++ = qRgb(I, I, I);
-					}
-				}
-				else
-				{
-					QVector<QRgb> ct = copy.colorTable();
-					for (auto& color : ct)
-					{
-						auto const gray = qGray(color);
-						color = qRgb(gray, gray, gray);
-					}
-					copy.setColorTable(ct);
-				}
+				if (auto const* t = tile(column, row))
+					p.drawImage(t->pos, t->image);
 			}
-
-			// scale it
-			if (dispMagnification != 1)
-			{
-				copy = copy.scaled(int(w * dispMagnification),
-								   int(h * dispMagnification),
-								   Qt::IgnoreAspectRatio,
-								   scalingSmooth ? Qt::SmoothTransformation
-												 : Qt::FastTransformation);
-			}
-
-			// and draw the copy onto widget
-			p.drawImage(
-				QPoint(int(x * dispMagnification), int(y * dispMagnification)),
-				copy);
 		}
 	}
 
@@ -171,10 +182,98 @@ void ImageWidget::paintEvent(QPaintEvent* pe)
 	}
 }
 
+/*! Returns the tile at the given column and row of the widget.
+ *
+ * The tile is a cut of the pyramid level which is closest to the current
+ * magnification, scaled to the magnification.  The result is cached, so
+ * that scrolling and repainting does not scale the image again.
+ * Returns nullptr if the tile is outside the image.
+ */
+const ImageWidget::Tile* ImageWidget::tile(int column, int row)
+{
+	// Row, column and the enabled state
+	auto const key = (quint64(quint32(row)) << 32) | (quint64(quint32(column)) << 1) | quint64(isEnabled());
+	if (auto const* cached = tiles.object(key))
+		return cached;
+
+	int level = 0;
+	while (level < 16 && dispMagnification * (2 << level) <= 1)
+		++level;
+	auto const& source = pyramidLevel(level);
+	auto const factor = dispMagnification * (1 << level);
+
+	// adjust coordinates
+	auto const r = QRect(column * tileSize, row * tileSize, tileSize, tileSize).intersected(rect());
+	int w = int(std::ceil(r.width() / factor)) + 1,
+		h = int(std::ceil(r.height() / factor)) + 1,
+		x = int(std::floor(r.x() / factor)),
+		y = int(std::floor(r.y() / factor));
+
+	// create cut of the source image
+	// Workaround Qt4 bug in copy(QRect(...))
+	if (y + h > source.height()) h = source.height() - y;
+	QImage copy = source.copy(QRect(x, y, w, h));
+	if (copy.isNull())
+		return nullptr;
+
+	// Gray out the image when widget is disabled.
+	if (!isEnabled())
+		grayOut(copy);
+
+	// scale it
+	if (factor != 1)
+	{
+		copy = copy.scaled(std::max(1, int(w * factor)),
+		                   std::max(1, int(h * factor)),
+		                   Qt::IgnoreAspectRatio,
+		                   scalingSmooth ? Qt::SmoothTransformation
+		                                 : Qt::FastTransformation);
+	}
+
+	auto* t = new Tile { QPoint(int(x * factor), int(y * factor)), std::move(copy) };
+	auto const cost = t->image.width() * t->image.height();
+	if (!tiles.insert(key, t, cost))
+		return nullptr;
+	return tiles.object(key);
+}
+
+/*! Returns the image reduced by 2^-level.
+ *
+ * Levels are computed on demand, each from the previous level.
+ */
+const QImage& ImageWidget::pyramidLevel(int level)
+{
+	if (level == 0)
+		return *dispImage;
+
+	if (pyramid.size() <= std::size_t(level))
+		pyramid.resize(std::size_t(level) + 1);
+	auto& image = pyramid[std::size_t(level)];
+	if (image.isNull())
+	{
+		auto const& previous = pyramidLevel(level - 1);
+		image = previous.scaled(std::max(1, previous.width() / 2),
+		                        std::max(1, previous.height() / 2),
+		                        Qt::IgnoreAspectRatio,
+		                        scalingSmooth ? Qt::SmoothTransformation
+		                                      : Qt::FastTransformation);
+	}
+	return image;
+}
+
+//! Drops the cached tiles.
+void ImageWidget::clearTiles()
+{
+	tiles.clear();
+}
+
 //! What dispImage should be viewed.
 void ImageWidget::setImage(const QImage* im)
 {
 	dispImage = im;
+	pyramid.clear();
+	clearTiles();
+	tilesImageKey = im ? im->cacheKey() : 0;
 	setMagnification(magnification());
 	update();
 }
@@ -195,6 +294,8 @@ void ImageWidget::setMagnification(qreal mag)
 		setMinimumSize(w, h);
 		resize(w, h);
 	}
+	if (mag != dispMagnification)
+		clearTiles();
 	dispMagnification = mag;
 }
 
@@ -210,7 +311,12 @@ void ImageWidget::setSmoothScaling(bool ss)
 {
 	bool doupdate = scalingSmooth ^ ss;
 	scalingSmooth = ss;
-	if (doupdate) update();
+	if (doupdate)
+	{
+		pyramid.clear();
+		clearTiles();
+		update();
+	}
 }
 
 /*! \fn bool ImageWidget::smoothScaling() const
@@ -21,7 +21,11 @@
 #ifndef COVE_IMAGEVIEW_H
 #define COVE_IMAGEVIEW_H
 
+#include <vector>
+
 #include <QtGlobal>
+#include <QCache>
+#include <QImage>
 #include <QObject>
 #include <QPoint>
 #include <QRect>
@@ -29,7 +33,6 @@
 #include <QString>
 #include <QWidget>
 
-class QImage;
 class QMouseEvent;
 class QPaintEvent;
 class QWheelEvent;
@@ -67,11 +70,24 @@ protected:
 	void paintEvent(QPaintEvent* pe) override;
 
 private:
+	struct Tile
+	{
+		QPoint pos;
+		QImage image;
+	};
+
+	const Tile* tile(int column, int row);
+	const QImage& pyramidLevel(int level);
+	void clearTiles();
+
 	const QImage* dispImage = nullptr;
 	QRect drect = {0, 0, 0, 0};
 	qreal dispMagnification = 1;
 	bool scalingSmooth = false;
 	bool dispRealPaintEnabled = true;
+	std::vector<QImage> pyramid;
+	QCache<quint64, Tile> tiles;
+	qint64 tilesImageKey = 0;
 };
 
 
@@ -20,6 +20,8 @@
 
 #include "PolygonsView.h"
 
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 #include <Qt>
@@ -29,6 +31,7 @@
 #include <QPen>
 #include <QPoint>
 #include <QPointF>
+#include <QPolygonF>
 #include <QRect>
 #include <QRectF>
 #include <QSize>
@@ -49,8 +52,28 @@ namespace cove {
  * \brief ImageWidget drawing \a PolygonList above the image.
  *
  * Helper class for PolygonsView.
+ *
+ * The polygons are sorted into the cells of a grid, so that painting a
+ * part of the widget does not need to visit all polygons.  When zoomed out,
+ * vertices closer than one screen pixel are skipped, and vertex markers are
+ * omitted.
+ */
+
+/*! \var std::vector<std::vector<std::size_t>> PolyImageWidget::buckets
+ * The indices of the polygons which overlap each cell of the grid, row by
+ * row.  \sa buildBuckets
  */
 
+namespace {
+
+//! Size of the grid cells in image pixels.
+constexpr qreal bucketSize = 128;
+
+//! Minimum magnification for drawing vertex markers.
+constexpr qreal minMarkerMagnification = 0.5;
+
+}  // namespace
+
 PolyImageWidget::PolyImageWidget(QWidget* parent)
 	: ImageWidget(parent)
 {
@@ -72,9 +95,34 @@ const PolygonList& PolyImageWidget::polygons() const
 void PolyImageWidget::setPolygons(PolygonList p)
 {
 	polygonsList = std::move(p);
+	buildBuckets();
 	update();
 }
 
+/*! Sorts the polygons into the cells of the grid. */
+void PolyImageWidget::buildBuckets()
+{
+	buckets.clear();
+	bucketsRect = {};
+	for (auto const& polygon : polygonsList)
+		bucketsRect |= polygon.boundingRect().adjusted(0, 0, 1, 1);
+
+	bucketColumns = std::max(1, int(std::ceil(bucketsRect.width() / bucketSize)));
+	bucketRows = std::max(1, int(std::ceil(bucketsRect.height() / bucketSize)));
+	buckets.resize(std::size_t(bucketColumns) * std::size_t(bucketRows));
+	for (std::size_t i = 0; i < polygonsList.size(); ++i)
+	{
+		auto const bounds = polygonsList[i].boundingRect().translated(-bucketsRect.topLeft());
+		auto const right = std::min(bucketColumns - 1, int(bounds.right() / bucketSize));
+		auto const bottom = std::min(bucketRows - 1, int(bounds.bottom() / bucketSize));
+		for (int row = std::max(0, int(bounds.top() / bucketSize)); row <= bottom; ++row)
+		{
+			for (int column = std::max(0, int(bounds.left() / bucketSize)); column <= right; ++column)
+				buckets[std::size_t(row * bucketColumns + column)].push_back(i);
+		}
+	}
+}
+
 /*! paintEvent called by Qt engine, calls inherited ImageWidget::paintEvent and
  * then draws lines. */
 void PolyImageWidget::paintEvent(QPaintEvent* pe)
@@ -96,28 +144,71 @@ void PolyImageWidget::paintEvent(QPaintEvent* pe)
 	                             event_rect.width() / magnification() + marker.width(),
 	                             event_rect.height() / magnification() + marker.height());
 
+	// collect the polygons from the grid cells of the repainted area,
+	// in their original order
+	std::vector<std::size_t> candidates;
+	auto const cells = event_rectf.translated(-bucketsRect.topLeft());
+	auto const right = std::min(bucketColumns - 1, int(cells.right() / bucketSize));
+	auto const bottom = std::min(bucketRows - 1, int(cells.bottom() / bucketSize));
+	for (int row = std::max(0, int(cells.top() / bucketSize)); row <= bottom; ++row)
+	{
+		for (int column = std::max(0, int(cells.left() / bucketSize)); column <= right; ++column)
+		{
+			auto const& bucket = buckets[std::size_t(row * bucketColumns + column)];
+			candidates.insert(candidates.end(), bucket.begin(), bucket.end());
+		}
+	}
+	std::sort(begin(candidates), end(candidates));
+	candidates.erase(std::unique(begin(candidates), end(candidates)), end(candidates));
+
 	QPainter p(this);
 	p.translate(magnification() / 2, magnification() / 2);  // offset for aliased painting
 	p.scale(magnification(), magnification());
 
-	for (auto const& polygon : polygonsList)
+	// draw lines, skipping vertices closer than one screen pixel
+	auto const minDistance = 1 / magnification();
+	QPolygonF simplified;
+	p.setPen(pen);
+	p.setBrush(Qt::NoBrush);
+	for (auto i : candidates)
 	{
+		auto const& polygon = polygonsList[i];
 		// when polygon does not interfere with current repainted area, skip it
 		if (!event_rectf.intersects(polygon.boundingRect()))
 			continue;
 
-		// draw line
-		p.setPen(pen);
-		p.setBrush(Qt::NoBrush);
+		auto const* points = polygon.data();
+		auto count = int(polygon.size());
+		if (minDistance > 1 && count > 2)
+		{
+			simplified.clear();
+			simplified.append(polygon.front());
+			for (auto const& pt : polygon)
+			{
+				if ((pt - simplified.back()).manhattanLength() >= minDistance)
+					simplified.append(pt);
+			}
+			if (simplified.back() != polygon.back())
+				simplified.append(polygon.back());
+			points = simplified.constData();
+			count = simplified.size();
+		}
+
 		if (polygon.isClosed())
-			p.drawPolygon(polygon.data(), int(polygon.size()));
+			p.drawPolygon(points, count);
 		else
-			p.drawPolyline(polygon.data(), int(polygon.size()));
+			p.drawPolyline(points, count);
+	}
+
+	if (magnification() < minMarkerMagnification)
+		return;
 
-		// draw squares
-		p.setPen(Qt::NoPen);
-		p.setBrush(brush);
-		for (auto const& pt : polygon)
+	// draw squares
+	p.setPen(Qt::NoPen);
+	p.setBrush(brush);
+	for (auto i : candidates)
+	{
+		for (auto const& pt : polygonsList[i])
 		{
 			if (event_rectf.contains(pt))
 				p.drawRect(QRectF(pt + marker.topLeft(), marker.size()));
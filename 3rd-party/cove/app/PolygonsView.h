@@ -21,7 +21,11 @@
 #ifndef COVE_POLYGONSVIEW_H
 #define COVE_POLYGONSVIEW_H
 
+#include <cstddef>
+#include <vector>
+
 #include <QObject>
+#include <QRectF>
 #include <QString>
 
 #include "libvectorizer/Polygons.h"
@@ -54,7 +58,13 @@ protected:
 	void paintEvent(QPaintEvent* pe) override;
 
 private:
+	void buildBuckets();
+
 	PolygonList polygonsList;
+	std::vector<std::vector<std::size_t>> buckets;
+	QRectF bucketsRect;
+	int bucketColumns = 0;
+	int bucketRows = 0;
 };
 
 
@@ -1,6 +1,6 @@
 /*
  * Copyright (c) 2005-2020 Libor Pecháček.
- * Copyright 2020 Kai Pastor
+ * Copyright 2020, 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -215,12 +215,22 @@ void mainForm::loadImage(const QImage& imageToLoad, const QString& imageName)
 
 	// no alpha channel desired in the vectorized image
 	// we also want to have white background to mimic Mapper look and feel
-	imageBitmap = QImage(imageToLoad.size(), QImage::Format_RGB32);
-	imageBitmap.fill(Qt::white);
-	QPainter painter(&imageBitmap);
-	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-	painter.drawImage(0, 0, imageToLoad);
-	painter.end();
+	if (!imageToLoad.hasAlphaChannel())
+	{
+		// Opaque images need no background. For RGB32 templates, this shares
+		// the template's pixel data instead of holding another copy of a
+		// possibly huge scan.
+		imageBitmap = imageToLoad.convertToFormat(QImage::Format_RGB32);
+	}
+	else
+	{
+		imageBitmap = QImage(imageToLoad.size(), QImage::Format_RGB32);
+		imageBitmap.fill(Qt::white);
+		QPainter painter(&imageBitmap);
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		painter.drawImage(0, 0, imageToLoad);
+		painter.end();
+	}
 
 	afterLoadImage();
 }
@@ -277,6 +287,11 @@ QRgb mainForm::getColorFromImage(const QImage& image)
 void mainForm::on_runClassificationButton_clicked()
 {
 	ui.runClassificationButton->setEnabled(false);
+	// Release the previous classification before creating a new one, so that
+	// two classified images never exist at the same time.
+	clearColorsTab();
+	classifiedBitmap = {};
+	vectorizerApp.reset();
 	vectorizerApp = std::make_unique<Vectorizer>(imageBitmap);
 	UIProgressDialog progressDialog(tr("Colors classification in progress"),
 	                                tr("Cancel"), this);
@@ -749,15 +764,16 @@ void mainForm::on_saveVectorsButton_clicked()
 		if (polygon.isClosed())
 			newOOPolygon->closeAllParts();
 		newOOPolygon->setTag(QStringLiteral("generator"), QStringLiteral("cove")); /// \todo Configuration of tag
-		ooMap->addObject(newOOPolygon);
-		ooMap->addObjectToSelection(newOOPolygon, false);
 		result.push_back(newOOPolygon);
 	}
 
-	auto const* part = ooMap->getCurrentPart();
+	// Adding all objects at once lets the map update them concurrently.
+	auto const first_index = ooMap->addObjects(result);
+	ooMap->addObjectsToSelection(result, false);
+
 	auto* undo_step = new OpenOrienteering::DeleteObjectsUndoStep(ooMap);
-	for (auto const* object : result)
-		undo_step->addObject(part->findObjectIndex(object));
+	for (int i = 0; i < int(result.size()); ++i)
+		undo_step->addObject(first_index + i);
 	ooMap->push(undo_step);
 
 	ooMap->setObjectsDirty();
@@ -827,10 +843,7 @@ void mainForm::on_applyFIRFilterPushButton_clicked()
 
 	UIProgressDialog progressDialog(tr("Applying FIR Filter on image"),
 	                                tr("Cancel"), this);
-	auto functor = [&f](const QImage& source_image, ProgressObserver& progress_observer) -> QImage {
-		return f.apply(source_image, qRgb(127, 127, 127), &progress_observer);
-	};
-	QImage newImageBitmap = Concurrency::process<QImage>(&progressDialog, functor, imageBitmap);
+	QImage newImageBitmap = f.apply(imageBitmap, qRgb(127, 127, 127), &progressDialog);
 	if (!newImageBitmap.isNull()) imageBitmap = newImageBitmap;
 	ui.imageView->setImage(&imageBitmap);
 }
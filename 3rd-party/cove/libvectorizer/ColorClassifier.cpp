@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 Kai Pastor
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ColorClassifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QtGlobal>
+
+#include "MapColor.h"
+
+namespace cove {
+
+namespace {
+
+/**
+ * The number of distances which are computed in one loop.
+ *
+ * The distance loop has no dependencies between iterations, so it can be
+ * vectorized. The search for the minimum follows in a separate loop.
+ */
+constexpr std::size_t block_size = 16;
+
+}  // namespace
+
+
+// ### ColorClassifier::Moments ###
+
+ColorClassifier::Moments::Moments(std::size_t size)
+	: sum1(size)
+	, sum2(size)
+	, sum3(size)
+	, counts(size)
+{
+}
+
+ColorClassifier::Moments& ColorClassifier::Moments::operator+=(const Moments& other)
+{
+	if (counts.empty())
+	{
+		*this = other;
+		return *this;
+	}
+
+	Q_ASSERT(counts.size() == other.counts.size());
+	for (std::size_t i = 0; i < counts.size(); ++i)
+	{
+		sum1[i] += other.sum1[i];
+		sum2[i] += other.sum2[i];
+		sum3[i] += other.sum3[i];
+		counts[i] += other.counts[i];
+	}
+	quality += other.quality;
+	changes += other.changes;
+	return *this;
+}
+
+
+// ### ColorClassifier ###
+
+ColorClassifier::ColorClassifier(const std::vector<std::shared_ptr<MapColor>>& classes)
+	: p(classes.empty() ? 2 : classes.front()->p)
+{
+	x1.reserve(classes.size());
+	x2.reserve(classes.size());
+	x3.reserve(classes.size());
+	for (auto const& color : classes)
+	{
+		Q_ASSERT(color->p == p);
+		x1.push_back(color->x1);
+		x2.push_back(color->x2);
+		x3.push_back(color->x3);
+	}
+
+	if (p == 1)
+		metric = Hamming;
+	else if (p == 2)
+		metric = Euclidean;
+	else if (std::isinf(p))
+		metric = Chebyshev;
+	else
+		metric = Minkowski;
+}
+
+int ColorClassifier::findClosest(const MapColor& color) const
+{
+	// For Euclidean and Minkowski metrics, the final root is omitted.
+	// It does not change the order of distances.
+	switch (metric)
+	{
+	case Hamming:
+		return findClosest(color, [](double d1, double d2, double d3) {
+			return std::abs(d1) + std::abs(d2) + std::abs(d3);
+		});
+	case Euclidean:
+		return findClosest(color, [](double d1, double d2, double d3) {
+			return d1 * d1 + d2 * d2 + d3 * d3;
+		});
+	case Chebyshev:
+		return findClosest(color, [](double d1, double d2, double d3) {
+			return std::max(std::abs(d1), std::max(std::abs(d2), std::abs(d3)));
+		});
+	case Minkowski:
+		break;
+	}
+	auto const p = this->p;
+	return findClosest(color, [p](double d1, double d2, double d3) {
+		return std::pow(std::abs(d1), p) + std::pow(std::abs(d2), p) + std::pow(std::abs(d3), p);
+	});
+}
+
+template <class Distance>
+int ColorClassifier::findClosest(const MapColor& color, Distance distance) const
+{
+	auto const y1 = color.x1;
+	auto const y2 = color.x2;
+	auto const y3 = color.x3;
+
+	double distances[block_size];
+	int best_index = 0;
+	auto best_distance = std::numeric_limits<double>::infinity();
+	for (std::size_t first = 0; first < size(); first += block_size)
+	{
+		auto const count = std::min(block_size, size() - first);
+		auto const* c1 = x1.data() + first;
+		auto const* c2 = x2.data() + first;
+		auto const* c3 = x3.data() + first;
+		for (std::size_t i = 0; i < count; ++i)
+			distances[i] = distance(c1[i] - y1, c2[i] - y2, c3[i] - y3);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (distances[i] < best_distance)
+			{
+				best_distance = distances[i];
+				best_index = int(first + i);
+			}
+		}
+	}
+	return best_index;
+}
+
+double ColorClassifier::squares(const MapColor& color, int index) const
+{
+	auto const i = std::size_t(index);
+	auto const d1 = x1[i] - color.x1;
+	auto const d2 = x2[i] - color.x2;
+	auto const d3 = x3[i] - color.x3;
+	return d1 * d1 + d2 * d2 + d3 * d3;
+}
+
+void ColorClassifier::accumulate(const MapColor& color, int index, Moments& moments) const
+{
+	auto const i = std::size_t(index);
+	moments.sum1[i] += color.x1;
+	moments.sum2[i] += color.x2;
+	moments.sum3[i] += color.x3;
+	++moments.counts[i];
+	moments.quality += squares(color, index);
+}
+
+void ColorClassifier::setMeans(const Moments& moments)
+{
+	Q_ASSERT(moments.counts.size() == size());
+	for (std::size_t i = 0; i < size(); ++i)
+	{
+		auto const factor = moments.counts[i] ? 1.0 / moments.counts[i] : 0.0;
+		x1[i] = moments.sum1[i] * factor;
+		x2[i] = moments.sum2[i] * factor;
+		x3[i] = moments.sum3[i] * factor;
+	}
+}
+
+void ColorClassifier::assignTo(const std::vector<std::shared_ptr<MapColor>>& classes) const
+{
+	Q_ASSERT(classes.size() == size());
+	for (std::size_t i = 0; i < size(); ++i)
+	{
+		classes[i]->x1 = x1[i];
+		classes[i]->x2 = x2[i];
+		classes[i]->x3 = x3[i];
+	}
+}
+
+} // cove
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Kai Pastor
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COVE_COLORCLASSIFIER_H
+#define COVE_COLORCLASSIFIER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace cove {
+
+class MapColor;
+
+/**
+ * A classifier which finds the closest class moment for colors.
+ *
+ * This is a fast alternative to KohonenMap::findClosest() for MapColor
+ * classes. The coordinates of the moments are stored in separate arrays,
+ * and the metric is selected once for all colors. So the distances to all
+ * moments are computed in simple loops without virtual function calls,
+ * which the compiler can vectorize for the target's SIMD instruction set.
+ *
+ * The classifier is not modified by classification, so a single instance
+ * can be used from multiple threads.
+ */
+class ColorClassifier
+{
+public:
+	/**
+	 * Class statistics collected during a pass of batch learning.
+	 *
+	 * Results from concurrent passes over parts of an image are combined
+	 * by operator+=().
+	 */
+	struct Moments
+	{
+		std::vector<double> sum1;      // NOLINT
+		std::vector<double> sum2;      // NOLINT
+		std::vector<double> sum3;      // NOLINT
+		std::vector<unsigned> counts;  // NOLINT
+		double quality = 0;            // NOLINT
+		long long changes = 0;         // NOLINT
+
+		Moments() = default;
+		explicit Moments(std::size_t size);
+
+		Moments& operator+=(const Moments& other);
+	};
+
+	/**
+	 * Constructs a classifier for the given class moments.
+	 *
+	 * All classes must use the same metric.
+	 */
+	explicit ColorClassifier(const std::vector<std::shared_ptr<MapColor>>& classes);
+
+	/** Returns the number of classes. */
+	std::size_t size() const noexcept { return x1.size(); }
+
+	/**
+	 * Returns the index of the closest class for the given color.
+	 *
+	 * Like KohonenMap::findClosest(), this returns the lowest index
+	 * among classes at the same distance.
+	 */
+	int findClosest(const MapColor& color) const;
+
+	/**
+	 * Returns the sum of squares of the coordinate differences between
+	 * the color and the class with the given index.
+	 */
+	double squares(const MapColor& color, int index) const;
+
+	/**
+	 * Adds the color to the statistics of the class with the given index.
+	 */
+	void accumulate(const MapColor& color, int index, Moments& moments) const;
+
+	/**
+	 * Sets the class moments to the mean values of the collected statistics.
+	 *
+	 * Classes without any colors are set to the origin, as in
+	 * KohonenMap::performBatchLearning().
+	 */
+	void setMeans(const Moments& moments);
+
+	/**
+	 * Copies the class moments to the given colors.
+	 */
+	void assignTo(const std::vector<std::shared_ptr<MapColor>>& classes) const;
+
+private:
+	enum Metric
+	{
+		Hamming,
+		Euclidean,
+		Chebyshev,
+		Minkowski
+	};
+
+	template <class Distance>
+	int findClosest(const MapColor& color, Distance distance) const;
+
+	std::vector<double> x1;
+	std::vector<double> x2;
+	std::vector<double> x3;
+	double p;
+	Metric metric;
+};
+
+} // cove
+
+#endif
@@ -1,5 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
+ * Copyright 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -19,14 +20,194 @@
 
 #include "FIRFilter.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <vector>
 
+#include <QtGlobal>
 #include <QImage>
 
+#include "Concurrency.h"
 #include "MapColor.h"
+#include "ParallelImageProcessing.h"
 #include "ProgressObserver.h"
 
 namespace cove {
+
+namespace {
+
+/**
+ * Applies a separable filter to horizontal stripes of an image.
+ *
+ * Each line of the source stripe is filtered horizontally into a buffer with
+ * separate planes for red, green and blue, and the output lines are filtered
+ * vertically from this buffer. All inner loops run over plain float arrays
+ * of a single channel, so that the compiler can vectorize them.
+ *
+ * The box filter uses running sums of the unnormalized pixel values. These
+ * sums are integers, and they are exact in float for all practical radii.
+ */
+class SeparableFilterMapper
+{
+	const std::vector<float>& kernel;
+	bool box;
+	QRgb outOfBoundsColor;
+
+public:
+	SeparableFilterMapper(const std::vector<float>& kernel, bool box, QRgb outOfBoundsColor)
+	    : kernel(kernel)
+	    , box(box)
+	    , outOfBoundsColor(outOfBoundsColor)
+	{}
+
+	int halo() const
+	{
+		return int(kernel.size() / 2);
+	}
+
+	void operator()(const QImage& source, int offset, QImage& output, ProgressObserver& progressObserver) const
+	{
+		auto const width = output.width();
+		auto const height = output.height();
+		auto const halo = this->halo();
+		auto const dimension = int(kernel.size());
+		auto const rows = height + 2 * halo;
+
+		auto const out_of_bounds = std::vector<float>{
+		    float(qRed(outOfBoundsColor)),
+		    float(qGreen(outOfBoundsColor)),
+		    float(qBlue(outOfBoundsColor)) };
+
+		// Horizontal pass
+		std::vector<float> padded[3];
+		std::vector<float> planes[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			padded[c].assign(std::size_t(width + 2 * halo), out_of_bounds[std::size_t(c)]);
+			planes[c].resize(std::size_t(rows) * std::size_t(width));
+		}
+		for (int row = 0; row < rows; ++row)
+		{
+			auto const y = row + offset - halo;
+			if (y < 0 || y >= source.height())
+			{
+				// Out-of-bounds lines are constant.
+				for (int c = 0; c < 3; ++c)
+				{
+					std::fill(padded[c].begin() + halo, padded[c].end() - halo, out_of_bounds[std::size_t(c)]);
+					filterLine(padded[c].data(), planes[c].data() + std::size_t(row) * std::size_t(width), width);
+				}
+				continue;
+			}
+
+			auto const* line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+			auto* red = padded[0].data() + halo;
+			auto* green = padded[1].data() + halo;
+			auto* blue = padded[2].data() + halo;
+			for (int x = 0; x < width; ++x)
+			{
+				red[x] = float(qRed(line[x]));
+				green[x] = float(qGreen(line[x]));
+				blue[x] = float(qBlue(line[x]));
+			}
+			for (int c = 0; c < 3; ++c)
+				filterLine(padded[c].data(), planes[c].data() + std::size_t(row) * std::size_t(width), width);
+		}
+
+		// Vertical pass
+		auto const scale = box ? 1.0f / float(dimension * dimension) : 1.0f;
+		std::vector<float> sums[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			sums[c].assign(std::size_t(width), 0.0f);
+			if (box)
+			{
+				for (int row = 0; row < dimension - 1; ++row)
+					addLine(planes[c], row, 1.0f, sums[c]);
+			}
+		}
+		for (int y = 0; y < height; ++y)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				if (box)
+				{
+					addLine(planes[c], y + dimension - 1, 1.0f, sums[c]);
+				}
+				else
+				{
+					std::fill(sums[c].begin(), sums[c].end(), 0.0f);
+					for (int j = 0; j < dimension; ++j)
+						addLine(planes[c], y + j, kernel[std::size_t(j)], sums[c]);
+				}
+			}
+
+			auto* line = reinterpret_cast<QRgb*>(output.scanLine(y));
+			for (int x = 0; x < width; ++x)
+			{
+				auto const i = std::size_t(x);
+				line[x] = qRgb(qBound(0, qRound(sums[0][i] * scale), 255),
+				               qBound(0, qRound(sums[1][i] * scale), 255),
+				               qBound(0, qRound(sums[2][i] * scale), 255));
+			}
+
+			if (box)
+			{
+				for (int c = 0; c < 3; ++c)
+					addLine(planes[c], y, -1.0f, sums[c]);
+			}
+
+			progressObserver.setPercentage((100 * y) / height);
+			if (progressObserver.isInterruptionRequested())
+				break;
+		}
+	}
+
+	using concurrent_processing = OverlappingHorizontalStripes;
+
+private:
+	/// Filters a padded input line of width + kernel.size() - 1 values.
+	void filterLine(const float* input, float* output, int width) const
+	{
+		auto const dimension = int(kernel.size());
+		if (box)
+		{
+			auto sum = 0.0f;
+			for (int i = 0; i < dimension - 1; ++i)
+				sum += input[i];
+			for (int x = 0; x < width; ++x)
+			{
+				sum += input[x + dimension - 1];
+				output[x] = sum;
+				sum -= input[x];
+			}
+			return;
+		}
+
+		std::fill(output, output + width, 0.0f);
+		for (int i = 0; i < dimension; ++i)
+		{
+			auto const k = kernel[std::size_t(i)];
+			auto const* in = input + i;
+			for (int x = 0; x < width; ++x)
+				output[x] += k * in[x];
+		}
+	}
+
+	/// Adds a line of the plane, multiplied by the given factor, to the sums.
+	static void addLine(const std::vector<float>& plane, int row, float factor, std::vector<float>& sums)
+	{
+		auto const width = sums.size();
+		auto const* line = plane.data() + std::size_t(row) * width;
+		auto* sum = sums.data();
+		for (std::size_t x = 0; x < width; ++x)
+			sum[x] += factor * line[x];
+	}
+};
+
+}  // namespace
+
 //@{
 //! \ingroup libvectorizer
 
@@ -77,6 +258,15 @@ FIRFilter& FIRFilter::binomic()
 			matrix[0][i] = temprow[i] + temprow[i + 1];
 	}
 
+	// the matrix is the outer product of the normalized coefficients
+	double sum = 0;
+	for (unsigned i = 0; i < dimension; i++)
+		sum += matrix[0][i];
+	kernel.resize(dimension);
+	for (unsigned i = 0; i < dimension; i++)
+		kernel[i] = float(matrix[0][i] / sum);
+	is_box = false;
+
 	// create other elements
 	double divisor = 0;
 	for (unsigned i = 0; i < dimension; i++)
@@ -104,6 +294,9 @@ FIRFilter& FIRFilter::box()
 		for (unsigned j = 0; j < dimension; j++)
 			matrix[i][j] = q;
 
+	kernel.assign(dimension, 1.0f);
+	is_box = true;
+
 	return *this;
 }
 
@@ -114,12 +307,16 @@ FIRFilter& FIRFilter::a(double /*center*/)
 }
 
 /*! Applies this FIR filter onto image and returns transformed image.
+  Binomic and box filters are applied by applySeparable().
   \param[in] source Source image.
   \param[in] outOfBoundsColor Color that has the out-of-bounds area.
   \param[in] progressObserver Progress observer.  */
 QImage FIRFilter::apply(const QImage& source, QRgb outOfBoundsColor,
 						ProgressObserver* progressObserver)
 {
+	if (!kernel.empty())
+		return applySeparable(source, outOfBoundsColor, progressObserver);
+
 	int imwidth = source.width(), imheight = source.height();
 	bool cancel = false;
 	int progressHowOften = (imheight > 100) ? imheight / 75 : 1;
@@ -154,6 +351,26 @@ QImage FIRFilter::apply(const QImage& source, QRgb outOfBoundsColor,
 	}
 	return cancel ? QImage() : retimage;
 }
+
+/*! Applies this separable FIR filter onto image and returns transformed image.
+  The filter is applied in a horizontal and a vertical pass, concurrently on
+  overlapping horizontal stripes of the image.
+  \param[in] source Source image.
+  \param[in] outOfBoundsColor Color that has the out-of-bounds area.
+  \param[in] progressObserver Progress observer.  */
+QImage FIRFilter::applySeparable(const QImage& source, QRgb outOfBoundsColor,
+                                 ProgressObserver* progressObserver) const
+{
+	auto const image = source.convertToFormat(QImage::Format_RGB32);
+	QImage retimage(image.size(), QImage::Format_RGB32);
+
+	auto mapFunctor = SeparableFilterMapper(kernel, is_box, outOfBoundsColor);
+	Concurrency::process(progressObserver, mapFunctor, image, retimage);
+	if (progressObserver && progressObserver->isInterruptionRequested())
+		return {};
+
+	return retimage;
+}
 } // cove
 
 //@}
@@ -1,5 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
+ * Copyright 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -32,6 +33,11 @@ class FIRFilter
 {
 protected:
 	std::vector<std::vector<double>> matrix;
+	std::vector<float> kernel;
+	bool is_box = false;
+
+	QImage applySeparable(const QImage& source, QRgb outOfBoundsColor,
+	                      ProgressObserver* progressObserver) const;
 
 public:
 	FIRFilter(unsigned radius = 0);
@@ -27,6 +27,8 @@
 namespace cove {
 class MapColor : public OrganizableElement
 {
+	friend class ColorClassifier;
+
 private:
 	typedef double (MapColor::*DistImplPtr)(double, double, double) const;
 	DistImplPtr currentDistImpl;
@@ -1,5 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
+ * Copyright 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -19,14 +20,307 @@
 
 #include "Morphology.h"
 
+#include <algorithm>
 #include <cmath>  // IWYU pragma: keep
+#include <cstddef>
+#include <map>
+#include <utility>
 #include <vector>
 
+#include <QtConcurrent>
 #include <QtGlobal>
 
 #include "ProgressObserver.h"
 
 namespace cove {
+
+namespace {
+
+using Word = quint64;
+constexpr int word_bits = 64;
+
+/**
+ * A binary image with 64 pixels packed into each word.
+ *
+ * Bit i of word w of a line holds the pixel at x = 64 * w + i. Bits beyond
+ * the width of the image are zero.
+ */
+struct BitImage
+{
+	int width;
+	int height;
+	int words_per_line;
+	std::vector<Word> words;
+
+	explicit BitImage(const QImage& image);
+
+	Word* line(int y)
+	{
+		return words.data() + std::size_t(y) * std::size_t(words_per_line);
+	}
+
+	const Word* line(int y) const
+	{
+		return words.data() + std::size_t(y) * std::size_t(words_per_line);
+	}
+
+	/// Returns the mask of the valid bits in the last word of a line.
+	Word lastWordMask() const
+	{
+		auto const bits = width % word_bits;
+		return bits ? (Word(1) << bits) - 1 : ~Word(0);
+	}
+
+	void writeTo(QImage& image) const;
+};
+
+unsigned char reversedBits(unsigned char byte)
+{
+	byte = static_cast<unsigned char>((byte & 0xf0) >> 4 | (byte & 0x0f) << 4);
+	byte = static_cast<unsigned char>((byte & 0xcc) >> 2 | (byte & 0x33) << 2);
+	return static_cast<unsigned char>((byte & 0xaa) >> 1 | (byte & 0x55) << 1);
+}
+
+bool isMonochrome(const QImage& image)
+{
+	return image.format() == QImage::Format_Mono
+	       || image.format() == QImage::Format_MonoLSB;
+}
+
+BitImage::BitImage(const QImage& image)
+	: width(image.width())
+	, height(image.height())
+	, words_per_line((width + word_bits - 1) / word_bits)
+	, words(std::size_t(words_per_line) * std::size_t(height), 0)
+{
+	auto const msb_first = image.format() == QImage::Format_Mono;
+	auto const bytes = (width + 7) / 8;
+	for (int y = 0; y < height; ++y)
+	{
+		auto* target = line(y);
+		if (isMonochrome(image))
+		{
+			auto const* source = image.constScanLine(y);
+			for (int j = 0; j < bytes; ++j)
+			{
+				auto const byte = msb_first ? reversedBits(source[j]) : source[j];
+				target[j / 8] |= Word(byte) << (8 * (j % 8));
+			}
+			target[words_per_line - 1] &= lastWordMask();
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				if (image.pixelIndex(x, y))
+					target[x / word_bits] |= Word(1) << (x % word_bits);
+			}
+		}
+	}
+}
+
+void BitImage::writeTo(QImage& image) const
+{
+	Q_ASSERT(image.width() == width);
+	Q_ASSERT(image.height() == height);
+	auto const msb_first = image.format() == QImage::Format_Mono;
+	auto const bytes = (width + 7) / 8;
+	for (int y = 0; y < height; ++y)
+	{
+		auto const* source = line(y);
+		if (isMonochrome(image))
+		{
+			auto* target = image.scanLine(y);
+			for (int j = 0; j < bytes; ++j)
+			{
+				auto const byte = static_cast<unsigned char>(source[j / 8] >> (8 * (j % 8)));
+				target[j] = msb_first ? reversedBits(byte) : byte;
+			}
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+				image.setPixel(x, y, uint(source[x / word_bits] >> (x % word_bits)) & 1);
+		}
+	}
+}
+
+
+/**
+ * A 3x3 neighborhood table which is evaluated for 64 pixels at once.
+ *
+ * The table is compiled into a reduced binary decision diagram. Each node
+ * selects one of two subfunctions by one bit of the neighborhood map. With
+ * the neighborhood maps of 64 pixels transposed into nine words, bitwise
+ * operations on whole words evaluate the table for all these pixels.
+ */
+class BitTable
+{
+public:
+	explicit BitTable(const bool* table);
+
+	/// The number of values needed for evaluation.
+	std::size_t size() const noexcept { return nodes.size() + 2; }
+
+	/**
+	 * Returns the table values for the given neighborhood words.
+	 *
+	 * neighbors[i] holds bit i of the neighborhood maps. values must provide
+	 * space for size() words.
+	 */
+	Word operator()(const Word* neighbors, Word* values) const;
+
+private:
+	struct Node
+	{
+		int bit;
+		int low;
+		int high;
+	};
+
+	int build(const std::vector<bool>& function, int bit,
+	          std::map<std::vector<bool>, int>& cache);
+
+	std::vector<Node> nodes;
+	int root;
+};
+
+BitTable::BitTable(const bool* table)
+{
+	std::map<std::vector<bool>, int> cache;
+	root = build(std::vector<bool>(table, table + 512), 0, cache);
+}
+
+// Returns the index of the function's value:
+// 0 for false, 1 for true, and 2 + i for the value of node i.
+int BitTable::build(const std::vector<bool>& function, int bit,
+                    std::map<std::vector<bool>, int>& cache)
+{
+	if (function.size() == 1)
+		return function.front() ? 1 : 0;
+
+	auto const found = cache.find(function);
+	if (found != cache.end())
+		return found->second;
+
+	auto const half = function.size() / 2;
+	std::vector<bool> low(half);
+	std::vector<bool> high(half);
+	for (std::size_t i = 0; i < half; ++i)
+	{
+		low[i] = function[2 * i];
+		high[i] = function[2 * i + 1];
+	}
+	auto index = build(low, bit + 1, cache);
+	auto const high_index = build(high, bit + 1, cache);
+	if (high_index != index)
+	{
+		// Children are created first, so nodes can be evaluated in order.
+		nodes.push_back({bit, index, high_index});
+		index = int(nodes.size()) + 1;
+	}
+	cache.emplace(function, index);
+	return index;
+}
+
+Word BitTable::operator()(const Word* neighbors, Word* values) const
+{
+	values[0] = 0;
+	values[1] = ~Word(0);
+	auto* value = values + 2;
+	for (auto const& node : nodes)
+	{
+		auto const selector = neighbors[node.bit];
+		*value++ = (selector & values[node.high]) | (~selector & values[node.low]);
+	}
+	return values[root];
+}
+
+
+/// Returns the index of the single bit which is set in mask.
+int bitIndex(unsigned int mask)
+{
+	int index = 0;
+	while (mask > 1)
+	{
+		mask >>= 1;
+		++index;
+	}
+	return index;
+}
+
+/**
+ * Applies a neighborhood table to all pixels of the source image.
+ *
+ * Where the table contains true and the guard neighbor (if not negative) is
+ * not set, the target pixel is set or reset according to insert. All other
+ * target pixels are copied from the source.
+ *
+ * The lines are processed concurrently in bands. The source is not modified,
+ * so each band reads the lines just above and below it directly from the
+ * source, and no synchronization is needed between the bands.
+ *
+ * Returns the number of pixels where the conditions are met.
+ */
+std::size_t applyTable(const BitTable& table, int guard, bool insert,
+                       const BitImage& source, BitImage& target)
+{
+	struct Band
+	{
+		int first;
+		int last;
+		std::size_t hits;
+	};
+	constexpr int band_height = 32;
+	std::vector<Band> bands;
+	for (int y = 0; y < source.height; y += band_height)
+		bands.push_back({y, std::min(y + band_height, source.height), 0});
+
+	QtConcurrent::blockingMap(bands, [&table, guard, insert, &source, &target](Band& band) {
+		auto values = std::vector<Word>(table.size());
+		auto const zeros = std::vector<Word>(std::size_t(source.words_per_line), 0);
+		auto const last = source.words_per_line - 1;
+		auto const last_mask = source.lastWordMask();
+		for (int y = band.first; y < band.last; ++y)
+		{
+			const Word* lines[3] = {
+				y > 0 ? source.line(y - 1) : zeros.data(),
+				source.line(y),
+				y + 1 < source.height ? source.line(y + 1) : zeros.data()
+			};
+			auto* output = target.line(y);
+			for (int w = 0; w <= last; ++w)
+			{
+				// Bit layout of the neighborhood maps: see Morphology::todelete
+				Word neighbors[9];
+				for (int r = 0; r < 3; ++r)
+				{
+					auto const* l = lines[r];
+					auto const center = l[w];
+					auto* row = neighbors + 3 * (2 - r);
+					row[2] = (center << 1) | (w > 0 ? l[w - 1] >> (word_bits - 1) : 0);
+					row[1] = center;
+					row[0] = (center >> 1) | (w < last ? l[w + 1] << (word_bits - 1) : 0);
+				}
+				auto hits = table(neighbors, values.data());
+				if (guard >= 0)
+					hits &= ~neighbors[guard];
+				if (w == last)
+					hits &= last_mask;
+				band.hits += std::size_t(qPopulationCount(hits));
+				output[w] = insert ? (lines[1][w] | hits) : (lines[1][w] & ~hits);
+			}
+		}
+	});
+
+	std::size_t hits = 0;
+	for (auto const& band : bands)
+		hits += band.hits;
+	return hits;
+}
+
+}  // namespace
+
 //@{
 //!\ingroup libvectorizer
 
@@ -127,18 +421,16 @@ bool Morphology::todelete[512] = {
 bool Morphology::rosenfeld(ProgressObserver* progressObserver)
 {
 	bool cancel = false; // whether the thinning was canceled
-	unsigned int x, y;   // Pixel coordinates
-	unsigned int count;  // Deleted pixel count
-	unsigned int p, q;   // Neighborhood maps of adjacent cells
+	std::size_t count;   // Deleted pixel count
 
 	thinnedImage = image;
 	thinnedImage.detach();
-	unsigned int xsize = thinnedImage.width();
-	unsigned int ysize = thinnedImage.height();
-	// Neighborhood maps of previous scanline
-	std::vector<unsigned char> qb(xsize);
+	auto const xsize = thinnedImage.width();
+	auto const ysize = thinnedImage.height();
 
-	qb[xsize - 1] = false; // Used for lower-right pixel
+	auto current = BitImage(thinnedImage);
+	auto next = current;
+	auto const table = BitTable(todelete);
 
 	do
 	{ // Thin image lines until there are no deletions
@@ -146,66 +438,21 @@ bool Morphology::rosenfeld(ProgressObserver* progressObserver)
 
 		for (auto const m : masks)
 		{
-			// Build initial previous scan buffer.
-			p = !!thinnedImage.pixelIndex(0, 0);
-			for (x = 0; x < xsize - 1; x++)
-				qb[x] =
-					(unsigned char)(p = ((p << 1) & 0006) |
-										(!!thinnedImage.pixelIndex(x + 1, 0)));
-
-			// Scan image for pixel deletion candidates.
-			for (y = 0; y < ysize - 1; y++)
-			{
-				q = qb[0];
-				p = ((q << 2) & 0330) | (!!thinnedImage.pixelIndex(0, y + 1));
-
-				for (x = 0; x < xsize - 1; x++)
-				{
-					q = qb[x];
-					p = ((p << 1) & 0666) | ((q << 3) & 0110) |
-						(!!thinnedImage.pixelIndex(x + 1, y + 1));
-					qb[x] = (unsigned char)p;
-					if (((p & m) == 0) && todelete[p])
-					{
-						count++;
-						thinnedImage.setPixel(x, y, 0); // delete the pixel
-					}
-				}
-
-				// Process right edge pixel.
-				p = (p << 1) & 0666;
-				if ((p & m) == 0 && todelete[p])
-				{
-					count++;
-					thinnedImage.setPixel(x, y, 0); // delete the pixel
-				}
-			}
-
-			// Process bottom scan line.
-			q = qb[0];
-			p = ((q << 2) & 0330);
-
-			for (x = 0; x < xsize; x++)
-			{
-				q = qb[x];
-				p = ((p << 1) & 0666) | ((q << 3) & 0110);
-				if ((p & m) == 0 && todelete[p])
-				{
-					count++;
-					thinnedImage.setPixel(x, y, 0); // delete the pixel
-				}
-			}
+			// Pixels are deleted only if the neighbor in direction m is not set.
+			count += applyTable(table, bitIndex(m), false, current, next);
+			std::swap(current, next);
 		}
 		if (progressObserver)
 			progressObserver->setPercentage(
 				100 -
 				static_cast<int>(
-					100 * std::pow(static_cast<float>(count) / (xsize * ysize),
+					100 * std::pow(static_cast<float>(count) / (float(xsize) * ysize),
 								   0.2)));
 	} while (
 		count &&
 		!(progressObserver && (cancel = progressObserver->isInterruptionRequested())));
 
+	current.writeTo(thinnedImage);
 	return !cancel;
 }
 
@@ -388,107 +635,24 @@ bool Morphology::runMorpholo(bool* table, bool insert,
 
 /*! Modifies thinnedImage according to given table.  Builds 3x3 neighborhood for
   every pixel and sets/resets (according to insert) the pixel in case the table
-  contains true.
+  contains true.  The neighborhoods are taken from the unmodified image.
   \param[in] table Neighborhood table, e.g. isDeletable or isInsertable
   \param[in] insert Whether the pixel should be set or reset when the table
   contains true.
   \param[in] progressObserver Progress observer.
+  \return Number of pixels where the table contains true, or -1 when canceled.
   */
 int Morphology::modifyImage(bool* table, bool insert,
 							ProgressObserver* progressObserver)
 {
-	int xSize = thinnedImage.width();
-	int ySize = thinnedImage.height();
-	int progressHowOften = (ySize > 100) ? ySize / 75 : 1;
-	std::vector<bool> topScanLine(xSize);
-	std::vector<bool> midScanLine(xSize);
-	std::vector<bool> botScanLine(xSize);
-	int p, modifications;
-	bool cancel = false;
-
-	modifications = 0;
-	// prepare buffers
-	for (int x = 0; x < xSize; x++)
-	{
-		midScanLine[x] = false;
-		botScanLine[x] = !!thinnedImage.pixelIndex(x, 0);
-	}
-
-	for (int y = 0; y < ySize - 1 && !cancel; y++)
-	{
-		// rotate buffers
-		auto& temp = topScanLine;
-		topScanLine = midScanLine;
-		midScanLine = botScanLine;
-		botScanLine = temp;
-		// initialize bottom line
-		botScanLine[0] = !!thinnedImage.pixelIndex(0, y + 1);
-		// create neighborhood
-		p = int(topScanLine[0]) << 6 | int(topScanLine[1]) << 5 | int(midScanLine[0]) << 3 |
-			int(midScanLine[1]) << 2 | int(botScanLine[0]);
-
-		// process line
-		for (int x = 0; x < xSize - 1; x++)
-		{
-			botScanLine[x + 1] = !!thinnedImage.pixelIndex(x + 1, y + 1);
-			p = ((p << 1) & 0666) | int(topScanLine[x + 1]) << 6 |
-				int(midScanLine[x + 1]) << 3 | int(botScanLine[x + 1]);
-			if (table[p])
-			{
-				thinnedImage.setPixel(x, y, insert ? 1 : 0); // set the pixel
-				// TTR midScanLine[x] = false;
-				modifications++;
-			}
-		}
-
-		// right margin line processing
-		p = (p << 1) & 0666;
-		if (table[p])
-		{
-			thinnedImage.setPixel(xSize - 1, y,
-								  insert ? 1 : 0); // set the pixel
-			// TTR midScanLine[xSize-1] = false;
-			modifications++;
-		}
-
-		if (progressObserver && !(y % progressHowOften))
-		{
-			progressObserver->setPercentage(y * 100 / ySize);
-			cancel = progressObserver->isInterruptionRequested();
-		}
-	}
-
-	// bottom margin line processing
-	auto& temp = topScanLine;
-	topScanLine = midScanLine;
-	midScanLine = botScanLine;
-	botScanLine = temp;
-	p = int(topScanLine[0]) << 7 | int(topScanLine[1]) << 6 | int(midScanLine[0]) << 4 |
-		int(midScanLine[1]) << 3;
-	for (int x = 0; x < xSize - 1 && !cancel; x++)
-	{
-		p = ((p << 1) & 0666) | int(topScanLine[x + 1]) << 6 |
-			int(midScanLine[x + 1]) << 3;
-		if (table[p])
-		{
-			thinnedImage.setPixel(x, ySize - 1,
-								  insert ? 1 : 0); // set the pixel
-			// TTR midScanLine[x] = false;
-			modifications++;
-		}
-	}
-
-	// bottom right pixel
-	p = (p << 1) & 0666;
-	if (table[p])
-	{
-		thinnedImage.setPixel(xSize - 1, ySize - 1,
-							  insert ? 1 : 0); // set the pixel
-		// TTR midScanLine[xSize-1] = false;
-		modifications++;
-	}
-
-	return cancel ? -1 : modifications;
+	auto const source = BitImage(thinnedImage);
+	auto target = source;
+	auto const modifications = applyTable(BitTable(table), -1, insert, source, target);
+	if (progressObserver && progressObserver->isInterruptionRequested())
+		return -1;
+
+	target.writeTo(thinnedImage);
+	return int(modifications);
 }
 } // cove
 
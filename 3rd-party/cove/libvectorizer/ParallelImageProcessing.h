@@ -1,6 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
- * Copyright 2020 Kai Pastor
+ * Copyright 2020, 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstddef>
 
+#include <QtGlobal>
 #include <QImage>
 #include <QThreadPool>
 
@@ -91,6 +92,58 @@ struct HorizontalStripes
 };
 
 
+/**
+ * Use concurrent image processing of horizontal stripes with overlapping sources.
+ * 
+ * This is meant for neighborhood operations where each output pixel depends
+ * on source pixels in the lines above and below. The functor must provide
+ * 
+ *     int halo() const;
+ * 
+ * returning the number of source lines needed above and below each output
+ * line, and it is called as
+ * 
+ *     functor(source_stripe, offset, target_stripe, observer);
+ * 
+ * where line y of the target stripe corresponds to line y + offset of the
+ * source stripe. Source and target must have the same height.
+ */
+struct OverlappingHorizontalStripes
+{
+	/// Creates concurrent jobs.
+	template <typename ResultType, typename Functor>
+	static Concurrency::JobList<ResultType> makeJobs(const Functor& functor, const QImage& source, QImage& target)
+	{
+		using InplaceStripeData = HorizontalStripes::InplaceStripeData;
+		
+		Q_ASSERT(source.height() == target.height());
+		Concurrency::JobList<ResultType> jobs;
+		
+		auto const num_jobs = std::max(1, QThreadPool::globalInstance()->maxThreadCount());
+		jobs.reserve(std::size_t(num_jobs));
+		
+		auto const image_height = target.height();
+		auto const stripe_height = (image_height + num_jobs - 1) / num_jobs;
+		auto const halo = functor.halo();
+		for (int i = 0; i < image_height; i += stripe_height)
+		{
+			// See HorizontalStripes::makeJobs() for the reason of the wrapper.
+			auto runner = [](const Functor& functor, InplaceStripeData& data, ProgressObserver& observer) -> ResultType {
+				auto const input = HorizontalStripes::makeStripe(data.source, data.source_scanline, data.source_height);
+				auto output = HorizontalStripes::makeStripe(data.target, data.target_scanline, data.target_height);
+				return functor(input, data.target_scanline - data.source_scanline, output, observer);
+			};
+			auto const first = std::max(0, i - halo);
+			auto const last = std::min(image_height, i + stripe_height + halo);
+			auto data = InplaceStripeData { source, first, last - first, target, i, stripe_height };
+			jobs.emplace_back(Concurrency::run<ResultType>(runner, functor, data));
+		}
+		
+		return jobs;
+	}
+};
+
+
 }  // namespace cove
 
 #endif  // COVE_PARALLELIMAGEPROCESSING_H
@@ -1,6 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
- * Copyright 2020 Kai Pastor
+ * Copyright 2020, 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -21,14 +21,17 @@
 #include "Polygons.h"
 
 #include <algorithm>
-#include <cerrno>
 #include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <limits>
 // IWYU pragma: no_include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include <QtGlobal>
 #include <QByteArray>
@@ -37,7 +40,10 @@
 
 #include <QImage>
 #include <QRectF>
+#include <QThreadPool>
 
+#include "Concurrency.h"
+#include "ParallelImageProcessing.h"
 #include "ProgressObserver.h"
 
 // IWYU pragma: no_forward_declare QPointF
@@ -51,7 +57,6 @@ do                                       \
 
 
 namespace cove {
-const int Polygons::NPOINTS_MAX = 350;
 
 //@{
 //! \ingroup libvectorizer
@@ -364,41 +369,376 @@ void Polygons::removePathFromImage(QImage& image, const Path& path)
 	}
 }
 
-/*! Finds all paths in image and returns them in PathList. */
-Polygons::PathList
-Polygons::decomposeImageIntoPaths(const QImage& sourceImage,
-								  ProgressObserver* progressObserver) const
+/*! \class Polygons::PathTracer
+ * \brief Finds the paths of an image concurrently in horizontal stripes.
+ *
+ * Each stripe is decomposed into pieces of paths, treating the stripe's
+ * borders like the image's borders. Pieces which end on vertically adjacent
+ * pixels of neighboring stripes are then stitched together.
+ *
+ * The sequential decomposition stops paths at junctions, and the resulting
+ * paths depend on the order in which the pixels are visited. To get the very
+ * same result, all pieces which belong to a component with a junction are
+ * collected and decomposed sequentially again. For all other components, the
+ * start pixel and the direction of tracing are derived directly from the
+ * stitched pixels. All paths are finally ordered by their start pixels,
+ * which is the order of the sequential scan.
+ */
+class Polygons::PathTracer
 {
-	PathList pathList;
-	QImage image = sourceImage;
-	int height = sourceImage.height(),
-		progressHowOften = (height > 100) ? height / 45 : 1;
+public:
+	/*! The pieces of paths found in a single stripe.
+	 *
+	 * The y coordinates are relative to the top of the stripe. A piece is
+	 * irregular when it touches a junction, i.e. a pixel with more than two
+	 * neighbors. */
+	struct Stripe
+	{
+		PathList pieces;
+		std::vector<bool> irregular;
+		int height = 0;
+	};
+
+	/*! Junctions are detected from source pixels with distance up to two
+	 * from the stripe. */
+	int halo() const
+	{
+		return 2;
+	}
+
+	Stripe operator()(const QImage& source, int offset, QImage& image,
+	                  ProgressObserver& progressObserver) const;
+
+	using concurrent_processing = OverlappingHorizontalStripes;
+
+	static PathList stitch(const std::vector<Stripe>& stripes, int width,
+	                       int height, unsigned specklesize);
+
+private:
+	static void orientPath(Path& path, const PATH_POINT& start);
+};
+
+/*! Decomposes a stripe into pieces of paths.
+ * \param[in] source The source stripe, including the halo.
+ * \param[in] offset The line of the source which is the first line of image.
+ * \param[in,out] image The stripe to be decomposed. It is cleared. */
+Polygons::PathTracer::Stripe
+Polygons::PathTracer::operator()(const QImage& source, int offset,
+                                 QImage& image,
+                                 ProgressObserver& progressObserver) const
+{
+	Stripe stripe;
+	auto const width = image.width();
+	auto const height = image.height();
+	stripe.height = height;
+
+	auto isSet = [&source](int x, int y) {
+		return source.valid(x, y) && source.pixelIndex(x, y);
+	};
+
+	// Junctions in the stripe and in the adjacent lines
+	std::vector<bool> junctions(std::size_t(width) * std::size_t(height + 2));
+	auto isJunction = [&junctions, width, height](int x, int y) {
+		return x >= 0 && x < width && y >= -1 && y <= height
+		       && junctions[std::size_t(y + 1) * std::size_t(width) + std::size_t(x)];
+	};
+	for (int y = -1; y <= height; ++y)
+	{
+		auto const sy = y + offset;
+		for (int x = 0; x < width; ++x)
+		{
+			if (isSet(x, sy)
+			    && isSet(x - 1, sy) + isSet(x + 1, sy) + isSet(x, sy - 1) + isSet(x, sy + 1) > 2)
+				junctions[std::size_t(y + 1) * std::size_t(width) + std::size_t(x)] = true;
+		}
+	}
+
+	int progressHowOften = (height > 100) ? height / 45 : 1;
 	int x = 0, y = 0;
-	bool cancel = false;
-	while (!cancel && findNextPixel(image, x, y))
+	while (findNextPixel(image, x, y))
 	{
+		auto piece = recordPath(image, x, y);
+		removePathFromImage(image, piece);
+		auto irregular = std::any_of(begin(piece), end(piece), [&isJunction](const PATH_POINT& p) {
+			return isJunction(p.x, p.y) || isJunction(p.x - 1, p.y) || isJunction(p.x + 1, p.y)
+			       || isJunction(p.x, p.y - 1) || isJunction(p.x, p.y + 1);
+		});
+		stripe.pieces.push_back(std::move(piece));
+		stripe.irregular.push_back(irregular);
+
+		if (!(y % progressHowOften))
 		{
-			auto pathFound = recordPath(image, x, y);
-			removePathFromImage(image, pathFound);
-			if (pathFound.size() > specklesize)
-				pathList.push_back(std::move(pathFound));
+			progressObserver.setPercentage(y * 25 / height);
+			if (progressObserver.isInterruptionRequested())
+				break;
 		}
-		if (progressObserver && !(y % progressHowOften))
+	}
+
+	return stripe;
+}
+
+/*! Orients a simple path or cycle the way it would be recorded when
+ * starting from the given pixel.
+ *
+ * For open paths, recordPath() follows the path to the end which is reached
+ * first, preferring the southern neighbor, and records the path from there.
+ * For cycles, it records the cycle from the eastern neighbor of the start
+ * pixel, in the direction which is found last by followPath(). */
+void Polygons::PathTracer::orientPath(Path& path, const PATH_POINT& start)
+{
+	auto const n = path.size();
+	if (n < 2)
+		return;
+
+	auto const isAt = [](const PATH_POINT& p, int x, int y) {
+		return p.x == x && p.y == y;
+	};
+	auto const s = std::size_t(std::find_if(begin(path), end(path), [&](const PATH_POINT& p) {
+		return isAt(p, start.x, start.y);
+	}) - begin(path));
+
+	if (!path.isClosed())
+	{
+		// The path ends at the start pixel, or it begins after the start
+		// pixel's southern neighbor.
+		if (s == 0
+		    || (s + 1 < n && isAt(path[s + 1], start.x, start.y + 1)))
+			std::reverse(begin(path), end(path));
+		return;
+	}
+
+	// The start pixel's neighbors are in the east and in the south.
+	auto const t = isAt(path[(s + 1) % n], start.x + 1, start.y) ? (s + 1) % n : (s + n - 1) % n;
+	std::rotate(begin(path), begin(path) + std::ptrdiff_t(t), end(path));
+	auto const& u = isAt(path[1], start.x, start.y) ? path[n - 1] : path[1];
+	auto const first_step_to_start = isAt(u, path[0].x + 1, path[0].y);
+	if (first_step_to_start != isAt(path[1], start.x, start.y))
+		std::reverse(begin(path) + 1, end(path));
+}
+
+/*! Stitches the pieces of all stripes, and returns all paths which are
+ * longer than specklesize. */
+Polygons::PathList
+Polygons::PathTracer::stitch(const std::vector<Stripe>& stripes, int width,
+                             int height, unsigned specklesize)
+{
+	struct Piece
+	{
+		const Path* path;
+		int first_line;
+		bool irregular;
+	};
+	std::vector<Piece> pieces;
+
+	// Piece ends are encoded as 2 * piece + end, with end 0 for the front
+	// and 1 for the back.
+	std::vector<int> links;
+	std::vector<int> bottom_ends;
+	std::vector<int> top_ends;
+	int first_line = 0;
+	for (auto const& stripe : stripes)
+	{
+		top_ends.assign(std::size_t(width), -1);
+		auto last_line = first_line + stripe.height - 1;
+		auto stripe_bottom_ends = std::vector<int>(std::size_t(width), -1);
+		for (std::size_t i = 0; i < stripe.pieces.size(); ++i)
 		{
-			// FIXME hardcoded value 25!!!
-			progressObserver->setPercentage(y * 25 / height);
-			cancel = progressObserver->isInterruptionRequested();
+			auto const& path = stripe.pieces[i];
+			auto const index = int(pieces.size());
+			pieces.push_back({&path, first_line, stripe.irregular[i]});
+			links.push_back(-1);
+			links.push_back(-1);
+			if (path.isClosed())
+				continue;
+
+			auto const& front = path.front();
+			auto const& back = path.back();
+			if (front.y == 0)
+				top_ends[std::size_t(front.x)] = 2 * index;
+			if (path.size() > 1 && back.y == 0)
+				top_ends[std::size_t(back.x)] = 2 * index + 1;
+			if (path.size() > 1 && front.y == stripe.height - 1)
+				stripe_bottom_ends[std::size_t(front.x)] = 2 * index;
+			if (back.y == stripe.height - 1)
+				stripe_bottom_ends[std::size_t(back.x)] = 2 * index + 1;
+		}
+
+		if (first_line > 0)
+		{
+			for (std::size_t x = 0; x < std::size_t(width); ++x)
+			{
+				auto const a = bottom_ends[x];
+				auto const b = top_ends[x];
+				if (a >= 0 && b >= 0
+				    && links[std::size_t(a)] < 0 && links[std::size_t(b)] < 0)
+				{
+					links[std::size_t(a)] = b;
+					links[std::size_t(b)] = a;
+				}
+			}
+		}
+		bottom_ends = std::move(stripe_bottom_ends);
+		first_line = last_line + 1;
+	}
+
+	struct StartedPath
+	{
+		qint64 start;
+		Path path;
+	};
+	std::vector<StartedPath> paths;
+	auto const key = [width](const PATH_POINT& p) {
+		return qint64(p.y) * width + p.x;
+	};
+
+	QImage irregular_image;
+	std::vector<qint64> irregular_pixels;
+
+	std::vector<bool> visited(pieces.size());
+	for (std::size_t i = 0; i < pieces.size(); ++i)
+	{
+		if (visited[i])
+			continue;
+
+		// Find the beginning of the chain of pieces.
+		auto start_end = int(2 * i);
+		bool closed = false;
+		for (auto piece_end = int(2 * i); ; )
+		{
+			auto const link = links[std::size_t(piece_end)];
+			if (link < 0)
+			{
+				start_end = piece_end;
+				break;
+			}
+			if (std::size_t(link / 2) == i)
+			{
+				closed = true;
+				break;
+			}
+			piece_end = link ^ 1;
+		}
+
+		// Collect the chain, beginning with start_end.
+		Path path;
+		path.setClosed(closed || pieces[i].path->isClosed());
+		bool irregular = false;
+		for (auto piece_end = start_end; ; )
+		{
+			auto const index = std::size_t(piece_end / 2);
+			auto const& piece = pieces[index];
+			visited[index] = true;
+			irregular |= piece.irregular;
+			auto const first = path.size();
+			for (auto const& p : *piece.path)
+				path.push_back({p.x, p.y + piece.first_line});
+			if (piece_end % 2)
+				std::reverse(begin(path) + std::ptrdiff_t(first), end(path));
+
+			auto const link = links[std::size_t(piece_end ^ 1)];
+			if (link < 0 || link == start_end)
+				break;
+			piece_end = link;
+		}
+
+		if (irregular)
+		{
+			if (irregular_image.isNull())
+			{
+				irregular_image = QImage(width, height, QImage::Format_Mono);
+				irregular_image.fill(0);
+			}
+			for (auto const& p : path)
+			{
+				irregular_image.setPixel(p.x, p.y, 1);
+				irregular_pixels.push_back(key(p));
+			}
+			continue;
+		}
+
+		auto const start = *std::min_element(begin(path), end(path), [&key](const PATH_POINT& a, const PATH_POINT& b) {
+			return key(a) < key(b);
+		});
+		if (path.size() > specklesize)
+		{
+			orientPath(path, start);
+			paths.push_back({key(start), std::move(path)});
 		}
 	}
 
-	if (cancel)
-		pathList.clear();
+	// Components with junctions, in the order of the sequential scan.
+	// Like in the sequential scan, a pixel may start more than one path.
+	std::sort(begin(irregular_pixels), end(irregular_pixels));
+	for (auto const pixel : irregular_pixels)
+	{
+		auto const x = int(pixel % width);
+		auto const y = int(pixel / width);
+		while (irregular_image.pixelIndex(x, y))
+		{
+			auto path = recordPath(irregular_image, x, y);
+			removePathFromImage(irregular_image, path);
+			if (path.size() > specklesize)
+				paths.push_back({pixel, std::move(path)});
+		}
+	}
 
+	std::stable_sort(begin(paths), end(paths), [](const StartedPath& a, const StartedPath& b) {
+		return a.start < b.start;
+	});
+	PathList pathList;
+	pathList.reserve(paths.size());
+	for (auto& started_path : paths)
+		pathList.push_back(std::move(started_path.path));
 	return pathList;
 }
 
+/*! Finds all paths in image and returns them in PathList.
+ * The paths are traced concurrently, see Polygons::PathTracer. */
+Polygons::PathList
+Polygons::decomposeImageIntoPaths(const QImage& sourceImage,
+								  ProgressObserver* progressObserver) const
+{
+	QImage image = sourceImage.copy();
+	auto jobs = Concurrency::process<PathTracer::Stripe>(progressObserver, PathTracer(), sourceImage, image);
+	if (progressObserver && progressObserver->isInterruptionRequested())
+		return {};
+
+	std::vector<PathTracer::Stripe> stripes;
+	stripes.reserve(jobs.size());
+	for (auto& job : jobs)
+		stripes.push_back(job.future.result());
+	return PathTracer::stitch(stripes, sourceImage.width(), sourceImage.height(), specklesize);
+}
+
+namespace {
+
+/*! Finds the optimal polygons for a range of potrace paths.
+ *
+ * Potrace processes each path on its own, so ranges of paths can be handled
+ * concurrently. Returns false if potrace fails for any path. */
+struct PathFitter
+{
+	bool operator()(path_t** first, path_t** last, ProgressObserver& progressObserver) const
+	{
+		auto const total = std::distance(first, last);
+		for (auto current = first; current != last; ++current)
+		{
+			auto* pp = (*current)->priv;
+			if (calc_sums(pp) || calc_lon(pp) || bestpolygon(pp) || adjust_vertices(pp))
+				return false;
+			if (progressObserver.isInterruptionRequested())
+				return true;
+			progressObserver.setPercentage(int(100 * std::distance(first, current) / total));
+		}
+		return true;
+	}
+};
+
+}  // namespace
+
 /*! Identifies straight segments of path and returns them as list of vertices
- * between them.  Prepares data for libpotrace, then calls its functions. */
+ * between them.  Prepares data for libpotrace, then calls its functions.
+ * The polygons are fitted concurrently, see PathFitter. */
 PolygonList
 Polygons::getPathPolygons(const Polygons::PathList& constpaths,
 						  ProgressObserver* progressObserver) const
@@ -448,15 +788,46 @@ Polygons::getPathPolygons(const Polygons::PathList& constpaths,
 		}
 	}
 
-// create polygons for all paths
-#define TRY(x) \
-	if (x) goto try_error // NOLINT
+	// create polygons for all paths, in one job per thread
+	std::vector<path_t*> paths;
+	paths.reserve(constpaths.size());
 	list_forall(p, plist)
 	{
-		TRY(calc_sums(p->priv));
-		TRY(calc_lon(p->priv));
-		TRY(bestpolygon(p->priv));
-		TRY(adjust_vertices(p->priv));
+		paths.push_back(p);
+	}
+
+	Concurrency::JobList<bool> jobs;
+	auto const num_jobs = std::size_t(std::max(1, QThreadPool::globalInstance()->maxThreadCount()));
+	auto const chunk_size = std::max(std::size_t(1), (paths.size() + num_jobs - 1) / num_jobs);
+	jobs.reserve(num_jobs);
+	for (std::size_t i = 0; i < paths.size(); i += chunk_size)
+	{
+		auto* first = paths.data() + i;
+		auto* last = paths.data() + std::min(paths.size(), i + chunk_size);
+		jobs.emplace_back(Concurrency::run<bool>(PathFitter(), first, last));
+	}
+	if (progressObserver)
+	{
+		auto fittingProgress = Concurrency::TransformedProgress{*progressObserver, 0.4, 50};
+		Concurrency::waitForFinished(&fittingProgress, jobs);
+	}
+	else
+	{
+		Concurrency::waitForFinished(nullptr, jobs);
+	}
+
+	auto const fitted = std::all_of(begin(jobs), end(jobs), [](auto& job) {
+		return job.future.result();
+	});
+	if (!fitted)
+		qWarning("process_path failed");
+	if (!fitted || (progressObserver && progressObserver->isInterruptionRequested()))
+	{
+		list_forall_unlink(p, plist)
+		{
+			path_free(p);
+		}
+		return {};
 	}
 
 	// do joining...
@@ -495,11 +866,6 @@ Polygons::getPathPolygons(const Polygons::PathList& constpaths,
 	}
 
 	return polylist;
-
-try_error:
-	qWarning("process_path failed with errno %d", errno);
-	path_free(p);
-	return {};
 }
 
 /*! Euclidean distance of two QPointFs. */
@@ -626,168 +992,138 @@ inline double Polygons::dstfun(const dpoint_t* a, const dpoint_t* b,
 					   : ((j) == BB ? "BB" : ((j) == NOJOIN ? "NOJOIN" \
 															: "!!invalid")))))
 
-// FIXME !!! - remove the recursion, then lower the NPOINTS_MAX to its optimal
-// value 35
-// stack is not always big enough...
-bool Polygons::splitlist(JOINENDPOINTLIST& pl, JOINOPLIST& ops,
-						 const dpoint_t& min, const dpoint_t& max,
-						 bool vertical, ProgressObserver* progressObserver,
-						 const double pBase, const double piece) const
-{
-	dpoint_t min1, max1, min2, max2;
-	JOINENDPOINTLIST pl1, pl2;
-
-	pl1.reserve(pl.size() / 2);
-	pl2.reserve(pl.size() / 2);
-
-	if (vertical)
-	{
-		min1.x = min.x;
-		max1.x = min2.x = min.x + (max.x - min.x) / 2;
-		max2.x = max.x;
-		min1.y = min2.y = min.y;
-		max1.y = max2.y = max.y;
-	}
-	else
-	{
-		min1.y = min.y;
-		max1.y = min2.y = min.y + (max.y - min.y) / 2;
-		max2.y = max.y;
-		min1.x = min2.x = min.x;
-		max1.x = max2.x = max.x;
-	}
-
-	if (vertical)
-	{
-		double x1bound = max1.x + maxdist / 2, x2bound = min2.x - maxdist / 2;
-		for (const auto& p : pl)
-		{
-			if (p.coords.x <= x1bound) pl1.push_back(p);
-			if (p.coords.x >= x2bound) pl2.push_back(p);
-		}
-	}
-	else
-	{
-		double y1bound = max1.y + maxdist / 2, y2bound = min2.y - maxdist / 2;
-		for (const auto& p : pl)
-		{
-			if (p.coords.y <= y1bound) pl1.push_back(p);
-			if (p.coords.y >= y2bound) pl2.push_back(p);
-		}
-	}
-
-	JOIN_DEBUG_PRINT(
-		"[%f, %f, %f, %f] -> [%f, %f, %f, %f]v[%f, %f, %f, %f] %d=>%d+%d",
-		min.x, min.y, max.x, max.y, min1.x, min1.y, max1.x, max1.y, min2.x,
-		min2.y, max2.x, max2.y, int(pl.size()), int(pl1.size()),
-		int(pl2.size()));
-
-	pl.clear();
+/*! \brief Finds all possible joins of path ends.
 
-	vertical = !vertical;
-	return compdists(pl1, ops, min1, max1, vertical, progressObserver, pBase,
-					 piece > 1 ? piece / 2 : 1) &&
-		   compdists(pl2, ops, min2, max2, vertical, progressObserver,
-					 pBase + piece / 2.0, piece > 1 ? piece / 2 : 1);
-}
-
-bool Polygons::compdists(JOINENDPOINTLIST& pl, JOINOPLIST& ops,
+ The end points are sorted into a grid of cells not smaller than maxdist,
+ so that only the points in neighboring cells need to be checked. The
+ operations are recorded in the order of the end point list. */
+bool Polygons::findJoins(const JOINENDPOINTLIST& pl, JOINOPLIST& ops,
 						 const dpoint_t& min, const dpoint_t& max,
-						 bool vertical, ProgressObserver* progressObserver,
+						 ProgressObserver* progressObserver,
 						 const double pBase, const double piece) const
 {
 	int cntr = 0, npoints = pl.size();
 	int progressHowOften = (npoints / piece >= 1) ? int(npoints / piece) : 1;
 	bool cancel = false;
 
-	// split the list whenever it's too long
-	if (npoints > NPOINTS_MAX)
+	// Limit the number of cells for large images and small distances.
+	const int max_cells = 1024;
+	auto cell_size = std::max({maxdist, (max.x - min.x) / max_cells,
+							   (max.y - min.y) / max_cells});
+	auto cellCoord = [cell_size, max_cells](double value, double min_value) {
+		return qBound(0, int((value - min_value) / cell_size), max_cells);
+	};
+	const int columns = cellCoord(max.x, min.x) + 1;
+	const int rows = cellCoord(max.y, min.y) + 1;
+
+	// Sort the point indices into the cells, keeping their order.
+	std::vector<int> cellStart(std::size_t(columns) * std::size_t(rows) + 1, 0);
+	std::vector<int> cellOfPoint(npoints);
+	for (int i = 0; i < npoints; ++i)
 	{
-		JOIN_DEBUG_PRINT("splitting");
-		splitlist(pl, ops, min, max, vertical, progressObserver, pBase, piece);
+		auto const& p = pl[i].coords;
+		cellOfPoint[i] =
+			cellCoord(p.y, min.y) * columns + cellCoord(p.x, min.x);
+		++cellStart[cellOfPoint[i] + 1];
 	}
-	else
+	std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+	std::vector<int> cellPoints(npoints);
 	{
-		double maxDistSqr = maxdist * maxdist;
-		std::vector<bool> alreadyUsed(npoints, false);
-		std::vector<bool>::iterator ai = alreadyUsed.begin(), aj;
+		auto next = cellStart;
+		for (int i = 0; i < npoints; ++i)
+			cellPoints[next[cellOfPoint[i]]++] = i;
+	}
 
-		JOIN_DEBUG_PRINT("computing set of %d points", npoints);
-		for (JOINENDPOINTLIST::const_iterator i = pl.begin();
-			 i != pl.end() && !cancel; ++i, ++ai)
-		{
-			privcurve_t* curve = &i->path->priv->curve;
-			const dpoint_t* start = &i->coords;
-			int nJoins = 0;
-
-			// Closed curves cannot be joined. Points outside the bounding
-			// rectangle
-			// are not considered for joining.
-			if (curve->closed || start->x < min.x || start->x > max.x ||
-				start->y < min.y || start->y > max.y)
-				continue;
+	double maxDistSqr = maxdist * maxdist;
+	std::vector<bool> alreadyUsed(npoints, false);
+	std::vector<int> candidates;
 
-			aj = ai + 1;
-			for (JOINENDPOINTLIST::const_iterator j = i + 1; j != pl.end();
-				 ++j, ++aj)
-			{
-				if (distSqr(start, &j->coords) < maxDistSqr)
-				{
-					dpoint_t *a, *b, *c, *d;
-					privcurve_t* pp_curve = &j->path->priv->curve;
+	JOIN_DEBUG_PRINT("computing set of %d points", npoints);
+	for (int i = 0; i < npoints && !cancel; ++i)
+	{
+		privcurve_t* curve = &pl[i].path->priv->curve;
+		const dpoint_t* start = &pl[i].coords;
+		int nJoins = 0;
 
-					switch (i->end)
-					{
-					case FRONT:
-						b = &curve->vertex[0];
-						a = b + 1;
-						break;
-					case BACK:
-						b = &curve->vertex[curve->n - 1];
-						a = b - 1;
-						break;
-					default:
-						throw std::logic_error("NOEND in JOINENDPOINT list");
-					}
-					switch (j->end)
-					{
-					case FRONT:
-						c = &pp_curve->vertex[0];
-						d = c + 1;
-						break;
-					case BACK:
-						c = &pp_curve->vertex[pp_curve->n - 1];
-						d = c - 1;
-						break;
-					default:
-						throw std::logic_error("NOEND in JOINENDPOINT list");
-					}
+		// Closed curves cannot be joined.
+		if (curve->closed)
+			continue;
 
-					ops.push_back(JOINOP(float(dstfun(a, b, c, d)
-					                           // self-connection penalization
-					                           - (i->path == j->path)),
-					                     endsToType(i->end, j->end), i->path,
-					                     j->path));
-					nJoins++;
-					*aj = true;
+		candidates.clear();
+		auto const column = cellOfPoint[i] % columns;
+		auto const row = cellOfPoint[i] / columns;
+		for (int r = std::max(0, row - 1); r <= std::min(rows - 1, row + 1); ++r)
+		{
+			for (int c = std::max(0, column - 1);
+				 c <= std::min(columns - 1, column + 1); ++c)
+			{
+				auto const cell = r * columns + c;
+				for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k)
+				{
+					auto const j = cellPoints[k];
+					if (j > i && distSqr(start, &pl[j].coords) < maxDistSqr)
+						candidates.push_back(j);
 				}
 			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (auto const j : candidates)
+		{
+			dpoint_t *a, *b, *c, *d;
+			privcurve_t* pp_curve = &pl[j].path->priv->curve;
 
-			if (nJoins == 1 && !*ai)
+			switch (pl[i].end)
 			{
-				// simple connection
-				ops.back().simple = true;
+			case FRONT:
+				b = &curve->vertex[0];
+				a = b + 1;
+				break;
+			case BACK:
+				b = &curve->vertex[curve->n - 1];
+				a = b - 1;
+				break;
+			default:
+				throw std::logic_error("NOEND in JOINENDPOINT list");
 			}
-
-			if (progressObserver && !(++cntr % progressHowOften))
+			switch (pl[j].end)
 			{
-				progressObserver->setPercentage(
-					int(cntr * piece / npoints + pBase));
-				cancel = progressObserver->isInterruptionRequested();
+			case FRONT:
+				c = &pp_curve->vertex[0];
+				d = c + 1;
+				break;
+			case BACK:
+				c = &pp_curve->vertex[pp_curve->n - 1];
+				d = c - 1;
+				break;
+			default:
+				throw std::logic_error("NOEND in JOINENDPOINT list");
 			}
-			if (cancel) return false;
+
+			ops.push_back(JOINOP(float(dstfun(a, b, c, d)
+			                           // self-connection penalization
+			                           - (pl[i].path == pl[j].path)),
+			                     endsToType(pl[i].end, pl[j].end), pl[i].path,
+			                     pl[j].path));
+			nJoins++;
+			alreadyUsed[j] = true;
+		}
+
+		if (nJoins == 1 && !alreadyUsed[i])
+		{
+			// simple connection
+			ops.back().simple = true;
+		}
+
+		if (progressObserver && !(++cntr % progressHowOften))
+		{
+			progressObserver->setPercentage(
+				int(cntr * piece / npoints + pBase));
+			cancel = progressObserver->isInterruptionRequested();
 		}
 	}
+	if (cancel) return false;
+
 	if (progressObserver)
 	{
 		progressObserver->setPercentage(int(piece + pBase));
@@ -826,7 +1162,7 @@ bool Polygons::joinPolygons(path_t*& plist,
 		if (b.y < min.y) min.y = b.y;
 	}
 
-	compdists(pointlist, ops, min, max, true, progressObserver, 50, 12);
+	findJoins(pointlist, ops, min, max, progressObserver, 50, 12);
 
 	sort(ops.begin(), ops.end(), 
 	     [](const JOINOP& x, const JOINOP& y) { return x.weight > y.weight; });
@@ -1,6 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
- * Copyright 2020 Kai Pastor
+ * Copyright 2020, 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -141,15 +141,10 @@ private:
 
 	typedef std::vector<JOINENDPOINT> JOINENDPOINTLIST;
 
-	// implementation dependent value...
-	static const int NPOINTS_MAX;
+	class PathTracer;
 
-	bool compdists(JOINENDPOINTLIST& pl, JOINOPLIST& ops, const dpoint_t& min,
-	               const dpoint_t& max, bool vertical,
-	               ProgressObserver* progressObserver, double pBase,
-	               double piece) const;
-	bool splitlist(JOINENDPOINTLIST& pl, JOINOPLIST& ops, const dpoint_t& min,
-	               const dpoint_t& max, bool vertical,
+	bool findJoins(const JOINENDPOINTLIST& pl, JOINOPLIST& ops,
+	               const dpoint_t& min, const dpoint_t& max,
 	               ProgressObserver* progressObserver, double pBase,
 	               double piece) const;
 	inline double distSqr(const dpoint_t* a, const dpoint_t* b) const;
@@ -186,8 +181,6 @@ public:
 	PolygonList
 	createPolygonsFromImage(const QImage& image,
 	                        ProgressObserver* progressObserver = nullptr) const;
-	// search for best value of NPOINTS_MAX - optinpoints.cpp
-	friend void perfcheck();
 };
 } // cove
 
@@ -1,6 +1,6 @@
 /*
  * Copyright (c) 2005-2019 Libor Pecháček.
- * Copyright 2020 Kai Pastor
+ * Copyright 2020, 2026 Kai Pastor
  *
  * This file is part of CoVe 
  *
@@ -21,6 +21,7 @@
 #include "Vectorizer.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <iosfwd>
 #include <iterator>
@@ -36,6 +37,7 @@
 #include <QVector>
 
 #include "AlphaGetter.h"
+#include "ColorClassifier.h"
 #include "Concurrency.h"
 #include "ProgressObserver.h"
 #include "KohonenMap.h"
@@ -349,13 +351,9 @@ bool Vectorizer::performClassification(ProgressObserver* progressObserver)
 	}
 	break;
 	case KOHONEN_BATCH:
-	{
-		auto bg = std::make_unique<SequentialPatternGetter>(
-			sourceImage, mc.get(), progressObserver);
-		quality = km.performBatchLearning(*bg);
-		classifiedImage = *bg->getClassifiedImage();
-	}
-	break;
+		quality = performBatchLearning(progressObserver);
+		km.setClasses(classes);
+		break;
 	default:
 		qWarning("UNIMPLEMENTED classification method");
 	}
@@ -377,6 +375,113 @@ bool Vectorizer::performClassification(ProgressObserver* progressObserver)
 	return !cancel;
 }
 
+/*! Creates image where original pixel colors are replaced by the class
+ * indices of the closest moments, and collects the class statistics for one
+ * pass of batch learning. */
+class BatchLearningMapper
+{
+	const ColorClassifier& classifier;
+	const MapColor& prototype;
+
+public:
+	BatchLearningMapper(const ColorClassifier& classifier, const MapColor& prototype)
+		: classifier(classifier)
+		, prototype(prototype)
+	{}
+
+	ColorClassifier::Moments operator()(const QImage& sourceImage, QImage& classifiedImage, ProgressObserver& observer) const
+	{
+		auto const width = classifiedImage.width();
+		auto const height = classifiedImage.height();
+
+		auto color = std::unique_ptr<MapColor>(
+			dynamic_cast<MapColor*>(prototype.clone()));
+
+		auto moments = ColorClassifier::Moments(classifier.size());
+		for (int y = 0; y < height && !observer.isInterruptionRequested(); y++)
+		{
+			auto index = -1;
+			auto last_rgb = QRgb(0);
+			for (int x = 0; x < width; x++)
+			{
+				// Neighbor pixels often have the same color.
+				auto const rgb = sourceImage.pixel(x, y);
+				if (index < 0 || rgb != last_rgb)
+				{
+					color->setRGBTriplet(rgb);
+					index = classifier.findClosest(*color);
+					last_rgb = rgb;
+				}
+				if (classifiedImage.pixelIndex(x, y) != index)
+				{
+					classifiedImage.setPixel(x, y, uint(index));
+					++moments.changes;
+				}
+				classifier.accumulate(*color, index, moments);
+			}
+		}
+		return moments;
+	}
+
+	using concurrent_processing = HorizontalStripes;
+};
+Q_STATIC_ASSERT((Concurrency::supported<BatchLearningMapper>::value));
+
+
+/*! Performs batch learning with the classes' moments in sourceImageColors.
+ * The image is classified concurrently in horizontal stripes, then all
+ * moments are moved to the mean of their pixels.  This is repeated until no
+ * pixel changes its class.  Sets classifiedImage, or a null image when
+ * cancelled.
+ * \param[in] progressObserver Optional progress observer.
+ * eturn Quality of learning. */
+double Vectorizer::performBatchLearning(ProgressObserver* progressObserver)
+{
+	classifiedImage = QImage(sourceImage.size(), QImage::Format_Indexed8);
+	classifiedImage.setColorCount(256);
+	classifiedImage.fill(0);
+
+	auto classifier = ColorClassifier(sourceImageColors);
+	auto const mapFunctor = BatchLearningMapper(classifier, *sourceImageColors[0]);
+	auto const numPixels = double(sourceImage.width()) * sourceImage.height();
+	double result = 0;
+	int percentage = 0;
+	for (int pass = 0; ; ++pass)
+	{
+		// The jobs do not report progress. The observer's progress is set
+		// from the number of changes after each pass.
+		auto jobs = [&]() {
+			if (!progressObserver)
+				return Concurrency::process<ColorClassifier::Moments>(nullptr, mapFunctor, sourceImage, classifiedImage);
+			auto passProgress = Concurrency::TransformedProgress{*progressObserver, 0, double(percentage)};
+			return Concurrency::process<ColorClassifier::Moments>(&passProgress, mapFunctor, sourceImage, classifiedImage);
+		}();
+		if (progressObserver && progressObserver->isInterruptionRequested())
+		{
+			classifiedImage = QImage();
+			return 0;
+		}
+
+		auto moments = ColorClassifier::Moments();
+		for (auto& job : jobs)
+			moments += job.future.result();
+		result = moments.quality;
+		classifier.setMeans(moments);
+
+		if (progressObserver)
+		{
+			percentage = 100 - static_cast<int>(100 * std::pow(moments.changes / numPixels, 0.2));
+			progressObserver->setPercentage(percentage);
+		}
+		// The initial classified image is not a result of classification.
+		if (moments.changes == 0 && pass > 0)
+			break;
+	}
+
+	classifier.assignTo(sourceImageColors);
+	return result;
+}
+
 /*! Returns colors found by classification process. */
 std::vector<QRgb> Vectorizer::getClassifiedColors()
 {
@@ -398,12 +503,12 @@ std::vector<QRgb> Vectorizer::getClassifiedColors()
 class ClassificationMapper
 {
 	const std::vector<std::shared_ptr<MapColor>>& sourceImageColors;
-	const KohonenMap& km;
+	const ColorClassifier& classifier;
 
 public:
-	ClassificationMapper(const std::vector<std::shared_ptr<MapColor>>& sic, KohonenMap& km)
+	ClassificationMapper(const std::vector<std::shared_ptr<MapColor>>& sic, const ColorClassifier& classifier)
 		: sourceImageColors(sic)
-		, km(km)
+		, classifier(classifier)
 	{}
 
 	double operator()(const QImage& sourceImage, QImage& outputImage, ProgressObserver& observer) const
@@ -417,13 +522,22 @@ public:
 		double quality = 0;
 		for (int y = 0; y < height && !observer.isInterruptionRequested(); y++)
 		{
+			auto index = -1;
+			auto last_rgb = QRgb(0);
+			auto last_squares = 0.0;
 			for (int x = 0; x < width; x++)
 			{
-				double distance;
-				color->setRGBTriplet(sourceImage.pixel(x, y));
-				int index = km.findClosest(*color, distance);
-				outputImage.setPixel(x, y, index);
-				quality += color->squares(*sourceImageColors[index]);
+				// Neighbor pixels often have the same color.
+				auto const rgb = sourceImage.pixel(x, y);
+				if (index < 0 || rgb != last_rgb)
+				{
+					color->setRGBTriplet(rgb);
+					index = classifier.findClosest(*color);
+					last_rgb = rgb;
+					last_squares = classifier.squares(*color, index);
+				}
+				outputImage.setPixel(x, y, uint(index));
+				quality += last_squares;
 			}
 			observer.setPercentage((100*y) / height);
 		}
@@ -447,14 +561,8 @@ QImage Vectorizer::getClassifiedImage(double* qualityPtr,
 			classifiedImage.setColor(i, sourceImageColors[i]->getRGBTriplet());
 		}
 
-		std::vector<OrganizableElement*> classes(sourceImageColors.size());
-		for (std::size_t i = 0; i < sourceImageColors.size(); i++)
-			classes[i] = sourceImageColors[i].get();
-
-		KohonenMap km;
-		km.setClasses(classes);
-
-		auto mapFunctor = ClassificationMapper(sourceImageColors, km);
+		auto const classifier = ColorClassifier(sourceImageColors);
+		auto mapFunctor = ClassificationMapper(sourceImageColors, classifier);
 		auto results = Concurrency::process<double>(progressObserver, mapFunctor, sourceImage, classifiedImage);
 		if (progressObserver && progressObserver->isInterruptionRequested())
 		{
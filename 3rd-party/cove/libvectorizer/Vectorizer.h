@@ -79,6 +79,7 @@ protected:
 	PatternStrategy patternStrategy;
 
 	void deleteColorsTable();
+	double performBatchLearning(ProgressObserver* progressObserver);
 
 public:
 	virtual ~Vectorizer();
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2026 Kai Pastor
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+
+#include "libvectorizer/ColorClassifier.h"
+#include "libvectorizer/KohonenMap.h"
+#include "libvectorizer/MapColor.h"
+#include "libvectorizer/PatternGetter.h"
+#include "libvectorizer/Vectorizer.h"
+// IWYU pragma: no_include "libvectorizer/ProgressObserver.h"
+
+using namespace cove;
+
+namespace {
+
+/// A deterministic source of pseudo-random colors.
+struct ColorGenerator
+{
+	unsigned state = 12345;
+	
+	int next(int range)
+	{
+		state = state * 1103515245u + 12345u;
+		return int((state >> 16) % unsigned(range));
+	}
+	
+	QRgb operator()()
+	{
+		auto const r = next(256);
+		auto const g = next(256);
+		auto const b = next(256);
+		return qRgb(r, g, b);
+	}
+};
+
+}  // namespace
+
+
+class ColorClassifierTest : public QObject
+{
+	Q_OBJECT
+	
+private slots:
+	void findClosestTest_data()
+	{
+		QTest::addColumn<double>("p");
+		
+		QTest::newRow("Hamming")   << 1.0;
+		QTest::newRow("Euclid")    << 2.0;
+		QTest::newRow("Minkowski") << 3.0;
+		QTest::newRow("Chebyshev") << std::numeric_limits<double>::infinity();
+	}
+	
+	void findClosestTest()
+	{
+		QFETCH(double, p);
+		
+		ColorGenerator generate;
+		std::vector<std::shared_ptr<MapColor>> classes;
+		std::vector<OrganizableElement*> elements;
+		for (int i = 0; i < 37; ++i)
+		{
+			classes.push_back(std::make_shared<MapColorRGB>(generate(), p));
+			elements.push_back(classes.back().get());
+		}
+		KohonenMap km;
+		km.setClasses(elements);
+		
+		auto const classifier = ColorClassifier(classes);
+		QCOMPARE(classifier.size(), classes.size());
+		
+		for (int i = 0; i < 1000; ++i)
+		{
+			auto const color = MapColorRGB(generate(), p);
+			double best_distance;
+			auto const expected = km.findClosest(color, best_distance);
+			auto const actual = classifier.findClosest(color);
+			QVERIFY(actual >= 0);
+			QVERIFY(actual < int(classes.size()));
+			if (actual != expected)
+				QCOMPARE(classes[std::size_t(actual)]->distance(color), best_distance);
+			QCOMPARE(classifier.squares(color, actual), color.squares(*classes[std::size_t(actual)]));
+		}
+	}
+	
+	void batchLearningTest()
+	{
+		// An image with four areas of similar colors
+		auto const base_colors = std::vector<QRgb>{ qRgb(250, 250, 250), qRgb(0, 0, 0), qRgb(200, 80, 0), qRgb(0, 100, 220) };
+		ColorGenerator generate;
+		auto image = QImage(128, 96, QImage::Format_RGB32);
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				auto const base = base_colors[std::size_t(2 * (2 * y / image.height()) + 2 * x / image.width())];
+				image.setPixel(x, y, qRgb(qBound(0, qRed(base) + generate.next(21) - 10, 255),
+				                          qBound(0, qGreen(base) + generate.next(21) - 10, 255),
+				                          qBound(0, qBlue(base) + generate.next(21) - 10, 255)));
+			}
+		}
+		auto const init_colors = std::vector<QRgb>{ qRgb(128, 128, 128), qRgb(64, 64, 64), qRgb(255, 0, 0), qRgb(0, 0, 255) };
+		
+		// Reference: sequential batch learning
+		std::vector<std::unique_ptr<MapColorRGB>> init;
+		std::vector<OrganizableElement*> elements;
+		for (auto rgb : init_colors)
+		{
+			init.push_back(std::make_unique<MapColorRGB>(rgb));
+			elements.push_back(init.back().get());
+		}
+		KohonenMap km;
+		km.setClasses(elements);
+		auto prototype = MapColorRGB();
+		SequentialPatternGetter pattern_getter(image, &prototype);
+		auto const expected_quality = km.performBatchLearning(pattern_getter);
+		auto const expected_classes = km.getClasses();
+		auto const& expected_image = *pattern_getter.getClassifiedImage();
+		
+		Vectorizer vectorizer(image);
+		vectorizer.setClassificationMethod(Vectorizer::KOHONEN_BATCH);
+		vectorizer.setNumberOfColors(int(init_colors.size()));
+		vectorizer.setInitColors(init_colors);
+		QVERIFY(vectorizer.performClassification());
+		
+		auto const colors = vectorizer.getClassifiedColors();
+		QCOMPARE(colors.size(), expected_classes.size());
+		for (std::size_t i = 0; i < colors.size(); ++i)
+		{
+			auto const expected = static_cast<const MapColor&>(*expected_classes[i]).getRGBTriplet();
+			QCOMPARE(qRed(colors[i]), qRed(expected));
+			QCOMPARE(qGreen(colors[i]), qGreen(expected));
+			QCOMPARE(qBlue(colors[i]), qBlue(expected));
+		}
+		
+		double quality;
+		auto const classified_image = vectorizer.getClassifiedImage(&quality);
+		QCOMPARE(quality, expected_quality);
+		QCOMPARE(classified_image.size(), image.size());
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+				QCOMPARE(classified_image.pixelIndex(x, y), expected_image.pixelIndex(x, y));
+		}
+	}
+	
+};
+
+QTEST_GUILESS_MAIN(ColorClassifierTest)
+#include "ColorClassifierTest.moc"  // IWYU pragma: keep
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 Kai Pastor
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+#include <QString>
+
+#include "libvectorizer/FIRFilter.h"
+// IWYU pragma: no_include "libvectorizer/ProgressObserver.h"
+
+using namespace cove;
+
+namespace {
+
+/// Provides access to the two-dimensional implementation.
+class MatrixFilter : public FIRFilter
+{
+public:
+	explicit MatrixFilter(const FIRFilter& filter)
+	    : FIRFilter(filter)
+	{
+		kernel.clear();
+	}
+};
+
+/// Returns a deterministic pseudo-random image.
+QImage randomImage(int width, int height)
+{
+	auto image = QImage(width, height, QImage::Format_RGB32);
+	unsigned state = 815;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			state = state * 1103515245u + 12345u;
+			image.setPixel(x, y, 0xff000000u | (state >> 8));
+		}
+	}
+	return image;
+}
+
+}  // namespace
+
+
+class FIRFilterTest : public QObject
+{
+	Q_OBJECT
+	
+private slots:
+	void separableTest_data()
+	{
+		QTest::addColumn<int>("radius");
+		QTest::addColumn<bool>("box");
+		
+		QTest::newRow("binomic 1") << 1 << false;
+		QTest::newRow("binomic 2") << 2 << false;
+		QTest::newRow("binomic 3") << 3 << false;
+		QTest::newRow("binomic 6") << 6 << false;
+		QTest::newRow("box 2")     << 2 << true;
+		QTest::newRow("box 3")     << 3 << true;
+		QTest::newRow("box 6")     << 6 << true;
+	}
+	
+	void separableTest()
+	{
+		QFETCH(int, radius);
+		QFETCH(bool, box);
+		
+		auto filter = FIRFilter(unsigned(radius));
+		if (box)
+			filter.box();
+		else
+			filter.binomic();
+		
+		auto const image = randomImage(61, 47);
+		auto const out_of_bounds = qRgb(127, 10, 200);
+		auto const actual = filter.apply(image, out_of_bounds);
+		auto const expected = MatrixFilter(filter).apply(image, out_of_bounds);
+		QCOMPARE(actual.size(), expected.size());
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				auto const a = actual.pixel(x, y);
+				auto const e = expected.pixel(x, y);
+				// Rounding may differ in the last bit.
+				if (std::abs(qRed(a) - qRed(e)) > 1
+				    || std::abs(qGreen(a) - qGreen(e)) > 1
+				    || std::abs(qBlue(a) - qBlue(e)) > 1)
+					QFAIL(qPrintable(QString::fromLatin1("Pixel %1,%2 differs").arg(x).arg(y)));
+			}
+		}
+	}
+	
+};
+
+QTEST_GUILESS_MAIN(FIRFilterTest)
+#include "FIRFilterTest.moc"  // IWYU pragma: keep
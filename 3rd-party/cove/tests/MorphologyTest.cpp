@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 Kai Pastor
+ *
+ * This file is part of CoVe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QImage>
+#include <QObject>
+#include <QRgb>
+
+#include "libvectorizer/Morphology.h"
+
+using namespace cove;
+
+namespace {
+
+/// Provides access to the tables and a per-pixel reference implementation.
+class ReferenceMorphology : public Morphology
+{
+public:
+	using Morphology::Morphology;
+	using Morphology::masks;
+	using Morphology::todelete;
+	using Morphology::isDeletable;
+	using Morphology::isInsertable;
+	using Morphology::isPrunable;
+	
+	static int neighborhood(const QImage& image, int x, int y)
+	{
+		int n = 0;
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				n <<= 1;
+				if (image.valid(x + dx, y + dy) && image.pixelIndex(x + dx, y + dy))
+					n |= 1;
+			}
+		}
+		return n;
+	}
+	
+	/// Applies the table to all pixels, using the given image as source.
+	static int apply(const bool* table, unsigned guard, bool insert, QImage& image)
+	{
+		auto const source = image.copy();
+		int hits = 0;
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x)
+			{
+				auto const n = neighborhood(source, x, y);
+				if (table[n] && !(unsigned(n) & guard))
+				{
+					image.setPixel(x, y, insert ? 1 : 0);
+					++hits;
+				}
+			}
+		}
+		return hits;
+	}
+	
+	static QImage rosenfeld(QImage image)
+	{
+		int count;
+		do
+		{
+			count = 0;
+			for (auto const m : masks)
+				count += apply(todelete, m, false, image);
+		}
+		while (count);
+		return image;
+	}
+};
+
+/// Returns a deterministic pseudo-random monochrome image.
+QImage randomImage(int width, int height, QImage::Format format, int density)
+{
+	auto image = QImage(width, height, format);
+	image.setColorCount(2);
+	image.setColor(0, qRgb(255, 255, 255));
+	image.setColor(1, qRgb(0, 0, 0));
+	unsigned state = 4711;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			state = state * 1103515245u + 12345u;
+			image.setPixel(x, y, int((state >> 16) % 100u) < density ? 1 : 0);
+		}
+	}
+	return image;
+}
+
+void compareImages(const QImage& actual, const QImage& expected)
+{
+	QCOMPARE(actual.size(), expected.size());
+	for (int y = 0; y < actual.height(); ++y)
+	{
+		for (int x = 0; x < actual.width(); ++x)
+		{
+			if (actual.pixelIndex(x, y) != expected.pixelIndex(x, y))
+				QFAIL(qPrintable(QString::fromLatin1("Pixel %1,%2 differs").arg(x).arg(y)));
+		}
+	}
+}
+
+}  // namespace
+
+
+class MorphologyTest : public QObject
+{
+	Q_OBJECT
+	
+private slots:
+	void morphologyTest_data()
+	{
+		QTest::addColumn<int>("width");
+		QTest::addColumn<int>("height");
+		QTest::addColumn<int>("format");
+		QTest::addColumn<int>("density");
+		
+		QTest::newRow("Mono small")    << 5   << 3   << int(QImage::Format_Mono)    << 50;
+		QTest::newRow("Mono 64")       << 64  << 64  << int(QImage::Format_Mono)    << 50;
+		QTest::newRow("Mono sparse")   << 130 << 37  << int(QImage::Format_Mono)    << 20;
+		QTest::newRow("Mono dense")    << 130 << 37  << int(QImage::Format_Mono)    << 80;
+		QTest::newRow("MonoLSB dense") << 199 << 101 << int(QImage::Format_MonoLSB) << 70;
+	}
+	
+	void morphologyTest()
+	{
+		QFETCH(int, width);
+		QFETCH(int, height);
+		QFETCH(int, format);
+		QFETCH(int, density);
+		
+		auto const image = randomImage(width, height, QImage::Format(format), density);
+		
+		{
+			ReferenceMorphology morphology(image);
+			QVERIFY(morphology.rosenfeld());
+			compareImages(morphology.getImage(), ReferenceMorphology::rosenfeld(image));
+		}
+		{
+			ReferenceMorphology morphology(image);
+			QVERIFY(morphology.erosion());
+			auto expected = image.copy();
+			ReferenceMorphology::apply(ReferenceMorphology::isDeletable, 0, false, expected);
+			compareImages(morphology.getImage(), expected);
+		}
+		{
+			ReferenceMorphology morphology(image);
+			QVERIFY(morphology.dilation());
+			auto expected = image.copy();
+			ReferenceMorphology::apply(ReferenceMorphology::isInsertable, 0, true, expected);
+			compareImages(morphology.getImage(), expected);
+		}
+		{
+			ReferenceMorphology morphology(image);
+			QVERIFY(morphology.pruning());
+			auto expected = image.copy();
+			ReferenceMorphology::apply(ReferenceMorphology::isPrunable, 0, false, expected);
+			compareImages(morphology.getImage(), expected);
+		}
+	}
+	
+};
+
+QTEST_GUILESS_MAIN(MorphologyTest)
+#include "MorphologyTest.moc"  // IWYU pragma: keep
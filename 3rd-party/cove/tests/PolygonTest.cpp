@@ -35,7 +35,9 @@
 #include <QFile>
 #include <QIODevice>
 #include <QImage>
+#include <QList>
 #include <QPointF>
+#include <QThreadPool>
 
 #include "libvectorizer/Polygons.h"
 
@@ -49,6 +51,56 @@
 #  define COVE_BENCHMARK
 #endif
 
+namespace {
+
+/*! Returns a small monochrome image with lines crossing the borders of
+ * the stripes and with junctions on the first or last row of a stripe,
+ * for 2, 3, 7, 16 or 24 stripes. */
+QImage stripesSample()
+{
+	QImage image(40, 24, QImage::Format_Mono);
+	image.fill(0);
+	auto hline = [&image](int y, int x0, int x1) {
+		for (int x = x0; x <= x1; ++x)
+			image.setPixel(x, y, 1);
+	};
+	auto vline = [&image](int x, int y0, int y1) {
+		for (int y = y0; y <= y1; ++y)
+			image.setPixel(x, y, 1);
+	};
+	vline(5, 0, 23);    // crosses all stripe borders
+	hline(11, 0, 12);   // crossing on the last row of the first of 2 stripes
+	hline(7, 5, 14);    // junction on the last row of a stripe (3, 16 stripes)
+	hline(16, 0, 5);    // junction on the first row of a stripe (3, 16 stripes)
+	hline(12, 10, 26);  // junction on the first row of the second of 2 stripes
+	vline(20, 12, 20);
+	for (int i = 0; i <= 8; ++i)
+		vline(28 + i / 3, i * 23 / 9, (i + 1) * 23 / 9);  // steep diagonal
+	hline(4, 32, 38);   // closed ring spanning several stripes
+	hline(19, 32, 38);
+	vline(32, 4, 19);
+	vline(38, 4, 19);
+	return image;
+}
+
+/*! Sets the maximum thread count of the global thread pool, which
+ * determines the number of stripes, and restores it on destruction. */
+struct ThreadCountRollback
+{
+	explicit ThreadCountRollback(int count)
+	: saved(QThreadPool::globalInstance()->maxThreadCount())
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(count);
+	}
+	~ThreadCountRollback()
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(saved);
+	}
+	const int saved;
+};
+
+}  // namespace
+
 void PolygonTest::initTestCase()
 {
 	QDir::addSearchPath(QStringLiteral("testdata"), QDir(QString::fromUtf8(COVE_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("data")));
@@ -97,6 +149,54 @@ void PolygonTest::testJoins()
 	compareResults(polys, resultFile);
 }
 
+void PolygonTest::testStripes_data()
+{
+	QTest::addColumn<QImage>("image");
+	QTest::addColumn<int>("speckleSize");
+	QTest::addColumn<QList<int>>("stripeCounts");
+
+	QImage sample;
+	QVERIFY(sample.load(QStringLiteral("testdata:PolygonTest1-sample.png")));
+	QTest::newRow("sample")
+		<< sample << 9 << QList<int>{ 2, 7, 64 };
+	QTest::newRow("borders and junctions")
+		<< stripesSample() << 0 << QList<int>{ 2, 3, 7, 16, 24 };
+}
+
+void PolygonTest::testStripes()
+{
+	QFETCH(QImage, image);
+	QFETCH(int, speckleSize);
+	QFETCH(QList<int>, stripeCounts);
+
+	cove::Polygons polyTracer;
+	polyTracer.setSimpleOnly(true);
+	polyTracer.setMaxDistance(5.0);
+	polyTracer.setSpeckleSize(speckleSize);
+	polyTracer.setDistDirRatio(0.0);
+
+	cove::PolygonList expected;
+	{
+		ThreadCountRollback rollback(1);
+		expected = polyTracer.createPolygonsFromImage(image);
+	}
+	QVERIFY(!expected.empty());
+
+	for (auto count : stripeCounts)
+	{
+		ThreadCountRollback rollback(count);
+		auto const polys = polyTracer.createPolygonsFromImage(image);
+		auto const message = "stripes: " + QByteArray::number(count);
+		QVERIFY2(polys.size() == expected.size(), message.constData());
+		for (std::size_t i = 0; i < polys.size(); ++i)
+		{
+			QVERIFY2(polys[i].isClosed() == expected[i].isClosed(), message.constData());
+			QVERIFY2(polys[i].size() == expected[i].size(), message.constData());
+			QVERIFY2(std::equal(polys[i].begin(), polys[i].end(), expected[i].begin()), message.constData());
+		}
+	}
+}
+
 void PolygonTest::saveResults(const cove::PolygonList& polys,
                               const QString& filename) const
 {
@@ -31,6 +31,9 @@ private slots:
 	void testJoins_data();
 	void testJoins();
 
+	void testStripes_data();
+	void testStripes();
+
 private:
 	void saveResults(const cove::PolygonList& polys,
 	                 const QString& filename) const;
@@ -27,6 +27,7 @@ import @MAPPER_APP_ID@.BuildConfig;
 import @MAPPER_APP_ID@.R;
 
 import android.app.AlertDialog;
+import android.content.ComponentCallbacks2;
 import android.content.DialogInterface;
 import android.content.Intent;
 import android.content.pm.ActivityInfo;
@@ -69,6 +70,27 @@ public class MapperActivity extends org.qtproject.qt5.android.bindings.QtActivit
 		instance = this;
 	}
 	
+	/** Lets the native code drop caches when the system runs low on memory. */
+	@Override
+	public void onTrimMemory(int level)
+	{
+		super.onTrimMemory(level);
+		if (level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW)
+		{
+			try
+			{
+				releaseMemory();
+			}
+			catch (UnsatisfiedLinkError e)
+			{
+				// The native library is not loaded yet.
+			}
+		}
+	}
+	
+	/** Releases memory which can be restored on demand, in the native code. */
+	private static native void releaseMemory();
+	
 	/** Call setIntent, as recommended for singleTask launch mode. */
 	@Override
 	public void onNewIntent(Intent intent)
@@ -56,7 +56,7 @@ void AutosavePrivate::settingsChanged()
 		autosave_interval = 0;
 		autosave_timer.stop();
 	}
-	else if (autosave_needed && !autosave_timer.isActive())
+	else if (autosave_needed && !autosave_pending && !autosave_timer.isActive())
 	{
 		// start autosave
 		autosave_timer.setInterval(autosave_interval);
@@ -75,7 +75,7 @@ void AutosavePrivate::setAutosaveNeeded(bool needed)
 	if (autosave_interval)
 	{
 		// autosaving enabled
-		if (autosave_needed && !autosave_timer.isActive())
+		if (autosave_needed && !autosave_pending && !autosave_timer.isActive())
 		{
 			autosave_timer.setInterval(autosave_interval);
 			autosave_timer.start();
@@ -90,21 +90,30 @@ void AutosavePrivate::setAutosaveNeeded(bool needed)
 void AutosavePrivate::autosave()
 {
 	Autosave::AutosaveResult result = document.autosave();
-	if (autosave_interval)
+	switch (result)
 	{
-		switch (result)
-		{
-		case Autosave::TemporaryFailure:
-			autosave_timer.setInterval(5000);
-			autosave_timer.start();
-			return;
-		case Autosave::Success:
-		case Autosave::PermanentFailure:
-			autosave_timer.setInterval(autosave_interval);
-			autosave_timer.start();
-			return;
-		}
-		Q_UNREACHABLE();
+	case Autosave::Pending:
+		// Wait for autosaveFinished()
+		autosave_pending = true;
+		return;
+	case Autosave::TemporaryFailure:
+		autosaveFinished(true);
+		return;
+	case Autosave::Success:
+	case Autosave::PermanentFailure:
+		autosaveFinished(false);
+		return;
+	}
+	Q_UNREACHABLE();
+}
+
+void AutosavePrivate::autosaveFinished(bool retry_soon)
+{
+	autosave_pending = false;
+	if (autosave_interval && autosave_needed)
+	{
+		autosave_timer.setInterval(retry_soon ? 5000 : autosave_interval);
+		autosave_timer.start();
 	}
 }
 
@@ -125,6 +134,12 @@ QString Autosave::autosavePath(const QString &path) const
 	return path + QLatin1String(".autosave");
 }
 
+void Autosave::autosaveFinished(AutosaveResult result)
+{
+	Q_ASSERT(result != Pending);
+	autosave_controller.autosaveFinished(result == TemporaryFailure);
+}
+
 void Autosave::setAutosaveNeeded(bool needed)
 {
 	autosave_controller.setAutosaveNeeded(needed);
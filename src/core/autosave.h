@@ -52,6 +52,8 @@ public:
 	
 	void setAutosaveNeeded(bool needed);
 	
+	void autosaveFinished(bool retry_soon);
+	
 public slots:
 	void autosave();
 	
@@ -64,6 +66,7 @@ private:
 	QTimer autosave_timer;
 	int  autosave_interval = 0;
 	bool autosave_needed = false;
+	bool autosave_pending = false;
 };
 
 
@@ -86,6 +89,10 @@ private:
  * regular autosaving period.
  * On temporary failure, autosave() will be called again after five seconds.
  * 
+ * Autosaving may also continue in the background. In this case, autosave()
+ * returns Pending, and the inheriting class must call autosaveFinished()
+ * with the actual result when done.
+ * 
  * The autosave period (in minutes) is taken from the setting
  * Settings::General_AutosaveInterval.
  */
@@ -97,7 +104,8 @@ public:
 	{
 		Success,          ///< Autosaving succeeded.
 		PermanentFailure, ///< Autosaving failed for some persistent reason.
-		TemporaryFailure  ///< Autosaving failed for some transient reason and shall be retried soon.
+		TemporaryFailure, ///< Autosaving failed for some transient reason and shall be retried soon.
+		Pending           ///< Autosaving continues in the background. The result is reported by autosaveFinished().
 	};
 	
 	/** @brief Returns the autosave file path for the given path. */
@@ -106,6 +114,9 @@ public:
 	/** @brief Performs an autosave, if possible. */
 	virtual AutosaveResult autosave() = 0;
 	
+	/** @brief Reports the result of an autosave which returned Pending. */
+	void autosaveFinished(AutosaveResult result);
+	
 	/** @brief Informs Autosave whether autosaving is needed or not. */
 	void setAutosaveNeeded(bool);
 	
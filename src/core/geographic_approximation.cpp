@@ -0,0 +1,130 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geographic_approximation.h"
+
+#include <cmath>
+
+#include "core/georeferencing.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The largest radius which is tried, in mm
+constexpr double max_radius = 64;
+
+/// The smallest radius which is tried, in mm
+constexpr double min_radius = 1;
+
+/// The step for the finite differences, in mm
+constexpr double step = 1;
+
+}  // namespace
+
+
+
+GeographicApproximation::GeographicApproximation(const Georeferencing& georef)
+: georef(georef)
+{
+	// nothing else
+}
+
+
+LatLon GeographicApproximation::toGeographicCoords(const MapCoordF& map_coords, bool* ok)
+{
+	if (valid
+	    && std::abs(map_coords.x() - center.x()) <= radius
+	    && std::abs(map_coords.y() - center.y()) <= radius)
+	{
+		if (ok)
+			*ok = true;
+		return approximate(map_coords);
+	}
+	
+	if (linearize(map_coords))
+	{
+		if (ok)
+			*ok = true;
+		return center_lat_lon;
+	}
+	
+	return georef.toGeographicCoords(map_coords, ok);
+}
+
+
+bool GeographicApproximation::linearize(const MapCoordF& map_coords)
+{
+	valid = false;
+	
+	bool ok = false;
+	center = map_coords;
+	center_lat_lon = georef.toGeographicCoords(center, &ok);
+	if (!ok)
+		return false;
+	
+	// Central differences
+	bool ok_east = false, ok_west = false, ok_south = false, ok_north = false;
+	auto const east = georef.toGeographicCoords(MapCoordF(center.x() + step, center.y()), &ok_east);
+	auto const west = georef.toGeographicCoords(MapCoordF(center.x() - step, center.y()), &ok_west);
+	auto const south = georef.toGeographicCoords(MapCoordF(center.x(), center.y() + step), &ok_south);
+	auto const north = georef.toGeographicCoords(MapCoordF(center.x(), center.y() - step), &ok_north);
+	if (!ok_east || !ok_west || !ok_south || !ok_north)
+		return false;
+	
+	lat_per_x = (east.latitude() - west.latitude()) / (2 * step);
+	lon_per_x = (east.longitude() - west.longitude()) / (2 * step);
+	lat_per_y = (south.latitude() - north.latitude()) / (2 * step);
+	lon_per_y = (south.longitude() - north.longitude()) / (2 * step);
+	
+	// The error grows with the distance from the center, so it is
+	// checked at opposite corners of the square.
+	auto const accurate = [this](const MapCoordF& corner) {
+		bool ok = false;
+		auto const expected = georef.toGeographicCoords(corner, &ok);
+		auto const actual = approximate(corner);
+		return ok
+		       && std::abs(expected.latitude() - actual.latitude()) <= tolerance
+		       && std::abs(expected.longitude() - actual.longitude()) <= tolerance;
+	};
+	for (radius = max_radius; radius >= min_radius; radius /= 4)
+	{
+		if (accurate(MapCoordF(center.x() + radius, center.y() + radius))
+		    && accurate(MapCoordF(center.x() - radius, center.y() - radius))
+		    && accurate(MapCoordF(center.x() + radius, center.y() - radius)))
+		{
+			valid = true;
+			break;
+		}
+	}
+	return valid;
+}
+
+
+LatLon GeographicApproximation::approximate(const MapCoordF& map_coords) const
+{
+	auto const dx = map_coords.x() - center.x();
+	auto const dy = map_coords.y() - center.y();
+	return { center_lat_lon.latitude() + lat_per_x * dx + lat_per_y * dy,
+	         center_lat_lon.longitude() + lon_per_x * dx + lon_per_y * dy };
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,103 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_GEOGRAPHIC_APPROXIMATION_H
+#define OPENORIENTEERING_GEOGRAPHIC_APPROXIMATION_H
+
+#include "core/latlon.h"
+#include "core/map_coord.h"
+
+namespace OpenOrienteering {
+
+class Georeferencing;
+
+
+/**
+ * A local linear approximation of the conversion from map coordinates to
+ * geographic coordinates.
+ * 
+ * Converting coordinates through PROJ is expensive for complex CRS
+ * pipelines. For frequent conversions of nearby points, such as the
+ * display of the cursor position, this class linearizes the conversion
+ * around a center point. The linearization is checked against PROJ, and
+ * it is used only within a radius where the error is below tolerance.
+ * Points outside this radius start a new linearization.
+ * 
+ * The approximation must be reset when the georeferencing changes.
+ */
+class GeographicApproximation
+{
+public:
+	/// The maximum accepted error, in degrees (about 1 cm)
+	static constexpr double tolerance = 1e-7;
+	
+	/**
+	 * Creates an approximation for the given georeferencing.
+	 * 
+	 * The georeferencing must outlive this object.
+	 */
+	explicit GeographicApproximation(const Georeferencing& georef);
+	
+	/**
+	 * Returns the georeferencing which is approximated.
+	 */
+	const Georeferencing& georeferencing() const { return georef; }
+	
+	/**
+	 * Converts map coordinates to geographic coordinates.
+	 * 
+	 * Cf. Georeferencing::toGeographicCoords(const MapCoordF&, bool*).
+	 */
+	LatLon toGeographicCoords(const MapCoordF& map_coords, bool* ok = nullptr);
+	
+	/**
+	 * Drops the current linearization.
+	 */
+	void reset() { valid = false; }
+	
+private:
+	/**
+	 * Linearizes the conversion around the given point.
+	 * 
+	 * Returns false if there is no radius where the approximation is
+	 * accurate enough.
+	 */
+	bool linearize(const MapCoordF& map_coords);
+	
+	/**
+	 * Returns the approximated geographic coordinates.
+	 */
+	LatLon approximate(const MapCoordF& map_coords) const;
+	
+	const Georeferencing& georef;
+	MapCoordF center;
+	LatLon center_lat_lon;
+	double lat_per_x = 0;
+	double lat_per_y = 0;
+	double lon_per_x = 0;
+	double lon_per_y = 0;
+	double radius = 0;  ///< Half the size of the valid square, in mm
+	bool valid = false;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_GEOGRAPHIC_APPROXIMATION_H
@@ -341,6 +341,46 @@ LatLon ProjTransform::inverse(const QPointF& projected_coords, bool* ok) const
 	return isGeographic() ? LatLon{northing, easting} : LatLon::fromRadiant(northing, easting);
 }
 
+std::vector<QPointF> ProjTransform::forward(const std::vector<LatLon>& lat_lon, bool* ok) const
+{
+	static auto const geographic_crs = ProjTransform(Georeferencing::geographic_crs_spec);
+	
+	auto const is_geographic = isGeographic();
+	std::vector<QPointF> points;
+	points.reserve(lat_lon.size());
+	for (auto const& item : lat_lon)
+	{
+		points.push_back(is_geographic
+		                 ? QPointF{item.longitude(), item.latitude()}
+		                 : QPointF{qDegreesToRadians(item.longitude()), qDegreesToRadians(item.latitude())});
+	}
+	auto const result = geographic_crs.isValid()
+	                    && (points.empty()
+	                        || pj_transform(geographic_crs.pj, pj, long(points.size()), 2, &points.front().rx(), &points.front().ry(), nullptr) == 0);
+	if (ok)
+		*ok = result;
+	return points;
+}
+
+std::vector<LatLon> ProjTransform::inverse(const std::vector<QPointF>& projected, bool* ok) const
+{
+	static auto const geographic_crs = ProjTransform(Georeferencing::geographic_crs_spec);
+	
+	auto points = projected;
+	auto const result = geographic_crs.isValid()
+	                    && (points.empty()
+	                        || pj_transform(pj, geographic_crs.pj, long(points.size()), 2, &points.front().rx(), &points.front().ry(), nullptr) == 0);
+	if (ok)
+		*ok = result;
+	
+	auto const is_geographic = isGeographic();
+	std::vector<LatLon> lat_lon;
+	lat_lon.reserve(points.size());
+	for (auto const& point : points)
+		lat_lon.push_back(is_geographic ? LatLon{point.y(), point.x()} : LatLon::fromRadiant(point.y(), point.x()));
+	return lat_lon;
+}
+
 QString ProjTransform::errorText() const
 {
 	auto err_no = *pj_get_errno_ref();
@@ -467,6 +507,51 @@ LatLon ProjTransform::inverse(const QPointF& projected_coords, bool* ok) const
 	return {pj_coord.lp.phi, pj_coord.lp.lam};
 }
 
+std::vector<QPointF> ProjTransform::forward(const std::vector<LatLon>& lat_lon, bool* ok) const
+{
+	std::vector<QPointF> points;
+	points.reserve(lat_lon.size());
+	for (auto const& item : lat_lon)
+		points.emplace_back(item.longitude(), item.latitude());
+	
+	proj_errno_reset(pj);
+	if (!points.empty())
+	{
+		auto const count = points.size();
+		proj_trans_generic(pj, PJ_FWD,
+		                   &points.front().rx(), sizeof(QPointF), count,
+		                   &points.front().ry(), sizeof(QPointF), count,
+		                   nullptr, 0, 0,
+		                   nullptr, 0, 0);
+	}
+	if (ok)
+		*ok = proj_errno(pj) == 0;
+	return points;
+}
+
+std::vector<LatLon> ProjTransform::inverse(const std::vector<QPointF>& projected, bool* ok) const
+{
+	auto points = projected;
+	proj_errno_reset(pj);
+	if (!points.empty())
+	{
+		auto const count = points.size();
+		proj_trans_generic(pj, PJ_INV,
+		                   &points.front().rx(), sizeof(QPointF), count,
+		                   &points.front().ry(), sizeof(QPointF), count,
+		                   nullptr, 0, 0,
+		                   nullptr, 0, 0);
+	}
+	if (ok)
+		*ok = proj_errno(pj) == 0;
+	
+	std::vector<LatLon> lat_lon;
+	lat_lon.reserve(points.size());
+	for (auto const& point : points)
+		lat_lon.emplace_back(point.y(), point.x());
+	return lat_lon;
+}
+
 QString ProjTransform::errorText() const
 {
 	auto err_no = proj_errno(pj);
@@ -1189,6 +1274,53 @@ MapCoordF Georeferencing::toMapCoordF(const LatLon& lat_lon, bool* ok) const
 	return toMapCoordF(toProjectedCoords(lat_lon, ok));
 }
 
+std::vector<QPointF> Georeferencing::toProjectedCoords(const MapCoordVectorF& map_coords) const
+{
+	// The transformation is affine, so the matrix is applied directly.
+	auto const& t = to_projected;
+	std::vector<QPointF> result;
+	result.reserve(map_coords.size());
+	for (auto const& coord : map_coords)
+		result.emplace_back(t.m11() * coord.x() + t.m21() * coord.y() + t.dx(),
+		                    t.m12() * coord.x() + t.m22() * coord.y() + t.dy());
+	return result;
+}
+
+MapCoordVectorF Georeferencing::toMapCoordF(const std::vector<QPointF>& projected_coords) const
+{
+	auto const& t = from_projected;
+	MapCoordVectorF result;
+	result.reserve(projected_coords.size());
+	for (auto const& coord : projected_coords)
+		result.emplace_back(t.m11() * coord.x() + t.m21() * coord.y() + t.dx(),
+		                    t.m12() * coord.x() + t.m22() * coord.y() + t.dy());
+	return result;
+}
+
+std::vector<LatLon> Georeferencing::toGeographicCoords(const MapCoordVectorF& map_coords, bool* ok) const
+{
+	return toGeographicCoords(toProjectedCoords(map_coords), ok);
+}
+
+std::vector<LatLon> Georeferencing::toGeographicCoords(const std::vector<QPointF>& projected_coords, bool* ok) const
+{
+	if (proj_transform.isValid())
+		return proj_transform.inverse(projected_coords, ok);
+	return std::vector<LatLon>(projected_coords.size());
+}
+
+std::vector<QPointF> Georeferencing::toProjectedCoords(const std::vector<LatLon>& lat_lon, bool* ok) const
+{
+	if (proj_transform.isValid())
+		return proj_transform.forward(lat_lon, ok);
+	return std::vector<QPointF>(lat_lon.size());
+}
+
+MapCoordVectorF Georeferencing::toMapCoordF(const std::vector<LatLon>& lat_lon, bool* ok) const
+{
+	return toMapCoordF(toProjectedCoords(lat_lon, ok));
+}
+
 MapCoordF Georeferencing::toMapCoordF(const Georeferencing* other, const MapCoordF& map_coords, bool* ok) const
 {
 	if (!other)
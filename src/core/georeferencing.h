@@ -69,6 +69,11 @@ struct ProjTransform
 	QPointF forward(const LatLon& lat_lon, bool* ok) const;
 	LatLon inverse(const QPointF& projected, bool* ok) const;
 	
+	/// Transforms many geographic coordinates in a single PROJ call.
+	std::vector<QPointF> forward(const std::vector<LatLon>& lat_lon, bool* ok) const;
+	/// Transforms many projected coordinates in a single PROJ call.
+	std::vector<LatLon> inverse(const std::vector<QPointF>& projected, bool* ok) const;
+	
 	QString errorText() const;
 	
 private:
@@ -507,6 +512,46 @@ public:
 	MapCoordF toMapCoordF(const Georeferencing* other, const MapCoordF& map_coords, bool* ok = nullptr) const;
 	
 	
+	/**
+	 * Transforms a list of map (paper) coordinates to projected coordinates.
+	 */
+	std::vector<QPointF> toProjectedCoords(const MapCoordVectorF& map_coords) const;
+	
+	/**
+	 * Transforms a list of projected coordinates to map (paper) coordinates.
+	 */
+	MapCoordVectorF toMapCoordF(const std::vector<QPointF>& projected_coords) const;
+	
+	/**
+	 * Transforms a list of map (paper) coordinates to geographic coordinates.
+	 * 
+	 * The PROJ transformation is done in a single call for the whole list.
+	 * ok is set to false if any of the coordinates fails to transform.
+	 */
+	std::vector<LatLon> toGeographicCoords(const MapCoordVectorF& map_coords, bool* ok = nullptr) const;
+	
+	/**
+	 * Transforms a list of CRS coordinates to geographic coordinates.
+	 * 
+	 * \see toGeographicCoords(const MapCoordVectorF&, bool*)
+	 */
+	std::vector<LatLon> toGeographicCoords(const std::vector<QPointF>& projected_coords, bool* ok = nullptr) const;
+	
+	/**
+	 * Transforms a list of geographic coordinates to CRS coordinates.
+	 * 
+	 * \see toGeographicCoords(const MapCoordVectorF&, bool*)
+	 */
+	std::vector<QPointF> toProjectedCoords(const std::vector<LatLon>& lat_lon, bool* ok = nullptr) const;
+	
+	/**
+	 * Transforms a list of geographic coordinates to map coordinates.
+	 * 
+	 * \see toGeographicCoords(const MapCoordVectorF&, bool*)
+	 */
+	MapCoordVectorF toMapCoordF(const std::vector<LatLon>& lat_lon, bool* ok = nullptr) const;
+	
+	
 	/**
 	 * Returns the current error text.
 	 */
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020, 2024, 2025 Kai Pastor
+ *    Copyright 2013-2020, 2024-2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -23,10 +23,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <Qt>
 #include <QtGlobal>
@@ -35,14 +40,19 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QIODevice>
+#include <QMetaObject>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QPoint>
 #include <QPointF>
+#include <QRectF>
+#include <QScopedValueRollback>
 #include <QSignalBlocker>
+#include <QSizeF>
 #include <QTimer>
 #include <QTranslator>
 
+#include "settings.h"
 #include "core/georeferencing.h"
 #include "core/map_color.h"
 #include "core/map_coord.h"
@@ -61,12 +71,15 @@
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
 #include "fileformats/xml_file_format_p.h"
+#include "gui/map/map_tile_store.h"
 #include "gui/map/map_widget.h"
 #include "templates/template.h"
 #include "undo/map_part_undo.h"
 #include "undo/object_undo.h"
 #include "undo/undo.h"
 #include "undo/undo_manager.h"
+#include "util/parallel.h"
+#include "util/trace.h"
 #include "util/util.h"
 #include "util/transformation.h"
 
@@ -119,6 +132,22 @@ struct MapColorSetMergeItem
 typedef std::vector<MapColorSetMergeItem> MapColorSetMergeList;
 
 
+/** The number of objects updated per batch in Map::updateDeferredObjects(). */
+constexpr std::size_t deferred_update_batch_size = 2000;
+
+/**
+ * The margin added to the coordinate extent of objects with deferred updates,
+ * in millimeters. It accounts for point symbols and texts.
+ */
+constexpr qreal deferred_update_margin = 5;
+
+/**
+ * The number of objects from which Map::clear() deletes the parts on a
+ * worker thread.
+ */
+constexpr int background_deletion_threshold = 10000;
+
+
 }  // namespace
 
 
@@ -210,6 +239,11 @@ MapColorMap Map::MapColorSet::importSet(const Map::MapColorSet& other, std::vect
 		
 		bool priorities_changed = false;
 		
+		// Bucket the existing colors by hash value, in the order of the colors
+		std::unordered_map<uint, std::vector<std::size_t>> color_buckets;
+		for (std::size_t k = 0, colors_size = colors.size(); k < colors_size; ++k)
+			color_buckets[colors[k]->hash()].push_back(k);
+		
 		// Initialize merge_list
 		auto merge_list_item = merge_list.begin();
 		for (std::size_t i = 0; i < other.colors.size(); ++i)
@@ -218,17 +252,21 @@ MapColorMap Map::MapColorSet::importSet(const Map::MapColorSet& other, std::vect
 			
 			MapColor* src_color = other.colors[i];
 			merge_list_item->src_color = src_color;
-			for (std::size_t k = 0, colors_size = colors.size(); k < colors_size; ++k)
+			auto const bucket = color_buckets.find(src_color->hash());
+			if (bucket != color_buckets.end())
 			{
-				if (colors[k]->equals(*src_color))
+				for (auto k : bucket->second)
 				{
-					merge_list_item->dest_color = colors[k];
-					merge_list_item->dest_index = k;
-					out_pointermap[src_color] = colors[k];
-					// Prefer a matching color at the same priority,
-					// so just abort early if priority matches
-					if (merge_list_item->dest_color->getPriority() == merge_list_item->src_color->getPriority())
-						break;
+					if (colors[k]->equals(*src_color))
+					{
+						merge_list_item->dest_color = colors[k];
+						merge_list_item->dest_index = k;
+						out_pointermap[src_color] = colors[k];
+						// Prefer a matching color at the same priority,
+						// so just abort early if priority matches
+						if (merge_list_item->dest_color->getPriority() == merge_list_item->src_color->getPriority())
+							break;
+					}
 				}
 			}
 			++merge_list_item;
@@ -396,7 +434,7 @@ MapColorMap Map::MapColorSet::importSet(const Map::MapColorSet& other, std::vect
 		
 		if (map && priorities_changed)
 		{
-			map->updateAllObjects();
+			map->updateAllMapWidgets();
 		}
 	}
 	
@@ -423,7 +461,10 @@ Map::Map()
  : color_set()
  , has_spot_colors(false)
  , undo_manager(new UndoManager(this))
+ , tile_store(new MapTileStore())
+ , frozen_tile_store(new MapTileStore())
  , renderables(new MapRenderables(this))
+ , frozen_renderables(new MapRenderables(this))
  , selection_renderables(new MapRenderables(this))
  , renderable_options(Symbol::RenderNormal)
  , printer_config(nullptr)
@@ -458,9 +499,31 @@ void Map::clear()
 	selection_renderables->clear();
 	
 	renderables->clear();
-	
-	for (MapPart* part : parts)
-		delete part;
+	frozen_renderables->clear();
+	deferred_updates.clear();
+	deferred_extents.clear();
+	deferred_updates_done = 0;
+	deferred_updates_drawn = {};
+	
+	auto num_objects = 0;
+	for (auto const* part : parts)
+		num_objects += part->getNumObjects();
+	if (num_objects >= background_deletion_threshold)
+	{
+		// Deleting the objects of a large map takes time. They are no longer
+		// accessed, so the parts are deleted on a worker thread.
+		for (MapPart* part : parts)
+			part->deleteTextObjects();
+		Util::startJob<void>([discarded_parts = std::move(parts)]() {
+			for (MapPart* part : discarded_parts)
+				delete part;
+		});
+	}
+	else
+	{
+		for (MapPart* part : parts)
+			delete part;
+	}
 	parts.clear();
 	current_part_index = 0;
 	
@@ -520,11 +583,11 @@ void Map::changeScale(unsigned int new_scale_denominator, double additional_stre
 	double factor = (getScaleDenominator() / (double)new_scale_denominator) * additional_stretch;
 	
 	if (scale_symbols)
-		scaleAllSymbols(factor);
+		scaleSymbols(factor);
 	if (scale_objects)
 	{
 		undo_manager->clear();
-		scaleAllObjects(factor, scaling_center);
+		scaleObjects(factor, scaling_center);
 		if (hasPrinterConfig())
 		{
 			auto print_area = printer_config->print_area;
@@ -556,6 +619,10 @@ void Map::changeScale(unsigned int new_scale_denominator, double additional_stre
 		}
 	}
 	
+	// A single update for scaled symbols and objects
+	if (scale_symbols || scale_objects)
+		updateTransformedObjects();
+	
 	setScaleDenominator(new_scale_denominator);
 	setOtherDirty();
 	updateAllMapWidgets();
@@ -567,7 +634,8 @@ void Map::rotateMap(double rotation, const MapCoord& center, bool adjust_georefe
 		return;
 	
 	undo_manager->clear();
-	rotateAllObjects(rotation, center);
+	rotateObjects(rotation, center);
+	updateTransformedObjects();
 	
 	if (adjust_georeferencing)
 	{
@@ -790,67 +858,204 @@ bool Map::importFromIODevice(QIODevice& device)
 }
 
 
+std::unique_ptr<Map> Map::createSnapshot() const
+{
+	auto snapshot = std::make_unique<Map>();
+	*snapshot->georeferencing = *georeferencing;
+	snapshot->grid = grid;
+	snapshot->renderable_options = renderable_options;
+	snapshot->symbol_set_id = symbol_set_id;
+	snapshot->map_notes = map_notes;
+	snapshot->image_template_defaults = image_template_defaults;
+	if (printer_config)
+		snapshot->printer_config.reset(new MapPrinterConfig(*printer_config));
+	
+	auto const color_map = snapshot->color_set->importSet(*color_set, nullptr, snapshot.get());
+	snapshot->has_spot_colors = has_spot_colors;
+	auto const symbol_map = snapshot->importSymbols(*this, color_map, -1, false);
+	
+	for (auto* part : snapshot->parts)
+		delete part;
+	snapshot->parts.clear();
+	snapshot->parts.reserve(parts.size());
+	for (auto const* part : parts)
+	{
+		std::vector<Object*> objects;
+		objects.reserve(std::size_t(part->getNumObjects()));
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			auto* duplicate = part->getObject(i)->duplicate();
+			// Objects may use symbols which are not owned by the map.
+			if (auto* symbol = symbol_map.value(duplicate->getSymbol()))
+				duplicate->setSymbol(symbol, true);
+			objects.push_back(duplicate);
+		}
+		auto* snapshot_part = new MapPart(part->getName(), snapshot.get());
+		snapshot->parts.push_back(snapshot_part);
+		snapshot_part->appendLoadedObjects(objects);
+	}
+	snapshot->current_part_index = current_part_index;
+	
+	snapshot->setHasUnsavedChanges(false);
+	return snapshot;
+}
+
+
 
 void Map::draw(QPainter* painter, const RenderConfig& config)
 {
+	MAPPER_TRACE_SCOPE("Map::draw");
+	
 	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	updateDirtyObjects();
+	
+	updateDeferredObjectsInRect(config.bounding_box);
 	
 	// The actual drawing
+	frozen_renderables->draw(painter, config);
 	renderables->draw(painter, config);
 }
 
 void Map::drawOverprintingSimulation(QPainter* painter, const RenderConfig& config)
 {
+	MAPPER_TRACE_SCOPE("Map::drawOverprintingSimulation");
+	
 	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	updateDirtyObjects();
+	
+	updateDeferredObjectsInRect(config.bounding_box);
 	
 	// The actual drawing
+	frozen_renderables->drawOverprintingSimulation(painter, config);
 	renderables->drawOverprintingSimulation(painter, config);
 }
 
+std::shared_ptr<const RenderablesSnapshot> Map::createRenderablesSnapshot(const RenderConfig& config)
+{
+	// Update the renderables of all objects marked as dirty
+	updateDirtyObjects();
+	updateDeferredObjectsInRect(config.bounding_box);
+	
+	return std::make_shared<const RenderablesSnapshot>(renderables->snapshot(config));
+}
+
+std::shared_ptr<const RenderablesSnapshot> Map::createFrozenRenderablesSnapshot(const RenderConfig& config)
+{
+	// Update the renderables of all objects marked as dirty
+	updateDirtyObjects();
+	updateDeferredObjectsInRect(config.bounding_box);
+	
+	return std::make_shared<const RenderablesSnapshot>(frozen_renderables->snapshot(config));
+}
+
 void Map::drawColorSeparation(QPainter* painter, const RenderConfig& config, const MapColor* spot_color, bool use_color)
 {
 	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	updateDirtyObjects();
+	
+	updateDeferredObjectsInRect(config.bounding_box);
 	
 	// The actual drawing
+	frozen_renderables->drawColorSeparation(painter, config, spot_color, use_color);
 	renderables->drawColorSeparation(painter, config, spot_color, use_color);
 }
 
+void Map::drawPreparedColorSeparation(QPainter* painter, const RenderConfig& config, const MapColor* spot_color, bool use_color) const
+{
+	frozen_renderables->drawColorSeparation(painter, config, spot_color, use_color);
+	renderables->drawColorSeparation(painter, config, spot_color, use_color);
+}
+
+void Map::drawPrepared(QPainter* painter, const RenderConfig& config) const
+{
+	frozen_renderables->draw(painter, config);
+	renderables->draw(painter, config);
+}
+
+void Map::drawPreparedOverprintingSimulation(QPainter* painter, const RenderConfig& config) const
+{
+	frozen_renderables->drawOverprintingSimulation(painter, config);
+	renderables->drawOverprintingSimulation(painter, config);
+}
+
 void Map::drawGrid(QPainter* painter, const QRectF& bounding_box)
 {
 	grid.draw(painter, bounding_box, this);
 }
 
-void Map::drawTemplates(QPainter* painter, const QRectF& bounding_box, int first_template, int last_template, const MapView* view, bool on_screen) const
+void Map::drawTemplates(QPainter* painter, const QRectF& bounding_box, int first_template, int last_template, const MapView* view, bool on_screen, bool full_opacity) const
 {
+	if (on_screen)
+		++template_draw_pass;
+	
 	for (int i = first_template; i <= last_template; ++i)
 	{
 		const Template* temp = getTemplate(i);
-		if (temp->getTemplateState() != Template::Loaded)
-			continue;
-		
-		double scale  = std::max(temp->getTemplateScaleX(), temp->getTemplateScaleY());
 		auto visibility = TemplateVisibility{ 1, true };
 		if (view)
 		{
 			visibility = view->getTemplateVisibility(temp);
 			visibility.visible &= visibility.opacity > 0;
-			scale *= view->getZoom();
+			if (on_screen)
+				visibility.visible &= temp->isVisibleAtZoom(view->getZoom());
+			if (full_opacity)
+				visibility.opacity = 1;
+		}
+		
+		if (visibility.visible
+		    && temp->isTemplateDataReleased()
+		    && temp->getTemplateState() == Template::Unloaded
+		    && temp->releasedBoundingBox().intersects(bounding_box))
+		{
+			if (on_screen)
+				temp->setLastDrawn(template_draw_pass);  // Reloaded by updateTemplateResidency()
+			else
+				const_cast<Template*>(temp)->loadTemplateFile();  // Needed now, e.g. for printing
 		}
+		if (temp->getTemplateState() != Template::Loaded)
+		{
+			if (on_screen && visibility.visible && temp->isLoadingAsync())
+			{
+				painter->save();
+				temp->drawTemplatePreview(painter, visibility.opacity);
+				painter->restore();
+			}
+			continue;
+		}
+		
+		double scale  = std::max(temp->getTemplateScaleX(), temp->getTemplateScaleY());
+		if (view)
+			scale *= view->getZoom();
 		if (visibility.visible)
 		{
+			if (on_screen)
+				temp->setLastDrawn(template_draw_pass);
 			Q_ASSERT(visibility.opacity == 1 || painter->paintEngine()->hasFeature(QPaintEngine::ConstantOpacity));
 			painter->save();
 			temp->drawTemplate(painter, bounding_box, scale, on_screen, visibility.opacity);
 			painter->restore();
 		}
 	}
+	
+	if (on_screen && !template_residency_pending)
+	{
+		template_residency_pending = true;
+		QMetaObject::invokeMethod(const_cast<Map*>(this), "updateTemplateResidency", Qt::QueuedConnection);
+	}
 }
 
 void Map::updateObjects()
 {
+	finishDeferredObjectUpdates();
+	updateDirtyObjects();
+}
+
+void Map::updateDirtyObjects()
+{
+	// Pending deferred updates are done in batches, and when drawn.
+	if (hasDeferredObjectUpdates())
+		return;
+	
 	// TODO: It maybe would be better if the objects entered themselves into a separate list when they get dirty so not all objects have to be traversed here
 	applyOnAllObjects(&Object::update);
 }
@@ -858,16 +1063,47 @@ void Map::updateObjects()
 void Map::removeRenderablesOfObject(const Object* object, bool mark_area_as_dirty)
 {
 	renderables->removeRenderablesOfObject(object, mark_area_as_dirty);
+	frozen_renderables->removeRenderablesOfObject(object, mark_area_as_dirty);
 	if (isObjectSelected(object))
 		removeSelectionRenderables(object);
 }
 void Map::insertRenderablesOfObject(const Object* object)
 {
-	renderables->insertRenderablesOfObject(object);
+	if (isObjectFrozen(object))
+		frozen_renderables->insertRenderablesOfObject(object);
+	else
+		renderables->insertRenderablesOfObject(object);
 	if (isObjectSelected(object))
 		addSelectionRenderables(object);
 }
 
+void Map::updateSpatialIndex(const Object* object) const
+{
+	for (const MapPart* part : parts)
+	{
+		if (part->updateSpatialIndex(object))
+			break;
+	}
+}
+
+void Map::updateSymbolIndex(Object* object, const Symbol* old_symbol)
+{
+	for (MapPart* part : parts)
+	{
+		if (part->updateSymbolIndex(object, old_symbol))
+			break;
+	}
+}
+
+void Map::updateTagIndex(const Object* object) const
+{
+	for (const MapPart* part : parts)
+	{
+		if (part->updateTagIndex(object))
+			break;
+	}
+}
+
 
 void Map::markAsIrregular(Object* object)
 {
@@ -958,13 +1194,14 @@ void Map::includeSelectionRect(QRectF& rect) const
 		rectIncludeSafe(rect, object->getExtent());
 }
 
-void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget, MapRenderables* replacement_renderables, bool draw_normal)
+void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget, MapRenderables* replacement_renderables, bool draw_normal, const QTransform& transform)
 {
 	MapView* view = widget->getMapView();
 	
 	painter->save();
 	painter->translate(widget->width() / 2.0 + view->panOffset().x(), widget->height() / 2.0 + view->panOffset().y());
 	painter->setWorldTransform(view->worldTransform(), true);
+	painter->setWorldTransform(transform, true);
 	
 	if (!replacement_renderables)
 		replacement_renderables = selection_renderables.data();
@@ -978,7 +1215,10 @@ void Map::drawSelection(QPainter* painter, bool force_min_size, MapWidget* widge
 		options |= RenderConfig::Highlighted;
 		selection_opacity = 0.4;
 	}
-	RenderConfig config = { *this, view->calculateViewedRect(widget->viewportToView(widget->rect())), view->calculateFinalZoomFactor(), options, selection_opacity };
+	auto bounding_box = view->calculateViewedRect(widget->viewportToView(widget->rect()));
+	if (!transform.isIdentity())
+		bounding_box = transform.inverted().mapRect(bounding_box);
+	RenderConfig config = { *this, bounding_box, view->calculateFinalZoomFactor(), options, selection_opacity };
 	replacement_renderables->draw(painter, config);
 	
 	painter->restore();
@@ -1001,6 +1241,34 @@ void Map::addObjectToSelection(Object* object, bool emit_selection_changed)
 		emit objectSelectionChanged();
 }
 
+std::size_t Map::addObjectsToSelection(const std::vector<Object*>& objects, bool emit_selection_changed)
+{
+	std::vector<const Object*> added;
+	added.reserve(objects.size());
+	object_selection.reserve(object_selection.size() + objects.size());
+	for (auto* object : objects)
+	{
+		// we omit hidden and protected objects from any kind of selection
+		const auto* object_symbol = object->getSymbol();
+		if (object_symbol->isProtected() || object_symbol->isHidden())
+			continue;
+		if (!object_selection.insert(object).second)
+			continue;
+		
+		added.push_back(object);
+		if (!first_selected_object)
+			first_selected_object = object;
+	}
+	
+	Object::updateAll(added);
+	for (const auto* object : added)
+		selection_renderables->insertRenderablesOfObject(object);
+	
+	if (emit_selection_changed && !added.empty())
+		emit objectSelectionChanged();
+	return added.size();
+}
+
 void Map::removeObjectFromSelection(Object* object, bool emit_selection_changed)
 {
 	bool removed = object_selection.erase(object);
@@ -1425,6 +1693,14 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 {
 	QHash<const Symbol*, Symbol*> out_pointermap;
 	
+	// Bucket the existing symbols by hash value, in the order of the symbols
+	std::unordered_map<uint, std::vector<Symbol*>> symbol_buckets;
+	if (merge_duplicates)
+	{
+		for (auto* symbol : symbols)
+			symbol_buckets[symbol->hash()].push_back(symbol);
+	}
+	
 	std::vector<Symbol*> created_symbols;
 	created_symbols.reserve(other.symbols.size());
 	for (std::size_t i = 0, last = other.symbols.size(); i < last; ++i)
@@ -1435,14 +1711,18 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 			if (merge_duplicates)
 			{
 				// Check if symbol is already present
-				auto match = std::find_if(begin(symbols), end(symbols), [symbol](auto s) {
-					return s->equals(symbol, Qt::CaseInsensitive);
-				});
-				if (match != end(symbols))
+				auto const bucket = symbol_buckets.find(symbol->hash());
+				if (bucket != symbol_buckets.end())
 				{
-					// Symbol is already present
-					out_pointermap.insert(symbol, *match);
-					continue;
+					auto match = std::find_if(begin(bucket->second), end(bucket->second), [symbol](auto s) {
+						return s->equals(symbol, Qt::CaseInsensitive);
+					});
+					if (match != end(bucket->second))
+					{
+						// Symbol is already present
+						out_pointermap.insert(symbol, *match);
+						continue;
+					}
 				}
 			}
 			
@@ -1676,14 +1956,34 @@ void Map::updateSymbolIcons(const MapColor* color)
 
 void Map::scaleAllSymbols(double factor)
 {
+	scaleSymbols(factor);
+	updateTransformedObjects();
+}
+
+void Map::scaleSymbols(double factor)
+{
+	// Symbols own their private parts and elements, so they can be scaled
+	// independently. Font data must not be shared between threads, so text
+	// symbols are scaled on the calling thread.
+	auto const has_text = [](const Symbol* symbol) {
+		return symbol->getContainedTypes().testFlag(Symbol::Text);
+	};
+	Util::parallelFor(symbols.size(), 16, [this, factor, &has_text](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			if (!has_text(symbols[i]))
+				symbols[i]->scale(factor);
+		}
+	});
+	
 	int size = getNumSymbols();
 	for (int i = 0; i < size; ++i)
 	{
 		Symbol* symbol = getSymbol(i);
-		symbol->scale(factor);
+		if (has_text(symbol))
+			symbol->scale(factor);
 		emit symbolChanged(i, symbol, symbol);
 	}
-	updateAllObjects();
 	
 	setSymbolsDirty();
 }
@@ -1693,9 +1993,8 @@ void Map::determineSymbolsInUse(std::vector< bool >& out) const
 	out.assign(symbols.size(), false);
 	for (auto part : parts)
 	{
-		for (int o = 0; o < part->getNumObjects(); ++o)
+		for (const Symbol* symbol : part->symbolsInUse())
 		{
-			const Symbol* symbol = part->getObject(o)->getSymbol();
 			int index = findSymbolIndex(symbol);
 			if (index >= 0)
 				out[index] = true;
@@ -1920,8 +2219,10 @@ void Map::setTemplateAreaDirty(Template* temp, const QRectF& area, int pixel_bor
 	for (MapWidget* widget : widgets)
 	{
 		const MapView* map_view = widget->getMapView();
-		if (map_view->isTemplateVisible(temp))
-			widget->markTemplateCacheDirty(map_view->calculateViewBoundingBox(area), pixel_border, front_cache);
+		auto const view_rect = map_view->calculateViewBoundingBox(area);
+		widget->markTemplateLayerDirty(temp, view_rect, pixel_border);
+		if (map_view->isTemplateDisplayed(temp))
+			widget->markTemplateCacheDirty(view_rect, pixel_border, front_cache);
 	}
 }
 
@@ -1969,13 +2270,17 @@ void Map::closeTemplate(int pos)
 {
 	auto temp = removeTemplate(pos);
 	
-	if (temp->getTemplateState() == Template::Loaded)
-		temp->unloadTemplateFile();
-	
+	// The data is kept for reopening, until updateTemplateResidency() needs the memory.
 	closed_templates.push_back(std::move(temp));
 	setTemplatesDirty();
 	if (closed_templates.size() == 1)
 		emit closedTemplateAvailabilityChanged();
+	
+	if (!template_residency_pending)
+	{
+		template_residency_pending = true;
+		QMetaObject::invokeMethod(this, "updateTemplateResidency", Qt::QueuedConnection);
+	}
 }
 
 bool Map::reloadClosedTemplate(int i, int target_pos, QWidget* dialog_parent, const QString& map_path)
@@ -2013,28 +2318,129 @@ void Map::loadTemplateFiles(const MapView& view)
 // cppcheck-suppress passedByValue
 void Map::loadTemplateFilesAsync(MapView& view, std::function<void(const QString&)> listener)
 {
-	(void)listener; // fix false-positive warning from misc-unused-parameters
-	
+	auto log = std::make_shared<std::function<void(const QString&)>>(std::move(listener));
+	auto pending = std::make_shared<int>(0);
 	for (auto& temp : templates)
 	{
 		if (temp->getTemplateState() == Template::Unloaded
 		    && view.getTemplateVisibility(temp.get()).visible)
 		{
-			QTimer::singleShot(10, temp.get(), ([this, &view, temp = temp.get(), log = std::move(listener)]() {
-				log(qApp->translate("OpenOrienteering::MainWindow", "Opening %1")
-				         .arg(temp->getTemplateFilename()));
-				if (temp->getTemplateState() != Template::Loaded)
-					temp->loadTemplateFile();
-				log(QString{});
-				loadTemplateFilesAsync(view, std::move(log));
-			}));
+			(*log)(qApp->translate("OpenOrienteering::MainWindow", "Opening %1")
+			       .arg(temp->getTemplateFilename()));
+			++*pending;
+			temp->loadTemplateFileAsync([log, pending]() {
+				if (--*pending == 0)
+					(*log)(QString{});
+			});
+		}
+	}
+}
+
+void Map::changeThreadAffinity(QThread* thread)
+{
+	moveToThread(thread);
+	georeferencing->moveToThread(thread);
+	for (auto& temp : templates)
+		temp->moveToThread(thread);
+	for (auto& temp : closed_templates)
+		temp->moveToThread(thread);
+}
+
+
+void Map::updateTemplateResidency()
+{
+	template_residency_pending = false;
+	auto const recent_pass = template_residency_pass;
+	template_residency_pass = template_draw_pass;
+	
+	// Reload released templates which are needed for drawing.
+	for (auto& temp : templates)
+	{
+		if (temp->isTemplateDataReleased()
+		    && temp->lastDrawn() > 0
+		    && temp->getTemplateState() == Template::Unloaded
+		    && !temp->isLoadingAsync())
+		{
+			temp->loadTemplateFileAsync({});
+		}
+	}
+	
+	auto const budget_mb = Settings::getInstance().getSettingCached(Settings::Templates_MemoryBudgetMB).toInt();
+	if (budget_mb <= 0)
+		return;
+	
+	auto const budget = qint64(budget_mb) << 20;
+	auto usage = qint64(0);
+	for (auto& temp : closed_templates)
+	{
+		if (temp->getTemplateState() == Template::Loaded)
+			usage += temp->memoryUsage();
+	}
+	std::vector<Template*> candidates;
+	for (auto& temp : templates)
+	{
+		if (temp->getTemplateState() != Template::Loaded)
+			continue;
+		
+		auto const template_usage = temp->memoryUsage();
+		usage += template_usage;
+		// Templates which were drawn since the last update are kept.
+		if (template_usage > 0 && temp->lastDrawn() <= recent_pass)
+			candidates.push_back(temp.get());
+	}
+	if (usage <= budget)
+		return;
+	
+	// Closed templates are unloaded first, the oldest first.
+	for (auto& temp : closed_templates)
+	{
+		if (temp->getTemplateState() != Template::Loaded)
+			continue;
+		
+		usage -= temp->memoryUsage();
+		temp->unloadTemplateFile();
+		if (usage <= budget)
 			return;
+	}
+	
+	std::sort(begin(candidates), end(candidates), [](auto const* a, auto const* b) {
+		return a->lastDrawn() < b->lastDrawn();
+	});
+	for (auto* temp : candidates)
+	{
+		auto const template_usage = temp->memoryUsage();
+		if (temp->releaseTemplateData())
+		{
+			usage -= template_usage;
+			if (usage <= budget)
+				break;
+		}
+	}
+}
+
+
+
+
+void Map::releaseHiddenTemplateData(const MapView& view)
+{
+	for (auto& temp : templates)
+	{
+		if (temp->getTemplateState() == Template::Loaded
+		    && !view.isTemplateDisplayed(temp.get()))
+		{
+			temp->releaseTemplateData();
 		}
 	}
+	for (auto& temp : closed_templates)
+	{
+		if (temp->getTemplateState() == Template::Loaded)
+			temp->unloadTemplateFile();
+	}
 }
 
 
 
+
 void Map::push(UndoStep *step)
 {
 	undo_manager->push(std::unique_ptr<UndoStep>(step));
@@ -2065,6 +2471,7 @@ void Map::removePart(std::size_t index)
 		setCurrentPartIndex((index == parts.size() - 1) ? (index - 1) : (index + 1));
 	
 	MapPart* part = parts[index];
+	auto const had_objects = part->getNumObjects() > 0;
 	
 	// FIXME: This loop should move to MapPart.
 	while(part->getNumObjects())
@@ -2079,7 +2486,8 @@ void Map::removePart(std::size_t index)
 	delete part;
 	
 	setOtherDirty();
-	updateAllMapWidgets();
+	if (had_objects)
+		updateAllMapWidgets();
 }
 
 int Map::findPartIndex(const MapPart* part) const
@@ -2114,33 +2522,94 @@ void Map::setCurrentPartIndex(std::size_t index)
 	}
 }
 
+void Map::setPartFrozen(std::size_t index, bool frozen)
+{
+	Q_ASSERT(index < parts.size());
+	
+	MapPart* const part = parts[index];
+	if (part->isFrozen() == frozen)
+		return;
+	
+	if (frozen && index == current_part_index && getNumSelectedObjects() > 0)
+		clearObjectSelection(true);
+	
+	part->setFrozen(frozen);
+	auto& source = frozen ? renderables : frozen_renderables;
+	auto& target = frozen ? frozen_renderables : renderables;
+	part->applyOnAllObjects([&source, &target](const Object* object) {
+		source->removeRenderablesOfObject(object, false);
+		target->insertRenderablesOfObject(object);
+	});
+	
+	auto const extent = part->calculateExtent(true);
+	if (extent.isValid())
+	{
+		tile_store->invalidate(extent);
+		frozen_tile_store->invalidate(extent);
+	}
+	
+	emit mapPartChanged(index, part);
+	updateAllMapWidgets();
+}
+
 int Map::reassignObjectsToMapPart(std::vector<int>::const_iterator first, std::vector<int>::const_iterator last, std::size_t source, std::size_t destination)
 {
 	Q_ASSERT(source < parts.size());
 	Q_ASSERT(destination < parts.size());
 	
+	auto const num_objects = int(std::distance(first, last));
+	transferObjects(source, std::vector<int>(first, last), destination);
+	return parts[destination]->getNumObjects() - num_objects;
+}
+
+void Map::transferObjects(std::size_t source, const std::vector<int>& indices, std::size_t destination, const std::vector<int>& positions)
+{
+	Q_ASSERT(source < parts.size());
+	Q_ASSERT(destination < parts.size());
+	Q_ASSERT(positions.empty() || positions.size() == indices.size());
+	
+	if (indices.empty())
+		return;
+	
 	MapPart* const source_part = parts[source];
 	MapPart* const target_part = parts[destination];
-	auto first_object = target_part->getNumObjects();
-	auto selection_size = getNumSelectedObjects();
-	for (auto it = first; it != last; ++it)
+	auto const selection_size = getNumSelectedObjects();
+	if (current_part_index == source && selection_size > 0)
 	{
-		Q_ASSERT(*it < source_part->getNumObjects());
-		Object* const object = source_part->getObject(*it);
-		
-		if (current_part_index == source && isObjectSelected(object))
-			removeObjectFromSelection(object, false);
-		
-		source_part->releaseObject(object);
-		target_part->addObject(object);
+		for (auto index : indices)
+		{
+			Q_ASSERT(index < source_part->getNumObjects());
+			Object* const object = source_part->getObject(index);
+			if (isObjectSelected(object))
+				removeObjectFromSelection(object, false);
+		}
+	}
+	
+	auto const objects = source_part->takeObjects(indices);
+	if (positions.empty())
+		target_part->adoptObjects(objects);
+	else
+		target_part->adoptObjects(objects, positions);
+	
+	if (source_part->isFrozen() != target_part->isFrozen())
+	{
+		// Relink without regenerating, and redraw both layers.
+		auto& from = source_part->isFrozen() ? frozen_renderables : renderables;
+		auto& to = source_part->isFrozen() ? renderables : frozen_renderables;
+		for (auto const* object : objects)
+		{
+			from->removeRenderablesOfObject(object, false);
+			to->insertRenderablesOfObject(object);
+			if (object->getExtent().isValid())
+				frozen_dirty_area.add(object->getExtent());
+		}
+		scheduleObjectAreaFlush();
 	}
 	
 	setOtherDirty();
 	
 	if (getNumSelectedObjects() != selection_size)
 		emit objectSelectionChanged();
-	
-	return first_object;
 }
 
 int Map::mergeParts(std::size_t source, std::size_t destination)
@@ -2148,19 +2617,14 @@ int Map::mergeParts(std::size_t source, std::size_t destination)
 	Q_ASSERT(source < parts.size());
 	Q_ASSERT(destination < parts.size());
 	
-	int count = 0;
 	MapPart* const source_part = parts[source];
 	MapPart* const target_part = parts[destination];
-	// Preserve order (but not efficient)
-	for (auto i = source_part->getNumObjects(); i > 0 ; --i)
+	auto const count = source_part->getNumObjects();
+	if (destination != source)
 	{
-		Object* object = source_part->getObject(0);
-		source_part->releaseObject(0);
-		
-		int index = target_part->getNumObjects();
-		target_part->addObject(object, index);
-		
-		++count;
+		std::vector<int> indices(std::size_t(count));
+		std::iota(begin(indices), end(indices), 0);
+		transferObjects(source, indices, destination);
 	}
 	
 	if (current_part_index == source)
@@ -2190,6 +2654,15 @@ int Map::addObject(Object* object, int part_index)
 	return object_index;
 }
 
+int Map::addObjects(const std::vector<Object*>& objects, int part_index)
+{
+	MapPart* part = parts[(part_index < 0) ? current_part_index : part_index];
+	int object_index = part->getNumObjects();
+	part->addObjects(objects);
+	
+	return object_index;
+}
+
 void Map::deleteObject(Object* object)
 {
 	delete releaseObject(object);
@@ -2241,8 +2714,63 @@ QRectF Map::calculateExtent(bool include_helper_symbols, bool include_templates,
 
 void Map::setObjectAreaDirty(const QRectF& map_coords_rect)
 {
-	for (MapWidget* widget : widgets)
-		widget->markObjectAreaDirty(map_coords_rect);
+	dirty_area.add(map_coords_rect);
+	scheduleObjectAreaFlush();
+}
+
+void Map::setObjectAreaDirty(const Object* object, const QRectF& map_coords_rect)
+{
+	if (isObjectFrozen(object))
+		frozen_dirty_area.add(map_coords_rect);
+	else
+		dirty_area.add(map_coords_rect);
+	scheduleObjectAreaFlush();
+}
+
+void Map::scheduleObjectAreaFlush()
+{
+	if (object_update_batch_level == 0 && !dirty_area_flush_pending
+	    && !(dirty_area.isEmpty() && frozen_dirty_area.isEmpty()))
+	{
+		dirty_area_flush_pending = true;
+		QMetaObject::invokeMethod(this, "flushObjectAreaDirty", Qt::QueuedConnection);
+	}
+}
+
+bool Map::hasFrozenParts() const
+{
+	return std::any_of(begin(parts), end(parts), [](const MapPart* part) {
+		return part->isFrozen();
+	});
+}
+
+bool Map::isObjectFrozen(const Object* object) const
+{
+	return std::any_of(begin(parts), end(parts), [object](const MapPart* part) {
+		return part->isFrozen() && part->contains(object);
+	});
+}
+
+void Map::flushObjectAreaDirty()
+{
+	dirty_area_flush_pending = false;
+	if (object_update_batch_level > 0)
+		return;
+	
+	for (auto const& rect : dirty_area.take())
+	{
+		tile_store->invalidate(rect);
+		for (MapWidget* widget : widgets)
+			widget->markObjectAreaDirty(rect);
+	}
+	// Some map tiles (e.g. overprinting simulation) show the frozen parts, too.
+	for (auto const& rect : frozen_dirty_area.take())
+	{
+		tile_store->invalidate(rect);
+		frozen_tile_store->invalidate(rect);
+		for (MapWidget* widget : widgets)
+			widget->markFrozenAreaDirty(rect);
+	}
 }
 
 void Map::findObjectsAt(
@@ -2317,6 +2845,13 @@ void Map::applyOnMatchingObjects(const std::function<void (Object*, MapPart*, in
 }
 
 
+void Map::applyOnMatchingObjectsConcurrently(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition)
+{
+	for (auto part : parts)
+		part->applyOnMatchingObjectsConcurrently(operation, condition);
+}
+
+
 void Map::applyOnAllObjects(const std::function<void (Object*)>& operation)
 {
 	for (auto part : parts)
@@ -2341,51 +2876,343 @@ void Map::applyOnAllObjects(const std::function<void (Object*, MapPart*, int)>&
 
 void Map::scaleAllObjects(double factor, const MapCoord& scaling_center)
 {
-	applyOnAllObjects(ObjectOp::Scale{factor, MapCoordF{scaling_center}});
+	scaleObjects(factor, scaling_center);
+	updateAllObjects();
+}
+
+void Map::scaleObjects(double factor, const MapCoord& scaling_center)
+{
+	auto const center = MapCoordF{scaling_center};
+	applyOnMatchingObjectsConcurrently([factor, center](Object* object, MapPart* /*part*/, int /*index*/) {
+		object->scale(center, factor);
+	}, [](const Object* /*object*/) { return true; });
 }
 
 void Map::rotateAllObjects(double rotation, const MapCoord& center)
 {
-	applyOnAllObjects(ObjectOp::Rotate{rotation, MapCoordF{center}});
+	rotateObjects(rotation, center);
+	updateAllObjects();
+}
+
+void Map::rotateObjects(double rotation, const MapCoord& center)
+{
+	auto const rotation_center = MapCoordF{center};
+	applyOnMatchingObjectsConcurrently([rotation, rotation_center](Object* object, MapPart* /*part*/, int /*index*/) {
+		object->rotateAround(rotation_center, rotation);
+	}, [](const Object* /*object*/) { return true; });
+}
+
+void Map::updateTransformedObjects()
+{
+	if (!object_updates_deferred)
+	{
+		updateAllObjects();
+		return;
+	}
+	
+	// Start with the objects which are visible in the first widget.
+	updateAllObjectsDeferred(deferredUpdateCenter());
+}
+
+MapCoordF Map::deferredUpdateCenter() const
+{
+	auto center = MapCoordF{};
+	if (!widgets.empty())
+		center = MapCoordF{widgets.front()->getMapView()->center()};
+	return center;
+}
+
+void Map::updateObjectsForSymbolChange(const std::vector<const Object*>& objects)
+{
+	if (!object_updates_deferred || objects.size() <= deferred_update_batch_size)
+	{
+		Object::updateAll(objects);
+		return;
+	}
+	
+	for (auto const* object : objects)
+		removeRenderablesOfObject(object, true);
+	updateObjectsDeferred(objects, deferredUpdateCenter());
 }
 
 void Map::updateAllObjects()
 {
-	applyOnAllObjects(&Object::forceUpdate);
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(getNumObjects()));
+	applyOnAllObjects([&objects](Object* object) {
+		object->setOutputDirty();
+		objects.push_back(object);
+	});
+	Object::updateAll(objects);
+}
+
+void Map::beginObjectUpdateBatch()
+{
+	++object_update_batch_level;
+}
+
+void Map::endObjectUpdateBatch()
+{
+	Q_ASSERT(object_update_batch_level > 0);
+	if (object_update_batch_level > 1)
+	{
+		--object_update_batch_level;
+		return;
+	}
+	
+	MAPPER_TRACE_SCOPE("Map::endObjectUpdateBatch");
+	// Collected objects may have been removed or deleted meanwhile,
+	// and the same object may have been collected more than once.
+	std::sort(begin(batched_updates), end(batched_updates));
+	batched_updates.erase(std::unique(begin(batched_updates), end(batched_updates)), end(batched_updates));
+	removeDetachedObjects(batched_updates);
+	Object::updateAll(batched_updates);
+	batched_updates.clear();
+	
+	object_update_batch_level = 0;
+	flushObjectAreaDirty();
+}
+
+void Map::removeDetachedObjects(std::vector<const Object*>& objects) const
+{
+	// Only the pointer values are compared, so deleted objects are fine.
+	objects.erase(std::remove_if(begin(objects), end(objects), [this](const Object* object) {
+		return std::none_of(begin(parts), end(parts), [object](const MapPart* part) {
+			return part->contains(object);
+		});
+	}), end(objects));
+}
+
+void Map::updateObject(const Object* object)
+{
+	if (object_update_batch_level > 0)
+		batched_updates.push_back(object);
+	else
+		object->update();
+}
+
+void Map::updateAllObjectsDeferred(const MapCoordF& center)
+{
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(getNumObjects()));
+	applyOnAllObjects([&objects](Object* object) {
+		object->setOutputDirty();
+		objects.push_back(object);
+	});
+	updateObjectsDeferred(objects, center);
+}
+
+void Map::updateObjectsDeferred(const std::vector<const Object*>& new_objects, const MapCoordF& center)
+{
+	struct Item
+	{
+		qreal distance;
+		QRectF extent;
+		const Object* object;
+	};
+	std::vector<Item> objects;
+	objects.reserve(new_objects.size());
+	std::for_each(begin(new_objects), end(new_objects), [&objects, center](const Object* object) {
+		auto distance = qreal(0);
+		auto extent = QRectF();
+		auto const& coords = object->getRawCoordinateVector();
+		if (!coords.empty())
+		{
+			auto const offset = MapCoordF(coords.front()) - center;
+			distance = offset.x() * offset.x() + offset.y() * offset.y();
+			extent = QRectF(MapCoordF(coords.front()), QSizeF(0, 0));
+			for (auto const& coord : coords)
+				rectInclude(extent, MapCoordF(coord));
+			auto margin = deferred_update_margin;
+			if (auto const* symbol = object->getSymbol())
+				margin += symbol->calculateLargestLineExtent();
+			extent.adjust(-margin, -margin, margin, margin);
+		}
+		objects.push_back({ distance, extent, object });
+	});
+	std::stable_sort(begin(objects), end(objects), [](const auto& a, const auto& b) {
+		return a.distance < b.distance;
+	});
+	
+	// Pending updates of other objects come first, in their current order.
+	auto const was_pending = hasDeferredObjectUpdates();
+	std::vector<const Object*> pending_updates;
+	std::vector<QRectF> pending_extents;
+	if (was_pending)
+	{
+		std::unordered_set<const Object*> const scheduled { begin(new_objects), end(new_objects) };
+		for (auto i = deferred_updates_done; i < deferred_updates.size(); ++i)
+		{
+			if (!scheduled.count(deferred_updates[i]))
+			{
+				pending_updates.push_back(deferred_updates[i]);
+				pending_extents.push_back(deferred_extents[i]);
+			}
+		}
+	}
+	
+	deferred_updates = std::move(pending_updates);
+	deferred_extents = std::move(pending_extents);
+	deferred_updates_done = 0;
+	deferred_updates_drawn = {};
+	deferred_updates.reserve(deferred_updates.size() + objects.size());
+	deferred_extents.reserve(deferred_extents.size() + objects.size());
+	for (auto const& item : objects)
+	{
+		deferred_updates.push_back(item.object);
+		deferred_extents.push_back(item.extent);
+	}
+	
+	if (hasDeferredObjectUpdates() && !was_pending)
+		QMetaObject::invokeMethod(this, "updateDeferredObjects", Qt::QueuedConnection);
+}
+
+void Map::updateDeferredObjects()
+{
+	if (!hasDeferredObjectUpdates())
+		return;
+	
+	MAPPER_TRACE_SCOPE("Map::updateDeferredObjects");
+	auto const first = begin(deferred_updates) + std::ptrdiff_t(deferred_updates_done);
+	auto const count = std::min(deferred_update_batch_size, deferred_updates.size() - deferred_updates_done);
+	auto objects = std::vector<const Object*>(first, first + std::ptrdiff_t(count));
+	removeDetachedObjects(objects);
+	Object::updateAll(objects);
+	deferred_updates_done += count;
+	
+	if (deferred_updates_done < deferred_updates.size())
+	{
+		emit deferredObjectUpdatesProgress(int(deferred_updates_done), int(deferred_updates.size()));
+		QMetaObject::invokeMethod(this, "updateDeferredObjects", Qt::QueuedConnection);
+		return;
+	}
+	
+	deferred_updates.clear();
+	deferred_extents.clear();
+	deferred_updates_done = 0;
+	deferred_updates_drawn = {};
+	emit deferredObjectUpdatesFinished();
+}
+
+void Map::finishDeferredObjectUpdates()
+{
+	if (!hasDeferredObjectUpdates())
+		return;
+	
+	auto objects = std::vector<const Object*>(begin(deferred_updates) + std::ptrdiff_t(deferred_updates_done), end(deferred_updates));
+	removeDetachedObjects(objects);
+	Object::updateAll(objects);
+	deferred_updates.clear();
+	deferred_extents.clear();
+	deferred_updates_done = 0;
+	deferred_updates_drawn = {};
+	emit deferredObjectUpdatesFinished();
+}
+
+void Map::updateDeferredObjectsInRect(const QRectF& map_rect)
+{
+	if (!hasDeferredObjectUpdates() || deferred_updates_drawn.contains(map_rect))
+		return;
+	
+	MAPPER_TRACE_SCOPE("Map::updateDeferredObjectsInRect");
+	std::vector<const Object*> objects;
+	for (auto i = deferred_updates_done; i < deferred_updates.size(); ++i)
+	{
+		auto const& extent = deferred_extents[i];
+		if (!extent.isValid() || extent.intersects(map_rect))
+			objects.push_back(deferred_updates[i]);
+	}
+	removeDetachedObjects(objects);
+	// Objects which are updated here are skipped by the next batches.
+	Object::updateAll(objects);
+	
+	// Only a single area is remembered, the most recent one.
+	deferred_updates_drawn = map_rect;
 }
 
 void Map::updateAllObjectsWithSymbol(const Symbol* symbol)
 {
-	applyOnMatchingObjects(&Object::forceUpdate, ObjectOp::HasSymbol{symbol});
+	std::vector<const Object*> objects;
+	for (MapPart* part : parts)
+	{
+		for (Object* object : part->objectsWithSymbol(symbol))
+		{
+			object->setOutputDirty();
+			objects.push_back(object);
+		}
+	}
+	updateObjectsForSymbolChange(objects);
+}
+
+void Map::updateObjectsForRenderableOptions(const std::function<bool (const Object*)>& condition)
+{
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(getNumObjects()));
+	applyOnMatchingObjects([&objects](Object* object) {
+		objects.push_back(object);
+	}, condition);
+	Object::updateAllForRenderableOptions(objects);
+}
+
+void Map::releaseRenderablesVariants()
+{
+	applyOnAllObjects([](Object* object) {
+		object->releaseRenderablesVariant();
+	});
 }
 
 void Map::changeSymbolForAllObjects(const Symbol* old_symbol, const Symbol* new_symbol)
 {
-	applyOnMatchingObjects(ObjectOp::ChangeSymbol{new_symbol}, ObjectOp::HasSymbol{old_symbol});
+	std::vector<const Object*> objects;
+	for (MapPart* part : parts)
+	{
+		for (Object* object : part->objectsWithSymbol(old_symbol))
+		{
+			if (!object->setSymbol(new_symbol, false))
+				part->deleteObject(object);
+			else
+				objects.push_back(object);
+		}
+	}
+	updateObjectsForSymbolChange(objects);
 }
 
 bool Map::deleteAllObjectsWithSymbol(const Symbol* symbol)
 {
-	bool exists = existsObject(ObjectOp::HasSymbol{symbol});
+	bool exists = existsObjectWithSymbol(symbol);
 	if (exists)
 	{
 		// Remove objects from selection
 		removeSymbolFromSelection(symbol, true);
 	
 		// Delete objects from map
-		applyOnMatchingObjects(ObjectOp::Delete(), ObjectOp::HasSymbol{symbol});
+		for (MapPart* part : parts)
+		{
+			for (Object* object : part->objectsWithSymbol(symbol))
+				part->deleteObject(object);
+		}
 	}
 	return exists;
 }
 
 bool Map::existsObjectWithSymbol(const Symbol* symbol) const
 {
-	return existsObject(ObjectOp::HasSymbol{symbol});
+	return std::any_of(begin(parts), end(parts), [symbol](const MapPart* part) {
+		return part->existsObjectWithSymbol(symbol);
+	});
 }
 
 void Map::setGeoreferencing(const Georeferencing& georeferencing)
 {
-	*this->georeferencing = georeferencing;
+	{
+		QScopedValueRollback<bool> rollback(setting_georeferencing, true);
+		*this->georeferencing = georeferencing;
+	}
+	
+	for (auto& temp : templates)
+		temp->updateGeoreferencing();
+	for (auto& temp : closed_templates)
+		temp->updateGeoreferencing();
 	setOtherDirty();
 }
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020, 2024 Kai Pastor
+ *    Copyright 2013-2020, 2024, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -27,6 +27,7 @@
 #include <functional>
 #include <memory>
 #include <set>
+#include <unordered_set>
 #include <vector>
 
 #include <QtGlobal>
@@ -45,10 +46,13 @@
 #include "core/map_coord.h"
 #include "core/map_grid.h"
 #include "core/map_part.h"
+#include "util/dirty_region.h"
+#include "util/key_value_container.h"
 // IWYU pragma: no_include "templates/template.h"
 
 class QIODevice;
 class QPainter;
+class QThread;
 class QTranslator;
 class QWidget;
 // IWYU pragma: no_forward_declare QRectF
@@ -62,11 +66,13 @@ class MapColor;
 class MapColorMap;
 class MapPrinterConfig;
 class MapRenderables;
+class MapTileStore;
 class MapView;
 class MapWidget;
 class Object;
 class PointSymbol;
 class RenderConfig;
+class RenderablesSnapshot;
 class Symbol;
 class Template;  // IWYU pragma: keep
 class TextSymbol;
@@ -94,8 +100,12 @@ friend class MapRenderables;
 friend class XMLFileImporter;
 friend class XMLFileExporter;
 public:
-	/** A set of selected objects represented by a std::set of object pointers. */
-	typedef std::set<Object*> ObjectSelection;
+	/**
+	 * A set of selected objects represented by a hash set of object pointers.
+	 * 
+	 * The iteration order is unspecified.
+	 */
+	typedef std::unordered_set<Object*> ObjectSelection;
 	
 	/**
 	 * Different strategies for importing elements from another map.
@@ -240,6 +250,20 @@ public:
 	 */
 	bool importFromIODevice(QIODevice& device);
 	
+	/**
+	 * Creates a snapshot of the map.
+	 * 
+	 * The snapshot is a new map with copies of the colors, symbols, parts and
+	 * objects, the georeferencing, the grid, the print configuration and the
+	 * map notes. It is not affected by later changes of this map, so it can be
+	 * handed to another thread, e.g. for exporting or printing. The objects
+	 * share their coordinates with the objects of this map until either of
+	 * them is modified. Thus taking a snapshot is cheap even for large maps.
+	 * 
+	 * Templates and undo steps are not part of the snapshot.
+	 */
+	std::unique_ptr<Map> createSnapshot() const;
+	
 	
 	/**
 	 * Draws the part of the map which is visible in the bounding box.
@@ -274,6 +298,62 @@ public:
 	void drawColorSeparation(QPainter* painter, const RenderConfig& config,
 		const MapColor* spot_color, bool use_color = false);
 	
+	/**
+	 * Draws the separation for a particular spot color, without updating
+	 * the renderables of objects which have changed.
+	 * 
+	 * This function does not modify the map. It may be called concurrently
+	 * from several threads, after a call to updateObjects(), as long as the
+	 * map is not modified meanwhile.
+	 * 
+	 * @see drawColorSeparation()
+	 */
+	void drawPreparedColorSeparation(QPainter* painter, const RenderConfig& config,
+		const MapColor* spot_color, bool use_color = false) const;
+	
+	/**
+	 * Draws the part of the map which is visible in the given bounding box,
+	 * without updating the renderables of objects which have changed.
+	 * 
+	 * This function does not modify the map. It may be called concurrently
+	 * from several threads, after a call to updateObjects(), as long as the
+	 * map is not modified meanwhile.
+	 * 
+	 * @see draw()
+	 */
+	void drawPrepared(QPainter* painter, const RenderConfig& config) const;
+	
+	/**
+	 * Draws a spot color overprinting simulation, without updating the
+	 * renderables of objects which have changed.
+	 * 
+	 * The same constraints as for drawPrepared() apply.
+	 * 
+	 * @see drawOverprintingSimulation()
+	 */
+	void drawPreparedOverprintingSimulation(QPainter* painter, const RenderConfig& config) const;
+	
+	/**
+	 * Creates a snapshot of the part of the map which is visible in the
+	 * config's bounding box.
+	 * 
+	 * The snapshot can be drawn on another thread, independent of subsequent
+	 * modifications of the map. The renderables of all objects marked as dirty
+	 * are updated first.
+	 * 
+	 * @param config  The rendering configuration
+	 */
+	std::shared_ptr<const RenderablesSnapshot> createRenderablesSnapshot(const RenderConfig& config);
+	
+	/**
+	 * Creates a snapshot of the frozen map parts, cf. createRenderablesSnapshot().
+	 * 
+	 * The other snapshot does not contain the objects of frozen parts.
+	 * 
+	 * @see setPartFrozen()
+	 */
+	std::shared_ptr<const RenderablesSnapshot> createFrozenRenderablesSnapshot(const RenderConfig& config);
+	
 	/**
 	 * Draws the map grid.
 	 * 
@@ -298,14 +378,20 @@ public:
 	 *     template visibilities.
 	 * @param on_screen Potentially enables some drawing optimizations which
 	 *     decrease drawing quality. Should be enabled when drawing on-screen.
+	 * @param full_opacity If set to true, visible templates are drawn with
+	 *     full opacity, regardless of the view's template opacity. This is
+	 *     useful for caching the appearance of single templates.
 	 */
 	void drawTemplates(QPainter* painter, const QRectF& bounding_box, int first_template,
-					   int last_template, const MapView* view, bool on_screen) const;
+					   int last_template, const MapView* view, bool on_screen, bool full_opacity = false) const;
 	
 	
 	/**
 	 * Updates the renderables and extent of all objects which have changed.
-	 * This is automatically called by draw(), you normally do not need to call it directly.
+	 * 
+	 * Pending deferred object updates are finished first. Drawing updates
+	 * the changed objects automatically, but it leaves deferred updates
+	 * outside the drawn area to the event loop.
 	 */
 	void updateObjects();
 	
@@ -330,6 +416,18 @@ public:
 	 */
 	void removeMapWidget(MapWidget* widget);
 	
+	/**
+	 * Returns the tile caches which are shared by the widgets of this map.
+	 */
+	MapTileStore& tileStore() { return *tile_store; }
+	
+	/**
+	 * Returns the tile caches for the frozen map parts.
+	 * 
+	 * These tiles are invalidated only when objects of frozen parts change.
+	 */
+	MapTileStore& frozenTileStore() { return *frozen_tile_store; }
+	
 	/**
 	 * Redraws all map widgets completely - this can be slow!
 	 * Try to avoid this and do partial redraws instead, if possible.
@@ -579,6 +677,9 @@ public:
 	
 	/**
 	 * Scales all symbols by the given factor.
+	 * 
+	 * The symbols are scaled concurrently. The objects are updated afterwards,
+	 * or scheduled for deferred updates, cf. setObjectUpdatesDeferred().
 	 */
 	void scaleAllSymbols(double factor);
 	
@@ -753,7 +854,11 @@ public:
 	
 	/**
 	 * Removes the template with the given index from the normal template list,
-	 * unloads the template file and adds the template to the closed template list.
+	 * and adds the template to the closed template list.
+	 * 
+	 * The template data stays loaded, so that reopening the template is
+	 * instant. updateTemplateResidency() unloads it when it doesn't fit into
+	 * the memory budget.
 	 * 
 	 * NOTE: if required, adjust first_front_template manually with setFirstFrontTemplate()!
 	 */
@@ -782,11 +887,61 @@ public:
 	/**
 	 * Requests all visible "unloaded" templates to be loaded asynchronously.
 	 * 
-	 * If the view is destroyed before template loading is finished, template
-	 * loading will be stopped. (The map must not be destroyed before the view.)
+	 * The template files are read in parallel on worker threads, where
+	 * supported by the template type, cf. Template::loadTemplateFileAsync().
+	 * The view is used only for selecting the templates.
 	 */
 	void loadTemplateFilesAsync(MapView& view, std::function<void(const QString&)> listener);
 	
+	/**
+	 * Changes the thread affinity of the map, of its georeferencing, and of
+	 * its templates.
+	 * 
+	 * This is needed for maps which are loaded on a worker thread. It must be
+	 * called from the map's current thread.
+	 */
+	void changeThreadAffinity(QThread* thread);
+	
+	/**
+	 * Releases the data of all templates which are hidden in the given view,
+	 * or outside of their zoom range, regardless of the memory budget.
+	 * The data of closed templates is unloaded, too.
+	 * 
+	 * This is meant for reacting to low memory conditions.
+	 */
+	void releaseHiddenTemplateData(const MapView& view);
+	
+public slots:
+	/**
+	 * Keeps the memory used by the templates within the budget.
+	 * 
+	 * Released templates which were needed for drawing on screen are loaded
+	 * again. If the template data exceeds the budget from the settings, the
+	 * data of closed templates is unloaded first, in the order of closing.
+	 * Then the templates which were not needed for the longest time are
+	 * released, until the data fits into the budget. Templates which were
+	 * needed in the latest drawing pass are kept.
+	 * 
+	 * This is scheduled by on-screen drawing of templates, and by closing
+	 * templates.
+	 */
+	void updateTemplateResidency();
+	
+	/**
+	 * Updates the next batch of objects scheduled by updateAllObjectsDeferred().
+	 */
+	void updateDeferredObjects();
+	
+	/**
+	 * Invalidates the areas collected by setObjectAreaDirty() in the tile
+	 * caches and in all map widgets.
+	 * 
+	 * This is scheduled by setObjectAreaDirty(), but it may be called
+	 * directly when the invalidation is needed immediately.
+	 */
+	void flushObjectAreaDirty();
+	
+public:
 	
 	// Undo & Redo
 	
@@ -860,6 +1015,26 @@ public:
 	 */
 	void setCurrentPartIndex(std::size_t index);
 	
+	/**
+	 * Freezes or unfreezes the map part with the given index.
+	 * 
+	 * The objects of a frozen part cannot be found by hit testing, so they
+	 * cannot be selected or edited with the tools. They are kept in separate
+	 * renderables, and map widgets draw them from separate tiles below the
+	 * other parts. Thus modifications of the other parts do not render the
+	 * frozen parts again. Printing and exporting draws the frozen parts below
+	 * the other parts, too.
+	 * 
+	 * Freezing the current part removes its objects from the selection.
+	 * The state of the parts is not saved with the map.
+	 */
+	void setPartFrozen(std::size_t index, bool frozen);
+	
+	/**
+	 * Returns true if at least one map part is frozen.
+	 */
+	bool hasFrozenParts() const;
+	
 	/**
 	 * Moves all specified objects from the source to the target map part.
 	 * 
@@ -874,6 +1049,21 @@ public:
 	 */
 	int reassignObjectsToMapPart(std::vector<int>::const_iterator first, std::vector<int>::const_iterator last, std::size_t source, std::size_t destination);
 	
+	/**
+	 * Moves the objects at the given indices from the source part to the
+	 * destination part, as a whole.
+	 * 
+	 * The indices must be distinct. The objects are appended in the order of
+	 * the indices, or, if positions is not empty, they are inserted such that
+	 * the i-th object ends up at positions[i] in the destination part.
+	 * 
+	 * The renderables of the objects are kept. They are only moved between
+	 * the map's containers when exactly one of the parts is frozen. Source
+	 * objects which were selected are removed from the object selection,
+	 * with a single objectSelectionChanged() signal.
+	 */
+	void transferObjects(std::size_t source, const std::vector<int>& indices, std::size_t destination, const std::vector<int>& positions = {});
+	
 	/**
 	 * Merges the source part with the destination part.
 	 * 
@@ -901,6 +1091,16 @@ public:
 	 */
 	int addObject(Object* object, int part_index = -1);
 	
+	/**
+	 * Adds the objects as new objects at the end of the part with the given
+	 * index, or of the current part if the default -1 is passed.
+	 * 
+	 * This is much faster than adding many objects one by one, cf.
+	 * MapPart::addObjects(). Returns the index of the first added object
+	 * in the part.
+	 */
+	int addObjects(const std::vector<Object*>& objects, int part_index = -1);
+	
 	/**
 	 * Deletes the given object from the map.
 	 * 
@@ -925,9 +1125,34 @@ public:
 	/**
 	 * Marks the area given by map_coords_rect as "dirty" in all map widgets,
 	 * i.e. as needing to be redrawn because some object(s) changed there.
+	 * 
+	 * The areas are collected in a DirtyRegion, and the tile caches and
+	 * widgets are invalidated once per event loop iteration, or at the end
+	 * of the current object update batch.
 	 */
 	void setObjectAreaDirty(const QRectF& map_coords_rect);
 	
+	/**
+	 * Marks the area of the given object as "dirty".
+	 * 
+	 * When the object is in a frozen part, this also invalidates the tiles of
+	 * the frozen parts. Otherwise it is the same as setObjectAreaDirty(rect).
+	 */
+	void setObjectAreaDirty(const Object* object, const QRectF& map_coords_rect);
+	
+private:
+	/**
+	 * Schedules flushObjectAreaDirty(), if needed and not done already.
+	 */
+	void scheduleObjectAreaFlush();
+	
+public:
+	
+	/**
+	 * Returns true if the object is in a frozen map part.
+	 */
+	bool isObjectFrozen(const Object* object) const;
+	
 	/**
 	 * Finds and returns all objects at the given position in the current part.
 	 * 
@@ -1012,6 +1237,19 @@ public:
 	 */
 	void applyOnMatchingObjects(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition);
 	
+	/**
+	 * Applies an operation concurrently on all objects which match a particular condition.
+	 * 
+	 * The condition is evaluated on the calling thread, and pending updates
+	 * of the matching objects are carried out before the operation starts.
+	 * The operation is called on the threads of the global thread pool. It
+	 * must be safe to call concurrently for different objects: It must neither
+	 * modify the map nor update objects. Results which need the map, such as
+	 * undo steps, are to be collected per object index, and to be merged on
+	 * the calling thread afterwards.
+	 */
+	void applyOnMatchingObjectsConcurrently(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition);
+	
 	/**
 	 * Applies an operation on all objects.
 	 */
@@ -1037,10 +1275,100 @@ public:
 	/** Forces an update of all objects, i.e. calls update(true) on each map object. */
 	void updateAllObjects();
 	
-	/** Forces an update of all objects with the given symbol. */
+	/**
+	 * Schedules an update of all objects, to be done in batches from the event loop.
+	 * 
+	 * Objects close to the given position are updated first, so that the
+	 * visible part of the map can be drawn early. Until all batches are done,
+	 * the extents and the spatial index are incomplete. updateObjects() and
+	 * finishDeferredObjectUpdates() do the pending updates immediately.
+	 * Objects which are removed from the map while updates are pending are
+	 * skipped.
+	 * 
+	 * Drawing updates the pending objects in the drawn area immediately,
+	 * selected by the extent of their coordinates.
+	 * 
+	 * deferredObjectUpdatesFinished() is emitted when all objects are updated.
+	 */
+	void updateAllObjectsDeferred(const MapCoordF& center);
+	
+	/** Returns true while objects are waiting for a deferred update. */
+	bool hasDeferredObjectUpdates() const { return !deferred_updates.empty(); }
+	
+	/** Immediately performs all pending deferred object updates. */
+	void finishDeferredObjectUpdates();
+	
+	/**
+	 * Returns true if bulk transformations defer the object updates.
+	 * 
+	 * \see setObjectUpdatesDeferred()
+	 */
+	bool objectUpdatesDeferred() const noexcept { return object_updates_deferred; }
+	
+	/**
+	 * Sets whether bulk transformations defer the object updates.
+	 * 
+	 * When enabled, scaleAllSymbols(), changeScale() and rotateMap() schedule
+	 * the update of all objects by updateAllObjectsDeferred(), starting at the
+	 * center of the first map widget, instead of updating them immediately.
+	 * This requires an event loop, and the caller must not delete objects
+	 * before deferredObjectUpdatesFinished() is emitted.
+	 * 
+	 * The default is false.
+	 */
+	void setObjectUpdatesDeferred(bool value) { object_updates_deferred = value; }
+	
+	/**
+	 * Starts collecting object updates and dirty areas.
+	 * 
+	 * Until the matching endObjectUpdateBatch(), objects which are put into
+	 * the map parts are not updated immediately, and the areas marked by
+	 * setObjectAreaDirty() are merged. Calls may be nested.
+	 */
+	void beginObjectUpdateBatch();
+	
+	/**
+	 * Ends collecting object updates and dirty areas.
+	 * 
+	 * When the outermost batch ends, the collected objects which are still
+	 * in the map are updated together, cf. Object::updateAll(), and the
+	 * collected areas are marked as dirty in all map widgets.
+	 */
+	void endObjectUpdateBatch();
+	
+	/**
+	 * Updates an object of the map, or collects it for the end of the
+	 * current batch.
+	 * 
+	 * \see beginObjectUpdateBatch()
+	 */
+	void updateObject(const Object* object);
+	
+	/**
+	 * Forces an update of all objects with the given symbol.
+	 * 
+	 * Many objects may be updated deferred, cf. setObjectUpdatesDeferred().
+	 */
 	void updateAllObjectsWithSymbol(const Symbol* symbol);
 	
-	/** For all symbols with old_symbol, replaces the symbol by new_symbol. */
+	/**
+	 * Updates the objects matching the condition after a change of the
+	 * renderable options, such as area hatching or baseline view.
+	 * 
+	 * The renderables for the previous options are kept, so that switching
+	 * back only exchanges the renderables.
+	 * \see Object::updateAllForRenderableOptions()
+	 */
+	void updateObjectsForRenderableOptions(const std::function<bool (const Object*)>& condition);
+	
+	/** Releases the renderables which objects keep for other renderable options. */
+	void releaseRenderablesVariants();
+	
+	/**
+	 * For all symbols with old_symbol, replaces the symbol by new_symbol.
+	 * 
+	 * Many objects may be updated deferred, cf. setObjectUpdatesDeferred().
+	 */
 	void changeSymbolForAllObjects(const Symbol* old_symbol, const Symbol* new_symbol);
 	
 	/**
@@ -1069,6 +1397,37 @@ public:
 	 */
 	void insertRenderablesOfObject(const Object* object);
 	
+	/**
+	 * Updates the spatial index of the map part which contains the object.
+	 * 
+	 * This must be called when the object's extent changed.
+	 * Object::update() takes care of this.
+	 */
+	void updateSpatialIndex(const Object* object) const;
+	
+	/**
+	 * Updates the symbol index of the map part which contains the object.
+	 * 
+	 * This must be called when the object's symbol changed.
+	 * Object::setSymbol() takes care of this.
+	 */
+	void updateSymbolIndex(Object* object, const Symbol* old_symbol);
+	
+	/**
+	 * Updates the tag index of the map part which contains the object.
+	 * 
+	 * This must be called when the object's tags changed.
+	 * Object's tag functions take care of this.
+	 */
+	void updateTagIndex(const Object* object) const;
+	
+	/**
+	 * Returns the pool of shared strings for the tags of the map's objects.
+	 * 
+	 * Object's tag functions and the importers take care of using this pool.
+	 */
+	StringPool& tagStrings() const { return tag_strings; }
+	
 	
 	/**
 	 * Marks an object as irregular.
@@ -1150,9 +1509,12 @@ public:
 	 *     Of the selection renderables. TODO: HACK
 	 * @param draw_normal If set to true, draws the objects like normal objects,
 	 *     otherwise draws transparent highlights.
+	 * @param transform A transformation of map coordinates which is applied
+	 *     to the renderables when drawing them.
 	 */
 	void drawSelection(QPainter* painter, bool force_min_size, MapWidget* widget,
-		MapRenderables* replacement_renderables = nullptr, bool draw_normal = false);
+		MapRenderables* replacement_renderables = nullptr, bool draw_normal = false,
+		const QTransform& transform = {});
 	
 	/**
 	 * Adds the given object to the selection.
@@ -1163,6 +1525,22 @@ public:
 	 */
 	void addObjectToSelection(Object* object, bool emit_selection_changed);
 	
+	/**
+	 * Adds the given objects to the selection.
+	 * 
+	 * Objects which are already selected, or which cannot be selected, are
+	 * skipped. The selection renderables of the added objects are generated
+	 * concurrently. This is much faster than separate calls to
+	 * addObjectToSelection() when selecting many objects.
+	 * 
+	 * @param objects The objects to add. The first selectable object becomes
+	 *     the first selected object if the selection was empty.
+	 * @param emit_selection_changed Set to true if objectSelectionChanged()
+	 *     should be emitted when at least one object was added.
+	 * @return The number of added objects.
+	 */
+	std::size_t addObjectsToSelection(const std::vector<Object*>& objects, bool emit_selection_changed);
+	
 	/**
 	 * Removes the given object from the selection.
 	 * @param object The object to remove.
@@ -1262,9 +1640,20 @@ public:
 	/**
 	 * Assigns georeferencing settings for the map from the given object and
 	 * sets the map to have unsaved changes.
+	 * 
+	 * The templates are adjusted once, by Template::updateGeoreferencing(),
+	 * instead of reacting to each of the georeferencing's change signals.
 	 */
 	void setGeoreferencing(const Georeferencing& georeferencing);
 	
+	/**
+	 * Returns true while setGeoreferencing() assigns the new georeferencing.
+	 * 
+	 * Templates shall ignore the georeferencing's change signals during this
+	 * time.
+	 */
+	bool isSettingGeoreferencing() const { return setting_georeferencing; }
+	
 	
 	/**
 	 * Returns the map's grid settings.
@@ -1428,6 +1817,13 @@ signals:
 	/** Emitted when the presence of spot colors in the map changes. */
 	void spotColorPresenceChanged(bool has_spot_colors) const;  // clazy:exclude=const-signal-or-slot
 	
+	/**
+	 * Emitted when an object of the map got new renderables and a new extent.
+	 * 
+	 * This follows changes of the object's coordinates or symbol.
+	 */
+	void objectUpdated(const OpenOrienteering::Object* object) const;  // clazy:exclude=const-signal-or-slot
+	
 	
 	/** Emitted when a symbol is added to the map, gives the symbol's index and pointer. */
 	void symbolAdded(int pos, const OpenOrienteering::Symbol* symbol);
@@ -1534,6 +1930,16 @@ signals:
 	 */
 	void mapPartDeleted(std::size_t index, const OpenOrienteering::MapPart* part);
 	
+	/**
+	 * Emitted after each batch of deferred object updates.
+	 */
+	void deferredObjectUpdatesProgress(int done, int total);
+	
+	/**
+	 * Emitted when all deferred object updates are done.
+	 */
+	void deferredObjectUpdatesFinished();
+	
 protected slots:
 	void checkSpotColorPresence();
 	
@@ -1600,6 +2006,76 @@ private:
 	);
 	
 	
+	/**
+	 * Updates the objects which have changed, for drawing.
+	 * 
+	 * Unlike updateObjects(), this does nothing while deferred object
+	 * updates are pending.
+	 */
+	void updateDirtyObjects();
+	
+	/**
+	 * Removes the objects which are no longer in a part of this map.
+	 * 
+	 * Deferred and batched updates keep plain pointers to objects, which
+	 * may have been removed or deleted meanwhile. The pointers are not
+	 * dereferenced.
+	 */
+	void removeDetachedObjects(std::vector<const Object*>& objects) const;
+	
+	/**
+	 * Updates the pending deferred objects which may intersect the given
+	 * rect, in map coordinates.
+	 */
+	void updateDeferredObjectsInRect(const QRectF& map_rect);
+	
+	/**
+	 * Scales all symbols without updating the objects.
+	 */
+	void scaleSymbols(double factor);
+	
+	/**
+	 * Scales all objects without updating them.
+	 */
+	void scaleObjects(double factor, const MapCoord& scaling_center);
+	
+	/**
+	 * Rotates all objects without updating them.
+	 */
+	void rotateObjects(double rotation, const MapCoord& center);
+	
+	/**
+	 * Updates all objects after a bulk transformation, immediately or
+	 * deferred according to objectUpdatesDeferred().
+	 */
+	void updateTransformedObjects();
+	
+	/**
+	 * Updates objects after a change of their symbol.
+	 * 
+	 * When object updates are deferred according to objectUpdatesDeferred(),
+	 * many objects are updated in batches from the event loop, starting with
+	 * the objects in the first map widget. Their old renderables are removed
+	 * immediately, because they may refer to a deleted symbol.
+	 * Otherwise, the objects are updated immediately.
+	 */
+	void updateObjectsForSymbolChange(const std::vector<const Object*>& objects);
+	
+	/**
+	 * Schedules the given objects for updates in batches from the event loop.
+	 * 
+	 * Objects close to the given position come first. Pending updates of
+	 * other objects are kept. Objects which are not dirty are skipped when
+	 * their batch is due, as in Object::updateAll().
+	 */
+	void updateObjectsDeferred(const std::vector<const Object*>& objects, const MapCoordF& center);
+	
+	/**
+	 * Returns the position where deferred updates shall start.
+	 */
+	MapCoordF deferredUpdateCenter() const;
+	
+	
 	void addSelectionRenderables(const Object* object);
 	void updateSelectionRenderables(const Object* object);
 	void removeSelectionRenderables(const Object* object);
@@ -1613,6 +2089,10 @@ private:
 	mutable qreal symbol_icon_scale = 0;
 	TemplateVector templates;
 	TemplateVector closed_templates;
+	mutable quint64 template_draw_pass = 0;                // counts on-screen drawing of templates
+	mutable bool template_residency_pending = false;     // updateTemplateResidency() is scheduled
+	bool setting_georeferencing = false;                 // setGeoreferencing() is in progress
+	quint64 template_residency_pass = 0;                 // template_draw_pass at the last residency update
 	int first_front_template = 0;		// index of the first template in templates which should be drawn in front of the map
 	PartVector parts;
 	ObjectSelection object_selection;
@@ -1620,8 +2100,22 @@ private:
 	QScopedPointer<UndoManager> undo_manager;
 	std::size_t current_part_index = 0;
 	WidgetVector widgets;
+	QScopedPointer<MapTileStore> tile_store;
+	QScopedPointer<MapTileStore> frozen_tile_store;
 	QScopedPointer<MapRenderables> renderables;
+	QScopedPointer<MapRenderables> frozen_renderables;  // renderables of frozen parts
 	QScopedPointer<MapRenderables> selection_renderables;
+	mutable StringPool tag_strings;                // shared keys and values of object tags
+	std::vector<const Object*> deferred_updates;  // objects scheduled by updateAllObjectsDeferred()
+	std::vector<QRectF> deferred_extents;         // coordinate extents of deferred_updates, with a margin
+	std::size_t deferred_updates_done = 0;        // number of deferred_updates which are done
+	QRectF deferred_updates_drawn;                // area in which all deferred_updates are done
+	bool object_updates_deferred = false;         // bulk transformations use deferred updates
+	std::vector<const Object*> batched_updates;   // objects collected by updateObject()
+	DirtyRegion dirty_area;                       // areas collected by setObjectAreaDirty()
+	DirtyRegion frozen_dirty_area;                // areas of objects in frozen parts
+	bool dirty_area_flush_pending = false;        // flushObjectAreaDirty() is scheduled
+	int object_update_batch_level = 0;            // nesting of beginObjectUpdateBatch()
 	
 	QString map_notes;
 	
@@ -26,6 +26,7 @@
 
 #include <Qt>
 #include <QCoreApplication>
+#include <QHash>
 #include <QLatin1Char>
 #include <QLatin1String>
 
@@ -152,6 +153,16 @@ bool MapColor::equals(const MapColor& other) const
 	return equals(other, false);
 }
 
+uint MapColor::hash() const
+{
+	auto seed = qHash(int(spot_color_method));
+	seed = qHash(int(cmyk_color_method), seed * 31);
+	seed = qHash(int(rgb_color_method), seed * 31);
+	seed = qHash(int(flags), seed * 31);
+	// Names are compared case-insensitively.
+	return qHash(name.toCaseFolded(), seed);
+}
+
 bool MapColor::equals(const MapColor& other, bool compare_priority) const
 {
 	return (!compare_priority || (priority == other.priority)) &&
@@ -420,6 +420,14 @@ public:
 	/** Compares this color and another, without looking at priorities. */
 	bool equals(const MapColor& other) const;
 	
+	/**
+	 * Returns a hash value which is consistent with equals().
+	 * 
+	 * The value covers the name and the color methods. Equal colors have
+	 * the same hash value, so it can be used to find candidates for equals().
+	 */
+	uint hash() const;
+	
 	/**
 	 * Compares two colors given by pointers, without looking at priorities.
 	 * 
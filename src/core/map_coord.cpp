@@ -255,6 +255,13 @@ MapCoord MapCoord::load(const QPointF& p, MapCoord::Flags flags)
 	return MapCoord::load(p.x(), p.y(), flags);
 }
 
+MapCoord MapCoord::loadNative64(qint64 x64, qint64 y64, MapCoord::Flags flags)
+{
+	handleBoundsOffset(x64, y64);
+	ensureBoundsForQint32(x64, y64);
+	return MapCoord { static_cast<qint32>(x64), static_cast<qint32>(y64), flags };
+}
+
 
 
 QString MapCoord::toString() const
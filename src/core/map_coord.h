@@ -467,6 +467,14 @@ public:
 	
 	static MapCoord load(const QPointF& p, int flags) = delete;
 	
+	/** Creates a MapCoord from native map coordinates, with offset handling.
+	 * 
+	 * This will initialize the boundsOffset() if necessary. Otherwise it will
+	 * apply the BoundsOffset() and throw a std::range_error if the adjusted
+	 * coordinates are out of bounds for qint32.
+	 */
+	static MapCoord loadNative64(qint64 x, qint64 y, MapCoord::Flags flags);
+	
 	
 	friend constexpr bool operator==(const MapCoord& lhs, const MapCoord& rhs);
 	friend constexpr MapCoord operator+(const MapCoord& lhs, const MapCoord& rhs);
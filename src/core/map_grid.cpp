@@ -21,8 +21,11 @@
 
 #include "map_grid.h"
 
+#include <functional>
+
 #include <QtMath>
 #include <QPainter>
+#include <QPointF>
 #include <QXmlStreamReader>
 
 #include "core/georeferencing.h"
@@ -34,6 +37,47 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Returns the spacing multiplied by the smallest power of two which makes it
+ * at least min_spacing.
+ */
+double thinnedSpacing(double spacing, double min_spacing)
+{
+	if (spacing > 0)
+	{
+		while (spacing < min_spacing)
+			spacing *= 2;
+	}
+	return spacing;
+}
+
+/**
+ * Calculates the grid lines for final parameters.
+ */
+std::vector<QLineF> gridLines(const QRectF& bounding_box, MapGrid::DisplayMode display,
+                              double horz_spacing, double vert_spacing,
+                              double horz_offset, double vert_offset, double rotation)
+{
+	std::vector<QLineF> lines;
+	auto add_line = std::function<void (const QPointF&, const QPointF&)>{ [&lines](const QPointF& p1, const QPointF& p2) {
+		lines.emplace_back(p1, p2);
+	} };
+	
+	if (display == MapGrid::AllLines)
+		Util::gridOperation(bounding_box, horz_spacing, vert_spacing, horz_offset, vert_offset, rotation, add_line);
+	else if (display == MapGrid::HorizontalLines)
+		Util::hatchingOperation(bounding_box, vert_spacing, vert_offset, rotation - M_PI / 2, add_line);
+	else // if (display == MapGrid::VerticalLines)
+		Util::hatchingOperation(bounding_box, horz_spacing, horz_offset, rotation, add_line);
+	return lines;
+}
+
+}  // namespace
+
+
+
 // ### MapGrid ###
 
 MapGrid::MapGrid()
@@ -92,11 +136,11 @@ const MapGrid& MapGrid::load(QXmlStreamReader& xml)
 
 void MapGrid::draw(QPainter* painter, const QRectF& bounding_box, Map* map, qreal scale_adjustment) const
 {
-	double final_horz_spacing, final_vert_spacing;
-	double final_horz_offset, final_vert_offset;
-	double final_rotation;
-	calculateFinalParameters(final_horz_spacing, final_vert_spacing, final_horz_offset, final_vert_offset, final_rotation, map);
-	
+	drawLines(painter, calculateLines(bounding_box, map), scale_adjustment);
+}
+
+void MapGrid::drawLines(QPainter* painter, const std::vector<QLineF>& lines, qreal scale_adjustment) const
+{
 	QPen pen(color);
 	if (qIsNull(scale_adjustment))
 	{
@@ -112,17 +156,20 @@ void MapGrid::draw(QPainter* painter, const QRectF& bounding_box, Map* map, qrea
 	painter->setPen(pen);
 	painter->setBrush(Qt::NoBrush);
 	painter->setOpacity(qAlpha(color) / 255.0);
+	if (!lines.empty())
+		painter->drawLines(lines.data(), int(lines.size()));
+}
+
+std::vector<QLineF> MapGrid::calculateLines(const QRectF& bounding_box, Map* map, double min_spacing) const
+{
+	double final_horz_spacing, final_vert_spacing;
+	double final_horz_offset, final_vert_offset;
+	double final_rotation;
+	calculateFinalParameters(final_horz_spacing, final_vert_spacing, final_horz_offset, final_vert_offset, final_rotation, map);
 	
-	auto draw_line = std::function<void (const QPointF&, const QPointF&)>{ [painter](const QPointF& p1, const QPointF& p2) {
-		painter->drawLine(p1, p2);
-	} };
-	
-	if (display == AllLines)
-		Util::gridOperation(bounding_box, final_horz_spacing, final_vert_spacing, final_horz_offset, final_vert_offset, final_rotation, draw_line);
-	else if (display == HorizontalLines)
-		Util::hatchingOperation(bounding_box, final_vert_spacing, final_vert_offset, final_rotation - M_PI / 2, draw_line);
-	else // if (display == VerticalLines)
-		Util::hatchingOperation(bounding_box, final_horz_spacing, final_horz_offset, final_rotation, draw_line);
+	return gridLines(bounding_box, display,
+	                 thinnedSpacing(final_horz_spacing, min_spacing), thinnedSpacing(final_vert_spacing, min_spacing),
+	                 final_horz_offset, final_vert_offset, final_rotation);
 }
 
 void MapGrid::calculateFinalParameters(double& final_horz_spacing, double& final_vert_spacing, double& final_horz_offset, double& final_vert_offset, double& final_rotation, Map* map) const
@@ -197,4 +244,37 @@ bool operator!=(const MapGrid& lhs, const MapGrid& rhs)
 }
 
 
+
+// ### MapGridCache ###
+
+const std::vector<QLineF>& MapGridCache::lines(const MapGrid& grid, const QRectF& bounding_box, Map* map, double min_spacing)
+{
+	std::array<double, 5> parameters;
+	grid.calculateFinalParameters(parameters[0], parameters[1], parameters[2], parameters[3], parameters[4], map);
+	parameters[0] = thinnedSpacing(parameters[0], min_spacing);
+	parameters[1] = thinnedSpacing(parameters[1], min_spacing);
+	
+	if (parameters != cached_parameters
+	    || grid.getDisplayMode() != cached_display
+	    || !cached_rect.contains(bounding_box))
+	{
+		// A margin of half the size avoids recalculation for small pan movements.
+		auto const margin_x = bounding_box.width() / 2;
+		auto const margin_y = bounding_box.height() / 2;
+		cached_rect = bounding_box.adjusted(-margin_x, -margin_y, margin_x, margin_y);
+		cached_parameters = parameters;
+		cached_display = grid.getDisplayMode();
+		cached_lines = gridLines(cached_rect, cached_display,
+		                         parameters[0], parameters[1], parameters[2], parameters[3], parameters[4]);
+	}
+	return cached_lines;
+}
+
+void MapGridCache::clear()
+{
+	cached_lines.clear();
+	cached_rect = {};
+}
+
+
 }  // namespace
@@ -22,10 +22,14 @@
 #ifndef OPENORIENTEERING_MAP_GRID_H
 #define OPENORIENTEERING_MAP_GRID_H
 
+#include <array>
+#include <vector>
+
+#include <QLineF>
+#include <QRectF>
 #include <QRgb>
 
 class QPainter;
-class QRectF;
 class QXmlStreamReader;
 class QXmlStreamWriter;
 
@@ -93,6 +97,22 @@ public:
 	void draw(QPainter* painter, const QRectF& bounding_box, Map* map, qreal scale_adjustment = 0) const;
 	void draw(QPainter* painter, const QRectF& bounding_box, Map* map, bool) const = delete;
 	
+	/**
+	 * Draws the given grid lines, with the pen and opacity of this grid.
+	 * 
+	 * For the parameters, see draw().
+	 */
+	void drawLines(QPainter* painter, const std::vector<QLineF>& lines, qreal scale_adjustment = 0) const;
+	
+	/**
+	 * Calculates the grid lines inside the bounding box.
+	 * 
+	 * When min_spacing is greater than zero, the spacing is multiplied by
+	 * the smallest power of two which makes it at least min_spacing (in
+	 * millimeters on the map). The result is a subset of the regular lines.
+	 */
+	std::vector<QLineF> calculateLines(const QRectF& bounding_box, Map* map, double min_spacing = 0) const;
+	
 	/**
 	 * Calculates the "final" parameters with the following properties:
 	 * - spacings and offsets are in millimeters on the map
@@ -155,6 +175,40 @@ private:
 	friend bool operator==(const MapGrid& lhs, const MapGrid& rhs);
 };
 
+
+
+/**
+ * A cache of the lines of a map grid for on-screen display.
+ * 
+ * The lines are calculated with a margin around the requested area, and they
+ * are thinned out according to the given minimum spacing. They are reused
+ * as long as the area stays inside the cached area and the final parameters
+ * of the grid remain the same. So repainting after map edits or for small
+ * pan movements does not need to calculate the grid again.
+ */
+class MapGridCache
+{
+public:
+	/**
+	 * Returns the lines of the grid which cover the bounding box.
+	 * 
+	 * The returned lines may extend beyond the bounding box.
+	 */
+	const std::vector<QLineF>& lines(const MapGrid& grid, const QRectF& bounding_box, Map* map, double min_spacing);
+	
+	/**
+	 * Discards the cached lines.
+	 */
+	void clear();
+	
+private:
+	std::vector<QLineF> cached_lines;
+	QRectF cached_rect;
+	std::array<double, 5> cached_parameters = {};
+	MapGrid::DisplayMode cached_display = MapGrid::AllLines;
+	
+};
+
 /**
  * Compares two map grid objects.
  * 
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2024 Kai Pastor
+ *    Copyright 2024, 2026 Kai Pastor
  *    Copyright 2024 Matthias Kühlewein
  *
  *    This file is part of OpenOrienteering.
@@ -21,6 +21,7 @@
 #include "map_information.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <iterator>
 // IWYU pragma: no_include <memory>
 #include <numeric>
@@ -32,10 +33,12 @@
 #include <QFontInfo>
 #include <QLatin1Char>
 #include <QLatin1String>
+#include <QLocale>
 
 #include "core/georeferencing.h"
 #include "core/map.h"
 #include "core/map_color.h"  // IWYU pragma: keep
+#include "core/map_memory_usage.h"
 #include "core/map_part.h"
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
@@ -103,6 +106,8 @@ private:
 	
 	std::vector<FontUsage> fonts;
 	
+	MapMemoryUsage memory_usage;
+	
 	/**
 	 * Returns the usage record for a given symbol type.
 	 */
@@ -111,6 +116,18 @@ private:
 
 
 
+namespace {
+
+QString memorySize(std::size_t bytes)
+{
+	if (bytes < 1024 * 1024)
+		return QCoreApplication::translate("OpenOrienteering::MapInformation", "%1 KiB").arg(QLocale().toString(double(bytes) / 1024, 'f', 1));
+	return QCoreApplication::translate("OpenOrienteering::MapInformation", "%1 MiB").arg(QLocale().toString(double(bytes) / (1024 * 1024), 'f', 1));
+}
+
+}  // namespace
+
+
 MapInformationBuilder::SymbolTypeUsage& MapInformationBuilder::getSymbolTypeUsage(Symbol::Type type)
 {
 	switch (type)
@@ -132,6 +149,7 @@ MapInformationBuilder::SymbolTypeUsage& MapInformationBuilder::getSymbolTypeUsag
 
 // retrieve and store the information
 MapInformationBuilder::MapInformationBuilder(const Map& map)
+: memory_usage(map)
 {
 	scale = int(map.getScaleDenominator());
 	
@@ -154,13 +172,8 @@ MapInformationBuilder::MapInformationBuilder(const Map& map)
 	templates_count = map.getNumTemplates();
 	
 	colors.reserve(map.getNumColors());
-	map.applyOnAllColors([this, &map](const auto* color){
+	map.applyOnAllColors([this](const auto* color){
 		colors.push_back({color->getName()});
-		
-		map.applyOnMatchingSymbols(
-		    [this](const Symbol* symbol) { colors.back().symbols.push_back(symbol->getNumberAndPlainTextName()); },
-		    [color](const Symbol* symbol) { return symbol->containsColor(color); }
-		    );
 	});
 	
 	getSymbolTypeUsage(Symbol::Point).name    = QCoreApplication::translate("OpenOrienteering::MapInformation", "Point symbols");
@@ -170,17 +183,23 @@ MapInformationBuilder::MapInformationBuilder(const Map& map)
 	getSymbolTypeUsage(Symbol::Text).name     = QCoreApplication::translate("OpenOrienteering::MapInformation", "Text symbols");
 	getSymbolTypeUsage(Symbol::NoSymbol).name = QCoreApplication::translate("OpenOrienteering::MapInformation", "Undefined symbols");
 	
+	// Each pair of symbol and color is tested once, for both lists.
 	symbols_count = map.getNumSymbols();
 	map.applyOnAllSymbols([this, &map](const Symbol* symbol){
 		auto& category = getSymbolTypeUsage(symbol->getType());
 		category.symbols.push_back({symbol, symbol->getNumberAndPlainTextName()});
 		
-		auto& colors = category.symbols.back().colors;
-		colors.reserve(4);
-		map.applyOnMatchingColors(
-		    [&colors](const MapColor* color) { colors.push_back(color->getName()); },
-		    [symbol](const MapColor* color) { return symbol->containsColor(color); }
-		    );
+		auto& symbol_usage = category.symbols.back();
+		symbol_usage.colors.reserve(4);
+		for (int i = 0; i < map.getNumColors(); ++i)
+		{
+			const auto* color = map.getColor(i);
+			if (symbol->containsColor(color))
+			{
+				symbol_usage.colors.push_back(color->getName());
+				colors[std::size_t(i)].symbols.push_back(symbol_usage.name);
+			}
+		}
 	});
 	
 	auto category_text = getSymbolTypeUsage(Symbol::Text);
@@ -209,15 +228,17 @@ MapInformationBuilder::MapInformationBuilder(const Map& map)
 		objects_count += map_part_objects;
 		map_parts.push_back({map_part->getName(), map_part_objects});
 		
-		map_part->applyOnAllObjects([this](const Object* object) {
-			const auto* const symbol = object->getSymbol();
+		// The symbol index maintains the object counts per symbol.
+		for (const auto* symbol : map_part->symbolsInUse())
+		{
+			auto const count = map_part->countObjectsWithSymbol(symbol);
 			auto& object_category = getSymbolTypeUsage(symbol ? symbol->getType() : Symbol::NoSymbol);
-			object_category.object_count++;
+			object_category.object_count += count;
 			auto s = std::find_if(object_category.symbols.begin(), object_category.symbols.end(), [symbol](const auto& s) { return symbol == s.symbol; } );
 			if (s == object_category.symbols.end())
 				s = object_category.symbols.insert(object_category.symbols.end(), {symbol, QCoreApplication::translate("OpenOrienteering::MapInformation", "<undefined>")});
-			s->object_count++;
-		});
+			s->object_count += count;
+		}
 	}
 	
 	const auto& undo_manager = map.undoManager();
@@ -279,6 +300,18 @@ void MapInformationBuilder::buildTree(std::vector<MapInformation::TreeItem>& tre
 			name = QCoreApplication::translate("OpenOrienteering::MapInformation", "%1 (substituted by %2)").arg(name, font_name.name_substitute);
 		tree_items.push_back({1, name, QCoreApplication::translate("OpenOrienteering::MapInformation", "%n symbol(s)", nullptr, font_name.symbol_count)});
 	}
+	
+	tree_items.push_back({0, QCoreApplication::translate("OpenOrienteering::MapInformation", "Memory usage (approximate)"), memorySize(memory_usage.total())});
+	{
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Objects"), memorySize(memory_usage.objects)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Coordinates"), memorySize(memory_usage.coordinates)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Renderables"), memorySize(memory_usage.renderables)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Text layout"), memorySize(memory_usage.text_layout)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Symbol icons"), memorySize(memory_usage.symbol_icons)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Templates"), memorySize(memory_usage.templates)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Drawing on templates"), memorySize(memory_usage.template_undo)});
+		tree_items.push_back({1, QCoreApplication::translate("OpenOrienteering::MapInformation", "Undo history"), memorySize(memory_usage.undo_history)});
+	}
 }
 
 
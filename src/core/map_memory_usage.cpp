@@ -0,0 +1,98 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_memory_usage.h"
+
+#include <QtGlobal>
+
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/path_coord.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/renderables/renderable.h"
+#include "core/symbols/symbol.h"
+#include "templates/template.h"
+#include "undo/undo_manager.h"
+#include "util/key_value_container.h"
+#include "util/trace.h"
+
+
+namespace OpenOrienteering {
+
+MapMemoryUsage::MapMemoryUsage(const Map& map)
+{
+	map.applyOnAllObjects([this](const Object* object) {
+		coordinates += object->getRawCoordinateVector().capacity() * sizeof(MapCoord);
+		if (!object->tags().empty())
+			objects += sizeof(KeyValueContainer) + object->tags().capacity() * sizeof(KeyValue);
+		switch (object->getType())
+		{
+		case Object::Path:
+			objects += sizeof(PathObject) + object->asPath()->parts().capacity() * sizeof(PathPart);
+			for (auto const& part : object->asPath()->parts())
+				coordinates += part.path_coords.capacity() * sizeof(PathCoord);
+			break;
+		case Object::Text:
+			objects += sizeof(TextObject);
+			text_layout += object->asText()->layoutMemoryUsage();
+			break;
+		case Object::Point:
+			objects += sizeof(PointObject);
+			break;
+		}
+		renderables += object->renderables().memoryUsage();
+	});
+	
+	map.applyOnAllSymbols([this](const Symbol* symbol) {
+		symbol_icons += symbol->iconMemoryUsage();
+	});
+	
+	for (int i = 0; i < map.getNumTemplates(); ++i)
+	{
+		auto const* temp = map.getTemplate(i);
+		templates += std::size_t(qMax(qint64(0), temp->memoryUsage()));
+		template_undo += std::size_t(qMax(qint64(0), temp->undoMemoryUsage()));
+	}
+	
+	undo_history = map.undoManager().memoryUsage();
+}
+
+
+std::size_t MapMemoryUsage::total() const noexcept
+{
+	return objects + coordinates + renderables + text_layout + symbol_icons
+	       + templates + template_undo + undo_history;
+}
+
+
+void MapMemoryUsage::trace() const
+{
+	Trace::counter("Memory: objects", qint64(objects));
+	Trace::counter("Memory: coordinates", qint64(coordinates));
+	Trace::counter("Memory: renderables", qint64(renderables));
+	Trace::counter("Memory: text layout", qint64(text_layout));
+	Trace::counter("Memory: symbol icons", qint64(symbol_icons));
+	Trace::counter("Memory: templates", qint64(templates));
+	Trace::counter("Memory: template undo", qint64(template_undo));
+	Trace::counter("Memory: undo history", qint64(undo_history));
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,70 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_MEMORY_USAGE_H
+#define OPENORIENTEERING_MAP_MEMORY_USAGE_H
+
+#include <cstddef>
+
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * Approximate amounts of memory held by the parts of a map, in bytes.
+ * 
+ * The numbers are estimated from the sizes of the major containers and
+ * images. They do not cover allocator overhead, shared data, or memory
+ * held by libraries.
+ */
+struct MapMemoryUsage
+{
+	std::size_t objects = 0;        ///< Objects, path parts and tags, without coordinates
+	std::size_t coordinates = 0;    ///< Object coordinates and path coordinates
+	std::size_t renderables = 0;    ///< Renderables of all objects
+	std::size_t text_layout = 0;    ///< Cached layout and outlines of text objects
+	std::size_t symbol_icons = 0;   ///< Cached and custom symbol icons
+	std::size_t templates = 0;      ///< Loaded template data
+	std::size_t template_undo = 0;  ///< Undo history of drawing onto templates
+	std::size_t undo_history = 0;   ///< Undo and redo steps of the map
+	
+	/**
+	 * Collects the memory usage of the given map.
+	 * 
+	 * This visits all objects, so it takes time for large maps.
+	 */
+	explicit MapMemoryUsage(const Map& map);
+	
+	/**
+	 * Returns the sum of all parts.
+	 */
+	std::size_t total() const noexcept;
+	
+	/**
+	 * Records the numbers as trace counters, cf. Trace::counter().
+	 */
+	void trace() const;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_MAP_MEMORY_USAGE_H
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,11 +22,17 @@
 #include "map_part.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <QtGlobal>
 #include <QLatin1String>
 #include <QObject>
+#include <QPointF>
 #include <QStringRef>
 #include <QTransform>
 #include <QXmlStreamReader>
@@ -35,7 +41,10 @@
 #include "core/map_coord.h"
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
+#include "fileformats/file_format.h"
+#include "fileformats/file_import_export.h"
 #include "undo/object_undo.h"
+#include "util/parallel.h"
 #include "util/util.h"
 #include "util/xml_stream_util.h"
 
@@ -53,6 +62,67 @@ namespace literal
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * The number of loaded objects which are collected before decoding their
+ * coordinates concurrently.
+ */
+constexpr std::size_t pending_objects_batch_size = 4096;
+
+/**
+ * A loaded object whose coordinates are not yet decoded.
+ */
+struct PendingObject
+{
+	Object* object;
+	DeferredCoords coords;
+	qint64 line;
+	qint64 column;
+	QString error;
+};
+
+/**
+ * Decodes the coordinates of the pending objects concurrently.
+ * 
+ * Throws FileFormatException for the first object which failed.
+ */
+void finishLoading(std::vector<PendingObject>& pending, Map& map)
+{
+	Util::parallelFor(pending.size(), 64, [&pending](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			auto& item = pending[i];
+			try
+			{
+				item.object->finishLoading(item.coords);
+			}
+			catch (FileFormatException& e)
+			{
+				item.error = e.message();
+			}
+		}
+	});
+	
+	for (auto const& item : pending)
+	{
+		auto* object = item.object;
+		if (!item.error.isEmpty())
+		{
+			throw FileFormatException(::OpenOrienteering::ImportExport::tr("Error while loading an object of type %1 at %2:%3: %4").
+			  arg(object->getType()).arg(item.line).arg(item.column).arg(item.error));
+		}
+		
+		auto const& coords = object->getRawCoordinateVector();
+		if (coords.empty() || !coords.front().isRegular() || !coords.back().isRegular())
+			map.markAsIrregular(object);
+	}
+	pending.clear();
+}
+
+}  // namespace
+
+
 MapPart::MapPart(const QString& name, Map* map)
 : name(name)
 , map(map)
@@ -93,12 +163,13 @@ void MapPart::save(QXmlStreamWriter& xml) const
 	}
 }
 
-MapPart* MapPart::load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol_dict)
+MapPart* MapPart::load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol_dict,
+                       const std::function<void ()>& progress)
 {
 	Q_ASSERT(xml.name() == literal::part);
 	
 	XmlElementReader part_element(xml);
-	auto part = new MapPart(part_element.attribute<QString>(literal::name), &map);
+	auto part = std::make_unique<MapPart>(part_element.attribute<QString>(literal::name), &map);
 	
 	while (xml.readNextStartElement())
 	{
@@ -108,27 +179,48 @@ MapPart* MapPart::load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol
 			
 			std::size_t num_objects = objects_element.attribute<std::size_t>(literal::count);
 			if (num_objects > 0)
+			{
 				part->objects.reserve(qMin(num_objects, std::size_t(20000))); // 20000 is not a limit
+				part->index_entries.reserve(int(qMin(num_objects, std::size_t(20000))));
+			}
 			
+			// The decoding of coordinates is done concurrently, in batches.
+			std::vector<PendingObject> pending;
+			DeferredCoords deferred;
 			while (xml.readNextStartElement())
 			{
 				if (xml.name() == literal::object)
-					part->objects.push_back(Object::load(xml, &map, symbol_dict));
+				{
+					auto* object = Object::load(xml, &map, symbol_dict, nullptr, &deferred);
+					part->objects.push_back(object);
+					part->addToSpatialIndex(object, true);
+					part->addToSymbolIndex(object);
+					part->addToTagIndex(object);
+					if (!deferred.text.isEmpty())
+					{
+						pending.push_back({object, std::move(deferred), xml.lineNumber(), xml.columnNumber(), {}});
+						if (pending.size() >= pending_objects_batch_size)
+							finishLoading(pending, map);
+					}
+					if (progress && part->objects.size() % pending_objects_batch_size == 0)
+						progress();
+				}
 				else
 					xml.skipCurrentElement(); // unknown
 			}
+			finishLoading(pending, map);
 		}
 		else
 			xml.skipCurrentElement(); // unknown
 	}
 	
-	return part;
+	return part.release();
 }
 
 
 bool MapPart::contains(const Object* const object) const
 {
-	return existsObject([object](auto const* o) { return object == o; });
+	return index_entries.contains(object);
 }
 
 int MapPart::findObjectIndex(const Object* object) const
@@ -146,12 +238,20 @@ int MapPart::findObjectIndex(const Object* object) const
 void MapPart::setObject(Object* object, int pos, bool delete_old)
 {
 	map->removeRenderablesOfObject(objects[pos], true);
+	auto const serial = index_entries.value(objects[pos]).serial;
+	removeFromSpatialIndex(objects[pos]);
+	removeFromSymbolIndex(objects[pos]);
+	removeFromTagIndex(objects[pos]);
 	if (delete_old)
 		delete objects[pos];
 	
 	objects[pos] = object;
+	addToSpatialIndex(object, true);
+	addToSymbolIndex(object);
+	addToTagIndex(object);
+	index_entries[object].serial = serial;
 	object->setMap(map);
-	object->update();
+	map->updateObject(object);
 	map->setObjectsDirty(); // TODO: remove from here, dirty state handling should be separate
 }
 
@@ -163,13 +263,53 @@ void MapPart::addObject(Object* object)
 void MapPart::addObject(Object* object, int pos)
 {
 	objects.insert(objects.begin() + pos, object);
+	addToSpatialIndex(object, std::size_t(pos) + 1 == objects.size());
+	addToSymbolIndex(object);
+	addToTagIndex(object);
 	object->setMap(map);
-	object->update();
+	map->updateObject(object);
 	
 	if (objects.size() == 1 && map->getNumObjects() == 1)
 		map->updateAllMapWidgets();
 }
 
+void MapPart::addObjects(const std::vector<Object*>& new_objects)
+{
+	if (new_objects.empty())
+		return;
+	
+	map->beginObjectUpdateBatch();
+	objects.reserve(objects.size() + new_objects.size());
+	index_entries.reserve(index_entries.size() + int(new_objects.size()));
+	for (auto* object : new_objects)
+	{
+		object->setMap(map);
+		objects.push_back(object);
+		addToSpatialIndex(object, true);
+		addToSymbolIndex(object);
+		addToTagIndex(object);
+		map->updateObject(object);
+	}
+	map->endObjectUpdateBatch();
+	
+	if (objects.size() == new_objects.size() && map->getNumObjects() == int(objects.size()))
+		map->updateAllMapWidgets();
+}
+
+void MapPart::appendLoadedObjects(const std::vector<Object*>& new_objects)
+{
+	objects.reserve(objects.size() + new_objects.size());
+	index_entries.reserve(index_entries.size() + int(new_objects.size()));
+	for (auto* object : new_objects)
+	{
+		object->setMap(map);
+		objects.push_back(object);
+		addToSpatialIndex(object, true);
+		addToSymbolIndex(object);
+		addToTagIndex(object);
+	}
+}
+
 void MapPart::deleteObject(int pos)
 {
 	delete releaseObject(pos);
@@ -183,10 +323,86 @@ bool MapPart::deleteObject(Object* object)
 	return object_ptr;
 }
 
+std::vector<Object*> MapPart::takeObjects(const std::vector<int>& indices)
+{
+	std::vector<Object*> taken;
+	taken.reserve(indices.size());
+	for (auto index : indices)
+	{
+		auto*& object = objects[std::size_t(index)];
+		Q_ASSERT(object);
+		removeFromSpatialIndex(object);
+		removeFromSymbolIndex(object);
+		removeFromTagIndex(object);
+		taken.push_back(object);
+		object = nullptr;
+	}
+	objects.erase(std::remove(begin(objects), end(objects), nullptr), end(objects));
+	return taken;
+}
+
+void MapPart::adoptObjects(const std::vector<Object*>& new_objects)
+{
+	objects.reserve(objects.size() + new_objects.size());
+	index_entries.reserve(index_entries.size() + int(new_objects.size()));
+	for (auto* object : new_objects)
+	{
+		Q_ASSERT(object->getMap() == map);
+		objects.push_back(object);
+		addToSpatialIndex(object, true);
+		updateSpatialIndex(object);
+		addToSymbolIndex(object);
+		addToTagIndex(object);
+	}
+}
+
+void MapPart::adoptObjects(const std::vector<Object*>& new_objects, const std::vector<int>& positions)
+{
+	Q_ASSERT(new_objects.size() == positions.size());
+	
+	ObjectList merged(objects.size() + new_objects.size(), nullptr);
+	for (std::size_t i = 0; i < new_objects.size(); ++i)
+	{
+		Q_ASSERT(!merged[std::size_t(positions[i])]);
+		merged[std::size_t(positions[i])] = new_objects[i];
+	}
+	auto object = begin(objects);
+	for (auto& slot : merged)
+	{
+		if (!slot)
+			slot = *object++;
+	}
+	Q_ASSERT(object == end(objects));
+	objects.swap(merged);
+	
+	index_entries.reserve(index_entries.size() + int(new_objects.size()));
+	for (auto* new_object : new_objects)
+	{
+		Q_ASSERT(new_object->getMap() == map);
+		addToSpatialIndex(new_object, false);
+		updateSpatialIndex(new_object);
+		addToSymbolIndex(new_object);
+		addToTagIndex(new_object);
+	}
+}
+
+void MapPart::deleteTextObjects()
+{
+	objects.erase(std::remove_if(begin(objects), end(objects), [](Object* object) {
+		if (object->getType() != Object::Text)
+			return false;
+		delete object;
+		return true;
+	}), end(objects));
+}
+
 Object* MapPart::releaseObject(int pos)
 {
 	map->removeRenderablesOfObject(objects[pos], true);
 	auto object_to_return = objects[pos];
+	removeFromSpatialIndex(object_to_return);
+	removeFromSymbolIndex(object_to_return);
+	removeFromTagIndex(object_to_return);
 	objects.erase(objects.begin() + pos);
 	
 	if (objects.empty() && map->getNumObjects() == 0)
@@ -218,23 +434,40 @@ std::unique_ptr<UndoStep> MapPart::importPart(const MapPart* other, const QHash<
 	if (select_new_objects)
 		map->clearObjectSelection(false);
 	
-	objects.reserve(objects.size() + other->objects.size());
-	for (const Object* object: other->objects)
+	// Duplicating and transforming only touches the new objects.
+	auto const& other_objects = other->objects;
+	std::vector<const Object*> new_objects(other_objects.size());
+	Util::parallelFor(other_objects.size(), 64, [&](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			Object* new_object = other_objects[i]->duplicate();
+			auto const symbol = symbol_map.find(new_object->getSymbol());
+			if (symbol != symbol_map.end())
+				new_object->setSymbol(symbol.value(), true);
+			new_object->transform(transform);
+			new_objects[i] = new_object;
+		}
+	});
+	
+	objects.reserve(objects.size() + new_objects.size());
+	index_entries.reserve(index_entries.size() + int(new_objects.size()));
+	for (auto const* object : new_objects)
 	{
-		Object* new_object = object->duplicate();
-		if (symbol_map.contains(new_object->getSymbol()))
-			new_object->setSymbol(symbol_map.value(new_object->getSymbol()), true);
-		new_object->transform(transform);
-		
+		auto* new_object = const_cast<Object*>(object);
 		objects.push_back(new_object);
+		addToSpatialIndex(new_object, true);
+		addToSymbolIndex(new_object);
+		addToTagIndex(new_object);
 		new_object->setMap(map);
-		new_object->update();
 		
 		undo_step->addObject((int)objects.size() - 1);
 		if (select_new_objects)
 			map->addObjectToSelection(new_object, false);
 	}
 	
+	// A single update pass for all new objects.
+	Object::updateAll(new_objects);
+	
 	map->setObjectsDirty();
 	if (select_new_objects)
 	{
@@ -257,7 +490,13 @@ void MapPart::findObjectsAt(
         bool include_protected_objects,
         SelectionInfoVector& out ) const
 {
-	for (Object* object : objects)
+	if (frozen)
+		return;
+	
+	// Point objects are tested by squared distance, cf. Object::isPointOnObject().
+	auto const radius = std::max(tolerance, std::sqrt(tolerance));
+	auto const query_rect = QRectF(coord.x() - radius, coord.y() - radius, 2 * radius, 2 * radius);
+	for (Object* object : findCandidates(query_rect))
 	{
 		if (!include_hidden_objects && object->getSymbol()->isHidden())
 			continue;
@@ -278,8 +517,11 @@ void MapPart::findObjectsAtBox(
         bool include_protected_objects,
         std::vector< Object* >& out ) const
 {
+	if (frozen)
+		return;
+	
 	auto rect = QRectF(corner1, corner2).normalized();
-	for (Object* object : objects)
+	for (Object* object : findCandidates(rect))
 	{
 		if (!include_hidden_objects && object->getSymbol()->isHidden())
 			continue;
@@ -295,7 +537,7 @@ void MapPart::findObjectsAtBox(
 int MapPart::countObjectsInRect(const QRectF& map_coord_rect, bool include_hidden_objects) const
 {
 	int count = 0;
-	for (const Object* object : objects)
+	for (const Object* object : findCandidates(map_coord_rect))
 	{
 		if (object->getSymbol()->isHidden() && !include_hidden_objects)
 			continue;
@@ -308,14 +550,36 @@ int MapPart::countObjectsInRect(const QRectF& map_coord_rect, bool include_hidde
 
 QRectF MapPart::calculateExtent(bool include_helper_symbols) const
 {
+	indexPendingObjects();
+	
+	auto const outdated = std::any_of(symbol_extents.cbegin(), symbol_extents.cend(), [](auto const& symbol_extent) {
+		return symbol_extent.outdated;
+	});
+	if (outdated)
+	{
+		for (auto& symbol_extent : symbol_extents)
+		{
+			if (symbol_extent.outdated)
+				symbol_extent.extent = {};
+		}
+		for (const auto* object : objects)
+		{
+			auto symbol_extent = symbol_extents.find(index_entries.value(object).symbol);
+			if (symbol_extent != symbol_extents.end() && symbol_extent->outdated)
+				rectIncludeSafe(symbol_extent->extent, object->getExtent());
+		}
+		for (auto& symbol_extent : symbol_extents)
+			symbol_extent.outdated = false;
+	}
+	
 	QRectF rect;
-	for (const auto* object : objects)
+	for (auto symbol_extent = symbol_extents.cbegin(); symbol_extent != symbol_extents.cend(); ++symbol_extent)
 	{
-		if (!object->getSymbol()->isHidden()
-		    && (include_helper_symbols || !object->getSymbol()->isHelperSymbol()) )
+		auto const* symbol = symbol_extent.key();
+		if (!symbol->isHidden()
+		    && (include_helper_symbols || !symbol->isHelperSymbol()) )
 		{
-			object->update();
-			rectIncludeSafe(rect, object->getExtent());
+			rectIncludeSafe(rect, symbol_extent->extent);
 		}
 	}
 	return rect;
@@ -323,6 +587,289 @@ QRectF MapPart::calculateExtent(bool include_helper_symbols) const
 
 
 
+bool MapPart::updateSpatialIndex(const Object* object) const
+{
+	auto entry = index_entries.find(object);
+	if (entry == index_entries.end())
+		return false;
+	
+	if (entry->indexed)
+	{
+		spatial_index.remove(entry->key, const_cast<Object*>(object));
+		removeFromSymbolExtent(*entry);
+	}
+	else
+	{
+		entry->indexed = true;
+		--num_unindexed;
+	}
+	entry->key = indexKey(object);
+	entry->symbol = object->getSymbol();
+	spatial_index.insert(entry->key, const_cast<Object*>(object));
+	addToSymbolExtent(*entry, object->getExtent());
+	return true;
+}
+
+
+void MapPart::addToSpatialIndex(const Object* object, bool append) const
+{
+	Q_ASSERT(!index_entries.contains(object));
+	auto& entry = index_entries[object];
+	entry.serial = next_serial++;
+	serials_dirty |= !append;
+	++num_unindexed;
+}
+
+
+void MapPart::removeFromSpatialIndex(const Object* object) const
+{
+	auto entry = index_entries.find(object);
+	if (entry == index_entries.end())
+		return;
+	
+	if (entry->indexed)
+	{
+		spatial_index.remove(entry->key, const_cast<Object*>(object));
+		removeFromSymbolExtent(*entry);
+	}
+	else
+	{
+		--num_unindexed;
+	}
+	index_entries.erase(entry);
+}
+
+
+void MapPart::indexPendingObjects() const
+{
+	if (num_unindexed > 0)
+	{
+		// Objects which were added or loaded but not updated since.
+		for (const auto* object : objects)
+		{
+			if (!index_entries.value(object).indexed)
+			{
+				object->update();
+				if (!index_entries.value(object).indexed)
+					updateSpatialIndex(object);
+			}
+		}
+		Q_ASSERT(num_unindexed == 0);
+	}
+}
+
+
+void MapPart::addToSymbolExtent(const IndexEntry& entry, const QRectF& extent) const
+{
+	auto& symbol_extent = symbol_extents[entry.symbol];
+	++symbol_extent.count;
+	if (!symbol_extent.outdated)
+		rectIncludeSafe(symbol_extent.extent, extent);
+}
+
+
+void MapPart::removeFromSymbolExtent(const IndexEntry& entry) const
+{
+	auto symbol_extent = symbol_extents.find(entry.symbol);
+	Q_ASSERT(symbol_extent != symbol_extents.end());
+	if (--symbol_extent->count == 0)
+	{
+		symbol_extents.erase(symbol_extent);
+	}
+	else if (!symbol_extent->outdated)
+	{
+		// Removing an extent which doesn't touch the border doesn't shrink the union.
+		auto const& extent = symbol_extent->extent;
+		auto const& key = entry.key;
+		symbol_extent->outdated = !(key.left() > extent.left() && key.right() < extent.right()
+		                            && key.top() > extent.top() && key.bottom() < extent.bottom());
+	}
+}
+
+
+bool MapPart::updateSymbolIndex(Object* object, const Symbol* old_symbol)
+{
+	auto entry = symbol_index.find(old_symbol);
+	if (entry == symbol_index.end() || !entry->remove(object))
+		return false;
+	
+	if (entry->isEmpty())
+		symbol_index.erase(entry);
+	symbol_index[object->getSymbol()].insert(object);
+	return true;
+}
+
+
+bool MapPart::existsObjectWithSymbol(const Symbol* symbol) const
+{
+	return symbol_index.contains(symbol);
+}
+
+
+std::vector<Object*> MapPart::objectsWithSymbol(const Symbol* symbol) const
+{
+	std::vector<Object*> result;
+	auto entry = symbol_index.constFind(symbol);
+	if (entry != symbol_index.constEnd())
+		result.assign(entry->begin(), entry->end());
+	return result;
+}
+
+
+int MapPart::countObjectsWithSymbol(const Symbol* symbol) const
+{
+	auto entry = symbol_index.constFind(symbol);
+	return entry != symbol_index.constEnd() ? entry->size() : 0;
+}
+
+
+std::vector<const Symbol*> MapPart::symbolsInUse() const
+{
+	std::vector<const Symbol*> result;
+	result.reserve(std::size_t(symbol_index.size()));
+	for (auto entry = symbol_index.cbegin(); entry != symbol_index.cend(); ++entry)
+		result.push_back(entry.key());
+	return result;
+}
+
+
+void MapPart::addToSymbolIndex(Object* object)
+{
+	symbol_index[object->getSymbol()].insert(object);
+}
+
+
+void MapPart::removeFromSymbolIndex(const Object* object)
+{
+	auto entry = symbol_index.find(object->getSymbol());
+	if (entry == symbol_index.end())
+		return;
+	
+	entry->remove(const_cast<Object*>(object));
+	if (entry->isEmpty())
+		symbol_index.erase(entry);
+}
+
+
+QSet<Object*> MapPart::objectsWithTag(const QString& key, const std::function<bool (const QString&)>& value_condition) const
+{
+	if (!tag_index_valid)
+	{
+		tag_index.clear();
+		tag_index_valid = true;
+		for (const auto* object : objects)
+			addToTagIndex(object);
+	}
+	
+	QSet<Object*> result;
+	auto const values = tag_index.constFind(key);
+	if (values != tag_index.constEnd())
+	{
+		for (auto value = values->cbegin(); value != values->cend(); ++value)
+		{
+			if (value_condition(value.key()))
+				result.unite(*value);
+		}
+	}
+	return result;
+}
+
+
+bool MapPart::updateTagIndex(const Object* object) const
+{
+	if (!index_entries.contains(object))
+		return false;
+	
+	if (tag_index_valid)
+	{
+		tag_index.clear();
+		tag_index_valid = false;
+	}
+	return true;
+}
+
+
+void MapPart::addToTagIndex(const Object* object) const
+{
+	if (!tag_index_valid)
+		return;
+	
+	for (auto const& tag : object->tags())
+		tag_index[tag.key][tag.value].insert(const_cast<Object*>(object));
+}
+
+
+void MapPart::removeFromTagIndex(const Object* object) const
+{
+	if (!tag_index_valid)
+		return;
+	
+	for (auto const& tag : object->tags())
+	{
+		auto values = tag_index.find(tag.key);
+		if (values == tag_index.end())
+			continue;
+		auto value = values->find(tag.value);
+		if (value == values->end())
+			continue;
+		value->remove(const_cast<Object*>(object));
+		if (value->isEmpty())
+		{
+			values->erase(value);
+			if (values->isEmpty())
+				tag_index.erase(values);
+		}
+	}
+}
+
+
+void MapPart::sortByObjectOrder(std::vector<Object*>& list) const
+{
+	updateSerials();
+	std::sort(begin(list), end(list), [this](auto const* a, auto const* b) {
+		return index_entries.value(a).serial < index_entries.value(b).serial;
+	});
+}
+
+
+void MapPart::updateSerials() const
+{
+	if (serials_dirty)
+	{
+		next_serial = 0;
+		for (const auto* object : objects)
+			index_entries[object].serial = next_serial++;
+		serials_dirty = false;
+	}
+}
+
+
+std::vector<Object*> MapPart::findCandidates(const QRectF& rect) const
+{
+	indexPendingObjects();
+	
+	auto candidates = spatial_index.values(rect);
+	sortByObjectOrder(candidates);
+	return candidates;
+}
+
+
+// static
+QRectF MapPart::indexKey(const Object* object)
+{
+	auto key = object->getExtent();
+	if (object->getType() == Object::Point)
+	{
+		// Point objects may be found by their coordinate, even outside their extent.
+		auto const& coords = object->getRawCoordinateVector();
+		if (!coords.empty())
+			rectIncludeSafe(key, QPointF(coords.front()));
+	}
+	return key;
+}
+
+
+
 bool MapPart::existsObject(const std::function<bool(const Object*)>& condition) const
 {
 	return std::any_of(begin(objects), end(objects), condition);
@@ -359,6 +906,34 @@ void MapPart::applyOnMatchingObjects(const std::function<void (Object*, MapPart*
 }
 
 
+void MapPart::applyOnMatchingObjectsConcurrently(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition)
+{
+	std::vector<int> indices;
+	std::vector<const Object*> matching_objects;
+	for (auto i = objects.size(); i > 0; )
+	{
+		--i;
+		Object* const object = objects[i];
+		if (condition(object))
+		{
+			indices.push_back(int(i));
+			matching_objects.push_back(object);
+		}
+	}
+	
+	// The operation may rely on the extent and on the path coords.
+	Object::updateAll(matching_objects);
+	
+	Util::parallelFor(indices.size(), 16, [this, &operation, &indices](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			auto const index = indices[i];
+			operation(objects[std::size_t(index)], this, index);
+		}
+	});
+}
+
+
 void MapPart::applyOnAllObjects(const std::function<void (Object*)>& operation)
 {
 	std::for_each(objects.rbegin(), objects.rend(), operation);
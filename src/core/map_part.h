@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -30,8 +30,11 @@
 
 #include <QHash>
 #include <QRectF>
+#include <QSet>
 #include <QString>
 
+#include "util/spatial_index.h"
+
 class QIODevice;
 class QTransform;
 class QXmlStreamReader;
@@ -93,8 +96,11 @@ public:
 	 * Loads the map part in xml format from the given stream.
 	 * 
 	 * Needs a dictionary to map symbol ids to symbol pointers.
+	 * If given, the progress function is called after each block of objects.
+	 * It may throw an exception in order to cancel loading.
 	 */
-	static MapPart* load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol_dict);
+	static MapPart* load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol_dict,
+	                     const std::function<void ()>& progress = {});
 	
 	/**
 	 * Returns the part's name.
@@ -106,6 +112,22 @@ public:
 	 */
 	void setName(const QString& new_name);
 	
+	/**
+	 * Returns true if the part is frozen.
+	 * 
+	 * The objects of a frozen part are not found by hit testing.
+	 * 
+	 * @see Map::setPartFrozen()
+	 */
+	bool isFrozen() const;
+	
+	/**
+	 * Sets the frozen state.
+	 * 
+	 * Use Map::setPartFrozen() which also moves the renderables.
+	 */
+	void setFrozen(bool frozen);
+	
 	
 	/**
 	 * Returns the number of objects in the part.
@@ -124,6 +146,8 @@ public:
 	
 	/**
 	 * Tests if the part contains the given object.
+	 * 
+	 * This is a lookup in the spatial index entries, not a scan of the objects.
 	 */
 	bool contains(const Object* object) const;
 	
@@ -154,6 +178,23 @@ public:
 	 */
 	void addObject(Object* object, int pos);
 	
+	/**
+	 * Adds the objects as new objects at the end.
+	 * 
+	 * Other than calling addObject() for each object, this updates the
+	 * objects together, concurrently where possible, and it marks their
+	 * areas as dirty once, cf. Map::beginObjectUpdateBatch().
+	 */
+	void addObjects(const std::vector<Object*>& new_objects);
+	
+	/**
+	 * Adds loaded objects as new objects at the end.
+	 * 
+	 * Other than addObject(), this does not update the objects immediately.
+	 * Like objects read by load(), they are updated and indexed when needed.
+	 */
+	void appendLoadedObjects(const std::vector<Object*>& new_objects);
+	
 	/**
 	 * Deleted the object from the given index.
 	 */
@@ -181,6 +222,41 @@ public:
 	  * structures. Object deletion is caller's responsibility.
 	  */
 	Object* releaseObject(Object* object);
+	
+	/**
+	 * Relinquishes the ownership of the objects at the given indices.
+	 * 
+	 * Returns the objects in the order of the given indices, which must be
+	 * distinct. Other than releaseObject(), this leaves the renderables of
+	 * the objects untouched, so that they can be adopted by another part of
+	 * the same map without updating them, cf. adoptObjects().
+	 */
+	std::vector<Object*> takeObjects(const std::vector<int>& indices);
+	
+	/**
+	 * Adds objects which were taken from another part of the same map.
+	 * 
+	 * The objects are appended at the end. Their renderables are kept.
+	 */
+	void adoptObjects(const std::vector<Object*>& new_objects);
+	
+	/**
+	 * Adds objects which were taken from another part of the same map,
+	 * such that the i-th object ends up at positions[i].
+	 * 
+	 * The positions must be distinct and refer to the resulting list of
+	 * objects.
+	 */
+	void adoptObjects(const std::vector<Object*>& new_objects, const std::vector<int>& positions);
+	
+	/**
+	 * Deletes the text objects of this part.
+	 * 
+	 * Text objects keep font data which must be released on the GUI thread.
+	 * Afterwards, the part can be destroyed on a worker thread. The indexes
+	 * are not updated, so the part must not be used for anything else.
+	 */
+	void deleteTextObjects();
 
 	
 	/**
@@ -196,6 +272,8 @@ public:
 	
 	/**
 	 * @see Map::findObjectsAt().
+	 * 
+	 * Finds nothing in a frozen part.
 	 */
 	void findObjectsAt(const MapCoordF& coord, qreal tolerance, bool treat_areas_as_paths,
 		bool extended_selection, bool include_hidden_objects,
@@ -203,6 +281,8 @@ public:
 	
 	/**
 	 * @see Map::findObjectsAtBox().
+	 * 
+	 * Finds nothing in a frozen part.
 	 */
 	void findObjectsAtBox(const MapCoordF& corner1, const MapCoordF& corner2,
 		bool include_hidden_objects, bool include_protected_objects,
@@ -213,11 +293,85 @@ public:
 	 */
 	int countObjectsInRect(const QRectF& map_coord_rect, bool include_hidden_objects) const;
 	
+	/**
+	 * Returns all objects whose extent overlaps the given rect,
+	 * in the order of the objects list.
+	 * 
+	 * This is a query of the spatial index. It does not update the objects.
+	 */
+	std::vector<Object*> findCandidates(const QRectF& rect) const;
+	
 	/**
 	 * Calculates and returns the bounding box of all objects in this map part.
+	 * 
+	 * Objects with hidden symbols are not included. The extents are maintained
+	 * per symbol, from the same hooks which maintain the spatial index, so the
+	 * objects need to be scanned only after an extent was reduced.
 	 */
 	QRectF calculateExtent(bool include_helper_symbols) const;
 	
+	/**
+	 * Updates the spatial index entry of an object after its extent changed.
+	 * 
+	 * This is called from Object::update() (via Map) for all objects.
+	 * Returns false if the object is not contained in this part.
+	 */
+	bool updateSpatialIndex(const Object* object) const;
+	
+	/**
+	 * Moves an object to the symbol index entry of its new symbol.
+	 * 
+	 * This is called from Object::setSymbol() (via Map) for all objects.
+	 * Returns false if the object is not contained in this part.
+	 */
+	bool updateSymbolIndex(Object* object, const Symbol* old_symbol);
+	
+	/**
+	 * Returns true if the part contains at least one object with the given symbol.
+	 */
+	bool existsObjectWithSymbol(const Symbol* symbol) const;
+	
+	/**
+	 * Returns the objects with the given symbol, in no particular order.
+	 */
+	std::vector<Object*> objectsWithSymbol(const Symbol* symbol) const;
+	
+	/**
+	 * Returns the number of objects with the given symbol.
+	 * 
+	 * This is a lookup in the symbol index, not a scan of the objects.
+	 */
+	int countObjectsWithSymbol(const Symbol* symbol) const;
+	
+	/**
+	 * Returns the symbols of the objects in this part, in no particular order.
+	 */
+	std::vector<const Symbol*> symbolsInUse() const;
+	
+	
+	/**
+	 * Returns the objects which have a tag with the given key and with a
+	 * value matching the given condition.
+	 * 
+	 * The objects are found from an index of the objects' tags. This index is
+	 * created on first use. Adding and removing objects updates it, but when
+	 * an object's tags change, the index is dropped until it is used again.
+	 */
+	QSet<Object*> objectsWithTag(const QString& key, const std::function<bool (const QString&)>& value_condition) const;
+	
+	/**
+	 * Drops the tag index if the part contains the object.
+	 * 
+	 * This is called from Object's tag modifying functions (via Map).
+	 * Returns false if the object is not contained in this part.
+	 */
+	bool updateTagIndex(const Object* object) const;
+	
+	/**
+	 * Sorts the given objects of this part in the order of the objects list.
+	 */
+	void sortByObjectOrder(std::vector<Object*>& list) const;
+	
 	
 	/**
 	 * Applies a condition on all objects (until the first match is found).
@@ -244,6 +398,12 @@ public:
 	 */
 	void applyOnMatchingObjects(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition);
 	
+	/**
+	 * @copybrief   Map::applyOnMatchingObjectsConcurrently()
+	 * @copydetails Map::applyOnMatchingObjectsConcurrently()
+	 */
+	void applyOnMatchingObjectsConcurrently(const std::function<void (Object*, MapPart*, int)>& operation, const std::function<bool (const Object*)>& condition);
+	
 	/**
 	 * @copybrief   Map::applyOnAllObjects()
 	 * @copydetails Map::applyOnAllObjects()
@@ -265,10 +425,108 @@ public:
 	
 private:
 	typedef std::vector<Object*> ObjectList;
-
+	
+	/**
+	 * The state of an object in the spatial index.
+	 */
+	struct IndexEntry
+	{
+		QRectF key;               ///< The rectangle the object is indexed by.
+		const Symbol* symbol = nullptr;  ///< The symbol the object was indexed with.
+		std::size_t serial = 0;   ///< Increasing in the order of objects.
+		bool indexed = false;     ///< False while waiting for the first update.
+	};
+	
+	/**
+	 * The united extent of the indexed objects with a particular symbol.
+	 */
+	struct SymbolExtent
+	{
+		QRectF extent;            ///< The extent, valid if not outdated.
+		std::size_t count = 0;    ///< The number of indexed objects.
+		bool outdated = false;    ///< True when the extent must be recalculated.
+	};
+	
+	/**
+	 * Registers a new object, to be indexed by its next update.
+	 */
+	void addToSpatialIndex(const Object* object, bool append) const;
+	
+	/**
+	 * Removes an object from the spatial index.
+	 */
+	void removeFromSpatialIndex(const Object* object) const;
+	
+	/**
+	 * Updates and indexes the objects which are waiting for the first update.
+	 */
+	void indexPendingObjects() const;
+	
+	/**
+	 * Adds an indexed object's extent to the extent of its symbol.
+	 */
+	void addToSymbolExtent(const IndexEntry& entry, const QRectF& extent) const;
+	
+	/**
+	 * Removes an indexed object from the extent of its symbol.
+	 * 
+	 * The extent is marked as outdated unless the object's key is strictly
+	 * inside of it.
+	 */
+	void removeFromSymbolExtent(const IndexEntry& entry) const;
+	
+	/**
+	 * Adds a new object to the symbol index.
+	 */
+	void addToSymbolIndex(Object* object);
+	
+	/**
+	 * Removes an object from the symbol index.
+	 */
+	void removeFromSymbolIndex(const Object* object);
+	
+	/**
+	 * Adds a new object to the tag index, if the index exists.
+	 */
+	void addToTagIndex(const Object* object) const;
+	
+	/**
+	 * Removes an object from the tag index, if the index exists.
+	 */
+	void removeFromTagIndex(const Object* object) const;
+	
+	/**
+	 * Updates the serials of the spatial index entries, if needed.
+	 */
+	void updateSerials() const;
+	
+	/**
+	 * Returns the rectangle which is used as index key for an object.
+	 */
+	static QRectF indexKey(const Object* object);
+	
 	QString name;
-	ObjectList objects;  ///< @todo This could be a spatial representation optimized for quick access
+	ObjectList objects;
 	Map* const map;
+	bool frozen = false;
+	
+	mutable SpatialIndex<Object*> spatial_index;
+	mutable QHash<const Object*, IndexEntry> index_entries;
+	mutable QHash<const Symbol*, SymbolExtent> symbol_extents;
+	mutable std::size_t num_unindexed = 0;
+	mutable std::size_t next_serial = 0;
+	mutable bool serials_dirty = false;
+	
+	/**
+	 * The objects of this part, by their symbol.
+	 */
+	QHash<const Symbol*, QSet<Object*>> symbol_index;
+	
+	/**
+	 * The objects of this part, by tag key and tag value.
+	 */
+	mutable QHash<QString, QHash<QString, QSet<Object*>>> tag_index;
+	mutable bool tag_index_valid = false;
 };
 
 
@@ -281,6 +539,18 @@ const QString& MapPart::getName() const
 	return name;
 }
 
+inline
+bool MapPart::isFrozen() const
+{
+	return frozen;
+}
+
+inline
+void MapPart::setFrozen(bool frozen)
+{
+	this->frozen = frozen;
+}
+
 inline
 int MapPart::getNumObjects() const
 {
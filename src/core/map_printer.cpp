@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020 Kai Pastor
+ *    Copyright 2012-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,8 +21,13 @@
 
 #include "map_printer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <deque>
+#include <future>
+#include <utility>
+#include <vector>
 
 #include <Qt>
 #include <QtMath>
@@ -36,12 +41,18 @@
 #include <QPaintEngine> // IWYU pragma: keep
 #include <QPainter>
 #include <QPageLayout>
+#include <QPicture>
 #include <QPointF>
 #include <QRect>
 #include <QRgb>
+#include <QSet>
 #include <QSize>
+#include <QString>
+#include <QStringList>
 #include <QStringRef>
+#include <QThread>
 #include <QTransform>
+#include <QVector>
 #include <QXmlStreamReader>
 
 
@@ -61,6 +72,8 @@
 #include "core/map_view.h"
 #include "core/renderables/renderable.h"
 #include "templates/template.h"
+#include "util/parallel.h"
+#include "util/trace.h"
 #include "util/xml_stream_util.h"
 
 
@@ -84,6 +97,7 @@ namespace literal {
 	static const QLatin1String color_mode("color_mode");
 	static const QLatin1String default_color_mode("default");
 	static const QLatin1String device_cmyk("DeviceCMYK");
+	static const QLatin1String device_n("DeviceN");
 	static const QLatin1String page_format("page_format");
 	static const QLatin1String paper_size("paper_size");
 	static const QLatin1String orientation("orientation");
@@ -96,6 +110,7 @@ namespace literal {
 	static const QLatin1String print_area("print_area");
 	static const QLatin1String center_area("center_area");
 	static const QLatin1String single_page("single_page");
+	static const QLatin1String series_area("series_area");
 	
 }  // namespace literal
 
@@ -234,6 +249,8 @@ MapPrinterConfig::MapPrinterConfig(const Map& map, QXmlStreamReader& xml)
 			options.color_mode = MapPrinterOptions::DefaultColorMode;
 		else if (color_mode == literal::device_cmyk)
 			options.color_mode = MapPrinterOptions::DeviceCmyk;
+		else if (color_mode == literal::device_n)
+			options.color_mode = MapPrinterOptions::SpotColors;
 		else
 			qDebug("Unsupported map color mode: %s", color_mode.toUtf8().constData());
 	}
@@ -291,6 +308,13 @@ MapPrinterConfig::MapPrinterConfig(const Map& map, QXmlStreamReader& xml)
 			center_print_area = print_area_element.attribute<bool>(literal::center_area);
 			single_page_print_area= print_area_element.attribute<bool>(literal::single_page);
 		}
+		else if (xml.name() == literal::series_area)
+		{
+			QRectF area;
+			XmlElementReader(xml).read(area);
+			if (area.left() < area.right() && area.top() < area.bottom())
+				series_areas.push_back(area);
+		}
 		else
 			xml.skipCurrentElement();
 	}
@@ -336,6 +360,9 @@ void MapPrinterConfig::save(QXmlStreamWriter& xml, const QLatin1String& element_
 	case MapPrinterOptions::DeviceCmyk:
 		printer_config_element.writeAttribute(literal::color_mode, literal::device_cmyk);
 		break;
+	case MapPrinterOptions::SpotColors:
+		printer_config_element.writeAttribute(literal::color_mode, literal::device_n);
+		break;
 	default:
 		// Do not fail on saving
 		qDebug("Unsupported map color mode: %d", int(options.color_mode));
@@ -367,6 +394,10 @@ void MapPrinterConfig::save(QXmlStreamWriter& xml, const QLatin1String& element_
 		print_area_element.writeAttribute(literal::center_area, center_print_area);
 		print_area_element.writeAttribute(literal::single_page, single_page_print_area);
 	}
+	for (auto const& area : series_areas)
+	{
+		XmlElementWriter(xml, literal::series_area).write(area, 3);
+	}
 }
 
 
@@ -377,7 +408,8 @@ bool operator==(const MapPrinterConfig& lhs, const MapPrinterConfig& rhs)
 	        && lhs.page_format            == rhs.page_format
 	        && lhs.options                == rhs.options
 	        && lhs.center_print_area      == rhs.center_print_area
-	        && lhs.single_page_print_area == rhs.single_page_print_area;
+	        && lhs.single_page_print_area == rhs.single_page_print_area
+	        && lhs.series_areas           == rhs.series_areas;
 }
 
 
@@ -492,6 +524,93 @@ void MapPrinter::setTarget(const QPrinterInfo* new_target)
 	}
 }
 
+namespace {
+
+/**
+ * Registers the spot color definitions of the map colors with the printer.
+ * 
+ * The printer identifies colors by their RGB value. Colors which share the
+ * RGB value with a different definition are left to DeviceCMYK.
+ */
+void setSpotColors(AdvancedPdfPrinter& printer, const Map& map)
+{
+	struct Definition
+	{
+		QStringList colorants;
+		QVector<QColor> alternates;
+		QVector<qreal> tints;
+		bool overprint;
+		
+		bool operator==(const Definition& other) const
+		{
+			return colorants == other.colorants
+			       && alternates == other.alternates
+			       && tints == other.tints
+			       && overprint == other.overprint;
+		}
+	};
+	
+	QHash<QRgb, Definition> definitions;
+	QSet<QRgb> ambiguous;
+	auto add = [&definitions, &ambiguous](const MapColor& color, Definition definition) {
+		auto const rgb = QColor(color).rgb();
+		auto const existing = definitions.constFind(rgb);
+		if (existing == definitions.constEnd())
+			definitions.insert(rgb, definition);
+		else if (!(*existing == definition))
+			ambiguous.insert(rgb);
+	};
+	
+	for (int i = 0; i < map.getNumColors(); ++i)
+	{
+		auto const* color = map.getColor(i);
+		Definition definition;
+		definition.overprint = !color->getKnockout();
+		switch (color->getSpotColorMethod())
+		{
+		case MapColor::SpotColor:
+			if (color->getSpotColorName().isEmpty())
+				continue;
+			definition.colorants.append(color->getSpotColorName());
+			definition.alternates.append(color->getCmyk());
+			definition.tints.append(1);
+			break;
+		case MapColor::CustomColor:
+			for (auto const& component : color->getComponents())
+			{
+				definition.colorants.append(component.spot_color->getSpotColorName());
+				definition.alternates.append(component.spot_color->getCmyk());
+				definition.tints.append(qreal(component.factor));
+			}
+			if (definition.colorants.isEmpty() || definition.colorants.contains(QString{}))
+				continue;
+			break;
+		default:
+			continue;
+		}
+		add(*color, definition);
+	}
+	
+	// Registration black prints on all separations.
+	Definition registration;
+	registration.colorants.append(QString::fromLatin1("All"));
+	registration.alternates.append(QColor::fromCmykF(1, 1, 1, 1));
+	registration.tints.append(1);
+	registration.overprint = false;
+	add(*Map::getRegistrationColor(), registration);
+	
+	for (auto item = definitions.constBegin(); item != definitions.constEnd(); ++item)
+	{
+		if (ambiguous.contains(item.key()))
+			continue;
+		auto const& definition = item.value();
+		printer.setSpotColor(item.key(), definition.colorants, definition.alternates, definition.tints, definition.overprint);
+	}
+}
+
+}  // namespace
+
+
 std::unique_ptr<QPrinter> MapPrinter::makePrinter() const
 {
 	std::unique_ptr<QPrinter> printer;
@@ -507,6 +626,13 @@ std::unique_ptr<QPrinter> MapPrinter::makePrinter() const
 	{
 		printer = std::make_unique<AdvancedPdfPrinter>(*target, QPrinter::HighResolution);
 	}
+	else if (options.color_mode == MapPrinterOptions::SpotColors)
+	{
+		auto pdf_printer = std::make_unique<AdvancedPdfPrinter>(*target, QPrinter::HighResolution);
+		if (vectorModeSelected())
+			setSpotColors(*pdf_printer, map);
+		printer = std::move(pdf_printer);
+	}
 	else
 	{
 		printer = std::make_unique<QPrinter>(*target, QPrinter::HighResolution);
@@ -860,18 +986,23 @@ bool MapPrinter::hasAlpha(const Template* temp) const
 
 void MapPrinter::updatePageBreaks()
 {
-	Q_ASSERT(print_area.left() <= print_area.right());
-	Q_ASSERT(print_area.top() <= print_area.bottom());
+	calculatePageBreaks(print_area, h_page_pos, v_page_pos);
+}
+
+void MapPrinter::calculatePageBreaks(const QRectF& area, std::vector<qreal>& h_page_pos, std::vector<qreal>& v_page_pos) const
+{
+	Q_ASSERT(area.left() <= area.right());
+	Q_ASSERT(area.top() <= area.bottom());
 	
 	// This whole implementation needs to deal with FP precision issues
 	
 	h_page_pos.clear();
-	qreal h_pos = print_area.left();
+	qreal h_pos = area.left();
 	h_page_pos.push_back(h_pos);
 	const qreal h_overlap = page_format.h_overlap / scale_adjustment;
 	const qreal page_width = page_format.page_rect.width() / scale_adjustment - h_overlap;
 	
-	const qreal right_bound = print_area.right() - h_overlap - 0.05;
+	const qreal right_bound = area.right() - h_overlap - 0.05;
 	if (page_width >= 0.01)
 	{
 		auto const max_size = std::size_t(std::ceil((right_bound - h_pos) / page_width));
@@ -880,17 +1011,17 @@ void MapPrinter::updatePageBreaks()
 		
 		// Center the print area on the pages total area.
 		// Don't pre-calculate this offset to avoid FP precision problems
-		const qreal h_offset = 0.5 * (h_pos + h_overlap - print_area.right());
+		const qreal h_offset = 0.5 * (h_pos + h_overlap - area.right());
 		for (auto& pos : h_page_pos)
 			pos -= h_offset;
 	}
 	
 	v_page_pos.clear();
-	qreal v_pos = print_area.top();
+	qreal v_pos = area.top();
 	v_page_pos.push_back(v_pos);
 	const qreal v_overlap = page_format.v_overlap / scale_adjustment;
 	const qreal page_height = page_format.page_rect.height() / scale_adjustment - v_overlap;
-	const qreal bottom_bound = print_area.bottom() - v_overlap - 0.05;
+	const qreal bottom_bound = area.bottom() - v_overlap - 0.05;
 	if (page_height >= 0.01)
 	{
 		auto const max_size = std::size_t(std::ceil((bottom_bound - v_pos) / page_height));
@@ -898,12 +1029,47 @@ void MapPrinter::updatePageBreaks()
 			v_page_pos.push_back(v_pos);
 		
 		// Don't pre-calculate offset to avoid FP precision problems
-		const qreal v_offset = 0.5 * (v_pos + v_overlap - print_area.bottom());
+		const qreal v_offset = 0.5 * (v_pos + v_overlap - area.bottom());
 		for (auto& pos : v_page_pos)
 			pos -= v_offset;
 	}
 }
 
+void MapPrinter::setSeriesAreas(std::vector<QRectF> areas)
+{
+	series_areas = std::move(areas);
+}
+
+std::vector<QRectF> MapPrinter::pageExtents() const
+{
+	QSizeF const extent_size = page_format.page_rect.size() / scale_adjustment;
+	std::vector<QRectF> page_extents;
+	auto add_pages = [&page_extents, extent_size](const std::vector<qreal>& h_pos, const std::vector<qreal>& v_pos) {
+		for (auto vpos : v_pos)
+		{
+			for (auto hpos : h_pos)
+				page_extents.emplace_back(QPointF(hpos, vpos), extent_size);
+		}
+	};
+	
+	if (series_areas.empty())
+	{
+		page_extents.reserve(v_page_pos.size() * h_page_pos.size());
+		add_pages(h_page_pos, v_page_pos);
+	}
+	else
+	{
+		std::vector<qreal> h_pos;
+		std::vector<qreal> v_pos;
+		for (auto const& area : series_areas)
+		{
+			calculatePageBreaks(area, h_pos, v_pos);
+			add_pages(h_pos, v_pos);
+		}
+	}
+	return page_extents;
+}
+
 void MapPrinter::mapScaleChanged()
 {
 	auto value = qreal(map.getScaleDenominator()) / options.scale;
@@ -944,7 +1110,7 @@ void MapPrinter::takePrinterSettings(const QPrinter* printer)
 }
 
 
-void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, QImage* page_buffer) const
+QTransform MapPrinter::pageExtentTransform(const QRectF& page_extent) const
 {
 	// Determine transformation and clipping for page extent and region
 	const qreal units_per_mm = options.resolution / 25.4;
@@ -955,11 +1121,82 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, Q
 	transform.scale(scale_adjustment, scale_adjustment);
 	// Translate and clip for margins and print area
 	transform.translate(-page_extent.left(), -page_extent.top());
-	drawPage(device_painter, page_extent, transform, page_buffer);
+	return transform;
+}
+
+bool MapPrinter::usesMapBuffer() const
+{
+	return rasterModeSelected() || target == imageTarget() || target == kmzTarget() || engineWillRasterize();
+}
+
+QSize MapPrinter::pageBufferSize(const QPainter* device_painter) const
+{
+	const qreal units_per_mm = options.resolution / 25.4;
+	int w = qCeil(page_format.paper_dimensions.width() * units_per_mm);
+	int h = qCeil(page_format.paper_dimensions.height() * units_per_mm);
+#if defined (Q_OS_MACOS)
+	if (device_painter->device()->physicalDpiX() == 0)
+	{
+		// Possible Qt bug, since according to QPaintDevice documentation,
+		// "if the physicalDpiX() doesn't equal the logicalDpiX(),
+		// the corresponding QPaintEngine must handle the resolution mapping"
+		// which doesn't seem to happen here.
+		qreal corr = device_painter->device()->logicalDpiX() / 72.0;
+		w = qCeil(page_format.paper_dimensions.width() * units_per_mm * corr);
+		h = qCeil(page_format.paper_dimensions.height() * units_per_mm * corr);
+	}
+#else
+	Q_UNUSED(device_painter)
+#endif
+	return { w, h };
+}
+
+void MapPrinter::prepareMapLayers() const
+{
+	map.updateObjects();
+}
+
+QImage MapPrinter::renderMapLayer(const QRectF& page_extent, const QTransform& page_extent_transform, const QSize& size, QPainter::RenderHints render_hints) const
+{
+	auto layer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	if (layer.isNull())
+		return layer;  // Allocation failed
+	
+	// Draw map into a temporary buffer first which is printed with the map's opacity later.
+	// This prevents artifacts with overlapping objects.
+	layer.fill(QColor(Qt::transparent));
+	QPainter painter(&layer);
+	painter.setRenderHints(render_hints);
+	painter.setTransform(page_extent_transform);
+	
+	const auto page_region_used = page_extent.intersected(print_area);
+	painter.setClipRect(page_region_used, Qt::ReplaceClip);
+	
+	const qreal units_per_mm = options.resolution / 25.4;
+	RenderConfig config = { map, page_region_used, units_per_mm * scale_adjustment, RenderConfig::BatchedDrawing, 1.0 };
+	if (rasterModeSelected() && options.simulate_overprinting)
+		map.drawPreparedOverprintingSimulation(&painter, config);
+	else
+		map.drawPrepared(&painter, config);
+	painter.end();
+	return layer;
+}
+
+
+void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, QImage* page_buffer) const
+{
+	drawPage(device_painter, page_extent, pageExtentTransform(page_extent), page_buffer, {});
 }
 
 void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer) const
 {
+	drawPage(device_painter, page_extent, page_extent_transform, page_buffer, {});
+}
+
+void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer, QImage map_layer) const
+{
+	MAPPER_TRACE_SCOPE("MapPrinter::drawPage");
+	
 	// Logical units per mm
 	const qreal units_per_mm = options.resolution / 25.4;
 	
@@ -990,7 +1227,7 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	 * When the target is an image, use the temporary image to enforce the given
 	 * resolution.
 	 */
-	const bool use_buffer_for_map = rasterModeSelected() || target == imageTarget() || target == kmzTarget() || engineWillRasterize();
+	const bool use_buffer_for_map = usesMapBuffer();
 	bool use_page_buffer = use_buffer_for_map;
 	
 	auto first_front_template = map.getFirstFrontTemplate();
@@ -1023,22 +1260,7 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	QPainter local_page_painter;
 	if (use_page_buffer && !page_buffer)
 	{
-		int w = qCeil(page_format.paper_dimensions.width() * units_per_mm);
-		int h = qCeil(page_format.paper_dimensions.height() * units_per_mm);
-#if defined (Q_OS_MACOS)
-		if (device_painter->device()->physicalDpiX() == 0)
-		{
-			// Possible Qt bug, since according to QPaintDevice documentation,
-			// "if the physicalDpiX() doesn't equal the logicalDpiX(),
-			// the corresponding QPaintEngine must handle the resolution mapping"
-			// which doesn't seem to happen here.
-			qreal corr = device_painter->device()->logicalDpiX() / 72.0;
-			w = qCeil(page_format.paper_dimensions.width() * units_per_mm * corr);
-			h = qCeil(page_format.paper_dimensions.height() * units_per_mm * corr);
-		}
-#endif
-		
-		local_page_buffer = QImage(w, h, QImage::Format_RGB32);
+		local_page_buffer = QImage(pageBufferSize(device_painter), QImage::Format_RGB32);
 		if (local_page_buffer.isNull())
 		{
 			// Allocation failed
@@ -1087,49 +1309,24 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 	 */
 	if (!view || view->effectiveMapVisibility().visible)
 	{
-		QPainter* map_painter = page_painter;
+		page_painter->save();  // Modified via map_painter, or when drawing the map buffer
 		
-		QPainter map_buffer_painter;
 		if (use_buffer_for_map)
 		{
-			// Draw map into a temporary buffer first which is printed with the map's opacity later.
-			// This prevents artifacts with overlapping objects.
-			local_buffer = QImage(page_buffer->size(), QImage::Format_ARGB32_Premultiplied);
+			// The map layer may have been rendered ahead by printMap().
+			if (map_layer.size() != page_buffer->size())
+			{
+				prepareMapLayers();
+				map_layer = renderMapLayer(page_extent, page_extent_transform, page_buffer->size(), render_hints);
+			}
+			local_buffer = std::move(map_layer);
 			if (local_buffer.isNull())
 			{
 				// Allocation failed
+				page_painter->restore();
 				device_painter->end(); // Signal error
 				return;
 			}
-			local_buffer.fill(QColor(Qt::transparent));
-			map_buffer_painter.begin(&local_buffer);
-			map_painter = &map_buffer_painter;
-		}
-		
-		page_painter->save();  // Modified via map_painter, or when drawing the map_buffer
-		
-		map_painter->setRenderHints(render_hints);
-		map_painter->setTransform(page_extent_transform, /*combine*/ true);
-		map_painter->setClipRect(page_region_used, Qt::ReplaceClip);
-		
-		RenderConfig config = { map, page_region_used, units_per_mm * scale_adjustment, RenderConfig::NoOptions, 1.0 };
-		
-		if (rasterModeSelected() && options.simulate_overprinting)
-		{
-			map.drawOverprintingSimulation(map_painter, config);
-		}
-		else
-		{
-			if (view && !map_buffer_painter.isActive())
-				config.opacity = view->effectiveMapVisibility().opacity;
-		
-			map.draw(map_painter, config);
-		}
-			
-		if (map_buffer_painter.isActive())
-		{
-			// Flush the buffer
-			map_buffer_painter.end();
 			
 			// Draw buffer with map opacity
 			if (view)
@@ -1137,6 +1334,24 @@ void MapPrinter::drawPage(QPainter* device_painter, const QRectF& page_extent, c
 			page_painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
 			page_painter->drawImage(0, 0, local_buffer);
 		}
+		else
+		{
+			page_painter->setRenderHints(render_hints);
+			page_painter->setTransform(page_extent_transform, /*combine*/ true);
+			page_painter->setClipRect(page_region_used, Qt::ReplaceClip);
+			
+			RenderConfig config = { map, page_region_used, units_per_mm * scale_adjustment, RenderConfig::BatchedDrawing, 1.0 };
+			if (rasterModeSelected() && options.simulate_overprinting)
+			{
+				map.drawOverprintingSimulation(page_painter, config);
+			}
+			else
+			{
+				if (view)
+					config.opacity = view->effectiveMapVisibility().opacity;
+				map.draw(page_painter, config);
+			}
+		}
 		
 		page_painter->restore();
 	}
@@ -1258,21 +1473,51 @@ void MapPrinter::drawSeparationPages(QPrinter* printer, QPainter* device_painter
 	
 	// Translate and clip for margins and print area
 	device_painter->translate(-page_extent.left(), -page_extent.top());
-	device_painter->setClipRect(page_extent.intersected(print_area).adjusted(-10, 10, 10, 10), Qt::ReplaceClip);
+	auto const clip_rect = page_extent.intersected(print_area).adjusted(-10, 10, 10, 10);
+	device_painter->setClipRect(clip_rect, Qt::ReplaceClip);
 	
-	bool need_new_page = false;
+	std::vector<const MapColor*> separations;
 	for (int i = map.getNumColors() - 1; i >= 0; --i)
 	{
 		const MapColor* color = map.getColor(i);
 		if (color->getSpotColorMethod() == MapColor::SpotColor)
+			separations.push_back(color);
+	}
+	
+	// The separations are recorded concurrently, in map coordinates and
+	// with the same clip, and then played back in order. This limits the
+	// number of recordings which are held in memory at the same time.
+	map.updateObjects();
+	RenderConfig config = { map, page_extent, scale, RenderConfig::NoOptions, 1.0 };
+	auto const render_hints = device_painter->renderHints();
+	auto const max_pending = std::size_t(std::max(1, QThread::idealThreadCount()));
+	std::vector<QPicture> pictures;
+	
+	bool need_new_page = false;
+	for (std::size_t first = 0; first < separations.size(); first += max_pending)
+	{
+		auto const count = std::min(max_pending, separations.size() - first);
+		pictures.clear();
+		pictures.resize(count);
+		Util::parallelFor(count, 1, [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+			{
+				QPainter painter(&pictures[i]);
+				painter.setRenderHints(render_hints);
+				painter.setClipRect(clip_rect);
+				map.drawPreparedColorSeparation(&painter, config, separations[first + i]);
+				painter.end();
+			}
+		});
+		
+		for (const auto& picture : pictures)
 		{
 			if (need_new_page)
 			{
 				printer->newPage();
 			}
 			
-			RenderConfig config = { map, page_extent, scale, RenderConfig::NoOptions, 1.0 };
-			map.drawColorSeparation(device_painter, config, color);
+			device_painter->drawPicture(0, 0, picture);
 			need_new_page = true;
 		}
 	}
@@ -1280,6 +1525,16 @@ void MapPrinter::drawSeparationPages(QPrinter* printer, QPainter* device_painter
 	device_painter->restore();
 }
 
+namespace {
+
+/**
+ * The maximum amount of memory for map layers which are rendered ahead.
+ */
+constexpr qint64 max_pages_in_flight_memory = qint64(1) << 30;
+
+}  // namespace
+
+
 bool MapPrinter::printMap(QPrinter* printer)
 {
 	// Printer settings may have been changed by preview or application.
@@ -1287,7 +1542,7 @@ bool MapPrinter::printMap(QPrinter* printer)
 	printer->setFullPage(true);
 	takePrinterSettings(printer);
 	
-	QSizeF extent_size = page_format.page_rect.size() / scale_adjustment;
+	auto const page_extents = pageExtents();
 	QPainter painter(printer);
 	
 #if defined(Q_OS_WIN)
@@ -1348,57 +1603,87 @@ bool MapPrinter::printMap(QPrinter* printer)
 	
 	cancel_print_map = false;
 	int step = 0;
-	auto num_steps = v_page_pos.size() * h_page_pos.size();
+	auto num_steps = page_extents.size();
 	const QString message_template( (options.mode == MapPrinterOptions::Separations) ?
 	  ::OpenOrienteering::MapPrinter::tr("Processing separations of page %1...") :
 	  ::OpenOrienteering::MapPrinter::tr("Processing page %1...") );
 	auto message = message_template.arg(1);
 	emit printProgress(0, message);
 	
+	// When the map is drawn via a buffer, the map layers of the upcoming
+	// pages are rendered concurrently, and consumed in order. The templates
+	// are drawn on this thread.
+	auto const layer_size = pageBufferSize(&painter);
+	auto const layer_bytes = std::max(qint64(1), qint64(layer_size.width()) * layer_size.height() * 4);
+	auto max_in_flight = max_pages_in_flight > 0 ? max_pages_in_flight : QThread::idealThreadCount();
+	max_in_flight = int(std::min(qint64(max_in_flight), max_pages_in_flight_memory / layer_bytes));
+	auto const render_ahead = max_in_flight > 1
+	                          && page_extents.size() > 1
+	                          && !separationsModeSelected()
+	                          && usesMapBuffer()
+	                          && (!view || view->effectiveMapVisibility().visible);
+	auto const render_hints = painter.renderHints() | QPainter::Antialiasing | QPainter::SmoothPixmapTransform;
+	std::deque<std::future<QImage>> map_layers;
+	std::size_t next_layer = 0;
+	auto start_map_layers = [&]() {
+		while (render_ahead && next_layer < page_extents.size() && map_layers.size() < std::size_t(max_in_flight))
+		{
+			auto const& page_extent = page_extents[next_layer++];
+			map_layers.push_back(Util::startJob<QImage>([this, page_extent, layer_size, render_hints]() {
+				return renderMapLayer(page_extent, pageExtentTransform(page_extent), layer_size, render_hints);
+			}));
+		}
+	};
+	if (render_ahead)
+		prepareMapLayers();
+	
 	bool need_new_page = false;
-	for (auto vpos : v_page_pos)
+	for (auto const& page_extent : page_extents)
 	{
 		if (!painter.isActive())
 		{
 			break;
 		}
 		
-		for (auto hpos : h_page_pos)
+		start_map_layers();
+		
+		++step;
+		auto progress = qMin(99, qMax(1, int((100 * static_cast<decltype(num_steps)>(step) - 50) / num_steps)));
+		emit printProgress(progress, message_template.arg(step));
+		
+		if (cancel_print_map) /* during printProgress handling */
 		{
-			if (!painter.isActive())
-			{
-				break;
-			}
-			
-			++step;
-			auto progress = qMin(99, qMax(1, int((100 * static_cast<decltype(num_steps)>(step) - 50) / num_steps)));
-			emit printProgress(progress, message_template.arg(step));
-			
-			if (cancel_print_map) /* during printProgress handling */
-			{
-				painter.end();
-				break;
-			}
-				
-			if (need_new_page)
-			{
-				printer->newPage();
-			}
-			
-			QRectF page_extent = QRectF(QPointF(hpos, vpos), extent_size);
-			if (separationsModeSelected())
-			{
-				drawSeparationPages(printer, &painter, page_extent);
-			}
-			else
-			{
-				drawPage(&painter, page_extent);
-			}
+			painter.end();
+			break;
+		}
 			
-			need_new_page = true;
+		if (need_new_page)
+		{
+			printer->newPage();
 		}
+		
+		if (separationsModeSelected())
+		{
+			drawSeparationPages(printer, &painter, page_extent);
+		}
+		else if (render_ahead)
+		{
+			auto map_layer = map_layers.front().get();
+			map_layers.pop_front();
+			drawPage(&painter, page_extent, pageExtentTransform(page_extent), nullptr, std::move(map_layer));
+		}
+		else
+		{
+			drawPage(&painter, page_extent);
+		}
+		
+		need_new_page = true;
 	}
 	
+	// The workers use this object and the map.
+	for (auto& map_layer : map_layers)
+		map_layer.wait();
+	
 	if (cancel_print_map)
 	{
 		emit printProgress(100, ::OpenOrienteering::MapPrinter::tr("Canceled"));
@@ -1415,6 +1700,41 @@ bool MapPrinter::printMap(QPrinter* printer)
 	return true;
 }
 
+bool MapPrinter::printSeriesToFiles(QPrinter* printer, const QString& path)
+{
+	if (series_areas.empty())
+	{
+		printer->setOutputFileName(path);
+		return printMap(printer);
+	}
+	
+	// Each sheet is printed as a series of a single area.
+	auto all_areas = std::vector<QRectF>();
+	swap(all_areas, series_areas);
+	auto const num_sheets = int(all_areas.size());
+	auto success = true;
+	for (int i = 0; i < num_sheets && success && !cancel_print_map; ++i)
+	{
+		series_areas = { all_areas[std::size_t(i)] };
+		printer->setOutputFileName(seriesSheetPath(path, i + 1, num_sheets));
+		success = printMap(printer);
+	}
+	series_areas = std::move(all_areas);
+	return success;
+}
+
+// static
+QString MapPrinter::seriesSheetPath(const QString& path, int sheet, int num_sheets)
+{
+	auto const digits = QString::number(num_sheets).length();
+	auto const number = QString::fromLatin1("-%1").arg(sheet, digits, 10, QLatin1Char('0'));
+	auto const file_name_start = path.lastIndexOf(QLatin1Char('/')) + 1;
+	auto suffix_start = path.lastIndexOf(QLatin1Char('.'));
+	if (suffix_start <= file_name_start)
+		suffix_start = path.length();
+	return QString(path).insert(suffix_start, number);
+}
+
 void MapPrinter::cancelPrintMap()
 {
 	cancel_print_map = true;
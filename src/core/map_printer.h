@@ -22,12 +22,14 @@
 #ifndef OPENORIENTEERING_MAP_PRINTER_H
 #define OPENORIENTEERING_MAP_PRINTER_H
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 #include <QtGlobal>
 #include <QObject>
 #include <QPageSize>
+#include <QPainter>
 #include <QRectF>
 #include <QSizeF>
 #include <QString>
@@ -42,9 +44,9 @@
 template <class Key, class T>
 class QHash;
 class QImage;
-class QPainter;
 class QPrinter;
 class QRectF;
+class QSize;
 class QSizeF;
 class QXmlStreamReader;
 class QXmlStreamWriter;
@@ -131,7 +133,8 @@ public:
 	enum ColorMode
 	{
 		DefaultColorMode,  ///< Use the target engine's default color mode.
-		DeviceCmyk         ///< Use device-dependent CMYK for vector data.
+		DeviceCmyk,        ///< Use device-dependent CMYK for vector data.
+		SpotColors         ///< Use the map's spot colors (Separation, DeviceN) for vector data.
 	};
 
 	/** Constructs new printer options.
@@ -211,6 +214,13 @@ public:
 	 *  to the current page size. */
 	bool single_page_print_area;
 	
+	/** The print areas of a map series.
+	 * 
+	 *  When this list is not empty, the map series is printed instead of the
+	 *  print area: Each area makes a sheet, with the page breaks determined
+	 *  like for the print area. */
+	std::vector<QRectF> series_areas;
+	
 	/** Platform-dependent data. */
 	std::shared_ptr<void> native_data;
 };
@@ -310,6 +320,24 @@ public:
 		return v_page_pos;
 	}
 	
+	/** Returns the print areas of the map series.
+	 * 
+	 *  @see MapPrinterConfig::series_areas */
+	const std::vector<QRectF>& getSeriesAreas() const
+	{
+		return series_areas;
+	}
+	
+	/** Sets the print areas of the map series.
+	 * 
+	 *  An empty list returns to printing the print area. */
+	void setSeriesAreas(std::vector<QRectF> areas);
+	
+	/** Returns the map extents of all pages which printMap() prints.
+	 * 
+	 *  For a map series, the pages are ordered by sheet. */
+	std::vector<QRectF> pageExtents() const;
+	
 	
 	/**
 	 * Returns true when the Qt print engine may rasterize non-opaque data.
@@ -356,6 +384,18 @@ public:
 	 *  @return true on success, false on error. */
 	bool printMap(QPrinter* printer);
 	
+	/** Prints each sheet of the map series to a separate file.
+	 * 
+	 *  The file names are derived from the given path by inserting the
+	 *  sheet number before the suffix, e.g. "atlas-01.pdf". Without a map
+	 *  series, this is the same as printMap() to the given path.
+	 * 
+	 *  @return true on success, false on error. */
+	bool printSeriesToFiles(QPrinter* printer, const QString& path);
+	
+	/** Returns the file name which printSeriesToFiles() uses for a sheet. */
+	static QString seriesSheetPath(const QString& path, int sheet, int num_sheets);
+	
 	/** Draws a single page to the painter.
 	 * 
 	 *  In case of an error, the painter will be inactive when returning from
@@ -371,9 +411,44 @@ public:
 	
 	void drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer = nullptr) const;
 	
+	/** Draws a single page, using a prerendered map layer if it is not null.
+	 * 
+	 *  The map layer must have the size of the page buffer.
+	 *  @see renderMapLayer() */
+	void drawPage(QPainter* device_painter, const QRectF& page_extent, const QTransform& page_extent_transform, QImage* page_buffer, QImage map_layer) const;
+	
+	/** Returns true if drawPage() draws the map to a temporary buffer.
+	 * 
+	 *  Only in this case, drawPage() can use a prerendered map layer. */
+	bool usesMapBuffer() const;
+	
+	/** Updates the map's renderables, ahead of concurrent calls to renderMapLayer(). */
+	void prepareMapLayers() const;
+	
+	/** Draws the map for the given page into a new transparent image.
+	 * 
+	 *  This does not update the map's renderables, so it may be called
+	 *  concurrently, after a call to prepareMapLayers().
+	 *  The image is null if the allocation fails. */
+	QImage renderMapLayer(const QRectF& page_extent, const QTransform& page_extent_transform, const QSize& size, QPainter::RenderHints render_hints) const;
+	
 	/** Draws the separations as distinct pages to the printer. */
 	void drawSeparationPages(QPrinter* printer, QPainter* device_painter, const QRectF& page_extent) const;
 	
+	/** Returns the maximum number of pages which printMap() renders ahead.
+	 * 
+	 *  @see setMaxPagesInFlight() */
+	int maxPagesInFlight() const { return max_pages_in_flight; }
+	
+	/** Sets the maximum number of pages which printMap() renders ahead.
+	 * 
+	 *  When the map is drawn via a page buffer, e.g. in raster mode, printMap()
+	 *  draws the map layers of the upcoming pages concurrently on worker
+	 *  threads, and the pages are sent to the printer in order. The number
+	 *  of pages in flight is further limited by the memory needed for the
+	 *  page buffers. 0 selects the number of cores, 1 disables rendering ahead. */
+	void setMaxPagesInFlight(int value) { max_pages_in_flight = std::max(0, value); }
+	
 	/** Returns the current configuration. */
 	const MapPrinterConfig& config() const
 	{
@@ -478,9 +553,18 @@ protected:
 	/** Updates the paper dimensions from paper format and orientation. */
 	void updatePaperDimensions();
 	
+	/** Returns the size of a page buffer for the given device painter. */
+	QSize pageBufferSize(const QPainter* device_painter) const;
+	
+	/** Returns the transformation from the page extent to the page buffer. */
+	QTransform pageExtentTransform(const QRectF& page_extent) const;
+	
 	/** Updates the page breaks from map area and page format. */
 	void updatePageBreaks();
 	
+	/** Calculates the page breaks for the given area from the page format. */
+	void calculatePageBreaks(const QRectF& area, std::vector<qreal>& h_pos, std::vector<qreal>& v_pos) const;
+	
 	/** Updates the scale adjustment and page breaks. */
 	void mapScaleChanged();
 	
@@ -491,6 +575,7 @@ protected:
 	qreal scale_adjustment;
 	std::vector<qreal> h_page_pos;
 	std::vector<qreal> v_page_pos;
+	int max_pages_in_flight = 0;
 	bool cancel_print_map = false;
 };
 
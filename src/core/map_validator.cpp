@@ -0,0 +1,251 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_validator.h"
+
+#include <algorithm>
+
+#include <QMetaObject>
+#include <QRectF>
+
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The number of objects which are validated before returning to the event loop
+constexpr std::size_t batch_size = 256;
+
+}  // namespace
+
+
+
+MapValidator::MapValidator(Map& map, QObject* parent)
+: QObject(parent)
+, map(map)
+{
+	connect(&map, &Map::objectUpdated, this, &MapValidator::objectUpdated);
+}
+
+MapValidator::~MapValidator() = default;
+
+
+void MapValidator::start()
+{
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		map.getPart(i)->applyOnAllObjects([this](const Object* object) {
+			objectUpdated(object);
+		});
+	}
+}
+
+
+std::vector<Object*> MapValidator::objectsWithIssues()
+{
+	std::vector<Object*> objects;
+	objects.reserve(std::size_t(results.size()));
+	for (auto item = results.begin(); item != results.end(); )
+	{
+		auto* part = findPart(item.key());
+		if (!part)
+		{
+			item = results.erase(item);
+			continue;
+		}
+		
+		auto* object = const_cast<Object*>(item.key());
+		if (item.value().testFlag(DuplicateObject))
+		{
+			object->update();
+			item.value() &= ~Issues(DuplicateObject);
+			item.value() |= checkDuplicates(part, object);
+		}
+		if (!item.value())
+		{
+			item = results.erase(item);
+			continue;
+		}
+		
+		objects.push_back(object);
+		++item;
+	}
+	return objects;
+}
+
+
+// static
+MapValidator::Issues MapValidator::checkGeometry(const Object* object)
+{
+	auto issues = Issues(NoIssue);
+	if (object->getType() != Object::Path)
+		return issues;
+	
+	auto const* path = object->asPath();
+	auto const& parts = path->parts();
+	for (auto const& part : parts)
+	{
+		auto const& path_coords = part.path_coords;
+		for (std::size_t i = 1; i < path_coords.size(); ++i)
+		{
+			if (path_coords[i].clen == path_coords[i-1].clen)
+			{
+				issues |= ZeroLengthSegment;
+				break;
+			}
+		}
+	}
+	
+	auto const* symbol = path->getSymbol();
+	if (symbol && (symbol->getContainedTypes() & Symbol::Area) && !parts.empty())
+	{
+		PathObject::Intersections intersections;
+		path->calcSelfIntersections(intersections);
+		if (!intersections.empty())
+			issues |= SelfIntersection;
+		
+		auto const& outline = parts.front().path_coords;
+		auto hole_outside = [&outline](const PathPart& hole) {
+			return !hole.path_coords.empty() && !outline.isPointInside(hole.path_coords.front().pos);
+		};
+		if (std::any_of(parts.begin() + 1, parts.end(), hole_outside))
+			issues |= HoleOutsideOutline;
+	}
+	
+	return issues;
+}
+
+
+// static
+MapValidator::Issues MapValidator::checkDuplicates(const MapPart* part, const Object* object)
+{
+	auto const& extent = object->getExtent();
+	for (auto const* other : part->findCandidates(extent))
+	{
+		if (other != object
+		    && other->getSymbol() == object->getSymbol()
+		    && other->getExtent() == extent
+		    && other->equals(object, false))
+		{
+			return DuplicateObject;
+		}
+	}
+	return NoIssue;
+}
+
+
+void MapValidator::objectUpdated(const Object* object)
+{
+	if (pending_set.contains(object))
+		return;
+	
+	pending_set.insert(object);
+	pending.push_back(object);
+	scheduleBatch();
+}
+
+
+void MapValidator::scheduleBatch()
+{
+	if (!batch_scheduled)
+	{
+		batch_scheduled = true;
+		QMetaObject::invokeMethod(this, "validateNextBatch", Qt::QueuedConnection);
+	}
+}
+
+
+MapPart* MapValidator::findPart(const Object* object) const
+{
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		auto* part = map.getPart(i);
+		if (part->contains(object))
+			return part;
+	}
+	return nullptr;
+}
+
+
+void MapValidator::validateNextBatch()
+{
+	batch_scheduled = false;
+	
+	// Objects may have been deleted since they were queued.
+	std::vector<const Object*> batch;
+	std::vector<const MapPart*> batch_parts;
+	auto const batch_end = std::min(pending.size(), next_pending + batch_size);
+	for (; next_pending < batch_end; ++next_pending)
+	{
+		auto const* object = pending[next_pending];
+		if (auto const* part = findPart(object))
+		{
+			batch.push_back(object);
+			batch_parts.push_back(part);
+		}
+		else
+		{
+			pending_set.remove(object);
+			results.remove(object);
+		}
+	}
+	
+	// Updating the batch must not queue its objects again.
+	Object::updateAll(batch);
+	for (auto const* object : batch)
+		pending_set.remove(object);
+	
+	std::vector<Issues> batch_issues(batch.size());
+	Util::parallelFor(batch.size(), 16, [&batch, &batch_issues](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			batch_issues[i] = checkGeometry(batch[i]);
+	});
+	
+	// The spatial index is not thread-safe.
+	for (std::size_t i = 0; i < batch.size(); ++i)
+	{
+		auto const issues = batch_issues[i] | checkDuplicates(batch_parts[i], batch[i]);
+		if (!issues)
+			results.remove(batch[i]);
+		else
+			results.insert(batch[i], issues);
+	}
+	
+	if (isRunning())
+	{
+		emit progressChanged(int(100 * next_pending / pending.size()));
+		scheduleBatch();
+	}
+	else
+	{
+		pending.clear();
+		next_pending = 0;
+		emit progressChanged(100);
+		emit finished();
+	}
+}
+
+
+}  // namespace OpenOrienteering
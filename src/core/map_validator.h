@@ -0,0 +1,167 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_VALIDATOR_H
+#define OPENORIENTEERING_MAP_VALIDATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QFlags>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPart;
+class Object;
+
+
+/**
+ * Checks the objects of a map for geometric problems.
+ *
+ * The validation is done in batches from the event loop, so that the user
+ * can continue to work while a large map is checked. Within a batch, the
+ * objects are checked concurrently. After the initial pass, the validator
+ * follows Map::objectUpdated(), and it checks the updated objects again.
+ */
+class MapValidator : public QObject
+{
+Q_OBJECT
+	
+public:
+	/**
+	 * The kinds of problems which are detected.
+	 */
+	enum Issue
+	{
+		NoIssue            = 0x00,
+		SelfIntersection   = 0x01,  ///< The outline of an area touches or crosses itself.
+		ZeroLengthSegment  = 0x02,  ///< Consecutive points of a path are at the same position.
+		HoleOutsideOutline = 0x04,  ///< A hole of an area is not inside the outer boundary.
+		DuplicateObject    = 0x08,  ///< Another object has the same symbol and geometry.
+	};
+	Q_DECLARE_FLAGS(Issues, Issue)
+	
+	
+	/**
+	 * Constructs a validator for the given map.
+	 * 
+	 * The validation is not started before calling start().
+	 */
+	explicit MapValidator(Map& map, QObject* parent = nullptr);
+	
+	~MapValidator() override;
+	
+	
+	/**
+	 * Schedules the validation of all objects of the map.
+	 */
+	void start();
+	
+	/**
+	 * Returns true while there are objects waiting for validation.
+	 */
+	bool isRunning() const { return next_pending < pending.size(); }
+	
+	
+	/**
+	 * Returns the issues found for the given object.
+	 */
+	Issues issues(const Object* object) const { return results.value(object); }
+	
+	/**
+	 * Returns the objects of the map which have issues.
+	 * 
+	 * Results for objects which were removed from the map are dropped.
+	 * Duplicates are checked again, because an object is not revalidated
+	 * when its duplicate changes.
+	 */
+	std::vector<Object*> objectsWithIssues();
+	
+	
+	/**
+	 * Checks a single object for problems of its own geometry.
+	 * 
+	 * The object must be up to date. This function may be called
+	 * concurrently for different objects.
+	 */
+	static Issues checkGeometry(const Object* object);
+	
+	/**
+	 * Checks if the map part contains a duplicate of the object.
+	 */
+	static Issues checkDuplicates(const MapPart* part, const Object* object);
+	
+	
+signals:
+	/**
+	 * Emitted after each batch of the validation.
+	 */
+	void progressChanged(int percent);
+	
+	/**
+	 * Emitted when all scheduled objects were validated.
+	 */
+	void finished();
+	
+	
+private:
+	/**
+	 * Queues an object for validation.
+	 */
+	void objectUpdated(const OpenOrienteering::Object* object);
+	
+	/**
+	 * Schedules validateNextBatch(), if not done already.
+	 */
+	void scheduleBatch();
+	
+	/**
+	 * Returns the part which contains the object, or nullptr.
+	 */
+	MapPart* findPart(const Object* object) const;
+	
+private slots:
+	/**
+	 * Validates the next batch of pending objects.
+	 */
+	void validateNextBatch();
+	
+private:
+	Map& map;
+	std::vector<const Object*> pending;
+	QSet<const Object*> pending_set;
+	std::size_t next_pending = 0;
+	QHash<const Object*, Issues> results;
+	bool batch_scheduled = false;
+
+};
+
+
+}  // namespace OpenOrienteering
+
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(OpenOrienteering::MapValidator::Issues)
+
+
+#endif // OPENORIENTEERING_MAP_VALIDATOR_H
@@ -401,6 +401,11 @@ bool MapView::isTemplateVisible(const Template* temp) const
 	       && entry->opacity > 0;
 }
 
+bool MapView::isTemplateDisplayed(const Template* temp) const
+{
+	return isTemplateVisible(temp) && temp->isVisibleAtZoom(zoom);
+}
+
 TemplateVisibility MapView::getTemplateVisibility(const Template* temp) const
 {
 	auto entry = findVisibility(temp);
@@ -280,6 +280,14 @@ public:
 	 */
 	bool isTemplateVisible(const Template* temp) const;
 	
+	/**
+	 * Checks if the template is visible and if the current zoom is within
+	 * the template's zoom range.
+	 * 
+	 * This decides about drawing the template on screen.
+	 */
+	bool isTemplateDisplayed(const Template* temp) const;
+	
 	/**
 	 * Returns the template visibility.
 	 * 
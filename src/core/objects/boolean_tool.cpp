@@ -24,16 +24,20 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <QtGlobal>
 #include <QDebug>
 #include <QFlags>
 #include <QHash>
 #include <QHashFunctions>
+#include <QPointF>
+#include <QRectF>
 #include <QScopedPointer>
 
 #include <clipper.hpp>
@@ -48,6 +52,7 @@
 #include "undo/object_undo.h"
 #include "undo/undo.h"
 #include "util/backports.h"  // IWYU pragma: keep
+#include "util/parallel.h"
 #include "util/util.h"
 
 
@@ -109,12 +114,31 @@ static void outerPolyNodeToPathObjects(
         const PathObject* proto,
         const PolyMap& polymap );
 
+/**
+ * A point of a polygon, and the path coord it was created from.
+ */
+using PolyMapEntries = std::vector<std::pair<ClipperLib::IntPoint, PathCoordInfo>>;
+
 /**
  * Constructs ClipperLib::Paths from a PathObject.
+ * 
+ * The object must be up to date. The entries for the polymap are appended
+ * to polymap_entries, so that this function can be called concurrently.
  */
 static void pathObjectToPolygons(
         const PathObject* object,
         ClipperLib::Paths& polygons,
+        PolyMapEntries& polymap_entries );
+
+/**
+ * Constructs ClipperLib::Paths for each of the given objects.
+ * 
+ * The objects are converted concurrently. The polymap is filled in the order
+ * of the objects.
+ */
+static void pathObjectsToPolygons(
+        const std::vector<const PathObject*>& objects,
+        std::vector<ClipperLib::Paths>& polygons,
         PolyMap& polymap );
 
 /**
@@ -200,6 +224,32 @@ static bool checkSegmentMatch(
         bool& out_coords_increasing,
         bool& out_is_curve );
 
+/**
+ * The number of objects above which a union is split into sub-unions.
+ */
+constexpr std::size_t union_partition_size = 32;
+
+/**
+ * The polygons of a single object, for partitioned unions.
+ */
+struct UnionItem
+{
+	ClipperLib::Paths polygons;
+	QPointF center;
+};
+
+using UnionItems = std::vector<UnionItem>;
+
+/**
+ * Unites the polygons of a range of objects.
+ * 
+ * Large ranges are bisected along the longer side of the bounding box of the
+ * objects' centers. The halves are united concurrently, and then the results
+ * are united. The solution is either ClipperLib::Paths or ClipperLib::PolyTree.
+ */
+template <class Solution>
+bool uniteRange(UnionItems::iterator first, UnionItems::iterator last, Solution& solution);
+
 /**
  * Removes flags from the coordinate to be able to use it in the reconstruction.
  */
@@ -292,12 +342,22 @@ bool BooleanTool::executePerSymbol()
 			backlog.push_back(object->asPath());
 	}
 	
-	QScopedPointer<CombinedUndoStep> undo_step(new CombinedUndoStep(map));
+	// The groups of objects are independent of each other.
+	struct Group
+	{
+		PathObject* primary_object;
+		PathObjects in_objects;
+		PathObjects out_objects;
+		bool success;
+	};
+	std::vector<Group> groups;
+	std::vector<const Object*> group_objects;
+	group_objects.reserve(backlog.size());
+	
 	PathObjects new_backlog;
 	new_backlog.reserve(backlog.size()/2);
 	PathObjects in_objects;
 	in_objects.reserve(backlog.size()/2);
-	PathObjects out_objects;
 	while (!backlog.empty())
 	{
 		PathObject* const primary_object = backlog.front();
@@ -326,9 +386,31 @@ bool BooleanTool::executePerSymbol()
 		if (in_objects.size() == 1)
 			continue;
 		
-		// Perform the core operation
-		out_objects.clear();
-		executeForObjects(primary_object, in_objects, out_objects, *undo_step);
+		groups.push_back({ primary_object, in_objects, {}, false });
+		group_objects.insert(group_objects.end(), in_objects.begin(), in_objects.end());
+		if (std::find(in_objects.begin(), in_objects.end(), primary_object) == in_objects.end())
+			group_objects.push_back(primary_object);
+	}
+	
+	// Prepare the path coords before the concurrent operation,
+	// so that the objects are not modified by the worker threads.
+	Object::updateAll(group_objects);
+	
+	// Perform the core operation
+	Util::parallelFor(groups.size(), 1, [this, &groups](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			auto& group = groups[i];
+			group.success = executeForObjects(group.primary_object, group.in_objects, group.out_objects);
+		}
+	});
+	
+	// Apply the results in the original order
+	QScopedPointer<CombinedUndoStep> undo_step(new CombinedUndoStep(map));
+	for (const auto& group : groups)
+	{
+		if (group.success)
+			replaceObjects(group.primary_object, group.in_objects, group.out_objects, *undo_step);
 	}
 	
 	bool const have_changes = undo_step->getNumSubSteps() > 0;
@@ -350,6 +432,12 @@ bool BooleanTool::executeForObjects(const PathObject* subject, const PathObjects
 		return false; // in release build
 	}
 	
+	replaceObjects(subject, in_objects, out_objects, undo_step);
+	return true;
+}
+
+void BooleanTool::replaceObjects(const PathObject* subject, const PathObjects& in_objects, const PathObjects& out_objects, CombinedUndoStep& undo_step)
+{
 	// Add original objects to undo step, and remove them from map.
 	QScopedPointer<AddObjectsUndoStep> add_step(new AddObjectsUndoStep(map));
 	for (PathObject* object : in_objects)
@@ -386,7 +474,6 @@ bool BooleanTool::executeForObjects(const PathObject* subject, const PathObjects
 	
 	undo_step.push(add_step.take());
 	undo_step.push(delete_step.take());
-	return true;
 }
 
 bool BooleanTool::executeForObjects(const PathObject* subject, const PathObjects& in_objects, PathObjects& out_objects) const
@@ -396,16 +483,39 @@ bool BooleanTool::executeForObjects(const PathObject* subject, const PathObjects
 	// These paths are to be regarded as closed.
 	PolyMap polymap;
 	
-	ClipperLib::Paths subject_polygons;
-	pathObjectToPolygons(subject, subject_polygons, polymap);
+	// Large unions are split into spatially partitioned sub-unions.
+	if (op == Union && in_objects.size() > union_partition_size)
+	{
+		std::vector<ClipperLib::Paths> polygons;
+		pathObjectsToPolygons({ in_objects.begin(), in_objects.end() }, polygons, polymap);
+		
+		UnionItems items;
+		items.reserve(in_objects.size());
+		for (std::size_t i = 0; i < in_objects.size(); ++i)
+			items.push_back({ std::move(polygons[i]), in_objects[i]->getExtent().center() });
+		
+		ClipperLib::PolyTree solution;
+		bool success = uniteRange(begin(items), end(items), solution);
+		if (success)
+			polyTreeToPathObjects(solution, out_objects, subject, polymap);
+		return success;
+	}
+	
+	// The subject comes first, followed by the clip objects.
+	std::vector<const PathObject*> objects;
+	objects.reserve(in_objects.size() + 1);
+	objects.push_back(subject);
+	std::copy_if(in_objects.begin(), in_objects.end(), std::back_inserter(objects), [subject](auto* object) {
+		return object != subject;
+	});
+	std::vector<ClipperLib::Paths> polygons;
+	pathObjectsToPolygons(objects, polygons, polymap);
 	
+	auto& subject_polygons = polygons.front();
 	ClipperLib::Paths clip_polygons;
-	for (PathObject* object : in_objects)
+	for (auto item = polygons.begin() + 1; item != polygons.end(); ++item)
 	{
-		if (object != subject)
-		{
-			pathObjectToPolygons(object, clip_polygons, polymap);
-		}
+		std::move(item->begin(), item->end(), std::back_inserter(clip_polygons));
 	}
 	
 	// Do the operation.
@@ -533,10 +643,54 @@ void BooleanTool::executeForLine(const PathObject* area, const PathObject* line,
 
 namespace {
 
+template <class Solution>
+bool uniteRange(UnionItems::iterator first, UnionItems::iterator last, Solution& solution)
+{
+	ClipperLib::Clipper clipper;
+	if (std::size_t(std::distance(first, last)) <= union_partition_size)
+	{
+		for (auto item = first; item != last; ++item)
+			clipper.AddPaths(item->polygons, ClipperLib::ptSubject, true);
+	}
+	else
+	{
+		auto bounds = QRectF(first->center, first->center);
+		for (auto item = first; item != last; ++item)
+			rectInclude(bounds, item->center);
+		
+		auto const middle = first + std::distance(first, last) / 2;
+		if (bounds.width() >= bounds.height())
+			std::nth_element(first, middle, last, [](const UnionItem& a, const UnionItem& b) { return a.center.x() < b.center.x(); });
+		else
+			std::nth_element(first, middle, last, [](const UnionItem& a, const UnionItem& b) { return a.center.y() < b.center.y(); });
+		
+		ClipperLib::Paths halves[2];
+		bool success[2] = { false, false };
+		Util::parallelFor(2, 1, [&](std::size_t i, std::size_t /*end*/) {
+			success[i] = (i == 0) ? uniteRange(first, middle, halves[0])
+			                      : uniteRange(middle, last, halves[1]);
+		});
+		if (!success[0] || !success[1])
+			return false;
+		
+		clipper.AddPaths(halves[0], ClipperLib::ptSubject, true);
+		clipper.AddPaths(halves[1], ClipperLib::ptClip, true);
+	}
+	return clipper.Execute(ClipperLib::ctUnion, solution, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+}
+
 void polyTreeToPathObjects(const ClipperLib::PolyTree& tree, PathObjects& out_objects, const PathObject* proto, const PolyMap& polymap)
 {
-	for (int i = 0, count = tree.ChildCount(); i < count; ++i)
-		outerPolyNodeToPathObjects(*tree.Childs[i], out_objects, proto, polymap);
+	// The outer polygons are converted concurrently, reading the polymap
+	// and the original objects only.
+	auto const count = std::size_t(tree.ChildCount());
+	std::vector<PathObjects> results(count);
+	Util::parallelFor(count, 4, [&tree, &results, proto, &polymap](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			outerPolyNodeToPathObjects(*tree.Childs[i], results[i], proto, polymap);
+	});
+	for (auto const& result : results)
+		out_objects.insert(out_objects.end(), result.begin(), result.end());
 }
 
 void outerPolyNodeToPathObjects(const ClipperLib::PolyNode& node, PathObjects& out_objects, const PathObject* proto, const PolyMap& polymap)
@@ -564,13 +718,35 @@ void outerPolyNodeToPathObjects(const ClipperLib::PolyNode& node, PathObjects& o
 	}
 }
 
+void pathObjectsToPolygons(
+        const std::vector<const PathObject*>& objects,
+        std::vector<ClipperLib::Paths>& polygons,
+        PolyMap& polymap)
+{
+	// Prepare the path coords before the concurrent conversion.
+	for (auto const* object : objects)
+		object->update();
+	
+	polygons.resize(objects.size());
+	std::vector<PolyMapEntries> polymap_entries(objects.size());
+	Util::parallelFor(objects.size(), 8, [&objects, &polygons, &polymap_entries](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			pathObjectToPolygons(objects[i], polygons[i], polymap_entries[i]);
+	});
+	
+	for (auto const& entries : polymap_entries)
+	{
+		for (auto const& entry : entries)
+			polymap.insertMulti(entry.first, entry.second);
+	}
+}
+
 void pathObjectToPolygons(
         const PathObject* object,
         ClipperLib::Paths& polygons,
-        PolyMap& polymap)
+        PolyMapEntries& polymap_entries)
 {
-	object->update();
-	auto coords = object->getRawCoordinateVector();
+	auto const& coords = object->getRawCoordinateVector();
 	
 	polygons.reserve(polygons.size() + object->parts().size());
 	
@@ -596,7 +772,7 @@ void pathObjectToPolygons(
 				auto point = MapCoord { path_coord.pos };
 				polygon.push_back(ClipperLib::IntPoint(point.nativeX(), point.nativeY()));
 			}
-			polymap.insertMulti(polygon.back(), std::make_pair(&part, &path_coord));
+			polymap_entries.emplace_back(polygon.back(), std::make_pair(&part, &path_coord));
 		}
 		
 		bool orientation = Orientation(polygon);
@@ -85,7 +85,7 @@ public:
 	 * 
 	 * Executes the operation independently for every group of path objects
 	 * which have got the same symbol. Objects which are not of type
-	 * Object::Path are ignored.
+	 * Object::Path are ignored. The groups are processed concurrently.
 	 * 
 	 * Errors during the operation are ignored, too. The original objects the
 	 * operation failed for remain unchanged. The operation continues for other
@@ -139,6 +139,23 @@ protected:
 	        PathObjects& out_objects,
 	        CombinedUndoStep& undo_step );
 	
+	/**
+	 * Replaces the input objects by the result of an operation, and provides
+	 * undo steps.
+	 * 
+	 * This function changes the collection of objects in the map and the selection.
+	 * 
+	 * @param subject               The primary affected object.
+	 * @param in_objects            All objects the operation was executed on.
+	 * @param out_objects           The resulting collection of objects.
+	 * @param undo_step             A combined undo step which will be filled with sub steps.
+	 */
+	void replaceObjects(
+	        const PathObject* subject,
+	        const PathObjects& in_objects,
+	        const PathObjects& out_objects,
+	        CombinedUndoStep& undo_step );
+	
 	Operation const op;
 	Map* const map;
 };
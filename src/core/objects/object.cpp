@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2021, 2025 Kai Pastor
+ *    Copyright 2012-2021, 2025, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -25,10 +25,12 @@
 #include <cmath>
 #include <cstddef>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 #include <Qt>
 #include <QtNumeric>
@@ -36,6 +38,7 @@
 #include <QLatin1String>
 #include <QPoint>
 #include <QPointF>
+#include <QRectF>
 #include <QScopedPointer>
 #include <QStringRef>
 #include <QTransform>
@@ -55,6 +58,11 @@
 #include "core/virtual_coord_vector.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_import_export.h"
+#include "fileformats/xml_file_format.h"
+#include "util/parallel.h"
+#include "util/performance_counters.h"
+#include "util/spatial_index.h"
+#include "util/trace.h"
 #include "util/util.h"
 #include "util/xml_stream_util.h"
 
@@ -82,31 +90,70 @@ namespace literal
 
 namespace OpenOrienteering {
 
+// ### SharedMapCoordVector ###
+
+SharedMapCoordVector& SharedMapCoordVector::operator=(const SharedMapCoordVector& other)
+{
+	if (other.d != d)
+		replace(other.d);
+	return *this;
+}
+
+SharedMapCoordVector& SharedMapCoordVector::operator=(MapCoordVector coords)
+{
+	if (isShared())
+		replace(std::make_shared<MapCoordVector>(std::move(coords)));
+	else
+		*d = std::move(coords);
+	return *this;
+}
+
+void SharedMapCoordVector::clear()
+{
+	if (isShared())
+		replace(std::make_shared<MapCoordVector>());
+	else
+		d->clear();
+}
+
+void SharedMapCoordVector::detachShared()
+{
+	replace(std::make_shared<MapCoordVector>(*d));
+}
+
+void SharedMapCoordVector::replace(std::shared_ptr<MapCoordVector> coords)
+{
+	d = std::move(coords);
+	owner->coordinateStorageChanged();
+}
+
+
+
 // ### Object implementation ###
 
 Object::Object(Object::Type type, const Symbol* symbol)
-: type(type)
-, symbol(symbol)
+: symbol(symbol)
+, type(type)
 , output(*this)
 {
 	// nothing
 }
 
 Object::Object(Object::Type type, const Symbol* symbol, MapCoordVector coords, Map* map)
-: type(type)
-, symbol(symbol)
-, coords(std::move(coords))
+: symbol(symbol)
+, coords(std::move(coords), this)
 , map(map)
+, type(type)
 , output(*this)
 {
 	// nothing
 }
 
 Object::Object(const Object& proto)
- : type(proto.type)
- , symbol(proto.symbol)
- , coords(proto.coords)
- , object_tags(proto.object_tags)
+ : symbol(proto.symbol)
+ , coords(proto.coords, this)
+ , object_tags(proto.object_tags ? std::make_unique<KeyValueContainer>(*proto.object_tags) : nullptr)
+ , type(proto.type)
  , rotation(proto.rotation)
  , extent(proto.extent)
  , output(*this)
@@ -124,13 +171,19 @@ void Object::copyFrom(const Object& other)
 	if (type != other.type)
 		throw std::invalid_argument(Q_FUNC_INFO);
 	
+	auto const old_symbol = symbol;
+	auto const tags_changed = tags() != other.tags();
 	symbol = other.symbol;
 	coords = other.coords;
 	rotation = other.rotation;
 	// map unchanged!
-	object_tags = other.object_tags;
-	output_dirty = true;
+	assignTags(other.tags());
+	setOutputDirty();
 	extent = other.extent;
+	if (map && symbol != old_symbol)
+		map->updateSymbolIndex(this, old_symbol);
+	if (map && tags_changed)
+		map->updateTagIndex(this);
 }
 
 bool Object::equals(const Object* other, bool compare_symbol) const
@@ -186,11 +239,13 @@ bool Object::equals(const Object* other, bool compare_symbol) const
 			return false;
 	}
 	
-	if (object_tags.empty())
-		return other->object_tags.empty();
+	if (!object_tags)
+		return !other->object_tags;
+	if (!other->object_tags)
+		return false;
 	
 	using std::begin; using std::end;
-	return std::is_permutation(object_tags.begin(), object_tags.end(), other->object_tags.begin(), other->object_tags.end());
+	return std::is_permutation(object_tags->begin(), object_tags->end(), other->object_tags->begin(), other->object_tags->end());
 }
 
 
@@ -242,14 +297,19 @@ const TextObject* Object::asText() const
 
 void Object::save(QXmlStreamWriter& xml) const
 {
-	XmlElementWriter object_element(xml, literal::object);
-	object_element.writeAttribute(literal::type, type);
 	int symbol_index = -1;
 	if (map)
 		symbol_index = map->findSymbolIndex(symbol);
+	save(xml, symbol_index, symbol->isRotatable(), XMLFileFormat::active_version);
+}
+
+void Object::save(QXmlStreamWriter& xml, int symbol_index, bool rotatable, int format_version) const
+{
+	XmlElementWriter object_element(xml, literal::object);
+	object_element.writeAttribute(literal::type, type);
 	if (symbol_index != -1)
 		object_element.writeAttribute(literal::symbol, symbol_index);
-	if (symbol->isRotatable() && !qIsNull(rotation))
+	if (rotatable && !qIsNull(rotation))
 		object_element.writeAttribute(literal::rotation, rotation);
 	
 	if (type == Text)
@@ -271,16 +331,16 @@ void Object::save(QXmlStreamWriter& xml) const
 		}
 	}
 	
-	if (!object_tags.empty())
+	if (object_tags)
 	{
 		XmlElementWriter tags_element(xml, literal::tags);
-		tags_element.write(object_tags);
+		tags_element.write(*object_tags);
 	}
 	
 	{
 		// Scope of coords XML element
 		XmlElementWriter coords_element(xml, literal::coords);
-		coords_element.write(coords);
+		coords_element.write(coords, format_version);
 	}
 	
 	if (type == Path)
@@ -304,10 +364,13 @@ void Object::save(QXmlStreamWriter& xml) const
 	}
 }
 
-Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& symbol_dict, const Symbol* symbol)
+Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& symbol_dict, const Symbol* symbol, DeferredCoords* deferred)
 {
 	Q_ASSERT(xml.name() == literal::object);
 	
+	if (deferred)
+		deferred->text.clear();
+	
 	XmlElementReader object_element(xml);
 	
 	Object::Type object_type = object_element.attribute<Object::Type>(literal::type);
@@ -379,13 +442,16 @@ Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& sy
 			try {
 				if (object_type == Text)
 				{
-					coords_element.readForText(object->coords);
+					coords_element.readForText(object->coords.mutableVector());
 					if (object->coords.size() > 1)
 						static_cast<TextObject*>(object)->setBoxSize(object->coords[1]);
 				}
 				else
 				{
-					coords_element.read(object->coords);
+					// The first coordinate may initialize the bounds offset.
+					if (MapCoord::boundsOffset().check_for_offset)
+						deferred = nullptr;
+					coords_element.read(object->coords.mutableVector(), deferred);
 				}
 			}
 			catch (FileFormatException& e)
@@ -436,18 +502,25 @@ Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& sy
 		}
 		else if (xml.name() == literal::tags)
 		{
-			XmlElementReader(xml).read(object->object_tags);
+			KeyValueContainer tags;
+			XmlElementReader(xml).read(tags);
+			object->assignTags(std::move(tags));
+			if (map && object->object_tags)
+				object->object_tags->internStrings(map->tagStrings());
 		}
 		else
 			xml.skipCurrentElement(); // unknown
 	}
 	
+	object->output_dirty = true;
+	if (deferred && !deferred->text.isEmpty())
+		return object;
+	
 	if (object_type == Path)
 	{
 		auto* path = static_cast<PathObject*>(object);
 		path->recalculateParts();
 	}
-	object->output_dirty = true;
 	
 	if (map &&
 	    ( object->coords.empty()
@@ -460,6 +533,16 @@ Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& sy
 	return object;
 }
 
+void Object::finishLoading(const DeferredCoords& deferred)
+{
+	deferred.decode(coords.mutableVector());
+	if (type == Path)
+	{
+		auto* path = static_cast<PathObject*>(this);
+		path->recalculateParts();
+	}
+}
+
 
 void Object::setRotation(qreal new_rotation)
 {
@@ -482,15 +565,119 @@ bool Object::update() const
 	if (!output_dirty)
 		return false;
 	
+	MAPPER_TRACE_SCOPE("Object::update");
+	Util::PerformanceCounters::add(Util::PerformanceCounters::instance().object_updates, 1);
+	PointSymbol::SharedElements shared_elements;
+	generateRenderables(beginUpdate());
+	finishUpdate();
+	return true;
+}
+
+// static
+void Object::updateAll(const std::vector<const Object*>& objects)
+{
+	MAPPER_TRACE_SCOPE("Object::updateAll");
+	
+	std::vector<const Object*> dirty_objects;
+	dirty_objects.reserve(objects.size());
+	std::copy_if(begin(objects), end(objects), std::back_inserter(dirty_objects), [](const Object* object) {
+		return object->output_dirty;
+	});
+	
+	// Text layout uses font data which must not be shared between threads.
+	auto const text_objects = std::stable_partition(begin(dirty_objects), end(dirty_objects), [](const Object* object) {
+		return object->getType() != Text;
+	});
+	
+	Util::PerformanceCounters::add(Util::PerformanceCounters::instance().object_updates, dirty_objects.size());
+	
+	std::vector<Symbol::RenderableOptions> options;
+	options.reserve(dirty_objects.size());
+	for (const auto* object : dirty_objects)
+		options.push_back(object->beginUpdate());
+	
+	auto const num_concurrent = std::size_t(std::distance(begin(dirty_objects), text_objects));
+	Util::parallelFor(num_concurrent, 64, [&dirty_objects, &options](std::size_t first, std::size_t last) {
+		MAPPER_TRACE_SCOPE("Object::generateRenderables");
+		PointSymbol::SharedElements shared_elements;
+		for (auto i = first; i < last; ++i)
+			dirty_objects[i]->generateRenderables(options[i]);
+	});
+	PointSymbol::SharedElements shared_elements;
+	for (auto i = num_concurrent; i < dirty_objects.size(); ++i)
+		dirty_objects[i]->generateRenderables(options[i]);
+	
+	for (const auto* object : dirty_objects)
+		object->finishUpdate();
+}
+
+// static
+void Object::updateAllForRenderableOptions(const std::vector<const Object*>& objects)
+{
+	std::vector<const Object*> dirty_objects;
+	std::vector<std::unique_ptr<ObjectRenderables::Variant>> variants;
+	dirty_objects.reserve(objects.size());
+	variants.reserve(objects.size());
+	for (const auto* object : objects)
+	{
+		if (object->output_dirty || !object->map)
+		{
+			object->output_dirty = true;
+			dirty_objects.push_back(object);
+			variants.emplace_back();
+			continue;
+		}
+		
+		auto const options = object->map->renderableOptions();
+		if (object->output.getOptions() == options)
+			continue;
+		
+		auto const previous_extent = object->extent;
+		if (object->output.switchToVariant(options))
+		{
+			if (previous_extent.isValid())
+				object->map->setObjectAreaDirty(object, previous_extent);
+			object->finishUpdate();
+			continue;
+		}
+		
+		object->output_dirty = true;
+		dirty_objects.push_back(object);
+		variants.push_back(object->output.makeVariant());
+	}
+	
+	updateAll(dirty_objects);
+	
+	for (std::size_t i = 0; i < dirty_objects.size(); ++i)
+	{
+		if (variants[i])
+			dirty_objects[i]->output.setVariant(std::move(variants[i]));
+	}
+}
+
+void Object::releaseRenderablesVariant() const
+{
+	output.dropVariant();
+}
+
+Symbol::RenderableOptions Object::beginUpdate() const
+{
 	Symbol::RenderableOptions options = Symbol::RenderNormal;
 	if (map)
 	{
 		options = QFlag(map->renderableOptions());
 		if (extent.isValid())
-			map->setObjectAreaDirty(extent);
+			map->setObjectAreaDirty(this, extent);
 	}
-	
-	output.deleteRenderables();
+	return options;
+}
+
+void Object::generateRenderables(Symbol::RenderableOptions options) const
+{
+	// Detach from the old renderables which may still be in use by
+	// snapshots of the map renderables.
+	output.takeRenderables();
+	output.setOptions(int(options));
 	
 	extent = QRectF();
 	
@@ -500,15 +687,18 @@ bool Object::update() const
 	
 	Q_ASSERT(extent.right() < 60000000);	// assert if bogus values are returned
 	output_dirty = false;
-	
+}
+
+void Object::finishUpdate() const
+{
 	if (map)
 	{
 		map->insertRenderablesOfObject(this);
+		map->updateSpatialIndex(this);
 		if (extent.isValid())
-			map->setObjectAreaDirty(extent);
+			map->setObjectAreaDirty(this, extent);
+		emit map->objectUpdated(this);
 	}
-	
-	return true;
 }
 
 void Object::updateEvent() const
@@ -521,6 +711,11 @@ void Object::createRenderables(ObjectRenderables& output, Symbol::RenderableOpti
 	symbol->createRenderables(this, VirtualCoordVector(coords), output, options);
 }
 
+void Object::coordinateStorageChanged()
+{
+	// nothing here
+}
+
 void Object::move(qint32 dx, qint32 dy)
 {
 	for (MapCoord& coord : coords)
@@ -671,8 +866,11 @@ bool Object::setSymbol(const Symbol* new_symbol, bool no_checks)
 			return false;
 	}
 	
+	auto const old_symbol = symbol;
 	symbol = new_symbol;
 	setOutputDirty();
+	if (map && symbol != old_symbol)
+		map->updateSymbolIndex(this, old_symbol);
 	return true;
 }
 
@@ -690,13 +888,26 @@ Object* Object::getObjectForType(Object::Type type, const Symbol* symbol)
 	return nullptr;
 }
 
+void Object::assignTags(KeyValueContainer tags)
+{
+	if (tags.empty())
+		object_tags.reset();
+	else if (object_tags)
+		*object_tags = std::move(tags);
+	else
+		object_tags = std::make_unique<KeyValueContainer>(std::move(tags));
+}
+
 void Object::setTags(const KeyValueContainer& tags)
 {
-	if (object_tags != tags)
+	if (this->tags() != tags)
 	{
-		object_tags = tags;
+		assignTags(tags);
 		if (map)
 		{
+			if (object_tags)
+				object_tags->internStrings(map->tagStrings());
+			map->updateTagIndex(this);
 			map->setObjectsDirty();
 			if (map->isObjectSelected(this))
 				map->emitSelectionEdited();
@@ -706,18 +917,23 @@ void Object::setTags(const KeyValueContainer& tags)
 
 QString OpenOrienteering::Object::getTag(const QString& key) const
 {
-	auto const it = object_tags.find(key);
-	return it == object_tags.end() ? QString{} : it->value;
+	auto const& tags = this->tags();
+	auto const it = tags.find(key);
+	return it == tags.end() ? QString{} : it->value;
 }
 
 void Object::setTag(const QString& key, const QString& value)
 {
-	auto it = object_tags.find(key);
-	if (it == object_tags.end() || it->value != value)
+	if (!object_tags)
+		object_tags = std::make_unique<KeyValueContainer>();
+	auto it = object_tags->find(key);
+	if (it == object_tags->end() || it->value != value)
 	{
-		object_tags.insert_or_assign(it, key, value);
+		object_tags->insert_or_assign(it, key, value);
 		if (map)
 		{
+			object_tags->internStrings(map->tagStrings());
+			map->updateTagIndex(this);
 			map->setObjectsDirty();
 			if (map->isObjectSelected(this))
 				map->emitSelectionEdited();
@@ -727,12 +943,20 @@ void Object::setTag(const QString& key, const QString& value)
 
 void Object::removeTag(const QString& key)
 {
-	auto it = object_tags.find(key);
-	if (it != object_tags.end())
+	if (!object_tags)
+		return;
+	
+	auto it = object_tags->find(key);
+	if (it != object_tags->end())
 	{
-		object_tags.erase(it);
+		object_tags->erase(it);
+		if (object_tags->empty())
+			object_tags.reset();
 		if (map)
+		{
+			map->updateTagIndex(this);
 			map->setObjectsDirty();
+		}
 	}
 }
 
@@ -812,7 +1036,7 @@ void PathPart::connectEnds()
 
 void PathPart::reverse()
 {
-	MapCoordVector& coords = path->coords;
+	MapCoordVector& coords = path->coords.mutableVector();
 	
 	bool set_last_hole_point = false;
 	auto half = (first_index + last_index + 1) / 2;
@@ -939,7 +1163,7 @@ PathObject::PathObject(const PathPart &proto_part)
 : Object(*proto_part.path)
 , pattern_origin(proto_part.path->pattern_origin)
 {
-	auto begin = proto_part.path->coords.begin();
+	auto begin = proto_part.path->getRawCoordinateVector().begin();
 	coords.reserve(proto_part.size());
 	coords.assign(begin + proto_part.first_index, begin + (proto_part.last_index+1));
 	path_parts.emplace_back(*this, proto_part);
@@ -1014,6 +1238,14 @@ void PathObject::normalize()
 				deleteCoordinate(i, false);
 		}
 	}
+	setOutputDirty();
+}
+
+void PathObject::shrinkToFit()
+{
+	coords.shrink_to_fit();
+	for (auto& part : path_parts)
+		part.path_coords.shrink_to_fit();
 }
 
 bool PathObject::intersectsBox(const QRectF& box) const
@@ -1091,7 +1323,7 @@ void PathObject::deletePart(PathPartVector::size_type part_index)
 
 void PathObject::partSizeChanged(PathPartVector::iterator part, MapCoordVector::difference_type change)
 {
-	Q_ASSERT(isOutputDirty());
+	setCoordinatesDirty(part->first_index, std::numeric_limits<MapCoordVector::size_type>::max());
 	
 	part->last_index += change;
 	auto last = end(path_parts);
@@ -1164,6 +1396,22 @@ ClosestPathCoord PathObject::findClosestPointTo(
 	                       op);
 }
 
+ClosestPathCoord PathObject::findClosestPointWithin(
+        const MapCoordF& coord,
+        double distance_bound_squared) const
+{
+	update();
+	
+	auto result = ClosestPathCoord { {}, distance_bound_squared };
+	for (const auto& part : path_parts)
+	{
+		auto closest = part.findClosestPointTo(coord, result.distance_squared, part.first_index, part.last_index);
+		if (closest.distance_squared < result.distance_squared)
+			result = closest;
+	}
+	return result;
+}
+
 ClosestBorderPathCoord PathObject::findClosestPointOnBorder(
         const MapCoordF& coord,
         const PathCoord& path_coord,
@@ -1569,7 +1817,6 @@ void PathObject::changePathBounds(
 		coords.insert(part_start + part_size, begin(out_coords) + copy_size, end(out_coords));
 	
 	recalculateParts();
-	setOutputDirty();
 }
 
 void PathObject::calcBezierPointDeletionRetainingShapeFactors(MapCoord p0, MapCoord p1, MapCoord p2, MapCoord q0, MapCoord q1, MapCoord q2, MapCoord q3, double& out_pfactor, double& out_qfactor)
@@ -2073,17 +2320,15 @@ void PathObject::appendPath(const PathObject* other)
 	coords.insert(coords.end(), other->coords.begin(), other->coords.end());
 	
 	recalculateParts();
-	setOutputDirty();
 }
 
 void PathObject::appendPathPart(const PathPart &part)
 {
 	coords.reserve(coords.size() + part.size());
 	for (std::size_t i = 0; i < part.size(); ++i)
-		coords.emplace_back(part.path->coords[part.first_index + i]);
+		coords.emplace_back(part.path->getRawCoordinateVector()[part.first_index + i]);
 	
 	recalculateParts();
-	setOutputDirty();
 }
 
 void PathObject::reverse()
@@ -2500,6 +2745,150 @@ bool PathObject::simplify(PathObject** undo_duplicate, double threshold)
 	return removed_a_point;
 }
 
+
+namespace {
+
+/**
+ * Returns the squared distance of point from the segment from start to end.
+ */
+double squaredDistanceToSegment(const MapCoordF& point, const MapCoordF& start, const MapCoordF& end)
+{
+	auto const segment = end - start;
+	auto const length_squared = segment.lengthSquared();
+	if (length_squared == 0)
+		return (point - start).lengthSquared();
+	
+	auto const t = qBound(0.0, MapCoordF::dotProduct(point - start, segment) / length_squared, 1.0);
+	return (point - (start + t * segment)).lengthSquared();
+}
+
+/**
+ * Clears the keep flag of the inner coordinates of a straight run which can be
+ * removed by the Douglas-Peucker algorithm.
+ * 
+ * The ranges are processed from a stack, so that very long runs from imported
+ * data do not exhaust the call stack.
+ */
+void markDouglasPeucker(const MapCoordVector& coords, std::size_t first, std::size_t last,
+                        double threshold_squared, std::vector<bool>& keep)
+{
+	std::vector<std::pair<std::size_t, std::size_t>> ranges;
+	ranges.emplace_back(first, last);
+	while (!ranges.empty())
+	{
+		auto const range = ranges.back();
+		ranges.pop_back();
+		if (range.second - range.first < 2)
+			continue;
+		
+		auto const start = MapCoordF(coords[range.first]);
+		auto const end = MapCoordF(coords[range.second]);
+		auto max_distance = 0.0;
+		auto max_index = range.first;
+		for (auto i = range.first + 1; i < range.second; ++i)
+		{
+			auto const distance = squaredDistanceToSegment(MapCoordF(coords[i]), start, end);
+			if (distance > max_distance)
+			{
+				max_distance = distance;
+				max_index = i;
+			}
+		}
+		
+		if (max_distance > threshold_squared)
+		{
+			ranges.emplace_back(range.first, max_index);
+			ranges.emplace_back(max_index, range.second);
+		}
+		else
+		{
+			std::fill(keep.begin() + std::ptrdiff_t(range.first + 1), keep.begin() + std::ptrdiff_t(range.second), false);
+		}
+	}
+}
+
+/**
+ * Returns the number of self-intersections of a path with the given coordinates.
+ */
+std::size_t countSelfIntersections(const MapCoordVector& coords)
+{
+	// The empty LineSymbol will not generate any renderables.
+	LineSymbol empty_symbol;
+	PathObject path { &empty_symbol, coords };
+	PathObject::Intersections intersections;
+	path.calcSelfIntersections(intersections);
+	return intersections.size();
+}
+
+}  // namespace
+
+
+bool PathObject::simplifyPolygonal(double threshold)
+{
+	auto const& original = getRawCoordinateVector();
+	auto original_intersections = std::numeric_limits<std::size_t>::max();
+	
+	// Retry with a smaller threshold when simplification adds self-intersections.
+	for (int attempt = 0; attempt < 3; ++attempt, threshold /= 2)
+	{
+		auto const threshold_squared = threshold * threshold;
+		std::vector<bool> keep(original.size(), true);
+		for (const auto& part : path_parts)
+		{
+			// Runs of straight segments end at curves, dash points and gap points.
+			auto run_start = part.first_index;
+			auto index = part.first_index;
+			while (index < part.last_index)
+			{
+				if (original[index].isCurveStart())
+				{
+					markDouglasPeucker(original, run_start, index, threshold_squared, keep);
+					index += 3;
+					run_start = index;
+					continue;
+				}
+				
+				++index;
+				if (original[index].isDashPoint() || original[index].isGapPoint())
+				{
+					markDouglasPeucker(original, run_start, index, threshold_squared, keep);
+					run_start = index;
+				}
+			}
+			markDouglasPeucker(original, run_start, part.last_index, threshold_squared, keep);
+			
+			// Don't let the part collapse.
+			auto const part_begin = keep.begin() + std::ptrdiff_t(part.first_index);
+			auto const part_end = keep.begin() + std::ptrdiff_t(part.last_index + 1);
+			if (std::count(part_begin, part_end, true) < (part.isClosed() ? 4 : 2))
+				std::fill(part_begin, part_end, true);
+		}
+		
+		auto const num_removed = std::size_t(std::count(keep.begin(), keep.end(), false));
+		if (num_removed == 0)
+			return false;
+		
+		MapCoordVector simplified;
+		simplified.reserve(original.size() - num_removed);
+		for (std::size_t i = 0; i < original.size(); ++i)
+		{
+			if (keep[i])
+				simplified.push_back(original[i]);
+		}
+		
+		if (original_intersections == std::numeric_limits<std::size_t>::max())
+			original_intersections = countSelfIntersections(original);
+		if (countSelfIntersections(simplified) > original_intersections)
+			continue;
+		
+		coords = std::move(simplified);
+		recalculateParts();
+		return true;
+	}
+	return false;
+}
+
+
 int PathObject::isPointOnPath(
         const MapCoordF& coord,
         qreal tolerance,
@@ -2520,12 +2909,10 @@ int PathObject::isPointOnPath(
 		for (const auto& part : path_parts)
 		{
 			const auto& path_coords = part.path_coords;
-			auto size = path_coords.size();
-			for (PathCoordVector::size_type i = 0; i < size - 1; ++i)
-			{
+			auto const is_on_edge = [&](PathCoordVector::size_type i) {
 				Q_ASSERT(path_coords[i].index < coords.size());
 				if (coords[path_coords[i].index].isHolePoint())
-					continue;
+					return false;
 				
 				MapCoordF to_coord = coord - path_coords[i].pos;
 				MapCoordF to_next = path_coords[i+1].pos - path_coords[i].pos;
@@ -2534,25 +2921,45 @@ int PathObject::isPointOnPath(
 				
 				auto dist_along_line = MapCoordF::dotProduct(to_coord, tangent);
 				if (dist_along_line < -tolerance)
-					continue;
+					return false;
 				
 				if (dist_along_line < 0 && to_coord.lengthSquared() <= tolerance*tolerance)
-					return Symbol::Line;
+					return true;
 				
 				auto line_length = qreal(path_coords[i+1].clen) - qreal(path_coords[i].clen);
 				if (line_length < 1e-7)
-					continue;
+					return false;
 				
 				if (dist_along_line > line_length + tolerance)
-					continue;
+					return false;
 				
 				if (dist_along_line > line_length && coord.distanceSquaredTo(path_coords[i+1].pos) <= tolerance*tolerance)
-					return Symbol::Line;
+					return true;
 				
 				auto right = tangent.perpRight();
 				
 				auto dist_from_line = qAbs(MapCoordF::dotProduct(right, to_coord));
-				if (dist_from_line <= side_tolerance)
+				return dist_from_line <= side_tolerance;
+			};
+			
+			if (path_coords.hasManyEdges())
+			{
+				// Only the edges near coord can match.
+				auto const radius = std::max(tolerance, side_tolerance);
+				auto const rect = QRectF(coord.x() - radius, coord.y() - radius, 2 * radius, 2 * radius);
+				auto found = false;
+				path_coords.edgeIndex().query(rect, [&](PathCoordVector::size_type i) {
+					found = found || is_on_edge(i);
+				});
+				if (found)
+					return Symbol::Line;
+				continue;
+			}
+			
+			auto size = path_coords.size();
+			for (PathCoordVector::size_type i = 0; i < size - 1; ++i)
+			{
+				if (is_on_edge(i))
 					return Symbol::Line;
 			}
 		}
@@ -2643,6 +3050,146 @@ double PathObject::calcMaximumDistanceTo(
 	return sqrt(max_distance_sq);
 }
 
+namespace {
+
+/**
+ * The number of segments per leaf of a SegmentBoxTree.
+ */
+constexpr std::size_t segment_leaf_size = 8;
+
+/**
+ * An axis-aligned box with inclusive bounds.
+ */
+struct SegmentBox
+{
+	double left;
+	double top;
+	double right;
+	double bottom;
+	
+	/**
+	 * Returns the box of a straight segment.
+	 * 
+	 * The box is enlarged by a margin which covers the tolerances
+	 * of the intersection tests.
+	 */
+	static SegmentBox of(const MapCoordF& start, const MapCoordF& end)
+	{
+		auto const margin = 1e-4 + 1e-9 * (qAbs(end.x() - start.x()) + qAbs(end.y() - start.y()));
+		return { std::min(start.x(), end.x()) - margin, std::min(start.y(), end.y()) - margin,
+		         std::max(start.x(), end.x()) + margin, std::max(start.y(), end.y()) + margin };
+	}
+	
+	bool intersects(const SegmentBox& other) const
+	{
+		return left <= other.right && other.left <= right
+		       && top <= other.bottom && other.top <= bottom;
+	}
+	
+	void unite(const SegmentBox& other)
+	{
+		left = std::min(left, other.left);
+		top = std::min(top, other.top);
+		right = std::max(right, other.right);
+		bottom = std::max(bottom, other.bottom);
+	}
+};
+
+
+/**
+ * A bounding box hierarchy over the straight segments of a path part.
+ * 
+ * Segment k leads from path coord k-1 to path coord k. The nodes cover
+ * ranges of consecutive segments, which are spatially coherent for typical
+ * paths. So a query visits only a few nodes away from the result.
+ */
+class SegmentBoxTree
+{
+public:
+	using size_type = PathCoordVector::size_type;
+	
+	explicit SegmentBoxTree(const PathCoordVector& path_coords)
+	{
+		auto const num_segments = path_coords.empty() ? 0 : path_coords.size() - 1;
+		if (num_segments == 0)
+			return;
+		
+		segments.reserve(num_segments);
+		for (auto k = size_type(1); k <= num_segments; ++k)
+			segments.push_back(SegmentBox::of(path_coords[k-1].pos, path_coords[k].pos));
+		
+		std::vector<SegmentBox> leaves;
+		leaves.reserve((num_segments + segment_leaf_size - 1) / segment_leaf_size);
+		for (std::size_t i = 0; i < num_segments; i += segment_leaf_size)
+		{
+			auto box = segments[i];
+			auto const last = std::min(i + segment_leaf_size, num_segments);
+			for (auto j = i + 1; j < last; ++j)
+				box.unite(segments[j]);
+			leaves.push_back(box);
+		}
+		levels.push_back(std::move(leaves));
+		
+		while (levels.back().size() > 1)
+		{
+			std::vector<SegmentBox> parents;
+			{
+				const auto& children = levels.back();
+				parents.reserve((children.size() + 1) / 2);
+				for (std::size_t i = 0; i < children.size(); i += 2)
+				{
+					auto box = children[i];
+					if (i + 1 < children.size())
+						box.unite(children[i + 1]);
+					parents.push_back(box);
+				}
+			}
+			levels.push_back(std::move(parents));
+		}
+	}
+	
+	/**
+	 * Appends the segments whose boxes intersect the given box to result,
+	 * in increasing order.
+	 */
+	void query(const SegmentBox& box, std::vector<size_type>& result) const
+	{
+		if (!levels.empty())
+			query(levels.size() - 1, 0, box, result);
+	}
+	
+private:
+	void query(std::size_t level, std::size_t index, const SegmentBox& box, std::vector<size_type>& result) const
+	{
+		if (!levels[level][index].intersects(box))
+			return;
+		
+		if (level == 0)
+		{
+			auto const first = index * segment_leaf_size;
+			auto const last = std::min(first + segment_leaf_size, segments.size());
+			for (auto i = first; i < last; ++i)
+			{
+				if (segments[i].intersects(box))
+					result.push_back(i + 1);
+			}
+			return;
+		}
+		
+		auto const child = 2 * index;
+		query(level - 1, child, box, result);
+		if (child + 1 < levels[level - 1].size())
+			query(level - 1, child + 1, box, result);
+	}
+	
+	std::vector<SegmentBox> segments;
+	std::vector<std::vector<SegmentBox>> levels;
+};
+
+
+}  // namespace
+
+
 PathObject::Intersection PathObject::Intersection::makeIntersectionAt(double a, double b, const PathCoord& a0, const PathCoord& a1, const PathCoord& b0, const PathCoord& b1, PathPartVector::size_type part_index, PathPartVector::size_type other_part_index)
 {
 	PathObject::Intersection new_intersection;
@@ -2669,6 +3216,13 @@ void PathObject::calcAllIntersectionsWith(const PathObject* other, PathObject::I
 	const double zero_minus_epsilon = 0 - epsilon;
 	const double one_plus_epsilon = 1 + epsilon;
 	
+	std::vector<SegmentBoxTree> other_trees;
+	other_trees.reserve(other->path_parts.size());
+	for (const auto& other_part : other->path_parts)
+		other_trees.emplace_back(other_part.path_coords);
+	
+	std::vector<SegmentBoxTree::size_type> candidates;
+	
 	for (size_t part_index = 0; part_index < path_parts.size(); ++part_index)
 	{
 		const PathPart& part = path_parts[part_index];
@@ -2713,16 +3267,39 @@ void PathObject::calcAllIntersectionsWith(const PathObject* other, PathObject::I
 			// when the next segment suddenly is not colliding anymore.
 			Intersection last_intersection;
 			
+			// Naming: segment in this path is a, segment in other path is b
+			const PathCoord& a0 = part.path_coords[i-1];
+			const PathCoord& a1 = part.path_coords[i];
+			auto const a_box = SegmentBox::of(a0.pos, a1.pos);
+			
 			for (size_t other_part_index = 0; other_part_index < other->path_parts.size(); ++other_part_index)
 			{
-				const PathPart& other_part = other->path_parts[part_index]; /// \todo FIXME: part_index or other_part_index ???
+				const PathPart& other_part = other->path_parts[other_part_index];
+				if (other_part.path_coords.size() < 2)
+					continue;
+				
 				auto other_path_coord_end_index = other_part.path_coords.size() - 1;
-				for (auto k = PathCoordVector::size_type { 1 }; k <= other_path_coord_end_index; ++k)
+				candidates.clear();
+				other_trees[other_part_index].query(a_box, candidates);
+				
+				// Segments which are not candidates are too far away from
+				// segment a. Such a segment only ends a collision, but at
+				// the start of the other part, it ends without intersection.
+				auto previous = PathCoordVector::size_type { 0 };
+				for (auto k : candidates)
 				{
+					if (k > 1 && previous == 0)
+					{
+						colliding = false;
+					}
+					else if (k > previous + 1)
+					{
+						if (colliding) out.push_back(last_intersection);
+						colliding = false;
+					}
+					previous = k;
+					
 					// Test the two line segments against each other.
-					// Naming: segment in this path is a, segment in other path is b
-					const PathCoord& a0 = part.path_coords[i-1];
-					const PathCoord& a1 = part.path_coords[i];
 					const PathCoord& b0 = other_part.path_coords[k-1];
 					const PathCoord& b1 = other_part.path_coords[k];
 					MapCoordF b_direction = b1.pos - b0.pos;
@@ -2922,6 +3499,109 @@ void PathObject::calcAllIntersectionsWith(const PathObject* other, PathObject::I
 						colliding = (b == 1);
 					}
 				}
+				
+				if (previous == 0)
+				{
+					colliding = false;
+				}
+				else if (previous < other_path_coord_end_index)
+				{
+					if (colliding) out.push_back(last_intersection);
+					colliding = false;
+				}
+			}
+		}
+	}
+}
+
+void PathObject::calcSelfIntersections(PathObject::Intersections& out) const
+{
+	update();
+	
+	const double epsilon = 1e-10;
+	const double zero_minus_epsilon = 0 - epsilon;
+	const double one_plus_epsilon = 1 + epsilon;
+	
+	std::vector<SegmentBoxTree> trees;
+	trees.reserve(path_parts.size());
+	for (const auto& part : path_parts)
+		trees.emplace_back(part.path_coords);
+	
+	std::vector<SegmentBoxTree::size_type> candidates;
+	
+	for (size_t part_index = 0; part_index < path_parts.size(); ++part_index)
+	{
+		const PathPart& part = path_parts[part_index];
+		if (part.path_coords.size() < 2)
+			continue;
+		
+		auto path_coord_end_index = part.path_coords.size() - 1;
+		for (auto i = PathCoordVector::size_type { 1 }; i <= path_coord_end_index; ++i)
+		{
+			// Naming: the earlier segment is a, the later segment is b
+			const PathCoord& a0 = part.path_coords[i-1];
+			const PathCoord& a1 = part.path_coords[i];
+			if (a0.clen == a1.clen)
+				continue;
+			
+			auto const a_box = SegmentBox::of(a0.pos, a1.pos);
+			for (auto other_part_index = part_index; other_part_index < path_parts.size(); ++other_part_index)
+			{
+				const PathPart& other_part = path_parts[other_part_index];
+				candidates.clear();
+				trees[other_part_index].query(a_box, candidates);
+				for (auto k : candidates)
+				{
+					const PathCoord& b0 = other_part.path_coords[k-1];
+					const PathCoord& b1 = other_part.path_coords[k];
+					if (b0.clen == b1.clen)
+						continue;
+					
+					if (other_part_index == part_index)
+					{
+						// Skip segments which are connected by zero-length segments only.
+						if (k <= i || a1.clen == b0.clen)
+							continue;
+						if (part.isClosed() && a0.clen == 0 && b1.clen == part.length())
+							continue;
+					}
+					
+					auto const a_direction = a1.pos - a0.pos;
+					auto const b_direction = b1.pos - b0.pos;
+					auto const b0_offset = b0.pos - a0.pos;
+					auto const denominator = a_direction.x() * b_direction.y() - a_direction.y() * b_direction.x();
+					if (qIsNull(denominator))
+					{
+						// Parallel lines, enter the ends of the overlap of collinear segments.
+						bool ok_start, ok_end;
+						auto const b_start = parameterOfPointOnLine(a0.pos.x(), a0.pos.y(), a_direction.x(), a_direction.y(), b0.pos.x(), b0.pos.y(), ok_start);
+						auto const b_end = parameterOfPointOnLine(a0.pos.x(), a0.pos.y(), a_direction.x(), a_direction.y(), b1.pos.x(), b1.pos.y(), ok_end);
+						if (!ok_start || !ok_end || b_start == b_end)
+							continue;
+						
+						auto const first = std::max(0.0, std::min(b_start, b_end));
+						auto const last = std::min(1.0, std::max(b_start, b_end));
+						if (first > last)
+							continue;
+						
+						out.push_back(Intersection::makeIntersectionAt(first, (first - b_start) / (b_end - b_start), a0, a1, b0, b1, part_index, other_part_index));
+						if (last > first)
+							out.push_back(Intersection::makeIntersectionAt(last, (last - b_start) / (b_end - b_start), a0, a1, b0, b1, part_index, other_part_index));
+					}
+					else
+					{
+						// Non-parallel lines, calculate intersection parameters and check if in range
+						auto const a = (b0_offset.x() * b_direction.y() - b0_offset.y() * b_direction.x()) / denominator;
+						if (a < zero_minus_epsilon || a > one_plus_epsilon)
+							continue;
+						
+						auto const b = (b0_offset.x() * a_direction.y() - b0_offset.y() * a_direction.x()) / denominator;
+						if (b < zero_minus_epsilon || b > one_plus_epsilon)
+							continue;
+						
+						out.push_back(Intersection::makeIntersectionAt(qBound(0.0, a, 1.0), qBound(0.0, b, 1.0), a0, a1, b0, b1, part_index, other_part_index));
+					}
+				}
 			}
 		}
 	}
@@ -2935,10 +3615,12 @@ void PathObject::setCoordinate(MapCoordVector::size_type pos, const MapCoord& c)
 	if (part.isClosed() && pos == part.last_index)
 		pos = part.first_index;
 	coords[pos] = c;
+	setCoordinatesDirty(pos, pos + 1);
 	if (part.isClosed() && pos == part.first_index)
+	{
 		setClosingPoint(part.last_index, c);
-	
-	setOutputDirty();
+		setCoordinatesDirty(part.last_index, part.last_index + 1);
+	}
 }
 
 void PathObject::addCoordinate(MapCoordVector::size_type pos, const MapCoord& c)
@@ -2951,6 +3633,7 @@ void PathObject::addCoordinate(MapCoordVector::size_type pos, const MapCoord& c)
 		
 		path_parts.clear();
 		path_parts.emplace_back(*this, 0, 0);
+		setOutputDirty();
 	}
 	else
 	{
@@ -2970,7 +3653,6 @@ void PathObject::addCoordinate(MapCoordVector::size_type pos, const MapCoord& c)
 			coords[pos-1].setHolePoint(false);
 		}
 	}
-	setOutputDirty();
 }
 
 void PathObject::addCoordinate(const MapCoord& c, bool start_new_part)
@@ -3192,15 +3874,49 @@ void PathObject::assignCoordinates(const PathObject& proto, MapCoordVector::size
 	setOutputDirty();
 }
 
+void PathObject::replaceCoordinates(MapCoordVector::size_type first, MapCoordVector::size_type count, const MapCoordVector& replacement)
+{
+	Q_ASSERT(first <= coords.size());
+	Q_ASSERT(count <= coords.size() - first);
+	
+	auto const range_begin = coords.begin() + MapCoordVector::difference_type(first);
+	auto const range_end = range_begin + MapCoordVector::difference_type(count);
+	if (count == replacement.size()
+	    && std::equal(range_begin, range_end, begin(replacement), [](const MapCoord& a, const MapCoord& b) {
+	           return a.flags() == b.flags();
+	       }))
+	{
+		// Same structure, only positions change.
+		std::copy(begin(replacement), end(replacement), range_begin);
+		setCoordinatesDirty(first, first + count);
+		return;
+	}
+	
+	auto const pos = coords.erase(range_begin, range_end);
+	coords.insert(pos, begin(replacement), end(replacement));
+	recalculateParts();
+}
+
 void PathObject::updatePathCoords() const
 {
 	auto part_start = VirtualPath::size_type { 0 };
 	for (auto& part : path_parts)
 	{
+		// Parts which were updated for the same indices and which do not
+		// overlap the dirty range are kept. The part with the first dirty
+		// coordinate is updated from this coordinate.
+		const auto& path_coords = part.path_coords;
+		auto const unchanged = !path_coords.empty()
+		                       && path_coords.front().index == part_start
+		                       && path_coords.back().index == part.last_index
+		                       && (part.last_index < dirty_coords_begin || part_start >= dirty_coords_end);
 		part.first_index = part_start;
-		part.last_index  = part.path_coords.update(part_start);
+		if (!unchanged)
+			part.last_index = part.path_coords.update(part_start, dirty_coords_begin);
 		part_start = part.last_index+1;
 	}
+	dirty_coords_begin = std::numeric_limits<quint32>::max();
+	dirty_coords_end = 0;
 }
 
 void PathObject::recalculateParts()
@@ -3250,6 +3966,13 @@ void PathObject::createRenderables(ObjectRenderables& output, Symbol::Renderable
 	symbol->createRenderables(this, path_parts, output, options);
 }
 
+void PathObject::coordinateStorageChanged()
+{
+	// This may be called from PathPart members, so the parts are updated in place.
+	for (auto& part : path_parts)
+		part.setCoords(coords.vector());
+}
+
 
 double PathObject::getPaperLength() const
 {
@@ -3282,6 +4005,21 @@ double PathObject::calculateRealArea() const
 	return calculatePaperArea() * paper_to_real * paper_to_real;
 }
 
+// static
+std::vector<PathObject::Metrics> PathObject::calculateMetrics(const std::vector<const PathObject*>& objects)
+{
+	std::vector<Metrics> metrics(objects.size());
+	Util::parallelFor(objects.size(), 64, [&objects, &metrics](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			auto const* object = objects[i];
+			object->updatePathCoords();
+			metrics[i] = { object->getPaperLength(), object->calculatePaperArea() };
+		}
+	});
+	return metrics;
+}
+
 bool PathObject::isAreaTooSmall() const
 {
 	int minimum_area = symbol ? symbol->getMinimumArea() : 0;
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2020, 2025 Kai Pastor
+ *    Copyright 2013-2020, 2025, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,7 +22,9 @@
 #ifndef OPENORIENTEERING_OBJECT_H
 #define OPENORIENTEERING_OBJECT_H
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -46,10 +48,168 @@ class QXmlStreamWriter;
 namespace OpenOrienteering {
 
 class Map;
+class Object;
 class PointObject;
 class PathObject;
 class TextObject;
 class VirtualCoordVector;
+struct DeferredCoords;
+
+
+/**
+ * An implicitly shared vector of map coordinates, owned by an object.
+ * 
+ * Copies of objects share the coordinates until one of them is modified.
+ * Thus duplicating an object, e.g. for undo steps, copy and paste, or by
+ * tools which keep the original object, does not copy the coordinates.
+ * 
+ * All non-const member functions detach the storage from other objects
+ * before returning. Detaching or replacing the storage moves the coordinates
+ * to a different std::vector. The owner is notified via
+ * Object::coordinateStorageChanged(), so that it can update references to the
+ * raw coordinate vector.
+ * 
+ * The interface resembles the parts of std::vector used by the objects.
+ */
+class SharedMapCoordVector
+{
+public:
+	using value_type      = MapCoordVector::value_type;
+	using size_type       = MapCoordVector::size_type;
+	using difference_type = MapCoordVector::difference_type;
+	using reference       = MapCoordVector::reference;
+	using const_reference = MapCoordVector::const_reference;
+	using iterator        = MapCoordVector::iterator;
+	using const_iterator  = MapCoordVector::const_iterator;
+	
+	explicit SharedMapCoordVector(Object* owner)
+	: SharedMapCoordVector(MapCoordVector(), owner)
+	{}
+	
+	SharedMapCoordVector(MapCoordVector coords, Object* owner)
+	: d(std::make_shared<MapCoordVector>(std::move(coords)))
+	, owner(owner)
+	{}
+	
+	/** Constructs a vector which shares the coordinates of other. */
+	SharedMapCoordVector(const SharedMapCoordVector& other, Object* owner) noexcept
+	: d(other.d)
+	, owner(owner)
+	{}
+	
+	SharedMapCoordVector(const SharedMapCoordVector&) = delete;
+	SharedMapCoordVector(SharedMapCoordVector&&) = delete;
+	
+	~SharedMapCoordVector() = default;
+	
+	/** Shares the coordinates of other. The owner is not changed. */
+	SharedMapCoordVector& operator=(const SharedMapCoordVector& other);
+	
+	SharedMapCoordVector& operator=(MapCoordVector coords);
+	
+	
+	/** Returns the raw coordinate vector. */
+	const MapCoordVector& vector() const noexcept { return *d; }
+	
+	operator const MapCoordVector&() const noexcept { return *d; }
+	
+	/** Detaches and returns the raw coordinate vector, for modification. */
+	MapCoordVector& mutableVector() { detach(); return *d; }
+	
+	/** Returns true if the coordinates are shared with another object. */
+	bool isShared() const noexcept { return d.use_count() > 1; }
+	
+	
+	bool empty() const noexcept { return d->empty(); }
+	
+	size_type size() const noexcept { return d->size(); }
+	
+	const_reference operator[](size_type pos) const { return (*d)[pos]; }
+	reference operator[](size_type pos) { detach(); return (*d)[pos]; }
+	
+	const_reference front() const { return d->front(); }
+	reference front() { detach(); return d->front(); }
+	
+	const_reference back() const { return d->back(); }
+	reference back() { detach(); return d->back(); }
+	
+	const_iterator begin() const noexcept { return d->cbegin(); }
+	iterator begin() { detach(); return d->begin(); }
+	
+	const_iterator end() const noexcept { return d->cend(); }
+	iterator end() { detach(); return d->end(); }
+	
+	friend const_iterator begin(const SharedMapCoordVector& c) noexcept { return c.begin(); }
+	friend iterator begin(SharedMapCoordVector& c) { return c.begin(); }
+	
+	friend const_iterator end(const SharedMapCoordVector& c) noexcept { return c.end(); }
+	friend iterator end(SharedMapCoordVector& c) { return c.end(); }
+	
+	
+	void reserve(size_type size) { detach(); d->reserve(size); }
+	
+	/** Releases excess capacity. Shared coordinates are left unchanged. */
+	void shrink_to_fit() { if (!isShared()) d->shrink_to_fit(); }
+	
+	void resize(size_type size) { detach(); d->resize(size); }
+	
+	void clear();
+	
+	template <class InputIt>
+	void assign(InputIt first, InputIt last) { detach(); d->assign(first, last); }
+	
+	void push_back(const MapCoord& coord) { detach(); d->push_back(coord); }
+	
+	template <class... Args>
+	reference emplace_back(Args&&... args)
+	{
+		detach();
+		d->emplace_back(std::forward<Args>(args)...);
+		return d->back();
+	}
+	
+	iterator insert(const_iterator pos, const MapCoord& coord)
+	{
+		auto const offset = pos - d->cbegin();
+		detach();
+		return d->insert(d->cbegin() + offset, coord);
+	}
+	
+	template <class InputIt>
+	iterator insert(const_iterator pos, InputIt first, InputIt last)
+	{
+		auto const offset = pos - d->cbegin();
+		detach();
+		return d->insert(d->cbegin() + offset, first, last);
+	}
+	
+	iterator erase(const_iterator pos)
+	{
+		auto const offset = pos - d->cbegin();
+		detach();
+		return d->erase(d->cbegin() + offset);
+	}
+	
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		auto const offset = first - d->cbegin();
+		auto const count = last - first;
+		detach();
+		return d->erase(d->cbegin() + offset, d->cbegin() + offset + count);
+	}
+	
+private:
+	void detach() { if (isShared()) detachShared(); }
+	
+	void detachShared();
+	
+	void replace(std::shared_ptr<MapCoordVector> coords);
+	
+	std::shared_ptr<MapCoordVector> d;
+	Object* const owner;
+	
+};
+
 
 
 /**
@@ -66,6 +226,7 @@ class VirtualCoordVector;
 class Object  // clazy:exclude=copyable-polymorphic
 {
 friend class ObjectRenderables;
+friend class SharedMapCoordVector;
 friend class XMLImportExport;
 public:
 	/** Enumeration of possible object types. */
@@ -148,6 +309,16 @@ public:
 	
 	/** Saves the object in xml format to the given stream. */
 	void save(QXmlStreamWriter& xml) const;
+	
+	/**
+	 * Saves the object in xml format, with the given symbol properties and
+	 * file format version.
+	 * 
+	 * This function accesses neither the map nor the symbol, nor the active
+	 * file format version. It is meant for saving copies of objects on
+	 * another thread while the map is modified.
+	 */
+	void save(QXmlStreamWriter& xml, int symbol_index, bool rotatable, int format_version) const;
 	/**
 	 * Loads the object in xml format from the given stream.
 	 * @param xml The stream to load the object from, must be at the correct tag.
@@ -157,8 +328,22 @@ public:
 	 * @param symbol_dict A dictionary mapping symbol IDs to symbol pointers.
 	 * @param symbol If set, this symbol will be assigned to the object, rather
 	 *               than reading the symbol from the stream.
+	 * @param deferred If set, the decoding of compact coordinates may be
+	 *                 deferred. If the deferred text is not empty after
+	 *                 loading, finishLoading() must be called.
 	 */
-	static Object* load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& symbol_dict, const Symbol* symbol = nullptr);
+	static Object* load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& symbol_dict, const Symbol* symbol = nullptr, DeferredCoords* deferred = nullptr);
+	
+	/**
+	 * Decodes the deferred coordinates of an object which was just loaded.
+	 * 
+	 * Unlike load(), this function does not access the map, so it may be
+	 * called concurrently for different objects. The caller must check the
+	 * coordinates and call Map::markAsIrregular() if needed.
+	 * 
+	 * Throws FileFormatException on errors.
+	 */
+	void finishLoading(const DeferredCoords& deferred);
 	
 	
 	/**
@@ -190,6 +375,32 @@ public:
 	 */
 	void forceUpdate() const;
 	
+	/**
+	 * Calls update() for all given objects.
+	 * 
+	 * The renderables are generated concurrently on worker threads, except for
+	 * text objects. Adding the renderables to the map happens on the calling
+	 * thread. Symbols and colors must not be modified during this call.
+	 * Objects which are updated together share the renderables of point
+	 * symbol elements, cf. PointSymbol::SharedElements.
+	 */
+	static void updateAll(const std::vector<const Object*>& objects);
+	
+	/**
+	 * Updates the given objects after a change of the map's renderable options.
+	 * 
+	 * Objects which are not dirty keep their current renderables as a variant
+	 * for the previous options. When the options are switched back, this
+	 * variant is restored instead of generating the renderables again.
+	 * Dirty objects are updated normally.
+	 */
+	static void updateAllForRenderableOptions(const std::vector<const Object*>& objects);
+	
+	/**
+	 * Releases the renderables which are kept for other renderable options.
+	 */
+	void releaseRenderablesVariant() const;
+	
 	
 	/** Moves the whole object
 	 * @param dx X offset in native map coordinates.
@@ -263,7 +474,11 @@ public:
 	 */
 	const MapCoordVector& getRawCoordinateVector() const;
 	
-	/** Sets the object output's dirty state. */
+	/**
+	 * Sets the object output's dirty state.
+	 * 
+	 * Setting the output dirty marks all coordinates as changed.
+	 */
 	void setOutputDirty(bool dirty = true);
 	/** Returns true if the object's output must be regenerated. */
 	bool isOutputDirty() const;
@@ -322,15 +537,64 @@ protected:
 	
 	virtual void createRenderables(ObjectRenderables& output, Symbol::RenderableOptions options) const;
 	
-	Type type;
+	/**
+	 * Called when the coordinates were moved to a different raw vector,
+	 * either by detaching them from shared storage or by assignment.
+	 * 
+	 * The coordinates themselves are the same as before when detaching.
+	 * Subclasses which keep references to getRawCoordinateVector()
+	 * must update these references.
+	 */
+	virtual void coordinateStorageChanged();
+	
+	/**
+	 * Marks the coordinates in the range [first, last) as changed,
+	 * and sets the output dirty.
+	 * 
+	 * Derived data may be updated for the changed coordinates only.
+	 */
+	void setCoordinatesDirty(MapCoordVector::size_type first, MapCoordVector::size_type last);
+	
 	const Symbol* symbol = nullptr;
-	MapCoordVector coords;
+	SharedMapCoordVector coords { this };
 	Map* map = nullptr;
-	KeyValueContainer object_tags;
+	
+	/**
+	 * The range of coordinates which changed since derived data was updated
+	 * the last time, as [dirty_coords_begin, dirty_coords_end).
+	 */
+	mutable quint32 dirty_coords_begin = 0;
+	mutable quint32 dirty_coords_end = std::numeric_limits<quint32>::max();
 	
 private:
-	qreal rotation = 0;               ///< The object's rotation (in radians).
+	/**
+	 * Sets the tags, allocating the container only for non-empty tags.
+	 */
+	void assignTags(KeyValueContainer tags);
+	
+
+	/**
+	 * Prepares the update of a dirty object, on the thread owning the map.
+	 * 
+	 * Returns the options for generating the renderables.
+	 */
+	Symbol::RenderableOptions beginUpdate() const;
+	
+	/**
+	 * Regenerates the output and extent, without accessing the map.
+	 */
+	void generateRenderables(Symbol::RenderableOptions options) const;
+	
+	/**
+	 * Updates the object's map (if set) after generateRenderables().
+	 */
+	void finishUpdate() const;
+	
+	// The members are ordered to avoid padding.
+	std::unique_ptr<KeyValueContainer> object_tags;  // nullptr when there are no tags
+	Type type;
 	mutable bool output_dirty = true; // does the output have to be re-generated because of changes?
+	qreal rotation = 0;               ///< The object's rotation (in radians).
 	mutable QRectF extent;            // only valid after calling update()
 	mutable ObjectRenderables output; // only valid after calling update()
 };
@@ -534,6 +798,15 @@ public:
 	/** Checks the path for valid flags, and makes corrections as necessary. */
 	void normalize();
 	
+	/**
+	 * Releases the excess capacity of the coordinates and path coords.
+	 * 
+	 * Importers append coordinates one by one, and coordinates take a large
+	 * share of the memory of a map. Shared coordinates are left unchanged.
+	 * This is meant to be called once after loading, not after each edit.
+	 */
+	void shrinkToFit();
+	
 	
 	bool intersectsBox(const QRectF& box) const override;
 	
@@ -604,6 +877,16 @@ public:
 	 */
 	void assignCoordinates(const PathObject& proto, MapCoordVector::size_type first, MapCoordVector::size_type last);
 	
+	/**
+	 * Replaces count coordinates, starting at first, with the given coordinates.
+	 * 
+	 * The coordinates are taken as they are, including their flags. This is
+	 * meant for restoring a previous state of the path, e.g. by undo steps.
+	 * When only the positions change, derived data may be updated for the
+	 * replaced range only.
+	 */
+	void replaceCoordinates(MapCoordVector::size_type first, MapCoordVector::size_type count, const MapCoordVector& replacement);
+	
 	
 	/** Finds the path part containing the given coord index. */
 	PathPartVector::const_iterator findPartForIndex(MapCoordVector::size_type coords_index) const;
@@ -698,6 +981,19 @@ public:
 	        MapCoordVector::size_type end_index = std::numeric_limits<PathPartVector::size_type>::max()
 	) const;
 	
+	/**
+	 * Calculates the closest point on the path to the given coordinate,
+	 * if it is closer than the given bound.
+	 * 
+	 * If there is no such point, the returned distance_squared is not less
+	 * than distance_bound_squared. For paths with many edges, only the edges
+	 * near the coordinate are tested.
+	 */
+	ClosestPathCoord findClosestPointWithin(
+	        const MapCoordF& coord,
+	        double distance_bound_squared
+	) const;
+	
 	/**
 	 * Calculates a border path with the closest point to the given coordinate.
 	 * 
@@ -857,6 +1153,22 @@ public:
 	 */
 	bool simplify(PathObject** undo_duplicate, double threshold);
 	
+	/**
+	 * Removes nodes from the straight sections of this path, using the
+	 * Douglas-Peucker algorithm.
+	 * 
+	 * This is much faster than simplify() for paths with many nodes, such as
+	 * imported data. Curves, dash points and gap points are kept, together
+	 * with the flags of all remaining nodes. Parts are not reduced below a
+	 * line or a triangle, and a result which has more self-intersections
+	 * than the original is discarded in favor of a smaller threshold.
+	 * Returns true if at least one node was removed.
+	 * 
+	 * The object must not be part of a map when this function is called from
+	 * another thread.
+	 */
+	bool simplifyPolygonal(double threshold);
+	
 	/** See Object::isPointOnObject() */
 	int isPointOnPath(
 	        const MapCoordF& coord,
@@ -887,9 +1199,24 @@ public:
 	 * Note: intersections are not sorted and may contain duplicates!
 	 * To clean them up, call clean() on the Intersections object after adding
 	 * all intersections with objects you are interested in.
+	 * 
+	 * The segments of the other path are organized in a bounding box hierarchy,
+	 * so that only nearby segments are tested against each other.
 	 */
 	void calcAllIntersectionsWith(const PathObject* other, Intersections& out) const;
 	
+	/**
+	 * Calculates and adds all self-intersections of this path to out.
+	 * 
+	 * These are the points where segments touch or cross each other, unless
+	 * the segments are adjacent. This includes intersections between different
+	 * parts. For collinear overlapping segments, the ends of the overlap are
+	 * added. The earlier position on the path is given by part_index and
+	 * length, the later one by other_part_index and other_length.
+	 * Note: intersections are not sorted and may contain duplicates!
+	 */
+	void calcSelfIntersections(Intersections& out) const;
+	
 	/** Called by Object::update() */
 	void updatePathCoords() const;
 	
@@ -918,6 +1245,24 @@ public:
 	 */
 	double calculateRealArea() const;
 	
+	/**
+	 * The length and area of a path object.
+	 */
+	struct Metrics
+	{
+		double paper_length = 0.0;  ///< cf. getPaperLength()
+		double paper_area   = 0.0;  ///< cf. calculatePaperArea()
+	};
+	
+	/**
+	 * Calculates the metrics of many path objects concurrently.
+	 * 
+	 * This is meant for reports and quality checks over whole maps. The path
+	 * coords are updated as needed, on worker threads. Each object must be
+	 * given only once, and the objects must not be modified during this call.
+	 */
+	static std::vector<Metrics> calculateMetrics(const std::vector<const PathObject*>& objects);
+	
 	/** Returns true if the object is smaller than the minimum area required by its symbol. */
 	bool isAreaTooSmall() const;
 	
@@ -929,7 +1274,7 @@ protected:
 	/**
 	 * Adjusts the end index of the given part and the start/end indexes of the following parts.
 	 * 
-	 * output_dirty must be set before calling this function.
+	 * Marks the coordinates from the start of the given part as changed.
 	 */
 	void partSizeChanged(PathPartVector::iterator part, MapCoordVector::difference_type change);
 	
@@ -1004,6 +1349,8 @@ protected:
 	
 	void createRenderables(ObjectRenderables& output, Symbol::RenderableOptions options) const override;
 	
+	void coordinateStorageChanged() override;
+	
 private:
 	/**
 	 * Origin shift of the object pattern. Only used if the object
@@ -1160,6 +1507,20 @@ inline
 void Object::setOutputDirty(bool dirty)
 {
 	output_dirty = dirty;
+	if (dirty)
+	{
+		dirty_coords_begin = 0;
+		dirty_coords_end = std::numeric_limits<quint32>::max();
+	}
+}
+
+inline
+void Object::setCoordinatesDirty(MapCoordVector::size_type first, MapCoordVector::size_type last)
+{
+	output_dirty = true;
+	// The number of coordinates is far below the limit of quint32.
+	dirty_coords_begin = std::min(dirty_coords_begin, quint32(first));
+	dirty_coords_end = std::max(dirty_coords_end, quint32(std::min(last, MapCoordVector::size_type(std::numeric_limits<quint32>::max()))));
 }
 
 inline
@@ -1196,7 +1557,8 @@ Map* Object::getMap() const
 inline
 const KeyValueContainer& Object::tags() const
 {
-	return object_tags;
+	static const KeyValueContainer no_tags;
+	return object_tags ? *object_tags : no_tags;
 }
 
 
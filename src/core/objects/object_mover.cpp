@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -183,6 +183,18 @@ void ObjectMover::move(qint32 dx, qint32 dy, HandleOpMode move_opposite_handles)
 }
 
 
+bool ObjectMover::movesObjectsOnly() const
+{
+	return points.empty() && text_handles.empty();
+}
+
+
+MapCoord ObjectMover::offset() const
+{
+	return MapCoord::fromNative(prev_drag_x, prev_drag_y);
+}
+
+
 ObjectMover::CoordIndexSet* ObjectMover::insertPointObject(PathObject* object)
 {
 	return &points.insert({object, CoordIndexSet()}).first->second;
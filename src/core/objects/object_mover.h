@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2015-2017 Kai Pastor
+ *    Copyright 2015-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -92,6 +92,19 @@ public:
 	/** Overload of move() taking delta values. */
 	void move(qint32 dx, qint32 dy, HandleOpMode move_opposite_handles);
 	
+	/**
+	 * Returns true if only whole objects are moved.
+	 * 
+	 * In this case, the result of the cursor moves is a mere translation
+	 * of the objects by offset().
+	 */
+	bool movesObjectsOnly() const;
+	
+	/**
+	 * Returns the sum of the cursor moves, in map units.
+	 */
+	MapCoord offset() const;
+	
 private:
 	using ObjectSet = std::unordered_set<Object*>;
 	using CoordIndexSet = std::unordered_set<MapCoordVector::size_type>;
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2016 Mitchell Krome
- *    Copyright 2017-2024 Kai Pastor
+ *    Copyright 2017-2024, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
 #include <new>
 #include <utility>
 #include <vector>
@@ -32,14 +33,21 @@
 #include <QChar>
 #include <QLatin1Char>
 #include <QLatin1String>
+#include <QPointF>
+#include <QRectF>
+#include <QSet>
 #include <QString>
+#include <QStringMatcher>
 #include <QVarLengthArray>
 
 #include "core/map.h"
+#include "core/map_part.h"
 #include "core/objects/object.h"
 #include "core/objects/text_object.h"
 #include "core/symbols/symbol.h"
 #include "util/key_value_container.h"
+#include "util/parallel.h"
+#include "util/util.h"
 
 
 // ### Local utilities ###
@@ -194,6 +202,224 @@ ObjectQuery::StringOperands::~StringOperands() = default;
 
 
 
+// ### ObjectQuery::SpatialReference ###
+
+namespace {
+
+/// Objects which are closer than this distance (in mm) are regarded as touching.
+constexpr double touch_distance = 0.001;
+
+bool isArea(const Object* object)
+{
+	auto const* symbol = object->getSymbol();
+	return object->getType() == Object::Path
+	       && symbol && (symbol->getContainedTypes() & Symbol::Area);
+}
+
+/**
+ * Returns true if the predicate is true for any of the positions which
+ * describe the geometry of the object.
+ * 
+ * For path objects, these are the path coords. For other objects, this is
+ * the first coordinate.
+ */
+template <class Predicate>
+bool anyPosition(const Object* object, Predicate&& predicate)
+{
+	if (object->getType() == Object::Path)
+	{
+		for (auto const& part : object->asPath()->parts())
+		{
+			for (auto const& path_coord : part.path_coords)
+			{
+				if (predicate(path_coord.pos))
+					return true;
+			}
+		}
+		return false;
+	}
+	
+	auto const& coords = object->getRawCoordinateVector();
+	return !coords.empty() && predicate(MapCoordF(coords.front()));
+}
+
+bool intersects(const PathObject* path, const PathObject* other)
+{
+	PathObject::Intersections intersections;
+	path->calcAllIntersectionsWith(other, intersections);
+	return !intersections.empty();
+}
+
+}  // namespace
+
+
+struct ObjectQuery::SpatialReference
+{
+	struct Path
+	{
+		std::unique_ptr<PathObject> object;
+		QRectF extent;
+		bool is_area;
+	};
+	
+	std::vector<Path> paths;
+	std::vector<MapCoordF> points;
+	QRectF extent;
+	
+	explicit SpatialReference(const std::vector<const Object*>& objects);
+	
+	std::size_t size() const { return paths.size() + points.size(); }
+	
+	bool contains(const Object* object) const;
+	
+	bool isWithin(const Object* object, double distance) const;
+};
+
+
+ObjectQuery::SpatialReference::SpatialReference(const std::vector<const Object*>& objects)
+{
+	for (auto const* object : objects)
+	{
+		if (object->getType() == Object::Path)
+		{
+			auto copy = std::unique_ptr<PathObject>(object->asPath()->duplicate());
+			// Only the geometry is needed. A simple symbol keeps the update cheap.
+			// After the update, the copy can be used concurrently.
+			copy->setSymbol(Map::getCoveringRedLine(), true);
+			copy->update();
+			auto path_extent = QRectF();
+			for (auto const& part : copy->parts())
+				rectIncludeSafe(path_extent, part.path_coords.calculateExtent());
+			if (!path_extent.isValid())
+				continue;
+			rectIncludeSafe(extent, path_extent);
+			paths.push_back({ std::move(copy), path_extent, isArea(object) });
+		}
+		else if (!object->getRawCoordinateVector().empty())
+		{
+			points.emplace_back(object->getRawCoordinateVector().front());
+			rectIncludeSafe(extent, QPointF(points.back()));
+		}
+	}
+}
+
+
+bool ObjectQuery::SpatialReference::contains(const Object* object) const
+{
+	auto const object_extent = object->getExtent();
+	for (auto const& path : paths)
+	{
+		if (!path.is_area || !path.extent.intersects(object_extent))
+			continue;
+		
+		auto const* area = path.object.get();
+		if (anyPosition(object, [area](auto const& pos) { return !area->isPointInsideArea(pos); }))
+			continue;
+		if (object->getType() == Object::Path && intersects(object->asPath(), area))
+			continue;
+		return true;
+	}
+	return false;
+}
+
+
+bool ObjectQuery::SpatialReference::isWithin(const Object* object, double distance) const
+{
+	// The minimum distance between two polylines which don't cross each other
+	// is found at a vertex of one of them.
+	auto const bound_sq = distance * distance;
+	auto const search_extent = object->getExtent().adjusted(-distance, -distance, distance, distance);
+	auto const* object_path = object->getType() == Object::Path ? object->asPath() : nullptr;
+	auto const object_is_area = isArea(object);
+	for (auto const& path : paths)
+	{
+		if (!path.extent.intersects(search_extent))
+			continue;
+		
+		auto const* other = path.object.get();
+		if (path.is_area
+		    && anyPosition(object, [other](auto const& pos) { return other->isPointInsideArea(pos); }))
+			return true;
+		if (anyPosition(object, [other, bound_sq](auto const& pos) {
+		        return other->findClosestPointWithin(pos, bound_sq).distance_squared < bound_sq;
+		    }))
+			return true;
+		
+		if (!object_path)
+			continue;
+		if (object_is_area
+		    && anyPosition(other, [object_path](auto const& pos) { return object_path->isPointInsideArea(pos); }))
+			return true;
+		if (anyPosition(other, [object_path, bound_sq](auto const& pos) {
+		        return object_path->findClosestPointWithin(pos, bound_sq).distance_squared < bound_sq;
+		    }))
+			return true;
+		if (intersects(object_path, other))
+			return true;
+	}
+	
+	for (auto const& point : points)
+	{
+		if (!search_extent.contains(point))
+			continue;
+		
+		if (object_path)
+		{
+			if (object_is_area && object_path->isPointInsideArea(point))
+				return true;
+			if (object_path->findClosestPointWithin(point, bound_sq).distance_squared < bound_sq)
+				return true;
+		}
+		else if (anyPosition(object, [&point, bound_sq](auto const& pos) { return pos.distanceSquaredTo(point) < bound_sq; }))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+namespace {
+
+bool evaluateSpatial(ObjectQuery::Operator op, const ObjectQuery::SpatialOperands& spatial, const Object* object)
+{
+	switch (op)
+	{
+	case ObjectQuery::OperatorInside:
+		return spatial.reference->contains(object);
+	case ObjectQuery::OperatorIntersects:
+		return spatial.reference->isWithin(object, touch_distance);
+	case ObjectQuery::OperatorWithinDistance:
+		return spatial.reference->isWithin(object, std::max(spatial.distance, touch_distance));
+	default:
+		Q_UNREACHABLE();
+	}
+}
+
+/**
+ * Returns the rectangle which contains the extents of all matching objects.
+ */
+QRectF spatialSearchRect(ObjectQuery::Operator op, const ObjectQuery::SpatialOperands& spatial)
+{
+	auto margin = 0.0;
+	if (op == ObjectQuery::OperatorIntersects)
+		margin = touch_distance;
+	else if (op == ObjectQuery::OperatorWithinDistance)
+		margin = std::max(spatial.distance, touch_distance);
+	return spatial.reference->extent.adjusted(-margin, -margin, margin, margin);
+}
+
+}  // namespace
+
+
+
+// ### ObjectQuery::SpatialOperands ###
+
+ObjectQuery::SpatialOperands::~SpatialOperands() = default;
+
+
+
 // ### ObjectQuery ###
 
 ObjectQuery::ObjectQuery() noexcept
@@ -222,6 +448,10 @@ ObjectQuery::ObjectQuery(const ObjectQuery& query)
 	{
 		symbol = query.symbol;
 	}
+	else if (op <= 35)
+	{
+		new (&spatial) SpatialOperands(query.spatial);
+	}
 }
 
 
@@ -342,6 +572,21 @@ ObjectQuery::ObjectQuery(const Symbol* symbol) noexcept
 }
 
 
+ObjectQuery::ObjectQuery(ObjectQuery::Operator op, const std::vector<const Object*>& reference, double distance)
+: op { op }
+, spatial { std::make_shared<SpatialReference>(reference), distance }
+{
+	// Must be a spatial operator
+	Q_ASSERT(op >= 33);
+	Q_ASSERT(op <= 35);
+	if (op < 33 || op > 35)
+	{
+		spatial.~SpatialOperands();
+		this->op = ObjectQuery::OperatorInvalid;
+	}
+}
+
+
 // static
 ObjectQuery ObjectQuery::negation(ObjectQuery query) noexcept
 {
@@ -385,6 +630,16 @@ QString ObjectQuery::labelFor(ObjectQuery::Operator op)
 		//: Very short label
 		return tr("Symbol");
 		
+	case OperatorInside:
+		//: Very short label
+		return tr("inside");
+	case OperatorIntersects:
+		//: Very short label
+		return tr("intersects");
+	case OperatorWithinDistance:
+		//: Very short label
+		return tr("within");
+		
 	case OperatorInvalid:
 		//: Very short label
 		return tr("invalid");
@@ -440,6 +695,11 @@ bool ObjectQuery::operator()(const Object* object) const
 	case OperatorSymbol:
 		return object->getSymbol() == symbol;
 		
+	case OperatorInside:
+	case OperatorIntersects:
+	case OperatorWithinDistance:
+		return evaluateSpatial(op, spatial, object);
+		
 	case OperatorInvalid:
 		return false;
 	}
@@ -496,6 +756,22 @@ const Symbol* ObjectQuery::symbolOperand() const
 }
 
 
+const ObjectQuery::SpatialOperands* ObjectQuery::spatialOperands() const
+{
+	const SpatialOperands* result = nullptr;
+	if (op >= 33 && op <= 35)
+	{
+		result = &spatial;
+	}
+	else
+	{
+		Q_ASSERT(op >= 33);
+		Q_ASSERT(op <= 35);
+	}
+	return result;
+}
+
+
 
 QString ObjectQuery::toString() const
 {
@@ -538,6 +814,17 @@ QString ObjectQuery::toString() const
 		ret = QLatin1String("SYMBOL \"") + (symbol ? symbol->getNumberAsString() : QString{}) + QLatin1Char('\"');
 		break;
 		
+	case OperatorInside:
+		ret = QLatin1String("INSIDE OBJECTS \"") + QString::number(spatial.reference->size()) + QLatin1Char('\"');
+		break;
+	case OperatorIntersects:
+		ret = QLatin1String("INTERSECTS OBJECTS \"") + QString::number(spatial.reference->size()) + QLatin1Char('\"');
+		break;
+	case OperatorWithinDistance:
+		ret = QLatin1String("WITHIN \"") + QString::number(spatial.distance) + QLatin1String("\" OF OBJECTS \"")
+		      + QString::number(spatial.reference->size()) + QLatin1Char('\"');
+		break;
+		
 	case OperatorInvalid:
 		// Default empty string is sufficient
 		break;
@@ -568,6 +855,11 @@ void ObjectQuery::reset()
 	{
 		op = ObjectQuery::OperatorInvalid;
 	}
+	else if (op <= 35)
+	{
+		spatial.~SpatialOperands();
+		op = ObjectQuery::OperatorInvalid;
+	}
 }
 
 
@@ -593,6 +885,11 @@ void ObjectQuery::consume(ObjectQuery&& other)
 	{
 		symbol = other.symbol;
 	}
+	else if (op <= 35)
+	{
+		new (&spatial) ObjectQuery::SpatialOperands(std::move(other.spatial));
+		other.spatial.~SpatialOperands();
+	}
 	other.op = ObjectQuery::OperatorInvalid;
 }
 
@@ -627,6 +924,13 @@ bool operator==(const ObjectQuery& lhs, const ObjectQuery& rhs)
 	case ObjectQuery::OperatorSymbol:
 		return lhs.symbol == rhs.symbol;
 		
+	case ObjectQuery::OperatorInside:
+	case ObjectQuery::OperatorIntersects:
+		return lhs.spatial.reference == rhs.spatial.reference;
+	case ObjectQuery::OperatorWithinDistance:
+		return lhs.spatial.reference == rhs.spatial.reference
+		       && lhs.spatial.distance == rhs.spatial.distance;
+		
 	case ObjectQuery::OperatorInvalid:
 		return false;
 	}
@@ -636,6 +940,267 @@ bool operator==(const ObjectQuery& lhs, const ObjectQuery& rhs)
 
 
 
+// ### ObjectQueryProgram ###
+
+ObjectQueryProgram::ObjectQueryProgram()
+{
+	compile(ObjectQuery{});
+}
+
+ObjectQueryProgram::ObjectQueryProgram(const ObjectQuery& query)
+{
+	compile(query);
+}
+
+ObjectQueryProgram::~ObjectQueryProgram() = default;
+
+
+void ObjectQueryProgram::compile(const ObjectQuery& query)
+{
+	auto const index = program.size();
+	program.emplace_back();
+	program[index].op = query.getOperator();
+	switch (query.getOperator())
+	{
+	case ObjectQuery::OperatorAnd:
+	case ObjectQuery::OperatorOr:
+		compile(*query.logicalOperands()->first);
+		compile(*query.logicalOperands()->second);
+		break;
+	case ObjectQuery::OperatorNot:
+		compile(*query.logicalOperands()->second);
+		break;
+		
+	case ObjectQuery::OperatorIs:
+	case ObjectQuery::OperatorIsNot:
+		program[index].key = query.tagOperands()->key;
+		program[index].value = query.tagOperands()->value;
+		break;
+	case ObjectQuery::OperatorContains:
+		program[index].key = query.tagOperands()->key;
+		program[index].value = query.tagOperands()->value;
+		program[index].matcher = QStringMatcher(program[index].value, Qt::CaseSensitive);
+		break;
+	case ObjectQuery::OperatorSearch:
+	case ObjectQuery::OperatorObjectText:
+		program[index].value = query.tagOperands()->value;
+		program[index].matcher = QStringMatcher(program[index].value, Qt::CaseInsensitive);
+		break;
+		
+	case ObjectQuery::OperatorSymbol:
+		program[index].symbol = query.symbolOperand();
+		break;
+		
+	case ObjectQuery::OperatorInside:
+	case ObjectQuery::OperatorIntersects:
+	case ObjectQuery::OperatorWithinDistance:
+		program[index].spatial = *query.spatialOperands();
+		break;
+		
+	case ObjectQuery::OperatorInvalid:
+		break;
+	}
+	program[index].size = program.size() - index;
+}
+
+
+bool ObjectQueryProgram::operator()(const Object* object) const
+{
+	return evaluate(0, object);
+}
+
+
+bool ObjectQueryProgram::evaluate(std::size_t index, const Object* object) const
+{
+	auto const& instruction = program[index];
+	switch (instruction.op)
+	{
+	case ObjectQuery::OperatorIs:
+		{
+			auto const& tags = object->tags();
+			auto const it = tags.find(instruction.key);
+			return it != tags.end() && it->value == instruction.value;
+		}
+	case ObjectQuery::OperatorIsNot:
+		{
+			// If the object does have the tag, not is true
+			auto const& tags = object->tags();
+			auto const it = tags.find(instruction.key);
+			return it == tags.end() || it->value != instruction.value;
+		}
+	case ObjectQuery::OperatorContains:
+		{
+			auto const& tags = object->tags();
+			auto const it = tags.find(instruction.key);
+			return it != tags.end() && instruction.matcher.indexIn(it->value) >= 0;
+		}
+	case ObjectQuery::OperatorSearch:
+		if (object->getSymbol() && instruction.matcher.indexIn(object->getSymbol()->getName()) >= 0)
+			return true;
+		for (auto const& current : object->tags())
+		{
+			if (instruction.matcher.indexIn(current.key) >= 0
+			    || instruction.matcher.indexIn(current.value) >= 0)
+				return true;
+		}
+		return false;
+	case ObjectQuery::OperatorObjectText:
+		if (object->getType() == Object::Text)
+			return instruction.matcher.indexIn(static_cast<const TextObject*>(object)->getText()) >= 0;
+		return false;
+		
+	case ObjectQuery::OperatorAnd:
+		return evaluate(index + 1, object)
+		       && evaluate(index + 1 + program[index + 1].size, object);
+	case ObjectQuery::OperatorOr:
+		return evaluate(index + 1, object)
+		       || evaluate(index + 1 + program[index + 1].size, object);
+	case ObjectQuery::OperatorNot:
+		return !evaluate(index + 1, object);
+		
+	case ObjectQuery::OperatorSymbol:
+		return object->getSymbol() == instruction.symbol;
+		
+	case ObjectQuery::OperatorInside:
+	case ObjectQuery::OperatorIntersects:
+	case ObjectQuery::OperatorWithinDistance:
+		return evaluateSpatial(instruction.op, instruction.spatial, object);
+		
+	case ObjectQuery::OperatorInvalid:
+		return false;
+	}
+	
+	Q_UNREACHABLE();
+}
+
+
+std::vector<Object*> ObjectQueryProgram::findMatchingObjects(MapPart& part) const
+{
+	std::vector<Object*> result;
+	if (!findCandidateObjects(part, result))
+	{
+		result.reserve(std::size_t(part.getNumObjects()));
+		part.applyOnAllObjects([&result](Object* object) { result.push_back(object); });
+	}
+	
+	auto const spatial = std::any_of(begin(program), end(program), [](const Instruction& instruction) {
+		return instruction.op >= ObjectQuery::OperatorInside && instruction.op <= ObjectQuery::OperatorWithinDistance;
+	});
+	if (spatial)
+	{
+		// The geometry must be up to date. Objects must not be updated concurrently.
+		Object::updateAll(std::vector<const Object*>(begin(result), end(result)));
+	}
+	
+	std::vector<char> matches(result.size());
+	Util::parallelFor(result.size(), 64, [this, &result, &matches](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			matches[i] = evaluate(0, result[i]);
+	});
+	auto last = begin(result);
+	for (std::size_t i = 0; i < matches.size(); ++i)
+	{
+		if (matches[i])
+			*last++ = result[i];
+	}
+	result.erase(last, end(result));
+	return result;
+}
+
+
+bool ObjectQueryProgram::findCandidateObjects(MapPart& part, std::vector<Object*>& candidates) const
+{
+	QSet<Object*> candidate_set;
+	if (!findCandidates(0, part, candidate_set))
+		return false;
+	
+	candidates.assign(candidate_set.begin(), candidate_set.end());
+	part.sortByObjectOrder(candidates);
+	return true;
+}
+
+
+bool ObjectQueryProgram::findCandidates(std::size_t index, const MapPart& part, QSet<Object*>& candidates) const
+{
+	auto const& instruction = program[index];
+	switch (instruction.op)
+	{
+	case ObjectQuery::OperatorIs:
+		candidates = part.objectsWithTag(instruction.key, [&instruction](const QString& value) {
+			return value == instruction.value;
+		});
+		return true;
+	case ObjectQuery::OperatorContains:
+		candidates = part.objectsWithTag(instruction.key, [&instruction](const QString& value) {
+			return instruction.matcher.indexIn(value) >= 0;
+		});
+		return true;
+		
+	case ObjectQuery::OperatorSymbol:
+		{
+			auto const objects = part.objectsWithSymbol(instruction.symbol);
+			candidates.clear();
+			candidates.reserve(int(objects.size()));
+			for (auto* object : objects)
+				candidates.insert(object);
+			return true;
+		}
+		
+	case ObjectQuery::OperatorInside:
+	case ObjectQuery::OperatorIntersects:
+	case ObjectQuery::OperatorWithinDistance:
+		{
+			candidates.clear();
+			auto const search_rect = spatialSearchRect(instruction.op, instruction.spatial);
+			if (!search_rect.isValid())
+				return true;
+			auto const objects = part.findCandidates(search_rect);
+			candidates.reserve(int(objects.size()));
+			for (auto* object : objects)
+				candidates.insert(object);
+			return true;
+		}
+		
+	case ObjectQuery::OperatorAnd:
+		{
+			// Either side restricts the candidates.
+			QSet<Object*> second_candidates;
+			auto const have_first = findCandidates(index + 1, part, candidates);
+			auto const have_second = findCandidates(index + 1 + program[index + 1].size, part, second_candidates);
+			if (have_first && have_second)
+				candidates.intersect(second_candidates);
+			else if (have_second)
+				candidates.swap(second_candidates);
+			return have_first || have_second;
+		}
+	case ObjectQuery::OperatorOr:
+		{
+			// Both sides must restrict the candidates.
+			QSet<Object*> second_candidates;
+			if (!findCandidates(index + 1, part, candidates)
+			    || !findCandidates(index + 1 + program[index + 1].size, part, second_candidates))
+				return false;
+			candidates.unite(second_candidates);
+			return true;
+		}
+		
+	case ObjectQuery::OperatorIsNot:
+	case ObjectQuery::OperatorSearch:
+	case ObjectQuery::OperatorObjectText:
+	case ObjectQuery::OperatorNot:
+		// These operators cannot be answered from the indexes.
+		return false;
+		
+	case ObjectQuery::OperatorInvalid:
+		candidates.clear();
+		return true;
+	}
+	
+	Q_UNREACHABLE();
+}
+
+
+
 // ### ObjectQueryParser ###
 
 ObjectQueryParser::ObjectQueryParser(const Map* map)
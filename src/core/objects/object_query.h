@@ -21,16 +21,21 @@
 #ifndef OPENORIENTEERING_OBJECT_QUERY_H
 #define OPENORIENTEERING_OBJECT_QUERY_H
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <QCoreApplication>
 #include <QMetaType>
+#include <QSet>
 #include <QString>
+#include <QStringMatcher>
 #include <QStringRef>
 
 namespace OpenOrienteering {
 
 class Map;
+class MapPart;
 class Object;
 class Symbol;
 
@@ -68,6 +73,11 @@ public:
 		// More operators, 32 ..
 		OperatorSymbol   = 32, ///< Test the symbol for equality.
 		
+		// Operators 33 .. 35 operate on the geometry of reference objects
+		OperatorInside         = 33, ///< Tests if the object is inside one of the reference areas
+		OperatorIntersects     = 34, ///< Tests if the object intersects or touches one of the reference objects
+		OperatorWithinDistance = 35, ///< Tests if the object is within a distance of one of the reference objects
+		
 		OperatorInvalid  = 0   ///< Marks an invalid query
 	};
 	
@@ -93,6 +103,18 @@ public:
 		
 		~StringOperands();
 	};
+	
+	// The geometry of the reference objects for spatial operations
+	struct SpatialReference;
+	
+	// Parameters for spatial operations
+	struct SpatialOperands
+	{
+		std::shared_ptr<const SpatialReference> reference;
+		double distance = 0;  ///< The distance in mm, for OperatorWithinDistance
+		
+		~SpatialOperands();
+	};
 
 	ObjectQuery() noexcept;
 	explicit ObjectQuery(const ObjectQuery& query); // maybe expensive copying
@@ -136,6 +158,17 @@ public:
 	 */
 	ObjectQuery(const Symbol* symbol) noexcept;
 	
+	/**
+	 * Constructs a query for the spatial relation to the given objects.
+	 * 
+	 * Valid for OperatorInside, OperatorIntersects and OperatorWithinDistance.
+	 * The geometry of the reference objects is copied, so the query remains
+	 * valid when the objects are modified or deleted. Only area objects can
+	 * contain other objects. The distance is given in mm on the map, and it
+	 * is used by OperatorWithinDistance only.
+	 */
+	ObjectQuery(Operator op, const std::vector<const Object*>& reference, double distance = 0);
+	
 	
 	/**
 	 * Returns a query which is the negation of the sub-query.
@@ -176,11 +209,18 @@ public:
 	 */
 	const Symbol* symbolOperand() const;
 	
+	/**
+	 * Returns the operands of spatial operations.
+	 */
+	const SpatialOperands* spatialOperands() const;
+	
 	
 	/**
 	 * Pretty print the query.
 	 * 
 	 * The output is meant to be formal language, for possible parsing.
+	 * The reference objects of spatial operations are represented only
+	 * by their number.
 	 */
 	QString toString() const;
 	
@@ -210,6 +250,7 @@ private:
 		LogicalOperands subqueries;
 		StringOperands     tags;
 		SymbolOperand   symbol;
+		SpatialOperands spatial;
 	};
 	
 };
@@ -224,6 +265,104 @@ bool operator!=(const ObjectQuery::StringOperands& lhs, const ObjectQuery::Strin
 
 
 
+/**
+ * A precompiled form of an ObjectQuery, for matching many objects.
+ * 
+ * The query tree is translated into a flat sequence of instructions in
+ * prefix order. Each instruction knows the size of its subtree, so that
+ * logical operators find their operands without following pointers. Search
+ * patterns are prepared once, instead of once per object.
+ * 
+ * findMatchingObjects() also uses the symbol index, the tag index and the
+ * spatial index of the map part in order to test only candidate objects,
+ * whenever the structure of the query allows this. findCandidateObjects()
+ * provides these candidates to callers which evaluate the program
+ * incrementally.
+ */
+class ObjectQueryProgram
+{
+public:
+	/**
+	 * Constructs a program which matches no objects.
+	 */
+	ObjectQueryProgram();
+	
+	/**
+	 * Compiles the given query.
+	 */
+	explicit ObjectQueryProgram(const ObjectQuery& query);
+	
+	ObjectQueryProgram(const ObjectQueryProgram&) = default;
+	ObjectQueryProgram(ObjectQueryProgram&&) = default;
+	
+	~ObjectQueryProgram();
+	
+	ObjectQueryProgram& operator=(const ObjectQueryProgram&) = default;
+	ObjectQueryProgram& operator=(ObjectQueryProgram&&) = default;
+	
+	
+	/**
+	 * Evaluates the program for the given object.
+	 * 
+	 * The result is the same as for the original query.
+	 */
+	bool operator()(const Object* object) const;
+	
+	/**
+	 * Returns all objects of the map part which match the program,
+	 * in the order of the part's objects.
+	 * 
+	 * The objects are tested concurrently. For spatial operations, the
+	 * candidate objects are updated first.
+	 * This function may build the tag index of the part, and so it must not
+	 * be called concurrently for the same part.
+	 */
+	std::vector<Object*> findMatchingObjects(MapPart& part) const;
+	
+	/**
+	 * Determines candidate objects of the map part from the part's symbol
+	 * index, tag index and spatial index, in the order of the part's objects.
+	 * 
+	 * All matching objects are among the candidates, but not all candidates
+	 * are matching objects. Returns false when the structure of the query
+	 * does not allow to restrict the candidates. Then all objects of the part
+	 * must be tested.
+	 * 
+	 * This function may build the tag index of the part, and so it must not
+	 * be called concurrently for the same part.
+	 */
+	bool findCandidateObjects(MapPart& part, std::vector<Object*>& candidates) const;
+	
+	
+private:
+	struct Instruction
+	{
+		ObjectQuery::Operator op;
+		std::size_t size;           ///< The number of instructions in this subtree.
+		QString key;
+		QString value;
+		QStringMatcher matcher;     ///< Prepared for the value, where needed.
+		const Symbol* symbol = nullptr;
+		ObjectQuery::SpatialOperands spatial;
+	};
+	
+	void compile(const ObjectQuery& query);
+	
+	bool evaluate(std::size_t index, const Object* object) const;
+	
+	/**
+	 * Determines the candidate objects for the subtree at index.
+	 * 
+	 * Returns false when the candidates cannot be restricted.
+	 */
+	bool findCandidates(std::size_t index, const MapPart& part, QSet<Object*>& candidates) const;
+	
+	std::vector<Instruction> program;
+	
+};
+
+
+
 /**
  * Utility to construct object queries from text.
  * 
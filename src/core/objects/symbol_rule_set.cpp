@@ -1,5 +1,5 @@
 /*
- *    Copyright 2017-2020 Kai Pastor
+ *    Copyright 2017-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -41,6 +41,7 @@
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
 #include "undo/undo_manager.h"
+#include "util/parallel.h"
 
 
 namespace OpenOrienteering {
@@ -433,6 +434,49 @@ void SymbolRuleSet::operator()(Object* object) const
 }
 
 
+void SymbolRuleSet::assignSymbols(Map& map) const
+{
+	struct CompiledRule
+	{
+		ObjectQueryProgram program;
+		const Symbol* symbol;
+	};
+	std::vector<CompiledRule> rules;
+	rules.reserve(size());
+	for (auto const& item : *this)
+	{
+		if (item.symbol)
+			rules.push_back({ ObjectQueryProgram(item.query), item.symbol });
+	}
+	if (rules.empty())
+		return;
+	
+	std::vector<Object*> objects;
+	map.applyOnAllObjects([&objects](Object* object) { objects.push_back(object); });
+	
+	// The queries only read the objects, so they can be evaluated concurrently.
+	auto replacements = std::vector<const Symbol*>(objects.size(), nullptr);
+	Util::parallelFor(objects.size(), 256, [&](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			auto const* object = objects[i];
+			auto const match = std::find_if(rules.rbegin(), rules.rend(), [object](auto const& rule) {
+				return rule.program(object);
+			});
+			if (match != rules.rend())
+				replacements[i] = match->symbol;
+		}
+	});
+	
+	// Changing the symbol updates the map's indexes, so it is done sequentially.
+	for (std::size_t i = 0; i < objects.size(); ++i)
+	{
+		if (replacements[i] && replacements[i] != objects[i]->getSymbol())
+			objects[i]->setSymbol(replacements[i], false);
+	}
+}
+
+
 void SymbolRuleSet::apply(Map& object_map, const Map& symbol_set, Options options) const &
 {
 	SymbolRuleSet(*this).apply(object_map, symbol_set, options);
@@ -489,7 +533,7 @@ void SymbolRuleSet::apply(Map& object_map, const Map& symbol_set, Options option
 	}
 	
 	// Change symbols for all objects
-	object_map.applyOnAllObjects(std::cref(*this));
+	assignSymbols(object_map);
 	
 	// Delete unused old symbols
 	if (!old_symbols.empty())
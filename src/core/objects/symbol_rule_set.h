@@ -1,5 +1,5 @@
 /*
- *    Copyright 2017-2020 Kai Pastor
+ *    Copyright 2017-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -268,6 +268,15 @@ public:
 	 */
 	void apply(Map& object_map, const Map& symbol_set, Options options) &&;
 	
+protected:
+	/**
+	 * Applies the matching rules to all objects of the map.
+	 * 
+	 * The rules are compiled once, and evaluated for the objects concurrently.
+	 * The resulting symbols are assigned in a single pass afterwards.
+	 */
+	void assignSymbols(Map& map) const;
+	
 };
 
 
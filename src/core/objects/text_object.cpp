@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2019, 2025 Kai Pastor
+ *    Copyright 2012-2019, 2025, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,9 +21,16 @@
 
 #include "text_object.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
 #include <QtMath>
+#include <Qt>
 #include <QChar>
+#include <QFont>
 #include <QLatin1Char>
+#include <QPainterPathStroker>
 
 #include "settings.h"
 #include "core/symbols/symbol.h"
@@ -34,6 +41,46 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Creates the outlines of the glyphs and underlines of a line,
+ * relative to the start of the line's baseline.
+ */
+QPainterPath makeGlyphPath(const TextObjectLineInfo& line_info, const QFont& font, const QFontMetricsF& metrics)
+{
+	QPainterPath path;
+	double underline_x0 = 0.0;
+	double underline_y0 = metrics.underlinePos();
+	double underline_y1 = underline_y0 + metrics.lineWidth();
+	
+	auto num_parts = line_info.part_infos.size();
+	for (std::size_t j=0; j < num_parts; j++)
+	{
+		const TextObjectPartInfo& part(line_info.part_infos.at(j));
+		auto const part_x = part.part_x - line_info.line_x;
+		if (font.underline())
+		{
+			if (j > 0)
+			{
+				// draw underline for gap between parts as rectangle
+				// TODO: watch out for inconsistency between text and gap underline
+				path.moveTo(underline_x0, underline_y0);
+				path.lineTo(part_x,       underline_y0);
+				path.lineTo(part_x,       underline_y1);
+				path.lineTo(underline_x0, underline_y1);
+				path.closeSubpath();
+			}
+			underline_x0 = part_x;
+		}
+		path.addText(part_x, 0.0, font, part.part_text);
+	}
+	return path;
+}
+
+}  // namespace
+
+
 // ### TextObjectPartInfo ###
 
 int TextObjectPartInfo::getIndex(double pos_x) const
@@ -138,6 +185,15 @@ TextObject::TextObject(const TextObject& proto)
  , has_single_anchor(proto.has_single_anchor)
  , size(proto.size)
  , line_infos(proto.line_infos)
+ , text_path(proto.text_path)
+ , framing_path(proto.framing_path)
+ , framing_path_width(proto.framing_path_width)
+ , layout_symbol(proto.layout_symbol)
+ , layout_revision(proto.layout_revision)
+ , valid_line_infos(proto.valid_line_infos)
+ , layout_delta_y(proto.layout_delta_y)
+ , text_path_valid(proto.text_path_valid)
+ , framing_path_valid(proto.framing_path_valid)
 {
 	// nothing
 }
@@ -160,10 +216,21 @@ void TextObject::copyFrom(const Object& other)
 	has_single_anchor = other_text.has_single_anchor;
 	size = other_text.size;
 	line_infos = other_text.line_infos;
+	text_path = other_text.text_path;
+	framing_path = other_text.framing_path;
+	framing_path_width = other_text.framing_path_width;
+	layout_symbol = other_text.layout_symbol;
+	layout_revision = other_text.layout_revision;
+	valid_line_infos = other_text.valid_line_infos;
+	layout_delta_y = other_text.layout_delta_y;
+	text_path_valid = other_text.text_path_valid;
+	framing_path_valid = other_text.framing_path_valid;
 }
 
 void TextObject::setAnchorPosition(qint32 x, qint32 y)
 {
+	if (!has_single_anchor)
+		invalidateLayout();
 	has_single_anchor = true;
 	coords[0].setNativeX(x);
 	coords[0].setNativeY(y);
@@ -172,6 +239,8 @@ void TextObject::setAnchorPosition(qint32 x, qint32 y)
 
 void TextObject::setAnchorPosition(const MapCoord& coord)
 {
+	if (!has_single_anchor)
+		invalidateLayout();
 	has_single_anchor = true;
 	coords[0] = coord;
 	setOutputDirty();
@@ -179,6 +248,8 @@ void TextObject::setAnchorPosition(const MapCoord& coord)
 
 void TextObject::setAnchorPosition(const MapCoordF& coord)
 {
+	if (!has_single_anchor)
+		invalidateLayout();
 	has_single_anchor = true;
 	coords[0].setX(coord.x());
 	coords[0].setY(coord.y());
@@ -211,6 +282,7 @@ void TextObject::setBox(qint32 mid_x, qint32 mid_y, qreal width, qreal height)
 	coords[0].setNativeX(mid_x);
 	coords[0].setNativeY(mid_y);
 	size = {width, height};
+	invalidateLayout();
 	setOutputDirty();
 }
 
@@ -218,6 +290,7 @@ void TextObject::setBoxSize(const MapCoord& size)
 {
 	has_single_anchor = false;
 	this->size = size;
+	invalidateLayout();
 	setOutputDirty();
 }
 
@@ -250,7 +323,10 @@ void TextObject::scale(const MapCoordF& center, double factor)
 {
 	coords.front() = MapCoord{center + (MapCoordF{coords.front()} - center) * factor};
 	if (!has_single_anchor)
+	{
 		size *= factor;
+		invalidateLayout();
+	}
 	setOutputDirty();
 }
 
@@ -264,6 +340,7 @@ void TextObject::scale(double factor_x, double factor_y)
 	{
 		size.setX(size.x() * factor_x);
 		size.setY(size.y() * factor_y);
+		invalidateLayout();
 	}
 	setOutputDirty();
 }
@@ -300,20 +377,33 @@ QTransform TextObject::calcMapToTextTransform() const
 
 void TextObject::setText(const QString& text)
 {
+	auto const old_text = this->text;
 	this->text = text;
 	this->text.remove(QLatin1Char('\r'));
+	
+	// Lines are never wrapped across line breaks, so the layout of the
+	// paragraphs before the first change remains valid.
+	auto const mismatch = std::mismatch(old_text.cbegin(), old_text.cend(), this->text.cbegin(), this->text.cend());
+	auto const changed = int(std::distance(this->text.cbegin(), mismatch.second));
+	auto const paragraph_start = changed > 0 ? this->text.lastIndexOf(QLatin1Char('\n'), changed - 1) + 1 : 0;
+	auto const first_changed_line = std::find_if(begin(line_infos), end(line_infos), [paragraph_start](const TextObjectLineInfo& line_info) {
+		return line_info.start_index >= paragraph_start;
+	});
+	valid_line_infos = std::min(valid_line_infos, std::size_t(std::distance(begin(line_infos), first_changed_line)));
 	setOutputDirty();
 }
 
 void TextObject::setHorizontalAlignment(TextObject::HorizontalAlignment h_align)
 {
 	this->h_align = h_align;
+	invalidateLayout();
 	setOutputDirty();
 }
 
 void TextObject::setVerticalAlignment(TextObject::VerticalAlignment v_align)
 {
 	this->v_align = v_align;
+	invalidateLayout();
 	setOutputDirty();
 }
 
@@ -377,9 +467,25 @@ const TextObjectLineInfo& TextObject::findLineInfoForIndex(int index) const
 	return *line_info;
 }
 
+void TextObject::invalidateLayout()
+{
+	layout_symbol = nullptr;
+}
+
 void TextObject::prepareLineInfos() const
 {
 	const TextSymbol* text_symbol = reinterpret_cast<const TextSymbol*>(symbol);
+	if (layout_symbol != symbol || layout_revision != text_symbol->getLayoutRevision())
+	{
+		layout_symbol = symbol;
+		layout_revision = text_symbol->getLayoutRevision();
+		valid_line_infos = 0;
+	}
+	else if (valid_line_infos == line_infos.size())
+	{
+		return;
+	}
+	text_path_valid = false;
 	
 	double scaling = text_symbol->calculateInternalScaling();
 	QFontMetricsF metrics = text_symbol->getFontMetrics();
@@ -396,7 +502,9 @@ void TextObject::prepareLineInfos() const
 	const QLatin1Char part_break('\t');
 	const QLatin1Char word_break(' ');
 	
-	line_infos.clear();
+	// Keep the lines which are still valid for the current text.
+	line_infos.erase(line_infos.begin() + std::ptrdiff_t(valid_line_infos), line_infos.end());
+	auto const first_new_line = valid_line_infos;
 	
 	// Initialize offsets
 	
@@ -417,6 +525,18 @@ void TextObject::prepareLineInfos() const
 	//double next_line_x_offset = 0; // to keep indentation after word wrap in a line with tabs
 	int num_paragraphs = 0;
 	int line_start = 0;
+	if (!line_infos.empty())
+	{
+		// Continue after the kept lines, without their vertical alignment.
+		num_paragraphs = int(std::count_if(begin(line_infos), end(line_infos), [](const TextObjectLineInfo& line_info) {
+			return line_info.paragraph_end;
+		}));
+		auto const& last_line = line_infos.back();
+		line_y = last_line.line_y - layout_delta_y + line_spacing;
+		if (last_line.paragraph_end)
+			line_y += paragraph_spacing;
+		line_start = last_line.end_index + 1;
+	}
 	while (line_start <= text_end) 
 	{
 		// Initialize input line
@@ -501,7 +621,7 @@ void TextObject::prepareLineInfos() const
 			++next_line_start;
 		}*/
 		
-		line_infos.push_back( { line_start, line_end, paragraph_end, line_x, line_y, line_width, metrics.ascent(), metrics.descent(), part_infos } );
+		line_infos.push_back( { line_start, line_end, paragraph_end, line_x, line_y, line_width, metrics.ascent(), metrics.descent(), part_infos, {} } );
 		
 		// Advance to next line
 		line_y += line_spacing;
@@ -527,10 +647,16 @@ void TextObject::prepareLineInfos() const
 			delta_y = -height + 0.5 * box_height;
 	}
 	
+	// The kept lines only need to follow the change of the vertical offset.
+	for (std::size_t i = 0; i < first_new_line; ++i)
+		line_infos[i].line_y += delta_y - layout_delta_y;
+	layout_delta_y = delta_y;
+	valid_line_infos = line_infos.size();
+	
 	if (delta_y != 0.0 || h_align != TextObject::AlignLeft)
 	{
 		int num_lines = getNumLines();
-		for (int i = 0; i < num_lines; i++)
+		for (int i = int(first_new_line); i < num_lines; i++)
 		{
 			TextObjectLineInfo* line_info = &line_infos[i];
 			
@@ -552,5 +678,59 @@ void TextObject::prepareLineInfos() const
 	}
 }
 
+std::size_t TextObject::layoutMemoryUsage() const
+{
+	auto usage = line_infos.capacity() * sizeof(TextObjectLineInfo);
+	for (auto const& line_info : line_infos)
+	{
+		usage += line_info.part_infos.capacity() * sizeof(TextObjectPartInfo);
+		usage += std::size_t(line_info.glyph_path.elementCount()) * sizeof(QPainterPath::Element);
+	}
+	usage += std::size_t(text_path.elementCount()) * sizeof(QPainterPath::Element);
+	usage += std::size_t(framing_path.elementCount()) * sizeof(QPainterPath::Element);
+	return usage;
+}
+
+const QPainterPath& TextObject::getTextPath() const
+{
+	Q_ASSERT(layout_symbol == symbol);
+	if (text_path_valid)
+		return text_path;
+	
+	const TextSymbol* text_symbol = reinterpret_cast<const TextSymbol*>(symbol);
+	const QFont& font(text_symbol->getQFont());
+	const QFontMetricsF& metrics(text_symbol->getFontMetrics());
+	
+	framing_path_valid = false;
+	text_path = QPainterPath();
+	text_path.setFillRule(Qt::WindingFill);	// Otherwise, when text and an underline intersect, holes appear
+	for (auto& line_info : line_infos)
+	{
+		// Only new lines need to be shaped again.
+		if (line_info.glyph_path.isEmpty())
+			line_info.glyph_path = makeGlyphPath(line_info, font, metrics);
+		text_path.addPath(line_info.glyph_path.translated(line_info.line_x, line_info.line_y));
+	}
+	text_path_valid = true;
+	return text_path;
+}
+
+const QPainterPath& TextObject::getFramingPath(qreal line_width) const
+{
+	auto const& path = getTextPath();
+	if (framing_path_valid && framing_path_width == line_width)
+		return framing_path;
+	
+	// The same pen style as in TextFramingRenderable::render()
+	QPainterPathStroker stroker;
+	stroker.setWidth(line_width);
+	stroker.setJoinStyle(Qt::MiterJoin);
+	stroker.setMiterLimit(0.5);
+	framing_path = stroker.createStroke(path);
+	framing_path_width = line_width;
+	framing_path_valid = true;
+	return framing_path;
+}
+
 
 }  // namespace OpenOrienteering
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2019, 2025 Kai Pastor
+ *    Copyright 2012-2019, 2025, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,10 +22,12 @@
 #ifndef OPENORIENTEERING_TEXT_OBJECT_H
 #define OPENORIENTEERING_TEXT_OBJECT_H
 
+#include <cstddef>
 #include <vector>
 
 #include <QtGlobal>
 #include <QFontMetricsF>
+#include <QPainterPath>
 #include <QPointF>
 #include <QRectF>
 #include <QString>
@@ -92,6 +94,7 @@ struct TextObjectLineInfo
 	double ascent;			/// The height of the rendered text above the baseline 
 	double descent;			/// The height of the rendered text below the baseline 
 	PartInfoContainer part_infos; /// The sequence of parts which make up this line
+	QPainterPath glyph_path;	/// The outlines of the parts relative to (line_x, line_y), cf. TextObject::getTextPath()
 	
 	/** Get the horizontal position of a particular character in a line.
 	 *  @param pos the index of the character in the original string
@@ -233,6 +236,9 @@ public:
 	
 	
 	/** Sets the text of the object.
+	 *  The layout of the paragraphs before the first changed character is
+	 *  kept, so that only the edited paragraph and the following ones need
+	 *  to be measured again.
 	 */
 	void setText(const QString& text);
 	
@@ -304,10 +310,35 @@ public:
 	const TextObjectLineInfo& findLineInfoForIndex(int index) const;
 	
 	/** Prepare the text layout information.
+	 *  The layout is kept until the text, the alignment, the box or the
+	 *  symbol's layout settings change.
 	 */
 	void prepareLineInfos() const;
 	
+	/** Returns the outlines of the glyphs and underlines, in text coordinates.
+	 *  The path is cached together with the layout. It requires prepared
+	 *  text layout information.
+	 */
+	const QPainterPath& getTextPath() const;
+	
+	/** Returns the outline of the text path stroked for line framing,
+	 *  in text coordinates.
+	 *  The outline is cached together with the text path, for the most
+	 *  recent line width. It requires prepared text layout information.
+	 */
+	const QPainterPath& getFramingPath(qreal line_width) const;
+	
+	/** Returns the approximate amount of memory held by the cached text
+	 *  layout and text path, in bytes.
+	 */
+	std::size_t layoutMemoryUsage() const;
+	
 private:
+	/** Marks the text layout and the text path as outdated.
+	 */
+	void invalidateLayout();
+	
+
 	QString text;
 	HorizontalAlignment h_align;
 	VerticalAlignment v_align;
@@ -318,6 +349,29 @@ private:
 	/** Information about the text layout.
 	 */
 	mutable LineInfoContainer line_infos;
+	
+	/** The cached outlines of the text, cf. getTextPath().
+	 */
+	mutable QPainterPath text_path;
+	
+	/** The cached framing outline, cf. getFramingPath().
+	 */
+	mutable QPainterPath framing_path;
+	mutable qreal framing_path_width = 0;
+	
+	/** The symbol and the symbol's layout revision the layout was made for.
+	 */
+	mutable const Symbol* layout_symbol = nullptr;
+	mutable quint64 layout_revision = 0;
+	
+	/** The number of leading line infos which are valid for the current text,
+	 *  and the vertical alignment offset which was applied to them.
+	 */
+	mutable std::size_t valid_line_infos = 0;
+	mutable double layout_delta_y = 0;
+	
+	mutable bool text_path_valid = false;
+	mutable bool framing_path_valid = false;
 };
 
 
@@ -0,0 +1,254 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "overprinting_compositor.h"
+
+#include <QtGlobal>
+#include <QImage>
+#include <QRect>
+#include <QRgb>
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define MAPPER_COMPOSITOR_SSE2
+#    include <emmintrin.h>
+#  elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define MAPPER_COMPOSITOR_NEON
+#    include <arm_neon.h>
+#  endif
+#endif
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/*
+ * The kernels follow the integer arithmetics of Qt's raster engine, so that
+ * their results are identical. All pixels are premultiplied, so that no
+ * intermediate value exceeds 255 * 255, and 16 bits per channel are enough.
+ */
+
+/// Divides by 255, with the same rounding as Qt's qt_div_255().
+constexpr unsigned int div255(unsigned int x)
+{
+	return (x + (x >> 8) + 0x80) >> 8;
+}
+
+QRgb multiplyPixel(QRgb d, QRgb s)
+{
+	auto const da = unsigned(qAlpha(d));
+	auto const sa = unsigned(qAlpha(s));
+	auto const op = [da, sa](unsigned int dc, unsigned int sc) {
+		return div255(sc * dc + sc * (255 - da) + dc * (255 - sa));
+	};
+	return qRgba(int(op(unsigned(qRed(d)), unsigned(qRed(s)))),
+	             int(op(unsigned(qGreen(d)), unsigned(qGreen(s)))),
+	             int(op(unsigned(qBlue(d)), unsigned(qBlue(s)))),
+	             int(255 - div255((255 - sa) * (255 - da))));
+}
+
+QRgb sourceOverPixel(QRgb d, QRgb s)
+{
+	auto const inv_sa = unsigned(255 - qAlpha(s));
+	return qRgba(qRed(s) + int(div255(unsigned(qRed(d)) * inv_sa)),
+	             qGreen(s) + int(div255(unsigned(qGreen(d)) * inv_sa)),
+	             qBlue(s) + int(div255(unsigned(qBlue(d)) * inv_sa)),
+	             qAlpha(s) + int(div255(unsigned(qAlpha(d)) * inv_sa)));
+}
+
+
+#if defined(MAPPER_COMPOSITOR_SSE2)
+
+// Each 16-bit vector holds two pixels, with the alpha channel in lanes 3 and 7.
+
+inline __m128i div255(__m128i x)
+{
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x80)), 8);
+}
+
+inline __m128i alphas(__m128i x)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+inline __m128i multiply(__m128i d, __m128i s)
+{
+	auto const c255 = _mm_set1_epi16(255);
+	auto const inv_da = _mm_sub_epi16(c255, alphas(d));
+	auto const inv_sa = _mm_sub_epi16(c255, alphas(s));
+	auto const colors = div255(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, d), _mm_mullo_epi16(s, inv_da)),
+	                                         _mm_mullo_epi16(d, inv_sa)));
+	auto const alpha = _mm_sub_epi16(c255, div255(_mm_mullo_epi16(inv_sa, inv_da)));
+	auto const alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	return _mm_or_si128(_mm_and_si128(alpha_mask, alpha), _mm_andnot_si128(alpha_mask, colors));
+}
+
+inline __m128i sourceOver(__m128i d, __m128i s)
+{
+	auto const inv_sa = _mm_sub_epi16(_mm_set1_epi16(255), alphas(s));
+	return _mm_add_epi16(s, div255(_mm_mullo_epi16(d, inv_sa)));
+}
+
+template <__m128i (*op)(__m128i, __m128i)>
+int composeSimd(QRgb* dest, const QRgb* src, int count)
+{
+	auto const zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		auto const d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+		auto const s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		auto const lo = op(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+		auto const hi = op(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(lo, hi));
+	}
+	return i;
+}
+
+int multiplySimd(QRgb* dest, const QRgb* src, int count)
+{
+	return composeSimd<multiply>(dest, src, count);
+}
+
+int sourceOverSimd(QRgb* dest, const QRgb* src, int count)
+{
+	return composeSimd<sourceOver>(dest, src, count);
+}
+
+#elif defined(MAPPER_COMPOSITOR_NEON)
+
+// Each 16-bit vector holds two pixels, with the alpha channel in lanes 3 and 7.
+
+inline uint16x8_t div255(uint16x8_t x)
+{
+	return vshrq_n_u16(vaddq_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), vdupq_n_u16(0x80)), 8);
+}
+
+inline uint16x8_t alphas(uint8x8_t x)
+{
+	static const uint8_t indices[8] = { 3, 3, 3, 3, 7, 7, 7, 7 };
+	return vmovl_u8(vtbl1_u8(x, vld1_u8(indices)));
+}
+
+inline uint8x8_t multiply(uint8x8_t d8, uint8x8_t s8)
+{
+	auto const d = vmovl_u8(d8);
+	auto const s = vmovl_u8(s8);
+	auto const c255 = vdupq_n_u16(255);
+	auto const inv_da = vsubq_u16(c255, alphas(d8));
+	auto const inv_sa = vsubq_u16(c255, alphas(s8));
+	auto const colors = div255(vaddq_u16(vaddq_u16(vmulq_u16(s, d), vmulq_u16(s, inv_da)), vmulq_u16(d, inv_sa)));
+	auto const alpha = vsubq_u16(c255, div255(vmulq_u16(inv_sa, inv_da)));
+	static const uint16_t mask[8] = { 0, 0, 0, 0xffff, 0, 0, 0, 0xffff };
+	return vmovn_u16(vbslq_u16(vld1q_u16(mask), alpha, colors));
+}
+
+inline uint8x8_t sourceOver(uint8x8_t d8, uint8x8_t s8)
+{
+	auto const inv_sa = vsubq_u16(vdupq_n_u16(255), alphas(s8));
+	return vmovn_u16(vaddq_u16(vmovl_u8(s8), div255(vmulq_u16(vmovl_u8(d8), inv_sa))));
+}
+
+template <uint8x8_t (*op)(uint8x8_t, uint8x8_t)>
+int composeSimd(QRgb* dest, const QRgb* src, int count)
+{
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		auto* d = reinterpret_cast<uint8_t*>(dest + i);
+		auto const* s = reinterpret_cast<const uint8_t*>(src + i);
+		vst1_u8(d, op(vld1_u8(d), vld1_u8(s)));
+	}
+	return i;
+}
+
+int multiplySimd(QRgb* dest, const QRgb* src, int count)
+{
+	return composeSimd<multiply>(dest, src, count);
+}
+
+int sourceOverSimd(QRgb* dest, const QRgb* src, int count)
+{
+	return composeSimd<sourceOver>(dest, src, count);
+}
+
+#else
+
+int multiplySimd(QRgb* /*dest*/, const QRgb* /*src*/, int /*count*/)
+{
+	return 0;
+}
+
+int sourceOverSimd(QRgb* /*dest*/, const QRgb* /*src*/, int /*count*/)
+{
+	return 0;
+}
+
+#endif
+
+
+void multiplyRow(QRgb* dest, const QRgb* src, int count)
+{
+	for (int i = multiplySimd(dest, src, count); i < count; ++i)
+		dest[i] = multiplyPixel(dest[i], src[i]);
+}
+
+void sourceOverRow(QRgb* dest, const QRgb* src, int count)
+{
+	for (int i = sourceOverSimd(dest, src, count); i < count; ++i)
+		dest[i] = sourceOverPixel(dest[i], src[i]);
+}
+
+
+template <class RowFunction>
+void compose(QImage& destination, const QImage& source, const QPoint& offset, RowFunction function)
+{
+	Q_ASSERT(destination.format() == QImage::Format_ARGB32_Premultiplied);
+	Q_ASSERT(source.format() == QImage::Format_ARGB32_Premultiplied);
+	
+	auto const area = destination.rect() & QRect(offset, source.size());
+	if (area.isEmpty())
+		return;
+	
+	for (int y = area.top(); y <= area.bottom(); ++y)
+	{
+		auto* dest = reinterpret_cast<QRgb*>(destination.scanLine(y)) + area.left();
+		auto const* src = reinterpret_cast<const QRgb*>(source.constScanLine(y - offset.y())) + (area.left() - offset.x());
+		function(dest, src, area.width());
+	}
+}
+
+}  // namespace
+
+
+
+void composeMultiply(QImage& destination, const QImage& source, const QPoint& offset)
+{
+	compose(destination, source, offset, &multiplyRow);
+}
+
+void composeSourceOver(QImage& destination, const QImage& source, const QPoint& offset)
+{
+	compose(destination, source, offset, &sourceOverRow);
+}
+
+
+}  // namespace OpenOrienteering
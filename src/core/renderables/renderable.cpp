@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2018 Kai Pastor
+ *    Copyright 2012-2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,7 +21,14 @@
 #include "renderable.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <memory>
+#include <tuple>
 #include <utility>
 
 #include <Qt>
@@ -31,14 +38,20 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QRect>
+#include <QRegion>
 #include <QRgb>
 #include <QTransform>
 
 #include "core/image_transparency_fixup.h"
 #include "core/map_color.h"
+#include "core/map_coord.h"
 #include "core/map.h"
+#include "core/overprinting_compositor.h"
 #include "core/objects/object.h"
+#include "core/renderables/renderable_implementation.h"
 #include "core/symbols/symbol.h"
+#include "util/performance_counters.h"
 #include "util/util.h"
 
 #if defined(Q_OS_ANDROID) && defined(QT_PRINTSUPPORT_LIB)
@@ -84,10 +97,172 @@ namespace OpenOrienteering {
 
 
 
+namespace {
+
+/**
+ * The size of the cells of the batching grid, in mm.
+ */
+constexpr qreal batch_cell_size = 100;
+
+/**
+ * The size of the header which precedes the memory of each renderable.
+ * 
+ * The header holds the address of the arena, or nullptr for heap memory.
+ */
+constexpr std::size_t allocation_header_size = alignof(std::max_align_t);
+static_assert(allocation_header_size >= sizeof(RenderableArena*), "The allocation header is too small");
+
+void writeAllocationHeader(void* memory, RenderableArena* arena)
+{
+	std::memcpy(memory, &arena, sizeof(arena));
+}
+
+RenderableArena* readAllocationHeader(const void* memory)
+{
+	RenderableArena* arena;
+	std::memcpy(&arena, memory, sizeof(arena));
+	return arena;
+}
+
+}  // namespace
+
+
+
+// ### RenderableArena ###
+
+/**
+ * A memory arena for one generation of renderables of a single object.
+ * 
+ * Renderables are allocated from blocks of growing size, by bumping a
+ * pointer. Deleting a renderable only drops a reference to the arena. The
+ * blocks are released together when the owner has released the arena and the
+ * last renderable is deleted.
+ * 
+ * Allocation is not thread-safe, but release is.
+ */
+class RenderableArena
+{
+public:
+	RenderableArena() = default;
+	RenderableArena(const RenderableArena&) = delete;
+	RenderableArena& operator=(const RenderableArena&) = delete;
+	
+	/**
+	 * Allocates memory, including the allocation header.
+	 */
+	void* allocate(std::size_t size);
+	
+	/**
+	 * Drops a reference, and deletes the arena if it was the last one.
+	 */
+	void release();
+	
+	/**
+	 * Returns the size of the allocated blocks.
+	 */
+	std::size_t memoryUsage() const { return allocated; }
+	
+private:
+	~RenderableArena();
+	
+	static constexpr std::size_t min_block_size = 512;
+	static constexpr std::size_t max_block_size = 16384;
+	
+	std::vector<void*> blocks;
+	char* next = nullptr;
+	std::size_t available = 0;
+	std::size_t block_size = min_block_size;
+	std::size_t allocated = 0;
+	std::atomic<int> ref_count { 1 };  ///< The owner and each allocation
+};
+
+RenderableArena::~RenderableArena()
+{
+	for (auto* block : blocks)
+		::operator delete(block);
+}
+
+void* RenderableArena::allocate(std::size_t size)
+{
+	auto const aligned_size = allocation_header_size
+	                          + (size + allocation_header_size - 1) / allocation_header_size * allocation_header_size;
+	if (aligned_size > available)
+	{
+		auto const new_block_size = std::max(aligned_size, block_size);
+		blocks.reserve(blocks.size() + 1);
+		next = static_cast<char*>(::operator new(new_block_size));
+		blocks.push_back(next);
+		available = new_block_size;
+		allocated += new_block_size;
+		if (block_size < max_block_size)
+			block_size *= 2;
+	}
+	
+	auto* memory = next;
+	next += aligned_size;
+	available -= aligned_size;
+	ref_count.fetch_add(1, std::memory_order_relaxed);
+	
+	writeAllocationHeader(memory, this);
+	return memory + allocation_header_size;
+}
+
+void RenderableArena::release()
+{
+	if (ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete this;
+}
+
+
+
 // ### Renderable ###
 
 Renderable::~Renderable() = default;
 
+void* Renderable::operator new(std::size_t size, ObjectRenderables& output)
+{
+	return output.allocate(size);
+}
+
+void* Renderable::operator new(std::size_t size)
+{
+	auto* memory = static_cast<char*>(::operator new(allocation_header_size + size));
+	writeAllocationHeader(memory, nullptr);
+	return memory + allocation_header_size;
+}
+
+void Renderable::operator delete(void* memory)
+{
+	if (!memory)
+		return;
+	
+	auto* header = static_cast<char*>(memory) - allocation_header_size;
+	if (auto* arena = readAllocationHeader(header))
+		arena->release();
+	else
+		::operator delete(header);
+}
+
+void Renderable::operator delete(void* memory, ObjectRenderables& /*output*/)
+{
+	Renderable::operator delete(memory);
+}
+
+int Renderable::batchKey() const
+{
+	return 0;
+}
+
+void Renderable::appendToBatch(QPainterPath& /*batch*/, int /*level*/) const
+{
+	; // nothing
+}
+
+void Renderable::renderBatch(QPainter& /*painter*/, const QPainterPath& /*batch*/) const
+{
+	; // nothing
+}
+
 
 
 // ### SharedRenderables ###
@@ -134,9 +309,18 @@ ObjectRenderables::ObjectRenderables(Object& object)
 	// nothing else
 }
 
-ObjectRenderables::~ObjectRenderables() = default;
+ObjectRenderables::ObjectRenderables(QRectF& extent)
+: extent(extent)
+{
+	// nothing else
+}
+
+ObjectRenderables::~ObjectRenderables()
+{
+	releaseArena();
+}
 
-void ObjectRenderables::draw(int map_color, const QColor& color, QPainter* painter, const RenderConfig& config) const
+void ObjectRenderables::draw(const MapColor* map_color, const QColor& color, QPainter* painter, const RenderConfig& config) const
 {
 	if (!extent.intersects(config.bounding_box))
 		return;
@@ -175,7 +359,7 @@ void ObjectRenderables::setClipPath(const QPainterPath* path)
 
 void ObjectRenderables::insertRenderable(Renderable* r, const PainterConfig& state)
 {
-	SharedRenderables::Pointer& container(operator[](state.color_priority));
+	SharedRenderables::Pointer& container(operator[](state.color));
 	if (!container)
 		container = new SharedRenderables();
 	container->operator[](state).push_back(r);
@@ -202,13 +386,40 @@ void ObjectRenderables::takeRenderables()
 	{
 		auto new_container = new SharedRenderables();
 		
-		// Pre-allocate as much space as in the original container
+		// Pre-allocate as much space as in the original container.
+		// Clip paths are owned by the old renderables, so they must not be
+		// referenced by the new container's configurations.
 		for (const auto& renderables : *color.second)
 		{
-			(*new_container)[renderables.first].reserve(renderables.second.size());
+			if (!renderables.first.clip_path)
+				(*new_container)[renderables.first].reserve(renderables.second.size());
 		}
 		color.second = new_container;
 	}
+	releaseArena();
+	dropVariant();
+}
+
+void ObjectRenderables::insertInstances(const ObjectRenderables& prototype, const MapCoordF& coord, qreal rotation)
+{
+	for (const auto& color : prototype)
+	{
+		for (const auto& renderables : *color.second)
+		{
+			Q_ASSERT(!renderables.first.clip_path);
+			for (const auto* renderable : renderables.second)
+				insertRenderable(new (*this) InstanceRenderable(renderable, color.second, coord, rotation));
+		}
+	}
+}
+
+bool ObjectRenderables::hasClipPaths() const
+{
+	return std::any_of(begin(), end(), [](const auto& color) {
+		return std::any_of(color.second->begin(), color.second->end(), [](const auto& renderables) {
+			return renderables.first.clip_path != nullptr;
+		});
+	});
 }
 
 void ObjectRenderables::deleteRenderables()
@@ -217,6 +428,145 @@ void ObjectRenderables::deleteRenderables()
 	{
 		color.second->deleteRenderables();
 	}
+	releaseArena();
+	dropVariant();
+}
+
+int ObjectRenderables::getOptions() const
+{
+	return options;
+}
+
+void ObjectRenderables::setOptions(int options)
+{
+	this->options = options;
+}
+
+std::unique_ptr<ObjectRenderables::Variant> ObjectRenderables::makeVariant() const
+{
+	return std::unique_ptr<Variant>(new Variant{ { begin(), end() }, extent, options });
+}
+
+void ObjectRenderables::setVariant(std::unique_ptr<Variant> variant)
+{
+	this->variant = std::move(variant);
+}
+
+void ObjectRenderables::dropVariant()
+{
+	variant.reset();
+}
+
+bool ObjectRenderables::switchToVariant(int options)
+{
+	if (!variant || variant->options != options)
+		return false;
+	
+	// The arena belongs to the renderables which become the variant.
+	releaseArena();
+	swap(variant->renderables);
+	std::swap(extent, variant->extent);
+	std::swap(this->options, variant->options);
+	return true;
+}
+
+std::size_t ObjectRenderables::memoryUsage() const
+{
+	auto usage = arena ? arena->memoryUsage() : std::size_t(0);
+	for (auto const& color : *this)
+	{
+		for (auto const& renderables : *color.second)
+			usage += renderables.second.capacity() * sizeof(Renderable*);
+	}
+	return usage;
+}
+
+void* ObjectRenderables::allocate(std::size_t size)
+{
+	if (!arena)
+		arena = new RenderableArena();
+	return arena->allocate(size);
+}
+
+void ObjectRenderables::releaseArena()
+{
+	if (arena)
+	{
+		arena->release();
+		arena = nullptr;
+	}
+}
+
+
+
+// ### RenderablesSnapshot ###
+
+void RenderablesSnapshot::draw(QPainter* painter, const RenderConfig& config) const
+{
+	// Level of detail
+	const qreal min_dimension = config.minVisibleSize();
+	
+	QPainterPath initial_clip = painter->clipPath();
+	const QPainterPath* current_clip = nullptr;
+	std::uint64_t num_visited = 0;
+	std::uint64_t num_drawn = 0;
+	
+	painter->save();
+	for (const auto& layer : layers)
+	{
+		auto const use_batches = layer.batched
+		                         && batch_level == SimplifiedPaths::level(config)
+		                         && config.opacity >= 1;
+		
+		for (const auto& item : layer.items)
+		{
+			if (!item.extent.intersects(config.bounding_box))
+				continue;
+			if (item.extent.width() < min_dimension && item.extent.height() < min_dimension)
+				continue;
+			
+			for (const auto& renderables : *item.renderables)
+			{
+				const PainterConfig& state = renderables.first;
+				if (!state.activate(painter, current_clip, config, layer.color, initial_clip))
+				    continue;
+				
+				num_visited += renderables.second.size();
+				for (const auto* renderable : renderables.second)
+				{
+					if (use_batches && renderable->batchKey())
+						continue;
+					const QRectF& extent = renderable->getExtent();
+					if (extent.width() < min_dimension && extent.height() < min_dimension)
+						continue;
+					if (renderable->intersects(config.bounding_box))
+					{
+						renderable->render(*painter, config);
+						++num_drawn;
+					}
+				}
+			}
+		}
+		
+		if (!use_batches)
+			continue;
+		
+		for (const auto* batch : layer.batches)
+		{
+			if (!batch->extent.intersects(config.bounding_box))
+				continue;
+			if (batch->state.activate(painter, current_clip, config, layer.color, initial_clip))
+			{
+				batch->renderable->renderBatch(*painter, batch->path);
+				++num_drawn;
+			}
+		}
+	}
+	painter->restore();
+	
+	auto& counters = Util::PerformanceCounters::instance();
+	Util::PerformanceCounters::add(counters.renderables_visited, num_visited);
+	Util::PerformanceCounters::add(counters.renderables_drawn, num_drawn);
 }
 
 
@@ -237,32 +587,31 @@ MapRenderables::MapRenderables(Map* map)
 
 void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
 {
-	// TODO: improve performance by using some spatial acceleration structure?
-	
-#ifdef Q_OS_ANDROID
-	const qreal min_dimension = 1.0/config.scaling;
-#endif
+	// Level of detail
+	const qreal min_dimension = config.minVisibleSize();
 	
 	QPainterPath initial_clip = painter->clipPath();
 	const QPainterPath* current_clip = nullptr;
+	std::uint64_t num_visited = 0;
+	std::uint64_t num_drawn = 0;
 	
 	painter->save();
-	auto end_of_colors = rend();
-	auto color = rbegin();
-	while (color != end_of_colors && color->first >= map->getNumColors())
-	{
-		++color;
-	}
-	for (; color != end_of_colors; ++color)
+	for (const auto* color : colorsInDrawingOrder())
 	{
 		if ( config.testFlag(RenderConfig::RequireSpotColor) &&
-		     (color->first < 0 || map->getColor(color->first)->getSpotColorMethod() == MapColor::UndefinedMethod) )
+		     (!color->first || color->first->getPriority() < 0 || color->first->getSpotColorMethod() == MapColor::UndefinedMethod) )
 		{
 			continue;
 		}
 		
-		for (const auto& object : color->second)
+		const ColorBatches* batched = nullptr;
+		if (useBatches(color->first, config))
+			batched = &batches(*color, SimplifiedPaths::level(config));
+		
+		for (const auto* item : objectsInBox(*color, config.bounding_box))
 		{
+			const auto& object = *item;
+			
 			// Settings check
 			const Symbol* symbol = object.first->getSymbol();
 			if (!config.testFlag(RenderConfig::HelperSymbols) && symbol->isHelperSymbol())
@@ -270,35 +619,37 @@ void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
 			if (symbol->isHidden())
 				continue;
 			
-			if (!object.first->getExtent().intersects(config.bounding_box))
+			const QRectF& object_extent = object.first->getExtent();
+			if (!object_extent.intersects(config.bounding_box))
+				continue;
+			if (object_extent.width() < min_dimension && object_extent.height() < min_dimension)
 				continue;
 			
 			for (const auto& renderables : *object.second)
 			{
 				// Render the renderables
 				const PainterConfig& state = renderables.first;
-				const MapColor* map_color = map->getColor(state.color_priority);
+				const MapColor* map_color = state.color;
 				if (!map_color)
-				{
-					Q_ASSERT(state.color_priority == MapColor::Reserved);
-					continue; // in release build
-				}
+					continue; // MapColor::Reserved
 				QColor color = *map_color;
-				if (state.color_priority >= 0 && map_color->getOpacity() < 1)
+				if (map_color->getPriority() >= 0 && map_color->getOpacity() < 1)
 					color.setAlphaF(map_color->getOpacity());
 				if (!state.activate(painter, current_clip, config, color, initial_clip))
 				    continue;
 				
+				num_visited += renderables.second.size();
 				for (const auto* renderable : renderables.second)
 				{
-#ifdef Q_OS_ANDROID
+					if (batched && renderable->batchKey())
+						continue;
 					const QRectF& extent = renderable->getExtent();
 					if (extent.width() < min_dimension && extent.height() < min_dimension)
 						continue;
-#endif
 					if (renderable->intersects(config.bounding_box))
 					{
 						renderable->render(*painter, config);
+						++num_drawn;
 					}
 				}
 				
@@ -306,9 +657,34 @@ void MapRenderables::draw(QPainter *painter, const RenderConfig &config) const
 			
 		} // each object
 		
+		if (batched)
+		{
+			for (const auto& cell : batched->cells)
+			{
+				for (const auto& batch : *cell.second)
+				{
+					if (!batch.extent.intersects(config.bounding_box))
+						continue;
+					if (!config.testFlag(RenderConfig::HelperSymbols) && batch.symbol->isHelperSymbol())
+						continue;
+					if (batch.symbol->isHidden())
+						continue;
+					if (batch.state.activate(painter, current_clip, config, *batch.state.color, initial_clip))
+					{
+						batch.renderable->renderBatch(*painter, batch.path);
+						++num_drawn;
+					}
+				}
+			}
+		}
+		
 	} // each map color
 	
 	painter->restore();
+	
+	auto& counters = Util::PerformanceCounters::instance();
+	Util::PerformanceCounters::add(counters.renderables_visited, num_visited);
+	Util::PerformanceCounters::add(counters.renderables_drawn, num_drawn);
 }
 
 void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderConfig& config) const
@@ -322,9 +698,44 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 	painter->save();
 	
 	painter->resetTransform();
-	painter->setCompositionMode(QPainter::CompositionMode_Multiply); // Alternative: CompositionMode_Darken
 	
-	QImage separation(image->size(), QImage::Format_ARGB32_Premultiplied);
+	// Separations are only needed for the clip area. When this area is a
+	// plain rectangle, the separations are composed without QPainter.
+	QRect area = image->rect();
+	bool use_compositor = painter->opacity() >= 1;
+	if (painter->hasClipping())
+	{
+		const QRegion clip_region = painter->clipRegion();
+		area &= clip_region.boundingRect();
+		use_compositor &= clip_region.rectCount() <= 1;
+	}
+	t *= QTransform::fromTranslate(-area.left(), -area.top());
+	
+	auto compose = [painter, image, &image_fixup, area, use_compositor](const QImage& separation, QPainter::CompositionMode mode) {
+		if (use_compositor && mode == QPainter::CompositionMode_Multiply)
+		{
+			composeMultiply(*image, separation, area.topLeft());
+		}
+		else if (use_compositor && mode == QPainter::CompositionMode_SourceOver)
+		{
+			composeSourceOver(*image, separation, area.topLeft());
+		}
+		else
+		{
+			painter->setCompositionMode(mode);
+			painter->drawImage(area.topLeft(), separation);
+			if (mode == QPainter::CompositionMode_Multiply)
+				image_fixup();
+		}
+	};
+	
+	if (area.isEmpty())
+	{
+		painter->restore();
+		return;
+	}
+	
+	QImage separation(area.size(), QImage::Format_ARGB32_Premultiplied);
 	
 	for (auto map_color = map->color_set->colors.rbegin();
 	     map_color != map->color_set->colors.rend();
@@ -342,9 +753,7 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 			p.end();
 			
 			// Add this separation to the composition with multiplication.
-			painter->setCompositionMode(QPainter::CompositionMode_Multiply);
-			painter->drawImage(0, 0, separation);
-			image_fixup();
+			compose(separation, QPainter::CompositionMode_Multiply); // Alternative: CompositionMode_Darken
 			
 #if MAPPER_OVERPRINTING_CORRECTION == -1
 			// Add some opacity to the multiplication, but not for black,
@@ -366,7 +775,7 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 					*px = alpha | (*px & 0xffffff);
 				}
 				painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
-				painter->drawImage(0, 0, copy);
+				painter->drawImage(area.topLeft(), copy);
 			}
 #endif
 		}
@@ -403,7 +812,7 @@ void MapRenderables::drawOverprintingSimulation(QPainter* painter, const RenderC
 		*px = (*px >> 1) & 0x7f7f7f7f;
 #endif
 	}
-	painter->drawImage(0, 0, separation);
+	compose(separation, QPainter::CompositionMode_SourceOver);
 #endif
 	
 	painter->restore();
@@ -426,19 +835,14 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 	// we need to take care of knockouts.
 	bool drawing_started = false;
 	
-	// For each pair of color priority and its renderables collection...
-	auto end_of_colors = rend();
-	auto color = rbegin();
-	while (color != end_of_colors && color->first >= map->getNumColors())
-	{
-		++color;
-	}
-	for (; color != end_of_colors; ++color)
+	// For each pair of color and its renderables collection...
+	for (const auto* color : colorsInDrawingOrder())
 	{
-		SpotColorComponent drawing_color(map->getColor(color->first), 1.0f);
+		SpotColorComponent drawing_color(color->first, 1.0f);
+		auto const priority = color->first ? color->first->getPriority() : int(MapColor::Reserved);
 		
 		// Check whether the current color [priority] applies to the current separation.
-		if (color->first > MapColor::Reserved)
+		if (priority > MapColor::Reserved)
 		{
 			if (separation->getPriority() == MapColor::Reserved)
 			{
@@ -503,9 +907,9 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 		}
 		else if (separation->getPriority() == MapColor::Reserved)
 		{
-			if (color->first == MapColor::Registration)
+			if (priority == MapColor::Registration)
 				continue; // treated per spot color
-			else if (color->first == MapColor::Reserved)
+			else if (priority == MapColor::Reserved)
 				continue; // never drawn
 			else if (!drawing_color.spot_color)
 			{
@@ -514,7 +918,7 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 			}
 			painter->setRenderHint(QPainter::Antialiasing, true);
 		}
-		else if (color->first == MapColor::Registration)
+		else if (priority == MapColor::Registration)
 		{
 			// Draw Registration Black as fulltone of regular spot color
 			drawing_color.spot_color = separation;
@@ -526,8 +930,10 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 		}
 		
 		// For each pair of object and its renderables [states] for a particular map color...
-		for (const auto& object : color->second)
+		for (const auto* item : objectsInBox(*color, config.bounding_box))
 		{
+			const auto& object = *item;
+			
 			// Check whether the symbol and object is to be drawn at all.
 			const Symbol* symbol = object.first->getSymbol();
 			if (!config.testFlag(RenderConfig::HelperSymbols) && symbol->isHelperSymbol())
@@ -585,44 +991,244 @@ void MapRenderables::drawColorSeparation(QPainter* painter, const RenderConfig&
 	painter->restore();
 }
 
+RenderablesSnapshot MapRenderables::snapshot(const RenderConfig& config) const
+{
+	const auto& bounding_box = config.bounding_box;
+	const auto& options = config.options;
+	auto const level = SimplifiedPaths::level(config);
+	
+	RenderablesSnapshot result;
+	result.bounding_box = bounding_box;
+	
+	auto const colors = colorsInDrawingOrder();
+	for (const auto& color : *this)
+	{
+		// Renderables of colors which are no longer part of the map
+		if (std::find(begin(colors), end(colors), &color) != end(colors))
+			continue;
+		for (const auto* item : objectsInBox(color, bounding_box))
+			result.retained.push_back(item->second);
+	}
+	
+	for (const auto* color : colors)
+	{
+		const MapColor* map_color = color->first;
+		bool drawn = map_color != nullptr;
+		if ( drawn
+		     && options.testFlag(RenderConfig::RequireSpotColor)
+		     && (map_color->getPriority() < 0 || map_color->getSpotColorMethod() == MapColor::UndefinedMethod) )
+		{
+			drawn = false;
+		}
+		
+		RenderablesSnapshot::Layer layer;
+		if (drawn)
+		{
+			layer.color = *map_color;
+			if (map_color->getPriority() >= 0 && map_color->getOpacity() < 1)
+				layer.color.setAlphaF(map_color->getOpacity());
+		}
+		
+		for (const auto* item : objectsInBox(*color, bounding_box))
+		{
+			const Object* object = item->first;
+			const Symbol* symbol = object->getSymbol();
+			if (!options.testFlag(RenderConfig::HelperSymbols) && symbol->isHelperSymbol())
+				continue;
+			if (symbol->isHidden())
+				continue;
+			if (!object->getExtent().intersects(bounding_box))
+				continue;
+			
+			if (drawn)
+				layer.items.push_back({ object->getExtent(), item->second });
+			else
+				result.retained.push_back(item->second);
+		}
+		
+		if (drawn && useBatches(map_color, config))
+		{
+			layer.batched = true;
+			result.batch_level = level;
+			for (const auto& cell : batches(*color, level).cells)
+			{
+				auto const num_batches = layer.batches.size();
+				for (const auto& batch : *cell.second)
+				{
+					if (!options.testFlag(RenderConfig::HelperSymbols) && batch.symbol->isHelperSymbol())
+						continue;
+					if (batch.symbol->isHidden())
+						continue;
+					if (batch.extent.intersects(bounding_box))
+						layer.batches.push_back(&batch);
+				}
+				if (layer.batches.size() != num_batches)
+					layer.batch_owners.push_back(cell.second);
+			}
+		}
+		
+		if (!layer.items.empty() || !layer.batches.empty())
+			result.layers.push_back(std::move(layer));
+	}
+	
+	return result;
+}
+
+std::vector<const MapRenderables::ColorRenderablesItem*> MapRenderables::colorsInDrawingOrder() const
+{
+	auto result = std::vector<const ColorRenderablesItem*>();
+	result.reserve(size());
+	auto const add = [this, &result](const MapColor* color) {
+		auto const item = find(color);
+		if (item != end())
+			result.push_back(&*item);
+	};
+	
+	const auto& map_colors = map->color_set->colors;
+	std::for_each(map_colors.rbegin(), map_colors.rend(), add);
+	
+	// The special colors, in the order of their priorities
+	add(nullptr);  // MapColor::Reserved
+	add(Map::getUndefinedColor());
+	add(Map::getRegistrationColor());
+	add(Map::getCoveringWhite());
+	add(Map::getCoveringRed());
+	
+	return result;
+}
+
+std::vector<const MapRenderables::ObjectRenderablesItem*> MapRenderables::objectsInBox(
+        const ColorRenderablesItem& color,
+        const QRectF& bounding_box) const
+{
+	auto result = std::vector<const ObjectRenderablesItem*>();
+	
+	auto const index = color_index.find(color.first);
+	if (index == color_index.end() || bounding_box.contains(index->second.bounds()))
+	{
+		// Everything is visible, no need for sorting.
+		result.reserve(color.second.size());
+		for (const auto& object : color.second)
+			result.push_back(&object);
+		return result;
+	}
+	
+	index->second.query(bounding_box, [this, &color, &result](const Object* object) {
+		auto const* item = findItem(color, object);
+		Q_ASSERT(item);
+		result.push_back(item);
+	});
+	// Preserve the drawing order of the container.
+	std::sort(begin(result), end(result));
+	return result;
+}
+
+const MapRenderables::ObjectRenderablesItem* MapRenderables::findItem(
+        const ColorRenderablesItem& color,
+        const Object* object) const
+{
+	auto const entry = object_entries.constFind(object);
+	if (entry == object_entries.constEnd())
+		return nullptr;
+	
+	auto const& slots = entry->slots;
+	auto const slot = std::find_if(begin(slots), end(slots), [&color](const auto& slot) {
+		return slot.color == color.first;
+	});
+	return slot != end(slots) ? &color.second[slot->index] : nullptr;
+}
+
+QRectF MapRenderables::indexKey(const Object* object) const
+{
+	auto const entry = object_entries.constFind(object);
+	return entry != object_entries.constEnd() ? entry->index_key : QRectF();
+}
+
+void MapRenderables::eraseObject(const Object* object)
+{
+	auto const entry = object_entries.find(object);
+	if (entry == object_entries.end())
+		return;
+	
+	auto const key = entry->index_key;
+	auto const slots = std::move(entry->slots);
+	object_entries.erase(entry);
+	for (const auto& slot : slots)
+	{
+		color_index[slot.color].remove(key, object);
+		invalidateBatches(slot.color, key);
+		eraseSlot(slot);
+	}
+}
+
+void MapRenderables::eraseSlot(const ObjectSlot& slot)
+{
+	auto& objects = operator[](slot.color);
+	Q_ASSERT(slot.index < objects.size());
+	if (slot.index + 1 != objects.size())
+	{
+		auto& moved = objects[slot.index];
+		moved = std::move(objects.back());
+		auto& moved_slots = object_entries[moved.first].slots;
+		auto const moved_slot = std::find_if(begin(moved_slots), end(moved_slots), [&slot](const auto& other) {
+			return other.color == slot.color;
+		});
+		Q_ASSERT(moved_slot != end(moved_slots));
+		moved_slot->index = slot.index;
+	}
+	objects.pop_back();
+}
+
 void MapRenderables::insertRenderablesOfObject(const Object* object)
 {
+	// The object's extent may have changed since the last insertion.
+	eraseObject(object);
+	
+	auto const key = object->getExtent();
+	auto& entry = object_entries[object];
+	entry.index_key = key;
+	entry.slots.reserve(object->renderables().size());
+	
 	auto end_of_colors = object->renderables().end();
 	auto color = object->renderables().begin();
 	for (; color != end_of_colors; ++color)
 	{
-		operator[](color->first)[object] = color->second;
+		auto& objects = operator[](color->first);
+		entry.slots.push_back({ color->first, objects.size() });
+		objects.emplace_back(object, color->second);
+		color_index[color->first].insert(key, object);
+		invalidateBatches(color->first, key);
 	}
 }
 
 void MapRenderables::removeRenderablesOfObject(const Object* object, bool mark_area_as_dirty)
 {
-	for (auto& color : *this)
+	auto const entry = object_entries.constFind(object);
+	if (entry == object_entries.constEnd())
+		return;
+	
+	if (mark_area_as_dirty)
 	{
-		auto obj = color.second.find(object);
-		if (obj != color.second.end())
+		for (const auto& slot : entry->slots)
 		{
-			if (mark_area_as_dirty)
+			// We don't want to loop over every dot in an area ...
+			QRectF extent = object->getExtent();
+			if (!extent.isValid())
 			{
-				// We don't want to loop over every dot in an area ...
-				QRectF extent = object->getExtent();
-				if (!extent.isValid())
+				// ... because here it gets expensive
+				for (const auto& renderables : *operator[](slot.color)[slot.index].second)
 				{
-					// ... because here it gets expensive
-					for (const auto& renderables : *obj->second)
+					for (const auto* renderable : renderables.second)
 					{
-						for (const auto* renderable : renderables.second)
-						{
-							extent = extent.isValid() ? extent.united(renderable->getExtent()) : renderable->getExtent();
-						}
+						extent = extent.isValid() ? extent.united(renderable->getExtent()) : renderable->getExtent();
 					}
 				}
-				map->setObjectAreaDirty(extent);
 			}
-			
-			color.second.erase(obj);
+			map->setObjectAreaDirty(object, extent);
 		}
 	}
+	
+	eraseObject(object);
 }
 
 void MapRenderables::clear(bool mark_area_as_dirty)
@@ -643,7 +1249,105 @@ void MapRenderables::clear(bool mark_area_as_dirty)
 			}
 		}
 	}
-	std::map<int, ObjectRenderablesMap>::clear();
+	ColorRenderablesMap::clear();
+	color_index.clear();
+	object_entries.clear();
+	color_batches.clear();
+}
+
+
+MapRenderables::BatchCell MapRenderables::batchCell(const QRectF& index_key)
+{
+	auto const center = index_key.center();
+	return { int(std::floor(center.x() / batch_cell_size)), int(std::floor(center.y() / batch_cell_size)) };
+}
+
+bool MapRenderables::useBatches(const MapColor* map_color, const RenderConfig& config)
+{
+	return config.testFlag(RenderConfig::BatchedDrawing)
+	       && config.opacity >= 1
+	       && map_color
+	       && map_color->getPriority() >= 0
+	       && map_color->getOpacity() >= 1;
+}
+
+const MapRenderables::ColorBatches& MapRenderables::batches(
+        const ColorRenderablesItem& color,
+        int level) const
+{
+	auto& result = color_batches[color.first];
+	if (result.level != level)
+	{
+		result.level = level;
+		result.cells.clear();
+		for (const auto& object : color.second)
+			result.cells[batchCell(indexKey(object.first))] = nullptr;
+	}
+	
+	for (auto& cell : result.cells)
+	{
+		if (!cell.second)
+			cell.second = createBatches(color, cell.first, level);
+	}
+	return result;
+}
+
+std::shared_ptr<const RenderableBatchVector> MapRenderables::createBatches(
+        const ColorRenderablesItem& color,
+        BatchCell cell, int level) const
+{
+	auto objects = std::vector<const ObjectRenderablesItem*>();
+	auto const index = color_index.find(color.first);
+	if (index != color_index.end())
+	{
+		// A margin for objects which are centered on the cell's boundary
+		auto const cell_rect = QRectF(cell.first * batch_cell_size, cell.second * batch_cell_size,
+		                              batch_cell_size, batch_cell_size).adjusted(-1, -1, 1, 1);
+		index->second.query(cell_rect, [this, &color, &objects, cell](const Object* object) {
+			if (batchCell(indexKey(object)) != cell)
+				return;
+			auto const* item = findItem(color, object);
+			Q_ASSERT(item);
+			objects.push_back(item);
+		});
+		// Keep the order of the container, for reproducible output.
+		std::sort(begin(objects), end(objects));
+	}
+	
+	auto result = std::make_shared<RenderableBatchVector>();
+	std::map<std::tuple<const Symbol*, PainterConfig, int>, std::size_t> batch_index;
+	for (const auto* object : objects)
+	{
+		const Symbol* symbol = object->first->getSymbol();
+		for (const auto& renderables : *object->second)
+		{
+			const PainterConfig& state = renderables.first;
+			for (const auto* renderable : renderables.second)
+			{
+				auto const key = renderable->batchKey();
+				if (!key)
+					continue;
+				
+				auto found = batch_index.find(std::make_tuple(symbol, state, key));
+				if (found == batch_index.end())
+				{
+					found = batch_index.emplace(std::make_tuple(symbol, state, key), result->size()).first;
+					result->push_back({ state, key, symbol, renderable, object->second, QRectF(), QPainterPath() });
+				}
+				auto& batch = (*result)[found->second];
+				renderable->appendToBatch(batch.path, level);
+				rectIncludeSafe(batch.extent, renderable->getExtent());
+			}
+		}
+	}
+	return result;
+}
+
+void MapRenderables::invalidateBatches(const MapColor* color, const QRectF& index_key)
+{
+	auto const found = color_batches.find(color);
+	if (found != color_batches.end())
+		found->second.cells[batchCell(index_key)] = nullptr;
 }
 
 // ### PainterConfig ###
@@ -699,11 +1403,13 @@ bool PainterConfig::activate(QPainter* painter, const QPainterPath*& current_cli
 	
 	qreal actual_pen_width = pen_width;
 	
-	if (color_priority < 0 && color_priority != MapColor::Registration)
+	if (!this->color)
+		return false;  // MapColor::Reserved
+	
+	// The colors of tool helper symbols are identified without accessing
+	// the color, because snapshots are drawn without access to the map.
+	if (this->color == Map::getCoveringRed() || this->color == Map::getCoveringWhite() || this->color == Map::getUndefinedColor())
 	{
-		if (color_priority == MapColor::Reserved)
-			return false;
-		
 		if (!config.testFlag(RenderConfig::DisableAntialiasing))
 		{
 			// this is not undone here anywhere as it should apply to 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,27 +21,37 @@
 #ifndef OPENORIENTEERING_RENDERABLE_H
 #define OPENORIENTEERING_RENDERABLE_H
 
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <QtGlobal>
+#include <QColor>
 #include <QFlags>
+#include <QHash>
+#include <QPainterPath>
 #include <QRectF>
 #include <QSharedData>
 #include <QExplicitlySharedDataPointer>
 
 #include "core/map_color.h"
+#include "util/spatial_index.h"
 
-class QColor;
 class QPainter;
-class QPainterPath;
 // IWYU pragma: no_forward_declare QRectF
 
 namespace OpenOrienteering {
 
 class Map;
+class MapCoordF;
 class Object;
+class ObjectRenderables;
 class PainterConfig;
+class RenderableArena;
+class Symbol;
 
 
 /**
@@ -72,6 +82,8 @@ public:
 		HelperSymbols       = 1<<3, ///< Activates display of symbols with the "helper symbol" flag.
 		Highlighted         = 1<<4, ///< Makes the color appear highlighted.
 		RequireSpotColor    = 1<<5, ///< Skips colors which do not have a spot color definition.
+		BatchedDrawing      = 1<<6, ///< Allows drawing similar renderables of a color in merged paths.
+		                            ///  Only effective for opaque colors at full opacity.
 		Tool                = Screen | ForceMinSize | HelperSymbols, ///< The recommended flags for tools.
 		NoOptions           = 0     ///< No option activated.
 	};
@@ -104,6 +116,22 @@ public:
 	 * \see QFlags::testFlag()
 	 */
 	bool testFlag(const Option flag) const;
+	
+	/**
+	 * Returns the size, in mm, below which items are too small to be seen.
+	 * 
+	 * Items which are smaller in both dimensions may be skipped.
+	 * This is zero unless drawing for the screen without ForceMinSize.
+	 */
+	qreal minVisibleSize() const;
+	
+	/**
+	 * Returns the distance, in mm, by which outlines may deviate from their
+	 * original shape without a visible effect.
+	 * 
+	 * This is zero unless drawing for the screen.
+	 */
+	qreal simplificationTolerance() const;
 };
 
 
@@ -113,6 +141,11 @@ public:
  * 
  * This is the abstract base class. Inheriting classes must implement the
  * abstract methods, and they must set the extent during construction.
+ * 
+ * Renderables should be allocated in the memory arena of the container which
+ * receives them, i.e. by `new (output) LineRenderable(...)`. The memory of
+ * such renderables is released in bulk, when the container has started over
+ * and the last renderable of the previous generation is deleted.
  */
 class Renderable  // clazy:exclude=copyable-polymorphic
 {
@@ -132,6 +165,26 @@ public:
 	Renderable& operator=(const Renderable&) = delete;
 	Renderable& operator=(Renderable&&) = delete;
 	
+	/**
+	 * Allocates memory for a renderable from the container's arena.
+	 */
+	static void* operator new(std::size_t size, ObjectRenderables& output);
+	
+	/**
+	 * Allocates memory for a renderable from the heap.
+	 */
+	static void* operator new(std::size_t size);
+	
+	/**
+	 * Releases the memory of a renderable.
+	 */
+	static void operator delete(void* memory);
+	
+	/**
+	 * Releases the memory of a renderable whose construction failed.
+	 */
+	static void operator delete(void* memory, ObjectRenderables& output);
+	
 	/**
 	 * Returns the extent (bounding box).
 	 */
@@ -154,9 +207,33 @@ public:
 	 */
 	virtual void render(QPainter& painter, const RenderConfig& config) const = 0;
 	
+	/**
+	 * Returns a key for drawing this renderable together with others.
+	 * 
+	 * Renderables with the same painter configuration and the same non-zero
+	 * batch key may be merged into a single path by appendToBatch(), and the
+	 * merged path may be drawn by renderBatch() of any of these renderables.
+	 * 
+	 * The default implementation returns 0, i.e. no batching.
+	 */
+	virtual int batchKey() const;
+	
+	/**
+	 * Appends the shape of this renderable to a batch.
+	 * 
+	 * @param batch  The merged path.
+	 * @param level  The level of detail, cf. SimplifiedPaths::level().
+	 */
+	virtual void appendToBatch(QPainterPath& batch, int level) const;
+	
+	/**
+	 * Renders a merged path of renderables with this renderable's batch key.
+	 */
+	virtual void renderBatch(QPainter& painter, const QPainterPath& batch) const;
+	
 protected:
-	/** The color priority is a major attribute and cannot be modified. */
-	const int color_priority;
+	/** The color is a major attribute and cannot be modified. */
+	const MapColor* const color;
 	
 	/** The extent must be set by inheriting classes. */
 	QRectF extent;
@@ -182,7 +259,7 @@ public:
 		Reserved  = -1	///< Not used.
 	};
 	
-	const int color_priority;       ///< The color priority which determines rendering order
+	const MapColor* color;          ///< The color, or nullptr for MapColor::Reserved
 	const PainterMode mode;         ///< The mode of painting
 	const qreal pen_width;          ///< The width of the pen
 	const QPainterPath* clip_path;  ///< A clip_path which may be shared by several Renderables
@@ -253,13 +330,22 @@ public:
 
 /**
  * A high-level container for all renderables of a single object, 
- * grouped by color priority and common render attributes.
+ * grouped by color and common render attributes.
  */
-class ObjectRenderables : protected std::map<int, SharedRenderables::Pointer>
+class ObjectRenderables : protected std::map<const MapColor*, SharedRenderables::Pointer>
 {
 friend class MapRenderables;
+friend class Renderable;
 public:
 	ObjectRenderables(Object& object);
+	
+	/**
+	 * Constructs a container which is not related to an object.
+	 * 
+	 * The extent of the renderables is maintained in the given rectangle.
+	 */
+	explicit ObjectRenderables(QRectF& extent);
+	
 	ObjectRenderables(const ObjectRenderables&) = delete;
 	ObjectRenderables& operator=(const ObjectRenderables&) = delete;
 	~ObjectRenderables();
@@ -272,22 +358,105 @@ public:
 	void takeRenderables();
 	
 	/**
-	 * Draws all renderables matching the given map color with the given color.
+	 * Inserts instances of all renderables of the prototype, at the given
+	 * position and rotation.
+	 * 
+	 * The prototype must not contain clipped renderables.
+	 * \see InstanceRenderable
+	 */
+	void insertInstances(const ObjectRenderables& prototype, const MapCoordF& coord, qreal rotation);
+	
+	/**
+	 * Returns true if any of the renderables is clipped.
+	 */
+	bool hasClipPaths() const;
+	
+	/**
+	 * Renderables of the same object which were generated with other
+	 * renderable options.
 	 * 
-	 * If map_color is -1, this functions draws all renderables of color which
-	 * are not in the list of map colors (i.e. objects with undefined symbol).
-	 * Used by FillTool to encode object IDs as colors.
+	 * A variant shares the containers of an earlier generation of renderables,
+	 * so it is only valid as long as the object's content is unchanged.
 	 */
-	void draw(int map_color, const QColor& color, QPainter* painter, const RenderConfig& config) const;
+	struct Variant
+	{
+		std::map<const MapColor*, SharedRenderables::Pointer> renderables;
+		QRectF extent;
+		int options;
+	};
+	
+	/**
+	 * Returns the renderable options of the current renderables.
+	 */
+	int getOptions() const;
+	
+	/**
+	 * Sets the renderable options of the current renderables.
+	 */
+	void setOptions(int options);
+	
+	/**
+	 * Returns a variant which shares the current renderables.
+	 */
+	std::unique_ptr<Variant> makeVariant() const;
+	
+	/**
+	 * Sets the variant which can be restored by switchToVariant().
+	 * 
+	 * At most one variant is kept. takeRenderables() and deleteRenderables()
+	 * drop the variant.
+	 */
+	void setVariant(std::unique_ptr<Variant> variant);
+	
+	/**
+	 * Drops the variant, releasing its renderables.
+	 */
+	void dropVariant();
+	
+	/**
+	 * Exchanges the current renderables with the variant if the variant was
+	 * generated with the given options.
+	 * 
+	 * Returns false if there is no such variant.
+	 */
+	bool switchToVariant(int options);
+	
+	/**
+	 * Draws all renderables matching the given map color with the given color.
+	 */
+	void draw(const MapColor* map_color, const QColor& color, QPainter* painter, const RenderConfig& config) const;
 	
 	void setClipPath(const QPainterPath* path);
 	const QPainterPath* getClipPath() const;
 	
 	const QRectF& getExtent() const;
 	
+	/**
+	 * Returns the approximate amount of memory held by the renderables.
+	 * 
+	 * This covers the renderables of the current generation and their
+	 * containers, but not the data which is owned by individual renderables.
+	 */
+	std::size_t memoryUsage() const;
+	
 private:
+	/**
+	 * Allocates memory from the arena of the current generation of renderables.
+	 */
+	void* allocate(std::size_t size);
+	
+	/**
+	 * Releases the arena of the current generation of renderables.
+	 * 
+	 * The memory is released when the last renderable in the arena is deleted.
+	 */
+	void releaseArena();
+	
 	QRectF& extent;
 	const QPainterPath* clip_path = nullptr; // no memory management here!
+	RenderableArena* arena = nullptr;
+	std::unique_ptr<Variant> variant;
+	int options = 0;
 };
 
 
@@ -297,19 +466,121 @@ private:
  * grouped by object and common render attributes.
  * 
  * This container uses a smart pointer to the renderable collection
- * of each single object.
+ * of each single object. The items are stored contiguously. MapRenderables
+ * removes an item by moving the last item into its place, and it keeps track
+ * of the position of each object's item.
+ */
+typedef std::vector<std::pair<const Object*, SharedRenderables::Pointer>> ObjectRenderablesVector;
+
+/**
+ * A container for the renderables of multiple objects, grouped by color.
+ * 
+ * The colors are the keys, so that the container remains valid when colors
+ * change their priority.
+ */
+typedef std::map<const MapColor*, ObjectRenderablesVector> ColorRenderablesMap;
+
+
+
+/**
+ * Renderables of a single color and symbol, merged into one path.
+ * 
+ * Batches are created by MapRenderables. They are not modified after
+ * creation, so they can be shared with snapshots.
+ */
+struct RenderableBatch
+{
+	PainterConfig state;             ///< The common painter configuration
+	int key;                         ///< The common batch key
+	const Symbol* symbol;            ///< The common symbol
+	const Renderable* renderable;    ///< A representative which renders the batch
+	SharedRenderables::Pointer owner;  ///< Keeps the representative alive
+	QRectF extent;                   ///< The united extents of the merged renderables
+	QPainterPath path;               ///< The merged path
+};
+
+/**
+ * A collection of batches which are created and shared as a unit.
+ */
+using RenderableBatchVector = std::vector<RenderableBatch>;
+
+
+
+/**
+ * A read-only copy of the drawable state of a MapRenderables container.
+ * 
+ * The snapshot shares the renderables with the map, but it does not refer to
+ * objects, symbols or colors. Symbol visibility and colors are resolved when
+ * the snapshot is taken. Object::update() replaces the containers of an object
+ * instead of modifying them, so a snapshot may be drawn on a worker thread
+ * while the map is being edited.
  */
-typedef std::map<const Object*, SharedRenderables::Pointer> ObjectRenderablesMap;
+class RenderablesSnapshot
+{
+friend class MapRenderables;
+public:
+	/**
+	 * Returns the bounding box of the area covered by this snapshot.
+	 */
+	const QRectF& getBoundingBox() const;
+	
+	/**
+	 * Draws the renderables normally (one opaque over the other).
+	 * 
+	 * The config's bounding box should be inside of the snapshot's
+	 * bounding box. The config's map is not accessed.
+	 */
+	void draw(QPainter* painter, const RenderConfig& config) const;
+	
+private:
+	struct Item
+	{
+		QRectF extent;
+		SharedRenderables::Pointer renderables;
+	};
+	
+	struct Layer
+	{
+		QColor color;
+		std::vector<Item> items;
+		std::vector<const RenderableBatch*> batches;  ///< The visible batches
+		std::vector<std::shared_ptr<const RenderableBatchVector>> batch_owners;
+		bool batched = false;  ///< If true, batchable renderables are drawn via batches.
+	};
+	
+	QRectF bounding_box;
+	
+	/// The level of detail of the batches, or -1 if batching is not used
+	int batch_level = -1;
+	
+	/// The colors which are to be drawn, in drawing order
+	std::vector<Layer> layers;
+	
+	/// Containers which are not drawn but may own clip paths of drawn items
+	std::vector<SharedRenderables::Pointer> retained;
+};
 
 
 
 /** 
  * A high-level container for renderables of multiple objects
- * grouped by color priority, object and common render attributes.
+ * grouped by color, object and common render attributes.
+ * 
+ * This container is able to draw the renderables. For each color,
+ * it maintains a spatial index of the objects' extents, so that drawing
+ * visits only the objects which intersect the bounding box.
  * 
- * This container is able to draw the renderables.
+ * The drawing order is resolved from the current priorities of the map's
+ * colors when drawing. Thus changing the order of the colors does not
+ * require to update the objects, only to redraw the map.
+ * 
+ * For the BatchedDrawing option, it also maintains merged paths of
+ * renderables which share a symbol and a painter configuration. These batches
+ * are grouped by a coarse grid of the objects' positions, and they are
+ * recreated on demand for the grid cells where objects were inserted or
+ * removed.
  */
-class MapRenderables : protected std::map<int, ObjectRenderablesMap>
+class MapRenderables : protected ColorRenderablesMap
 {
 public:
 	/**
@@ -359,6 +630,15 @@ public:
 	void drawColorSeparation(QPainter* painter, const RenderConfig& config,
 		const MapColor* separation, bool use_color = false) const;
 	
+	/**
+	 * Creates a snapshot of the renderables which intersect the config's
+	 * bounding box.
+	 * 
+	 * Only the options HelperSymbols, RequireSpotColor and BatchedDrawing
+	 * are considered. The scaling determines the level of detail of batches.
+	 */
+	RenderablesSnapshot snapshot(const RenderConfig& config) const;
+	
 	void insertRenderablesOfObject(const Object* object);
 	
 	/* NOTE: does not delete the renderables, just removes them from display */
@@ -369,7 +649,109 @@ public:
 	inline bool empty() const;
 	
 private:
+	using ObjectRenderablesItem = ObjectRenderablesVector::value_type;
+	
+	using ColorRenderablesItem = ColorRenderablesMap::value_type;
+	
+	/// The position of an object's item in the container of a color
+	struct ObjectSlot
+	{
+		const MapColor* color;
+		std::size_t index;
+	};
+	
+	/// The data which is kept for each object
+	struct ObjectEntry
+	{
+		QRectF index_key;               ///< The rectangle the object is indexed by
+		std::vector<ObjectSlot> slots;  ///< The object's items, one for each color
+	};
+	
+	/**
+	 * Returns the colors of the renderables in drawing order.
+	 * 
+	 * The map's colors are drawn from the lowest to the highest priority,
+	 * followed by the special colors. Colors which are no longer part of the
+	 * map are skipped.
+	 */
+	std::vector<const ColorRenderablesItem*> colorsInDrawingOrder() const;
+	
+	/**
+	 * Returns the objects of the given color whose extent may intersect the
+	 * bounding box, in the order of the color's ObjectRenderablesVector.
+	 */
+	std::vector<const ObjectRenderablesItem*> objectsInBox(
+	        const ColorRenderablesItem& color,
+	        const QRectF& bounding_box) const;
+	
+	/**
+	 * Returns the object's item in the container of the given color.
+	 */
+	const ObjectRenderablesItem* findItem(const ColorRenderablesItem& color, const Object* object) const;
+	
+	/**
+	 * Returns the rectangle the object is indexed by.
+	 */
+	QRectF indexKey(const Object* object) const;
+	
+	/**
+	 * Removes the object from all colors, without marking any area as dirty.
+	 */
+	void eraseObject(const Object* object);
+	
+	/**
+	 * Removes an item by moving the last item of the color into its place.
+	 */
+	void eraseSlot(const ObjectSlot& slot);
+	
+	
+	/// A cell of the batching grid
+	using BatchCell = std::pair<int, int>;
+	
+	/// The batches of a single color
+	struct ColorBatches
+	{
+		int level = -1;  ///< The level of detail
+		std::map<BatchCell, std::shared_ptr<const RenderableBatchVector>> cells;  ///< Null for outdated cells
+	};
+	
+	/**
+	 * Returns the cell of the batching grid for an object's index key.
+	 */
+	static BatchCell batchCell(const QRectF& index_key);
+	
+	/**
+	 * Returns true if the renderables of the color are to be drawn in batches.
+	 */
+	static bool useBatches(const MapColor* map_color, const RenderConfig& config);
+	
+	/**
+	 * Returns the up-to-date batches of the given color and level of detail.
+	 */
+	const ColorBatches& batches(const ColorRenderablesItem& color, int level) const;
+	
+	/**
+	 * Creates the batches for the objects in the given cell.
+	 */
+	std::shared_ptr<const RenderableBatchVector> createBatches(
+	        const ColorRenderablesItem& color,
+	        BatchCell cell, int level) const;
+	
+	/**
+	 * Marks the batches of the object's cell in the given color as outdated.
+	 */
+	void invalidateBatches(const MapColor* color, const QRectF& index_key);
+	
 	Map* const map;
+	
+	/// The objects' extents by color
+	std::map<const MapColor*, SpatialIndex<const Object*>> color_index;
+	
+	/// The index keys and item positions of the objects
+	QHash<const Object*, ObjectEntry> object_entries;
+	
+	/// The batches by color, created on demand
+	mutable std::map<const MapColor*, ColorBatches> color_batches;
 };
 
 
@@ -382,13 +764,25 @@ bool RenderConfig::testFlag(const RenderConfig::Option flag) const
 	return options.testFlag(flag);
 }
 
+inline
+qreal RenderConfig::minVisibleSize() const
+{
+	return (testFlag(Screen) && !testFlag(ForceMinSize)) ? 1 / scaling : 0;
+}
+
+inline
+qreal RenderConfig::simplificationTolerance() const
+{
+	return testFlag(Screen) ? 0.5 / scaling : 0;
+}
+
 
 
 // ### Renderable ###
 
 inline
 Renderable::Renderable(const MapColor* color)
- : color_priority(color ? color->getPriority() : MapColor::Reserved)
+ : color(color)
 {
 	; // nothing
 }
@@ -412,7 +806,7 @@ bool Renderable::intersects(const QRectF& rect) const
 inline
 bool operator==(const PainterConfig& lhs, const PainterConfig& rhs)
 {
-	return (lhs.color_priority == rhs.color_priority) &&
+	return (lhs.color == rhs.color) &&
 	       (lhs.mode == rhs.mode) &&
 	       (lhs.pen_width == rhs.pen_width || lhs.mode == PainterConfig::BrushOnly) &&
 	       (lhs.clip_path != rhs.clip_path);
@@ -427,11 +821,11 @@ bool operator!=(const PainterConfig& lhs, const PainterConfig& rhs)
 inline
 bool operator<(const PainterConfig& lhs, const PainterConfig& rhs)
 {
-	// First, decide by priority
-	if (lhs.color_priority != rhs.color_priority)
-		return lhs.color_priority > rhs.color_priority;
+	// First, decide by color
+	if (lhs.color != rhs.color)
+		return std::greater<const MapColor*>()(lhs.color, rhs.color);
 	
-	// Same priority, decide by clip path
+	// Same color, decide by clip path
 	else if (lhs.clip_path != rhs.clip_path)
 		return lhs.clip_path > rhs.clip_path;
 	
@@ -468,12 +862,22 @@ const QRectF &ObjectRenderables::getExtent() const
 
 
 
+// ### RenderablesSnapshot ###
+
+inline
+const QRectF& RenderablesSnapshot::getBoundingBox() const
+{
+	return bounding_box;
+}
+
+
+
 // ### MapRenderables ###
 
 inline
 bool MapRenderables::empty() const
 {
-	return std::map<int, ObjectRenderablesMap>::empty();
+	return ColorRenderablesMap::empty();
 }
 
 
@@ -20,19 +20,27 @@
 
 #include "renderable_implementation.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <QtMath>
 #include <QtNumeric>
+#include <QBrush>
+#include <QColor>
 #include <QFont>
 #include <QFontMetricsF>
+#include <QImage>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QPen>
 #include <QPoint>
+#include <QPolygonF>
+#include <QRgb>
 #include <QTransform>
 // IWYU pragma: no_include <QVariant>
 
@@ -85,6 +93,113 @@ inline void fixPenForPdf(QPen& pen, const QPainter& painter)
 #endif
 }
 
+
+/**
+ * Paths with fewer elements are not simplified.
+ */
+constexpr int min_simplification_elements = 64;
+
+/**
+ * The simplification tolerance of the finest variant, in mm.
+ */
+constexpr qreal base_simplification_tolerance = 0.05;
+
+/**
+ * The maximum number of simplified variants.
+ */
+constexpr std::size_t max_simplification_levels = 3;
+
+
+/**
+ * Returns the squared distance of point p from the segment from a to b.
+ */
+qreal distanceSquared(const QPointF& p, const QPointF& a, const QPointF& b)
+{
+	auto const ab = b - a;
+	auto const ap = p - a;
+	auto const length_sq = QPointF::dotProduct(ab, ab);
+	auto t = length_sq > 0 ? QPointF::dotProduct(ap, ab) / length_sq : 0;
+	t = qBound(qreal(0), t, qreal(1));
+	auto const d = ap - t * ab;
+	return QPointF::dotProduct(d, d);
+}
+
+/**
+ * Simplifies a polyline by the Douglas-Peucker algorithm.
+ * 
+ * The first and the last point are always kept.
+ */
+QPolygonF simplified(const QPolygonF& polygon, qreal tolerance)
+{
+	auto const size = polygon.size();
+	if (size < 3)
+		return polygon;
+	
+	auto const tolerance_sq = tolerance * tolerance;
+	std::vector<bool> keep(std::size_t(size), false);
+	keep.front() = keep.back() = true;
+	
+	std::vector<std::pair<int, int>> ranges { { 0, size - 1 } };
+	while (!ranges.empty())
+	{
+		auto const range = ranges.back();
+		ranges.pop_back();
+		
+		auto max_distance_sq = qreal(0);
+		auto farthest = range.first;
+		for (auto i = range.first + 1; i < range.second; ++i)
+		{
+			auto const distance_sq = distanceSquared(polygon[i], polygon[range.first], polygon[range.second]);
+			if (distance_sq > max_distance_sq)
+			{
+				max_distance_sq = distance_sq;
+				farthest = i;
+			}
+		}
+		if (max_distance_sq > tolerance_sq)
+		{
+			keep[std::size_t(farthest)] = true;
+			ranges.emplace_back(range.first, farthest);
+			ranges.emplace_back(farthest, range.second);
+		}
+	}
+	
+	QPolygonF result;
+	for (auto i = 0; i < size; ++i)
+	{
+		if (keep[std::size_t(i)])
+			result.append(polygon[i]);
+	}
+	return result;
+}
+
+/**
+ * Returns a simplified copy of the path.
+ * 
+ * Curves are flattened, with a precision matching the tolerance.
+ */
+QPainterPath simplified(const QPainterPath& path, qreal tolerance, bool area)
+{
+	// Qt flattens curves with a precision of 0.5 units, so the
+	// polygons are created in units of the tolerance.
+	auto const to_tolerance_units = QTransform::fromScale(1 / tolerance, 1 / tolerance);
+	auto const to_map_units = QTransform::fromScale(tolerance, tolerance);
+	
+	QPainterPath result;
+	result.setFillRule(path.fillRule());
+	for (const auto& polygon : path.toSubpathPolygons(to_tolerance_units))
+	{
+		auto const closed = area || (polygon.size() > 2 && polygon.front() == polygon.back());
+		auto simple_polygon = simplified(polygon, 1);
+		if (closed && simple_polygon.size() < 4)
+			simple_polygon = polygon;  // Don't let rings collapse.
+		result.addPolygon(to_map_units.map(simple_polygon));
+		if (closed)
+			result.closeSubpath();
+	}
+	return result;
+}
+
 }  // namespace
 
 
@@ -104,7 +219,7 @@ DotRenderable::DotRenderable(const PointSymbol* symbol, MapCoordF coord)
 
 PainterConfig DotRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::BrushOnly, 0, clip_path };
+	return { color, PainterConfig::BrushOnly, 0, clip_path };
 }
 
 void DotRenderable::render(QPainter &painter, const RenderConfig &config) const
@@ -132,7 +247,7 @@ CircleRenderable::CircleRenderable(const PointSymbol* symbol, MapCoordF coord)
 
 PainterConfig CircleRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::PenOnly, line_width, clip_path };
+	return { color, PainterConfig::PenOnly, line_width, clip_path };
 }
 
 void CircleRenderable::render(QPainter &painter, const RenderConfig &config) const
@@ -145,6 +260,53 @@ void CircleRenderable::render(QPainter &painter, const RenderConfig &config) con
 
 
 
+// ### SimplifiedPaths ###
+
+void SimplifiedPaths::create(const QPainterPath& path, bool area)
+{
+	levels.clear();
+	
+	auto tolerance = base_simplification_tolerance;
+	const QPainterPath* previous = &path;
+	while (levels.size() < max_simplification_levels
+	       && previous->elementCount() >= min_simplification_elements)
+	{
+		auto level = simplified(*previous, tolerance, area);
+		if (level.elementCount() > previous->elementCount() * 3 / 4)
+			break;
+		
+		levels.push_back(std::move(level));
+		previous = &levels.back();
+		tolerance *= 4;
+	}
+}
+
+int SimplifiedPaths::level(const RenderConfig& config)
+{
+	auto const max_tolerance = config.simplificationTolerance();
+	auto result = 0;
+	for (auto tolerance = base_simplification_tolerance; tolerance <= max_tolerance; tolerance *= 4)
+	{
+		if (++result == int(max_simplification_levels))
+			break;
+	}
+	return result;
+}
+
+const QPainterPath& SimplifiedPaths::select(const QPainterPath& path, int level) const
+{
+	if (level <= 0 || levels.empty())
+		return path;
+	return levels[std::min(std::size_t(level), levels.size()) - 1];
+}
+
+const QPainterPath& SimplifiedPaths::select(const QPainterPath& path, const RenderConfig& config) const
+{
+	return select(path, level(config));
+}
+
+
+
 // ### LineRenderable ###
 
 LineRenderable::LineRenderable(const LineSymbol* symbol, const VirtualPath& virtual_path, bool closed)
@@ -153,7 +315,7 @@ LineRenderable::LineRenderable(const LineSymbol* symbol, const VirtualPath& virt
 {
 	Q_ASSERT(virtual_path.size() >= 2);
 	
-	qreal half_line_width = (color_priority < 0) ? 0 : line_width/2;
+	qreal half_line_width = (!color || color->getPriority() < 0) ? 0 : line_width/2;
 	
 	switch (symbol->getCapStyle())
 	{
@@ -273,6 +435,8 @@ LineRenderable::LineRenderable(const LineSymbol* symbol, const VirtualPath& virt
 		}
 	}
 	Q_ASSERT(extent.right() < 60000000);	// assert if bogus values are returned
+	
+	simplified_paths.create(path, false);
 }
 
 LineRenderable::LineRenderable(const LineSymbol* symbol, QPointF first, QPointF second)
@@ -281,7 +445,7 @@ LineRenderable::LineRenderable(const LineSymbol* symbol, QPointF first, QPointF
  , cap_style(Qt::FlatCap)
  , join_style(Qt::MiterJoin)
 {
-	qreal half_line_width = (color_priority < 0) ? 0 : line_width/2;
+	qreal half_line_width = (!color || color->getPriority() < 0) ? 0 : line_width/2;
 	
 	auto margin = MapCoordF(second - first).perpRight();
 	margin.normalize();
@@ -445,10 +609,27 @@ void LineRenderable::extentIncludeJoin(quint32 i, qreal half_line_width, const L
 
 PainterConfig LineRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::PenOnly, line_width, clip_path };
+	return { color, PainterConfig::PenOnly, line_width, clip_path };
 }
 
-void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
+int LineRenderable::batchKey() const
+{
+	// Pen cap and join styles use distinct bits.
+	return 1 + int(cap_style) + int(join_style);
+}
+
+void LineRenderable::appendToBatch(QPainterPath& batch, int level) const
+{
+	batch.addPath(simplified_paths.select(path, level));
+}
+
+void LineRenderable::renderBatch(QPainter& painter, const QPainterPath& batch) const
+{
+	applyPenStyle(painter);
+	painter.drawPath(batch);
+}
+
+void LineRenderable::applyPenStyle(QPainter& painter) const
 {
 	QPen pen(painter.pen());
 	pen.setCapStyle(cap_style);
@@ -459,14 +640,21 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 		fixPenForPdf(pen, painter);
 	}
 	painter.setPen(pen);
+}
+
+void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
+{
+	applyPenStyle(painter);
+	
+	const auto& visible_path = simplified_paths.select(path, config);
 	
 	// One-time adjustment for line width
 	QRectF bounding_box = config.bounding_box.adjusted(-line_width, -line_width, line_width, line_width);
-	const int count = path.elementCount();
-	if (count <= 2 || bounding_box.contains(path.controlPointRect()))
+	const int count = visible_path.elementCount();
+	if (count <= 2 || bounding_box.contains(visible_path.controlPointRect()))
 	{
 		// path fully contained
-		painter.drawPath(path);
+		painter.drawPath(visible_path);
 	}
 	else
 	{
@@ -475,8 +663,8 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 		// the view rect and renders these only.
 		// NOTE: this does not work correctly with miter joins, but this
 		//       should be a minor issue.
-		QPainterPath::Element element = path.elementAt(0);
-		QPainterPath::Element last_element = path.elementAt(count-1);
+		QPainterPath::Element element = visible_path.elementAt(0);
+		QPainterPath::Element last_element = visible_path.elementAt(count-1);
 		bool path_closed = (element.x == last_element.x) && (element.y == last_element.y);
 		
 		QPainterPath part_path;
@@ -488,7 +676,7 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 		QPainterPath::Element prev_element = element;
 		for (int i = 1; i < count; ++i)
 		{
-			element = path.elementAt(i);
+			element = visible_path.elementAt(i);
 			if (element.isLineTo())
 			{
 				qreal min_x, min_y, max_x, max_y;
@@ -537,8 +725,8 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 			else if (element.isCurveTo())
 			{
 				Q_ASSERT(i < count - 2);
-				QPainterPath::Element next_element = path.elementAt(i + 1);
-				QPainterPath::Element end_element = path.elementAt(i + 2);
+				QPainterPath::Element next_element = visible_path.elementAt(i + 1);
+				QPainterPath::Element end_element = visible_path.elementAt(i + 2);
 				
 				qreal min_x = qMin(prev_element.x, qMin(element.x, qMin(next_element.x, end_element.x)));
 				qreal min_y = qMin(prev_element.y, qMin(element.y, qMin(next_element.y, end_element.y)));
@@ -611,6 +799,131 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 	painter.setPen(pen);*/
 }
 
+// ### LinePatternRenderable ###
+
+LinePatternRenderable::LinePatternRenderable(const MapColor* color, qreal line_width, qreal spacing, qreal offset, bool vertical, const QRectF& canvas)
+ : Renderable(color)
+ , line_width(line_width)
+ , spacing(spacing)
+ , offset(offset)
+ , vertical(vertical)
+{
+	extent = canvas;
+}
+
+PainterConfig LinePatternRenderable::getPainterConfig(const QPainterPath* clip_path) const
+{
+	return { color, PainterConfig::PenOnly, line_width, clip_path };
+}
+
+void LinePatternRenderable::render(QPainter& painter, const RenderConfig& config) const
+{
+	auto const area = extent.intersected(config.bounding_box.adjusted(-line_width, -line_width, line_width, line_width));
+	if (area.isEmpty())
+		return;
+	
+	// Print and export need the exact lines.
+	if (config.testFlag(RenderConfig::Screen) && renderTexture(painter, area))
+		return;
+	
+	renderLines(painter, area);
+}
+
+bool LinePatternRenderable::renderTexture(QPainter& painter, const QRectF& area) const
+{
+	const auto& transform = painter.worldTransform();
+	if (transform.type() > QTransform::TxScale)
+		return false;
+	
+	// The period of the pattern, in pixels. Large periods have few lines.
+	auto const scale = qAbs(vertical ? transform.m11() : transform.m22());
+	auto const period = spacing * scale;
+	if (period < 2 || period > 512)
+		return false;
+	
+	// A cosmetic pen is one pixel wide.
+	auto const pen = painter.pen();
+	auto const width = pen.widthF() > 0 ? pen.widthF() * scale : qreal(1);
+	if (width < 1)
+		return false;
+	
+	// The texture has an integer number of texels per period.
+	// The line at texel 0 is at the pattern offset.
+	auto const size = qRound(period);
+	auto const texel = spacing / size;
+	auto const half_width = width * size / period / 2;
+	auto const antialiasing = painter.testRenderHint(QPainter::Antialiasing);
+	auto const color = pen.color();
+	
+	QImage texture(vertical ? size : 1, vertical ? 1 : size, QImage::Format_ARGB32_Premultiplied);
+	for (int i = 0; i < size; ++i)
+	{
+		qreal coverage = 0;
+		if (antialiasing)
+		{
+			// The part of texel i which is covered by the line at 0,
+			// or by its repetitions.
+			auto const repetitions = int(half_width / size) + 1;
+			for (int k = -repetitions; k <= repetitions; ++k)
+			{
+				auto const center = qreal(k * size);
+				auto const overlap = std::min(qreal(i + 1), center + half_width) - std::max(qreal(i), center - half_width);
+				coverage += std::max(qreal(0), overlap);
+			}
+			coverage = std::min(coverage, qreal(1));
+		}
+		else
+		{
+			// Texel i is set if its center is covered.
+			auto const distance = std::fmod(i + qreal(0.5) + qreal(size) / 2, qreal(size)) - qreal(size) / 2;
+			if (distance >= -half_width && distance < half_width)
+				coverage = 1;
+		}
+		
+		auto const pixel = qPremultiply(qRgba(color.red(), color.green(), color.blue(), qRound(color.alpha() * coverage)));
+		if (vertical)
+			texture.setPixel(i, 0, pixel);
+		else
+			texture.setPixel(0, i, pixel);
+	}
+	
+	QBrush brush(texture);
+	if (vertical)
+		brush.setTransform(QTransform(texel, 0, 0, texel, offset, 0));
+	else
+		brush.setTransform(QTransform(texel, 0, 0, texel, 0, offset));
+	painter.fillRect(area, brush);
+	return true;
+}
+
+void LinePatternRenderable::renderLines(QPainter& painter, const QRectF& area) const
+{
+	QPen pen(painter.pen());
+	pen.setCapStyle(Qt::FlatCap);
+	painter.setPen(pen);
+	
+	QPainterPath lines;
+	if (vertical)
+	{
+		auto const first = offset + std::ceil((area.left() - offset) / spacing) * spacing;
+		for (auto x = first; x < area.right(); x += spacing)
+		{
+			lines.moveTo(x, area.top());
+			lines.lineTo(x, area.bottom());
+		}
+	}
+	else
+	{
+		auto const first = offset + std::ceil((area.top() - offset) / spacing) * spacing;
+		for (auto y = first; y < area.bottom(); y += spacing)
+		{
+			lines.moveTo(area.left(), y);
+			lines.lineTo(area.right(), y);
+		}
+	}
+	painter.drawPath(lines);
+}
+
 // ### AreaRenderable ###
 
 AreaRenderable::AreaRenderable(const AreaSymbol* symbol, const PathPartVector& path_parts)
@@ -633,6 +946,8 @@ AreaRenderable::AreaRenderable(const AreaSymbol* symbol, const PathPartVector& p
 		}
 	}
 	Q_ASSERT(extent.right() < 60000000);	// assert if bogus values are returned
+	
+	simplified_paths.create(path, true);
 }
 
 AreaRenderable::AreaRenderable(const AreaSymbol* symbol, const VirtualPath& path)
@@ -640,6 +955,7 @@ AreaRenderable::AreaRenderable(const AreaSymbol* symbol, const VirtualPath& path
 {
 	extent = path.path_coords.calculateExtent();
 	addSubpath(path);
+	simplified_paths.create(this->path, true);
 }
 
 void AreaRenderable::addSubpath(const VirtualPath& virtual_path)
@@ -668,12 +984,12 @@ void AreaRenderable::addSubpath(const VirtualPath& virtual_path)
 
 PainterConfig AreaRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::BrushOnly, 0, clip_path };
+	return { color, PainterConfig::BrushOnly, 0, clip_path };
 }
 
-void AreaRenderable::render(QPainter &painter, const RenderConfig &/*config*/) const
+void AreaRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
-	painter.drawPath(path);
+	painter.drawPath(simplified_paths.select(path, config));
 	
 	// DEBUG: show all control points
 	/*QPen pen(painter.pen());
@@ -692,53 +1008,72 @@ void AreaRenderable::render(QPainter &painter, const RenderConfig &/*config*/) c
 
 
 
+// ### InstanceRenderable ###
+
+InstanceRenderable::InstanceRenderable(const Renderable* prototype, SharedRenderables::Pointer owner, MapCoordF coord, qreal rotation)
+ : Renderable(prototype->getPainterConfig().color)
+ , prototype(prototype)
+ , owner(std::move(owner))
+ , position(coord)
+ , rotation(rotation)
+{
+	extent = transform().mapRect(prototype->getExtent());
+}
+
+QTransform InstanceRenderable::transform() const
+{
+	auto transform = QTransform::fromTranslate(position.x(), position.y());
+	if (!qIsNull(rotation))
+		transform.rotateRadians(rotation);
+	return transform;
+}
+
+PainterConfig InstanceRenderable::getPainterConfig(const QPainterPath* clip_path) const
+{
+	return prototype->getPainterConfig(clip_path);
+}
+
+void InstanceRenderable::render(QPainter& painter, const RenderConfig& config) const
+{
+	auto const instance_transform = transform();
+	auto instance_config = config;
+	instance_config.bounding_box = instance_transform.inverted().mapRect(config.bounding_box);
+	
+	auto const saved_transform = painter.transform();
+	painter.setTransform(instance_transform, true);
+	prototype->render(painter, instance_config);
+	painter.setTransform(saved_transform);
+}
+
+int InstanceRenderable::batchKey() const
+{
+	return prototype->batchKey();
+}
+
+void InstanceRenderable::appendToBatch(QPainterPath& batch, int level) const
+{
+	QPainterPath path;
+	prototype->appendToBatch(path, level);
+	batch.addPath(transform().map(path));
+}
+
+void InstanceRenderable::renderBatch(QPainter& painter, const QPainterPath& batch) const
+{
+	prototype->renderBatch(painter, batch);
+}
+
+
+
 // ### TextRenderable ###
 
 TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_object, const MapColor* color, double anchor_x, double anchor_y)
 : Renderable { color }
+, path       { text_object->getTextPath() }
 , anchor_x   { anchor_x }
 , anchor_y   { anchor_y }
 , rotation   { 0.0 }
 , scale_factor { symbol->getFontSize() / TextSymbol::internal_point_size }
 {
-	path.setFillRule(Qt::WindingFill);	// Otherwise, when text and an underline intersect, holes appear
-	
-	const QFont& font(symbol->getQFont());
-	const QFontMetricsF& metrics(symbol->getFontMetrics());
-	
-	int num_lines = text_object->getNumLines();
-	for (int i=0; i < num_lines; i++)
-	{
-		const TextObjectLineInfo* line_info = text_object->getLineInfo(i);
-		
-		double line_y = line_info->line_y;
-		
-		double underline_x0 = 0.0;
-		double underline_y0 = line_info->line_y + metrics.underlinePos();
-		double underline_y1 = underline_y0 + metrics.lineWidth();
-		
-		auto num_parts = line_info->part_infos.size();
-		for (std::size_t j=0; j < num_parts; j++)
-		{
-			const TextObjectPartInfo& part(line_info->part_infos.at(j));
-			if (font.underline())
-			{
-				if (j > 0)
-				{
-					// draw underline for gap between parts as rectangle
-					// TODO: watch out for inconsistency between text and gap underline
-					path.moveTo(underline_x0, underline_y0);
-					path.lineTo(part.part_x,  underline_y0);
-					path.lineTo(part.part_x,  underline_y1);
-					path.lineTo(underline_x0, underline_y1);
-					path.closeSubpath();
-				}
-				underline_x0 = part.part_x;
-			}
-			path.addText(part.part_x, line_y, font, part.part_text);
-		}
-	}
-	
 	QTransform t { 1.0, 0.0, 0.0, 1.0, anchor_x, anchor_y };
 	t.scale(scale_factor, scale_factor);
 	
@@ -754,17 +1089,17 @@ TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_
 
 PainterConfig TextRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::BrushOnly, 0.0, clip_path };
+	return { color, PainterConfig::BrushOnly, 0.0, clip_path };
 }
 
 void TextRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
 	painter.save();
-	renderCommon(painter, config);
+	renderCommon(painter, config, path);
 	painter.restore();
 }
 
-void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config) const
+void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config, const QPainterPath& shape) const
 {
 	bool disable_antialiasing = config.options.testFlag(RenderConfig::Screen) && !(Settings::getInstance().getSettingCached(Settings::MapDisplay_TextAntialiasing).toBool());
 	if (disable_antialiasing)
@@ -777,7 +1112,7 @@ void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config)
 	if (rotation != 0.0)
 		painter.rotate(rotation);
 	painter.scale(scale_factor, scale_factor);
-	painter.drawPath(path);
+	painter.drawPath(shape);
 }
 
 
@@ -787,6 +1122,7 @@ void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config)
 TextFramingRenderable::TextFramingRenderable(const TextSymbol* symbol, const TextObject* text_object, const MapColor* color, double anchor_x, double anchor_y)
 : TextRenderable     { symbol, text_object, color, anchor_x, anchor_y }
 , framing_line_width { 2 * 0.001 * symbol->getFramingLineHalfWidth() / scale_factor }
+, framing_path       { text_object->getFramingPath(framing_line_width) }
 {
 	auto adjustment = 0.001 * symbol->getFramingLineHalfWidth() ;
 	extent.adjust(-adjustment, -adjustment, +adjustment, +adjustment);
@@ -794,18 +1130,30 @@ TextFramingRenderable::TextFramingRenderable(const TextSymbol* symbol, const Tex
 
 PainterConfig TextFramingRenderable::getPainterConfig(const QPainterPath* clip_path) const
 {
-	return { color_priority, PainterConfig::PenOnly, framing_line_width, clip_path };
+	return { color, PainterConfig::PenOnly, framing_line_width, clip_path };
 }
 
 void TextFramingRenderable::render(QPainter& painter, const RenderConfig& config) const
 {
 	painter.save();
 	QPen pen(painter.pen());
+	if (pen.widthF() == framing_line_width)
+	{
+		// Fill the cached outline instead of stroking the glyphs again.
+		// This also gives the same miter joins in PDF output.
+		painter.setBrush(pen.brush());
+		painter.setPen(Qt::NoPen);
+		TextRenderable::renderCommon(painter, config, framing_path);
+		painter.restore();
+		return;
+	}
+	
+	// Cosmetic or adjusted pens must stroke the glyphs.
 	pen.setJoinStyle(Qt::MiterJoin);
 	pen.setMiterLimit(0.5);
 	fixPenForPdf(pen, painter);
 	painter.setPen(pen);
-	TextRenderable::renderCommon(painter, config);
+	TextRenderable::renderCommon(painter, config, path);
 	painter.restore();
 }
 
@@ -22,11 +22,14 @@
 #ifndef OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 #define OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 
+#include <vector>
+
 #include <Qt>
 #include <QtGlobal>
 #include <QPainterPath>
 #include <QPointF>
 #include <QRectF>
+#include <QTransform>
 
 #include "renderable.h"
 
@@ -68,6 +71,47 @@ protected:
 	QRectF rect;
 };
 
+/**
+ * Simplified variants of a long painter path, for drawing at small scales.
+ * 
+ * The variants use fixed tolerances, two zoom octaves apart. Variants are
+ * made only when they save a significant number of path elements.
+ */
+class SimplifiedPaths
+{
+public:
+	/**
+	 * Creates the variants for the given path, if it is long enough.
+	 * 
+	 * For areas, all subpaths are closed.
+	 */
+	void create(const QPainterPath& path, bool area);
+	
+	/**
+	 * Returns the level of detail which is good enough for the given
+	 * rendering configuration.
+	 * 
+	 * Level 0 is the original path. Higher levels are coarser.
+	 */
+	static int level(const RenderConfig& config);
+	
+	/**
+	 * Returns the variant for the given level of detail, or the coarsest
+	 * variant if there are fewer levels, or the original path.
+	 */
+	const QPainterPath& select(const QPainterPath& path, int level) const;
+	
+	/**
+	 * Returns the coarsest variant which is good enough for the given
+	 * rendering configuration, or the original path.
+	 */
+	const QPainterPath& select(const QPainterPath& path, const RenderConfig& config) const;
+	
+private:
+	std::vector<QPainterPath> levels;
+};
+
+
 /** Renderable for displaying a line. */
 class LineRenderable : public Renderable
 {
@@ -76,18 +120,67 @@ public:
 	LineRenderable(const LineSymbol* symbol, QPointF first, QPointF second);
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	int batchKey() const override;
+	void appendToBatch(QPainterPath& batch, int level) const override;
+	void renderBatch(QPainter& painter, const QPainterPath& batch) const override;
 	
 protected:
+	void applyPenStyle(QPainter& painter) const;
 	void extentIncludeCap(quint32 i, qreal half_line_width, bool end_cap, const LineSymbol* symbol, const VirtualPath& path);
 	
 	void extentIncludeJoin(quint32 i, qreal half_line_width, const LineSymbol* symbol, const VirtualPath& path);
 	
 	const qreal line_width;
 	QPainterPath path;
+	SimplifiedPaths simplified_paths;
 	Qt::PenCapStyle cap_style;
 	Qt::PenJoinStyle join_style;
 };
 
+/**
+ * Renderable for displaying a pattern of horizontal or vertical lines.
+ *
+ * This renderable replaces the individual line renderables of an unrotated,
+ * clipped line pattern. The lines are generated when rendering, and only for
+ * the visible part of the pattern. On the screen, the lines may be painted
+ * by filling the visible part with a texture brush made from a single period
+ * of the pattern.
+ */
+class LinePatternRenderable : public Renderable
+{
+public:
+	/**
+	 * Constructs a line pattern renderable.
+	 *
+	 * @param color       The line color.
+	 * @param line_width  The line width, in mm.
+	 * @param spacing     The distance between the lines, in mm.
+	 * @param offset      The position of one of the lines, in mm.
+	 * @param vertical    If true, the lines are vertical, otherwise horizontal.
+	 * @param canvas      The area covered by the lines.
+	 */
+	LinePatternRenderable(const MapColor* color, qreal line_width, qreal spacing, qreal offset, bool vertical, const QRectF& canvas);
+	void render(QPainter& painter, const RenderConfig& config) const override;
+	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	
+protected:
+	/**
+	 * Fills the area with a texture brush, if the painter's transformation
+	 * allows an accurate texture.
+	 *
+	 * Returns false if nothing was drawn.
+	 */
+	bool renderTexture(QPainter& painter, const QRectF& area) const;
+	
+	/** Strokes the lines which intersect the area. */
+	void renderLines(QPainter& painter, const QRectF& area) const;
+	
+	const qreal line_width;
+	const qreal spacing;
+	const qreal offset;
+	const bool vertical;
+};
+
 /** Renderable for displaying an area. */
 class AreaRenderable : public Renderable
 {
@@ -103,6 +196,42 @@ protected:
 	void addSubpath(const VirtualPath& virtual_path);
 	
 	QPainterPath path;
+	SimplifiedPaths simplified_paths;
+};
+
+/**
+ * Renderable for displaying a shared renderable at another position.
+ * 
+ * Instances are used for point symbol elements: The geometry of the elements
+ * is created once, relative to the origin, and each placement of the symbol
+ * stores only its position and rotation.
+ */
+class InstanceRenderable : public Renderable
+{
+public:
+	/**
+	 * Constructs an instance of the prototype.
+	 * 
+	 * @param prototype  The shared renderable.
+	 * @param owner      The container which owns the prototype.
+	 * @param coord      The position of the prototype's origin.
+	 * @param rotation   The rotation of the prototype, in radians.
+	 */
+	InstanceRenderable(const Renderable* prototype, SharedRenderables::Pointer owner, MapCoordF coord, qreal rotation);
+	void render(QPainter& painter, const RenderConfig& config) const override;
+	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	int batchKey() const override;
+	void appendToBatch(QPainterPath& batch, int level) const override;
+	void renderBatch(QPainter& painter, const QPainterPath& batch) const override;
+	
+protected:
+	/** Returns the transformation from prototype to map coordinates. */
+	QTransform transform() const;
+	
+	const Renderable* const prototype;
+	const SharedRenderables::Pointer owner;
+	const QPointF position;
+	const qreal rotation;
 };
 
 /** Renderable for displaying text. */
@@ -114,7 +243,7 @@ public:
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	
 protected:
-	void renderCommon(QPainter& painter, const RenderConfig& config) const;
+	void renderCommon(QPainter& painter, const RenderConfig& config, const QPainterPath& shape) const;
 	
 	QPainterPath path;
 	qreal anchor_x;
@@ -133,6 +262,7 @@ public:
 	
 protected:
 	qreal framing_line_width;
+	QPainterPath framing_path;  ///< The stroked path, shared with the text object's cache.
 };
 
 
@@ -241,7 +241,7 @@ void AreaSymbol::FillPattern::createLine<AreaSymbol::FillPattern::LinePattern>(
         ObjectRenderables& output ) const
 {
 	// out of inlining
-	output.insertRenderable(new LineRenderable(line, first, second));
+	output.insertRenderable(new (output) LineRenderable(line, first, second));
 }
 
 
@@ -443,6 +443,27 @@ void AreaSymbol::FillPattern::createRenderables(const AreaRenderable& outline, q
 	switch (type)
 	{
 	case LinePattern:
+		if (!(flags & Option::AlternativeToClipping)
+		    && (qAbs(rotation - 0) < 0.0001 || qAbs(rotation - M_PI/2) < 0.0001))
+		{
+			// Special case: clipped horizontal or vertical lines,
+			// generated on demand by a single renderable.
+			auto const vertical = qAbs(rotation - M_PI/2) < 0.0001;
+			auto offset = 0.001 * line_offset;
+			if (rotatable())
+			{
+				MapCoordF line_normal(0, -1);
+				line_normal.rotate(rotation);
+				line_normal.setY(-line_normal.y());
+				offset += MapCoordF::dotProduct(line_normal, MapCoordF(pattern_origin));
+			}
+			
+			auto line_width_f = 0.001*line_width;
+			auto margin = line_width_f / 2;
+			auto canvas = outline.getExtent().adjusted(-margin, -margin, margin, margin);
+			output.insertRenderable(new (output) LinePatternRenderable(line_color, line_width_f, 0.001*line_spacing, offset, vertical, canvas));
+		}
+		else
 		{
 			LineSymbol line;
 			line.setColor(line_color);
@@ -639,7 +660,7 @@ void AreaSymbol::createRenderablesNormal(
 {
 	// The shape output is even created if the area is not filled with a color
 	// because the QPainterPath created by it is needed as clip path for the fill objects
-	auto color_fill = new AreaRenderable(this, path_parts);
+	auto color_fill = new (output) AreaRenderable(this, path_parts);
 	output.insertRenderable(color_fill);
 	
 	auto rotation = object->getPatternRotation();
@@ -40,6 +40,7 @@
 #include "core/map.h"
 #include "core/map_color.h"
 #include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
 #include "core/symbols/symbol.h"
 
 
@@ -107,6 +108,8 @@ void CombinedSymbol::createRenderables(
         ObjectRenderables &output,
         Symbol::RenderableOptions options) const
 {
+	// The parts may shift the same paths by the same distances.
+	ShiftedPathCache shifted_paths(path_parts);
 	for (auto subsymbol : parts)
 	{
 		if (subsymbol)
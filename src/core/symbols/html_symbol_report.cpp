@@ -19,29 +19,38 @@
 
 #include "html_symbol_report.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+
 #include <QBuffer>
 #include <QByteArray>
 #include <QChar>
 #include <QColor>
 #include <QCoreApplication>
 #include <QImage>
+#include <QHash>
+#include <QIODevice>
 #include <QImageWriter>
 #include <QLatin1String>
 #include <QLocale>
 #include <QString>
+#include <QThread>
 
 #include "core/map.h"
 #include "core/map_color.h"
 #include "core/symbols/symbol.h"
 #include "gui/util_gui.h"
+#include "util/parallel.h"
 
 namespace OpenOrienteering {
 
 /**
  * Generates HTML reports for colors and symbols in a Map.
  * 
- * The public interface of this class is the free-standing function
- * makeHTMLSymbolReport(const Map& map).
+ * The public interface of this class are the free-standing functions
+ * makeHTMLSymbolReport() and writeHTMLSymbolReport().
  */
 class HTMLSymbolReportGenerator
 {
@@ -78,10 +87,27 @@ private:
 		Extended  ///< A color row with all details
 	};
 	
+	/**
+	 * A symbol row which is waiting for the PNG data of its icon.
+	 */
+	struct PendingSymbolRow
+	{
+		const Symbol* symbol;
+		std::future<QByteArray> icon_png;
+	};
+	
 	const Map& map;
 	QImage icon_image;
 	QLocale locale;
 	PNGImageWriter image_writer;
+	QHash<const MapColor*, QString> basic_color_rows;
+	bool write_failed = false;
+	
+	void writeData(QIODevice& device, const QByteArray& data)
+	{
+		if (!write_failed && device.write(data) != data.size())
+			write_failed = true;
+	}
 	
 	QString imgForColor(const QColor& c, const QString& alt)
 	{
@@ -168,23 +194,42 @@ private:
 		        color_data );
 	}
 	
-	QString imgForSymbol(const Symbol& s, const QString& alt)
+	/// The display size of symbol icons, in pixels
+	static constexpr int symbol_icon_size = 48;
+	
+	/**
+	 * Starts the encoding of the symbol's icon on the job system.
+	 * 
+	 * The icon is rendered on the calling thread.
+	 */
+	std::future<QByteArray> startSymbolIcon(const Symbol& s)
 	{
 		// For better quality and compression,
 		// using multiple of display size but no antialiasing
-		auto const display_size = 48;
-		icon_image = s.createIcon(map, 4 * display_size, false);
-		return QString::fromLatin1("<img alt=\"%1\" width=\"%2\" src=\"data:image/png;base64,").arg(alt).arg(display_size)
-		       + QString::fromLatin1(image_writer.write(icon_image).toBase64())
+		auto image = s.createIcon(map, 4 * symbol_icon_size, false);
+		return Util::startJob<QByteArray>([image]() {
+			return PNGImageWriter().write(image).toBase64();
+		}, Util::JobPriority::Interactive);
+	}
+	
+	QString imgForSymbol(const QByteArray& icon_png, const QString& alt)
+	{
+		return QString::fromLatin1("<img alt=\"%1\" width=\"%2\" src=\"data:image/png;base64,").arg(alt).arg(symbol_icon_size)
+		       + QString::fromLatin1(icon_png)
 		       + QString::fromLatin1("\">");
 	}
 	
 	QString colorsForSymbol(const Symbol& s)
 	{
+		// Most colors are used by many symbols.
 		QString color_data;
 		map.applyOnAllColors([this, &s, &color_data](const MapColor* c){
-			if (s.containsColor(c))
-				color_data.append(makeColorRow(*c, ColorRowType::Basic));
+			if (!s.containsColor(c))
+				return;
+			auto row = basic_color_rows.find(c);
+			if (row == basic_color_rows.end())
+				row = basic_color_rows.insert(c, makeColorRow(*c, ColorRowType::Basic));
+			color_data.append(*row);
 		});
 		return QString::fromLatin1(
 		           "<table>\n"
@@ -196,7 +241,7 @@ private:
 		        color_data );
 	}
 	
-	QString makeSymbolRow(const Symbol& s)
+	QString makeSymbolRow(const Symbol& s, const QByteArray& icon_png)
 	{
 		auto label = s.getNumberAndPlainTextName();
 		auto extra_text = QString{};
@@ -225,29 +270,47 @@ private:
 		           "%5</td>"            // colors
 		           "</tr>\n"
 		           ).arg(
-		        imgForSymbol(s, label),
+		        imgForSymbol(icon_png, label),
 		        label,
 		        QString(s.getDescription()).replace(QChar::LineFeed, QLatin1String("<br>\n")),
 		        extra_text,
 		        colorsForSymbol(s) );
 	}
 	
-	QString makeSymbolSection()
+	/**
+	 * Writes the symbol section.
+	 * 
+	 * While the icons of the next symbols are encoded on the job system,
+	 * the finished rows are written to the device.
+	 */
+	void writeSymbolSection(QIODevice& device)
 	{
-		QString symbol_data;
-		map.applyOnAllSymbols([this, &symbol_data](const Symbol* s){
-			symbol_data.append(makeSymbolRow(*s));
+		writeData(device, QString::fromLatin1(
+		                 "<h2>%1</h2>\n"
+		                 "<table class=\"symbols\">\n"
+		                 "<tbody>\n"
+		                 ).arg(
+		                 QCoreApplication::translate("OpenOrienteering::SymbolReport", "Symbols") ).toUtf8());
+		
+		auto const max_in_flight = std::size_t(std::max(1, 2 * QThread::idealThreadCount()));
+		std::deque<PendingSymbolRow> pending;
+		auto write_rows = [this, &device, &pending](std::size_t max_pending) {
+			while (pending.size() > max_pending)
+			{
+				auto& row = pending.front();
+				writeData(device, makeSymbolRow(*row.symbol, row.icon_png.get()).toUtf8());
+				pending.pop_front();
+			}
+		};
+		map.applyOnAllSymbols([this, &pending, &write_rows, max_in_flight](const Symbol* s){
+			pending.push_back({s, startSymbolIcon(*s)});
+			write_rows(max_in_flight);
 		});
-		return QString::fromLatin1(
-		           "<h2>%1</h2>\n"
-		           "<table class=\"symbols\">\n"
-		           "<tbody>\n"
-		           "%2"
-		           "</tbody>\n"
-		           "</table>\n"
-		           ).arg(
-		        QCoreApplication::translate("OpenOrienteering::SymbolReport", "Symbols"),
-		        symbol_data );
+		write_rows(0);
+		
+		writeData(device, QByteArrayLiteral(
+		                 "</tbody>\n"
+		                 "</table>\n" ));
 	}
 	
 public:
@@ -255,9 +318,9 @@ public:
 	: map(map)
 	{}
 	
-	QString generate()
+	bool write(QIODevice& device)
 	{
-		return QString::fromLatin1(
+		auto const parts = QString::fromLatin1(
 		           "<!DOCTYPE html>\n"
 		           "<html>\n"
 		           "<head>\n"
@@ -276,20 +339,34 @@ public:
 		           "<body>\n"
 		           "<h1>%0</h1>\n"
 		           "%1"
-		           "%2"
+		           "\x01"  // symbols
 		           "</body>\n"
 		           "</html>"
 		           ).arg(
 		        QCoreApplication::translate("OpenOrienteering::SymbolReport", "Symbol Set Report on '%0'").arg(map.symbolSetId()),
-		        makeColorSection(),
-		        makeSymbolSection() );
+		        makeColorSection() ).split(QChar(1));
+		Q_ASSERT(parts.size() == 2);
+		
+		writeData(device, parts.front().toUtf8());
+		writeSymbolSection(device);
+		writeData(device, parts.back().toUtf8());
+		return !write_failed;
 	}
 };
 
 
 QString makeHTMLSymbolReport(const Map& map)
 {
-	return HTMLSymbolReportGenerator(map).generate();
+	QByteArray report;
+	QBuffer buffer(&report);
+	buffer.open(QIODevice::WriteOnly);
+	HTMLSymbolReportGenerator(map).write(buffer);
+	return QString::fromUtf8(report);
+}
+
+bool writeHTMLSymbolReport(const Map& map, QIODevice& device)
+{
+	return HTMLSymbolReportGenerator(map).write(device);
 }
 
 }  // namespace OpenOrienteering
@@ -20,6 +20,7 @@
 #ifndef OPENORIENTEERING_HTML_SYMBOL_REPORT_H
 #define OPENORIENTEERING_HTML_SYMBOL_REPORT_H
 
+class QIODevice;
 class QString;
 
 namespace OpenOrienteering {
@@ -31,6 +32,15 @@ class Map;
  */
 QString makeHTMLSymbolReport(const Map& map);
 
+/**
+ * Writes a symbol set report in HTML format to the given device.
+ * 
+ * The report is written while it is generated, and the symbol icons are
+ * encoded concurrently.
+ * Returns false if writing to the device failed.
+ */
+bool writeHTMLSymbolReport(const Map& map, QIODevice& device);
+
 }  // namespace OpenOrienteering
 
 #endif  // OPENORIENTEERING_HTML_SYMBOL_REPORT_H
@@ -23,15 +23,20 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <QtNumeric>
 #include <QCoreApplication>
 #include <QLatin1String>
 #include <QStringRef>
+#include <QThreadStorage>
 #include <QXmlStreamAttributes>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -57,6 +62,80 @@ namespace OpenOrienteering {
 using length_type = PathCoord::length_type;
 
 
+namespace {
+
+/**
+ * A cache of shifted bezier curves.
+ * 
+ * Shifting a bezier curve is expensive. When an object is edited, most of its
+ * curves keep their control points, so that only the curves next to changed
+ * coordinates need to be shifted again.
+ * 
+ * Renderables are created concurrently, so there is one cache per thread.
+ */
+class ShiftedCurveCache
+{
+public:
+	/**
+	 * Returns the curves which approximate the given curve shifted by offset,
+	 * as returned by QBezier::shifted().
+	 */
+	const std::vector<QBezier>& shifted(const QBezier& bezier, qreal offset, float threshold)
+	{
+		Key key { { bezier.x1, bezier.y1, bezier.x2, bezier.y2, bezier.x3, bezier.y3, bezier.x4, bezier.y4, offset, threshold } };
+		auto entry = entries.find(key);
+		if (entry != entries.end())
+			return entry->second;
+		
+		if (entries.size() >= max_entries)
+			entries.clear();
+		
+		QBezier curves[max_curves];
+		auto count = bezier.shifted(curves, max_curves, offset, threshold);
+		auto& result = entries[key];
+		result.assign(curves, curves + std::max(0, count));
+		return result;
+	}
+	
+	static ShiftedCurveCache& forCurrentThread()
+	{
+		static QThreadStorage<ShiftedCurveCache> caches;
+		return caches.localData();
+	}
+	
+	static constexpr int max_curves = 16;
+	
+private:
+	static constexpr std::size_t max_entries = 4096;
+	
+	struct Key
+	{
+		qreal values[10];
+		
+		bool operator==(const Key& other) const
+		{
+			return std::equal(std::begin(values), std::end(values), std::begin(other.values));
+		}
+	};
+	
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const noexcept
+		{
+			auto seed = std::size_t(0);
+			for (auto value : key.values)
+				seed ^= std::hash<qreal>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			return seed;
+		}
+	};
+	
+	std::unordered_map<Key, std::vector<QBezier>, KeyHash> entries;
+};
+
+}  // namespace
+
+
+
 // ### LineSymbolBorder ###
 
 void LineSymbolBorder::save(QXmlStreamWriter& xml, const Map& map) const
@@ -306,7 +385,7 @@ void LineSymbol::createSinglePathRenderables(const VirtualPath& path, bool path_
 		// This is a simple plain line (no pointed line ends, no dashes).
 		// It may be drawn directly from the given path.
 		if (create_line)
-			output.insertRenderable(new LineRenderable(this, path, path_closed));
+			output.insertRenderable(new (output) LineRenderable(this, path, path_closed));
 		
 		auto create_mid_symbols = mid_symbol && !mid_symbol->isEmpty() && segment_length > 0;
 		if (create_mid_symbols || create_border)
@@ -406,7 +485,7 @@ void LineSymbol::createSinglePathRenderables(const VirtualPath& path, bool path_
 		processed_path.path_coords.update(processed_path.first_index);
 		if (create_line)
 		{
-			output.insertRenderable(new LineRenderable(this, processed_path, path_closed));
+			output.insertRenderable(new (output) LineRenderable(this, processed_path, path_closed));
 		}
 		if (create_border)
 		{
@@ -459,7 +538,7 @@ void LineSymbol::createBorderLines(
 		auto border_path = VirtualPath{border_flags, border_coords};
 		auto last = border_path.path_coords.update(0);
 		Q_ASSERT(last+1 == border_coords.size()); Q_UNUSED(last);
-		output.insertRenderable(new LineRenderable(&border_symbol, border_path, path_closed));
+		output.insertRenderable(new (output) LineRenderable(&border_symbol, border_path, path_closed));
 	}
 		
 	if (right_border.isVisible())
@@ -489,16 +568,33 @@ void LineSymbol::createBorderLines(
 		auto border_path = VirtualPath{border_flags, border_coords};
 		auto last = border_path.path_coords.update(0);
 		Q_ASSERT(last+1 == border_coords.size()); Q_UNUSED(last);
-		output.insertRenderable(new LineRenderable(&border_symbol, border_path, path_closed));
+		output.insertRenderable(new (output) LineRenderable(&border_symbol, border_path, path_closed));
 	}
 }
 
 
 void LineSymbol::shiftCoordinates(const VirtualPath& path, double main_shift, double border_shift, LineSymbol::JoinStyle join_style, MapCoordVector& out_flags, MapCoordVectorF& out_coords)
+{
+	// Other parts of a combined symbol may have shifted the same path already.
+	auto* shifted_paths = ShiftedPathCache::current();
+	auto const part_index = shifted_paths ? shifted_paths->partIndex(path) : -1;
+	if (part_index >= 0)
+	{
+		if (shifted_paths->restore(part_index, main_shift, border_shift, join_style, out_flags, out_coords))
+			return;
+		shiftCoordinatesImpl(path, main_shift, border_shift, join_style, out_flags, out_coords);
+		shifted_paths->store(part_index, main_shift, border_shift, join_style, out_flags, out_coords);
+		return;
+	}
+	
+	shiftCoordinatesImpl(path, main_shift, border_shift, join_style, out_flags, out_coords);
+}
+
+
+void LineSymbol::shiftCoordinatesImpl(const VirtualPath& path, double main_shift, double border_shift, LineSymbol::JoinStyle join_style, MapCoordVector& out_flags, MapCoordVectorF& out_coords)
 {
 	const float curve_threshold = 0.03f;	// TODO: decrease for export/print?
-	const int MAX_OFFSET = 16;
-	QBezier offsetCurves[MAX_OFFSET];
+	auto& shifted_curves = ShiftedCurveCache::forCurrentThread();
 	
 	double miter_limit = 2.0 * miterLimit(); // needed more than once
 	if (miter_limit <= 0.0)
@@ -727,7 +823,8 @@ void LineSymbol::shiftCoordinates(const VirtualPath& path, double main_shift, do
 			if (shift > 0.0)
 			{
 				QBezier bezier = QBezier::fromPoints(path.coords[i+3], path.coords[i+2], path.coords[i+1], coords_i);
-				auto count = bezier.shifted(offsetCurves, MAX_OFFSET, qAbs(shift), curve_threshold);
+				const auto& offsetCurves = shifted_curves.shifted(bezier, qAbs(shift), curve_threshold);
+				auto count = int(offsetCurves.size());
 				for (auto j = count - 1; j >= 0; --j)
 				{
 					out_flags.back().setCurveStart(true);
@@ -748,7 +845,8 @@ void LineSymbol::shiftCoordinates(const VirtualPath& path, double main_shift, do
 			else
 			{
 				QBezier bezier = QBezier::fromPoints(path.coords[i], path.coords[i+1], path.coords[i+2], path.coords[i+3]);
-				int count = bezier.shifted(offsetCurves, MAX_OFFSET, qAbs(shift), curve_threshold);
+				const auto& offsetCurves = shifted_curves.shifted(bezier, qAbs(shift), curve_threshold);
+				auto count = int(offsetCurves.size());
 				for (int j = 0; j < count; ++j)
 				{
 					out_flags.back().setCurveStart(true);
@@ -994,7 +1092,7 @@ void LineSymbol::createPointedLineCap(
 	
 	VirtualPath cap_path { cap_flags, cap_coords };
 	cap_path.path_coords.update(0);
-	output.insertRenderable(new AreaRenderable(&area_symbol, cap_path));
+	output.insertRenderable(new (output) AreaRenderable(&area_symbol, cap_path));
 }
 
 void LineSymbol::processDashedLine(
@@ -2085,4 +2183,73 @@ bool LineSymbol::equalsImpl(const Symbol* other, Qt::CaseSensitivity case_sensit
 }
 
 
+
+
+// ### ShiftedPathCache ###
+
+namespace {
+
+thread_local ShiftedPathCache* current_shifted_path_cache = nullptr;
+
+}  // namespace
+
+
+ShiftedPathCache::ShiftedPathCache(const PathPartVector& path_parts)
+: path_parts(path_parts)
+, previous(current_shifted_path_cache)
+{
+	current_shifted_path_cache = this;
+}
+
+ShiftedPathCache::~ShiftedPathCache()
+{
+	Q_ASSERT(current_shifted_path_cache == this);
+	current_shifted_path_cache = previous;
+}
+
+
+// static
+ShiftedPathCache* ShiftedPathCache::current() noexcept
+{
+	return current_shifted_path_cache;
+}
+
+
+int ShiftedPathCache::partIndex(const VirtualPath& path) const noexcept
+{
+	// Paths created during rendering, e.g. for dashes, are never registered.
+	for (std::size_t i = 0; i < path_parts.size(); ++i)
+	{
+		if (&path == &path_parts[i])
+			return int(i);
+	}
+	return -1;
+}
+
+
+bool ShiftedPathCache::restore(int part_index, double main_shift, double border_shift, LineSymbol::JoinStyle join_style,
+                               MapCoordVector& out_flags, MapCoordVectorF& out_coords) const
+{
+	auto const entry = std::find_if(begin(entries), end(entries), [&](const Entry& e) {
+		return e.part_index == part_index
+		       && e.main_shift == main_shift
+		       && e.border_shift == border_shift
+		       && e.join_style == join_style;
+	});
+	if (entry == end(entries))
+		return false;
+	
+	out_flags = entry->flags;
+	out_coords = entry->coords;
+	return true;
+}
+
+
+void ShiftedPathCache::store(int part_index, double main_shift, double border_shift, LineSymbol::JoinStyle join_style,
+                             const MapCoordVector& flags, const MapCoordVectorF& coords)
+{
+	entries.push_back({ part_index, main_shift, border_shift, join_style, flags, coords });
+}
+
+
 }  // namespace OpenOrienteering
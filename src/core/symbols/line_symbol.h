@@ -316,6 +316,19 @@ public:
 	);
 	
 protected:
+	/**
+	 * Implements shiftCoordinates(), without using a ShiftedPathCache.
+	 */
+	static void shiftCoordinatesImpl(
+	        const VirtualPath& path,
+	        double main_shift,
+	        double border_shift,
+	        LineSymbol::JoinStyle join_style,
+	        MapCoordVector& out_flags,
+	        MapCoordVectorF& out_coords
+	);
+	
+
 	void shiftCoordinatesLeft(
 	        const VirtualPath& path,
 	        MapCoordVector& out_flags,
@@ -482,6 +495,83 @@ protected:
 };
 
 
+
+/**
+ * A cache of shifted path parts, shared by the parts of a combined symbol.
+ * 
+ * The parts of a combined symbol create their renderables from the same path
+ * parts. Double lines and framed lines often shift these paths by the same
+ * distances, with the same join style. While an object of this class exists,
+ * LineSymbol::shiftCoordinates() keeps its results for the registered path
+ * parts on the current thread, and returns them again for the same shift.
+ * 
+ * Objects of this class are meant to be created on the stack, for the
+ * duration of a single call to Symbol::createRenderables().
+ */
+class ShiftedPathCache
+{
+public:
+	/**
+	 * Registers the path parts, and makes this cache the current one
+	 * for the current thread.
+	 */
+	explicit ShiftedPathCache(const PathPartVector& path_parts);
+	
+	ShiftedPathCache(const ShiftedPathCache&) = delete;
+	ShiftedPathCache(ShiftedPathCache&&) = delete;
+	
+	/**
+	 * Restores the previous cache of the current thread.
+	 */
+	~ShiftedPathCache();
+	
+	ShiftedPathCache& operator=(const ShiftedPathCache&) = delete;
+	ShiftedPathCache& operator=(ShiftedPathCache&&) = delete;
+	
+	
+	/**
+	 * Returns the current cache of the current thread, or nullptr.
+	 */
+	static ShiftedPathCache* current() noexcept;
+	
+	/**
+	 * Returns the index of the given path in the registered path parts,
+	 * or -1 if it is not one of these parts.
+	 */
+	int partIndex(const VirtualPath& path) const noexcept;
+	
+	/**
+	 * Copies a cached result to out_flags and out_coords.
+	 * 
+	 * Returns false if no result is cached for the parameters.
+	 */
+	bool restore(int part_index, double main_shift, double border_shift, LineSymbol::JoinStyle join_style,
+	             MapCoordVector& out_flags, MapCoordVectorF& out_coords) const;
+	
+	/**
+	 * Stores a result for the parameters.
+	 */
+	void store(int part_index, double main_shift, double border_shift, LineSymbol::JoinStyle join_style,
+	           const MapCoordVector& flags, const MapCoordVectorF& coords);
+	
+private:
+	struct Entry
+	{
+		int part_index;
+		double main_shift;
+		double border_shift;
+		LineSymbol::JoinStyle join_style;
+		MapCoordVector flags;
+		MapCoordVectorF coords;
+	};
+	
+	const PathPartVector& path_parts;
+	ShiftedPathCache* const previous;
+	std::vector<Entry> entries;
+	
+};
+
+
 }  // namespace OpenOrienteering
 
 #endif // OPENORIENTEERING_LINE_SYMBOL_H
@@ -55,6 +55,41 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The innermost sharing scope of the current thread
+thread_local PointSymbol::SharedElements* shared_elements = nullptr;
+
+}  // namespace
+
+
+
+// ### PointSymbol::SharedElements ###
+
+struct PointSymbol::SharedElements::Prototype
+{
+	QRectF extent;
+	ObjectRenderables renderables { extent };
+	bool shareable = false;
+};
+
+
+PointSymbol::SharedElements::SharedElements()
+: previous { shared_elements }
+{
+	shared_elements = this;
+}
+
+
+PointSymbol::SharedElements::~SharedElements()
+{
+	shared_elements = previous;
+}
+
+
+
+// ### PointSymbol ###
+
 PointSymbol::PointSymbol() noexcept
 : Symbol { Symbol::Point }
 , inner_color { nullptr }
@@ -134,45 +169,69 @@ void PointSymbol::createRenderables(
 void PointSymbol::createRenderablesScaled(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale) const
 {
 	if (inner_color && inner_radius > 0)
-		output.insertRenderable(new DotRenderable(this, coord));
+		output.insertRenderable(new (output) DotRenderable(this, coord));
 	if (outer_color && outer_width > 0)
-		output.insertRenderable(new CircleRenderable(this, coord));
+		output.insertRenderable(new (output) CircleRenderable(this, coord));
 	
 	if (!elements.empty())
 	{
-		auto offset_x = coord.x();
-		auto offset_y = coord.y();
-		auto cosr = 1.0;
-		auto sinr = 0.0;
-		if (!qIsNull(rotation))
-		{
-			cosr = cos(rotation);
-			sinr = sin(rotation);
-		}
+		if (auto const* prototype = sharedElementRenderables(coord_scale))
+			output.insertInstances(*prototype, coord, rotation);
+		else
+			createElementRenderables(coord, rotation, output, coord_scale);
+	}
+}
+
+void PointSymbol::createElementRenderables(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale) const
+{
+	auto offset_x = coord.x();
+	auto offset_y = coord.y();
+	auto cosr = 1.0;
+	auto sinr = 0.0;
+	if (!qIsNull(rotation))
+	{
+		cosr = cos(rotation);
+		sinr = sin(rotation);
+	}
+	
+	for (auto& element : elements)
+	{
+		// Point symbol elements should not be entered into the map,
+		// otherwise map settings like area hatching affect them
+		Q_ASSERT(!element.object->getMap());
 		
-		for (auto& element : elements)
+		const MapCoordVector& object_coords = element.object->getRawCoordinateVector();
+		
+		MapCoordVectorF transformed_coords;
+		transformed_coords.reserve(object_coords.size());
+		for (auto& coord : object_coords)
 		{
-			// Point symbol elements should not be entered into the map,
-			// otherwise map settings like area hatching affect them
-			Q_ASSERT(!element.object->getMap());
-			
-			const MapCoordVector& object_coords = element.object->getRawCoordinateVector();
-			
-			MapCoordVectorF transformed_coords;
-			transformed_coords.reserve(object_coords.size());
-			for (auto& coord : object_coords)
-			{
-				auto ox = coord_scale * coord.x();
-				auto oy = coord_scale * coord.y();
-				transformed_coords.emplace_back(ox * cosr - oy * sinr + offset_x,
-				                                oy * cosr + ox * sinr + offset_y);
-			}
-			
-			// TODO: if this point is rotated, it has to pass it on to its children to make it work that rotatable point objects can be children.
-			// But currently only basic, rotationally symmetric points can be children, so it does not matter for now.
-			element.symbol->createRenderables(element.object.get(), VirtualCoordVector(object_coords, transformed_coords), output, Symbol::RenderNormal);
+			auto ox = coord_scale * coord.x();
+			auto oy = coord_scale * coord.y();
+			transformed_coords.emplace_back(ox * cosr - oy * sinr + offset_x,
+			                                oy * cosr + ox * sinr + offset_y);
 		}
+		
+		// TODO: if this point is rotated, it has to pass it on to its children to make it work that rotatable point objects can be children.
+		// But currently only basic, rotationally symmetric points can be children, so it does not matter for now.
+		element.symbol->createRenderables(element.object.get(), VirtualCoordVector(object_coords, transformed_coords), output, Symbol::RenderNormal);
+	}
+}
+
+const ObjectRenderables* PointSymbol::sharedElementRenderables(qreal coord_scale) const
+{
+	if (!shared_elements)
+		return nullptr;
+	
+	auto& prototype = shared_elements->prototypes[{ this, coord_scale }];
+	if (!prototype)
+	{
+		prototype = std::make_unique<SharedElements::Prototype>();
+		createElementRenderables({}, 0, prototype->renderables, coord_scale);
+		// Clip paths cannot be moved with the instances.
+		prototype->shareable = !prototype->renderables.hasClipPaths();
 	}
+	return prototype->shareable ? &prototype->renderables : nullptr;
 }
 
 
@@ -182,12 +241,12 @@ void PointSymbol::createRenderablesIfCenterInside(const MapCoordF& point_coord,
 	{
 		if (inner_color && inner_radius > 0)
 		{
-			output.insertRenderable(new DotRenderable(this, point_coord));
+			output.insertRenderable(new (output) DotRenderable(this, point_coord));
 		}
 		
 		if (outer_color && outer_width > 0)
 		{
-			output.insertRenderable(new CircleRenderable(this, point_coord));
+			output.insertRenderable(new (output) CircleRenderable(this, point_coord));
 		}
 	}
 	
@@ -245,7 +304,7 @@ void PointSymbol::createPrimitivesIfCompletelyInside(const MapCoordF& point_coor
 		    && outline->contains({point_coord.x()+r, point_coord.y()})
 		    && outline->contains({point_coord.x(), point_coord.y()+r}) )
 		{
-			output.insertRenderable(new DotRenderable(this, point_coord));
+			output.insertRenderable(new (output) DotRenderable(this, point_coord));
 		}
 	}
 	
@@ -257,7 +316,7 @@ void PointSymbol::createPrimitivesIfCompletelyInside(const MapCoordF& point_coor
 		    && outline->contains({point_coord.x()+r, point_coord.y()})
 		    && outline->contains({point_coord.x(), point_coord.y()+r}) )
 		{
-			output.insertRenderable(new CircleRenderable(this, point_coord));
+			output.insertRenderable(new (output) CircleRenderable(this, point_coord));
 		}
 	}
 }
@@ -332,7 +391,7 @@ void PointSymbol::createPrimitivesIfPartiallyInside(const MapCoordF& point_coord
 		    || outline->contains({point_coord.x()+r, point_coord.y()})
 		    || outline->contains({point_coord.x(), point_coord.y()+r}) )
 		{
-			output.insertRenderable(new DotRenderable(this, point_coord));
+			output.insertRenderable(new (output) DotRenderable(this, point_coord));
 		}
 	}
 	
@@ -344,7 +403,7 @@ void PointSymbol::createPrimitivesIfPartiallyInside(const MapCoordF& point_coord
 		    || outline->contains({point_coord.x()+r, point_coord.y()})
 		    || outline->contains({point_coord.x(), point_coord.y()+r}) )
 		{
-			output.insertRenderable(new CircleRenderable(this, point_coord));
+			output.insertRenderable(new (output) CircleRenderable(this, point_coord));
 		}
 	}
 }
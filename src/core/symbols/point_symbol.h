@@ -22,7 +22,9 @@
 #ifndef OPENORIENTEERING_POINT_SYMBOL_H
 #define OPENORIENTEERING_POINT_SYMBOL_H
 
+#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <Qt>
@@ -64,6 +66,30 @@ friend class PointSymbolSettings;
 friend class PointSymbolEditorWidget;
 friend class XMLImportExport;
 public:
+	/**
+	 * Enables the sharing of element renderables on the current thread.
+	 * 
+	 * While an object of this class exists, createRenderablesScaled() creates
+	 * the renderables of the elements only once per symbol and scale. Each
+	 * placement of the symbol adds instances of these renderables which store
+	 * only the position and rotation. Symbols must not be modified during the
+	 * lifetime of this object.
+	 */
+	class SharedElements
+	{
+	friend class PointSymbol;
+	public:
+		SharedElements();
+		SharedElements(const SharedElements&) = delete;
+		SharedElements& operator=(const SharedElements&) = delete;
+		~SharedElements();
+		
+	private:
+		struct Prototype;
+		std::map<std::pair<const PointSymbol*, qreal>, std::unique_ptr<Prototype>> prototypes;
+		SharedElements* const previous;
+	};
+	
 	/** Constructs an empty point symbol. */
 	PointSymbol() noexcept;
 	~PointSymbol() override;
@@ -145,6 +171,17 @@ protected:
 	bool loadImpl(QXmlStreamReader& xml, const Map& map, SymbolDictionary& symbol_dict, int version) override;
 	bool equalsImpl(const Symbol* other, Qt::CaseSensitivity case_sensitivity) const override;
 	
+	/**
+	 * Creates the renderables of the elements at the given position.
+	 */
+	void createElementRenderables(const MapCoordF& coord, qreal rotation, ObjectRenderables& output, qreal coord_scale) const;
+	
+	/**
+	 * Returns the shared renderables of the elements at the origin,
+	 * or nullptr if the elements cannot be shared on the current thread.
+	 */
+	const ObjectRenderables* sharedElementRenderables(qreal coord_scale) const;
+	
 	
 	/// \todo Expose elements more directly in PointSymbol API.
 	struct Element
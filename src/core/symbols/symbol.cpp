@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020, 2022, 2024 Kai Pastor
+ *    Copyright 2012-2020, 2022, 2024, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -31,6 +31,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QChar>
+#include <QHash>
 #include <QImageReader>
 #include <QImageWriter>
 #include <QLatin1Char>
@@ -117,6 +118,22 @@ bool Symbol::equals(const Symbol* other, Qt::CaseSensitivity case_sensitivity) c
 }
 
 
+uint Symbol::hash() const
+{
+	auto seed = qHash(int(type));
+	seed = qHash(int(is_helper_symbol) + 2 * int(is_rotatable), seed * 31);
+	// Like numberEquals(), ignore the components after the first -1.
+	for (auto component : number)
+	{
+		seed = qHash(component, seed * 31);
+		if (component == -1)
+			break;
+	}
+	// Names are compared case-insensitively when merging symbols.
+	return qHash(name.toCaseFolded(), seed);
+}
+
+
 bool Symbol::stateEquals(const Symbol* other) const
 {
 	return is_hidden == other->is_hidden
@@ -435,7 +452,7 @@ void Symbol::createBaselineRenderables(
 		line_symbol.setLineWidth(0);
 		for (const auto& part : path_parts)
 		{
-			output.insertRenderable(new LineRenderable(&line_symbol, part, false));
+			output.insertRenderable(new (output) LineRenderable(&line_symbol, part, false));
 		}
 	}
 }
@@ -476,6 +493,15 @@ QImage Symbol::getIcon(const Map* map) const
 	return icon;
 }
 
+std::size_t Symbol::iconMemoryUsage() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return std::size_t(icon.sizeInBytes()) + std::size_t(custom_icon.sizeInBytes());
+#else
+	return std::size_t(icon.byteCount()) + std::size_t(custom_icon.byteCount());
+#endif
+}
+
 
 QImage Symbol::createIcon(const Map& map, int side_length, bool antialiasing, qreal zoom) const
 {
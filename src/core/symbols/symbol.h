@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020, 2024, 2025 Kai Pastor
+ *    Copyright 2012-2020, 2024-2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -162,6 +162,16 @@ public:
 	 */
 	bool equals(const Symbol* other, Qt::CaseSensitivity case_sensitivity = Qt::CaseSensitive) const;
 	
+	/**
+	 * Returns a hash value which is consistent with equals().
+	 * 
+	 * The value covers the properties which are common to all symbol types.
+	 * Symbols which are equal, either case-sensitive or case-insensitive,
+	 * have the same hash value, so it can be used to find candidates for
+	 * equals() without comparing the type-specific properties.
+	 */
+	uint hash() const;
+	
 	/**
 	 * Checks protected/hidden state for equality to the other symbol.
 	 */
@@ -371,6 +381,27 @@ public:
 	 */
 	QImage getIcon(const Map* map) const;
 	
+	/**
+	 * Sets the symbol's cached icon.
+	 * 
+	 * This is meant for restoring an icon which was created by getIcon()
+	 * for the same symbol definition and settings, e.g. from a disk cache.
+	 */
+	void setIcon(const QImage& image) const { icon = image; }
+	
+	/**
+	 * Returns true if the symbol's icon is cached.
+	 * 
+	 * When this function returns true, getIcon() is cheap.
+	 */
+	bool hasIcon() const { return !icon.isNull(); }
+	
+	/**
+	 * Returns the amount of memory held by the cached icon and by the custom
+	 * icon, in bytes.
+	 */
+	std::size_t iconMemoryUsage() const;
+	
 	/**
 	 * Creates a symbol icon with the given side length (pixels).
 	 * 
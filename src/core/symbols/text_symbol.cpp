@@ -21,6 +21,7 @@
 
 #include "text_symbol.h"
 
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <memory>
@@ -97,6 +98,7 @@ TextSymbol::TextSymbol(const TextSymbol& proto)
 , line_below_color { proto.line_below_color }
 , custom_tabs { proto.custom_tabs }
 , tab_interval { proto.tab_interval }
+, layout_revision { proto.layout_revision }
 , line_spacing { proto.line_spacing }
 , character_spacing { proto.character_spacing }
 , font_size { proto.font_size }
@@ -150,7 +152,7 @@ void TextSymbol::createRenderables(
 		double anchor_y = anchor.y();
 		
 		if (color)
-			output.insertRenderable(new TextRenderable(this, text_object, color, anchor_x, anchor_y));
+			output.insertRenderable(new (output) TextRenderable(this, text_object, color, anchor_x, anchor_y));
 		
 		if (line_below && line_below_color && line_below_width > 0)
 			createLineBelowRenderables(object, output);
@@ -159,11 +161,11 @@ void TextSymbol::createRenderables(
 		{
 			if (framing_mode == LineFraming && framing_line_half_width > 0)
 			{
-				output.insertRenderable(new TextFramingRenderable(this, text_object, framing_color, anchor_x, anchor_y));
+				output.insertRenderable(new (output) TextFramingRenderable(this, text_object, framing_color, anchor_x, anchor_y));
 			}
 			else if (framing_mode == ShadowFraming)
 			{
-				output.insertRenderable(new TextRenderable(this, text_object, framing_color, anchor_x + 0.001 * framing_shadow_x_offset, anchor_y + 0.001 * framing_shadow_y_offset));
+				output.insertRenderable(new (output) TextRenderable(this, text_object, framing_color, anchor_x + 0.001 * framing_shadow_x_offset, anchor_y + 0.001 * framing_shadow_y_offset));
 			}
 		}
 	}
@@ -200,7 +202,7 @@ void TextSymbol::createBaselineRenderables(
 		path.parts().front().setClosed(true, true);
 		path.updatePathCoords();
 		
-		auto line_renderable = new LineRenderable(&line_symbol, path.parts().front(), false);
+		auto line_renderable = new (output) LineRenderable(&line_symbol, path.parts().front(), false);
 		output.insertRenderable(line_renderable);
 	}
 }
@@ -248,7 +250,7 @@ void TextSymbol::createLineBelowRenderables(const Object* object, ObjectRenderab
 			line_coords[3] = MapCoordF(transform.map(QPointF(line_below_x0, line_below_y1)));
 			
 			line_path.path_coords.update(0);
-			output.insertRenderable(new AreaRenderable(&area_symbol, line_path));
+			output.insertRenderable(new (output) AreaRenderable(&area_symbol, line_path));
 		}
 	}
 }
@@ -330,6 +332,9 @@ void TextSymbol::updateQFont()
 
 	metrics = QFontMetricsF(qfont);
 	tab_interval = 8.0 * metrics.averageCharWidth();
+	
+	static std::atomic<quint64> last_layout_revision { 0 };
+	layout_revision = ++last_layout_revision;
 }
 
 
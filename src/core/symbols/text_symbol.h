@@ -26,6 +26,7 @@
 
 #include <vector>
 
+#include <QtGlobal>
 #include <Qt>
 #include <QFont>
 #include <QFontMetricsF>
@@ -108,7 +109,11 @@ public:
 	void replaceColors(const MapColorMap& color_map) override;
 	void scale(double factor) override;
 	
-	/** Updates the internal QFont from the font settings. */
+	/**
+	 * Updates the internal QFont from the font settings.
+	 * 
+	 * This must be called after any change which affects the text layout.
+	 */
 	void updateQFont();
 	
 	/** Calculates the factor to convert from the real font size to the internal font size */
@@ -142,6 +147,14 @@ public:
 	inline const QFont& getQFont() const {return qfont;}
 	inline const QFontMetricsF& getFontMetrics() const { return metrics; }
 	
+	/**
+	 * Returns a number which identifies the current layout settings.
+	 * 
+	 * The number changes whenever updateQFont() is called. Symbols with
+	 * equal numbers have equal layout settings.
+	 */
+	inline quint64 getLayoutRevision() const { return layout_revision; }
+	
 	double getNextTab(double pos) const;
 	
 	constexpr static qreal internal_point_size = 256;
@@ -168,6 +181,7 @@ protected:
 	std::vector<int> custom_tabs;
 	
 	double tab_interval;		/// default tab interval length in text coordinates
+	quint64 layout_revision;	/// identifies the layout settings, cf. getLayoutRevision()
 	float line_spacing;			// as factor of original line spacing
 	float character_spacing;	// as a factor of the space character width
 	int font_size;				// this defines the font size in 1000 mm. How big the letters really are depends on the design of the font though
@@ -21,6 +21,9 @@
 
 #include "track.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 #include <memory>
 
 #include <Qt>
@@ -46,6 +49,31 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The value which marks an invalid time in TrackPointList.
+constexpr auto invalid_time = std::numeric_limits<qint64>::min();
+
+/// The number of track points which are projected together while loading.
+constexpr TrackPointList::size_type projection_batch_size = 4096;
+
+/// Updates the map coordinates of the points in a single projection call.
+void projectTrackPoints(std::vector<TrackPoint>& points, const Georeferencing& georef)
+{
+	std::vector<LatLon> lat_lon;
+	lat_lon.reserve(points.size());
+	for (auto const& point : points)
+		lat_lon.push_back(point.latlon);
+	auto const map_coords = georef.toMapCoordF(lat_lon, nullptr);
+	for (std::size_t i = 0; i < points.size(); ++i)
+		points[i].map_coord = map_coords[i];
+}
+
+
+}  // namespace
+
+
+
 // ### TrackPoint ###
 
 void TrackPoint::save(QXmlStreamWriter* stream) const
@@ -76,6 +104,70 @@ bool operator==(const TrackPoint& lhs, const TrackPoint& rhs)
 
 
 
+// ### TrackPointList ###
+
+void TrackPointList::clear()
+{
+	latlon.clear();
+	time.clear();
+	elevation.clear();
+	hdop.clear();
+	map_coords.clear();
+}
+
+void TrackPointList::reserve(size_type size)
+{
+	latlon.reserve(size);
+	time.reserve(size);
+	elevation.reserve(size);
+	hdop.reserve(size);
+	map_coords.reserve(size);
+}
+
+void TrackPointList::push_back(const TrackPoint& point)
+{
+	latlon.push_back(point.latlon);
+	time.push_back(point.datetime.isValid() ? point.datetime.toMSecsSinceEpoch() : invalid_time);
+	elevation.push_back(point.elevation);
+	hdop.push_back(point.hDOP);
+	map_coords.push_back(point.map_coord);
+}
+
+TrackPoint TrackPointList::operator[](size_type index) const
+{
+	auto const msecs = time[index];
+	return { latlon[index],
+	         msecs == invalid_time ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC),
+	         elevation[index],
+	         hdop[index],
+	         map_coords[index] };
+}
+
+void TrackPointList::project(const Georeferencing& georef, size_type first)
+{
+	if (first >= size())
+		return;
+	
+	auto const lat_lon = std::vector<LatLon>(latlon.begin() + std::ptrdiff_t(first), latlon.end());
+	auto const projected = georef.toMapCoordF(lat_lon, nullptr);
+	std::copy(projected.begin(), projected.end(), map_coords.begin() + std::ptrdiff_t(first));
+}
+
+bool operator==(const TrackPointList& lhs, const TrackPointList& rhs)
+{
+	if (lhs.size() != rhs.size())
+		return false;
+	
+	for (TrackPointList::size_type i = 0; i < lhs.size(); ++i)
+	{
+		if (lhs[i] != rhs[i])
+			return false;
+	}
+	return true;
+}
+
+
+
 // ### Track ###
 
 Track::Track(const Georeferencing& map_georef)
@@ -108,6 +200,7 @@ Track& Track::operator=(const Track& rhs)
 	
 	map_georef = rhs.map_georef;
 	
+	++current_revision;
 	return *this;
 }
 
@@ -118,6 +211,7 @@ void Track::clear()
 	segment_points.clear();
 	segment_starts.clear();
 	current_segment_finished = true;
+	++current_revision;
 }
 
 bool Track::loadFrom(const QString& path, bool project_points)
@@ -208,14 +302,16 @@ bool Track::saveGpxTo(QIODevice& device) const
 
 void Track::appendTrackPoint(const TrackPoint& point)
 {
-	segment_points.push_back(point);
-	segment_points.back().map_coord = map_georef.toMapCoordF(point.latlon, nullptr); // TODO: check for errors
+	auto projected_point = point;
+	projected_point.map_coord = map_georef.toMapCoordF(point.latlon, nullptr); // TODO: check for errors
+	segment_points.push_back(projected_point);
 	
 	if (current_segment_finished)
 	{
 		segment_starts.push_back(segment_points.size() - 1);
 		current_segment_finished = false;
 	}
+	++current_revision;
 }
 void Track::finishCurrentSegment()
 {
@@ -234,6 +330,7 @@ void Track::changeMapGeoreferencing(const Georeferencing& new_map_georef)
 	map_georef = new_map_georef;
 	
 	projectPoints();
+	++current_revision;
 }
 
 int Track::getNumSegments() const
@@ -250,12 +347,18 @@ int Track::getSegmentPointCount(int segment_number) const
 		return segment_starts[segment_number + 1] - segment_starts[segment_number];
 }
 
-const TrackPoint& Track::getSegmentPoint(int segment_number, int point_number) const
+TrackPoint Track::getSegmentPoint(int segment_number, int point_number) const
 {
 	Q_ASSERT(segment_number >= 0 && segment_number < (int)segment_starts.size());
 	return segment_points[segment_starts[segment_number] + point_number];
 }
 
+int Track::getSegmentStart(int segment_number) const
+{
+	Q_ASSERT(segment_number >= 0 && segment_number < (int)segment_starts.size());
+	return segment_starts[segment_number];
+}
+
 int Track::getNumWaypoints() const
 {
 	return waypoints.size();
@@ -285,16 +388,11 @@ LatLon Track::calcAveragePosition() const
 		avg_longitude += point.latlon.longitude();
 		++num_samples;
 	}
-	for (int i = 0; i < getNumSegments(); ++i)
+	for (auto const& latlon : segment_points.latLon())
 	{
-		size = getSegmentPointCount(i);
-		for (int k = 0; k < size; ++k)
-		{
-			const TrackPoint& point = getSegmentPoint(i, k);
-			avg_latitude += point.latlon.latitude();
-			avg_longitude += point.latlon.longitude();
-			++num_samples;
-		}
+		avg_latitude += latlon.latitude();
+		avg_longitude += latlon.longitude();
+		++num_samples;
 	}
 	
 	return LatLon((num_samples > 0) ? (avg_latitude / num_samples) : 0,
@@ -305,6 +403,13 @@ bool Track::loadGpxFrom(QIODevice& device, bool project_points)
 {
 	TrackPoint point;
 	QString point_name;
+	
+	// Points are projected in batches while parsing.
+	auto projected = segment_points.size();
+	auto const project_pending = [this, &projected]() {
+		segment_points.project(map_georef, projected);
+		projected = segment_points.size();
+	};
 
 	QXmlStreamReader stream(&device);
 	while (!stream.atEnd())
@@ -318,8 +423,6 @@ bool Track::loadGpxFrom(QIODevice& device, bool project_points)
 			{
 				point = TrackPoint{LatLon{stream.attributes().value(QLatin1String("lat")).toDouble(),
 				                          stream.attributes().value(QLatin1String("lon")).toDouble()}};
-				if (project_points)
-					point.map_coord = map_georef.toMapCoordF(point.latlon); // TODO: check for errors
 				point_name.clear();
 			}
 			else if (stream.name().compare(QLatin1String("trkseg"), Qt::CaseInsensitive) == 0
@@ -351,26 +454,34 @@ bool Track::loadGpxFrom(QIODevice& device, bool project_points)
 			         || stream.name().compare(QLatin1String("rtept"), Qt::CaseInsensitive) == 0)
 			{
 				segment_points.push_back(point);
+				if (project_points && segment_points.size() - projected >= projection_batch_size)
+					project_pending();
 			}
 		}
 	}
 	
+	/// \todo Check for errors from Georeferencing::toMapCoordF()
+	if (project_points)
+	{
+		project_pending();
+		projectTrackPoints(waypoints, map_georef);
+	}
+	
 	if (!segment_starts.empty()
 	    && segment_starts.back() == (int)segment_points.size())
 	{
 		segment_starts.pop_back();
 	}
 	
+	++current_revision;
 	return !stream.hasError();
 }
 
 void Track::projectPoints()
 {
 	/// \todo Check for errors from Georeferencing::toMapCoordF()
-	for (auto& waypoint : waypoints)
-		waypoint.map_coord = map_georef.toMapCoordF(waypoint.latlon, nullptr); 
-	for (auto& segment_point : segment_points)
-		segment_point.map_coord = map_georef.toMapCoordF(segment_point.latlon, nullptr); 
+	projectTrackPoints(waypoints, map_georef);
+	segment_points.project(map_georef);
 }
 
 
@@ -25,6 +25,7 @@
 #include <cmath>
 #include <vector>
 
+#include <QtGlobal>
 #include <QDateTime>
 #include <QString>
 
@@ -62,6 +63,60 @@ inline bool operator!=(const TrackPoint& lhs, const TrackPoint& rhs) { return !(
 
 
 
+/**
+ * A list of track points, stored in a columnar layout.
+ * 
+ * Each attribute is kept in its own contiguous array. This takes much less
+ * memory than a list of TrackPoint for tracks with millions of points, and
+ * it lets the geographic coordinates be projected, and the map coordinates
+ * be drawn, without touching the other attributes.
+ */
+class TrackPointList
+{
+public:
+	using size_type = std::vector<LatLon>::size_type;
+	
+	size_type size() const noexcept { return latlon.size(); }
+	
+	bool empty() const noexcept { return latlon.empty(); }
+	
+	void clear();
+	
+	void reserve(size_type size);
+	
+	/// Appends a point, including its map coordinates.
+	void push_back(const TrackPoint& point);
+	
+	/// Returns the point at the given index.
+	TrackPoint operator[](size_type index) const;
+	
+	/// Returns the geographic coordinates of all points.
+	const std::vector<LatLon>& latLon() const noexcept { return latlon; }
+	
+	/// Returns the map coordinates of all points.
+	const MapCoordVectorF& mapCoords() const noexcept { return map_coords; }
+	
+	/**
+	 * Updates the map coordinates of the points from the given index to the end.
+	 * 
+	 * All these points are projected in a single call.
+	 */
+	void project(const Georeferencing& georef, size_type first = 0);
+	
+private:
+	std::vector<LatLon> latlon;
+	std::vector<qint64> time;       // msecs since epoch, invalid_time when invalid
+	std::vector<float> elevation;   // NaN when invalid
+	std::vector<float> hdop;        // NaN when invalid
+	MapCoordVectorF map_coords;
+};
+
+bool operator==(const TrackPointList& lhs, const TrackPointList& rhs);
+
+inline bool operator!=(const TrackPointList& lhs, const TrackPointList& rhs) { return !(lhs==rhs); }
+
+
+
 /**
  * Stores a set of tracks and / or waypoints, e.g. taken from a GPS device.
  * 
@@ -122,7 +177,19 @@ public:
 	// Getters
 	int getNumSegments() const;
 	int getSegmentPointCount(int segment_number) const;
-	const TrackPoint& getSegmentPoint(int segment_number, int point_number) const;
+	TrackPoint getSegmentPoint(int segment_number, int point_number) const;
+	
+	/// Returns the index of the first point of a segment in segmentPoints().
+	int getSegmentStart(int segment_number) const;
+	/// Returns the points of all segments.
+	const TrackPointList& segmentPoints() const { return segment_points; }
+	
+	/**
+	 * Returns a number which changes whenever the points or segments change.
+	 * 
+	 * This allows users to cache data derived from the track.
+	 */
+	unsigned int revision() const { return current_revision; }
 	
 	int getNumWaypoints() const;
 	const TrackPoint& getWaypoint(int number) const;
@@ -141,12 +208,14 @@ private:
 	std::vector<TrackPoint> waypoints;
 	std::vector<QString> waypoint_names;
 	
-	std::vector<TrackPoint> segment_points;
+	TrackPointList segment_points;
 	// The indices of the first points of every track segment in this track
 	std::vector<int> segment_starts;
 	
 	bool current_segment_finished = true;
 	
+	unsigned int current_revision = 0;
+	
 	Georeferencing map_georef;
 	
 	friend bool operator==(const Track& lhs, const Track& rhs);
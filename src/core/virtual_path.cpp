@@ -21,8 +21,28 @@
 
 #include "virtual_path.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "util/spatial_index.h"
 #include "util/util.h"
 
+#if !defined(QT_COORD_TYPE)  // qreal is double
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define MAPPER_PATH_COORD_SSE2
+#    include <emmintrin.h>
+#  elif defined(__aarch64__) || defined(_M_ARM64)
+#    define MAPPER_PATH_COORD_NEON
+#    include <arm_neon.h>
+#  endif
+#endif
+
 
 namespace OpenOrienteering {
 
@@ -46,6 +66,186 @@ namespace
 	 */
 	const double bezier_segment_maxlen_squared = 1.0;
 	
+	/**
+	 * Global threshold for the deviation from a linear mapping of the curve
+	 * parameter to the length along a segment.
+	 * 
+	 * Segments which are longer than the maximum length above are acceptable
+	 * when the curve parameter is uniform enough along the segment. This
+	 * avoids many path coords for long, gentle curves such as contours.
+	 */
+	const double bezier_parameter_error = 0.05;
+	
+	
+#if defined(MAPPER_PATH_COORD_SSE2) || defined(MAPPER_PATH_COORD_NEON)
+	
+	/*
+	 * Vectors of two doubles, used for processing the x and y of a position
+	 * at the same time, or for processing two positions at the same time.
+	 * The operations match the scalar code, so that the results are identical.
+	 */
+	
+	static_assert(sizeof(MapCoordF) == 2 * sizeof(double), "MapCoordF must hold exactly x and y");
+	
+#  if defined(MAPPER_PATH_COORD_SSE2)
+	
+	using Pair = __m128d;
+	using PairMask = __m128d;
+	
+	inline Pair loadPair(const MapCoordF& pos) { return _mm_loadu_pd(reinterpret_cast<const double*>(&pos)); }
+	inline Pair makePair(double first, double second) { return _mm_set_pd(second, first); }
+	inline void storePair(double* out, Pair v) { _mm_storeu_pd(out, v); }
+	inline Pair minimum(Pair a, Pair b) { return _mm_min_pd(a, b); }
+	inline Pair maximum(Pair a, Pair b) { return _mm_max_pd(a, b); }
+	inline Pair add(Pair a, Pair b) { return _mm_add_pd(a, b); }
+	inline Pair subtract(Pair a, Pair b) { return _mm_sub_pd(a, b); }
+	inline Pair multiply(Pair a, Pair b) { return _mm_mul_pd(a, b); }
+	inline Pair divide(Pair a, Pair b) { return _mm_div_pd(a, b); }
+	/// Returns the first elements of a and b.
+	inline Pair firsts(Pair a, Pair b) { return _mm_unpacklo_pd(a, b); }
+	/// Returns the second elements of a and b.
+	inline Pair seconds(Pair a, Pair b) { return _mm_unpackhi_pd(a, b); }
+	inline PairMask greater(Pair a, Pair b) { return _mm_cmpgt_pd(a, b); }
+	inline PairMask lessEqual(Pair a, Pair b) { return _mm_cmple_pd(a, b); }
+	inline PairMask maskAnd(PairMask a, PairMask b) { return _mm_and_pd(a, b); }
+	inline PairMask maskXor(PairMask a, PairMask b) { return _mm_xor_pd(a, b); }
+	/// Returns the mask as bits, the first element in the lowest bit.
+	inline int maskBits(PairMask m) { return _mm_movemask_pd(m); }
+	
+#  else
+	
+	using Pair = float64x2_t;
+	using PairMask = uint64x2_t;
+	
+	inline Pair loadPair(const MapCoordF& pos) { return vld1q_f64(reinterpret_cast<const double*>(&pos)); }
+	inline Pair makePair(double first, double second) { return vcombine_f64(vdup_n_f64(first), vdup_n_f64(second)); }
+	inline void storePair(double* out, Pair v) { vst1q_f64(out, v); }
+	inline Pair minimum(Pair a, Pair b) { return vminq_f64(a, b); }
+	inline Pair maximum(Pair a, Pair b) { return vmaxq_f64(a, b); }
+	inline Pair add(Pair a, Pair b) { return vaddq_f64(a, b); }
+	inline Pair subtract(Pair a, Pair b) { return vsubq_f64(a, b); }
+	inline Pair multiply(Pair a, Pair b) { return vmulq_f64(a, b); }
+	inline Pair divide(Pair a, Pair b) { return vdivq_f64(a, b); }
+	/// Returns the first elements of a and b.
+	inline Pair firsts(Pair a, Pair b) { return vzip1q_f64(a, b); }
+	/// Returns the second elements of a and b.
+	inline Pair seconds(Pair a, Pair b) { return vzip2q_f64(a, b); }
+	inline PairMask greater(Pair a, Pair b) { return vcgtq_f64(a, b); }
+	inline PairMask lessEqual(Pair a, Pair b) { return vcleq_f64(a, b); }
+	inline PairMask maskAnd(PairMask a, PairMask b) { return vandq_u64(a, b); }
+	inline PairMask maskXor(PairMask a, PairMask b) { return veorq_u64(a, b); }
+	/// Returns the mask as bits, the first element in the lowest bit.
+	inline int maskBits(PairMask m) { return int((vgetq_lane_u64(m, 0) & 1) | ((vgetq_lane_u64(m, 1) & 1) << 1)); }
+	
+#  endif
+	
+	
+	QRectF calculateExtentSimd(const PathCoordVector& path_coords)
+	{
+		auto pc = path_coords.begin();
+		auto last = path_coords.end();
+		auto lower = loadPair(pc->pos);
+		auto upper = add(lower, makePair(0.0001, 0.0001));
+		for (++pc; pc != last; ++pc)
+		{
+			auto const pos = loadPair(pc->pos);
+			lower = minimum(lower, pos);
+			upper = maximum(upper, pos);
+		}
+		
+		double l[2];
+		double u[2];
+		storePair(l, lower);
+		storePair(u, upper);
+		return QRectF(QPointF(l[0], l[1]), QPointF(u[0], u[1]));
+	}
+	
+	bool intersectsBoxSimd(const PathCoordVector& path_coords, const QRectF& box)
+	{
+		auto const normalized = box.normalized();
+		auto const box_lower = makePair(normalized.left(), normalized.top());
+		auto const box_upper = makePair(normalized.right(), normalized.bottom());
+		
+		auto pc = path_coords.begin();
+		auto last = path_coords.end();
+		auto previous = loadPair(pc->pos);
+		for (++pc; pc != last; ++pc)
+		{
+			// Only segments whose bounding box touches the box need the exact test.
+			auto const pos = loadPair(pc->pos);
+			auto const touching = maskAnd(lessEqual(minimum(previous, pos), box_upper),
+			                              lessEqual(box_lower, maximum(previous, pos)));
+			if (maskBits(touching) == 3 && lineIntersectsRect(box, (pc-1)->pos, pc->pos))
+				return true;
+			previous = pos;
+		}
+		return false;
+	}
+	
+	bool isPointInsideSimd(const PathCoordVector& path_coords, const MapCoordF& coord)
+	{
+		// Two edges at a time: from the positions at i-1 and i to the positions
+		// at i and i+1. The edge to the first position starts at the last one.
+		auto const size = path_coords.size();
+		auto const coord_x = makePair(coord.x(), coord.x());
+		auto const coord_y = makePair(coord.y(), coord.y());
+		
+		auto crossings = 0;
+		auto previous = loadPair(path_coords.back().pos);
+		std::size_t i = 0;
+		for (; i + 1 < size; i += 2)
+		{
+			auto const current = loadPair(path_coords[i].pos);
+			auto const next = loadPair(path_coords[i+1].pos);
+			auto const pos_x = firsts(current, next);
+			auto const pos_y = seconds(current, next);
+			auto const last_x = firsts(previous, current);
+			auto const last_y = seconds(previous, current);
+			
+			auto const crossing_y = maskXor(greater(pos_y, coord_y), greater(last_y, coord_y));
+			auto const intersection_x = add(divide(multiply(subtract(last_x, pos_x), subtract(coord_y, pos_y)),
+			                                       subtract(last_y, pos_y)),
+			                                pos_x);
+			auto const bits = maskBits(maskAnd(crossing_y, greater(intersection_x, coord_x)));
+			crossings ^= (bits ^ (bits >> 1)) & 1;
+			previous = next;
+		}
+		
+		bool inside = crossings != 0;
+		if (i < size)
+		{
+			auto const& last_pos = path_coords[i-1].pos;
+			auto const& pos = path_coords[i].pos;
+			if ( ((pos.y() > coord.y()) != (last_pos.y() > coord.y())) &&
+			     (coord.x() < (last_pos.x() - pos.x()) *
+			      (coord.y() - pos.y()) / (last_pos.y() - pos.y()) + pos.x()) )
+			{
+				inside = !inside;
+			}
+		}
+		return inside;
+	}
+	
+#endif
+	
+	
+	/**
+	 * Calculates the area of the polygon formed by the path coords.
+	 */
+	double polygonArea(const PathCoordVector& path_coords)
+	{
+		auto area = 0.0;
+		auto end_index = path_coords.size() - 1;
+		auto j = end_index;  // The last vertex is the 'previous' one to the first
+		
+		for (PathCoordVector::size_type i = 0u; i <= end_index; ++i)
+		{
+			area += (path_coords[j].pos.x() + path_coords[i].pos.x()) * (path_coords[j].pos.y() - path_coords[i].pos.y()); 
+			j = i;
+		}
+		return qAbs(area) / 2;
+	}
+	
 	
 }  // namespace
 
@@ -83,25 +283,53 @@ PathCoordVector::PathCoordVector(const VirtualCoordVector& coords)
 
 VirtualCoordVector::size_type PathCoordVector::update(VirtualCoordVector::size_type part_start)
 {
+	return update(part_start, part_start);
+}
+
+VirtualCoordVector::size_type PathCoordVector::update(VirtualCoordVector::size_type part_start, VirtualCoordVector::size_type first_changed)
+{
+	edge_index.reset();
+	edge_bands.reset();
+	area = 0.0;
+	
 	auto& flags = virtual_coords.flags;
 	auto part_end = virtual_coords.size() - 1;
 	if (part_start <= part_end)
 	{	
 		Q_ASSERT(virtual_coords.size() == flags.size());
 		
-		clear();
-		
-		if (flags[part_start].isHolePoint())
+		// Keep the path coords which depend on unchanged coordinates only.
+		// Curve points depend on the coordinates up to the curve's end.
+		if (first_changed <= part_start || empty() || front().index != part_start)
+		{
+			clear();
+		}
+		else
 		{
-			auto pos = virtual_coords[0];
-			qWarning("PathCoordVector at %g %g (mm) has an invalid hole at index %d.",
-			         pos.x(), -pos.y(), part_start);
-			return part_start;
+			auto const unchanged = std::partition_point(begin(), end(), [first_changed](const PathCoord& pc) {
+				return (pc.param == 0 ? pc.index : pc.index + 3) < first_changed;
+			});
+			erase(unchanged, end());
 		}
 		
-		emplace_back(virtual_coords[part_start], part_start, 0.0, 0.0);
+		if (empty())
+		{
+			if (flags[part_start].isHolePoint())
+			{
+				auto pos = virtual_coords[0];
+				qWarning("PathCoordVector at %g %g (mm) has an invalid hole at index %d.",
+				         pos.x(), -pos.y(), part_start);
+				return part_start;
+			}
+			
+			emplace_back(virtual_coords[part_start], part_start, 0.0, 0.0);
+		}
+		else if (flags[back().index].isHolePoint() && back().index < part_end)
+		{
+			part_end = back().index;
+		}
 		
-		for (auto index = part_start + 1; index <= part_end; ++index)
+		for (auto index = back().index + 1; index <= part_end; ++index)
 		{
 			if (flags[index-1].isCurveStart())
 			{
@@ -123,10 +351,110 @@ VirtualCoordVector::size_type PathCoordVector::update(VirtualCoordVector::size_t
 				part_end = index;
 			}
 		}
+		
+		area = polygonArea(*this);
 	}
 	return part_end;
 }
 
+const SpatialIndex<PathCoordVector::size_type>& PathCoordVector::edgeIndex() const
+{
+	auto index = std::atomic_load(&edge_index);
+	if (!index)
+	{
+		auto new_index = std::make_shared<SpatialIndex<size_type>>();
+		for (size_type i = 0; i + 1 < size(); ++i)
+			new_index->insert(QRectF((*this)[i].pos, (*this)[i+1].pos), i);
+		
+		// Another thread may have been faster.
+		index = std::move(new_index);
+		std::shared_ptr<const SpatialIndex<size_type>> expected;
+		if (!std::atomic_compare_exchange_strong(&edge_index, &expected, index))
+			index = std::move(expected);
+	}
+	return *index;
+}
+
+struct PathCoordVector::EdgeBands
+{
+	double top = 0;
+	double bottom = 0;
+	double scale = 0;             ///< Bands per unit of y
+	size_type num_bands = 0;
+	std::vector<size_type> first; ///< The first entry of each band, plus the end
+	std::vector<size_type> edges; ///< The end of each edge, cf. isPointInside()
+	
+	size_type bandAt(double y) const
+	{
+		return std::min(num_bands - 1, size_type((y - top) * scale));
+	}
+};
+
+const PathCoordVector::EdgeBands& PathCoordVector::edgeBands() const
+{
+	auto bands = std::atomic_load(&edge_bands);
+	if (!bands)
+	{
+		auto new_bands = std::make_shared<EdgeBands>();
+		auto& b = *new_bands;
+		auto const n = size_type(size());
+		
+		// Calls fn(edge, first_band, last_band) for each edge which is not
+		// horizontal. Horizontal edges never cross the ray of a point.
+		auto const for_each_edge = [this, n, &b](auto&& fn) {
+			auto last_y = back().pos.y();
+			for (size_type i = 0; i < n; ++i)
+			{
+				auto const y = (*this)[i].pos.y();
+				if (y != last_y)
+					fn(i, b.bandAt(std::min(y, last_y)), b.bandAt(std::max(y, last_y)));
+				last_y = y;
+			}
+		};
+		
+		b.top = b.bottom = front().pos.y();
+		for (const auto& path_coord : *this)
+		{
+			b.top = std::min(b.top, path_coord.pos.y());
+			b.bottom = std::max(b.bottom, path_coord.pos.y());
+		}
+		if (n > 2 && b.bottom > b.top)
+		{
+			// Long edges are entered in every band they cross.
+			// Use fewer bands when this would make the index too large.
+			b.num_bands = std::max(size_type(1), std::min(size_type(1024), n / 4));
+			for (;;)
+			{
+				b.scale = b.num_bands / (b.bottom - b.top);
+				b.first.assign(b.num_bands + 1, 0);
+				for_each_edge([&b](size_type /*edge*/, size_type first_band, size_type last_band) {
+					for (auto band = first_band; band <= last_band; ++band)
+						++b.first[band + 1];
+				});
+				for (size_type band = 0; band < b.num_bands; ++band)
+					b.first[band + 1] += b.first[band];
+				if (b.num_bands == 1 || b.first.back() <= 8 * n)
+					break;
+				b.num_bands /= 2;
+			}
+			
+			b.edges.resize(b.first.back());
+			auto next = b.first;
+			for_each_edge([&b, &next](size_type edge, size_type first_band, size_type last_band) {
+				for (auto band = first_band; band <= last_band; ++band)
+					b.edges[next[band]++] = edge;
+			});
+		}
+		
+		// Another thread may have been faster.
+		bands = std::move(new_bands);
+		std::shared_ptr<const EdgeBands> expected;
+		if (!std::atomic_compare_exchange_strong(&edge_bands, &expected, bands))
+			bands = std::move(expected);
+	}
+	return *bands;
+}
+
 bool PathCoordVector::isClosed() const
 {
 	return virtual_coords.flags[back().index].isClosePoint();
@@ -164,17 +492,7 @@ PathCoord::length_type PathCoordVector::length() const
 double PathCoordVector::calculateArea() const
 {
 	Q_ASSERT(!empty());
-	
-	auto area = 0.0;
-	auto end_index = size() - 1;
-	auto j = end_index;  // The last vertex is the 'previous' one to the first
-	
-	for (size_type i = 0u; i <= end_index; ++i)
-	{
-		area += ((*this)[j].pos.x() + (*this)[i].pos.x()) * ((*this)[j].pos.y() - (*this)[i].pos.y()); 
-		j = i;
-	}
-	return qAbs(area) / 2;
+	return area;
 }
 
 QRectF PathCoordVector::calculateExtent() const
@@ -182,6 +500,9 @@ QRectF PathCoordVector::calculateExtent() const
 	QRectF extent(0.0, 0.0, -1.0, 0.0);
 	if (!empty())
 	{
+#if defined(MAPPER_PATH_COORD_SSE2) || defined(MAPPER_PATH_COORD_NEON)
+		extent = calculateExtentSimd(*this);
+#else
 		auto pc = begin();
 		extent = QRectF(pc->pos.x(), pc->pos.y(), 0.0001, 0.0001);
 		
@@ -190,6 +511,7 @@ QRectF PathCoordVector::calculateExtent() const
 		{
 			rectInclude(extent, pc->pos);
 		}
+#endif
 		
 		Q_ASSERT(extent.isValid());
 	}
@@ -201,6 +523,9 @@ bool PathCoordVector::intersectsBox(const QRectF& box) const
 	bool result = false;
 	if (!empty())
 	{
+#if defined(MAPPER_PATH_COORD_SSE2) || defined(MAPPER_PATH_COORD_NEON)
+		result = intersectsBoxSimd(*this, box);
+#else
 		auto last_pos = front().pos;
 		result = std::any_of(begin()+1, end(), [&box, &last_pos](const PathCoord& pc)
 		{
@@ -209,6 +534,7 @@ bool PathCoordVector::intersectsBox(const QRectF& box) const
 			last_pos = pos;
 			return result;
 		});
+#endif
 	}
 	return result;
 }
@@ -216,8 +542,32 @@ bool PathCoordVector::intersectsBox(const QRectF& box) const
 bool PathCoordVector::isPointInside(const MapCoordF& coord) const
 {
 	bool inside = false;
-	if (size() > 2)
+	if (size() > 2 && hasManyEdges())
+	{
+		// Only the edges in the band of the point can cross its ray.
+		auto const& bands = edgeBands();
+		if (bands.num_bands == 0 || !(coord.y() >= bands.top && coord.y() < bands.bottom))
+			return false;
+		
+		auto const band = bands.bandAt(coord.y());
+		auto const last = begin(bands.edges) + std::ptrdiff_t(bands.first[band + 1]);
+		for (auto edge = begin(bands.edges) + std::ptrdiff_t(bands.first[band]); edge != last; ++edge)
+		{
+			auto const& pos = (*this)[*edge].pos;
+			auto const& last_pos = (*this)[*edge == 0 ? size() - 1 : *edge - 1].pos;
+			if ( ((pos.y() > coord.y()) != (last_pos.y() > coord.y())) &&
+			     (coord.x() < (last_pos.x() - pos.x()) *
+			      (coord.y() - pos.y()) / (last_pos.y() - pos.y()) + pos.x()) )
+			{
+				inside = !inside;
+			}
+		}
+	}
+	else if (size() > 2)
 	{
+#if defined(MAPPER_PATH_COORD_SSE2) || defined(MAPPER_PATH_COORD_NEON)
+		inside = isPointInsideSimd(*this, coord);
+#else
 		auto last_pos = back().pos;
 		for(const auto& path_coord : *this)
 		{
@@ -230,6 +580,7 @@ bool PathCoordVector::isPointInside(const MapCoordF& coord) const
 			}
 			last_pos = pos;
 		}
+#endif
 	}
 	return inside;
 }
@@ -247,9 +598,23 @@ void PathCoordVector::curveToPathCoord(
 	auto p_half = (double(p0) + double(p1)) * 0.5;
 	MapCoordF c12((c1.x() + c2.x()) * 0.5, (c1.y() + c2.y()) * 0.5);
 	
-	auto inner_len_sq = c0.distanceSquaredTo(c3);
-	auto outer_len    = [&]() { return c0.distanceTo(c1) + c1.distanceTo(c2) + c2.distanceTo(c3); };
-	if (inner_len_sq <= bezier_segment_maxlen_squared && outer_len() - sqrt(inner_len_sq) <= bezier_error)
+	auto is_flat = [&]() {
+		auto l0 = c0.distanceTo(c1);
+		auto l1 = c1.distanceTo(c2);
+		auto l2 = c2.distanceTo(c3);
+		auto outer_len = l0 + l1 + l2;
+		auto inner_len_sq = c0.distanceSquaredTo(c3);
+		auto inner_len = std::sqrt(inner_len_sq);
+		if (outer_len - inner_len > bezier_error)
+			return false;
+		if (inner_len_sq <= bezier_segment_maxlen_squared)
+			return true;
+		// The speed along the curve is proportional to the control polygon's
+		// leg lengths. Equal legs mean a linear parameter-to-length mapping.
+		auto spread = std::max({l0, l1, l2}) - std::min({l0, l1, l2});
+		return 3 * spread * inner_len <= bezier_parameter_error * outer_len;
+	};
+	if (is_flat())
 	{
 		const PathCoord& prev = back();
 		emplace_back(c12, edge_start, p_half, prev.clen + float(prev.pos.distanceTo(c12)));
@@ -317,6 +682,12 @@ VirtualPath::VirtualPath(const MapCoordVector& flags, const MapCoordVectorF& coo
 	// nothing else
 }
 
+void VirtualPath::setCoords(const MapCoordVector& coords)
+{
+	this->coords = VirtualCoordVector(coords);
+	path_coords.virtual_coords = this->coords;
+}
+
 VirtualPath::size_type VirtualPath::countRegularNodes() const
 {
 	size_type num_regular_points = 0;
@@ -350,13 +721,9 @@ ClosestPathCoord VirtualPath::findClosestPointTo(
 	
 	auto result = ClosestPathCoord { path_coords.front(), distance_bound_squared };
 	
-	// Find upper bound for distance.
-	for (const auto& path_coord : path_coords)
-	{
-		if (path_coord.index > end_index)
-			break;
-		if (path_coord.index < start_index)
-			continue;
+	auto const check_coord = [&](const PathCoord& path_coord) {
+		if (path_coord.index > end_index || path_coord.index < start_index)
+			return;
 		
 		auto to_coord = coord - path_coord.pos;
 		auto dist_sq = to_coord.lengthSquared();
@@ -365,16 +732,11 @@ ClosestPathCoord VirtualPath::findClosestPointTo(
 			result.distance_squared = dist_sq;
 			result.path_coord = path_coord;
 		}
-	}
+	};
 	
-	// Check between this coord and the next one.
-	auto last = end(path_coords)-1;
-	for (auto pc = begin(path_coords); pc != last; ++pc)
-	{
-		if (pc->index > end_index)
-			break;
-		if (pc->index < start_index)
-			continue;
+	auto const check_edge = [&](PathCoordVector::const_iterator pc) {
+		if (pc->index > end_index || pc->index < start_index)
+			return;
 		
 		auto pos = pc->pos;
 		auto next_pc = pc+1;
@@ -392,7 +754,7 @@ ClosestPathCoord VirtualPath::findClosestPointTo(
 				result.distance_squared = to_coord.lengthSquared();
 				result.path_coord = *pc;
 			}
-			continue;
+			return;
 		}
 		
 		auto line_length = next_pc->clen - pc->clen;
@@ -403,7 +765,7 @@ ClosestPathCoord VirtualPath::findClosestPointTo(
 				result.distance_squared = coord.distanceSquaredTo(next_pos);
 				result.path_coord = *next_pc;
 			}
-			continue;
+			return;
 		}
 		
 		auto right = tangent.perpRight();
@@ -433,6 +795,39 @@ ClosestPathCoord VirtualPath::findClosestPointTo(
 				result.path_coord.pos = pos + (next_pos - pos) * double(factor);
 			}
 		}
+	};
+	
+	if (distance_bound_squared < std::numeric_limits<double>::max() && path_coords.hasManyEdges())
+	{
+		// Only the edges near coord can be closer than the bound.
+		auto const radius = std::sqrt(distance_bound_squared);
+		auto edges = path_coords.edgeIndex().values(QRectF(coord.x() - radius, coord.y() - radius, 2 * radius, 2 * radius));
+		std::sort(begin(edges), end(edges));
+		for (auto edge : edges)
+		{
+			check_coord(path_coords[edge]);
+			check_coord(path_coords[edge + 1]);
+		}
+		for (auto edge : edges)
+			check_edge(begin(path_coords) + std::ptrdiff_t(edge));
+		return result;
+	}
+	
+	// Find upper bound for distance.
+	for (const auto& path_coord : path_coords)
+	{
+		if (path_coord.index > end_index)
+			break;
+		check_coord(path_coord);
+	}
+	
+	// Check between this coord and the next one.
+	auto last = end(path_coords)-1;
+	for (auto pc = begin(path_coords); pc != last; ++pc)
+	{
+		if (pc->index > end_index)
+			break;
+		check_edge(pc);
 	}
 	return result;
 }
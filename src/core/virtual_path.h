@@ -36,6 +36,9 @@
 
 namespace OpenOrienteering {
 
+template <class T> class SpatialIndex;
+
+
 class PathCoordVector : public std::vector<PathCoord>
 {
 private:
@@ -77,6 +80,45 @@ public:
 	 */
 	VirtualCoordVector::size_type update(VirtualCoordVector::size_type first);
 	
+	/**
+	 * Updates the path coords from the flags/coords, starting at first,
+	 * after a change of the coordinates from first_changed onwards.
+	 * 
+	 * Path coords which depend only on coordinates before first_changed are
+	 * kept, if the path coords were previously updated for the same first.
+	 * 
+	 * \return The index after the last element of this part.
+	 */
+	VirtualCoordVector::size_type update(VirtualCoordVector::size_type first, VirtualCoordVector::size_type first_changed);
+	
+	
+	/**
+	 * Returns true if searching the edges near a location should use edgeIndex().
+	 * 
+	 * For short paths, testing all edges is faster.
+	 */
+	bool hasManyEdges() const noexcept { return size() > 64; }
+	
+	/**
+	 * Returns an index of the edges between consecutive path coords.
+	 * 
+	 * The value of an edge is the index of the path coord at its start.
+	 * The index is built on first use, and it is discarded by update().
+	 * It may be built concurrently from multiple threads.
+	 */
+	const SpatialIndex<size_type>& edgeIndex() const;
+	
+	/**
+	 * Returns an index of the edges crossing horizontal bands of the path's extent.
+	 * 
+	 * isPointInside() uses this index for paths with many edges, so that only
+	 * the edges in the band of the point need to be tested. The index is built
+	 * on first use, and it is discarded by update().
+	 * It may be built concurrently from multiple threads.
+	 */
+	struct EdgeBands;
+	const EdgeBands& edgeBands() const;
+	
 	
 	/**
 	 * Finds the index of the next dash point after first, or returns size()-1.
@@ -111,7 +153,9 @@ public:
 	PathCoord::length_type length() const;
 	
 	/**
-	 * Calculates the area of this part.
+	 * Returns the area of this part.
+	 * 
+	 * The area is calculated by update().
 	 */
 	double calculateArea() const;
 	
@@ -122,8 +166,15 @@ public:
 	bool isPointInside(const MapCoordF& coord) const;
 	
 private:
+	mutable std::shared_ptr<const SpatialIndex<size_type>> edge_index;
+	mutable std::shared_ptr<const EdgeBands> edge_bands;
+	double area = 0.0;
+	
 	/**
 	 * Recursive approximation of a bezier curve by polygonal segments.
+	 * 
+	 * The curve is split until the segments are flat enough and until the
+	 * curve parameter maps linearly enough to the length along the segments.
 	 */
 	void curveToPathCoord(
 		MapCoordF c0,
@@ -185,6 +236,14 @@ protected:
 	VirtualPath& operator=(VirtualPath&&) = default;
 	
 public:
+	/**
+	 * Lets this path refer to another vector of coordinates and flags.
+	 * 
+	 * The new vector must have the same contents as the current one.
+	 * The path coords are kept.
+	 */
+	void setCoords(const MapCoordVector& coords);
+	
 	/**
 	 * Returns true if there are no nodes in this path.
 	 */
@@ -0,0 +1,435 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch_export.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QByteArray>
+#include <QColor>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QObject>
+#include <QPainter>
+#include <QProcess>
+#include <QSizeF>
+#include <QThread>
+
+#ifdef QT_PRINTSUPPORT_LIB
+#include <QPrinter>
+#endif
+
+#include "mapper_config.h"
+#include "core/map.h"
+#include "core/map_printer.h"
+#include "fileformats/file_format.h"
+#include "fileformats/file_format_registry.h"
+#include "fileformats/file_import_export.h"
+
+#ifdef MAPPER_USE_GDAL
+#include "gdal/geotiff_export.h"
+#include "gdal/kmz_groundoverlay_export.h"
+#endif
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The command line option which requests the batch export.
+constexpr auto export_option = "--export";
+
+
+bool isOneOf(const QString& value, std::initializer_list<const char*> candidates)
+{
+	return std::any_of(candidates.begin(), candidates.end(), [&value](auto candidate) {
+		return value.compare(QLatin1String(candidate), Qt::CaseInsensitive) == 0;
+	});
+}
+
+bool isImageFormat(const QString& format)
+{
+	return isOneOf(format, { "png", "jpg", "jpeg", "bmp", "tif", "tiff" });
+}
+
+bool isKmzFormat(const QString& format)
+{
+	return isOneOf(format, { "kmz", "kml" });
+}
+
+bool isPrintedFormat(const QString& format)
+{
+	return isImageFormat(format) || isKmzFormat(format) || isOneOf(format, { "pdf" });
+}
+
+
+}  // namespace
+
+
+
+// ### BatchExport ###
+
+// static
+bool BatchExport::isRequested(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		auto const length = std::strlen(export_option);
+		if (std::strncmp(argv[i], export_option, length) == 0
+		    && (argv[i][length] == 0 || argv[i][length] == '='))
+			return true;
+	}
+	return false;
+}
+
+
+BatchExport::BatchExport() = default;
+
+BatchExport::~BatchExport() = default;
+
+
+int BatchExport::exec(const QStringList& arguments)
+{
+	if (!parseArguments(arguments))
+		return 1;
+	
+	if (input_paths.size() > 1 && jobs > 1)
+		return exportInWorkers() ? 0 : 1;
+	
+	auto result = true;
+	for (auto const& input_path : qAsConst(input_paths))
+		result = exportFile(input_path, outputPath(input_path)) && result;
+	return result ? 0 : 1;
+}
+
+
+bool BatchExport::parseArguments(const QStringList& arguments)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription(tr("Converts or exports map files without a user interface."));
+	parser.addHelpOption();
+	QCommandLineOption format_option(QString::fromLatin1(export_option + 2),
+	                                 tr("The output format: a file format id or extension, or one of pdf, png, jpg, bmp, tif, kmz, kml."),
+	                                 tr("format"));
+	QCommandLineOption output_option({ QString::fromLatin1("o"), QString::fromLatin1("output") },
+	                                 tr("The directory for the output files."),
+	                                 tr("directory"));
+	QCommandLineOption jobs_option({ QString::fromLatin1("j"), QString::fromLatin1("jobs") },
+	                               tr("The number of files to process at the same time."),
+	                               tr("number"), QString::number(QThread::idealThreadCount()));
+	QCommandLineOption resolution_option(QString::fromLatin1("resolution"),
+	                                     tr("The resolution for PDF, image and KMZ export, in dpi."),
+	                                     tr("dpi"));
+	QCommandLineOption transparent_option(QString::fromLatin1("transparent"),
+	                                      tr("Use a transparent background for PNG and TIFF export."));
+	parser.addOptions({ format_option, output_option, jobs_option, resolution_option, transparent_option });
+	parser.addPositionalArgument(tr("files"), tr("The map files to be processed."), tr("files..."));
+	
+	if (!parser.parse(arguments))
+	{
+		report(parser.errorText());
+		return false;
+	}
+	if (parser.isSet(QString::fromLatin1("help")))
+		parser.showHelp();  // exits
+	
+	format = parser.value(format_option);
+	input_paths = parser.positionalArguments();
+	output_dir = parser.value(output_option);
+	transparent_background = parser.isSet(transparent_option);
+	
+	auto ok = true;
+	jobs = std::max(1, parser.value(jobs_option).toInt(&ok));
+	if (!ok)
+	{
+		report(tr("Invalid number of jobs: %1").arg(parser.value(jobs_option)));
+		return false;
+	}
+	if (parser.isSet(resolution_option))
+	{
+		resolution = parser.value(resolution_option).toInt(&ok);
+		if (!ok || resolution <= 0)
+		{
+			report(tr("Invalid resolution: %1").arg(parser.value(resolution_option)));
+			return false;
+		}
+	}
+	
+	if (isPrintedFormat(format))
+	{
+		format = format.toLower();
+		extension = format;
+	}
+	else
+	{
+		auto const* file_format = FileFormats.findFormat(format.toLatin1().constData());
+		if (!file_format || !file_format->supportsFileExport())
+			file_format = FileFormats.findFormatForFilename(QLatin1String("file.") + format, &FileFormat::supportsFileExport);
+		if (!file_format)
+		{
+			report(tr("Unknown output format: %1").arg(format));
+			return false;
+		}
+		format = QString::fromLatin1(file_format->id());
+		extension = file_format->primaryExtension();
+	}
+	
+	if (input_paths.isEmpty())
+	{
+		report(tr("No input files."));
+		return false;
+	}
+	if (!output_dir.isEmpty() && !QDir().mkpath(output_dir))
+	{
+		report(tr("Cannot create the output directory: %1").arg(output_dir));
+		return false;
+	}
+	return true;
+}
+
+
+QString BatchExport::outputPath(const QString& input_path) const
+{
+	auto const info = QFileInfo(input_path);
+	auto const dir = output_dir.isEmpty() ? info.dir() : QDir(output_dir);
+	return dir.filePath(info.completeBaseName() + QLatin1Char('.') + extension);
+}
+
+
+bool BatchExport::exportFile(const QString& input_path, const QString& output_path)
+{
+	if (QFileInfo(input_path).absoluteFilePath() == QFileInfo(output_path).absoluteFilePath())
+	{
+		report(tr("%1: Output file would replace the input file.").arg(input_path));
+		return false;
+	}
+	
+	Map map;
+	auto importer = FileFormats.makeImporter(input_path, map, nullptr);
+	if (!importer)
+	{
+		report(tr("%1: Cannot find a file format for reading.").arg(input_path));
+		return false;
+	}
+	auto const imported = importer->doImport();
+	for (auto const& warning : importer->warnings())
+		report(input_path + QLatin1String(": ") + warning);
+	if (!imported)
+		return false;
+	
+	auto const result = isPrintedFormat(format) ? exportPrinted(map, output_path)
+	                                            : exportFileFormat(map, output_path);
+	if (result)
+		std::fprintf(stdout, "%s\n", qPrintable(QDir::toNativeSeparators(output_path)));
+	return result;
+}
+
+
+bool BatchExport::exportFileFormat(Map& map, const QString& output_path)
+{
+	auto const* file_format = FileFormats.findFormat(format.toLatin1().constData());
+	Q_ASSERT(file_format);
+	auto exporter = file_format->makeExporter(output_path, &map, nullptr);
+	if (!exporter)
+	{
+		report(tr("%1: Cannot create the exporter.").arg(output_path));
+		return false;
+	}
+	auto const exported = exporter->doExport();
+	for (auto const& warning : exporter->warnings())
+		report(output_path + QLatin1String(": ") + warning);
+	return exported;
+}
+
+
+bool BatchExport::exportPrinted(Map& map, const QString& output_path)
+{
+#ifdef QT_PRINTSUPPORT_LIB
+	MapPrinter map_printer(map, nullptr, nullptr);
+	if (!map.hasPrinterConfig())
+		map_printer.setPrintArea(map.calculateExtent());
+	
+	if (format == QLatin1String("pdf"))
+	{
+		map_printer.setTarget(MapPrinter::pdfTarget());
+		if (resolution > 0)
+			map_printer.setResolution(resolution);
+		auto printer = map_printer.makePrinter();
+		if (!printer)
+		{
+			report(tr("%1: Failed to prepare the PDF export.").arg(output_path));
+			return false;
+		}
+		printer->setOutputFormat(QPrinter::PdfFormat);
+		printer->setCreator(APP_NAME);
+		printer->setDocName(QFileInfo(output_path).baseName());
+		printer->setOutputFileName(output_path);
+		if (!map_printer.printMap(printer.get()))
+		{
+			QFile(output_path).remove();
+			report(tr("%1: Failed to finish the PDF export.").arg(output_path));
+			return false;
+		}
+		return true;
+	}
+	
+	if (isKmzFormat(format))
+	{
+#ifdef MAPPER_USE_GDAL
+		map_printer.setTarget(MapPrinter::kmzTarget());
+		if (resolution > 0)
+			map_printer.setResolution(resolution);
+		KmzGroundOverlayExport exporter(output_path, map);
+		if (!exporter.doExport(map_printer))
+		{
+			report(output_path + QLatin1String(": ") + exporter.errorString());
+			return false;
+		}
+		return true;
+#else
+		report(tr("%1: KMZ export is not supported in this build.").arg(output_path));
+		return false;
+#endif
+	}
+	
+	map_printer.setTarget(MapPrinter::imageTarget());
+	if (resolution > 0)
+		map_printer.setResolution(resolution);
+	auto const transparent = transparent_background
+	                         && isOneOf(format, { "png", "tif", "tiff" });
+#ifdef MAPPER_USE_GDAL
+	if (isOneOf(format, { "tif", "tiff" }))
+	{
+		GeoTiffExport exporter(output_path, map);
+		if (!exporter.doExport(map_printer, transparent))
+		{
+			report(output_path + QLatin1String(": ") + exporter.errorString());
+			return false;
+		}
+		return true;
+	}
+#endif
+
+	auto const pixel_per_mm = map_printer.getOptions().resolution / 25.4;
+	auto const print_width = qRound(map_printer.getPrintAreaPaperSize().width() * pixel_per_mm);
+	auto const print_height = qRound(map_printer.getPrintAreaPaperSize().height() * pixel_per_mm);
+	QImage image(print_width, print_height, QImage::Format_ARGB32_Premultiplied);
+	if (image.isNull())
+	{
+		report(tr("%1: Failed to prepare the image. Not enough memory.").arg(output_path));
+		return false;
+	}
+	
+	auto const dots_per_meter = qRound(pixel_per_mm * 1000);
+	image.setDotsPerMeterX(dots_per_meter);
+	image.setDotsPerMeterY(dots_per_meter);
+	image.fill(QColor(transparent ? Qt::transparent : Qt::white));
+	
+	QPainter painter(&image);
+	map_printer.drawPage(&painter, map_printer.getPrintArea(), &image);
+	painter.end();
+	if (!image.save(output_path))
+	{
+		report(tr("%1: Failed to save the image. Does the path exist? Do you have sufficient rights?").arg(output_path));
+		return false;
+	}
+	return true;
+#else
+	Q_UNUSED(map)
+	report(tr("%1: Printing and image export is not supported in this build.").arg(output_path));
+	return false;
+#endif  // QT_PRINTSUPPORT_LIB
+}
+
+
+bool BatchExport::exportInWorkers()
+{
+	// Each worker process handles a single file with the same options.
+	QStringList common_arguments = { QLatin1String(export_option), format, QStringLiteral("--jobs"), QStringLiteral("1") };
+	if (!output_dir.isEmpty())
+		common_arguments << QStringLiteral("--output") << output_dir;
+	if (resolution > 0)
+		common_arguments << QStringLiteral("--resolution") << QString::number(resolution);
+	if (transparent_background)
+		common_arguments << QStringLiteral("--transparent");
+	
+	QEventLoop loop;
+	std::vector<std::unique_ptr<QProcess>> workers;
+	auto next_input = 0;
+	auto running = 0;
+	auto result = true;
+	
+	std::function<void ()> start_next;
+	start_next = [&]() {
+		while (running < jobs && next_input < input_paths.size())
+		{
+			workers.push_back(std::make_unique<QProcess>());
+			auto* worker = workers.back().get();
+			worker->setProcessChannelMode(QProcess::ForwardedChannels);
+			QObject::connect(worker, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+			                 &loop, [&](int exit_code, QProcess::ExitStatus exit_status) {
+				result = result && exit_status == QProcess::NormalExit && exit_code == 0;
+				--running;
+				start_next();
+				if (running == 0)
+					loop.quit();
+			});
+			worker->start(QCoreApplication::applicationFilePath(),
+			              QStringList(common_arguments) << QLatin1String("--") << input_paths[next_input++]);
+			if (worker->waitForStarted())
+			{
+				++running;
+			}
+			else
+			{
+				report(worker->errorString());
+				result = false;
+			}
+		}
+	};
+	
+	start_next();
+	if (running > 0)
+		loop.exec();
+	return result;
+}
+
+
+void BatchExport::report(const QString& message) const
+{
+	std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,111 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_BATCH_EXPORT_H
+#define OPENORIENTEERING_BATCH_EXPORT_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * Converts or exports map files without a user interface.
+ * 
+ * The batch export is requested by the command line option --export, with
+ * the id or the filename extension of a file format, or with one of the
+ * print targets "pdf", "png", "jpg", "bmp", "tif", "kmz" or "kml". Each input
+ * file is written to a file with the same base name and the format's
+ * extension, in the directory given by --output or next to the input file.
+ * 
+ * With more than one input file, the files are processed by separate worker
+ * processes, at most --jobs at a time. Templates are not loaded.
+ */
+class BatchExport
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::BatchExport)
+
+public:
+	/**
+	 * Returns true if the command line arguments request a batch export.
+	 * 
+	 * This is meant to be called before the application object is created.
+	 */
+	static bool isRequested(int argc, char** argv);
+	
+	BatchExport();
+	BatchExport(const BatchExport&) = delete;
+	BatchExport(BatchExport&&) = delete;
+	~BatchExport();
+	
+	BatchExport& operator=(const BatchExport&) = delete;
+	BatchExport& operator=(BatchExport&&) = delete;
+	
+	/**
+	 * Parses the command line arguments, and processes all input files.
+	 * 
+	 * Returns the exit code for the application.
+	 */
+	int exec(const QStringList& arguments);
+	
+	/**
+	 * Returns the path of the output file for the given input file.
+	 */
+	QString outputPath(const QString& input_path) const;
+	
+	/**
+	 * Converts or exports a single file in this process.
+	 */
+	bool exportFile(const QString& input_path, const QString& output_path);
+	
+	/**
+	 * Runs a worker process for each input file, at most jobs at a time.
+	 */
+	bool exportInWorkers();
+
+
+protected:
+	bool parseArguments(const QStringList& arguments);
+	
+	bool exportPrinted(Map& map, const QString& output_path);
+	
+	bool exportFileFormat(Map& map, const QString& output_path);
+	
+	void report(const QString& message) const;
+
+
+private:
+	QString format;
+	QString extension;
+	QString output_dir;
+	QStringList input_paths;
+	int jobs = 1;
+	int resolution = 0;
+	bool transparent_background = false;
+
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_BATCH_EXPORT_H
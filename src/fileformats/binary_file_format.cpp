@@ -0,0 +1,530 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binary_file_format.h"
+#include "binary_file_format_p.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <QtGlobal>
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFileDevice>
+#include <QFlags>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QString>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/symbol.h"
+#include "fileformats/file_format.h"
+#include "fileformats/file_import_export.h"
+#include "util/key_value_container.h"
+#include "util/xml_stream_util.h"
+
+
+namespace OpenOrienteering {
+
+namespace literal
+{
+	static const QLatin1String part("part");
+	static const QLatin1String name("name");
+	static const QLatin1String objects("objects");
+	static const QLatin1String count("count");
+	static const QLatin1String offset("offset");
+}
+
+
+namespace {
+
+/**
+ * The fixed-size header at the start of the container.
+ *
+ * Offsets are counted from the start of the file, in bytes.
+ */
+struct ContainerHeader
+{
+	char magic[4];
+	quint32 version;
+	quint32 coord_size;     ///< The size of a single MapCoord.
+	quint32 reserved;
+	quint64 xml_offset;
+	quint64 xml_size;
+	quint64 objects_offset;
+	quint64 objects_size;
+	quint64 coords_offset;
+	quint64 num_coords;
+};
+
+static_assert(sizeof(ContainerHeader) == 64, "The header must not contain padding.");
+static_assert(std::is_trivially_copyable<MapCoord>::value, "Raw MapCoord arrays require trivially copyable MapCoord.");
+
+constexpr char container_magic[4] = { 'O', 'O', 'M', 'B' };
+
+/// The alignment of the sections.
+constexpr quint64 section_alignment = 8;
+
+quint64 aligned(quint64 offset)
+{
+	return (offset + section_alignment - 1) / section_alignment * section_alignment;
+}
+
+/**
+ * Returns true if the given range is within a file of the given size.
+ */
+bool isInFile(quint64 offset, quint64 size, quint64 file_size)
+{
+	return offset <= file_size && size <= file_size - offset;
+}
+
+void setupStream(QDataStream& stream)
+{
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setVersion(QDataStream::Qt_5_5);
+}
+
+
+/**
+ * Temporarily replaces the device of an importer or exporter.
+ */
+class DeviceSwitch
+{
+public:
+	DeviceSwitch(ImportExport& import_export, QIODevice* device)
+	: import_export(import_export)
+	, original(import_export.device())
+	{
+		import_export.setDevice(device);
+	}
+	
+	DeviceSwitch(const DeviceSwitch&) = delete;
+	DeviceSwitch& operator=(const DeviceSwitch&) = delete;
+	
+	~DeviceSwitch()
+	{
+		import_export.setDevice(original);
+	}
+
+private:
+	ImportExport& import_export;
+	QIODevice* const original;
+};
+
+
+/**
+ * Unmaps a memory-mapped file when going out of scope.
+ */
+class FileMapping
+{
+public:
+	FileMapping(QFileDevice* file, quint64 size)
+	: file(file)
+	, data(file ? file->map(0, qint64(size)) : nullptr)
+	{}
+	
+	FileMapping(const FileMapping&) = delete;
+	FileMapping& operator=(const FileMapping&) = delete;
+	
+	~FileMapping()
+	{
+		if (data)
+			file->unmap(data);
+	}
+	
+	const char* constData() const { return reinterpret_cast<const char*>(data); }
+
+private:
+	QFileDevice* const file;
+	uchar* const data;
+};
+
+
+}  // namespace
+
+
+
+// ### BinaryFileFormat definition ###
+
+constexpr quint32 BinaryFileFormat::current_version;
+
+BinaryFileFormat::BinaryFileFormat()
+ : FileFormat(MapFile,
+              "OMAPB",
+              ::OpenOrienteering::ImportExport::tr("OpenOrienteering Mapper binary"),
+              QString::fromLatin1("omapb"),
+              Feature::FileOpen | Feature::FileImport |
+              Feature::FileSave | Feature::FileSaveAs )
+{
+	// Nothing
+}
+
+
+FileFormat::ImportSupportAssumption BinaryFileFormat::understands(const char* buffer, int size) const
+{
+	if (size < int(sizeof(container_magic)))
+		return Unknown;
+	if (std::memcmp(buffer, container_magic, sizeof(container_magic)) == 0)
+		return FullySupported;
+	return NotSupported;
+}
+
+
+std::unique_ptr<Importer> BinaryFileFormat::makeImporter(const QString& path, Map* map, MapView* view) const
+{
+	return std::make_unique<BinaryFileImporter>(path, map, view);
+}
+
+std::unique_ptr<Exporter> BinaryFileFormat::makeExporter(const QString& path, const Map* map, const MapView* view) const
+{
+	return std::make_unique<BinaryFileExporter>(path, map, view);
+}
+
+
+
+// ### BinaryFileExporter definition ###
+
+BinaryFileExporter::BinaryFileExporter(const QString& path, const Map* map, const MapView* view)
+: XMLFileExporter(path, map, view)
+, objects_stream(&objects_data, QIODevice::WriteOnly)
+{
+	setupStream(objects_stream);
+	setOption(QString::fromLatin1("autoFormatting"), false);
+}
+
+BinaryFileExporter::~BinaryFileExporter() = default;
+
+
+bool BinaryFileExporter::exportImplementation()
+{
+	objects_stream.device()->seek(0);
+	objects_data.clear();
+	coords_data.clear();
+	num_coords = 0;
+	
+	QByteArray xml_data;
+	{
+		QBuffer buffer(&xml_data);
+		buffer.open(QIODevice::WriteOnly);
+		DeviceSwitch device_switch(*this, &buffer);
+		if (!XMLFileExporter::exportImplementation())
+			return false;
+	}
+	
+	ContainerHeader header = {};
+	std::memcpy(header.magic, container_magic, sizeof(header.magic));
+	header.version = BinaryFileFormat::current_version;
+	header.coord_size = sizeof(MapCoord);
+	header.xml_offset = sizeof(ContainerHeader);
+	header.xml_size = quint64(xml_data.size());
+	header.objects_offset = aligned(header.xml_offset + header.xml_size);
+	header.objects_size = quint64(objects_data.size());
+	header.coords_offset = aligned(header.objects_offset + header.objects_size);
+	header.num_coords = num_coords;
+	
+	auto const padding = QByteArray(int(section_alignment), 0);
+	auto* output = device();
+	output->write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output->write(xml_data);
+	output->write(padding.constData(), qint64(header.objects_offset - header.xml_offset - header.xml_size));
+	output->write(objects_data);
+	output->write(padding.constData(), qint64(header.coords_offset - header.objects_offset - header.objects_size));
+	output->write(coords_data);
+	return true;
+}
+
+
+void BinaryFileExporter::exportMapPart(const MapPart& part)
+{
+	XmlElementWriter part_element(xml, literal::part);
+	part_element.writeAttribute(literal::name, part.getName());
+	{
+		XmlElementWriter objects_element(xml, literal::objects);
+		objects_element.writeAttribute(literal::count, part.getNumObjects());
+		objects_element.writeAttribute(literal::offset, qint64(objects_data.size()));
+		for (int i = 0; i < part.getNumObjects(); ++i)
+			exportObject(*part.getObject(i));
+	}
+}
+
+
+void BinaryFileExporter::exportObject(const Object& object)
+{
+	auto const type = object.getType();
+	auto const& coords = object.getRawCoordinateVector();
+	// Text objects keep just the anchor coordinate.
+	auto const count = (type == Object::Path) ? coords.size() : std::min(coords.size(), std::size_t(1));
+	
+	objects_stream << quint8(type)
+	               << qint32(map->findSymbolIndex(object.getSymbol()))
+	               << double(object.getRotation())
+	               << num_coords
+	               << quint32(count);
+	
+	coords_data.append(reinterpret_cast<const char*>(coords.data()), int(count * sizeof(MapCoord)));
+	num_coords += count;
+	
+	auto const& tags = object.tags();
+	objects_stream << quint32(tags.size());
+	for (auto const& tag : tags)
+		objects_stream << tag.key << tag.value;
+	
+	if (type == Object::Path)
+	{
+		auto const origin = static_cast<const PathObject&>(object).getPatternOrigin();
+		objects_stream << qint32(origin.nativeX()) << qint32(origin.nativeY());
+	}
+	else if (type == Object::Text)
+	{
+		auto const& text = static_cast<const TextObject&>(object);
+		auto const size = text.getBoxSize();
+		objects_stream << quint8(text.getHorizontalAlignment())
+		               << quint8(text.getVerticalAlignment())
+		               << text.hasSingleAnchor()
+		               << qint32(size.nativeX()) << qint32(size.nativeY())
+		               << text.getText();
+	}
+}
+
+
+
+// ### BinaryFileImporter definition ###
+
+BinaryFileImporter::BinaryFileImporter(const QString& path, Map* map, MapView* view)
+: XMLFileImporter(path, map, view)
+{}
+
+BinaryFileImporter::~BinaryFileImporter() = default;
+
+
+bool BinaryFileImporter::importImplementation()
+{
+	auto* input = device();
+	ContainerHeader header;
+	if (input->read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header))
+	    || std::memcmp(header.magic, container_magic, sizeof(container_magic)) != 0)
+	{
+		throw FileFormatException(::OpenOrienteering::Importer::tr("Unsupported file format."));
+	}
+	if (header.version < 1)
+		throw FileFormatException(::OpenOrienteering::Importer::tr("Invalid file format version."));
+	if (header.version > BinaryFileFormat::current_version || header.coord_size != sizeof(MapCoord))
+		throw FileFormatException(tr("Unsupported file format version %1.").arg(header.version));
+	
+	auto const file_size = quint64(input->size());
+	if (!isInFile(header.xml_offset, header.xml_size, file_size)
+	    || !isInFile(header.objects_offset, header.objects_size, file_size)
+	    || header.coords_offset > file_size
+	    || header.num_coords > (file_size - header.coords_offset) / sizeof(MapCoord)
+	    || header.xml_size > quint64(std::numeric_limits<int>::max())
+	    || header.objects_size > quint64(std::numeric_limits<int>::max()))
+	{
+		throw FileFormatException(tr("The file is damaged."));
+	}
+	
+	// Map the whole file, or read it if the device cannot be mapped.
+	FileMapping mapping(qobject_cast<QFileDevice*>(input), file_size);
+	QByteArray file_data;
+	auto const* data = mapping.constData();
+	if (!data)
+	{
+		if (!input->seek(0))
+			throw FileFormatException(input->errorString());
+		file_data = input->readAll();
+		if (quint64(file_data.size()) != file_size)
+			throw FileFormatException(input->errorString());
+		data = file_data.constData();
+	}
+	
+	objects_data = data + header.objects_offset;
+	objects_size = header.objects_size;
+	coords_data = data + header.coords_offset;
+	num_coords = header.num_coords;
+	
+	auto xml_data = QByteArray::fromRawData(data + header.xml_offset, int(header.xml_size));
+	QBuffer buffer(&xml_data);
+	buffer.open(QIODevice::ReadOnly);
+	DeviceSwitch device_switch(*this, &buffer);
+	return XMLFileImporter::importImplementation();
+}
+
+
+MapPart* BinaryFileImporter::importMapPart()
+{
+	Q_ASSERT(xml.name() == literal::part);
+	
+	XmlElementReader part_element(xml);
+	auto part = std::make_unique<MapPart>(part_element.attribute<QString>(literal::name), map);
+	
+	while (xml.readNextStartElement())
+	{
+		if (xml.name() == literal::objects)
+		{
+			XmlElementReader objects_element(xml);
+			auto const num_objects = objects_element.attribute<qint64>(literal::count);
+			auto const offset = objects_element.attribute<qint64>(literal::offset);
+			if (num_objects < 0 || offset < 0 || quint64(offset) > objects_size)
+				throw FileFormatException(tr("The file is damaged."));
+			
+			auto block = QByteArray::fromRawData(objects_data + offset, int(objects_size - quint64(offset)));
+			QDataStream stream(block);
+			setupStream(stream);
+			
+			std::vector<Object*> objects;
+			objects.reserve(std::size_t(qMin(num_objects, qint64(20000)))); // 20000 is not a limit
+			try
+			{
+				for (auto i = qint64(0); i < num_objects; ++i)
+					objects.push_back(importObject(stream));
+			}
+			catch (...)
+			{
+				for (auto* object : objects)
+					delete object;
+				throw;
+			}
+			part->appendLoadedObjects(objects);
+			
+			for (auto* object : objects)
+			{
+				auto const& coords = object->getRawCoordinateVector();
+				if (coords.empty() || !coords.front().isRegular() || !coords.back().isRegular())
+					map->markAsIrregular(object);
+			}
+		}
+		else
+		{
+			xml.skipCurrentElement(); // unknown
+		}
+	}
+	
+	return part.release();
+}
+
+
+Object* BinaryFileImporter::importObject(QDataStream& stream)
+{
+	quint8 type;
+	qint32 symbol_index;
+	double rotation;
+	quint64 first_coord;
+	quint32 count;
+	stream >> type >> symbol_index >> rotation >> first_coord >> count;
+	
+	quint32 num_tags;
+	stream >> num_tags;
+	if (stream.status() != QDataStream::Ok
+	    || first_coord > num_coords
+	    || count > num_coords - first_coord)
+	{
+		throw FileFormatException(tr("The file is damaged."));
+	}
+	
+	KeyValueContainer tags;
+	tags.reserve(std::min(num_tags, quint32(100)));
+	for (auto i = 0u; i < num_tags && stream.status() == QDataStream::Ok; ++i)
+	{
+		KeyValue tag;
+		stream >> tag.key >> tag.value;
+		tags.push_back(tag);
+	}
+	tags.internStrings(map->tagStrings());
+	
+	MapCoordVector coords(count);
+	std::memcpy(coords.data(), coords_data + first_coord * sizeof(MapCoord), count * sizeof(MapCoord));
+	
+	// Like Object::load(), use the symbols for undefined objects
+	// instead of failing on broken files.
+	const Symbol* symbol = symbol_dict.value(symbol_index);
+	std::unique_ptr<Object> object;
+	switch (type)
+	{
+	case Object::Point:
+		{
+			if (!symbol || symbol->getType() != Symbol::Point)
+				symbol = Map::getUndefinedPoint();
+			if (coords.empty())
+				throw FileFormatException(tr("The file is damaged."));
+			auto point = std::make_unique<PointObject>(symbol);
+			point->setPosition(coords.front());
+			object = std::move(point);
+		}
+		break;
+	
+	case Object::Path:
+		{
+			if (!symbol || (symbol->getType() != Symbol::Line && symbol->getType() != Symbol::Area && symbol->getType() != Symbol::Combined))
+				symbol = Map::getUndefinedLine();
+			qint32 x, y;
+			stream >> x >> y;
+			auto path = std::make_unique<PathObject>(symbol, std::move(coords), nullptr);
+			path->setPatternOrigin(MapCoord::fromNative(x, y));
+			object = std::move(path);
+		}
+		break;
+	
+	case Object::Text:
+		{
+			if (!symbol || symbol->getType() != Symbol::Text)
+				symbol = Map::getUndefinedText();
+			if (coords.empty())
+				throw FileFormatException(tr("The file is damaged."));
+			quint8 h_align, v_align;
+			bool single_anchor;
+			qint32 width, height;
+			QString string;
+			stream >> h_align >> v_align >> single_anchor >> width >> height >> string;
+			auto text = std::make_unique<TextObject>(symbol);
+			text->setAnchorPosition(coords.front());
+			if (!single_anchor)
+				text->setBoxSize(MapCoord::fromNative(width, height));
+			text->setHorizontalAlignment(TextObject::HorizontalAlignment(h_align));
+			text->setVerticalAlignment(TextObject::VerticalAlignment(v_align));
+			text->setText(string);
+			object = std::move(text);
+		}
+		break;
+	
+	default:
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Error while loading an object of type %1.").arg(int(type)));
+	}
+	
+	if (stream.status() != QDataStream::Ok)
+		throw FileFormatException(tr("The file is damaged."));
+	
+	if (symbol->isRotatable())
+		object->setRotation(rotation);
+	object->setTags(tags);
+	return object.release();
+}
+
+
+}  // namespace OpenOrienteering
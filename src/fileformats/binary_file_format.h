@@ -0,0 +1,94 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_BINARY_FILE_FORMAT_H
+#define OPENORIENTEERING_BINARY_FILE_FORMAT_H
+
+#include <memory>
+
+#include <QtGlobal>
+
+#include "fileformats/file_format.h"
+
+class QString;
+
+namespace OpenOrienteering {
+
+class Exporter;
+class Importer;
+class Map;
+class MapView;
+
+
+/**
+ * A binary container for the native map format.
+ *
+ * The container starts with a fixed-size header which gives the offsets and
+ * sizes of three sections:
+ *
+ * - An XML section with everything but the map objects, i.e. colors, symbols,
+ *   templates, view and print settings, in the XML file format. The map parts
+ *   in this section refer to blocks of object records.
+ * - An objects section with the object records of all map parts.
+ * - A coordinates section with the raw MapCoord arrays of all objects.
+ *
+ * The coordinates section is aligned so that the file can be memory-mapped
+ * for loading, and the coordinates be copied without decoding.
+ *
+ * The data is in little endian byte order. Thus the format is available only
+ * on little endian systems.
+ */
+class BinaryFileFormat : public FileFormat
+{
+public:
+	/**
+	 * The current version of the container.
+	 */
+	static constexpr quint32 current_version = 1;
+	
+	
+	/**
+	 * Creates a new file format of type OMAPB.
+	 */
+	BinaryFileFormat();
+	
+	
+	/**
+	 * Returns true for data which starts with the container magic.
+	 */
+	ImportSupportAssumption understands(const char* buffer, int size) const override;
+	
+	
+	/**
+	 * Creates an importer for binary map files.
+	 */
+	std::unique_ptr<Importer> makeImporter(const QString& path, Map* map, MapView* view) const override;
+	
+	/**
+	 * Creates an exporter for binary map files.
+	 */
+	std::unique_ptr<Exporter> makeExporter(const QString& path, const Map* map, const MapView* view) const override;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_BINARY_FILE_FORMAT_H
@@ -0,0 +1,97 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_BINARY_FILE_FORMAT_P_H
+#define OPENORIENTEERING_BINARY_FILE_FORMAT_P_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QString>
+
+#include "fileformats/xml_file_format_p.h"
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPart;
+class MapView;
+class Object;
+
+
+/** Map exporter for the binary container format. */
+class BinaryFileExporter : public XMLFileExporter
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::BinaryFileExporter)
+	
+public:
+	BinaryFileExporter(const QString& path, const Map* map, const MapView* view);
+	~BinaryFileExporter() override;
+	
+protected:
+	bool exportImplementation() override;
+	
+	/**
+	 * Writes the part element to the XML section, and the part's objects
+	 * to the objects and coordinates sections.
+	 */
+	void exportMapPart(const MapPart& part) override;
+	
+	void exportObject(const Object& object);
+	
+private:
+	QByteArray objects_data;
+	QByteArray coords_data;
+	QDataStream objects_stream;
+	quint64 num_coords = 0;
+};
+
+
+/** Map importer for the binary container format. */
+class BinaryFileImporter : public XMLFileImporter
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::BinaryFileImporter)
+	
+public:
+	BinaryFileImporter(const QString& path, Map* map, MapView* view);
+	~BinaryFileImporter() override;
+	
+protected:
+	bool importImplementation() override;
+	
+	/**
+	 * Reads the part element from the XML section, and the part's objects
+	 * from the objects and coordinates sections.
+	 */
+	MapPart* importMapPart() override;
+	
+	Object* importObject(QDataStream& stream);
+	
+private:
+	const char* objects_data = nullptr;
+	quint64 objects_size = 0;
+	const char* coords_data = nullptr;
+	quint64 num_coords = 0;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
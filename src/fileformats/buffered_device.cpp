@@ -0,0 +1,306 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "buffered_device.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <QtGlobal>
+#include <QFile>
+#include <QString>
+
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The size of the largest file which is read by prefetchFile()
+constexpr qint64 max_prefetch_size = qint64(256) << 20;
+
+}  // namespace
+
+
+
+// ### ReadAheadDevice ###
+
+ReadAheadDevice::ReadAheadDevice(QIODevice* device, int chunk_size)
+: device(device)
+, chunk_size(std::max(chunk_size, 1))
+{
+	// nothing else
+}
+
+ReadAheadDevice::~ReadAheadDevice()
+{
+	close();
+}
+
+
+bool ReadAheadDevice::isSequential() const
+{
+	return false;
+}
+
+bool ReadAheadDevice::open(OpenMode mode)
+{
+	if ((mode & ReadWrite) != ReadOnly || !device || !device->isReadable() || device->isSequential())
+	{
+		setErrorString(tr("Unsupported mode"));
+		return false;
+	}
+	
+	device_size = device->size();
+	chunk.clear();
+	chunk_offset = device->pos();
+	chunk_pos = 0;
+	if (!QIODevice::open(mode | Unbuffered))
+		return false;
+	// Positions are relative to the start of the underlying device.
+	return QIODevice::seek(chunk_offset);
+}
+
+void ReadAheadDevice::close()
+{
+	dropPendingChunk();
+	chunk.clear();
+	QIODevice::close();
+}
+
+qint64 ReadAheadDevice::size() const
+{
+	return device_size;
+}
+
+bool ReadAheadDevice::seek(qint64 pos)
+{
+	if (!QIODevice::seek(pos))
+		return false;
+	
+	if (pos >= chunk_offset && pos <= chunk_offset + chunk.size())
+	{
+		chunk_pos = int(pos - chunk_offset);
+		return true;
+	}
+	
+	dropPendingChunk();
+	chunk.clear();
+	chunk_offset = pos;
+	chunk_pos = 0;
+	return true;
+}
+
+
+qint64 ReadAheadDevice::readData(char* data, qint64 max_size)
+{
+	qint64 total = 0;
+	while (total < max_size)
+	{
+		if (chunk_pos == chunk.size())
+		{
+			if (!nextChunk())
+				return total > 0 ? total : -1;
+			if (chunk.isEmpty())
+				break;
+		}
+		auto const n = std::min(max_size - total, qint64(chunk.size() - chunk_pos));
+		std::memcpy(data + total, chunk.constData() + chunk_pos, std::size_t(n));
+		chunk_pos += int(n);
+		total += n;
+	}
+	return total;
+}
+
+qint64 ReadAheadDevice::writeData(const char* /*data*/, qint64 /*size*/)
+{
+	return -1;
+}
+
+
+// static
+ReadAheadDevice::Chunk ReadAheadDevice::readChunk(QIODevice* device, qint64 offset, int size)
+{
+	Chunk result;
+	if (device->seek(offset))
+	{
+		result.data.resize(size);
+		auto const n = device->read(result.data.data(), size);
+		result.ok = (n >= 0);
+		result.data.resize(int(std::max(n, qint64(0))));
+	}
+	return result;
+}
+
+bool ReadAheadDevice::nextChunk()
+{
+	chunk_offset += chunk.size();
+	chunk_pos = 0;
+	chunk.clear();
+	if (chunk_offset >= device_size)
+	{
+		dropPendingChunk();
+		return true;
+	}
+	
+	// The pending read, if any, is for the chunk after the current one.
+	auto next = pending.valid() ? pending.get() : readChunk(device, chunk_offset, chunk_size);
+	if (!next.ok)
+	{
+		setErrorString(device->errorString());
+		return false;
+	}
+	chunk = std::move(next.data);
+	
+	auto const next_offset = chunk_offset + chunk.size();
+	if (!chunk.isEmpty() && next_offset < device_size)
+	{
+		auto* const device = this->device;
+		auto const size = chunk_size;
+		pending = Util::startJob<Chunk>([device, next_offset, size]() {
+			return readChunk(device, next_offset, size);
+		}, Util::JobPriority::Interactive);
+	}
+	return true;
+}
+
+void ReadAheadDevice::dropPendingChunk()
+{
+	if (pending.valid())
+		pending.get();
+}
+
+
+
+// ### WriteBehindDevice ###
+
+WriteBehindDevice::WriteBehindDevice(QIODevice* device, int chunk_size)
+: device(device)
+, chunk_size(std::max(chunk_size, 1))
+{
+	// nothing else
+}
+
+WriteBehindDevice::~WriteBehindDevice()
+{
+	close();
+}
+
+
+bool WriteBehindDevice::isSequential() const
+{
+	return true;
+}
+
+bool WriteBehindDevice::open(OpenMode mode)
+{
+	if ((mode & ReadWrite) != WriteOnly || !device || !device->isWritable())
+	{
+		setErrorString(tr("Unsupported mode"));
+		return false;
+	}
+	
+	chunk.clear();
+	chunk.reserve(chunk_size);
+	failed = false;
+	return QIODevice::open(mode | Unbuffered);
+}
+
+void WriteBehindDevice::close()
+{
+	if (isOpen())
+	{
+		finish();
+		QIODevice::close();
+	}
+}
+
+bool WriteBehindDevice::finish()
+{
+	if (!isOpen())
+		return false;
+	
+	return writeChunk() && waitForPendingChunk();
+}
+
+
+qint64 WriteBehindDevice::readData(char* /*data*/, qint64 /*max_size*/)
+{
+	return -1;
+}
+
+qint64 WriteBehindDevice::writeData(const char* data, qint64 size)
+{
+	if (failed)
+		return -1;
+	
+	chunk.append(data, int(size));
+	if (chunk.size() >= chunk_size && !writeChunk())
+		return -1;
+	return size;
+}
+
+
+bool WriteBehindDevice::writeChunk()
+{
+	if (!waitForPendingChunk())
+		return false;
+	
+	if (!chunk.isEmpty())
+	{
+		auto* const device = this->device;
+		pending = Util::startJob<bool>([device, data = std::move(chunk)]() {
+			return device->write(data) == data.size();
+		}, Util::JobPriority::Interactive);
+		chunk = QByteArray();
+		chunk.reserve(chunk_size);
+	}
+	return true;
+}
+
+bool WriteBehindDevice::waitForPendingChunk()
+{
+	if (pending.valid() && !pending.get())
+	{
+		setErrorString(device->errorString());
+		failed = true;
+	}
+	return !failed;
+}
+
+
+
+// ### prefetchFile ###
+
+void prefetchFile(const QString& path)
+{
+	Util::startJob<void>([path]() {
+		QFile file(path);
+		if (!file.open(QIODevice::ReadOnly) || file.size() > max_prefetch_size)
+			return;
+		QByteArray buffer(ReadAheadDevice::default_chunk_size, Qt::Uninitialized);
+		while (file.read(buffer.data(), buffer.size()) > 0)
+			;
+	});
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,217 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_BUFFERED_DEVICE_H
+#define OPENORIENTEERING_BUFFERED_DEVICE_H
+
+#include <future>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QIODevice>
+
+class QString;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A random-access input device which reads the underlying device in large
+ * chunks, and which reads the next chunk on a worker thread.
+ * 
+ * Consumers such as QXmlStreamReader read in small blocks. On slow storage,
+ * e.g. SD cards or content URIs on Android, each small read of a file may
+ * take a long time. This device serves the small reads from memory, while
+ * the next chunk is already read in the background.
+ * 
+ * The underlying device must be open, and it must not be sequential. It must
+ * not be used directly while this device is open.
+ */
+class ReadAheadDevice : public QIODevice
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::ReadAheadDevice)
+	
+public:
+	/**
+	 * The default size of the chunks read from the underlying device.
+	 */
+	static constexpr int default_chunk_size = 1 << 20;
+	
+	/**
+	 * Constructs a device reading from the given device.
+	 */
+	explicit ReadAheadDevice(QIODevice* device, int chunk_size = default_chunk_size);
+	
+	ReadAheadDevice(const ReadAheadDevice&) = delete;
+	ReadAheadDevice(ReadAheadDevice&&) = delete;
+	
+	~ReadAheadDevice() override;
+	
+	ReadAheadDevice& operator=(const ReadAheadDevice&) = delete;
+	ReadAheadDevice& operator=(ReadAheadDevice&&) = delete;
+	
+	
+	bool isSequential() const override;
+	
+	/**
+	 * Opens the device. Only QIODevice::ReadOnly is supported.
+	 * 
+	 * Reading starts at the current position of the underlying device.
+	 */
+	bool open(OpenMode mode) override;
+	
+	/**
+	 * Closes the device, after waiting for a pending read.
+	 */
+	void close() override;
+	
+	qint64 size() const override;
+	
+	bool seek(qint64 pos) override;
+	
+protected:
+	qint64 readData(char* data, qint64 max_size) override;
+	
+	qint64 writeData(const char* data, qint64 size) override;
+	
+private:
+	struct Chunk
+	{
+		QByteArray data;
+		bool ok = false;
+	};
+	
+	static Chunk readChunk(QIODevice* device, qint64 offset, int size);
+	
+	/**
+	 * Replaces the current chunk with the next one, and starts reading ahead.
+	 */
+	bool nextChunk();
+	
+	/**
+	 * Waits for a pending read, and drops its result.
+	 */
+	void dropPendingChunk();
+	
+	QIODevice* const device;
+	int const chunk_size;
+	qint64 device_size = 0;
+	QByteArray chunk;
+	qint64 chunk_offset = 0;
+	int chunk_pos = 0;
+	std::future<Chunk> pending;
+};
+
+
+
+/**
+ * A sequential output device which writes to the underlying device in large
+ * chunks, on a worker thread.
+ * 
+ * The producer of the data, e.g. a QXmlStreamWriter, continues to fill the
+ * next chunk while the previous one is written to slow storage.
+ * 
+ * finish() must be called to write the last chunk. The underlying device is
+ * neither closed nor committed. For a QSaveFile, QSaveFile::commit() flushes
+ * the data to the storage.
+ */
+class WriteBehindDevice : public QIODevice
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::WriteBehindDevice)
+	
+public:
+	/**
+	 * The default size of the chunks written to the underlying device.
+	 */
+	static constexpr int default_chunk_size = 1 << 20;
+	
+	/**
+	 * Constructs a device writing to the given device.
+	 */
+	explicit WriteBehindDevice(QIODevice* device, int chunk_size = default_chunk_size);
+	
+	WriteBehindDevice(const WriteBehindDevice&) = delete;
+	WriteBehindDevice(WriteBehindDevice&&) = delete;
+	
+	~WriteBehindDevice() override;
+	
+	WriteBehindDevice& operator=(const WriteBehindDevice&) = delete;
+	WriteBehindDevice& operator=(WriteBehindDevice&&) = delete;
+	
+	
+	bool isSequential() const override;
+	
+	/**
+	 * Opens the device. Only QIODevice::WriteOnly is supported.
+	 */
+	bool open(OpenMode mode) override;
+	
+	/**
+	 * Writes all pending data, and closes the device.
+	 */
+	void close() override;
+	
+	/**
+	 * Writes all pending data to the underlying device.
+	 * 
+	 * Returns false on error, with the message in errorString().
+	 */
+	bool finish();
+	
+protected:
+	qint64 readData(char* data, qint64 max_size) override;
+	
+	qint64 writeData(const char* data, qint64 size) override;
+	
+private:
+	/**
+	 * Starts writing the collected data, after waiting for a pending write.
+	 */
+	bool writeChunk();
+	
+	/**
+	 * Waits for a pending write, and returns false if any write failed.
+	 */
+	bool waitForPendingChunk();
+	
+	QIODevice* const device;
+	int const chunk_size;
+	QByteArray chunk;
+	std::future<bool> pending;
+	bool failed = false;
+};
+
+
+
+/**
+ * Reads the file at the given path on a background thread, discarding
+ * the data.
+ * 
+ * This brings the contents of files which are going to be loaded soon,
+ * e.g. template images, into the operating system's file cache. Files which
+ * are larger than 256 MiB are skipped, because they are not likely to be
+ * loaded as a whole.
+ */
+void prefetchFile(const QString& path);
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_BUFFERED_DEVICE_H
@@ -1,7 +1,7 @@
 /*
  *    Copyright 2012, 2013 Pete Curtis
  *    Copyright 2013, 2014 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -37,6 +37,7 @@
 #include <QObject>
 #include <QSaveFile>
 #include <QScopedValueRollback>
+#include <QString>
 
 #include "core/georeferencing.h"
 #include "core/map.h"
@@ -47,9 +48,12 @@
 #include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
 #include "core/symbols/symbol.h"
+#include "fileformats/buffered_device.h"
 #include "fileformats/file_format.h"
 #include "templates/template.h"
+#include "templates/template_file_lookup.h"
 #include "templates/template_placeholder.h"
+#include "util/trace.h"
 
 
 namespace OpenOrienteering {
@@ -84,6 +88,22 @@ void ImportExport::setOption(const QString& name, const QVariant& value)
 }
 
 
+void ImportExport::setProgressHandler(ProgressHandler handler)
+{
+	progress_handler = std::move(handler);
+}
+
+
+void ImportExport::reportProgress(int percent)
+{
+	if (progress_handler && !progress_handler(percent))
+	{
+		canceled = true;
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("The operation was canceled."));
+	}
+}
+
+
 // ### Importer ###
 
 Importer::~Importer() = default;
@@ -95,8 +115,16 @@ void Importer::setLoadSymbolsOnly(bool value)
 }
 
 
+void Importer::setObjectUpdatesDeferred(bool value)
+{
+	object_updates_deferred = value;
+}
+
+
 bool Importer::doImport()
 {
+	MAPPER_TRACE_SCOPE("Importer::doImport");
+	
 	std::unique_ptr<QFile> managed_file;
 	QScopedValueRollback<QIODevice*> original_device{device_};
 	if (supportsQIODevice())
@@ -116,18 +144,27 @@ bool Importer::doImport()
 	try
 	{
 		prepare();
-		if (!importImplementation())
+		auto success = false;
+		{
+			MAPPER_TRACE_SCOPE("Importer::importImplementation");
+			success = importImplementation();
+		}
+		if (!success)
 		{
 			Q_ASSERT(!warnings().empty());
 			importFailed();
 			return false;
 		}
+		MAPPER_TRACE_SCOPE("Importer::validate");
 		validate();
 	}
 	catch (std::exception &e)
 	{
 		importFailed();
-		addWarning(tr("Cannot open file\n%1:\n%2").arg(path, QString::fromLocal8Bit(e.what())));
+		if (isCanceled())
+			addWarning(QString::fromLocal8Bit(e.what()));
+		else
+			addWarning(tr("Cannot open file\n%1:\n%2").arg(path, QString::fromLocal8Bit(e.what())));
 		return false;
 	}
 	
@@ -209,6 +246,10 @@ void Importer::validate()
 	}
 	
 	// Template post processing
+	// The candidate directories are listed concurrently, and only once.
+	TemplateFileLookup lookup;
+	lookup.prefetch(*map, path);
+	auto const map_dir = path.isEmpty() ? QString() : QFileInfo(path).absolutePath();
 	bool have_lost_template = false;
 	for (int i = 0; i < map->getNumTemplates(); ++i)
 	{
@@ -243,6 +284,17 @@ void Importer::validate()
 			}
 		}
 		
+		// Visible templates from the map's directory will be loaded soon.
+		// Reading them ahead overlaps the slow storage access with the
+		// remaining work of opening the map.
+		if (view && view->isTemplateVisible(temp)
+		    && temp->getTemplateState() == Template::Unloaded
+		    && !map_dir.isEmpty()
+		    && QFileInfo(temp->getTemplatePath()).absolutePath() == map_dir)
+		{
+			prefetchFile(temp->getTemplatePath());
+		}
+		
 		// Report warnings
 		error_string.append(temp->errorString());
 		if (!error_string.isEmpty())
@@ -268,7 +320,15 @@ void Importer::validate()
 	}
 
 	// Update all objects without trying to remove their renderables first, this gives a significant speedup when loading large files
-	map->updateAllObjects(); // TODO: is the comment above still applicable?
+	if (!object_updates_deferred)
+		map->updateAllObjects(); // TODO: is the comment above still applicable?
+	
+	// Release the excess capacity of coordinates which were appended one by
+	// one, and of the path coords created by the update.
+	map->applyOnAllObjects([](Object* object) {
+		if (object->getType() == Object::Path)
+			object->asPath()->shrinkToFit();
+	});
 }
 
 
@@ -280,6 +340,8 @@ Exporter::~Exporter() = default;
 
 bool Exporter::doExport()
 {
+	MAPPER_TRACE_SCOPE("Exporter::doExport");
+	
 	std::unique_ptr<QSaveFile> managed_file;
 	QScopedValueRollback<QIODevice*> original_device{device_};
 	if (supportsQIODevice())
@@ -300,6 +362,7 @@ bool Exporter::doExport()
 	// Save the map
 	try
 	{
+		MAPPER_TRACE_SCOPE("Exporter::exportImplementation");
 		if (!exportImplementation())
 		{
 			Q_ASSERT(!warnings().empty());
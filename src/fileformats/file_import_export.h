@@ -21,6 +21,7 @@
 #ifndef OPENORIENTEERING_FILE_IMPORT_EXPORT_H
 #define OPENORIENTEERING_FILE_IMPORT_EXPORT_H
 
+#include <functional>
 #include <vector>
 
 #include <QCoreApplication>
@@ -40,7 +41,8 @@ class MapView;
  * Abstract base class for both importer and exporters.
  * 
  * This class provides support for setting and retrieving options, for
- * collecting a list of warnings, and for storing a final error message.
+ * collecting a list of warnings, for storing a final error message, and for
+ * reporting progress to a handler which may cancel the operation.
  * 
  * Subclass constructors need to define default values for options they use,
  * by calling setOption().
@@ -117,6 +119,39 @@ public:
 	 */
 	const std::vector<QString>& warnings() const noexcept { return warnings_; }
 	
+	
+	/**
+	 * A function which receives the progress in percent.
+	 * 
+	 * It returns false in order to cancel the import or export.
+	 */
+	using ProgressHandler = std::function<bool (int)>;
+	
+	/**
+	 * Sets the handler for progress reports.
+	 * 
+	 * The handler is called from the thread which runs the import or export.
+	 * A modal QProgressDialog may be updated directly from the handler.
+	 */
+	void setProgressHandler(ProgressHandler handler);
+	
+	/**
+	 * Returns true when the progress handler canceled the operation.
+	 */
+	bool isCanceled() const noexcept { return canceled; }
+	
+protected:
+	/**
+	 * Reports the progress of the operation, in percent.
+	 * 
+	 * Implementations shall call this function regularly, e.g. after each
+	 * block of objects, at points where the operation may be interrupted.
+	 * 
+	 * This function throws FileFormatException when the handler canceled
+	 * the operation.
+	 */
+	void reportProgress(int percent);
+	
 private:
 	friend class Exporter;  // direct access to device_ in Exporter::doExport()
 	friend class Importer;  // direct access to device_ in Importer::doImport()
@@ -129,6 +164,12 @@ private:
 	
 	/// A list of warnings
 	std::vector<QString> warnings_;
+	
+	/// The receiver of progress reports
+	ProgressHandler progress_handler;
+	
+	/// A flag which is set when the progress handler canceled the operation.
+	bool canceled = false;
 };
 
 
@@ -174,6 +215,19 @@ public:
 	 */
 	void setLoadSymbolsOnly(bool value);
 	
+	/**
+	 * Returns true if the final update of all objects is left to the caller.
+	 */
+	bool objectUpdatesDeferred() const noexcept { return object_updates_deferred; }
+	
+	/**
+	 * If set to true, validate() does not update the objects.
+	 * 
+	 * The caller is expected to update the objects later, e.g. by
+	 * Map::updateAllObjectsDeferred().
+	 */
+	void setObjectUpdatesDeferred(bool value);
+	
 	
 	/**
 	 * Imports the map and view.
@@ -253,6 +307,9 @@ private:
 	/// A flag which controls whether only symbols and colors are imported.
 	bool load_symbols_only = false;
 	
+	/// A flag which controls whether validate() skips the update of all objects.
+	bool object_updates_deferred = false;
+	
 };
 
 
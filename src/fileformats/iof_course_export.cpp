@@ -19,6 +19,8 @@
 
 #include "iof_course_export.h"
 
+#include <cstddef>
+
 #include <Qt>
 #include <QDateTime>
 #include <QLatin1String>
@@ -26,10 +28,8 @@
 #include <QXmlStreamWriter>
 
 #include "mapper_config.h"
-#include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map.h"
-#include "core/map_coord.h"
 #include "core/objects/object.h"
 #include "fileformats/simple_course_export.h"
 #include "util/xml_stream_util.h"
@@ -97,39 +97,32 @@ void IofCourseExport::writeXml(const PathObject& object)
 	}
 	{
 		XmlElementWriter event(*xml, QLatin1String("RaceCourseData"));
-		writeControls(object.getRawCoordinateVector());
-		writeCourse(object.getRawCoordinateVector());
+		auto const positions = simple_course->controlPositions(object);
+		writeControls(positions);
+		writeCourse(positions.size() - 2);
 	}
 }
 
-void IofCourseExport::writeControls(const std::vector<MapCoord>& coords)
+void IofCourseExport::writeControls(const std::vector<LatLon>& positions)
 {
-	auto next = [](auto current) {
-		return current + (current->isCurveStart() ? 3 : 1);
-	};
-	
-	writeControl(coords.front(), QLatin1String("S1"));
+	writeControl(positions.front(), QLatin1String("S1"));
 	auto code_number = simple_course->firstCode();
-	for (auto current = next(coords.begin()); current != coords.end() - 1; current = next(current))
+	for (auto current = positions.begin() + 1; current != positions.end() - 1; ++current)
 	{
 		auto const name = QString::number(code_number);
 		writeControl(*current, name);
 		++code_number;
 	}
-	writeControl(coords.back(), QLatin1String("F1"));
+	writeControl(positions.back(), QLatin1String("F1"));
 }
 
-void IofCourseExport::writeCourse(const std::vector<MapCoord>& coords)
+void IofCourseExport::writeCourse(std::size_t num_controls)
 {
-	auto next = [](auto current) {
-		return current + (current->isCurveStart() ? 3 : 1);
-	};
-	
 	XmlElementWriter event(*xml, QLatin1String("Course"));
 	xml->writeTextElement(QLatin1String("Name"), simple_course->courseName());
 	writeCourseControl(QLatin1String("Start"), QLatin1String("S1"));
 	auto code_number = simple_course->firstCode();
-	for (auto current = next(coords.begin()); current != coords.end() - 1; current = next(current))
+	for (std::size_t i = 0; i < num_controls; ++i)
 	{
 		auto const name = QString::number(code_number);
 		writeCourseControl(QLatin1String("Control"), name);
@@ -138,11 +131,11 @@ void IofCourseExport::writeCourse(const std::vector<MapCoord>& coords)
 	writeCourseControl(QLatin1String("Finish"), QLatin1String("F1"));
 }
 
-void IofCourseExport::writeControl(const MapCoord& coord, const QString& id)
+void IofCourseExport::writeControl(const LatLon& position, const QString& id)
 {
 	XmlElementWriter control(*xml, QLatin1String("Control"));
 	xml->writeTextElement(QLatin1String("Id"), id);
-	writePosition(map->getGeoreferencing().toGeographicCoords(MapCoordF(coord)));
+	writePosition(position);
 }
 
 void IofCourseExport::writeCourseControl(const QString& type, const QString& id)
@@ -20,6 +20,7 @@
 #ifndef OPENORIENTEERING_IOF_COURSE_EXPORT_H
 #define OPENORIENTEERING_IOF_COURSE_EXPORT_H
 
+#include <cstddef>
 #include <vector>
 
 #include "fileformats/file_import_export.h"
@@ -32,7 +33,6 @@ namespace OpenOrienteering {
 class LatLon;
 class Map;
 class MapView;
-class MapCoord;
 class PathObject;
 class SimpleCourseExport;
 
@@ -60,11 +60,11 @@ protected:
 	
 	void writeXml(const PathObject& object);
 	
-	void writeControls(const std::vector<MapCoord>& coords);
+	void writeControls(const std::vector<LatLon>& positions);
 	
-	void writeCourse(const std::vector<MapCoord>& coords);
+	void writeCourse(std::size_t num_controls);
 	
-	void writeControl(const MapCoord& coord, const QString& id);
+	void writeControl(const LatLon& position, const QString& id);
 	
 	void writeCourseControl(const QString& type, const QString& id);
 	
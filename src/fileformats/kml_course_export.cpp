@@ -26,10 +26,8 @@
 #include <QXmlStreamWriter>
 
 #include "mapper_config.h"
-#include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map.h"
-#include "core/map_coord.h"
 #include "core/objects/object.h"
 #include "fileformats/simple_course_export.h"
 #include "util/xml_stream_util.h"
@@ -97,36 +95,32 @@ void KmlCourseExport::writeKml(const PathObject& object)
 			XmlElementWriter folder(*xml, QLatin1String("Folder"));
 			xml->writeTextElement(QLatin1String("name"), simple_course->courseName());
 			xml->writeTextElement(QLatin1String("open"), QLatin1String("1"));
-			writeKmlPlacemarks(object.getRawCoordinateVector());
+			writeKmlPlacemarks(simple_course->controlPositions(object));
 		}
 	}
 }
 
-void KmlCourseExport::writeKmlPlacemarks(const std::vector<MapCoord>& coords)
+void KmlCourseExport::writeKmlPlacemarks(const std::vector<LatLon>& positions)
 {
-	auto next = [](auto current) {
-		return current + (current->isCurveStart() ? 3 : 1);
-	};
-	
-	writeKmlPlacemark(coords.front(), QLatin1String("S1"), QLatin1String("Start"));
+	writeKmlPlacemark(positions.front(), QLatin1String("S1"), QLatin1String("Start"));
 	auto code_number = simple_course->firstCode();
-	for (auto current = next(coords.begin()); current != coords.end() - 1; current = next(current))
+	for (auto current = positions.begin() + 1; current != positions.end() - 1; ++current)
 	{
 		auto const name = QString::number(code_number);
 		writeKmlPlacemark(*current, name, QLatin1String("Control ") + name);
 		++code_number;
 	}
-	writeKmlPlacemark(coords.back(), QLatin1String("F1"), QLatin1String("Finish"));
+	writeKmlPlacemark(positions.back(), QLatin1String("F1"), QLatin1String("Finish"));
 }
 
-void KmlCourseExport::writeKmlPlacemark(const MapCoord& coord, const QString& name, const QString& description)
+void KmlCourseExport::writeKmlPlacemark(const LatLon& position, const QString& name, const QString& description)
 {
 	XmlElementWriter placemark(*xml, QLatin1String("Placemark"));
 	xml->writeTextElement(QLatin1String("name"), name);
 	xml->writeTextElement(QLatin1String("description"), description);
 	{
 		XmlElementWriter point(*xml, QLatin1String("Point"));
-		writeCoordinates(map->getGeoreferencing().toGeographicCoords(MapCoordF(coord)));
+		writeCoordinates(position);
 	}
 }
 
@@ -31,7 +31,6 @@ namespace OpenOrienteering {
 
 class LatLon;
 class Map;
-class MapCoord;
 class MapView;
 class PathObject;
 class SimpleCourseExport;
@@ -60,9 +59,9 @@ protected:
 	
 	void writeKml(const PathObject& object);
 	
-	void writeKmlPlacemarks(const std::vector<MapCoord>& coords);
+	void writeKmlPlacemarks(const std::vector<LatLon>& positions);
 	
-	void writeKmlPlacemark(const MapCoord& coord, const QString& name, const QString& description);
+	void writeKmlPlacemark(const LatLon& position, const QString& name, const QString& description);
 	
 	void writeCoordinates(const LatLon& latlon);
 	
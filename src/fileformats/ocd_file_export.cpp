@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <utility>
 #include <stdexcept>
 #include <type_traits>
@@ -79,6 +80,7 @@
 #include "fileformats/ocd_file_format.h"
 #include "fileformats/ocd_georef_fields.h"
 #include "fileformats/ocd_icon.h"
+#include "fileformats/ocd_point_codec.h"
 #include "fileformats/ocd_types.h"
 #include "fileformats/ocd_types_v8.h"
 #include "fileformats/ocd_types_v9.h"
@@ -87,6 +89,7 @@
 #include "templates/template.h"
 #include "templates/template_map.h"
 #include "util/encoding.h"
+#include "util/parallel.h"
 #include "util/util.h"
 
 
@@ -366,46 +369,14 @@ bool maybeMainLine(const LineSymbol* line)
 
 
 
-/**
- * Efficiently convert a single coordinate value to the OCD format.
- * 
- * This function handles two responsibilities at the same time,
- * in a constexpr implementation:
- * 
- * - convert from 1/100 mm to 1/10 mm, rounding half up (for intervals of equal size),
- * - shift by 8 bits (which are reserved for flags in OCD format).
- *
- * Neither rounding (the result of an integer division) half up 
- * nor shifting of signed integers ("implementation-defined")
- * come out of the box in C++.
- */
-constexpr qint32 convertPointMember(qint32 value)
-{
-	return (value < -5) ? qint32(0x80000000u | ((0x7fffffu & quint32((value-4)/10)) << 8)) : qint32((0x7fffffu & quint32((value+5)/10)) << 8);
-}
-
-// convertPointMember() shall round half up.
-Q_STATIC_ASSERT(convertPointMember(-16) == qint32(0xfffffe00u)); // __ down __
-Q_STATIC_ASSERT(convertPointMember(-15) == qint32(0xffffff00u)); //     up
-Q_STATIC_ASSERT(convertPointMember( -6) == qint32(0xffffff00u)); // __ down __
-Q_STATIC_ASSERT(convertPointMember( -5) == qint32(0x00000000u)); //     up
-Q_STATIC_ASSERT(convertPointMember( -1) == qint32(0x00000000u)); //     up
-Q_STATIC_ASSERT(convertPointMember(  0) == qint32(0x00000000u)); //  unchanged
-Q_STATIC_ASSERT(convertPointMember( +1) == qint32(0x00000000u)); //    down
-Q_STATIC_ASSERT(convertPointMember( +4) == qint32(0x00000000u)); // __ down __
-Q_STATIC_ASSERT(convertPointMember( +5) == qint32(0x00000100u)); //     up
-Q_STATIC_ASSERT(convertPointMember(+14) == qint32(0x00000100u)); // __ down __
-Q_STATIC_ASSERT(convertPointMember(+15) == qint32(0x00000200u)); //     up
-
-
 /**
  * Convert a pair of coordinates to a point in OCD format.
  * 
- * \see convertPointMember()
+ * \see Ocd::encodeCoordinate()
  */
 Ocd::OcdPoint32 convertPoint(qint32 x, qint32 y)
 {
-	return { convertPointMember(x), convertPointMember(-y) };
+	return { Ocd::encodeCoordinate(x), Ocd::encodeCoordinate(-y) };
 }
 
 
@@ -414,7 +385,7 @@ Ocd::OcdPoint32 convertPoint(qint32 x, qint32 y)
  * 
  * This function does not deal with flags.
  * 
- * \see convertPointMember()
+ * \see Ocd::encodeCoordinate()
  */
 Ocd::OcdPoint32 convertPoint(const MapCoord& coord)
 {
@@ -686,6 +657,20 @@ void setupFileHeaderGeneric(quint16 actual_version, Ocd::FileHeaderGeneric& head
 	}
 }
 
+
+/**
+ * An object which is encoded for the OCD export.
+ * 
+ * A single object may result in multiple OCD objects.
+ */
+template< class IndexEntryType >
+struct PendingObject
+{
+	const Object* object;
+	std::vector<std::pair<QByteArray, IndexEntryType>> records;
+	QString error;
+};
+
 } // namespace
 
 
@@ -2435,47 +2420,101 @@ QByteArray OcdFileExport::exportCombinedLineSymbol(
 template<class Format>
 void OcdFileExport::exportObjects(OcdFile<Format>& file)
 {
+	using IndexEntryType = typename Format::Object::IndexEntryType;
+	
+	std::vector<std::unique_ptr<Object>> duplicates;
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(map->getNumObjects()));
 	for (int l = 0; l < map->getNumParts(); ++l)
 	{
 		auto part = map->getPart(std::size_t(l));
 		for (int o = 0; o < part->getNumObjects(); ++o)
 		{
 			const auto* object = part->getObject(o);
-			
-			std::unique_ptr<Object> duplicate;
 			if (area_offset.nativeX() != 0 || area_offset.nativeY() != 0)
 			{
 				// Create a safely managed duplicate and move it as needed.
-				duplicate.reset(object->duplicate());
-				duplicate->move(-area_offset);  /// \todo move pattern origin etc.
-				object = duplicate.get();
+				duplicates.emplace_back(object->duplicate());
+				duplicates.back()->move(-area_offset);  /// \todo move pattern origin etc.
+				object = duplicates.back().get();
 			}
-			object->update();
-			
-			QByteArray ocd_object;
-			auto entry = typename Format::Object::IndexEntryType {};
+			objects.push_back(object);
+		}
+	}
+	Object::updateAll(objects);
+	
+	std::vector<PendingObject<IndexEntryType>> pending;
+	pending.reserve(objects.size());
+	for (const auto* object : objects)
+		pending.push_back({object, {}, {}});
+	
+	// Points and paths are encoded concurrently, into separate buffers.
+	// Texts depend on font data, and they may add warnings.
+	Util::parallelFor(pending.size(), 64, [this, &pending](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			auto& item = pending[i];
+			try
+			{
+				switch (item.object->getType())
+				{
+				case Object::Point:
+					item.records.emplace_back();
+					item.records.back().first = exportPointObject<typename Format::Object>(static_cast<const PointObject*>(item.object), item.records.back().second);
+					FILEFORMAT_ASSERT(!item.records.back().first.isEmpty());
+					break;
+					
+				case Object::Path:
+					exportPathObject<Format>(static_cast<const PathObject*>(item.object), item.records);
+					break;
+					
+				case Object::Text:
+					break;
+				}
+			}
+			catch (FileFormatException& e)
+			{
+				item.error = e.message();
+			}
+		}
+	});
+	
+	for (auto& item : pending)
+	{
+		switch (item.object->getType())
+		{
+		case Object::Point:
+			break;
 			
-			switch (object->getType())
+		case Object::Path:
+			if (item.object->getSymbol()
+			    && item.object->getSymbol()->getType() == Symbol::Area
+			    && static_cast<const PathObject*>(item.object)->getPatternOrigin() != MapCoord(0, 0))
 			{
-			case Object::Point:
-				ocd_object = exportPointObject<typename Format::Object>(static_cast<const PointObject*>(object), entry);
-				FILEFORMAT_ASSERT(!ocd_object.isEmpty());
-				file.objects().insert(ocd_object, entry);
-				break;
-				
-			case Object::Path:
-				exportPathObject<Format>(file, static_cast<const PathObject*>(object));
-				break;
-				
-			case Object::Text:
-				ocd_object = exportTextObject<typename Format::Object>(static_cast<const TextObject*>(object), entry);
-				FILEFORMAT_ASSERT(!ocd_object.isEmpty());
-				file.objects().insert(ocd_object, entry);
-				break;
+				addWarning(::OpenOrienteering::OcdFileExport::tr("Unable to export fill pattern shift for an area object"));
 			}
+			break;
 			
+		case Object::Text:
+			item.records.emplace_back();
+			item.records.back().first = exportTextObject<typename Format::Object>(static_cast<const TextObject*>(item.object), item.records.back().second);
+			FILEFORMAT_ASSERT(!item.records.back().first.isEmpty());
+			break;
 		}
+		if (!item.error.isEmpty())
+			throw FileFormatException(item.error);
 	}
+	duplicates.clear();
+	
+	// All encoded objects are added to the file in a single pass.
+	std::vector<std::pair<QByteArray, IndexEntryType>> records;
+	records.reserve(std::accumulate(begin(pending), end(pending), std::size_t(0), [](std::size_t sum, const auto& item) {
+		return sum + item.records.size();
+	}));
+	for (auto& item : pending)
+		std::move(begin(item.records), end(item.records), std::back_inserter(records));
+	pending.clear();
+	file.objects().insert(records);
 }
 
 
@@ -2521,7 +2560,7 @@ QByteArray OcdFileExport::exportPointObject(const PointObject* point, typename O
 
 
 template< class Format >
-void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* path, bool lines_only)
+void OcdFileExport::exportPathObject(const PathObject* path, std::vector<std::pair<QByteArray, typename Format::Object::IndexEntryType>>& records, bool lines_only)
 {
 	typename Format::Object ocd_object = {};
 	typename Format::Object::IndexEntryType entry = {};
@@ -2537,8 +2576,6 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 		{
 			if (static_cast<const AreaSymbol*>(symbol)->hasRotatableFillPattern())
 				ocd_object.angle = decltype(ocd_object.angle)(convertRotation(path->getPatternRotation()));
-			if (path->getPatternOrigin() != MapCoord(0, 0))
-				addWarning(::OpenOrienteering::OcdFileExport::tr("Unable to export fill pattern shift for an area object"));
 		}
 	}
 	else
@@ -2560,7 +2597,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 		if (breakdown_index_entry == end(breakdown_index))
 		{
 			// Regular symbol which does not need to be split
-			file.objects().insert(data, entry);
+			records.emplace_back(data, entry);
 			return;
 		}
 		
@@ -2595,7 +2632,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 				exported_ocd_object.symbol = entry.symbol = decltype(entry.symbol)(breakdown->number);
 				exported_ocd_object.type = decltype(exported_ocd_object.type)(breakdown->type);
 				handleObjectExtras(path, exported_ocd_object, entry);  // update entry.type if it exists
-				file.objects().insert(data, entry);
+				records.emplace_back(data, entry);
 			}
 			
 			if (backlog.empty())
@@ -2613,7 +2650,7 @@ void OcdFileExport::exportPathObject(OcdFile<Format>& file, const PathObject* pa
 			PathObject split_line{part};
 			split_line.setSymbol(path->getSymbol(), true);
 			split_line.update();
-			exportPathObject(file, &split_line, true);
+			exportPathObject<Format>(&split_line, records, true);
 		}
 	}
 	
@@ -2947,50 +2984,34 @@ quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Sym
 
 quint16 OcdFileExport::exportCoordinates(const MapCoordVector& coords, const Symbol* symbol, QByteArray& byte_array, MapCoord& bottom_left, MapCoord& top_right)
 {
-	quint16 num_points = 0;
-	bool curve_start = false;
-	bool hole_point = false;
-	bool curve_continue = false;
+	auto min_x = bottom_left.nativeX();
+	auto max_y = bottom_left.nativeY();
+	auto max_x = top_right.nativeX();
+	auto min_y = top_right.nativeY();
 	for (const auto& point : coords)
 	{
-		if (point.nativeX() < bottom_left.nativeX())
-			bottom_left.setNativeX(point.nativeX());
-		else if (point.nativeX() > top_right.nativeX())
-			top_right.setNativeX(point.nativeX());
-		if (point.nativeY() > bottom_left.nativeY())
-			bottom_left.setNativeY(point.nativeY());
-		else if (point.nativeY() < top_right.nativeY())
-			top_right.setNativeY(point.nativeY());
-		
-		auto p = convertPoint(point);
-		if (point.isDashPoint())
-		{
-			if (!symbol || symbol->getType() != Symbol::Line)
-				p.y |= Ocd::OcdPoint32::FlagCorner;
-			else
-			{
-				const LineSymbol* line_symbol = static_cast<const LineSymbol*>(symbol);
-				if ((line_symbol->getDashSymbol() == nullptr || line_symbol->getDashSymbol()->isEmpty()) && line_symbol->isDashed())
-					p.y |= Ocd::OcdPoint32::FlagDash;
-				else
-					p.y |= Ocd::OcdPoint32::FlagCorner;
-			}
-		}
-		if (curve_start)
-			p.x |= Ocd::OcdPoint32::FlagCtl1;
-		if (hole_point)
-			p.y |= Ocd::OcdPoint32::FlagHole;
-		if (curve_continue)
-			p.x |= Ocd::OcdPoint32::FlagCtl2;
-		
-		curve_continue = curve_start;
-		curve_start = point.isCurveStart();
-		hole_point = point.isHolePoint();
-		
-		byte_array.append(reinterpret_cast<const char*>(&p), sizeof(p));
-		++num_points;
+		min_x = std::min(min_x, point.nativeX());
+		max_x = std::max(max_x, point.nativeX());
+		min_y = std::min(min_y, point.nativeY());
+		max_y = std::max(max_y, point.nativeY());
 	}
-	return num_points;
+	bottom_left.setNativeX(min_x);
+	bottom_left.setNativeY(max_y);
+	top_right.setNativeX(max_x);
+	top_right.setNativeY(min_y);
+	
+	auto dash_flag = qint32(Ocd::OcdPoint32::FlagCorner);
+	if (symbol && symbol->getType() == Symbol::Line)
+	{
+		const LineSymbol* line_symbol = static_cast<const LineSymbol*>(symbol);
+		if ((line_symbol->getDashSymbol() == nullptr || line_symbol->getDashSymbol()->isEmpty()) && line_symbol->isDashed())
+			dash_flag = Ocd::OcdPoint32::FlagDash;
+	}
+	
+	auto const offset = byte_array.size();
+	byte_array.resize(offset + int(coords.size() * sizeof(Ocd::OcdPoint32)));
+	Ocd::encodePoints(coords.data(), coords.data() + coords.size(), byte_array.data() + offset, dash_flag);
+	return quint16(coords.size());
 }
 
 
@@ -27,6 +27,7 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <QtGlobal>
@@ -265,7 +266,7 @@ protected:
 	QByteArray exportPointObject(const PointObject* point, typename OcdObject::IndexEntryType& entry);
 	
 	template< class Format >
-	void exportPathObject(OcdFile<Format>& file, const PathObject* path, bool lines_only = false);
+	void exportPathObject(const PathObject* path, std::vector<std::pair<QByteArray, typename Format::Object::IndexEntryType>>& records, bool lines_only = false);
 	
 	template< class OcdObject >
 	QByteArray exportTextObject(const TextObject* text, typename OcdObject::IndexEntryType& entry);
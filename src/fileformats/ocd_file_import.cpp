@@ -24,11 +24,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iterator>
 #include <limits>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <Qt>
@@ -39,6 +41,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QFileDevice>
 #include <QFlags>
 #include <QFontMetricsF>
 #include <QIODevice>
@@ -70,6 +73,7 @@
 #include "fileformats/ocd_georef_fields.h"
 #include "fileformats/ocd_icon.h"
 #include "fileformats/ocd_parameter_stream_reader.h"
+#include "fileformats/ocd_point_codec.h"
 #include "fileformats/ocd_types_v8.h"
 #include "fileformats/ocd_types_v9.h"
 #include "fileformats/ocd_types_v10.h"
@@ -80,6 +84,7 @@
 #include "templates/template_map.h"
 #include "templates/template_placeholder.h"
 #include "util/encoding.h"
+#include "util/parallel.h"
 #include "util/util.h"
 
 
@@ -95,6 +100,49 @@ static QTextCodec* codecFromSettings()
 }	
 
 
+/**
+ * Provides the contents of a device in a byte array, for the duration of
+ * the import.
+ * 
+ * If the device is a file which can be memory-mapped, the byte array is
+ * set up on the mapped data, so that the contents are not copied.
+ * Otherwise the contents are read into the byte array.
+ */
+class ImportBuffer
+{
+public:
+	ImportBuffer(QIODevice* device, QByteArray& buffer)
+	: buffer(buffer)
+	, file(qobject_cast<QFileDevice*>(device))
+	{
+		auto const size = file ? file->size() : 0;
+		if (size > 0 && size <= std::numeric_limits<int>::max())
+			data = file->map(0, size);
+		if (data)
+			buffer = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(size));
+		else
+			buffer = device->readAll();
+	}
+	
+	ImportBuffer(const ImportBuffer&) = delete;
+	ImportBuffer& operator=(const ImportBuffer&) = delete;
+	
+	~ImportBuffer()
+	{
+		if (data)
+		{
+			buffer.clear();
+			file->unmap(data);
+		}
+	}
+	
+private:
+	QByteArray& buffer;
+	QFileDevice* const file;
+	uchar* data = nullptr;
+};
+
+
 }  // namespace
 
 
@@ -184,20 +232,7 @@ QString OcdFileImport::convertOcdString(const QChar* src, uint maxlen) const
 
 MapCoord OcdFileImport::convertOcdPoint(const Ocd::OcdPoint32& ocd_point) const
 {
-	qint32 ocad_x = ocd_point.x >> 8;
-	qint32 ocad_y = ocd_point.y >> 8;
-	// Recover from broken coordinate export from Mapper 0.6.2 ... 0.6.4 (#749)
-	// Cf. broken::convertPointMember in file_format_ocad8.cpp:
-	// The values -4 ... -1 (-0.004 mm ... -0.001 mm) were converted to 0x80000000u instead of 0.
-	// This is the maximum value. Thus it is okay to assume it won't occur in regular data,
-	// and we can safely replace it with 0 here.
-	// But the input parameter were already subject to right shift ...
-	constexpr auto invalid_value = qint32(0x80000000u) >> 8; // ... so we use this value here.
-	if (ocad_x == invalid_value)
-		ocad_x = 0;
-	if (ocad_y == invalid_value)
-		ocad_y = 0;
-	return MapCoord::fromNative(ocad_x * 10, ocad_y * -10);
+	return Ocd::decodePosition(ocd_point);
 }
 
 
@@ -635,7 +670,7 @@ void OcdFileImport::importColor(const QString& param_string)
 	float opacity = 1.0f;
 	
 	SpotColorComponents components;
-	QString spot_color_name;
+	QStringRef spot_color_name;
 	
 	while (parameters.readNext())
 	{
@@ -679,7 +714,7 @@ void OcdFileImport::importColor(const QString& param_string)
 				opacity = 0.01f * f_value;
 			break;
 		case 's':
-			spot_color_name = param_value.toString();
+			spot_color_name = param_value;
 			break;
 		case 'p':
 			if (!spot_color_name.isEmpty())
@@ -797,12 +832,26 @@ void OcdFileImport::importSymbols(const OcdFile< F >& file)
 	}
 	resolveSubsymbols();
 	
+	// Custom icons are decoded only if Mapper cannot reproduce them.
+	std::vector<std::pair<Symbol*, const typename F::BaseSymbol*>> custom_icons;
 	for (auto ocd_symbol_entry : file.symbols())
 	{
 		auto& ocd_symbol = *ocd_symbol_entry.entity;
 		if (symbol_index.contains(ocd_symbol.number))
-			dropRedundantIcon(symbol_index[ocd_symbol.number], ocd_symbol);
+		{
+			auto* symbol = symbol_index[ocd_symbol.number];
+			if (!isRedundantIcon(symbol, ocd_symbol))
+				custom_icons.emplace_back(symbol, &ocd_symbol);
+		}
 	}
+	
+	std::vector<QImage> icons(custom_icons.size());
+	Util::parallelFor(custom_icons.size(), 8, [&custom_icons, &icons](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			icons[i] = decodeIcon(*custom_icons[i].second);
+	});
+	for (std::size_t i = 0; i < custom_icons.size(); ++i)
+		custom_icons[i].first->setCustomIcon(icons[i]);
 }
 
 void OcdFileImport::resolveSubsymbols()
@@ -831,14 +880,13 @@ void OcdFileImport::importObjects(const OcdFile<Ocd::FormatV8>& file)
 	MapPart* part = map->getCurrentPart();
 	FILEFORMAT_ASSERT(part);
 	
+	std::vector<const Ocd::ObjectV8*> ocd_objects;
 	for (auto ocd_object : file.objects())
 	{
 		if (ocd_object.entry->symbol)
-		{
-			if (auto object = importObject(*ocd_object.entity, part))
-				part->addObject(object, part->getNumObjects());
-		}
+			ocd_objects.push_back(ocd_object.entity);
 	}
+	importObjects(ocd_objects, part);
 }
 
 template< class F >
@@ -847,16 +895,101 @@ void OcdFileImport::importObjects(const OcdFile< F >& file)
 	MapPart* part = map->getCurrentPart();
 	FILEFORMAT_ASSERT(part);
 	
+	std::vector<const typename F::Object*> ocd_objects;
 	for (auto ocd_object : file.objects())
 	{
 		if ( ocd_object.entry->symbol
 		     && ocd_object.entry->status != Ocd::ObjectDeleted
 		     && ocd_object.entry->status != Ocd::ObjectDeletedForUndo )
 		{
-			if (auto object = importObject(*ocd_object.entity, part))
-				part->addObject(object, part->getNumObjects());
+			ocd_objects.push_back(ocd_object.entity);
+		}
+	}
+	importObjects(ocd_objects, part);
+}
+
+template< class O >
+void OcdFileImport::importObjects(const std::vector<const O*>& ocd_objects, MapPart* part)
+{
+	struct PendingObject
+	{
+		const O* ocd_object;
+		Symbol* symbol;
+		Object* object;
+	};
+	
+	std::vector<PendingObject> pending;
+	pending.reserve(ocd_objects.size());
+	for (auto const* ocd_object : ocd_objects)
+		pending.push_back({ocd_object, importObjectSymbol(*ocd_object), nullptr});
+	
+	// The objects are converted in blocks, with a progress report after each block.
+	auto const block_size = std::size_t(4096);
+	for (std::size_t block = 0; block < pending.size(); block += block_size)
+	{
+		auto const block_end = std::min(pending.size(), block + block_size);
+		Util::parallelFor(block_end - block, 64, [this, &pending, block](std::size_t begin, std::size_t end) {
+			for (auto i = block + begin; i < block + end; ++i)
+			{
+				auto& item = pending[i];
+				if (item.symbol
+				    && !(item.symbol->getType() == Symbol::Line && rectangle_info.contains(item.ocd_object->symbol)))
+				{
+					item.object = importObject(*item.ocd_object, item.symbol);
+				}
+			}
+		});
+		
+		try
+		{
+			reportProgress(int(99 * block_end / pending.size()));
+		}
+		catch (...)
+		{
+			for (auto& item : pending)
+				delete item.object;
+			throw;
+		}
+	}
+	
+	// Rectangle objects and warnings are handled in order.
+	std::vector<Object*> objects;
+	objects.reserve(pending.size());
+	for (auto& item : pending)
+	{
+		auto const& ocd_object = *item.ocd_object;
+		auto* object = item.object;
+		if (!item.symbol)
+		{
+			addWarning(OcdFileImport::tr("Unable to load object"));
+			qDebug() << "Undefined object type" << ocd_object.type << " for object of symbol" << ocd_object.symbol;
 		}
+		else if (item.symbol->getType() == Symbol::Line && rectangle_info.contains(ocd_object.symbol))
+		{
+			// Grid objects are added to the part directly.
+			part->appendLoadedObjects(objects);
+			objects.clear();
+			object = importRectangleObject(ocd_object, part, rectangle_info[ocd_object.symbol]);
+			if (!object)
+				addWarning(OcdFileImport::tr("Unable to import rectangle object"));
+		}
+		else if (item.symbol->getType() == Symbol::Text)
+		{
+			// Text objects need special path translation
+			auto* text = static_cast<TextObject*>(object);
+			if (!fillTextPathCoords(text, reinterpret_cast<TextSymbol*>(item.symbol), ocd_object.num_items, reinterpret_cast<const Ocd::OcdPoint32 *>(ocd_object.coords)))
+			{
+				addWarning(OcdFileImport::tr("Not importing text symbol, couldn't figure out path' (npts=%1): %2")
+				           .arg(ocd_object.num_items).arg(text->getText()));
+				delete text;
+				object = nullptr;
+			}
+		}
+		
+		if (object)
+			objects.push_back(object);
 	}
+	part->appendLoadedObjects(objects);
 }
 
 
@@ -1064,71 +1197,54 @@ void OcdFileImport::setupBaseSymbol(Symbol* symbol, const OcdBaseSymbol& ocd_bas
 	symbol->setIsHelperSymbol(false);
 	symbol->setProtected(ocd_base_symbol.status & Ocd::SymbolProtected);
 	symbol->setHidden(ocd_base_symbol.status & Ocd::SymbolHidden);
-	setupIcon(symbol, ocd_base_symbol);
 }
 
 
-template< >
-void OcdFileImport::setupIcon<Ocd::BaseSymbolV8>(Symbol* symbol, const Ocd::BaseSymbolV8& ocd_base_symbol)
+template<>
+bool OcdFileImport::isRedundantIcon<Ocd::BaseSymbolV8>(const Symbol* symbol, const Ocd::BaseSymbolV8& ocd_base_symbol)
 try
 {
+	// The comparison is done in OCD format, due to the limited color palette.
+	auto ocd_icon = OcdIcon{*map, *symbol};
 	if (ocd_base_symbol.flags & Ocd::SymbolIconCompressedV8)
-		symbol->setCustomIcon(OcdIcon::toQImage(ocd_base_symbol.icon.uncompress()));
-	else
-		symbol->setCustomIcon(OcdIcon::toQImage(ocd_base_symbol.icon));
+		return ocd_base_symbol.icon.uncompress() == ocd_icon;
+	return ocd_base_symbol.icon == ocd_icon;
 }
 catch (std::logic_error& e)
 {
+	// There is no icon which could be imported.
 	addWarning(tr(e.what()));
+	return true;
 }
 
-template< class OcdBaseSymbol >
-void OcdFileImport::setupIcon(Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol)
+template<class OcdBaseSymbol>
+bool OcdFileImport::isRedundantIcon(const Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol)
 {
-	symbol->setCustomIcon(OcdIcon::toQImage(ocd_base_symbol.icon));
+	// The comparison is done in OCD format, due to the limited color palette.
+	return ocd_base_symbol.icon == OcdIcon{*map, *symbol};
 }
 
 
 template<>
-void OcdFileImport::dropRedundantIcon<Ocd::BaseSymbolV8>(Symbol* symbol, const Ocd::BaseSymbolV8& ocd_base_symbol)
+QImage OcdFileImport::decodeIcon<Ocd::BaseSymbolV8>(const Ocd::BaseSymbolV8& ocd_base_symbol)
 try
 {
-	const auto imported = symbol->getCustomIcon();
-	if (imported.isNull())
-		return;
-	
-	// The comparison is done in OCD format, due to the limited color palette.
-	symbol->setCustomIcon({});
-	auto ocd_icon = OcdIcon{*map, *symbol};
 	if (ocd_base_symbol.flags & Ocd::SymbolIconCompressedV8)
-	{
-		if (ocd_base_symbol.icon.uncompress() != ocd_icon)
-			symbol->setCustomIcon(imported);
-	}
-	else
-	{
-		if (ocd_base_symbol.icon != ocd_icon)
-			symbol->setCustomIcon(imported);
-	}
+		return OcdIcon::toQImage(ocd_base_symbol.icon.uncompress());
+	return OcdIcon::toQImage(ocd_base_symbol.icon);
 }
 catch (std::logic_error&)
 {
 	// In general, ocd_base_symbol.icon.uncompress() can throw. But here,
-	// it is called after successful icon import - which indicates that
-	// uncompress() does not fail for ocd_base_symbol.icon.
+	// it is called after a successful comparison in isRedundantIcon() -
+	// which indicates that uncompress() does not fail for this icon.
+	return {};
 }
 
 template<class OcdBaseSymbol>
-void OcdFileImport::dropRedundantIcon(Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol)
+QImage OcdFileImport::decodeIcon(const OcdBaseSymbol& ocd_base_symbol)
 {
-	const auto imported = symbol->getCustomIcon();
-	if (imported.isNull())
-		return;
-	
-	// The comparison is done in OCD format, due to the limited color palette.
-	symbol->setCustomIcon({});
-	if (ocd_base_symbol.icon != OcdIcon{*map, *symbol})
-		symbol->setCustomIcon(imported);
+	return OcdIcon::toQImage(ocd_base_symbol.icon);
 }
 
 
@@ -1854,12 +1970,12 @@ void OcdFileImport::setupPointSymbolPattern(PointSymbol* symbol, std::size_t dat
 }
 
 template< class O >
-Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
+Symbol* OcdFileImport::importObjectSymbol(const O& ocd_object)
 {
 	Symbol* symbol = nullptr;
 	if (ocd_object.symbol >= 0)
 	{
-		symbol = symbol_index[ocd_object.symbol];
+		symbol = symbol_index.value(ocd_object.symbol);
 	}
 	
 	if (!symbol)
@@ -1878,39 +1994,32 @@ Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
 			symbol = map->getUndefinedText();
 			break;
 		default:
-			addWarning(OcdFileImport::tr("Unable to load object"));
-			qDebug() << "Undefined object type" << ocd_object.type << " for object of symbol" << ocd_object.symbol;
 			return nullptr;
 		}
 	}
-		
-	if (symbol->getType() == Symbol::Line && rectangle_info.contains(ocd_object.symbol))
+	
+	if (symbol->getType() == Symbol::Point && ocd_object.angle != 0)
 	{
-		Object* object = importRectangleObject(ocd_object, part, rectangle_info[ocd_object.symbol]);
-		if (!object)
-			addWarning(OcdFileImport::tr("Unable to import rectangle object"));
-		return object;
+		// extra properties: rotation
+		auto point_symbol = reinterpret_cast<PointSymbol*>(symbol);
+		if (!point_symbol->isRotatable() && !point_symbol->isSymmetrical())
+			point_symbol->setRotatable(true);
 	}
 	
+	return symbol;
+}
+
+template< class O >
+Object* OcdFileImport::importObject(const O& ocd_object, Symbol* symbol)
+{
 	if (symbol->getType() == Symbol::Point)
 	{
 		auto p = new PointObject();
 		p->setSymbol(symbol, true);
 		
 		// extra properties: rotation
-		auto point_symbol = reinterpret_cast<PointSymbol*>(symbol);
-		if (point_symbol->isRotatable())
-		{
+		if (symbol->isRotatable())
 			p->setRotation(convertAngle(ocd_object.angle));
-		}
-		else if (ocd_object.angle != 0)
-		{
-			if (!point_symbol->isSymmetrical())
-			{
-				point_symbol->setRotatable(true);
-				p->setRotation(convertAngle(ocd_object.angle));
-			}
-		}
 		
 		const MapCoord pos = convertOcdPoint(ocd_object.coords[0]);
 		p->setPosition(pos.nativeX(), pos.nativeY());
@@ -1924,16 +2033,7 @@ Object* OcdFileImport::importObject(const O& ocd_object, MapPart* part)
 		t->setText(getObjectText(ocd_object));
 		t->setRotation(convertAngle(ocd_object.angle));
 		t->setHorizontalAlignment(text_halign_map.value(symbol));
-		// Vertical alignment is set in fillTextPathCoords().
-		
-		// Text objects need special path translation
-		if (!fillTextPathCoords(t, reinterpret_cast<TextSymbol*>(symbol), ocd_object.num_items, reinterpret_cast<const Ocd::OcdPoint32 *>(ocd_object.coords)))
-		{
-			addWarning(OcdFileImport::tr("Not importing text symbol, couldn't figure out path' (npts=%1): %2")
-			           .arg(ocd_object.num_items).arg(t->getText()));
-			delete t;
-			return nullptr;
-		}
+		// Position and vertical alignment are set in fillTextPathCoords().
 		t->setMap(map);
 		return t;
 	}
@@ -2142,28 +2242,25 @@ void OcdFileImport::setPathHolePoint(OcdImportedPathObject *object, quint32 pos)
 		object->coords[pos].setHolePoint(true);
 }
 
-void OcdFileImport::setPointFlags(OcdImportedPathObject* object, quint32 pos, bool is_area, const Ocd::OcdPoint32& ocd_point)
-{
-	// We can support CurveStart, HolePoint, DashPoint.
-	// CurveStart needs to be applied to the main point though, not the control point, and
-	// hole points need to bet set as the last point of a part of an area object instead of the first point of the next part
-	if (ocd_point.x & Ocd::OcdPoint32::FlagCtl1 && pos > 0)
-		object->coords[pos-1].setCurveStart(true);
-	if ((ocd_point.y & Ocd::OcdPoint32::FlagDash) || (ocd_point.y & Ocd::OcdPoint32::FlagCorner))
-		object->coords[pos].setDashPoint(true);
-	if (ocd_point.y & Ocd::OcdPoint32::FlagHole && pos > 1 && is_area)
-		setPathHolePoint(object, pos - 1);
-}
-
 /** Translates the OC*D path given in the last two arguments into an Object.
  */
 void OcdFileImport::fillPathCoords(OcdImportedPathObject *object, bool is_area, quint32 num_points, const Ocd::OcdPoint32* ocd_points)
 {
+	// We can support CurveStart, HolePoint, DashPoint.
+	// CurveStart is applied to the main point by the codec, not to the control point.
 	object->coords.resize(num_points);
-	for (auto i = 0u; i < num_points; i++)
+	Ocd::decodePoints(ocd_points, ocd_points + num_points, object->coords.data());
+	
+	// Hole points need to be set as the last point of a part of an area object
+	// instead of the first point of the next part. This depends on the curve
+	// start flags of the preceding points, so it is done in a second pass.
+	if (is_area)
 	{
-		object->coords[i] = convertOcdPoint(ocd_points[i]);
-		setPointFlags(object, i, is_area, ocd_points[i]);
+		for (auto i = 2u; i < num_points; ++i)
+		{
+			if (ocd_points[i].y & Ocd::OcdPoint32::FlagHole)
+				setPathHolePoint(object, i - 1);
+		}
 	}
 	
 	// For path objects, create closed parts where the position of the last point is equal to that of the first point
@@ -2374,7 +2471,7 @@ void OcdFileImport::setFraming(OcdFileImport::OcdImportedTextSymbol* symbol, con
 
 bool OcdFileImport::importImplementation()
 {
-	buffer = device()->readAll();
+	ImportBuffer import_buffer(device(), buffer);
 	if (buffer.isEmpty())
 		throw FileFormatException(device()->errorString());
 	
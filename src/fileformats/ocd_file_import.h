@@ -46,6 +46,7 @@
 #include "fileformats/ocd_types_v8.h" // IWYU pragma: keep
 
 class QChar;
+class QImage;
 class QTextCodec;
 
 namespace OpenOrienteering {
@@ -213,6 +214,15 @@ protected:
 	template< class F >
 	void importObjects(const OcdFile< F >& file);
 	
+	/**
+	 * Imports the given objects into the part.
+	 * 
+	 * Symbols are resolved in order, the coordinates and texts are converted
+	 * concurrently, and the objects are added to the part in order.
+	 */
+	template< class O >
+	void importObjects(const std::vector<const O*>& ocd_objects, MapPart* part);
+	
 	
 	template< class F >
 	void importTemplates(const OcdFile< F >& file);
@@ -284,26 +294,48 @@ protected:
 	template< class OcdBaseSymbol >
 	void setupBaseSymbol(Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol);
 	
-	template< class OcdBaseSymbol >
-	void setupIcon(Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol);
-	
-	/** Drop the symbol's custom icon if it can be reproduced by Mapper.
+	/** Returns true if the OCD symbol's icon can be reproduced by Mapper.
 	 * 
 	 * Mapper normally generates symbol icons in the required size, but OCD
 	 * format carries user-defined rastern icons. These imported low resolution
 	 * icons needs to be kept and used only if they are really different from
 	 * the default icons generatored by Mapper.
+	 * 
+	 * The comparison is done on the raw OCD icon data, so the icon needs to
+	 * be decoded only when it is different.
+	 */
+	template< class OcdBaseSymbol >
+	bool isRedundantIcon(const Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol);
+	
+	/** Decodes the OCD symbol's icon.
+	 * 
+	 * This function may be called concurrently.
 	 */
 	template< class OcdBaseSymbol >
-	void dropRedundantIcon(Symbol* symbol, const OcdBaseSymbol& ocd_base_symbol);
+	static QImage decodeIcon(const OcdBaseSymbol& ocd_base_symbol);
 	
 	void setupPointSymbolPattern(PointSymbol* symbol, std::size_t data_size, const Ocd::PointSymbolElementV8* elements);
 	
 	
 	// Object import
 	
+	/**
+	 * Returns the symbol for the given object.
+	 * 
+	 * Returns nullptr if the object cannot be imported. This function may
+	 * adjust the symbol to the object, so it must be called in object order.
+	 */
 	template< class O >
-	Object* importObject(const O& ocd_object, MapPart* part);
+	Symbol* importObjectSymbol(const O& ocd_object);
+	
+	/**
+	 * Creates an object with the given symbol.
+	 * 
+	 * This function is safe to be called concurrently. It does not handle
+	 * rectangle objects, and it does not set the position of text objects.
+	 */
+	template< class O >
+	Object* importObject(const O& ocd_object, Symbol* symbol);
 	
 	QString getObjectText(const Ocd::ObjectV8& ocd_object) const;
 	
@@ -317,8 +349,6 @@ protected:
 	
 	// Some helper functions that are used in multiple places
 	
-	void setPointFlags(OcdImportedPathObject* object, quint32 pos, bool is_area, const Ocd::OcdPoint32& ocd_point);
-	
 	void setPathHolePoint(OcdFileImport::OcdImportedPathObject* object, quint32 pos);
 	
 	void fillPathCoords(OcdFileImport::OcdImportedPathObject* object, bool is_area, quint32 num_points, const Ocd::OcdPoint32* ocd_points);
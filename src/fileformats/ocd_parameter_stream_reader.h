@@ -30,6 +30,10 @@ namespace OpenOrienteering {
 /**
  * A class for processing OCD parameter strings,
  * loosely modeled after QXmlStreamReader.
+ * 
+ * The reader does not allocate memory: The parameter string is implicitly
+ * shared, and values are returned as references into this string. Callers
+ * should convert values to QString only when they need to keep them.
  */
 class OcdParameterStreamReader
 {
@@ -0,0 +1,160 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_OCD_POINT_CODEC_H
+#define OPENORIENTEERING_OCD_POINT_CODEC_H
+
+#include <cstring>
+
+#include <QtGlobal>
+
+#include "core/map_coord.h"
+
+#include "ocd_types.h"
+
+/**
+ * Conversion of coordinate arrays between OCD and Mapper.
+ * 
+ * All OCD format versions use the same OcdPoint32 layout for the coordinates
+ * of objects and symbol elements. The functions in this file convert whole
+ * arrays in a single pass, without per-point function calls into the
+ * importer or exporter. They do not depend on the format version.
+ */
+namespace Ocd
+{
+	/**
+	 * Converts a single coordinate value to the OCD format.
+	 * 
+	 * This function handles two responsibilities at the same time,
+	 * in a constexpr implementation:
+	 * 
+	 * - convert from 1/100 mm to 1/10 mm, rounding half up (for intervals of equal size),
+	 * - shift by 8 bits (which are reserved for flags in OCD format).
+	 *
+	 * Neither rounding (the result of an integer division) half up 
+	 * nor shifting of signed integers ("implementation-defined")
+	 * come out of the box in C++.
+	 */
+	constexpr qint32 encodeCoordinate(qint32 value)
+	{
+		return (value < -5) ? qint32(0x80000000u | ((0x7fffffu & quint32((value-4)/10)) << 8)) : qint32((0x7fffffu & quint32((value+5)/10)) << 8);
+	}
+	
+	// encodeCoordinate() shall round half up.
+	Q_STATIC_ASSERT(encodeCoordinate(-16) == qint32(0xfffffe00u)); // __ down __
+	Q_STATIC_ASSERT(encodeCoordinate(-15) == qint32(0xffffff00u)); //     up
+	Q_STATIC_ASSERT(encodeCoordinate( -6) == qint32(0xffffff00u)); // __ down __
+	Q_STATIC_ASSERT(encodeCoordinate( -5) == qint32(0x00000000u)); //     up
+	Q_STATIC_ASSERT(encodeCoordinate( -1) == qint32(0x00000000u)); //     up
+	Q_STATIC_ASSERT(encodeCoordinate(  0) == qint32(0x00000000u)); //  unchanged
+	Q_STATIC_ASSERT(encodeCoordinate( +1) == qint32(0x00000000u)); //    down
+	Q_STATIC_ASSERT(encodeCoordinate( +4) == qint32(0x00000000u)); // __ down __
+	Q_STATIC_ASSERT(encodeCoordinate( +5) == qint32(0x00000100u)); //     up
+	Q_STATIC_ASSERT(encodeCoordinate(+14) == qint32(0x00000100u)); // __ down __
+	Q_STATIC_ASSERT(encodeCoordinate(+15) == qint32(0x00000200u)); //     up
+	
+	
+	/**
+	 * Converts a single OCD coordinate value, including flags, to 1/100 mm.
+	 * 
+	 * Recovers from broken coordinate export from Mapper 0.6.2 ... 0.6.4 (#749):
+	 * The values -4 ... -1 (-0.004 mm ... -0.001 mm) were converted to
+	 * 0x80000000u instead of 0. This is the maximum value. Thus it is okay to
+	 * assume it won't occur in regular data, and we can safely replace it
+	 * with 0 here.
+	 */
+	constexpr qint32 decodeCoordinate(qint32 value)
+	{
+		return ((value >> 8) == (qint32(0x80000000u) >> 8)) ? 0 : (value >> 8) * 10;
+	}
+	
+	Q_STATIC_ASSERT(decodeCoordinate(encodeCoordinate(-1230)) == -1230);
+	Q_STATIC_ASSERT(decodeCoordinate(encodeCoordinate(1230) | OcdPoint32::FlagCtl1) == 1230);
+	Q_STATIC_ASSERT(decodeCoordinate(qint32(0x80000000u)) == 0);
+	
+	
+	/**
+	 * Converts the position of an OCD point to a MapCoord without flags.
+	 */
+	constexpr OpenOrienteering::MapCoord decodePosition(const OcdPoint32& point)
+	{
+		return OpenOrienteering::MapCoord::fromNative(decodeCoordinate(point.x), -decodeCoordinate(point.y));
+	}
+	
+	
+	/**
+	 * Converts an array of OCD points to MapCoords.
+	 * 
+	 * The output must have room for the same number of elements.
+	 * This function sets the CurveStart flag for points which are followed
+	 * by a first control point, and the DashPoint flag for OCD dash and
+	 * corner points. Hole points depend on context and are left to the
+	 * caller.
+	 */
+	inline void decodePoints(const OcdPoint32* first, const OcdPoint32* last, OpenOrienteering::MapCoord* out)
+	{
+		using OpenOrienteering::MapCoord;
+		for (auto point = first; point != last; ++point, ++out)
+		{
+			auto flags = MapCoord::Flags();
+			if (point + 1 != last && (point[1].x & OcdPoint32::FlagCtl1))
+				flags |= MapCoord::CurveStart;
+			if (point->y & (OcdPoint32::FlagDash | OcdPoint32::FlagCorner))
+				flags |= MapCoord::DashPoint;
+			*out = MapCoord::fromNative(decodeCoordinate(point->x), -decodeCoordinate(point->y), flags);
+		}
+	}
+	
+	
+	/**
+	 * Converts an array of MapCoords to OCD points.
+	 * 
+	 * The output is written as raw bytes, so it doesn't need to be aligned.
+	 * It must have room for the same number of OcdPoint32 elements.
+	 * Dash points are marked with the given dash_flag, i.e.
+	 * OcdPoint32::FlagDash or OcdPoint32::FlagCorner.
+	 */
+	inline void encodePoints(const OpenOrienteering::MapCoord* first, const OpenOrienteering::MapCoord* last, char* out, qint32 dash_flag)
+	{
+		bool curve_start = false;
+		bool hole_point = false;
+		bool curve_continue = false;
+		for (auto coord = first; coord != last; ++coord, out += sizeof(OcdPoint32))
+		{
+			OcdPoint32 p = { encodeCoordinate(coord->nativeX()), encodeCoordinate(-coord->nativeY()) };
+			if (coord->isDashPoint())
+				p.y |= dash_flag;
+			if (curve_start)
+				p.x |= OcdPoint32::FlagCtl1;
+			if (hole_point)
+				p.y |= OcdPoint32::FlagHole;
+			if (curve_continue)
+				p.x |= OcdPoint32::FlagCtl2;
+			
+			curve_continue = curve_start;
+			curve_start = coord->isCurveStart();
+			hole_point = coord->isHolePoint();
+			
+			std::memcpy(out, &p, sizeof(p));
+		}
+	}
+	
+}  // namespace Ocd
+
+#endif // OPENORIENTEERING_OCD_POINT_CODEC_H
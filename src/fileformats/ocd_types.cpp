@@ -479,16 +479,14 @@ namespace {
 // ### OcdEntityIndex implementation ###
 
 template< class F, class T >
-typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByteArray& entity_data, const EntryType& entry)
+quint32 OcdEntityIndex<F,T>::lastBlock(const QByteArray& byte_array) const
 {
-	auto& byte_array = Ocd::addPadding(file.byteArray());
-	IndexBlock* block;
 	auto next_block_pos = firstBlock<typename T::IndexEntryType>();
 	auto block_pos = decltype(next_block_pos)(0);
 	do
 	{
 		block_pos = next_block_pos;
-		block = Ocd::getBlockChecked<IndexBlock>(byte_array, block_pos);
+		auto const* block = Ocd::getBlockChecked<IndexBlock>(byte_array, block_pos);
 		if (Q_UNLIKELY(!block))
 		{
 			///  \todo Throw exception
@@ -497,6 +495,16 @@ typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByte
 		next_block_pos = block->next_block;
 	}
 	while (next_block_pos != 0);
+	return block_pos;
+}
+
+
+template< class F, class T >
+typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByteArray& entity_data, const EntryType& entry)
+{
+	auto& byte_array = Ocd::addPadding(file.byteArray());
+	auto block_pos = lastBlock(byte_array);
+	auto* block = reinterpret_cast<IndexBlock*>(byte_array.data() + block_pos);
 	
 	quint16 index = 0;
 	while (index < 256 && block->entries[index].pos)
@@ -522,6 +530,52 @@ typename OcdEntityIndex<F,T>::EntryType& OcdEntityIndex<F,T>::insert(const QByte
 }
 
 
+template< class F, class T >
+void OcdEntityIndex<F,T>::insert(const std::vector<std::pair<QByteArray, EntryType>>& entities)
+{
+	if (entities.empty())
+		return;
+	
+	auto& byte_array = Ocd::addPadding(file.byteArray());
+	auto block_pos = lastBlock(byte_array);
+	auto* block = reinterpret_cast<IndexBlock*>(byte_array.data() + block_pos);
+	
+	quint16 index = 0;
+	while (index < 256 && block->entries[index].pos)
+		++index;
+	
+	// Reserve the space for the entities, the padding, and the new blocks.
+	auto const free_entries = std::size_t(256 - index);
+	auto const new_blocks = entities.size() > free_entries ? (entities.size() - free_entries + 255) / 256 : 0;
+	auto required_size = qint64(byte_array.size()) + qint64(new_blocks * (sizeof(IndexBlock) + 7));
+	for (const auto& entity : entities)
+		required_size += entity.first.size() + 7;
+	if (required_size < std::numeric_limits<int>::max())
+		byte_array.reserve(int(required_size));
+	
+	for (const auto& entity : entities)
+	{
+		Ocd::addPadding(byte_array);
+		if (Q_UNLIKELY(index == 256))
+		{
+			block = reinterpret_cast<IndexBlock*>(byte_array.data() + block_pos);
+			block_pos = decltype(block->next_block)(byte_array.size());
+			block->next_block = block_pos;
+			auto new_block = IndexBlock {};
+			byte_array.append(reinterpret_cast<const char*>(&new_block), sizeof(IndexBlock));
+			index = 0;
+		}
+		
+		auto entity_pos = decltype(block->entries[index].pos)(byte_array.size());
+		byte_array.append(entity.first);
+		block = reinterpret_cast<IndexBlock*>(byte_array.data() + block_pos);
+		block->entries[index] = entity.second;
+		block->entries[index].pos = entity_pos;
+		++index;
+	}
+}
+
+
 
 // ### OcdFile implementation ###
 
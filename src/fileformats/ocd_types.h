@@ -23,6 +23,8 @@
 #include <cstddef>
 #include <iterator>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <QtGlobal>
 #include <QByteArray>
@@ -504,6 +506,15 @@ public:
 	 */
 	EntryType& insert(const QByteArray& entity_data, const EntryType& entry);
 	
+	/**
+	 * Inserts a sequence of objects with the given entry prototypes.
+	 * 
+	 * The result is the same as when inserting the objects one by one, but
+	 * the file data is reserved in advance, and the index blocks are
+	 * traversed only once.
+	 */
+	void insert(const std::vector<std::pair<QByteArray, EntryType>>& entities);
+	
 	/**
 	 * Inserts a symbol.
 	 */
@@ -529,6 +540,11 @@ private:
 	template< class X = EntryType, typename std::enable_if<std::is_same<X, typename F::Object::IndexEntryType>::value, int>::type = 0 >
 	quint32 firstBlock() const;
 	
+	/**
+	 * Returns the position of the last index block in the byte array.
+	 */
+	quint32 lastBlock(const QByteArray& byte_array) const;
+	
 	OcdFile<F>& file;
 };
 
@@ -670,6 +686,9 @@ private:
 	typename OcdEntityIndex<F, F::Object>::EntryType& OcdEntityIndex<F, F::Object>::insert(const QByteArray&, const EntryType&); \
 	\
 	keywords \
+	void OcdEntityIndex<F, F::Object>::insert(const std::vector<std::pair<QByteArray, EntryType>>&); \
+	\
+	keywords \
 	OcdFile<F>::OcdFile();
 
 
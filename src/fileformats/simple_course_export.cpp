@@ -21,7 +21,10 @@
 
 #include <QVariant>
 
+#include "core/georeferencing.h"
+#include "core/latlon.h"
 #include "core/map.h"
+#include "core/map_coord.h"
 #include "core/map_part.h"
 #include "core/objects/object.h"
 
@@ -82,6 +85,23 @@ const PathObject* SimpleCourseExport::findObjectForExport() const
 }
 
 
+std::vector<LatLon> SimpleCourseExport::controlPositions(const PathObject& object) const
+{
+	auto next = [](auto current) {
+		return current + (current->isCurveStart() ? 3 : 1);
+	};
+	
+	auto const& coords = object.getRawCoordinateVector();
+	MapCoordVectorF positions;
+	positions.reserve(coords.size());
+	positions.emplace_back(coords.front());
+	for (auto current = next(coords.begin()); current < coords.end() - 1; current = next(current))
+		positions.emplace_back(*current);
+	positions.emplace_back(coords.back());
+	return map.getGeoreferencing().toGeographicCoords(positions);
+}
+
+
 QString SimpleCourseExport::eventName() const
 {
 	auto name = map.property("simple-course-event-name").toString();
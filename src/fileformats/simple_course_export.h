@@ -20,11 +20,14 @@
 #ifndef OPENORIENTEERING_SIMPLE_COURSE_EXPORT_H
 #define OPENORIENTEERING_SIMPLE_COURSE_EXPORT_H
 
+#include <vector>
+
 #include <QCoreApplication>
 #include <QString>
 
 namespace OpenOrienteering {
 
+class LatLon;
 class Map;
 class PathObject;
 
@@ -56,6 +59,14 @@ public:
 	
 	const PathObject* findObjectForExport() const;
 	
+	/**
+	 * Returns the geographic positions of start, controls and finish.
+	 * 
+	 * The start is the first, and the finish is the last element. All
+	 * positions are transformed in a single call to the georeferencing.
+	 */
+	std::vector<LatLon> controlPositions(const PathObject& object) const;
+	
 	
 	QString eventName() const;
 	
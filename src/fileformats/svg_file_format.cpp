@@ -0,0 +1,649 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "svg_file_format.h"
+
+#include <cmath>
+#include <limits>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QBuffer>
+#include <QBrush>
+#include <QByteArray>
+#include <QColor>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QIODevice>
+#include <QImage>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QPixmap>
+#include <QPointF>
+#include <QRectF>
+#include <QRegion>
+#include <QSaveFile>
+#include <QSize>
+#include <QTransform>
+#include <QVariant>
+#include <QXmlStreamWriter>
+#include <QtMath>
+
+#include "core/map.h"
+#include "core/renderables/renderable.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * Appends a number with the given number of decimals, without trailing zeros.
+ */
+void appendNumber(QByteArray& data, qreal value, int decimals = 3)
+{
+	auto number = QByteArray::number(value, 'f', decimals);
+	auto length = number.size();
+	while (length > 0 && number[length - 1] == '0')
+		--length;
+	if (length > 0 && number[length - 1] == '.')
+		--length;
+	number.truncate(length);
+	if (number.isEmpty() || number == "-")
+		number = "0";
+	data += number;
+}
+
+QString toString(qreal value, int decimals = 3)
+{
+	QByteArray data;
+	appendNumber(data, value, decimals);
+	return QString::fromLatin1(data);
+}
+
+/**
+ * Returns the SVG path data for a painter path.
+ * 
+ * Subpaths which end at their start point are closed.
+ */
+QByteArray pathData(const QPainterPath& path)
+{
+	QByteArray data;
+	data.reserve(path.elementCount() * 16);
+	auto const close_ring = [&path, &data](int first, int last) {
+		if (last - first > 2 && QPointF(path.elementAt(first)) == QPointF(path.elementAt(last - 1)))
+			data += 'Z';
+	};
+	
+	auto start = 0;
+	for (auto i = 0; i < path.elementCount(); ++i)
+	{
+		auto const& element = path.elementAt(i);
+		switch (element.type)
+		{
+		case QPainterPath::MoveToElement:
+			close_ring(start, i);
+			start = i;
+			data += 'M';
+			break;
+		case QPainterPath::LineToElement:
+			data += 'L';
+			break;
+		case QPainterPath::CurveToElement:
+			data += 'C';
+			break;
+		case QPainterPath::CurveToDataElement:
+			data += ' ';
+			break;
+		}
+		appendNumber(data, element.x);
+		data += ' ';
+		appendNumber(data, element.y);
+	}
+	close_ring(start, path.elementCount());
+	return data;
+}
+
+QString transformAttribute(const QTransform& transform)
+{
+	QByteArray data("matrix(");
+	for (auto value : { transform.m11(), transform.m12(), transform.m21(), transform.m22() })
+	{
+		appendNumber(data, value, 6);
+		data += ' ';
+	}
+	appendNumber(data, transform.dx());
+	data += ' ';
+	appendNumber(data, transform.dy());
+	data += ')';
+	return QString::fromLatin1(data);
+}
+
+QString colorStyle(const char* property, const QColor& color, qreal opacity)
+{
+	auto style = QString::fromLatin1(property) + QLatin1Char(':') + color.name();
+	auto const alpha = color.alphaF() * opacity;
+	if (alpha < 1)
+		style += QLatin1Char(';') + QString::fromLatin1(property) + QLatin1String("-opacity:") + toString(alpha);
+	return style;
+}
+
+
+
+/**
+ * A paint engine which writes SVG elements to a QXmlStreamWriter.
+ * 
+ * The elements are written immediately, in painting order. Only solid
+ * pens and brushes are supported.
+ */
+class SvgPaintEngine : public QPaintEngine
+{
+public:
+	explicit SvgPaintEngine(QXmlStreamWriter& xml)
+	: QPaintEngine(QPaintEngine::AllFeatures)
+	, xml(xml)
+	{}
+	
+	bool begin(QPaintDevice* /*device*/) override
+	{
+		return true;
+	}
+	
+	bool end() override
+	{
+		closeGroup();
+		return !xml.hasError();
+	}
+	
+	Type type() const override
+	{
+		return QPaintEngine::User;
+	}
+	
+	void updateState(const QPaintEngineState& state) override
+	{
+		auto const flags = state.state();
+		if (flags.testFlag(DirtyPen))
+			pen = state.pen();
+		if (flags.testFlag(DirtyBrush))
+			brush = state.brush();
+		if (flags.testFlag(DirtyTransform))
+			transform = state.transform();
+		if (flags.testFlag(DirtyOpacity))
+			opacity = state.opacity();
+		if (flags.testFlag(DirtyClipPath))
+			updateClip(state.clipOperation(), state.clipPath());
+		if (flags.testFlag(DirtyClipRegion))
+		{
+			QPainterPath path;
+			path.addRegion(state.clipRegion());
+			updateClip(state.clipOperation(), path);
+		}
+		if (flags.testFlag(DirtyClipEnabled) && state.isClipEnabled() != clip_enabled)
+		{
+			clip_enabled = state.isClipEnabled();
+			clip_dirty = true;
+		}
+	}
+	
+	void drawPath(const QPainterPath& path) override
+	{
+		writePath(path, brush);
+	}
+	
+	void drawPolygon(const QPointF* points, int count, PolygonDrawMode mode) override
+	{
+		if (count < 2)
+			return;
+		
+		QPainterPath path;
+		path.moveTo(points[0]);
+		for (int i = 1; i < count; ++i)
+			path.lineTo(points[i]);
+		if (mode == PolylineMode)
+		{
+			writePath(path, Qt::NoBrush);
+			return;
+		}
+		
+		path.closeSubpath();
+		path.setFillRule(mode == WindingMode ? Qt::WindingFill : Qt::OddEvenFill);
+		writePath(path, brush);
+	}
+	
+	void drawPixmap(const QRectF& rect, const QPixmap& pixmap, const QRectF& source_rect) override
+	{
+		drawImage(rect, pixmap.toImage(), source_rect, Qt::AutoColor);
+	}
+	
+	void drawImage(const QRectF& rect, const QImage& image, const QRectF& source_rect, Qt::ImageConversionFlags /*flags*/) override
+	{
+		QByteArray png;
+		QBuffer buffer(&png);
+		buffer.open(QIODevice::WriteOnly);
+		if (!image.copy(source_rect.toAlignedRect()).save(&buffer, "PNG"))
+			return;
+		
+		prepareDrawing();
+		xml.writeEmptyElement(QLatin1String("image"));
+		xml.writeAttribute(QLatin1String("x"), toString(rect.x()));
+		xml.writeAttribute(QLatin1String("y"), toString(rect.y()));
+		xml.writeAttribute(QLatin1String("width"), toString(rect.width()));
+		xml.writeAttribute(QLatin1String("height"), toString(rect.height()));
+		xml.writeAttribute(QLatin1String("preserveAspectRatio"), QLatin1String("none"));
+		if (opacity < 1)
+			xml.writeAttribute(QLatin1String("opacity"), toString(opacity));
+		if (!transform.isIdentity())
+			xml.writeAttribute(QLatin1String("transform"), transformAttribute(transform));
+		xml.writeAttribute(QLatin1String("xlink:href"), QLatin1String("data:image/png;base64,") + QString::fromLatin1(png.toBase64()));
+	}
+	
+private:
+	/**
+	 * Updates the clip path, in the untransformed coordinates of the SVG.
+	 */
+	void updateClip(Qt::ClipOperation operation, const QPainterPath& path)
+	{
+		switch (operation)
+		{
+		case Qt::NoClip:
+			clip_enabled = false;
+			break;
+		case Qt::ReplaceClip:
+			clip_path = transform.map(path);
+			clip_enabled = true;
+			break;
+		case Qt::IntersectClip:
+			clip_path = clip_enabled ? clip_path.intersected(transform.map(path)) : transform.map(path);
+			clip_enabled = true;
+			break;
+		}
+		clip_dirty = true;
+	}
+	
+	/**
+	 * Opens a group with the current clip path, if it has changed.
+	 */
+	void prepareDrawing()
+	{
+		if (!clip_dirty)
+			return;
+		
+		closeGroup();
+		clip_dirty = false;
+		if (!clip_enabled)
+			return;
+		
+		auto const id = QStringLiteral("c%1").arg(++num_clip_paths);
+		xml.writeStartElement(QLatin1String("clipPath"));
+		xml.writeAttribute(QLatin1String("id"), id);
+		xml.writeEmptyElement(QLatin1String("path"));
+		xml.writeAttribute(QLatin1String("d"), QString::fromLatin1(pathData(clip_path)));
+		if (clip_path.fillRule() == Qt::WindingFill)
+			xml.writeAttribute(QLatin1String("clip-rule"), QLatin1String("nonzero"));
+		xml.writeEndElement();
+		
+		xml.writeStartElement(QLatin1String("g"));
+		xml.writeAttribute(QLatin1String("clip-path"), QLatin1String("url(#") + id + QLatin1Char(')'));
+		group_open = true;
+	}
+	
+	void closeGroup()
+	{
+		if (group_open)
+		{
+			xml.writeEndElement();
+			group_open = false;
+		}
+	}
+	
+	/**
+	 * Returns the CSS class for the current pen, the given brush, and the
+	 * current opacity. New classes are written as style elements.
+	 */
+	QString styleClass(const QBrush& fill)
+	{
+		QString style;
+		if (fill.style() == Qt::NoBrush)
+			style = QStringLiteral("fill:none");
+		else
+			style = colorStyle("fill", fill.color(), opacity);
+		
+		if (pen.style() == Qt::NoPen)
+		{
+			style += QLatin1String(";stroke:none");
+		}
+		else
+		{
+			style += QLatin1Char(';') + colorStyle("stroke", pen.color(), opacity);
+			if (pen.isCosmetic())
+				style += QLatin1String(";stroke-width:1px;vector-effect:non-scaling-stroke");
+			else
+				style += QLatin1String(";stroke-width:") + toString(pen.widthF(), 4);
+			switch (pen.capStyle())
+			{
+			case Qt::FlatCap:   style += QLatin1String(";stroke-linecap:butt"); break;
+			case Qt::SquareCap: style += QLatin1String(";stroke-linecap:square"); break;
+			default:            style += QLatin1String(";stroke-linecap:round"); break;
+			}
+			switch (pen.joinStyle())
+			{
+			case Qt::BevelJoin: style += QLatin1String(";stroke-linejoin:bevel"); break;
+			case Qt::RoundJoin: style += QLatin1String(";stroke-linejoin:round"); break;
+			default:
+				style += QLatin1String(";stroke-linejoin:miter;stroke-miterlimit:") + toString(pen.miterLimit());
+				break;
+			}
+		}
+		
+		auto id = style_classes.value(style);
+		if (!id)
+		{
+			id = style_classes.size() + 1;
+			style_classes.insert(style, id);
+			xml.writeStartElement(QLatin1String("style"));
+			xml.writeAttribute(QLatin1String("type"), QLatin1String("text/css"));
+			xml.writeCharacters(QStringLiteral(".s%1{%2}").arg(id).arg(style));
+			xml.writeEndElement();
+		}
+		return QStringLiteral("s%1").arg(id);
+	}
+	
+	/**
+	 * Writes a path, or a reference to a path which was drawn before.
+	 */
+	void writePath(const QPainterPath& path, const QBrush& fill)
+	{
+		if (path.isEmpty() || (fill.style() == Qt::NoBrush && pen.style() == Qt::NoPen))
+			return;
+		
+		prepareDrawing();
+		auto const style = styleClass(fill);
+		auto const data = pathData(path);
+		auto const winding = fill.style() != Qt::NoBrush && path.fillRule() == Qt::WindingFill;
+		
+		if (transform.isIdentity())
+		{
+			writePathElement(data, style, winding);
+			return;
+		}
+		
+		// Shapes drawn with a transformation are candidates for instancing.
+		// The first occurrence is written in place, the second one creates
+		// the symbol.
+		auto const key = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+		auto symbol = shapes.find(key);
+		if (symbol == shapes.end())
+		{
+			shapes.insert(key, 0);
+			writePathElement(data, style, winding);
+			xml.writeAttribute(QLatin1String("transform"), transformAttribute(transform));
+			return;
+		}
+		
+		if (!*symbol)
+		{
+			*symbol = ++num_symbols;
+			xml.writeStartElement(QLatin1String("symbol"));
+			xml.writeAttribute(QLatin1String("id"), QStringLiteral("p%1").arg(*symbol));
+			xml.writeAttribute(QLatin1String("overflow"), QLatin1String("visible"));
+			writePathElement(data, {}, winding);
+			xml.writeEndElement();
+		}
+		xml.writeEmptyElement(QLatin1String("use"));
+		xml.writeAttribute(QLatin1String("xlink:href"), QStringLiteral("#p%1").arg(*symbol));
+		xml.writeAttribute(QLatin1String("class"), style);
+		xml.writeAttribute(QLatin1String("transform"), transformAttribute(transform));
+	}
+	
+	/**
+	 * Writes a path element. Attributes may be added by the caller.
+	 */
+	void writePathElement(const QByteArray& data, const QString& style, bool winding)
+	{
+		xml.writeEmptyElement(QLatin1String("path"));
+		if (!style.isEmpty())
+			xml.writeAttribute(QLatin1String("class"), style);
+		// An inline style overrides the class. The default is set for the
+		// whole document.
+		if (winding)
+			xml.writeAttribute(QLatin1String("style"), QLatin1String("fill-rule:nonzero"));
+		xml.writeAttribute(QLatin1String("d"), QString::fromLatin1(data));
+	}
+	
+	QXmlStreamWriter& xml;
+	QPen pen;
+	QBrush brush;
+	QTransform transform;
+	qreal opacity = 1;
+	QPainterPath clip_path;
+	bool clip_enabled = false;
+	bool clip_dirty = false;
+	bool group_open = false;
+	int num_clip_paths = 0;
+	int num_symbols = 0;
+	QHash<QString, int> style_classes;
+	QHash<QByteArray, int> shapes;  ///< Symbol IDs by hash of path data, 0 if not instanced yet
+	
+};
+
+
+
+/**
+ * A paint device for SvgPaintEngine.
+ * 
+ * One unit of the device is one millimeter of the map.
+ */
+class SvgPaintDevice : public QPaintDevice
+{
+public:
+	SvgPaintDevice(QXmlStreamWriter& xml, const QRectF& area)
+	: engine(xml)
+	, size(qCeil(area.width()), qCeil(area.height()))
+	{}
+	
+	~SvgPaintDevice() override = default;
+	
+	QPaintEngine* paintEngine() const override
+	{
+		return &engine;
+	}
+	
+protected:
+	int metric(PaintDeviceMetric metric) const override
+	{
+		switch (metric)
+		{
+		case PdmWidth:
+		case PdmWidthMM:
+			return size.width();
+		case PdmHeight:
+		case PdmHeightMM:
+			return size.height();
+		case PdmNumColors:
+			return std::numeric_limits<int>::max();
+		case PdmDepth:
+			return 32;
+		case PdmDpiX:
+		case PdmDpiY:
+		case PdmPhysicalDpiX:
+		case PdmPhysicalDpiY:
+			return 25;  // approximately one unit per mm
+		default:
+			return QPaintDevice::metric(metric);
+		}
+	}
+	
+private:
+	mutable SvgPaintEngine engine;
+	QSize size;
+	
+};
+
+
+}  // namespace
+
+
+
+// ### SvgFileFormat ###
+
+SvgFileFormat::SvgFileFormat()
+: FileFormat(VectorGraphicsFile,
+             "SVG",
+             ::OpenOrienteering::ImportExport::tr("Scalable Vector Graphics"),
+             QString::fromLatin1("svg"),
+             Feature::FileExport | Feature::WritingLossy)
+{
+	// Nothing
+}
+
+
+std::unique_ptr<Exporter> SvgFileFormat::makeExporter(const QString& path, const Map* map, const MapView* view) const
+{
+	return std::make_unique<SvgFileExport>(path, map, view);
+}
+
+
+
+// ### SvgFileExport ###
+
+SvgFileExport::SvgFileExport(const QString& path, const Map* map, const MapView* view)
+: Exporter(path, map, view)
+{
+	setOption(QStringLiteral("tileSize"), 0.0);
+}
+
+SvgFileExport::~SvgFileExport() = default;
+
+
+bool SvgFileExport::exportImplementation()
+{
+	auto area = map->calculateExtent(false, false, view);
+	if (!area.isValid())
+		area = { 0, 0, 1, 1 };
+	
+	auto const tile_size = option(QStringLiteral("tileSize")).toDouble();
+	if (tile_size > 0 && !path.isEmpty())
+		return exportTiles(area, tile_size);
+	
+	writeSvg(*device(), area, false);
+	return true;
+}
+
+
+void SvgFileExport::writeSvg(QIODevice& device, const QRectF& area, bool clip) const
+{
+	QXmlStreamWriter xml(&device);
+	xml.setAutoFormatting(true);
+	xml.setAutoFormattingIndent(0);
+	xml.writeStartDocument();
+	xml.writeStartElement(QLatin1String("svg"));
+	xml.writeDefaultNamespace(QLatin1String("http://www.w3.org/2000/svg"));
+	xml.writeNamespace(QLatin1String("http://www.w3.org/1999/xlink"), QLatin1String("xlink"));
+	xml.writeAttribute(QLatin1String("version"), QLatin1String("1.1"));
+	xml.writeAttribute(QLatin1String("width"), toString(area.width()) + QLatin1String("mm"));
+	xml.writeAttribute(QLatin1String("height"), toString(area.height()) + QLatin1String("mm"));
+	xml.writeAttribute(QLatin1String("viewBox"), QString::fromLatin1("%1 %2 %3 %4").arg(
+	                       toString(area.x()), toString(area.y()), toString(area.width()), toString(area.height())));
+	// The default fill rule of QPainterPath
+	xml.writeAttribute(QLatin1String("fill-rule"), QLatin1String("evenodd"));
+	
+	{
+		SvgPaintDevice paint_device(xml, area);
+		QPainter painter(&paint_device);
+		if (clip)
+			painter.setClipRect(area);
+		// Drawing updates the renderables of modified objects.
+		auto& drawn_map = const_cast<Map&>(*map);
+		drawn_map.draw(&painter, { *map, area, 1.0, RenderConfig::NoOptions, 1.0 });
+		painter.end();
+	}
+	
+	xml.writeEndElement();  // svg
+	xml.writeEndDocument();
+	if (xml.hasError())
+		throw FileFormatException(device.errorString());
+}
+
+
+bool SvgFileExport::exportTiles(const QRectF& area, double tile_size)
+{
+	auto const file_info = QFileInfo(path);
+	auto const base_name = file_info.completeBaseName();
+	auto const columns = qMax(1, qCeil(area.width() / tile_size));
+	auto const rows = qMax(1, qCeil(area.height() / tile_size));
+	
+	QXmlStreamWriter xml(device());
+	xml.setAutoFormatting(true);
+	xml.setAutoFormattingIndent(0);
+	xml.writeStartDocument();
+	xml.writeStartElement(QLatin1String("svg"));
+	xml.writeDefaultNamespace(QLatin1String("http://www.w3.org/2000/svg"));
+	xml.writeNamespace(QLatin1String("http://www.w3.org/1999/xlink"), QLatin1String("xlink"));
+	xml.writeAttribute(QLatin1String("version"), QLatin1String("1.1"));
+	xml.writeAttribute(QLatin1String("width"), toString(area.width()) + QLatin1String("mm"));
+	xml.writeAttribute(QLatin1String("height"), toString(area.height()) + QLatin1String("mm"));
+	xml.writeAttribute(QLatin1String("viewBox"), QString::fromLatin1("%1 %2 %3 %4").arg(
+	                       toString(area.x()), toString(area.y()), toString(area.width()), toString(area.height())));
+	
+	for (int row = 0; row < rows; ++row)
+	{
+		for (int column = 0; column < columns; ++column)
+		{
+			auto const tile = QRectF(area.x() + column * tile_size, area.y() + row * tile_size, tile_size, tile_size)
+			                  .intersected(area);
+			auto const tile_name = QString::fromLatin1("%1-%2-%3.svg").arg(base_name).arg(row).arg(column);
+			QSaveFile file(file_info.dir().filePath(tile_name));
+			if (!file.open(QIODevice::WriteOnly))
+			{
+				addWarning(tr("Cannot save file\n%1:\n%2").arg(file.fileName(), file.errorString()));
+				return false;
+			}
+			writeSvg(file, tile, true);
+			if (!file.commit())
+			{
+				addWarning(tr("Cannot save file\n%1:\n%2").arg(file.fileName(), file.errorString()));
+				return false;
+			}
+			
+			xml.writeEmptyElement(QLatin1String("image"));
+			xml.writeAttribute(QLatin1String("x"), toString(tile.x()));
+			xml.writeAttribute(QLatin1String("y"), toString(tile.y()));
+			xml.writeAttribute(QLatin1String("width"), toString(tile.width()));
+			xml.writeAttribute(QLatin1String("height"), toString(tile.height()));
+			xml.writeAttribute(QLatin1String("xlink:href"), tile_name);
+		}
+	}
+	
+	xml.writeEndElement();  // svg
+	xml.writeEndDocument();
+	if (xml.hasError())
+		throw FileFormatException(device()->errorString());
+	return true;
+}
+
+
+}  // namespace OpenOrienteering
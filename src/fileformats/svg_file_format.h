@@ -0,0 +1,102 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_SVG_FILE_FORMAT_H
+#define OPENORIENTEERING_SVG_FILE_FORMAT_H
+
+#include <memory>
+
+#include <QString>
+
+#include "fileformats/file_format.h"
+#include "fileformats/file_import_export.h"
+
+class QIODevice;
+class QRectF;
+
+namespace OpenOrienteering {
+
+class Map;
+class MapView;
+
+
+/**
+ * The SVG export format.
+ */
+class SvgFileFormat : public FileFormat
+{
+public:
+	/**
+	 * Constructs a new SvgFileFormat.
+	 */
+	SvgFileFormat();
+	
+	/// \copydoc FileFormat::makeExporter()
+	std::unique_ptr<Exporter> makeExporter(const QString& path, const Map* map, const MapView* view) const override;
+	
+};
+
+
+
+/**
+ * An exporter which writes the map as Scalable Vector Graphics.
+ * 
+ * The renderables of the map are drawn in the order of the colors' priorities,
+ * through a paint engine which writes each shape to the output as soon as it
+ * is drawn. So memory does not grow with the size of the map. Each distinct
+ * combination of color, line width and line style becomes a CSS class, and
+ * shapes which are drawn more than once at different positions, such as the
+ * elements of point symbols, become a `<symbol>` which is instanced by `<use>`.
+ * 
+ * The SVG user unit is millimeters on the map.
+ * 
+ * Options:
+ * - "tileSize": If greater than zero, the map is split into square tiles of
+ *   this size in millimeters. Each tile is written to a separate file next
+ *   to the output file, and the output file refers to the tiles as images.
+ */
+class SvgFileExport : public Exporter
+{
+public:
+	SvgFileExport(const QString& path, const Map* map, const MapView* view);
+	
+	~SvgFileExport() override;
+	
+protected:
+	bool exportImplementation() override;
+	
+	/**
+	 * Writes an SVG document showing the given area of the map.
+	 * 
+	 * If clip is true, the drawing is clipped to the area.
+	 */
+	void writeSvg(QIODevice& device, const QRectF& area, bool clip) const;
+	
+	/**
+	 * Writes the tiles of the given area, and an SVG document which refers
+	 * to the tiles.
+	 */
+	bool exportTiles(const QRectF& area, double tile_size);
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_SVG_FILE_FORMAT_H
@@ -0,0 +1,132 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "symbol_set_cache.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QIODevice>
+#include <QImage>
+#include <QLatin1String>
+#include <QVariant>
+
+#include "mapper_config.h" // IWYU pragma: keep
+#include "settings.h"
+#include "core/map.h"
+#include "core/symbols/symbol.h"
+#include "util/disk_cache.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The magic number at the start of cache files ("MSIC")
+constexpr quint32 cache_magic = 0x4d534943;
+
+/// The version of the cache file layout
+constexpr quint32 cache_version = 1;
+
+}  // namespace
+
+
+
+SymbolSetCache::SymbolSetCache(const QString& path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+	
+	auto& settings = Settings::getInstance();
+	auto const show_custom_icons = settings.getSetting(Settings::SymbolWidget_ShowCustomIcons).toBool();
+	
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	if (!hash.addData(&file))
+		return;
+	hash.addData(QByteArray(APP_VERSION));
+	hash.addData(QByteArray::number(settings.getSymbolWidgetIconSizePx()));
+	hash.addData(show_custom_icons ? QByteArrayLiteral("custom") : QByteArrayLiteral("generated"));
+	
+	cache_path = DiskCache::entryPath(DiskCache::SymbolIcons, hash.result().toHex(), QLatin1String(".icons"));
+}
+
+
+bool SymbolSetCache::restoreIcons(const Map& map) const
+{
+	if (!isValid())
+		return false;
+	
+	QFile file(cache_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_5);
+	quint32 magic = 0, version = 0;
+	qint32 num_icons = 0;
+	stream >> magic >> version >> num_icons;
+	if (magic != cache_magic || version != cache_version || num_icons != map.getNumSymbols())
+		return false;
+	
+	std::vector<QImage> icons(std::size_t(num_icons));
+	for (auto& icon : icons)
+		stream >> icon;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+	
+	for (int i = 0; i < num_icons; ++i)
+		map.getSymbol(i)->setIcon(icons[std::size_t(i)]);
+	DiskCache::touch(DiskCache::SymbolIcons, cache_path);
+	return true;
+}
+
+
+bool SymbolSetCache::storeIcons(const Map& map) const
+{
+	if (!isValid())
+		return false;
+	
+	auto const ok = DiskCache::write(cache_path, [&map](QIODevice& device) {
+		QDataStream stream(&device);
+		stream.setVersion(QDataStream::Qt_5_5);
+		stream << cache_magic << cache_version << qint32(map.getNumSymbols());
+		for (int i = 0; i < map.getNumSymbols(); ++i)
+			stream << map.getSymbol(i)->getIcon(&map);
+		return stream.status() == QDataStream::Ok;
+	});
+	if (ok)
+		DiskCache::scheduleTrim(DiskCache::SymbolIcons);
+	return ok;
+}
+
+
+void SymbolSetCache::provideIcons(const Map& map) const
+{
+	if (!restoreIcons(map) && !storeIcons(map))
+		qDebug("Failed to store symbol icons in %s", qPrintable(cache_path));
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,92 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_SYMBOL_SET_CACHE_H
+#define OPENORIENTEERING_SYMBOL_SET_CACHE_H
+
+#include <QString>
+
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * A disk cache for the generated icons of symbol sets.
+ *
+ * Rendering the icons is a major part of the time needed to bring up a new
+ * map with a symbol set. This cache stores the icons of all symbols of a
+ * symbol set file in the cache directory, so that they can be restored after
+ * loading the symbols.
+ *
+ * Cache entries are keyed by a hash of the file contents, the application
+ * version, and the icon settings. Thus modified symbol sets, new versions of
+ * Mapper, and different icon sizes use separate entries. The entries are
+ * stored in the DiskCache::SymbolIcons category.
+ */
+class SymbolSetCache
+{
+public:
+	/**
+	 * Prepares the cache for the symbol set file at the given path.
+	 * 
+	 * This reads the whole file to compute the cache key.
+	 */
+	explicit SymbolSetCache(const QString& path);
+	
+	/**
+	 * Returns true if a cache key could be computed for the file.
+	 */
+	bool isValid() const { return !cache_path.isEmpty(); }
+	
+	/**
+	 * Sets the cached icons to the symbols of the given map.
+	 * 
+	 * The map must have been loaded from the file given to the constructor,
+	 * without further modifications.
+	 * Returns true when the icons were restored for all symbols.
+	 */
+	bool restoreIcons(const Map& map) const;
+	
+	/**
+	 * Creates the icons of all symbols of the given map, and stores them
+	 * in the cache.
+	 * 
+	 * The map must have been loaded from the file given to the constructor,
+	 * without further modifications.
+	 * Returns true on success.
+	 */
+	bool storeIcons(const Map& map) const;
+	
+	/**
+	 * Restores the icons from the cache, or creates and stores them if they
+	 * are not in the cache yet.
+	 */
+	void provideIcons(const Map& map) const;
+
+private:
+	QString cache_path;
+
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_SYMBOL_SET_CACHE_H
@@ -23,6 +23,7 @@
 #include "xml_file_format_p.h"
 
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -30,8 +31,10 @@
 
 #include <QtGlobal>
 #include <QByteArray>
+#include <QBuffer>
 #include <QDir>
 #include <QExplicitlySharedDataPointer>
+#include <QFileDevice>
 #include <QFileInfo>
 #include <QFlags>
 #include <QIODevice>
@@ -39,6 +42,7 @@
 #include <QLocale>
 #include <QObject>
 #include <QRectF>
+#include <QSaveFile>
 #include <QScopedValueRollback>
 #include <QString>
 #include <QStringRef>
@@ -55,14 +59,20 @@
 #include "core/map_part.h"
 #include "core/map_printer.h"  // IWYU pragma: keep
 #include "core/map_view.h"
+#include "core/objects/object.h"
 #include "core/symbols/line_symbol.h"
 #include "core/symbols/point_symbol.h"
 #include "core/symbols/symbol.h"
+#include "fileformats/buffered_device.h"
 #include "fileformats/file_import_export.h"
 #include "templates/template.h"
 #include "undo/undo_manager.h"
 #include "util/xml_stream_util.h"
 
+#ifdef MAPPER_USE_ZSTD
+#include "fileformats/zstd_device.h"
+#endif
+
 
 namespace OpenOrienteering {
 
@@ -83,6 +93,17 @@ QString mapperNamespace()
 	return QStringLiteral("http://openorienteering.org/apps/mapper/xml/v2");
 }
 
+/**
+ * The magic number at the start of zstd compressed data.
+ */
+const char zstd_magic[4] = { '\x28', '\xb5', '\x2f', '\xfd' };
+
+bool isZstdCompressed(const char* buffer, qint64 size)
+{
+	return size >= qint64(sizeof(zstd_magic))
+	       && std::memcmp(buffer, zstd_magic, sizeof(zstd_magic)) == 0;
+}
+
 
 }  // namespace
 
@@ -106,6 +127,22 @@ FileFormat::ImportSupportAssumption XMLFileFormat::understands(const char* buffe
 	if (size >= 4 && qstrncmp(buffer, "OMAP", 4) == 0)
 	    return FullySupported;  // Legacy binary format. Final error raised in doImport().
 	
+	if (isZstdCompressed(buffer, size))
+	{
+#ifdef MAPPER_USE_ZSTD
+		// Check the beginning of the decompressed data.
+		QBuffer compressed;
+		compressed.setData(data);
+		compressed.open(QIODevice::ReadOnly);
+		ZstdDecompressionDevice decompressor(&compressed);
+		decompressor.open(QIODevice::ReadOnly);
+		auto const decompressed = decompressor.read(size);
+		return understands(decompressed.constData(), decompressed.size());
+#else
+		return NotSupported;
+#endif
+	}
+	
 	if (size > 38)  // length of "<?xml ...>"
 	{
 		QXmlStreamReader xml(data);
@@ -188,6 +225,7 @@ namespace literal
 	
 	static const QLatin1String parts("parts");
 	static const QLatin1String part("part");
+	static const QLatin1String objects("objects");
 	
 	static const QLatin1String templates("templates");
 	static const QLatin1String template_string("template");
@@ -221,6 +259,12 @@ XMLFileExporter::XMLFileExporter(const QString& path, const Map* map, const MapV
 	// Determine auto-formatting default from filename, if possible.
 	bool auto_formatting = path.endsWith(QLatin1String(".xmap"));
 	setOption(QString::fromLatin1("autoFormatting"), auto_formatting);
+	
+	// Compression is not used for the human-readable format.
+	auto compression_level = 0;
+	if (!auto_formatting)
+		compression_level = Settings::getInstance().getSetting(Settings::General_CompressionLevel).toInt();
+	setOption(QString::fromLatin1("compressionLevel"), compression_level);
 }
 
 XMLFileExporter::~XMLFileExporter() = default;
@@ -229,11 +273,30 @@ XMLFileExporter::~XMLFileExporter() = default;
 
 bool XMLFileExporter::exportImplementation()
 {
-	xml.setDevice(device());
+	// Files are written in large chunks on a worker thread, while the XML
+	// is generated.
+	WriteBehindDevice write_behind(device());
+	auto* output = device();
+	if (qobject_cast<QFileDevice*>(output) && write_behind.open(QIODevice::WriteOnly))
+		output = &write_behind;
+	xml.setDevice(output);
 	
 	if (option(QString::fromLatin1("autoFormatting")).toBool())
 		xml.setAutoFormatting(true);
 	
+#ifdef MAPPER_USE_ZSTD
+	// Compression runs concurrently, while the XML is generated.
+	std::unique_ptr<ZstdCompressionDevice> compressor;
+	auto const compression_level = option(QString::fromLatin1("compressionLevel")).toInt();
+	if (compression_level > 0)
+	{
+		compressor = std::make_unique<ZstdCompressionDevice>(output, compression_level);
+		if (!compressor->open(QIODevice::WriteOnly))
+			throw FileFormatException(compressor->errorString());
+		xml.setDevice(compressor.get());
+	}
+#endif
+	
 #ifdef MAPPER_ENABLE_COMPATIBILITY
 	int current_version = XMLFileFormat::current_version;
 	bool retain_compatibility = Settings::getInstance().getSetting(Settings::General_RetainCompatiblity).toBool();
@@ -305,6 +368,23 @@ bool XMLFileExporter::exportImplementation()
 	}
 	
 	xml.writeEndDocument();
+	
+#ifdef MAPPER_USE_ZSTD
+	if (compressor)
+	{
+		xml.setDevice(device());
+		if (!compressor->finish())
+			throw FileFormatException(compressor->errorString());
+	}
+#endif
+	
+	if (output == &write_behind)
+	{
+		xml.setDevice(device());
+		if (!write_behind.finish())
+			throw FileFormatException(write_behind.errorString());
+	}
+	
 	return true;
 }
 
@@ -428,11 +508,16 @@ void XMLFileExporter::exportMapParts()
 	for (auto i = 0lu; i < num_parts; ++i)
 	{
 		writeLineBreak(xml);
-		map->getPart(i)->save(xml);
+		exportMapPart(*map->getPart(i));
 	}
 	writeLineBreak(xml);
 }
 
+void XMLFileExporter::exportMapPart(const MapPart& part)
+{
+	part.save(xml);
+}
+
 void XMLFileExporter::exportTemplates()
 {
 	QDir map_dir;
@@ -515,6 +600,94 @@ void XMLFileExporter::exportRedo()
 
 
 
+// ### XMLFileSnapshotExporter definition ###
+
+XMLFileSnapshotExporter::XMLFileSnapshotExporter(const QString& path, const Map* map, const MapView* view)
+: XMLFileExporter(path, map, view)
+{
+	// The snapshot is spliced by position.
+	setOption(QString::fromLatin1("compressionLevel"), 0);
+}
+
+XMLFileSnapshotExporter::~XMLFileSnapshotExporter() = default;
+
+bool XMLFileSnapshotExporter::takeSnapshot()
+{
+	data.clear();
+	parts.clear();
+	
+	QBuffer buffer(&data);
+	setDevice(&buffer);
+	auto const success = doExport();
+	// The version is set by doExport(), on the same thread.
+	format_version = XMLFileFormat::active_version;
+	xml.setDevice(nullptr);
+	setDevice(nullptr);
+	symbol_indices.clear();
+	return success;
+}
+
+bool XMLFileSnapshotExporter::writeSnapshot()
+{
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		addWarning(file.errorString());
+		return false;
+	}
+	
+	QXmlStreamWriter object_xml(&file);
+	qint64 pos = 0;
+	for (const auto& part : parts)
+	{
+		file.write(data.constData() + pos, part.pos - pos);
+		pos = part.pos;
+		for (const auto& item : part.objects)
+		{
+			item.object->save(object_xml, item.symbol_index, item.rotatable, format_version);
+			writeLineBreak(object_xml);
+		}
+	}
+	file.write(data.constData() + pos, data.size() - pos);
+	
+	if (object_xml.hasError() || !file.commit())
+	{
+		addWarning(file.errorString());
+		return false;
+	}
+	return true;
+}
+
+void XMLFileSnapshotExporter::exportMapPart(const MapPart& part)
+{
+	XmlElementWriter part_element(xml, literal::part);
+	part_element.writeAttribute(literal::name, part.getName());
+	{
+		XmlElementWriter objects_element(xml, literal::objects);
+		objects_element.writeAttribute(literal::count, std::size_t(part.getNumObjects()));
+		writeLineBreak(xml);
+		
+		// The objects will be inserted here by writeSnapshot().
+		parts.push_back({device()->pos(), {}});
+		auto& objects = parts.back().objects;
+		objects.reserve(std::size_t(part.getNumObjects()));
+		for (int i = 0; i < part.getNumObjects(); ++i)
+		{
+			auto const* object = part.getObject(i);
+			auto const* symbol = object->getSymbol();
+			auto symbol_index = symbol_indices.find(symbol);
+			if (symbol_index == symbol_indices.end())
+				symbol_index = symbol_indices.insert(symbol, map->findSymbolIndex(symbol));
+			
+			std::unique_ptr<Object> duplicate { object->duplicate() };
+			duplicate->setSymbol(nullptr, true);
+			objects.push_back({std::move(duplicate), *symbol_index, symbol->isRotatable()});
+		}
+	}
+}
+
+
+
 // ### XMLFileImporter definition ###
 
 XMLFileImporter::XMLFileImporter(const QString& path, Map *map, MapView *view)
@@ -536,13 +709,36 @@ void XMLFileImporter::addWarningUnsupportedElement()
 
 bool XMLFileImporter::importImplementation()
 {
-	xml.setDevice(device());
+	auto const header = device()->peek(4);
+	input_size = device()->isSequential() ? 0 : device()->size();
+	
+	// Files are read in large chunks, and the next chunk is read on a worker
+	// thread while the XML is parsed.
+	ReadAheadDevice read_ahead(device());
+	auto* input = device();
+	if (qobject_cast<QFileDevice*>(input) && read_ahead.open(QIODevice::ReadOnly))
+		input = &read_ahead;
+	xml.setDevice(input);
+	
+	if (isZstdCompressed(header.constData(), header.size()))
+	{
+#ifdef MAPPER_USE_ZSTD
+		// Decompression feeds the reader while the file is read.
+		decompressor = std::make_unique<ZstdDecompressionDevice>(input);
+		if (!decompressor->open(QIODevice::ReadOnly))
+			throw FileFormatException(decompressor->errorString());
+		xml.setDevice(decompressor.get());
+		input_size = 0;
+#else
+		throw FileFormatException(::OpenOrienteering::Importer::tr("Compressed map files are not supported by this program version."));
+#endif
+	}
 	if (!xml.readNextStartElement() || xml.name() != literal::map)
 	{
-		if (device()->seek(0))
+		if (input->seek(0))
 		{
 			char data[4] = {};
-			device()->read(data, 4);
+			input->read(data, 4);
 			if (qstrncmp(data, "OMAP", 4) == 0)
 			{
 				throw FileFormatException(::OpenOrienteering::Importer::tr(
@@ -961,12 +1157,12 @@ void XMLFileImporter::importMapParts()
 		if (xml.name() == literal::part)
 		{
 			auto recovery = XmlRecoveryHelper(xml);
-			auto part = MapPart::load(xml, *map, symbol_dict);
+			auto part = importMapPart();
 			if (xml.hasError() && recovery())
 			{
 				addWarning(tr("Some invalid characters had to be removed."));
 				delete part;
-				part = MapPart::load(xml, *map, symbol_dict);
+				part = importMapPart();
 			}
 			map->parts.push_back(part);
 		}
@@ -990,6 +1186,16 @@ void XMLFileImporter::importMapParts()
 	emit map->currentMapPartChanged(map->getPart(map->current_part_index));
 }
 
+MapPart* XMLFileImporter::importMapPart()
+{
+	// The input is read ahead on another thread, so the progress is taken
+	// from the parser. The size of compressed input is unknown.
+	auto const progress = [this]() {
+		reportProgress(input_size > 0 ? int(qMin(qint64(99), 100 * xml.characterOffset() / input_size)) : 0);
+	};
+	return MapPart::load(xml, *map, symbol_dict, progress);
+}
+
 void XMLFileImporter::importTemplates()
 {
 	FILEFORMAT_ASSERT(xml.name() == literal::templates);
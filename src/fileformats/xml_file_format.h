@@ -96,6 +96,7 @@ public:
 - For writing, drop compatibility with Mapper versions before 0.9.
 - Use the streaming variant when writing `barrier` elements.
 - Stop writing text object box sizes to the coordinates stream.
+- Write `coords` elements in the compact delta encoding.
 
 
 \subsection version-9  Version 9
@@ -108,6 +109,11 @@ public:
 - 2019-10-02 Added a text symbol `rotatable` property. This must be exported as
              `true` now when the text symbol is rotatable, but default to `true`
              when reading previous versions of the format.
+- 2026-10-14 Added reading of a compact delta encoding of `coords` elements,
+             marked by the attribute `encoding="delta"`. The base64 text holds
+             zigzag varints of the differences of native x and y to the
+             previous coordinate. The lowest bit of the x value indicates a
+             following varint for the flags.
 
 
 \subsection version-8 Version 8
@@ -22,8 +22,14 @@
 #define OPENORIENTEERING_FILE_FORMAT_XML_P_H
 
 #include <functional>
+#include <memory>
+#include <vector>
 
+#include <QtGlobal>
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QHash>
+#include <QIODevice>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
@@ -32,6 +38,11 @@
 
 namespace OpenOrienteering {
 
+class MapPart;
+class Object;
+class Symbol;
+
+
 /** Map exporter for the xml based map format. */
 class XMLFileExporter : public Exporter
 {
@@ -54,17 +65,85 @@ protected:
 	void exportColors();
 	void exportSymbols();
 	void exportMapParts();
+	
+	/**
+	 * Writes a single map part.
+	 * 
+	 * The default implementation writes the part with all its objects.
+	 */
+	virtual void exportMapPart(const MapPart& part);
+	
 	void exportTemplates();
 	void exportView();
 	void exportPrint();
 	void exportUndo();
 	void exportRedo();
 	
-private:
 	QXmlStreamWriter xml;
 };
 
 
+/**
+ * Map exporter which takes a snapshot of the map for writing on another thread.
+ * 
+ * takeSnapshot() serializes everything but the map objects to memory, and it
+ * copies the objects. It must be called on the thread which owns the map.
+ * writeSnapshot() serializes the copied objects and writes the file. It does
+ * not access the map, so it may be called on another thread while the map is
+ * modified.
+ */
+class XMLFileSnapshotExporter : public XMLFileExporter
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::XMLFileSnapshotExporter)
+	
+public:
+	XMLFileSnapshotExporter(const QString& path, const Map* map, const MapView* view);
+	~XMLFileSnapshotExporter() override;
+	
+	/**
+	 * Takes the snapshot.
+	 * 
+	 * This replaces doExport(). Modified templates are saved, too.
+	 * Returns false on error, with the message in warnings().
+	 */
+	bool takeSnapshot();
+	
+	/**
+	 * Writes the snapshot to the exporter's path.
+	 * 
+	 * Returns false on error, with the message in warnings().
+	 */
+	bool writeSnapshot();
+	
+protected:
+	/**
+	 * Writes the part element, and copies the part's objects.
+	 */
+	void exportMapPart(const MapPart& part) override;
+	
+private:
+	using Exporter::doExport;
+	
+	struct ObjectSnapshot
+	{
+		std::unique_ptr<Object> object;
+		int symbol_index;
+		bool rotatable;
+	};
+	
+	struct PartSnapshot
+	{
+		qint64 pos;  ///< The position of the objects in the data
+		std::vector<ObjectSnapshot> objects;
+	};
+	
+	QByteArray data;
+	std::vector<PartSnapshot> parts;
+	QHash<const Symbol*, int> symbol_indices;
+	int format_version = 0;  ///< The file format version of the snapshot
+};
+
+
 /** Map importer for the xml based map format. */
 class XMLFileImporter : public Importer
 {
@@ -94,15 +173,26 @@ protected:
 	void importColors();
 	void importSymbols();
 	void importMapParts();
+	
+	/**
+	 * Reads a single map part from the current part element.
+	 * 
+	 * The default implementation reads the part with all its objects.
+	 */
+	virtual MapPart* importMapPart();
+	
 	void importTemplates();
 	void importView();
 	void importPrint();
 	void importUndo();
 	void importRedo();
 	
-private:
 	QXmlStreamReader xml;
 	SymbolDictionary symbol_dict;
+	
+private:
+	std::unique_ptr<QIODevice> decompressor;
+	qint64 input_size = 0;  ///< The size of the uncompressed input for progress reports, or 0.
 	int version = -1;
 	bool georef_offset_adjusted;
 };
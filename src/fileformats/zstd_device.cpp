@@ -0,0 +1,282 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "zstd_device.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include <QtGlobal>
+#include <QString>
+
+#include <zstd.h>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * The amount of data which is collected before passing it to the compressor.
+ * 
+ * This is large enough to let a worker thread do the compression, while the
+ * next chunk is produced.
+ */
+constexpr int chunk_size = 1 << 20;
+
+QString errorString(std::size_t result)
+{
+	return QString::fromLatin1(ZSTD_getErrorName(result));
+}
+
+
+}  // namespace
+
+
+
+// ### ZstdCompressionDevice ###
+
+ZstdCompressionDevice::ZstdCompressionDevice(QIODevice* device, int level)
+: device(device)
+, level(level)
+{
+	// nothing else
+}
+
+ZstdCompressionDevice::~ZstdCompressionDevice()
+{
+	close();
+	ZSTD_freeCCtx(context);
+}
+
+
+// static
+int ZstdCompressionDevice::maxLevel()
+{
+	return ZSTD_maxCLevel();
+}
+
+
+bool ZstdCompressionDevice::isSequential() const
+{
+	return true;
+}
+
+bool ZstdCompressionDevice::open(OpenMode mode)
+{
+	if ((mode & ReadWrite) != WriteOnly || !device || !device->isWritable())
+	{
+		setErrorString(tr("Unsupported mode"));
+		return false;
+	}
+	
+	if (!context)
+		context = ZSTD_createCCtx();
+	if (!context)
+	{
+		setErrorString(tr("Out of memory"));
+		return false;
+	}
+	
+	ZSTD_CCtx_reset(context, ZSTD_reset_session_and_parameters);
+	ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level);
+	// Compress on a worker thread. This fails harmlessly when the library
+	// was built without multi-threading support.
+	ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, 1);
+	
+	input.clear();
+	input.reserve(chunk_size);
+	output.resize(int(ZSTD_CStreamOutSize()));
+	finished = false;
+	return QIODevice::open(mode | Unbuffered);
+}
+
+void ZstdCompressionDevice::close()
+{
+	if (isOpen())
+	{
+		finish();
+		QIODevice::close();
+	}
+}
+
+bool ZstdCompressionDevice::finish()
+{
+	if (!isOpen())
+		return false;
+	
+	if (!finished)
+		finished = compress(true);
+	return finished;
+}
+
+
+qint64 ZstdCompressionDevice::readData(char* /*data*/, qint64 /*max_size*/)
+{
+	return -1;
+}
+
+qint64 ZstdCompressionDevice::writeData(const char* data, qint64 size)
+{
+	if (finished)
+		return -1;
+	
+	auto remaining = size;
+	while (remaining > 0)
+	{
+		auto const count = int(std::min(remaining, qint64(chunk_size - input.size())));
+		input.append(data, count);
+		data += count;
+		remaining -= count;
+		if (input.size() >= chunk_size && !compress(false))
+			return -1;
+	}
+	return size;
+}
+
+
+bool ZstdCompressionDevice::compress(bool end)
+{
+	auto const mode = end ? ZSTD_e_end : ZSTD_e_continue;
+	ZSTD_inBuffer in = { input.constData(), std::size_t(input.size()), 0 };
+	for (;;)
+	{
+		ZSTD_outBuffer out = { output.data(), std::size_t(output.size()), 0 };
+		auto const result = ZSTD_compressStream2(context, &out, &in, mode);
+		if (ZSTD_isError(result))
+		{
+			setErrorString(errorString(result));
+			return false;
+		}
+		if (out.pos > 0 && device->write(output.constData(), qint64(out.pos)) != qint64(out.pos))
+		{
+			setErrorString(device->errorString());
+			return false;
+		}
+		if (end ? result == 0 : in.pos == in.size)
+			break;
+	}
+	input.clear();
+	return true;
+}
+
+
+
+// ### ZstdDecompressionDevice ###
+
+ZstdDecompressionDevice::ZstdDecompressionDevice(QIODevice* device)
+: device(device)
+{
+	// nothing else
+}
+
+ZstdDecompressionDevice::~ZstdDecompressionDevice()
+{
+	close();
+	ZSTD_freeDCtx(context);
+}
+
+
+bool ZstdDecompressionDevice::isSequential() const
+{
+	return true;
+}
+
+bool ZstdDecompressionDevice::open(OpenMode mode)
+{
+	if ((mode & ReadWrite) != ReadOnly || !device || !device->isReadable())
+	{
+		setErrorString(tr("Unsupported mode"));
+		return false;
+	}
+	
+	if (!context)
+		context = ZSTD_createDCtx();
+	if (!context)
+	{
+		setErrorString(tr("Out of memory"));
+		return false;
+	}
+	
+	ZSTD_DCtx_reset(context, ZSTD_reset_session_and_parameters);
+	input.clear();
+	input_pos = 0;
+	frame_complete = true;
+	end_reached = false;
+	return QIODevice::open(mode);
+}
+
+void ZstdDecompressionDevice::close()
+{
+	input.clear();
+	QIODevice::close();
+}
+
+bool ZstdDecompressionDevice::atEnd() const
+{
+	return end_reached && QIODevice::atEnd();
+}
+
+
+qint64 ZstdDecompressionDevice::readData(char* data, qint64 max_size)
+{
+	if (end_reached)
+		return -1;
+	
+	ZSTD_outBuffer out = { data, std::size_t(max_size), 0 };
+	while (out.pos == 0 && out.size > 0)
+	{
+		if (input_pos == input.size())
+		{
+			input = device->read(qint64(ZSTD_DStreamInSize()));
+			input_pos = 0;
+			if (input.isEmpty())
+			{
+				end_reached = true;
+				if (!frame_complete)
+				{
+					setErrorString(tr("Unexpected end of compressed data"));
+					return -1;
+				}
+				break;
+			}
+		}
+		
+		ZSTD_inBuffer in = { input.constData(), std::size_t(input.size()), std::size_t(input_pos) };
+		auto const result = ZSTD_decompressStream(context, &out, &in);
+		input_pos = int(in.pos);
+		if (ZSTD_isError(result))
+		{
+			setErrorString(errorString(result));
+			end_reached = true;
+			return -1;
+		}
+		frame_complete = (result == 0);
+	}
+	return (out.pos == 0 && end_reached) ? -1 : qint64(out.pos);
+}
+
+qint64 ZstdDecompressionDevice::writeData(const char* /*data*/, qint64 /*size*/)
+{
+	return -1;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,168 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_ZSTD_DEVICE_H
+#define OPENORIENTEERING_ZSTD_DEVICE_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QIODevice>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A sequential output device which compresses the written data with zstd.
+ * 
+ * The compressed data is written to the underlying device. Data is collected
+ * in chunks, and compression runs on a worker thread of the zstd library when
+ * available, so that the producer of the data, e.g. a QXmlStreamWriter, can
+ * continue while the previous chunk is compressed.
+ * 
+ * finish() must be called to complete the compressed stream. The underlying
+ * device is not closed.
+ */
+class ZstdCompressionDevice : public QIODevice
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::ZstdCompressionDevice)
+	
+public:
+	/**
+	 * The default compression level.
+	 */
+	static constexpr int default_level = 3;
+	
+	/**
+	 * Constructs a device writing to the given device, with the given
+	 * compression level.
+	 */
+	ZstdCompressionDevice(QIODevice* device, int level = default_level);
+	
+	ZstdCompressionDevice(const ZstdCompressionDevice&) = delete;
+	ZstdCompressionDevice(ZstdCompressionDevice&&) = delete;
+	
+	~ZstdCompressionDevice() override;
+	
+	ZstdCompressionDevice& operator=(const ZstdCompressionDevice&) = delete;
+	ZstdCompressionDevice& operator=(ZstdCompressionDevice&&) = delete;
+	
+	/**
+	 * Returns the highest supported compression level.
+	 */
+	static int maxLevel();
+	
+	
+	bool isSequential() const override;
+	
+	/**
+	 * Opens the device. Only QIODevice::WriteOnly is supported.
+	 */
+	bool open(OpenMode mode) override;
+	
+	/**
+	 * Finishes the compressed stream, and closes the device.
+	 */
+	void close() override;
+	
+	/**
+	 * Compresses all pending data and completes the compressed stream.
+	 * 
+	 * Returns false on error, with the message in errorString().
+	 */
+	bool finish();
+	
+protected:
+	qint64 readData(char* data, qint64 max_size) override;
+	
+	qint64 writeData(const char* data, qint64 size) override;
+	
+private:
+	bool compress(bool end);
+	
+	QIODevice* const device;
+	ZSTD_CCtx_s* context = nullptr;
+	int level;
+	QByteArray input;
+	QByteArray output;
+	bool finished = false;
+};
+
+
+
+/**
+ * A sequential input device which decompresses zstd data.
+ * 
+ * The compressed data is read from the underlying device in small chunks,
+ * as needed for the requested amount of decompressed data. So a consumer
+ * such as a QXmlStreamReader starts working before the whole file has been
+ * read.
+ */
+class ZstdDecompressionDevice : public QIODevice
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::ZstdDecompressionDevice)
+	
+public:
+	/**
+	 * Constructs a device reading from the given device.
+	 */
+	explicit ZstdDecompressionDevice(QIODevice* device);
+	
+	ZstdDecompressionDevice(const ZstdDecompressionDevice&) = delete;
+	ZstdDecompressionDevice(ZstdDecompressionDevice&&) = delete;
+	
+	~ZstdDecompressionDevice() override;
+	
+	ZstdDecompressionDevice& operator=(const ZstdDecompressionDevice&) = delete;
+	ZstdDecompressionDevice& operator=(ZstdDecompressionDevice&&) = delete;
+	
+	
+	bool isSequential() const override;
+	
+	/**
+	 * Opens the device. Only QIODevice::ReadOnly is supported.
+	 */
+	bool open(OpenMode mode) override;
+	
+	void close() override;
+	
+	bool atEnd() const override;
+	
+protected:
+	qint64 readData(char* data, qint64 max_size) override;
+	
+	qint64 writeData(const char* data, qint64 size) override;
+	
+private:
+	QIODevice* const device;
+	ZSTD_DCtx_s* context = nullptr;
+	QByteArray input;
+	int input_pos = 0;
+	bool frame_complete = true;
+	bool end_reached = false;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_ZSTD_DEVICE_H
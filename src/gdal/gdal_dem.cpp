@@ -0,0 +1,180 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gdal_dem.h"
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include <QtGlobal>
+#include <QtMath>
+#include <QImage>
+#include <QRgb>
+#include <QString>
+
+#include <cpl_error.h>
+#include <gdal.h>
+#include <gdal_alg.h>
+
+#include "gdal/gdal_manager.h"
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The direction of the light for hillshading, clockwise from north
+constexpr double azimuth = 315;
+
+/// The angle of the light above the horizon for hillshading
+constexpr double altitude = 45;
+
+
+/**
+ * Forwards the output of GDAL's contour generator to a sink.
+ */
+CPLErr writeContour(double level, int num_points, double* x, double* y, void* data)
+{
+	auto const& sink = *static_cast<const std::function<void (double, std::vector<QPointF>&&)>*>(data);
+	std::vector<QPointF> line;
+	line.reserve(std::size_t(num_points));
+	for (int i = 0; i < num_points; ++i)
+		line.emplace_back(x[i], y[i]);
+	sink(level, std::move(line));
+	return CE_None;
+}
+
+}  // namespace
+
+
+
+void shadeRelief(QImage& image, const float* elevation, double cell_width, double cell_height, ReliefShading shading)
+{
+	Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+	
+	auto const width = image.width();
+	auto const stride = std::size_t(width) + 2;
+	auto const zenith = qDegreesToRadians(90 - altitude);
+	auto const cos_zenith = std::cos(zenith);
+	auto const sin_zenith = std::sin(zenith);
+	auto const azimuth_math = qDegreesToRadians(360 - azimuth + 90);
+	
+	auto* const bits = image.bits();  // Detaches once, before the threads start.
+	auto const bytes_per_line = std::size_t(image.bytesPerLine());
+	Util::parallelFor(std::size_t(image.height()), 32, [=](std::size_t first, std::size_t last) {
+		for (auto y = first; y < last; ++y)
+		{
+			auto* row = reinterpret_cast<QRgb*>(bits + y * bytes_per_line);
+			auto const* above = elevation + y * stride;
+			auto const* center = above + stride;
+			auto const* below = center + stride;
+			for (int x = 0; x < width; ++x)
+			{
+				auto const z = center[x + 1];
+				if (std::isnan(z))
+				{
+					row[x] = 0;
+					continue;
+				}
+				
+				// Missing neighbours are replaced by the center value.
+				auto value = [z](float v) { return double(std::isnan(v) ? z : v); };
+				auto const a = value(above[x]), b = value(above[x + 1]), c = value(above[x + 2]);
+				auto const d = value(center[x]),                          f = value(center[x + 2]);
+				auto const g = value(below[x]), h = value(below[x + 1]), i = value(below[x + 2]);
+				
+				// Horn's method
+				auto const dz_dx = ((c + 2 * f + i) - (a + 2 * d + g)) / (8 * cell_width);
+				auto const dz_dy = ((g + 2 * h + i) - (a + 2 * b + c)) / (8 * cell_height);
+				auto const slope = std::atan(std::hypot(dz_dx, dz_dy));
+				
+				auto shade = 0.0;
+				if (shading == ReliefShading::Slope)
+				{
+					shade = 1 - slope / M_PI_2;
+				}
+				else
+				{
+					auto const aspect = std::atan2(dz_dy, -dz_dx);
+					shade = cos_zenith * std::cos(slope)
+					        + sin_zenith * std::sin(slope) * std::cos(azimuth_math - aspect);
+				}
+				auto const gray = qBound(0, qRound(255 * shade), 255);
+				row[x] = qRgb(gray, gray, gray);
+			}
+		}
+	});
+}
+
+
+bool traceContours(const QString& path, double interval, double base,
+                   const std::function<void (double, std::vector<QPointF>&&)>& sink,
+                   const std::function<bool (int)>& progress)
+{
+	if (interval <= 0)
+		return false;
+	
+	GdalManager().registerDrivers();
+	CPLErrorReset();
+	auto dataset = GDALOpen(path.toUtf8(), GA_ReadOnly);
+	if (!dataset)
+		return false;
+	
+	auto const width = GDALGetRasterXSize(dataset);
+	auto const height = GDALGetRasterYSize(dataset);
+	auto band = GDALGetRasterBand(dataset, 1);
+	auto has_nodata = 0;
+	auto const nodata = GDALGetRasterNoDataValue(band, &has_nodata);
+	
+	// GDAL places the values at the pixel centers.
+	auto const shifted_sink = [&sink](double level, std::vector<QPointF>&& line) {
+		for (auto& point : line)
+			point += QPointF(0.5, 0.5);
+		sink(level, std::move(line));
+	};
+	auto writer_data = std::function<void (double, std::vector<QPointF>&&)>(shifted_sink);
+	auto generator = GDAL_CG_Create(width, height, has_nodata, nodata, interval, base, &writeContour, &writer_data);
+	
+	auto ok = generator != nullptr;
+	std::vector<double> scanline(std::size_t(width));
+	auto last_percent = -1;
+	for (int y = 0; ok && y < height; ++y)
+	{
+		ok = GDALRasterIO(band, GF_Read, 0, y, width, 1, scanline.data(), width, 1, GDT_Float64, 0, 0) == CE_None
+		     && GDAL_CG_FeedLine(generator, scanline.data()) == CE_None;
+		
+		auto const percent = int(100 * qint64(y) / height);
+		if (ok && percent != last_percent && progress)
+		{
+			last_percent = percent;
+			ok = progress(percent);
+		}
+	}
+	
+	// Destroying the generator flushes the remaining lines.
+	if (generator)
+		GDAL_CG_Destroy(generator);
+	GDALClose(dataset);
+	return ok;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,81 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_GDAL_DEM_H
+#define OPENORIENTEERING_GDAL_DEM_H
+
+#include <functional>
+#include <vector>
+
+#include <QPointF>
+
+class QImage;
+class QString;
+
+namespace OpenOrienteering {
+
+
+/**
+ * The ways of drawing an elevation raster.
+ */
+enum class ReliefShading
+{
+	None,       ///< The raster is not an elevation model.
+	Hillshade,  ///< Illumination from the north-west, at 45 degrees altitude.
+	Slope,      ///< Darker for steeper terrain.
+};
+
+
+/**
+ * Computes the shaded relief for a grid of elevation values.
+ * 
+ * The grid has one row and one column more than the image on each side, so
+ * that the pixels at the edges have all neighbours. NaN marks missing values;
+ * the corresponding pixels are transparent. The image must have the format
+ * QImage::Format_ARGB32_Premultiplied.
+ * 
+ * @param image        The image to be filled.
+ * @param elevation    The elevation grid, row by row.
+ * @param cell_width   The horizontal distance of the grid values, in elevation units.
+ * @param cell_height  The vertical distance of the grid values, in elevation units.
+ * @param shading      The kind of relief.
+ */
+void shadeRelief(QImage& image, const float* elevation, double cell_width, double cell_height, ReliefShading shading);
+
+
+/**
+ * Traces contour lines in the first band of an elevation raster.
+ * 
+ * The raster is read line by line, and each completed contour line is passed
+ * to the sink. The coordinates are raster pixel coordinates, with the top-left
+ * corner of the raster at (0, 0).
+ * 
+ * The progress callback receives the percentage of the lines processed. When
+ * it returns false, the tracing is cancelled.
+ * 
+ * Returns false on error or when cancelled.
+ */
+bool traceContours(const QString& path, double interval, double base,
+                   const std::function<void (double, std::vector<QPointF>&&)>& sink,
+                   const std::function<bool (int)>& progress);
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_GDAL_DEM_H
@@ -0,0 +1,197 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gdal_extraction_cache.h"
+
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <cpl_conv.h>
+#include <cpl_string.h>
+#include <cpl_vsi.h>
+#include <gdal.h>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QSaveFile>
+#include <QString>
+
+#include "util/disk_cache.h"
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace GdalExtractionCache {
+
+namespace {
+
+/// The suffix of entries which are still being extracted
+const auto partial_suffix = QLatin1String(".part");
+
+const char* const archive_prefixes[] = { "/vsizip/", "/vsitar/", "/vsigzip/", "/vsi7z/", "/vsirar/" };
+
+std::mutex pending_mutex;
+std::set<QByteArray> pending_keys;
+
+
+QString entryPath(const QByteArray& path, const QByteArray& key)
+{
+	return DiskCache::entryPath(DiskCache::ExtractedFiles, key)
+	       + QLatin1Char('/') + QString::fromUtf8(CPLGetFilename(path));
+}
+
+bool copyFile(const QByteArray& source, const QString& target)
+{
+	auto* input = VSIFOpenL(source, "rb");
+	if (!input)
+		return false;
+	
+	QSaveFile output(target);
+	auto ok = output.open(QIODevice::WriteOnly);
+	QByteArray buffer(1 << 20, Qt::Uninitialized);
+	while (ok)
+	{
+		auto const count = VSIFReadL(buffer.data(), 1, std::size_t(buffer.size()), input);
+		if (count == 0)
+		{
+			ok = VSIFEofL(input) != 0;
+			break;
+		}
+		ok = output.write(buffer.constData(), qint64(count)) == qint64(count);
+	}
+	VSIFCloseL(input);
+	return ok && output.commit();
+}
+
+/**
+ * Extracts the dataset at the given path, with its sidecar files.
+ */
+void extract(const QByteArray& path, const QByteArray& key)
+{
+	auto const entry = QFileInfo(entryPath(path, key)).absolutePath();
+	auto const partial_entry = entry + partial_suffix;
+	QDir(partial_entry).removeRecursively();
+	
+	// World files, .aux.xml files etc. must be next to the extracted file.
+	std::vector<QByteArray> files = { path };
+	if (auto* dataset = GDALOpen(path, GA_ReadOnly))
+	{
+		auto const directory = QByteArray(CPLGetPath(path));
+		auto** file_list = GDALGetFileList(dataset);
+		for (auto** file = file_list; file && *file; ++file)
+		{
+			auto const file_path = QByteArray(*file);
+			if (file_path != path && directory == CPLGetPath(file_path))
+				files.push_back(file_path);
+		}
+		CSLDestroy(file_list);
+		GDALClose(dataset);
+	}
+	
+	auto ok = QDir().mkpath(partial_entry);
+	for (auto const& file : files)
+	{
+		if (!ok)
+			break;
+		ok = copyFile(file, partial_entry + QLatin1Char('/') + QString::fromUtf8(CPLGetFilename(file)));
+	}
+	// Entries appear only when complete.
+	if (ok)
+		ok = QDir().rename(partial_entry, entry);
+	if (!ok)
+	{
+		qDebug("GdalExtractionCache: Failed to extract %s", path.constData());
+		QDir(partial_entry).removeRecursively();
+	}
+	
+	DiskCache::trim(DiskCache::ExtractedFiles);
+}
+
+
+}  // namespace
+
+
+
+bool isArchiveMember(const QByteArray& path)
+{
+	for (auto const* prefix : archive_prefixes)
+	{
+		if (path.startsWith(prefix))
+			return true;
+	}
+	return false;
+}
+
+
+QByteArray fileKey(const QByteArray& path)
+{
+	VSIStatBufL stat_buf;
+	if (VSIStatL(path, &stat_buf) != 0)
+		return {};
+	
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(path);
+	hash.addData(QByteArray::number(qint64(stat_buf.st_size)));
+	hash.addData(QByteArray::number(qint64(stat_buf.st_mtime)));
+	return hash.result().toHex();
+}
+
+
+QByteArray localPath(const QByteArray& path)
+{
+	if (!isArchiveMember(path))
+		return path;
+	
+	auto const key = fileKey(path);
+	if (key.isEmpty())
+		return path;
+	
+	auto const local_path = entryPath(path, key);
+	if (QFileInfo::exists(local_path))
+	{
+		DiskCache::touch(DiskCache::ExtractedFiles, local_path);
+		return local_path.toUtf8();
+	}
+	
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	if (pending_keys.insert(key).second)
+	{
+		Util::startJob<void>([path, key]() {
+			extract(path, key);
+			std::lock_guard<std::mutex> lock(pending_mutex);
+			pending_keys.erase(key);
+		});
+	}
+	return path;
+}
+
+
+}  // namespace GdalExtractionCache
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,74 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_GDAL_EXTRACTION_CACHE_H
+#define OPENORIENTEERING_GDAL_EXTRACTION_CACHE_H
+
+class QByteArray;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A persistent cache of files extracted from archives.
+ * 
+ * Raster templates may refer to files inside of archives through GDAL's
+ * virtual file systems, e.g. the ground overlay images of KMZ files, or
+ * zipped GeoTIFFs. Reading such files means decompressing them again each
+ * time the template is loaded or a tile is read. This cache keeps extracted
+ * copies in the application's cache location, together with the dataset's
+ * sidecar files from the same archive. Extraction runs as a background job,
+ * so the first access uses the archive directly.
+ * 
+ * Entries are keyed by the path, size and modification time of the file
+ * inside the archive. They are stored in the DiskCache::ExtractedFiles
+ * category, which evicts the least recently used entries.
+ * 
+ * Paths must be passed as, and are returned as, UTF-8.
+ * These functions may be called concurrently from multiple threads.
+ */
+namespace GdalExtractionCache {
+
+/**
+ * Checks if a path refers to a file inside an archive.
+ */
+bool isArchiveMember(const QByteArray& path);
+
+/**
+ * Returns a hash of the path, size and modification time of a file,
+ * or an empty value if the file does not exist.
+ * 
+ * This works for all paths supported by GDAL's virtual file systems.
+ */
+QByteArray fileKey(const QByteArray& path);
+
+/**
+ * Returns the path of an extracted copy of the given archive member.
+ * 
+ * If there is no extracted copy yet, the extraction is started in the
+ * background, and the given path is returned. Paths which do not refer to
+ * archive members are returned unchanged.
+ */
+QByteArray localPath(const QByteArray& path);
+
+}  // namespace GdalExtractionCache
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_GDAL_EXTRACTION_CACHE_H
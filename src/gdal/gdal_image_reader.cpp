@@ -1,5 +1,5 @@
 /*
- *    Copyright 2019, 2020 Kai Pastor
+ *    Copyright 2019, 2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,13 +21,20 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
 #include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <vector>
 
 #include <Qt>
 #include <QtGlobal>
 #include <QCoreApplication>
 #include <QImage>
 #include <QImageReader>
+#include <QPoint>
+#include <QRect>
 #include <QRgb>
 #include <QSize>
 #include <QString>
@@ -36,10 +43,22 @@
 
 #include <cpl_conv.h>
 #include <gdal.h>
+#include <gdalwarper.h>
 #include <ogr_api.h>
 #include <ogr_srs_api.h>
 
 #include "gdal/gdal_manager.h"
+#include "util/parallel.h"
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define MAPPER_IMAGE_READER_SSE2
+#    include <emmintrin.h>
+#  elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define MAPPER_IMAGE_READER_NEON
+#    include <arm_neon.h>
+#  endif
+#endif
 
 
 namespace {
@@ -54,17 +73,157 @@ QString toWkt(OGRSpatialReferenceH srs)
 	return wkt;
 }
 
+
+/*
+ * The kernels follow the integer arithmetics of qPremultiply(), so that
+ * their results are identical. The gray variants take the gray value from
+ * the red channel, and copy it to the green and blue channels first.
+ */
+
+#if defined(MAPPER_IMAGE_READER_SSE2)
+
+// Each 16-bit vector holds two pixels, with the alpha channel in lanes 3 and 7.
+
+inline __m128i div255(__m128i x)
+{
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x80)), 8);
+}
+
+inline __m128i alphas(__m128i x)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+inline __m128i grays(__m128i x)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 2, 2, 2)), _MM_SHUFFLE(3, 2, 2, 2));
+}
+
+inline __m128i premultiply(__m128i x)
+{
+	auto const colors = div255(_mm_mullo_epi16(x, alphas(x)));
+	auto const alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	return _mm_or_si128(_mm_and_si128(alpha_mask, x), _mm_andnot_si128(alpha_mask, colors));
+}
+
+template <bool gray>
+int premultiplySimd(QRgb* pixels, int count)
+{
+	auto const zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		auto const x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+		auto lo = _mm_unpacklo_epi8(x, zero);
+		auto hi = _mm_unpackhi_epi8(x, zero);
+		if (gray)
+		{
+			lo = grays(lo);
+			hi = grays(hi);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_packus_epi16(premultiply(lo), premultiply(hi)));
+	}
+	return i;
 }
 
+#elif defined(MAPPER_IMAGE_READER_NEON)
+
+// Each 16-bit vector holds two pixels, with the alpha channel in lanes 3 and 7.
+
+inline uint16x8_t div255(uint16x8_t x)
+{
+	return vshrq_n_u16(vaddq_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), vdupq_n_u16(0x80)), 8);
+}
+
+inline uint8x8_t premultiply(uint8x8_t x8)
+{
+	static const uint8_t indices[8] = { 3, 3, 3, 3, 7, 7, 7, 7 };
+	auto const alphas = vmovl_u8(vtbl1_u8(x8, vld1_u8(indices)));
+	auto const colors = div255(vmulq_u16(vmovl_u8(x8), alphas));
+	static const uint16_t mask[8] = { 0, 0, 0, 0xffff, 0, 0, 0, 0xffff };
+	return vmovn_u16(vbslq_u16(vld1q_u16(mask), vmovl_u8(x8), colors));
+}
+
+inline uint8x8_t grays(uint8x8_t x8)
+{
+	static const uint8_t indices[8] = { 2, 2, 2, 3, 6, 6, 6, 7 };
+	return vtbl1_u8(x8, vld1_u8(indices));
+}
+
+template <bool gray>
+int premultiplySimd(QRgb* pixels, int count)
+{
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		auto* p = reinterpret_cast<uint8_t*>(pixels + i);
+		auto x = vld1_u8(p);
+		if (gray)
+			x = grays(x);
+		vst1_u8(p, premultiply(x));
+	}
+	return i;
+}
+
+#else
+
+template <bool gray>
+int premultiplySimd(QRgb* /*pixels*/, int /*count*/)
+{
+	return 0;
+}
+
+#endif
+
+
+template <bool gray>
+void premultiplyRow(QRgb* pixels, int count)
+{
+	for (int i = premultiplySimd<gray>(pixels, count); i < count; ++i)
+	{
+		auto qrgb = pixels[i];
+		if (gray)
+		{
+			auto const value = qRed(qrgb);
+			qrgb = qRgba(value, value, value, qAlpha(qrgb));
+		}
+		pixels[i] = qPremultiply(qrgb);
+	}
+}
+
+
+/**
+ * Premultiplies the pixels of an image of depth 32, with the scanlines
+ * distributed over the threads of the global thread pool.
+ */
+template <bool gray>
+void premultiplyImage(QImage& image)
+{
+	if (image.depth() != 32)
+		return;
+	
+	auto const width = image.width();
+	auto* const bits = image.bits();  // Detaches once, before the threads start.
+	auto const bytes_per_line = std::size_t(image.bytesPerLine());
+	OpenOrienteering::Util::parallelFor(std::size_t(image.height()), 64, [=](std::size_t first, std::size_t last) {
+		for (auto y = first; y < last; ++y)
+			premultiplyRow<gray>(reinterpret_cast<QRgb*>(bits + y * bytes_per_line), width);
+	});
+}
+
+}  // namespace
+
 
 namespace OpenOrienteering {
 
-GdalImageReader::GdalImageReader(const QString& path)
+GdalImageReader::GdalImageReader(const QString& path, const QByteArray& target_crs)
 : path(path)
 {
-	GdalManager();
+	GdalManager().registerDrivers();
 	CPLErrorReset();
 	dataset = GDALOpen(path.toUtf8(), GA_ReadOnly);
+	if (dataset && !target_crs.isEmpty())
+		warpTo(target_crs);
 	if (dataset)
 		raster_count = GDALGetRasterCount(dataset);
 	if (!canRead())
@@ -75,6 +234,8 @@ GdalImageReader::~GdalImageReader()
 {
 	if (dataset)
 		GDALClose(dataset);
+	if (source_dataset)
+		GDALClose(source_dataset);
 }
 
 bool GdalImageReader::canRead() const
@@ -112,6 +273,12 @@ QImage GdalImageReader::read()
 }
 
 bool GdalImageReader::read(QImage* image)
+{
+	auto const raster = readRasterInfo();
+	return read(image, raster, { QPoint(), raster.size }, raster.size);
+}
+
+bool GdalImageReader::read(QImage* image, const RasterInfo& raster, const QRect& region, const QSize& size)
 {
 	Q_ASSERT(image);
 	if (!image)
@@ -120,7 +287,6 @@ bool GdalImageReader::read(QImage* image)
 		return false;
 	}
 	
-	auto raster = readRasterInfo();
 	if (raster.image_format == QImage::Format_Invalid)
 	{
 		err = QImageReader::UnsupportedFormatError;
@@ -129,9 +295,9 @@ bool GdalImageReader::read(QImage* image)
 		return false;
 	}
 	
-	if (image->format() != raster.image_format || image->size() != raster.size)
+	if (image->format() != raster.image_format || image->size() != size)
 	{
-		*image = QImage(raster.size, raster.image_format);
+		*image = QImage(size, raster.image_format);
 	}
 	if (image->isNull())
 	{
@@ -139,17 +305,18 @@ bool GdalImageReader::read(QImage* image)
 		error_string = QCoreApplication::translate(
 		                   "OpenOrienteering::TemplateImage",
 		                   "Not enough free memory (image size: %1x%2 pixels)")
-		               .arg(raster.size.width()).arg(raster.size.height());
+		               .arg(size.width()).arg(size.height());
 		return false;
 	}
 	
+	if (raster.relief != ReliefShading::None)
+		return readRelief(image, raster, region, size);
+	
 	image->fill(Qt::white);
-	auto const width = raster.size.width();
-	auto const height = raster.size.height();
 	CPLErrorReset();
 	auto result = GDALDatasetRasterIO(dataset, GF_Read, 
-	                                  0, 0, width, height,
-	                                  image->bits() + raster.band_offset, width, height,
+	                                  region.x(), region.y(), region.width(), region.height(),
+	                                  image->bits() + raster.band_offset, size.width(), size.height(),
 	                                  GDT_Byte, raster.bands.count(), raster.bands.data(),
 	                                  raster.pixel_space, image->bytesPerLine(), raster.band_space);
 	if (result >= CE_Warning)
@@ -225,7 +392,22 @@ GdalImageReader::RasterInfo GdalImageReader::readRasterInfo() const
 			};
 			break;
 		default:
-			// unsupported
+			{
+				auto const data_type = GDALGetRasterDataType(GDALGetRasterBand(dataset, color_band));
+				if (data_type != GDT_Byte && !GDALDataTypeIsComplex(data_type))
+				{
+					// An elevation model
+					raster.image_format = QImage::Format_ARGB32_Premultiplied;
+					raster.relief = ReliefShading::Hillshade;
+					raster.bands.push_back(color_band);
+					auto geo_transform = std::array<double, 6> {};
+					if (GDALGetGeoTransform(dataset, geo_transform.data()) == CE_None)
+					{
+						raster.cell_width = std::hypot(geo_transform[1], geo_transform[4]);
+						raster.cell_height = std::hypot(geo_transform[2], geo_transform[5]);
+					}
+				}
+			}
 			break;
 		}
 	}
@@ -274,6 +456,97 @@ GdalImageReader::RasterInfo GdalImageReader::readRasterInfo() const
 	return raster;
 }
 
+bool GdalImageReader::readRelief(QImage* image, const RasterInfo& raster, const QRect& region, const QSize& size)
+{
+	// The grid gets one extra value on each side, read from the neighbouring
+	// raster pixels at the same resolution where available.
+	auto const step_x = std::max(1, qRound(qreal(region.width()) / size.width()));
+	auto const step_y = std::max(1, qRound(qreal(region.height()) / size.height()));
+	auto const left   = region.left() >= step_x ? 1 : 0;
+	auto const top    = region.top() >= step_y ? 1 : 0;
+	auto const right  = region.right() + step_x < raster.size.width() ? 1 : 0;
+	auto const bottom = region.bottom() + step_y < raster.size.height() ? 1 : 0;
+	auto const source = region.adjusted(-left * step_x, -top * step_y, right * step_x, bottom * step_y);
+	
+	auto const width = std::size_t(size.width()) + 2;
+	auto const height = std::size_t(size.height()) + 2;
+	std::vector<float> elevation(width * height);
+	auto* const first = elevation.data() + std::size_t(1 - top) * width + std::size_t(1 - left);
+	auto const band = GDALGetRasterBand(dataset, raster.bands.front());
+	CPLErrorReset();
+	auto const result = GDALRasterIO(band, GF_Read,
+	                                 source.x(), source.y(), source.width(), source.height(),
+	                                 first, size.width() + left + right, size.height() + top + bottom,
+	                                 GDT_Float32, sizeof(float), int(width * sizeof(float)));
+	if (result >= CE_Warning)
+	{
+		err = QImageReader::InvalidDataError;
+		error_string = tr("Failed to read image data: %1").arg(QString::fromUtf8(CPLGetLastErrorMsg()));
+		return false;
+	}
+	
+	// Repeat the edge values where there were no neighbouring pixels.
+	for (auto y = std::size_t(1); y + 1 < height; ++y)
+	{
+		auto* row = elevation.data() + y * width;
+		if (!left)
+			row[0] = row[1];
+		if (!right)
+			row[width - 1] = row[width - 2];
+	}
+	if (!top)
+		std::copy(elevation.begin() + std::ptrdiff_t(width), elevation.begin() + std::ptrdiff_t(2 * width), elevation.begin());
+	if (!bottom)
+		std::copy(elevation.end() - std::ptrdiff_t(2 * width), elevation.end() - std::ptrdiff_t(width), elevation.end() - std::ptrdiff_t(width));
+	
+	auto has_nodata = 0;
+	auto const nodata = float(GDALGetRasterNoDataValue(band, &has_nodata));
+	if (has_nodata)
+		std::replace(elevation.begin(), elevation.end(), nodata, std::numeric_limits<float>::quiet_NaN());
+	
+	shadeRelief(*image, elevation.data(),
+	            raster.cell_width * region.width() / size.width(),
+	            raster.cell_height * region.height() / size.height(),
+	            raster.relief);
+	return true;
+}
+
+void GdalImageReader::warpTo(const QByteArray& target_crs)
+{
+	auto const* source_wkt = GDALGetProjectionRef(dataset);
+	if (!source_wkt || !*source_wkt)
+		return;  // Not georeferenced
+	
+	auto source_srs = OSRNewSpatialReference(source_wkt);
+	auto target_srs = OSRNewSpatialReference(nullptr);
+	char* target_wkt = nullptr;
+	if (OSRSetFromUserInput(target_srs, target_crs) == OGRERR_NONE
+	    && !OSRIsSame(source_srs, target_srs)
+	    && OSRExportToWkt(target_srs, &target_wkt) == OGRERR_NONE)
+	{
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(2,2,0)
+		auto* options = GDALCreateWarpOptions();
+		options->nDstAlphaBand = GDALGetRasterCount(dataset) + 1;
+		auto warped = GDALAutoCreateWarpedVRTEx(dataset, source_wkt, target_wkt, GRA_Bilinear, 0.125, options, nullptr);
+		GDALDestroyWarpOptions(options);
+#else
+		auto warped = GDALAutoCreateWarpedVRT(dataset, source_wkt, target_wkt, GRA_Bilinear, 0.125, nullptr);
+#endif
+		if (warped)
+		{
+			source_dataset = dataset;
+			dataset = warped;
+		}
+		else
+		{
+			qDebug("GdalImageReader: Cannot warp %s: %s", qPrintable(path), CPLGetLastErrorMsg());
+		}
+	}
+	CPLFree(target_wkt);
+	OSRDestroySpatialReference(target_srs);
+	OSRDestroySpatialReference(source_srs);
+}
+
 QVector<QRgb> GdalImageReader::readColorTable(int band) const
 {
 	QVector<QRgb> palette;
@@ -334,26 +607,13 @@ void GdalImageReader::noop(QImage& /*image*/)
 // static
 void GdalImageReader::premultiplyARGB32(QImage &image)
 {
-	if (image.depth() != 32)
-		return;
-	
-	auto const first = reinterpret_cast<QRgb*>(image.bits());
-	auto const last = first + image.width() * image.height();
-	std::transform(first, last, first, [](auto qrgb) { return qPremultiply(qrgb); });
+	premultiplyImage<false>(image);
 }
 
 // static
 void GdalImageReader::premultiplyGray8(QImage &image)
 {
-	if (image.depth() != 32)
-		return;
-	
-	auto const first = reinterpret_cast<QRgb*>(image.bits());
-	auto const last = first + image.width() * image.height();
-	std::transform(first, last, first, [](auto qrgb) {
-		auto const gray = qRed(qrgb);
-		return qPremultiply(qRgba(gray, gray, gray, qAlpha(qrgb))); 
-	});
+	premultiplyImage<true>(image);
 }
 
 
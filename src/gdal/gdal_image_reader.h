@@ -26,6 +26,7 @@
 #include <QCoreApplication>
 #include <QImage>
 #include <QImageReader>
+#include <QRect>
 #include <QRgb>
 #include <QSize>
 #include <QString>
@@ -34,6 +35,7 @@
 
 #include <gdal.h>
 
+#include "gdal/gdal_dem.h"
 #include "templates/template_image.h"
 
 namespace OpenOrienteering {
@@ -53,7 +55,15 @@ public:
 	
 	// QImageReader related API
 	
-	explicit GdalImageReader(const QString& path);
+	/**
+	 * Opens the raster at the given path.
+	 * 
+	 * If a target CRS is given, and if the raster is georeferenced in a
+	 * different CRS, the raster is accessed through a warped virtual dataset
+	 * in the target CRS. GDAL's warper then reprojects the data which is
+	 * read, and an alpha band marks the area outside of the source raster.
+	 */
+	explicit GdalImageReader(const QString& path, const QByteArray& target_crs = {});
 	
 	~GdalImageReader();
 	
@@ -89,10 +99,25 @@ public:
 		int pixel_space = 1;   ///< The byte offset from one pixel to the next one.
 		int band_space  = 1;   ///< The in-pixel byte offset from one band value to the next one.
 		int band_offset = 0;   ///< The in-pixel byte offset of the first band value.
+		ReliefShading relief = ReliefShading::None;  ///< The drawing of elevation rasters.
+		double cell_width  = 1;  ///< The georeferenced width of a pixel, for relief shading.
+		double cell_height = 1;  ///< The georeferenced height of a pixel, for relief shading.
 	};
 	
 	RasterInfo readRasterInfo() const;
 	
+	/**
+	 * Reads the given region of the raster into an image of the given size.
+	 * 
+	 * When the size is smaller than the region, GDAL reads from the raster's
+	 * overviews if available, so that only the data needed for this size is
+	 * actually accessed.
+	 * 
+	 * For elevation rasters, the image shows the relief as specified in
+	 * raster.relief, computed at the resolution of the image.
+	 */
+	bool read(QImage* image, const RasterInfo& raster, const QRect& region, const QSize& size);
+	
 	QVector<QRgb> readColorTable(int band) const;
 	
 	/**
@@ -117,12 +142,23 @@ protected:
 	
 	static void premultiplyGray8(QImage& image);
 	
+	/**
+	 * Reads the elevation for the given region, and computes the relief.
+	 */
+	bool readRelief(QImage* image, const RasterInfo& raster, const QRect& region, const QSize& size);
+	
+	/**
+	 * Replaces the dataset with a warped virtual dataset in the target CRS.
+	 */
+	void warpTo(const QByteArray& target_crs);
+	
 	
 private:
 	QString path;
 	QImageReader::ImageReaderError err = QImageReader::UnknownError;
 	QString error_string;
 	GDALDatasetH dataset = nullptr;
+	GDALDatasetH source_dataset = nullptr;  ///< The source of a warped dataset
 	int raster_count = 0;
 	
 };
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016-2020 Kai Pastor
+ *    Copyright 2016-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <iterator>
+#include <mutex>
 // IWYU pragma: no_include <type_traits>
 
 #include <cpl_conv.h>
@@ -33,12 +34,14 @@
 #include <QByteArray>
 #include <QDir>
 #include <QFileInfo>
+#include <QLatin1Char>
 #include <QLatin1String>
 #include <QSettings>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
 
+#include "mapper_config.h" // IWYU pragma: keep
 #include "gdal/gdal_extensions.h"
 #include "util/backports.h"  // IWYU pragma: keep
 
@@ -50,6 +53,7 @@ class GdalManager::GdalManagerPrivate
 public:
 	const QString gdal_manager_group{ QStringLiteral("GdalManager") };
 	const QString gdal_configuration_group{ QStringLiteral("GdalConfiguration") };
+	const QString gdal_driver_cache_group{ QStringLiteral("GdalDriverCache") };
 
 	// Enabled formats
 	const QString gdal_gpx_key{ QStringLiteral("gpx") };
@@ -64,18 +68,22 @@ public:
 	// Import options
 	const QString gdal_import_clip_layers{ QStringLiteral("clip_layers") };
 	
+	// Driver cache
+	const QString driver_cache_version_key{ QStringLiteral("version") };
+	const QString driver_cache_raster_import_key{ QStringLiteral("raster_import") };
+	const QString driver_cache_vector_import_key{ QStringLiteral("vector_import") };
+	const QString driver_cache_vector_export_key{ QStringLiteral("vector_export") };
+	const QString driver_cache_export_drivers_key{ QStringLiteral("export_drivers") };
+	
 	
 	using ExtensionList = std::vector<QByteArray>;
+	using ExportDriverList = std::vector<GdalManager::ExportDriver>;
 	
 	
 	GdalManagerPrivate()
 	: dirty{ true }
 	{
-		GDALAllRegister();
-
-		// Prefer LIBMKL driver to the KML driver if available
-		if (GDALGetDriverByName("LIBKML") != nullptr)
-			GDALDeregisterDriver(GDALGetDriverByName("KML"));
+		// Driver registration is deferred, cf. registerDrivers().
 	}
 	
 	GdalManagerPrivate(const GdalManagerPrivate&) = delete;
@@ -87,6 +95,24 @@ public:
 	{
 		if (dirty)
 			update();
+		registerDrivers();
+	}
+	
+	/**
+	 * Registers all GDAL drivers, once.
+	 * 
+	 * Registering the drivers takes noticeable time, so it is deferred
+	 * until the first GDAL-backed operation.
+	 */
+	void registerDrivers()
+	{
+		std::call_once(drivers_registered, []() {
+			GDALAllRegister();
+			
+			// Prefer LIBMKL driver to the KML driver if available
+			if (GDALGetDriverByName("LIBKML") != nullptr)
+				GDALDeregisterDriver(GDALGetDriverByName("KML"));
+		});
 	}
 	
 	
@@ -214,6 +240,13 @@ public:
 		return enabled_vector_export_extensions;
 	}
 	
+	const ExportDriverList& vectorExportDrivers() const
+	{
+		if (dirty)
+			const_cast<GdalManagerPrivate*>(this)->update();
+		return vector_export_drivers;
+	}
+	
 	QStringList parameterKeys() const
 	{
 		if (dirty)
@@ -274,19 +307,102 @@ private:
 		list.erase(std::remove(begin(list), end(list), extension), end(list));
 	}
 	
-	void updateExtensions(QSettings& settings)
+	static QStringList toStringList(const ExtensionList& list)
 	{
-		static auto const qimagereader_extensions = gdal::qImageReaderExtensions<ExtensionList>();
+		QStringList result;
+		result.reserve(int(list.size()));
+		for (auto const& item : list)
+			result.append(QString::fromLatin1(item));
+		return result;
+	}
+	
+	static ExtensionList toExtensionList(const QStringList& list)
+	{
+		ExtensionList result;
+		result.reserve(std::size_t(list.size()));
+		for (auto const& item : list)
+			result.emplace_back(item.toLatin1());
+		return result;
+	}
+	
+	/**
+	 * Returns the identifier of the current set of drivers.
+	 * 
+	 * The driver cache is valid only for this identifier.
+	 */
+	static QString driverCacheVersion()
+	{
+		return QString::fromUtf8(GDALVersionInfo("RELEASE_NAME"))
+		       + QLatin1Char(' ') + QLatin1String(APP_VERSION)
+		       + QLatin1Char(' ') + QString::fromUtf8(CPLGetConfigOption("GDAL_DRIVER_PATH", ""));
+	}
+	
+	/**
+	 * Reads the driver information from the settings.
+	 * 
+	 * Returns false if there is no valid information for the current version.
+	 */
+	bool readDriverCache(QSettings& settings)
+	{
+		settings.beginGroup(gdal_driver_cache_group);
+		auto const valid = settings.value(driver_cache_version_key).toString() == driverCacheVersion();
+		if (valid)
+		{
+			raster_import_extensions = toExtensionList(settings.value(driver_cache_raster_import_key).toStringList());
+			vector_import_extensions = toExtensionList(settings.value(driver_cache_vector_import_key).toStringList());
+			vector_export_extensions = toExtensionList(settings.value(driver_cache_vector_export_key).toStringList());
+			
+			// Triples of short name, long name, and extensions
+			auto const export_drivers = settings.value(driver_cache_export_drivers_key).toStringList();
+			vector_export_drivers.clear();
+			vector_export_drivers.reserve(std::size_t(export_drivers.size() / 3));
+			for (auto i = 0; i + 2 < export_drivers.size(); i += 3)
+			{
+				vector_export_drivers.push_back({ export_drivers[i].toLatin1(),
+				                                  export_drivers[i+1].toUtf8(),
+				                                  export_drivers[i+2].toLatin1() });
+			}
+		}
+		settings.endGroup();
+		return valid;
+	}
+	
+	void writeDriverCache(QSettings& settings) const
+	{
+		QStringList export_drivers;
+		export_drivers.reserve(int(vector_export_drivers.size() * 3));
+		for (auto const& driver : vector_export_drivers)
+		{
+			export_drivers << QString::fromLatin1(driver.name)
+			               << QString::fromUtf8(driver.long_name)
+			               << QString::fromLatin1(driver.extensions);
+		}
+		
+		settings.beginGroup(gdal_driver_cache_group);
+		settings.setValue(driver_cache_version_key, driverCacheVersion());
+		settings.setValue(driver_cache_raster_import_key, toStringList(raster_import_extensions));
+		settings.setValue(driver_cache_vector_import_key, toStringList(vector_import_extensions));
+		settings.setValue(driver_cache_vector_export_key, toStringList(vector_export_extensions));
+		settings.setValue(driver_cache_export_drivers_key, export_drivers);
+		settings.endGroup();
+	}
+	
+	/**
+	 * Collects the driver information from the registered drivers.
+	 */
+	void scanDrivers()
+	{
+		registerDrivers();
 		
 		auto count = GDALGetDriverCount();
-		enabled_raster_import_extensions.clear();
-		enabled_raster_import_extensions.reserve(std::size_t(count));
-		enabled_vector_import_extensions.clear();
-		enabled_vector_import_extensions.reserve(std::size_t(count));
-		enabled_vector_export_extensions.clear();
-		enabled_vector_export_extensions.reserve(std::size_t(count));
+		raster_import_extensions.clear();
+		raster_import_extensions.reserve(std::size_t(count));
+		vector_import_extensions.clear();
+		vector_import_extensions.reserve(std::size_t(count));
+		vector_export_extensions.clear();
+		vector_export_extensions.reserve(std::size_t(count));
+		vector_export_drivers.clear();
 		
-		// Register extensions, either directly (enabled_*), or staged for ambiguity check (secondary_*)
 		for (auto i = 0; i < count; ++i)
 		{
 			auto driver_data = GDALGetDriver(i);
@@ -300,18 +416,43 @@ private:
 			if (qstrcmp(cap_raster, "YES") == 0)
 			{
 				if (qstrcmp(cap_open, "YES") == 0)
-					copyExtensions(extensions, enabled_raster_import_extensions);
+					copyExtensions(extensions, raster_import_extensions);
 			}
 
 			if (qstrcmp(cap_vector, "YES") == 0)
 			{
 				if (qstrcmp(cap_open, "YES") == 0)
-					copyExtensions(extensions, enabled_vector_import_extensions);
+					copyExtensions(extensions, vector_import_extensions);
 				
 				if (qstrcmp(cap_create, "YES") == 0)
-					copyExtensions(extensions, enabled_vector_export_extensions);
+				{
+					copyExtensions(extensions, vector_export_extensions);
+					if (!extensions.isEmpty())
+						vector_export_drivers.push_back({ GDALGetDriverShortName(driver_data),
+						                                  GDALGetDriverLongName(driver_data),
+						                                  QByteArray(extensions.constData(), extensions.size()) });
+				}
 			}
 		}
+	}
+	
+	void updateExtensions(QSettings& settings)
+	{
+		static auto const qimagereader_extensions = gdal::qImageReaderExtensions<ExtensionList>();
+		
+		if (!drivers_scanned)
+		{
+			if (!readDriverCache(settings))
+			{
+				scanDrivers();
+				writeDriverCache(settings);
+			}
+			drivers_scanned = true;
+		}
+		
+		enabled_raster_import_extensions = raster_import_extensions;
+		enabled_vector_import_extensions = vector_import_extensions;
+		enabled_vector_export_extensions = vector_export_extensions;
 		
 		// Handle GDAL activation settings, before checking ambiguity
 		settings.beginGroup(gdal_manager_group);
@@ -407,6 +548,16 @@ private:
 	
 	mutable bool dirty;
 	
+	bool drivers_scanned = false;
+	
+	std::once_flag drivers_registered;
+	
+	/// Driver information, cf. readDriverCache() and scanDrivers()
+	ExtensionList raster_import_extensions;
+	ExtensionList vector_import_extensions;
+	ExtensionList vector_export_extensions;
+	ExportDriverList vector_export_drivers;
+	
 	mutable ExtensionList enabled_raster_import_extensions;
 
 	mutable ExtensionList enabled_vector_import_extensions;
@@ -432,6 +583,11 @@ void GdalManager::configure()
 	p->configure();
 }
 
+void GdalManager::registerDrivers()
+{
+	p->registerDrivers();
+}
+
 
 bool GdalManager::isAreaHatchingEnabled() const
 {
@@ -499,9 +655,32 @@ const std::vector<QByteArray>& GdalManager::supportedVectorExportExtensions() co
 	return p->supportedVectorExportExtensions();
 }
 
+const std::vector<GdalManager::ExportDriver>& GdalManager::vectorExportDrivers() const
+{
+	return p->vectorExportDrivers();
+}
+
+bool GdalManager::hasSupportedExtension(const QString& path) const
+{
+	auto const suffix = QFileInfo(path).suffix().toLower().toLatin1();
+	if (suffix.isEmpty())
+		return true;
+	
+	// Raster extensions may be prefixed, cf. prefixDuplicates().
+	QByteArray const dotted_suffix = '.' + suffix;
+	auto const matches = [&suffix, &dotted_suffix](const QByteArray& extension) {
+		return extension == suffix || extension.endsWith(dotted_suffix);
+	};
+	auto const& raster = supportedRasterExtensions();
+	auto const& vector = supportedVectorImportExtensions();
+	return std::any_of(begin(raster), end(raster), matches)
+	       || std::any_of(begin(vector), end(vector), matches);
+}
+
 
 bool GdalManager::isDriverEnabled(const char* driver_name)
 {
+	GdalManager().registerDrivers();
 	auto driver = GDALGetDriverByName(driver_name);
 	return bool(driver);
 }
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016-2020 Kai Pastor
+ *    Copyright 2016-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -23,7 +23,8 @@
 
 #include <vector>
 
-class QByteArray;
+#include <QByteArray>
+
 class QString;
 class QStringList;
 
@@ -36,6 +37,10 @@ namespace OpenOrienteering {
  * This class provides lists of extensions supported via GDAL in Mapper.
  * It sets and updates GDAL configuration parameters from Mapper's settings.
  * 
+ * The GDAL drivers are registered only when needed, cf. registerDrivers().
+ * The lists of extensions are kept in the settings for the current versions
+ * of GDAL and Mapper, so that they are available without driver registration.
+ * 
  * There is no need to keep objects of this class for an extended life time:
  * instantiation is cheap; the actual state is shared and retained.
  */
@@ -62,16 +67,36 @@ public:
 		OneLayerPerSymbol
 	};
 	
+	/**
+	 * The properties of a GDAL vector export driver.
+	 */
+	struct ExportDriver
+	{
+		QByteArray name;        ///< The short name of the driver
+		QByteArray long_name;   ///< The long name of the driver
+		QByteArray extensions;  ///< The space-separated file name extensions
+	};
+	
 	/**
 	 * Constructs a new manager object.
 	 */
 	GdalManager();
 	
 	/**
-	 * Sets the GDAL configuration from Mapper's defaults and settings.
+	 * Sets the GDAL configuration from Mapper's defaults and settings,
+	 * and registers the GDAL drivers.
 	 */
 	void configure();
 	
+	/**
+	 * Registers the GDAL drivers, unless this was already done.
+	 * 
+	 * Driver registration is deferred until the first GDAL-backed operation.
+	 * This function must be called before opening or creating datasets, or
+	 * looking up drivers.
+	 */
+	void registerDrivers();
+	
 	
 	/**
 	 * Returns the area hatching display setting.
@@ -143,6 +168,19 @@ public:
 	 */
 	const std::vector<QByteArray>& supportedVectorExportExtensions() const;
 	
+	/**
+	 * Returns the vector export drivers which have file name extensions.
+	 */
+	const std::vector<ExportDriver>& vectorExportDrivers() const;
+	
+	/**
+	 * Returns true if the path has no file name extension, or an extension
+	 * of a supported raster or vector import format.
+	 * 
+	 * Paths for which this function returns false need not be probed.
+	 */
+	bool hasSupportedExtension(const QString& path) const;
+	
 	
 	/**
 	 * Tests if a particular driver is available.
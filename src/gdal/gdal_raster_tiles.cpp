@@ -0,0 +1,323 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gdal_raster_tiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include <Qt>
+#include <QDir>
+#include <QIODevice>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPoint>
+#include <QRectF>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+
+#include "gdal/gdal_image_reader.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * The maximum number of tiles in memory.
+ * 
+ * A tile with 32 bits per pixel takes 1 MiB.
+ */
+#ifdef Q_OS_ANDROID
+constexpr int max_tiles = 48;
+#else
+constexpr int max_tiles = 256;
+#endif
+
+}  // namespace
+
+
+
+// ### GdalRasterTiles::Reader ###
+
+/**
+ * A GDAL dataset handle for loading tiles, with the raster's properties.
+ * 
+ * GDAL dataset handles must not be used concurrently, so each worker takes
+ * a reader from the pool while loading a tile.
+ */
+struct GdalRasterTiles::Reader
+{
+	Reader(const QString& path, ReliefShading shading, const QByteArray& target_crs)
+	: reader(path, target_crs)
+	, raster(reader.readRasterInfo())
+	{
+		if (raster.relief != ReliefShading::None)
+			raster.relief = shading;
+	}
+	
+	GdalImageReader reader;
+	GdalImageReader::RasterInfo raster;
+};
+
+
+
+// ### GdalRasterTiles::LoadJob ###
+
+/**
+ * Loads a single tile on a worker thread.
+ */
+class GdalRasterTiles::LoadJob : public QRunnable
+{
+public:
+	LoadJob(GdalRasterTiles& tiles, quint64 key, const QRect& rect, int level)
+	: tiles(tiles)
+	, key(key)
+	, rect(rect)
+	, level(level)
+	{}
+	
+	void run() override
+	{
+		tiles.deliver({ tiles.load(rect, level), rect, key });
+	}
+
+private:
+	GdalRasterTiles& tiles;
+	quint64 key;
+	QRect rect;
+	int level;
+};
+
+
+
+// ### GdalRasterTiles ###
+
+GdalRasterTiles::GdalRasterTiles(const QString& path, const QSize& raster_size, ReliefShading shading,
+                                 const QByteArray& target_crs, QObject* parent)
+: QObject(parent)
+, path(path)
+, raster_size(raster_size)
+, shading(shading)
+, target_crs(target_crs)
+{
+	while ((std::max(raster_size.width(), raster_size.height()) >> max_level) > tile_size)
+		++max_level;
+	workers.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+GdalRasterTiles::~GdalRasterTiles()
+{
+	// Workers deliver to this object.
+	workers.clear();
+	workers.waitForDone();
+}
+
+
+int GdalRasterTiles::levelForScale(qreal scale) const
+{
+	if (scale <= 0 || scale >= 0.5)
+		return 0;
+	return std::min(int(std::floor(std::log2(1 / scale))), max_level);
+}
+
+qint64 GdalRasterTiles::memoryUsage() const
+{
+	auto usage = qint64(0);
+	for (auto const& tile : tiles)
+	{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		usage += qint64(tile.image.sizeInBytes());
+#else
+		usage += qint64(tile.image.byteCount());
+#endif
+	}
+	return usage;
+}
+
+void GdalRasterTiles::setCacheDirectory(const QString& directory)
+{
+	Q_ASSERT(tiles.isEmpty());
+	if (QDir().mkpath(directory))
+		cache_directory = directory;
+}
+
+void GdalRasterTiles::draw(QPainter* painter, const QRect& region, int level, const QImage& fallback, bool asynchronous)
+{
+	auto const area = region.intersected(QRect(QPoint(), raster_size));
+	if (area.isEmpty())
+		return;
+	
+	++use_counter;
+	level = qBound(0, level, max_level);
+	auto const span = tile_size << level;
+	auto const fx = qreal(fallback.width()) / raster_size.width();
+	auto const fy = qreal(fallback.height()) / raster_size.height();
+	for (int row = area.top() / span; row <= area.bottom() / span; ++row)
+	{
+		for (int column = area.left() / span; column <= area.right() / span; ++column)
+		{
+			auto const key = keyOf(level, column, row);
+			auto const rect = tileRect(level, column, row);
+			auto& tile = tiles[key];
+			tile.last_used = use_counter;
+			if (!tile.loaded && !asynchronous)
+			{
+				tile.image = load(rect, level);
+				tile.loaded = true;
+			}
+			else if (!tile.loaded && !tile.pending)
+			{
+				tile.pending = true;
+				workers.start(new LoadJob(*this, key, rect, level));
+			}
+			
+			if (!tile.image.isNull())
+				painter->drawImage(QRectF(rect), tile.image);
+			else if (!fallback.isNull())
+				painter->drawImage(QRectF(rect), fallback, QRectF(rect.x() * fx, rect.y() * fy, rect.width() * fx, rect.height() * fy));
+		}
+	}
+	
+	trim();
+}
+
+
+void GdalRasterTiles::collectLoadedTiles()
+{
+	std::vector<LoadedTile> results;
+	{
+		QMutexLocker lock(&mutex);
+		results.swap(loaded);
+	}
+	
+	QRect changed;
+	for (auto& result : results)
+	{
+		auto tile = tiles.find(result.key);
+		if (tile == tiles.end())
+			continue;
+		
+		tile->pending = false;
+		if (!tile->loaded)
+		{
+			tile->image = std::move(result.image);
+			tile->loaded = true;
+			changed |= result.rect;
+		}
+	}
+	
+	trim();
+	if (changed.isValid())
+		emit tilesReady(changed);
+}
+
+
+quint64 GdalRasterTiles::keyOf(int level, int column, int row)
+{
+	return (quint64(level) << 56) | (quint64(quint32(column)) << 28) | quint32(row);
+}
+
+QRect GdalRasterTiles::tileRect(int level, int column, int row) const
+{
+	auto const span = tile_size << level;
+	return QRect(column * span, row * span, span, span).intersected(QRect(QPoint(), raster_size));
+}
+
+QImage GdalRasterTiles::load(const QRect& rect, int level)
+{
+	QString cache_file;
+	if (!cache_directory.isEmpty())
+	{
+		cache_file = cache_directory + QStringLiteral("/%1-%2-%3.png").arg(level).arg(rect.x()).arg(rect.y());
+		QImage cached(cache_file);
+		if (!cached.isNull())
+			return cached;
+	}
+	
+	std::unique_ptr<Reader> reader;
+	{
+		QMutexLocker lock(&mutex);
+		if (!readers.empty())
+		{
+			reader = std::move(readers.back());
+			readers.pop_back();
+		}
+	}
+	if (!reader)
+		reader = std::make_unique<Reader>(path, shading, target_crs);
+	
+	auto const size = QSize(std::max(1, (rect.width() + (1 << level) - 1) >> level),
+	                        std::max(1, (rect.height() + (1 << level) - 1) >> level));
+	QImage image;
+	if (!reader->reader.read(&image, reader->raster, rect, size))
+	{
+		qDebug("GdalRasterTiles: %s", qPrintable(reader->reader.errorString()));
+		image = {};
+	}
+	
+	{
+		QMutexLocker lock(&mutex);
+		readers.push_back(std::move(reader));
+	}
+	
+	if (!cache_file.isEmpty() && !image.isNull())
+	{
+		QSaveFile file(cache_file);
+		if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "PNG") || !file.commit())
+			qDebug("GdalRasterTiles: Cannot store %s", qPrintable(cache_file));
+	}
+	return image;
+}
+
+void GdalRasterTiles::trim()
+{
+	if (tiles.size() <= max_tiles)
+		return;
+	
+	// Tiles which are pending or which were used in the last draw are kept.
+	std::vector<std::pair<quint64, quint64>> candidates;
+	candidates.reserve(std::size_t(tiles.size()));
+	for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		if (!tile->pending && tile->last_used != use_counter)
+			candidates.emplace_back(tile->last_used, tile.key());
+	}
+	auto const count = std::min(candidates.size(), std::size_t(tiles.size() - max_tiles));
+	std::partial_sort(candidates.begin(), candidates.begin() + std::ptrdiff_t(count), candidates.end());
+	for (std::size_t i = 0; i < count; ++i)
+		tiles.remove(candidates[i].second);
+}
+
+void GdalRasterTiles::deliver(LoadedTile&& tile)
+{
+	QMutexLocker lock(&mutex);
+	auto const first = loaded.empty();
+	loaded.push_back(std::move(tile));
+	if (first)
+		QMetaObject::invokeMethod(this, "collectLoadedTiles", Qt::QueuedConnection);
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,193 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_GDAL_RASTER_TILES_H
+#define OPENORIENTEERING_GDAL_RASTER_TILES_H
+
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include "gdal/gdal_dem.h"
+
+class QPainter;
+
+namespace OpenOrienteering {
+
+
+/**
+ * On-demand access to a large raster file, in tiles.
+ * 
+ * The tiles form a grid for each level, where level 0 has the full resolution
+ * of the raster, and each following level halves the resolution. The data for
+ * a tile is read via GDAL RasterIO, which takes it from the raster's overviews
+ * where available. So only the visible parts of the raster are held in memory,
+ * at the resolution which is needed for drawing.
+ * 
+ * Missing tiles can be loaded on a pool of worker threads. Each worker uses
+ * its own GDAL dataset handle. The number of tiles in memory is bounded; the
+ * least recently used tiles are dropped first.
+ * 
+ * The cache itself is not thread-safe. It must be used from the thread which
+ * owns the object.
+ */
+class GdalRasterTiles : public QObject
+{
+	Q_OBJECT
+
+public:
+	/** The width and height of a tile, in pixels of its level. */
+	static constexpr int tile_size = 512;
+	
+	/**
+	 * Constructs an empty cache for the raster in the given file.
+	 * 
+	 * For elevation rasters, the tiles show the given kind of relief.
+	 * If a target CRS is given, the raster is warped to this CRS, cf.
+	 * GdalImageReader.
+	 */
+	GdalRasterTiles(const QString& path, const QSize& raster_size, ReliefShading shading = ReliefShading::Hillshade,
+	                const QByteArray& target_crs = {}, QObject* parent = nullptr);
+	
+	GdalRasterTiles(const GdalRasterTiles&) = delete;
+	GdalRasterTiles& operator=(const GdalRasterTiles&) = delete;
+	
+	/** Waits for all workers to finish. */
+	~GdalRasterTiles() override;
+	
+	
+	/** Returns the size of the raster, in full resolution pixels. */
+	const QSize& rasterSize() const { return raster_size; }
+	
+	/**
+	 * Returns the lowest resolution level which still provides at least one
+	 * raster pixel per device pixel.
+	 * 
+	 * @param scale  The number of device pixels per full resolution pixel.
+	 */
+	int levelForScale(qreal scale) const;
+	
+	/** Returns the size of the tiles in memory, in bytes. */
+	qint64 memoryUsage() const;
+	
+	/**
+	 * Enables a persistent cache of the tiles in the given directory.
+	 * 
+	 * Loaded tiles are stored as PNG files, and later loads take them from
+	 * there. This is meant for rasters where reading a tile is expensive,
+	 * such as warped rasters. It must be set before drawing.
+	 */
+	void setCacheDirectory(const QString& directory);
+	
+	/**
+	 * Draws the given region of the raster from the tiles of the given level.
+	 * 
+	 * The painter must be set up for drawing in full resolution pixels.
+	 * Missing tiles are either loaded immediately, or enqueued for loading by
+	 * worker threads. Until such a tile is ready, the corresponding part of
+	 * the fallback image, an overview of the whole raster, is drawn instead.
+	 * 
+	 * @param region        The area of interest, in full resolution pixels.
+	 * @param level         The level of the tiles.
+	 * @param fallback      The image to be drawn for missing tiles.
+	 * @param asynchronous  If true, missing tiles are loaded by worker threads.
+	 */
+	void draw(QPainter* painter, const QRect& region, int level, const QImage& fallback, bool asynchronous);
+
+
+signals:
+	/**
+	 * Indicates that tiles in the given area were loaded by a worker.
+	 * 
+	 * @param region  The area which changed, in full resolution pixels.
+	 */
+	void tilesReady(const QRect& region);
+
+
+private slots:
+	/** Moves the images loaded by the workers into the cache. */
+	void collectLoadedTiles();
+
+private:
+	class LoadJob;
+	struct Reader;
+	
+	struct Tile
+	{
+		QImage image;
+		quint64 last_used = 0;  ///< The value of use_counter when the tile was last drawn.
+		bool loaded = false;    ///< Set when the image is final, even if null after an error.
+		bool pending = false;   ///< Set while a worker loads this tile.
+	};
+	
+	struct LoadedTile
+	{
+		QImage image;
+		QRect rect;
+		quint64 key;
+	};
+	
+	static quint64 keyOf(int level, int column, int row);
+	
+	/** Returns the area of a tile, in full resolution pixels. */
+	QRect tileRect(int level, int column, int row) const;
+	
+	/**
+	 * Reads the given area into an image with the resolution of the level.
+	 * 
+	 * This function may be called concurrently.
+	 */
+	QImage load(const QRect& rect, int level);
+	
+	/** Drops the least recently used tiles when there are too many. */
+	void trim();
+	
+	/** Receives a loaded tile from a worker thread. */
+	void deliver(LoadedTile&& tile);
+	
+	
+	QString path;
+	QSize raster_size;
+	ReliefShading shading;
+	QByteArray target_crs;
+	QString cache_directory;
+	int max_level = 0;
+	QHash<quint64, Tile> tiles;
+	quint64 use_counter = 0;
+	
+	QThreadPool workers;
+	QMutex mutex;  ///< Protects readers and loaded.
+	std::vector<std::unique_ptr<Reader>> readers;
+	std::vector<LoadedTile> loaded;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_GDAL_RASTER_TILES_H
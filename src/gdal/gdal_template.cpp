@@ -1,5 +1,5 @@
 /*
- *    Copyright 2019, 2020 Kai Pastor
+ *    Copyright 2019, 2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -20,34 +20,80 @@
 #include "gdal_template.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include <Qt>
 #include <QtGlobal>
 #include <QByteArray>
 #include <QChar>
+#include <QCryptographicHash>
+#include <QImage>
 #include <QImageReader>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QPainter>
+#include <QPoint>
 #include <QPointF>
+#include <QPolygonF>
 #include <QRectF>
 #include <QString>
+#include <QTransform>
 #include <QVariant>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map.h"
 #include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "gdal/gdal_extraction_cache.h"
 #include "gdal/gdal_file.h"
 #include "gdal/gdal_image_reader.h"
 #include "gdal/gdal_manager.h"
+#include "gdal/gdal_raster_tiles.h"
+#include "util/disk_cache.h"
+#include "util/parallel.h"
 #include "util/transformation.h"
 #include "util/util.h"
 
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Rasters with more pixels are not loaded completely, but read in tiles.
+ */
+#ifdef Q_OS_ANDROID
+constexpr qint64 max_loaded_pixels = 4096 * 4096;
+#else
+constexpr qint64 max_loaded_pixels = 10000 * 10000;
+#endif
+
+/**
+ * The maximum width and height of the overview image of tiled rasters.
+ */
+constexpr int overview_size = 2048;
+
+}  // namespace
+
+
+
 // static
 bool GdalTemplate::canRead(const QString& path)
 {
+	if (!GdalManager().hasSupportedExtension(path))
+		return false;
 	return GdalImageReader(path).canRead();
 }
 
@@ -70,7 +116,16 @@ GdalTemplate::GdalTemplate(const QString& path, Map* map)
 : TemplateImage(path, map)
 {}
 
-GdalTemplate::GdalTemplate(const GdalTemplate& proto) = default;
+GdalTemplate::GdalTemplate(const GdalTemplate& proto)
+: TemplateImage(proto)
+, raster_size(proto.raster_size)
+, relief_shading(proto.relief_shading)
+, elevation_model(proto.elevation_model)
+, reproject(proto.reproject)
+{
+	if (proto.tiles)
+		createTiles();
+}
 
 GdalTemplate::~GdalTemplate() = default;
 
@@ -113,35 +168,223 @@ bool GdalTemplate::fileExists() const
 }
 
 
-bool GdalTemplate::loadTemplateFileImpl()
+void GdalTemplate::drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const
 {
-	GdalImageReader reader(template_path);
-	if (!reader.canRead())
+	if (!tiles)
 	{
-		setErrorString(reader.errorString());
-		return false;
+		TemplateImage::drawTemplate(painter, clip_rect, scale, on_screen, opacity);
+		return;
 	}
 	
-	qDebug("GdalTemplate: Using GDAL driver '%s'", reader.format().constData());
+	// The clip rect is in map coordinates.
+	auto const offset = QPointF(raster_size.width() * 0.5, raster_size.height() * 0.5);
+	QPolygonF corners;
+	for (auto const& corner : { clip_rect.topLeft(), clip_rect.topRight(), clip_rect.bottomRight(), clip_rect.bottomLeft() })
+		corners.append(mapToTemplate(MapCoordF(corner)) + offset);
+	auto const visible = corners.boundingRect().toAlignedRect().adjusted(-1, -1, 1, 1);
+	
+	applyTemplateTransform(painter);
+	painter->translate(-offset);
 	
-	if (!reader.read(&image))
+	// Use the lowest resolution level which still provides at least one
+	// raster pixel per device pixel. Missing tiles are loaded in the
+	// background only when drawing on screen.
+	auto const device_scale = std::sqrt(std::abs(painter->combinedTransform().determinant()));
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->setOpacity(opacity);
+	tiles->draw(painter, visible, tiles->levelForScale(device_scale), image, on_screen);
+	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+}
+
+void GdalTemplate::setReliefShading(ReliefShading shading)
+{
+	if (shading == relief_shading)
+		return;
+	
+	relief_shading = shading;
+	map->setTemplatesDirty();
+	if (elevation_model && getTemplateState() == Loaded)
 	{
-		setErrorString(reader.errorString());
-		
-		QImageReader image_reader(template_path);
-		if (image_reader.canRead())
+		unloadTemplateFile();
+		loadTemplateFile();
+	}
+}
+
+void GdalTemplate::setReprojected(bool value)
+{
+	if (value == reproject)
+		return;
+	
+	reproject = value;
+	map->setTemplatesDirty();
+	
+	// Let the effective georeferencing be selected again.
+	available_georef.effective = {};
+	if (getTemplateState() == Loaded)
+	{
+		unloadTemplateFile();
+		loadTemplateFile();
+	}
+}
+
+QByteArray GdalTemplate::targetCrs() const
+{
+	if (!reproject || !is_georeferenced)
+		return {};
+	return map->getGeoreferencing().getProjectedCRSSpec().toUtf8();
+}
+
+// static
+QString GdalTemplate::tileCacheRoot()
+{
+	return DiskCache::directory(DiskCache::RasterTiles);
+}
+
+QString GdalTemplate::tileCacheDirectory() const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(GdalExtractionCache::fileKey(template_path.toUtf8()));
+	hash.addData(targetCrs());
+	hash.addData(QByteArray::number(int(relief_shading)));
+	return tileCacheRoot() + QLatin1Char('/') + QString::fromLatin1(hash.result().toHex());
+}
+
+std::vector<PathObject*> GdalTemplate::generateContours(double interval, const Symbol* symbol, const std::function<bool (int)>& progress) const
+{
+	struct Contour
+	{
+		double level;
+		std::vector<QPointF> points;
+	};
+	std::vector<Contour> contours;
+	auto const sink = [&contours](double level, std::vector<QPointF>&& points) {
+		if (points.size() >= 2)
+			contours.push_back({ level, std::move(points) });
+	};
+	auto const source_path = QString::fromUtf8(GdalExtractionCache::localPath(template_path.toUtf8()));
+	if (!traceContours(source_path, interval, 0, sink, progress))
+		return {};
+	
+	// Template coordinates have their origin at the center of the raster.
+	auto const size = imageSize();
+	auto const offset = QPointF(size.width() * 0.5, size.height() * 0.5);
+	std::vector<PathObject*> objects(contours.size(), nullptr);
+	Util::parallelFor(contours.size(), 64, [&](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
 		{
-			qDebug("GdalTemplate: Falling back to QImageReader, reason: %s", qPrintable(errorString()));
-			if (!image_reader.read(&image))
+			auto const& points = contours[i].points;
+			auto const closed = points.front() == points.back();
+			MapCoordVector coords;
+			coords.reserve(points.size());
+			try
+			{
+				for (auto const& point : points)
+					coords.emplace_back(templateToMap(point - offset));
+			}
+			catch (const std::range_error&)
 			{
-				setErrorString(errorString() + QChar::LineFeed + image_reader.errorString());
-				return false;
+				continue;  // Outside of the map's coordinate range
 			}
+			
+			auto* object = new PathObject(symbol, std::move(coords));
+			if (closed)
+				object->closeAllParts();  // Uses the existing close point
+			objects[i] = object;
 		}
+	});
+	
+	std::vector<PathObject*> result;
+	result.reserve(objects.size());
+	for (std::size_t i = 0; i < objects.size(); ++i)
+	{
+		if (!objects[i])
+			continue;
+		objects[i]->setTag(QStringLiteral("ele"), QString::number(contours[i].level));
+		result.push_back(objects[i]);
+	}
+	return result;
+}
+
+
+void GdalTemplate::saveTypeSpecificTemplateConfiguration(QXmlStreamWriter& xml) const
+{
+	TemplateImage::saveTypeSpecificTemplateConfiguration(xml);
+	if (relief_shading == ReliefShading::Slope)
+	{
+		xml.writeStartElement(QString::fromLatin1("relief"));
+		xml.writeAttribute(QString::fromLatin1("shading"), QString::fromLatin1("slope"));
+		xml.writeEndElement(/*relief*/);
+	}
+	if (reproject)
+	{
+		xml.writeStartElement(QString::fromLatin1("reprojection"));
+		xml.writeAttribute(QString::fromLatin1("crs"), QString::fromLatin1("map"));
+		xml.writeEndElement(/*reprojection*/);
+	}
+}
+
+bool GdalTemplate::loadTypeSpecificTemplateConfiguration(QXmlStreamReader& xml)
+{
+	if (xml.name() == QLatin1String("relief"))
+	{
+		if (xml.attributes().value(QLatin1String("shading")) == QLatin1String("slope"))
+			relief_shading = ReliefShading::Slope;
+		xml.skipCurrentElement();
+		return true;
+	}
+	if (xml.name() == QLatin1String("reprojection"))
+	{
+		reproject = xml.attributes().value(QLatin1String("crs")) == QLatin1String("map");
+		xml.skipCurrentElement();
+		return true;
+	}
+	return TemplateImage::loadTypeSpecificTemplateConfiguration(xml);
+}
+
+
+QSize GdalTemplate::imageSize() const
+{
+	return tiles ? raster_size : TemplateImage::imageSize();
+}
+
+qint64 GdalTemplate::memoryUsage() const
+{
+	auto usage = TemplateImage::memoryUsage();
+	if (tiles)
+		usage += tiles->memoryUsage();
+	return usage;
+}
+
+
+bool GdalTemplate::loadTemplateFileImpl()
+{
+	auto data = takeImageData();
+	if (!data)
+	{
+		data = std::make_shared<ImageData>();
+		data->path = template_path;
+		readRasterData(*data, relief_shading, targetCrs());
+	}
+	discardPreview();
+	setErrorString(data->error);
+	if (data->image.isNull())
+		return false;
+	
+	image = std::move(data->image);
+	elevation_model = data->elevation;
+	if (data->size.isValid())
+	{
+		raster_size = data->size;
+		createTiles();
 	}
 	
 	// Duplicated from TemplateImage, for compatibility
-	available_georef = findAvailableGeoreferencing(reader.readGeoTransform());
+	available_georef = findAvailableGeoreferencing(data->georeferencing);
+	if (reproject && !data->georeferencing.crs_spec.isEmpty() && !data->georeferencing.transform.source.isEmpty())
+	{
+		// The warped raster's own georeferencing, overriding world files
+		available_georef.effective = data->georeferencing;
+	}
 	if (is_georeferenced)
 	{
 		if (!isGeoreferencingUsable())
@@ -162,6 +405,88 @@ bool GdalTemplate::loadTemplateFileImpl()
 	return true;
 }
 
+std::function<void ()> GdalTemplate::makeFileReader()
+{
+	auto data = std::make_shared<ImageData>();
+	data->path = template_path;
+	image_data = data;
+	return [data, shading = relief_shading, target_crs = targetCrs(), preview_ready = makePreviewHandler()]() {
+		readRasterData(*data, shading, target_crs, preview_ready);
+	};
+}
+
+// static
+void GdalTemplate::readRasterData(ImageData& data, ReliefShading shading, const QByteArray& target_crs,
+                                  const std::function<void ()>& preview_ready)
+{
+	// Archive members are read from an extracted copy when available.
+	auto const source_path = QString::fromUtf8(GdalExtractionCache::localPath(data.path.toUtf8()));
+	GdalImageReader reader(source_path, target_crs);
+	if (!reader.canRead())
+	{
+		data.error = reader.errorString();
+		return;
+	}
+	
+	qDebug("GdalTemplate: Using GDAL driver '%s'", reader.format().constData());
+	
+	auto raster = reader.readRasterInfo();
+	data.elevation = raster.relief != ReliefShading::None;
+	if (data.elevation)
+		raster.relief = shading;
+	if (raster.image_format != QImage::Format_Invalid
+	    && qint64(raster.size.width()) * raster.size.height() > max_loaded_pixels)
+	{
+		// Keep only an overview in memory, and read the details on demand.
+		auto const size = raster.size.scaled(overview_size, overview_size, Qt::KeepAspectRatio).expandedTo({1, 1});
+		if (!reader.read(&data.image, raster, { QPoint(), raster.size }, size))
+		{
+			data.error = reader.errorString();
+			data.image = {};
+			return;
+		}
+		data.size = raster.size;
+	}
+	else if (preview_ready && raster.image_format != QImage::Format_Invalid
+	         && (raster.size.width() > overview_size || raster.size.height() > overview_size)
+	         && reader.read(&data.preview, raster, { QPoint(), raster.size },
+	                        raster.size.scaled(overview_size, overview_size, Qt::KeepAspectRatio).expandedTo({1, 1})))
+	{
+		// GDAL uses the overviews of the raster if available.
+		data.preview_size = raster.size;
+		preview_ready();
+	}
+	
+	if (!data.size.isValid()
+	    && !reader.read(&data.image, raster, { QPoint(), raster.size }, raster.size))
+	{
+		data.error = reader.errorString();
+		data.image = {};
+		
+		QImageReader image_reader(source_path);
+		if (image_reader.canRead())
+		{
+			qDebug("GdalTemplate: Falling back to QImageReader, reason: %s", qPrintable(data.error));
+			if (!image_reader.read(&data.image))
+			{
+				data.error += QChar::LineFeed + image_reader.errorString();
+				data.image = {};
+				return;
+			}
+		}
+	}
+	
+	data.georeferencing = reader.readGeoTransform();
+}
+
+void GdalTemplate::unloadTemplateFileImpl()
+{
+	tiles.reset();
+	raster_size = {};
+	elevation_model = false;
+	TemplateImage::unloadTemplateFileImpl();
+}
+
 bool GdalTemplate::applyCornerPassPoints()
 {
 	if (passpoints.empty())
@@ -215,4 +540,33 @@ bool GdalTemplate::applyCornerPassPoints()
 }
 
 
+void GdalTemplate::createTiles()
+{
+	auto const target_crs = targetCrs();
+	auto const path_utf8 = template_path.toUtf8();
+	auto const source_path = QString::fromUtf8(GdalExtractionCache::localPath(path_utf8));
+	tiles = std::make_unique<GdalRasterTiles>(source_path, raster_size, relief_shading, target_crs);
+	// Warping and decompressing archive members are too slow to be
+	// repeated in each session.
+	if (!target_crs.isEmpty() || GdalExtractionCache::isArchiveMember(path_utf8))
+	{
+		auto const cache_directory = tileCacheDirectory();
+		tiles->setCacheDirectory(cache_directory);
+		DiskCache::touch(DiskCache::RasterTiles, cache_directory);
+		DiskCache::scheduleTrim(DiskCache::RasterTiles);
+	}
+	connect(tiles.get(), &GdalRasterTiles::tilesReady, this, &GdalTemplate::setRegionDirty);
+}
+
+void GdalTemplate::setRegionDirty(const QRect& region)
+{
+	auto const offset = QPointF(raster_size.width() * 0.5, raster_size.height() * 0.5);
+	auto const rect = QRectF(region).translated(-offset);
+	QRectF map_bbox;
+	for (auto const& corner : { rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft() })
+		rectIncludeSafe(map_bbox, templateToMap(corner));
+	map->setTemplateAreaDirty(this, map_bbox, 0);
+}
+
+
 }  // namespace OpenOrienteering
@@ -20,22 +20,43 @@
 #ifndef OPENORIENTEERING_GDAL_TEMPLATE_H
 #define OPENORIENTEERING_GDAL_TEMPLATE_H
 
+#include <functional>
+#include <memory>
 #include <vector>
 
+#include <QRect>
+#include <QRectF>
+#include <QSize>
 #include <QString>
 
+#include "gdal/gdal_dem.h"
 #include "templates/template.h"
 #include "templates/template_image.h"
 
 class QByteArray;
+class QPainter;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 
 namespace OpenOrienteering {
 
+class GdalRasterTiles;
 class Map;
+class PathObject;
+class Symbol;
 
 
 /**
  * Support for geospatial raster data.
+ * 
+ * Large rasters are not loaded completely. Instead, the internal image is only
+ * a reduced resolution overview, and the visible parts of the raster are read
+ * on demand, in tiles, at the resolution which is needed for drawing.
+ * 
+ * Single-band rasters with numeric data other than bytes are taken as
+ * elevation models. They are drawn as a hillshade or slope relief which is
+ * computed for the tiles at the resolution of drawing, instead of requiring
+ * precomputed relief rasters.
  */
 class GdalTemplate : public TemplateImage
 {
@@ -60,10 +81,123 @@ public:
 	
 	bool fileExists() const override;
 	
+	void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const override;
+	
+	QSize imageSize() const override;
+	
+	qint64 memoryUsage() const override;
+	
+	/**
+	 * Returns true if the raster is read on demand, in tiles.
+	 */
+	bool isTiled() const { return bool(tiles); }
+	
+	/**
+	 * Returns true if the raster is drawn as the relief of an elevation model.
+	 */
+	bool isElevationModel() const { return elevation_model; }
+	
+	/**
+	 * Returns the kind of relief for elevation models.
+	 */
+	ReliefShading reliefShading() const { return relief_shading; }
+	
+	/**
+	 * Sets the kind of relief for elevation models.
+	 * 
+	 * A loaded template is reloaded in order to apply the change.
+	 */
+	void setReliefShading(ReliefShading shading);
+	
+	/**
+	 * Creates contour lines from the elevation model.
+	 * 
+	 * The raster file is read in full resolution, line by line. The objects
+	 * are created concurrently, with the given symbol, and with the elevation
+	 * as "ele" tag. Ownership of the objects is passed to the caller.
+	 * 
+	 * The progress callback receives the percentage of the raster processed.
+	 * When it returns false, the generation is cancelled, and the result is
+	 * empty.
+	 */
+	std::vector<PathObject*> generateContours(double interval, const Symbol* symbol, const std::function<bool (int)>& progress) const;
+	
+	/**
+	 * Returns true if the raster is warped to the map's CRS.
+	 */
+	bool isReprojected() const { return reproject; }
+	
+	/**
+	 * Enables or disables warping the raster to the map's CRS.
+	 * 
+	 * Without reprojection, georeferenced rasters in a different CRS are
+	 * positioned by an affine approximation. With reprojection, GDAL's warper
+	 * transforms the raster to the map's CRS when reading the tiles, and the
+	 * warped tiles are kept in a persistent cache.
+	 * 
+	 * A loaded template is reloaded in order to apply the change.
+	 */
+	void setReprojected(bool value);
+	
 protected:
+	void saveTypeSpecificTemplateConfiguration(QXmlStreamWriter& xml) const override;
+	
+	bool loadTypeSpecificTemplateConfiguration(QXmlStreamReader& xml) override;
+	
+
 	bool loadTemplateFileImpl() override;
 	
+	void unloadTemplateFileImpl() override;
+	
+	std::function<void ()> makeFileReader() override;
+	
+	/**
+	 * Reads the raster file at data.path, or an overview of large rasters.
+	 * 
+	 * Before reading a raster which is larger than the overview size,
+	 * a preview is read at this size, and preview_ready is called.
+	 * Elevation models are read with the given relief shading. If a target
+	 * CRS is given, the raster is warped to this CRS.
+	 */
+	static void readRasterData(ImageData& data, ReliefShading shading, const QByteArray& target_crs,
+	                           const std::function<void ()>& preview_ready = {});
+	
+	/**
+	 * Returns the CRS for warping the raster, or an empty value.
+	 */
+	QByteArray targetCrs() const;
+	
+	/**
+	 * Returns the directory which contains the persistent tile caches.
+	 */
+	static QString tileCacheRoot();
+	
+	/**
+	 * Returns the directory for the persistent cache of tiles.
+	 * 
+	 * The name depends on the file's path, size and modification time, and on
+	 * the target CRS and relief shading.
+	 */
+	QString tileCacheDirectory() const;
+	
 	bool applyCornerPassPoints();
+	
+	/**
+	 * Sets up the on-demand access to the raster, for the current raster size.
+	 */
+	void createTiles();
+	
+	/**
+	 * Marks the map area covered by the given raster region as dirty.
+	 */
+	void setRegionDirty(const QRect& region);
+	
+private:
+	QSize raster_size;  ///< The raster's full size, when tiled.
+	std::unique_ptr<GdalRasterTiles> tiles;
+	ReliefShading relief_shading = ReliefShading::Hillshade;
+	bool elevation_model = false;
+	bool reproject = false;
 };
 
 
@@ -0,0 +1,264 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geotiff_export.h"
+
+#include <algorithm>
+
+#include <cpl_conv.h>
+#include <cpl_error.h>
+#include <cpl_string.h>
+#include <cpl_vsi.h>
+#include <gdal.h>
+#include <ogr_srs_api.h>
+
+#include <Qt>
+#include <QApplication>
+#include <QColor>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QPointF>
+#include <QProgressDialog>
+#include <QRectF>
+#include <QSizeF>
+#include <QTransform>
+
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_printer.h"
+#include "gdal/gdal_manager.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * The memory for a single band, in bytes.
+ * 
+ * Bands are at least one TIFF block high.
+ */
+constexpr qint64 max_band_bytes = qint64(64) << 20;
+
+
+/**
+ * Sets the CRS of the dataset from the map's georeferencing.
+ */
+void setProjection(GDALDatasetH dataset, const Georeferencing& georef)
+{
+	auto srs = OSRNewSpatialReference(nullptr);
+	auto const spec = georef.getProjectedCRSSpec().toLatin1();
+	char* wkt = nullptr;
+	if (OSRImportFromProj4(srs, spec) == OGRERR_NONE
+	    && OSRExportToWkt(srs, &wkt) == OGRERR_NONE)
+	{
+		GDALSetProjection(dataset, wkt);
+	}
+	CPLFree(wkt);
+	OSRDestroySpatialReference(srs);
+}
+
+
+}  // namespace
+
+
+
+// ### GeoTiffExport ###
+
+GeoTiffExport::~GeoTiffExport() = default;
+
+GeoTiffExport::GeoTiffExport(const QString& path, const Map& map)
+: map(map)
+, path_utf8(QFileInfo(path).absoluteFilePath().toUtf8())
+{
+	// nothing else
+}
+
+
+void GeoTiffExport::setProgressObserver(QProgressDialog* observer) noexcept
+{
+	progress_observer = observer;
+}
+
+QString GeoTiffExport::errorString() const
+{
+	return error_message;
+}
+
+
+bool GeoTiffExport::doExport(const MapPrinter& map_printer, bool transparent_background)
+{
+	error_message.clear();
+
+#ifdef QT_PRINTSUPPORT_LIB
+	auto const units_per_mm = map_printer.getOptions().resolution / 25.4;
+	auto const pixel_per_mm = units_per_mm * map_printer.getScaleAdjustment();
+	auto const print_area = map_printer.getPrintArea();
+	auto const width = qRound(map_printer.getPrintAreaPaperSize().width() * units_per_mm);
+	auto const height = qRound(map_printer.getPrintAreaPaperSize().height() * units_per_mm);
+	if (width <= 0 || height <= 0)
+	{
+		error_message = tr("Unknown error");
+		return false;
+	}
+	
+	GdalManager().registerDrivers();
+	CPLErrorReset();
+	auto* driver = GDALGetDriverByName("GTiff");
+	if (!driver)
+	{
+		error_message = tr("The GeoTIFF driver is not available.");
+		return false;
+	}
+	
+	auto const num_bands = transparent_background ? 4 : 3;
+	char** options = nullptr;
+	options = CSLSetNameValue(options, "TILED", "YES");
+	options = CSLSetNameValue(options, "BLOCKXSIZE", QByteArray::number(block_size));
+	options = CSLSetNameValue(options, "BLOCKYSIZE", QByteArray::number(block_size));
+	options = CSLSetNameValue(options, "COMPRESS", "DEFLATE");
+	options = CSLSetNameValue(options, "PREDICTOR", "2");
+	options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+	options = CSLSetNameValue(options, "PHOTOMETRIC", "RGB");
+	if (transparent_background)
+		options = CSLSetNameValue(options, "ALPHA", "UNASSOCIATED");
+	auto* dataset = GDALCreate(driver, path_utf8, width, height, num_bands, GDT_Byte, options);
+	CSLDestroy(options);
+	if (!dataset)
+	{
+		error_message = QString::fromUtf8(CPLGetLastErrorMsg());
+		return false;
+	}
+	
+	// The geotransform maps pixels to projected coordinates.
+	auto const& georef = map.getGeoreferencing();
+	auto const& map_to_projected = georef.mapToProjected();
+	auto const top_left = georef.toProjectedCoords(MapCoordF(print_area.topLeft()));
+	double geotransform[6] = {
+	    top_left.x(), map_to_projected.m11() / pixel_per_mm, map_to_projected.m21() / pixel_per_mm,
+	    top_left.y(), map_to_projected.m12() / pixel_per_mm, map_to_projected.m22() / pixel_per_mm
+	};
+	GDALSetGeoTransform(dataset, geotransform);
+	if (georef.getState() == Georeferencing::Geospatial)
+		setProjection(dataset, georef);
+	auto const dpi = QByteArray::number(map_printer.getOptions().resolution);
+	GDALSetMetadataItem(dataset, "TIFFTAG_XRESOLUTION", dpi, nullptr);
+	GDALSetMetadataItem(dataset, "TIFFTAG_YRESOLUTION", dpi, nullptr);
+	GDALSetMetadataItem(dataset, "TIFFTAG_RESOLUTIONUNIT", "2", nullptr);  // inch
+	// An unsupported CRS is not an error for the export.
+	CPLErrorReset();
+	
+	// Bands are rendered at full width, and a multiple of the block height.
+	auto const band_rows = std::max(1, int(max_band_bytes / (qint64(width) * 4 * block_size)));
+	auto const band_height = band_rows * block_size;
+	auto const num_image_bands = (height + band_height - 1) / band_height;
+	setMaximumProgress(num_image_bands);
+	
+	auto const background = QColor(transparent_background ? Qt::transparent : Qt::white);
+	auto const format = transparent_background ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+	QImage band;
+	auto result = true;
+	for (int i = 0; i < num_image_bands && result; ++i)
+	{
+		auto const y = i * band_height;
+		auto const rows = std::min(band_height, height - y);
+		if (band.height() != rows)
+			band = QImage(width, rows, QImage::Format_ARGB32_Premultiplied);
+		if (band.isNull())
+		{
+			error_message = tr("Not enough memory.");
+			result = false;
+			break;
+		}
+		band.fill(background);
+		
+		auto transform = QTransform::fromScale(pixel_per_mm, pixel_per_mm);
+		transform.translate(-print_area.left(), -print_area.top() - y / pixel_per_mm);
+		auto const band_area = QRectF(print_area.left(), print_area.top() + (y - 1) / pixel_per_mm,
+		                              print_area.width(), (rows + 2) / pixel_per_mm);
+		QPainter painter(&band);
+		map_printer.drawPage(&painter, band_area, transform, &band);
+		if (!painter.isActive())
+		{
+			error_message = tr("Not enough memory.");
+			result = false;
+			break;
+		}
+		painter.end();
+		
+		// Pixel interleaved, with the alignment of the QImage's scanlines.
+		auto const pixels = band.convertToFormat(format);
+		auto const error = GDALDatasetRasterIO(dataset, GF_Write, 0, y, width, rows,
+		                                       const_cast<uchar*>(pixels.constBits()), width, rows, GDT_Byte,
+		                                       num_bands, nullptr, num_bands, pixels.bytesPerLine(), 1);
+		if (error != CE_None)
+		{
+			error_message = QString::fromUtf8(CPLGetLastErrorMsg());
+			result = false;
+		}
+		
+		setProgress(i + 1);
+		if (wasCanceled())
+			result = false;
+	}
+	
+	GDALClose(dataset);
+	if (result && CPLGetLastErrorType() >= CE_Failure)
+	{
+		error_message = QString::fromUtf8(CPLGetLastErrorMsg());
+		result = false;
+	}
+	if (!result)
+		VSIUnlink(path_utf8);
+	return result;
+#else
+	Q_UNUSED(map_printer)
+	Q_UNUSED(transparent_background)
+	return false;
+#endif  // QT_PRINTSUPPORT_LIB
+}
+
+
+void GeoTiffExport::setMaximumProgress(int value) const
+{
+	if (progress_observer)
+	{
+		progress_observer->setMaximum(value);
+	}
+}
+
+void GeoTiffExport::setProgress(int value) const
+{
+	if (progress_observer)
+	{
+		progress_observer->setValue(value);
+		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents, 100 /* ms */); // Drawing and Cancel events
+	}
+}
+
+bool GeoTiffExport::wasCanceled() const
+{
+	return progress_observer && progress_observer->wasCanceled();
+}
+
+
+}  // namespace OpenOrienteering
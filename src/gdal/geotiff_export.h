@@ -0,0 +1,92 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_GEOTIFF_EXPORT_H
+#define OPENORIENTEERING_GEOTIFF_EXPORT_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+
+class QProgressDialog;
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPrinter;
+
+
+/**
+ * A class which exports the print area to a tiled and compressed GeoTIFF file.
+ * 
+ * The image is rendered in horizontal bands which are written to the file
+ * one after another, so the memory needed for the export depends on the
+ * width of the image, but not on its height. For georeferenced maps, the
+ * file carries the geotransform and the CRS.
+ */
+class GeoTiffExport
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::GeoTiffExport)
+
+public:
+	/**
+	 * The width and height of the TIFF tiles, in pixels.
+	 * 
+	 * Bands are multiples of this height, so that each TIFF tile is written
+	 * exactly once.
+	 */
+	static constexpr int block_size = 256;
+	
+	~GeoTiffExport();
+	
+	GeoTiffExport(const QString& path, const Map& map);
+	
+	void setProgressObserver(QProgressDialog* observer) noexcept;
+	
+	QString errorString() const;
+	
+	/**
+	 * Renders the print area of the map printer to the file.
+	 * 
+	 * When transparent_background is true, the file gets an alpha band.
+	 * On error or cancellation, the file is removed.
+	 */
+	bool doExport(const MapPrinter& map_printer, bool transparent_background);
+
+
+protected:
+	void setMaximumProgress(int value) const;
+	
+	void setProgress(int value) const;
+	
+	bool wasCanceled() const;
+
+private:
+	const Map& map;
+	QProgressDialog* progress_observer = nullptr;
+	QByteArray path_utf8;
+	QString error_message;
+
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_GEOTIFF_EXPORT_H
@@ -21,7 +21,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <deque>
+#include <future>
 #include <iterator>
+#include <utility>
 #include <vector>
 
 #include <cpl_vsi.h>
@@ -42,6 +46,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QProgressDialog>
+#include <QThread>
 #include <QTransform>
 
 #include "mapper_config.h"
@@ -52,6 +57,7 @@
 #include "core/map_printer.h"
 #include "fileformats/file_format.h"
 #include "gdal/gdal_file.h"
+#include "util/parallel.h"
 #include "util/util.h"
 
 // IWYU pragma: no_forward_declare QRectF
@@ -65,6 +71,14 @@ namespace {
 static constexpr const char* format = "jpg";
 static constexpr int quality        = 75;
 
+/**
+ * The maximum amount of memory for tiles which are rendered or compressed
+ * concurrently.
+ */
+constexpr qint64 max_tiles_in_flight_memory = qint64(256) << 20;
+
+
+
 
 QPointF toLonLat(const LatLon& latlon) noexcept
 {
@@ -267,26 +281,106 @@ try
 	writeKml(byte_array, tiles);
 	writeToVSI(doc_filepath_utf8, byte_array);
 	
-	// Create the tile files, reusing the same QImage allocation.
+	// Create the tile files.
 	mkdir(basepath_utf8 + "/files");
 	
-	QImage image(metrics.tile_size_px, QImage::Format_ARGB32_Premultiplied);
+	/*
+	 * The tiles pass a pipeline: The map layers of the upcoming tiles are
+	 * rendered on the thread pool. The templates are drawn and the layers are
+	 * composed on this thread, because the template caches are not
+	 * thread-safe. The finished tiles are compressed on the thread pool again,
+	 * and written on this thread, in order.
+	 */
+	auto const declination = map.getGeoreferencing().getDeclination();
+	auto const tile_bytes = std::max(qint64(1), qint64(metrics.tile_size_px.width()) * metrics.tile_size_px.height() * 4);
+	auto const max_in_flight = std::size_t(std::max(qint64(1), std::min(qint64(QThread::idealThreadCount()), max_tiles_in_flight_memory / tile_bytes)));
+	auto const render_ahead = max_in_flight > 1 && tiles.size() > 1 && map_printer.usesMapBuffer();
+	
 	QImage buffer(metrics.tile_size_px, QImage::Format_RGB32);
-	auto progress = 0;
-	for (auto const& tile : tiles)
+	auto const render_hints = QPainter(&buffer).renderHints() | QPainter::Antialiasing | QPainter::SmoothPixmapTransform;
+	if (render_ahead)
+		map_printer.prepareMapLayers();
+	
+	std::deque<std::future<QImage>> map_layers;
+	std::deque<std::future<QByteArray>> compressed_tiles;
+	std::size_t next_layer = 0;
+	std::size_t next_file = 0;
+	
+	auto start_map_layers = [&]() {
+		while (render_ahead && next_layer < tiles.size() && map_layers.size() < max_in_flight)
+		{
+			auto const& tile = tiles[next_layer++];
+			auto const page_extent = tile.rect_map.adjusted(-5, -5, 5, 5);
+			auto const tile_transform = makeTileTransform(tile.rect_map, metrics, declination);
+			auto const size = metrics.tile_size_px;
+			map_layers.push_back(Util::startJob<QImage>([&map_printer, page_extent, tile_transform, size, render_hints]() {
+				return map_printer.renderMapLayer(page_extent, tile_transform, size, render_hints);
+			}));
+		}
+	};
+	auto write_tiles = [&](std::size_t max_pending) {
+		while (compressed_tiles.size() > max_pending)
+		{
+			byte_array = compressed_tiles.front().get();
+			compressed_tiles.pop_front();
+			writeToVSI(basepath_utf8 + '/' + tiles[next_file++].filepath, byte_array);
+		}
+	};
+	// The workers use the map printer.
+	auto wait_for_workers = [&]() {
+		for (auto& map_layer : map_layers)
+			map_layer.wait();
+		for (auto& compressed_tile : compressed_tiles)
+			compressed_tile.wait();
+	};
+	
+	try
 	{
-		image.fill(Qt::white);
-		buffer.fill(Qt::white);
-		QPainter painter(&image);
-		const auto tile_transform = makeTileTransform(tile.rect_map, metrics, map.getGeoreferencing().getDeclination());
-		map_printer.drawPage(&painter, tile.rect_map.adjusted(-5, -5, 5, 5), tile_transform, &buffer);
-		saveToBuffer(image, byte_array);
-		writeToVSI(basepath_utf8 + '/' + tile.filepath, byte_array);
-		
-		setProgress(++progress);
-		if (wasCanceled())
-			break;
+		for (auto const& tile : tiles)
+		{
+			start_map_layers();
+			
+			QImage image(metrics.tile_size_px, QImage::Format_ARGB32_Premultiplied);
+			if (image.isNull())
+				throw FileFormatException(tr("Not enough memory."));
+			
+			image.fill(Qt::white);
+			buffer.fill(Qt::white);
+			QPainter painter(&image);
+			const auto tile_transform = makeTileTransform(tile.rect_map, metrics, declination);
+			const auto page_extent = tile.rect_map.adjusted(-5, -5, 5, 5);
+			if (render_ahead)
+			{
+				auto map_layer = map_layers.front().get();
+				map_layers.pop_front();
+				map_printer.drawPage(&painter, page_extent, tile_transform, &buffer, std::move(map_layer));
+			}
+			else
+			{
+				map_printer.drawPage(&painter, page_extent, tile_transform, &buffer);
+			}
+			painter.end();
+			
+			compressed_tiles.push_back(Util::startJob<QByteArray>([image]() {
+				QByteArray data;
+				saveToBuffer(image, data);
+				return data;
+			}));
+			write_tiles(max_in_flight - 1);
+			
+			setProgress(int(next_file));
+			if (wasCanceled())
+				break;
+		}
+		if (!wasCanceled())
+			write_tiles(0);
+	}
+	catch (...)
+	{
+		wait_for_workers();
+		throw;
 	}
+	wait_for_workers();
 	return true;
 #else
 	Q_UNUSED(map_printer)
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016-2020 Kai Pastor
+ *    Copyright 2016-2020, 2026 Kai Pastor
  *    Copyright 2025 Matthias Kühlewein
  *
  *    This file is part of OpenOrienteering.
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <exception>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -31,6 +32,7 @@
 #include <vector>
 
 #include <cpl_conv.h>
+#include <cpl_string.h>
 #include <gdal.h>
 #include <ogr_api.h>
 #include <ogr_srs_api.h>
@@ -82,6 +84,7 @@
 #include "gdal/gdal_template.h"
 #include "templates/template.h"
 #include "util/key_value_container.h"
+#include "util/parallel.h"
 
 // IWYU pragma: no_forward_declare QFile
 
@@ -89,6 +92,12 @@ namespace OpenOrienteering {
 
 namespace {
 	
+	/**
+	 * The number of features which are imported together.
+	 */
+	constexpr std::size_t feature_batch_size = 1000;
+	
+	
 	void applyPenWidth(OGRStyleToolH tool, LineSymbol* line_symbol)
 	{
 		int is_null;
@@ -654,24 +663,15 @@ std::vector<std::unique_ptr<OgrFileExportFormat>> OgrFileExportFormat::makeAll()
 {
 	std::vector<std::unique_ptr<OgrFileExportFormat>> result;
 	
-	auto count = GDALGetDriverCount();
-	result.reserve(count / 2);
+	// Doesn't need driver registration, cf. GdalManager.
+	auto const& drivers = GdalManager().vectorExportDrivers();
+	result.reserve(drivers.size());
 	
-	for (auto i = 0; i < count; ++i)
+	for (auto const& driver : drivers)
 	{
-		auto driver_data = GDALGetDriver(i);
-		auto const* cap_vector = GDALGetMetadataItem(driver_data, GDAL_DCAP_VECTOR, nullptr);
-		auto const* cap_create = GDALGetMetadataItem(driver_data, GDAL_DCAP_CREATE, nullptr);
-		auto const* extensions = GDALGetMetadataItem(driver_data, GDAL_DMD_EXTENSIONS, nullptr);
-		if (qstrcmp(cap_vector, "YES") != 0
-		    || qstrcmp(cap_create, "YES") != 0
-		    || qstrlen(extensions) == 0)
-			continue;
-		
 		auto id = QByteArray("OGR-export-");
-		id.append(GDALGetDriverShortName(driver_data));
-		auto const* long_name  = GDALGetDriverLongName(driver_data);
-		result.push_back(std::make_unique<OgrFileExportFormat>(id, long_name, extensions));
+		id.append(driver.name);
+		result.push_back(std::make_unique<OgrFileExportFormat>(id, driver.long_name.constData(), driver.extensions.constData()));
 	}
 	return result;
 }
@@ -689,7 +689,11 @@ OgrFileImport::Clipping::~Clipping() = default;
 bool OgrFileImport::canRead(const QString& path)
 {
 	// GDAL 2.0: ... = GDALOpenEx(template_path.toLatin1(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
-	GdalManager();
+	GdalManager manager;
+	if (!manager.hasSupportedExtension(path))
+		return false;
+	
+	manager.registerDrivers();
 	return bool(ogr::unique_datasource(OGROpen(path.toUtf8().constData(), 0, nullptr)));
 }
 
@@ -771,6 +775,16 @@ void OgrFileImport::setGeoreferencingImportEnabled(bool enabled)
 	georeferencing_import_enabled = enabled;
 }
 
+void OgrFileImport::setSpatialFilter(const MapCoordVectorF& area)
+{
+	spatial_filter = area;
+}
+
+void OgrFileImport::setAttributeFilter(const QString& expression)
+{
+	attribute_filter = expression.toUtf8();
+}
+
 
 
 ogr::unique_srs OgrFileImport::srsFromMap()
@@ -880,7 +894,7 @@ bool OgrFileImport::importImplementation()
 				}
 			}
 				
-			importLayer(part, layer);
+			importLayer(part, layer, 99 * i / num_layers, 99 * (i + 1) / num_layers);
 		}
 		
 		const auto& offset = MapCoord::boundsOffset();
@@ -1040,21 +1054,47 @@ void OgrFileImport::importStyles(OGRDataSourceH data_source)
 	Q_UNUSED(data_source)
 }
 
-void OgrFileImport::importLayer(MapPart* map_part, OGRLayerH layer)
+void OgrFileImport::importLayer(MapPart* map_part, OGRLayerH layer, int progress_first, int progress_last)
 {
 	FILEFORMAT_ASSERT(map_part);
 	
 	auto feature_definition = OGR_L_GetLayerDefn(layer);
 	
+	if (!applyLayerFilters(layer))
+		return;
+	
 	std::unique_ptr<Clipping> clipping;
 	if (clip_layers && OGR_L_TestCapability(layer, OLCFastGetExtent))
 	{
 		clipping = getLayerClipping(layer);
 	}
 	
+	// The features must be kept until the path coordinates are converted.
+	struct ImportedFeature
+	{
+		ogr::unique_feature feature;
+		ObjectList objects;
+	};
+	std::vector<ImportedFeature> batch;
+	batch.reserve(feature_batch_size);
+	ObjectList new_objects;
+	auto const import_batch = [&]() {
+		convertPendingPaths();
+		for (auto& item : batch)
+			finishFeature(new_objects, feature_definition, item.feature.get(), std::move(item.objects), clipping.get());
+		map_part->appendLoadedObjects(new_objects);
+		new_objects.clear();
+		batch.clear();
+	};
+	
+	// The feature count is -1 if it is expensive to determine.
+	auto const num_features = OGR_L_GetFeatureCount(layer, FALSE);
+	auto num_read = decltype(num_features)(0);
+	
 	OGR_L_ResetReading(layer);
 	while (auto feature = ogr::unique_feature(OGR_L_GetNextFeature(layer)))
 	{
+		++num_read;
 		auto geometry = OGR_F_GetGeometryRef(feature.get());
 		if (!geometry || OGR_G_IsEmpty(geometry))
 		{
@@ -1062,27 +1102,43 @@ void OgrFileImport::importLayer(MapPart* map_part, OGRLayerH layer)
 			continue;
 		}
 		
-		importFeature(map_part, feature_definition, feature.get(), geometry, clipping.get());
+		auto objects = importFeature(feature.get(), geometry);
+		if (objects.empty())
+			continue;
+		
+		batch.push_back({std::move(feature), std::move(objects)});
+		if (batch.size() == feature_batch_size)
+		{
+			import_batch();
+			auto const fraction = num_features > 0 ? double(qMin(num_read, num_features)) / num_features : 0.0;
+			reportProgress(progress_first + int((progress_last - progress_first) * fraction));
+		}
 	}
+	import_batch();
 }
 
-void OgrFileImport::importFeature(MapPart* map_part, OGRFeatureDefnH feature_definition, OGRFeatureH feature, OGRGeometryH geometry, const Clipping* clipping)
+OgrFileImport::ObjectList OgrFileImport::importFeature(OGRFeatureH feature, OGRGeometryH geometry)
 {
 	auto new_srs = OGR_G_GetSpatialReference(geometry);
 	if (!setSRS(new_srs))
-		return;
+		return {};
 	
 	if (new_srs)
 	{
+		// Transforms all points of the geometry in a single call.
 		auto error = OGR_G_Transform(geometry, data_transform.get());
 		if (error)
 		{
 			++failed_transformation;
-			return;
+			return {};
 		}
 	}
 	
-	auto objects = importGeometry(feature, geometry);
+	return importGeometry(feature, geometry);
+}
+
+void OgrFileImport::finishFeature(ObjectList& new_objects, OGRFeatureDefnH feature_definition, OGRFeatureH feature, ObjectList objects, const Clipping* clipping)
+{
     //JU: Possibility to add more tags later
 	auto tags = importFields(feature_definition, feature);
 	
@@ -1106,7 +1162,7 @@ void OgrFileImport::importFeature(MapPart* map_part, OGRFeatureDefnH feature_def
 			}
 		}
 		object->setTags(tags);
-		map_part->addObject(object);
+		new_objects.push_back(object);
 	}
 }
 
@@ -1123,6 +1179,7 @@ KeyValueContainer OgrFileImport::importFields(OGRFeatureDefnH feature_definition
 			tags.insert_or_assign(QString::fromUtf8(OGR_Fld_GetNameRef(field_definition)), QString::fromUtf8(value));
 		}
 	}
+	tags.internStrings(map->tagStrings());
 	return tags;
 }
 
@@ -1279,10 +1336,7 @@ PathObject* OgrFileImport::importLineStringGeometry(OGRFeatureH feature, OGRGeom
 	
 	auto style = OGR_F_GetStyleString(feature);
 	auto object = new PathObject(getSymbol(Symbol::Line, style));
-	for (int i = 0; i < num_points; ++i)
-	{
-		object->addCoordinate(toMapCoord(OGR_G_GetX(geometry, i), OGR_G_GetY(geometry, i)));
-	}
+	pending_paths.push_back({object, geometry, geometry, std::move(managed_geometry), to_map_coord});
 	return object;
 }
 
@@ -1311,25 +1365,72 @@ PathObject* OgrFileImport::importPolygonGeometry(OGRFeatureH feature, OGRGeometr
 	
 	auto style = OGR_F_GetStyleString(feature);
 	auto object = new PathObject(getSymbol(Symbol::Area, style));
+	pending_paths.push_back({object, geometry, outline, std::move(managed_outline), to_map_coord});
+	return object;
+}
+
+void OgrFileImport::convertPath(const PendingPath& path) const
+{
+	auto* object = path.object;
+	auto const to_map_coord = path.to_map_coord;
+	auto const num_points = OGR_G_GetPointCount(path.outline);
 	for (int i = 0; i < num_points; ++i)
 	{
-		object->addCoordinate(toMapCoord(OGR_G_GetX(outline, i), OGR_G_GetY(outline, i)));
+		object->addCoordinate((this->*to_map_coord)(OGR_G_GetX(path.outline, i), OGR_G_GetY(path.outline, i)));
 	}
 	
+	if (path.geometry == path.outline)
+		return;  // line string
+	
+	auto const num_geometries = OGR_G_GetGeometryCount(path.geometry);
 	for (int g = 1; g < num_geometries; ++g)
 	{
 		bool start_new_part = true;
-		auto hole = /*OGR_G_ForceToLineString*/(OGR_G_GetGeometryRef(geometry, g));
+		auto hole = /*OGR_G_ForceToLineString*/(OGR_G_GetGeometryRef(path.geometry, g));
 		auto num_points = OGR_G_GetPointCount(hole);
 		for (int i = 0; i < num_points; ++i)
 		{
-			object->addCoordinate(toMapCoord(OGR_G_GetX(hole, i), OGR_G_GetY(hole, i)), start_new_part);
+			object->addCoordinate((this->*to_map_coord)(OGR_G_GetX(hole, i), OGR_G_GetY(hole, i)), start_new_part);
 			start_new_part = false;
 		}
 	}
 	
 	object->closeAllParts();
-	return object;
+}
+
+void OgrFileImport::convertPendingPaths()
+{
+	auto const size = pending_paths.size();
+	auto first = std::size_t(0);
+	if (size > 0 && MapCoord::boundsOffset().check_for_offset)
+	{
+		// The first coordinate initializes the bounds offset.
+		convertPath(pending_paths.front());
+		first = 1;
+	}
+	
+	// Exceptions must not leave the worker threads.
+	std::vector<std::exception_ptr> errors(size);
+	Util::parallelFor(size - first, 16, [this, first, &errors](std::size_t begin, std::size_t end) {
+		for (auto i = first + begin; i < first + end; ++i)
+		{
+			try
+			{
+				convertPath(pending_paths[i]);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}
+	});
+	pending_paths.clear();
+	
+	for (auto const& error : errors)
+	{
+		if (error)
+			std::rethrow_exception(error);
+	}
 }
 
 std::unique_ptr<OgrFileImport::Clipping> OgrFileImport::getLayerClipping(OGRLayerH layer)
@@ -1369,6 +1470,57 @@ std::unique_ptr<OgrFileImport::Clipping> OgrFileImport::getLayerClipping(OGRLaye
 	return {};
 }
 
+bool OgrFileImport::applyLayerFilters(OGRLayerH layer)
+{
+	auto const* layer_name = OGR_L_GetName(layer);
+	
+	if (!attribute_filter.isEmpty()
+	    && OGR_L_SetAttributeFilter(layer, attribute_filter.constData()) != OGRERR_NONE)
+	{
+		addWarning(tr("Unable to apply the attribute filter to layer %1: %2")
+		           .arg(QString::fromUtf8(layer_name), QString::fromUtf8(CPLGetLastErrorMsg())));
+		return false;
+	}
+	
+	if (spatial_filter.size() < 3)
+		return true;
+	
+	// Build the area in the layer's coordinates, reversing toMapCoord().
+	auto layer_srs = OGR_L_GetSpatialRef(layer);
+	auto const& georef = map->getGeoreferencing();
+	auto ring = ogr::unique_geometry(OGR_G_CreateGeometry(wkbLinearRing));
+	for (auto const& coord : spatial_filter)
+	{
+		if (!layer_srs && unit_type == UnitOnPaper)
+		{
+			OGR_G_AddPoint_2D(ring.get(), coord.x(), -coord.y());
+		}
+		else
+		{
+			auto const projected = georef.toProjectedCoords(coord);
+			OGR_G_AddPoint_2D(ring.get(), projected.x(), projected.y());
+		}
+	}
+	OGR_G_CloseRings(ring.get());
+	
+	auto area = ogr::unique_geometry(OGR_G_CreateGeometry(wkbPolygon));
+	OGR_G_AddGeometryDirectly(area.get(), ring.release());
+	
+	if (layer_srs)
+	{
+		auto transformation = ogr::unique_transformation{ OCTNewCoordinateTransformation(map_srs.get(), layer_srs) };
+		if (!transformation || OGR_G_Transform(area.get(), transformation.get()) != OGRERR_NONE)
+		{
+			addWarning(tr("Unable to apply the spatial filter to layer %1.").arg(QString::fromUtf8(layer_name)));
+			return false;
+		}
+	}
+	
+	// OGR copies the geometry.
+	OGR_L_SetSpatialFilter(layer, area.get());
+	return true;
+}
+
 
 bool OgrFileImport::setSRS(OGRSpatialReferenceH srs)
 {
@@ -1820,7 +1972,7 @@ bool OgrFileImport::checkGeoreferencing(const QString& path, const Georeferencin
 	if (georef.getState() != Georeferencing::Geospatial)
 		return false;
 	
-	GdalManager();
+	GdalManager().registerDrivers();
 	
 	// GDAL 2.0: ... = GDALOpenEx(template_path.toLatin1(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
 	auto data_source = ogr::unique_datasource(OGROpen(path.toUtf8().constData(), 0, nullptr));
@@ -1875,7 +2027,7 @@ bool OgrFileImport::checkGeoreferencing(OGRDataSourceH data_source, const Georef
 // static
 LatLon OgrFileImport::calcAverageLatLon(const QString& path)
 {
-	GdalManager();
+	GdalManager().registerDrivers();
 	
 	// GDAL 2.0: ... = GDALOpenEx(template_path.toLatin1(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
 	auto data_source = ogr::unique_datasource(OGROpen(path.toUtf8().constData(), 0, nullptr));
@@ -1959,8 +2111,10 @@ OgrFileExport::OgrFileExport(const QString& path, const Map* map, const MapView*
 		this->id = nullptr;
 	
 	GdalManager manager;
+	manager.registerDrivers();
 	bool one_layer_per_symbol = manager.isExportOptionEnabled(GdalManager::OneLayerPerSymbol);
 	setOption(QString::fromLatin1("Per Symbol Layers"), one_layer_per_symbol);
+	setOption(QString::fromLatin1("Transaction size"), default_transaction_size);
 }
 
 OgrFileExport::~OgrFileExport() = default;
@@ -1993,11 +2147,29 @@ bool OgrFileExport::exportImplementation()
 
 	setupGeoreferencing(po_driver);
 
+	// Vector tiles: The driver reprojects, clips and simplifies the
+	// geometries for each zoom level, and encodes the tiles.
+	char** creation_options = nullptr;
+	if (quirks & VectorTiles)
+	{
+		auto const default_max_zoom = defaultVectorTilesMaxZoom(map->getScaleDenominator());
+		auto max_zoom = option(QString::fromLatin1("Vector tiles max zoom"));
+		if (!max_zoom.isValid())
+			max_zoom = default_max_zoom;
+		auto min_zoom = option(QString::fromLatin1("Vector tiles min zoom"));
+		if (!min_zoom.isValid())
+			min_zoom = std::max(0, max_zoom.toInt() - 6);
+		creation_options = CSLSetNameValue(creation_options, "MINZOOM", QByteArray::number(min_zoom.toInt()));
+		creation_options = CSLSetNameValue(creation_options, "MAXZOOM", QByteArray::number(max_zoom.toInt()));
+		creation_options = CSLSetNameValue(creation_options, "NAME", info.completeBaseName().toUtf8());
+	}
+
 	// Create output dataset
 	po_ds = ogr::unique_datasource(OGR_Dr_CreateDataSource(
 	                                   po_driver,
 	                                   path.toLatin1(),
-	                                   nullptr));
+	                                   creation_options));
+	CSLDestroy(creation_options);
 	if (!po_ds)
 		throw FileFormatException(tr("Failed to create dataset: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
 
@@ -2035,7 +2207,8 @@ bool OgrFileExport::exportImplementation()
 		if (layer == nullptr)
 			throw FileFormatException(tr("Failed to create layer: %2").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
 	}
-	else if (option(QString::fromLatin1("Per Symbol Layers")).toBool())
+	else if (option(QString::fromLatin1("Per Symbol Layers")).toBool()
+	         || quirks.testFlag(VectorTiles))
 	{
 		export_mode = ExportMode::LayerPerSymbol;
 	}
@@ -2119,6 +2292,16 @@ bool OgrFileExport::exportImplementation()
 }
 
 
+// static
+int OgrFileExport::defaultVectorTilesMaxZoom(unsigned int scale_denominator)
+{
+	// Web Mercator ground resolution at zoom level 0, for 256 px tiles
+	constexpr auto meters_per_pixel_z0 = 156543.03392804;
+	auto const meters_per_pixel = std::max(1u, scale_denominator) * 0.0001;
+	return qBound(0, qRound(std::log2(meters_per_pixel_z0 / meters_per_pixel)), 22);
+}
+
+
 std::vector<const Symbol*> OgrFileExport::symbolsForExport() const
 {
 	std::vector<bool> symbols_in_use;
@@ -2205,8 +2388,11 @@ void OgrFileExport::setupQuirks(GDALDriverH po_driver)
 	    { "GPX",           NeedsWgs84 },
 	    { "INGRES",        GeorefOptional },
 	    { "LIBKML",        NeedsWgs84 },
+	    { "MBTiles",       VectorTiles },
+	    { "MVT",           VectorTiles },
 	    { "ODS",           GeorefOptional },
 	    { "OpenJUMP .jml", GeorefOptional },
+	    { "PMTiles",       VectorTiles },
 	    { "REC",           GeorefOptional },
 	    { "SEGY",          GeorefOptional },
 	    { "XLS",           GeorefOptional },
@@ -2226,44 +2412,38 @@ void OgrFileExport::addPointsToLayer(OGRLayerH layer, const std::function<bool (
 {
 	const auto& georef = map->getGeoreferencing();
 
-	auto add_feature = [&](const Object* object) {
-		auto symbol = object->getSymbol();
-		auto po_feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(layer)));
-
-		QString sym_name = symbol->getPlainTextName();
-		sym_name.truncate(32);
-		OGR_F_SetFieldString(po_feature.get(), OGR_F_GetFieldIndex(po_feature.get(), symbol_field), sym_name.toLatin1().constData());
-
-		auto pt = ogr::unique_geometry(OGR_G_CreateGeometry(wkbPoint));
+	auto make_geometries = [&georef](const Object* object) {
+		GeometryList result;
+		result.emplace_back(OGR_G_CreateGeometry(wkbPoint));
 		QPointF proj_cord = georef.toProjectedCoords(object->asPoint()->getCoordF());
+		OGR_G_SetPoint_2D(result.back().get(), 0, proj_cord.x(), proj_cord.y());
+		return result;
+	};
 
-		OGR_G_SetPoint_2D(pt.get(), 0, proj_cord.x(), proj_cord.y());
-
-		if (quirks & NeedsWgs84)
-			OGR_G_Transform(pt.get(), transformation.get());
-
-		OGR_F_SetGeometry(po_feature.get(), pt.get());
-
-		OGR_F_SetStyleString(po_feature.get(), OGR_STBL_Find(table.get(), symbolId(symbol)));
-
-		if (OGR_L_CreateFeature(layer, po_feature.get()) != OGRERR_NONE)
-			throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
+	auto set_attributes = [this](OGRFeatureH po_feature, const Object* object) {
+		auto symbol = object->getSymbol();
+		setSymbolField(po_feature, symbol);
+		OGR_F_SetStyleString(po_feature, OGR_STBL_Find(table.get(), symbolId(symbol)));
 	};
 
-	map->applyOnMatchingObjects(add_feature, condition);
+	addFeaturesToLayer(layer, condition, make_geometries, set_attributes);
 }
 
 void OgrFileExport::addTextToLayer(OGRLayerH layer, const std::function<bool (const Object*)>& condition)
 {
 	const auto& georef = map->getGeoreferencing();
 
-	auto add_feature = [&](const Object* object) {
-		auto symbol = object->getSymbol();
-		auto po_feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(layer)));
+	auto make_geometries = [&georef](const Object* object) {
+		GeometryList result;
+		result.emplace_back(OGR_G_CreateGeometry(wkbPoint));
+		QPointF proj_cord = georef.toProjectedCoords(object->asText()->getAnchorCoordF());
+		OGR_G_SetPoint_2D(result.back().get(), 0, proj_cord.x(), proj_cord.y());
+		return result;
+	};
 
-		QString sym_name = symbol->getPlainTextName();
-		sym_name.truncate(32);
-		OGR_F_SetFieldString(po_feature.get(), OGR_F_GetFieldIndex(po_feature.get(), symbol_field), sym_name.toLatin1().constData());
+	auto set_attributes = [this](OGRFeatureH po_feature, const Object* object) {
+		auto symbol = object->getSymbol();
+		setSymbolField(po_feature, symbol);
 
 		auto text = object->asText()->getText();
 		if (o_name_field)
@@ -2271,20 +2451,10 @@ void OgrFileExport::addTextToLayer(OGRLayerH layer, const std::function<bool (co
 			// Use the name field for the text (useful e.g. for KML).
 			// This may overwrite the symbol name, and
 			// it may be too short for the full text.
-			auto index = OGR_F_GetFieldIndex(po_feature.get(), OGR_Fld_GetNameRef(o_name_field.get()));
-			OGR_F_SetFieldString(po_feature.get(), index, text.leftRef(32).toUtf8().constData());
+			auto index = OGR_F_GetFieldIndex(po_feature, OGR_Fld_GetNameRef(o_name_field.get()));
+			OGR_F_SetFieldString(po_feature, index, text.leftRef(32).toUtf8().constData());
 		}
 
-		auto pt = ogr::unique_geometry(OGR_G_CreateGeometry(wkbPoint));
-		QPointF proj_cord = georef.toProjectedCoords(object->asText()->getAnchorCoordF());
-
-		OGR_G_SetPoint_2D(pt.get(), 0, proj_cord.x(), proj_cord.y());
-
-		if (quirks & NeedsWgs84)
-			OGR_G_Transform(pt.get(), transformation.get());
-
-		OGR_F_SetGeometry(po_feature.get(), pt.get());
-
 		QByteArray style = OGR_STBL_Find(table.get(), symbolId(symbol));
 		if (!o_name_field || text.length() > 32)
 		{
@@ -2293,99 +2463,150 @@ void OgrFileExport::addTextToLayer(OGRLayerH layer, const std::function<bool (co
 			text.replace(QRegularExpression(QLatin1String("([\"\\\\])"), QRegularExpression::MultilineOption), QLatin1String("\\\\1"));
 			style.replace("{Name}", text.toUtf8());
 		}
-		OGR_F_SetStyleString(po_feature.get(), style);
-
-		if (OGR_L_CreateFeature(layer, po_feature.get()) != OGRERR_NONE)
-			throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
+		OGR_F_SetStyleString(po_feature, style);
 	};
 
-	map->applyOnMatchingObjects(add_feature, condition);
+	addFeaturesToLayer(layer, condition, make_geometries, set_attributes);
 }
 
 void OgrFileExport::addLinesToLayer(OGRLayerH layer, const std::function<bool (const Object*)>& condition)
 {
 	const auto& georef = map->getGeoreferencing();
 
-	auto add_feature = [&](const Object* object) {
-		const auto* symbol = object->getSymbol();
-		const auto* path = object->asPath();
-		if (path->parts().empty())
-			return;
-
-		QString sym_name = symbol->getPlainTextName();
-		sym_name.truncate(32);
-
-		auto line_string = ogr::unique_geometry(OGR_G_CreateGeometry(wkbLineString));
-		const auto& parts = path->parts();
+	// One feature per part
+	auto make_geometries = [&georef](const Object* object) {
+		GeometryList result;
+		const auto& parts = object->asPath()->parts();
+		result.reserve(parts.size());
 		for (const auto& part : parts)
 		{
-			auto po_feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(layer)));
-			OGR_F_SetFieldString(po_feature.get(), OGR_F_GetFieldIndex(po_feature.get(), symbol_field), sym_name.toLatin1().constData());
-
+			result.emplace_back(OGR_G_CreateGeometry(wkbLineString));
 			for (const auto& coord : part.path_coords)
 			{
 				QPointF proj_cord = georef.toProjectedCoords(coord.pos);
-				OGR_G_AddPoint_2D(line_string.get(), proj_cord.x(), proj_cord.y());
+				OGR_G_AddPoint_2D(result.back().get(), proj_cord.x(), proj_cord.y());
 			}
-
-			if (quirks & NeedsWgs84)
-				OGR_G_Transform(line_string.get(), transformation.get());
-
-			OGR_F_SetGeometry(po_feature.get(), line_string.get());
-
-			OGR_F_SetStyleString(po_feature.get(), OGR_STBL_Find(table.get(), symbolId(symbol)));
-
-			if (OGR_L_CreateFeature(layer, po_feature.get()) != OGRERR_NONE)
-				throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
 		}
+		return result;
 	};
 
-	map->applyOnMatchingObjects(add_feature, condition);
+	auto set_attributes = [this](OGRFeatureH po_feature, const Object* object) {
+		auto symbol = object->getSymbol();
+		setSymbolField(po_feature, symbol);
+		OGR_F_SetStyleString(po_feature, OGR_STBL_Find(table.get(), symbolId(symbol)));
+	};
+
+	addFeaturesToLayer(layer, condition, make_geometries, set_attributes);
 }
 
 void OgrFileExport::addAreasToLayer(OGRLayerH layer, const std::function<bool (const Object*)>& condition)
 {
 	const auto& georef = map->getGeoreferencing();
 
-	auto add_feature = [&](const Object* object) {
-		const auto* symbol = object->getSymbol();
-		const auto* path = object->asPath();
-		if (path->parts().empty())
-			return;
-
-		auto po_feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(layer)));
-
-		QString sym_name = symbol->getPlainTextName();
-		sym_name.truncate(32);
-		OGR_F_SetFieldString(po_feature.get(), OGR_F_GetFieldIndex(po_feature.get(), symbol_field), sym_name.toLatin1().constData());
+	auto make_geometries = [&georef](const Object* object) {
+		GeometryList result;
+		const auto& parts = object->asPath()->parts();
+		if (parts.empty())
+			return result;
 
 		auto polygon = ogr::unique_geometry(OGR_G_CreateGeometry(wkbPolygon));
-		auto cur_ring = ogr::unique_geometry(OGR_G_CreateGeometry(wkbLinearRing));
-
-		const auto& parts = path->parts();
 		for (const auto& part : parts)
 		{
+			auto cur_ring = OGR_G_CreateGeometry(wkbLinearRing);
 			for (const auto& coord : part.path_coords)
 			{
 				QPointF proj_cord = georef.toProjectedCoords(coord.pos);
-				OGR_G_AddPoint_2D(cur_ring.get(), proj_cord.x(), proj_cord.y());
+				OGR_G_AddPoint_2D(cur_ring, proj_cord.x(), proj_cord.y());
 			}
-			OGR_G_CloseRings(cur_ring.get());
-			if (quirks & NeedsWgs84)
-				OGR_G_Transform(cur_ring.get(), transformation.get());
-			OGR_G_AddGeometry(polygon.get(), cur_ring.get());
-			cur_ring.reset(OGR_G_CreateGeometry(wkbLinearRing));
+			OGR_G_CloseRings(cur_ring);
+			OGR_G_AddGeometryDirectly(polygon.get(), cur_ring);
 		}
+		result.push_back(std::move(polygon));
+		return result;
+	};
 
-		OGR_F_SetGeometry(po_feature.get(), polygon.get());
+	auto set_attributes = [this](OGRFeatureH po_feature, const Object* object) {
+		auto symbol = object->getSymbol();
+		setSymbolField(po_feature, symbol);
+		OGR_F_SetStyleString(po_feature, OGR_STBL_Find(table.get(), symbolId(symbol)));
+	};
 
-		OGR_F_SetStyleString(po_feature.get(), OGR_STBL_Find(table.get(), symbolId(symbol)));
+	addFeaturesToLayer(layer, condition, make_geometries, set_attributes);
+}
 
-		if (OGR_L_CreateFeature(layer, po_feature.get()) != OGRERR_NONE)
-			throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
-	};
+void OgrFileExport::addFeaturesToLayer(OGRLayerH layer,
+                                       const std::function<bool (const Object*)>& condition,
+                                       const std::function<GeometryList (const Object*)>& make_geometries,
+                                       const std::function<void (OGRFeatureH, const Object*)>& set_attributes)
+{
+	std::vector<const Object*> objects;
+	map->applyOnMatchingObjects([&objects](const Object* object) { objects.push_back(object); }, condition);
+
+	auto const batch_size = std::max(std::size_t(1), std::size_t(option(QString::fromLatin1("Transaction size")).toUInt()));
+	std::vector<GeometryList> geometries;
+	for (std::size_t first = 0; first < objects.size(); first += batch_size)
+	{
+		auto const count = std::min(batch_size, objects.size() - first);
+
+		// Build the geometries concurrently. The coordinate transformation
+		// object must not be shared between threads, so it is used below.
+		geometries.clear();
+		geometries.resize(count);
+		Util::parallelFor(count, 64, [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+				geometries[i] = make_geometries(objects[first + i]);
+		});
+
+		// One transaction per batch, if supported by the driver.
+		auto const transaction = GDALDatasetStartTransaction(po_ds.get(), FALSE) == OGRERR_NONE;
+		try
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				for (auto& geometry : geometries[i])
+				{
+					if (quirks & NeedsWgs84)
+						OGR_G_Transform(geometry.get(), transformation.get());
+
+					auto po_feature = ogr::unique_feature(OGR_F_Create(OGR_L_GetLayerDefn(layer)));
+					set_attributes(po_feature.get(), objects[first + i]);
+					OGR_F_SetGeometryDirectly(po_feature.get(), geometry.release());
+
+					if (OGR_L_CreateFeature(layer, po_feature.get()) != OGRERR_NONE)
+						throw FileFormatException(tr("Failed to create feature in layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
+				}
+			}
+		}
+		catch (...)
+		{
+			if (transaction)
+				GDALDatasetRollbackTransaction(po_ds.get());
+			throw;
+		}
 
-	map->applyOnMatchingObjects(add_feature, condition);
+		if (transaction && GDALDatasetCommitTransaction(po_ds.get()) != OGRERR_NONE)
+			throw FileFormatException(tr("Failed to commit features to layer: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
+	}
+}
+
+void OgrFileExport::setSymbolField(OGRFeatureH po_feature, const Symbol* symbol) const
+{
+	QString sym_name = symbol->getPlainTextName();
+	sym_name.truncate(32);
+	OGR_F_SetFieldString(po_feature, OGR_F_GetFieldIndex(po_feature, symbol_field), sym_name.toLatin1().constData());
+	
+	if (quirks & VectorTiles)
+	{
+		// Vector tiles have no style table. Web viewers style the features
+		// by the symbol's dominant color, in the order of color priorities.
+		OGR_F_SetFieldString(po_feature, OGR_F_GetFieldIndex(po_feature, "Code"), symbol->getNumberAsString().toLatin1().constData());
+		if (auto color = symbol->guessDominantColor())
+		{
+			auto rgb = QColor(color->getRgb()).name(QColor::HexRgb).toLatin1();
+			OGR_F_SetFieldString(po_feature, OGR_F_GetFieldIndex(po_feature, "Color"), rgb.constData());
+			OGR_F_SetFieldInteger(po_feature, OGR_F_GetFieldIndex(po_feature, "Priority"), color->getPriority());
+		}
+	}
 }
 
 OGRLayerH OgrFileExport::createLayer(const char* layer_name, OGRwkbGeometryType type)
@@ -2401,6 +2622,24 @@ OGRLayerH OgrFileExport::createLayer(const char* layer_name, OGRwkbGeometryType
 	{
 		addWarning(tr("Failed to create name field: %1").arg(QString::fromLatin1(CPLGetLastErrorMsg())));
 	}
+	
+	if (quirks & VectorTiles)
+	{
+		static const struct {
+			const char* name;
+			OGRFieldType type;
+		} tile_fields[] = {
+		    { "Code",     OFTString },
+		    { "Color",    OFTString },
+		    { "Priority", OFTInteger },
+		};
+		for (auto const& tile_field : tile_fields)
+		{
+			auto field = ogr::unique_fielddefn(OGR_Fld_Create(tile_field.name, tile_field.type));
+			if (OGR_L_CreateField(po_layer, field.get(), 1) != OGRERR_NONE)
+				addWarning(tr("Failed to create field %1: %2").arg(QString::fromLatin1(tile_field.name), QString::fromLatin1(CPLGetLastErrorMsg())));
+		}
+	}
 
 	return po_layer;
 }
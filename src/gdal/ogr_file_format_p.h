@@ -241,6 +241,25 @@ public:
 	 */
 	void setGeoreferencingImportEnabled(bool enabled);
 	
+	/**
+	 * Restricts the import to the features which intersect the given area.
+	 * 
+	 * The area is a polygon in the coordinates of the Map given to the
+	 * constructor. The filter is passed to OGR before reading the features
+	 * of each layer, so that other features are not even fetched. An empty
+	 * area disables the filter.
+	 */
+	void setSpatialFilter(const MapCoordVectorF& area);
+	
+	/**
+	 * Restricts the import to the features which match the given expression.
+	 * 
+	 * The expression is an OGR SQL WHERE clause, passed to OGR before
+	 * reading the features of each layer. An empty expression disables the
+	 * filter.
+	 */
+	void setAttributeFilter(const QString& expression);
+	
 	
 	/**
 	 * Tests if the file's spatial references can be used with the given georeferencing.
@@ -280,9 +299,29 @@ protected:
 	
 	void importStyles(OGRDataSourceH data_source);
 	
-	void importLayer(MapPart* map_part, OGRLayerH layer);
+	/**
+	 * Imports the features of a layer in batches.
+	 * 
+	 * For each batch, the features are read and transformed, and the objects
+	 * are created, on the calling thread. The coordinates of path objects are
+	 * converted concurrently, and finally the objects are added to the map
+	 * part in bulk. After each batch, the progress is reported within the
+	 * given range.
+	 */
+	void importLayer(MapPart* map_part, OGRLayerH layer, int progress_first = 0, int progress_last = 100);
+	
+	/**
+	 * Creates the objects for a feature.
+	 * 
+	 * The coordinates of path objects are converted by convertPendingPaths().
+	 */
+	ObjectList importFeature(OGRFeatureH feature, OGRGeometryH geometry);
 	
-	void importFeature(MapPart* map_part, OGRFeatureDefnH feature_definition, OGRFeatureH feature, OGRGeometryH geometry, const Clipping* clipping);
+	/**
+	 * Tags and clips the objects of a feature, and appends them to the list
+	 * of new objects.
+	 */
+	void finishFeature(ObjectList& new_objects, OGRFeatureDefnH feature_definition, OGRFeatureH feature, ObjectList objects, const Clipping* clipping);
 	
 	
 	KeyValueContainer importFields(OGRFeatureDefnH feature_definition, OGRFeatureH feature);
@@ -299,6 +338,20 @@ protected:
 	
 	std::unique_ptr<Clipping> getLayerClipping(OGRLayerH layer);
 	
+	/**
+	 * Passes the spatial filter and the attribute filter to the layer.
+	 * 
+	 * Returns false if the layer cannot be filtered as requested.
+	 */
+	bool applyLayerFilters(OGRLayerH layer);
+	
+	/**
+	 * Converts the coordinates of all pending path objects.
+	 * 
+	 * This work is distributed over the global thread pool.
+	 */
+	void convertPendingPaths();
+	
 	
 	bool setSRS(OGRSpatialReferenceH srs);
 	
@@ -334,6 +387,20 @@ protected:
 	
 	
 private:
+	/**
+	 * A path object whose coordinates are still to be converted.
+	 */
+	struct PendingPath
+	{
+		PathObject* object;
+		OGRGeometryH geometry;                  ///< The line string or polygon
+		OGRGeometryH outline;                   ///< The line string, or the polygon's outline
+		ogr::unique_geometry managed_geometry;  ///< Owns a line string created for conversion
+		MapCoordConstructor to_map_coord;       ///< The conversion for the feature's SRS
+	};
+	
+	void convertPath(const PendingPath& path) const;
+	
 	Symbol* getSymbolForPointGeometry(const QByteArray& style_string);
 	LineSymbol* getLineSymbol(const QByteArray& style_string);
 	AreaSymbol* getAreaSymbol(const QByteArray& style_string);
@@ -366,6 +433,8 @@ private:
 	
 	ogr::unique_stylemanager manager;
 	
+	std::vector<PendingPath> pending_paths;
+	
 	int empty_geometries = 0;
 	int no_transformation = 0;
 	int failed_transformation = 0;
@@ -374,6 +443,9 @@ private:
 	
 	UnitType unit_type;
 	
+	MapCoordVectorF spatial_filter;
+	QByteArray attribute_filter;
+	
 	bool georeferencing_import_enabled = true;
 	bool clip_layers;
 };
@@ -411,6 +483,7 @@ public:
 		NeedsWgs84     = 0x02,   ///< The driver needs WGS84 geographic coordinates.
 		SingleLayer    = 0x04,   ///< The driver supports just a single layer.
 		UseLayerField  = 0x08,   ///< Write the symbol names to the layer field.
+		VectorTiles    = 0x10,   ///< The driver writes Mapbox vector tiles.
 	};
 
 	/**
@@ -418,6 +491,22 @@ public:
 	 */
 	Q_DECLARE_FLAGS(OgrQuirks, OgrQuirk)
 
+	/**
+	 * The default number of objects which are written in a single transaction.
+	 *
+	 * This can be changed via the option "Transaction size".
+	 */
+	static constexpr uint default_transaction_size = 10000;
+
+	/**
+	 * Returns the default maximum zoom level for a vector tile export.
+	 *
+	 * At this zoom level, a pixel of a 256 px tile is about 0.1 mm on the map.
+	 * The minimum zoom level defaults to six levels less. The levels can be
+	 * changed via the options "Vector tiles min zoom" and "Vector tiles max zoom".
+	 */
+	static int defaultVectorTilesMaxZoom(unsigned int scale_denominator);
+
 	OgrFileExport(const QString& path, const Map *map, const MapView *view, const char* id);
 	~OgrFileExport() override;
 
@@ -433,6 +522,24 @@ protected:
 	void addLinesToLayer(OGRLayerH layer, const std::function<bool (const Object*)>& condition);
 	void addAreasToLayer(OGRLayerH layer, const std::function<bool (const Object*)>& condition);
 
+	using GeometryList = std::vector<ogr::unique_geometry>;
+
+	/**
+	 * Adds features for the matching objects to the layer.
+	 *
+	 * The objects are processed in batches. For each batch, make_geometries
+	 * is called concurrently, creating the geometries of each object in
+	 * projected coordinates. Then each geometry is written as a feature with
+	 * the attributes set by set_attributes. Each batch is written in a single
+	 * transaction when the driver supports this.
+	 */
+	void addFeaturesToLayer(OGRLayerH layer,
+	                        const std::function<bool (const Object*)>& condition,
+	                        const std::function<GeometryList (const Object*)>& make_geometries,
+	                        const std::function<void (OGRFeatureH, const Object*)>& set_attributes);
+
+	void setSymbolField(OGRFeatureH po_feature, const Symbol* symbol) const;
+
 	OGRLayerH createLayer(const char* layer_name, OGRwkbGeometryType type);
 
 	static QByteArray symbolId(const Symbol* symbol) { return QByteArray::number(quint64(symbol), 16); }
@@ -25,19 +25,28 @@
 #include <memory>
 #include <utility>
 
+#include <cpl_string.h>
+#include <gdal.h>
+
 #include <Qt>
 #include <QtGlobal>
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDialog>
+#include <QDir>
+#include <QFileInfo>
 #include <QLatin1String>
 #include <QPainter>
 #include <QPoint>
 #include <QPointF>
 #include <QRectF>
 #include <QStringRef>
+#include <QThread>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
+#include "mapper_config.h" // IWYU pragma: keep
 #include "settings.h"
 #include "core/georeferencing.h"
 #include "core/latlon.h"
@@ -45,7 +54,9 @@
 #include "core/map_coord.h"
 #include "core/map_view.h"
 #include "core/track.h"
+#include "fileformats/binary_file_format.h"
 #include "fileformats/file_format.h"
+#include "fileformats/file_import_export.h"
 #include "gdal/gdal_file.h"
 #include "gdal/gdal_manager.h"
 #include "gdal/ogr_file_format_p.h"
@@ -53,6 +64,7 @@
 #include "templates/template.h"
 #include "templates/template_positioning_dialog.h"
 #include "templates/template_track.h"
+#include "util/disk_cache.h"
 
 
 namespace OpenOrienteering {
@@ -67,6 +79,10 @@ namespace {
 	}
 	
 	
+	/// The version of the cache entries for converted templates
+	constexpr int cache_version = 1;
+	
+	
 	bool preserveRefPoints(Georeferencing& data_georef, const Georeferencing& initial_georef)
 	{
 		// Keep a configured local reference point from initial_georef?
@@ -91,6 +107,32 @@ namespace {
 		return false;
 	}
 	
+	
+	/**
+	 * Returns the files of the vector dataset at the given path.
+	 * 
+	 * The first element is the path itself. Multi-file datasets such as
+	 * Shapefiles add their sidecar files (.dbf, .prj etc.).
+	 */
+	std::vector<QByteArray> datasetFiles(const QByteArray& path)
+	{
+		std::vector<QByteArray> files = { path };
+		GdalManager().registerDrivers();
+		if (auto* dataset = GDALOpenEx(path, GDAL_OF_VECTOR, nullptr, nullptr, nullptr))
+		{
+			auto** file_list = GDALGetFileList(dataset);
+			for (auto** file = file_list; file && *file; ++file)
+			{
+				auto const file_path = QByteArray(*file);
+				if (std::find(begin(files), end(files), file_path) == end(files))
+					files.push_back(file_path);
+			}
+			CSLDestroy(file_list);
+			GDALClose(dataset);
+		}
+		return files;
+	}
+	
 }  // namespace
 
 
@@ -342,62 +384,53 @@ catch (FileFormatException& e)
 }
 
 
+void OgrTemplate::setImportArea(const MapCoordVectorF& area)
+{
+	import_area = area;
+}
+
+void OgrTemplate::setAttributeFilter(const QString& expression)
+{
+	attribute_filter = expression;
+}
+
+
 bool OgrTemplate::loadTemplateFileImpl()
 try
 {
-	if (explicit_georef_pending)
-	{
-		// Need to create an orthographic projection during data loading.
-		explicit_georef = makeOrthographicGeoreferencing();
-		if (!explicit_georef)
-		{
-			setErrorString(tr("Invalid template configuration."));
-			return false;
-		}
-		projected_crs_spec = explicit_georef->getProjectedCRSSpec();
-		explicit_georef_pending = false;
-	}
-	
-	auto new_template_map = std::make_unique<Map>();
-	auto* view = new MapView(new_template_map.get(), new_template_map.get());
-	auto unit_type = use_real_coords ? OgrFileImport::UnitOnGround : OgrFileImport::UnitOnPaper;
-	OgrFileImport importer{template_path, new_template_map.get(), view, unit_type };
-	
-	// Configure generation of renderables.
-	updateView(*new_template_map);
-	
-	const auto& map_georef = map->getGeoreferencing();
+	if (!resolvePendingGeoreferencing())
+		return false;
 	
-	if (is_georeferenced || !explicit_georef)
+	auto data = takeMapData();
+	if (!data)
 	{
-		new_template_map->setGeoreferencing(map_georef);
+		data = std::make_shared<MapData>();
+		data->path = template_path;
+		auto const options = ogrReadOptions();
+		readOgrData(*data, options, thread());
 	}
-	else
-	{
-		new_template_map->setGeoreferencing(*explicit_georef);
-	}
-	
-	const auto pp0 = new_template_map->getGeoreferencing().getProjectedRefPoint();
-	importer.setGeoreferencingImportEnabled(false);
-	if (!importer.doImport())
+	if (!data->valid)
 	{
-		setErrorString(importer.warnings().back());
+		setErrorString(data->error);
 		return false;
 	}
 	
+	auto new_template_map = std::move(data->map);
+	auto* view = data->view;
+	
 	// MapCoord bounds handling may have moved the paper position of the
 	// template data during import. The template position might need to be
 	// adjusted accordingly.
 	// However, this will happen again the next time the template is loaded.
 	// So this adjustment must not affect the saved configuration.
-	const auto pm0 = new_template_map->getGeoreferencing().toMapCoords(pp0);
+	const auto pm0 = new_template_map->getGeoreferencing().toMapCoords(data->projected_ref_point);
 	const auto pm1 = new_template_map->getGeoreferencing().getMapRefPoint();
 	setTemplatePositionOffset(pm1 - pm0);
 	
 	setTemplateMap(std::move(new_template_map));
 	loadChildTemplatesAsync(*view);
 	
-	const auto& warnings = importer.warnings();
+	const auto& warnings = data->warnings;
 	if (!warnings.empty())
 	{
 		QString message;
@@ -420,6 +453,176 @@ catch (FileFormatException& e)
 }
 
 
+bool OgrTemplate::resolvePendingGeoreferencing()
+{
+	if (explicit_georef_pending)
+	{
+		// Need to create an orthographic projection during data loading.
+		explicit_georef = makeOrthographicGeoreferencing();
+		if (!explicit_georef)
+		{
+			setErrorString(tr("Invalid template configuration."));
+			return false;
+		}
+		projected_crs_spec = explicit_georef->getProjectedCRSSpec();
+		explicit_georef_pending = false;
+	}
+	return true;
+}
+
+OgrTemplate::OgrReadOptions OgrTemplate::ogrReadOptions() const
+{
+	OgrReadOptions options;
+	if (is_georeferenced || !explicit_georef)
+		options.georef = std::make_shared<Georeferencing>(map->getGeoreferencing());
+	else
+		options.georef = std::make_shared<Georeferencing>(*explicit_georef);
+	if (is_georeferenced)
+		options.area = import_area;
+	options.attribute_filter = attribute_filter;
+	options.real_coords = use_real_coords;
+	
+	// Configure generation of renderables.
+	GdalManager manager;
+	options.area_hatching = manager.isAreaHatchingEnabled();
+	options.baseline_view = manager.isBaselineViewEnabled();
+	return options;
+}
+
+// static
+void OgrTemplate::readOgrData(MapData& data, const OgrReadOptions& options, QThread* thread)
+try
+{
+	auto new_template_map = std::unique_ptr<Map>();
+	MapView* view = nullptr;
+	auto const make_map = [&new_template_map, &view, &options]() {
+		new_template_map = std::make_unique<Map>();
+		view = new MapView(new_template_map.get(), new_template_map.get());
+		new_template_map->setAreaHatchingEnabled(options.area_hatching);
+		new_template_map->setBaselineViewEnabled(options.baseline_view);
+		new_template_map->setGeoreferencing(*options.georef);
+	};
+	make_map();
+	data.projected_ref_point = new_template_map->getGeoreferencing().getProjectedRefPoint();
+	
+	auto const cache_path = cachePath(data.path, options);
+	if (!cache_path.isEmpty() && QFileInfo::exists(cache_path))
+	{
+		try
+		{
+			auto importer = BinaryFileFormat().makeImporter(cache_path, new_template_map.get(), view);
+			data.valid = importer->doImport() && importer->warnings().empty();
+			if (data.valid)
+				DiskCache::touch(DiskCache::VectorTemplates, cache_path);
+		}
+		catch (FileFormatException& /*e*/)
+		{
+			data.valid = false;
+		}
+		if (!data.valid)
+			make_map();  // Discard a partial cache import.
+	}
+	
+	if (!data.valid)
+	{
+		auto unit_type = options.real_coords ? OgrFileImport::UnitOnGround : OgrFileImport::UnitOnPaper;
+		OgrFileImport importer{data.path, new_template_map.get(), view, unit_type };
+		importer.setGeoreferencingImportEnabled(false);
+		importer.setSpatialFilter(options.area);
+		importer.setAttributeFilter(options.attribute_filter);
+		data.valid = importer.doImport();
+		data.warnings = importer.warnings();
+		if (!data.valid)
+			data.error = data.warnings.back();
+		
+		// Imports with warnings are not cached, so that the warnings are
+		// reported again on the next load. Child templates would need their
+		// paths to be resolved relative to the original file.
+		if (data.valid && data.warnings.empty() && !cache_path.isEmpty()
+		    && new_template_map->getNumTemplates() == 0
+		    && QDir().mkpath(QFileInfo(cache_path).absolutePath()))
+		{
+			try
+			{
+				auto exporter = BinaryFileFormat().makeExporter(cache_path, new_template_map.get(), view);
+				if (exporter->doExport())
+					DiskCache::scheduleTrim(DiskCache::VectorTemplates);
+				else
+					qDebug("Failed to store the converted template in %s", qPrintable(cache_path));
+			}
+			catch (FileFormatException& e)
+			{
+				qDebug("Failed to store the converted template in %s: %s", qPrintable(cache_path), qPrintable(e.message()));
+			}
+		}
+	}
+	
+	new_template_map->changeThreadAffinity(thread);
+	data.map = std::move(new_template_map);
+	data.view = view;
+}
+catch (FileFormatException& e)
+{
+	data.valid = false;
+	data.error = e.message();
+}
+
+// static
+QString OgrTemplate::cachePath(const QString& path, const OgrReadOptions& options)
+{
+	auto const file_info = QFileInfo(path);
+	if (!file_info.isFile())
+		return {};
+	
+	QByteArray georef_data;
+	{
+		QXmlStreamWriter xml(&georef_data);
+		options.georef->save(xml);
+	}
+	
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(QByteArray(APP_VERSION));
+	hash.addData(QByteArray::number(cache_version));
+	for (auto const& file : datasetFiles(file_info.absoluteFilePath().toUtf8()))
+	{
+		auto const info = QFileInfo(QString::fromUtf8(file));
+		hash.addData(file);
+		hash.addData(QByteArray::number(info.size()));
+		hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+	}
+	hash.addData(georef_data);
+	for (auto const& coord : options.area)
+	{
+		hash.addData(QByteArray::number(coord.x(), 'g', 17));
+		hash.addData(QByteArray::number(coord.y(), 'g', 17));
+	}
+	hash.addData(options.attribute_filter.toUtf8());
+	hash.addData(options.real_coords ? QByteArrayLiteral("real") : QByteArrayLiteral("paper"));
+	hash.addData(options.area_hatching ? QByteArrayLiteral("hatching") : QByteArrayLiteral("-"));
+	hash.addData(options.baseline_view ? QByteArrayLiteral("baseline") : QByteArrayLiteral("-"));
+	
+	return DiskCache::entryPath(DiskCache::VectorTemplates, hash.result().toHex(), QLatin1String(".omapb"));
+}
+
+std::function<void ()> OgrTemplate::makeFileReader()
+try
+{
+	if (!resolvePendingGeoreferencing())
+		return {};  // The synchronous load reports the error.
+	
+	auto data = std::make_shared<MapData>();
+	data->path = template_path;
+	map_data = data;
+	return [data, options = ogrReadOptions(), thread = thread()]() {
+		readOgrData(*data, options, thread);
+	};
+}
+catch (FileFormatException& /*e*/)
+{
+	return {};
+}
+
+
 bool OgrTemplate::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_view)
 {
 	Q_UNUSED(dialog_parent)
@@ -557,6 +760,7 @@ void OgrTemplate::updateView(Map& template_map)
 	if (dirty && templateMap() == &template_map)
 	{
 		template_map.updateAllObjects();
+		invalidateRasterCache();
 		setTemplateAreaDirty();
 	}
 }
@@ -20,6 +20,7 @@
 #ifndef OPENORIENTEERING_OGR_TEMPLATE_H
 #define OPENORIENTEERING_OGR_TEMPLATE_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -27,16 +28,20 @@
 #include <QObject>
 #include <QString>
 
+#include "core/map_coord.h"
 #include "templates/template.h"
 #include "templates/template_map.h"
 
 class QByteArray;
 class QPainter;
 class QRectF;
+class QThread;
 class QWidget;
 class QXmlStreamReader;
 class QXmlStreamWriter;
 
+class TemplateTest;
+
 namespace OpenOrienteering {
 
 class Georeferencing;
@@ -83,6 +88,23 @@ public:
 	std::unique_ptr<Georeferencing> makeGeoreferencing(const QString& spec) const;
 	
 	
+	/**
+	 * Restricts loading to the features which intersect the given area.
+	 * 
+	 * The area is a polygon in map coordinates. It is used only when the
+	 * template is georeferenced.
+	 */
+	void setImportArea(const MapCoordVectorF& area);
+	
+	/**
+	 * Restricts loading to the features which match the given expression.
+	 * 
+	 * The expression is an OGR SQL WHERE clause. An empty expression
+	 * disables the filter.
+	 */
+	void setAttributeFilter(const QString& expression);
+	
+	
 	bool preLoadSetup(QWidget* dialog_parent) override;
 	
 	/**
@@ -101,7 +123,58 @@ public:
 	 */
 	bool loadTemplateFileImpl() override;
 	
+protected:
+	/**
+	 * Returns a reader which runs the OGR import on a worker thread.
+	 * 
+	 * The georeferencing and the view settings are captured from the
+	 * main thread.
+	 */
+	std::function<void ()> makeFileReader() override;
+	
 private:
+	/**
+	 * Prepares the explicit georeferencing if it is still pending.
+	 * 
+	 * Returns false on error.
+	 */
+	bool resolvePendingGeoreferencing();
+	
+	friend class ::TemplateTest;
+	
+	/**
+	 * The parameters of an OGR import, captured on the main thread.
+	 */
+	struct OgrReadOptions
+	{
+		std::shared_ptr<const Georeferencing> georef;
+		MapCoordVectorF area;
+		QString attribute_filter;
+		bool real_coords = true;
+		bool area_hatching = false;
+		bool baseline_view = false;
+	};
+	
+	OgrReadOptions ogrReadOptions() const;
+	
+	/**
+	 * Imports the file at data.path, and moves the map to the given thread.
+	 * 
+	 * Warning-free imports are kept in the cache directory, in the binary
+	 * map format. Another import of the same file with the same options
+	 * is served from the cache, without using GDAL.
+	 */
+	static void readOgrData(MapData& data, const OgrReadOptions& options, QThread* thread);
+	
+	/**
+	 * Returns the path of the cache entry for the file and the options.
+	 * 
+	 * The entry is keyed by the paths, sizes and modification times of all
+	 * files of the dataset, the georeferencing, and the other options. It returns an empty string
+	 * when the data is not in a regular file, e.g. in a GDAL virtual file.
+	 */
+	static QString cachePath(const QString& path, const OgrReadOptions& options);
+	
 	void loadChildTemplatesAsync(MapView& view);
 	
 public:
@@ -136,6 +209,8 @@ private:
 	std::unique_ptr<Georeferencing> map_configuration_georef;
 	QString track_crs_spec;           // (limited) TemplateTrack compatibility
 	QString projected_crs_spec;       // (limited) TemplateTrack compatibility
+	MapCoordVectorF import_area;      //  transient
+	QString attribute_filter;         //  transient
 	bool template_track_compatibility { false };  //  transient
 	bool explicit_georef_pending      { false };  //  transient
 	bool use_real_coords              { true };   //  transient
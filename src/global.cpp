@@ -23,10 +23,12 @@
 
 #include "mapper_config.h" // IWYU pragma: keep
 
+#include "fileformats/binary_file_format.h"
 #include "fileformats/course_file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/xml_file_format.h"
 #include "fileformats/ocd_file_format.h"
+#include "fileformats/svg_file_format.h"
 #include "gdal/ogr_file_format.h"
 
 
@@ -37,6 +39,7 @@ void doStaticInitializations()
 	// Register the supported file formats
 	FileFormats.registerFormat(new XMLFileFormat());
 #ifndef MAPPER_BIG_ENDIAN
+	FileFormats.registerFormat(new BinaryFileFormat());
 	for (auto&& format : OcdFileFormat::makeAll())
 		FileFormats.registerFormat(format.release());
 #endif
@@ -47,6 +50,7 @@ void doStaticInitializations()
 #endif
 	for (auto&& format : CourseFileFormat::makeAll())
 		FileFormats.registerFormat(format.release());
+	FileFormats.registerFormat(new SvgFileFormat());
 }
 
 
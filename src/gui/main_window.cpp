@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013, 2014 Thomas Schöps
- *    Copyright 2012-2018 Kai Pastor
+ *    Copyright 2012-2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,9 @@
 
 #include "main_window.h"
 
+#include <functional>
+#include <utility>
+
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDialogButtonBox>
@@ -30,7 +33,9 @@
 #include <QLabel>
 #include <QMessageBox>
 #include <QMenuBar>
+#include <QMetaObject>
 #include <QPushButton>
+#include <QRunnable>
 #include <QScopedValueRollback>
 #include <QSettings>
 #include <QStackedWidget>
@@ -54,6 +59,7 @@
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
+#include "fileformats/symbol_set_cache.h"
 #include "gui/about_dialog.h"
 #include "gui/autosave_dialog.h"
 #include "gui/file_dialog.h"
@@ -76,6 +82,34 @@
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * A job which writes an autosave snapshot, and reports the result
+ * to the main window.
+ */
+class AutosaveJob : public QRunnable
+{
+public:
+	AutosaveJob(std::function<bool()> write, MainWindow* window)
+	: write(std::move(write))
+	, window(window)
+	{}
+	
+	void run() override
+	{
+		auto const success = write();
+		QMetaObject::invokeMethod(window, "autosaveWritten", Qt::QueuedConnection, Q_ARG(bool, success));
+	}
+	
+private:
+	std::function<bool()> write;
+	MainWindow* window;
+};
+
+}  // namespace
+
+
 constexpr int MainWindow::max_recent_files;
 
 int MainWindow::num_open_files = 0;
@@ -129,6 +163,7 @@ MainWindow::MainWindow(bool as_main_window, QWidget* parent, Qt::WindowFlags fla
 
 MainWindow::~MainWindow()
 {
+	autosave_worker.waitForDone();
 	if (controller)
 	{
 		controller->detach();
@@ -198,6 +233,12 @@ void MainWindow::applicationStateChanged()
 	}
 }
 
+void MainWindow::releaseMemory()
+{
+	if (controller)
+		controller->releaseMemory();
+}
+
 
 
 QString MainWindow::appName() const
@@ -840,6 +881,11 @@ void MainWindow::showNewMapWizard()
 			
 			new_map->setScaleDenominator(newMapDialog.getSelectedScale());
 		}
+		else
+		{
+			// Only the icons of the unmodified symbol set are cached.
+			SymbolSetCache(symbol_set_path).provideIcons(*new_map);
+		}
 		
 		for (int i = new_map->getNumSymbols(); i > 0; i = qMin(i, new_map->getNumSymbols()))
 		{
@@ -1101,8 +1147,9 @@ void MainWindow::setHasAutosaveConflict(bool value)
 	}
 }
 
-bool MainWindow::removeAutosaveFile() const
+bool MainWindow::removeAutosaveFile()
 {
+	autosave_worker.waitForDone();
 	if (!currentPath().isEmpty() && !has_autosave_conflict)
 	{
 		QFile autosave_file(autosavePath(currentPath()));
@@ -1119,14 +1166,22 @@ Autosave::AutosaveResult MainWindow::autosave()
 	{
 		return Autosave::PermanentFailure;
 	}
-	else if (controller->isEditingInProgress())
+	else if (controller->isEditingInProgress() || autosave_running)
 	{
 		return Autosave::TemporaryFailure;
 	}
 	else
 	{
 		showStatusBarMessageImmediately(tr("Autosaving..."), 0);
-		if (controller->exportTo(autosavePath(currentPath()), *autosave_format))
+		auto write_snapshot = controller->exportSnapshotTo(autosavePath(currentPath()), *autosave_format);
+		if (write_snapshot)
+		{
+			// Writing continues on the worker thread.
+			autosave_running = true;
+			autosave_worker.start(new AutosaveJob(std::move(write_snapshot), this));
+			return Autosave::Pending;
+		}
+		else if (controller->exportTo(autosavePath(currentPath()), *autosave_format))
 		{
 			// Success
 			clearStatusBarMessage();
@@ -1141,6 +1196,21 @@ Autosave::AutosaveResult MainWindow::autosave()
 	}
 }
 
+void MainWindow::autosaveWritten(bool success)
+{
+	autosave_running = false;
+	if (success)
+	{
+		clearStatusBarMessage();
+		autosaveFinished(Autosave::Success);
+	}
+	else
+	{
+		showStatusBarMessage(tr("Autosaving failed!"), 6000);
+		autosaveFinished(Autosave::PermanentFailure);
+	}
+}
+
 bool MainWindow::save()
 {
 	auto path = currentPath();
@@ -1437,3 +1507,26 @@ bool MainWindow::eventFilter(QObject *object, QEvent *event)
 
 
 }  // namespace OpenOrienteering
+
+
+
+#ifdef Q_OS_ANDROID
+
+/**
+ * Receives the memory trim notifications from MapperActivity.
+ * 
+ * This function is called on the Android UI thread.
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_org_openorienteering_mapper_MapperActivity_releaseMemory(JNIEnv* /*env*/, jclass /*clazz*/)
+{
+	QMetaObject::invokeMethod(qApp, []() {
+		for (auto* widget : QApplication::topLevelWidgets())
+		{
+			if (auto* window = qobject_cast<OpenOrienteering::MainWindow*>(widget))
+				window->releaseMemory();
+		}
+	}, Qt::QueuedConnection);
+}
+
+#endif
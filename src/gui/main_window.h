@@ -29,6 +29,7 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
 
 #include "core/autosave.h"
 #include "fileformats/file_format.h"
@@ -299,6 +300,13 @@ public slots:
 	 */
 	void applicationStateChanged();
 	
+	/**
+	 * Lets the controller release memory which can be restored on demand.
+	 * 
+	 * On Android, this is triggered by the activity's onTrimMemory().
+	 */
+	void releaseMemory();
+	
 	/**
 	 * Show a wizard for creating new maps.
 	 * 
@@ -448,6 +456,11 @@ protected slots:
 	 */
 	void settingsChanged();
 	
+	/**
+	 * Finishes an autosave which was written on a worker thread.
+	 */
+	void autosaveWritten(bool success);
+	
 private:
 	/**
 	 * Enables or disables the "toast" which replaces the status bar in touch mode.
@@ -478,9 +491,11 @@ protected:
 	/**
 	 * Removes the autosave file if it exists.
 	 * 
+	 * Waits for a running autosave to finish first.
+	 * 
 	 * Returns true if the file was removed or didn't exist, false otherwise.
 	 */
-	bool removeAutosaveFile() const;
+	bool removeAutosaveFile();
 	
 	bool event(QEvent* event) override;
 	void closeEvent(QCloseEvent *event) override;
@@ -550,6 +565,10 @@ private:
 	bool has_unsaved_changes;
 	/// Indicates the presence of an autosave conflict. @see setHasAutosaveConflict()
 	bool has_autosave_conflict;
+	/// Indicates that an autosave is being written by the autosave_worker.
+	bool autosave_running = false;
+	/// The thread for writing autosave snapshots.
+	QThreadPool autosave_worker;
 	
 	/// Was the window maximized before going into fullscreen mode? In this case, we have to show it maximized again when leaving fullscreen mode.
 	bool maximized_before_fullscreen;
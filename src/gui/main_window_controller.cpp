@@ -83,6 +83,11 @@ bool MainWindowController::exportTo(const QString& /*path*/, const FileFormat& /
 	return false;
 }
 
+std::function<bool()> MainWindowController::exportSnapshotTo(const QString& /*path*/, const FileFormat& /*format*/)
+{
+	return {};
+}
+
 bool MainWindowController::loadFrom(const QString& /*path*/, const FileFormat& /*format*/, QWidget* /*dialog_parent*/)
 {
 	return false;
@@ -98,6 +103,11 @@ bool MainWindowController::isEditingInProgress() const
 	return false;
 }
 
+void MainWindowController::releaseMemory()
+{
+	// nothing
+}
+
 bool MainWindowController::keyPressEventFilter(QKeyEvent* event)
 {
 	Q_UNUSED(event);
@@ -22,6 +22,8 @@
 #ifndef OPENORIENTEERING_MAIN_WINDOW_CONTROLLER_H
 #define OPENORIENTEERING_MAIN_WINDOW_CONTROLLER_H
 
+#include <functional>
+
 #include <QObject>
 #include <QString>
 
@@ -84,6 +86,17 @@ public:
 	 *  @return true if saving was successful, false on errors
 	 */
 	virtual bool exportTo(const QString& path, const FileFormat& format);
+	
+	/** Take a snapshot for exporting to a file on another thread.
+	 *  The returned function writes the snapshot, without accessing
+	 *  the document. It may be called on another thread.
+	 *  The default implementation returns an empty function.
+	 *  @param path the path to export to
+	 *  @param format the file format
+	 *  @return a function which returns true if writing was successful,
+	 *          or an empty function if no snapshot can be taken
+	 */
+	virtual std::function<bool()> exportSnapshotTo(const QString& path, const FileFormat& format);
 
 	/** Load from a file.
 	 *  @param path the path to load from
@@ -111,6 +124,14 @@ public:
 	 */
 	virtual bool isEditingInProgress() const;
 	
+	/**
+	 * Releases caches and other memory which can be restored on demand.
+	 * 
+	 * This is called when the operating system reports low memory.
+	 * The default implementation does nothing.
+	 */
+	virtual void releaseMemory();
+	
 	/**
 	 * @brief Receives key press events from the main window.
 	 * 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2021, 2024, 2025 Kai Pastor
+ *    Copyright 2012-2021, 2024-2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -27,6 +27,7 @@
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -40,9 +41,11 @@
 #include <QApplication>
 #include <QBuffer>
 #include <QByteArray>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QDate>
 #include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
 #include <QDockWidget>
 #include <QEvent>
@@ -50,6 +53,7 @@
 #include <QFlags>
 #include <QFont>
 #include <QFontMetrics>
+#include <QFormLayout>
 #include <QFrame>
 #include <QHBoxLayout>
 #include <QIcon>
@@ -74,6 +78,7 @@
 #include <QPoint>
 #include <QPointer>
 #include <QPointF>
+#include <QProgressDialog>
 #include <QRect>
 #include <QRectF>
 #include <QSettings>
@@ -99,17 +104,21 @@
 #include "core/georeferencing.h"
 #include "core/map.h"
 #include "core/map_coord.h"
+#include "core/map_memory_usage.h"
 #include "core/map_part.h"
+#include "core/map_validator.h"
 #include "core/map_view.h"
 #include "core/objects/boolean_tool.h"
 #include "core/objects/object.h"
 #include "core/objects/object_operations.h"
+#include "core/objects/object_query.h"
 #include "core/symbols/symbol.h"
 #include "core/symbols/symbol_icon_decorator.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
 #include "fileformats/simple_course_export.h"
+#include "fileformats/xml_file_format_p.h"
 #include "gui/configure_grid_dialog.h"
 #include "gui/file_dialog.h"
 #include "gui/georeferencing_dialog.h"
@@ -166,8 +175,11 @@
 #include "undo/map_part_undo.h"
 #include "undo/object_undo.h"
 #include "undo/undo.h"
+#include "undo/undo_journal.h"
 #include "undo/undo_manager.h"
 #include "util/backports.h" // IWYU pragma: keep
+#include "util/parallel.h"
+#include "util/trace.h"
 
 #ifdef MAPPER_USE_GDAL
 #include "gdal/ogr_template.h"
@@ -337,6 +349,12 @@ MapEditorController::~MapEditorController()
 	delete gps_track_recorder;
 	delete compass_display;
 	delete gps_marker_display;
+	if (journal)
+	{
+		// Regular closing means that the changes were saved or discarded.
+		map->undoManager().setJournal(nullptr);
+		journal->discard();
+	}
 	delete map;
 }
 
@@ -434,6 +452,10 @@ MapEditorTool* MapEditorController::getDefaultDrawToolForSymbol(const Symbol* sy
 
 void MapEditorController::setEditingInProgress(bool value)
 {
+	// Editing is blocked until all objects of a newly loaded map are updated.
+	if (map && map->hasDeferredObjectUpdates())
+		value = true;
+	
 	if (value != editing_in_progress)
 	{
 		editing_in_progress = value;
@@ -456,6 +478,7 @@ void MapEditorController::setEditingInProgress(bool value)
 		select_all_act->setEnabled(!editing_in_progress);
 		select_nothing_act->setEnabled(!editing_in_progress);
 		invert_selection_act->setEnabled(!editing_in_progress);
+		select_with_issues_act->setEnabled(!editing_in_progress);
 		find_feature->setEnabled(!editing_in_progress);
 		
 		// Map menu
@@ -470,6 +493,7 @@ void MapEditorController::setEditingInProgress(bool value)
 		mappart_add_act->setEnabled(!editing_in_progress);
 		mappart_rename_act->setEnabled(!editing_in_progress && num_parts > 0);
 		mappart_remove_act->setEnabled(!editing_in_progress && num_parts > 1);
+		mappart_freeze_act->setEnabled(!editing_in_progress && num_parts > 0);
 		mappart_move_menu->setEnabled(!editing_in_progress && num_parts > 1);
 		mappart_merge_act->setEnabled(!editing_in_progress && num_parts > 1);
 		mappart_merge_menu->setEnabled(!editing_in_progress && num_parts > 1);
@@ -495,6 +519,20 @@ bool MapEditorController::isEditingInProgress() const
 	return editing_in_progress;
 }
 
+void MapEditorController::releaseMemory()
+{
+	if (map_widget)
+		map_widget->releaseCaches();
+	if (map)
+	{
+		if (main_view)
+			map->releaseHiddenTemplateData(*main_view);
+		for (int i = 0; i < map->getNumSymbols(); ++i)
+			map->getSymbol(i)->resetIcon();
+		map->releaseRenderablesVariants();
+	}
+}
+
 
 void MapEditorController::setEditorActivity(MapEditorActivity* new_activity)
 {
@@ -596,6 +634,7 @@ bool MapEditorController::saveTo(const QString& path, const FileFormat& format)
 	
 	map->setHasUnsavedChanges(false);
 	map->undoManager().setClean();
+	startJournal(path, format);
 	window->showStatusBarMessage(tr("Map saved"), 1000);
 	return true;
 }
@@ -640,6 +679,19 @@ bool MapEditorController::exportTo(const QString& path, const FileFormat& format
 }
 
 
+std::function<bool()> MapEditorController::exportSnapshotTo(const QString& path, const FileFormat& format)
+{
+	if (!map || editing_in_progress || qstrcmp(format.id(), "XML") != 0)
+		return {};
+	
+	auto exporter = std::make_shared<XMLFileSnapshotExporter>(path, map, main_view);
+	if (!exporter->takeSnapshot())
+		return {};
+	
+	return [exporter]() { return exporter->writeSnapshot(); };
+}
+
+
 bool MapEditorController::loadFrom(const QString& path, const FileFormat& format, QWidget* dialog_parent)
 {
 	if (!dialog_parent)
@@ -665,14 +717,32 @@ bool MapEditorController::loadFrom(const QString& path, const FileFormat& format
 		return false;
 	}
 	
-	if (!importer->doImport())
+	// The objects are updated after the window is shown, see below.
+	importer->setObjectUpdatesDeferred(true);
+	
+	// Large imports show a modal progress dialog which allows to cancel.
+	// Setting the value of a modal progress dialog processes events.
+	QProgressDialog progress(::OpenOrienteering::MainWindow::tr("Opening %1").arg(QFileInfo(path).fileName()),
+	                         tr("Cancel"),
+	                         0, 100, dialog_parent);
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(500);
+	importer->setProgressHandler([&progress](int percent) {
+		progress.setValue(percent);
+		return !progress.wasCanceled();
+	});
+	
+	auto const imported = importer->doImport();
+	progress.reset();
+	if (!imported)
 	{
 		delete map;
 		map = nullptr;
 		main_view = nullptr;
 		
 		Q_ASSERT(!importer->warnings().empty());
-		QMessageBox::warning(dialog_parent, tr("Error"), importer->warnings().back());
+		if (!importer->isCanceled())
+			QMessageBox::warning(dialog_parent, tr("Error"), importer->warnings().back());
 		return false;
 	}
 	
@@ -687,6 +757,20 @@ bool MapEditorController::loadFrom(const QString& path, const FileFormat& format
 	});
 	setMapAndView(map, main_view);
 	map->setHasUnsavedChanges(false);
+	
+	// Generate the renderables from the event loop, starting at the center
+	// of the view, so that the window can show the map progressively.
+	// Editing is blocked until all objects are updated.
+	loading_objects = true;
+	map->updateAllObjectsDeferred(MapCoordF(main_view->center()));
+	
+	// Deal with the journal asynchronously, so that the window has taken over
+	// the map's state of unsaved changes.
+	auto const* journal_format = &format;
+	QTimer::singleShot(0, this, [this, path, journal_format]() {
+		resumeJournal(path, *journal_format, window);
+	});
+	
 	if (!importer->warnings().empty())
 	{
 		// Display warnings asynchronously, so that map and templates get visible.
@@ -845,6 +929,9 @@ void MapEditorController::attach(MainWindow* window)
 		
 		// Set the coordinates display mode
 		coordsDisplayChanged();
+		
+		if (map->hasDeferredObjectUpdates())
+			setEditingInProgress(true);
 	}
 	else
 	{
@@ -920,6 +1007,7 @@ void MapEditorController::assignKeyboardShortcuts()
 	findAction("hidealltemplates")->setShortcut(QKeySequence(Qt::Key_F10));
 	findAction("overprintsimulation")->setShortcut(QKeySequence(Qt::Key_F4));
 	findAction("fullscreen")->setShortcut(QKeySequence(Qt::Key_F11));
+	findAction("performancehud")->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_F12));
 	tags_window_act->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_6));
 	color_window_act->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_7));
 	symbol_window_act->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_8));
@@ -966,6 +1054,7 @@ void MapEditorController::createActions()
 	export_kmz_act->setVisible(false);
 #endif
 	export_simple_course_act = newAction("export-simple-course", tr("Simple &course"), this, SLOT(exportSimpleCourse()), nullptr, QString{}, "file_menu.html");
+	export_svg_act = newAction("export-svg", tr("&SVG"), this, SLOT(exportSvg()), nullptr, QString{}, "file_menu.html");
 	export_pdf_act = newAction("export-pdf", tr("&PDF"), print_act_mapper, SLOT(map()), nullptr, QString{}, "file_menu.html");
 	print_act_mapper->setMapping(export_pdf_act, PrintWidget::EXPORT_PDF_TASK);
 #ifdef MAPPER_USE_GDAL
@@ -979,6 +1068,7 @@ void MapEditorController::createActions()
 	export_image_act = nullptr;
 	export_kmz_act = nullptr;
 	export_simple_course_act = nullptr;
+	export_svg_act = nullptr;
 	export_pdf_act = nullptr;
 #endif
 	
@@ -1001,6 +1091,10 @@ void MapEditorController::createActions()
 	select_nothing_act = newAction("select-nothing", tr("Select nothing"), this, SLOT(selectNothing()), nullptr, QString{}, "edit_menu.html");
 	invert_selection_act = newAction("invert-selection", tr("Invert selection"), this, SLOT(invertSelection()), nullptr, QString{}, "edit_menu.html");
 	select_by_current_symbol_act = newAction("select-by-symbol", QApplication::translate("OpenOrienteering::SymbolRenderWidget", "Select all objects with selected symbols"), this, SLOT(selectByCurrentSymbols()), nullptr, QString{}, "edit_menu.html");
+	select_with_issues_act = newAction("select-with-issues", tr("Select objects with problems"), this, SLOT(selectObjectsWithIssues()), nullptr, tr("Find self-intersections, zero-length segments, holes outside of areas and duplicate objects"), "edit_menu.html");
+	select_inside_act = newAction("select-inside", tr("Select objects inside selected areas"), this, SLOT(selectInsideSelection()), nullptr, QString{}, "edit_menu.html");
+	select_intersecting_act = newAction("select-intersecting", tr("Select objects intersecting the selection"), this, SLOT(selectIntersectingSelection()), nullptr, QString{}, "edit_menu.html");
+	select_near_act = newAction("select-near", tr("Select objects near the selection..."), this, SLOT(selectNearSelection()), nullptr, QString{}, "edit_menu.html");
 	find_feature = std::make_unique<MapFindFeature>(*this);
 	
 	clear_undo_redo_history_act = newAction("clearundoredohistory", tr("Clear undo / redo history"), this, SLOT(clearUndoRedoHistory()), nullptr, tr("Clear the undo / redo history to reduce map file size."), "edit_menu.html");
@@ -1022,6 +1116,7 @@ void MapEditorController::createActions()
 	baseline_view_act = newCheckAction("baselineview", tr("Baseline view"), this, SLOT(baselineView(bool)), "view-baseline.png", QString{}, "view_menu.html");
 	hide_all_templates_act = newCheckAction("hidealltemplates", tr("Hide all templates"), this, SLOT(hideAllTemplates(bool)), nullptr, QString{}, "view_menu.html");
 	overprinting_simulation_act = newCheckAction("overprintsimulation", tr("Overprinting simulation"), this, SLOT(overprintingSimulation(bool)), nullptr, QString{}, "view_menu.html");
+	performance_hud_act = newCheckAction("performancehud", tr("Show performance information"), this, SLOT(showPerformanceHud(bool)), nullptr, QString{}, "view_menu.html");
 	
 	symbol_window_act = newCheckAction("symbolwindow", tr("Symbol window"), this, SLOT(showSymbolWindow(bool)), "symbols.png", tr("Show/Hide the symbol window"), "symbol_dock_widget.html");
 	color_window_act = newCheckAction("colorwindow", tr("Color window"), this, SLOT(showColorWindow(bool)), "colors.png", tr("Show/Hide the color window"), "color_dock_widget.html");
@@ -1109,6 +1204,7 @@ void MapEditorController::createActions()
 	mappart_add_act = newAction("addmappart", tr("Add new part..."), this, SLOT(addMapPart()));
 	mappart_rename_act = newAction("renamemappart", tr("Rename current part..."), this, SLOT(renameMapPart()));
 	mappart_remove_act = newAction("removemappart", tr("Remove current part"), this, SLOT(removeMapPart()));
+	mappart_freeze_act = newCheckAction("freezemappart", tr("Freeze current part"), this, SLOT(freezeMapPart(bool)));
 	mappart_merge_act = newAction("mergemapparts", tr("Merge all parts"), this, SLOT(mergeAllMapParts()));
 	
 	import_act = newAction("import", tr("Import..."), this, SLOT(importClicked()), nullptr, QString{}, "file_menu.html");
@@ -1161,6 +1257,7 @@ void MapEditorController::createMenuAndToolbars()
 	export_menu->addAction(export_pdf_act);
 	export_menu->addAction(export_kmz_act);
 	export_menu->addAction(export_simple_course_act);
+	export_menu->addAction(export_svg_act);
 	if (export_vector_act)
 		export_menu->addAction(export_vector_act);
 	file_menu->insertMenu(insertion_act, export_menu);
@@ -1183,6 +1280,10 @@ void MapEditorController::createMenuAndToolbars()
 	edit_menu->addAction(select_nothing_act);
 	edit_menu->addAction(invert_selection_act);
 	edit_menu->addAction(select_by_current_symbol_act);
+	edit_menu->addAction(select_with_issues_act);
+	edit_menu->addAction(select_inside_act);
+	edit_menu->addAction(select_intersecting_act);
+	edit_menu->addAction(select_near_act);
 	edit_menu->addSeparator();
 	edit_menu->addAction(find_feature->showDialogAction());
 	edit_menu->addAction(find_feature->findNextAction());
@@ -1214,6 +1315,7 @@ void MapEditorController::createMenuAndToolbars()
 	view_menu->addMenu(coordinates_menu);
 	view_menu->addSeparator();
 	view_menu->addAction(fullscreen_act);
+	view_menu->addAction(performance_hud_act);
 	view_menu->addSeparator();
 	toolbars_menu = view_menu->addMenu(tr("Toolbars"));
 	view_menu->addAction(tags_window_act);
@@ -1271,6 +1373,7 @@ void MapEditorController::createMenuAndToolbars()
 	map_menu->addAction(mappart_add_act);
 	map_menu->addAction(mappart_rename_act);
 	map_menu->addAction(mappart_remove_act);
+	map_menu->addAction(mappart_freeze_act);
 	map_menu->addMenu(mappart_move_menu);
 	map_menu->addMenu(mappart_merge_menu);
 	map_menu->addAction(mappart_merge_act);
@@ -1841,6 +1944,13 @@ void MapEditorController::exportSimpleCourse()
 }
 
 
+// slot
+void MapEditorController::exportSvg()
+{
+	exportVectorData(FileFormat::VectorGraphicsFile, QStringLiteral("Export/lastVectorGraphicsFormat"));
+}
+
+
 // slot
 void MapEditorController::exportVector()
 {
@@ -1926,8 +2036,8 @@ void MapEditorController::copy()
 		return;
 	
 	// Create map containing required objects and their symbol and color dependencies
-	Map copy_map;
-	copy_map.setScaleDenominator(map->getScaleDenominator());
+	auto copy_map = std::make_unique<Map>();
+	copy_map->setScaleDenominator(map->getScaleDenominator());
 	
 	std::vector<bool> symbol_filter;
 	symbol_filter.assign(map->getNumSymbols(), false);
@@ -1939,10 +2049,10 @@ void MapEditorController::copy()
 	}
 	
 	// Copy all colors. This improves preservation of relative order during paste.
-	copy_map.importMap(*map, Map::ColorImport);
+	copy_map->importMap(*map, Map::ColorImport);
 	
 	// Export symbols and colors into copy_map
-	auto symbol_map = copy_map.importMap(*map, Map::MinimalSymbolImport, &symbol_filter, -1, true);
+	auto symbol_map = copy_map->importMap(*map, Map::MinimalSymbolImport, &symbol_filter, -1, true);
 	
 	// Duplicate all selected objects into copy map
 	for (const auto* object : map->selectedObjects())
@@ -1951,21 +2061,11 @@ void MapEditorController::copy()
 		if (symbol_map.contains(new_object->getSymbol()))
 			new_object->setSymbol(symbol_map.value(new_object->getSymbol()), true);
 		
-		copy_map.addObject(new_object);
+		copy_map->addObject(new_object);
 	}
 	
-	// Save map to memory
-	QBuffer buffer;
-	if (!copy_map.exportToIODevice(buffer))
-	{
-		QMessageBox::warning(nullptr, tr("Error"), tr("An internal error occurred, sorry!"));
-		return;
-	}
-	
-	// Put buffer into clipboard
-	auto* mime_data = new QMimeData();
-	mime_data->setData(MimeType::OpenOrienteeringObjects(), buffer.data());
-	QApplication::clipboard()->setMimeData(mime_data);
+	// Put the map into the clipboard. It is serialized on demand.
+	QApplication::clipboard()->setMimeData(new MapMimeData(std::move(copy_map)));
 	
 	// Show message
 	window->showStatusBarMessage(tr("Copied %n object(s)", nullptr, map->getNumSelectedObjects()), 2000);
@@ -1976,23 +2076,34 @@ void MapEditorController::paste(int paste_at_center)
 {
 	if (editing_in_progress)
 		return;
-	if (!QApplication::clipboard()->mimeData()->hasFormat(MimeType::OpenOrienteeringObjects()))
+	auto const* mime_data = QApplication::clipboard()->mimeData();
+	if (!mime_data->hasFormat(MimeType::OpenOrienteeringObjects()))
 	{
 		QMessageBox::warning(nullptr, tr("Error"), tr("There are no objects in clipboard which could be pasted!"));
 		return;
 	}
 	
-	// Get buffer from clipboard
-	QByteArray byte_array = QApplication::clipboard()->mimeData()->data(MimeType::OpenOrienteeringObjects());
-	QBuffer buffer(&byte_array);
-	buffer.open(QIODevice::ReadOnly);
-	
-	// Create map from buffer
 	Map paste_map;
-	if (!paste_map.importFromIODevice(buffer))
+	if (auto const* map_data = qobject_cast<const MapMimeData*>(mime_data))
 	{
-		QMessageBox::warning(nullptr, tr("Error"), tr("An internal error occurred, sorry!"));
-		return;
+		// Copied in this process: Duplicate the objects without serialization.
+		auto const& copied_map = map_data->map();
+		paste_map.setScaleDenominator(copied_map.getScaleDenominator());
+		paste_map.importMap(copied_map, Map::ObjectImport);
+	}
+	else
+	{
+		// Get buffer from clipboard
+		QByteArray byte_array = mime_data->data(MimeType::OpenOrienteeringObjects());
+		QBuffer buffer(&byte_array);
+		buffer.open(QIODevice::ReadOnly);
+		
+		// Create map from buffer
+		if (!paste_map.importFromIODevice(buffer))
+		{
+			QMessageBox::warning(nullptr, tr("Error"), tr("An internal error occurred, sorry!"));
+			return;
+		}
 	}
 	
 	if (paste_at_center)
@@ -2134,13 +2245,13 @@ void MapEditorController::hatchAreas(bool checked)
 {
 	map->setAreaHatchingEnabled(checked);
 	// Update all areas
-	map->applyOnMatchingObjects(&Object::forceUpdate, ObjectOp::ContainsSymbolType{Symbol::Area});
+	map->updateObjectsForRenderableOptions(ObjectOp::ContainsSymbolType{Symbol::Area});
 }
 
 void MapEditorController::baselineView(bool checked)
 {
 	map->setBaselineViewEnabled(checked);
-	map->updateAllObjects();
+	map->updateObjectsForRenderableOptions([](const Object*) { return true; });
 }
 
 void MapEditorController::hideAllTemplates(bool checked)
@@ -2158,6 +2269,11 @@ void MapEditorController::overprintingSimulation(bool checked)
 	main_view->setOverprintingSimulationEnabled(checked);
 }
 
+void MapEditorController::showPerformanceHud(bool checked)
+{
+	map_widget->setPerformanceHudVisible(checked);
+}
+
 void MapEditorController::coordsDisplayChanged()
 {
 	if (geographic_coordinates_dms_act->isChecked())
@@ -2620,6 +2736,9 @@ void MapEditorController::updateObjectDependentActions()
 	}
 	
 	// have_selection
+	select_inside_act->setEnabled(have_area);
+	select_intersecting_act->setEnabled(have_selection);
+	select_near_act->setEnabled(have_selection);
 	cut_act->setEnabled(have_selection);
 	copy_act->setEnabled(have_selection);
 	delete_act->setEnabled(have_selection);
@@ -2714,6 +2833,14 @@ void MapEditorController::undoStepAvailabilityChanged()
 	undo_act->setEnabled(map->undoManager().canUndo());
 	redo_act->setEnabled(map->undoManager().canRedo());
 	clear_undo_redo_history_act->setEnabled(undo_act->isEnabled() || redo_act->isEnabled());
+	
+	auto const usage_mib = map->undoManager().memoryUsage() / double(1 << 20);
+	clear_undo_redo_history_act->setStatusTip(tr("Clear the undo / redo history to reduce map file size.")
+	                                          + QLatin1Char(' ')
+	                                          + tr("The history currently uses %1 MiB of memory.").arg(QLocale().toString(usage_mib, 'f', 1)));
+	
+	if (Trace::isRecording())
+		MapMemoryUsage(*map).trace();
 }
 
 void MapEditorController::clipboardChanged(QClipboard::Mode mode)
@@ -3007,18 +3134,17 @@ void MapEditorController::selectObjectsClicked(bool select_exclusively)
 		map->clearObjectSelection(false);
 	}
 
-	bool object_selected = false;	
+	std::vector<Object*> objects;
 	MapPart* part = map->getCurrentPart();
 	for (int i = 0, size = part->getNumObjects(); i < size; ++i)
 	{
 		Object* object = part->getObject(i);
 		if (symbol_widget->isSymbolSelected(object->getSymbol()) && !(!select_exclusively && map->isObjectSelected(object)))
-		{
-			map->addObjectToSelection(object, false);
-			object_selected = true;
-		}
+			objects.push_back(object);
 	}
+	map->addObjectsToSelection(objects, false);
 	
+	bool const object_selected = !objects.empty();
 	selection_changed |= object_selected;
 	if (selection_changed)
 		map->emitSelectionChanged();
@@ -3062,9 +3188,13 @@ void MapEditorController::selectAll()
 {
 	auto num_selected_objects = map->getNumSelectedObjects();
 	map->clearObjectSelection(false);
-	map->getCurrentPart()->applyOnAllObjects([this](Object* object) {
-		map->addObjectToSelection(object, false);
+	auto* part = map->getCurrentPart();
+	std::vector<Object*> objects;
+	objects.reserve(std::size_t(part->getNumObjects()));
+	part->applyOnAllObjects([&objects](Object* object) {
+		objects.push_back(object);
 	});
+	map->addObjectsToSelection(objects, false);
 	
 	if (map->getNumSelectedObjects() != num_selected_objects)
 	{
@@ -3084,10 +3214,12 @@ void MapEditorController::invertSelection()
 {
 	auto selection = Map::ObjectSelection{ map->selectedObjects() };
 	map->clearObjectSelection(false);
-	map->getCurrentPart()->applyOnAllObjects([this, &selection](Object* object) {
+	std::vector<Object*> objects;
+	map->getCurrentPart()->applyOnAllObjects([&objects, &selection](Object* object) {
 		if (selection.find(object) == end(selection))
-			map->addObjectToSelection(object, false);
+			objects.push_back(object);
 	});
+	map->addObjectsToSelection(objects, false);
 	
 	if (map->getCurrentPart()->getNumObjects() > 0)
 	{
@@ -3102,6 +3234,88 @@ void MapEditorController::selectByCurrentSymbols()
 	selectObjectsClicked(true);
 }
 
+void MapEditorController::selectObjectsWithIssues()
+{
+	if (!map_validator)
+	{
+		map_validator = std::make_unique<MapValidator>(*map);
+		connect(map_validator.get(), &MapValidator::progressChanged, this, &MapEditorController::mapValidationProgress);
+		map_validator->start();
+	}
+	if (map_validator->isRunning())
+	{
+		select_objects_with_issues = true;
+		return;
+	}
+	
+	select_objects_with_issues = false;
+	auto* part = map->getCurrentPart();
+	auto objects = map_validator->objectsWithIssues();
+	objects.erase(std::remove_if(begin(objects), end(objects), [part](const Object* object) {
+		return !part->contains(object);
+	}), end(objects));
+	
+	map->clearObjectSelection(false);
+	map->addObjectsToSelection(objects, false);
+	map->emitSelectionChanged();
+	if (!objects.empty() && current_tool && current_tool->isDrawTool())
+		setEditTool();
+	window->showStatusBarMessage(tr("%n object(s) with problems", nullptr, int(objects.size())), 2000);
+}
+
+void MapEditorController::selectInsideSelection()
+{
+	auto const reference = std::vector<const Object*>(begin(map->selectedObjects()), end(map->selectedObjects()));
+	selectBySpatialQuery(ObjectQuery(ObjectQuery::OperatorInside, reference));
+}
+
+void MapEditorController::selectIntersectingSelection()
+{
+	auto const reference = std::vector<const Object*>(begin(map->selectedObjects()), end(map->selectedObjects()));
+	selectBySpatialQuery(ObjectQuery(ObjectQuery::OperatorIntersects, reference));
+}
+
+void MapEditorController::selectNearSelection()
+{
+	bool ok = false;
+	auto const distance_m = QInputDialog::getDouble(window, tr("Select objects near the selection"), tr("Distance in meters:"), 10, 0, 100000, 1, &ok);
+	if (!ok)
+		return;
+	
+	auto const distance_mm = distance_m * 1000 / map->getScaleDenominator();
+	auto const reference = std::vector<const Object*>(begin(map->selectedObjects()), end(map->selectedObjects()));
+	selectBySpatialQuery(ObjectQuery(ObjectQuery::OperatorWithinDistance, reference, distance_mm));
+}
+
+void MapEditorController::selectBySpatialQuery(const ObjectQuery& query)
+{
+	auto const selection = Map::ObjectSelection{ map->selectedObjects() };
+	auto objects = ObjectQueryProgram(query).findMatchingObjects(*map->getCurrentPart());
+	objects.erase(std::remove_if(begin(objects), end(objects), [&selection](Object* object) {
+		return selection.find(object) != end(selection);
+	}), end(objects));
+	
+	map->clearObjectSelection(false);
+	map->addObjectsToSelection(objects, false);
+	map->emitSelectionChanged();
+	if (!objects.empty() && current_tool && current_tool->isDrawTool())
+		setEditTool();
+	window->showStatusBarMessage(tr("%n object(s) selected", nullptr, int(objects.size())), 2000);
+}
+
+void MapEditorController::mapValidationProgress(int percent)
+{
+	if (!select_objects_with_issues)
+		return;
+	
+	if (percent < 100)
+		window->showStatusBarMessage(tr("Checking objects... %1%").arg(percent));
+	else if (editing_in_progress)
+		select_objects_with_issues = false;
+	else
+		selectObjectsWithIssues();
+}
+
 void MapEditorController::switchDashesClicked()
 {
 	auto* undo_step = new SwitchDashesUndoStep(map);
@@ -3540,25 +3754,63 @@ void MapEditorController::simplifyPathClicked()
 	// TODO: make threshold configurable!
 	const auto threshold = 0.1;
 	
-	auto* undo_step = new ReplaceObjectsUndoStep(map);
+	// Collecting the paths in part order provides their indices for undo.
 	MapPart* part = map->getCurrentPart();
+	std::vector<PathObject*> paths;
+	std::vector<int> indices;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto* object = part->getObject(i);
+		if (object->getType() == Object::Path && map->isObjectSelected(object))
+		{
+			paths.push_back(object->asPath());
+			indices.push_back(i);
+		}
+	}
 	
-	for (auto* object : map->selectedObjects())
+	auto const has_curves = [](const PathObject* path) {
+		auto const& coords = path->getRawCoordinateVector();
+		return std::any_of(begin(coords), end(coords), [](const MapCoord& coord) { return coord.isCurveStart(); });
+	};
+	
+	// Polygonal paths, e.g. from imported data, are simplified concurrently.
+	// The work is done on copies which are not part of the map.
+	std::vector<std::unique_ptr<PathObject>> simplified(paths.size());
+	Util::parallelFor(paths.size(), 16, [&](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+		{
+			if (has_curves(paths[i]))
+				continue;
+			auto copy = std::make_unique<PathObject>(*paths[i]);
+			if (copy->simplifyPolygonal(threshold))
+				simplified[i] = std::move(copy);
+		}
+	});
+	
+	auto* undo_step = new ReplaceObjectsUndoStep(map);
+	std::vector<const Object*> modified;
+	for (std::size_t i = 0; i < paths.size(); ++i)
 	{
-		if (object->getType() != Object::Path)
-			continue;
-		
-		PathObject* path = object->asPath();
+		PathObject* path = paths[i];
 		PathObject* undo_duplicate = nullptr;
-		if (path->simplify(&undo_duplicate, threshold))
-			undo_step->addObject(part->findObjectIndex(path), undo_duplicate);
-		path->update();
+		if (simplified[i])
+		{
+			undo_duplicate = path->duplicate();
+			path->copyFrom(*simplified[i]);
+		}
+		else if (!has_curves(path) || !path->simplify(&undo_duplicate, threshold))
+		{
+			continue;
+		}
+		undo_step->addObject(indices[i], undo_duplicate);
+		modified.push_back(path);
 	}
 	
 	if (undo_step->isEmpty())
 		delete undo_step;
 	else
 	{
+		Object::updateAll(modified);
 		map->setObjectsDirty();
 		map->push(undo_step);
 		map->emitSelectionEdited();
@@ -3892,6 +4144,10 @@ void MapEditorController::updateMapPartsUI()
 		mappart_remove_act->setEnabled(have_multiple_parts);
 		mappart_merge_act->setEnabled(have_multiple_parts);
 	}
+	if (mappart_freeze_act)
+	{
+		mappart_freeze_act->setChecked(count > 0 && map->getCurrentPart()->isFrozen());
+	}
 	if (toolbar_mapparts && !toolbar_mapparts->isVisible())
 	{
 		toolbar_mapparts->setVisible(have_multiple_parts);
@@ -4000,6 +4256,13 @@ void MapEditorController::renameMapPart()
 	}
 }
 
+void MapEditorController::freezeMapPart(bool frozen)
+{
+	map->setPartFrozen(map->getCurrentPartIndex(), frozen);
+	if (frozen)
+		window->showStatusBarMessage(tr("Map part '%1' is frozen. Its objects cannot be selected.").arg(map->getCurrentPart()->getName()), 2000);
+}
+
 void MapEditorController::changeMapPart(int index)
 {
 	if (index >= 0)
@@ -4109,6 +4372,68 @@ void MapEditorController::templateDeleted(int /*pos*/, const Template* /*temp*/)
 		templateAvailabilityChanged();
 }
 
+void MapEditorController::startJournal(const QString& path, const FileFormat& format)
+{
+	map->undoManager().setJournal(nullptr);
+	if (journal)
+		journal->discard();
+	
+	if (Settings::getInstance().getSetting(Settings::General_SaveJournal).toBool()
+	    && !format.isWritingLossy())
+	{
+		if (!journal)
+			journal = std::make_unique<UndoJournal>(map);
+		if (journal->start(path))
+		{
+			map->undoManager().setJournal(journal.get());
+			return;
+		}
+	}
+	journal.reset();
+}
+
+void MapEditorController::resumeJournal(const QString& path, const FileFormat& format, QWidget* dialog_parent)
+{
+	map->undoManager().setJournal(nullptr);
+	journal.reset();
+	
+	if (!Settings::getInstance().getSetting(Settings::General_SaveJournal).toBool()
+	    || format.isReadingLossy())
+	{
+		return;
+	}
+	
+	journal = std::make_unique<UndoJournal>(map);
+	if (UndoJournal::hasChanges(path)
+	    && QMessageBox::question(dialog_parent, tr("Recovery"),
+	                             tr("The file has changes which were recorded in the journal, but not saved. "
+	                                "Do you want to restore these changes?"),
+	                             QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+	{
+		map->finishDeferredObjectUpdates();
+		auto const num_changes = journal->resume(path);
+		if (num_changes > 0)
+		{
+			// The undo history does not match the replayed changes.
+			// After clearing, the undo manager's clean state must not
+			// reset the map's unsaved changes.
+			map->undoManager().clear();
+			map->setOtherDirty();
+		}
+		if (journal->isRecording())
+		{
+			map->undoManager().setJournal(journal.get());
+			return;
+		}
+	}
+	
+	if (journal->start(path))
+		map->undoManager().setJournal(journal.get());
+	else
+		journal.reset();
+}
+
+
 void MapEditorController::setMapAndView(Map* map, MapView* map_view)
 {
 	Q_ASSERT(map);
@@ -4132,6 +4457,7 @@ void MapEditorController::setMapAndView(Map* map, MapView* map_view)
 	
 	connect(&map->undoManager(), &UndoManager::canRedoChanged, this, &MapEditorController::undoStepAvailabilityChanged);
 	connect(&map->undoManager(), &UndoManager::canUndoChanged, this, &MapEditorController::undoStepAvailabilityChanged);
+	connect(&map->undoManager(), &UndoManager::memoryUsageChanged, this, &MapEditorController::undoStepAvailabilityChanged);
 	connect(map, &Map::objectSelectionChanged, this, &MapEditorController::objectSelectionChanged);
 	connect(map, &Map::templateAdded, this, &MapEditorController::templateAdded);
 	connect(map, &Map::templateDeleted, this, &MapEditorController::templateDeleted);
@@ -4142,6 +4468,14 @@ void MapEditorController::setMapAndView(Map* map, MapView* map_view)
 	connect(map, &Map::mapPartChanged, this, &MapEditorController::updateMapPartsUI);
 	connect(map, &Map::mapPartDeleted, this, &MapEditorController::updateMapPartsUI);
 	
+	if (mode == MapEditor)
+	{
+		// Rescaling and rotating the map update the objects progressively, too.
+		map->setObjectUpdatesDeferred(true);
+		connect(map, &Map::deferredObjectUpdatesProgress, this, &MapEditorController::objectLoadingProgress);
+		connect(map, &Map::deferredObjectUpdatesFinished, this, &MapEditorController::objectLoadingFinished);
+	}
+	
 	if (symbol_widget)
 	{
 		delete symbol_widget;
@@ -4155,6 +4489,31 @@ void MapEditorController::setMapAndView(Map* map, MapView* map_view)
 	}
 }
 
+void MapEditorController::objectLoadingProgress(int done, int total)
+{
+	if (!editing_in_progress)
+		setEditingInProgress(true);
+	
+	if (window && total > 0)
+	{
+		auto const percent = qint64(done) * 100 / total;
+		if (loading_objects)
+			window->showStatusBarMessage(tr("Loading objects... %1%").arg(percent));
+		else
+			window->showStatusBarMessage(tr("Updating objects... %1%").arg(percent));
+	}
+}
+
+void MapEditorController::objectLoadingFinished()
+{
+	loading_objects = false;
+	if (!window || mode != MapEditor)
+		return;
+	
+	window->clearStatusBarMessage();
+	setEditingInProgress(current_tool && current_tool->editingInProgress());
+}
+
 void MapEditorController::updateWidgets()
 {
 	undoStepAvailabilityChanged();
@@ -4305,6 +4664,40 @@ bool MapEditorController::importOgrFile(const QString& filename)
 {
 #if MAPPER_USE_GDAL
 	OgrTemplate ogr_template {filename, map};
+	
+	// A single selected area may limit the import to the features inside.
+	MapCoordVectorF area;
+	if (map->getNumSelectedObjects() == 1 && map->getFirstSelectedObject()->getType() == Object::Path)
+	{
+		auto const* path = map->getFirstSelectedObject()->asPath();
+		if (path->parts().size() == 1 && path->parts().front().isClosed())
+		{
+			for (auto const& path_coord : path->parts().front().path_coords)
+				area.push_back(path_coord.pos);
+		}
+	}
+	
+	QDialog options_dialog(window);
+	options_dialog.setWindowTitle(tr("Import %1").arg(QFileInfo(filename).fileName()));
+	auto* area_check = new QCheckBox(tr("Only features inside the selected area"));
+	area_check->setEnabled(!area.empty());
+	area_check->setChecked(false);
+	auto* attribute_edit = new QLineEdit();
+	attribute_edit->setPlaceholderText(tr("e.g. %1").arg(QStringLiteral("highway = 'track'")));
+	auto* button_box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	connect(button_box, &QDialogButtonBox::accepted, &options_dialog, &QDialog::accept);
+	connect(button_box, &QDialogButtonBox::rejected, &options_dialog, &QDialog::reject);
+	auto* options_layout = new QFormLayout(&options_dialog);
+	options_layout->addRow(area_check);
+	options_layout->addRow(tr("Attribute filter:"), attribute_edit);
+	options_layout->addRow(button_box);
+	if (options_dialog.exec() == QDialog::Rejected)
+		return false;
+	
+	if (area_check->isChecked())
+		ogr_template.setImportArea(area);
+	ogr_template.setAttributeFilter(attribute_edit->text().trimmed());
+	
 	if (!ogr_template.setupAndLoad(window, main_view))
 		return false;
 	
@@ -4496,4 +4889,42 @@ void MapEditorToolAction::triggeredImpl(bool checked)
 }
 
 
+
+// ### MapMimeData ###
+
+MapMimeData::MapMimeData(std::unique_ptr<Map> map)
+ : copied_map(std::move(map))
+{
+	// nothing else
+}
+
+MapMimeData::~MapMimeData() = default;
+
+bool MapMimeData::hasFormat(const QString& mimetype) const
+{
+	return mimetype == MimeType::OpenOrienteeringObjects();
+}
+
+QStringList MapMimeData::formats() const
+{
+	return { MimeType::OpenOrienteeringObjects() };
+}
+
+QVariant MapMimeData::retrieveData(const QString& mimetype, QVariant::Type preferred_type) const
+{
+	Q_UNUSED(preferred_type)
+	if (!hasFormat(mimetype))
+		return {};
+	
+	if (xml_data.isEmpty())
+	{
+		QBuffer buffer;
+		if (!copied_map->exportToIODevice(buffer))
+			return {};
+		xml_data = buffer.data();
+	}
+	return xml_data;
+}
+
+
 }  // namespace OpenOrienteering
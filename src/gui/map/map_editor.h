@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013, 2014 Thomas Schöps
- *    Copyright 2013-2025 Kai Pastor
+ *    Copyright 2013-2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,7 @@
 #ifndef OPENORIENTEERING_MAP_EDITOR_H
 #define OPENORIENTEERING_MAP_EDITOR_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -65,8 +66,10 @@ class MapCoordF;
 class MapEditorActivity;
 class MapEditorTool;
 class MapFindFeature;
+class MapValidator;
 class MapView;
 class MapWidget;
+class ObjectQuery;
 class PaintOnTemplateFeature;
 class PrintWidget;
 class ReopenTemplateDialog;
@@ -75,6 +78,7 @@ class SymbolReportFeature;
 class SymbolWidget;
 class Template;
 class TemplateListWidget;
+class UndoJournal;
 
 
 /**
@@ -182,6 +186,12 @@ public:
 	 */
 	bool isEditingInProgress() const override;
 	
+	/**
+	 * Drops the map widget caches, the data of hidden templates, and the
+	 * symbol icons.
+	 */
+	void releaseMemory() override;
+	
 	/**
 	 * Adds a floating dock widget to the main window.
 	 * Adjusts some geometric properties.
@@ -236,6 +246,12 @@ public:
 	bool saveTo(const QString& path, const FileFormat& format) override;
 	/** Override from MainWindowController */
 	bool exportTo(const QString& path, const FileFormat& format) override;
+	/**
+	 * Override from MainWindowController
+	 * 
+	 * Snapshots are supported for the XML file format.
+	 */
+	std::function<bool()> exportSnapshotTo(const QString& path, const FileFormat& format) override;
 	/** Override from MainWindowController */
 	bool loadFrom(const QString& path, const FileFormat& format, QWidget* dialog_parent = nullptr) override;
 	
@@ -269,6 +285,11 @@ public slots:
 	 */
 	void exportSimpleCourse();
 	
+	/**
+	 * Lets the user export the map as scalable vector graphics.
+	 */
+	void exportSvg();
+	
 	/**
 	 * Lets the user export the map as geospatial vector data.
 	 */
@@ -323,6 +344,8 @@ public slots:
 	void hideAllTemplates(bool checked);
 	/** Sets the overprinting simulation view option. */
 	void overprintingSimulation(bool checked);
+	/** Shows or hides the performance overlay of the map widget. */
+	void showPerformanceHud(bool checked);
 	
 	/** Adjusts the coordinates display of the map widget to the selected option. */
 	void coordsDisplayChanged();
@@ -436,6 +459,21 @@ public slots:
 	void invertSelection();
 	/** Selects all objects having the current selected symbols. */
 	void selectByCurrentSymbols();
+	/**
+	 * Selects the objects in the current map part which have problems.
+	 * 
+	 * The map is validated on first use. Afterwards, the validation follows
+	 * the changes of the objects.
+	 */
+	void selectObjectsWithIssues();
+	/** Reports the progress of the map validation. */
+	void mapValidationProgress(int percent);
+	/** Selects the objects which are inside the selected area objects. */
+	void selectInsideSelection();
+	/** Selects the objects which intersect or touch the selected objects. */
+	void selectIntersectingSelection();
+	/** Asks for a distance, and selects the objects near the selected objects. */
+	void selectNearSelection();
 	
 	/**
 	 * Reverses the selected object(s) direcction(s),
@@ -519,6 +557,8 @@ public slots:
 	void removeMapPart();
 	/** Renames the current map part */
 	void renameMapPart();
+	/** Freezes or unfreezes the current map part */
+	void freezeMapPart(bool frozen);
 	/** Moves all selected objects to a different map part */
 	void reassignObjectsToMapPart(int target);
 	/** Merges the current map part with another one */
@@ -656,9 +696,38 @@ protected slots:
 	 */
 	void updateMapPartsUI();
 	
+	/**
+	 * Shows the progress of updating the objects of a newly loaded,
+	 * rescaled or rotated map, and blocks editing meanwhile.
+	 */
+	void objectLoadingProgress(int done, int total);
+	
+	/**
+	 * Enables editing when the deferred object updates are finished.
+	 */
+	void objectLoadingFinished();
+	
 private:
 	void setMapAndView(Map* map, MapView* map_view);
 	
+	/**
+	 * Replaces the selection by the other objects of the current map part
+	 * which match the given spatial query.
+	 */
+	void selectBySpatialQuery(const ObjectQuery& query);
+	
+	/**
+	 * Starts a new journal for the file which the map was just saved to,
+	 * if enabled in the settings.
+	 */
+	void startJournal(const QString& path, const FileFormat& format);
+	
+	/**
+	 * Offers to replay the journal for the file which the map was just
+	 * loaded from, and continues recording if enabled in the settings.
+	 */
+	void resumeJournal(const QString& path, const FileFormat& format, QWidget* dialog_parent);
+	
 	/// Updates enabled state of all widgets
 	void updateWidgets();
 	
@@ -696,6 +765,7 @@ private:
 	Symbol* active_symbol;
 	
 	bool editing_in_progress;
+	bool loading_objects = false;
 	
 	// Action handling
 	QHash<QByteArray, QAction*> actionsById;
@@ -707,6 +777,7 @@ private:
 	QAction* export_image_act = {};
 	QAction* export_kmz_act = {};
 	QAction* export_simple_course_act = {};
+	QAction* export_svg_act = {};
 	QAction* export_pdf_act = {};
 	QAction* export_vector_act = {};
 	
@@ -721,6 +792,12 @@ private:
 	QAction* select_nothing_act = {};
 	QAction* invert_selection_act = {};
 	QAction* select_by_current_symbol_act = {};
+	QAction* select_with_issues_act = {};
+	QAction* select_inside_act = {};
+	QAction* select_intersecting_act = {};
+	QAction* select_near_act = {};
+	std::unique_ptr<MapValidator> map_validator;
+	bool select_objects_with_issues = false;
 	std::unique_ptr<MapFindFeature> find_feature;
 	QAction* clear_undo_redo_history_act = {};
 	
@@ -739,6 +816,7 @@ private:
 	QAction* baseline_view_act = {};
 	QAction* hide_all_templates_act = {};
 	QAction* overprinting_simulation_act = {};
+	QAction* performance_hud_act = {};
 	
 	QAction* map_coordinates_act = {};
 	QAction* projected_coordinates_act = {};
@@ -813,6 +891,8 @@ private:
 	
 	std::unique_ptr<PaintOnTemplateFeature> paint_feature;
 	
+	std::unique_ptr<UndoJournal> journal;
+	
 	QAction* touch_cursor_action = {};
 	QAction* gps_display_action = {};
 	QAction* gps_distance_rings_action = {};
@@ -831,6 +911,7 @@ private:
 	QAction* mappart_add_act = {};
 	QAction* mappart_rename_act = {};
 	QAction* mappart_remove_act = {};
+	QAction* mappart_freeze_act = {};
 	QAction* mappart_merge_act = {};
 	QMenu* mappart_merge_menu;
 	QMenu* mappart_move_menu;
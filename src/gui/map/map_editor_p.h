@@ -22,8 +22,14 @@
 #ifndef OPENORIENTEERING_MAP_EDITOR_P_H
 #define OPENORIENTEERING_MAP_EDITOR_P_H
 
+#include <memory>
+
 #include <QAction>
+#include <QByteArray>
 #include <QDockWidget>
+#include <QMimeData>
+#include <QStringList>
+#include <QVariant>
 
 class QEvent;
 class QIcon;
@@ -35,6 +41,7 @@ class QWidget;
 
 namespace OpenOrienteering {
 
+class Map;
 class MapEditorController;
 class Template;
 
@@ -82,6 +89,37 @@ private slots:
 };
 
 
+
+/**
+ * Clipboard data for objects which are copied from a map editor.
+ * 
+ * The data keeps the copied objects, together with their symbols and colors,
+ * in a map of its own. Pasting in the same process duplicates the objects
+ * from this map directly. The XML data for other processes is generated only
+ * when it is requested.
+ */
+class MapMimeData : public QMimeData
+{
+Q_OBJECT
+public:
+	explicit MapMimeData(std::unique_ptr<Map> map);
+	~MapMimeData() override;
+	
+	/** Returns the map with the copied objects. */
+	const Map& map() const { return *copied_map; }
+	
+	bool hasFormat(const QString& mimetype) const override;
+	QStringList formats() const override;
+	
+protected:
+	QVariant retrieveData(const QString& mimetype, QVariant::Type preferred_type) const override;
+	
+private:
+	std::unique_ptr<Map> copied_map;
+	mutable QByteArray xml_data;
+};
+
+
 }  // namespace OpenOrienteering
 
 #endif
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2017-2020, 2024, 2025 Kai Pastor
+ *    Copyright 2017-2020, 2024-2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -20,7 +20,9 @@
 
 #include "map_find_feature.h"
 
-#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
 
 #include <QAbstractButton>
 #include <QAction>
@@ -28,6 +30,7 @@
 #include <QDialogButtonBox>
 #include <QGridLayout>
 #include <QKeySequence>  // IWYU pragma: keep
+#include <QMetaObject>
 #include <QPushButton>
 #include <QStackedLayout>
 #include <QTextEdit>
@@ -48,6 +51,9 @@ namespace OpenOrienteering {
 
 namespace {
 
+/// The number of objects which are tested before returning to the event loop
+constexpr std::size_t search_batch_size = 1024;
+
 // Returns true if an object can be added to the selection.
 bool isSelectable(const Object* object)
 {
@@ -112,6 +118,7 @@ void MapFindFeature::showDialog()
 		
 		text_edit = new QTextEdit;
 		text_edit->setLineWrapMode(QTextEdit::WidgetWidth);
+		connect(text_edit, &QTextEdit::textChanged, this, &MapFindFeature::startSearch);
 		
 		tag_selector = new TagSelectWidget;
 		
@@ -155,7 +162,7 @@ void MapFindFeature::showDialog()
 
 
 
-ObjectQuery MapFindFeature::makeQuery() const
+ObjectQuery MapFindFeature::currentQuery() const
 {
 	auto query = ObjectQuery{};
 	if (find_dialog)
@@ -178,6 +185,13 @@ ObjectQuery MapFindFeature::makeQuery() const
 			query = tag_selector->makeQuery();
 		}
 	}
+	return query;
+}
+
+
+ObjectQuery MapFindFeature::makeQuery() const
+{
+	auto query = currentQuery();
 	if (!query)
 	{
 		controller.getMap()->clearObjectSelection(true);
@@ -187,8 +201,93 @@ ObjectQuery MapFindFeature::makeQuery() const
 }
 
 
+void MapFindFeature::startSearch()
+{
+	cancelSearch();
+	if (!find_dialog || !find_dialog->isVisible() || editor_stack->currentIndex() != 0)
+		return;
+	
+	// Incomplete input must not clear the selection.
+	auto const query = currentQuery();
+	if (!query)
+		return;
+	
+	auto* map = controller.getMap();
+	auto* part = map->getCurrentPart();
+	search_program.reset(new ObjectQueryProgram(query));
+	if (!search_program->findCandidateObjects(*part, search_objects))
+	{
+		search_objects.reserve(std::size_t(part->getNumObjects()));
+		for (int i = 0; i < part->getNumObjects(); ++i)
+			search_objects.push_back(part->getObject(i));
+	}
+	search_part = part;
+	
+	map->clearObjectSelection(true);
+	scheduleSearchBatch();
+}
+
+
+void MapFindFeature::cancelSearch()
+{
+	// A scheduled batch finds no search program.
+	search_program.reset();
+	search_part = nullptr;
+	search_objects.clear();
+	search_next = 0;
+}
+
+
+void MapFindFeature::scheduleSearchBatch()
+{
+	if (!search_scheduled)
+	{
+		search_scheduled = true;
+		QMetaObject::invokeMethod(this, "searchNextBatch", Qt::QueuedConnection);
+	}
+}
+
+
+void MapFindFeature::searchNextBatch()
+{
+	search_scheduled = false;
+	if (!search_program)
+		return;
+	
+	auto* map = controller.getMap();
+	if (!find_dialog || !find_dialog->isVisible() || map->getCurrentPart() != search_part)
+	{
+		cancelSearch();
+		return;
+	}
+	
+	// Objects may have been deleted since the search was started.
+	std::vector<Object*> matches;
+	auto const batch_end = std::min(search_objects.size(), search_next + search_batch_size);
+	for (; search_next < batch_end; ++search_next)
+	{
+		auto* object = search_objects[search_next];
+		if (search_part->contains(object) && (*search_program)(object))
+			matches.push_back(object);
+	}
+	if (!matches.empty())
+		map->addObjectsToSelection(matches, true);
+	
+	if (search_next < search_objects.size())
+	{
+		scheduleSearchBatch();
+	}
+	else
+	{
+		cancelSearch();
+		controller.getWindow()->showStatusBarMessage(OpenOrienteering::TagSelectWidget::tr("%n object(s) selected", nullptr, map->getNumSelectedObjects()), 2000);
+	}
+}
+
+
 void MapFindFeature::findNext()
 {
+	cancelSearch();
 	if (auto query = makeQuery())
 		findNextMatchingObject(controller, query);
 }
@@ -203,6 +302,7 @@ void MapFindFeature::findNextMatchingObject(MapEditorController& controller, con
 	Object* next_match = nullptr;   // the next match after pivot_object
 	map->clearObjectSelection(false);
 	
+	ObjectQueryProgram const program(query);
 	auto search = [&](Object* object) {
 		if (next_match)
 			return;
@@ -211,7 +311,7 @@ void MapFindFeature::findNextMatchingObject(MapEditorController& controller, con
 		if (object == pivot_object)
 			pivot_object = nullptr;
 		
-		if (isSelectable(object) && query(object))
+		if (isSelectable(object) && program(object))
 		{
 			if (after_pivot)
 				next_match = object;
@@ -236,6 +336,7 @@ void MapFindFeature::findNextMatchingObject(MapEditorController& controller, con
 
 void MapFindFeature::findAll()
 {
+	cancelSearch();
 	if (auto query = makeQuery())
 		findAllMatchingObjects(controller, query);
 }
@@ -246,10 +347,10 @@ void MapFindFeature::findAllMatchingObjects(MapEditorController& controller, con
 	auto map = controller.getMap();
 	map->clearObjectSelection(false);
 	
-	map->getCurrentPart()->applyOnMatchingObjects([map](Object* object) {
-		if (isSelectable(object))
-			map->addObjectToSelection(object, false);
-	}, std::cref(query));
+	// Reverse order, so that the last match remains the first selected object.
+	auto matches = ObjectQueryProgram(query).findMatchingObjects(*map->getCurrentPart());
+	std::reverse(matches.begin(), matches.end());
+	map->addObjectsToSelection(matches, false);
 	
 	map->emitSelectionChanged();
 	map->ensureVisibilityOfSelectedObjects(Map::FullVisibility);
@@ -20,6 +20,10 @@
 #ifndef OPENORIENTEERING_MAP_FIND_FEATURE_H
 #define OPENORIENTEERING_MAP_FIND_FEATURE_H
 
+#include <cstddef>
+#include <memory>
+#include <vector>
+
 #include <QtGlobal>
 #include <QObject>
 #include <QPointer>
@@ -34,7 +38,10 @@ class QWidget;
 namespace OpenOrienteering {
 
 class MapEditorController;
+class MapPart;
+class Object;
 class ObjectQuery;
+class ObjectQueryProgram;
 class TagSelectWidget;
 
 /**
@@ -43,6 +50,11 @@ class TagSelectWidget;
  * The search text from the provided dialog is trimmed and parsed as an 
  * ObjectQuery. If parsing fails, the trimmed text is used to find any matching
  * text in tag keys, tag values, text object content or symbol name.
+ * 
+ * While the user types the search text, a background search selects all
+ * matching objects. It evaluates the query in batches from the event loop,
+ * adding the matches of each batch to the selection, and it is restarted when
+ * the text changes.
  */
 class MapFindFeature : public QObject
 {
@@ -65,8 +77,33 @@ public:
 private:
 	void showDialog();
 	
+	/**
+	 * Returns the query for the current input, or an invalid query.
+	 */
+	ObjectQuery currentQuery() const;
+	
+	/**
+	 * Returns the query for the current input.
+	 * 
+	 * For invalid input, this clears the selection and shows a message.
+	 */
 	ObjectQuery makeQuery() const;
 	
+	/**
+	 * Restarts the background search for the current search text.
+	 */
+	void startSearch();
+	
+	/**
+	 * Stops the background search.
+	 */
+	void cancelSearch();
+	
+	/**
+	 * Schedules searchNextBatch(), if not done already.
+	 */
+	void scheduleSearchBatch();
+	
 	void findNext();
 	
 	void findAll();
@@ -75,7 +112,13 @@ private:
 	
 	void tagSelectorToggled(bool active);
 	
+private slots:
+	/**
+	 * Tests the next batch of objects for the background search.
+	 */
+	void searchNextBatch();
 	
+private:
 	MapEditorController& controller;
 	QPointer<QDialog> find_dialog;           // child of controller's window
 	QStackedLayout* editor_stack = nullptr;  // child of find_dialog
@@ -85,6 +128,12 @@ private:
 	QAction* show_action = nullptr;          // child of this
 	QAction* find_next_action = nullptr;     // child of this
 	
+	std::unique_ptr<ObjectQueryProgram> search_program;
+	const MapPart* search_part = nullptr;
+	std::vector<Object*> search_objects;
+	std::size_t search_next = 0;
+	bool search_scheduled = false;
+	
 	Q_DISABLE_COPY(MapFindFeature)
 };
 
@@ -39,6 +39,7 @@ class MapInformation;
  * the number of symbols, templates and undo/redo steps.
  * For each color a list of symbols using that color is shown.
  * All fonts (and their substitutions) being used by symbols are shown.
+ * The approximate memory usage is shown for the major parts of the map.
  * For objects there is a hierarchical view:
  * - the number of objects per symbol class (e.g., Point symbols, Line symbols etc.)
  *   - for each symbol class the symbols in use and the related number of objects
@@ -0,0 +1,440 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "map_tile_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include <Qt>
+#include <QColor>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRegion>
+#include <QRunnable>
+#include <QThread>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// Integer division which rounds towards negative infinity.
+int floorDiv(int value, int divisor)
+{
+	return value >= 0 ? value / divisor : -((-value - 1) / divisor) - 1;
+}
+
+}  // namespace
+
+
+
+// ### MapTileCache::RenderJob ###
+
+/**
+ * Renders a single tile on a worker thread.
+ */
+class MapTileCache::RenderJob : public QRunnable
+{
+public:
+	RenderJob(MapTileCache& cache, Renderer renderer, const QTransform& transform, const QRectF& map_rect, RenderedTile&& result)
+	: cache(cache)
+	, renderer(std::move(renderer))
+	, transform(transform)
+	, map_rect(map_rect)
+	, result(std::move(result))
+	{}
+	
+	void run() override
+	{
+		result.image = QImage(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+		result.image.fill(Qt::transparent);
+		
+		QPainter painter(&result.image);
+		painter.setWorldTransform(transform);
+		renderer(painter, map_rect);
+		painter.end();
+		
+		cache.deliver(std::move(result));
+	}
+
+private:
+	MapTileCache& cache;
+	Renderer renderer;
+	QTransform transform;
+	QRectF map_rect;
+	RenderedTile result;
+};
+
+
+
+// ### MapTileCache ###
+
+MapTileCache::MapTileCache(QObject* parent)
+: QObject(parent)
+{
+	workers.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+MapTileCache::~MapTileCache()
+{
+	// Workers deliver to this object.
+	workers.clear();
+	workers.waitForDone();
+}
+
+
+const QTransform& MapTileCache::layout() const
+{
+	return map_to_grid;
+}
+
+void MapTileCache::setLayout(const QTransform& map_to_grid)
+{
+	if (this->map_to_grid != map_to_grid)
+	{
+		if (preview.isEmpty() || isMostlyComplete())
+		{
+			preview.clear();
+			for (auto tile = tiles.cbegin(); tile != tiles.cend(); ++tile)
+			{
+				if (!tile->image.isNull())
+					preview.insert(tile.key(), tile->image);
+			}
+			preview_map_to_grid = this->map_to_grid;
+		}
+		
+		this->map_to_grid = map_to_grid;
+		workers.clear();
+		tiles.clear();
+		client_ranges.clear();
+		++layout_serial;  // Results of running jobs are obsolete.
+	}
+}
+
+void MapTileCache::clear()
+{
+	workers.clear();
+	tiles.clear();
+	client_ranges.clear();
+	preview.clear();
+	++layout_serial;  // Results of running jobs are obsolete.
+}
+
+void MapTileCache::invalidate()
+{
+	for (auto& tile : tiles)
+	{
+		tile.dirty_rect = QRect(0, 0, tile_size, tile_size);
+		++tile.generation;
+	}
+}
+
+void MapTileCache::invalidate(const QRectF& map_rect, int pixel_border)
+{
+	if (!map_rect.isValid())
+		return;
+	
+	auto const border = 1 + pixel_border;
+	auto const grid_rect = map_to_grid.mapRect(map_rect).toAlignedRect().adjusted(-border, -border, border, border);
+	for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		auto const column = int(qint32(tile.key() >> 32));
+		auto const row = int(qint32(tile.key() & 0xffffffffu));
+		auto const rect = tileRect(column, row);
+		if (rect.intersects(grid_rect))
+		{
+			tile->dirty_rect |= grid_rect.intersected(rect).translated(-rect.topLeft());
+			++tile->generation;
+		}
+	}
+}
+
+QRect MapTileCache::pendingArea(const QRect& grid_rect) const
+{
+	QRect result;
+	auto const range = tileIndexRange(grid_rect);
+	for (int row = range.top(); row <= range.bottom(); ++row)
+	{
+		for (int column = range.left(); column <= range.right(); ++column)
+		{
+			auto const tile = tiles.constFind(keyOf(column, row));
+			if (tile == tiles.constEnd()
+			    || (tile->dirty_rect.isValid() && (!tile->pending || isSmall(tile->dirty_rect))))
+			{
+				result |= tileRect(column, row);
+			}
+		}
+	}
+	return result;
+}
+
+void MapTileCache::render(const QRect& grid_rect, const Renderer& renderer, bool asynchronous, const void* client)
+{
+	auto const range = tileIndexRange(grid_rect);
+	recent_range = range;
+	client_ranges[client] = range;
+	
+	// Drop the tiles which are far from the areas of interest.
+	std::vector<QRect> keep;
+	keep.reserve(std::size_t(client_ranges.size()));
+	for (auto const& r : client_ranges)
+		keep.push_back(r.adjusted(-r.width(), -r.height(), r.width(), r.height()));
+	for (auto tile = tiles.begin(); tile != tiles.end(); )
+	{
+		auto const column = int(qint32(tile.key() >> 32));
+		auto const row = int(qint32(tile.key() & 0xffffffffu));
+		auto const keep_tile = std::any_of(begin(keep), end(keep), [column, row](const QRect& r) {
+			return r.contains(column, row);
+		});
+		if (keep_tile)
+			++tile;
+		else
+			tile = tiles.erase(tile);
+	}
+	
+	// Workers start with the tiles close to the center.
+	auto const center = range.center();
+	auto const priority = [center](int column, int row) {
+		return -(std::abs(column - center.x()) + std::abs(row - center.y()));
+	};
+	
+	for (int row = range.top(); row <= range.bottom(); ++row)
+	{
+		for (int column = range.left(); column <= range.right(); ++column)
+		{
+			auto& tile = tiles[keyOf(column, row)];
+			if (tile.image.isNull())
+			{
+				if (tile.pending)
+					continue;
+				if (asynchronous)
+					enqueue(tile, column, row, renderer, priority(column, row));
+				else
+					renderNow(tile, column, row, renderer);
+			}
+			else if (tile.dirty_rect.isValid())
+			{
+				// Small updates, e.g. from editing, are not deferred.
+				if (!asynchronous || isSmall(tile.dirty_rect))
+					renderNow(tile, column, row, renderer);
+				else if (!tile.pending)
+					enqueue(tile, column, row, renderer, priority(column, row));
+			}
+		}
+	}
+	
+	if (!asynchronous)
+		preview.clear();
+}
+
+void MapTileCache::removeClient(const void* client)
+{
+	client_ranges.remove(client);
+}
+
+void MapTileCache::draw(QPainter* painter, const QRect& grid_rect) const
+{
+	QRegion missing;
+	auto const range = tileIndexRange(grid_rect);
+	for (int row = range.top(); row <= range.bottom(); ++row)
+	{
+		for (int column = range.left(); column <= range.right(); ++column)
+		{
+			auto const rect = tileRect(column, row);
+			auto const tile = tiles.constFind(keyOf(column, row));
+			if (tile != tiles.constEnd() && !tile->image.isNull())
+			{
+				painter->drawImage(rect.topLeft(), tile->image);
+			}
+			else
+			{
+				painter->fillRect(rect, QColor(128, 128, 128, 48));
+				missing += rect;
+			}
+		}
+	}
+	
+	if (!missing.isEmpty() && !preview.isEmpty())
+		drawPreview(painter, missing);
+}
+
+void MapTileCache::drawPreview(QPainter* painter, const QRegion& grid_region) const
+{
+	auto const preview_to_grid = preview_map_to_grid.inverted() * map_to_grid;
+	auto const preview_rect = preview_to_grid.inverted().mapRect(QRectF(grid_region.boundingRect())).toAlignedRect();
+	
+	painter->save();
+	painter->setClipRegion(grid_region, Qt::IntersectClip);
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->setTransform(preview_to_grid, true);
+	for (auto image = preview.cbegin(); image != preview.cend(); ++image)
+	{
+		auto const column = int(qint32(image.key() >> 32));
+		auto const row = int(qint32(image.key() & 0xffffffffu));
+		auto const rect = tileRect(column, row);
+		if (rect.intersects(preview_rect))
+			painter->drawImage(rect.topLeft(), *image);
+	}
+	painter->restore();
+}
+
+
+void MapTileCache::collectRenderedTiles()
+{
+	std::vector<RenderedTile> results;
+	{
+		QMutexLocker lock(&rendered_mutex);
+		results.swap(rendered);
+	}
+	
+	QRect changed;
+	for (auto& result : results)
+	{
+		if (result.layout_serial != layout_serial)
+			continue;
+		
+		auto tile = tiles.find(result.key);
+		if (tile == tiles.end())
+			continue;
+		
+		tile->pending = false;
+		if (result.generation == tile->generation)
+		{
+			tile->image = std::move(result.image);
+			tile->dirty_rect = QRect();
+		}
+		else if (tile->image.isNull())
+		{
+			// Outdated, but better than nothing.
+			tile->image = std::move(result.image);
+			tile->dirty_rect = QRect(0, 0, tile_size, tile_size);
+		}
+		
+		auto const column = int(qint32(result.key >> 32));
+		auto const row = int(qint32(result.key & 0xffffffffu));
+		changed |= tileRect(column, row);
+	}
+	
+	if (!preview.isEmpty() && !tiles.isEmpty())
+	{
+		auto const complete = std::all_of(tiles.cbegin(), tiles.cend(), [](const Tile& tile) {
+			return !tile.image.isNull();
+		});
+		if (complete)
+			preview.clear();
+	}
+	
+	if (changed.isValid())
+		emit tilesReady(changed);
+}
+
+
+quint64 MapTileCache::keyOf(int column, int row)
+{
+	return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+bool MapTileCache::isSmall(const QRect& dirty_rect)
+{
+	return dirty_rect.width() * dirty_rect.height() <= tile_size * tile_size / 4;
+}
+
+QRect MapTileCache::tileRect(int column, int row)
+{
+	return { column * tile_size, row * tile_size, tile_size, tile_size };
+}
+
+QRect MapTileCache::tileIndexRange(const QRect& grid_rect)
+{
+	return { QPoint{ floorDiv(grid_rect.left(), tile_size), floorDiv(grid_rect.top(), tile_size) },
+	         QPoint{ floorDiv(grid_rect.right(), tile_size), floorDiv(grid_rect.bottom(), tile_size) } };
+}
+
+bool MapTileCache::isMostlyComplete() const
+{
+	auto available = 0;
+	for (int row = recent_range.top(); row <= recent_range.bottom(); ++row)
+	{
+		for (int column = recent_range.left(); column <= recent_range.right(); ++column)
+		{
+			auto const tile = tiles.constFind(keyOf(column, row));
+			if (tile != tiles.constEnd() && !tile->image.isNull())
+				++available;
+		}
+	}
+	return 2 * available >= recent_range.width() * recent_range.height();
+}
+
+QRectF MapTileCache::mapRect(const QRect& grid_rect) const
+{
+	// One pixel extra for antialiasing
+	return map_to_grid.inverted().mapRect(QRectF(grid_rect.adjusted(-1, -1, 1, 1)));
+}
+
+
+void MapTileCache::renderNow(Tile& tile, int column, int row, const Renderer& renderer)
+{
+	if (tile.image.isNull())
+	{
+		tile.image = QImage(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+		tile.dirty_rect = QRect(0, 0, tile_size, tile_size);
+	}
+	
+	QPainter painter(&tile.image);
+	painter.setClipRect(tile.dirty_rect);
+	painter.setCompositionMode(QPainter::CompositionMode_Clear);
+	painter.fillRect(tile.dirty_rect, Qt::transparent);
+	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	
+	auto const rect = tileRect(column, row);
+	painter.translate(-rect.left(), -rect.top());
+	painter.setWorldTransform(map_to_grid, true);
+	renderer(painter, mapRect(tile.dirty_rect.translated(rect.topLeft())));
+	painter.end();
+	
+	tile.dirty_rect = QRect();
+}
+
+void MapTileCache::enqueue(Tile& tile, int column, int row, const Renderer& renderer, int priority)
+{
+	auto const rect = tileRect(column, row);
+	auto const transform = map_to_grid * QTransform::fromTranslate(-rect.left(), -rect.top());
+	tile.pending = true;
+	workers.start(new RenderJob(*this, renderer, transform, mapRect(rect),
+	                            { QImage(), keyOf(column, row), layout_serial, tile.generation }),
+	              priority);
+}
+
+void MapTileCache::deliver(RenderedTile&& tile)
+{
+	QMutexLocker lock(&rendered_mutex);
+	auto const first = rendered.empty();
+	rendered.push_back(std::move(tile));
+	if (first)
+		QMetaObject::invokeMethod(this, "collectRenderedTiles", Qt::QueuedConnection);
+}
+
+
+}  // namespace OpenOrienteering
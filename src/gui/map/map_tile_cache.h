@@ -0,0 +1,233 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_MAP_TILE_CACHE_H
+#define OPENORIENTEERING_MAP_TILE_CACHE_H
+
+#include <functional>
+#include <vector>
+
+#include <QtGlobal>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPoint>
+#include <QRect>
+#include <QRectF>
+#include <QRegion>
+#include <QThreadPool>
+#include <QTransform>
+
+class QPainter;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A cache of map images in fixed-size tiles.
+ *
+ * The tiles form a grid in pixel coordinates which is defined by a layout,
+ * i.e. by the transformation from map coordinates to grid pixels. The layout
+ * depends on zoom and rotation, but not on the position of the view, so that
+ * the tiles survive panning.
+ *
+ * Missing tiles can be rendered on a pool of worker threads, starting from
+ * the center of the area of interest. Until a tile is ready, the tiles from
+ * the previous layout are drawn scaled in its place, or a placeholder if
+ * there are no such tiles. Invalidated tiles keep their old image until they
+ * are rendered again.
+ *
+ * A cache may be shared by several map widgets with the same layout, cf.
+ * MapTileStore. The widgets identify themselves as clients when rendering.
+ */
+class MapTileCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	/** The width and height of a tile, in pixels. */
+	static constexpr int tile_size = 256;
+	
+	/**
+	 * A function which draws the map for a tile.
+	 *
+	 * The painter is set up for drawing in map coordinates. The rectangle is
+	 * the area of the tile in map coordinates. Functions which are passed to
+	 * render() for asynchronous rendering are called on worker threads.
+	 */
+	using Renderer = std::function<void (QPainter& painter, const QRectF& map_rect)>;
+	
+	/** Constructs an empty cache. */
+	explicit MapTileCache(QObject* parent = nullptr);
+	
+	MapTileCache(const MapTileCache&) = delete;
+	MapTileCache& operator=(const MapTileCache&) = delete;
+	
+	/** Waits for all workers to finish. */
+	~MapTileCache() override;
+	
+
+	/**
+	 * Returns the transformation from map coordinates to grid pixels.
+	 */
+	const QTransform& layout() const;
+	
+	/**
+	 * Sets the transformation from map coordinates to grid pixels.
+	 *
+	 * If the transformation differs from the current layout, all tiles are
+	 * dropped, and pending work is cancelled. The dropped tiles are kept as
+	 * a preview until the new tiles are ready. During fast zooming, when
+	 * most tiles of the current layout are still missing, the existing
+	 * preview is kept instead.
+	 */
+	void setLayout(const QTransform& map_to_grid);
+	
+	/**
+	 * Drops all tiles, the preview, and pending work.
+	 */
+	void clear();
+	
+	/**
+	 * Marks all tiles as needing to be rendered again.
+	 */
+	void invalidate();
+	
+	/**
+	 * Marks the given area as needing to be rendered again.
+	 *
+	 * @param map_rect      The area in map coordinates.
+	 * @param pixel_border  An additional border, in pixels.
+	 */
+	void invalidate(const QRectF& map_rect, int pixel_border);
+	
+	/**
+	 * Returns the part of the grid rect which is covered by tiles from the
+	 * given rect which need to be rendered, in grid pixels.
+	 *
+	 * Returns an invalid rect if there is nothing to do.
+	 */
+	QRect pendingArea(const QRect& grid_rect) const;
+	
+	/**
+	 * Renders the tiles from the given grid rect which are missing or
+	 * invalidated, and drops tiles which are far from the given rect.
+	 *
+	 * For asynchronous rendering, small invalidated areas are still
+	 * rendered immediately, in order to have edits appear without delay.
+	 *
+	 * Tiles are kept while they are close to the area of interest of any
+	 * client.
+	 *
+	 * @param grid_rect     The area of interest, in grid pixels.
+	 * @param renderer      The function which draws the map.
+	 * @param asynchronous  If true, missing tiles are rendered by worker threads.
+	 * @param client        Identifies the user of a shared cache.
+	 */
+	void render(const QRect& grid_rect, const Renderer& renderer, bool asynchronous, const void* client = nullptr);
+	
+	/**
+	 * Forgets the area of interest of the given client.
+	 */
+	void removeClient(const void* client);
+	
+	/**
+	 * Draws the tiles from the given grid rect.
+	 *
+	 * The painter must be set up for drawing in grid pixels.
+	 * The preview or placeholders are drawn for tiles which are not yet
+	 * available.
+	 */
+	void draw(QPainter* painter, const QRect& grid_rect) const;
+
+
+signals:
+	/**
+	 * Indicates that tiles in the given area were rendered by a worker.
+	 *
+	 * @param grid_rect  The area which changed, in grid pixels.
+	 */
+	void tilesReady(const QRect& grid_rect);
+
+
+private slots:
+	/** Moves the images rendered by the workers into the cache. */
+	void collectRenderedTiles();
+
+private:
+	class RenderJob;
+	
+	struct Tile
+	{
+		QImage image;
+		QRect dirty_rect;          ///< The stale part of the image, in tile pixels.
+		quint32 generation = 0;    ///< Incremented on invalidation.
+		bool pending = false;      ///< Set while a worker renders this tile.
+	};
+	
+	struct RenderedTile
+	{
+		QImage image;
+		quint64 key;
+		quint32 layout_serial;
+		quint32 generation;
+	};
+	
+	static quint64 keyOf(int column, int row);
+	static bool isSmall(const QRect& dirty_rect);
+	static QRect tileRect(int column, int row);
+	static QRect tileIndexRange(const QRect& grid_rect);
+	
+	QRectF mapRect(const QRect& grid_rect) const;
+	
+	/** Renders the tile's dirty area on the current thread. */
+	void renderNow(Tile& tile, int column, int row, const Renderer& renderer);
+	
+	/** Enqueues a tile for rendering by a worker thread. */
+	void enqueue(Tile& tile, int column, int row, const Renderer& renderer, int priority);
+	
+	/** Returns true if most tiles in the most recent area of interest are available. */
+	bool isMostlyComplete() const;
+	
+	/** Draws the preview, clipped to the given area in grid pixels. */
+	void drawPreview(QPainter* painter, const QRegion& grid_region) const;
+	
+	/** Receives a rendered tile from a worker thread. */
+	void deliver(RenderedTile&& tile);
+	
+	QTransform map_to_grid;
+	quint32 layout_serial = 0;
+	QHash<quint64, Tile> tiles;
+	QRect recent_range;                 ///< The tile indices of the most recent area of interest.
+	QHash<const void*, QRect> client_ranges;  ///< The tile indices of the areas of interest of all clients.
+	
+	QTransform preview_map_to_grid;     ///< The layout of the preview images.
+	QHash<quint64, QImage> preview;     ///< Tile images from a previous layout.
+	
+	QThreadPool workers;
+	QMutex rendered_mutex;
+	std::vector<RenderedTile> rendered;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_tile_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+
+#include "gui/map/map_tile_cache.h"
+
+
+namespace OpenOrienteering {
+
+MapTileStore::MapTileStore() = default;
+
+MapTileStore::~MapTileStore() = default;
+
+
+std::shared_ptr<MapTileCache> MapTileStore::acquire(const QTransform& viewport_transform, int options, std::shared_ptr<MapTileCache> current)
+{
+	entries.erase(std::remove_if(begin(entries), end(entries), [](const Entry& entry) {
+		return entry.cache.expired();
+	}), end(entries));
+	
+	for (auto const& entry : entries)
+	{
+		auto cache = entry.cache.lock();
+		if (entry.options == options && matches(cache->layout(), viewport_transform))
+			return cache;
+	}
+	
+	// The cache of the widget gets the new layout, unless it is shared.
+	auto entry = std::find_if(begin(entries), end(entries), [&current](const Entry& entry) {
+		return entry.cache.lock() == current;
+	});
+	if (!current || current.use_count() > 1)
+	{
+		current = std::make_shared<MapTileCache>();
+		entry = end(entries);
+	}
+	if (entry == end(entries))
+		entries.push_back({ current, options });
+	else
+		entry->options = options;
+	
+	auto const offset = QPointF{ viewport_transform.dx(), viewport_transform.dy() }.toPoint();
+	current->setLayout({ viewport_transform.m11(), viewport_transform.m12(),
+	                     viewport_transform.m21(), viewport_transform.m22(),
+	                     viewport_transform.dx() - offset.x(),
+	                     viewport_transform.dy() - offset.y() });
+	return current;
+}
+
+
+void MapTileStore::invalidate(const QRectF& map_rect)
+{
+	for (auto const& entry : entries)
+	{
+		if (auto cache = entry.cache.lock())
+			cache->invalidate(map_rect, 0);
+	}
+}
+
+
+// static
+bool MapTileStore::matches(const QTransform& layout, const QTransform& viewport_transform)
+{
+	if (viewport_transform.m11() != layout.m11() || viewport_transform.m12() != layout.m12()
+	    || viewport_transform.m21() != layout.m21() || viewport_transform.m22() != layout.m22())
+		return false;
+	
+	auto const offset = QPointF{ viewport_transform.dx() - layout.dx(), viewport_transform.dy() - layout.dy() };
+	auto const pixels = offset.toPoint();
+	return std::abs(offset.x() - pixels.x()) <= 0.25
+	       && std::abs(offset.y() - pixels.y()) <= 0.25;
+}
+
+
+}  // namespace OpenOrienteering
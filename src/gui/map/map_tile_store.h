@@ -0,0 +1,90 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_TILE_STORE_H
+#define OPENORIENTEERING_MAP_TILE_STORE_H
+
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+#include <QTransform>
+
+class QRectF;
+
+namespace OpenOrienteering {
+
+class MapTileCache;
+
+
+/**
+ * The map tile caches of all widgets which show a map.
+ *
+ * Widgets with the same zoom, rotation and render options, e.g. a second
+ * view of a map or the print preview next to the editor, draw from the same
+ * MapTileCache. The store is owned by the map. It doesn't own the caches but
+ * tracks them while they are in use, so that invalidation is done once per
+ * cache instead of once per widget.
+ */
+class MapTileStore
+{
+public:
+	MapTileStore();
+	
+	MapTileStore(const MapTileStore&) = delete;
+	MapTileStore& operator=(const MapTileStore&) = delete;
+	
+	~MapTileStore();
+	
+	
+	/**
+	 * Returns a cache for the given transformation from map coordinates to
+	 * viewport pixels, and the given render options.
+	 * 
+	 * The layout of the returned cache matches the transformation, up to an
+	 * integer offset in pixels. A cache from another widget is used when
+	 * possible. Otherwise, the current cache of the widget is given the new
+	 * layout if no other widget uses it, or a new cache is created.
+	 */
+	std::shared_ptr<MapTileCache> acquire(const QTransform& viewport_transform, int options, std::shared_ptr<MapTileCache> current);
+	
+	/**
+	 * Marks the given area as needing to be rendered again, in all caches.
+	 */
+	void invalidate(const QRectF& map_rect);
+	
+	
+private:
+	struct Entry
+	{
+		std::weak_ptr<MapTileCache> cache;
+		int options;
+	};
+	
+	/** Returns true if the cache layout matches the transformation. */
+	static bool matches(const QTransform& layout, const QTransform& viewport_transform);
+	
+	std::vector<Entry> entries;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,12 +21,15 @@
 
 #include "map_widget.h"
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <stdexcept>
 
 #include <QApplication>
 #include <QColor>
 #include <QContextMenuEvent>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFlags>
 #include <QFont>
@@ -42,7 +45,6 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPinchGesture>
-#include <QPixmap>
 #include <QPointer>
 #include <QResizeEvent>
 #include <QSizePolicy>
@@ -54,6 +56,7 @@
 #include <QWheelEvent>
 
 #include "settings.h"
+#include "core/geographic_approximation.h"
 #include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map.h"
@@ -61,6 +64,7 @@
 #include "core/symbols/symbol.h"  // IWYU pragma: keep
 #include "gui/touch_cursor.h"
 #include "gui/map/map_editor_activity.h"
+#include "gui/map/performance_hud.h"
 #include "gui/widgets/action_grid_bar.h"
 #include "gui/widgets/key_button_bar.h"
 #include "gui/widgets/pie_menu.h"
@@ -69,6 +73,7 @@
 #include "templates/template.h"
 #include "tools/tool.h"
 #include "util/backports.h" // IWYU pragma: keep
+#include "util/trace.h"
 #include "util/util.h"
 
 class QGesture;
@@ -82,8 +87,65 @@ class QGesture;
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * The maximum number of single template layers in a MapWidget.
+ * 
+ * Each layer takes the memory of a full viewport image. With more visible
+ * templates, the templates are drawn directly into the template caches.
+ */
+#ifdef Q_OS_ANDROID
+constexpr int max_template_layers = 0;
+#else
+constexpr int max_template_layers = 6;
+#endif
+
+/**
+ * The time after the last zoom change until the caches are rendered at full
+ * device resolution, in milliseconds.
+ */
+constexpr int zoom_idle_interval = 300;
+
+/**
+ * The minimum distance between parallel grid lines on screen, in pixels.
+ * 
+ * When zoomed out further, only every second, fourth, ... line is drawn.
+ */
+constexpr qreal min_grid_spacing_px = 8;
+
+/**
+ * Returns the given rect in the pixels of an image with the given resolution.
+ */
+QRectF toImagePixels(const QRect& rect, qreal resolution)
+{
+	return { rect.x() * resolution, rect.y() * resolution, rect.width() * resolution, rect.height() * resolution };
+}
+
+/**
+ * Sets the offset from the cache's grid pixels to viewport pixels, and
+ * returns true if the cache's layout fits the viewport transform.
+ * 
+ * The tile grid depends on zoom and rotation, and on the subpixel
+ * position of the view. Panning by whole pixels keeps the tiles.
+ */
+bool updateCacheOffset(const MapTileCache& cache, const QTransform& viewport_transform, QPoint& offset)
+{
+	auto const& layout = cache.layout();
+	auto const exact_offset = QPointF{ viewport_transform.dx() - layout.dx(), viewport_transform.dy() - layout.dy() };
+	offset = exact_offset.toPoint();
+	return viewport_transform.m11() == layout.m11() && viewport_transform.m12() == layout.m12()
+	       && viewport_transform.m21() == layout.m21() && viewport_transform.m22() == layout.m22()
+	       && std::abs(exact_offset.x() - offset.x()) <= 0.25
+	       && std::abs(exact_offset.y() - offset.y()) <= 0.25;
+}
+
+}  // namespace
+
+
+
 MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
- : QWidget(parent)
+ : MapWidgetBase(parent)
  , view(nullptr)
  , tool(nullptr)
  , activity(nullptr)
@@ -94,9 +156,8 @@ MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
  , dragging(false)
  , pinching(false)
  , pinching_factor(1.0)
- , below_template_cache_dirty_rect(rect())
- , above_template_cache_dirty_rect(rect())
- , map_cache_dirty_rect(rect())
+ , below_template_cache_dirty_region(rect())
+ , above_template_cache_dirty_region(rect())
  , drawing_dirty_rect_border(0)
  , activity_dirty_rect_border(0)
  , last_mouse_release_time(QTime::currentTime())
@@ -115,11 +176,23 @@ MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
 	setMouseTracking(true);
 	setFocusPolicy(Qt::ClickFocus);
 	setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
+	
+	setMapCache(std::make_shared<MapTileCache>());
+	
+	zoom_idle_timer = new QTimer(this);
+	zoom_idle_timer->setSingleShot(true);
+	zoom_idle_timer->setInterval(zoom_idle_interval);
+	connect(zoom_idle_timer, &QTimer::timeout, this, [this]() {
+		if (targetCacheResolution() != cache_resolution)
+			update();
+	});
 }
 
 MapWidget::~MapWidget()
 {
-	// nothing, not inlined
+	map_cache->removeClient(this);
+	if (frozen_cache)
+		frozen_cache->removeClient(this);
 }
 
 void MapWidget::setMapView(MapView* view)
@@ -135,6 +208,13 @@ void MapWidget::setMapView(MapView* view)
 		}
 		
 		this->view = view;
+		setMapCache(std::make_shared<MapTileCache>());
+		map_snapshot.reset();
+		setFrozenCache({});
+		frozen_snapshot.reset();
+		below_template_cache_dirty_region = rect();
+		above_template_cache_dirty_region = rect();
+		template_layers.clear();
 		
 		if (view)
 		{
@@ -150,6 +230,9 @@ void MapWidget::setMapView(MapView* view)
 			connect(map, &Map::symbolDeleted, this, &MapWidget::updatePlaceholder);
 			connect(map, &Map::templateAdded, this, &MapWidget::updatePlaceholder);
 			connect(map, &Map::templateDeleted, this, &MapWidget::updatePlaceholder);
+			connect(map, &Map::templateDeleted, this, [this](int /*pos*/, const Template* temp) {
+				template_layers.remove(temp);
+			});
 		}
 		
 		update();
@@ -281,9 +364,14 @@ void MapWidget::viewChanged(MapView::ChangeFlags changes)
 {
 	setDrawingBoundingBox(drawing_dirty_rect_map, drawing_dirty_rect_border, true);
 	setActivityBoundingBox(activity_dirty_rect_map, activity_dirty_rect_border, true);
-	updateEverything();
+	// The map cache is adjusted to the view in updateMapCache().
+	scrollTemplateCaches();
+	update();
 	if (changes.testFlag(MapView::ZoomChange))
+	{
+		zoom_idle_timer->start();
 		updateZoomDisplay();
+	}
 }
 
 void MapWidget::visibilityChanged(MapView::VisibilityFeature feature, bool active, Template* temp)
@@ -325,8 +413,6 @@ void MapWidget::visibilityChanged(MapView::VisibilityFeature feature, bool activ
 		
 	case MapView::VisibilityFeature::GridVisible:
 	case MapView::VisibilityFeature::MapVisible:
-		map_cache_dirty_rect = rect();
-		Q_FALLTHROUGH();
 	case MapView::VisibilityFeature::AllTemplatesHidden:
 		update();
 		break;
@@ -488,27 +574,53 @@ void MapWidget::moveDirtyRect(QRect& dirty_rect, qreal x, qreal y)
 		dirty_rect = dirty_rect.translated(x, y).intersected(rect());
 }
 
-void MapWidget::markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache)
+QRect MapWidget::templateCacheRect(const QRectF& view_rect, int pixel_border) const
 {
-	QRect& cache_dirty_rect = front_cache ? above_template_cache_dirty_rect : below_template_cache_dirty_rect;
 	QRectF viewport_rect = viewToViewport(view_rect);
-	QRect integer_rect = QRect(viewport_rect.left() - (1+pixel_border), viewport_rect.top() - (1+pixel_border),
-							   viewport_rect.width() + 2*(1+pixel_border), viewport_rect.height() + 2*(1+pixel_border));
+	return QRect(viewport_rect.left() - (1+pixel_border), viewport_rect.top() - (1+pixel_border),
+	             viewport_rect.width() + 2*(1+pixel_border), viewport_rect.height() + 2*(1+pixel_border));
+}
+
+void MapWidget::markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache)
+{
+	QRegion& cache_dirty_region = front_cache ? above_template_cache_dirty_region : below_template_cache_dirty_region;
+	QRect integer_rect = templateCacheRect(view_rect, pixel_border);
 	
 	if (!integer_rect.intersects(rect()))
 		return;
 	
-	if (cache_dirty_rect.isValid())
-		cache_dirty_rect = cache_dirty_rect.united(integer_rect);
-	else
-		cache_dirty_rect = integer_rect;
+	cache_dirty_region |= integer_rect.intersected(rect());
 	
 	update(integer_rect);
 }
 
+void MapWidget::markTemplateLayerDirty(const Template* temp, const QRectF& view_rect, int pixel_border)
+{
+	auto layer = template_layers.find(temp);
+	if (layer != template_layers.end())
+	{
+		auto const integer_rect = templateCacheRect(view_rect, pixel_border).intersected(rect());
+		layer->dirty_region |= integer_rect;
+	}
+}
+
+void MapWidget::markTemplateLayersDirty(const QRect& dirty_rect)
+{
+	for (auto& layer : template_layers)
+		layer.dirty_region |= dirty_rect;
+}
+
 void MapWidget::markObjectAreaDirty(const QRectF& map_rect)
 {
-	updateMapRect(map_rect, 0, map_cache_dirty_rect);
+	// The map invalidates the tiles, once for all widgets.
+	map_snapshot.reset();
+	updateDrawing(map_rect, 0);
+}
+
+void MapWidget::markFrozenAreaDirty(const QRectF& map_rect)
+{
+	frozen_snapshot.reset();
+	markObjectAreaDirty(map_rect);
 }
 
 void MapWidget::setDrawingBoundingBox(QRectF map_rect, int pixel_border, bool do_update)
@@ -607,20 +719,48 @@ void MapWidget::updateDrawingLaterSlot()
 
 void MapWidget::updateEverything()
 {
-	map_cache_dirty_rect = rect();
-	below_template_cache_dirty_rect = map_cache_dirty_rect;
-	above_template_cache_dirty_rect = map_cache_dirty_rect;
-	update(map_cache_dirty_rect);
+	map_cache->invalidate();
+	map_snapshot.reset();
+	if (frozen_cache)
+		frozen_cache->invalidate();
+	frozen_snapshot.reset();
+	below_template_cache_dirty_region = rect();
+	above_template_cache_dirty_region = rect();
+	markTemplateLayersDirty(rect());
+	update();
 }
 
 void MapWidget::updateEverythingInRect(const QRect& dirty_rect)
 {
-	rectIncludeSafe(map_cache_dirty_rect, dirty_rect);
-	rectIncludeSafe(below_template_cache_dirty_rect, dirty_rect);
-	rectIncludeSafe(above_template_cache_dirty_rect, dirty_rect);
+	if (view && dirty_rect.isValid())
+	{
+		auto const map_rect = view->calculateViewedRect(viewportToView(dirty_rect));
+		map_cache->invalidate(map_rect, 0);
+		map_snapshot.reset();
+		if (frozen_cache)
+			frozen_cache->invalidate(map_rect, 0);
+		frozen_snapshot.reset();
+	}
+	below_template_cache_dirty_region |= dirty_rect;
+	above_template_cache_dirty_region |= dirty_rect;
+	markTemplateLayersDirty(dirty_rect);
 	update(dirty_rect);
 }
 
+void MapWidget::releaseCaches()
+{
+	below_template_cache.clear();
+	below_template_cache_dirty_region = rect();
+	above_template_cache.clear();
+	above_template_cache_dirty_region = rect();
+	template_layers.clear();
+	setMapCache(std::make_shared<MapTileCache>());
+	map_snapshot.reset();
+	setFrozenCache({});
+	frozen_snapshot.reset();
+	update();
+}
+
 QRect MapWidget::calculateViewportBoundingBox(const QRectF& map_rect, int pixel_border) const
 {
 	QRectF view_rect = view->calculateViewBoundingBox(map_rect);
@@ -656,6 +796,21 @@ void MapWidget::setCoordsDisplay(CoordsType type)
 	updateCursorposLabel(last_cursor_pos);
 }
 
+GeographicApproximation& MapWidget::geographicApproximation(const Georeferencing& georef)
+{
+	if (!geographic_approximation || &geographic_approximation->georeferencing() != &georef)
+	{
+		geographic_approximation = std::make_unique<GeographicApproximation>(georef);
+		auto reset = [this]() {
+			if (geographic_approximation)
+				geographic_approximation->reset();
+		};
+		connect(&georef, &Georeferencing::transformationChanged, this, reset);
+		connect(&georef, &Georeferencing::projectionChanged, this, reset);
+	}
+	return *geographic_approximation;
+}
+
 void MapWidget::updateCursorposLabel(const MapCoordF& pos)
 {
 	last_cursor_pos = pos;
@@ -698,7 +853,7 @@ void MapWidget::updateCursorposLabel(const MapCoordF& pos)
 		}
 		else if (coords_type == GEOGRAPHIC_COORDS)
 		{
-			const LatLon lat_lon(georef.toGeographicCoords(pos, &ok));
+			const LatLon lat_lon(geographicApproximation(georef).toGeographicCoords(pos, &ok));
 			cursorpos_label->setText(
 			  QString::fromUtf8("%1° %2°").
 			  arg(locale().toString(lat_lon.latitude(), 'f', 6),
@@ -707,7 +862,7 @@ void MapWidget::updateCursorposLabel(const MapCoordF& pos)
 		}
 		else if (coords_type == GEOGRAPHIC_COORDS_DMS)
 		{
-			const LatLon lat_lon(georef.toGeographicCoords(pos, &ok));
+			const LatLon lat_lon(geographicApproximation(georef).toGeographicCoords(pos, &ok));
 			cursorpos_label->setText(
 			  QStringLiteral("%1 %2").
 			  arg(georef.degToDMS(lat_lon.latitude()),
@@ -800,7 +955,7 @@ bool MapWidget::event(QEvent* event)
 		; // nothing
 	}
 	
-    return QWidget::event(event);
+    return MapWidgetBase::event(event);
 }
 
 void MapWidget::gestureEvent(QGestureEvent* event)
@@ -848,12 +1003,28 @@ void MapWidget::gestureEvent(QGestureEvent* event)
 	}
 }
 
+#ifdef MAPPER_ENABLE_OPENGL
+
+void MapWidget::paintGL()
+{
+	// The OpenGL paint engine keeps unchanged cache images as textures,
+	// so the whole widget is composed on the GPU.
+	QPainter painter(this);
+	drawViewport(painter, rect());
+}
+
+#else
+
 void MapWidget::paintEvent(QPaintEvent* event)
 {
-	// Draw on the widget
 	QPainter painter(this);
-	QRect exposed = event->rect();
-	
+	drawViewport(painter, event->rect());
+}
+
+#endif
+
+void MapWidget::drawViewport(QPainter& painter, const QRect& exposed)
+{
 	if (!view)
 	{
 		painter.fillRect(exposed, QColor(Qt::gray));
@@ -865,8 +1036,12 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	
 	QTransform transform = painter.worldTransform();
 	
+	// A mere refresh of the performance overlay is not a frame.
+	auto const is_frame = performance_hud && !performance_hud->rect().contains(exposed);
+	if (is_frame)
+		performance_hud->beginFrame();
+	
 	// Update all dirty caches
-	// TODO: It would be an idea to do these updates in a background thread and use the old caches in the meantime
 	updateAllDirtyCaches();
 	
 	QRect target = exposed;
@@ -896,7 +1071,10 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	
 	if (!view->areAllTemplatesHidden() && isBelowTemplateVisible() && !below_template_cache.isNull() && view->getMap()->getFirstFrontTemplate() > 0)
 	{
-		painter.drawImage(target, below_template_cache, exposed);
+		painter.save();
+		painter.translate(target.topLeft() - exposed.topLeft());
+		below_template_cache.draw(painter, exposed);
+		painter.restore();
 	}
 	else if (show_help && no_contents)
 	{
@@ -916,16 +1094,49 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	}
 	
 	const auto map_visibility = view->effectiveMapVisibility();
-	if (!map_cache.isNull() && map_visibility.visible)
+	if (map_visibility.visible)
 	{
-		qreal saved_opacity = painter.opacity();
+		painter.save();
 		painter.setOpacity(map_visibility.opacity);
-		painter.drawImage(target, map_cache, exposed);
-		painter.setOpacity(saved_opacity);
+		painter.setClipRect(target);
+		painter.translate(target.topLeft() - exposed.topLeft());
+		
+		if (frozen_cache)
+		{
+			painter.save();
+			painter.scale(1 / cache_resolution, 1 / cache_resolution);
+			painter.translate(frozen_cache_offset);
+			frozen_cache->draw(&painter, toImagePixels(exposed, cache_resolution).toAlignedRect().translated(-frozen_cache_offset));
+			painter.restore();
+		}
+		
+		painter.save();
+		painter.scale(1 / cache_resolution, 1 / cache_resolution);
+		painter.translate(map_cache_offset);
+		map_cache->draw(&painter, toImagePixels(exposed, cache_resolution).toAlignedRect().translated(-map_cache_offset));
+		painter.restore();
+		
+		if (view->isGridVisible())
+		{
+			if (force_antialiasing || Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool())
+				painter.setRenderHint(QPainter::Antialiasing);
+			painter.translate(width() / 2.0, height() / 2.0);
+			painter.setWorldTransform(view->worldTransform(), true);
+			auto* map = view->getMap();
+			auto const& grid = map->getGrid();
+			auto const min_spacing = min_grid_spacing_px / view->calculateFinalZoomFactor();
+			grid.drawLines(&painter, grid_cache.lines(grid, view->calculateViewedRect(viewportToView(rect())), map, min_spacing));
+		}
+		painter.restore();
 	}
 	
 	if (!view->areAllTemplatesHidden() && isAboveTemplateVisible() && !above_template_cache.isNull() && view->getMap()->getNumTemplates() - view->getMap()->getFirstFrontTemplate() > 0)
-		painter.drawImage(target, above_template_cache, exposed);
+	{
+		painter.save();
+		painter.translate(target.topLeft() - exposed.topLeft());
+		above_template_cache.draw(painter, exposed);
+		painter.restore();
+	}
 	
 	//painter.setClipRect(exposed);
 	
@@ -951,21 +1162,31 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	
 	
 	painter.setWorldTransform(transform, false);
+	
+	// Draw performance overlay
+	if (performance_hud)
+	{
+		if (is_frame)
+		{
+			performance_hud->endFrame();
+			if (!exposed.contains(performance_hud->rect()))
+			{
+				QTimer::singleShot(0, this, [this]() {
+					if (performance_hud)
+						update(performance_hud->rect());
+				});
+			}
+		}
+		performance_hud->paint(&painter);
+	}
 }
 
 void MapWidget::resizeEvent(QResizeEvent* event)
 {
-	map_cache_dirty_rect = rect();
-	below_template_cache_dirty_rect = map_cache_dirty_rect;
-	above_template_cache_dirty_rect = map_cache_dirty_rect;
-	
-	if (map_cache.width() < map_cache_dirty_rect.width() ||
-	    map_cache.height() < map_cache_dirty_rect.height())
-	{
-		map_cache = QImage();
-		below_template_cache = QImage();
-		above_template_cache = QImage();
-	}
+	// The ring buffers must match the viewport size, cf. updateTemplateCache().
+	below_template_cache_dirty_region = rect();
+	above_template_cache_dirty_region = rect();
+	template_layers.clear();
 	
 	for (QObject* const child : children())
 	{
@@ -985,7 +1206,7 @@ void MapWidget::resizeEvent(QResizeEvent* event)
 		}
 	}
 	
-	QWidget::resizeEvent(event);
+	MapWidgetBase::resizeEvent(event);
 }
 
 void MapWidget::mousePressEvent(QMouseEvent* event)
@@ -1109,7 +1330,7 @@ void MapWidget::_mouseDoubleClickEvent(QMouseEvent* event)
 		return;
 	}
 	
-	QWidget::mouseDoubleClickEvent(event);
+	MapWidgetBase::mouseDoubleClickEvent(event);
 }
 
 void MapWidget::wheelEvent(QWheelEvent* event)
@@ -1212,7 +1433,7 @@ QVariant MapWidget::inputMethodQuery(Qt::InputMethodQuery property, const QVaria
 	if (tool)
 		result = tool->inputMethodQuery(property, argument);
 	if (!result.isValid())
-		result = QWidget::inputMethodQuery(property);
+		result = MapWidgetBase::inputMethodQuery(property);
 	return result;
 }
 
@@ -1235,11 +1456,25 @@ void MapWidget::enableTouchCursor(bool enabled)
 	}
 }
 
+void MapWidget::setPerformanceHudVisible(bool visible)
+{
+	if (visible == bool(performance_hud))
+		return;
+	
+	if (performance_hud)
+		update(performance_hud->rect());
+	if (visible)
+		performance_hud = std::make_unique<PerformanceHud>(font());
+	else
+		performance_hud.reset();
+	update();
+}
+
 void MapWidget::focusOutEvent(QFocusEvent* event)
 {
 	if (tool)
 		tool->focusOutEvent(event);
-	QWidget::focusOutEvent(event);
+	MapWidgetBase::focusOutEvent(event);
 }
 
 void MapWidget::contextMenuEvent(QContextMenuEvent* event)
@@ -1283,7 +1518,7 @@ bool MapWidget::containsVisibleTemplate(int first_template, int last_template) c
 	Map* map = view->getMap();
 	for (int i = first_template; i <= last_template; ++i)
 	{
-		if (view->isTemplateVisible(map->getTemplate(i)))
+		if (view->isTemplateDisplayed(map->getTemplate(i)))
 			return true;
 	}
 	
@@ -1302,145 +1537,375 @@ bool MapWidget::isBelowTemplateVisible() const
 	return containsVisibleTemplate(0, view->getMap()->getFirstFrontTemplate() - 1);
 }
 
-void MapWidget::updateTemplateCache(QImage& cache, QRect& dirty_rect, int first_template, int last_template, bool use_background)
+void MapWidget::updateTemplateCache(ViewportCache& cache, QRegion& dirty_region, int first_template, int last_template, bool use_background)
 {
+	MAPPER_TRACE_SCOPE("MapWidget::updateTemplateCache");
 	Q_ASSERT(containsVisibleTemplate(first_template, last_template));
 	
-	if (cache.isNull())
+	if (cache.isNull() || cache.size() != size())
 	{
 		// Lazy allocation of cache image
-		cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
-		dirty_rect = rect();
+		allocateCache(cache, use_background);
+		dirty_region = rect();
 	}
 	else
 	{
 		// Make sure not to use a bigger draw rect than necessary
-		dirty_rect = dirty_rect.intersected(rect());
+		dirty_region &= rect();
 	}
-		
-	// Start drawing
-	QPainter painter(&cache);
-	painter.setClipRect(dirty_rect);
 	
-	// Fill with background color (TODO: make configurable)
-	if (use_background)
-		painter.fillRect(dirty_rect, Qt::white);
-	else
+	for (auto const& dirty_rect : dirty_region.rects())
 	{
-		QPainter::CompositionMode mode = painter.compositionMode();
-		painter.setCompositionMode(QPainter::CompositionMode_Clear);
-		painter.fillRect(dirty_rect, Qt::transparent);
-		painter.setCompositionMode(mode);
+		if (performance_hud)
+			performance_hud->addDirtyArea(dirty_rect);
+		
+		cache.paint(dirty_rect, [this, first_template, last_template, use_background](QPainter& painter, const QRect& part) {
+			// Fill with background color (TODO: make configurable)
+			if (use_background)
+				painter.fillRect(part, Qt::white);
+			else
+			{
+				QPainter::CompositionMode mode = painter.compositionMode();
+				painter.setCompositionMode(QPainter::CompositionMode_Clear);
+				painter.fillRect(part, Qt::transparent);
+				painter.setCompositionMode(mode);
+			}
+			
+			// Draw templates
+			if (!drawTemplateLayers(painter, part, first_template, last_template))
+			{
+				painter.translate(width() / 2.0, height() / 2.0);
+				painter.setWorldTransform(view->worldTransform(), true);
+				
+				Map* map = view->getMap();
+				QRectF map_view_rect = view->calculateViewedRect(viewportToView(part));
+				
+				map->drawTemplates(&painter, map_view_rect, first_template, last_template, view, true);
+			}
+		});
 	}
 	
-	// Draw templates
-	painter.translate(width() / 2.0, height() / 2.0);
-	painter.setWorldTransform(view->worldTransform(), true);
-	
-	Map* map = view->getMap();
-	QRectF map_view_rect = view->calculateViewedRect(viewportToView(dirty_rect));
-	
-	map->drawTemplates(&painter, map_view_rect, first_template, last_template, view, true);
-	
-	dirty_rect.setWidth(-1); // => !dirty_rect.isValid()
+	dirty_region = QRegion();
 }
 
-void MapWidget::updateMapCache(bool use_background)
+bool MapWidget::drawTemplateLayers(QPainter& painter, const QRect& dirty_rect, int first_template, int last_template)
 {
-	if (map_cache.isNull())
+	Map* map = view->getMap();
+	auto visible_templates = 0;
+	for (int i = first_template; i <= last_template; ++i)
 	{
-		// Lazy allocation of cache image
-		map_cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
-		map_cache_dirty_rect = rect();
+		if (view->isTemplateDisplayed(map->getTemplate(i)))
+			++visible_templates;
 	}
-	else
+	if (visible_templates > max_template_layers)
+		return false;
+	if (Settings::getInstance().getSettingCached(Settings::MapDisplay_LowMemory).toBool())
 	{
-		// Make sure not to use a bigger draw rect than necessary
-		map_cache_dirty_rect = map_cache_dirty_rect.intersected(rect());
+		template_layers.clear();
+		return false;
 	}
 	
-	// Start drawing
-	QPainter painter;
-	painter.begin(&map_cache);
-	painter.setClipRect(map_cache_dirty_rect);
-	
-	// Fill with background color (TODO: make configurable)
-	if (use_background)
+	// Drop the layers of hidden templates when there are too many layers.
+	if (template_layers.size() + visible_templates > max_template_layers)
 	{
-		painter.fillRect(map_cache_dirty_rect, Qt::white);
+		for (auto layer = template_layers.begin(); layer != template_layers.end(); )
+		{
+			if (view->isTemplateDisplayed(layer.key()))
+				++layer;
+			else
+				layer = template_layers.erase(layer);
+		}
 	}
-	else
+	
+	for (int i = first_template; i <= last_template; ++i)
 	{
-		QPainter::CompositionMode mode = painter.compositionMode();
-		painter.setCompositionMode(QPainter::CompositionMode_Clear);
-		painter.fillRect(map_cache_dirty_rect, Qt::transparent);
-		painter.setCompositionMode(mode);
+		auto const* temp = map->getTemplate(i);
+		if (!view->isTemplateDisplayed(temp))
+			continue;
+		
+		auto& layer = template_layers[temp];
+		if (layer.image.isNull() || layer.image.size() != size())
+		{
+			allocateCache(layer.image);
+			layer.dirty_region = rect();
+		}
+		for (auto const& layer_rect : layer.dirty_region.intersected(rect()).rects())
+		{
+			layer.image.paint(layer_rect, [this, map, i](QPainter& layer_painter, const QRect& part) {
+				layer_painter.setCompositionMode(QPainter::CompositionMode_Clear);
+				layer_painter.fillRect(part, Qt::transparent);
+				layer_painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+				
+				layer_painter.translate(width() / 2.0, height() / 2.0);
+				layer_painter.setWorldTransform(view->worldTransform(), true);
+				QRectF map_view_rect = view->calculateViewedRect(viewportToView(part));
+				map->drawTemplates(&layer_painter, map_view_rect, i, i, view, true, true);
+			});
+		}
+		layer.dirty_region = QRegion();
+		
+		painter.setOpacity(view->getTemplateVisibility(temp).opacity);
+		layer.image.draw(painter, dirty_rect);
 	}
+	painter.setOpacity(1);
+	return true;
+}
+
+void MapWidget::updateMapCache()
+{
+	MAPPER_TRACE_SCOPE("MapWidget::updateMapCache");
 	
-	RenderConfig::Options options(RenderConfig::Screen | RenderConfig::HelperSymbols);
+	RenderConfig::Options options(RenderConfig::Screen | RenderConfig::HelperSymbols | RenderConfig::BatchedDrawing);
 	bool use_antialiasing = force_antialiasing || Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool();
-	if (use_antialiasing)
-		painter.setRenderHint(QPainter::Antialiasing);
-	else
+	if (!use_antialiasing)
 		options |= RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
-		
+	
+	auto overprinting_simulation = false;
+#ifndef Q_OS_ANDROID
+	overprinting_simulation = view->isOverprintingSimulationEnabled();
+#endif
+	
 	Map* map = view->getMap();
-	QRectF map_view_rect = view->calculateViewedRect(viewportToView(map_cache_dirty_rect));
-
-	RenderConfig config = { *map, map_view_rect, view->calculateFinalZoomFactor(), options, 1.0 };
+	auto const viewport_transform = view->worldTransform()
+	                                * QTransform::fromTranslate(width() / 2.0, height() / 2.0)
+	                                * QTransform::fromScale(cache_resolution, cache_resolution);
+	auto const cache_options = int(options) | (overprinting_simulation ? 0x10000 : 0);
+	if (cache_options != map_cache_options
+	    || !updateCacheOffset(*map_cache, viewport_transform, map_cache_offset))
+	{
+		// Release the current cache, so that the store may reuse it.
+		auto cache = map_cache;
+		setMapCache({});
+		setMapCache(map->tileStore().acquire(viewport_transform, cache_options, std::move(cache)));
+		map_cache_options = cache_options;
+		updateCacheOffset(*map_cache, viewport_transform, map_cache_offset);
+	}
+	
+	// The overprinting simulation draws the frozen parts into the map cache.
+	if (overprinting_simulation || !map->hasFrozenParts())
+	{
+		setFrozenCache({});
+		frozen_snapshot.reset();
+	}
+	else if (!frozen_cache
+	         || cache_options != frozen_cache_options
+	         || !updateCacheOffset(*frozen_cache, viewport_transform, frozen_cache_offset))
+	{
+		auto cache = frozen_cache;
+		setFrozenCache({});
+		setFrozenCache(map->frozenTileStore().acquire(viewport_transform, cache_options, std::move(cache)));
+		frozen_cache_options = cache_options;
+		updateCacheOffset(*frozen_cache, viewport_transform, frozen_cache_offset);
+	}
+	
+	auto const scaling = view->calculateFinalZoomFactor();
+	RenderConfig const tile_config = { *map, {}, scaling, options, 1.0 };
+	
+	if (frozen_cache)
+		renderTiles(*frozen_cache, frozen_cache_offset, frozen_snapshot, &Map::createFrozenRenderablesSnapshot, tile_config, use_antialiasing);
 	
-	painter.translate(width() / 2.0, height() / 2.0);
-	painter.setWorldTransform(view->worldTransform(), true);
 #ifndef Q_OS_ANDROID
-	if (view->isOverprintingSimulationEnabled())
-		map->drawOverprintingSimulation(&painter, config);
-	else
+	if (overprinting_simulation)
+	{
+		auto const grid_rect = toImagePixels(rect(), cache_resolution).toAlignedRect().translated(-map_cache_offset);
+		auto const pending_area = map_cache->pendingArea(grid_rect);
+		if (!pending_area.isValid())
+			return;
+		
+		if (performance_hud)
+			performance_hud->addDirtyArea(pending_area);
+		
+		// The overprinting simulation draws from the map directly.
+		map_cache->render(grid_rect, [map, scaling, options, use_antialiasing](QPainter& painter, const QRectF& map_rect) {
+			if (use_antialiasing)
+				painter.setRenderHint(QPainter::Antialiasing);
+			RenderConfig config = { *map, map_rect, scaling, options, 1.0 };
+			map->drawOverprintingSimulation(&painter, config);
+		}, false, this);
+		return;
+	}
 #endif
-		map->draw(&painter, config);
 	
-	if (view->isGridVisible())
-		map->drawGrid(&painter, map_view_rect);
+	renderTiles(*map_cache, map_cache_offset, map_snapshot, &Map::createRenderablesSnapshot, tile_config, use_antialiasing);
+}
+
+void MapWidget::renderTiles(MapTileCache& cache, QPoint cache_offset, std::shared_ptr<const RenderablesSnapshot>& snapshot,
+                            std::shared_ptr<const RenderablesSnapshot> (Map::*create_snapshot)(const RenderConfig&),
+                            const RenderConfig& tile_config, bool use_antialiasing)
+{
+	auto const grid_rect = toImagePixels(rect(), cache_resolution).toAlignedRect().translated(-cache_offset);
+	auto const pending_area = cache.pendingArea(grid_rect);
+	if (!pending_area.isValid())
+		return;
+	
+	if (performance_hud)
+		performance_hud->addDirtyArea(pending_area);
 	
-	// Finish drawing
-	painter.end();
+	auto* map = view->getMap();
+	auto const to_map = cache.layout().inverted();
+	if (!snapshot || !snapshot->getBoundingBox().contains(to_map.mapRect(QRectF(pending_area))))
+	{
+		// Cover an extra tile around the viewport, for panning.
+		auto const margin = MapTileCache::tile_size;
+		auto const snapshot_rect = pending_area.united(grid_rect).adjusted(-margin, -margin, margin, margin);
+		RenderConfig snapshot_config = { *map, to_map.mapRect(QRectF(snapshot_rect)), tile_config.scaling, tile_config.options, 1.0 };
+		snapshot = (map->*create_snapshot)(snapshot_config);
+	}
 	
-	map_cache_dirty_rect.setWidth(-1); // => !map_cache_dirty_rect.isValid()
+	auto const render_snapshot = snapshot;
+	auto const scaling = tile_config.scaling;
+	auto const options = tile_config.options;
+	cache.render(grid_rect, [map, render_snapshot, scaling, options, use_antialiasing](QPainter& painter, const QRectF& map_rect) {
+		if (use_antialiasing)
+			painter.setRenderHint(QPainter::Antialiasing);
+		RenderConfig config = { *map, map_rect, scaling, options, 1.0 };
+		render_snapshot->draw(&painter, config);
+	}, true, this);
 }
 
-void MapWidget::updateAllDirtyCaches()
+void MapWidget::setMapCache(std::shared_ptr<MapTileCache> cache)
 {
-	if (map_cache_dirty_rect.isValid())
-		updateMapCache(false);
+	if (cache == map_cache)
+		return;
 	
-	if (!view->areAllTemplatesHidden())
+	if (map_cache)
 	{
-		if (below_template_cache_dirty_rect.isValid() && isBelowTemplateVisible())
-			updateTemplateCache(below_template_cache, below_template_cache_dirty_rect, 0, view->getMap()->getFirstFrontTemplate() - 1, true);
-		
-		if (above_template_cache_dirty_rect.isValid() && isAboveTemplateVisible())
-			updateTemplateCache(above_template_cache, above_template_cache_dirty_rect, view->getMap()->getFirstFrontTemplate(), view->getMap()->getNumTemplates() - 1, false);
+		map_cache->removeClient(this);
+		disconnect(map_cache.get(), &MapTileCache::tilesReady, this, &MapWidget::mapTilesReady);
 	}
+	map_cache = std::move(cache);
+	map_cache_options = -1;
+	if (map_cache)
+		connect(map_cache.get(), &MapTileCache::tilesReady, this, &MapWidget::mapTilesReady);
+}
+
+void MapWidget::setFrozenCache(std::shared_ptr<MapTileCache> cache)
+{
+	if (cache == frozen_cache)
+		return;
+	
+	if (frozen_cache)
+	{
+		frozen_cache->removeClient(this);
+		disconnect(frozen_cache.get(), &MapTileCache::tilesReady, this, &MapWidget::frozenTilesReady);
+	}
+	frozen_cache = std::move(cache);
+	frozen_cache_options = -1;
+	if (frozen_cache)
+		connect(frozen_cache.get(), &MapTileCache::tilesReady, this, &MapWidget::frozenTilesReady);
+}
+
+qreal MapWidget::targetCacheResolution() const
+{
+	auto const device_pixel_ratio = devicePixelRatioF();
+	if (zoom_idle_timer->isActive())
+		return std::min(device_pixel_ratio, qreal(1));
+	return device_pixel_ratio;
+}
+
+void MapWidget::updateCacheResolution()
+{
+	auto const resolution = targetCacheResolution();
+	if (resolution == cache_resolution)
+		return;
+	
+	cache_resolution = resolution;
+	below_template_cache.clear();
+	below_template_cache_dirty_region = rect();
+	above_template_cache.clear();
+	above_template_cache_dirty_region = rect();
+	template_layers.clear();
+}
+
+void MapWidget::allocateCache(ViewportCache& cache, bool opaque) const
+{
+	auto format = QImage::Format_ARGB32_Premultiplied;
+	if (opaque && Settings::getInstance().getSettingCached(Settings::MapDisplay_LowMemory).toBool())
+		format = QImage::Format_RGB16;
+	cache.allocate(size(), cache_resolution, format);
 }
 
-void MapWidget::shiftCache(int sx, int sy, QImage& cache)
+void MapWidget::scrollTemplateCaches()
 {
-	if (!cache.isNull())
+	auto const transform = view->worldTransform() * QTransform::fromTranslate(width() / 2.0, height() / 2.0);
+	auto const shift = QPointF{ transform.dx() - template_cache_transform.dx(), transform.dy() - template_cache_transform.dy() };
+	auto const offset = shift.toPoint();
+	if (transform.m11() != template_cache_transform.m11() || transform.m12() != template_cache_transform.m12()
+	    || transform.m21() != template_cache_transform.m21() || transform.m22() != template_cache_transform.m22()
+	    || std::abs(shift.x() - offset.x()) > 0.25
+	    || std::abs(shift.y() - offset.y()) > 0.25
+	    || cache_resolution != std::floor(cache_resolution))
 	{
-		QImage new_cache(cache.size(), cache.format());
-		QPainter painter(&new_cache);
-		painter.setCompositionMode(QPainter::CompositionMode_Source);
-		painter.drawImage(sx, sy, cache);
-		painter.end();
-		cache = new_cache;
+		// Not a plain scroll by whole pixels
+		template_cache_transform = transform;
+		below_template_cache_dirty_region = rect();
+		above_template_cache_dirty_region = rect();
+		markTemplateLayersDirty(rect());
+		return;
 	}
+	
+	// Keep the subpixel remainder, so that it cannot accumulate.
+	template_cache_transform *= QTransform::fromTranslate(offset.x(), offset.y());
+	
+	auto const scroll = [this, offset](ViewportCache& cache, QRegion& dirty_region) {
+		auto const exposed = cache.scroll(offset);
+		dirty_region = dirty_region.translated(offset).intersected(rect()) | exposed;
+	};
+	scroll(below_template_cache, below_template_cache_dirty_region);
+	scroll(above_template_cache, above_template_cache_dirty_region);
+	for (auto& layer : template_layers)
+		scroll(layer.image, layer.dirty_region);
 }
 
-void MapWidget::shiftCache(int sx, int sy, QPixmap& cache)
+void MapWidget::updateAllDirtyCaches()
 {
-	if (!cache.isNull())
+	updateCacheResolution();
+	
+	QElapsedTimer timer;
+	auto const measure = [this, &timer](PerformanceHud::Cache cache) {
+		if (performance_hud)
+			performance_hud->addCacheTime(cache, timer.nsecsElapsed());
+	};
+	
+	if (view->effectiveMapVisibility().visible)
 	{
-		cache.scroll(sx, sy, cache.rect());
+		timer.start();
+		updateMapCache();
+		measure(PerformanceHud::MapCache);
 	}
+	
+	if (!view->areAllTemplatesHidden())
+	{
+		if (!below_template_cache_dirty_region.isEmpty() && isBelowTemplateVisible())
+		{
+			timer.start();
+			updateTemplateCache(below_template_cache, below_template_cache_dirty_region, 0, view->getMap()->getFirstFrontTemplate() - 1, true);
+			measure(PerformanceHud::BelowTemplateCache);
+		}
+		
+		if (!above_template_cache_dirty_region.isEmpty() && isAboveTemplateVisible())
+		{
+			timer.start();
+			updateTemplateCache(above_template_cache, above_template_cache_dirty_region, view->getMap()->getFirstFrontTemplate(), view->getMap()->getNumTemplates() - 1, false);
+			measure(PerformanceHud::AboveTemplateCache);
+		}
+	}
+}
+
+void MapWidget::mapTilesReady(const QRect& grid_rect)
+{
+	if (pinching)
+		update();
+	else
+		update(toImagePixels(grid_rect.translated(map_cache_offset), 1 / cache_resolution).toAlignedRect().translated(pan_offset));
+}
+
+void MapWidget::frozenTilesReady(const QRect& grid_rect)
+{
+	if (pinching)
+		update();
+	else
+		update(toImagePixels(grid_rect.translated(frozen_cache_offset), 1 / cache_resolution).toAlignedRect().translated(pan_offset));
 }
 
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -23,25 +23,36 @@
 #define OPENORIENTEERING_MAP_WIDGET_H
 
 #include <functional>
+#include <memory>
 
 #include <Qt>
 #include <QtGlobal>
 #include <QCursor>
+#include <QHash>
 #include <QImage>
 #include <QObject>
 #include <QPoint>
 #include <QPointF>
 #include <QRect>
 #include <QRectF>
+#include <QRegion>
 #include <QScopedPointer>
 #include <QSize>
 #include <QString>
 #include <QTime>
+#include <QTransform>
 #include <QVariant>
 #include <QWidget>
 
+#ifdef MAPPER_ENABLE_OPENGL
+#  include <QOpenGLWidget>
+#endif
+
 #include "core/map_coord.h"
+#include "core/map_grid.h"
 #include "core/map_view.h"
+#include "gui/map/map_tile_cache.h"
+#include "gui/map/viewport_cache.h"
 
 class QContextMenuEvent;
 class QEvent;
@@ -53,21 +64,36 @@ class QLabel;
 class QMouseEvent;
 class QPaintEvent;
 class QPainter;
-class QPixmap;
 class QResizeEvent;
+class QTimer;
 class QWheelEvent;
 
 namespace OpenOrienteering {
 
+class GeographicApproximation;
+class Georeferencing;
 class GPSDisplay;
 class GPSTemporaryMarkers;
 class MapEditorActivity;
 class MapEditorTool;
+class PerformanceHud;
 class PieMenu;
+class Map;
+class RenderConfig;
+class RenderablesSnapshot;
 class Template;
 class TouchCursor;
 
 
+#ifdef MAPPER_ENABLE_OPENGL
+/// The base class of MapWidget, composing on the GPU.
+using MapWidgetBase = QOpenGLWidget;
+#else
+/// The base class of MapWidget, composing with the raster paint engine.
+using MapWidgetBase = QWidget;
+#endif
+
+
 /**
  * QWidget for displaying a map. Needs a pointer to a MapView which defines
  * the view properties.
@@ -82,8 +108,13 @@ class TouchCursor;
  * <li>The <b>above template cache</b> contains the currently
  *     visible part of all templates above the map</li>
  * </ul>
+ * 
+ * When built with MAPPER_ENABLE_OPENGL, the widget is a QOpenGLWidget. The
+ * caches are still rendered by the raster engine, but the OpenGL paint engine
+ * keeps the unchanged cache images as textures, so that panning and zooming
+ * is composed on the GPU.
  */
-class MapWidget : public QWidget
+class MapWidget : public MapWidgetBase
 {
 Q_OBJECT
 friend class MapView;
@@ -232,6 +263,20 @@ public:
 	 */
 	void markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache);
 	
+	/**
+	 * Mark a rectangular region of the cached layer of a single template as
+	 * dirty, i.e. the template must be drawn again.
+	 * 
+	 * This must be called when the template's appearance changes, even if it
+	 * is hidden. It does not affect the template caches which are composed
+	 * from the layers, cf. markTemplateCacheDirty().
+	 * @param temp The template which changed.
+	 * @param view_rect Affected rect in view coordinates.
+	 * @param pixel_border Additional affected extent around the view rect in
+	 *     pixels. Allows to specify zoom-independent extents.
+	 */
+	void markTemplateLayerDirty(const Template* temp, const QRectF& view_rect, int pixel_border);
+	
 	/**
 	 * Mark a rectangular region given in map coordinates of the map cache
 	 * as dirty, i.e. redraw needed.
@@ -239,6 +284,12 @@ public:
 	 */
 	void markObjectAreaDirty(const QRectF& map_rect);
 	
+	/**
+	 * Mark a rectangular region given in map coordinates of the frozen map
+	 * parts as dirty, cf. markObjectAreaDirty().
+	 */
+	void markFrozenAreaDirty(const QRectF& map_rect);
+	
 	/**
 	 * Set the given rect as bounding box for the current drawing, i.e. the
 	 * graphical display of the active tool.
@@ -295,6 +346,13 @@ public:
 	 */
 	void updateEverythingInRect(const QRect& dirty_rect);
 	
+	/**
+	 * Drops all caches, in order to release memory.
+	 * 
+	 * The caches are rendered again when the widget is drawn.
+	 */
+	void releaseCaches();
+	
 	/**
 	 * Sets the function which will be called to display zoom information.
 	 */
@@ -354,6 +412,9 @@ public slots:
 	/** Enables or disables the touch cursor. */
 	void enableTouchCursor(bool enabled);
 	
+	/** Shows or hides the overlay with performance information. */
+	void setPerformanceHudVisible(bool visible);
+	
 signals:
 	/**
 	 * Support function for input methods.
@@ -362,13 +423,21 @@ signals:
 	
 private slots:
 	void updateDrawingLaterSlot();
+	/** Triggers a redraw of the map tiles which were rendered in the background. */
+	void mapTilesReady(const QRect& grid_rect);
+	/** Triggers a redraw of the frozen tiles which were rendered in the background. */
+	void frozenTilesReady(const QRect& grid_rect);
 	
 protected:
 	bool event(QEvent *event) override;
 	
 	virtual void gestureEvent(QGestureEvent* event);
 	
+#ifdef MAPPER_ENABLE_OPENGL
+	void paintGL() override;
+#else
 	void paintEvent(QPaintEvent* event) override;
+#endif
 	void resizeEvent(QResizeEvent* event) override;
 	
 	// Mouse input
@@ -390,6 +459,11 @@ protected:
 	void contextMenuEvent(QContextMenuEvent* event) override;
 	
 private:
+	/**
+	 * Draws the caches and overlays for the exposed part of the widget.
+	 */
+	void drawViewport(QPainter& painter, const QRect& exposed);
+	
 	void updatePlaceholder();
 	
 	/** Checks if there is a visible template in the range
@@ -401,25 +475,91 @@ private:
 	bool isBelowTemplateVisible() const;
 	/**
 	 * Redraws the template cache.
-	 * @param cache Reference to pointer to the cache.
-	 * @param dirty_rect Rectangle of the cache to redraw, in viewport coordinates.
+	 * @param cache Reference to the cache.
+	 * @param dirty_region Region of the cache to redraw, in viewport coordinates.
 	 * @param first_template Lowest template index to draw.
 	 * @param last_template Highest template index to draw.
 	 * @param use_background If set to true, fills the cache with white before
 	 *     drawing the templates, else makes it transparent.
 	 */
-	void updateTemplateCache(QImage& cache, QRect& dirty_rect, int first_template, int last_template, bool use_background);
+	void updateTemplateCache(ViewportCache& cache, QRegion& dirty_region, int first_template, int last_template, bool use_background);
 	/**
-	 * Redraws the map cache in the map cache dirty rect.
-	 * @param use_background If set to true, fills the cache with white before
-	 *     drawing the map, else makes it transparent.
+	 * Composes the visible templates of the given range from their layers.
+	 * 
+	 * Layers are drawn as needed. The painter must be clipped to dirty_rect,
+	 * in viewport coordinates. Returns false, without drawing, if there are
+	 * more visible templates than the number of layers which may be cached.
+	 */
+	bool drawTemplateLayers(QPainter& painter, const QRect& dirty_rect, int first_template, int last_template);
+	/**
+	 * Marks the given region, in viewport coordinates, as dirty for all
+	 * template layers.
+	 */
+	void markTemplateLayersDirty(const QRect& dirty_rect);
+	/**
+	 * Returns the viewport rectangle which is covered by a view rectangle
+	 * and a border in pixels.
 	 */
-	void updateMapCache(bool use_background);
+	QRect templateCacheRect(const QRectF& view_rect, int pixel_border) const;
+	/**
+	 * Adjusts the map cache to the view and renders missing and invalidated
+	 * tiles in the viewport.
+	 * 
+	 * Unless overprinting simulation is enabled, missing tiles are rendered
+	 * in the background, from a snapshot of the map. Frozen map parts are
+	 * rendered into a separate cache from the map's frozen tile store.
+	 * 
+	 * The cache is taken from the map's MapTileStore, so that widgets with
+	 * the same layout and render options share their tiles.
+	 */
+	void updateMapCache();
+	/** Replaces the map cache, and connects to the new cache, if not null. */
+	void setMapCache(std::shared_ptr<MapTileCache> cache);
+	/** Replaces the cache of the frozen parts, and connects to the new cache, if not null. */
+	void setFrozenCache(std::shared_ptr<MapTileCache> cache);
+	/**
+	 * Renders the pending tiles of the given cache from the snapshot.
+	 * 
+	 * When the snapshot does not cover the pending tiles, it is replaced
+	 * by a new one from the given snapshot function.
+	 */
+	void renderTiles(MapTileCache& cache, QPoint cache_offset, std::shared_ptr<const RenderablesSnapshot>& snapshot,
+	                 std::shared_ptr<const RenderablesSnapshot> (Map::*create_snapshot)(const RenderConfig&),
+	                 const RenderConfig& tile_config, bool use_antialiasing);
 	/** Redraws all dirty caches. */
 	void updateAllDirtyCaches();
-	/** Shifts the content in the cache by the given amount of pixels. */
-	void shiftCache(int sx, int sy, QImage& cache);
-	void shiftCache(int sx, int sy, QPixmap& cache);
+	
+	/**
+	 * Returns the resolution which the caches shall use now.
+	 * 
+	 * While the user is zooming, the caches are rendered in widget pixels.
+	 * When the view is idle, they are rendered in device pixels.
+	 */
+	qreal targetCacheResolution() const;
+	
+	/**
+	 * Adjusts the resolution of the caches to targetCacheResolution().
+	 * 
+	 * Changing the resolution drops the template caches. The map tiles are
+	 * replaced via the layout of the map cache.
+	 */
+	void updateCacheResolution();
+	
+	/**
+	 * Allocates a template cache image for the current size and resolution.
+	 * 
+	 * With the low-memory display setting, opaque caches use 16 bits per pixel.
+	 */
+	void allocateCache(ViewportCache& cache, bool opaque = false) const;
+	
+	/**
+	 * Adjusts the template caches to a change of the view.
+	 * 
+	 * When the view was only moved by whole cache pixels, the template caches
+	 * and layers are scrolled, and only the exposed strips are marked dirty.
+	 * Otherwise, the template caches are marked dirty entirely.
+	 */
+	void scrollTemplateCaches();
 	
 	/**
 	 * Calculates the bounding box of the given map coordinates rect and
@@ -467,6 +607,13 @@ private:
 	void updateZoomDisplay();
 	/** Updates the content of the cursorpos label, set by setCursorposLabel(). */
 	void updateCursorposLabel(const MapCoordF& pos);
+	/**
+	 * Returns the approximation of the given georeferencing for the cursor
+	 * position.
+	 * 
+	 * The approximation is reset when the georeferencing changes.
+	 */
+	GeographicApproximation& geographicApproximation(const Georeferencing& georef);
 	
 	MapView* view;
 	MapEditorTool* tool;
@@ -478,6 +625,7 @@ private:
 	QLabel* cursorpos_label;
 	QLabel* objecttag_label;
 	MapCoordF last_cursor_pos;
+	std::unique_ptr<GeographicApproximation> geographic_approximation;  ///< For the cursor position
 	
 	bool show_help;
 	bool force_antialiasing;
@@ -498,16 +646,50 @@ private:
 	
 	// Template caches
 	/** Cache for templates below map layer */
-	QImage below_template_cache;
-	QRect below_template_cache_dirty_rect;
+	ViewportCache below_template_cache;
+	QRegion below_template_cache_dirty_region;
 	
 	/** Cache for templates above map layer */
-	QImage above_template_cache;
-	QRect above_template_cache_dirty_rect;
+	ViewportCache above_template_cache;
+	QRegion above_template_cache_dirty_region;
 	
-	/** Map layer cache  */
-	QImage map_cache;
-	QRect map_cache_dirty_rect;
+	/** Cache for the lines of the map grid, drawn on top of the map layer */
+	MapGridCache grid_cache;
+	
+	/** A cached rendering of a single template, at full opacity */
+	struct TemplateLayer
+	{
+		ViewportCache image;
+		QRegion dirty_region;
+	};
+	/** Layers of single templates, composed into the template caches */
+	QHash<const Template*, TemplateLayer> template_layers;
+	
+	/** The transformation from map to viewport which the template caches were rendered for */
+	QTransform template_cache_transform;
+	
+	/** Map layer cache, in tiles, possibly shared with other widgets */
+	std::shared_ptr<MapTileCache> map_cache;
+	/** The render options which the map cache was acquired for */
+	int map_cache_options = -1;
+	/** Offset from map cache grid pixels to viewport pixels, in cache pixels */
+	QPoint map_cache_offset;
+	
+	/** The resolution of all caches, in cache pixels per widget pixel */
+	qreal cache_resolution = 1;
+	/** Active while interactive zooming is assumed to continue */
+	QTimer* zoom_idle_timer;
+	/** The map state for rendering map tiles in the background */
+	std::shared_ptr<const RenderablesSnapshot> map_snapshot;
+	
+	/** Cache for the frozen map parts, drawn below the map cache, or null */
+	std::shared_ptr<MapTileCache> frozen_cache;
+	/** The render options which the frozen cache was acquired for */
+	int frozen_cache_options = -1;
+	/** Offset from frozen cache grid pixels to viewport pixels, in cache pixels */
+	QPoint frozen_cache_offset;
+	/** The state of the frozen parts for rendering tiles in the background */
+	std::shared_ptr<const RenderablesSnapshot> frozen_snapshot;
 	
 	// Dirty regions for drawings (tools) and activities
 	/** Dirty rect for the current tool, in viewport coordinates (pixels). */
@@ -537,6 +719,9 @@ private:
 	/** Optional touch cursor for mobile devices */
 	QScopedPointer<TouchCursor> touch_cursor;
 	
+	/** Optional overlay with performance information */
+	std::unique_ptr<PerformanceHud> performance_hud;
+	
 	/** For checking for interaction with the widget: the last QTime where
 	 *  a mouse release event happened. Check for current_pressed_buttons == 0
 	 *  and a last_mouse_release_time a given time interval in the past to check
@@ -0,0 +1,142 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "performance_hud.h"
+
+#include <algorithm>
+
+#include <Qt>
+#include <QColor>
+#include <QFontMetrics>
+#include <QLocale>
+#include <QPainter>
+#include <QString>
+
+#include "util/performance_counters.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+constexpr int hud_margin = 8;
+constexpr int hud_padding = 4;
+constexpr int num_lines = 7;
+
+QString milliseconds(qint64 nsecs)
+{
+	return QLocale().toString(nsecs / 1e6, 'f', 1);
+}
+
+}  // namespace
+
+
+
+PerformanceHud::PerformanceHud(const QFont& font)
+: font(font)
+{
+	lines.reserve(num_lines);
+	for (int i = 0; i < num_lines; ++i)
+		lines.append(QString{});
+	
+	// The initial size, for values up to 7 digits
+	QFontMetrics const metrics(font);
+	auto const width = metrics.width(tr("Renderables: %1 drawn of %2").arg(9999999).arg(9999999));
+	hud_rect = QRect(hud_margin, hud_margin,
+	                 width + 2 * hud_padding,
+	                 num_lines * metrics.lineSpacing() + 2 * hud_padding);
+	
+	auto const& counters = Util::PerformanceCounters::instance();
+	renderables_visited = counters.renderables_visited.load(std::memory_order_relaxed);
+	renderables_drawn = counters.renderables_drawn.load(std::memory_order_relaxed);
+	object_updates = counters.object_updates.load(std::memory_order_relaxed);
+	
+	frame_timer.invalidate();
+}
+
+
+void PerformanceHud::beginFrame()
+{
+	frame_timer.start();
+	std::fill(std::begin(cache_nsecs), std::end(cache_nsecs), 0);
+	dirty_area = 0;
+}
+
+void PerformanceHud::addCacheTime(Cache cache, qint64 nsecs)
+{
+	cache_nsecs[cache] += nsecs;
+}
+
+void PerformanceHud::addDirtyArea(const QRect& rect)
+{
+	if (rect.isValid())
+		dirty_area += qint64(rect.width()) * rect.height();
+}
+
+void PerformanceHud::endFrame()
+{
+	if (!frame_timer.isValid())
+		return;
+	
+	auto const& counters = Util::PerformanceCounters::instance();
+	auto const visited = counters.renderables_visited.load(std::memory_order_relaxed);
+	auto const drawn = counters.renderables_drawn.load(std::memory_order_relaxed);
+	auto const updates = counters.object_updates.load(std::memory_order_relaxed);
+	
+	auto const locale = QLocale();
+	lines[0] = tr("Frame: %1 ms").arg(milliseconds(frame_timer.nsecsElapsed()));
+	lines[1] = tr("Map cache: %1 ms").arg(milliseconds(cache_nsecs[MapCache]));
+	lines[2] = tr("Templates below: %1 ms").arg(milliseconds(cache_nsecs[BelowTemplateCache]));
+	lines[3] = tr("Templates above: %1 ms").arg(milliseconds(cache_nsecs[AboveTemplateCache]));
+	lines[4] = tr("Dirty area: %1 px").arg(locale.toString(dirty_area));
+	lines[5] = tr("Renderables: %1 drawn of %2").arg(locale.toString(qulonglong(drawn - renderables_drawn)),
+	                                                 locale.toString(qulonglong(visited - renderables_visited)));
+	lines[6] = tr("Object updates: %1").arg(locale.toString(qulonglong(updates - object_updates)));
+	
+	renderables_visited = visited;
+	renderables_drawn = drawn;
+	object_updates = updates;
+	frame_timer.invalidate();
+}
+
+
+void PerformanceHud::paint(QPainter* painter)
+{
+	QFontMetrics const metrics(font);
+	auto width = hud_rect.width() - 2 * hud_padding;
+	for (auto const& line : lines)
+		width = std::max(width, metrics.width(line));
+	hud_rect.setWidth(width + 2 * hud_padding);
+	
+	painter->save();
+	painter->fillRect(hud_rect, QColor(0, 0, 0, 160));
+	painter->setPen(Qt::white);
+	painter->setFont(font);
+	auto baseline = hud_rect.top() + hud_padding + metrics.ascent();
+	for (auto const& line : lines)
+	{
+		painter->drawText(hud_rect.left() + hud_padding, baseline, line);
+		baseline += metrics.lineSpacing();
+	}
+	painter->restore();
+}
+
+
+}  // namespace OpenOrienteering
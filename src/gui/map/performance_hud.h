@@ -0,0 +1,101 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_PERFORMANCE_HUD_H
+#define OPENORIENTEERING_PERFORMANCE_HUD_H
+
+#include <cstdint>
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFont>
+#include <QRect>
+#include <QStringList>
+
+class QPainter;
+
+namespace OpenOrienteering {
+
+
+/**
+ * An overlay which shows the cost of the last frame of a map widget.
+ * 
+ * A frame is a paint event which is not just a refresh of the overlay
+ * itself. The overlay shows the time spent in the paint event and in
+ * updating the map and template caches, the number of renderables which
+ * were visited and drawn, the area of the caches which was drawn, and the
+ * number of object updates, cf. Util::PerformanceCounters.
+ * 
+ * Map tiles which are rendered in the background are counted in the frame
+ * which follows their rendering, but their time is not included in the
+ * map cache time.
+ */
+class PerformanceHud
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::PerformanceHud)
+	
+public:
+	/** The caches which are timed. */
+	enum Cache
+	{
+		MapCache = 0,
+		BelowTemplateCache,
+		AboveTemplateCache,
+		NumCaches
+	};
+	
+	explicit PerformanceHud(const QFont& font);
+	
+	/** Returns the area covered by the overlay, in viewport coordinates. */
+	QRect rect() const { return hud_rect; }
+	
+	/** Starts measuring a frame. */
+	void beginFrame();
+	
+	/** Adds the time spent in updating the given cache during this frame. */
+	void addCacheTime(Cache cache, qint64 nsecs);
+	
+	/** Adds the area of a cache which was drawn during this frame. */
+	void addDirtyArea(const QRect& rect);
+	
+	/** Finishes measuring a frame, and updates the displayed values. */
+	void endFrame();
+	
+	/** Draws the overlay, in viewport coordinates. */
+	void paint(QPainter* painter);
+	
+private:
+	QFont font;
+	QRect hud_rect;
+	QStringList lines;
+	
+	QElapsedTimer frame_timer;
+	qint64 cache_nsecs[NumCaches] = {};
+	qint64 dirty_area = 0;
+	std::uint64_t renderables_visited = 0;
+	std::uint64_t renderables_drawn = 0;
+	std::uint64_t object_updates = 0;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
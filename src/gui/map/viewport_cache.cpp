@@ -0,0 +1,137 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "viewport_cache.h"
+
+#include <cstdlib>
+
+#include <QPainter>
+#include <QRectF>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// Returns the value modulo divisor, in the range [0, divisor).
+int wrap(int value, int divisor)
+{
+	auto const result = value % divisor;
+	return result < 0 ? result + divisor : result;
+}
+
+}  // namespace
+
+
+
+void ViewportCache::clear()
+{
+	image = {};
+	viewport_size = {};
+	origin = {};
+}
+
+void ViewportCache::allocate(const QSize& size, qreal resolution, QImage::Format format)
+{
+	this->resolution = resolution;
+	viewport_size = size;
+	origin = {};
+	image = QImage(QRectF(QPointF(), QSizeF(size) * resolution).toAlignedRect().size(), format);
+	image.setDevicePixelRatio(resolution);
+}
+
+QRegion ViewportCache::scroll(const QPoint& offset)
+{
+	auto const width = viewport_size.width();
+	auto const height = viewport_size.height();
+	auto const viewport = QRect(QPoint(), viewport_size);
+	if (isNull() || std::abs(offset.x()) >= width || std::abs(offset.y()) >= height)
+		return viewport;
+	
+	origin = { wrap(origin.x() - offset.x(), width), wrap(origin.y() - offset.y(), height) };
+	
+	QRegion exposed;
+	if (offset.x() > 0)
+		exposed += QRect(0, 0, offset.x(), height);
+	else if (offset.x() < 0)
+		exposed += QRect(width + offset.x(), 0, -offset.x(), height);
+	if (offset.y() > 0)
+		exposed += QRect(0, 0, width, offset.y());
+	else if (offset.y() < 0)
+		exposed += QRect(0, height + offset.y(), width, -offset.y());
+	return exposed;
+}
+
+void ViewportCache::paint(const QRect& rect, const PaintFunction& paint_function)
+{
+	QPainter painter(&image);
+	forEachPart(rect, [&painter, &paint_function](const QRect& part, const QPoint& offset) {
+		painter.save();
+		painter.translate(offset);
+		painter.setClipRect(part);
+		paint_function(painter, part);
+		painter.restore();
+	});
+}
+
+void ViewportCache::draw(QPainter& painter, const QRect& rect) const
+{
+	forEachPart(rect, [this, &painter](const QRect& part, const QPoint& offset) {
+		auto const source = QRectF(part.translated(offset));
+		painter.drawImage(QRectF(part), image, QRectF(source.topLeft() * resolution, source.size() * resolution));
+	});
+}
+
+void ViewportCache::forEachPart(const QRect& rect, const std::function<void (const QRect& part, const QPoint& offset)>& function) const
+{
+	auto const width = viewport_size.width();
+	auto const height = viewport_size.height();
+	auto const area = rect.intersected(QRect(QPoint(), viewport_size));
+	if (area.isEmpty())
+		return;
+	
+	// Viewport coordinates at which the image wraps around
+	auto const split_x = width - origin.x();
+	auto const split_y = height - origin.y();
+	
+	QRect const columns[2] = {
+	    QRect(area.left(), 0, qMin(area.right() + 1, split_x) - area.left(), 1),
+	    QRect(qMax(area.left(), split_x), 0, area.right() + 1 - qMax(area.left(), split_x), 1),
+	};
+	QRect const rows[2] = {
+	    QRect(0, area.top(), 1, qMin(area.bottom() + 1, split_y) - area.top()),
+	    QRect(0, qMax(area.top(), split_y), 1, area.bottom() + 1 - qMax(area.top(), split_y)),
+	};
+	for (int i = 0; i < 2; ++i)
+	{
+		if (columns[i].width() <= 0)
+			continue;
+		auto const dx = i == 0 ? origin.x() : origin.x() - width;
+		for (int j = 0; j < 2; ++j)
+		{
+			if (rows[j].height() <= 0)
+				continue;
+			auto const dy = j == 0 ? origin.y() : origin.y() - height;
+			function({ columns[i].left(), rows[j].top(), columns[i].width(), rows[j].height() }, { dx, dy });
+		}
+	}
+}
+
+
+}  // namespace OpenOrienteering
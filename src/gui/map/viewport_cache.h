@@ -0,0 +1,113 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_VIEWPORT_CACHE_H
+#define OPENORIENTEERING_VIEWPORT_CACHE_H
+
+#include <functional>
+
+#include <QtGlobal>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QSize>
+
+class QPainter;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A cached image of a viewport, organized as a ring buffer.
+ *
+ * The image wraps around at its edges: the viewport's top left corner may be
+ * stored anywhere in the image. Scrolling the viewport only moves this origin,
+ * so that no pixels need to be copied. Only the exposed strips need to be
+ * rendered again.
+ *
+ * All rectangles are given in viewport coordinates. A rectangle of the
+ * viewport is stored in up to four parts of the image.
+ */
+class ViewportCache
+{
+public:
+	/**
+	 * A function which paints a part of the viewport.
+	 *
+	 * The painter is set up for drawing in viewport coordinates, and clipped
+	 * to the part which is given as rectangle.
+	 */
+	using PaintFunction = std::function<void (QPainter& painter, const QRect& part)>;
+	
+	/** Returns true if there is no image. */
+	bool isNull() const { return image.isNull(); }
+	
+	/** Returns the size of the viewport, in viewport pixels. */
+	QSize size() const { return viewport_size; }
+	
+	/** Returns the image format. */
+	QImage::Format format() const { return image.format(); }
+	
+	/** Drops the image. */
+	void clear();
+	
+	/**
+	 * Allocates an uninitialized image for the given viewport size.
+	 *
+	 * The resolution is the number of image pixels per viewport pixel.
+	 */
+	void allocate(const QSize& size, qreal resolution, QImage::Format format);
+	
+	/**
+	 * Moves the contents by the given offset, in viewport pixels.
+	 *
+	 * Returns the area which is exposed and must be painted again.
+	 */
+	QRegion scroll(const QPoint& offset);
+	
+	/**
+	 * Calls the paint function for each stored part of the given rectangle.
+	 */
+	void paint(const QRect& rect, const PaintFunction& paint_function);
+	
+	/**
+	 * Draws the given rectangle of the cache to the same rectangle of the
+	 * painter's coordinate system.
+	 */
+	void draw(QPainter& painter, const QRect& rect) const;
+
+private:
+	/**
+	 * Calls the function with each stored part of the given rectangle, and
+	 * with the offset from viewport coordinates to image coordinates.
+	 */
+	void forEachPart(const QRect& rect, const std::function<void (const QRect& part, const QPoint& offset)>& function) const;
+	
+	QImage image;
+	QSize viewport_size;
+	QPoint origin;          ///< The position of the viewport's top left corner, in the image
+	qreal resolution = 1;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_VIEWPORT_CACHE_H
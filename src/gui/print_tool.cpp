@@ -26,6 +26,8 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPointF>
+#include <QSizeF>
 
 #include "core/map.h"
 #include "core/map_printer.h"
@@ -58,6 +60,7 @@ PrintTool::~PrintTool()
 void PrintTool::init()
 {
 	setStatusBarText(tr("<b>Drag</b>: Move the map, the print area or the area's borders. "));
+	drawn_extent = {};
 	updatePrintArea();
 	
 	MapEditorTool::init();
@@ -248,9 +251,31 @@ void PrintTool::draw(QPainter* painter, MapWidget* widget)
 
 void PrintTool::updatePrintArea()
 {
-	// The print area visualization is updated by redrawing the whole map.
-	// TODO: Replace with a more explicit way of marking the whole map area as dirty.
-	editor->getMap()->setDrawingBoundingBox(QRectF(-1000000, -1000000, 2000000, 2000000), 0);
+	// The darkened outside region covers the whole map widget. So the drawing
+	// bounding box is set to the whole map once, and later changes only
+	// repaint the area which was or is covered by the print area and the
+	// page frames. This keeps dragging responsive on big maps.
+	auto const extent = visualizationExtent();
+	if (drawn_extent.isValid())
+		editor->getMap()->updateDrawing(drawn_extent.united(extent), 8);
+	else
+		editor->getMap()->setDrawingBoundingBox(QRectF(-1000000, -1000000, 2000000, 2000000), 0);
+	drawn_extent = extent;
+}
+
+QRectF PrintTool::visualizationExtent() const
+{
+	auto extent = map_printer->getPrintArea();
+	auto const& h_page_pos = map_printer->horizontalPagePositions();
+	auto const& v_page_pos = map_printer->verticalPagePositions();
+	if (!h_page_pos.empty() && !v_page_pos.empty())
+	{
+		auto const page_size = map_printer->getPageFormat().page_rect.size() / map_printer->getScaleAdjustment();
+		auto const pages = QRectF(QPointF(h_page_pos.front(), v_page_pos.front()),
+		                          QPointF(h_page_pos.back() + page_size.width(), v_page_pos.back() + page_size.height()));
+		extent = extent.united(pages.normalized());
+	}
+	return extent;
 }
 
 void PrintTool::updateDragging(const MapCoordF& mouse_pos_map)
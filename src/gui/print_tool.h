@@ -26,6 +26,7 @@
 
 #include <QObject>
 #include <QPoint>
+#include <QRectF>
 
 #include "core/map_coord.h"
 #include "tools/tool.h"
@@ -92,6 +93,9 @@ protected:
 	 *  This must not be called during dragging. */
 	void mouseMoved(const MapCoordF& mouse_pos_map, MapWidget* widget);
 	
+	/** Returns the map area covered by the print area and the page frames. */
+	QRectF visualizationExtent() const;
+	
 	/** Regions of interaction with the print area. */
 	enum InteractionRegion {
 		Inside            = 0x00,
@@ -121,6 +125,10 @@ protected:
 	
 	/** The map position where the initial click was made. */
 	MapCoordF click_pos_map;
+	
+	/** The visualization extent at the last update, or invalid before
+	 *  the first update. */
+	QRectF drawn_extent;
 };
 
 
@@ -100,6 +100,7 @@
 #include "util/scoped_signals_blocker.h"
 
 #ifdef MAPPER_USE_GDAL
+#  include "gdal/geotiff_export.h"
 #  include "gdal/kmz_groundoverlay_export.h"
 #endif
 
@@ -214,6 +215,23 @@ PrintWidget::PrintWidget(Map* map, MainWindow* main_window, MapView* main_view,
 	overlap_edit = Util::SpinBox::create(2, -999999.9, 999999.9, tr("mm"), 1.0);
 	layout->addRow(tr("Page overlap:"), overlap_edit);
 	
+	auto series_widget = new QWidget();
+	auto series_layout = new QHBoxLayout();
+	series_layout->setContentsMargins(QMargins());
+	series_widget->setLayout(series_layout);
+	series_label = new QLabel();
+	series_layout->addWidget(series_label, 1);
+	auto series_add_button = new QToolButton();
+	series_add_button->setText(tr("Add area"));
+	series_layout->addWidget(series_add_button);
+	series_clear_button = new QToolButton();
+	series_clear_button->setText(tr("Clear"));
+	series_layout->addWidget(series_clear_button);
+	layout->addRow(tr("Map series:"), series_widget);
+	
+	series_files_check = new QCheckBox(tr("One file per sheet"));
+	layout->addRow(series_files_check);
+	
 	layout->addItem(Util::SpacerItem::create(this));
 	
 	layout->addRow(Util::Headline::create(tr("Options")));
@@ -242,8 +260,9 @@ PrintWidget::PrintWidget(Map* map, MainWindow* main_window, MapView* main_view,
 	
 	color_mode_combo = new QComboBox();
 	color_mode_combo->setEditable(false);
-	color_mode_combo->addItem(tr("Default"), QVariant());
-	color_mode_combo->addItem(tr("Device CMYK"), QVariant(true));
+	color_mode_combo->addItem(tr("Default"), int(MapPrinterOptions::DefaultColorMode));
+	color_mode_combo->addItem(tr("Device CMYK"), int(MapPrinterOptions::DeviceCmyk));
+	color_mode_combo->addItem(tr("Spot colors"), int(MapPrinterOptions::SpotColors));
 	layout->addRow(tr("Color mode:"), color_mode_combo);
 	
 	dpi_combo = new QComboBox();
@@ -352,6 +371,8 @@ PrintWidget::PrintWidget(Map* map, MainWindow* main_window, MapView* main_view,
 	connect(width_edit, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &PrintWidget::printAreaResized);
 	connect(height_edit, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &PrintWidget::printAreaResized);
 	connect(overlap_edit, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &PrintWidget::overlapEdited);
+	connect(series_add_button, &QAbstractButton::clicked, this, &PrintWidget::addSeriesAreaClicked);
+	connect(series_clear_button, &QAbstractButton::clicked, this, &PrintWidget::clearSeriesClicked);
 	
 	connect(mode_button_group, QOverload<QAbstractButton*>::of(&QButtonGroup::buttonClicked), this, &PrintWidget::printModeChanged);
 	connect(dpi_combo->lineEdit(), &QLineEdit::textEdited, this, &PrintWidget::resolutionEdited);
@@ -419,6 +440,8 @@ void PrintWidget::setTask(PrintWidget::TaskFlags type)
 		layout->labelForField(copies_edit)->setVisible(is_multipage);
 		copies_edit->setVisible(is_multipage);
 		policy_combo->setVisible(is_multipage);
+		layout->labelForField(series_label->parentWidget())->setVisible(is_multipage);
+		series_label->parentWidget()->setVisible(is_multipage);
 		tile_size_combo->setVisible(supports_tiles);
 		layout->labelForField(tile_size_combo)->setVisible(supports_tiles);
 		updateTargets();
@@ -676,6 +699,7 @@ void PrintWidget::setTarget(const QPrinterInfo* target)
 	
 	transparent_background_check->setVisible(is_image_target);
 	
+	updateSeriesWidgets();
 	updateColorMode();
 }
 
@@ -923,6 +947,38 @@ void PrintWidget::overlapEdited(double overlap)
 	map_printer->setOverlap(overlap, overlap);
 }
 
+// slot
+void PrintWidget::addSeriesAreaClicked()
+{
+	auto areas = map_printer->getSeriesAreas();
+	areas.push_back(map_printer->getPrintArea());
+	map_printer->setSeriesAreas(std::move(areas));
+	updateSeriesWidgets();
+}
+
+// slot
+void PrintWidget::clearSeriesClicked()
+{
+	map_printer->setSeriesAreas({});
+	updateSeriesWidgets();
+}
+
+void PrintWidget::updateSeriesWidgets() const
+{
+	auto const target = map_printer->getTarget();
+	auto const supports_series = target != MapPrinter::imageTarget() && target != MapPrinter::kmzTarget();
+	auto const num_sheets = int(map_printer->getSeriesAreas().size());
+	if (num_sheets == 0)
+		series_label->setText(tr("Print area only"));
+	else
+		series_label->setText(tr("%n sheet(s)", nullptr, num_sheets));
+	series_label->setEnabled(supports_series);
+	layout->labelForField(series_label->parentWidget())->setEnabled(supports_series);
+	series_clear_button->setEnabled(supports_series && num_sheets > 0);
+	series_files_check->setVisible(target == MapPrinter::pdfTarget());
+	series_files_check->setEnabled(num_sheets > 0);
+}
+
 void PrintWidget::setOverlapEditEnabled(bool state) const
 {
 	overlap_edit->setEnabled(state);
@@ -987,6 +1043,9 @@ void PrintWidget::setOptions(const MapPrinterOptions& options)
 	case MapPrinterOptions::DeviceCmyk:
 		color_mode_combo->setCurrentIndex(1);
 		break;
+	case MapPrinterOptions::SpotColors:
+		color_mode_combo->setCurrentIndex(2);
+		break;
 	}
 	
 	checkTemplateConfiguration();
@@ -1163,10 +1222,7 @@ void PrintWidget::overprintingClicked(bool checked)
 
 void PrintWidget::colorModeChanged()
 {
-	if (color_mode_combo->currentData().toBool())
-		map_printer->setColorMode(MapPrinterOptions::DeviceCmyk);
-	else
-		map_printer->setColorMode(MapPrinterOptions::DefaultColorMode);
+	map_printer->setColorMode(MapPrinterOptions::ColorMode(color_mode_combo->currentData().toInt()));
 }
 
 // slot
@@ -1296,6 +1352,24 @@ void PrintWidget::exportToImage()
 		path.append(QString::fromLatin1(".png"));
 	}
 	
+	bool transparent_background = transparent_background_check->isChecked();
+	if (transparent_background
+		&& !path.endsWith(QLatin1String(".png"), Qt::CaseInsensitive)
+	    && !path.endsWith(QLatin1String(".tif"), Qt::CaseInsensitive) && !path.endsWith(QLatin1String(".tiff"), Qt::CaseInsensitive) )
+	{
+		transparent_background = false;
+		QMessageBox::information(this, tr("Information"), tr("Transparent background is not supported for this file format.\nUsing a white background instead."));
+	}
+	
+#ifdef MAPPER_USE_GDAL
+	if (path.endsWith(QLatin1String(".tif"), Qt::CaseInsensitive) || path.endsWith(QLatin1String(".tiff"), Qt::CaseInsensitive))
+	{
+		// Rendered in bands, so that the size of the image is not limited by memory.
+		exportToGeoTiff(path, transparent_background);
+		return;
+	}
+#endif
+	
 	qreal pixel_per_mm = map_printer->getOptions().resolution / 25.4;
 	int print_width = qRound(map_printer->getPrintAreaPaperSize().width() * pixel_per_mm);
 	int print_height = qRound(map_printer->getPrintAreaPaperSize().height() * pixel_per_mm);
@@ -1306,15 +1380,6 @@ void PrintWidget::exportToImage()
 		return;
 	}
 	
-	bool transparent_background = transparent_background_check->isChecked();
-	if (transparent_background
-		&& !path.endsWith(QLatin1String(".png"), Qt::CaseInsensitive)
-	    && !path.endsWith(QLatin1String(".tif"), Qt::CaseInsensitive) && !path.endsWith(QLatin1String(".tiff"), Qt::CaseInsensitive) )
-	{
-		transparent_background = false;
-		QMessageBox::information(this, tr("Information"), tr("Transparent background is not supported for this file format.\nUsing a white background instead."));
-	}
-	
 	int dots_per_meter = qRound(pixel_per_mm * 1000);
 	image.setDotsPerMeterX(dots_per_meter);
 	image.setDotsPerMeterY(dots_per_meter);
@@ -1346,6 +1411,40 @@ void PrintWidget::exportToImage()
 	}
 }
 
+void PrintWidget::exportToGeoTiff(const QString& path, bool transparent_background)
+{
+#ifdef MAPPER_USE_GDAL
+	QProgressDialog progress(main_window);
+	progress.setWindowModality(Qt::ApplicationModal); // Required for OSX, cf. QTBUG-40112
+	progress.setWindowTitle(tr("Export map ..."));
+	progress.setMinimumDuration(500);
+	progress.setAutoClose(true);
+	
+	GeoTiffExport exporter(path, *map);
+	exporter.setProgressObserver(&progress);
+	if (!exporter.doExport(*map_printer, transparent_background))
+	{
+		progress.cancel();
+		if (!exporter.errorString().isEmpty())
+			QMessageBox::warning(this, tr("Error"), tr("Failed to save the image:\n%1").arg(exporter.errorString()));
+		main_window->showStatusBarMessage(tr("Canceled."), 4000);
+	}
+	else
+	{
+		main_window->showStatusBarMessage(tr("Exported successfully to %1").arg(path), 4000);
+		if (world_file_check->isChecked())
+		{
+			if (!exportWorldFile(path))
+				QMessageBox::warning(this, tr("Error"), tr("Failed to save the world file."));
+		}
+		emit finished(0);
+	}
+#else
+	Q_UNUSED(path)
+	Q_UNUSED(transparent_background)
+#endif
+}
+
 bool PrintWidget::exportWorldFile(const QString& path) const
 {
 	const auto& georef = map->getGeoreferencing();
@@ -1393,7 +1492,12 @@ void PrintWidget::exportToPdf()
 	progress.setWindowTitle(tr("Export map ..."));
 	
 	// Export the map
-	if (!map_printer->printMap(printer.get()))
+	auto const per_sheet = series_files_check->isChecked() && !map_printer->getSeriesAreas().empty();
+	if (per_sheet && !map_printer->printSeriesToFiles(printer.get(), path))
+	{
+		QMessageBox::warning(this, tr("Error"), tr("Failed to finish the PDF export."));
+	}
+	else if (!per_sheet && !map_printer->printMap(printer.get()))
 	{
 		QFile(path).remove();
 		QMessageBox::warning(this, tr("Error"), tr("Failed to finish the PDF export."));
@@ -182,6 +182,15 @@ protected slots:
 	/** This slot reacts to changes to the page overlap widget. */
 	void overlapEdited(double overlap);
 	
+	/** Adds the current print area to the map series. */
+	void addSeriesAreaClicked();
+	
+	/** Removes all areas from the map series. */
+	void clearSeriesClicked();
+	
+	/** Updates the map series widgets from the map printer and the target. */
+	void updateSeriesWidgets() const;
+	
 	/** This slot is called when the resolution widget signals that editing finished. */
 	void resolutionEdited();
 	
@@ -261,6 +270,9 @@ protected:
 
 	/** Exports to an image file. */
 	void exportToImage();
+	
+	/** Exports the map to a tiled GeoTIFF file, rendered in bands. */
+	void exportToGeoTiff(const QString& path, bool transparent_background);
 
 	/** Export a world file */
 	bool exportWorldFile(const QString& path) const;
@@ -315,6 +327,9 @@ private:
 	QDoubleSpinBox* width_edit;
 	QDoubleSpinBox* height_edit;
 	QDoubleSpinBox* overlap_edit;
+	QLabel* series_label;
+	QToolButton* series_clear_button;
+	QCheckBox* series_files_check;
 	
 	QToolButton* vector_mode_button;
 	QToolButton* raster_mode_button;
@@ -53,6 +53,7 @@
 
 #include "settings.h"
 #include "gui/util_gui.h"
+#include "gui/widgets/cache_settings_page.h"
 #include "gui/widgets/editor_settings_page.h"
 #include "gui/widgets/general_settings_page.h"
 #include "gui/widgets/paint_on_template_settings_page.h"
@@ -223,6 +224,7 @@ void SettingsDialog::addPages()
 	addPage(new SensorsSettingsPage(this));
 #endif
     addPage(new PaintOnTemplateSettingsPage(this));
+	addPage(new CacheSettingsPage(this));
 }
 
 void SettingsDialog::addPage(SettingsPage* page)
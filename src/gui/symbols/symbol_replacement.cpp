@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2017-2020 Kai Pastor
+ *    Copyright 2017-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -40,6 +40,7 @@
 #include "core/symbols/symbol.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_import_export.h"
+#include "fileformats/symbol_set_cache.h"
 #include "gui/file_dialog.h"
 #include "gui/main_window.h"
 #include "gui/symbols/symbol_replacement_dialog.h"
@@ -269,6 +270,8 @@ std::unique_ptr<Map> SymbolReplacement::getOpenSymbolSet(QWidget* parent) const
 			                           importer->warnings());
 		}
 		
+		SymbolSetCache(selected.filePath()).provideIcons(*symbol_set);
+		
 		if (object_map.getScaleDenominator() != symbol_set->getScaleDenominator())
 		{
 			if (QMessageBox::warning(parent,
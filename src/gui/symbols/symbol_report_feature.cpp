@@ -105,9 +105,7 @@ void SymbolReportFeature::showDialog()
 	QSaveFile file(filepath);
 	if (file.open(QIODevice::WriteOnly | QIODevice::Text))
 	{
-		const auto report = makeHTMLSymbolReport(*map);
-		file.write(report.toUtf8());
-		if(file.commit())
+		if (writeHTMLSymbolReport(*map, file) && file.commit())
 			QDesktopServices::openUrl(QUrl::fromLocalFile(filepath));
 	}
 }
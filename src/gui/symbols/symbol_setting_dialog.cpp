@@ -29,6 +29,7 @@
 #include <QMenu>
 #include <QPushButton>
 #include <QSplitter>
+#include <QTimer>
 #include <QToolButton>
 #include <QVBoxLayout>
 
@@ -58,6 +59,7 @@ SymbolSettingDialog::SymbolSettingDialog(const Symbol* source_symbol, Map* sourc
 , source_symbol_copy(duplicate(*source_symbol))	// don't rely on external entity
 , symbol(duplicate(*source_symbol))
 , symbol_modified(false)
+, preview_update_triggered(false)
 {
 	setWindowTitle(tr("Symbol settings"));
 	setSizeGripEnabled(true);
@@ -186,6 +188,16 @@ std::unique_ptr<Symbol> SymbolSettingDialog::getNewSymbol() const
 
 void SymbolSettingDialog::updatePreview()
 {
+	if (!preview_update_triggered)
+	{
+		QTimer::singleShot(10, this, &SymbolSettingDialog::updatePreviewSlot);
+		preview_update_triggered = true;
+	}
+}
+
+void SymbolSettingDialog::updatePreviewSlot()
+{
+	preview_update_triggered = false;
 	symbol->resetIcon();
 	symbol_icon_label->setPixmap(QPixmap::fromImage(symbol->getIcon(source_map)));
 	preview_map->updateAllObjects();
@@ -121,7 +121,10 @@ public slots:
 	void updateSymbolLabel();
 	
 	/** 
-	 * Updates the preview from the current symbol settings.
+	 * Schedules an update of the preview from the current symbol settings.
+	 * 
+	 * Subsequent changes are collected until the event loop runs the update,
+	 * so that fast edits, e.g. from spin boxes, update the preview once.
 	 */
 	void updatePreview();
 	
@@ -147,6 +150,11 @@ protected slots:
 	 */
 	void centerTemplateGravity();
 	
+	/**
+	 * Updates the symbol icon and the preview map.
+	 */
+	void updatePreviewSlot();
+	
 protected:
 	/**
 	 * Populates the preview map for the symbol.
@@ -178,6 +186,7 @@ private:
 	QLabel* symbol_text_label;
 	
 	bool symbol_modified;
+	bool preview_update_triggered;
 };
 
 
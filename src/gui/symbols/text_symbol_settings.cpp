@@ -509,6 +509,7 @@ void TextSymbolSettings::addCustomTabClicked()
 		custom_tab_list->insertItem(row, locale().toString(position, 'g', 3) + QLatin1Char(' ') + tr("mm"));
 		custom_tab_list->setCurrentRow(row);
 		symbol->custom_tabs.insert(symbol->custom_tabs.begin() + row, int_position);
+		symbol->updateQFont();
 		emit propertiesModified();
 		updateCompatibilityCheckEnabled();
 	}
@@ -522,6 +523,7 @@ void TextSymbolSettings::removeCustomTabClicked()
 		delete custom_tab_list->item(row);
 		custom_tab_list->setCurrentRow(row - 1);
 		symbol->custom_tabs.erase(symbol->custom_tabs.begin() + row);
+		symbol->updateQFont();
 		emit propertiesModified();
 		updateCompatibilityCheckEnabled();
 	}
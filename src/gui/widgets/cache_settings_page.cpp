@@ -0,0 +1,153 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cache_settings_page.h"
+
+#include <cstddef>
+
+#include <Qt>
+#include <QAbstractButton>
+#include <QAbstractItemView>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMetaObject>
+#include <QPushButton>
+#include <QStringList>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QVBoxLayout>
+
+#include "gui/util_gui.h"
+#include "gui/widgets/settings_page.h"
+#include "util/disk_cache.h"
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+QString formatSize(qint64 size)
+{
+	return CacheSettingsPage::tr("%1 MiB").arg(double(size) / (1 << 20), 0, 'f', 1);
+}
+
+}  // namespace
+
+
+
+CacheSettingsPage::CacheSettingsPage(QWidget* parent)
+: SettingsPage(parent)
+{
+	auto* layout = new QVBoxLayout(this);
+	
+	layout->addWidget(Util::Headline::create(tr("Disk cache")));
+	
+	usage_table = new QTableWidget(DiskCache::numCategories(), 3);
+	usage_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	usage_table->setSelectionMode(QAbstractItemView::NoSelection);
+	usage_table->setHorizontalHeaderLabels({ tr("Content"), tr("Used"), tr("Limit") });
+	usage_table->verticalHeader()->setVisible(false);
+	auto* header_view = usage_table->horizontalHeader();
+	header_view->setSectionResizeMode(0, QHeaderView::Stretch);
+	header_view->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+	header_view->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+	for (int i = 0; i < DiskCache::numCategories(); ++i)
+	{
+		auto const category = DiskCache::Category(i);
+		usage_table->setItem(i, 0, new QTableWidgetItem(DiskCache::displayName(category)));
+		usage_table->setItem(i, 1, new QTableWidgetItem(tr("Calculating...")));
+		usage_table->setItem(i, 2, new QTableWidgetItem(formatSize(DiskCache::maxSize(category))));
+		usage_table->item(i, 1)->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+		usage_table->item(i, 2)->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	}
+	layout->addWidget(usage_table, 1);
+	
+	clear_button = new QPushButton(tr("Clear cache"));
+	clear_button->setToolTip(tr("Removes all cached data. It is created again when needed."));
+	layout->addWidget(clear_button, 0, Qt::AlignLeft);
+	
+	connect(clear_button, &QAbstractButton::clicked, this, &CacheSettingsPage::clearCache);
+	
+	updateUsage();
+}
+
+CacheSettingsPage::~CacheSettingsPage()
+{
+	// The job must not outlive the page, cf. updateUsage().
+	if (usage_job.valid())
+		usage_job.wait();
+}
+
+
+QString CacheSettingsPage::title() const
+{
+	return tr("Cache");
+}
+
+void CacheSettingsPage::apply()
+{
+	// nothing, the cache is cleared immediately
+}
+
+void CacheSettingsPage::reset()
+{
+	// nothing
+}
+
+
+void CacheSettingsPage::updateUsage(bool clear)
+{
+	if (usage_job.valid())
+		return;
+	
+	clear_button->setEnabled(false);
+	usage_job = Util::startJob<std::vector<qint64>>([this, clear]() {
+		if (clear)
+		{
+			for (int i = 0; i < DiskCache::numCategories(); ++i)
+				DiskCache::clear(DiskCache::Category(i));
+		}
+		std::vector<qint64> usage;
+		usage.reserve(DiskCache::numCategories());
+		for (int i = 0; i < DiskCache::numCategories(); ++i)
+			usage.push_back(DiskCache::usage(DiskCache::Category(i)));
+		// Posted before the future is ready, cf. ~CacheSettingsPage().
+		QMetaObject::invokeMethod(this, "usageCalculated", Qt::QueuedConnection);
+		return usage;
+	}, Util::JobPriority::Interactive);
+}
+
+void CacheSettingsPage::usageCalculated()
+{
+	auto const usage = usage_job.get();
+	for (int i = 0; i < DiskCache::numCategories(); ++i)
+		usage_table->item(i, 1)->setText(formatSize(usage[std::size_t(i)]));
+	clear_button->setEnabled(true);
+}
+
+void CacheSettingsPage::clearCache()
+{
+	for (int i = 0; i < DiskCache::numCategories(); ++i)
+		usage_table->item(i, 1)->setText(tr("Calculating..."));
+	updateUsage(true);
+}
+
+
+}  // namespace OpenOrienteering
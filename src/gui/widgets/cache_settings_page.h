@@ -0,0 +1,84 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_CACHE_SETTINGS_PAGE_H
+#define OPENORIENTEERING_CACHE_SETTINGS_PAGE_H
+
+#include <future>
+#include <vector>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QString>
+
+#include "settings_page.h"
+
+class QPushButton;
+class QTableWidget;
+class QWidget;
+
+
+namespace OpenOrienteering {
+
+
+/**
+ * A settings page which shows the usage of the disk cache.
+ * 
+ * The usage is calculated in a background job. The page allows to clear
+ * the cache.
+ */
+class CacheSettingsPage : public SettingsPage
+{
+Q_OBJECT
+public:
+	explicit CacheSettingsPage(QWidget* parent = nullptr);
+	
+	~CacheSettingsPage() override;
+	
+	QString title() const override;
+	
+	void apply() override;
+	
+	void reset() override;
+	
+protected:
+	/**
+	 * Starts the calculation of the usage, if not running.
+	 * 
+	 * If clear is true, the cache is cleared before.
+	 */
+	void updateUsage(bool clear = false);
+	
+private slots:
+	void usageCalculated();
+	
+	void clearCache();
+	
+private:
+	QTableWidget* usage_table;
+	QPushButton*  clear_button;
+	
+	std::future<std::vector<qint64>> usage_job;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
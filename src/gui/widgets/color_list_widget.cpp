@@ -218,8 +218,6 @@ void ColorListWidget::newColor()
 		row = color_table->rowCount();
 	map->addColor(new MapColor(), row);
 	
-	map->updateAllObjects();
-	
 	editCurrentColor();
 }
 
@@ -312,10 +310,18 @@ void ColorListWidget::deleteColor()
 	if (!confirmColorDeletion(map->getColor(row)))
 		return;
 	
+	// Only the objects which use the color need to be updated.
+	std::vector<const Symbol*> affected_symbols;
+	map->applyOnAllSymbols([this, row, &affected_symbols](const Symbol* symbol) {
+		if (symbol->containsColor(map->getColor(row)))
+			affected_symbols.push_back(symbol);
+	});
+	
 	map->deleteColor(row);
 	
 	map->setColorsDirty();
-	map->updateAllObjects();
+	for (const auto* symbol : affected_symbols)
+		map->updateAllObjectsWithSymbol(symbol);
 }
 
 void ColorListWidget::duplicateColor()
@@ -330,8 +336,6 @@ void ColorListWidget::duplicateColor()
 	new_color->setName(map->translate(new_color->getName()) + tr(" (Duplicate)"));
 	map->addColor(new_color, row);
 	
-	map->updateAllObjects();
-	
 	editCurrentColor();
 }
 
@@ -350,8 +354,9 @@ void ColorListWidget::moveColorUp()
 	
 	color_table->setCurrentCell(row - 1, color_table->currentColumn());
 	
+	// The renderables are independent of the color priorities.
 	map->setColorsDirty();
-	map->updateAllObjects();
+	map->updateAllMapWidgets();
 }
 
 void ColorListWidget::moveColorDown()
@@ -369,8 +374,9 @@ void ColorListWidget::moveColorDown()
 	
 	color_table->setCurrentCell(row + 1, color_table->currentColumn());
 	
+	// The renderables are independent of the color priorities.
 	map->setColorsDirty();
-	map->updateAllObjects();
+	map->updateAllMapWidgets();
 }
 
 // slot
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Jan Dalheimer
- *    Copyright 2012-2016  Kai Pastor
+ *    Copyright 2012-2016, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -61,6 +61,10 @@ EditorSettingsPage::EditorSettingsPage(QWidget* parent)
 	text_antialiasing->setToolTip(tr("Antialiasing makes the map look much better, but also slows down the map display"));
 	layout->addRow(text_antialiasing);
 	
+	low_memory_display = new QCheckBox(tr("Reduced memory map display"), this);
+	low_memory_display->setToolTip(tr("Uses less memory for the display of templates, at the cost of color depth"));
+	layout->addRow(low_memory_display);
+	
 	tolerance = Util::SpinBox::create(0, 50, tr("mm", "millimeters"));
 	layout->addRow(tr("Click tolerance:"), tolerance);
 	
@@ -84,6 +88,14 @@ EditorSettingsPage::EditorSettingsPage(QWidget* parent)
 	keep_settings_of_closed_templates = new QCheckBox(tr("Templates: keep settings of closed templates"));
 	layout->addRow(keep_settings_of_closed_templates);
 	
+	template_memory_budget = Util::SpinBox::create(0, 1 << 20, tr("MiB", "mebibytes"), 64);
+	template_memory_budget->setSpecialValueText(tr("unlimited"));
+	layout->addRow(tr("Templates: memory limit:"), template_memory_budget);
+	
+	undo_memory_budget = Util::SpinBox::create(0, 1 << 20, tr("MiB", "mebibytes"), 16);
+	undo_memory_budget->setSpecialValueText(tr("unlimited"));
+	layout->addRow(tr("Undo history: memory limit:"), undo_memory_budget);
+	
 	ignore_touch_input = new QCheckBox(tr("User input: Ignore display touch"));
 	layout->addRow(ignore_touch_input);
 	
@@ -135,6 +147,7 @@ void EditorSettingsPage::apply()
 	setSetting(Settings::SymbolWidget_IconSizeMM, icon_size->value());
 	setSetting(Settings::MapDisplay_Antialiasing, antialiasing->isChecked());
 	setSetting(Settings::MapDisplay_TextAntialiasing, text_antialiasing->isChecked());
+	setSetting(Settings::MapDisplay_LowMemory, low_memory_display->isChecked());
 	setSetting(Settings::MapEditor_ClickToleranceMM, tolerance->value());
 	setSetting(Settings::MapEditor_SnapDistanceMM, snap_distance->value());
 	setSetting(Settings::MapEditor_FixedAngleStepping, fixed_angle_stepping->value());
@@ -142,6 +155,8 @@ void EditorSettingsPage::apply()
 	setSetting(Settings::MapEditor_ZoomOutAwayFromCursor, zoom_out_away_from_cursor->isChecked());
 	setSetting(Settings::MapEditor_DrawLastPointOnRightClick, draw_last_point_on_right_click->isChecked());
 	setSetting(Settings::Templates_KeepSettingsOfClosed, keep_settings_of_closed_templates->isChecked());
+	setSetting(Settings::Templates_MemoryBudgetMB, template_memory_budget->value());
+	setSetting(Settings::MapEditor_UndoMemoryBudgetMB, undo_memory_budget->value());
 	setSetting(Settings::MapEditor_IgnoreTouchInput, ignore_touch_input->isChecked());
 	setSetting(Settings::EditTool_DeleteBezierPointAction, edit_tool_delete_bezier_point_action->currentData());
 	setSetting(Settings::EditTool_DeleteBezierPointActionAlternative, edit_tool_delete_bezier_point_action_alternative->currentData());
@@ -162,6 +177,7 @@ void EditorSettingsPage::updateWidgets()
 	antialiasing->setChecked(getSetting(Settings::MapDisplay_Antialiasing).toBool());
 	text_antialiasing->setEnabled(antialiasing->isChecked());
 	text_antialiasing->setChecked(getSetting(Settings::MapDisplay_TextAntialiasing).toBool());
+	low_memory_display->setChecked(getSetting(Settings::MapDisplay_LowMemory).toBool());
 	tolerance->setValue(getSetting(Settings::MapEditor_ClickToleranceMM).toInt());
 	snap_distance->setValue(getSetting(Settings::MapEditor_SnapDistanceMM).toInt());
 	fixed_angle_stepping->setValue(getSetting(Settings::MapEditor_FixedAngleStepping).toInt());
@@ -169,6 +185,8 @@ void EditorSettingsPage::updateWidgets()
 	zoom_out_away_from_cursor->setChecked(getSetting(Settings::MapEditor_ZoomOutAwayFromCursor).toBool());
 	draw_last_point_on_right_click->setChecked(getSetting(Settings::MapEditor_DrawLastPointOnRightClick).toBool());
 	keep_settings_of_closed_templates->setChecked(getSetting(Settings::Templates_KeepSettingsOfClosed).toBool());
+	template_memory_budget->setValue(getSetting(Settings::Templates_MemoryBudgetMB).toInt());
+	undo_memory_budget->setValue(getSetting(Settings::MapEditor_UndoMemoryBudgetMB).toInt());
 	ignore_touch_input->setChecked(getSetting(Settings::MapEditor_IgnoreTouchInput).toBool());
 	
 	edit_tool_delete_bezier_point_action->setCurrentIndex(edit_tool_delete_bezier_point_action->findData(getSetting(Settings::EditTool_DeleteBezierPointAction).toInt()));
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Jan Dalheimer
- *    Copyright 2013-2016  Kai Pastor
+ *    Copyright 2013-2016, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -57,6 +57,7 @@ private:
 	QSpinBox* icon_size;
 	QCheckBox* antialiasing;
 	QCheckBox* text_antialiasing;
+	QCheckBox* low_memory_display;
 	QSpinBox* tolerance;
 	QSpinBox* snap_distance;
 	QDoubleSpinBox* fixed_angle_stepping;
@@ -64,6 +65,8 @@ private:
 	QCheckBox* zoom_out_away_from_cursor;
 	QCheckBox* draw_last_point_on_right_click;
 	QCheckBox* keep_settings_of_closed_templates;
+	QSpinBox* template_memory_budget;
+	QSpinBox* undo_memory_budget;
 	QCheckBox* ignore_touch_input;
 	
 	QComboBox* edit_tool_delete_bezier_point_action;
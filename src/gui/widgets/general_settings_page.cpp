@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Jan Dalheimer
- *    Copyright 2012-2017  Kai Pastor
+ *    Copyright 2012-2017, 2026  Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -63,8 +63,13 @@
 #include "gui/util_gui.h"
 #include "gui/widgets/home_screen_widget.h"
 #include "gui/widgets/settings_page.h"
+#include "util/trace.h"
 #include "util/translation_util.h"
 
+#ifdef MAPPER_USE_ZSTD
+#include "fileformats/zstd_device.h"
+#endif
+
 
 namespace OpenOrienteering {
 
@@ -139,6 +144,23 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget* parent)
 	autosave_interval_edit = Util::SpinBox::create(1, 120, tr("min", "unit minutes"), 1);
 	layout->addRow(tr("Recovery information saving interval:"), autosave_interval_edit);
 	
+	journal_check = new QCheckBox(tr("Record changes in a journal for recovery"));
+	layout->addRow(journal_check);
+	
+#ifdef MAPPER_USE_ZSTD
+	auto const max_compression_level = ZstdCompressionDevice::maxLevel();
+#else
+	auto const max_compression_level = 0;
+#endif
+	compression_level_edit = Util::SpinBox::create(0, max_compression_level);
+	compression_level_edit->setSpecialValueText(tr("Off"));
+#ifdef MAPPER_USE_ZSTD
+	layout->addRow(tr("Compression level:"), compression_level_edit);
+#else
+	// Let compression_level_edit be valid, but not leak
+	connect(this, &QObject::destroyed, compression_level_edit, &QObject::deleteLater);
+#endif
+	
 	layout->addItem(Util::SpacerItem::create(this));
 	layout->addRow(Util::Headline::create(tr("File import and export")));
 	
@@ -167,6 +189,17 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget* parent)
 	encoding_box->setCompleter(completer);
 	layout->addRow(tr("8-bit encoding:"), encoding_box);
 	
+	trace_check = new QCheckBox(tr("Record a performance trace"));
+	trace_check->setToolTip(tr("The trace is saved to %1 when recording is turned off or when the program is closed.").arg(Trace::defaultFilePath()));
+#ifdef MAPPER_ENABLE_TRACING
+	layout->addItem(Util::SpacerItem::create(this));
+	layout->addRow(Util::Headline::create(tr("Troubleshooting")));
+	layout->addRow(trace_check);
+#else
+	// Let trace_check be valid, but not leak
+	connect(this, &QObject::destroyed, trace_check, &QObject::deleteLater);
+#endif
+	
 	updateWidgets();
 	
 	connect(language_file_button, &QAbstractButton::clicked, this, &GeneralSettingsPage::openTranslationFileDialog);
@@ -227,7 +260,14 @@ void GeneralSettingsPage::apply()
 	setSetting(Settings::HomeScreen_TipsVisible, tips_visible_check->isChecked());
 	setSetting(Settings::General_RetainCompatiblity, compatibility_check->isChecked());
 	setSetting(Settings::General_SaveUndoRedo, undo_check->isChecked());
+	setSetting(Settings::General_SaveJournal, journal_check->isChecked());
+#ifdef MAPPER_USE_ZSTD
+	setSetting(Settings::General_CompressionLevel, compression_level_edit->value());
+#endif
 	setSetting(Settings::General_PixelsPerInch, ppi_edit->value());
+#ifdef MAPPER_ENABLE_TRACING
+	setSetting(Settings::General_RecordTrace, trace_check->isChecked());
+#endif
 	
 	auto encoding = encoding_box->currentText().toLatin1();
 	if (QLatin1String(encoding) == encoding_box->itemText(0)
@@ -291,6 +331,9 @@ void GeneralSettingsPage::updateWidgets()
 	autosave_check->setChecked(autosave_interval > 0);
 	autosave_interval_edit->setEnabled(autosave_interval > 0);
 	autosave_interval_edit->setValue(qAbs(autosave_interval));
+	journal_check->setChecked(getSetting(Settings::General_SaveJournal).toBool());
+	compression_level_edit->setValue(getSetting(Settings::General_CompressionLevel).toInt());
+	trace_check->setChecked(getSetting(Settings::General_RecordTrace).toBool());
 	
 	auto encoding = getSetting(Settings::General_Local8BitEncoding).toByteArray();
 	if (encoding != "Default"
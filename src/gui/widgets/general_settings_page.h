@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Jan Dalheimer
- *    Copyright 2013-2016  Kai Pastor
+ *    Copyright 2013-2016, 2026  Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -87,8 +87,12 @@ private:
 	QCheckBox* undo_check;
 	QCheckBox* autosave_check;
 	QSpinBox*  autosave_interval_edit;
+	QCheckBox* journal_check;
+	QSpinBox*  compression_level_edit;
 	
 	QComboBox* encoding_box;
+	
+	QCheckBox* trace_check;
 };
 
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2018 Kai Pastor
+ *    Copyright 2012-2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -30,6 +30,7 @@
 #include <QLabel>
 #include <QListWidget>
 #include <QMessageBox>
+#include <QMetaObject>
 #include <QPainter>
 #include <QScroller>
 #include <QSettings>
@@ -43,6 +44,7 @@
 #include "gui/main_window.h"
 #include "gui/settings_dialog.h"
 #include "gui/util_gui.h"
+#include "util/parallel.h"
 
 
 namespace OpenOrienteering {
@@ -364,7 +366,12 @@ HomeScreenWidgetMobile::HomeScreenWidgetMobile(HomeScreenController* controller,
 	updateFileListWidget();
 }
 
-HomeScreenWidgetMobile::~HomeScreenWidgetMobile() = default;
+HomeScreenWidgetMobile::~HomeScreenWidgetMobile()
+{
+	// The job must not outlive the widget, cf. checkRecentFiles().
+	if (recent_files_check.valid())
+		recent_files_check.wait();
+}
 
 
 void HomeScreenWidgetMobile::resizeEvent(QResizeEvent* /*event*/)
@@ -516,26 +523,9 @@ void HomeScreenWidgetMobile::updateFileListWidget()
 	if (history.empty())
 	{
 		// First screen.
-		// Recent files first.
-		Settings& settings = Settings::getInstance();
-		auto recent_files = settings.getSetting(Settings::General_RecentFilesList).toStringList();
-		for (auto& file_path : recent_files)
-		{
-			auto file_info = QFileInfo(file_path);
-			if (file_info.exists())
-				addItemToFileList(file_info);
-		}
-		
-#ifdef Q_OS_ANDROID
-		// If there are no recent files, offer a link to the Android storage manual page.
-		if (file_list_widget->count() == 0)
-		{
-			auto* help_item = new QListWidgetItem(tr("Help"));
-			help_item->setData(pathRole(), QLatin1String("doc:"));
-			help_item->setIcon(file_list_widget->style()->standardIcon(QStyle::SP_DialogHelpButton));
-			file_list_widget->addItem(help_item);
-		}
-#endif
+		// Recent files first, but checking them may block on slow storage.
+		// They are inserted on top when available, cf. recentFilesChecked().
+		checkRecentFiles();
 		
 		// Device-specific locations next.
 		// For disambiguation, using the full path for the label.
@@ -589,6 +579,58 @@ void HomeScreenWidgetMobile::updateFileListWidget()
 }
 
 
+void HomeScreenWidgetMobile::checkRecentFiles()
+{
+	if (recent_files_check.valid())
+		return;  // The pending result will be used.
+	
+	Settings& settings = Settings::getInstance();
+	auto recent_files = settings.getSetting(Settings::General_RecentFilesList).toStringList();
+	recent_files_check = Util::startJob<QFileInfoList>([this, recent_files]() {
+		QFileInfoList existing_files;
+		for (auto& file_path : recent_files)
+		{
+			auto file_info = QFileInfo(file_path);
+			if (!file_info.exists())
+				continue;
+			// Cache the attributes which are used by addItemToFileList().
+			file_info.isDir();
+			file_info.isWritable();
+			existing_files.append(file_info);
+		}
+		// Posted before the future is ready, cf. ~HomeScreenWidgetMobile().
+		QMetaObject::invokeMethod(this, "recentFilesChecked", Qt::QueuedConnection);
+		return existing_files;
+	}, Util::JobPriority::Interactive);
+}
+
+void HomeScreenWidgetMobile::recentFilesChecked()
+{
+	auto const existing_files = recent_files_check.get();
+	if (!history.empty())
+		return;
+	
+	// Append the items, and move them to the top at the end.
+	auto const num_items = file_list_widget->count();
+	for (auto const& file_info : existing_files)
+		addItemToFileList(file_info);
+	auto const num_recent_files = file_list_widget->count() - num_items;
+	
+#ifdef Q_OS_ANDROID
+	// If there are no recent files, offer a link to the Android storage manual page.
+	if (num_recent_files == 0)
+	{
+		auto* help_item = new QListWidgetItem(tr("Help"));
+		help_item->setData(pathRole(), QLatin1String("doc:"));
+		help_item->setIcon(file_list_widget->style()->standardIcon(QStyle::SP_DialogHelpButton));
+		file_list_widget->insertItem(0, help_item);
+	}
+#endif
+	
+	for (int i = 0; i < num_recent_files; ++i)
+		file_list_widget->insertItem(i, file_list_widget->takeItem(num_items + i));
+}
+
 void HomeScreenWidgetMobile::addItemToFileList(const QFileInfo& file_info, int hint, const QIcon& icon)
 {
 	addItemToFileList(file_info.fileName(), file_info, hint, icon);
@@ -1,5 +1,6 @@
 /*
  *    Copyright 2012, 2013, 2014 Thomas Schöps, Kai Pastor
+ *    Copyright 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,8 +22,10 @@
 #ifndef OPENORIENTEERING_HOME_SCREEN_WIDGET_H
 #define OPENORIENTEERING_HOME_SCREEN_WIDGET_H
 
+#include <future>
 #include <vector>
 
+#include <QFileInfo>
 #include <QIcon>
 #include <QObject>
 #include <QPixmap>
@@ -32,7 +35,6 @@
 
 class QAbstractButton;
 class QCheckBox;
-class QFileInfo;
 class QIcon;
 class QLabel;
 class QListWidget;
@@ -202,6 +204,9 @@ protected:
 	/** Updates the file list widget. */
 	void updateFileListWidget();
 	
+	/** Starts checking the recent files in the background. */
+	void checkRecentFiles();
+	
 	/** Add a single file or dir item to the file list. */
 	void addItemToFileList(const QFileInfo& file_info, int hint = 0, const QIcon& icon = {});
 	
@@ -211,11 +216,16 @@ protected:
 	/** Returns the role to be used for storing hints (number or text). */
 	constexpr static int hintRole() { return Qt::UserRole + 1; }
 	
+private slots:
+	/** Adds the existing recent files to the top of the file list. */
+	void recentFilesChecked();
+	
 private:
 	QPixmap title_pixmap;
 	QLabel* title_label;
 	QListWidget* file_list_widget;
 	std::vector<StorageLocation> history;
+	std::future<QFileInfoList> recent_files_check;
 };
 
 
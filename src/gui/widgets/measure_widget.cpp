@@ -34,6 +34,7 @@
 #include <QLatin1Char>
 #include <QLatin1String>
 #include <QLocale>
+#include <QMetaObject>
 #include <QPixmap>
 #include <QScroller>
 #include <QSize>
@@ -66,7 +67,7 @@ MeasureWidget::MeasureWidget(Map* map, QWidget* parent)
 	connect(map, &Map::selectedObjectEdited, this, &MeasureWidget::objectSelectionChanged);
 	connect(map, &Map::symbolChanged, this, &MeasureWidget::objectSelectionChanged);
 	
-	objectSelectionChanged();
+	updateContent();
 }
 
 MeasureWidget::~MeasureWidget() = default;
@@ -74,6 +75,17 @@ MeasureWidget::~MeasureWidget() = default;
 
 void MeasureWidget::objectSelectionChanged()
 {
+	if (!update_pending)
+	{
+		update_pending = true;
+		QMetaObject::invokeMethod(this, "updateContent", Qt::QueuedConnection);
+	}
+}
+
+void MeasureWidget::updateContent()
+{
+	update_pending = false;
+	
 	QString headline;   // inline HTML
 	QString body;       // HTML blocks
 	QString extra_text; // inline HTML
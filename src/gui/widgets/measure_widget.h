@@ -50,13 +50,22 @@ public:
 protected slots:
 	/**
 	 * Is called when the object selection in the map changes.
-	 * Updates the widget content.
+	 * Schedules an update of the widget content.
+	 * 
+	 * Editing the selected objects may emit many signals in a row.
+	 * These are coalesced into a single update when returning to the event loop.
 	 */
 	void objectSelectionChanged();
 	
+	/**
+	 * Updates the widget content.
+	 */
+	void updateContent();
+	
 private:
 	Map* map;
 	QString warning_icon;
+	bool update_pending = false;
 };
 
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014-2020, 2025 Kai Pastor
+ *    Copyright 2014-2020, 2025, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,18 +21,24 @@
 
 #include "symbol_render_widget.h"
 
+#include <algorithm>
+
 #include <QApplication>
 #include <QBuffer>
 #include <QClipboard>
+#include <QColor>
 #include <QDrag>
+#include <QElapsedTimer>
 #include <QInputDialog>
 #include <QMenu>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QPainter>
 #include <QPaintEvent>
+#include <QRegion>
 #include <QResizeEvent>
 #include <QScopedValueRollback>
+#include <QTimer>
 
 #include "settings.h"
 #include "core/map.h"
@@ -154,6 +160,11 @@ SymbolRenderWidget::SymbolRenderWidget(Map* map, bool mobile_mode, QWidget* pare
 	sort_manual_action->setCheckable(true);
 	context_menu->addMenu(sort_menu);
 	
+	icon_timer = new QTimer(this);
+	icon_timer->setSingleShot(true);
+	icon_timer->setInterval(0);
+	connect(icon_timer, &QTimer::timeout, this, &SymbolRenderWidget::createPendingIcons);
+	
 	connect(map, &Map::colorDeleted, this, QOverload<>::of(&QWidget::update));
 	connect(map, &Map::symbolAdded, this, &SymbolRenderWidget::updateAll);
 	connect(map, &Map::symbolDeleted, this, &SymbolRenderWidget::symbolDeleted);
@@ -220,13 +231,14 @@ void SymbolRenderWidget::updateSingleIcon(int i)
 
 void SymbolRenderWidget::settingsChanged()
 {
+	// The layout adds one pixel for the grid lines.
 	const auto new_size = Settings::getInstance().getSymbolWidgetIconSizePx();
-	if (icon_size != new_size)
+	if (icon_size != new_size + 1)
 	{
 		for (int i = 0; i < map->getNumSymbols(); ++i)
 		{
 			auto symbol = map->getSymbol(i);
-			if (symbol->getIcon(map).width() != new_size)
+			if (symbol->hasIcon() && symbol->getIcon(map).width() != new_size)
 				symbol->resetIcon();
 		}
 		updateAll();
@@ -406,7 +418,10 @@ void SymbolRenderWidget::drawIcon(QPainter &painter, int i) const
 	painter.save();
 	
 	Symbol* symbol = map->getSymbol(i);
-	painter.drawImage(0, 0, symbol->getIcon(map));
+	if (symbol->hasIcon())
+		painter.drawImage(0, 0, symbol->getIcon(map));
+	else
+		painter.fillRect(0, 0, icon_size - 1, icon_size - 1, QColor(128, 128, 128, 48));
 	
 	if (isSymbolSelected(i) || i == current_symbol_index)
 	{
@@ -472,29 +487,33 @@ void SymbolRenderWidget::drawIcon(QPainter &painter, int i) const
 
 void SymbolRenderWidget::paintEvent(QPaintEvent* event)
 {
-	QRect event_rect = event->rect().adjusted(-icon_size, -icon_size, 0, 0);
-	
 	QPainter painter(this);
 	painter.setPen(Qt::gray);
 	
-	int x = 0;
-	int y = 0;
-	for (int i = 0; i < map->getNumSymbols(); ++i)
+	// Only the icons in the exposed rows and columns are visited.
+	auto const event_rect = event->rect();
+	auto const num_symbols = map->getNumSymbols();
+	auto const first_row = qMax(0, event_rect.top() / icon_size);
+	auto const last_row = event_rect.bottom() / icon_size;
+	auto const first_column = qMax(0, event_rect.left() / icon_size);
+	auto const last_column = qMin(icons_per_row - 1, event_rect.right() / icon_size);
+	for (int row = first_row; row <= last_row; ++row)
 	{
-		if (event_rect.contains(x,y))
+		for (int column = first_column; column <= last_column; ++column)
 		{
+			auto const i = row * icons_per_row + column;
+			if (i >= num_symbols)
+				break;
+			
+			if (!map->getSymbol(i)->hasIcon()
+			    && std::find(begin(pending_icons), end(pending_icons), i) == end(pending_icons))
+				pending_icons.push_back(i);
+			
 			painter.save();
-			painter.translate(x, y);
+			painter.translate(column * icon_size, row * icon_size);
 			drawIcon(painter, i);
 			painter.restore();
 		}
-		
-		x += icon_size;
-		if (x >= icons_per_row * icon_size)
-		{
-			x = 0;
-			y +=  icon_size;
-		}
 	}
 	
 	// Drop indicator?
@@ -507,6 +526,39 @@ void SymbolRenderWidget::paintEvent(QPaintEvent* event)
 	}
 	
 	painter.end();
+	
+	if (!pending_icons.empty())
+		icon_timer->start();
+}
+
+void SymbolRenderWidget::createPendingIcons()
+{
+	QElapsedTimer timer;
+	timer.start();
+	
+	// Symbols which were scrolled out of view are dropped from the queue.
+	// They are queued again when they are painted.
+	auto const visible_rect = visibleRegion().boundingRect();
+	auto next = begin(pending_icons);
+	for (; next != end(pending_icons) && !timer.hasExpired(20); ++next)
+	{
+		auto const i = *next;
+		if (i >= map->getNumSymbols())
+			continue;
+		if (!visible_rect.intersects(QRect(iconPosition(i), QSize(icon_size, icon_size))))
+			continue;
+		
+		auto const* symbol = map->getSymbol(i);
+		if (!symbol->hasIcon())
+		{
+			symbol->getIcon(map);
+			updateSingleIcon(i);
+		}
+	}
+	pending_icons.erase(begin(pending_icons), next);
+	
+	if (!pending_icons.empty())
+		icon_timer->start();
 }
 
 void SymbolRenderWidget::resizeEvent(QResizeEvent* event)
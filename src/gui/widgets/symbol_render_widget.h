@@ -23,6 +23,7 @@
 #define OPENORIENTEERING_SYMBOL_RENDER_WIDGET_H
 
 #include <set>
+#include <vector>
 
 #include <QObject>
 #include <QPoint>
@@ -42,6 +43,7 @@ class QMouseEvent;
 class QPaintEvent;
 class QPainter;
 class QResizeEvent;
+class QTimer;
 
 namespace OpenOrienteering {
 
@@ -217,6 +219,14 @@ protected slots:
 	void sortByColorPriority();
 	void setCustomIconsVisible(bool checked);
 	
+	/**
+	 * @brief Creates the missing icons for the visible symbols.
+	 * 
+	 * Icons are created in short time slices on the GUI thread. This function
+	 * reschedules itself until all pending icons are done.
+	 */
+	void createPendingIcons();
+	
 protected:
 	void resizeEvent(QResizeEvent* event) override;
 	
@@ -369,6 +379,9 @@ private:
 	QScopedPointer<SymbolIconDecorator> hidden_symbol_decoration;
 	QScopedPointer<SymbolIconDecorator> protected_symbol_decoration;
 	QScopedPointer<SymbolIconDecorator> helper_symbol_decoration;
+	
+	std::vector<int> pending_icons;  ///< Symbols whose icons are shown as placeholders
+	QTimer* icon_timer;
 };
 
 //### SymbolRenderWidget inline code ###
@@ -21,6 +21,7 @@
 
 #include "template_list_widget.h"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -37,9 +38,12 @@
 #include <QCheckBox>
 #include <QCoreApplication>
 #include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
+#include <QDoubleSpinBox>
 #include <QEvent>
 #include <QFileInfo>
+#include <QFormLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QIcon>
@@ -49,6 +53,7 @@
 #include <QLabel>
 #include <QLatin1Char>
 #include <QLatin1String>
+#include <QLineEdit>
 #include <QList>
 #include <QLocale>
 #include <QMenu>
@@ -56,6 +61,7 @@
 #include <QModelIndex>
 #include <QPainter>
 #include <QPixmap>
+#include <QProgressDialog>
 #include <QRect>
 #include <QScroller>
 #include <QSettings>
@@ -80,6 +86,8 @@
 #include "settings.h"
 #include "core/georeferencing.h"
 #include "core/map.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
 #include "gui/file_dialog.h"
@@ -94,10 +102,16 @@
 #include "templates/template_map.h"
 #include "templates/template_position_dock_widget.h"
 #include "templates/template_table_model.h"
+#include "templates/template_tile_service.h"
 #include "templates/template_tool_move.h"
 #include "tools/tool.h"
+#include "undo/object_undo.h"
 #include "util/item_delegates.h"
 
+#ifdef MAPPER_USE_GDAL
+#include "gdal/gdal_template.h"
+#endif
+
 
 #ifdef __clang_analyzer__
 #define singleShot(A, B, C) singleShot(A, B, #C) // NOLINT 
@@ -129,6 +143,23 @@ QToolButton* createToolButton(const QIcon& icon, const QString& text)
 	return Util::ToolButton::create(icon, text, "templates.html#setup");
 }
 
+#ifdef MAPPER_USE_GDAL
+/// Returns the template as GdalTemplate, or nullptr.
+GdalTemplate* gdalTemplate(Template* temp)
+{
+	if (!temp || qstrcmp(temp->getTemplateType(), "GdalTemplate") != 0)
+		return nullptr;
+	return static_cast<GdalTemplate*>(temp);
+}
+
+/// Returns the template as GdalTemplate if it is a loaded elevation model.
+GdalTemplate* elevationModel(Template* temp)
+{
+	auto* gdal_template = gdalTemplate(temp);
+	return gdal_template && gdal_template->isElevationModel() ? gdal_template : nullptr;
+}
+#endif
+
 }  // anonymous namespace
 
 
@@ -188,6 +219,8 @@ TemplateListWidget::TemplateListWidget(Map& map, MapView& main_view, MapEditorCo
 	template_table->setSelectionBehavior(QAbstractItemView::SelectRows);
 	template_table->setSelectionMode(QAbstractItemView::SingleSelection);
 	template_table->verticalHeader()->setVisible(false);
+	// Thumbnails are twice as wide as high, and fit into the row height.
+	template_table->setIconSize(QSize(2, 1) * fontMetrics().height());
 #ifdef NO_TEMPLATE_GROUP_SUPPORT
 	// Template grouping is not yet implemented.
 	template_table->hideColumn(TemplateTableModel::groupColumn());
@@ -239,6 +272,7 @@ TemplateListWidget::TemplateListWidget(Map& map, MapView& main_view, MapEditorCo
 	{
 		new_button_menu->addAction(QIcon(QString::fromLatin1(":/images/open.png")), tr("Open..."), this, &TemplateListWidget::openTemplate);
 		new_button_menu->addAction(controller.getAction("reopentemplate"));
+		new_button_menu->addAction(tr("Tile service..."), this, &TemplateListWidget::openTileService);
 	}
 	duplicate_action = new_button_menu->addAction(QIcon(QString::fromLatin1(":/images/tool-duplicate.png")), tr("Duplicate"), this, &TemplateListWidget::duplicateTemplate);
 #if 0
@@ -281,6 +315,7 @@ TemplateListWidget::TemplateListWidget(Map& map, MapView& main_view, MapEditorCo
 	georef_action->setCheckable(true);
 	position_action = edit_menu->addAction(tr("Positioning..."));
 	position_action->setCheckable(true);
+	zoom_range_action = edit_menu->addAction(tr("Zoom range..."), this, &TemplateListWidget::zoomRangeClicked);
 	edit_menu->addSeparator();
 	import_action =  edit_menu->addAction(tr("Import and remove"), this, &TemplateListWidget::importClicked);
 	
@@ -290,6 +325,18 @@ TemplateListWidget::TemplateListWidget(Map& map, MapView& main_view, MapEditorCo
 	vectorize_action = nullptr;
 #endif /* WITH_COVE */
 
+#ifdef MAPPER_USE_GDAL
+	slope_shading_action = edit_menu->addAction(tr("Slope shading"), this, &TemplateListWidget::slopeShadingClicked);
+	slope_shading_action->setCheckable(true);
+	contours_action = edit_menu->addAction(tr("Generate contours..."), this, &TemplateListWidget::generateContoursClicked);
+	reproject_action = edit_menu->addAction(tr("Reproject to map CRS"), this, &TemplateListWidget::reprojectClicked);
+	reproject_action->setCheckable(true);
+#else
+	slope_shading_action = nullptr;
+	contours_action = nullptr;
+	reproject_action = nullptr;
+#endif
+
 	edit_button = createToolButton(QIcon(QString::fromLatin1(":/images/settings.png")),
 	                            ::OpenOrienteering::MapEditorController::tr("&Edit").remove(QLatin1Char('&')));
 	edit_button->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
@@ -478,6 +525,10 @@ void TemplateListWidget::updateButtons()
 		bool custom_enabled = false;
 		bool import_enabled = false;
 		bool vectorize_enabled  = false;
+		bool elevation_enabled  = false;
+		bool slope_shading      = false;
+		bool reproject_enabled  = false;
+		bool reprojected        = false;
 		if (bool(temp))
 		{
 			is_georeferenced = temp->isTemplateGeoreferenced();
@@ -489,6 +540,18 @@ void TemplateListWidget::updateButtons()
 				import_enabled = bool(qobject_cast<TemplateMap*>(temp));
 				vectorize_enabled = qobject_cast<TemplateImage*>(temp)
 									&& temp->getTemplateState() == Template::Loaded;
+#ifdef MAPPER_USE_GDAL
+				if (auto* dem = elevationModel(temp))
+				{
+					elevation_enabled = true;
+					slope_shading = dem->reliefShading() == ReliefShading::Slope;
+				}
+				if (auto* gdal_template = gdalTemplate(temp))
+				{
+					reproject_enabled = is_georeferenced;
+					reprojected = gdal_template->isReprojected();
+				}
+#endif
 			}
 		}
 		else if (current_row >= 0)
@@ -503,9 +566,22 @@ void TemplateListWidget::updateButtons()
 		move_by_hand_action->setEnabled(custom_enabled);
 		adjust_button->setEnabled(custom_enabled);
 		position_action->setEnabled(custom_enabled);
+		zoom_range_action->setEnabled(edit_enabled);
 		import_action->setEnabled(import_enabled);
 		if (vectorize_action)
 			vectorize_action->setEnabled(vectorize_enabled);
+		if (slope_shading_action)
+		{
+			slope_shading_action->setEnabled(elevation_enabled);
+			slope_shading_action->setChecked(slope_shading);
+		}
+		if (contours_action)
+			contours_action->setEnabled(elevation_enabled);
+		if (reproject_action)
+		{
+			reproject_action->setEnabled(reproject_enabled);
+			reproject_action->setChecked(reprojected);
+		}
 	}
 	
 	// Not strictly related to buttons, but exactly the same triggers.
@@ -701,6 +777,49 @@ void TemplateListWidget::openTemplate()
 	}
 }
 
+void TemplateListWidget::openTileService()
+{
+	QSettings settings;
+	auto url = settings.value(QString::fromLatin1("templateTileServiceUrl")).toString();
+	bool ok = false;
+	url = QInputDialog::getText(window(), tr("Tile service"),
+	                            tr("URL pattern of the tiles, with {z}, {x} and {y}:"),
+	                            QLineEdit::Normal, url, &ok).trimmed();
+	if (!ok || url.isEmpty())
+		return;
+	
+	QString error;
+	auto new_template = std::unique_ptr<Template>();
+	if (!TemplateTileService::canRead(url))
+	{
+		error = tr("This is not a URL of a tile service.");
+	}
+	else
+	{
+		settings.setValue(QString::fromLatin1("templateTileServiceUrl"), url);
+		new_template = std::make_unique<TemplateTileService>(url, &map);
+		if (!new_template->setupAndLoad(window(), controller.getMainWidget()->getMapView()))
+		{
+			error = new_template->errorString();
+			new_template.reset();
+		}
+	}
+	
+	if (!error.isEmpty())
+	{
+		auto const error_template = tr("Cannot open template\n%1:\n%2");
+		QMessageBox::warning(window(), tr("Error"), error_template.arg(url, error));
+		return;
+	}
+	
+	int pos = -1;
+	int row = currentRow();
+	if (row >= 0)
+		pos = posFromRow(row);
+	
+	map.addTemplate(pos, std::move(new_template));
+}
+
 void TemplateListWidget::deleteTemplate()
 {
 	int pos = posFromRow(currentRow());
@@ -849,6 +968,43 @@ void TemplateListWidget::positionClicked(bool checked)
 	}
 }
 
+void TemplateListWidget::zoomRangeClicked()
+{
+	auto* temp = currentTemplate();
+	if (!temp)
+		return;
+	
+	QDialog dialog(window());
+	dialog.setWindowTitle(tr("Zoom range"));
+	
+	auto* layout = new QFormLayout(&dialog);
+	auto* explanation = new QLabel(tr("The template is drawn only when the zoom is within this range."));
+	explanation->setWordWrap(true);
+	layout->addRow(explanation);
+	
+	auto* min_zoom_edit = Util::SpinBox::create(3, 0, MapView::zoom_in_limit, QString::fromLatin1("x"));
+	min_zoom_edit->setSpecialValueText(tr("No limit"));
+	min_zoom_edit->setValue(temp->getMinZoom());
+	layout->addRow(tr("Minimum zoom:"), min_zoom_edit);
+	
+	auto* max_zoom_edit = Util::SpinBox::create(3, 0, MapView::zoom_in_limit, QString::fromLatin1("x"));
+	max_zoom_edit->setSpecialValueText(tr("No limit"));
+	max_zoom_edit->setValue(temp->getMaxZoom());
+	layout->addRow(tr("Maximum zoom:"), max_zoom_edit);
+	
+	auto* button_box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	connect(button_box, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+	connect(button_box, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+	layout->addRow(button_box);
+	
+	if (dialog.exec() != QDialog::Accepted)
+		return;
+	
+	temp->setZoomRange(min_zoom_edit->value(), max_zoom_edit->value());
+	map.setTemplatesDirty();
+	map.updateAllMapWidgets();
+}
+
 void TemplateListWidget::importClicked()
 {
 	auto* prototype = qobject_cast<const TemplateMap*>(currentTemplate());
@@ -991,6 +1147,70 @@ void TemplateListWidget::vectorizeClicked()
 #endif /* WITH_COVE */
 }
 
+void TemplateListWidget::slopeShadingClicked(bool checked)
+{
+#ifdef MAPPER_USE_GDAL
+	if (auto* dem = elevationModel(currentTemplate()))
+		dem->setReliefShading(checked ? ReliefShading::Slope : ReliefShading::Hillshade);
+#else
+	Q_UNUSED(checked)
+#endif
+}
+
+void TemplateListWidget::generateContoursClicked()
+{
+#ifdef MAPPER_USE_GDAL
+	auto* dem = elevationModel(currentTemplate());
+	if (!dem)
+		return;
+	
+	auto const* symbol = controller.activeSymbol();
+	if (!symbol || symbol->getType() != Symbol::Line)
+	{
+		QMessageBox::warning(this, tr("Error"), tr("Select a line symbol for the contours."));
+		return;
+	}
+	
+	bool ok = false;
+	auto const interval = QInputDialog::getDouble(window(), tr("Generate contours"),
+	                                              tr("Contour interval:"), 5, 0.1, 1000, 1, &ok);
+	if (!ok)
+		return;
+	
+	QProgressDialog progress_dialog(tr("Generating contours..."), tr("Cancel"), 0, 100, window());
+	progress_dialog.setWindowModality(Qt::WindowModal);
+	progress_dialog.setMinimumDuration(500);
+	auto objects = dem->generateContours(interval, symbol, [&progress_dialog](int percent) {
+		progress_dialog.setValue(percent);
+		return !progress_dialog.wasCanceled();
+	});
+	progress_dialog.setValue(100);
+	if (objects.empty())
+		return;
+	
+	map.beginObjectUpdateBatch();
+	auto* undo_step = new DeleteObjectsUndoStep(&map);
+	for (auto* object : objects)
+		undo_step->addObject(map.addObject(object));
+	map.endObjectUpdateBatch();
+	map.push(undo_step);
+	map.setObjectsDirty();
+#endif
+}
+
+void TemplateListWidget::reprojectClicked(bool checked)
+{
+#ifdef MAPPER_USE_GDAL
+	if (auto* gdal_template = gdalTemplate(currentTemplate()))
+	{
+		gdal_template->setReprojected(checked);
+		map.updateAllMapWidgets();
+	}
+#else
+	Q_UNUSED(checked)
+#endif
+}
+
 void TemplateListWidget::moreActionClicked(QAction* action)
 {
 	Q_UNUSED(action);
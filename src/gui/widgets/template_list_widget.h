@@ -121,6 +121,7 @@ protected:
 #endif
 	
 	void openTemplate();
+	void openTileService();
 	void deleteTemplate();
 	void duplicateTemplate();
 	void moveTemplateUp();
@@ -131,10 +132,14 @@ protected:
 	void adjustClicked(bool checked);
 	//void groupClicked();
 	void positionClicked(bool checked);
+	void zoomRangeClicked();
 	void importClicked();
 	void changeGeorefClicked();
 	void moreActionClicked(QAction* action);
 	void vectorizeClicked();
+	void slopeShadingClicked(bool checked);
+	void generateContoursClicked();
+	void reprojectClicked(bool checked);
 	
 	void templatePositionDockWidgetClosed(OpenOrienteering::Template* temp);
 	
@@ -159,9 +164,13 @@ private:
 	QAction* duplicate_action;
 	QAction* move_by_hand_action;
 	QAction* position_action;
+	QAction* zoom_range_action;
 	QAction* import_action;
 	QAction* georef_action;
 	QAction* vectorize_action;
+	QAction* slope_shading_action;
+	QAction* contours_action;
+	QAction* reproject_action;
 	
 	// Buttons
 	QWidget* list_buttons_group;
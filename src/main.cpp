@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020 Kai Pastor
+ *    Copyright 2012-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -51,10 +51,13 @@
 #include "global.h"
 #include "mapper_config.h"
 #include "mapper_resource.h"
+#include "settings.h"
+#include "fileformats/batch_export.h"
 #include "gui/home_screen_controller.h"
 #include "gui/main_window.h"
 #include "gui/widgets/mapper_proxystyle.h"
 #include "util/recording_translator.h"  // IWYU pragma: keep
+#include "util/trace.h"
 #include "util/translation_util.h"
 
 // IWYU pragma: no_forward_declare QTranslator
@@ -96,6 +99,23 @@ QStringList firstRemoved(QStringList&& input)
 }
 
 
+#ifdef MAPPER_ENABLE_TRACING
+
+/**
+ * Starts or stops recording a performance trace, according to the settings.
+ */
+void updateTraceRecording()
+{
+	auto const record = Settings::getInstance().getSetting(Settings::General_RecordTrace).toBool();
+	if (record && !Trace::isRecording())
+		Trace::startRecording();
+	else if (!record && Trace::isRecording())
+		Trace::stopRecording(Trace::defaultFilePath());
+}
+
+#endif
+
+
 #ifdef MAPPER_USE_QTSINGLEAPPLICATION
 
 void resetActivationWindow(QtSingleApplication& app)
@@ -123,8 +143,45 @@ void resetActivationWindow(QtSingleApplication& app)
 #endif
 
 
+#ifndef Q_OS_ANDROID
+
+/**
+ * Runs the batch export, without a single application instance and without
+ * a main window.
+ */
+int runBatchExport(int argc, char** argv)
+{
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+	// No display is needed for rendering.
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+	QApplication qapp(argc, argv);
+	
+	Q_INIT_RESOURCE(resources);
+	QCoreApplication::setOrganizationName(QString::fromLatin1("OpenOrienteering.org"));
+	QCoreApplication::setApplicationName(QString::fromLatin1("Mapper"));
+#ifdef WIN32
+	QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath() + QLatin1String("/plugins"));
+#endif
+	MapperResource::setSeachPaths();
+	setlocale(LC_NUMERIC, "C");
+	doStaticInitializations();
+	
+	BatchExport batch_export;
+	return batch_export.exec(QCoreApplication::arguments());
+}
+
+#endif
+
+
 int main(int argc, char** argv)
 {
+#ifndef Q_OS_ANDROID
+	if (BatchExport::isRequested(argc, argv))
+		return runBatchExport(argc, argv);
+#endif
+	
 #ifdef MAPPER_USE_QTSINGLEAPPLICATION
 	// Create single-instance application.
 	// Use "oo-mapper" instead of the executable as identifier, in case we launch from different paths.
@@ -179,9 +236,6 @@ int main(int argc, char** argv)
 #endif
 	QCoreApplication::installTranslator(&translation.getQtTranslator());
 	QCoreApplication::installTranslator(&translation.getAppTranslator());
-	map_symbol_translator = translation.load(QString::fromLatin1("map_symbols")).release();
-	if (map_symbol_translator)
-		map_symbol_translator->setParent(&qapp);
 	
 	// Avoid numeric issues in libraries such as GDAL
 	setlocale(LC_NUMERIC, "C");
@@ -189,11 +243,20 @@ int main(int argc, char** argv)
 	// Initialize static things like the file format registry.
 	doStaticInitializations();
 	
+#ifdef MAPPER_ENABLE_TRACING
+	updateTraceRecording();
+	QObject::connect(&Settings::getInstance(), &Settings::settingsChanged, &qapp, &updateTraceRecording);
+	QObject::connect(&qapp, &QCoreApplication::aboutToQuit, &qapp, []() {
+		if (Trace::isRecording())
+			Trace::stopRecording(Trace::defaultFilePath());
+	});
+#endif
+	
 	// Some style settings (in particular the menu item font) are not
 	// applied correctly before the app runs. So we postpone these steps
 	// via the event loop.
 	// OTOH the app crashes on Android if we don't set style early enough.
-	QTimer::singleShot(0, qApp, [&qapp]() {
+	QTimer::singleShot(0, qApp, [&qapp, &translation]() {
 #ifndef __clang_analyzer__
 		// No leak: QApplication takes ownership.
 		QApplication::setStyle(new MapperProxyStyle());
@@ -221,6 +284,15 @@ int main(int argc, char** argv)
 		
 		first_window->setVisible(true);
 		first_window->raise();
+		
+		// Symbol texts are needed only for maps, and files are opened even
+		// later (cf. MainWindow::openPathLater()). So the map symbol
+		// translations are loaded after the home screen was set up.
+		QTimer::singleShot(0, &qapp, [&qapp, &translation]() {
+			map_symbol_translator = translation.load(QString::fromLatin1("map_symbols")).release();
+			if (map_symbol_translator)
+				map_symbol_translator->setParent(&qapp);
+		});
 	});
 	
 	// Let application run
@@ -50,3 +50,9 @@ QPaintEngine::Type AdvancedPdfPrinter::paintEngineType()
 {
 	return AdvancedPdfEngine::PaintEngineType;
 }
+
+void AdvancedPdfPrinter::setSpotColor(QRgb color, const QStringList& colorants, const QVector<QColor>& alternates,
+                                      const QVector<qreal>& tints, bool overprint)
+{
+	engine->setSpotColor(color, colorants, alternates, tints, overprint);
+}
@@ -22,8 +22,12 @@
 
 #include <memory>
 
+#include <QtGlobal>
+#include <QColor>
 #include <QPaintEngine>
 #include <QPrinter>
+#include <QStringList>
+#include <QVector>
 
 
 class AdvancedPdfPrintEngine;
@@ -43,6 +47,16 @@ public:
 	/** Returns the paint engine type which is used for advanced pdf generation. */
 	static QPaintEngine::Type paintEngineType();
 	
+	/**
+	 * Paints the given color in named separations instead of DeviceCMYK.
+	 * 
+	 * The color is identified by its RGB value. For each colorant, there
+	 * must be a CMYK alternate color and a tint. When overprint is true,
+	 * the color does not knock out other separations on the output device.
+	 */
+	void setSpotColor(QRgb color, const QStringList& colorants, const QVector<QColor>& alternates,
+	                  const QVector<qreal>& tints, bool overprint);
+	
 private:
 	void init();
 	
@@ -36,10 +36,13 @@
 
 #include <qbuffer.h>
 #include <qcryptographichash.h>
+#include <qdatastream.h>
 #include <qdatetime.h>
 #include <qdebug.h>
 #include <qfile.h>
+#include <qhash.h>
 #include <qimagewriter.h>
+#include <qmutex.h>
 #include <qnumeric.h>
 #include <qtemporaryfile.h>
 #include <quuid.h>
@@ -58,6 +61,16 @@ static const bool do_compress = true;
 // Can't use it though, as gs generates completely wrong images if this is true.
 static const bool interpolateImages = false;
 
+// Repeated paths, e.g. from point symbols, are written once as form XObjects.
+// Paths with more elements are drawn inline.
+static const int maxInstanceElements = 256;
+// Shorter path content is not worth a form reference.
+static const int minInstanceContentSize = 64;
+// The number of distinct paths which are tracked for instancing.
+static const int maxPathInstances = 65536;
+// The number of generated font subsets which are kept for the session.
+static const int maxCachedFontSubsets = 64;
+
 static void initResources()
 {
 #if BUILDING_QT
@@ -912,9 +925,11 @@ void AdvancedPdfEngine::drawPath (const QPainterPath &p)
 
     if (d->simplePen) {
         // draw strokes natively in this case for better output
-        *d->currentPage << AdvancedPdf::generatePath(p, QTransform(), d->hasBrush ? AdvancedPdf::FillAndStrokePath : AdvancedPdf::StrokePath);
+        const auto flags = d->hasBrush ? AdvancedPdf::FillAndStrokePath : AdvancedPdf::StrokePath;
+        if (!d->drawPathInstance(p, QTransform(), flags))
+            *d->currentPage << AdvancedPdf::generatePath(p, QTransform(), flags);
     } else {
-        if (d->hasBrush)
+        if (d->hasBrush && !d->drawPathInstance(p, d->stroker.matrix, AdvancedPdf::FillPath))
             *d->currentPage << AdvancedPdf::generatePath(p, d->stroker.matrix, AdvancedPdf::FillPath);
         if (d->hasPen) {
             *d->currentPage << "q\n";
@@ -1257,16 +1272,25 @@ void AdvancedPdfEngine::setPen()
     Q_ASSERT(b.style() == Qt::SolidPattern && b.isOpaque());
 
     QColor rgba = b.color();
-    if (d->grayscale) {
-        qreal gray = (255-qGray(rgba.rgba()))/255.0;
-        *d->currentPage << 0.0 << 0.0 << 0.0 << gray;
+    if (const AdvancedPdfEnginePrivate::SpotColor *spot = d->spotColor(rgba)) {
+        *d->currentPage << "/CSs" << int(spot->colorSpace) << "CS ";
+        for (qreal tint : spot->tints)
+            *d->currentPage << tint;
     } else {
-        *d->currentPage << rgba.cyanF()
-                        << rgba.magentaF()
-                        << rgba.yellowF()
-                        << rgba.blackF();
+        if (!d->spotColors.isEmpty())
+            *d->currentPage << "/CSp CS ";
+        if (d->grayscale) {
+            qreal gray = (255-qGray(rgba.rgba()))/255.0;
+            *d->currentPage << 0.0 << 0.0 << 0.0 << gray;
+        } else {
+            *d->currentPage << rgba.cyanF()
+                            << rgba.magentaF()
+                            << rgba.yellowF()
+                            << rgba.blackF();
+        }
     }
     *d->currentPage << "SCN\n";
+    d->setOverprint();
 
     *d->currentPage << d->pen.widthF() << "w ";
 
@@ -1321,17 +1345,26 @@ void AdvancedPdfEngine::setBrush()
     if (!patternObject && !specifyColor)
         return;
 
-    *d->currentPage << (patternObject ? "/PCSp cs " : "/CSp cs ");
-    if (specifyColor) {
-        QColor rgba = d->brush.color();
-        if (d->grayscale) {
-            qreal gray = (255-qGray(rgba.rgba()))/255.0;
-            *d->currentPage << 0.0 << 0.0 << 0.0 << gray;
-        } else {
-            *d->currentPage << rgba.cyanF()
-                            << rgba.magentaF()
-                            << rgba.yellowF()
-                            << rgba.blackF();
+    const AdvancedPdfEnginePrivate::SpotColor *spot = nullptr;
+    if (specifyColor && !patternObject)
+        spot = d->spotColor(d->brush.color());
+    if (spot) {
+        *d->currentPage << "/CSs" << int(spot->colorSpace) << "cs ";
+        for (qreal tint : spot->tints)
+            *d->currentPage << tint;
+    } else {
+        *d->currentPage << (patternObject ? "/PCSp cs " : "/CSp cs ");
+        if (specifyColor) {
+            QColor rgba = d->brush.color();
+            if (d->grayscale) {
+                qreal gray = (255-qGray(rgba.rgba()))/255.0;
+                *d->currentPage << 0.0 << 0.0 << 0.0 << gray;
+            } else {
+                *d->currentPage << rgba.cyanF()
+                                << rgba.magentaF()
+                                << rgba.yellowF()
+                                << rgba.blackF();
+            }
         }
     }
     if (patternObject)
@@ -1342,6 +1375,7 @@ void AdvancedPdfEngine::setBrush()
         *d->currentPage << "/GState" << gStateObject << "gs\n";
     else
         *d->currentPage << "/GSa gs\n";
+    d->setOverprint();
 }
 
 
@@ -1384,6 +1418,42 @@ void AdvancedPdfEngine::setPdfVersion(PdfVersion version)
     d->pdfVersion = version;
 }
 
+// Returns a PDF name object for the UTF-8 encoded string.
+static QByteArray toPdfName(const QString &string)
+{
+    QByteArray name = "/";
+    const QByteArray utf8 = string.toUtf8();
+    for (const char c : utf8) {
+        const uchar u = uchar(c);
+        if (u < 0x21 || u > 0x7e || strchr("()<>[]{}/%#", c)) {
+            char buf[4];
+            qsnprintf(buf, sizeof(buf), "#%02X", u);
+            name += buf;
+        } else {
+            name += c;
+        }
+    }
+    return name;
+}
+
+void AdvancedPdfEngine::setSpotColor(QRgb color, const QStringList &colorants, const QVector<QColor> &alternates,
+                                     const QVector<qreal> &tints, bool overprint)
+{
+    Q_D(AdvancedPdfEngine);
+    Q_ASSERT(!colorants.isEmpty());
+    Q_ASSERT(alternates.size() == colorants.size());
+    Q_ASSERT(tints.size() == colorants.size());
+
+    AdvancedPdfEnginePrivate::SpotColor spot;
+    for (const QString &colorant : colorants)
+        spot.colorants.append(toPdfName(colorant));
+    spot.alternates = alternates;
+    spot.tints = tints;
+    spot.overprint = overprint;
+    spot.colorSpace = 0;
+    d->spotColors.insert(qRgb(qRed(color), qGreen(color), qBlue(color)), spot);
+}
+
 void AdvancedPdfEngine::setPageLayout(const QPageLayout &pageLayout)
 {
     Q_D(AdvancedPdfEngine);
@@ -1523,6 +1593,7 @@ bool AdvancedPdfEngine::begin(QPaintDevice *pdev)
     d->pages.clear();
     d->imageCache.clear();
     d->alphaCache.clear();
+    d->pathInstances.clear();
 
     setActive(true);
     d->writeHeader();
@@ -1767,11 +1838,63 @@ void AdvancedPdfEnginePrivate::writePageRoot()
 }
 
 
+namespace {
+
+struct CachedFontSubset
+{
+    QByteArray data;
+    QFixed emSquare;
+    QVector<QFixed> widths;
+};
+
+// Identifies the font data generated by QFontSubset::toTruetype().
+QByteArray fontSubsetKey(const QFontSubset *font)
+{
+    const QFontEngine::FaceId face_id = font->fontEngine->faceId();
+    const QFontDef &def = font->fontEngine->fontDef;
+    QByteArray key;
+    QDataStream s(&key, QIODevice::WriteOnly);
+    s << face_id.filename << face_id.uuid << face_id.index << face_id.encoding
+      << def.pixelSize << int(def.weight) << int(def.style) << int(def.styleHint)
+      << font->noEmbed << font->glyph_indices;
+    return key;
+}
+
+}
+
+// Multi-page prints and series of exports embed the same glyphs of the same
+// fonts again and again. Generating a subset means extracting and converting
+// every glyph outline, so the results are reused across documents.
+static QByteArray toTruetypeCached(const QFontSubset *font)
+{
+    static QMutex mutex;
+    static QHash<QByteArray, CachedFontSubset> cache;
+
+    const QByteArray key = fontSubsetKey(font);
+    {
+        QMutexLocker locker(&mutex);
+        const auto cached = cache.constFind(key);
+        if (cached != cache.constEnd()) {
+            // Restore the side effects of toTruetype() needed by widthArray().
+            font->emSquare = cached->emSquare;
+            font->widths = cached->widths;
+            return cached->data;
+        }
+    }
+
+    const QByteArray data = font->toTruetype();
+    QMutexLocker locker(&mutex);
+    if (cache.size() >= maxCachedFontSubsets)
+        cache.clear();
+    cache.insert(key, CachedFontSubset{ data, font->emSquare, font->widths });
+    return data;
+}
+
 void AdvancedPdfEnginePrivate::embedFont(QFontSubset *font)
 {
     //qDebug() << "embedFont" << font->object_id;
     int fontObject = font->object_id;
-    QByteArray fontData = font->toTruetype();
+    QByteArray fontData = toTruetypeCached(font);
 #ifdef FONT_DUMP
     static int i = 0;
     QString fileName("font%1.ttf");
@@ -1965,11 +2088,14 @@ void AdvancedPdfEnginePrivate::writePage()
             "/ColorSpace <<\n"
             "/PCSp %d 0 R\n"
             "/CSp /DeviceCMYK\n"
-            "/CSpg /DeviceGray\n"
-            ">>\n"
+            "/CSpg /DeviceGray\n",
+            patternColorSpace);
+    for (uint colorSpace : qAsConst(currentPage->colorSpaces))
+        xprintf("/CSs%d %d 0 R\n", colorSpace, colorSpace);
+    xprintf(">>\n"
             "/ExtGState <<\n"
             "/GSa %d 0 R\n",
-            patternColorSpace, graphicsState);
+            graphicsState);
 
     for (int i = 0; i < currentPage->graphicStates.size(); ++i)
         xprintf("/GState%d %d 0 R\n", currentPage->graphicStates.at(i), currentPage->graphicStates.at(i));
@@ -1989,6 +2115,8 @@ void AdvancedPdfEnginePrivate::writePage()
     for (int i = 0; i<currentPage->images.size(); ++i) {
         xprintf("/Im%d %d 0 R\n", currentPage->images.at(i), currentPage->images.at(i));
     }
+    for (uint form : qAsConst(currentPage->forms))
+        xprintf("/Fm%d %d 0 R\n", form, form);
     xprintf(">>\n");
 
     xprintf(">>\n"
@@ -2271,6 +2399,36 @@ int AdvancedPdfEnginePrivate::writeImage(const QByteArray &data, int width, int
     return image;
 }
 
+int AdvancedPdfEnginePrivate::writePathForm(const QByteArray &content, const QRectF &bbox)
+{
+    int form = addXrefEntry(-1);
+    char buf[256];
+    xprintf("<<\n"
+            "/Type /XObject\n"
+            "/Subtype /Form\n"
+            "/BBox [");
+    xprintf("%s", qt_real_to_string(bbox.left(), buf));
+    xprintf("%s", qt_real_to_string(bbox.top(), buf));
+    xprintf("%s", qt_real_to_string(bbox.right(), buf));
+    xprintf("%s", qt_real_to_string(bbox.bottom(), buf));
+    xprintf("]\n"
+            "/Resources << >>\n");
+
+    int lenobj = requestObject();
+    xprintf("/Length %d 0 R\n", lenobj);
+    if (do_compress)
+        xprintf("/Filter /FlateDecode\n>>\nstream\n");
+    else
+        xprintf(">>\nstream\n");
+    int len = writeCompressed(content);
+    xprintf("\nendstream\n"
+            "endobj\n");
+    addXrefEntry(lenobj);
+    xprintf("%d\n"
+            "endobj\n", len);
+    return form;
+}
+
 struct QGradientBound {
     qreal start;
     qreal stop;
@@ -3025,6 +3183,171 @@ void AdvancedPdfEnginePrivate::drawTextItem(const QPointF &p, const QTextItemInt
     *currentPage << "ET\n";
 }
 
+bool AdvancedPdfEnginePrivate::drawPathInstance(const QPainterPath &path, const QTransform &matrix, AdvancedPdf::PathFlags flags)
+{
+    // The form inherits the graphics state, but patterns and gradients
+    // would be aligned to the form's coordinate space.
+    if (path.elementCount() < 2 || path.elementCount() > maxInstanceElements)
+        return false;
+    if (flags != AdvancedPdf::StrokePath && brush.style() != Qt::SolidPattern)
+        return false;
+
+    // The content is generated relative to the first point, on a fixed grid,
+    // so that translated copies of the same path match.
+    const QPainterPath::Element &first = path.elementAt(0);
+    const QPointF origin = matrix.map(QPointF(first.x, first.y));
+    QPainterPath relative = path;
+    for (int i = 0; i < relative.elementCount(); ++i) {
+        const QPainterPath::Element &elm = path.elementAt(i);
+        const QPointF p = matrix.map(QPointF(elm.x, elm.y)) - origin;
+        relative.setElementPositionAt(i, qRound64(p.x() * 1000000) / 1000000.0, qRound64(p.y() * 1000000) / 1000000.0);
+    }
+    QByteArray content = AdvancedPdf::generatePath(relative, QTransform(), flags);
+    if (content.size() < minInstanceContentSize)
+        return false;
+
+    // The bounding box of the form must contain the stroke, including miters.
+    qreal margin = 0;
+    if (flags != AdvancedPdf::FillPath)
+        margin = pen.widthF() * qMax(qreal(1), pen.miterLimit());
+    QByteArray key = content;
+    key += QByteArray::number(margin);
+
+    auto instance = pathInstances.find(key);
+    if (instance == pathInstances.end()) {
+        // The first occurrence is drawn inline.
+        if (pathInstances.size() < maxPathInstances)
+            pathInstances.insert(key, 0);
+        return false;
+    }
+    if (!instance.value()) {
+        const QRectF bbox = relative.controlPointRect().adjusted(-margin, -margin, margin, margin);
+        instance.value() = writePathForm(content, bbox);
+    }
+
+    *currentPage << "q 1 0 0 1 " << origin << "cm /Fm" << int(instance.value()) << "Do Q\n";
+    currentPage->forms.insert(instance.value());
+    return true;
+}
+
+const AdvancedPdfEnginePrivate::SpotColor *AdvancedPdfEnginePrivate::spotColor(const QColor &color)
+{
+    if (grayscale || spotColors.isEmpty())
+        return nullptr;
+
+    auto spot = spotColors.find(color.rgb());
+    if (spot == spotColors.end())
+        return nullptr;
+
+    if (!spot->colorSpace)
+        spot->colorSpace = writeSpotColorSpace(*spot);
+    if (currentPage->colorSpaces.indexOf(spot->colorSpace) < 0)
+        currentPage->colorSpaces.append(spot->colorSpace);
+    return &*spot;
+}
+
+uint AdvancedPdfEnginePrivate::writeSpotColorSpace(const SpotColor &spot)
+{
+    const int n = spot.colorants.size();
+    QByteArray definition;
+    QByteArray function;
+    {
+        AdvancedPdf::ByteStream s(&definition);
+        AdvancedPdf::ByteStream f(&function);
+        if (n == 1) {
+            const QColor &alternate = spot.alternates.at(0);
+            s << "[/Separation " << spot.colorants.at(0) << " /DeviceCMYK\n"
+              << "<< /FunctionType 2 /Domain [0 1] /C0 [0 0 0 0] /C1 ["
+              << alternate.cyanF() << alternate.magentaF() << alternate.yellowF() << alternate.blackF()
+              << "] /N 1 >>]";
+        } else {
+            s << "[/DeviceN [";
+            for (const QByteArray &colorant : spot.colorants)
+                s << colorant << ' ';
+            s << "] /DeviceCMYK ";
+
+            // The tinted alternates are added up per CMYK component.
+            // The stack holds the n tints, the finished components,
+            // and the current sum.
+            f << "{\n";
+            for (int j = 0; j < 4; ++j) {
+                f << "0 ";
+                for (int i = 0; i < n; ++i) {
+                    const QColor &alternate = spot.alternates.at(i);
+                    const qreal value = j == 0 ? alternate.cyanF()
+                                      : j == 1 ? alternate.magentaF()
+                                      : j == 2 ? alternate.yellowF()
+                                               : alternate.blackF();
+                    f << (j + n - i) << "index " << value << "mul add ";
+                }
+                f << "dup 1 gt { pop 1 } if\n";
+            }
+            f << (n + 4) << "4 roll";
+            for (int i = 0; i < n; ++i)
+                f << " pop";
+            f << "\n}";
+        }
+    }
+
+    uint &object = spotColorSpaces[definition + function];
+    if (object)
+        return object;
+
+    if (n > 1) {
+        int functionObject = addXrefEntry(-1);
+        xprintf("<<\n"
+                "/FunctionType 4\n"
+                "/Domain [");
+        for (int i = 0; i < n; ++i)
+            xprintf("0 1 ");
+        xprintf("]\n"
+                "/Range [0 1 0 1 0 1 0 1]\n"
+                "/Length %d\n"
+                ">>\n"
+                "stream\n", function.size());
+        write(function);
+        xprintf("\nendstream\n"
+                "endobj\n");
+        definition += QByteArray::number(functionObject) + " 0 R]";
+    }
+
+    object = addXrefEntry(-1);
+    xprintf("%s\nendobj\n", definition.constData());
+    return object;
+}
+
+void AdvancedPdfEnginePrivate::setOverprint()
+{
+    if (spotColors.isEmpty())
+        return;
+
+    // Other colors knock out the separations.
+    auto overprints = [this](const QBrush &b) {
+        if (b.style() != Qt::SolidPattern)
+            return false;
+        const SpotColor *spot = spotColor(b.color());
+        return spot && spot->overprint;
+    };
+    const int mode = (brush.style() != Qt::NoBrush && overprints(brush) ? 1 : 0)
+                     | (pen.style() != Qt::NoPen && overprints(pen.brush()) ? 2 : 0);
+    uint &state = overprintStates[mode];
+    if (!state) {
+        state = addXrefEntry(-1);
+        xprintf("<<\n"
+                "/Type /ExtGState\n"
+                "/op %s\n"
+                "/OP %s\n"
+                "/OPM 1\n"
+                ">>\n"
+                "endobj\n",
+                (mode & 1) ? "true" : "false",
+                (mode & 2) ? "true" : "false");
+    }
+    if (currentPage->graphicStates.indexOf(state) < 0)
+        currentPage->graphicStates.append(state);
+    *currentPage << "/GState" << int(state) << "gs\n";
+}
+
 QTransform AdvancedPdfEnginePrivate::pageMatrix() const
 {
     qreal userUnit = calcUserUnit();
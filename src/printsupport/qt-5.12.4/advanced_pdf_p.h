@@ -43,7 +43,9 @@
 #ifndef QT_NO_PDF
 
 #include "QtGui/qmatrix.h"
+#include "QtCore/qset.h"
 #include "QtCore/qstring.h"
+#include "QtCore/qstringlist.h"
 #include "QtCore/qvector.h"
 #include <private/qstroker_p.h>
 #include <private/qpaintengine_p.h>
@@ -138,6 +140,8 @@ public:
     QVector<uint> patterns;
     QVector<uint> fonts;
     QVector<uint> annotations;
+    QVector<uint> colorSpaces;
+    QSet<uint> forms;
 
     void streamImage(int w, int h, int object);
 
@@ -178,6 +182,14 @@ public:
 
     void setPdfVersion(PdfVersion version);
 
+    // Paints the given color in named separations instead of DeviceCMYK.
+    // The color is identified by its RGB value. For each colorant, there
+    // must be a CMYK alternate color and a tint. A single colorant is
+    // written as Separation color space, multiple colorants as DeviceN.
+    // Overprinting is left to the output device.
+    void setSpotColor(QRgb color, const QStringList &colorants, const QVector<QColor> &alternates,
+                      const QVector<qreal> &tints, bool overprint);
+
     // reimplementations QPaintEngine
     bool begin(QPaintDevice *pdev) override;
     bool end() override;
@@ -240,10 +252,31 @@ public:
 
     void drawTextItem(const QPointF &p, const QTextItemInt &ti);
 
+    // Draws a repeated path as a reference to a shared form XObject.
+    // Returns false if the path must be drawn inline.
+    bool drawPathInstance(const QPainterPath &path, const QTransform &matrix, AdvancedPdf::PathFlags flags);
+
     QTransform pageMatrix() const;
 
     void newPage();
 
+    struct SpotColor
+    {
+        QVector<QByteArray> colorants;
+        QVector<QColor> alternates;
+        QVector<qreal> tints;
+        bool overprint;
+        uint colorSpace;
+    };
+    QHash<QRgb, SpotColor> spotColors;
+
+    // Returns the spot color which replaces the given color, or nullptr.
+    // The color space is written when needed.
+    const SpotColor *spotColor(const QColor &color);
+
+    // Sets the overprint mode of the current brush and pen.
+    void setOverprint();
+
     int currentObject;
 
     AdvancedPdfPage* currentPage;
@@ -301,6 +334,7 @@ private:
 
     int writeImage(const QByteArray &data, int width, int height, int depth,
                    int maskObject, int softMaskObject, bool dct = false, bool isMono = false);
+    int writePathForm(const QByteArray &content, const QRectF &bbox);
     void writePage();
 
     int addXrefEntry(int object, bool printostr = true);
@@ -320,6 +354,14 @@ private:
     QVector<uint> pages;
     QHash<qint64, uint> imageCache;
     QHash<QPair<uint, uint>, uint > alphaCache;
+    // Path content relative to its first point, and the form object (0 if seen only once)
+    QHash<QByteArray, uint> pathInstances;
+    // Color space definitions of spot colors, and their objects
+    QHash<QByteArray, uint> spotColorSpaces;
+    // Graphics states for overprinting of fill (1) and stroke (2)
+    uint overprintStates[4] = {};
+
+    uint writeSpotColorSpace(const SpotColor &spot);
 };
 
 QT_END_NAMESPACE
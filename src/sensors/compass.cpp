@@ -1,6 +1,6 @@
 /*
  *    Copyright 2014 Thomas Schöps
- *    Copyright 2014, 2019 Kai Pastor
+ *    Copyright 2014, 2019, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -613,7 +613,16 @@ void Compass::disconnectNotify(const QMetaMethod& signal)
 
 void Compass::emitAzimuthChanged(float value)
 {
-	emit azimuthChanged(value);
+	posted_azimuth.store(value);
+	if (!azimuth_pending.exchange(true))
+		QMetaObject::invokeMethod(this, "deliverAzimuth", Qt::QueuedConnection);
+}
+
+void Compass::deliverAzimuth()
+{
+	// Reset before reading, so that a newer value posts a new event.
+	azimuth_pending.store(false);
+	emit azimuthChanged(posted_azimuth.load());
 }
 
 
@@ -22,6 +22,7 @@
 #ifndef OPENORIENTEERING_COMPASS_H
 #define OPENORIENTEERING_COMPASS_H
 
+#include <atomic>
 #include <memory>
 
 #include <QObject>
@@ -73,11 +74,21 @@ protected:
 	
 	void disconnectNotify(const QMetaMethod& signal) override;
 	
+private slots:
+	/** Emits azimuthChanged() with the most recent value posted by the sensor thread. */
+	void deliverAzimuth();
+	
 private:
+	/** Posts a new value from the sensor thread.
+	 *  
+	 *  The value is kept in a single slot. Until it is delivered on the
+	 *  compass' thread, newer values replace it without posting another event. */
 	void emitAzimuthChanged(float value);
 	
 	std::unique_ptr<CompassPrivate> p;
 	int reference_counter = 0;
+	std::atomic<float> posted_azimuth { 0 };
+	std::atomic<bool> azimuth_pending { false };
 };
 
 
@@ -23,20 +23,43 @@
 #include "fake_position_source.h"
 
 #include <algorithm>
+#include <initializer_list>
+#include <utility>
 
 #include <QtGlobal>
 #include <QtMath>
 #include <QDateTime>
 #include <QGeoCoordinate>
 #include <QGeoPositionInfo>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QNmeaPositionInfoSource>
+#include <QString>
 #include <QTime>
 #include <QTimerEvent>
+#include <QXmlStreamReader>
 
 
 namespace OpenOrienteering
 {
 
+namespace {
+
+/**
+ * Provides access to the NMEA parser of QNmeaPositionInfoSource.
+ */
+class NmeaParser : public QNmeaPositionInfoSource
+{
+public:
+	NmeaParser() : QNmeaPositionInfoSource(SimulationMode) {}
+	using QNmeaPositionInfoSource::parsePosInfoFromNmeaData;
+};
+
+}  // namespace
+
+
 QGeoCoordinate FakePositionSource::initial_reference  {};
+std::vector<QGeoPositionInfo> FakePositionSource::initial_replay_track {};
 
 // static
 void FakePositionSource::setReferencePoint(const QGeoCoordinate &reference)
@@ -44,12 +67,98 @@ void FakePositionSource::setReferencePoint(const QGeoCoordinate &reference)
 	FakePositionSource::initial_reference = reference;
 }
 
+// static
+void FakePositionSource::setReplayTrack(std::vector<QGeoPositionInfo> track)
+{
+	FakePositionSource::initial_replay_track = std::move(track);
+}
+
+// static
+std::vector<QGeoPositionInfo> FakePositionSource::readGpx(QIODevice& device)
+{
+	std::vector<QGeoPositionInfo> track;
+	QXmlStreamReader xml(&device);
+	while (!xml.atEnd())
+	{
+		xml.readNext();
+		if (!xml.isStartElement() || xml.name() != QLatin1String("trkpt"))
+			continue;
+		
+		auto const attributes = xml.attributes();
+		auto coordinate = QGeoCoordinate {
+		                  attributes.value(QLatin1String("lat")).toDouble(),
+		                  attributes.value(QLatin1String("lon")).toDouble() };
+		auto timestamp = QDateTime();
+		auto hdop = -1.0;
+		while (xml.readNextStartElement())
+		{
+			if (xml.name() == QLatin1String("ele"))
+				coordinate.setAltitude(xml.readElementText().toDouble());
+			else if (xml.name() == QLatin1String("time"))
+				timestamp = QDateTime::fromString(xml.readElementText(), Qt::ISODate);
+			else if (xml.name() == QLatin1String("hdop"))
+				hdop = xml.readElementText().toDouble();
+			else
+				xml.skipCurrentElement();
+		}
+		
+		auto point = QGeoPositionInfo(coordinate, timestamp);
+		if (hdop >= 0)
+			point.setAttribute(QGeoPositionInfo::HorizontalAccuracy, hdop);
+		track.push_back(point);
+	}
+	
+	if (xml.hasError())
+		track.clear();
+	return track;
+}
+
+// static
+std::vector<QGeoPositionInfo> FakePositionSource::readNmea(QIODevice& device)
+{
+	std::vector<QGeoPositionInfo> track;
+	NmeaParser parser;
+	while (!device.atEnd())
+	{
+		auto const line = device.readLine();
+		QGeoPositionInfo position;
+		bool has_fix = false;
+		if (!parser.parsePosInfoFromNmeaData(line.constData(), line.size(), &position, &has_fix)
+		    || !has_fix
+		    || !position.coordinate().isValid())
+		{
+			continue;
+		}
+		
+		if (!track.empty() && track.back().timestamp().time() == position.timestamp().time())
+		{
+			// Another sentence for the same fix
+			auto& last = track.back();
+			if (position.coordinate().type() == QGeoCoordinate::Coordinate3D)
+				last.setCoordinate(position.coordinate());
+			for (auto attribute : { QGeoPositionInfo::Direction,
+			                        QGeoPositionInfo::GroundSpeed,
+			                        QGeoPositionInfo::HorizontalAccuracy,
+			                        QGeoPositionInfo::VerticalAccuracy })
+			{
+				if (position.hasAttribute(attribute))
+					last.setAttribute(attribute, position.attribute(attribute));
+			}
+			continue;
+		}
+		track.push_back(position);
+	}
+	return track;
+}
+
 
 FakePositionSource::~FakePositionSource() = default;
 
 FakePositionSource::FakePositionSource(QObject* object)
 : FakePositionSource(initial_reference, object)
-{}
+{
+	replay_track = initial_replay_track;
+}
 
 FakePositionSource::FakePositionSource(const QGeoCoordinate& reference, QObject* object)
 : QGeoPositionInfoSource(object)
@@ -69,7 +178,7 @@ QGeoPositionInfo FakePositionSource::lastKnownPosition(bool /*fromSatellitePosit
 
 int FakePositionSource::minimumUpdateInterval() const
 {
-	return 500;
+	return replay_track.empty() ? 500 : 20;
 }
 
 QGeoPositionInfoSource::PositioningMethods FakePositionSource::supportedPositioningMethods() const
@@ -80,6 +189,15 @@ QGeoPositionInfoSource::PositioningMethods FakePositionSource::supportedPosition
 void FakePositionSource::requestUpdate(int /*timeout*/)
 {
 	const auto now = QDateTime::currentDateTime();
+	if (!replay_track.empty())
+	{
+		info = replay_track[replay_next];
+		info.setTimestamp(now);
+		replay_next = (replay_next + 1) % replay_track.size();
+		emit positionUpdated(info);
+		return;
+	}
+	
 	const auto offset = now.time().msecsSinceStartOfDay() / qreal(20000);
 	const auto position = QGeoCoordinate {
 	                      reference.latitude() + 0.001 * qSin(offset),
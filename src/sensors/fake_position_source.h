@@ -21,12 +21,16 @@
 #ifndef OPENORIENTEERING_FAKE_POSITION_SOURCE_H
 #define OPENORIENTEERING_FAKE_POSITION_SOURCE_H
 
+#include <cstddef>
+#include <vector>
+
 #include <QGeoCoordinate>
 #include <QGeoPositionInfo>
 #include <QGeoPositionInfoSource>
 #include <QObject>
 #include <QString>
 
+class QIODevice;
 class QTimerEvent;
 
 namespace OpenOrienteering
@@ -38,6 +42,12 @@ namespace OpenOrienteering
  * 
  * This is a development tool providing fake positions near an initial
  * reference point.
+ * 
+ * Alternatively, the source replays a recorded track which is set via
+ * setReplayTrack(). The replayed positions are stamped with the current
+ * time, and the track is repeated when its end is reached. In replay mode,
+ * update intervals down to 20 ms (50 Hz) are supported, for load testing
+ * the processing of positions.
  */
 class FakePositionSource : public QGeoPositionInfoSource
 {
@@ -50,6 +60,28 @@ public:
 	 */
 	static void setReferencePoint(const QGeoCoordinate& reference);
 	
+	/**
+	 * Sets a track to be replayed by objects constructed afterwards.
+	 * 
+	 * An empty track restores the simulated positions.
+	 */
+	static void setReplayTrack(std::vector<QGeoPositionInfo> track);
+	
+	/**
+	 * Reads the track points of a GPX file.
+	 * 
+	 * Returns an empty vector on error.
+	 */
+	static std::vector<QGeoPositionInfo> readGpx(QIODevice& device);
+	
+	/**
+	 * Reads the positions from a log of NMEA sentences.
+	 * 
+	 * Consecutive sentences for the same time are merged into one position.
+	 */
+	static std::vector<QGeoPositionInfo> readNmea(QIODevice& device);
+	
+
 	~FakePositionSource() override;
 	FakePositionSource(QObject* object);
 	FakePositionSource(const QGeoCoordinate& reference, QObject* object);
@@ -73,7 +105,10 @@ protected:
 	
 private:
 	static QGeoCoordinate initial_reference;
+	static std::vector<QGeoPositionInfo> initial_replay_track;
 	QGeoCoordinate reference;
+	std::vector<QGeoPositionInfo> replay_track;
+	std::size_t replay_next = 0;
 	QGeoPositionInfo info;
 	int timer_id = 0;
 };
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2014-2020 Kai Pastor
+ *    Copyright 2014-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -47,8 +47,10 @@ Q_DECLARE_METATYPE(QGeoPositionInfo)  // QTBUG-65937
 #include <QPen>
 #include <QPoint>
 #include <QPointF>
+#include <QRectF>
 #include <QTimer>  // IWYU pragma: keep
 #include <QTimerEvent>
+#include <QTransform>
 
 #include "settings.h"
 #include "core/georeferencing.h"
@@ -58,6 +60,7 @@ Q_DECLARE_METATYPE(QGeoPositionInfo)  // QTBUG-65937
 #include "gui/map/map_widget.h"
 #include "sensors/compass.h"
 #include "util/backports.h"  // IWYU pragma: keep
+#include "util/util.h"
 
 #if defined(MAPPER_USE_FAKE_POSITION_PLUGIN)
 #include "sensors/fake_position_source.h"
@@ -70,6 +73,12 @@ namespace {
 // Opacities as understood by QPainter::setOpacity().
 static qreal opacity_curve[] = { 0.8, 1.0, 0.8, 0.5, 0.2, 0.0, 0.2, 0.5 };
 
+constexpr int num_distance_rings = 2;
+constexpr int distance_ring_radius_meters = 10;
+
+// The length of the heading line, in mm. Very long.
+constexpr qreal heading_line_length = 500;
+
 }  // namespace
 
 
@@ -239,6 +248,7 @@ void GPSDisplay::enableHeadingIndicator(bool enable)
 
 void GPSDisplay::paint(QPainter* painter)
 {
+	painted_rect = {};
 	if (!visible || !has_valid_position)
 		return;
 	
@@ -248,6 +258,8 @@ void GPSDisplay::paint(QPainter* painter)
 	if (!ok)
 		return;
 	QPointF gps_pos = widget->mapToViewport(gps_coord);
+	const auto heading_rotation_deg = heading_indicator_enabled ? headingRotation() : 0;
+	painted_rect = markerExtent(gps_pos, heading_rotation_deg).toAlignedRect();
 	
 	const auto one_mm = Util::mmToPixelLogical(1);
 	const auto mmToPixelLogical = [one_mm](qreal mm) { return mm * one_mm; };
@@ -264,11 +276,6 @@ void GPSDisplay::paint(QPainter* painter)
 	// Draw center dot or arrow
 	if (heading_indicator_enabled)
 	{
-		// For heading indicator, get azimuth from compass and calculate
-		// the relative rotation to map view rotation, clockwise.
-		const auto heading_rotation_deg = qreal(Compass::getInstance().getCurrentAzimuth())
-		                                  + qRadiansToDegrees(widget->getMapView()->getRotation());
-		
 		painter->save();
 		painter->translate(gps_pos);
 		painter->rotate(heading_rotation_deg);
@@ -288,7 +295,7 @@ void GPSDisplay::paint(QPainter* painter)
 		// Draw heading line
 		painter->setPen(QPen(Qt::gray, 0.2));
 		painter->setBrush(Qt::NoBrush);
-		painter->drawLine(QPointF(0, 0), QPointF(0, -500)); // very long
+		painter->drawLine(QPointF(0, 0), QPointF(0, -heading_line_length));
 		
 		painter->restore();
 	}
@@ -318,8 +325,6 @@ void GPSDisplay::paint(QPainter* painter)
 	// Draw distance circles
 	if (distance_rings_enabled)
 	{
-		const auto num_distance_rings = 2;
-		const auto distance_ring_radius_meters = 10;
 		const auto distance_ring_radius_pixels = distance_ring_radius_meters * meters_to_pixels;
 		painter->setPen(QPen(Qt::gray, mmToPixelLogical(0.1)));
 		painter->setBrush(Qt::NoBrush);
@@ -466,10 +471,53 @@ MapCoordF GPSDisplay::calcLatestGPSCoord(bool& ok)
 	return latest_gps_coord;
 }
 
+qreal GPSDisplay::headingRotation() const
+{
+	// Get azimuth from compass and calculate the relative rotation to map
+	// view rotation, clockwise.
+	return qreal(Compass::getInstance().getCurrentAzimuth())
+	       + qRadiansToDegrees(widget->getMapView()->getRotation());
+}
+
+QRectF GPSDisplay::markerExtent(const QPointF& gps_pos, qreal heading_rotation_deg) const
+{
+	const auto one_mm = Util::mmToPixelLogical(1);
+	
+	// Arrow or crosshairs, including the framing pen
+	auto radius = (heading_indicator_enabled ? 2.6 : 10.5) * one_mm;
+	
+	auto meters_to_pixels = widget->getMapView()->lengthToPixel(qreal(1000000) / georeferencing.getScaleDenominator());
+	if (distance_rings_enabled)
+		radius = std::max(radius, num_distance_rings * distance_ring_radius_meters * meters_to_pixels + 0.05 * one_mm);
+	if (latest_gps_coord_accuracy >= 0)
+		radius = std::max(radius, qreal(latest_gps_coord_accuracy) * meters_to_pixels + 0.5 * one_mm);
+	
+	QRectF extent { gps_pos - QPointF(radius, radius), gps_pos + QPointF(radius, radius) };
+	if (heading_indicator_enabled)
+	{
+		QTransform rotation;
+		rotation.rotate(heading_rotation_deg);
+		rectInclude(extent, gps_pos + rotation.map(QPointF(0, -heading_line_length * one_mm)));
+	}
+	// Antialiasing
+	return extent.adjusted(-2, -2, 2, 2);
+}
+
 void GPSDisplay::updateMapWidget()
 {
-	// TODO: Limit update region to union of old and new bounding rect
-	widget->update();
+	auto rect = painted_rect;
+	bool ok = false;
+	if (visible && has_valid_position)
+	{
+		auto const gps_pos = widget->mapToViewport(calcLatestGPSCoord(ok));
+		if (ok)
+		{
+			auto const heading_rotation_deg = heading_indicator_enabled ? headingRotation() : 0;
+			rect |= markerExtent(gps_pos, heading_rotation_deg).toAlignedRect();
+		}
+	}
+	if (rect.isValid())
+		widget->update(rect);
 }
 
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2016, 2018 Kai Pastor
+ *    Copyright 2016, 2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,6 +24,7 @@
 
 #include <QtGlobal>
 #include <QObject>
+#include <QRect>
 #include <QString>
 
 #include "core/map_coord.h"
@@ -31,6 +32,8 @@
 class QGeoPositionInfo;
 class QGeoPositionInfoSource;
 class QPainter;
+class QPointF;
+class QRectF;
 class QTimerEvent;
 
 namespace OpenOrienteering {
@@ -125,6 +128,14 @@ private slots:
 	
 private:
 	MapCoordF calcLatestGPSCoord(bool& ok);
+	
+	/// Returns the heading indicator's rotation relative to the map view, clockwise.
+	qreal headingRotation() const;
+	
+	/// Returns the viewport area covered by the marker at the given position.
+	QRectF markerExtent(const QPointF& gps_pos, qreal heading_rotation_deg) const;
+	
+	/// Updates the map widget where the marker was painted, and where it will be painted.
 	void updateMapWidget();
 	
 	/**
@@ -162,6 +173,7 @@ private:
 	QGeoPositionInfoSource* source = nullptr;
 	MapCoordF latest_gps_coord;
 	float latest_gps_coord_accuracy = 0;
+	QRect painted_rect;  ///< The viewport area of the last marker painted.
 	PulsatingOpacity pulsating_opacity;
 	int blink_count = 0;
 	bool tracking_lost             = false;
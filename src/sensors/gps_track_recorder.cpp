@@ -1,5 +1,6 @@
 /*
  *    Copyright 2014 Thomas Schöps
+ *    Copyright 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -46,6 +47,7 @@ GPSTrackRecorder::GPSTrackRecorder(GPSDisplay* gps_display, TemplateTrack* targe
 	
 	// Start with a new segment
 	target_template->getTrack().finishCurrentSegment();
+	first_new_point = target_template->getTrack().segmentPoints().size();
 	
 	connect(gps_display, &GPSDisplay::latLonUpdated, this, &GPSTrackRecorder::newPosition);
 	connect(gps_display, &GPSDisplay::positionUpdatesInterrupted, this, &GPSTrackRecorder::positionUpdatesInterrupted);
@@ -100,9 +102,11 @@ void GPSTrackRecorder::drawUpdate()
 	
 	if (track_changed_since_last_update)
 	{
+		// Only the points added since the last update need to be drawn.
 		if (widget->getMapView()->isTemplateVisible(target_template))
-			target_template->setTemplateAreaDirty();
+			target_template->setTrackAreaDirty(first_new_point);
 		
+		first_new_point = target_template->getTrack().segmentPoints().size();
 		track_changed_since_last_update = false;
 	}
 }
@@ -1,5 +1,6 @@
 /*
  *    Copyright 2014 Thomas Schöps
+ *    Copyright 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +22,8 @@
 #ifndef OPENORIENTEERING_GPS_TRACK_RECORDER_H
 #define OPENORIENTEERING_GPS_TRACK_RECORDER_H
 
+#include <cstddef>
+
 #include <QObject>
 #include <QString>
 #include <QTimer>
@@ -52,6 +55,7 @@ private:
 	MapWidget* widget;
 	QTimer draw_update_timer;
 	bool track_changed_since_last_update;
+	std::size_t first_new_point = 0;
 	bool is_active;
 };
 
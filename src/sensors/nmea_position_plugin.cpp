@@ -1,5 +1,5 @@
 /*
- *    Copyright 2020 Kai Pastor
+ *    Copyright 2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -19,14 +19,23 @@
 
 #include "nmea_position_plugin.h"
 
+#include <cmath>
+
+#include <Qt>
 #include <QtGlobal>
+#include <QtNumeric>
 #include <QByteArray>
+#include <QDate>
+#include <QDateTime>
 #include <QFileInfo>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
 #include <QGeoPositionInfoSource>
 #include <QLatin1Char>
 #include <QList>
 #include <QNmeaPositionInfoSource>
 #include <QProcess>
+#include <QTime>
 
 #ifdef QT_SERIALPORT_LIB
 #  include <QSerialPortInfo>
@@ -36,6 +45,210 @@
 namespace OpenOrienteering
 {
 
+namespace {
+
+/**
+ * A field of an NMEA sentence, referring to the sentence data.
+ */
+struct NmeaField
+{
+	const char* begin;
+	const char* end;
+	
+	bool isEmpty() const noexcept { return begin == end; }
+	int size() const noexcept { return int(end - begin); }
+};
+
+/**
+ * Splits an NMEA sentence into fields, without copying.
+ * 
+ * Fields beyond the end of the sentence are empty.
+ */
+class NmeaFields
+{
+public:
+	NmeaFields(const char* begin, const char* end) noexcept
+	: pos(begin)
+	, end(end)
+	{}
+	
+	NmeaField next() noexcept
+	{
+		auto const field_begin = pos;
+		while (pos != end && *pos != ',')
+			++pos;
+		auto const field = NmeaField { field_begin, pos };
+		if (pos != end)
+			++pos;
+		return field;
+	}
+	
+	void skip(int count) noexcept
+	{
+		for (; count > 0; --count)
+			next();
+	}
+	
+private:
+	const char* pos;
+	const char* end;
+};
+
+bool isDigit(char c) noexcept
+{
+	return c >= '0' && c <= '9';
+}
+
+int hexValue(char c) noexcept
+{
+	if (isDigit(c))
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/**
+ * Returns the end of the sentence's data, i.e. the position of the checksum's
+ * asterisk, or nullptr if the checksum is missing or wrong.
+ */
+const char* verifiedEnd(const char* data, int size) noexcept
+{
+	auto const end = data + size;
+	auto checksum = 0;
+	auto pos = data + 1;  // after '$'
+	for (; pos != end && *pos != '*'; ++pos)
+		checksum ^= *pos;
+	if (end - pos < 3)
+		return nullptr;
+	auto const high = hexValue(pos[1]);
+	auto const low = hexValue(pos[2]);
+	if (high < 0 || low < 0 || checksum != high * 16 + low)
+		return nullptr;
+	return pos;
+}
+
+bool toInt(const NmeaField& field, int& value) noexcept
+{
+	if (field.isEmpty())
+		return false;
+	value = 0;
+	for (auto pos = field.begin; pos != field.end; ++pos)
+	{
+		if (!isDigit(*pos))
+			return false;
+		value = value * 10 + (*pos - '0');
+	}
+	return true;
+}
+
+bool toDouble(const NmeaField& field, double& value) noexcept
+{
+	auto pos = field.begin;
+	auto const negative = pos != field.end && *pos == '-';
+	if (negative)
+		++pos;
+	if (pos == field.end)
+		return false;
+	
+	value = 0;
+	for (; pos != field.end && isDigit(*pos); ++pos)
+		value = value * 10 + (*pos - '0');
+	if (pos != field.end)
+	{
+		if (*pos != '.')
+			return false;
+		auto scale = 1.0;
+		for (++pos; pos != field.end; ++pos)
+		{
+			if (!isDigit(*pos))
+				return false;
+			scale /= 10;
+			value += (*pos - '0') * scale;
+		}
+	}
+	if (negative)
+		value = -value;
+	return true;
+}
+
+/**
+ * Parses a time of the form hhmmss[.sss].
+ */
+bool toTime(const NmeaField& field, QTime& time)
+{
+	int h, m, s;
+	if (field.size() < 6
+	    || !toInt({field.begin, field.begin + 2}, h)
+	    || !toInt({field.begin + 2, field.begin + 4}, m)
+	    || !toInt({field.begin + 4, field.begin + 6}, s))
+		return false;
+	
+	auto ms = 0;
+	if (field.size() > 6)
+	{
+		auto fraction = 0.0;
+		if (!toDouble({field.begin + 6, field.end}, fraction) || field.begin[6] != '.')
+			return false;
+		ms = qRound(fraction * 1000);
+	}
+	time = QTime(h, m, s, qMin(ms, 999));
+	return time.isValid();
+}
+
+/**
+ * Parses a date of the form ddmmyy.
+ */
+bool toDate(const NmeaField& field, QDate& date)
+{
+	int d, m, y;
+	if (field.size() != 6
+	    || !toInt({field.begin, field.begin + 2}, d)
+	    || !toInt({field.begin + 2, field.begin + 4}, m)
+	    || !toInt({field.begin + 4, field.begin + 6}, y))
+		return false;
+	
+	date = QDate(2000 + y, m, d);
+	return date.isValid();
+}
+
+/**
+ * Parses an angle of the form [d]ddmm.mmmm and a hemisphere indicator.
+ */
+bool toDegrees(const NmeaField& field, const NmeaField& hemisphere, char negative, double& value) noexcept
+{
+	if (hemisphere.size() != 1 || !toDouble(field, value) || value < 0)
+		return false;
+	auto const degrees = std::floor(value / 100);
+	value = degrees + (value - 100 * degrees) / 60;
+	if (*hemisphere.begin == negative)
+		value = -value;
+	return true;
+}
+
+bool toCoordinate(NmeaFields& fields, QGeoCoordinate& coord)
+{
+	auto const lat_field = fields.next();
+	auto const lat_hemisphere = fields.next();
+	auto const lon_field = fields.next();
+	auto const lon_hemisphere = fields.next();
+	double lat, lon;
+	if (!toDegrees(lat_field, lat_hemisphere, 'S', lat)
+	    || !toDegrees(lon_field, lon_hemisphere, 'W', lon)
+	    || qAbs(lat) > 90 || qAbs(lon) > 180)
+		return false;
+	
+	coord.setLatitude(lat);
+	coord.setLongitude(lon);
+	return true;
+}
+
+}  // namespace
+
+
+
 /**
  * A position info source which reads NMEA from an arbitrary file or device.
  * 
@@ -145,6 +358,111 @@ public:
 	using QGeoPositionInfoSource::error;  // the signal
 
 protected:
+	/**
+	 * Parses GGA and RMC sentences in place, falling back to the base class
+	 * for other sentences.
+	 * 
+	 * GGA and RMC sentences carry the position. They arrive with every fix,
+	 * i.e. up to 20 times per second for some receivers, so they are parsed
+	 * without splitting them into temporary byte arrays.
+	 */
+	bool parsePosInfoFromNmeaData(const char* data, int size, QGeoPositionInfo* posInfo, bool* hasFix) override
+	{
+		if (size < 6 || data[0] != '$')
+			return false;
+		
+		auto const type = data + 3;
+		if (type[0] == 'G' && type[1] == 'G' && type[2] == 'A')
+		{
+			if (auto const end = verifiedEnd(data, size))
+			{
+				auto fields = NmeaFields(data, end);
+				parseGga(fields, posInfo, hasFix);
+				return true;
+			}
+			return false;
+		}
+		if (type[0] == 'R' && type[1] == 'M' && type[2] == 'C')
+		{
+			if (auto const end = verifiedEnd(data, size))
+			{
+				auto fields = NmeaFields(data, end);
+				parseRmc(fields, posInfo, hasFix);
+				return true;
+			}
+			return false;
+		}
+		return QNmeaPositionInfoSource::parsePosInfoFromNmeaData(data, size, posInfo, hasFix);
+	}
+	
+	/**
+	 * Parses a GGA sentence (time, position, fix quality, HDOP, altitude).
+	 */
+	void parseGga(NmeaFields& fields, QGeoPositionInfo* posInfo, bool* hasFix) const
+	{
+		fields.skip(1);
+		
+		QTime time;
+		if (toTime(fields.next(), time))
+			posInfo->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
+		
+		QGeoCoordinate coord;
+		auto const has_position = toCoordinate(fields, coord);
+		
+		int quality;
+		if (hasFix && toInt(fields.next(), quality))
+			*hasFix = quality > 0;
+		
+		fields.skip(1);  // number of satellites
+		double hdop;
+		auto const uere = userEquivalentRangeError();
+		if (toDouble(fields.next(), hdop) && qIsFinite(uere))
+			posInfo->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
+		
+		double altitude;
+		if (has_position && toDouble(fields.next(), altitude))
+			coord.setAltitude(altitude);
+		if (has_position)
+			posInfo->setCoordinate(coord);
+	}
+	
+	/**
+	 * Parses an RMC sentence (time, status, position, speed, course, date).
+	 */
+	void parseRmc(NmeaFields& fields, QGeoPositionInfo* posInfo, bool* hasFix) const
+	{
+		fields.skip(1);
+		
+		QTime time;
+		toTime(fields.next(), time);
+		
+		auto const status = fields.next();
+		if (hasFix && status.size() == 1)
+			*hasFix = *status.begin == 'A';
+		
+		QGeoCoordinate coord;
+		if (toCoordinate(fields, coord))
+			posInfo->setCoordinate(coord);
+		
+		double value;
+		if (toDouble(fields.next(), value))
+			posInfo->setAttribute(QGeoPositionInfo::GroundSpeed, value * 1.852 / 3.6);  // knots
+		if (toDouble(fields.next(), value))
+			posInfo->setAttribute(QGeoPositionInfo::Direction, value);
+		
+		QDate date;
+		toDate(fields.next(), date);
+		
+		auto const variation = fields.next();
+		auto const variation_direction = fields.next();
+		if (toDouble(variation, value) && variation_direction.size() == 1)
+			posInfo->setAttribute(QGeoPositionInfo::MagneticVariation, *variation_direction.begin == 'W' ? -value : value);
+		
+		if (time.isValid())
+			posInfo->setTimestamp(QDateTime(date, time, Qt::UTC));
+	}
+	
+
 	/**
 	 * Sets the error and emits the error signal (unless NoError).
 	 */
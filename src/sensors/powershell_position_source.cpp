@@ -101,6 +101,13 @@ public:
 };
 
 
+/// The command which restarts updates after the main script was run.
+const char* const resume_command = "Start-Watcher\r\n";
+
+/// The command which terminates the Powershell process.
+const char* const exit_command = "Exit 0\r\n";
+
+
 /**
  * Returns the main Powershell script.
  */
@@ -125,7 +132,7 @@ QGeoPositionInfoSource::Error defaultSetup(QProcess& process, QByteArray& start_
 	if (start_script.isEmpty())
 		return QGeoPositionInfoSource::UnknownSourceError;
 	
-	stop_script = QByteArrayLiteral("Exit 0 \r\n");
+	stop_script = QByteArrayLiteral("Stop-Watcher\r\n");
 	
 	auto const powershell_path = QStandardPaths::findExecutable(QStringLiteral("powershell.exe"));
 	if (powershell_path.isEmpty())
@@ -167,6 +174,11 @@ PowershellPositionSource::PowershellPositionSource(SetupFunction& setup, QObject
 PowershellPositionSource::~PowershellPositionSource()
 {
 	powershell.disconnect(this);
+	if (powershell.state() == QProcess::Running)
+	{
+		powershell.write(exit_command);
+		powershell.waitForFinished(100);
+	}
 	if (powershell.state() != QProcess::NotRunning)
 		powershell.kill();
 	powershell.waitForFinished(100);
@@ -191,7 +203,7 @@ void PowershellPositionSource::setError(QGeoPositionInfoSource::Error value)
 	case AccessError:
 		emit this->QGeoPositionInfoSource::error(value);
 		// Exit gracefully
-		powershell.write(stop_script);
+		powershell.write(exit_command);
 		break;
 	default:
 		emit this->QGeoPositionInfoSource::error(value);
@@ -241,7 +253,7 @@ void PowershellPositionSource::stopUpdates()
 	
 	updates_ongoing = false;
 	periodic_update_timer.stop();
-	// Exit gracefully
+	// Keep the process for the next session.
 	powershell.write(stop_script);
 }
 
@@ -268,6 +280,10 @@ void PowershellPositionSource::requestUpdate(int timeout)
 
 bool PowershellPositionSource::startPowershell()
 {
+	// A process which is still running from an earlier session has run the
+	// main script already. It only needs to start the watcher again.
+	if (powershell.state() == QProcess::Running)
+		powershell.write(resume_command);
 	if (powershell.state() != QProcess::NotRunning)
 		return true;
 	
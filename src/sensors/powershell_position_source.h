@@ -34,6 +34,10 @@ namespace OpenOrienteering
 /**
  * A Windows position source based on Powershell's access to Windows.Device.Location.
  * 
+ * Starting Powershell and loading the assembly takes seconds. So the process
+ * is kept running when updates are stopped, and the next start only resumes
+ * the watcher. On start, the watcher's known position is reported at once.
+ * 
  * @see QGeoPositionInfoSourceWinRT
  */
 class PowershellPositionSource : public QGeoPositionInfoSource
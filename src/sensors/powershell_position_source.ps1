@@ -28,9 +28,10 @@ $statusChangedAction = {
 }
 Register-ObjectEvent -InputObject $watcher -EventName StatusChanged -Action $statusChangedAction | Out-Null
 
-$positionChangedAction = {
-	$time_ = $EventArgs.Position.Timestamp.UtcDateTime
-	$loc_ = $EventArgs.Position.Location
+# Positions are written in the format expected by PowershellPositionSource.
+function global:Write-Position($position_) {
+	$time_ = $position_.Timestamp.UtcDateTime
+	$loc_ = $position_.Location
 	$lat_ = $loc_.Latitude
 	$lon_ = $loc_.Longitude
 	$alt_ = $loc_.Altitude
@@ -40,11 +41,32 @@ $positionChangedAction = {
 	$line_ = "Position;{0:u};$lat_;$lon_;$alt_;$hac_;$vac_" -f ($time_)
     $line_ | Write-Host
 }
+
+$positionChangedAction = {
+	Write-Position $EventArgs.Position
+}
 Register-ObjectEvent -InputObject $watcher -EventName PositionChanged -Action $positionChangedAction | Out-Null
 
+# Start and stop commands
+#
+# The process is kept when updates are stopped, so that restarting
+# does not need to load Powershell and the assembly again.
+
+function global:Start-Watcher {
+	$watcher.Start()
+	# Report a known position immediately, instead of waiting for the next event.
+	if (-not $watcher.Position.Location.IsUnknown) {
+		Write-Position $watcher.Position
+	}
+}
+
+function global:Stop-Watcher {
+	$watcher.Stop()
+}
+
 # Start
 
-$watcher.start()
+Start-Watcher
 
 # Output permission status
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -109,6 +109,9 @@ Settings::Settings()
 	float map_editor_click_tolerance_default;
 	float map_editor_snap_distance_default;
 	int start_drag_distance_default;
+	int template_memory_budget_default;  // MiB
+	int undo_memory_budget_default;  // MiB
+	bool low_memory_display_default;
 	
 	// Platform-specific settings defaults
 #if defined(ANDROID) || !defined(QT_WIDGETS_LIB)
@@ -116,11 +119,17 @@ Settings::Settings()
 	map_editor_click_tolerance_default = 4.0f;
 	map_editor_snap_distance_default = 15.0f;
 	start_drag_distance_default = Util::mmToPixelLogical(3.0f);
+	template_memory_budget_default = 384;
+	undo_memory_budget_default = 64;
+	low_memory_display_default = true;
 #else
 	symbol_widget_icon_size_mm_default = 8;
 	map_editor_click_tolerance_default = 3.0f;
 	map_editor_snap_distance_default = 10.0f;
 	start_drag_distance_default = QApplication::startDragDistance();
+	template_memory_budget_default = 4096;
+	undo_memory_budget_default = 512;
+	low_memory_display_default = false;
 #endif
 	
 	qreal ppi = QGuiApplication::primaryScreen()->physicalDotsPerInch();
@@ -129,6 +138,7 @@ Settings::Settings()
 		ppi = QGuiApplication::primaryScreen()->logicalDotsPerInch();
 	
 	registerSetting(MapDisplay_TextAntialiasing, "MapDisplay/text_antialiasing", false);
+	registerSetting(MapDisplay_LowMemory, "MapDisplay/low_memory", low_memory_display_default);
 	registerSetting(MapEditor_ClickToleranceMM, "MapEditor/click_tolerance_mm", map_editor_click_tolerance_default);
 	registerSetting(MapEditor_SnapDistanceMM, "MapEditor/snap_distance_mm", map_editor_snap_distance_default);
 	registerSetting(MapEditor_FixedAngleStepping, "MapEditor/fixed_angle_stepping", 15);
@@ -136,6 +146,7 @@ Settings::Settings()
 	registerSetting(MapEditor_ZoomOutAwayFromCursor, "MapEditor/zoom_out_away_from_cursor", true);
 	registerSetting(MapEditor_DrawLastPointOnRightClick, "MapEditor/draw_last_point_on_right_click", true);
 	registerSetting(MapEditor_IgnoreTouchInput, "MapEditor/ignore_touch_input", false);
+	registerSetting(MapEditor_UndoMemoryBudgetMB, "MapEditor/undo_memory_budget_mb", undo_memory_budget_default);  // 0: unlimited
 	registerSetting(MapGeoreferencing_ControlScaleFactor, "MapGeoreferencing/control_scale_factor", false);
 	
 	registerSetting(EditTool_DeleteBezierPointAction, "EditTool/delete_bezier_point_action", int(DeleteBezierPoint_RetainExistingShape));
@@ -145,6 +156,7 @@ Settings::Settings()
 	registerSetting(RectangleTool_PreviewLineWidth, "RectangleTool/preview_line_with", true);
 	
 	registerSetting(Templates_KeepSettingsOfClosed, "Templates/keep_settings_of_closed_templates", true);
+	registerSetting(Templates_MemoryBudgetMB, "Templates/memory_budget_mb", template_memory_budget_default);  // 0: unlimited
 	
 	registerSetting(ActionGridBar_ButtonSizeMM, "ActionGridBar/button_size_mm", touch_button_minimum_size_default);
 	registerSetting(SymbolWidget_IconSizeMM, "SymbolWidget/icon_size_mm", symbol_widget_icon_size_mm_default);
@@ -153,6 +165,8 @@ Settings::Settings()
 	registerSetting(General_RetainCompatiblity, "retainCompatiblity", false);
 	registerSetting(General_SaveUndoRedo, "saveUndoRedo", true);
 	registerSetting(General_AutosaveInterval, "autosave", 15); // unit: minutes
+	registerSetting(General_SaveJournal, "saveJournal", false);
+	registerSetting(General_CompressionLevel, "compressionLevel", 0);
 	registerSetting(General_Language, "language", QLocale::system().name().left(2));
 	registerSetting(General_PixelsPerInch, "pixelsPerInch", ppi);
 	registerSetting(General_TranslationFile, "translationFile", QVariant(QString{}));
@@ -160,6 +174,7 @@ Settings::Settings()
 	registerSetting(General_OpenMRUFile, "openMRUFile", false);
 	registerSetting(General_Local8BitEncoding, "local_8bit_encoding", QLatin1String("Default"));
 	registerSetting(General_StartDragDistance, "startDragDistance", start_drag_distance_default);
+	registerSetting(General_RecordTrace, "recordTrace", false);
 	
 	registerSetting(HomeScreen_TipsVisible, "HomeScreen/tipsVisible", true);
 	registerSetting(HomeScreen_CurrentTip, "HomeScreen/currentTip", -1);
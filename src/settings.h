@@ -48,6 +48,7 @@ public:
 	{
 		MapDisplay_Antialiasing = 0,
 		MapDisplay_TextAntialiasing,
+		MapDisplay_LowMemory,
 		MapEditor_ClickToleranceMM,
 		MapEditor_SnapDistanceMM,
 		MapEditor_FixedAngleStepping,
@@ -55,18 +56,22 @@ public:
 		MapEditor_ZoomOutAwayFromCursor,
 		MapEditor_DrawLastPointOnRightClick,
 		MapEditor_IgnoreTouchInput,
+		MapEditor_UndoMemoryBudgetMB,
 		MapGeoreferencing_ControlScaleFactor,
 		EditTool_DeleteBezierPointAction,
 		EditTool_DeleteBezierPointActionAlternative,
 		RectangleTool_HelperCrossRadiusMM,
 		RectangleTool_PreviewLineWidth,
 		Templates_KeepSettingsOfClosed,
+		Templates_MemoryBudgetMB,
 		SymbolWidget_IconSizeMM,
 		SymbolWidget_ShowCustomIcons,
 		ActionGridBar_ButtonSizeMM,
 		General_RetainCompatiblity,
 		General_SaveUndoRedo,
 		General_AutosaveInterval,
+		General_SaveJournal,
+		General_CompressionLevel,
 		General_Language,
 		General_PixelsPerInch,
 		General_RecentFilesList,
@@ -74,6 +79,7 @@ public:
 		General_OpenMRUFile,
 		General_Local8BitEncoding,
 		General_StartDragDistance,
+		General_RecordTrace,
 		HomeScreen_TipsVisible,
 		HomeScreen_CurrentTip,
 		PaintOnTemplateTool_Colors,
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -41,6 +41,7 @@
 #include <QLatin1Char>
 #include <QLatin1String>
 #include <QMessageBox>
+#include <QMetaObject>
 #include <QPainter>
 #include <QRectF>
 #include <QSizeF>
@@ -58,17 +59,22 @@
 #include "gdal/gdal_template.h"
 #include "gdal/ogr_template.h"
 #include "gui/file_dialog.h"
+#include "templates/template_file_lookup.h"
 #include "templates/template_image.h"
 #include "templates/template_map.h"
 #include "templates/template_placeholder.h"
+#include "templates/template_tile_service.h"
 #include "templates/template_track.h"
 #include "util/backports.h"  // IWYU pragma: keep
+#include "util/parallel.h"
+#include "util/trace.h"
 #include "util/util.h"
 #include "util/xml_stream_util.h"
 
 
 namespace OpenOrienteering {
 
+
 class Template::ScopedOffsetReversal
 {
 public:
@@ -254,6 +260,8 @@ Template::Template(const Template& proto)
 , adjustment_dirty(proto.adjustment_dirty)
 , passpoints(proto.passpoints)
 , template_group(proto.template_group)
+, min_zoom(proto.min_zoom)
+, max_zoom(proto.max_zoom)
 , map_to_template(proto.map_to_template)
 , template_to_map(proto.template_to_map)
 , template_to_map_other(proto.template_to_map_other)
@@ -264,6 +272,9 @@ Template::Template(const Template& proto)
 Template::~Template()
 {
 	Q_ASSERT(template_state != Loaded);
+	// The worker may still post to this object.
+	if (async_read.valid())
+		async_read.wait();
 }
 
 QString Template::errorString() const
@@ -296,6 +307,11 @@ void Template::saveTemplateConfiguration(QXmlStreamWriter& xml, bool open, const
 		xml.writeAttribute(QString::fromLatin1("group"), QString::number(template_group));
 	}
 	
+	if (min_zoom > 0)
+		xml.writeAttribute(QString::fromLatin1("min_zoom"), QString::number(min_zoom));
+	if (max_zoom > 0)
+		xml.writeAttribute(QString::fromLatin1("max_zoom"), QString::number(max_zoom));
+	
 	if (is_georeferenced)
 	{
 		xml.writeAttribute(QString::fromLatin1("georef"), QString::fromLatin1("true"));
@@ -352,6 +368,8 @@ std::unique_ptr<Template> Template::loadTemplateConfiguration(QXmlStreamReader&
 	temp->is_georeferenced = (attributes.value(QLatin1String("georef")) == QLatin1String("true"));
 	if (attributes.hasAttribute(QLatin1String("group")))
 		temp->template_group = attributes.value(QLatin1String("group")).toInt();
+	temp->setZoomRange(attributes.value(QLatin1String("min_zoom")).toDouble(),
+	                   attributes.value(QLatin1String("max_zoom")).toDouble());
 		
 	while (xml.readNextStartElement())
 	{
@@ -598,12 +616,19 @@ Template::LookupResult Template::tryToFindTemplateFile(const QString& map_path)
 		return {};
 	};
 	
+	// Probing a candidate, possibly from cached directory listings
+	auto const is_file = [](const QFileInfo& path_info) -> bool {
+		if (auto* lookup = TemplateFileLookup::current())
+			return lookup->isFile(path_info.absoluteFilePath());
+		return path_info.isFile();
+	};
+	
 	// 1. The relative path with regard to the map directory, if both are valid
 	auto const rel_path = getTemplateRelativePath();
 	if (!rel_path.isEmpty() && !map_path.isEmpty())
 	{
 		auto const abs_path_info = QFileInfo(dir(map_path).absoluteFilePath(rel_path));
-		if (abs_path_info.isFile())
+		if (is_file(abs_path_info))
 		{
 			setTemplateFileInfo(abs_path_info);
 			set_state(Unloaded);
@@ -613,7 +638,7 @@ Template::LookupResult Template::tryToFindTemplateFile(const QString& map_path)
 	
 	// 2. The absolute path of the template
 	auto const template_path_info = QFileInfo(getTemplatePath());
-	if (template_path_info.isFile())
+	if (is_file(template_path_info))
 	{
 		/* setTemplateFileInfo(template_path_info); */
 		set_state(Unloaded);
@@ -625,7 +650,7 @@ Template::LookupResult Template::tryToFindTemplateFile(const QString& map_path)
 	if (!filename.isEmpty() && !map_path.isEmpty())
 	{
 		auto const abs_path_info = QFileInfo(dir(map_path).absoluteFilePath(filename));
-		if (abs_path_info.isFile())
+		if (is_file(abs_path_info))
 		{
 			setTemplateFileInfo(abs_path_info);
 			set_state(Unloaded);
@@ -658,9 +683,15 @@ bool Template::preLoadSetup(QWidget* /*dialog_parent*/)
 bool Template::loadTemplateFile()
 {
 	Q_ASSERT(template_state != Loaded);
+	MAPPER_TRACE_SCOPE("Template::loadTemplateFile");
+	
+	// Data from an asynchronous reader must be complete.
+	if (async_read.valid())
+		async_read.wait();
 	
 	const State old_state = template_state;
 	
+	data_released = false;
 	setErrorString(QString());
 	try
 	{
@@ -703,6 +734,57 @@ bool Template::loadTemplateFile()
 	return template_state != Invalid;
 }
 
+void Template::loadTemplateFileAsync(std::function<void ()> finished)
+{
+	Q_ASSERT(template_state == Unloaded);
+	
+	async_finished.push_back(std::move(finished));
+	if (async_read.valid())
+		return;
+	
+	auto reader = makeFileReader();
+	if (!reader)
+	{
+		QMetaObject::invokeMethod(this, "finishLoadingAsync", Qt::QueuedConnection);
+		return;
+	}
+	
+	// The user is waiting for the template to appear.
+	auto job = [this, reader]() {
+		try
+		{
+			reader();
+		}
+		catch (...)
+		{
+			// Incomplete data is reported by loadTemplateFileImpl().
+		}
+		// Posted before the future is ready, cf. ~Template().
+		QMetaObject::invokeMethod(this, "finishLoadingAsync", Qt::QueuedConnection);
+	};
+	async_read = Util::startJob<void>(std::move(job), Util::JobPriority::Interactive).share();
+}
+
+bool Template::isLoadingAsync() const
+{
+	return async_read.valid();
+}
+
+void Template::finishLoadingAsync()
+{
+	if (template_state == Unloaded)
+		loadTemplateFile();
+	async_read = {};
+	
+	auto finished = std::move(async_finished);
+	async_finished.clear();
+	for (auto& function : finished)
+	{
+		if (function)
+			function();
+	}
+}
+
 bool Template::postLoadSetup(QWidget* /*dialog_parent*/, bool& /*out_center_in_view*/)
 {
 	return true;
@@ -718,9 +800,34 @@ void Template::unloadTemplateFile()
 	}
 	unloadTemplateFileImpl();
 	template_state = Unloaded;
+	data_released = false;
 	emit templateStateChanged();
 }
 
+bool Template::releaseTemplateData()
+{
+	if (template_state != Loaded || hasUnsavedChanges() || isLoadingAsync())
+		return false;
+	
+	released_bounding_box = calculateTemplateBoundingBox();
+	unloadTemplateFile();
+	data_released = true;
+	last_drawn = 0;
+	return true;
+}
+
+// virtual
+qint64 Template::memoryUsage() const
+{
+	return 0;
+}
+
+// virtual
+qint64 Template::undoMemoryUsage() const
+{
+	return 0;
+}
+
 
 // virtual
 bool Template::canChangeTemplateGeoreferenced() const
@@ -734,6 +841,12 @@ bool Template::trySetTemplateGeoreferenced(bool value, QWidget* /*dialog_parent*
 	return isTemplateGeoreferenced() == value;
 }
 
+// virtual
+void Template::updateGeoreferencing()
+{
+	// nothing
+}
+
 
 void Template::applyTemplateTransform(QPainter* painter) const
 {
@@ -941,6 +1054,20 @@ void Template::setAdjustmentDirty(bool value)
 		map->setTemplatesDirty();
 }
 
+void Template::setZoomRange(double min_zoom, double max_zoom)
+{
+	this->min_zoom = std::max(min_zoom, 0.0);
+	this->max_zoom = std::max(max_zoom, 0.0);
+	if (this->max_zoom > 0 && this->min_zoom > this->max_zoom)
+		std::swap(this->min_zoom, this->max_zoom);
+}
+
+bool Template::isVisibleAtZoom(double zoom) const
+{
+	return (min_zoom <= 0 || zoom >= min_zoom)
+	       && (max_zoom <= 0 || zoom <= max_zoom);
+}
+
 
 
 bool Template::hasAlpha() const
@@ -1002,7 +1129,9 @@ std::unique_ptr<Template> Template::templateForPath(const QString& path, Map* ma
 #endif
 	
 	std::unique_ptr<Template> t;
-	if (endsWithAnyOf(path, TemplateImage::supportedExtensions())
+	if (TemplateTileService::canRead(path))
+		t = std::make_unique<TemplateTileService>(path, map);
+	else if (endsWithAnyOf(path, TemplateImage::supportedExtensions())
 	    && !HANDLED_BY_GDAL(endsWithAnyOf(path, GdalTemplate::supportedExtensions())))
 		t = std::make_unique<TemplateImage>(path, map);
 	else if (endsWithAnyOf(path, TemplateMap::supportedExtensions()))
@@ -1048,6 +1177,8 @@ std::unique_ptr<Template> Template::templateForType(const QStringRef& type, cons
 		t = std::make_unique<TemplateTrack>(path, map);
 	else if (type_cstring == "TemplateTrack" && !track_with_gdal)
 		t = std::make_unique<TemplateTrack>(path, map);
+	else if (type_cstring == "TemplateTileService")
+		t = std::make_unique<TemplateTileService>(path, map);
 #ifdef MAPPER_USE_GDAL
 	else if (type_cstring == "GdalTemplate")
 		t = std::make_unique<GdalTemplate>(path, map);
@@ -1075,6 +1206,16 @@ bool Template::finishTypeSpecificTemplateConfiguration()
 	return true;
 }
 
+std::function<void ()> Template::makeFileReader()
+{
+	return {};
+}
+
+void Template::drawTemplatePreview(QPainter* /*painter*/, qreal /*opacity*/) const
+{
+	// nothing
+}
+
 
 
 void Template::drawOntoTemplateImpl(MapCoordF* /*coords*/, int /*num_coords*/, const QColor& /*color*/, qreal /*width*/, ScribbleOptions /*mode*/)
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020 Kai Pastor
+ *    Copyright 2012-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -23,6 +23,7 @@
 #define OPENORIENTEERING_TEMPLATE_H
 
 #include <functional>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -30,6 +31,7 @@
 #include <QFlags>
 #include <QObject>
 #include <QPointF>
+#include <QRectF>
 #include <QString>
 #include <QStringRef>
 
@@ -295,6 +297,9 @@ public:
 	 *     are moved to the same flat folder, e.g. when receiving them via
 	 *     individual e-mail attachments.
 	 * 
+	 * While a TemplateFileLookup exists, the candidates are checked against
+	 * its cached directory listings.
+	 * 
 	 * \param map_path  Either the full filepath of the map, or an arbitrary
 	 *                  directory which shall be regarded as the map directory.
 	 */
@@ -346,6 +351,25 @@ public:
 	 */
 	bool loadTemplateFile();
 	
+	/**
+	 * Loads the template file asynchronously.
+	 * 
+	 * If the template type supports it (cf. makeFileReader()), the file is
+	 * read on a worker thread, and loadTemplateFile() is called on this
+	 * object's thread when the data is ready. Otherwise, loadTemplateFile()
+	 * is called from the event loop. So several templates can be read in
+	 * parallel, without blocking the user interface.
+	 * 
+	 * The given function is called after loading, successful or not.
+	 * This function can be called if the template state is Unloaded.
+	 */
+	void loadTemplateFileAsync(std::function<void ()> finished);
+	
+	/**
+	 * Returns true while the template file is read on a worker thread.
+	 */
+	bool isLoadingAsync() const;
+	
 	/**
 	 * Setup event after the template is loaded for the first time.
 	 * 
@@ -369,6 +393,58 @@ public:
 	 */
 	void unloadTemplateFile();
 	
+	/**
+	 * Unloads the template file in order to free memory.
+	 * 
+	 * The data is released only if the template is loaded and if it can be
+	 * reloaded from the file without loss. The template's bounding box is
+	 * kept, so that the template can be reloaded when this area is needed
+	 * for drawing again.
+	 * 
+	 * Returns true if the data was released.
+	 */
+	bool releaseTemplateData();
+	
+	/**
+	 * Returns true if the data was released by releaseTemplateData(),
+	 * and the template was not loaded again since then.
+	 */
+	bool isTemplateDataReleased() const { return data_released; }
+	
+	/**
+	 * Returns the bounding box of the template at the time when its data
+	 * was released, in map coordinates.
+	 */
+	const QRectF& releasedBoundingBox() const { return released_bounding_box; }
+	
+	/**
+	 * Returns the approximate amount of memory which is held by the loaded
+	 * template data, in bytes.
+	 * 
+	 * This is used to keep the templates within the memory budget.
+	 * The default implementation returns 0.
+	 */
+	virtual qint64 memoryUsage() const;
+	
+	/**
+	 * Returns the approximate amount of memory which is held by the
+	 * template's own undo history, in bytes.
+	 * 
+	 * The default implementation returns 0.
+	 */
+	virtual qint64 undoMemoryUsage() const;
+	
+	/**
+	 * Returns the number of the latest on-screen drawing pass which needed
+	 * this template, as recorded by setLastDrawn().
+	 */
+	quint64 lastDrawn() const { return last_drawn; }
+	
+	/**
+	 * Records the number of an on-screen drawing pass which needed this template.
+	 */
+	void setLastDrawn(quint64 pass) const { last_drawn = pass; }
+	
 	/** 
 	 * Draws the template using the given painter with the given opacity.
 	 * 
@@ -379,6 +455,15 @@ public:
 	 */
     virtual void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const = 0;
 	
+	/**
+	 * Draws a preview of the template while it is loaded asynchronously.
+	 * 
+	 * This is called on screen for visible templates which are not loaded yet.
+	 * The painter transformation is the same as for drawTemplate().
+	 * The default implementation does nothing.
+	 */
+	virtual void drawTemplatePreview(QPainter* painter, qreal opacity) const;
+	
 	
 	/** 
 	 * Calculates the template's bounding box in map coordinates.
@@ -558,6 +643,33 @@ public:
 	inline int getTemplateGroup() const {return template_group;}
 	inline void setTemplateGroup(int value) {template_group = value;}
 	
+	/**
+	 * Returns the lowest view zoom factor at which the template is drawn
+	 * on screen, or 0 if there is no lower limit.
+	 */
+	double getMinZoom() const { return min_zoom; }
+	
+	/**
+	 * Returns the highest view zoom factor at which the template is drawn
+	 * on screen, or 0 if there is no upper limit.
+	 */
+	double getMaxZoom() const { return max_zoom; }
+	
+	/**
+	 * Sets the range of view zoom factors at which the template is drawn
+	 * on screen.
+	 * 
+	 * A value of 0 removes the respective limit. This permits to keep
+	 * templates of different resolution for the same area, and to switch
+	 * between them automatically when zooming.
+	 */
+	void setZoomRange(double min_zoom, double max_zoom);
+	
+	/**
+	 * Returns true if the given view zoom factor is within the zoom range.
+	 */
+	bool isVisibleAtZoom(double zoom) const;
+	
 	inline bool hasUnsavedChanges() const {return has_unsaved_changes;}
 	void setHasUnsavedChanges(bool value);
 	
@@ -582,6 +694,16 @@ public:
 	 */
 	virtual bool trySetTemplateGeoreferenced(bool value, QWidget* dialog_parent);
 	
+	/**
+	 * Adjusts the template to a change of the map's georeferencing.
+	 * 
+	 * Map::setGeoreferencing() calls this function once for each template,
+	 * after the new georeferencing is in place.
+	 * 
+	 * The default implementation does nothing.
+	 */
+	virtual void updateGeoreferencing();
+	
 	
 	// Transformation of non-georeferenced templates
 	
@@ -666,6 +788,13 @@ signals:
 	void templateStateChanged();
 	
 	
+private slots:
+	/**
+	 * Completes asynchronous loading, on this object's thread.
+	 */
+	void finishLoadingAsync();
+	
+	
 protected:
 	/**
 	 * Sets the error description which will be returned by errorString().
@@ -717,6 +846,22 @@ protected:
 	 */
 	virtual bool loadTemplateFileImpl() = 0;
 	
+	/**
+	 * Hook for reading the template file on a worker thread.
+	 * 
+	 * This function is called by loadTemplateFileAsync(), on this object's
+	 * thread. It may return a function which does the expensive part of
+	 * reading the template file. The returned function is called on a worker
+	 * thread. It must access neither the template object nor the map, but
+	 * only data which it captured, typically shared with the template.
+	 * loadTemplateFileImpl() can take this data, because loadTemplateFile()
+	 * waits for the worker to finish.
+	 * 
+	 * The default implementation returns an empty function, so that all work
+	 * is done in loadTemplateFileImpl().
+	 */
+	virtual std::function<void ()> makeFileReader();
+	
 	/**
 	 * Hook for unloading the template file.
 	 */
@@ -771,6 +916,21 @@ private:
 	/// Bounds correction offset for map templates. Must be masked out when saving.
 	MapCoord accounted_offset;
 	
+	/// The state of the worker which reads the file, while loading asynchronously.
+	std::shared_future<void> async_read;
+	
+	/// The functions to be called when asynchronous loading is finished.
+	std::vector<std::function<void ()>> async_finished;
+	
+	/// The bounding box at the time when the data was released.
+	QRectF released_bounding_box;
+	
+	/// The drawing pass which needed the template most recently.
+	mutable quint64 last_drawn = 0;
+	
+	/// Set by releaseTemplateData(), and reset when the template is loaded.
+	bool data_released = false;
+	
 	/**
 	 * This class reverts the template's accounted offset for its lifetime.
 	 * 
@@ -799,6 +959,10 @@ protected:
 	/// \todo Switch to initialization with -1. ATM 0 is kept for compatibility.
 	int template_group = 0;
 	
+	/// The zoom range for drawing on screen, 0 meaning no limit
+	double min_zoom = 0;
+	double max_zoom = 0;
+	
 	// Transformation matrices calculated from cur_trans
 	Matrix map_to_template;
 	Matrix template_to_map;
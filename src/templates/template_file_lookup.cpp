@@ -0,0 +1,130 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "template_file_lookup.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "core/map.h"
+#include "templates/template.h"
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// Returns the name used for comparing file names on this platform.
+QString normalized(const QString& filename)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+	return filename.toLower();
+#else
+	return filename;
+#endif
+}
+
+}  // namespace
+
+
+
+TemplateFileLookup* TemplateFileLookup::current_lookup = nullptr;
+
+
+TemplateFileLookup::TemplateFileLookup()
+: previous(current_lookup)
+{
+	current_lookup = this;
+}
+
+TemplateFileLookup::~TemplateFileLookup()
+{
+	Q_ASSERT(current_lookup == this);
+	current_lookup = previous;
+}
+
+
+void TemplateFileLookup::prefetch(const Map& map, const QString& map_path)
+{
+	QSet<QString> dir_set;
+	auto const add_dir = [&dir_set](const QString& path) {
+		if (QDir::isAbsolutePath(path))
+			dir_set.insert(QFileInfo(path).absolutePath());
+	};
+	
+	auto const map_info = QFileInfo(map_path);
+	auto const map_dir = map_info.isDir() ? QDir(map_path) : map_info.dir();
+	auto const have_map_dir = !map_path.isEmpty() && map_dir.isAbsolute();
+	if (have_map_dir)
+		dir_set.insert(map_dir.absolutePath());
+	
+	for (int i = 0; i < map.getNumTemplates(); ++i)
+	{
+		auto const* temp = map.getTemplate(i);
+		if (have_map_dir && !temp->getTemplateRelativePath().isEmpty())
+			add_dir(map_dir.absoluteFilePath(temp->getTemplateRelativePath()));
+		add_dir(temp->getTemplatePath());
+	}
+	
+	auto const dirs = dir_set.values();
+	Util::parallelFor(std::size_t(dirs.size()), 1, [this, &dirs](std::size_t first, std::size_t last) {
+		for (auto i = first; i < last; ++i)
+			listing(dirs[int(i)]);
+	});
+}
+
+
+bool TemplateFileLookup::isFile(const QString& path)
+{
+	if (!QDir::isAbsolutePath(path))
+		return QFileInfo(path).isFile();
+	
+	auto const info = QFileInfo(path);
+	return listing(info.absolutePath()).contains(normalized(info.fileName()));
+}
+
+
+TemplateFileLookup::Listing TemplateFileLookup::listing(const QString& dir)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto const cached = listings.constFind(dir);
+		if (cached != listings.constEnd())
+			return *cached;
+	}
+	
+	// The slow part runs without the lock.
+	Listing entries;
+	auto const filter = QDir::Files | QDir::Hidden | QDir::System;
+	for (auto const& entry : QDir(dir).entryList(filter))
+		entries.insert(normalized(entry));
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	listings.insert(dir, entries);
+	return entries;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,117 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TEMPLATE_FILE_LOOKUP_H
+#define OPENORIENTEERING_TEMPLATE_FILE_LOOKUP_H
+
+#include <mutex>
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * A cache of directory listings for resolving template paths.
+ *
+ * Template::tryToFindTemplateFile() probes up to three candidate paths for
+ * each template. On network shares or cloud-synced folders, each probe may
+ * take a long time, and the candidates of different templates are mostly in
+ * the same few directories. While an object of this class exists, the probes
+ * are answered from a single listing per directory.
+ *
+ * The directories of all templates of a map can be listed concurrently with
+ * prefetch(). The cache is meant for a single lookup pass: Files which are
+ * added to a directory after it was listed are not seen.
+ *
+ * Objects of this class must be created and destroyed on the GUI thread.
+ */
+class TemplateFileLookup
+{
+public:
+	/**
+	 * Constructs an empty cache, and makes it the current one.
+	 */
+	TemplateFileLookup();
+	
+	TemplateFileLookup(const TemplateFileLookup&) = delete;
+	TemplateFileLookup(TemplateFileLookup&&) = delete;
+	
+	/**
+	 * Restores the previous current cache.
+	 */
+	~TemplateFileLookup();
+	
+	TemplateFileLookup& operator=(const TemplateFileLookup&) = delete;
+	TemplateFileLookup& operator=(TemplateFileLookup&&) = delete;
+	
+	
+	/**
+	 * Returns the innermost existing cache, or nullptr.
+	 */
+	static TemplateFileLookup* current() { return current_lookup; }
+	
+	
+	/**
+	 * Lists the candidate directories of all templates of the map.
+	 * 
+	 * The directories are listed concurrently through the job system.
+	 * This function returns when all listings are available.
+	 * 
+	 * \param map_path  Either the full filepath of the map, or an arbitrary
+	 *                  directory which shall be regarded as the map directory.
+	 */
+	void prefetch(const Map& map, const QString& map_path);
+	
+	/**
+	 * Returns true if there is a regular file at the given path.
+	 * 
+	 * Absolute paths are answered from the listing of the directory,
+	 * which is created when needed. Other paths, e.g. with a search path
+	 * prefix, are checked directly.
+	 * 
+	 * This function may be called concurrently from multiple threads.
+	 */
+	bool isFile(const QString& path);
+	
+	
+private:
+	using Listing = QSet<QString>;
+	
+	/**
+	 * Returns the listing of the given directory.
+	 */
+	Listing listing(const QString& dir);
+	
+	static TemplateFileLookup* current_lookup;
+	
+	TemplateFileLookup* const previous;
+	std::mutex mutex;
+	QHash<QString, Listing> listings;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_TEMPLATE_FILE_LOOKUP_H
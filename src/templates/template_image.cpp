@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020 Kai Pastor
+ *    Copyright 2012-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,8 +22,13 @@
 #include "template_image.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
 #include <iosfwd>
 #include <iterator>
+#include <memory>
 #include <utility>
 
 #include <Qt>
@@ -33,14 +38,17 @@
 #include <QByteArray>
 #include <QDialog>
 #include <QFileInfo>  // IWYU pragma: keep
+#include <QImageIOHandler>
 #include <QImageReader>
 #include <QImageWriter>
 #include <QLatin1String>
 #include <QList>
+#include <QMetaObject>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QPen>
 #include <QPoint>
+#include <QPolygonF>
 #include <QRect>
 #include <QSaveFile>
 #include <QSize>
@@ -89,6 +97,36 @@ QByteArray findExportFormat(const QString& filename)
 	return {};
 }
 
+/// Pyramid levels are created until the image is not larger than this.
+constexpr int min_pyramid_size = 256;
+
+/// Images which are larger than this get a preview of this size while loading.
+constexpr int max_preview_size = 1024;
+
+/**
+ * Returns the region of a pyramid level which covers the given image region.
+ */
+QRect levelRegion(const QRect& region, const QSize& image_size, const QSize& level_size)
+{
+	auto const fx = qreal(level_size.width()) / image_size.width();
+	auto const fy = qreal(level_size.height()) / image_size.height();
+	auto const left = qFloor(region.left() * fx);
+	auto const top = qFloor(region.top() * fy);
+	auto const right = qCeil((region.right() + 1) * fx);
+	auto const bottom = qCeil((region.bottom() + 1) * fy);
+	return QRect(left, top, right - left, bottom - top).intersected(QRect(QPoint(), level_size));
+}
+
+/// The width and height of the tiles of paint-on-template undo steps.
+constexpr int undo_tile_size = 256;
+
+/// The maximum amount of memory for the paint-on-template undo steps.
+#ifdef Q_OS_ANDROID
+constexpr qint64 max_undo_memory = qint64(16) << 20;
+#else
+constexpr qint64 max_undo_memory = qint64(128) << 20;
+#endif
+
 }
 
 
@@ -202,38 +240,22 @@ bool TemplateImage::loadTypeSpecificTemplateConfiguration(QXmlStreamReader& xml)
 
 bool TemplateImage::loadTemplateFileImpl()
 {
-	QImageReader reader(template_path);
-	const QSize size = reader.size();
-	const QImage::Format format = reader.imageFormat();
-	if (size.isEmpty() || format == QImage::Format_Invalid)
+	discardPreview();
+	auto data = takeImageData();
+	if (!data)
 	{
-		// Leave memory allocation to QImageReader
-		image = reader.read();
+		data = std::make_shared<ImageData>();
+		data->path = template_path;
+		readImageData(*data);
 	}
-	else
+	if (data->image.isNull())
 	{
-		// Pre-allocate the memory in order to catch errors
-		image = QImage(size, format);
-		if (image.isNull())
-		{
-			setErrorString(tr("Not enough free memory (image size: %1x%2 pixels)").arg(size.width()).arg(size.height()));
-			return false;
-		}
-		// Read into pre-allocated image
-		reader.read(&image);
-	}
-	
-	if (image.isNull())
-	{
-		setErrorString(reader.errorString());
+		setErrorString(data->error);
 		return false;
 	}
 	
-#ifdef MAPPER_USE_GDAL
-	available_georef = findAvailableGeoreferencing(readGdalGeoTransform(template_path));
-#else
-	available_georef = findAvailableGeoreferencing({});
-#endif
+	image = std::move(data->image);
+	available_georef = findAvailableGeoreferencing(data->georeferencing);
 	
 	if (is_georeferenced)
 	{
@@ -251,6 +273,119 @@ bool TemplateImage::loadTemplateFileImpl()
 	return true;
 }
 
+// static
+void TemplateImage::readImageData(ImageData& data, const std::function<void ()>& preview_ready)
+{
+	QImageReader reader(data.path);
+	const QSize size = reader.size();
+	const QImage::Format format = reader.imageFormat();
+	
+	// Formats such as JPEG can decode at reduced scale much faster.
+	if (preview_ready
+	    && (size.width() > max_preview_size || size.height() > max_preview_size)
+	    && reader.supportsOption(QImageIOHandler::ScaledSize))
+	{
+		QImageReader preview_reader(data.path);
+		preview_reader.setScaledSize(size.scaled(max_preview_size, max_preview_size, Qt::KeepAspectRatio).expandedTo({1, 1}));
+		data.preview = preview_reader.read();
+		if (!data.preview.isNull())
+		{
+			data.preview_size = size;
+			preview_ready();
+		}
+	}
+	
+	if (size.isEmpty() || format == QImage::Format_Invalid)
+	{
+		// Leave memory allocation to QImageReader
+		data.image = reader.read();
+	}
+	else
+	{
+		// Pre-allocate the memory in order to catch errors
+		data.image = QImage(size, format);
+		if (data.image.isNull())
+		{
+			data.error = tr("Not enough free memory (image size: %1x%2 pixels)").arg(size.width()).arg(size.height());
+			return;
+		}
+		// Read into pre-allocated image
+		reader.read(&data.image);
+	}
+	
+	if (data.image.isNull())
+	{
+		data.error = reader.errorString();
+		return;
+	}
+	
+#ifdef MAPPER_USE_GDAL
+	data.georeferencing = readGdalGeoTransform(data.path);
+#endif
+}
+
+std::shared_ptr<TemplateImage::ImageData> TemplateImage::takeImageData()
+{
+	auto data = std::move(image_data);
+	image_data.reset();
+	if (data && data->path != template_path)
+		data.reset();
+	return data;
+}
+
+std::function<void ()> TemplateImage::makeFileReader()
+{
+	auto data = std::make_shared<ImageData>();
+	data->path = template_path;
+	image_data = data;
+	return [data, preview_ready = makePreviewHandler()]() { readImageData(*data, preview_ready); };
+}
+
+std::function<void ()> TemplateImage::makePreviewHandler()
+{
+	// The reader is finished before this object is destroyed, cf. ~Template().
+	return [this]() {
+		QMetaObject::invokeMethod(this, "showPreview", Qt::QueuedConnection);
+	};
+}
+
+void TemplateImage::showPreview()
+{
+	if (getTemplateState() != Unloaded || !image_data || image_data->path != template_path)
+		return;
+	
+	// The reader does not touch the preview after posting it.
+	preview = std::move(image_data->preview);
+	preview_size = image_data->preview_size;
+	image_data->preview = {};
+	if (!preview.isNull())
+		setTemplateAreaDirty();
+}
+
+void TemplateImage::discardPreview()
+{
+	if (preview.isNull())
+		return;
+	
+	setTemplateAreaDirty();
+	preview = {};
+	preview_size = {};
+}
+
+void TemplateImage::drawTemplatePreview(QPainter* painter, qreal opacity) const
+{
+	if (preview.isNull())
+		return;
+	
+	applyTemplateTransform(painter);
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->setOpacity(opacity);
+	auto const target = QRectF(-preview_size.width() * 0.5, -preview_size.height() * 0.5,
+	                           preview_size.width(), preview_size.height());
+	painter->drawImage(target, preview);
+	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+}
+
 bool TemplateImage::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_view)
 {
 	TemplateImageOpenDialog open_dialog(this, dialog_parent);
@@ -273,7 +408,7 @@ bool TemplateImage::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_vi
 			{
 				// Use the center coordinates of the image as initial reference point.
 				calculateGeoreferencing();
-				auto const center_pixel = MapCoordF(0.5 * (image.width() - 1), 0.5 * (image.height() - 1));
+				auto const center_pixel = MapCoordF(0.5 * (imageSize().width() - 1), 0.5 * (imageSize().height() - 1));
 				initial_georef.setProjectedRefPoint(georef->toProjectedCoords(center_pixel));
 				initial_georef.setCombinedScaleFactor(1.0);
 				initial_georef.setGrivation(0.0);
@@ -336,12 +471,42 @@ bool TemplateImage::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_vi
 void TemplateImage::unloadTemplateFileImpl()
 {
 	image = QImage();
+	pyramid.clear();
+	pyramid_key = 0;
+	undo_steps.clear();
+	undo_index = 0;
 }
 
-void TemplateImage::drawTemplate(QPainter* painter, const QRectF& /*clip_rect*/, double /*scale*/, bool /*on_screen*/, qreal opacity) const
+void TemplateImage::drawTemplate(QPainter* painter, const QRectF& clip_rect, double /*scale*/, bool on_screen, qreal opacity) const
 {
+	// The clip rect is in map coordinates.
+	QPolygonF corners;
+	for (auto const& corner : { clip_rect.topLeft(), clip_rect.topRight(), clip_rect.bottomRight(), clip_rect.bottomLeft() })
+		corners.append(mapToTemplate(MapCoordF(corner)) + QPointF(image.width() * 0.5, image.height() * 0.5));
+	auto const visible = corners.boundingRect().toAlignedRect().adjusted(-1, -1, 1, 1).intersected(image.rect());
+	if (visible.isEmpty())
+		return;
+	
 	applyTemplateTransform(painter);
 	
+	// On screen and in PDF output, use the lowest resolution level which
+	// still provides at least one image pixel per device pixel.
+	// PDF output is resampled to the device resolution, i.e. the resolution
+	// of the print job, so that the file doesn't embed the full image.
+	auto resample_to_device = false;
+#ifdef QT_PRINTSUPPORT_LIB
+	resample_to_device = !on_screen && painter->paintEngine()->type() == AdvancedPdfPrinter::paintEngineType();
+#endif
+	auto const device_scale = std::sqrt(std::abs(painter->combinedTransform().determinant()));
+	auto const* level_image = &image;
+	if ((on_screen || resample_to_device) && device_scale > 0 && device_scale < 0.5)
+	{
+		updatePyramid();
+		auto const level = std::min(int(std::floor(std::log2(1 / device_scale))), int(pyramid.size()));
+		if (level > 0)
+			level_image = &pyramid[std::size_t(level - 1)];
+	}
+	
 	painter->setRenderHint(QPainter::SmoothPixmapTransform);
 	painter->setOpacity(opacity);
 #ifdef QT_PRINTSUPPORT_LIB
@@ -360,15 +525,106 @@ void TemplateImage::drawTemplate(QPainter* painter, const QRectF& /*clip_rect*/,
 			painter->setBrush(Qt::white);
 	}
 #endif
-	painter->drawImage(QPointF(-image.width() * 0.5, -image.height() * 0.5), image);
+	// Draw only the visible part of the image.
+	auto const source = levelRegion(visible, image.size(), level_image->size());
+	auto const fx = qreal(image.width()) / level_image->width();
+	auto const fy = qreal(image.height()) / level_image->height();
+	auto const target = QRectF(source.left() * fx - image.width() * 0.5,
+	                           source.top() * fy - image.height() * 0.5,
+	                           source.width() * fx,
+	                           source.height() * fy);
+	if (resample_to_device && device_scale > 0 && device_scale < 1)
+	{
+		auto const size = QSize(qCeil(target.width() * device_scale), qCeil(target.height() * device_scale))
+		                  .boundedTo(source.size()).expandedTo({1, 1});
+		painter->drawImage(target, level_image->copy(source).scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	}
+	else
+	{
+		painter->drawImage(target, *level_image, source);
+	}
 	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
 }
+
+void TemplateImage::updatePyramid(const QRect& region) const
+{
+	if (pyramid_key == image.cacheKey() && region.isEmpty())
+		return;
+	
+	if (pyramid_key != image.cacheKey() && !region.isEmpty() && !pyramid.empty())
+	{
+		// Update the levels within the modified region only.
+		auto const* source = &image;
+		for (auto& level : pyramid)
+		{
+			auto const level_region = levelRegion(region, image.size(), level.size());
+			if (level_region.isEmpty())
+				break;
+			// Rescale from the aligned region of the next finer level.
+			auto const aligned = levelRegion(level_region, level.size(), source->size());
+			QPainter painter(&level);
+			painter.setCompositionMode(QPainter::CompositionMode_Source);
+			painter.drawImage(level_region.topLeft(),
+			                  source->copy(aligned).scaled(level_region.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+			source = &level;
+		}
+		pyramid_key = image.cacheKey();
+		return;
+	}
+	
+	pyramid.clear();
+	for (;;)
+	{
+		auto const& source = pyramid.empty() ? image : pyramid.back();
+		if (source.width() <= min_pyramid_size && source.height() <= min_pyramid_size)
+			break;
+		auto const size = QSize((source.width() + 1) / 2, (source.height() + 1) / 2);
+		auto level = source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		pyramid.push_back(std::move(level));
+	}
+	pyramid_key = image.cacheKey();
+}
+
 QRectF TemplateImage::getTemplateExtent() const
 {
     // If the image is invalid, the extent is an empty rectangle.
     if (image.isNull())
-		return QRectF();
-	return QRectF(-image.width() * 0.5, -image.height() * 0.5, image.width(), image.height());
+	{
+		// While loading, the preview stands in for the image.
+		if (preview.isNull())
+			return QRectF();
+		return QRectF(-preview_size.width() * 0.5, -preview_size.height() * 0.5, preview_size.width(), preview_size.height());
+	}
+	auto const size = imageSize();
+	return QRectF(-size.width() * 0.5, -size.height() * 0.5, size.width(), size.height());
+}
+
+QSize TemplateImage::imageSize() const
+{
+	return image.size();
+}
+
+qint64 TemplateImage::memoryUsage() const
+{
+	auto bytes = [](const QImage& image) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		return qint64(image.sizeInBytes());
+#else
+		return qint64(image.byteCount());
+#endif
+	};
+	auto usage = bytes(image);
+	for (auto const& level : pyramid)
+		usage += bytes(level);
+	return usage;
+}
+
+qint64 TemplateImage::undoMemoryUsage() const
+{
+	qint64 usage = 0;
+	for (auto const& step : undo_steps)
+		usage += step.memoryUsage();
+	return usage;
 }
 
 QPointF TemplateImage::calcCenterOfGravity(QRgb background_color)
@@ -395,6 +651,11 @@ QPointF TemplateImage::calcCenterOfGravity(QRgb background_color)
 		center = QPointF(center.x() / num_points, center.y() / num_points);
 	center -= QPointF(image.width() * 0.5 - 0.5, image.height() * 0.5 - 0.5);
 	
+	// Scale from the internal image to the template coordinates.
+	auto const size = imageSize();
+	if (size != image.size() && !image.isNull())
+		center = QPointF(center.x() * size.width() / width, center.y() * size.height() / height);
+	
 	return center;
 }
 
@@ -447,6 +708,9 @@ bool TemplateImage::trySetTemplateGeoreferenced(bool value, QWidget* dialog_pare
 
 void TemplateImage::updateGeoreferencing()
 {
+	if (map->isSettingGeoreferencing())
+		return;  // Called again when done
+	
 	if (is_georeferenced)
 	{
 		if (map->getGeoreferencing().getState() != Georeferencing::Geospatial)
@@ -552,6 +816,7 @@ void TemplateImage::drawOntoTemplateImpl(MapCoordF* coords, int num_coords, cons
 			qFloor(points[3].x() - width - 1), qFloor(points[4].y() - width - 1),
 			qCeil(2 * ring_radius + 2*width + 2.5f), qCeil(2 * ring_radius + 2*width + 2.5f)
 		);
+		radius_bbox = radius_bbox.intersected(QRect(0, 0, image.width(), image.height()));
 	}
 	else
 	{
@@ -569,18 +834,18 @@ void TemplateImage::drawOntoTemplateImpl(MapCoordF* coords, int num_coords, cons
 		radius_bbox = radius_bbox.intersected(QRect(0, 0, image.width(), image.height()));
 	}
 	
-	// Create undo step
-	DrawOnImageUndoStep undo_step;
-	undo_step.x = radius_bbox.left();
-	undo_step.y = radius_bbox.top();
-	undo_step.image = image.copy(radius_bbox);
-	addUndoStep(undo_step);
-	
 	// This conversion is to prevent a very strange bug where the behavior of the
 	// default QPainter composition mode seems to be incorrect for images which are
-	// loaded from a file without alpha and then painted over with the eraser
-	if (color.alpha() == 0 && image.format() != QImage::Format_ARGB32_Premultiplied)
+	// loaded from a file without alpha and then painted over with the eraser.
+	// In addition, the undo steps need a constant format with 32 bit pixels.
+	if (image.format() != QImage::Format_ARGB32_Premultiplied)
+	{
 		image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+		undo_steps.clear();
+		undo_index = 0;
+	}
+	
+	auto const before = image.copy(radius_bbox);
 	
 	QPainter painter(&image);
 	painter.setRenderHint(QPainter::Antialiasing);
@@ -619,6 +884,12 @@ void TemplateImage::drawOntoTemplateImpl(MapCoordF* coords, int num_coords, cons
 		painter.setBrush(brush);
 		painter.drawPolygon(points, num_coords);
 	}
+	painter.end();
+	
+	addUndoStep(before, radius_bbox);
+	
+	if (!pyramid.empty())
+		updatePyramid(radius_bbox);
 	
 	delete[] points;
 }
@@ -639,41 +910,110 @@ void TemplateImage::drawOntoTemplateUndo(bool redo)
 			return;
 	}
 	
-	DrawOnImageUndoStep& step = undo_steps[step_index];
-	QImage undo_image = step.image.copy();
-	step.image = image.copy(step.x, step.y, step.image.width(), step.image.height());
-	QPainter painter(&image);
-	painter.setCompositionMode(QPainter::CompositionMode_Source);
-	painter.drawImage(step.x, step.y, undo_image);
-	
+	auto const area = applyUndoStep(undo_steps[std::size_t(step_index)]);
 	undo_index += redo ? 1 : -1;
+	if (area.isEmpty())
+		return;
+	
+	if (!pyramid.empty())
+		updatePyramid(area);
 	
-	qreal template_left = step.x - 0.5 * image.width();
-	qreal template_top = step.y - 0.5 * image.height();
+	qreal template_left = area.x() - 0.5 * image.width();
+	qreal template_top = area.y() - 0.5 * image.height();
 	QRectF map_bbox;
 	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left, template_top)));
-	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left + step.image.width(), template_top)));
-	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left, template_top + step.image.height())));
-	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left + step.image.width(), template_top + step.image.height())));
+	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left + area.width(), template_top)));
+	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left, template_top + area.height())));
+	rectIncludeSafe(map_bbox, templateToMap(QPointF(template_left + area.width(), template_top + area.height())));
 	map->setTemplateAreaDirty(this, map_bbox, 0);
 	
 	setHasUnsavedChanges(true);
 }
 
-void TemplateImage::addUndoStep(const TemplateImage::DrawOnImageUndoStep& new_step)
+void TemplateImage::addUndoStep(const QImage& before, const QRect& area)
 {
-	// TODO: undo step limitation based on used memory
-	const int max_undo_steps = 5;
+	Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+	Q_ASSERT(before.format() == image.format());
 	
+	DrawOnImageUndoStep new_step;
+	QByteArray delta;
+	auto const first_column = area.left() / undo_tile_size;
+	auto const first_row = area.top() / undo_tile_size;
+	for (auto row = first_row; row * undo_tile_size <= area.bottom(); ++row)
+	{
+		for (auto column = first_column; column * undo_tile_size <= area.right(); ++column)
+		{
+			auto const rect = QRect(column * undo_tile_size, row * undo_tile_size, undo_tile_size, undo_tile_size).intersected(area);
+			delta.resize(rect.width() * rect.height() * int(sizeof(quint32)));
+			auto* out = reinterpret_cast<quint32*>(delta.data());
+			auto changed = false;
+			for (auto y = rect.top(); y <= rect.bottom(); ++y)
+			{
+				auto const* old_pixel = reinterpret_cast<const quint32*>(before.constScanLine(y - area.top())) + (rect.left() - area.left());
+				auto const* new_pixel = reinterpret_cast<const quint32*>(image.constScanLine(y)) + rect.left();
+				for (auto x = 0; x < rect.width(); ++x)
+				{
+					*out = old_pixel[x] ^ new_pixel[x];
+					changed |= (*out != 0);
+					++out;
+				}
+			}
+			if (changed)
+				new_step.tiles.push_back({ rect, qCompress(delta, 1) });
+		}
+	}
 	while (static_cast<int>(undo_steps.size()) > undo_index)
 		undo_steps.pop_back();
-	while (static_cast<int>(undo_steps.size()) >= max_undo_steps)
-		undo_steps.erase(undo_steps.begin());
+	undo_steps.push_back(std::move(new_step));
 	
-	undo_steps.push_back(new_step);
+	// Drop the oldest steps when the memory limit is exceeded.
+	auto usage = qint64(0);
+	auto first_kept = undo_steps.end();
+	while (first_kept != undo_steps.begin())
+	{
+		usage += std::prev(first_kept)->memoryUsage();
+		if (usage > max_undo_memory && first_kept != undo_steps.end())
+			break;
+		--first_kept;
+	}
+	undo_steps.erase(undo_steps.begin(), first_kept);
 	undo_index = static_cast<int>(undo_steps.size());
 }
 
+QRect TemplateImage::applyUndoStep(const DrawOnImageUndoStep& step)
+{
+	if (image.format() != QImage::Format_ARGB32_Premultiplied)
+		return {};
+	
+	QRect area;
+	for (auto const& tile : step.tiles)
+	{
+		auto const delta = qUncompress(tile.data);
+		if (delta.size() != tile.rect.width() * tile.rect.height() * int(sizeof(quint32))
+		    || !QRect(QPoint(), image.size()).contains(tile.rect))
+			continue;
+		
+		auto const* in = reinterpret_cast<const quint32*>(delta.constData());
+		for (auto y = tile.rect.top(); y <= tile.rect.bottom(); ++y)
+		{
+			auto* pixel = reinterpret_cast<quint32*>(image.scanLine(y)) + tile.rect.left();
+			for (auto x = 0; x < tile.rect.width(); ++x)
+				pixel[x] ^= *in++;
+		}
+		area |= tile.rect;
+	}
+	return area;
+}
+
+
+qint64 TemplateImage::DrawOnImageUndoStep::memoryUsage() const
+{
+	auto usage = qint64(sizeof(*this));
+	for (auto const& tile : tiles)
+		usage += qint64(sizeof(tile)) + tile.data.size();
+	return usage;
+}
+
 void TemplateImage::calculateGeoreferencing()
 {
 	if (!isGeoreferencingUsable())
@@ -703,13 +1043,13 @@ void TemplateImage::updatePosFromGeoreferencing()
 		qDebug("%s failed", Q_FUNC_INFO);
 		return; // TODO: proper error message?
 	}
-	MapCoordF top_right = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(image.width(), 0.0), &ok);
+	MapCoordF top_right = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(imageSize().width(), 0.0), &ok);
 	if (!ok)
 	{
 		qDebug("%s failed", Q_FUNC_INFO);
 		return; // TODO: proper error message?
 	}
-	MapCoordF bottom_left = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(0.0, image.height()), &ok);
+	MapCoordF bottom_left = map->getGeoreferencing().toMapCoordF(georef.get(), MapCoordF(0.0, imageSize().height()), &ok);
 	if (!ok)
 	{
 		qDebug("%s failed", Q_FUNC_INFO);
@@ -719,14 +1059,15 @@ void TemplateImage::updatePosFromGeoreferencing()
 	// Calculate template transform as similarity transform from pixels to map coordinates
 	PassPointList pp_list;
 	
+	auto const size = imageSize();
 	PassPoint pp;
-	pp.src_coords = MapCoordF(-0.5 * image.width(), -0.5 * image.height());
+	pp.src_coords = MapCoordF(-0.5 * size.width(), -0.5 * size.height());
 	pp.dest_coords = top_left;
 	pp_list.push_back(pp);
-	pp.src_coords = MapCoordF(0.5 * image.width(), -0.5 * image.height());
+	pp.src_coords = MapCoordF(0.5 * size.width(), -0.5 * size.height());
 	pp.dest_coords = top_right;
 	pp_list.push_back(pp);
-	pp.src_coords = MapCoordF(-0.5 * image.width(), 0.5 * image.height());
+	pp.src_coords = MapCoordF(-0.5 * size.width(), 0.5 * size.height());
 	pp.dest_coords = bottom_left;
 	pp_list.push_back(pp);
 	
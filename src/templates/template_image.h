@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2020 Kai Pastor
+ *    Copyright 2012-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,7 @@
 #ifndef OPENORIENTEERING_TEMPLATE_IMAGE_H
 #define OPENORIENTEERING_TEMPLATE_IMAGE_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -31,8 +32,10 @@
 #include <QImage>
 #include <QObject>
 #include <QPointF>
+#include <QRect>
 #include <QRectF>
 #include <QRgb>
+#include <QSize>
 #include <QString>
 #include <QTransform>
 
@@ -117,6 +120,16 @@ public:
     void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const override;
 	QRectF getTemplateExtent() const override;
 	bool canBeDrawnOnto() const override { return drawable; }
+	
+	/**
+	 * Returns the size of the image and of its pyramid, in bytes.
+	 */
+	qint64 memoryUsage() const override;
+	
+	/**
+	 * Returns the size of the undo steps for drawing onto the image, in bytes.
+	 */
+	qint64 undoMemoryUsage() const override;
 
 	/**
 	 * Calculates the image's center of gravity in template coordinates by
@@ -127,6 +140,15 @@ public:
 	/** Returns the internal QImage. */
 	inline const QImage& getImage() const {return image;}
 	
+	/**
+	 * Returns the size of the image in pixels.
+	 * 
+	 * This is the size of the template in template coordinates. It may differ
+	 * from the size of the internal QImage when this image is only a reduced
+	 * resolution overview of a larger raster.
+	 */
+	virtual QSize imageSize() const;
+	
 	/**
 	 * Returns which georeferencing methods are known to be available.
 	 * 
@@ -140,9 +162,20 @@ public:
 	bool canChangeTemplateGeoreferenced() const override;
 	bool trySetTemplateGeoreferenced(bool value, QWidget* dialog_parent) override;
 	
+	void updateGeoreferencing() override;
 	
-public slots:
-	void updateGeoreferencing();
+	/**
+	 * Draws the reduced-scale preview which is available while the full
+	 * image is read on a worker thread.
+	 */
+	void drawTemplatePreview(QPainter* painter, qreal opacity) const override;
+	
+	
+private slots:
+	/**
+	 * Takes the preview from the image data which is being read.
+	 */
+	void showPreview();
 	
 protected:
 	/**
@@ -167,27 +200,110 @@ protected:
 	 */
 	bool isGeoreferencingUsable() const;
 	
-	/** Information about an undo step for the paint-on-template functionality. */
+	/**
+	 * Image data which is read from the template file on a worker thread.
+	 */
+	struct ImageData
+	{
+		QString path;                         ///< The file which was read.
+		QImage image;                         ///< The image, null on error.
+		QSize size;                           ///< The full size, if the image is only an overview.
+		QImage preview;                       ///< A reduced-scale image, read before the image.
+		QSize preview_size;                   ///< The full size of the image shown by the preview.
+		GeoreferencingOption georeferencing;  ///< Georeferencing from the file.
+		QString error;                        ///< The description of an error.
+		bool elevation = false;               ///< The image is the relief of an elevation raster.
+	};
+	
+	/**
+	 * Reads the image file at data.path.
+	 * 
+	 * For large images, when the image format supports decoding at reduced
+	 * scale, a preview is read first, and preview_ready is called before the
+	 * full image is read.
+	 */
+	static void readImageData(ImageData& data, const std::function<void ()>& preview_ready = {});
+	
+	/**
+	 * Returns a function which can be passed as preview_ready.
+	 * 
+	 * The function lets this object take the preview on its own thread.
+	 */
+	std::function<void ()> makePreviewHandler();
+	
+	/**
+	 * Removes the preview, and marks its area as dirty.
+	 * 
+	 * This is meant to be called from loadTemplateFileImpl().
+	 */
+	void discardPreview();
+	
+	/**
+	 * Returns the image data which was read for the current template path,
+	 * or nullptr.
+	 */
+	std::shared_ptr<ImageData> takeImageData();
+	
+	std::function<void ()> makeFileReader() override;
+	
+	/**
+	 * Information about an undo step for the paint-on-template functionality.
+	 * 
+	 * The step holds the changes of the image in tiles. Each tile holds the
+	 * compressed XOR of the pixels before and after the change, so applying
+	 * the same tile again reverts the change. Tiles without changed pixels
+	 * are not stored.
+	 */
 	struct DrawOnImageUndoStep
 	{
-		/** Copy of previous image part */
-		QImage image;
+		struct Tile
+		{
+			QRect rect;       ///< The area of the tile, in image pixels.
+			QByteArray data;  ///< The compressed XOR of 32 bit pixels.
+		};
 		
-		/** X position of image part origin */
-		int x;
+		std::vector<Tile> tiles;
 		
-		/** Y position of image part origin */
-		int y;
+		/** Returns the amount of memory held by the compressed tiles. */
+		qint64 memoryUsage() const;
 	};
 	
 	void drawOntoTemplateImpl(MapCoordF* coords, int num_coords, const QColor& color, qreal width, ScribbleOptions mode) override;
 	void drawOntoTemplateUndo(bool redo) override;
-	void addUndoStep(const DrawOnImageUndoStep& new_step);
+	
+	/**
+	 * Records the changes of the given image area as a new undo step.
+	 * 
+	 * The before image holds a copy of the area before the change.
+	 */
+	void addUndoStep(const QImage& before, const QRect& area);
+	
+	/**
+	 * Applies the tiles of an undo step to the image, reverting a change or
+	 * redoing a reverted change.
+	 * 
+	 * Returns the bounding box of the affected pixels.
+	 */
+	QRect applyUndoStep(const DrawOnImageUndoStep& step);
 	void calculateGeoreferencing();
 	void updatePosFromGeoreferencing();
+	
+	/**
+	 * Builds or updates the reduced resolution levels of the image.
+	 * 
+	 * Each level has half the size of the previous one. If region is not
+	 * empty, only this part of the image has changed, and the existing levels
+	 * are updated for this part only.
+	 */
+	void updatePyramid(const QRect& region = {}) const;
 
 	QImage image;
 	
+	/// Reduced resolution levels for drawing at small scales, built on demand.
+	mutable std::vector<QImage> pyramid;
+	/// The cache key of the image which the pyramid was built for.
+	mutable qint64 pyramid_key = 0;
+	
 	std::vector< DrawOnImageUndoStep > undo_steps;
 	/// Current index in undo_steps, where 0 means before the first item.
 	int undo_index = 0;
@@ -196,6 +312,14 @@ protected:
 	
 	GeoreferencingOptions available_georef;
 	std::unique_ptr<Georeferencing> georef;
+	
+	/// Data read on a worker thread, to be taken by loadTemplateFileImpl().
+	std::shared_ptr<ImageData> image_data;
+	
+	/// A reduced-scale image to be drawn while the image is read.
+	QImage preview;
+	/// The size of the image which is represented by the preview.
+	QSize preview_size;
 };
 
 
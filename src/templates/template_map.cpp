@@ -21,17 +21,27 @@
 
 #include "template_map.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <utility>
+#include <vector>
 
+#include <Qt>
 #include <QtGlobal>
 #include <QByteArray>
 #include <QDialog>
+#include <QHash>
+#include <QImage>
 #include <QPaintDevice>
 #include <QPainter>
 #include <QPoint>
 #include <QPointF>
 #include <QRectF>
 #include <QStringList>
+#include <QThread>
 #include <QTimer>
 #include <QTransform>
 #include <QVariant>
@@ -74,8 +84,155 @@ void transformMap(Map& template_map, Map const& map, TemplateTransform const& tr
 		template_map.scaleAllSymbols(template_scale);
 }
 
+
+/**
+ * The maximum number of raster tiles of a map template in memory.
+ * 
+ * A tile with 32 bits per pixel takes 1 MiB.
+ */
+#ifdef Q_OS_ANDROID
+constexpr int max_raster_tiles = 48;
+#else
+constexpr int max_raster_tiles = 128;
+#endif
+
+}  // namespace
+
+
+
+// ### TemplateMap::RasterCache ###
+
+/**
+ * Raster tiles of a template map, for drawing on screen.
+ * 
+ * The tiles are rendered in template map coordinates, at resolutions in
+ * steps of half an octave, so that they do not depend on the template's
+ * transformation and can be reused for all views and for nearby zoom levels.
+ * Drawing is thus about as expensive as drawing an image. The tiles remain
+ * valid until the content of the template map changes.
+ */
+class TemplateMap::RasterCache
+{
+public:
+	/** The width and height of a tile, in pixels. */
+	static constexpr int tile_size = 512;
+	
+	/**
+	 * Draws the template map from the cached tiles.
+	 * 
+	 * Missing tiles are rendered immediately. Returns false, without drawing,
+	 * when the area would need too many tiles.
+	 * 
+	 * @param clip_rect  The area to be drawn, in template map coordinates.
+	 * @param scaling    The number of device pixels per template map millimeter.
+	 */
+	bool draw(QPainter* painter, const Map& map, const QRectF& clip_rect, qreal scaling, bool antialiasing, qreal opacity);
+	
+	qint64 memoryUsage() const;
+	
+private:
+	struct Tile
+	{
+		QImage image;
+		quint64 last_used = 0;
+	};
+	
+	static quint64 keyOf(int level, qint64 column, qint64 row);
+	
+	/** Drops the least recently used tiles when there are too many. */
+	void trim();
+	
+	QHash<quint64, Tile> tiles;
+	quint64 use_counter = 0;
+	bool antialiasing = false;
+};
+
+
+bool TemplateMap::RasterCache::draw(QPainter* painter, const Map& map, const QRectF& clip_rect, qreal scaling, bool antialiasing, qreal opacity)
+{
+	if (!(scaling > 0) || !clip_rect.isValid())
+		return false;
+	
+	if (antialiasing != this->antialiasing)
+	{
+		tiles.clear();
+		this->antialiasing = antialiasing;
+	}
+	
+	auto const level = qBound(-64, int(std::ceil(2 * std::log2(scaling))), 63);
+	auto const resolution = std::exp2(level / 2.0);  // pixels per mm
+	auto const span = tile_size / resolution;         // mm per tile
+	auto const first_column = qint64(std::floor(clip_rect.left() / span));
+	auto const last_column  = qint64(std::floor(clip_rect.right() / span));
+	auto const first_row    = qint64(std::floor(clip_rect.top() / span));
+	auto const last_row     = qint64(std::floor(clip_rect.bottom() / span));
+	if ((last_column - first_column + 1) * (last_row - first_row + 1) > max_raster_tiles / 2)
+		return false;
+	
+	++use_counter;
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->setOpacity(painter->opacity() * opacity);
+	for (auto row = first_row; row <= last_row; ++row)
+	{
+		for (auto column = first_column; column <= last_column; ++column)
+		{
+			auto const rect = QRectF(column * span, row * span, span, span);
+			auto& tile = tiles[keyOf(level, column, row)];
+			tile.last_used = use_counter;
+			if (tile.image.isNull())
+			{
+				tile.image = QImage(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+				tile.image.fill(Qt::transparent);
+				QPainter tile_painter(&tile.image);
+				if (antialiasing)
+					tile_painter.setRenderHint(QPainter::Antialiasing);
+				tile_painter.scale(resolution, resolution);
+				tile_painter.translate(-rect.left(), -rect.top());
+				RenderConfig config = { map, rect, resolution, RenderConfig::BatchedDrawing | RenderConfig::Screen, 1.0 };
+				map.draw(&tile_painter, config);
+			}
+			painter->drawImage(rect, tile.image);
+		}
+	}
+	
+	trim();
+	return true;
 }
 
+qint64 TemplateMap::RasterCache::memoryUsage() const
+{
+	return qint64(tiles.size()) * tile_size * tile_size * 4;
+}
+
+// static
+quint64 TemplateMap::RasterCache::keyOf(int level, qint64 column, qint64 row)
+{
+	return (quint64(level + 64) << 56) | ((quint64(column) & 0xfffffff) << 28) | (quint64(row) & 0xfffffff);
+}
+
+void TemplateMap::RasterCache::trim()
+{
+	if (tiles.size() <= max_raster_tiles)
+		return;
+	
+	// Tiles which were used in the last draw are kept.
+	std::vector<std::pair<quint64, quint64>> candidates;
+	candidates.reserve(std::size_t(tiles.size()));
+	for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		if (tile->last_used != use_counter)
+			candidates.emplace_back(tile->last_used, tile.key());
+	}
+	auto const count = std::min(candidates.size(), std::size_t(tiles.size() - max_raster_tiles));
+	std::partial_sort(candidates.begin(), candidates.begin() + std::ptrdiff_t(count), candidates.end());
+	for (std::size_t i = 0; i < count; ++i)
+		tiles.remove(candidates[i].second);
+}
+
+
+
+// ### TemplateMap ###
+
 
 
 QStringList TemplateMap::locked_maps;
@@ -92,7 +249,10 @@ TemplateMap::TemplateMap(const QString& path, Map* map)
 	const Georeferencing& georef = map->getGeoreferencing();
 	connect(&georef, &Georeferencing::projectionChanged, this, &TemplateMap::mapProjectionChanged);
 	// For connecting to virtual methods using PMF, we need to use a lambda.
-	connect(&georef, &Georeferencing::transformationChanged, this, [this]() { mapTransformationChanged(); });
+	connect(&georef, &Georeferencing::transformationChanged, this, [this]() {
+		if (!map->isSettingGeoreferencing())
+			mapTransformationChanged();
+	});
 }
 
 TemplateMap::TemplateMap(const TemplateMap& proto)
@@ -101,7 +261,10 @@ TemplateMap::TemplateMap(const TemplateMap& proto)
 	const Georeferencing& georef = map->getGeoreferencing();
 	connect(&georef, &Georeferencing::projectionChanged, this, &TemplateMap::mapProjectionChanged);
 	// For connecting to virtual methods using PMF, we need to use a lambda.
-	connect(&georef, &Georeferencing::transformationChanged, this, [this]() { mapTransformationChanged(); });
+	connect(&georef, &Georeferencing::transformationChanged, this, [this]() {
+		if (!map->isSettingGeoreferencing())
+			mapTransformationChanged();
+	});
 }
 
 TemplateMap::~TemplateMap()
@@ -146,15 +309,21 @@ bool TemplateMap::loadTemplateFileImpl()
 	if (locked_maps.contains(template_path))
 		return true;
 	
-	auto new_template_map = std::make_unique<Map>(); 
-	auto importer = FileFormats.makeImporter(template_path, *new_template_map, nullptr);
-	locked_maps.append(template_path);  /// \todo Convert to RAII
-	auto new_template_valid = importer && importer->doImport();
-	locked_maps.removeAll(template_path);
+	auto data = takeMapData();
+	if (!data)
+	{
+		data = std::make_shared<MapData>();
+		data->path = template_path;
+		locked_maps.append(template_path);  /// \todo Convert to RAII
+		readMapData(*data, thread());
+		locked_maps.removeAll(template_path);
+	}
 	
+	auto new_template_valid = data->valid;
 	if (new_template_valid)
 	{
-		template_map = std::move(new_template_map);
+		template_map = std::move(data->map);
+		invalidateRasterCache();
 		
 		if (property(ocdTransformProperty()).toBool())
 		{
@@ -194,18 +363,52 @@ bool TemplateMap::loadTemplateFileImpl()
 			block_georeferencing = false;
 		}
 	}
-	else if (importer)
-	{
-		setErrorString(importer->warnings().back());
-	}
 	else
 	{
-		setErrorString(tr("Cannot load map file, aborting."));
+		setErrorString(data->error);
 	}
 	
 	return new_template_valid;
 }
 
+// static
+void TemplateMap::readMapData(MapData& data, QThread* thread)
+{
+	auto new_template_map = std::make_unique<Map>();
+	auto importer = FileFormats.makeImporter(data.path, *new_template_map, nullptr);
+	data.valid = importer && importer->doImport();
+	if (importer)
+		data.warnings = importer->warnings();
+	
+	if (!importer)
+		data.error = tr("Cannot load map file, aborting.");
+	else if (!data.valid)
+		data.error = data.warnings.back();
+	
+	new_template_map->changeThreadAffinity(thread);
+	data.map = std::move(new_template_map);
+}
+
+std::shared_ptr<TemplateMap::MapData> TemplateMap::takeMapData()
+{
+	auto data = std::move(map_data);
+	map_data.reset();
+	if (data && data->path != template_path)
+		data.reset();
+	return data;
+}
+
+std::function<void ()> TemplateMap::makeFileReader()
+{
+	if (locked_maps.contains(template_path))
+		return {};
+	
+	auto data = std::make_shared<MapData>();
+	data->path = template_path;
+	map_data = data;
+	return [data, thread = thread()]() { readMapData(*data, thread); };
+}
+
 bool TemplateMap::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_view)
 {
 	if (map->getGeoreferencing().getState() != Georeferencing::Geospatial
@@ -236,6 +439,7 @@ bool TemplateMap::postLoadSetup(QWidget* dialog_parent, bool& out_center_in_view
 void TemplateMap::unloadTemplateFileImpl()
 {
 	template_map.reset();
+	invalidateRasterCache();
 }
 
 void TemplateMap::drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const
@@ -243,7 +447,8 @@ void TemplateMap::drawTemplate(QPainter* painter, const QRectF& clip_rect, doubl
 	if (!is_georeferenced)
 		applyTemplateTransform(painter);
 	
-	if (Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool())
+	auto const antialiasing = Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool();
+	if (antialiasing)
 		painter->setRenderHint(QPainter::Antialiasing);
 	
 	QRectF transformed_clip_rect;
@@ -259,7 +464,7 @@ void TemplateMap::drawTemplate(QPainter* painter, const QRectF& clip_rect, doubl
 		transformed_clip_rect = clip_rect;
 	}
 	
-	RenderConfig::Options options;
+	RenderConfig::Options options = RenderConfig::BatchedDrawing;
 	auto scaling = scale;
 	if (on_screen)
 	{
@@ -275,6 +480,15 @@ void TemplateMap::drawTemplate(QPainter* painter, const QRectF& clip_rect, doubl
 		if (dpi > 0)
 			scaling *= dpi / 25.4;
 	}
+	
+	if (on_screen)
+	{
+		if (!raster_cache)
+			raster_cache = std::make_unique<RasterCache>();
+		if (raster_cache->draw(painter, *template_map, transformed_clip_rect, scaling, antialiasing, opacity))
+			return;
+	}
+	
 	RenderConfig config = { *template_map, transformed_clip_rect, scaling, options, qreal(opacity) };
 	// TODO: introduce template-specific options, adjustable by the user, to allow changing some of these parameters
 	template_map->draw(painter, config);
@@ -289,6 +503,11 @@ QRectF TemplateMap::getTemplateExtent() const
 	return extent;
 }
 
+qint64 TemplateMap::memoryUsage() const
+{
+	return raster_cache ? raster_cache->memoryUsage() : 0;
+}
+
 
 bool TemplateMap::hasAlpha() const
 {
@@ -331,6 +550,7 @@ bool TemplateMap::trySetTemplateGeoreferenced(bool value, QWidget* /*dialog_pare
 			
 			is_georeferenced = true;
 			transformMap(*template_map, *map, TemplateTransform::fromQTransform(q_transform));
+			invalidateRasterCache();
 			transform = {};
 			updateTransformationMatrices();
 			setTemplateAreaDirty();
@@ -357,6 +577,7 @@ std::unique_ptr<Map> TemplateMap::takeTemplateMap()
 	if (template_state == Loaded)
 	{
 		swap(result, template_map);
+		invalidateRasterCache();
 		setTemplateState(Unloaded);
 		emit templateStateChanged();
 	}
@@ -366,11 +587,26 @@ std::unique_ptr<Map> TemplateMap::takeTemplateMap()
 void TemplateMap::setTemplateMap(std::unique_ptr<Map>&& map)
 {
 	template_map = std::move(map);
+	invalidateRasterCache();
 }
 
+void TemplateMap::invalidateRasterCache()
+{
+	raster_cache.reset();
+}
+
+
+void TemplateMap::updateGeoreferencing()
+{
+	// Reloads the template if the projection changed.
+	mapTransformationChanged();
+}
 
 void TemplateMap::mapProjectionChanged()
 {
+	if (map->isSettingGeoreferencing())
+		return;  // Handled by updateGeoreferencing()
+	
 	if (is_georeferenced && template_state == Template::Loaded)
 		reloadLater();
 }
@@ -390,6 +626,7 @@ void TemplateMap::mapTransformationChanged()
 			auto const t = templ_georef.mapToProjected() * map_georef.projectedToMap();
 			templateMap()->applyOnAllObjects([&t](Object* o) { o->transform(t); });
 			templateMap()->setGeoreferencing(map_georef);
+			invalidateRasterCache();
 		}
 		else
 		{
@@ -410,7 +647,10 @@ void TemplateMap::reloadLater()
 	if (reload_pending)
 		return;
 	if (template_state == Loaded)
+	{
 		templateMap()->clear(); // no expensive operations before reloading
+		invalidateRasterCache();
+	}
 	QTimer::singleShot(0, this, &TemplateMap::reload);
 	reload_pending = true;
 }
@@ -22,11 +22,13 @@
 #ifndef OPENORIENTEERING_TEMPLATE_MAP_H
 #define OPENORIENTEERING_TEMPLATE_MAP_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 #include <QtGlobal>
 #include <QObject>
+#include <QPointF>
 #include <QString>
 
 #include "templates/template.h"
@@ -35,12 +37,14 @@ class QByteArray;
 class QPainter;
 class QRectF;
 class QStringList;
+class QThread;
 class QTransform;
 class QWidget;
 
 namespace OpenOrienteering {
 
 class Map;
+class MapView;
 
 
 /**
@@ -84,6 +88,11 @@ public:
 	
 	QRectF getTemplateExtent() const override;
 	
+	/**
+	 * Returns the size of the cached raster tiles, in bytes.
+	 */
+	qint64 memoryUsage() const override;
+	
 	
 	bool hasAlpha() const override;
 	
@@ -92,6 +101,8 @@ public:
 	
 	bool trySetTemplateGeoreferenced(bool value, QWidget* dialog_parent) override;
 	
+	void updateGeoreferencing() override;
+	
 	
 	const Map* templateMap() const;
 	
@@ -108,6 +119,44 @@ protected:
 	
 	void setTemplateMap(std::unique_ptr<Map>&& map);
 	
+	/**
+	 * Drops the raster tiles which are cached for drawing on screen.
+	 * 
+	 * This must be called when the content of the template map changes.
+	 */
+	void invalidateRasterCache();
+	
+	
+	/**
+	 * Map data which is read from the template file on a worker thread.
+	 */
+	struct MapData
+	{
+		QString path;                  ///< The file which was read.
+		std::unique_ptr<Map> map;      ///< The map, with affinity to the template's thread.
+		MapView* view = nullptr;       ///< An optional view, owned by the map.
+		QPointF projected_ref_point;   ///< The projected reference point before import.
+		std::vector<QString> warnings; ///< The warnings from the importer.
+		QString error;                 ///< The description of an error.
+		bool valid = false;
+	};
+	
+	/**
+	 * Imports the map file at data.path, and moves the map to the given thread.
+	 */
+	static void readMapData(MapData& data, QThread* thread);
+	
+	/**
+	 * Returns the map data which was read for the current template path,
+	 * or nullptr.
+	 */
+	std::shared_ptr<MapData> takeMapData();
+	
+	std::function<void ()> makeFileReader() override;
+	
+	/// Data read on a worker thread, to be taken by loadTemplateFileImpl().
+	std::shared_ptr<MapData> map_data;
+	
 	
 	void mapProjectionChanged();
 	
@@ -143,9 +192,12 @@ public:
 	static const char* ocdTransformProperty();
 	
 private:
+	class RasterCache;
+	
 	bool georeferencedStateSupported() const;
 	
 	std::unique_ptr<Map> template_map;
+	mutable std::unique_ptr<RasterCache> raster_cache;
 	bool reload_pending = false;
 	
 	/**
@@ -27,13 +27,18 @@
 #include <QCoreApplication>
 #include <QFlags>
 #include <QIcon>
+#include <QImage>
 #include <QLatin1String>
+#include <QMetaObject>
 #include <QModelIndex>
 #include <QPalette>
+#include <QPixmap>
 
 #include "core/map.h"
 #include "core/map_view.h"
 #include "templates/template.h"
+#include "templates/template_thumbnail_cache.h"
+#include "util/parallel.h"
 
 
 namespace {
@@ -65,7 +70,12 @@ constexpr int combined(int column, Qt::ItemDataRole role)
 
 namespace OpenOrienteering {
 
-TemplateTableModel::~TemplateTableModel() = default;
+TemplateTableModel::~TemplateTableModel()
+{
+	// The job must not outlive the model, cf. startThumbnailJob().
+	if (thumbnail_job.valid())
+		thumbnail_job.wait();
+}
 
 TemplateTableModel::TemplateTableModel(Map& map, MapView& view, QObject* parent)
 : QAbstractTableModel(parent)
@@ -311,6 +321,13 @@ QVariant TemplateTableModel::templateData(Template* temp, const QModelIndex &ind
 	case combined(nameColumn(), Qt::DisplayRole):
 		return temp->getTemplateFilename();
 		
+	case combined(visibilityColumn(), Qt::DecorationRole):
+		if (!touchMode())
+			break;
+		Q_FALLTHROUGH();
+	case combined(nameColumn(), Qt::DecorationRole):
+		return thumbnail(temp);
+		
 	case combined(visibilityColumn(), Qt::ToolTipRole):
 		if (!touchMode())
 			break;
@@ -462,4 +479,58 @@ void TemplateTableModel::onTemplateStateChanged()
 }
 
 
+QVariant TemplateTableModel::thumbnail(const Template* temp) const
+{
+	auto const path = temp->getTemplatePath();
+	auto const found = thumbnails.constFind(path);
+	if (found != thumbnails.constEnd())
+	{
+		if (found->isNull())
+			return {};
+		return *found;
+	}
+	
+	if (path != thumbnail_job_path && !pending_thumbnails.contains(path))
+	{
+		pending_thumbnails.append(path);
+		startThumbnailJob();
+	}
+	return {};
+}
+
+void TemplateTableModel::startThumbnailJob() const
+{
+	if (thumbnail_job.valid() || pending_thumbnails.empty())
+		return;
+	
+	auto* self = const_cast<TemplateTableModel*>(this);
+	thumbnail_job_path = pending_thumbnails.takeFirst();
+	thumbnail_job = Util::startJob<QImage>([self, path = thumbnail_job_path]() {
+		auto thumbnail = TemplateThumbnailCache(path).provideThumbnail();
+		// Posted before the future is ready, cf. ~TemplateTableModel().
+		QMetaObject::invokeMethod(self, "thumbnailFinished", Qt::QueuedConnection);
+		return thumbnail;
+	});
+}
+
+void TemplateTableModel::thumbnailFinished()
+{
+	auto const thumbnail = thumbnail_job.get();
+	auto const path = thumbnail_job_path;
+	thumbnail_job_path.clear();
+	thumbnails.insert(path, thumbnail.isNull() ? QIcon() : QIcon(QPixmap::fromImage(thumbnail)));
+	
+	for (auto pos = 0, last = map.getNumTemplates(); pos < last; ++pos)
+	{
+		if (map.getTemplate(pos)->getTemplatePath() == path)
+		{
+			auto const row = rowFromPos(pos);
+			emit dataChanged(index(row, visibilityColumn()), index(row, nameColumn()), { Qt::DecorationRole });
+		}
+	}
+	
+	startThumbnailJob();
+}
+
+
 }  // namespace OpenOrienteering
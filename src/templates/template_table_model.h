@@ -21,10 +21,16 @@
 #ifndef OPENORIENTEERING_TEMPLATE_TABLE_MODEL_H
 #define OPENORIENTEERING_TEMPLATE_TABLE_MODEL_H
 
+#include <future>
+
 #include <Qt>
 #include <QAbstractTableModel>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 
 class QModelIndex;
@@ -40,6 +46,10 @@ class Template;
  * An item model representing template and map visibility properties.
  * 
  * Each template, and also the map, is represented by a row in the model.
+ * 
+ * The name column is decorated with a thumbnail of the template file. The
+ * thumbnails are created one at a time by a background job, when they are
+ * first requested, and they are cached on disk by TemplateThumbnailCache.
  */
 class TemplateTableModel :  public QAbstractTableModel
 {
@@ -122,12 +132,34 @@ protected:
 	void onTemplateDeleted();
 	void onTemplateStateChanged();
 	
+	/**
+	 * Returns the thumbnail for the template, or requests it.
+	 */
+	QVariant thumbnail(const Template* temp) const;
+	
+	/**
+	 * Starts the job for the next requested thumbnail, if not busy.
+	 */
+	void startThumbnailJob() const;
+	
+private slots:
+	/**
+	 * Takes the result of the thumbnail job, and updates the affected rows.
+	 */
+	void thumbnailFinished();
+	
 private:
 	Map& map;
 	MapView& view;
 	QVariant checkbox_decorator;
 	bool touch_mode = false;
 	
+	/// Thumbnails by template path, with null icons for unsupported files
+	mutable QHash<QString, QIcon> thumbnails;
+	mutable QStringList pending_thumbnails;
+	mutable QString thumbnail_job_path;
+	mutable std::future<QImage> thumbnail_job;
+	
 };
 
 
@@ -0,0 +1,114 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "template_thumbnail_cache.h"
+
+#include <Qt>
+#include <QtGlobal>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QImageReader>
+#include <QLatin1String>
+
+#include "util/disk_cache.h"
+
+
+namespace OpenOrienteering {
+
+TemplateThumbnailCache::TemplateThumbnailCache(const QString& path)
+: path(path)
+{
+	auto const file_info = QFileInfo(path);
+	if (!file_info.isFile())
+		return;
+	
+	auto const key = DiskCache::makeKey({
+	    file_info.absoluteFilePath().toUtf8(),
+	    QByteArray::number(file_info.size()),
+	    QByteArray::number(file_info.lastModified().toMSecsSinceEpoch()),
+	    QByteArray::number(maxSize().width()) + 'x' + QByteArray::number(maxSize().height()),
+	});
+	cache_path = DiskCache::entryPath(DiskCache::TemplateThumbnails, key, QLatin1String(".png"));
+}
+
+
+QImage TemplateThumbnailCache::restoreThumbnail() const
+{
+	if (!isValid() || !QFileInfo::exists(cache_path))
+		return {};
+	
+	auto thumbnail = QImage(cache_path, "PNG");
+	if (!thumbnail.isNull())
+		DiskCache::touch(DiskCache::TemplateThumbnails, cache_path);
+	return thumbnail;
+}
+
+
+bool TemplateThumbnailCache::storeThumbnail(const QImage& thumbnail) const
+{
+	if (!isValid() || thumbnail.isNull())
+		return false;
+	
+	auto const ok = DiskCache::write(cache_path, [&thumbnail](QIODevice& device) {
+		return thumbnail.save(&device, "PNG");
+	});
+	if (ok)
+		DiskCache::scheduleTrim(DiskCache::TemplateThumbnails);
+	return ok;
+}
+
+
+QImage TemplateThumbnailCache::provideThumbnail() const
+{
+	if (!isValid())
+		return {};
+	
+	auto thumbnail = restoreThumbnail();
+	if (thumbnail.isNull())
+	{
+		thumbnail = createThumbnail(path);
+		if (!thumbnail.isNull() && !storeThumbnail(thumbnail))
+			qDebug("Failed to store the template thumbnail in %s", qPrintable(cache_path));
+	}
+	return thumbnail;
+}
+
+
+// static
+QImage TemplateThumbnailCache::createThumbnail(const QString& path)
+{
+	QImageReader reader(path);
+	if (!reader.canRead())
+		return {};
+	
+	// Let the decoder do the scaling if the size is known in advance.
+	auto const size = reader.size();
+	if (size.isValid() && (size.width() > maxSize().width() || size.height() > maxSize().height()))
+		reader.setScaledSize(size.scaled(maxSize(), Qt::KeepAspectRatio));
+	
+	auto image = reader.read();
+	if (image.width() > maxSize().width() || image.height() > maxSize().height())
+		image = image.scaled(maxSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	return image;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,98 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TEMPLATE_THUMBNAIL_CACHE_H
+#define OPENORIENTEERING_TEMPLATE_THUMBNAIL_CACHE_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+
+namespace OpenOrienteering {
+
+
+/**
+ * A disk cache for small preview images of template files.
+ *
+ * Thumbnails are created by a downscaled decoding of the template file, so
+ * decoders which support scaled reading (such as JPEG) never allocate the
+ * full image. The thumbnails are stored in the DiskCache::TemplateThumbnails
+ * category. Cache entries are keyed by a hash of the file path, size and
+ * modification time. Thus modified files get new thumbnails, without reading
+ * large template files for computing the key.
+ *
+ * This class is reentrant, so that thumbnails can be provided by background
+ * jobs.
+ */
+class TemplateThumbnailCache
+{
+public:
+	/**
+	 * The maximum size of the thumbnails, in pixels.
+	 */
+	static constexpr QSize maxSize() { return { 128, 64 }; }
+	
+	/**
+	 * Prepares the cache for the template file at the given path.
+	 */
+	explicit TemplateThumbnailCache(const QString& path);
+	
+	/**
+	 * Returns true if the file exists, and a cache key was computed.
+	 */
+	bool isValid() const { return !cache_path.isEmpty(); }
+	
+	/**
+	 * Returns the cached thumbnail, or a null image.
+	 */
+	QImage restoreThumbnail() const;
+	
+	/**
+	 * Stores a thumbnail in the cache.
+	 * 
+	 * Returns true on success.
+	 */
+	bool storeThumbnail(const QImage& thumbnail) const;
+	
+	/**
+	 * Returns the cached thumbnail, or creates and stores it if it is not
+	 * in the cache yet.
+	 * 
+	 * Returns a null image if the file is not a supported image file.
+	 */
+	QImage provideThumbnail() const;
+	
+	/**
+	 * Creates a thumbnail from the image file at the given path.
+	 * 
+	 * Returns a null image if the file cannot be read.
+	 */
+	static QImage createThumbnail(const QString& path);
+	
+private:
+	QString path;
+	QString cache_path;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_TEMPLATE_THUMBNAIL_CACHE_H
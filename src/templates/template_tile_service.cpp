@@ -0,0 +1,617 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "template_tile_service.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include <Qt>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRunnable>
+#include <QSizeF>
+#include <QTransform>
+#include <QUrl>
+
+#if defined(QT_NETWORK_LIB)
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#endif
+
+#include "mapper_config.h"
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "util/disk_cache.h"
+#include "util/util.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * The maximum number of tiles in memory.
+ * 
+ * A tile of 256 x 256 pixels with 32 bits per pixel takes 256 KiB.
+ */
+#ifdef Q_OS_ANDROID
+constexpr int max_tiles = 128;
+#else
+constexpr int max_tiles = 384;
+#endif
+
+/**
+ * The maximum number of tiles to be drawn at once.
+ * 
+ * When the view needs more tiles, a lower zoom level is used.
+ */
+constexpr int max_drawn_tiles = 64;
+
+/**
+ * The highest zoom level which is requested from the service.
+ */
+constexpr int max_zoom = 19;
+
+/**
+ * The number of lower zoom levels which are searched for a fallback tile.
+ */
+constexpr int max_fallback_levels = 6;
+
+/**
+ * The ground resolution of zoom level 0 at the equator, in meters per pixel,
+ * for tiles of 256 pixels.
+ */
+constexpr double zoom_0_resolution = 156543.03392804097;
+
+/**
+ * The latitude limit of the Web Mercator projection.
+ */
+constexpr double max_latitude = 85.05112877980659;
+
+
+/**
+ * Returns the Web Mercator position of the given point, as a fraction of the
+ * world's width and height.
+ */
+QPointF mercatorOf(const LatLon& latlon)
+{
+	auto const latitude = qDegreesToRadians(qBound(-max_latitude, latlon.latitude(), max_latitude));
+	return { (latlon.longitude() + 180.0) / 360.0,
+	         (1.0 - std::log(std::tan(latitude) + 1.0 / std::cos(latitude)) / M_PI) / 2.0 };
+}
+
+/**
+ * Returns the geographic coordinates of the top left corner of a tile.
+ */
+LatLon cornerOf(int zoom, int column, int row)
+{
+	auto const n = std::ldexp(1.0, zoom);
+	return { qRadiansToDegrees(std::atan(std::sinh(M_PI * (1.0 - 2.0 * row / n)))),
+	         column / n * 360.0 - 180.0 };
+}
+
+
+}  // namespace
+
+
+
+// ### TemplateTileService::LoadJob ###
+
+/**
+ * Reads a tile from the disk cache, or stores a downloaded tile there,
+ * and decodes the tile's image on a worker thread.
+ */
+class TemplateTileService::LoadJob : public QRunnable
+{
+public:
+	LoadJob(TemplateTileService& tiles, quint64 key, const QString& path, const QByteArray& data = {})
+	: tiles(tiles)
+	, key(key)
+	, path(path)
+	, data(data)
+	{}
+	
+	void run() override
+	{
+		auto const downloaded = !data.isEmpty();
+		if (downloaded)
+		{
+			if (!DiskCache::write(path, data))
+				qDebug("TemplateTileService: Cannot write %s", qPrintable(path));
+		}
+		else
+		{
+			QFile file(path);
+			if (file.open(QIODevice::ReadOnly))
+				data = file.readAll();
+		}
+		
+		auto image = QImage::fromData(data);
+		if (!image.isNull())
+			image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+		tiles.deliver({ std::move(image), key, downloaded });
+	}
+
+private:
+	TemplateTileService& tiles;
+	quint64 key;
+	QString path;
+	QByteArray data;
+};
+
+
+
+// ### TemplateTileService ###
+
+// static
+bool TemplateTileService::canRead(const QString& path)
+{
+	auto const scheme = QUrl(path).scheme();
+	return (scheme == QLatin1String("http") || scheme == QLatin1String("https"))
+	       && (path.contains(QLatin1String("{z}")) || path.contains(QLatin1String("{TileMatrix}")));
+}
+
+
+TemplateTileService::TemplateTileService(const QString& path, Map* map)
+: Template(path, map)
+{
+	template_path = path;
+	template_file = QUrl(path).host();
+	is_georeferenced = true;
+	workers.setMaxThreadCount(2);
+}
+
+TemplateTileService::TemplateTileService(const TemplateTileService& proto)
+: Template(proto)
+, cache_dir(proto.cache_dir)
+{
+	workers.setMaxThreadCount(2);
+}
+
+TemplateTileService::~TemplateTileService()
+{
+	// Workers deliver to this object.
+	workers.clear();
+	workers.waitForDone();
+}
+
+TemplateTileService* TemplateTileService::duplicate() const
+{
+	return new TemplateTileService(*this);
+}
+
+const char* TemplateTileService::getTemplateType() const
+{
+	return "TemplateTileService";
+}
+
+
+Template::LookupResult TemplateTileService::tryToFindTemplateFile(const QString& /*map_path*/)
+{
+	return FoundByAbsPath;
+}
+
+bool TemplateTileService::fileExists() const
+{
+	return true;
+}
+
+
+bool TemplateTileService::preLoadSetup(QWidget* /*dialog_parent*/)
+{
+	is_georeferenced = true;
+	return true;
+}
+
+
+void TemplateTileService::drawTemplate(QPainter* painter, const QRectF& clip_rect, double /*scale*/, bool on_screen, qreal opacity) const
+{
+	auto const& georef = map->getGeoreferencing();
+	if (georef.getState() != Georeferencing::Geospatial)
+		return;
+	
+	// The clip rect is in map coordinates. The visible area is determined in
+	// Web Mercator coordinates, from the corners and the edge midpoints.
+	auto visible = QRectF();
+	auto any_visible = false;
+	for (auto const& point : { clip_rect.topLeft(), clip_rect.topRight(), clip_rect.bottomRight(), clip_rect.bottomLeft(),
+	                           QPointF(clip_rect.center().x(), clip_rect.top()), QPointF(clip_rect.right(), clip_rect.center().y()),
+	                           QPointF(clip_rect.center().x(), clip_rect.bottom()), QPointF(clip_rect.left(), clip_rect.center().y()) })
+	{
+		bool ok;
+		auto const latlon = georef.toGeographicCoords(MapCoordF(point), &ok);
+		if (!ok)
+			continue;
+		auto const position = mercatorOf(latlon);
+		if (!any_visible)
+			visible = QRectF(position, position);
+		visible.setLeft(std::min(visible.left(), position.x()));
+		visible.setRight(std::max(visible.right(), position.x()));
+		visible.setTop(std::min(visible.top(), position.y()));
+		visible.setBottom(std::max(visible.bottom(), position.y()));
+		any_visible = true;
+	}
+	if (!any_visible)
+		return;
+	
+	// Use the lowest zoom level which still provides at least one tile pixel
+	// per device pixel, but limit the number of tiles.
+	auto const device_scale = std::sqrt(std::abs(painter->combinedTransform().determinant()));
+	if (device_scale <= 0)
+		return;
+	auto const latitude = georef.toGeographicCoords(MapCoordF(clip_rect.center())).latitude();
+	auto const meters_per_pixel = georef.getScaleDenominator() / 1000.0 / device_scale;
+	auto const resolution = zoom_0_resolution * std::cos(qDegreesToRadians(latitude)) / meters_per_pixel;
+	auto zoom = resolution > 1 ? qBound(0, int(std::ceil(std::log2(resolution))), max_zoom) : 0;
+	
+	int first_column, last_column, first_row, last_row;
+	for (;;)
+	{
+		auto const n = 1 << zoom;
+		first_column = qBound(0, int(std::floor(visible.left() * n)), n - 1);
+		last_column  = qBound(0, int(std::floor(visible.right() * n)), n - 1);
+		first_row    = qBound(0, int(std::floor(visible.top() * n)), n - 1);
+		last_row     = qBound(0, int(std::floor(visible.bottom() * n)), n - 1);
+		if (zoom == 0 || (last_column - first_column + 1) * (last_row - first_row + 1) <= max_drawn_tiles)
+			break;
+		--zoom;
+	}
+	
+	// The map positions of the tile corners, shared by neighbouring tiles.
+	auto const columns = last_column - first_column + 2;
+	std::vector<QPointF> corners;
+	std::vector<bool> corners_ok;
+	corners.reserve(std::size_t(columns * (last_row - first_row + 2)));
+	corners_ok.reserve(corners.capacity());
+	for (int row = first_row; row <= last_row + 1; ++row)
+	{
+		for (int column = first_column; column <= last_column + 1; ++column)
+		{
+			bool ok;
+			corners.push_back(georef.toMapCoordF(cornerOf(zoom, column, row), &ok));
+			corners_ok.push_back(ok);
+		}
+	}
+	
+	// Missing tiles are read from the disk cache, and downloaded from the
+	// service, in the background only when drawing on screen.
+	++use_counter;
+	auto const base_transform = painter->transform();
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->setOpacity(opacity);
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int column = first_column; column <= last_column; ++column)
+		{
+			auto const key = keyOf(zoom, column, row);
+			auto& tile = tiles[key];
+			tile.last_used = use_counter;
+			if (!tile.loaded && !tile.pending)
+			{
+				if (on_screen)
+				{
+					tile.pending = true;
+					// The job only delivers to the mutex-protected queue.
+					workers.start(new LoadJob(const_cast<TemplateTileService&>(*this), key, cachePath(zoom, column, row)));
+				}
+				else
+				{
+					tile.image = QImage(cachePath(zoom, column, row));
+					tile.loaded = !tile.image.isNull();
+				}
+			}
+			
+			auto const index = std::size_t((row - first_row) * columns + column - first_column);
+			if (!corners_ok[index] || !corners_ok[index + 1] || !corners_ok[index + std::size_t(columns)] || !corners_ok[index + std::size_t(columns) + 1])
+				continue;
+			
+			const QImage* image = &tile.image;
+			auto source = QRectF(image->rect());
+			if (image->isNull())
+			{
+				// Draw the corresponding part of a lower zoom level tile.
+				auto fallback_zoom = zoom;
+				auto const fallback = findFallback(fallback_zoom, column, row);
+				if (fallback_zoom == zoom)
+					continue;
+				image = &tiles[fallback].image;
+				auto const levels = zoom - fallback_zoom;
+				auto const mask = (1 << levels) - 1;
+				auto const size = QSizeF(image->width(), image->height()) / (1 << levels);
+				source = { QPointF((column & mask) * size.width(), (row & mask) * size.height()), size };
+			}
+			
+			QPolygonF quad;
+			quad << corners[index] << corners[index + 1] << corners[index + std::size_t(columns) + 1] << corners[index + std::size_t(columns)];
+			QPolygonF rect;
+			rect << source.topLeft() << source.topRight() << source.bottomRight() << source.bottomLeft();
+			QTransform transform;
+			if (QTransform::quadToQuad(rect, quad, transform))
+			{
+				painter->setTransform(transform * base_transform);
+				painter->drawImage(source, *image, source);
+			}
+		}
+	}
+	painter->setTransform(base_transform);
+	painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+	
+	trim();
+}
+
+
+QRectF TemplateTileService::getTemplateExtent() const
+{
+	return infiniteRectF();
+}
+
+
+qint64 TemplateTileService::memoryUsage() const
+{
+	auto usage = qint64(0);
+	for (auto const& tile : tiles)
+	{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		usage += qint64(tile.image.sizeInBytes());
+#else
+		usage += qint64(tile.image.byteCount());
+#endif
+	}
+	return usage;
+}
+
+
+bool TemplateTileService::loadTemplateFileImpl()
+{
+	if (!canRead(template_path))
+	{
+		setErrorString(tr("This is not a URL of a tile service."));
+		return false;
+	}
+	if (map->getGeoreferencing().getState() != Georeferencing::Geospatial)
+	{
+		setErrorString(tr("Tile services can only be used with a georeferenced map."));
+		return false;
+	}
+	
+	auto const hash = QCryptographicHash::hash(template_path.toUtf8(), QCryptographicHash::Md5).toHex();
+	cache_dir = DiskCache::entryPath(DiskCache::ServiceTiles, hash);
+	DiskCache::touch(DiskCache::ServiceTiles, cache_dir);
+	DiskCache::scheduleTrim(DiskCache::ServiceTiles);
+	return true;
+}
+
+void TemplateTileService::unloadTemplateFileImpl()
+{
+	workers.clear();
+	workers.waitForDone();
+
+#if defined(QT_NETWORK_LIB)
+	auto const pending = replies.keys();
+	replies.clear();
+	for (auto* reply : pending)
+		reply->abort();
+	network.reset();
+#endif
+
+	tiles.clear();
+	QMutexLocker lock(&mutex);
+	loaded.clear();
+}
+
+
+void TemplateTileService::collectLoadedTiles()
+{
+	std::vector<LoadedTile> results;
+	{
+		QMutexLocker lock(&mutex);
+		results.swap(loaded);
+	}
+	
+	for (auto& result : results)
+	{
+		auto tile = tiles.find(result.key);
+		if (tile == tiles.end())
+			continue;
+
+#if defined(QT_NETWORK_LIB)
+		if (result.image.isNull() && !result.downloaded)
+		{
+			// Not in the disk cache. The tile remains pending.
+			download(result.key);
+			continue;
+		}
+#endif
+
+		tile->pending = false;
+		if (!tile->loaded)
+		{
+			tile->image = std::move(result.image);
+			tile->loaded = true;
+			if (!tile->image.isNull())
+				setTileAreaDirty(result.key);
+		}
+	}
+	
+	trim();
+}
+
+
+// static
+quint64 TemplateTileService::keyOf(int zoom, int column, int row)
+{
+	return (quint64(zoom) << 56) | (quint64(quint32(column)) << 28) | quint32(row);
+}
+
+QString TemplateTileService::tileUrl(int zoom, int column, int row) const
+{
+	auto const z = QString::number(zoom);
+	auto const x = QString::number(column);
+	auto const y = QString::number(row);
+	auto url = template_path;
+	url.replace(QLatin1String("{z}"), z)
+	   .replace(QLatin1String("{x}"), x)
+	   .replace(QLatin1String("{y}"), y)
+	   .replace(QLatin1String("{-y}"), QString::number((1 << zoom) - 1 - row))
+	   .replace(QLatin1String("{TileMatrix}"), z)
+	   .replace(QLatin1String("{TileCol}"), x)
+	   .replace(QLatin1String("{TileRow}"), y);
+	return url;
+}
+
+QString TemplateTileService::cachePath(int zoom, int column, int row) const
+{
+	return cache_dir + QLatin1Char('/') + QString::number(zoom)
+	       + QLatin1Char('/') + QString::number(column)
+	       + QLatin1Char('/') + QString::number(row);
+}
+
+quint64 TemplateTileService::findFallback(int& zoom, int column, int row) const
+{
+	for (int levels = 1; levels <= max_fallback_levels && levels <= zoom; ++levels)
+	{
+		auto const key = keyOf(zoom - levels, column >> levels, row >> levels);
+		auto const tile = tiles.find(key);
+		if (tile != tiles.end() && !tile->image.isNull())
+		{
+			tile->last_used = use_counter;
+			zoom -= levels;
+			return key;
+		}
+	}
+	return 0;
+}
+
+
+#if defined(QT_NETWORK_LIB)
+
+void TemplateTileService::download(quint64 key)
+{
+	if (!network)
+		network = std::make_unique<QNetworkAccessManager>();
+	
+	auto const zoom = int(key >> 56);
+	auto const column = int((key >> 28) & 0xfffffff);
+	auto const row = int(key & 0xfffffff);
+	QNetworkRequest request(QUrl(tileUrl(zoom, column, row)));
+	// Tile usage policies require an identifying user agent.
+	request.setRawHeader("User-Agent", "OpenOrienteering Mapper " APP_VERSION);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+	request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#endif
+	auto* reply = network->get(request);
+	replies.insert(reply, key);
+	connect(reply, &QNetworkReply::finished, this, [this, reply]() { downloadFinished(reply); });
+}
+
+void TemplateTileService::downloadFinished(QNetworkReply* reply)
+{
+	reply->deleteLater();
+	auto const entry = replies.find(reply);
+	if (entry == replies.end())
+		return;
+	
+	auto const key = entry.value();
+	replies.erase(entry);
+	auto tile = tiles.find(key);
+	if (tile == tiles.end())
+		return;
+	
+	auto const data = reply->readAll();
+	if (reply->error() != QNetworkReply::NoError || data.isEmpty())
+	{
+		qDebug("TemplateTileService: %s", qPrintable(reply->errorString()));
+		tile->pending = false;
+		tile->loaded = true;
+		return;
+	}
+	
+	auto const zoom = int(key >> 56);
+	auto const column = int((key >> 28) & 0xfffffff);
+	auto const row = int(key & 0xfffffff);
+	workers.start(new LoadJob(*this, key, cachePath(zoom, column, row), data));
+}
+
+#endif
+
+
+void TemplateTileService::setTileAreaDirty(quint64 key)
+{
+	auto const zoom = int(key >> 56);
+	auto const column = int((key >> 28) & 0xfffffff);
+	auto const row = int(key & 0xfffffff);
+	auto const& georef = map->getGeoreferencing();
+	QRectF area;
+	for (auto const& corner : { cornerOf(zoom, column, row), cornerOf(zoom, column + 1, row),
+	                            cornerOf(zoom, column + 1, row + 1), cornerOf(zoom, column, row + 1) })
+	{
+		bool ok;
+		auto const point = georef.toMapCoordF(corner, &ok);
+		if (ok)
+			rectIncludeSafe(area, point);
+	}
+	if (area.isValid())
+		map->setTemplateAreaDirty(this, area, 1);
+}
+
+void TemplateTileService::trim() const
+{
+	if (tiles.size() <= max_tiles)
+		return;
+	
+	// Tiles which are pending or which were used in the last draw are kept.
+	std::vector<std::pair<quint64, quint64>> candidates;
+	candidates.reserve(std::size_t(tiles.size()));
+	for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		if (!tile->pending && tile->last_used != use_counter)
+			candidates.emplace_back(tile->last_used, tile.key());
+	}
+	auto const count = std::min(candidates.size(), std::size_t(tiles.size() - max_tiles));
+	std::partial_sort(candidates.begin(), candidates.begin() + std::ptrdiff_t(count), candidates.end());
+	for (std::size_t i = 0; i < count; ++i)
+		tiles.remove(candidates[i].second);
+}
+
+void TemplateTileService::deliver(LoadedTile&& tile)
+{
+	QMutexLocker lock(&mutex);
+	auto const first = loaded.empty();
+	loaded.push_back(std::move(tile));
+	if (first)
+		QMetaObject::invokeMethod(this, "collectLoadedTiles", Qt::QueuedConnection);
+}
+
+
+}  // namespace OpenOrienteering
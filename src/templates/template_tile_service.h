@@ -0,0 +1,188 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TEMPLATE_TILE_SERVICE_H
+#define OPENORIENTEERING_TEMPLATE_TILE_SERVICE_H
+
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QRectF>
+#include <QString>
+#include <QThreadPool>
+
+#include "templates/template.h"
+
+class QByteArray;
+class QNetworkAccessManager;
+class QNetworkReply;
+class QPainter;
+class QWidget;
+
+class TemplateTest;
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * A template showing the tiles of a web map tile service.
+ * 
+ * The template path is a URL pattern for the tiles of the service, e.g.
+ * "https://tile.example.org/{z}/{x}/{y}.png". The XYZ placeholders {z}, {x},
+ * {y} are supported, {-y} for services using TMS row numbering, and the
+ * WMTS placeholders {TileMatrix}, {TileCol}, {TileRow}. The tiles must follow
+ * the Web Mercator tiling scheme ("GoogleMapsCompatible").
+ * 
+ * The template is always georeferenced, and it needs a map with geospatial
+ * georeferencing. Each tile is placed on the map by the map coordinates of its
+ * corners, so the tiles are reprojected to the map's CRS.
+ * 
+ * Only the tiles for the visible area are requested, at the zoom level which
+ * matches the current view. Downloaded tiles are kept in a persistent cache on
+ * disk, and a bounded number of decoded tiles is kept in memory, dropping the
+ * least recently used tiles first. Until a tile is available, a lower zoom
+ * level tile from memory is drawn instead.
+ */
+class TemplateTileService : public Template
+{
+Q_OBJECT
+public:
+	/**
+	 * Returns true if the given path looks like a tile service URL pattern.
+	 */
+	static bool canRead(const QString& path);
+	
+	TemplateTileService(const QString& path, Map* map);
+protected:
+	TemplateTileService(const TemplateTileService& proto);
+public:
+	TemplateTileService() = delete;
+	TemplateTileService(TemplateTileService&&) = delete;
+	
+	~TemplateTileService() override;
+	
+	TemplateTileService& operator=(const TemplateTileService&) = delete;
+	TemplateTileService& operator=(TemplateTileService&&) = delete;
+	
+	TemplateTileService* duplicate() const override;
+	
+	const char* getTemplateType() const override;
+	bool isRasterGraphics() const override { return true; }
+	
+	/** Always succeeds: there is no file to be found. */
+	LookupResult tryToFindTemplateFile(const QString& map_path) override;
+	
+	/** Always returns true: the tiles come from the service. */
+	bool fileExists() const override;
+	
+	bool preLoadSetup(QWidget* dialog_parent) override;
+	
+	void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const override;
+	
+	/** As the service covers the whole world, returns a very large rectangle. */
+	QRectF getTemplateExtent() const override;
+	
+	qint64 memoryUsage() const override;
+
+
+protected:
+	bool loadTemplateFileImpl() override;
+	
+	void unloadTemplateFileImpl() override;
+
+
+private slots:
+	/** Moves the tiles read by the workers into the memory cache. */
+	void collectLoadedTiles();
+
+private:
+	class LoadJob;
+	
+	struct Tile
+	{
+		QImage image;
+		quint64 last_used = 0;  ///< The value of use_counter when the tile was last drawn.
+		bool loaded = false;    ///< Set when the image is final, even if null after an error.
+		bool pending = false;   ///< Set while the tile is read or downloaded.
+	};
+	
+	struct LoadedTile
+	{
+		QImage image;
+		quint64 key;
+		bool downloaded;  ///< Set if the data came from the service, not from the disk cache.
+	};
+	
+	static quint64 keyOf(int zoom, int column, int row);
+	
+	/** Returns the URL of a tile, by substituting the placeholders. */
+	QString tileUrl(int zoom, int column, int row) const;
+	
+	/** Returns the path of a tile in the disk cache. */
+	QString cachePath(int zoom, int column, int row) const;
+	
+	/** Returns the key of a tile which is in memory and covers the given tile. */
+	quint64 findFallback(int& zoom, int column, int row) const;
+
+#if defined(QT_NETWORK_LIB)
+	/** Requests a tile from the service, after it was not found on disk. */
+	void download(quint64 key);
+	
+	/** Stores and decodes a downloaded tile. */
+	void downloadFinished(QNetworkReply* reply);
+#endif
+
+	/** Marks the map area of the given tile as dirty. */
+	void setTileAreaDirty(quint64 key);
+	
+	/** Drops the least recently used tiles when there are too many. */
+	void trim() const;
+	
+	/** Receives a tile from a worker thread. */
+	void deliver(LoadedTile&& tile);
+	
+	
+	QString cache_dir;
+	mutable QHash<quint64, Tile> tiles;
+	mutable quint64 use_counter = 0;
+	
+	mutable QThreadPool workers;
+	QMutex mutex;  ///< Protects loaded.
+	std::vector<LoadedTile> loaded;
+
+#if defined(QT_NETWORK_LIB)
+	std::unique_ptr<QNetworkAccessManager> network;
+	QHash<QNetworkReply*, quint64> replies;  ///< The pending downloads and their tiles.
+#endif
+	
+	friend class ::TemplateTest;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_TEMPLATE_TILE_SERVICE_H
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,12 @@
 
 #include "template_track.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 #include <utility>
 
 #include <Qt>
@@ -35,9 +41,11 @@
 #include <QLatin1String>
 #include <QMessageBox>
 #include <QPainter>
-#include <QPainterPath>
 #include <QPen>
+#include <QPointF>
+#include <QPolygonF>
 #include <QRect>
+#include <QRectF>
 #include <QRgb>
 #include <QSize>
 #include <QStringRef>
@@ -67,6 +75,55 @@ class Symbol;
 
 namespace {
 
+/// The maximum number of points in a TrackPiece.
+constexpr std::size_t piece_size = 1024;
+
+/// The decimation tolerance of level 0, in template units.
+constexpr double min_tolerance = 0.001;
+
+/// The maximum number of decimation levels which are cached at a time.
+constexpr std::size_t max_cached_levels = 8;
+
+/**
+ * Returns true if the rectangles overlap, including touching edges.
+ * 
+ * Unlike QRectF::intersects(), this also works for rectangles with zero
+ * width or height, as they are common for straight tracks.
+ */
+bool overlaps(const QRectF& a, const QRectF& b)
+{
+	return a.left() <= b.right() && b.left() <= a.right()
+	       && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+/**
+ * Returns the polyline through the given points, dropping points which are
+ * closer than tolerance to the previous remaining point.
+ * 
+ * The first and the last point are always kept.
+ */
+QPolygonF decimate(const MapCoordF* points, std::size_t count, double tolerance)
+{
+	QPolygonF result;
+	if (count == 0)
+		return result;
+	
+	auto const tolerance_sq = tolerance * tolerance;
+	result.reserve(int(count));
+	result.append(points[0]);
+	for (std::size_t i = 1; i + 1 < count; ++i)
+	{
+		auto const delta = points[i] - result.back();
+		if (delta.x() * delta.x() + delta.y() * delta.y() >= tolerance_sq)
+			result.append(points[i]);
+	}
+	if (count > 1)
+		result.append(points[count - 1]);
+	result.squeeze();
+	return result;
+}
+
+
 const MapColor& makeTrackColor(Map& map)
 {
 	auto* track_color = new MapColor(QLatin1String{"Purple"}, 0); 
@@ -263,8 +320,18 @@ bool TemplateTrack::loadTemplateFileImpl()
 		return false;
 	}
 	
-	if (!track.loadFrom(template_path, false))
+	auto data = std::move(track_data);
+	track_data.reset();
+	if (data && data->path == template_path)
+	{
+		if (!data->valid)
+			return false;
+		track = data->track;
+	}
+	else if (!track.loadFrom(template_path, false))
+	{
 		return false;
+	}
 	
 	if (getTemplateState() != Configuring)
 	{
@@ -284,6 +351,19 @@ bool TemplateTrack::loadTemplateFileImpl()
 	return true;
 }
 
+std::function<void ()> TemplateTrack::makeFileReader()
+{
+	if (preserved_georef
+	    || (!track_crs_spec.isEmpty() && track_crs_spec != Georeferencing::geographic_crs_spec))
+		return {};  // loadTemplateFileImpl() reports the error.
+	
+	// The track is created on this thread, but filled on the worker.
+	auto data = std::make_shared<TrackData>();
+	data->path = template_path;
+	track_data = data;
+	return [data]() { data->valid = data->track.loadFrom(data->path, false); };
+}
+
 bool TemplateTrack::postLoadSetup(QWidget* dialog_parent, bool& /*out_center_in_view*/)
 {
 	is_georeferenced = true;
@@ -346,20 +426,29 @@ void TemplateTrack::unloadTemplateFileImpl()
 	track.clear();
 }
 
-void TemplateTrack::drawTemplate(QPainter* painter, const QRectF& /*clip_rect*/, double /*scale*/, bool on_screen, qreal opacity) const
+void TemplateTrack::drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, qreal opacity) const
 {
 	painter->save();
 	painter->setOpacity(opacity);
-	drawTracks(painter, on_screen);
+	drawTracks(painter, clip_rect, scale, on_screen);
 	drawWaypoints(painter);
 	painter->restore();
 }
 
-void TemplateTrack::drawTracks(QPainter* painter, bool on_screen) const
+void TemplateTrack::drawTracks(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen) const
 {
 	painter->save();
+	
+	// The clip rect is in map coordinates, the track is in template coordinates.
+	auto visible = clip_rect;
 	if (!is_georeferenced)
+	{
 		applyTemplateTransform(painter);
+		QPolygonF corners;
+		for (auto const& corner : { clip_rect.topLeft(), clip_rect.topRight(), clip_rect.bottomRight(), clip_rect.bottomLeft() })
+			corners.append(mapToTemplate(MapCoordF(corner)));
+		visible = corners.boundingRect();
+	}
 	
 	// Tracks
 	QPen pen(qRgb(212, 0, 244));
@@ -370,24 +459,81 @@ void TemplateTrack::drawTracks(QPainter* painter, bool on_screen) const
 	painter->setPen(pen);
 	painter->setBrush(Qt::NoBrush);
 	
-	// TODO: could speed that up by storing the template coords of the GPS points in a separate vector or caching the painter paths
+	// On screen, deviations of about 0.1 mm at 100% zoom are not visible.
+	// Level -1 means no decimation.
+	auto level = -1;
+	if (on_screen && scale > 0)
+	{
+		auto const tolerance = 0.1 / scale;
+		if (tolerance >= 2 * min_tolerance)
+			level = int(std::floor(std::log2(tolerance / min_tolerance)));
+	}
+	
+	updateTrackPieces();
+	for (std::size_t i = 0; i < track_pieces.size(); ++i)
+	{
+		if (overlaps(track_pieces[i].extent, visible))
+			painter->drawPolyline(decimatedPiece(i, level));
+	}
+	
+	painter->restore();
+}
+
+void TemplateTrack::updateTrackPieces() const
+{
+	if (pieces_valid && pieces_revision == track.revision())
+		return;
+	
+	track_pieces.clear();
+	decimated_pieces.clear();
+	
+	auto const& map_coords = track.segmentPoints().mapCoords();
 	for (int i = 0; i < track.getNumSegments(); ++i)
 	{
-		QPainterPath path;
-		int size = track.getSegmentPointCount(i);
-		for (int k = 0; k < size; ++k)
+		auto first = std::size_t(track.getSegmentStart(i));
+		auto const end = first + std::size_t(track.getSegmentPointCount(i));
+		// Consecutive pieces share a point, so that there are no gaps.
+		while (first + 1 < end)
 		{
-			const TrackPoint& point = track.getSegmentPoint(i, k);
-			
-			if (k > 0)
-				path.lineTo(point.map_coord.x(), point.map_coord.y());
-			else
-				path.moveTo(point.map_coord.x(), point.map_coord.y());
+			auto const count = std::min(piece_size, end - first);
+			auto min_x = map_coords[first].x();
+			auto max_x = min_x;
+			auto min_y = map_coords[first].y();
+			auto max_y = min_y;
+			for (auto j = first + 1; j < first + count; ++j)
+			{
+				min_x = std::min(min_x, map_coords[j].x());
+				max_x = std::max(max_x, map_coords[j].x());
+				min_y = std::min(min_y, map_coords[j].y());
+				max_y = std::max(max_y, map_coords[j].y());
+			}
+			track_pieces.push_back({ QRectF(QPointF(min_x, min_y), QPointF(max_x, max_y)), first, count });
+			first += count - 1;
 		}
-		painter->drawPath(path);
 	}
 	
-	painter->restore();
+	pieces_revision = track.revision();
+	pieces_valid = true;
+}
+
+const QPolygonF& TemplateTrack::decimatedPiece(std::size_t index, int level) const
+{
+	auto found = decimated_pieces.find(level);
+	if (found == decimated_pieces.end())
+	{
+		if (decimated_pieces.size() >= max_cached_levels)
+			decimated_pieces.clear();
+		found = decimated_pieces.emplace(level, std::vector<QPolygonF>(track_pieces.size())).first;
+	}
+	
+	auto& polyline = found->second[index];
+	if (polyline.isEmpty())
+	{
+		auto const& piece = track_pieces[index];
+		auto const tolerance = level < 0 ? 0.0 : std::ldexp(min_tolerance, level);
+		polyline = decimate(track.segmentPoints().mapCoords().data() + piece.first, piece.count, tolerance);
+	}
+	return polyline;
 }
 
 void TemplateTrack::drawWaypoints(QPainter* painter) const
@@ -445,15 +591,9 @@ QRectF TemplateTrack::calculateTemplateBoundingBox() const
 		MapCoordF point = track_point.map_coord;
 		rectIncludeSafe(bbox, is_georeferenced ? point : templateToMap(point));
 	}
-	for (int i = 0; i < track.getNumSegments(); ++i)
+	for (auto const& point : track.segmentPoints().mapCoords())
 	{
-		size = track.getSegmentPointCount(i);
-		for (int k = 0; k < size; ++k)
-		{
-			const TrackPoint& track_point = track.getSegmentPoint(i, k);
-			MapCoordF point = track_point.map_coord;
-			rectIncludeSafe(bbox, is_georeferenced ? point : templateToMap(point));
-		}
+		rectIncludeSafe(bbox, is_georeferenced ? point : templateToMap(point));
 	}
 	
 	return bbox;
@@ -466,6 +606,38 @@ int TemplateTrack::getTemplateBoundingBoxPixelBorder() const
 	return 10e8;
 }
 
+void TemplateTrack::setTrackAreaDirty(std::size_t first_point)
+{
+	auto const& map_coords = track.segmentPoints().mapCoords();
+	if (first_point > map_coords.size())
+	{
+		// Not an append
+		setTemplateAreaDirty();
+		return;
+	}
+	if (first_point == map_coords.size())
+		return;
+	
+	// The line to the preceding point is new, too, and the decimated
+	// polyline of the piece containing this point may change.
+	updateTrackPieces();
+	auto first = first_point > 0 ? first_point - 1 : first_point;
+	auto const piece = std::find_if(track_pieces.rbegin(), track_pieces.rend(), [first](const TrackPiece& piece) {
+		return piece.first <= first;
+	});
+	if (piece != track_pieces.rend())
+		first = std::min(first, piece->first);
+	
+	QRectF area;
+	for (auto i = first; i < map_coords.size(); ++i)
+	{
+		auto const& point = map_coords[i];
+		rectIncludeSafe(area, is_georeferenced ? point : templateToMap(point));
+	}
+	// The track is drawn with a thin cosmetic pen.
+	map->setTemplateAreaDirty(this, area, 2);
+}
+
 
 bool TemplateTrack::hasAlpha() const
 {
@@ -543,14 +715,18 @@ bool TemplateTrack::import(QWidget* dialog_parent)
 			continue; // Don't create path without objects.
 		}
 		
+		auto const first = std::size_t(track.getSegmentStart(i));
+		auto const last = first + std::size_t(segment_size) - 1;
+		auto const& map_coords = track.segmentPoints().mapCoords();
 		MapCoordVector coords;
 		coords.reserve(MapCoordVector::size_type(segment_size));
-		for (int j = 0; j < segment_size; j++)
-			coords.push_back(MapCoord(templateToMap(track.getSegmentPoint(i, j).map_coord)));
+		for (auto j = first; j <= last; j++)
+			coords.push_back(MapCoord(templateToMap(map_coords[j])));
 		
 		if (auto* path = importPath(*map, track_symbol, std::move(coords)))
 		{
-			if (track.getSegmentPoint(i, 0).latlon == track.getSegmentPoint(i, segment_size-1).latlon)
+			auto const& latlon = track.segmentPoints().latLon();
+			if (latlon[first] == latlon[last])
 				path->closeAllParts();
 			result.push_back(path);
 		}
@@ -590,6 +766,9 @@ void TemplateTrack::configureForGPSTrack()
 
 void TemplateTrack::updateGeoreferencing()
 {
+	if (map->isSettingGeoreferencing())
+		return;  // Called again when done
+	
 	if (is_georeferenced && template_state == Template::Loaded)
 	{
 		projected_crs_spec.clear();
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020 Kai Pastor
+ *    Copyright 2013-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,11 +22,15 @@
 #ifndef OPENORIENTEERING_TEMPLATE_TRACK_H
 #define OPENORIENTEERING_TEMPLATE_TRACK_H
 
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <vector>
 
 #include <QtGlobal>
 #include <QObject>
+#include <QPolygonF>
 #include <QRectF>
 #include <QString>
 
@@ -84,10 +88,25 @@ public:
 	QRectF calculateTemplateBoundingBox() const override;
 	int getTemplateBoundingBoxPixelBorder() const override;
 	
+	/**
+	 * Marks only the area of the track points from first_point to the end
+	 * as dirty.
+	 * 
+	 * This is meant for points which were appended to the track. Unlike
+	 * setTemplateAreaDirty(), it doesn't invalidate the waypoints and the
+	 * rest of the track.
+	 */
+	void setTrackAreaDirty(std::size_t first_point);
+	
 	bool hasAlpha() const override;
 	
-	/// Draws all tracks.
-	void drawTracks(QPainter* painter, bool on_screen) const;
+	/**
+	 * Draws the tracks which intersect the clip rect.
+	 * 
+	 * On screen, the tracks are drawn from cached polylines which are
+	 * decimated according to the scale.
+	 */
+	void drawTracks(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen) const;
 	
 	/// Draws all waypoints.
 	void drawWaypoints(QPainter* painter) const;
@@ -103,8 +122,7 @@ public:
 	/// Returns the Track data object.
 	inline Track& getTrack() {return track;}
 	
-public slots:
-	void updateGeoreferencing();
+	void updateGeoreferencing() override;
 	
 protected:
 	void saveTypeSpecificTemplateConfiguration(QXmlStreamWriter& xml) const override;
@@ -115,12 +133,53 @@ protected:
 	
 	void applyProjectedCrsSpec();
 	
+	std::function<void ()> makeFileReader() override;
+	
 private:
+	/**
+	 * Track data which is read from the template file on a worker thread.
+	 */
+	struct TrackData
+	{
+		QString path;
+		Track track;
+		bool valid = false;
+	};
+	
+	/**
+	 * A consecutive range of track points, with their bounding box.
+	 * 
+	 * Track segments are split into pieces of limited size, so that parts
+	 * of long segments outside the view can be skipped.
+	 */
+	struct TrackPiece
+	{
+		QRectF extent;
+		std::size_t first;
+		std::size_t count;
+	};
+	
+	/**
+	 * Rebuilds the pieces when the track was changed.
+	 */
+	void updateTrackPieces() const;
+	
+	/**
+	 * Returns the polyline of the piece, decimated for the given level.
+	 */
+	const QPolygonF& decimatedPiece(std::size_t index, int level) const;
+	
 	Track track;
+	mutable std::vector<TrackPiece> track_pieces;
+	mutable std::map<int, std::vector<QPolygonF>> decimated_pieces;  // by level
+	mutable unsigned int pieces_revision = 0;
+	mutable bool pieces_valid = false;
 	QString track_crs_spec;
 	QString projected_crs_spec;
 	friend class OgrTemplate; // for migration
 	std::unique_ptr<Georeferencing> preserved_georef;
+	/// Data read on a worker thread, to be taken by loadTemplateFileImpl().
+	std::shared_ptr<TrackData> track_data;
 };
 
 
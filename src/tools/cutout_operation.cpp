@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013, 2014, 2017-2019 Kai Pastor
+ *    Copyright 2013, 2014, 2017-2019, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,7 @@
 #include "cutout_operation.h"
 
 // IWYU pragma: no_include <algorithm>
+#include <cstddef>
 #include <iterator>
 #include <vector>
 
@@ -59,34 +60,76 @@ CutoutOperation::~CutoutOperation()
 
 
 void CutoutOperation::operator()(Object* object)
+{
+	if (!isApplicable(object))
+		return;
+	
+	out_objects.clear();
+	if (cut(object, out_objects))
+	{
+		add_step->addObject(object, object);
+		new_objects.insert(end(new_objects), begin(out_objects), end(out_objects));
+	}
+}
+
+
+void CutoutOperation::applyOnCurrentPart()
+{
+	struct Result
+	{
+		BooleanTool::PathObjects out_objects;
+		bool replace = false;
+	};
+	
+	auto* part = map->getCurrentPart();
+	std::vector<Result> results(std::size_t(part->getNumObjects()));
+	
+	// The workers read the cutout object's extent and path coords.
+	cutout_object->update();
+	part->applyOnMatchingObjectsConcurrently([this, &results](Object* object, MapPart* /*part*/, int index) {
+		auto& result = results[std::size_t(index)];
+		result.replace = cut(object, result.out_objects);
+	}, [this](const Object* object) { return isApplicable(object); });
+	
+	// Merge the results in the order of applyOnAllObjects().
+	for (auto index = int(results.size()); index > 0; )
+	{
+		--index;
+		auto& result = results[std::size_t(index)];
+		if (result.replace)
+		{
+			add_step->addObject(index, part->getObject(index));
+			new_objects.insert(end(new_objects), begin(result.out_objects), end(result.out_objects));
+		}
+	}
+}
+
+
+bool CutoutOperation::isApplicable(const Object* object) const
 {
 	// If there is a selection, only clip selected objects
 	if (!map->selectedObjects().empty() && !map->isObjectSelected(object))
-		return;
+		return false;
 	
 	// Don't clip object itself
-	if (object == cutout_object)
-		return;
-	
+	return object != cutout_object;
+}
+
+
+bool CutoutOperation::cut(Object* object, BooleanTool::PathObjects& out_objects) const
+{
 	// Early out
 	if (!object->getExtent().intersects(cutout_object->getExtent()))
-	{
-		if (!cut_away)
-			add_step->addObject(object, object);
-		return;
-	}
+		return !cut_away;
 	
 	switch (object->getType())
 	{
 	case Object::Point:
 	case Object::Text:
 		// Simple check if the (first) point is inside the area
-		if (cutout_object->isPointInsideArea(MapCoordF(object->getRawCoordinateVector().at(0))) == cut_away)
-			add_step->addObject(object, object);
-		break;
+		return cutout_object->isPointInsideArea(MapCoordF(object->getRawCoordinateVector().at(0))) == cut_away;
 		
 	case Object::Path:
-		out_objects.clear();
 		if (object->getSymbol()->getContainedTypes() & Symbol::Area)
 		{
 			// Use the Clipper library to clip the area
@@ -94,20 +137,17 @@ void CutoutOperation::operator()(Object* object)
 			in_objects.push_back(cutout_object);
 			in_objects.push_back(object->asPath());
 			if (!boolean_tool.executeForObjects(object->asPath(), in_objects, out_objects))
-				break;
+				return false;
 		}
 		else
 		{
 			// Use some custom code to clip the line
 			boolean_tool.executeForLine(cutout_object, object->asPath(), out_objects);
 		}
-		
-		add_step->addObject(object, object);
-		new_objects.insert(end(new_objects), begin(out_objects), end(out_objects));
-		break;
+		return true;
 	}
 	
-	return;
+	return false;
 }
 
 
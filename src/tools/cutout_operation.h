@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013, 2014, 2017-2019 Kai Pastor
+ *    Copyright 2013, 2014, 2017-2019, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -79,6 +79,14 @@ public:
 	 */
 	void operator()(Object* object);
 	
+	/**
+	 * Applies the configured cutting operation on all objects of the current map part.
+	 * 
+	 * The objects are clipped concurrently. The results are merged in the
+	 * same order as when applying operator() via MapPart::applyOnAllObjects().
+	 */
+	void applyOnCurrentPart();
+	
 	/**
 	 * Commits the changes.
 	 * 
@@ -88,6 +96,20 @@ public:
 	void commit();
 	
 private:
+	/**
+	 * Returns true if the operation is to be applied on the given object.
+	 */
+	bool isApplicable(const Object* object) const;
+	
+	/**
+	 * Clips the given object.
+	 * 
+	 * Returns true if the object is to be replaced by the out_objects.
+	 * This function does not modify the map, and it can be called
+	 * concurrently for different objects.
+	 */
+	bool cut(Object* object, BooleanTool::PathObjects& out_objects) const;
+	
 	UndoStep* finish();
 	
 	Map* map;
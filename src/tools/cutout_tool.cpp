@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013-2019 Kai Pastor
+ *    Copyright 2013-2019, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,8 +21,6 @@
 
 #include "cutout_tool.h"
 
-#include <functional>
-
 #include <Qt>
 #include <QtGlobal>
 #include <QCursor>
@@ -188,7 +186,7 @@ void CutoutTool::dragFinish()
 void CutoutTool::apply(Map* map, PathObject* cutout_object, bool cut_away)
 {
 	CutoutOperation operation(map, cutout_object, cut_away);
-	map->getCurrentPart()->applyOnAllObjects(std::ref(operation));
+	operation.applyOnCurrentPart();
 	operation.commit();
 }
 
@@ -21,6 +21,8 @@
 
 #include "draw_freehand_tool.h"
 
+#include <algorithm>
+
 #include <Qt>
 #include <QCursor>
 #include <QKeyEvent>
@@ -32,14 +34,53 @@
 #include "core/map.h"
 #include "core/map_view.h"
 #include "core/objects/object.h"
+#include "core/renderables/renderable.h"
+#include "core/symbols/symbol.h"
 #include "gui/modifier_key.h"
 #include "gui/map/map_editor.h"
 #include "gui/map/map_widget.h"
 #include "tools/tool.h"
+#include "util/util.h"
 
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The maximum number of samples which are checked for each new sample
+constexpr std::size_t max_pending_samples = 100;
+
+/// The number of points which are collected in the tail before moving them
+/// to the preview path
+constexpr std::size_t max_tail_points = 32;
+
+
+/**
+ * Returns the squared distance of coord from the line segment between
+ * start_coord and end_coord.
+ */
+qreal distanceSquaredToSegment(const MapCoordF& coord, const MapCoordF& start_coord, const MapCoordF& end_coord)
+{
+	auto tangent = end_coord - start_coord;
+	tangent.normalize();
+	
+	const auto to_coord = coord - start_coord;
+	auto dist_along_line = MapCoordF::dotProduct(to_coord, tangent);
+	if (dist_along_line <= 0)
+		return to_coord.lengthSquared();
+	
+	if (dist_along_line >= end_coord.distanceTo(start_coord))
+		return coord.distanceSquaredTo(end_coord);
+	
+	auto distance = qAbs(MapCoordF::dotProduct(tangent.perpRight(), to_coord));
+	return distance * distance;
+}
+
+
+}  // namespace
+
+
+
 DrawFreehandTool::DrawFreehandTool(MapEditorController* editor, QAction* tool_action, bool is_helper_tool)
 : DrawLineAndAreaTool(editor, DrawFreehand, tool_action, is_helper_tool)
 {
@@ -47,7 +88,10 @@ DrawFreehandTool::DrawFreehandTool(MapEditorController* editor, QAction* tool_ac
 }
 
 
-DrawFreehandTool::~DrawFreehandTool() = default;
+DrawFreehandTool::~DrawFreehandTool()
+{
+	delete tail_path;
+}
 
 
 void DrawFreehandTool::init()
@@ -77,6 +121,18 @@ bool DrawFreehandTool::mousePressEvent(QMouseEvent* event, const MapCoordF& map_
 		
 		startDrawing();
 		preview_path->addCoordinate(MapCoord(cur_pos_map));
+		pending.assign(1, cur_pos_map);
+		
+		// Use 999 instead of 1000, and save the rounding.
+		split_distance_sq = editor->getMainWidget()->getMapView()->pixelToLength(1) / 999;
+		split_distance_sq *= split_distance_sq;
+		
+		// An area cannot be drawn in pieces.
+		if (!drawing_symbol || !(drawing_symbol->getContainedTypes() & Symbol::Area))
+		{
+			tail_path = new PathObject(path_combination.get());
+			tail_path->addCoordinate(MapCoord(cur_pos_map));
+		}
 		hidePreviewPoints();
 		return true;
 	}
@@ -109,7 +165,7 @@ bool DrawFreehandTool::mouseReleaseEvent(QMouseEvent* event, const MapCoordF& ma
 	
 	if (event->button() == Qt::LeftButton && editingInProgress())
 	{	
-		if (preview_path->getCoordinateCount() < 2)
+		if (pending.size() < 2)
 		{
 			abortDrawing();
 			return true;
@@ -155,13 +211,13 @@ void DrawFreehandTool::finishDrawing()
 {
 	updateStatusText();
 	
-	// Clean up path: remove superfluous points
+	mergeTail();
+	pending.clear();
+	
+	// Clean up path: remove superfluous points which were kept
+	// before the simplification could see the following samples
 	if (preview_path->getCoordinateCount() > 2)
 	{
-		// Use 999 instead of 1000, and save the rounding.
-		split_distance_sq = editor->getMainWidget()->getMapView()->pixelToLength(1) / 999;
-		split_distance_sq *= split_distance_sq;
-		
 		point_mask.assign(preview_path->getCoordinateCount(), false);
 		point_mask.front() = true;
 		point_mask.back() = true;
@@ -184,6 +240,14 @@ void DrawFreehandTool::abortDrawing()
 {
 	updateStatusText();
 	
+	if (tail_path)
+	{
+		renderables->removeRenderablesOfObject(tail_path, false);
+		delete tail_path;
+		tail_path = nullptr;
+	}
+	pending.clear();
+	
 	DrawLineAndAreaTool::abortDrawing();
 }
 
@@ -203,32 +267,11 @@ void DrawFreehandTool::checkLineSegment(std::size_t first, std::size_t last)
 		auto max_distance_sq = qreal(0);
 		const auto start_coord = MapCoordF(preview_path->getRawCoordinateVector()[first]);
 		const auto end_coord = MapCoordF(preview_path->getRawCoordinateVector()[last]);
-		auto tangent = end_coord - start_coord;
-		tangent.normalize();
 		
 		for (auto i = first + 1; i < last; ++i)
 		{
 			const auto coord = MapCoordF(preview_path->getRawCoordinateVector()[i]);
-			const auto to_coord = coord - start_coord;
-			
-			qreal distance_sq;
-			
-			auto dist_along_line = MapCoordF::dotProduct(to_coord, tangent);
-			if (dist_along_line <= 0)
-			{
-				distance_sq = to_coord.lengthSquared();
-			}
-			else if (dist_along_line >= end_coord.distanceTo(start_coord))
-			{
-				distance_sq = coord.distanceSquaredTo(end_coord);
-			}
-			else
-			{
-				auto right = tangent.perpRight();
-				distance_sq = qAbs(MapCoordF::dotProduct(right, to_coord));
-				distance_sq = distance_sq*distance_sq;
-			}
-			
+			auto const distance_sq = distanceSquaredToSegment(coord, start_coord, end_coord);
 			if (distance_sq > max_distance_sq)
 			{
 				max_distance_sq = distance_sq;
@@ -248,15 +291,81 @@ void DrawFreehandTool::checkLineSegment(std::size_t first, std::size_t last)
 
 
 
+bool DrawFreehandTool::pendingSamplesFitLine() const
+{
+	if (pending.size() > max_pending_samples)
+		return false;
+	
+	auto const& start_coord = pending.front();
+	auto const& end_coord = pending.back();
+	return std::all_of(begin(pending) + 1, end(pending) - 1, [&](const MapCoordF& coord) {
+		return distanceSquaredToSegment(coord, start_coord, end_coord) < split_distance_sq;
+	});
+}
+
+
+void DrawFreehandTool::flushTail()
+{
+	auto const num_coords = tail_path->getCoordinateCount();
+	for (MapCoordVector::size_type i = 1; i + 1 < num_coords; ++i)
+		preview_path->addCoordinate(tail_path->getCoordinate(i));
+	updatePreviewPath();
+	
+	while (tail_path->getCoordinateCount() > 2)
+		tail_path->deleteCoordinate(0, false);
+}
+
+
+void DrawFreehandTool::mergeTail()
+{
+	if (!tail_path)
+		return;
+	
+	renderables->removeRenderablesOfObject(tail_path, false);
+	auto const num_coords = tail_path->getCoordinateCount();
+	for (MapCoordVector::size_type i = 1; i < num_coords; ++i)
+		preview_path->addCoordinate(tail_path->getCoordinate(i));
+	delete tail_path;
+	tail_path = nullptr;
+	updatePreviewPath();
+}
+
+
 void DrawFreehandTool::updatePath()
 {
 	if ((last_pos - cur_pos).manhattanLength() <= 2)
 		return;
 	
-	preview_path->addCoordinate(MapCoord(cur_pos_map));
 	last_pos = cur_pos;
 	
-	updatePreviewPath();
+	// The last point of the path follows the samples as long as the pending
+	// samples are close to a straight line. Otherwise the previous sample is
+	// kept, and a new last point is added.
+	auto* path = activePath();
+	pending.push_back(cur_pos_map);
+	if (pending.size() > 2 && pendingSamplesFitLine())
+	{
+		path->setCoordinate(path->getCoordinateCount() - 1, MapCoord(cur_pos_map));
+	}
+	else
+	{
+		if (pending.size() > 2)
+			pending.erase(begin(pending), end(pending) - 2);
+		path->addCoordinate(MapCoord(cur_pos_map));
+	}
+	
+	if (!tail_path)
+	{
+		updatePreviewPath();
+	}
+	else
+	{
+		renderables->removeRenderablesOfObject(tail_path, false);
+		if (tail_path->getCoordinateCount() > max_tail_points)
+			flushTail();
+		tail_path->update();
+		renderables->insertRenderablesOfObject(tail_path);
+	}
 	setDirtyRect();
 }
 
@@ -266,6 +375,8 @@ void DrawFreehandTool::setDirtyRect()
 {
 	QRectF rect;
 	includePreviewRects(rect);
+	if (tail_path)
+		rectIncludeSafe(rect, tail_path->getExtent());
 	
 	if (is_helper_tool)
 	{
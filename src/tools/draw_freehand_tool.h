@@ -42,9 +42,17 @@ namespace OpenOrienteering {
 
 class MapEditorController;
 class MapWidget;
+class PathObject;
 
 
-/** Tool for free-hand drawing. */
+/**
+ * Tool for free-hand drawing.
+ * 
+ * The samples are simplified while drawing: a sample is kept only when the
+ * samples since the last kept point deviate from a straight line. For line
+ * symbols, the newest points are drawn as a separate tail object, so that
+ * the renderables of the whole stroke are not regenerated for every sample.
+ */
 class DrawFreehandTool : public DrawLineAndAreaTool
 {
 Q_OBJECT
@@ -74,9 +82,37 @@ protected:
 private:
 	void checkLineSegment(std::size_t first, std::size_t last);
 	
+	/**
+	 * Returns true if all pending samples are close to the line from the
+	 * first to the last pending sample.
+	 */
+	bool pendingSamplesFitLine() const;
+	
+	/**
+	 * Returns the object which receives new points.
+	 */
+	PathObject* activePath() const { return tail_path ? tail_path : preview_path; }
+	
+	/**
+	 * Moves the points of the tail to the preview path.
+	 * 
+	 * The last point of the tail remains in the tail.
+	 */
+	void flushTail();
+	
+	/**
+	 * Moves all points of the tail to the preview path, and deletes the tail.
+	 */
+	void mergeTail();
+	
 	std::vector<bool> point_mask;
 	qreal split_distance_sq;
 	
+	/// The samples since the last kept point, starting with this point
+	std::vector<MapCoordF> pending;
+	/// The newest points of a line, drawn separately
+	PathObject* tail_path = nullptr;
+	
 	QPoint last_pos;
 	QPoint cur_pos;
 	MapCoordF cur_pos_map;
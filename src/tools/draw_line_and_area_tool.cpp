@@ -163,8 +163,15 @@ void DrawLineAndAreaTool::hidePreviewPoints()
 
 void DrawLineAndAreaTool::includePreviewRects(QRectF& rect)
 {
-	if (preview_path)
+	if (committed_preview)
+	{
+		rectIncludeSafe(rect, committed_preview->getExtent());
+		rectIncludeSafe(rect, rubber_band_preview->getExtent());
+	}
+	else if (preview_path)
+	{
 		rectIncludeSafe(rect, preview_path->getExtent());
+	}
 	
 	if (preview_points_shown)
 	{
@@ -214,12 +221,68 @@ void DrawLineAndAreaTool::startDrawing()
 void DrawLineAndAreaTool::updatePreviewPath()
 {
 	renderables->removeRenderablesOfObject(preview_path, false);
-	preview_path->update();
-	renderables->insertRenderablesOfObject(preview_path);
+	
+	auto const split = rubberBandStart();
+	if (split == 0)
+	{
+		deleteSegmentedPreview();
+		preview_path->update();
+		renderables->insertRenderablesOfObject(preview_path);
+		return;
+	}
+	
+	// The preview path is not drawn itself, but the tools use its path coords.
+	preview_path->updatePathCoords();
+	
+	const auto& coords = preview_path->getRawCoordinateVector();
+	auto committed_coords = MapCoordVector(begin(coords), begin(coords) + std::ptrdiff_t(split) + 1);
+	committed_coords.back().setCurveStart(false);
+	if (!committed_preview || committed_preview->getRawCoordinateVector() != committed_coords)
+	{
+		if (committed_preview)
+			renderables->removeRenderablesOfObject(committed_preview.get(), false);
+		committed_preview = std::make_unique<PathObject>(preview_path->getSymbol(), std::move(committed_coords));
+		committed_preview->update();
+		renderables->insertRenderablesOfObject(committed_preview.get());
+	}
+	
+	if (rubber_band_preview)
+		renderables->removeRenderablesOfObject(rubber_band_preview.get(), false);
+	rubber_band_preview = std::make_unique<PathObject>(preview_path->getSymbol(), MapCoordVector(begin(coords) + std::ptrdiff_t(split), end(coords)));
+	rubber_band_preview->update();
+	renderables->insertRenderablesOfObject(rubber_band_preview.get());
+}
+
+std::size_t DrawLineAndAreaTool::rubberBandStart() const
+{
+	// Areas and closed lines depend on all coordinates.
+	if (drawing_symbol && (drawing_symbol->getContainedTypes() & Symbol::Area))
+		return 0;
+	
+	const auto& parts = preview_path->parts();
+	if (parts.size() != 1 || parts.front().isClosed())
+		return 0;
+	
+	const auto& coords = preview_path->getRawCoordinateVector();
+	auto start = std::size_t(0);
+	for (auto i = std::size_t(0); i + 1 < coords.size(); i += coords[i].isCurveStart() ? 3 : 1)
+		start = i;
+	return start;
+}
+
+void DrawLineAndAreaTool::deleteSegmentedPreview()
+{
+	if (committed_preview)
+		renderables->removeRenderablesOfObject(committed_preview.get(), false);
+	if (rubber_band_preview)
+		renderables->removeRenderablesOfObject(rubber_band_preview.get(), false);
+	committed_preview.reset();
+	rubber_band_preview.reset();
 }
 
 void DrawLineAndAreaTool::abortDrawing()
 {
+	deleteSegmentedPreview();
 	renderables->removeRenderablesOfObject(preview_path, false);
 	delete preview_path;
 	map()->clearDrawingBoundingBox();
@@ -238,6 +301,8 @@ void DrawLineAndAreaTool::finishDrawing()
 
 void DrawLineAndAreaTool::finishDrawing(PathObject* append_to_object)
 {
+	// The final object is rendered as a whole, with continuous patterns.
+	deleteSegmentedPreview();
 	if (preview_path)
 	{
 		renderables->removeRenderablesOfObject(preview_path, false);
@@ -322,6 +387,7 @@ void DrawLineAndAreaTool::deletePreviewObjects()
 	preview_point_symbols.clear();
 	preview_point_symbols_external.clear();
 
+	deleteSegmentedPreview();
 	if (preview_path)
 	{
 		renderables->removeRenderablesOfObject(preview_path, false);
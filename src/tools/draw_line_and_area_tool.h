@@ -22,6 +22,7 @@
 #ifndef OPENORIENTEERING_DRAW_LINE_AND_AREA_H
 #define OPENORIENTEERING_DRAW_LINE_AND_AREA_H
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -102,7 +103,15 @@ protected:
 	/** Does necessary preparations to start drawing. */
 	void startDrawing();
 	
-	/** Calls update() on the preview path, correctly handling its renderables. */
+	/**
+	 * Calls update() on the preview path, correctly handling its renderables.
+	 * 
+	 * For open lines, the segments before the last one are drawn from a
+	 * separate object which keeps its renderables as long as these segments
+	 * do not change. Only the last segment, the rubber band, is regenerated.
+	 * Dash patterns and symbol placement are approximate at the junction
+	 * until the object is finished.
+	 */
 	virtual void updatePreviewPath();
 	
 	/** Aborts drawing. */
@@ -118,6 +127,15 @@ protected:
 	/** Deletes preview all objects and points. */
 	void deletePreviewObjects();
 	
+	/**
+	 * Returns the index of the first coordinate of the last segment of the
+	 * preview path, or 0 if the preview path must be drawn as a whole.
+	 */
+	std::size_t rubberBandStart() const;
+	
+	/** Deletes the objects which draw the preview path in pieces. */
+	void deleteSegmentedPreview();
+	
 	/** Extends the rect to cover all preview objects. */
 	void includePreviewRects(QRectF& rect);
 	
@@ -133,6 +151,9 @@ protected:
 	
 	std::unique_ptr<MapRenderables> renderables;
 	
+	std::unique_ptr<PathObject> committed_preview;    ///< The preview path before the rubber band
+	std::unique_ptr<PathObject> rubber_band_preview;  ///< The last segment of the preview path
+	
 	const Symbol* drawing_symbol = nullptr;
 	PathObject* preview_path     = nullptr;
 	int preview_point_radius     = 0;
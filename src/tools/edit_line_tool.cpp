@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,7 @@
 
 #include "edit_line_tool.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <limits>
@@ -38,6 +39,7 @@
 #include <QPointF>
 #include <QPointer>
 #include <QString>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/map_view.h"
@@ -297,7 +299,17 @@ void EditLineTool::dragMove()
 			highlight_renderables->insertRenderablesOfObject(highlight_object);
 		}
 		
-		updatePreviewObjectsAsynchronously();
+		if (object_mover->movesObjectsOnly())
+		{
+			// The objects' renderables are updated once when finishing.
+			auto const offset = MapCoordF(object_mover->offset());
+			setPreviewTransform(QTransform::fromTranslate(offset.x(), offset.y()));
+			updateStatusText();
+		}
+		else
+		{
+			updatePreviewObjectsAsynchronously();
+		}
 	}
 	else if (box_selection)
 	{
@@ -560,30 +572,39 @@ void EditLineTool::updateHoverState(const MapCoordF& cursor_pos)
 			auto click_tolerance_sq = qPow(0.001 * cur_map_widget->getMapView()->pixelToLength(clickTolerance()), 2);
 			auto best_distance_sq = std::numeric_limits<double>::max();
 			
-			for (auto object : map()->selectedObjects())
-			{
-				if (object->getType() == Object::Path)
+			auto const check_edge = [&](const PathObject* path) {
+				auto const bound_sq = std::min(best_distance_sq, qMax(click_tolerance_sq, qPow(path->getSymbol()->calculateLargestLineExtent(), 2)));
+				auto closest = path->findClosestPointWithin(cursor_pos, bound_sq);
+				if (closest.distance_squared >= +0.0 &&
+				    closest.distance_squared < bound_sq)
 				{
-					PathObject* path = object->asPath();
-					auto closest = path->findClosestPointTo(cursor_pos);
+					new_hover_state  = OverPathEdge;
+					new_hover_object = path;
+					new_hover_line   = closest.path_coord.index;
+					best_distance_sq = closest.distance_squared;
+					handle_offset    = closest.path_coord.pos - cursor_pos;
 					
-					if (closest.distance_squared >= +0.0 &&
-					    closest.distance_squared < best_distance_sq &&
-					    closest.distance_squared < qMax(click_tolerance_sq, qPow(path->getSymbol()->calculateLargestLineExtent(), 2)))
+					const auto part = path->findPartForIndex(new_hover_line);
+					if (new_hover_line == part->last_index)
 					{
-						new_hover_state  = OverPathEdge;
-						new_hover_object = path;
-						new_hover_line   = closest.path_coord.index;
-						best_distance_sq = closest.distance_squared;
-						handle_offset    = closest.path_coord.pos - cursor_pos;
-						
-						const auto part = path->findPartForIndex(new_hover_line);
-						if (new_hover_line == part->last_index)
-						{
-							new_hover_line = part->prevCoordIndex(new_hover_line);
-						}
+						new_hover_line = part->prevCoordIndex(new_hover_line);
 					}
 				}
+			};
+			
+			// The previous edge is likely to be hit again, and it limits
+			// the search in the other objects.
+			const PathObject* previous_path = nullptr;
+			if (hover_state == OverPathEdge && map()->selectedObjects().count(hover_object))
+			{
+				previous_path = hover_object;
+				check_edge(previous_path);
+			}
+			
+			for (auto object : map()->selectedObjects())
+			{
+				if (object->getType() == Object::Path && object != previous_path)
+					check_edge(object->asPath());
 			}
 		}
 		
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2020, 2024 Kai Pastor
+ *    Copyright 2013-2020, 2024, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,7 @@
 
 #include "edit_point_tool.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <memory>
@@ -39,6 +40,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QToolButton>
+#include <QTransform>
 
 #include "settings.h"
 #include "core/map.h"
@@ -361,7 +363,17 @@ void EditPointTool::dragMove()
 		
 		object_mover->move(constrained_pos_map, 
 		                   moveOppositeHandle() ? ObjectMover::HandleOpMode::Click : ObjectMover::HandleOpMode::Never);
-		updatePreviewObjectsAsynchronously();
+		if (object_mover->movesObjectsOnly())
+		{
+			// The objects' renderables are updated once when finishing.
+			auto const offset = MapCoordF(object_mover->offset());
+			setPreviewTransform(QTransform::fromTranslate(offset.x(), offset.y()));
+			updateStatusText();
+		}
+		else
+		{
+			updatePreviewObjectsAsynchronously();
+		}
 	}
 	else if (box_selection)
 	{
@@ -518,6 +530,9 @@ QVariant EditPointTool::inputMethodQuery(Qt::InputMethodQuery property, const QV
 
 void EditPointTool::initImpl()
 {
+	connect(map(), &Map::objectUpdated, this, [this](const Object* object) {
+		handle_index.objectUpdated(object);
+	});
 	objectSelectionChanged();
 	
 	if (editor->isInMobileMode())
@@ -535,6 +550,8 @@ void EditPointTool::initImpl()
 
 void EditPointTool::objectSelectionChangedImpl()
 {
+	handle_index.invalidate();
+	
 	if (text_editor)
 	{
 		// This case can be reproduced by using "select all objects of symbol" for any symbol while editing a text.
@@ -782,49 +799,51 @@ void EditPointTool::updateHoverState(const MapCoordF& cursor_pos)
 		if (map()->selectedObjects().size() <= max_objects_for_handle_display)
 		{
 			// Try to find object node.
+			auto const click_tolerance = 0.001 * cur_map_widget->getMapView()->pixelToLength(clickTolerance());
 			auto best_distance_sq = std::numeric_limits<double>::max();
-			for (const auto* object : map()->selectedObjects())
+			auto const handle = handle_index.findHandle(*map(), cursor_pos, click_tolerance);
+			if (handle.object)
 			{
-				MapCoordF handle_pos;
-				auto hover_point = findHoverPoint(cur_map_widget->mapToViewport(cursor_pos), cur_map_widget, object, true, &handle_pos);
-				if (hover_point == no_point)
-					continue;
-				
-				auto distance_sq = cursor_pos.distanceSquaredTo(handle_pos);
-				if (distance_sq < best_distance_sq)
-				{
-					new_hover_state |= OverObjectNode;
-					new_hover_object = object;
-					new_hover_point  = hover_point;
-					best_distance_sq = distance_sq;
-					handle_offset    = handle_pos - cursor_pos;
-				}
+				new_hover_state |= OverObjectNode;
+				new_hover_object = handle.object;
+				new_hover_point  = handle.index;
+				best_distance_sq = cursor_pos.distanceSquaredTo(handle.pos);
+				handle_offset    = handle.pos - cursor_pos;
 			}
 			
 			if (!new_hover_state.testFlag(OverObjectNode))
 			{
 				// No object node found. Try to find path object edge.
 				/// \todo De-duplicate: Copied from EditLineTool
-				auto click_tolerance_sq = qPow(0.001 * cur_map_widget->getMapView()->pixelToLength(clickTolerance()), 2);
+				auto click_tolerance_sq = qPow(click_tolerance, 2);
 				
-				for (auto object : map()->selectedObjects())
-				{
-					if (object->getType() == Object::Path)
+				auto const check_edge = [&](PathObject* path) {
+					auto const bound_sq = std::min(best_distance_sq, qMax(click_tolerance_sq, qPow(path->getSymbol()->calculateLargestLineExtent(), 2)));
+					auto closest = path->findClosestPointWithin(cursor_pos, bound_sq);
+					if (closest.distance_squared >= +0.0 &&
+					    closest.distance_squared < bound_sq)
 					{
-						PathObject* path = object->asPath();
-						auto closest = path->findClosestPointTo(cursor_pos);
-						
-						if (closest.distance_squared >= +0.0 &&
-						    closest.distance_squared < best_distance_sq &&
-						    closest.distance_squared < qMax(click_tolerance_sq, qPow(path->getSymbol()->calculateLargestLineExtent(), 2)))
-						{
-							new_hover_state |= OverPathEdge;
-							new_hover_object = path;
-							new_hover_point  = closest.path_coord.index;
-							best_distance_sq = closest.distance_squared;
-							handle_offset    = closest.path_coord.pos - cursor_pos;
-						}
+						new_hover_state |= OverPathEdge;
+						new_hover_object = path;
+						new_hover_point  = closest.path_coord.index;
+						best_distance_sq = closest.distance_squared;
+						handle_offset    = closest.path_coord.pos - cursor_pos;
 					}
+				};
+				
+				// The previous edge is likely to be hit again, and it limits
+				// the search in the other objects.
+				PathObject* previous_path = nullptr;
+				if (hover_state.testFlag(OverPathEdge) && map()->selectedObjects().count(hover_object))
+				{
+					previous_path = hover_object->asPath();
+					check_edge(previous_path);
+				}
+				
+				for (auto object : map()->selectedObjects())
+				{
+					if (object->getType() == Object::Path && object != previous_path)
+						check_edge(object->asPath());
 				}
 			}
 		}
@@ -35,6 +35,7 @@
 #include "core/map_coord.h"
 #include "core/map_view.h"
 #include "tools/edit_tool.h"
+#include "tools/selection_handle_index.h"
 
 class QAction;
 class QFocusEvent;
@@ -159,6 +160,9 @@ protected:
 	/** Bounding box of the selection */
 	QRectF selection_extent;
 	
+	/** Control points of the selection, for finding the hover point */
+	SelectionHandleIndex handle_index;
+	
 	
 	/**
 	 * Provides general information on what is hovered over.
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2014-2017 Kai Pastor
+ *    Copyright 2014-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,51 +22,36 @@
 #include "fill_tool.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <limits>
 #include <memory>
-#include <type_traits>
+#include <vector>
 
 #include <QtGlobal>
 #include <QCursor>
-#include <QDir>  // IWYU pragma: keep
-#include <QFlags>
 #include <QMessageBox>
-#include <QPainter>
 #include <QPixmap>
-#include <QPoint>
 #include <QPointF>
-#include <QRect>
-#include <QRgb>
-#include <QSize>
+#include <QRectF>
 #include <QString>
 
+#include <clipper.hpp>
+
 #include "core/map.h"
-#include "core/map_color.h"
 #include "core/map_coord.h"
 #include "core/map_part.h"
 #include "core/map_view.h"
 #include "core/path_coord.h"
 #include "core/objects/object.h"
-#include "core/renderables/renderable.h"
-#include "core/symbols/area_symbol.h"
 #include "core/symbols/symbol.h"
 #include "gui/map/map_editor.h"
 #include "gui/map/map_widget.h"
 #include "tools/tool.h"
 #include "tools/tool_base.h"
 #include "undo/object_undo.h"
-
-
-// Uncomment this to generate an image file of the rasterized map
-//#define FILLTOOL_DEBUG_IMAGE "FillTool.png"
-
-
-// Make sure that we can use the object ID in place of a qRgb
-// directly and in a sufficiently large domain.
-Q_STATIC_ASSERT((std::is_same<QRgb, unsigned int>::value));
-Q_STATIC_ASSERT(RGB_MASK == 0x00ffffff);
+#include "util/spatial_index.h"
 
 
 namespace OpenOrienteering {
@@ -85,7 +70,51 @@ struct PathSection
 	PathCoord::length_type end_clen;
 };
 
-constexpr auto background = QRgb(0xffffffffu);
+/**
+ * The distance by which the bounding objects are widened, in native map units.
+ * 
+ * This closes tiny gaps between objects which are meant to touch.
+ */
+constexpr auto boundary_tolerance = 50.0;
+
+/**
+ * The maximum distance between consecutive boundary points, in mm.
+ */
+constexpr auto boundary_spacing = PathCoord::length_type(0.05);
+
+
+ClipperLib::IntPoint toIntPoint(const MapCoordF& pos)
+{
+	auto const coord = MapCoord(pos);
+	return ClipperLib::IntPoint(coord.nativeX(), coord.nativeY());
+}
+
+MapCoordF toMapCoordF(const ClipperLib::IntPoint& point)
+{
+	return MapCoordF(MapCoord::fromNative64(point.X, point.Y));
+}
+
+/**
+ * Finds the outer polygon of the free region which contains the given point.
+ * 
+ * Returns nullptr if the point is not inside a free region.
+ */
+const ClipperLib::PolyNode* findFace(const ClipperLib::PolyNode& parent, const ClipperLib::IntPoint& point)
+{
+	for (auto const* node : parent.Childs)
+	{
+		if (ClipperLib::PointInPolygon(point, node->Contour) != 1)
+			continue;
+		
+		auto const hole = std::find_if(begin(node->Childs), end(node->Childs), [&point](auto const* hole) {
+			return ClipperLib::PointInPolygon(point, hole->Contour) != 0;
+		});
+		if (hole == end(node->Childs))
+			return node;
+		return findFace(**hole, point);
+	}
+	return nullptr;
+}
 
 }  // namespace
 
@@ -130,10 +159,10 @@ void FillTool::clickPress()
 	if (result == -1 || result == 1)
 		return;
 	
-	// If not successful, try again with rasterizing the whole map part
+	// If not successful, try again with the whole map part
 	QRectF map_part_extent = map()->getCurrentPart()->calculateExtent(true);
 	if (viewport_extent.united(map_part_extent) != viewport_extent)
-		result = fill(map_part_extent);
+		result = fill(viewport_extent.united(map_part_extent));
 	if (result == -1 || result == 1)
 		return;
 	
@@ -146,30 +175,13 @@ void FillTool::clickPress()
 
 int FillTool::fill(const QRectF& extent)
 {
-	constexpr auto extent_area_warning_threshold = qreal(600 * 600); // 60 cm x 60 cm
-	
-	// Warn if desired extent is large
-	if (extent.width() * extent.height() > extent_area_warning_threshold)
-	{
-		if (QMessageBox::question(
-			window(),
-			tr("Warning"),
-			tr("The map area is large. Use of the fill tool may be very slow. Do you want to use it anyway?"),
-			QMessageBox::No | QMessageBox::Yes) == QMessageBox::No)
-		{
-			return -1;
-		}
-	}
-	
-	// Rasterize map into image
-	QTransform transform;
-	QImage image = rasterizeMap(extent, transform);
-	
-	// Calculate click position in image and check if it is inside the map area and free
-	QPoint clicked_pixel = transform.map(cur_map_widget->viewportToMapF(click_pos)).toPoint();
-	if (!image.rect().contains(clicked_pixel, true))
+	auto const click_pos_map = cur_map_widget->viewportToMapF(click_pos);
+	if (!extent.contains(click_pos_map))
 		return 0;
-	if (image.pixel(clicked_pixel) != background)
+	
+	std::vector<Boundary> boundaries;
+	auto const result = findBoundary(extent, click_pos_map, boundaries);
+	if (result == -1)
 	{
 		QMessageBox::warning(
 			window(),
@@ -178,64 +190,20 @@ int FillTool::fill(const QRectF& extent)
 		);
 		return -1;
 	}
+	if (result == 0)
+		return 0;
 	
-	// Go to the right and find collisions with objects.
-	// For every collision, trace the boundary of the collision object
-	// and check whether the click position is inside the boundary.
-	// If it is, the correct outline was found which is then filled.
-	for (QPoint free_pixel = clicked_pixel; free_pixel.x() < image.width() - 1; free_pixel += QPoint(1, 0))
+	// Create fill object
+	if (!fillBoundary(boundaries))
 	{
-		// Check if there is a collision to the right
-		QPoint boundary_pixel = free_pixel + QPoint(1, 0);
-		if (image.pixel(boundary_pixel) == background)
-			continue;
-		
-		// Found a collision, trace outline of hit object
-		// and check whether the outline contains start_pixel
-		std::vector<QPoint> boundary;
-		int trace_result = traceBoundary(image, free_pixel, boundary_pixel, boundary);
-		if (trace_result == -1)
-			return 0;
-		
-		if (trace_result == 0)
-		{
-			// The outline does not contain start_pixel.
-			// Jump to the rightmost pixel of the boundary with same y as the start.
-			for (const auto& point : boundary)
-			{
-				if (point.y() == free_pixel.y() && point.x() > free_pixel.x())
-					free_pixel = point;
-			}
-			
-			// Skip over the rest of the floating object.
-			free_pixel += QPoint(1, 0);
-			while (free_pixel.x() < image.width() - 1
-				&& image.pixel(free_pixel) != background)
-				free_pixel += QPoint(1, 0);
-			free_pixel -= QPoint(1, 0);
-			continue;
-		}
-		
-		// Don't let the boundary start in the midde of an object
-		const auto id = image.pixel(boundary.front());
-		auto new_object = std::find_if(begin(boundary), end(boundary), [&image, id](auto pos) {
-			return image.pixel(pos) != id;
-		});
-		std::rotate(begin(boundary), new_object, end(boundary));
-		
-		// Create fill object
-		if (!fillBoundary(image, boundary, transform.inverted()))
-		{
-			QMessageBox::warning(
-				window(),
-				tr("Error"),
-				tr("Failed to create the fill object.")
-			);
-			return -1;
-		}
-		return 1;
+		QMessageBox::warning(
+			window(),
+			tr("Error"),
+			tr("Failed to create the fill object.")
+		);
+		return -1;
 	}
-	return 0;
+	return 1;
 }
 
 void FillTool::updateStatusText()
@@ -247,182 +215,156 @@ void FillTool::objectSelectionChangedImpl()
 {
 }
 
-QImage FillTool::rasterizeMap(const QRectF& extent, QTransform& out_transform)
+int FillTool::findBoundary(const QRectF& extent, const MapCoordF& pos, std::vector<Boundary>& out_boundaries)
 {
-	// Draw map into a QImage with the following settings:
-	// - specific zoom factor (resolution)
-	// - no antialiasing
-	// - encode object ids in object colors
-	// - draw baselines in advance to normal rendering
-	//   This makes it possible to fill areas bounded by e.g. dashed paths.
-	
-	constexpr auto zoom_level = qreal(4);
-	
-	// Create map view centered on the extent
-	MapView view{ map() };
-	view.setCenter(MapCoord{ extent.center() });
-	view.setZoom(zoom_level);
-	
-	// Allocate the image
-	auto image_size = view.calculateViewBoundingBox(extent).toAlignedRect().size();
-	QImage image = QImage(image_size, QImage::Format_RGB32);
-	image.fill(background);
+	// Only the objects in the extent can bound the face, and the spatial
+	// index finds them without looking at the rest of the map.
+	std::vector<Object*> objects;
+	map()->getCurrentPart()->findObjectsAtBox(MapCoordF(extent.topLeft()), MapCoordF(extent.bottomRight()), false, true, objects);
+	
+	// The bounding objects are taken by their base lines. This makes it
+	// possible to fill areas bounded by e.g. dashed paths.
+	SpatialIndex<PathObject*> bounding_objects;
+	ClipperLib::ClipperOffset offset;
+	for (auto* object : objects)
+	{
+		if (object->getType() != Object::Path)
+			continue;
+		
+		auto* path = object->asPath();
+		if (path->isPointOnObject(pos, 0, false, false))
+			return -1;
+		
+		bounding_objects.insert(path->getExtent(), path);
+		for (const auto& part : path->parts())
+		{
+			ClipperLib::Path polyline;
+			polyline.reserve(part.path_coords.size());
+			for (const auto& path_coord : part.path_coords)
+				polyline.push_back(toIntPoint(path_coord.pos));
+			if (part.isClosed() && polyline.size() > 1)
+				polyline.pop_back();
+			offset.AddPath(polyline, ClipperLib::jtMiter, part.isClosed() ? ClipperLib::etClosedLine : ClipperLib::etOpenSquare);
+		}
+	}
+	ClipperLib::Paths obstacles;
+	offset.Execute(obstacles, boundary_tolerance);
+	
+	// The faces of the arrangement are the free regions of the extent.
+	auto const top_left = toIntPoint(MapCoordF(extent.topLeft()));
+	auto const bottom_right = toIntPoint(MapCoordF(extent.bottomRight()));
+	ClipperLib::Path frame = {
+	    top_left,
+	    ClipperLib::IntPoint(bottom_right.X, top_left.Y),
+	    bottom_right,
+	    ClipperLib::IntPoint(top_left.X, bottom_right.Y),
+	};
+	ClipperLib::Clipper clipper;
+	clipper.AddPath(frame, ClipperLib::ptSubject, true);
+	clipper.AddPaths(obstacles, ClipperLib::ptClip, true);
+	ClipperLib::PolyTree faces;
+	if (!clipper.Execute(ClipperLib::ctDifference, faces, ClipperLib::pftNonZero, ClipperLib::pftNonZero))
+		return 0;
 	
-	// Draw map
-	RenderConfig::Options options = RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
-	RenderConfig config = { *map(), extent, view.calculateFinalZoomFactor(), options, 1.0 };
+	auto const* face = findFace(faces, toIntPoint(pos));
+	if (!face)
+		return -1;
 	
-	QPainter painter;
-	painter.begin(&image);
-	painter.translate(image_size.width() / 2.0, image_size.height() / 2.0);
-	painter.setWorldTransform(view.worldTransform(), true);
+	// A face which reaches the frame is not bounded within the extent.
+	auto const on_frame = [&top_left, &bottom_right](const ClipperLib::IntPoint& point) {
+		return point.X <= top_left.X || point.X >= bottom_right.X
+		       || point.Y <= top_left.Y || point.Y >= bottom_right.Y;
+	};
+	if (std::any_of(begin(face->Contour), end(face->Contour), on_frame))
+		return 0;
 	
-	auto original_area_hatching = map()->isAreaHatchingEnabled();
-	if (original_area_hatching)
-	{
-		map()->setAreaHatchingEnabled(false);
-	}
+	out_boundaries.clear();
+	out_boundaries.push_back(makeBoundary(face->Contour, bounding_objects));
+	for (auto const* hole : face->Childs)
+		out_boundaries.push_back(makeBoundary(hole->Contour, bounding_objects));
+	return 1;
+}
+
+FillTool::Boundary FillTool::makeBoundary(const ClipperLib::Path& polygon, const SpatialIndex<PathObject*>& bounding_objects) const
+{
+	auto const search_distance = 4 * boundary_tolerance / 1000;
+	auto const closest_object = [&bounding_objects, search_distance](const MapCoordF& pos) {
+		auto result = BoundaryPoint{ nullptr, pos };
+		auto min_distance_squared = std::numeric_limits<double>::max();
+		auto const rect = QRectF(pos.x() - search_distance, pos.y() - search_distance, 2 * search_distance, 2 * search_distance);
+		bounding_objects.query(rect, [&](PathObject* object) {
+			auto const closest = object->findClosestPointTo(pos);
+			if (closest.distance_squared < min_distance_squared)
+			{
+				min_distance_squared = closest.distance_squared;
+				result.object = object;
+			}
+		});
+		return result;
+	};
 	
-	if (!map()->isBaselineViewEnabled())
+	Boundary boundary;
+	for (std::size_t i = 0, size = polygon.size(); i < size; ++i)
 	{
-		// Temporarily enable baseline view and draw map once.
-		map()->setBaselineViewEnabled(true);
-		map()->getCurrentPart()->applyOnAllObjects(&Object::forceUpdate);
-		drawObjectIDs(map(), &painter, config);
-		map()->setBaselineViewEnabled(false);
-		map()->getCurrentPart()->applyOnAllObjects(&Object::forceUpdate);
+		auto const start = toMapCoordF(polygon[i]);
+		auto const end = toMapCoordF(polygon[(i + 1) % size]);
+		auto const steps = std::max(1, int(std::ceil(start.distanceTo(end) / boundary_spacing)));
+		for (int step = 0; step < steps; ++step)
+			boundary.push_back(closest_object(start + (end - start) * (qreal(step) / steps)));
 	}
-	else if (original_area_hatching)
-	{
-		map()->getCurrentPart()->applyOnAllObjects(&Object::forceUpdate);
-	}
-	
-	// Draw the map in original mode (but without area hatching)
-	drawObjectIDs(map(), &painter, config);
 	
-	if (original_area_hatching)
+	// Don't let the boundary start in the midde of an object
+	if (!boundary.empty())
 	{
-		map()->setAreaHatchingEnabled(original_area_hatching);
-		map()->getCurrentPart()->applyOnAllObjects(&Object::forceUpdate);
+		const auto object = boundary.front().object;
+		auto new_object = std::find_if(begin(boundary), end(boundary), [object](const auto& point) {
+			return point.object != object;
+		});
+		std::rotate(begin(boundary), new_object, end(boundary));
 	}
-	
-	out_transform = painter.combinedTransform();
-	painter.end();
-	
-#ifdef FILLTOOL_DEBUG_IMAGE
-	image.save(QDir::temp().absoluteFilePath(QString::fromLatin1(FILLTOOL_DEBUG_IMAGE)));
-#endif
-	
-	return image;
+	return boundary;
 }
 
-void FillTool::drawObjectIDs(Map* map, QPainter* painter, const RenderConfig &config)
+bool FillTool::fillBoundary(const std::vector<Boundary>& boundaries)
 {
-	Q_STATIC_ASSERT(MapColor::Reserved == -1);
-	Q_ASSERT(!map->isAreaHatchingEnabled());
-	
-	auto part = map->getCurrentPart();
-	auto num_objects = qMin(part->getNumObjects(), int(RGB_MASK));
-	auto num_colors = map->getNumColors();
-	for (auto c = num_colors-1; c >= MapColor::Reserved; --c)
+	auto path = std::make_unique<PathObject>(drawing_symbol);
+	for (const auto& boundary : boundaries)
 	{
-		auto map_color = map->getColor(c);
-		for (int o = 0; o < num_objects; ++o)
+		auto ring = traceBoundary(boundary);
+		if (ring->getCoordinateCount() < 2)
 		{
-			auto object = part->getObject(o);
-			if (object->getType() != Object::Path)
-				continue;
-			if (auto symbol = object->getSymbol())
-			{
-				if (symbol->isHidden())
-					continue;
-				if (symbol->getType() == Symbol::Area
-				    && static_cast<const AreaSymbol*>(symbol)->getColor() != map_color)
-					continue;
-			}
-			
-			object->update();
-			object->renderables().draw(c, QRgb(o) | ~RGB_MASK, painter, config);
+			if (path->getCoordinateCount() == 0)
+				return false;
+			continue;
 		}
+		ring->closeAllParts();
+		path->appendPath(ring.get());
 	}
-}
-
-int FillTool::traceBoundary(const QImage& image, const QPoint& free_pixel, const QPoint& boundary_pixel, std::vector<QPoint>& out_boundary)
-{
-	Q_ASSERT(image.pixel(free_pixel) == background);
-	Q_ASSERT(image.pixel(boundary_pixel) != background);
 	
-#ifdef FILLTOOL_DEBUG_IMAGE
-	{
-		auto debugImage = image.copy();
-		debugImage.setPixel(free_pixel, qRgb(255, 0, 0));
-		debugImage.save(QDir::temp().absoluteFilePath(QString::fromLatin1(FILLTOOL_DEBUG_IMAGE)));
-	}
-#endif
+	// Obsolete: The resulting path is as simple as the bounding objects,
+	// so better avoid the loss in precision from PathObject::simplify.
+	//   const auto simplify_epsilon = 1e-2;
+	//   path->simplify(nullptr, simplify_epsilon);
 	
-	out_boundary.clear();
-	out_boundary.reserve(4096);
-	out_boundary.push_back(boundary_pixel);
+	auto* fill_object = path.release();
+	int index = map()->addObject(fill_object);
+	map()->clearObjectSelection(false);
+	map()->addObjectToSelection(fill_object, true);
 	
-	// Go along obstructed pixels with a "right(?) hand on the wall" method.
-	// Iteration keeps the following variables as state:
-	// cur_free_pixel:     current free position next to boundary
-	// cur_boundary_pixel: current position on boundary
-	auto cur_free_pixel     = free_pixel;
-	auto cur_boundary_pixel = boundary_pixel;
-	do
-	{
-		const auto fwd_vector = cur_free_pixel - cur_boundary_pixel;
-		const auto right_vector = QPoint(fwd_vector.y(), -fwd_vector.x());
-		const auto right_pixel = cur_free_pixel + right_vector;
-		if (!image.rect().contains(right_pixel, true))
-			return -1;
-		
-		// Now analysing a 2x2 pixel block:
-		// | cur_free_pixel | cur_boundary_pixel |
-		// |  right_pixel   |     diag_pixel     |
-		const auto diag_pixel = cur_boundary_pixel + right_vector;
-		if (image.pixel(right_pixel) == image.pixel(cur_boundary_pixel))
-		{
-			out_boundary.push_back(right_pixel);
-		}
-		else if (image.pixel(diag_pixel) != background)
-		{
-			out_boundary.push_back(diag_pixel);
-			if (image.pixel(right_pixel) == background)
-				cur_free_pixel = right_pixel;
-			else
-				out_boundary.push_back(right_pixel);
-		}
-		else if (image.pixel(right_pixel) != background)
-		{
-			out_boundary.push_back(right_pixel);
-		}
-		else
-		{
-			cur_free_pixel = diag_pixel;
-		}
-		cur_boundary_pixel = out_boundary.back();
-	}
-	while (cur_boundary_pixel != boundary_pixel || cur_free_pixel != free_pixel);
+	auto undo_step = new DeleteObjectsUndoStep(map());
+	undo_step->addObject(index);
+	map()->push(undo_step);
 	
-	bool inside = false;
-	auto size = out_boundary.size();
-	for (std::size_t i = 0, j = size - 1; i < size; j = i++)
-	{
-		if ( ((out_boundary[i].y() > free_pixel.y()) != (out_boundary[j].y() > free_pixel.y()))
-		     &&	(free_pixel.x() < (out_boundary[j].x() - out_boundary[i].x())
-		                           * (free_pixel.y() - out_boundary[i].y())
-		                           / double(out_boundary[j].y() - out_boundary[i].y()) + out_boundary[i].x()) )
-			inside = !inside;
-	}
-	return inside ? 1 : 0;
+	map()->setObjectsDirty();
+	updateDirtyRect();
+	
+	return true;
 }
 
-bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boundary, const QTransform& image_to_map)
+std::unique_ptr<PathObject> FillTool::traceBoundary(const Boundary& boundary) const
 {
-	auto path = new PathObject(drawing_symbol);
-	auto append_section = [path](const PathSection& section)
+	auto path = std::make_unique<PathObject>(drawing_symbol);
+	auto append_section = [&path](const PathSection& section)
 	{
 		if (!section.object)
 			return;
@@ -451,34 +393,30 @@ bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boun
 			path->connectPathParts(0, &part_copy, 0, false, false);
 	};
 	
-	auto last_pixel = background; // no object
-	const auto pixel_length = PathCoord::length_type((image_to_map.map(QPointF(0, 0)) - image_to_map.map(QPointF(1, 1))).manhattanLength());
+	const PathObject* last_object = nullptr;
 	auto threshold = std::numeric_limits<PathCoord::length_type>::max();
 	auto section = PathSection{ nullptr, 0, 0, 0 };
 	for (const auto& point : boundary)
 	{
-		auto pixel = image.pixel(point);
-		if (pixel == background)
+		if (!point.object)
 			continue;
 		
-		MapCoordF map_pos = MapCoordF(image_to_map.map(QPointF(point)));
-		
-		if (pixel != last_pixel)
+		if (point.object != last_object)
 		{
 			// Change of object
 			append_section(section);
 			
-			section.object = map()->getCurrentPart()->getObject(int(pixel & RGB_MASK))->asPath();
-			auto closest = section.object->findClosestPointTo(map_pos);
+			section.object = point.object;
+			auto closest = section.object->findClosestPointTo(point.pos);
 			section.part = section.object->findPartIndexForIndex(closest.path_coord.index);
 			section.start_clen = closest.path_coord.clen;
 			section.end_clen = closest.path_coord.clen;
-			last_pixel = pixel;
-			threshold = section.object->parts()[section.part].length() - 5*pixel_length;
+			last_object = point.object;
+			threshold = section.object->parts()[section.part].length() - 5*boundary_spacing;
 			continue;
 		}
 		
-		auto closest = section.object->findClosestPointTo(map_pos);
+		auto closest = section.object->findClosestPointTo(point.pos);
 		auto part = section.object->findPartIndexForIndex(closest.path_coord.index);
 		if (Q_UNLIKELY(part != section.part))
 		{
@@ -488,7 +426,7 @@ bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boun
 			section.part = part;
 			section.start_clen = closest.path_coord.clen;
 			section.end_clen = closest.path_coord.clen;
-			threshold = section.object->parts()[section.part].length() - 4*pixel_length;
+			threshold = section.object->parts()[section.part].length() - 4*boundary_spacing;
 			continue;
 		}
 		
@@ -511,31 +449,7 @@ bool FillTool::fillBoundary(const QImage& image, const std::vector<QPoint>& boun
 	// Final section
 	append_section(section);
 	
-	if (path->getCoordinateCount() < 2)
-	{
-		delete path;
-		return false;
-	}
-	
-	path->closeAllParts();
-	
-	// Obsolete: The resulting path is as simple as the bounding objects,
-	// so better avoid the loss in precision from PathObject::simplify.
-	//   const auto simplify_epsilon = 1e-2;
-	//   path->simplify(nullptr, simplify_epsilon);
-	
-	int index = map()->addObject(path);
-	map()->clearObjectSelection(false);
-	map()->addObjectToSelection(path, true);
-	
-	auto undo_step = new DeleteObjectsUndoStep(map());
-	undo_step->addObject(index);
-	map()->push(undo_step);
-	
-	map()->setObjectsDirty();
-	updateDirtyRect();
-	
-	return true;
+	return path;
 }
 
 
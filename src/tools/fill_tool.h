@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2014, 2017 Kai Pastor
+ *    Copyright 2014, 2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,42 +22,62 @@
 #ifndef OPENORIENTEERING_FILL_TOOL_H
 #define OPENORIENTEERING_FILL_TOOL_H
 
+#include <memory>
 #include <vector>
 
-#include <QImage>
 #include <QObject>
 // IWYU pragma: no_include <QRectF>
 #include <QString>
-#include <QTransform>
 
+#include "core/map_coord.h"
 #include "tool_base.h"
 
 class QAction;
-class QPainter;
-class QPoint;
 class QRectF;
 
+namespace ClipperLib {
+struct IntPoint;
+}  // namespace ClipperLib
+
 namespace OpenOrienteering {
 
-class Map;
 class MapEditorController;
-class RenderConfig;
+class PathObject;
 class Symbol;
+template <class T> class SpatialIndex;
 
 
 /** 
  * Tool to fill bounded areas with PathObjects.
+ * 
+ * The tool finds the area around the clicked position from the arrangement of
+ * the base lines of the nearby line and area objects, and creates an object
+ * which follows the bounding objects, including their curves.
  */
 class FillTool : public MapEditorToolBase
 {
 Q_OBJECT
 public:
+	/**
+	 * A point on the boundary of the area to be filled.
+	 */
+	struct BoundaryPoint
+	{
+		PathObject* object;  ///< The closest bounding object, or nullptr.
+		MapCoordF pos;
+	};
+	
+	/**
+	 * A closed ring of boundary points.
+	 */
+	using Boundary = std::vector<BoundaryPoint>;
+	
 	FillTool(MapEditorController* editor, QAction* tool_action);
 	~FillTool() override;
-	
+
 protected slots:
 	void setDrawingSymbol(const OpenOrienteering::Symbol* symbol);
-	
+
 protected:
 	void updateStatusText() override;
 	void objectSelectionChangedImpl() override;
@@ -66,44 +86,42 @@ protected:
 	
 	/**
 	 * Tries to apply the fill tool at the current click position,
-	 * rasterizing the given extent of the map.
+	 * considering the objects in the given extent of the map.
 	 * Returns -1 for abort, 0 for unsuccessful, 1 for successful.
 	 */
 	int fill(const QRectF& extent);
 	
 	/**
-	 * Rasterizes an area of the current map part with the given extent into an image.
+	 * Finds the boundary of the free area around pos.
+	 * 
+	 * The base lines of the line and area objects in the extent are
+	 * united with Clipper, and the face of the resulting arrangement which
+	 * contains pos is taken. The first boundary is the outline, the others
+	 * are the holes.
 	 * 
-	 * The pixels encodes object IDs (with alpha = 255). The background is white.
-	 * Returns the image and the used map-to-image transform.
+	 * Returns:
+	 * -1 if pos is not free,
+	 *  0 if the area is not bounded within the extent,
+	 *  1 if the boundary was found.
 	 */
-	QImage rasterizeMap(const QRectF& extent, QTransform& out_transform);
+	int findBoundary(const QRectF& extent, const MapCoordF& pos, std::vector<Boundary>& out_boundaries);
 	
 	/**
-	 * Helper method for rasterizeMap().
+	 * Converts a polygon of the arrangement to a boundary, assigning each
+	 * point to the closest bounding object.
 	 */
-	void drawObjectIDs(Map* map, QPainter* painter, const RenderConfig& config);
+	Boundary makeBoundary(const std::vector<ClipperLib::IntPoint>& polygon, const SpatialIndex<PathObject*>& bounding_objects) const;
 	
 	/**
-	 * Constructs the boundary around an area of free pixels in the given image.
-	 * 
-	 * The discovered boundary is stored as a vector of pixel positions.
-	 * The tracing starts from the free_pixel/boundary_pixel pair, where
-	 * free_pixel references a free (transparent) pixel next to boundary pixel
-	 * which reference an obstructed pixel of area to be traced.
-	 * 
-	 * Returns:
-	 * -1 if running out of the image borders,
-	 *  0 if the tracing fails because the start is not included in the shape,
-	 *  1 if the tracing succeeds.
+	 * Creates a fill object for the given boundaries.
+	 * Returns false if the creation fails.
 	 */
-	int traceBoundary(const QImage& image, const QPoint& free_pixel, const QPoint& boundary_pixel, std::vector<QPoint>& out_boundary);
+	bool fillBoundary(const std::vector<Boundary>& boundaries);
 	
 	/**
-	 * Creates a fill object for the given image, boundary vector (of pixel positions) and transform.
-	 * Returns false if the creation fails.
+	 * Constructs a path which follows the bounding objects of a boundary.
 	 */
-	bool fillBoundary(const QImage& image, const std::vector<QPoint>& boundary, const QTransform& image_to_map);
+	std::unique_ptr<PathObject> traceBoundary(const Boundary& boundary) const;
 	
 	const Symbol* drawing_symbol;
 };
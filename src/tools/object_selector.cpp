@@ -145,18 +145,19 @@ bool ObjectSelector::selectBox(const MapCoordF& corner1, const MapCoordF& corner
 		map->clearObjectSelection(false);
 	}
 	
-	const auto size = objects.size();
-	for (std::size_t i = 0; i < size; ++i)
+	if (toggle)
 	{
-		if (toggle)
+		const auto size = objects.size();
+		for (std::size_t i = 0; i < size; ++i)
 			map->toggleObjectSelection(objects[i], i == size - 1);
-		else
-			map->addObjectToSelection(objects[i], i == size - 1);
-			
-		selection_changed = true;
+	}
+	else if (!objects.empty())
+	{
+		map->addObjectsToSelection(objects, false);
+		map->emitSelectionChanged();
 	}
 	
-	return selection_changed;
+	return selection_changed || !objects.empty();
 }
 
 
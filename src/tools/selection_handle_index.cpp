@@ -0,0 +1,117 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "selection_handle_index.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+#include "core/map.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+
+
+namespace OpenOrienteering {
+
+void SelectionHandleIndex::invalidate()
+{
+	valid = false;
+	handles.clear();
+	objects.clear();
+}
+
+
+void SelectionHandleIndex::objectUpdated(const Object* object)
+{
+	if (valid && objects.count(object))
+		invalidate();
+}
+
+
+SelectionHandleIndex::Handle SelectionHandleIndex::findHandle(const Map& map, const MapCoordF& pos, double distance)
+{
+	if (!valid)
+		rebuild(map);
+	
+	auto result = Handle { nullptr, 0, {}, false };
+	auto best_distance_sq = distance * distance;
+	handles.query(QRectF(pos.x() - distance, pos.y() - distance, 2 * distance, 2 * distance), [&](const Handle& handle) {
+		auto const distance_sq = pos.distanceSquaredTo(handle.pos);
+		if (distance_sq < best_distance_sq
+		    || (distance_sq == best_distance_sq && handle.is_curve_handle && (!result.object || !result.is_curve_handle)))
+		{
+			result = handle;
+			best_distance_sq = distance_sq;
+		}
+	});
+	return result;
+}
+
+
+void SelectionHandleIndex::rebuild(const Map& map)
+{
+	handles.clear();
+	objects.clear();
+	
+	auto const add = [this](const Object* object, MapCoordVector::size_type index, const MapCoordF& pos, bool is_curve_handle) {
+		handles.insert(QRectF(pos, pos), { object, index, pos, is_curve_handle });
+	};
+	
+	for (auto const* object : map.selectedObjects())
+	{
+		objects.insert(object);
+		switch (object->getType())
+		{
+		case Object::Point:
+			add(object, 0, object->asPoint()->getCoordF(), false);
+			break;
+			
+		case Object::Text:
+			{
+				auto const control_points = object->asText()->controlPoints();
+				for (std::size_t i = 0; i < control_points.size(); ++i)
+					add(object, i, MapCoordF(control_points[i]), false);
+			}
+			break;
+			
+		case Object::Path:
+			{
+				auto const* path = object->asPath();
+				auto const size = path->getCoordinateCount();
+				for (MapCoordVector::size_type i = 0; i < size; ++i)
+				{
+					auto const& coord = path->getCoordinate(i);
+					if (coord.isClosePoint())
+						continue;
+					auto const is_curve_handle = (i >= 1 && path->getCoordinate(i - 1).isCurveStart())
+					                             || (i >= 2 && path->getCoordinate(i - 2).isCurveStart());
+					add(object, i, MapCoordF(coord), is_curve_handle);
+				}
+			}
+			break;
+		}
+	}
+	valid = true;
+}
+
+
+}  // namespace OpenOrienteering
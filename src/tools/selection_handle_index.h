@@ -0,0 +1,92 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_SELECTION_HANDLE_INDEX_H
+#define OPENORIENTEERING_SELECTION_HANDLE_INDEX_H
+
+#include <unordered_set>
+
+#include "core/map_coord.h"
+#include "util/spatial_index.h"
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+
+
+/**
+ * A spatial index of the control points of the selected objects.
+ *
+ * Finding the control point under the cursor by testing all points of
+ * the selection is too slow for objects with many points. This index is
+ * built on demand from the map's object selection, and it is kept until
+ * the selection changes or one of the selected objects is updated.
+ */
+class SelectionHandleIndex
+{
+public:
+	/**
+	 * A control point of a selected object.
+	 */
+	struct Handle
+	{
+		const Object* object;
+		MapCoordVector::size_type index;
+		MapCoordF pos;
+		bool is_curve_handle;
+	};
+	
+	/**
+	 * Discards the index.
+	 * 
+	 * This must be called when the object selection changes.
+	 */
+	void invalidate();
+	
+	/**
+	 * Discards the index if it contains the given object.
+	 * 
+	 * This must be called when an object is updated.
+	 */
+	void objectUpdated(const Object* object);
+	
+	/**
+	 * Finds the control point of the map's selected objects which is closest
+	 * to the given position, within the given distance.
+	 * 
+	 * The result follows MapEditorTool::findHoverPoint(): At the same
+	 * distance, curve handles are preferred. Returns a handle with a null
+	 * object if there is no control point within the distance.
+	 */
+	Handle findHandle(const Map& map, const MapCoordF& pos, double distance);
+	
+private:
+	void rebuild(const Map& map);
+	
+	SpatialIndex<Handle> handles;
+	std::unordered_set<const Object*> objects;
+	bool valid = false;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_SELECTION_HANDLE_INDEX_H
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2017, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -33,8 +33,10 @@
 #include <QEvent>
 #include <QKeyEvent>
 #include <QRectF>
+#include <QTransform>
 
 #include "core/map.h"
+#include "core/map_part.h"
 #include "core/objects/object.h"
 #include "core/renderables/renderable.h"
 #include "gui/map/map_editor.h"
@@ -42,6 +44,7 @@
 #include "gui/widgets/key_button_bar.h"  // IWYU pragma: keep
 #include "tools/tool_helpers.h"
 #include "undo/object_undo.h"
+#include "util/util.h"
 
 
 #ifdef __clang_analyzer__
@@ -331,6 +334,8 @@ void MapEditorToolBase::updateDirtyRect()
 	QRectF rect;
 	
 	map()->includeSelectionRect(rect);
+	if (!preview_transform.isIdentity() && rect.isValid())
+		rectInclude(rect, preview_transform.mapRect(rect));
 	if (angle_helper->isActive())
 	{
 		angle_helper->includeDirtyRect(rect);
@@ -487,9 +492,21 @@ void MapEditorToolBase::updatePreviewObjectsAsynchronously()
 	}
 }
 
+void MapEditorToolBase::setPreviewTransform(const QTransform& transform)
+{
+	if (transform == preview_transform)
+		return;
+	
+	preview_transform = transform;
+	updateDirtyRect();
+}
+
 void MapEditorToolBase::drawSelectionOrPreviewObjects(QPainter* painter, MapWidget* widget, bool draw_opaque)
 {
-	map()->drawSelection(painter, true, widget, renderables->empty() ? nullptr : renderables.get(), draw_opaque);
+	if (!preview_transform.isIdentity())
+		map()->drawSelection(painter, true, widget, nullptr, draw_opaque, preview_transform);
+	else
+		map()->drawSelection(painter, true, widget, renderables->empty() ? nullptr : renderables.get(), draw_opaque);
 }
 
 
@@ -524,7 +541,7 @@ void MapEditorToolBase::startEditing(Object* object)
 }
 
 
-void MapEditorToolBase::startEditing(const std::set<Object*>& objects)
+void MapEditorToolBase::startEditing(const std::unordered_set<Object*>& objects)
 {
 	Q_ASSERT(!editingInProgress());
 	setEditingInProgress(true);
@@ -557,6 +574,7 @@ void MapEditorToolBase::abortEditing()
 	edited_items.clear();
 	renderables->clear();
 	old_renderables->clear(true);
+	preview_transform.reset();
 	MapEditorTool::setEditingInProgress(false);
 }
 
@@ -565,7 +583,25 @@ void MapEditorToolBase::finishEditing()
 {
 	Q_ASSERT(editingInProgress());
 	
-	if (!edited_items.empty())
+	auto const coords_only = std::all_of(begin(edited_items), end(edited_items), [](const EditedItem& item) {
+		return ObjectCoordsUndoStep::isApplicable(*item.duplicate, *item.active_object);
+	});
+	if (!edited_items.empty() && coords_only)
+	{
+		// Record the changed coordinates only, not copies of the objects.
+		auto part = map()->getCurrentPart();
+		auto undo_step = new ObjectCoordsUndoStep(map());
+		for (auto& edited_item : edited_items)
+		{
+			auto object = edited_item.active_object;
+			object->setMap(map());
+			object->update();
+			undo_step->addObject(part->findObjectIndex(object), *edited_item.duplicate);
+		}
+		edited_items.clear();
+		map()->push(undo_step);
+	}
+	else if (!edited_items.empty())
 	{
 		auto undo_step = new ReplaceObjectsUndoStep(map());
 		for (auto& edited_item : edited_items)
@@ -580,6 +616,7 @@ void MapEditorToolBase::finishEditing()
 	}
 	renderables->clear();
 	old_renderables->clear(true);
+	preview_transform.reset();
 	
 	MapEditorTool::finishEditing();
 	map()->setObjectsDirty();
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2017, 2026 Kai Pastor
  *    
  *    This file is part of OpenOrienteering.
  * 
@@ -23,7 +23,7 @@
 #define OPENORIENTEERING_MAP_EDITOR_TOOL_BASE_H
 
 #include <memory>
-#include <set>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -33,6 +33,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QString>
+#include <QTransform>
 
 #include <QPointer>
 
@@ -229,7 +230,7 @@ protected:
 	/// Takes care of the preview renderables handling, map dirty flag, and objects edited signal.
 	void startEditing();
 	void startEditing(Object* object);
-	void startEditing(const std::set<Object*>& objects);
+	void startEditing(const std::unordered_set<Object*>& objects);
 	void abortEditing();
 	
 	ObjectsRange editedObjects() { return ObjectsRange { edited_items }; }
@@ -243,6 +244,21 @@ protected:
 	/// This method delays the actual redraw by a short amount of time to reduce the load when editing many objects.
 	void updatePreviewObjectsAsynchronously();
 	
+	/**
+	 * Sets a transformation of map coordinates for previewing the edited objects.
+	 * 
+	 * While the transform is not the identity, the renderables which the
+	 * selected objects had when editing started are drawn with this transform
+	 * instead of the preview renderables. This avoids regenerating the
+	 * renderables for every pointer movement when the transformed renderables
+	 * are an exact preview, e.g. when all edited objects are moved as a whole.
+	 * The tool must still apply the actual change to the objects before
+	 * finishEditing().
+	 * 
+	 * The transform is reset by finishEditing() and abortEditing().
+	 */
+	void setPreviewTransform(const QTransform& transform);
+	
 	/// If the tool created custom renderables (e.g. with updatePreviewObjects()), draws the preview renderables,
 	/// else draws the renderables of the selected map objects.
 	void drawSelectionOrPreviewObjects(QPainter* painter, MapWidget* widget, bool draw_opaque = false);
@@ -341,6 +357,7 @@ private:
 	std::unique_ptr<MapRenderables> renderables;
 	std::unique_ptr<MapRenderables> old_renderables;
 	std::vector<EditedItem> edited_items;
+	QTransform preview_transform;
 };
 
 
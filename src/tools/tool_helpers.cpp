@@ -367,7 +367,18 @@ MapCoord SnappingToolHelper::snapToObject(const MapCoordF& position, MapWidget*
 				const PathObject* path = object->asPath();
 				if (filter & ObjectPaths)
 				{
-					auto closest = path->findClosestPointTo(position);
+					// Line borders may be snapped to at a distance from the path.
+					auto search_distance_sq = closest_distance_sq;
+					if (filter & LineBorders)
+					{
+						auto const search_distance = std::sqrt(closest_distance_sq) + path->getSymbol()->calculateLargestLineExtent();
+						search_distance_sq = search_distance * search_distance;
+					}
+					
+					auto closest = path->findClosestPointWithin(position, search_distance_sq);
+					if (closest.distance_squared >= search_distance_sq)
+						continue;
+					
 					if (closest.distance_squared < closest_distance_sq)
 					{
 						closest_distance_sq = closest.distance_squared;
@@ -0,0 +1,296 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lazy_undo_step.h"
+
+#include <utility>
+
+#include <QLatin1String>
+#include <QStringRef>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "core/map.h"
+#include "fileformats/file_format.h"
+
+
+namespace literal
+{
+	const QLatin1String step("step");
+	const QLatin1String type("type");
+	const QLatin1String object("object");
+	const QLatin1String ref("ref");
+	const QLatin1String symbol("symbol");
+}
+
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/**
+ * Copies the child nodes of the step element in data to the writer.
+ */
+void copyStepContent(const QByteArray& data, QXmlStreamWriter& xml)
+{
+	QXmlStreamReader reader(data);
+	if (!reader.readNextStartElement())
+		return;
+	
+	auto depth = 0;
+	while (!reader.atEnd())
+	{
+		reader.readNext();
+		if (reader.isStartElement())
+			++depth;
+		else if (reader.isEndElement() && --depth < 0)
+			break;
+		xml.writeCurrentToken(reader);
+	}
+}
+
+
+}  // namespace
+
+
+
+// ### LazyUndoContext ###
+
+LazyUndoContext::LazyUndoContext(Map* map, const SymbolDictionary& symbol_dict)
+: map(map)
+, symbol_dict(symbol_dict)
+{
+	if (map)
+	{
+		connect(map, &Map::symbolChanged, this, [this](int, const Symbol* new_symbol, const Symbol* old_symbol) {
+			symbolChanged(new_symbol, old_symbol);
+		});
+		connect(map, &Map::symbolDeleted, this, [this](int, const Symbol* old_symbol) {
+			symbolDeleted(old_symbol);
+		});
+	}
+}
+
+LazyUndoContext::~LazyUndoContext() = default;
+
+
+bool LazyUndoContext::symbolIndicesUnchanged() const
+{
+	if (!map)
+		return true;
+	
+	for (int i = 0; i < map->getNumSymbols(); ++i)
+	{
+		if (symbol_dict.value(i) != map->getSymbol(i))
+			return false;
+	}
+	return deleted_ids.isEmpty();
+}
+
+bool LazyUndoContext::referencesDeletedSymbol(const QByteArray& data) const
+{
+	if (deleted_ids.isEmpty())
+		return false;
+	
+	QXmlStreamReader xml(data);
+	while (!xml.atEnd())
+	{
+		if (xml.readNext() == QXmlStreamReader::StartElement
+		    && (xml.name() == literal::object || xml.name() == literal::ref))
+		{
+			bool ok;
+			auto const id = xml.attributes().value(literal::symbol).toInt(&ok);
+			if (ok && deleted_ids.contains(id))
+				return true;
+		}
+	}
+	return false;
+}
+
+
+void LazyUndoContext::symbolChanged(const Symbol* new_symbol, const Symbol* old_symbol)
+{
+	for (auto& symbol : symbol_dict)
+	{
+		if (symbol == old_symbol)
+			symbol = const_cast<Symbol*>(new_symbol);
+	}
+}
+
+void LazyUndoContext::symbolDeleted(const Symbol* old_symbol)
+{
+	for (auto it = symbol_dict.begin(); it != symbol_dict.end(); ++it)
+	{
+		if (it.value() == old_symbol)
+		{
+			it.value() = nullptr;
+			deleted_ids.insert(it.key());
+		}
+	}
+}
+
+
+
+// ### LazyUndoStep ###
+
+// static
+UndoStep* LazyUndoStep::load(QXmlStreamReader& xml, Map* map, const std::shared_ptr<LazyUndoContext>& context)
+{
+	Q_ASSERT(xml.name() == literal::step);
+	
+	auto const type = Type(xml.attributes().value(literal::type).toInt());
+	switch (type)
+	{
+	case CombinedUndoStepType:
+	case ReplaceObjectsUndoStepType:
+	case AddObjectsUndoStepType:
+		break;
+	default:
+		{
+			// Cheap enough to be loaded immediately.
+			auto symbol_dict = context->symbolDictionary();
+			return UndoStep::load(xml, map, symbol_dict);
+		}
+	}
+	
+	QByteArray data;
+	{
+		QXmlStreamWriter writer(&data);
+		writer.writeCurrentToken(xml);
+		for (auto depth = 1; depth > 0 && !xml.atEnd(); )
+		{
+			xml.readNext();
+			if (xml.isStartElement())
+				++depth;
+			else if (xml.isEndElement())
+				--depth;
+			writer.writeCurrentToken(xml);
+		}
+	}
+	
+	return new LazyUndoStep(type, map, std::move(data), context);
+}
+
+
+LazyUndoStep::LazyUndoStep(Type type, Map* map, QByteArray data, std::shared_ptr<LazyUndoContext> context)
+: UndoStep(type, map)
+, data(std::move(data))
+, context(std::move(context))
+{
+	// nothing else
+}
+
+LazyUndoStep::~LazyUndoStep() = default;
+
+
+bool LazyUndoStep::isMaterialized() const
+{
+	return bool(step);
+}
+
+UndoStep* LazyUndoStep::materialize() const
+{
+	if (!step)
+	{
+		auto const data_valid = isValid();
+		QXmlStreamReader xml(data);
+		if (xml.readNextStartElement() && xml.name() == literal::step)
+		{
+			auto symbol_dict = context->symbolDictionary();
+			try
+			{
+				step.reset(UndoStep::load(xml, map, symbol_dict));
+			}
+			catch (FileFormatException& e)
+			{
+				qWarning("%s", qPrintable(e.message()));
+				step.reset();
+			}
+		}
+		if (!step || xml.hasError() || !data_valid)
+			step.reset(new NoOpUndoStep(map, false));
+		data.clear();
+	}
+	return step.get();
+}
+
+
+bool LazyUndoStep::isValid() const
+{
+	if (step)
+		return step->isValid();
+	
+	if (checked_generation != context->generation())
+	{
+		valid = !context->referencesDeletedSymbol(data);
+		checked_generation = context->generation();
+	}
+	return valid;
+}
+
+UndoStep* LazyUndoStep::undo()
+{
+	return materialize()->undo();
+}
+
+UndoStep* LazyUndoStep::makeRedoStep() const
+{
+	return materialize()->makeRedoStep();
+}
+
+bool LazyUndoStep::getModifiedParts(PartSet& out) const
+{
+	return materialize()->getModifiedParts(out);
+}
+
+void LazyUndoStep::getModifiedObjects(int part_index, ObjectSet& out) const
+{
+	materialize()->getModifiedObjects(part_index, out);
+}
+
+std::size_t LazyUndoStep::memoryFootprint() const
+{
+	auto footprint = sizeof(LazyUndoStep) + std::size_t(data.capacity());
+	if (step)
+		footprint += step->memoryFootprint();
+	return footprint;
+}
+
+
+void LazyUndoStep::saveImpl(QXmlStreamWriter& xml) const
+{
+	if (!step && context->symbolIndicesUnchanged())
+	{
+		copyStepContent(data, xml);
+		return;
+	}
+	
+	QByteArray step_data;
+	{
+		QXmlStreamWriter step_writer(&step_data);
+		materialize()->save(step_writer);
+	}
+	copyStepContent(step_data, xml);
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,175 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_LAZY_UNDO_STEP_H
+#define OPENORIENTEERING_LAZY_UNDO_STEP_H
+
+#include <cstddef>
+#include <memory>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QObject>
+#include <QSet>
+
+#include "core/symbols/symbol.h"
+#include "undo/undo.h"
+
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * The symbols referenced by undo steps which were loaded from a file.
+ * 
+ * The dictionary follows symbol changes made after loading. The symbols
+ * which were deleted in the meantime are tracked so that steps referencing
+ * them can be invalidated.
+ */
+class LazyUndoContext : public QObject
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * Constructs a context for the given map and symbol dictionary.
+	 */
+	LazyUndoContext(Map* map, const SymbolDictionary& symbol_dict);
+	
+	~LazyUndoContext() override;
+	
+	/**
+	 * Returns the current dictionary from file symbol IDs to symbols.
+	 */
+	const SymbolDictionary& symbolDictionary() const { return symbol_dict; }
+	
+	/**
+	 * Returns true if the symbol IDs still match the map's symbol indices.
+	 * 
+	 * In this case, stored steps can be saved without change.
+	 */
+	bool symbolIndicesUnchanged() const;
+	
+	/**
+	 * Returns a number which is increased whenever a symbol is deleted.
+	 */
+	int generation() const { return deleted_ids.size(); }
+	
+	/**
+	 * Returns true if the given step data references a deleted symbol.
+	 */
+	bool referencesDeletedSymbol(const QByteArray& data) const;
+
+private:
+	void symbolChanged(const Symbol* new_symbol, const Symbol* old_symbol);
+	
+	void symbolDeleted(const Symbol* old_symbol);
+	
+	Map* const map;
+	SymbolDictionary symbol_dict;
+	QSet<qint32> deleted_ids;
+};
+
+
+
+/**
+ * An undo step which was loaded from a file, but is not yet deserialized.
+ * 
+ * A LazyUndoStep keeps the XML data of the step element. It deserializes
+ * the actual step on first use, i.e. typically when the user undoes that
+ * far. Saving a step which was never used writes the original data again,
+ * unless the symbol indices have changed in the meantime.
+ */
+class LazyUndoStep : public UndoStep
+{
+public:
+	/**
+	 * Loads an undo step from the stream in xml format.
+	 * 
+	 * Undo steps which hold copies of objects are returned as LazyUndoStep.
+	 * Other steps are loaded immediately.
+	 */
+	static UndoStep* load(QXmlStreamReader& xml, Map* map, const std::shared_ptr<LazyUndoContext>& context);
+	
+	/**
+	 * Constructs a lazy undo step of the given type from the given data.
+	 */
+	LazyUndoStep(Type type, Map* map, QByteArray data, std::shared_ptr<LazyUndoContext> context);
+	
+	~LazyUndoStep() override;
+	
+	
+	/**
+	 * Returns true when the actual step has been deserialized.
+	 */
+	bool isMaterialized() const;
+	
+	/**
+	 * Returns the actual step, deserializing it if necessary.
+	 * 
+	 * If the data is broken, returns an invalid NoOpUndoStep.
+	 */
+	UndoStep* materialize() const;
+	
+	
+	/**
+	 * Checks the stored data for references to deleted symbols,
+	 * or returns the actual step's validness.
+	 */
+	bool isValid() const override;
+	
+	UndoStep* undo() override;
+	
+	UndoStep* makeRedoStep() const override;
+	
+	bool getModifiedParts(PartSet& out) const override;
+	
+	void getModifiedObjects(int part_index, ObjectSet& out) const override;
+	
+	/**
+	 * Returns the size of the stored data, or the actual step's footprint.
+	 * 
+	 * This function does not deserialize the step.
+	 */
+	std::size_t memoryFootprint() const override;
+
+
+protected:
+	/**
+	 * Writes the stored data, or the actual step's data.
+	 */
+	void saveImpl(QXmlStreamWriter& xml) const override;
+
+private:
+	mutable QByteArray data;
+	std::shared_ptr<LazyUndoContext> context;
+	mutable std::unique_ptr<UndoStep> step;
+	mutable int checked_generation = 0;
+	mutable bool valid = true;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_LAZY_UNDO_STEP_H
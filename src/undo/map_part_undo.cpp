@@ -115,6 +115,32 @@ UndoStep* MapPartUndoStep::undo()
 	return redo_step;
 }
 
+// virtual
+UndoStep* MapPartUndoStep::makeRedoStep() const
+{
+	MapPartUndoStep* redo_step = nullptr;
+	switch (change)
+	{
+	case AddMapPart:
+		// The part does not exist in the current state.
+		redo_step = new MapPartUndoStep(map);
+		redo_step->change = RemoveMapPart;
+		redo_step->index = index;
+		break;
+	case RemoveMapPart:
+		redo_step = new MapPartUndoStep(map, AddMapPart, index);
+		break;
+	case ModifyMapPart:
+		redo_step = new MapPartUndoStep(map, ModifyMapPart, index);
+		break;
+	case UndefinedChange:
+		break;
+	// default: nothing left (but watch compiler warnings).
+	}
+	
+	return redo_step;
+}
+
 // virtual
 bool MapPartUndoStep::getModifiedParts(PartSet &out) const
 {
@@ -76,6 +76,8 @@ public:
 	bool isValid() const override;
 	
 	UndoStep* undo() override;
+	
+	UndoStep* makeRedoStep() const override;
 
 	bool getModifiedParts(PartSet& out) const override;
 	
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014 Kai Pastor
+ *    Copyright 2014, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,9 +22,19 @@
 #include "object_undo.h"
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+#include <QtGlobal>
+#include <QChar>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include "core/map.h"
 #include "core/objects/object.h"
+#include "core/objects/text_object.h"
 #include "core/symbols/symbol.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_import_export.h"
@@ -36,11 +46,46 @@ namespace literal
 	const QLatin1String source("source");
 	const QLatin1String part("part");
 	const QLatin1String reverse("reverse");
+	const QLatin1String coords_delta("coords_delta");
+	const QLatin1String object("object");
+	const QLatin1String coords("coords");
+	const QLatin1String first("first");
+	const QLatin1String replace("replace");
 }
 
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Returns the approximate amount of memory used by an object which is not
+ * part of the map, i.e. which has no renderables.
+ */
+std::size_t objectFootprint(const Object& object)
+{
+	auto footprint = std::max(sizeof(PathObject), sizeof(TextObject))
+	                 + object.getRawCoordinateVector().capacity() * sizeof(MapCoord);
+	for (auto const& tag : object.tags())
+		footprint += sizeof(KeyValue) + std::size_t(tag.key.size() + tag.value.size()) * sizeof(QChar);
+	switch (object.getType())
+	{
+	case Object::Path:
+		footprint += object.asPath()->parts().capacity() * sizeof(PathPart);
+		break;
+	case Object::Text:
+		footprint += std::size_t(object.asText()->getText().size()) * sizeof(QChar);
+		break;
+	default:
+		break;
+	}
+	return footprint;
+}
+
+}  // namespace
+
+
+
 // ### ObjectModifyingUndoStep ###
 
 ObjectModifyingUndoStep::ObjectModifyingUndoStep(Type type, Map* map)
@@ -79,6 +124,18 @@ void ObjectModifyingUndoStep::addObject(int index)
 	modified_objects.push_back(index);
 }
 
+UndoStep* ObjectModifyingUndoStep::makeRedoStep() const
+{
+	auto* redo_step = new ReplaceObjectsUndoStep(map);
+	redo_step->setPartIndex(part_index);
+	
+	const MapPart* part = map->getPart(part_index);
+	for (int index : modified_objects)
+		redo_step->addObject(index, part->getObject(index)->duplicate());
+	
+	return redo_step;
+}
+
 bool ObjectModifyingUndoStep::getModifiedParts(PartSet& out) const
 {
 	out.insert(getPartIndex());
@@ -98,6 +155,11 @@ void ObjectModifyingUndoStep::getModifiedObjects(int part_index, ObjectSet& out)
 	}
 }
 
+std::size_t ObjectModifyingUndoStep::memoryFootprint() const
+{
+	return sizeof(ObjectModifyingUndoStep) + modified_objects.capacity() * sizeof(int);
+}
+
 
 
 void ObjectModifyingUndoStep::saveImpl(QXmlStreamWriter& xml) const
@@ -209,6 +271,16 @@ void ObjectCreatingUndoStep::getModifiedObjects(int part_index, ObjectSet& out)
 		out.insert(objects.begin(), objects.end());
 }
 
+std::size_t ObjectCreatingUndoStep::memoryFootprint() const
+{
+	auto footprint = ObjectModifyingUndoStep::memoryFootprint()
+	                 + sizeof(ObjectCreatingUndoStep) - sizeof(ObjectModifyingUndoStep)
+	                 + objects.capacity() * sizeof(Object*);
+	for (const auto* object : objects)
+		footprint += objectFootprint(*object);
+	return footprint;
+}
+
 void ObjectCreatingUndoStep::saveImpl(QXmlStreamWriter& xml) const
 {
 	ObjectModifyingUndoStep::saveImpl(xml);
@@ -340,6 +412,18 @@ UndoStep* DeleteObjectsUndoStep::undo()
 	return undo_step;
 }
 
+UndoStep* DeleteObjectsUndoStep::makeRedoStep() const
+{
+	auto* redo_step = new AddObjectsUndoStep(map);
+	redo_step->setPartIndex(getPartIndex());
+	
+	const MapPart* part = map->getPart(getPartIndex());
+	for (int index : modified_objects)
+		redo_step->addObject(index, part->getObject(index)->duplicate());
+	
+	return redo_step;
+}
+
 bool DeleteObjectsUndoStep::getModifiedParts(PartSet&) const
 {
 	return false;
@@ -394,6 +478,16 @@ UndoStep* AddObjectsUndoStep::undo()
 	return undo_step;
 }
 
+UndoStep* AddObjectsUndoStep::makeRedoStep() const
+{
+	auto* redo_step = new DeleteObjectsUndoStep(map);
+	redo_step->setPartIndex(getPartIndex());
+	for (int index : modified_objects)
+		redo_step->addObject(index);
+	
+	return redo_step;
+}
+
 void AddObjectsUndoStep::removeContainedObjects(bool emit_selection_changed)
 {
 	MapPart* part = map->getPart(getPartIndex());
@@ -477,6 +571,39 @@ UndoStep* SwitchPartUndoStep::undo()
 	auto target = map->getPart(getPartIndex());
 	SwitchPartUndoStep* undo = new SwitchPartUndoStep(map, source_index, getPartIndex());
 	undo->modified_objects = modified_objects;
+	
+	// Steps created by reassigning objects list distinct indices in descending
+	// order. Steps created by merging parts list index 0 for every object.
+	// These cases can be done as a whole, keeping the renderables.
+	auto const n = int(modified_objects.size());
+	auto const descending = std::adjacent_find(begin(modified_objects), end(modified_objects), std::less_equal<int>()) == end(modified_objects);
+	auto const all_zero = std::all_of(begin(modified_objects), end(modified_objects), [](auto i) { return i == 0; });
+	if (descending || all_zero)
+	{
+		std::vector<int> indices(modified_objects.size());
+		if (reverse)
+		{
+			// Move back to the end of the source part.
+			if (descending)
+				indices = modified_objects;
+			else
+				std::iota(begin(indices), end(indices), 0);
+			map->transferObjects(std::size_t(getPartIndex()), indices, std::size_t(source_index));
+		}
+		else
+		{
+			// The objects at the end of the source part are in the order of
+			// modified_objects.
+			undo->reverse = true;
+			std::iota(begin(indices), end(indices), source->getNumObjects() - n);
+			auto positions = modified_objects;
+			if (all_zero)
+				std::iota(begin(positions), end(positions), 0);
+			map->transferObjects(std::size_t(source_index), indices, std::size_t(getPartIndex()), positions);
+		}
+		return undo;
+	}
+	
 	if (reverse)
 	{
 		std::for_each(begin(modified_objects), end(modified_objects), [this, source, target](auto i) {
@@ -507,6 +634,15 @@ UndoStep* SwitchPartUndoStep::undo()
 	return undo;
 }
 
+// virtual
+UndoStep* SwitchPartUndoStep::makeRedoStep() const
+{
+	auto* redo_step = new SwitchPartUndoStep(map, source_index, getPartIndex());
+	redo_step->modified_objects = modified_objects;
+	redo_step->reverse = !reverse;
+	return redo_step;
+}
+
 
 // virtual
 void SwitchPartUndoStep::saveImpl(QXmlStreamWriter &xml) const
@@ -724,6 +860,20 @@ UndoStep* ObjectTagsUndoStep::undo()
 	return redo_step;
 }
 
+std::size_t ObjectTagsUndoStep::memoryFootprint() const
+{
+	auto footprint = ObjectModifyingUndoStep::memoryFootprint()
+	                 + sizeof(ObjectTagsUndoStep) - sizeof(ObjectModifyingUndoStep);
+	for (auto const& object_tags : object_tags_map)
+	{
+		// A rough estimate of the map node's size
+		footprint += sizeof(ObjectTagsMap::value_type) + 4 * sizeof(void*);
+		for (auto const& tag : object_tags.second)
+			footprint += sizeof(KeyValue) + std::size_t(tag.key.size() + tag.value.size()) * sizeof(QChar);
+	}
+	return footprint;
+}
+
 // override
 void ObjectTagsUndoStep::saveObject(XmlElementWriter& xml, int index) const
 {
@@ -737,4 +887,219 @@ void ObjectTagsUndoStep::loadObject(XmlElementReader& xml, int index)
 }
 
 
+
+// ### ObjectCoordsUndoStep ###
+
+namespace {
+
+/**
+ * The number of unchanged coordinates which may be included in a range
+ * in order to merge it with the previous range.
+ */
+constexpr MapCoordVector::size_type max_unchanged_gap = 4;
+
+}  // namespace
+
+
+ObjectCoordsUndoStep::ObjectCoordsUndoStep(Map* map)
+: ObjectModifyingUndoStep(ObjectCoordsUndoStepType, map)
+{
+	; // nothing else
+}
+
+ObjectCoordsUndoStep::~ObjectCoordsUndoStep()
+{
+	; // nothing
+}
+
+// static
+bool ObjectCoordsUndoStep::isApplicable(const Object& old_object, const Object& object)
+{
+	if (old_object.getType() != Object::Path || object.getType() != Object::Path)
+		return false;
+	
+	auto const* old_path = old_object.asPath();
+	auto const* path = object.asPath();
+	return old_path->getSymbol() == path->getSymbol()
+	       && old_path->getRotation() == path->getRotation()
+	       && old_path->getPatternOrigin() == path->getPatternOrigin()
+	       && old_path->tags() == path->tags();
+}
+
+void ObjectCoordsUndoStep::addObject(int)
+{
+	qWarning("This implementation must not be called");
+}
+
+void ObjectCoordsUndoStep::addObject(int index, const Object& old_object)
+{
+	using difference_type = MapCoordVector::difference_type;
+	
+	auto const* object = map->getPart(getPartIndex())->getObject(index);
+	Q_ASSERT(isApplicable(old_object, *object));
+	
+	auto const& old_coords = old_object.getRawCoordinateVector();
+	auto const& coords = object->getRawCoordinateVector();
+	CoordsRanges ranges;
+	if (&old_coords == &coords)
+	{
+		// The copy still shares the unmodified coordinates.
+	}
+	else if (old_coords.size() == coords.size())
+	{
+		// The changed coordinates, merged across short gaps
+		for (MapCoordVector::size_type i = 0; i < coords.size(); ++i)
+		{
+			if (coords[i] == old_coords[i])
+				continue;
+			if (!ranges.empty() && i <= ranges.back().first + ranges.back().count + max_unchanged_gap)
+				ranges.back().count = i + 1 - ranges.back().first;
+			else
+				ranges.push_back({i, 1, {}});
+		}
+		for (auto& range : ranges)
+		{
+			auto const range_begin = old_coords.begin() + difference_type(range.first);
+			range.coords.assign(range_begin, range_begin + difference_type(range.count));
+		}
+	}
+	else
+	{
+		// A single range between the common prefix and the common suffix
+		auto const prefix = MapCoordVector::size_type(std::distance(
+		    begin(coords), std::mismatch(begin(coords), end(coords), begin(old_coords), end(old_coords)).first));
+		auto const max_suffix = difference_type(std::min(coords.size(), old_coords.size()) - prefix);
+		auto const suffix = MapCoordVector::size_type(std::distance(
+		    coords.rbegin(), std::mismatch(coords.rbegin(), coords.rbegin() + max_suffix, old_coords.rbegin()).first));
+		ranges.push_back({prefix, coords.size() - prefix - suffix,
+		                  MapCoordVector(old_coords.begin() + difference_type(prefix),
+		                                 old_coords.end() - difference_type(suffix))});
+	}
+	
+	ObjectModifyingUndoStep::addObject(index);
+	object_ranges.push_back(std::move(ranges));
+}
+
+UndoStep* ObjectCoordsUndoStep::undo()
+{
+	using difference_type = MapCoordVector::difference_type;
+	
+	int const part_index = getPartIndex();
+	
+	auto* redo_step = new ObjectCoordsUndoStep(map);
+	redo_step->setPartIndex(part_index);
+	
+	MapPart* part = map->getPart(part_index);
+	auto const size = std::min(modified_objects.size(), object_ranges.size());
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		auto const object_index = modified_objects[i];
+		auto* object = part->getObject(object_index);
+		if (object->getType() != Object::Path)
+			continue;
+		
+		auto* path = object->asPath();
+		CoordsRanges redo_ranges;
+		redo_ranges.reserve(object_ranges[i].size());
+		// Replacing a range may shift the following ranges.
+		difference_type offset = 0;
+		for (auto const& range : object_ranges[i])
+		{
+			auto const& coords = path->getRawCoordinateVector();
+			auto const first = MapCoordVector::size_type(difference_type(range.first) + offset);
+			if (first > coords.size() || range.count > coords.size() - first)
+			{
+				qWarning("ObjectCoordsUndoStep: Coordinates range is out of bounds");
+				break;
+			}
+			
+			auto const range_begin = coords.begin() + difference_type(first);
+			redo_ranges.push_back({first, range.coords.size(),
+			                       MapCoordVector(range_begin, range_begin + difference_type(range.count))});
+			path->replaceCoordinates(first, range.count, range.coords);
+			offset += difference_type(range.coords.size()) - difference_type(range.count);
+		}
+		path->update();
+		
+		redo_step->ObjectModifyingUndoStep::addObject(object_index);
+		redo_step->object_ranges.push_back(std::move(redo_ranges));
+	}
+	
+	return redo_step;
+}
+
+std::size_t ObjectCoordsUndoStep::memoryFootprint() const
+{
+	auto footprint = ObjectModifyingUndoStep::memoryFootprint()
+	                 + sizeof(ObjectCoordsUndoStep) - sizeof(ObjectModifyingUndoStep)
+	                 + object_ranges.capacity() * sizeof(CoordsRanges);
+	for (auto const& ranges : object_ranges)
+	{
+		footprint += ranges.capacity() * sizeof(CoordsRange);
+		for (auto const& range : ranges)
+			footprint += range.coords.capacity() * sizeof(MapCoord);
+	}
+	return footprint;
+}
+
+void ObjectCoordsUndoStep::saveImpl(QXmlStreamWriter& xml) const
+{
+	ObjectModifyingUndoStep::saveImpl(xml);
+	
+	XmlElementWriter element(xml, literal::coords_delta);
+	for (auto const& ranges : object_ranges)
+	{
+		XmlElementWriter object_element(xml, literal::object);
+		for (auto const& range : ranges)
+		{
+			XmlElementWriter coords_element(xml, literal::coords);
+			coords_element.writeAttribute(literal::first, range.first);
+			coords_element.writeAttribute(literal::replace, range.count);
+			coords_element.write(range.coords);
+		}
+	}
+}
+
+void ObjectCoordsUndoStep::loadImpl(QXmlStreamReader& xml, SymbolDictionary& symbol_dict)
+{
+	if (xml.name() == literal::coords_delta)
+	{
+		XmlElementReader element(xml);
+		while (xml.readNextStartElement())
+		{
+			if (xml.name() == literal::object)
+			{
+				XmlElementReader object_element(xml);
+				CoordsRanges ranges;
+				while (xml.readNextStartElement())
+				{
+					if (xml.name() == literal::coords)
+					{
+						XmlElementReader coords_element(xml);
+						CoordsRange range;
+						range.first = coords_element.attribute<std::size_t>(literal::first);
+						range.count = coords_element.attribute<std::size_t>(literal::replace);
+						coords_element.read(range.coords);
+						ranges.push_back(std::move(range));
+					}
+					else
+					{
+						xml.skipCurrentElement(); // unknown
+					}
+				}
+				object_ranges.push_back(std::move(ranges));
+			}
+			else
+			{
+				xml.skipCurrentElement(); // unknown
+			}
+		}
+	}
+	else
+	{
+		ObjectModifyingUndoStep::loadImpl(xml, symbol_dict);
+	}
+}
+
+
 }  // namespace OpenOrienteering
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014, 2015 Kai Pastor
+ *    Copyright 2014, 2015, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -91,6 +91,14 @@ public:
 	virtual void addObject(int index);
 	
 	
+	/**
+	 * Returns a ReplaceObjectsUndoStep with copies of the modified objects.
+	 * 
+	 * This is suitable for all steps which modify objects in place.
+	 */
+	UndoStep* makeRedoStep() const override;
+	
+	
 	/**
 	 * Adds the step's modified part to the container provided by out.
 	 * 
@@ -105,6 +113,11 @@ public:
 	 */
 	void getModifiedObjects(int part_index, ObjectSet& out) const override;
 	
+	/**
+	 * Returns the step's footprint including the list of object indices.
+	 */
+	std::size_t memoryFootprint() const override;
+	
 	
 protected:
 	/**
@@ -213,6 +226,11 @@ public:
 	 */
 	void getModifiedObjects(int, ObjectSet&) const override;
 	
+	/**
+	 * Returns the step's footprint including the copies of the objects.
+	 */
+	std::size_t memoryFootprint() const override;
+	
 	
 public slots:
 	/**
@@ -281,6 +299,11 @@ public:
 	
 	UndoStep* undo() override;
 	
+	/**
+	 * Returns an AddObjectsUndoStep with copies of the referenced objects.
+	 */
+	UndoStep* makeRedoStep() const override;
+	
 	bool getModifiedParts(PartSet& out) const override;
 	
 	void getModifiedObjects(int part_index, ObjectSet& out) const override;
@@ -302,6 +325,11 @@ public:
 	
 	UndoStep* undo() override;
 	
+	/**
+	 * Returns a DeleteObjectsUndoStep for the contained objects' indices.
+	 */
+	UndoStep* makeRedoStep() const override;
+	
 	/**
 	 * Removes all contained objects from the map.
 	 * 
@@ -338,6 +366,8 @@ public:
 	
 	UndoStep* undo() override;
 	
+	UndoStep* makeRedoStep() const override;
+	
 	
 protected:
 	void saveImpl(QXmlStreamWriter& xml) const override;
@@ -418,6 +448,8 @@ public:
 	
 	UndoStep* undo() override;
 	
+	std::size_t memoryFootprint() const override;
+	
 protected:
 	void saveObject(XmlElementWriter& xml, int index) const override;
 	
@@ -429,6 +461,71 @@ protected:
 };
 
 
+
+/**
+ * Undo step which restores the coordinates of path objects.
+ * 
+ * In contrast to ReplaceObjectsUndoStep, this step stores only the ranges of
+ * coordinates which differ from the current state. Editing a few points of
+ * a large path thus needs little memory. This step can be used only when the
+ * objects differ by their coordinates only, as tested by isApplicable().
+ */
+class ObjectCoordsUndoStep : public ObjectModifyingUndoStep
+{
+public:
+	ObjectCoordsUndoStep(Map* map);
+	
+	~ObjectCoordsUndoStep() override;
+	
+	/**
+	 * Returns true if the step can restore old_object from object.
+	 */
+	static bool isApplicable(const Object& old_object, const Object& object);
+	
+	/**
+	 * Must not be called. Use the other overload.
+	 */
+	void addObject(int index) override;
+	
+	/**
+	 * Adds the object with the given index to the step.
+	 * 
+	 * The step records the coordinates of old_object where they differ from
+	 * the coordinates of the object in the map. isApplicable() must be true
+	 * for these objects.
+	 */
+	void addObject(int index, const Object& old_object);
+	
+	UndoStep* undo() override;
+	
+	std::size_t memoryFootprint() const override;
+	
+protected:
+	void saveImpl(QXmlStreamWriter& xml) const override;
+	
+	void loadImpl(QXmlStreamReader& xml, SymbolDictionary& symbol_dict) override;
+	
+	/**
+	 * A range of coordinates to be restored.
+	 * 
+	 * The count coordinates starting at first are replaced by coords.
+	 */
+	struct CoordsRange
+	{
+		MapCoordVector::size_type first;
+		MapCoordVector::size_type count;
+		MapCoordVector coords;
+	};
+	
+	typedef std::vector<CoordsRange> CoordsRanges;
+	
+	/**
+	 * The ascending, disjoint ranges for each of the modified objects.
+	 */
+	std::vector<CoordsRanges> object_ranges;
+};
+
+
 // ### ObjectModifyingUndoStep inline code ###
 
 inline
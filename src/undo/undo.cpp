@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014 Kai Pastor
+ *    Copyright 2014, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,9 @@
 
 #include "undo.h"
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
 #include <vector>
 
 #include <QXmlStreamReader>
@@ -71,6 +74,9 @@ UndoStep* UndoStep::getUndoStepForType(Type type, Map* map)
 	case ObjectTagsUndoStepType:
 		return new ObjectTagsUndoStep(map);
 		
+	case ObjectCoordsUndoStepType:
+		return new ObjectCoordsUndoStep(map);
+		
 	case SwitchPartUndoStepType:
 		return new SwitchPartUndoStep(map);
 		
@@ -103,6 +109,11 @@ bool UndoStep::isValid() const
 	return true;
 }
 
+UndoStep* UndoStep::makeRedoStep() const
+{
+	return nullptr;
+}
+
 bool UndoStep::getModifiedParts(PartSet& out) const
 {
 	Q_UNUSED(out);
@@ -114,6 +125,11 @@ void UndoStep::getModifiedObjects(int, ObjectSet&) const
 	; // nothing
 }
 
+std::size_t UndoStep::memoryFootprint() const
+{
+	return sizeof(UndoStep);
+}
+
 // static
 UndoStep* UndoStep::load(QXmlStreamReader& xml, Map* map, SymbolDictionary& symbol_dict)
 {
@@ -180,6 +196,40 @@ UndoStep* CombinedUndoStep::undo()
 	return undo_step;
 }
 
+UndoStep* CombinedUndoStep::makeRedoStep() const
+{
+	if (steps.size() == 1)
+		return steps.front()->makeRedoStep();
+	
+	auto const modifies_in_place = [](const UndoStep* step) {
+		switch (step->getType())
+		{
+		case ReplaceObjectsUndoStepType:
+		case SwitchSymbolUndoStepType:
+		case SwitchDashesUndoStepType:
+		case ObjectTagsUndoStepType:
+		case ObjectCoordsUndoStepType:
+		case ValidNoOpUndoStepType:
+			return true;
+		default:
+			return false;
+		}
+	};
+	if (!std::all_of(begin(steps), end(steps), modifies_in_place))
+		return nullptr;
+	
+	auto redo_step = std::make_unique<CombinedUndoStep>(map);
+	redo_step->steps.reserve(steps.size());
+	for (const auto* step : steps)
+	{
+		auto* redo_sub_step = step->makeRedoStep();
+		if (!redo_sub_step)
+			return nullptr;
+		redo_step->push(redo_sub_step);
+	}
+	return redo_step.release();
+}
+
 bool CombinedUndoStep::getModifiedParts(PartSet &out) const
 {
 	for (const auto* step : steps)
@@ -197,6 +247,16 @@ void CombinedUndoStep::getModifiedObjects(int part_index, ObjectSet &out) const
 	}
 }
 
+std::size_t CombinedUndoStep::memoryFootprint() const
+{
+	auto footprint = sizeof(CombinedUndoStep) + steps.capacity() * sizeof(UndoStep*);
+	for (const auto* step : steps)
+	{
+		footprint += step->memoryFootprint();
+	}
+	return footprint;
+}
+
 
 
 void CombinedUndoStep::saveImpl(QXmlStreamWriter& xml) const
@@ -274,6 +334,11 @@ UndoStep* NoOpUndoStep::undo()
 	return new NoOpUndoStep(map, true);
 }
 
+UndoStep* NoOpUndoStep::makeRedoStep() const
+{
+	return new NoOpUndoStep(map, true);
+}
+
 
 }  // namespace OpenOrienteering
 
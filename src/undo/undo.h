@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014 Kai Pastor
+ *    Copyright 2014, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,6 +24,7 @@
 
 #include "core/symbols/symbol.h"
 
+#include <cstddef>
 #include <set>
 #include <vector>
 
@@ -67,6 +68,7 @@ public:
 		MapPartUndoStepType        =   8,
 		SwitchPartUndoStepTypeV0   =   9,
 		SwitchPartUndoStepType     =  10,
+		ObjectCoordsUndoStepType   =  11,
 		InvalidUndoStepType        = 999
 	};
 	
@@ -136,6 +138,19 @@ public:
 	 */
 	virtual UndoStep* undo() = 0;
 	
+	/**
+	 * Creates a new UndoStep which repeats the action undone by this step.
+	 * 
+	 * This must be called while the map is in the state which is the input to
+	 * undo(), e.g. right after pushing this step to the undo manager. Unlike
+	 * undo(), this function does not modify the map. The returned step is to
+	 * be applied (by undo()) to the state which this step would produce.
+	 * 
+	 * The default implementation returns nullptr, indicating that the action
+	 * cannot be repeated this way.
+	 */
+	virtual UndoStep* makeRedoStep() const;
+	
 	
 	/**
 	 * Adds the list of the step's modified parts to the container provided by out.
@@ -156,6 +171,16 @@ public:
 	virtual void getModifiedObjects(int part_index, ObjectSet& out) const;
 	
 	
+	/**
+	 * Returns the approximate amount of memory used by this step, in bytes.
+	 * 
+	 * The UndoManager uses this value to keep the undo history within its
+	 * memory budget. The default implementation returns the size of the
+	 * UndoStep object.
+	 */
+	virtual std::size_t memoryFootprint() const;
+	
+	
 	/**
 	 * Loads the undo step from the stream in xml format.
 	 */
@@ -232,6 +257,15 @@ public:
 	 */
 	UndoStep* undo() override;
 	
+	/**
+	 * Returns a step which repeats the action of all sub steps.
+	 * 
+	 * Sub steps may change the object indices seen by the preceding sub steps.
+	 * Thus this returns nullptr unless there is a single sub step, or all sub
+	 * steps only modify objects in place.
+	 */
+	UndoStep* makeRedoStep() const override;
+	
 	
 	/**
 	 * Adds the modified parts of all sub steps to the given set.
@@ -243,6 +277,11 @@ public:
 	 */
 	void getModifiedObjects(int part_index, ObjectSet& out) const override;
 	
+	/**
+	 * Returns the sum of the memory footprints of all sub steps.
+	 */
+	std::size_t memoryFootprint() const override;
+	
 	
 	/** 
 	 * Returns the number of sub steps.
@@ -315,6 +354,11 @@ public:
 	 */
 	UndoStep* undo() override;
 	
+	/**
+	 * Returns a valid NoOpUndoStep.
+	 */
+	UndoStep* makeRedoStep() const override;
+	
 	
 private:
 	bool const valid;
@@ -0,0 +1,263 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "undo_journal.h"
+
+#include <cstring>
+#include <memory>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QStringRef>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "core/map.h"
+#include "core/symbols/symbol.h"
+#include "fileformats/file_format.h"
+#include "undo/undo.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+const char magic[8] = { 'O', 'M', 'A', 'P', 'J', 'R', 'N', 'L' };
+
+const qint64 header_size = sizeof(magic) + sizeof(quint32) + 2 * sizeof(qint64);
+
+
+}  // namespace
+
+
+
+UndoJournal::UndoJournal(Map* map)
+: map(map)
+{
+	// nothing else
+}
+
+UndoJournal::~UndoJournal() = default;
+
+
+// static
+QString UndoJournal::journalPath(const QString& path)
+{
+	return path + QLatin1String(".journal");
+}
+
+// static
+bool UndoJournal::hasChanges(const QString& path)
+{
+	QFile journal_file(journalPath(path));
+	if (!journal_file.open(QIODevice::ReadOnly) || journal_file.size() <= header_size)
+		return false;
+	
+	QDataStream stream(&journal_file);
+	return readHeader(stream, path);
+}
+
+
+bool UndoJournal::start(const QString& path)
+{
+	stop();
+	
+	file.setFileName(journalPath(path));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	
+	QDataStream stream(&file);
+	writeHeader(stream, path);
+	if (stream.status() != QDataStream::Ok || !file.flush())
+	{
+		discard();
+		return false;
+	}
+	return true;
+}
+
+int UndoJournal::resume(const QString& path)
+{
+	stop();
+	
+	file.setFileName(journalPath(path));
+	if (!file.open(QIODevice::ReadWrite))
+		return -1;
+	
+	QDataStream stream(&file);
+	if (!readHeader(stream, path))
+	{
+		file.close();
+		return -1;
+	}
+	
+	SymbolDictionary symbol_dict;
+	symbol_dict.reserve(map->getNumSymbols() + 2);
+	symbol_dict[map->findSymbolIndex(map->getUndefinedPoint())] = map->getUndefinedPoint();
+	symbol_dict[map->findSymbolIndex(map->getUndefinedLine())] = map->getUndefinedLine();
+	for (int i = 0; i < map->getNumSymbols(); ++i)
+		symbol_dict[i] = map->getSymbol(i);
+	
+	auto num_changes = 0;
+	auto valid_size = file.pos();
+	while (!stream.atEnd())
+	{
+		QByteArray record;
+		stream >> record;
+		if (stream.status() != QDataStream::Ok)
+			break;
+		
+		QXmlStreamReader xml(record);
+		if (!xml.readNextStartElement() || xml.name() != QLatin1String("step"))
+			break;
+		
+		std::unique_ptr<UndoStep> step;
+		try
+		{
+			step.reset(UndoStep::load(xml, map, symbol_dict));
+		}
+		catch (FileFormatException& e)
+		{
+			qWarning("%s", qPrintable(e.message()));
+			break;
+		}
+		if (xml.hasError() || !step->isValid())
+			break;
+		
+		// The replayed changes are not added to the undo history.
+		std::unique_ptr<UndoStep> redo_step(step->undo());
+		++num_changes;
+		valid_size = file.pos();
+	}
+	
+	if (!file.resize(valid_size) || !file.seek(valid_size))
+		stop();
+	
+	return num_changes;
+}
+
+void UndoJournal::discard()
+{
+	stop();
+	if (!file.fileName().isEmpty())
+		file.remove();
+}
+
+bool UndoJournal::isRecording() const
+{
+	return file.isOpen();
+}
+
+
+void UndoJournal::recordPushed(const UndoStep& step)
+{
+	if (!isRecording())
+		return;
+	
+	std::unique_ptr<UndoStep> redo_step;
+	if (!hasUnrecordableChanges())
+		redo_step.reset(step.makeRedoStep());
+	
+	if (redo_step)
+		append(*redo_step);
+	else
+		stop();
+}
+
+void UndoJournal::recordExecuted(const UndoStep& step)
+{
+	if (!isRecording())
+		return;
+	
+	if (hasUnrecordableChanges())
+		stop();
+	else
+		append(step);
+}
+
+
+// static
+void UndoJournal::writeHeader(QDataStream& stream, const QString& path)
+{
+	QFileInfo const info(path);
+	stream.setVersion(QDataStream::Qt_5_5);
+	stream.writeRawData(magic, sizeof(magic));
+	stream << current_version
+	       << qint64(info.size())
+	       << qint64(info.lastModified().toMSecsSinceEpoch());
+}
+
+// static
+bool UndoJournal::readHeader(QDataStream& stream, const QString& path)
+{
+	char file_magic[sizeof(magic)];
+	if (stream.readRawData(file_magic, sizeof(magic)) != sizeof(magic)
+	    || std::memcmp(file_magic, magic, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+	
+	quint32 version;
+	qint64 size;
+	qint64 last_modified;
+	stream.setVersion(QDataStream::Qt_5_5);
+	stream >> version >> size >> last_modified;
+	
+	QFileInfo const info(path);
+	return stream.status() == QDataStream::Ok
+	       && version == current_version
+	       && size == info.size()
+	       && last_modified == info.lastModified().toMSecsSinceEpoch();
+}
+
+
+bool UndoJournal::hasUnrecordableChanges() const
+{
+	// Objects refer to colors and symbols by index.
+	return map->areColorsDirty() || map->areSymbolsDirty();
+}
+
+void UndoJournal::append(const UndoStep& step)
+{
+	QByteArray record;
+	{
+		QXmlStreamWriter xml(&record);
+		step.save(xml);
+	}
+	
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_5);
+	stream << record;
+	if (stream.status() != QDataStream::Ok || !file.flush())
+		stop();
+}
+
+void UndoJournal::stop()
+{
+	if (file.isOpen())
+		file.close();
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,167 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_UNDO_JOURNAL_H
+#define OPENORIENTEERING_UNDO_JOURNAL_H
+
+#include <QtGlobal>
+#include <QFile>
+#include <QString>
+
+class QDataStream;
+
+namespace OpenOrienteering {
+
+class Map;
+class UndoStep;
+
+
+/**
+ * An append-only journal of the changes to a saved map.
+ * 
+ * The journal is a file next to the map file. It is started empty when the
+ * map is saved. Each change which is committed to the undo manager is
+ * appended to the journal, as an undo step which repeats the change. After a
+ * crash, the changes can be recovered by loading the map file and replaying
+ * the journal. This is much cheaper than writing the full map for each change.
+ * 
+ * The journal is bound to the size and modification time of the map file.
+ * It stops recording at the first change which it cannot represent, such as
+ * changes to colors or symbols, or an undo step which cannot be repeated.
+ * The changes recorded until then remain available for recovery.
+ */
+class UndoJournal
+{
+public:
+	/**
+	 * The current version of the journal file.
+	 */
+	static constexpr quint32 current_version = 1;
+	
+	
+	/**
+	 * Constructs a journal for the given map, not recording yet.
+	 */
+	explicit UndoJournal(Map* map);
+	
+	UndoJournal(const UndoJournal&) = delete;
+	UndoJournal(UndoJournal&&) = delete;
+	
+	~UndoJournal();
+	
+	UndoJournal& operator=(const UndoJournal&) = delete;
+	UndoJournal& operator=(UndoJournal&&) = delete;
+	
+	
+	/**
+	 * Returns the path of the journal for the given map file.
+	 */
+	static QString journalPath(const QString& path);
+	
+	/**
+	 * Returns true if there is a journal with recorded changes which matches
+	 * the given map file.
+	 */
+	static bool hasChanges(const QString& path);
+	
+	
+	/**
+	 * Starts recording to a new, empty journal for the given map file.
+	 * 
+	 * This is to be called right after the map was saved to this file.
+	 * Returns false if the journal cannot be written.
+	 */
+	bool start(const QString& path);
+	
+	/**
+	 * Replays the journal of the given map file, and continues recording.
+	 * 
+	 * This is to be called right after the map was loaded from this file.
+	 * The replayed changes are not added to the undo history. An incomplete
+	 * record at the end of the journal, e.g. from an interrupted write, is
+	 * dropped.
+	 * 
+	 * Returns the number of replayed changes, or -1 if there is no journal
+	 * which matches the map file.
+	 */
+	int resume(const QString& path);
+	
+	/**
+	 * Stops recording, and removes the journal file.
+	 */
+	void discard();
+	
+	/**
+	 * Returns true while changes are recorded.
+	 */
+	bool isRecording() const;
+	
+	
+	/**
+	 * Records the change which is undone by the given step.
+	 * 
+	 * This is to be called when the step is pushed to the undo manager,
+	 * while the map is still in the state after the change.
+	 */
+	void recordPushed(const UndoStep& step);
+	
+	/**
+	 * Records the change which is done by the given step.
+	 * 
+	 * This is to be called for undo and redo, before executing the step.
+	 */
+	void recordExecuted(const UndoStep& step);
+	
+	
+private:
+	/**
+	 * Writes the header which binds the journal to the map file.
+	 */
+	static void writeHeader(QDataStream& stream, const QString& path);
+	
+	/**
+	 * Reads the header and returns true if it matches the map file.
+	 */
+	static bool readHeader(QDataStream& stream, const QString& path);
+	
+	/**
+	 * Returns true if the map has changes which cannot be recorded.
+	 */
+	bool hasUnrecordableChanges() const;
+	
+	/**
+	 * Appends a record for the given step.
+	 */
+	void append(const UndoStep& step);
+	
+	/**
+	 * Stops recording, but keeps the journal file.
+	 */
+	void stop();
+	
+	
+	Map* const map;
+	QFile file;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_UNDO_JOURNAL_H
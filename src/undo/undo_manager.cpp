@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014-2018 Kai Pastor
+ *    Copyright 2014-2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,6 +24,8 @@
 #include <algorithm>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <set>
 #include <utility>
 
@@ -34,8 +36,12 @@
 #include <QStringRef>
 #include <QXmlStreamReader>
 
+#include "settings.h"
 #include "core/map.h"
+#include "undo/lazy_undo_step.h"
 #include "undo/undo.h"
+#include "undo/undo_journal.h"
+#include "util/trace.h"
 #include "util/xml_stream_util.h"
 
 
@@ -72,7 +78,10 @@ UndoManager::UndoManager(Map* map)
 		connect(map, &Map::symbolDeleted, this, [this]() {
 			validateUndoSteps();
 			validateRedoSteps();
+			updateMemoryUsage();
 		}, Qt::QueuedConnection);
+		connect(&Settings::getInstance(), &Settings::settingsChanged, this, &UndoManager::applySettings);
+		applySettings();
 	}
 }
 
@@ -109,6 +118,9 @@ void UndoManager::push(std::unique_ptr<UndoStep>&& step)
 	
 	clearRedoSteps();
 	
+	if (journal)
+		journal->recordPushed(*step);
+	
 	UndoManager::State const old_state(this);
 	undo_steps.emplace_back(std::move(step));
 	++current_index;
@@ -126,6 +138,7 @@ bool UndoManager::canUndo() const
 
 bool UndoManager::undo(QWidget* dialog_parent)
 {
+	MAPPER_TRACE_SCOPE("UndoManager::undo");
 	UndoManager::State const old_state(this);
 	
 	if (!old_state.can_undo)
@@ -150,13 +163,17 @@ bool UndoManager::undo(QWidget* dialog_parent)
 		}
 	}
 	
+	if (journal)
+		journal->recordExecuted(*step);
+	
 	UndoStep* redo_step = step->undo();
 	updateMapState(step);
 	
 	--current_index;
 	undo_steps[StepList::size_type(current_index)].reset(redo_step);
 	
-	emitChangedSignals(old_state);
+	if (!in_batch)
+		emitChangedSignals(old_state);
 	
 	return true;
 }
@@ -171,6 +188,7 @@ bool UndoManager::canRedo() const
 
 bool UndoManager::redo(QWidget* dialog_parent)
 {
+	MAPPER_TRACE_SCOPE("UndoManager::redo");
 	UndoManager::State const old_state(this);
 	
 	if (!old_state.can_redo)
@@ -187,19 +205,64 @@ bool UndoManager::redo(QWidget* dialog_parent)
 		return false;
 	}
 	
+	if (journal)
+		journal->recordExecuted(*step);
+	
 	UndoStep* undo_step = step->undo();
 	updateMapState(step);
 	
 	undo_steps[StepList::size_type(current_index)].reset(undo_step);
 	++current_index;
 	
-	emitChangedSignals(old_state);
+	if (!in_batch)
+		emitChangedSignals(old_state);
 	
 	return true;
 }
 
 
 
+int UndoManager::index() const
+{
+	return current_index;
+}
+
+
+bool UndoManager::setIndex(int index, QWidget* dialog_parent)
+{
+	MAPPER_TRACE_SCOPE("UndoManager::setIndex");
+	Q_ASSERT(index >= 0 && index <= int(undo_steps.size()));
+	Q_ASSERT(!in_batch);
+	
+	UndoManager::State const old_state(this);
+	if (map)
+		map->beginObjectUpdateBatch();
+	in_batch = true;
+	batch_has_state = false;
+	
+	while (current_index != index)
+	{
+		if (current_index > index ? !(canUndo() && undo(dialog_parent))
+		                          : !(canRedo() && redo(dialog_parent)))
+			break;
+	}
+	
+	in_batch = false;
+	if (map)
+		map->endObjectUpdateBatch();
+	if (batch_has_state)
+	{
+		applyMapState(batch_part_index, batch_selection);
+		batch_selection.clear();
+		batch_has_state = false;
+	}
+	emitChangedSignals(old_state);
+	
+	return current_index == index;
+}
+
+
+
 bool UndoManager::isClean() const
 {
 	return clean_state_index == UndoManager::StepList::difference_type(current_index);
@@ -234,6 +297,13 @@ void UndoManager::setLoaded()
 
 
 
+void UndoManager::setJournal(UndoJournal* journal)
+{
+	this->journal = journal;
+}
+
+
+
 int UndoManager::undoStepCount() const
 {
 	return current_index;
@@ -262,7 +332,7 @@ UndoStep* UndoManager::nextRedoStep() const
 
 
 
-void UndoManager::updateMapState(const UndoStep *step) const
+void UndoManager::updateMapState(const UndoStep *step)
 {
 	// Do nothing for a null map (which is the case for tests)
 	if (!map)
@@ -271,15 +341,35 @@ void UndoManager::updateMapState(const UndoStep *step) const
 	// Make a modified part the current one
 	UndoStep::PartSet result_parts;
 	bool have_modified_objects = step->getModifiedParts(result_parts);
-	if (have_modified_objects && result_parts.find(map->getCurrentPartIndex()) == end(result_parts))
-		map->setCurrentPartIndex(*begin(result_parts));
+	auto part_index = map->getCurrentPartIndex();
+	if (have_modified_objects && result_parts.find(int(part_index)) == end(result_parts))
+		part_index = std::size_t(*begin(result_parts));
 	
-	// Select affected objects and ensure that they are visible
+	// Select affected objects
 	UndoStep::ObjectSet result_objects;
-	step->getModifiedObjects(map->getCurrentPartIndex(), result_objects);
+	step->getModifiedObjects(int(part_index), result_objects);
+	std::vector<Object*> selection { begin(result_objects), end(result_objects) };
+	
+	if (in_batch)
+	{
+		// The objects are not updated before the end of the batch.
+		batch_part_index = part_index;
+		batch_selection = std::move(selection);
+		batch_has_state = true;
+		return;
+	}
+	applyMapState(part_index, selection);
+}
+
+
+void UndoManager::applyMapState(std::size_t part_index, const std::vector<Object*>& selection) const
+{
+	if (part_index != map->getCurrentPartIndex())
+		map->setCurrentPartIndex(part_index);
+	
+	// Select affected objects and ensure that they are visible
 	map->clearObjectSelection(false);
-	for (auto object : result_objects)
-		map->addObjectToSelection(object, false);
+	map->addObjectsToSelection(selection, false);
 	emit map->objectSelectionChanged();
 	
 	map->ensureVisibilityOfSelectedObjects(Map::PartialVisibility);
@@ -309,6 +399,24 @@ void UndoManager::validateUndoSteps()
 		if (current_index > int(max_undo_steps))
 			num_removed_undo_steps += current_index - int(max_undo_steps);
 		
+		if (memory_budget > 0)
+		{
+			// The redo steps and the latest undo step are always kept.
+			auto index = current_index - 1;
+			auto usage = std::accumulate(begin(undo_steps) + index, end(undo_steps), std::size_t(0), [](auto sum, auto&& step) {
+				return sum + step->memoryFootprint();
+			});
+			while (index > num_removed_undo_steps)
+			{
+				auto const footprint = undo_steps[StepList::size_type(index) - 1]->memoryFootprint();
+				if (usage + footprint > memory_budget)
+					break;
+				usage += footprint;
+				--index;
+			}
+			num_removed_undo_steps = index;
+		}
+		
 		auto rfirst = undo_steps.rend() - StepList::difference_type(current_index);
 		Q_ASSERT(rfirst->get() == nextUndoStep());
 		auto rlast = undo_steps.rend() - num_removed_undo_steps;
@@ -379,6 +487,52 @@ void UndoManager::emitChangedSignals(const UndoManager::State& old_state)
 	bool const can_redo = canRedo();
 	if (can_redo != old_state.can_redo)
 		emit canRedoChanged(can_redo);
+	
+	updateMemoryUsage();
+}
+
+void UndoManager::updateMemoryUsage()
+{
+	auto const usage = std::accumulate(begin(undo_steps), end(undo_steps), std::size_t(0), [](auto sum, auto&& step) {
+		return sum + step->memoryFootprint();
+	});
+	if (usage != memory_usage)
+	{
+		memory_usage = usage;
+		emit memoryUsageChanged();
+	}
+}
+
+
+
+std::size_t UndoManager::memoryUsage() const
+{
+	return memory_usage;
+}
+
+
+std::size_t UndoManager::memoryBudget() const
+{
+	return memory_budget;
+}
+
+
+void UndoManager::setMemoryBudget(std::size_t bytes)
+{
+	if (bytes != memory_budget)
+	{
+		UndoManager::State const old_state(this);
+		memory_budget = bytes;
+		validateUndoSteps();
+		emitChangedSignals(old_state);
+	}
+}
+
+
+void UndoManager::applySettings()
+{
+	auto const budget_mb = Settings::getInstance().getSettingCached(Settings::MapEditor_UndoMemoryBudgetMB).toInt();
+	setMemoryBudget(std::size_t(qMax(0, budget_mb)) << 20);
 }
 
 
@@ -447,6 +601,7 @@ void UndoManager::loadUndo(QXmlStreamReader& xml, SymbolDictionary& symbol_dict)
 	using std::swap;
 	swap(undo_steps, loaded_steps);
 	current_index = int(undo_steps.size());
+	validateUndoSteps();
 	setLoaded();
 	setClean();
 	emitChangedSignals(old_state);
@@ -473,10 +628,11 @@ UndoManager::StepList UndoManager::loadSteps(QXmlStreamReader& xml, SymbolDictio
 {
 	StepList steps;
 	steps.reserve(max_undo_steps + 1);
+	auto const context = std::make_shared<LazyUndoContext>(map, symbol_dict);
 	while (xml.readNextStartElement())
 	{
 		if (xml.name() == QLatin1String("step"))
-			steps.emplace_back(UndoStep::load(xml, map, symbol_dict));
+			steps.emplace_back(LazyUndoStep::load(xml, map, context));
 		else
 			xml.skipCurrentElement(); // unknown
 	}
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014, 2017, 2018 Kai Pastor
+ *    Copyright 2014, 2017, 2018, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -39,6 +39,8 @@ class QXmlStreamWriter;
 namespace OpenOrienteering {
 
 class Map;
+class Object;
+class UndoJournal;
 class UndoStep;
 
 
@@ -109,6 +111,30 @@ public:
 	bool redo(QWidget* dialog_parent = nullptr);
 	
 	
+	/**
+	 * Returns the index of the current state.
+	 * 
+	 * This is the number of steps which can be undone, including invalid
+	 * steps, cf. undoStepCount().
+	 */
+	int index() const;
+	
+	/**
+	 * Undoes or redoes steps until the given index is reached.
+	 * 
+	 * The steps are executed in a batch: The affected objects are updated
+	 * together at the end, the map widgets are notified of a single dirty
+	 * area, and the map's selection and the changed signals are set only
+	 * once, from the last executed step.
+	 * 
+	 * Stops at invalid steps and when the user cancels going beyond the
+	 * loaded state, like undo() and redo().
+	 * 
+	 * @returns True if the given index has been reached, false otherwise.
+	 */
+	bool setIndex(int index, QWidget* dialog_parent = nullptr);
+	
+	
 	/**
 	 * Returns true iff the current state is the clean state.
 	 */
@@ -142,6 +168,14 @@ public:
 	void setLoaded();
 	
 	
+	/**
+	 * Sets a journal which records all changes done through this manager.
+	 * 
+	 * The journal is not owned by the manager. Pass nullptr to unset it.
+	 */
+	void setJournal(UndoJournal* journal);
+	
+	
 	/**
 	 * Returns the current number of undo steps.
 	 * 
@@ -184,6 +218,9 @@ public:
 	 * Loads the undo steps from the file in xml format.
 	 * 
 	 * Any existing undo steps and redo steps will be deleted first.
+	 * 
+	 * Steps which hold copies of objects are kept as unparsed data, and
+	 * deserialized when they are actually needed. (See LazyUndoStep.)
 	 */
 	void loadUndo(QXmlStreamReader& xml, SymbolDictionary& symbol_dict);
 	
@@ -196,11 +233,36 @@ public:
 	
 	
 	/**
-	 * The maximum number of steps kept for undo() and redo(), respectively.
+	 * Returns the approximate amount of memory used by all undo and redo steps, in bytes.
+	 * 
+	 * @see UndoStep::memoryFootprint()
+	 */
+	std::size_t memoryUsage() const;
+	
+	/**
+	 * Returns the memory budget for the undo and redo steps, in bytes.
 	 * 
-	 * This limits the amount of memory occupied by undo steps.
+	 * A value of zero means that only the step count is limited.
+	 */
+	std::size_t memoryBudget() const;
+	
+	/**
+	 * Sets the memory budget for the undo and redo steps, in bytes.
+	 * 
+	 * When the steps exceed this budget, the oldest undo steps are removed.
+	 * The latest undo step and all redo steps are always kept.
+	 * A value of zero means that only the step count is limited.
+	 * 
+	 * For an UndoManager of a map, the budget is taken from the settings.
+	 */
+	void setMemoryBudget(std::size_t bytes);
+	
+	
+	/**
+	 * The maximum number of steps kept for undo() and redo(), respectively.
 	 * 
-	 * @todo Make this configurable (maybe by used memory instead of step count)
+	 * This limits the amount of memory occupied by undo steps, in addition
+	 * to the memory budget.
 	 */
 	static constexpr std::size_t max_undo_steps = 128;
 	
@@ -225,6 +287,11 @@ signals:
 	 */
 	void loadedChanged(bool loaded);
 	
+	/**
+	 * This signal is emitted whenever the value of memoryUsage() changes.
+	 */
+	void memoryUsageChanged();
+	
 protected:
 	/**
 	 * A list of UndoSteps.
@@ -242,9 +309,9 @@ protected:
 	 * In order to maintain the validness of current_index etc., this
 	 * method does not remove elements from undo_steps.
 	 * Instead, it replaces steps which are no longer reachable via valid steps,
-	 * or which exceed the max_undo_steps limit, with invalid NoOpUndoStep objects,
-	 * thus releasing the memory which was originally occupied by now obsolete
-	 * undo steps.
+	 * or which exceed the max_undo_steps limit or the memory budget, with
+	 * invalid NoOpUndoStep objects, thus releasing the memory which was
+	 * originally occupied by now obsolete undo steps.
 	 */
 	void validateUndoSteps();
 	
@@ -283,17 +350,35 @@ protected:
 	 */
 	void emitChangedSignals(UndoManager::State const &old_state);
 	
+	/**
+	 * Updates the memory usage, and emits memoryUsageChanged() if needed.
+	 */
+	void updateMemoryUsage();
+	
 	/**
 	 * Set the map's current part and selection from the given undo step.
 	 * 
 	 * This method relies on the step already being applied to the map,
 	 * i.e. all affected parts and objects do exist.
+	 * 
+	 * During setIndex(), the state is only recorded, and it is applied
+	 * at the end of the batch.
+	 */
+	void updateMapState(const UndoStep* step);
+	
+	/**
+	 * Sets the map's current part and selection.
 	 */
-	void updateMapState(const UndoStep* step) const;
+	void applyMapState(std::size_t part_index, const std::vector<Object*>& selection) const;
 	
 private:
 	StepList loadSteps(QXmlStreamReader& xml, SymbolDictionary& symbol_dict) const;
 	
+	/**
+	 * Applies the memory budget from the settings.
+	 */
+	void applySettings();
+	
 	/**
 	 * The list of all steps available for undo() and redo().
 	 * 
@@ -335,6 +420,33 @@ private:
 	 */
 	int loaded_state_index;
 	
+	/**
+	 * The journal which records the changes, or nullptr.
+	 */
+	UndoJournal* journal = nullptr;
+	
+	/**
+	 * The memory budget in bytes, or zero for no budget.
+	 */
+	std::size_t memory_budget = 0;
+	
+	/**
+	 * The map state recorded from the last step executed during setIndex().
+	 */
+	std::vector<Object*> batch_selection;
+	std::size_t batch_part_index = 0;
+	bool batch_has_state = false;
+	
+	/**
+	 * True while setIndex() executes steps.
+	 */
+	bool in_batch = false;
+	
+	/**
+	 * The memory usage as of the last change of the steps.
+	 */
+	std::size_t memory_usage = 0;
+	
 };
 
 
@@ -0,0 +1,135 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dirty_region.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include <QtGlobal>
+
+#include "util/util.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+qreal area(const QRectF& rect)
+{
+	return rect.width() * rect.height();
+}
+
+}  // namespace
+
+
+
+DirtyRegion::DirtyRegion(std::size_t max_rects)
+: max_rects(std::max(max_rects, std::size_t(1)))
+{
+	rects.reserve(this->max_rects + 1);
+}
+
+
+QRectF DirtyRegion::boundingRect() const
+{
+	QRectF result;
+	for (auto const& rect : rects)
+		rectIncludeSafe(result, rect);
+	return result;
+}
+
+
+void DirtyRegion::add(const QRectF& rect)
+{
+	if (!rect.isValid())
+		return;
+	
+	for (auto const& existing : rects)
+	{
+		if (existing.contains(rect))
+			return;
+	}
+	
+	insertDisjoint(rect);
+	
+	while (rects.size() > max_rects)
+	{
+		// Merge the pair which adds the least area.
+		auto best_cost = std::numeric_limits<qreal>::max();
+		auto best = std::make_pair(std::size_t(0), std::size_t(1));
+		for (std::size_t i = 0; i < rects.size(); ++i)
+		{
+			for (auto j = i + 1; j < rects.size(); ++j)
+			{
+				auto const cost = area(rects[i].united(rects[j])) - area(rects[i]) - area(rects[j]);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best = { i, j };
+				}
+			}
+		}
+		
+		auto const merged = rects[best.first].united(rects[best.second]);
+		rects.erase(begin(rects) + std::ptrdiff_t(best.second));
+		rects.erase(begin(rects) + std::ptrdiff_t(best.first));
+		insertDisjoint(merged);
+	}
+}
+
+
+std::vector<QRectF> DirtyRegion::take()
+{
+	std::vector<QRectF> result;
+	result.reserve(max_rects + 1);
+	swap(result, rects);
+	return result;
+}
+
+
+void DirtyRegion::insertDisjoint(QRectF rect)
+{
+	// A merged rectangle may intersect rectangles which were disjoint
+	// from the original rectangles, so repeat until nothing changes.
+	for (auto merged = true; merged; )
+	{
+		merged = false;
+		for (auto it = begin(rects); it != end(rects); )
+		{
+			if (it->intersects(rect))
+			{
+				rect = rect.united(*it);
+				it = rects.erase(it);
+				merged = true;
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+	rects.push_back(rect);
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,99 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_DIRTY_REGION_H
+#define OPENORIENTEERING_DIRTY_REGION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QRectF>
+
+
+namespace OpenOrienteering {
+
+/**
+ * A dirty region made of a small number of disjoint rectangles.
+ *
+ * Unlike a single bounding box, this keeps separate areas separate, so that
+ * e.g. editing objects at opposite corners of a map does not invalidate
+ * everything in between. Overlapping rectangles are merged when they are
+ * added. When the number of rectangles exceeds the limit, the pair of
+ * rectangles is merged which adds the least area to the region.
+ */
+class DirtyRegion
+{
+public:
+	/**
+	 * The default limit for the number of rectangles.
+	 */
+	static constexpr std::size_t default_max_rects = 8;
+	
+	/**
+	 * Constructs an empty region with the given limit for the number of rectangles.
+	 */
+	explicit DirtyRegion(std::size_t max_rects = default_max_rects);
+	
+	/**
+	 * Returns true if the region contains no rectangle.
+	 */
+	bool isEmpty() const { return rects.empty(); }
+	
+	/**
+	 * Returns the disjoint rectangles of the region.
+	 */
+	const std::vector<QRectF>& getRects() const { return rects; }
+	
+	/**
+	 * Returns the bounding box of the region.
+	 */
+	QRectF boundingRect() const;
+	
+	/**
+	 * Adds a rectangle to the region.
+	 * 
+	 * Invalid rectangles are ignored.
+	 */
+	void add(const QRectF& rect);
+	
+	/**
+	 * Removes all rectangles.
+	 */
+	void clear() { rects.clear(); }
+	
+	/**
+	 * Returns the rectangles of the region, and clears the region.
+	 */
+	std::vector<QRectF> take();
+	
+private:
+	/**
+	 * Adds the rectangle after merging all rectangles which intersect it.
+	 */
+	void insertDisjoint(QRectF rect);
+	
+	std::vector<QRectF> rects;
+	std::size_t max_rects;
+	
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_DIRTY_REGION_H
@@ -0,0 +1,235 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "disk_cache.h"
+
+#include <atomic>
+
+#include <Qt>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "util/parallel.h"
+
+
+namespace OpenOrienteering {
+
+namespace DiskCache {
+
+namespace {
+
+struct CategoryInfo
+{
+	const char* directory;
+	const char* name;
+	qint64 max_size;
+};
+
+constexpr qint64 MiB = qint64(1) << 20;
+
+#ifdef Q_OS_ANDROID
+constexpr int size_divisor = 4;
+#else
+constexpr int size_divisor = 1;
+#endif
+
+/// The properties of the categories, in the order of the enum
+const CategoryInfo categories[numCategories()] = {
+    { "symbol-sets",         QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Symbol icons"),          64 * MiB / size_divisor },
+    { "template-thumbnails", QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Template thumbnails"),   32 * MiB / size_divisor },
+    { "ogr-templates",       QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Converted templates"), 1024 * MiB / size_divisor },
+    { "raster-tiles",        QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Raster template tiles"), 1024 * MiB / size_divisor },
+    { "tiles",               QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Tile service tiles"),   512 * MiB / size_divisor },
+    { "extracted",           QT_TRANSLATE_NOOP("OpenOrienteering::DiskCache", "Extracted files"),     1024 * MiB / size_divisor },
+};
+
+/// Pending trim() jobs, cf. scheduleTrim()
+std::atomic<bool> trim_pending[numCategories()];
+
+/// The suffix of entries which are still being written
+const auto partial_suffix = QLatin1String(".part");
+
+/// A file which is recreated to update the time of directory entries
+const auto used_marker = QLatin1String("/.used");
+
+
+qint64 directorySize(const QString& directory)
+{
+	qint64 size = 0;
+	QDirIterator it(directory, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		it.next();
+		size += it.fileInfo().size();
+	}
+	return size;
+}
+
+
+}  // namespace
+
+
+
+QString displayName(Category category)
+{
+	return QCoreApplication::translate("OpenOrienteering::DiskCache", categories[category].name);
+}
+
+
+QString directory(Category category)
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+	       + QLatin1Char('/') + QLatin1String(categories[category].directory);
+}
+
+
+qint64 maxSize(Category category)
+{
+	return categories[category].max_size;
+}
+
+
+QByteArray makeKey(std::initializer_list<QByteArray> parts)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	for (auto const& part : parts)
+		hash.addData(part);
+	return hash.result().toHex();
+}
+
+
+QString entryPath(Category category, const QByteArray& key, const QString& suffix)
+{
+	return directory(category) + QLatin1Char('/') + QString::fromLatin1(key) + suffix;
+}
+
+
+bool write(const QString& path, const std::function<bool (QIODevice&)>& writer)
+{
+	if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+		return false;
+	
+	QSaveFile file(path);
+	return file.open(QIODevice::WriteOnly)
+	       && writer(file)
+	       && file.commit();
+}
+
+
+bool write(const QString& path, const QByteArray& data)
+{
+	return write(path, [&data](QIODevice& device) {
+		return device.write(data) == data.size();
+	});
+}
+
+
+void touch(Category category, const QString& path)
+{
+	auto const root = directory(category);
+	auto const relative_path = QDir(root).relativeFilePath(path);
+	if (relative_path.startsWith(QLatin1String("..")))
+		return;
+	
+	auto const entry = root + QLatin1Char('/') + relative_path.section(QLatin1Char('/'), 0, 0);
+	if (QFileInfo(entry).isDir())
+	{
+		// Creating a file updates the modification time of the directory.
+		QFile marker(entry + used_marker);
+		marker.remove();
+		if (marker.open(QIODevice::WriteOnly))
+			marker.close();
+		return;
+	}
+	
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	QFile file(entry);
+	if (file.open(QIODevice::ReadOnly))
+		file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+#endif
+}
+
+
+qint64 usage(Category category)
+{
+	return directorySize(directory(category));
+}
+
+
+void trim(Category category)
+{
+	auto const max_size = maxSize(category);
+	
+	// Most recently used entries first
+	auto const entries = QDir(directory(category)).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::Time);
+	qint64 total_size = 0;
+	bool keep = true;
+	for (auto const& entry : entries)
+	{
+		if (entry.fileName().endsWith(partial_suffix))
+			continue;
+		
+		// The most recently used entry is kept even if it exceeds the limit.
+		total_size += entry.isDir() ? directorySize(entry.absoluteFilePath()) : entry.size();
+		if (total_size <= max_size || keep)
+		{
+			keep = false;
+			continue;
+		}
+		
+		if (entry.isDir())
+			QDir(entry.absoluteFilePath()).removeRecursively();
+		else
+			QFile::remove(entry.absoluteFilePath());
+	}
+}
+
+
+void scheduleTrim(Category category)
+{
+	if (trim_pending[category].exchange(true))
+		return;
+	
+	Util::startJob<void>([category]() {
+		trim(category);
+		trim_pending[category] = false;
+	});
+}
+
+
+void clear(Category category)
+{
+	QDir(directory(category)).removeRecursively();
+}
+
+
+}  // namespace DiskCache
+
+}  // namespace OpenOrienteering
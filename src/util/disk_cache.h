@@ -0,0 +1,156 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_DISK_CACHE_H
+#define OPENORIENTEERING_DISK_CACHE_H
+
+#include <functional>
+#include <initializer_list>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A persistent cache of generated data, in the application's cache location.
+ * 
+ * The cache is divided into categories. Each category has its own directory
+ * and size limit. Entries are files or directories in the category's
+ * directory, named by a key which is a hash of everything that determines
+ * their contents. So entries never need to be invalidated: changed input
+ * results in a new key, and stale entries are evicted eventually.
+ * 
+ * Eviction removes the least recently used entries when a category exceeds
+ * its size limit. Entries are written atomically, so that readers never see
+ * partial entries. Code which reads an entry marks it as used by touch().
+ * 
+ * These functions may be called concurrently from multiple threads.
+ */
+namespace DiskCache {
+
+/**
+ * The categories of cached data.
+ */
+enum Category
+{
+	SymbolIcons,         ///< Icons of symbol set files
+	TemplateThumbnails,  ///< Previews of template files
+	VectorTemplates,     ///< Vector data templates, converted to Mapper's format
+	RasterTiles,         ///< Warped or decompressed tiles of raster templates
+	ServiceTiles,        ///< Tiles downloaded from online tile services
+	ExtractedFiles,      ///< Template files extracted from archives
+};
+
+/**
+ * The number of categories.
+ */
+constexpr int numCategories() { return ExtractedFiles + 1; }
+
+
+/**
+ * Returns a translated name of the category, for display.
+ */
+QString displayName(Category category);
+
+/**
+ * Returns the directory of the category.
+ * 
+ * The directory is not created by this function.
+ */
+QString directory(Category category);
+
+/**
+ * Returns the maximum total size of the entries of the category, in bytes.
+ */
+qint64 maxSize(Category category);
+
+
+/**
+ * Returns a key for an entry with the given input.
+ * 
+ * The key is the hexadecimal SHA-1 hash of the concatenated parts.
+ */
+QByteArray makeKey(std::initializer_list<QByteArray> parts);
+
+/**
+ * Returns the path of the entry with the given key and suffix.
+ */
+QString entryPath(Category category, const QByteArray& key, const QString& suffix = {});
+
+
+/**
+ * Writes a file atomically.
+ * 
+ * The writer function is called with the opened device, and it shall return
+ * true on success. The file appears at the given path only if the writer
+ * succeeded. Missing directories are created.
+ * 
+ * Returns true on success.
+ */
+bool write(const QString& path, const std::function<bool (QIODevice&)>& writer);
+
+/**
+ * Writes data to a file atomically.
+ * 
+ * Returns true on success.
+ */
+bool write(const QString& path, const QByteArray& data);
+
+/**
+ * Marks the entry containing the given path as recently used.
+ */
+void touch(Category category, const QString& path);
+
+
+/**
+ * Returns the total size of the entries of the category, in bytes.
+ */
+qint64 usage(Category category);
+
+/**
+ * Removes the least recently used entries of the category, until the
+ * category does not exceed its size limit.
+ * 
+ * The most recently used entry is never removed by this function.
+ */
+void trim(Category category);
+
+/**
+ * Calls trim() in a background job.
+ * 
+ * While a job is running for a category, further requests are ignored.
+ */
+void scheduleTrim(Category category);
+
+/**
+ * Removes all entries of the category.
+ */
+void clear(Category category);
+
+
+}  // namespace DiskCache
+
+}  // namespace OpenOrienteering
+
+#endif // OPENORIENTEERING_DISK_CACHE_H
@@ -25,6 +25,16 @@
 
 namespace OpenOrienteering {
 
+QString StringPool::intern(const QString& string)
+{
+	auto item = strings.constFind(string);
+	if (item == strings.constEnd())
+		item = strings.insert(string);
+	return *item;
+}
+
+
+
 bool operator==(const KeyValue& lhs, const KeyValue& rhs)
 {
 	return lhs.key == rhs.key && lhs.value == rhs.value;
@@ -100,4 +110,15 @@ KeyValueContainer::iterator KeyValueContainer::insert_or_assign(iterator hint, c
 }
 
 
+void KeyValueContainer::internStrings(StringPool& pool)
+{
+	for (auto& tag : *this)
+	{
+		tag.key = pool.intern(tag.key);
+		if (tag.value.size() <= max_interned_value_length)
+			tag.value = pool.intern(tag.value);
+	}
+}
+
+
 }  // namespace OpenOrienteering
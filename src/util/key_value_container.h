@@ -24,10 +24,46 @@
 #include <utility>
 #include <vector>
 
+#include <QSet>
 #include <QString>
 
 namespace OpenOrienteering {
 
+/**
+ * A pool of shared strings, for the keys and values of tags.
+ * 
+ * QString is implicitly shared. For equal strings, the pool returns copies of
+ * the same instance, so that the many repetitions of common keys and values
+ * in a map use a single allocation. Comparing copies of the same instance
+ * does not need to compare characters.
+ * 
+ * This class is not thread-safe.
+ */
+class StringPool
+{
+public:
+	/**
+	 * Returns a shared copy of a string in the pool equal to the given string.
+	 * 
+	 * The given string is added to the pool if there is no such string yet.
+	 */
+	QString intern(const QString& string);
+	
+	/**
+	 * Returns the number of strings in the pool.
+	 */
+	int size() const { return strings.size(); }
+	
+	/**
+	 * Removes all strings from the pool.
+	 */
+	void clear() { strings.clear(); }
+	
+private:
+	QSet<QString> strings;
+};
+
+
 struct KeyValue
 {
 	QString key;
@@ -83,6 +119,17 @@ public:
 	/** Inserts a new item if it doesn't already exist, or updates the existing one. */
 	iterator insert_or_assign(iterator hint, const key_type& key, const mapped_type& object);
 	
+	/**
+	 * Replaces the keys and short values with shared copies from the pool.
+	 * 
+	 * Values longer than max_interned_value_length are rarely repeated, so
+	 * they are not added to the pool.
+	 */
+	void internStrings(StringPool& pool);
+	
+	/** The maximum length of values which are added to a StringPool. */
+	static constexpr int max_interned_value_length = 64;
+	
 private:
 	using std::vector<KeyValue>::operator[];
 };
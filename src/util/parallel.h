@@ -0,0 +1,167 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_PARALLEL_H
+#define OPENORIENTEERING_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <utility>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+
+namespace OpenOrienteering {
+
+namespace Util {
+
+/**
+ * The priority of a job started by startJob().
+ * 
+ * Jobs which the user is waiting for are queued before background jobs.
+ */
+enum class JobPriority
+{
+	Background  = 0,  ///< Work ahead of time, e.g. rendering the next pages.
+	Interactive = 1,  ///< Work which the user is waiting for.
+};
+
+
+namespace detail {
+
+/**
+ * A helper job for parallelFor().
+ */
+template <class Work>
+class ParallelForJob : public QRunnable
+{
+public:
+	ParallelForJob(Work& work, QSemaphore& done) noexcept
+	: work(work)
+	, done(done)
+	{}
+
+	void run() override
+	{
+		work();
+		done.release();
+	}
+
+private:
+	Work& work;
+	QSemaphore& done;
+};
+
+
+/**
+ * A helper job for startJob().
+ */
+template <class T>
+class PackagedTaskJob : public QRunnable
+{
+public:
+	explicit PackagedTaskJob(std::packaged_task<T ()>&& task) noexcept
+	: task(std::move(task))
+	{}
+
+	void run() override
+	{
+		task();
+	}
+
+private:
+	std::packaged_task<T ()> task;
+};
+
+}  // namespace detail
+
+
+/**
+ * Runs the function on a thread of the global thread pool, and returns a
+ * future for its result.
+ *
+ * Exceptions thrown by the function are stored in the future. Queued jobs are
+ * started in the order of their priority.
+ */
+template <class T, class Function>
+std::future<T> startJob(Function&& function, JobPriority priority = JobPriority::Background)
+{
+	std::packaged_task<T ()> task(std::forward<Function>(function));
+	auto future = task.get_future();
+	QThreadPool::globalInstance()->start(new detail::PackagedTaskJob<T>(std::move(task)), int(priority));
+	return future;
+}
+
+
+
+/**
+ * Calls the function for consecutive batches of the index range [0, size),
+ * distributed over the threads of the global thread pool.
+ *
+ * The function is called with the begin and end index of a batch. It must
+ * be safe to call it concurrently, for disjoint batches. The calling thread
+ * takes part in the work, and the function returns when all batches are done.
+ * Idle pool threads are used only if they are available immediately, so it is
+ * safe to call this function from pool threads, too.
+ */
+template <class Function>
+void parallelFor(std::size_t size, std::size_t batch_size, Function&& function)
+{
+	batch_size = std::max(batch_size, std::size_t(1));
+	auto const num_batches = (size + batch_size - 1) / batch_size;
+
+	std::atomic<std::size_t> next_batch { 0 };
+	auto work = [&]() {
+		for (auto batch = next_batch++; batch < num_batches; batch = next_batch++)
+		{
+			auto const begin = batch * batch_size;
+			function(begin, std::min(begin + batch_size, size));
+		}
+	};
+
+	using Job = detail::ParallelForJob<decltype(work)>;
+	QSemaphore done;
+	int num_helpers = 0;
+	auto* pool = QThreadPool::globalInstance();
+	for (auto i = std::size_t(1); i < num_batches; ++i)
+	{
+		auto* job = new Job(work, done);
+		if (!pool->tryStart(job))
+		{
+			delete job;
+			break;
+		}
+		++num_helpers;
+	}
+
+	work();
+	done.acquire(num_helpers);
+}
+
+
+}  // namespace Util
+
+}  // namespace OpenOrienteering
+
+#endif
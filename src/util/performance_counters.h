@@ -0,0 +1,65 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_PERFORMANCE_COUNTERS_H
+#define OPENORIENTEERING_PERFORMANCE_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace OpenOrienteering {
+
+namespace Util {
+
+/**
+ * Application-wide counters of expensive operations.
+ * 
+ * The counters only grow. Observers take the difference between two
+ * readings. Hot loops shall count locally and add the result once.
+ */
+struct PerformanceCounters
+{
+	/// Renderables which were checked for drawing.
+	std::atomic<std::uint64_t> renderables_visited { 0 };
+	/// Renderables (and batches of renderables) which were drawn.
+	std::atomic<std::uint64_t> renderables_drawn { 0 };
+	/// Objects whose renderables were generated.
+	std::atomic<std::uint64_t> object_updates { 0 };
+	
+	static PerformanceCounters& instance() noexcept
+	{
+		static PerformanceCounters counters;
+		return counters;
+	}
+	
+	static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+	{
+		if (value)
+			counter.fetch_add(value, std::memory_order_relaxed);
+	}
+};
+
+
+}  // namespace Util
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,459 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_SPATIAL_INDEX_H
+#define OPENORIENTEERING_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+
+namespace OpenOrienteering {
+
+/**
+ * An R-tree for rectangles with associated values.
+ *
+ * The index answers the question which values have a rectangle overlapping
+ * a given query rectangle, without testing all values. Rectangle edges are
+ * treated as closed intervals, so degenerate rectangles (i.e. points and
+ * axis-parallel lines) are found, too. Consequently, query results are a
+ * superset of the results of QRectF::intersects(), and callers which need
+ * the exact QRectF semantics must still test the candidate rectangles.
+ *
+ * A value is identified by the pair of its rectangle and the value itself.
+ * In order to remove or move a value, the caller must provide the exact
+ * rectangle which was used for inserting the value.
+ *
+ * Nodes are split along the longer axis of their entries' centers.
+ * Underfull nodes from removal are dissolved, and their values reinserted.
+ */
+template <class T>
+class SpatialIndex
+{
+public:
+	SpatialIndex();
+	SpatialIndex(const SpatialIndex&) = delete;
+	SpatialIndex(SpatialIndex&&) noexcept = default;
+	~SpatialIndex() = default;
+
+	SpatialIndex& operator=(const SpatialIndex&) = delete;
+	SpatialIndex& operator=(SpatialIndex&&) noexcept = default;
+
+	/** Returns true if there are no values in the index. */
+	bool empty() const noexcept { return count == 0; }
+
+	/** Returns the number of values in the index. */
+	std::size_t size() const noexcept { return count; }
+
+	/** Removes all values from the index. */
+	void clear();
+
+	/** Adds a value with the given rectangle. */
+	void insert(const QRectF& rect, const T& value);
+
+	/**
+	 * Removes a value which was inserted with the given rectangle.
+	 *
+	 * Returns false if the value was not found.
+	 */
+	bool remove(const QRectF& rect, const T& value);
+
+	/**
+	 * Calls the given function for every value whose rectangle overlaps rect.
+	 *
+	 * The order of the calls is unspecified.
+	 * The function must not modify the index.
+	 */
+	template <class Function>
+	void query(const QRectF& rect, Function&& function) const;
+
+	/**
+	 * Returns the values whose rectangles overlap rect.
+	 *
+	 * The order of the values is unspecified.
+	 */
+	std::vector<T> values(const QRectF& rect) const;
+
+	/**
+	 * Returns the bounding box of all rectangles in the index.
+	 *
+	 * Returns a null rectangle when the index is empty.
+	 */
+	QRectF bounds() const;
+
+
+private:
+	/// Axis-aligned box with normalized, closed coordinate intervals.
+	struct Box
+	{
+		qreal left;
+		qreal top;
+		qreal right;
+		qreal bottom;
+
+		explicit Box(const QRectF& rect) noexcept;
+
+		constexpr Box(qreal left, qreal top, qreal right, qreal bottom) noexcept
+		: left(left), top(top), right(right), bottom(bottom)
+		{}
+
+		bool overlaps(const Box& other) const noexcept;
+		bool contains(const Box& other) const noexcept;
+		bool operator==(const Box& other) const noexcept;
+		qreal area() const noexcept;
+		Box united(const Box& other) const noexcept;
+	};
+
+	struct Node
+	{
+		int level = 0;  ///< Zero for leaves.
+		std::vector<Box> boxes;
+		std::vector<T> entries;                       ///< Leaves only
+		std::vector<std::unique_ptr<Node>> children;  ///< Inner nodes only
+
+		explicit Node(int level) : level(level) {}
+		std::size_t size() const noexcept { return boxes.size(); }
+		Box bounds() const noexcept;
+	};
+
+	static constexpr std::size_t max_entries = 16;
+	static constexpr std::size_t min_entries = 6;
+
+	void insertBox(const Box& box, const T& value);
+	std::unique_ptr<Node> insert(Node& node, const Box& box, const T& value);
+	std::unique_ptr<Node> split(Node& node);
+	bool remove(Node& node, const Box& box, const T& value, std::vector<std::pair<Box, T>>& orphans);
+	static void collect(Node& node, std::vector<std::pair<Box, T>>& orphans);
+
+	std::unique_ptr<Node> root;
+	std::size_t count = 0;
+};
+
+
+
+// ### SpatialIndex::Box inline code ###
+
+template <class T>
+SpatialIndex<T>::Box::Box(const QRectF& rect) noexcept
+{
+	auto const r = rect.normalized();
+	left = r.left();
+	top = r.top();
+	right = r.right();
+	bottom = r.bottom();
+}
+
+template <class T>
+bool SpatialIndex<T>::Box::overlaps(const Box& other) const noexcept
+{
+	return left <= other.right && other.left <= right
+	       && top <= other.bottom && other.top <= bottom;
+}
+
+template <class T>
+bool SpatialIndex<T>::Box::contains(const Box& other) const noexcept
+{
+	return left <= other.left && other.right <= right
+	       && top <= other.top && other.bottom <= bottom;
+}
+
+template <class T>
+bool SpatialIndex<T>::Box::operator==(const Box& other) const noexcept
+{
+	return left == other.left && top == other.top
+	       && right == other.right && bottom == other.bottom;
+}
+
+template <class T>
+qreal SpatialIndex<T>::Box::area() const noexcept
+{
+	return (right - left) * (bottom - top);
+}
+
+template <class T>
+typename SpatialIndex<T>::Box SpatialIndex<T>::Box::united(const Box& other) const noexcept
+{
+	return { std::min(left, other.left), std::min(top, other.top),
+	         std::max(right, other.right), std::max(bottom, other.bottom) };
+}
+
+
+
+// ### SpatialIndex::Node inline code ###
+
+template <class T>
+typename SpatialIndex<T>::Box SpatialIndex<T>::Node::bounds() const noexcept
+{
+	Q_ASSERT(!boxes.empty());
+	return std::accumulate(begin(boxes) + 1, end(boxes), boxes.front(), [](const Box& a, const Box& b) {
+		return a.united(b);
+	});
+}
+
+
+
+// ### SpatialIndex inline code ###
+
+template <class T>
+SpatialIndex<T>::SpatialIndex()
+: root(std::make_unique<Node>(0))
+{}
+
+template <class T>
+void SpatialIndex<T>::clear()
+{
+	root = std::make_unique<Node>(0);
+	count = 0;
+}
+
+template <class T>
+void SpatialIndex<T>::insert(const QRectF& rect, const T& value)
+{
+	insertBox(Box(rect), value);
+}
+
+template <class T>
+void SpatialIndex<T>::insertBox(const Box& box, const T& value)
+{
+	if (auto sibling = insert(*root, box, value))
+	{
+		auto new_root = std::make_unique<Node>(root->level + 1);
+		new_root->boxes.push_back(root->bounds());
+		new_root->children.push_back(std::move(root));
+		new_root->boxes.push_back(sibling->bounds());
+		new_root->children.push_back(std::move(sibling));
+		root = std::move(new_root);
+	}
+	++count;
+}
+
+template <class T>
+std::unique_ptr<typename SpatialIndex<T>::Node> SpatialIndex<T>::insert(Node& node, const Box& box, const T& value)
+{
+	if (node.level == 0)
+	{
+		node.boxes.push_back(box);
+		node.entries.push_back(value);
+	}
+	else
+	{
+		// Choose the child which needs least enlargement, then smallest area.
+		auto best = std::size_t(0);
+		auto best_enlargement = qreal(0);
+		auto best_area = qreal(0);
+		for (std::size_t i = 0; i < node.size(); ++i)
+		{
+			auto const area = node.boxes[i].area();
+			auto const enlargement = node.boxes[i].united(box).area() - area;
+			if (i == 0
+			    || enlargement < best_enlargement
+			    || (enlargement == best_enlargement && area < best_area))
+			{
+				best = i;
+				best_enlargement = enlargement;
+				best_area = area;
+			}
+		}
+
+		auto& child = *node.children[best];
+		auto sibling = insert(child, box, value);
+		node.boxes[best] = child.bounds();
+		if (sibling)
+		{
+			node.boxes.push_back(sibling->bounds());
+			node.children.push_back(std::move(sibling));
+		}
+	}
+
+	if (node.size() > max_entries)
+		return split(node);
+	return {};
+}
+
+template <class T>
+std::unique_ptr<typename SpatialIndex<T>::Node> SpatialIndex<T>::split(Node& node)
+{
+	auto const& boxes = node.boxes;
+	auto const total = node.bounds();
+
+	auto order = std::vector<std::size_t>(node.size());
+	std::iota(begin(order), end(order), std::size_t(0));
+	if (total.right - total.left >= total.bottom - total.top)
+	{
+		std::sort(begin(order), end(order), [&boxes](auto a, auto b) {
+			return boxes[a].left + boxes[a].right < boxes[b].left + boxes[b].right;
+		});
+	}
+	else
+	{
+		std::sort(begin(order), end(order), [&boxes](auto a, auto b) {
+			return boxes[a].top + boxes[a].bottom < boxes[b].top + boxes[b].bottom;
+		});
+	}
+
+	auto lower = Node(node.level);
+	auto upper = std::make_unique<Node>(node.level);
+	auto const half = order.size() / 2;
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		auto& target = (i < half) ? lower : *upper;
+		auto const index = order[i];
+		target.boxes.push_back(node.boxes[index]);
+		if (node.level == 0)
+			target.entries.push_back(std::move(node.entries[index]));
+		else
+			target.children.push_back(std::move(node.children[index]));
+	}
+	node = std::move(lower);
+	return upper;
+}
+
+template <class T>
+bool SpatialIndex<T>::remove(const QRectF& rect, const T& value)
+{
+	auto orphans = std::vector<std::pair<Box, T>>();
+	if (!remove(*root, Box(rect), value, orphans))
+		return false;
+
+	--count;
+	while (root->level > 0 && root->size() == 1)
+	{
+		auto child = std::move(root->children.front());
+		root = std::move(child);
+	}
+	if (root->size() == 0)
+		root = std::make_unique<Node>(0);
+
+	count -= orphans.size();
+	for (auto const& orphan : orphans)
+		insertBox(orphan.first, orphan.second);
+	return true;
+}
+
+template <class T>
+bool SpatialIndex<T>::remove(Node& node, const Box& box, const T& value, std::vector<std::pair<Box, T>>& orphans)
+{
+	if (node.level == 0)
+	{
+		for (std::size_t i = 0; i < node.size(); ++i)
+		{
+			if (node.entries[i] == value && node.boxes[i] == box)
+			{
+				node.boxes.erase(node.boxes.begin() + std::ptrdiff_t(i));
+				node.entries.erase(node.entries.begin() + std::ptrdiff_t(i));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	for (std::size_t i = 0; i < node.size(); ++i)
+	{
+		if (!node.boxes[i].contains(box))
+			continue;
+
+		auto& child = *node.children[i];
+		if (!remove(child, box, value, orphans))
+			continue;
+
+		if (child.size() < min_entries)
+		{
+			collect(child, orphans);
+			node.boxes.erase(node.boxes.begin() + std::ptrdiff_t(i));
+			node.children.erase(node.children.begin() + std::ptrdiff_t(i));
+		}
+		else
+		{
+			node.boxes[i] = child.bounds();
+		}
+		return true;
+	}
+	return false;
+}
+
+// static
+template <class T>
+void SpatialIndex<T>::collect(Node& node, std::vector<std::pair<Box, T>>& orphans)
+{
+	if (node.level == 0)
+	{
+		for (std::size_t i = 0; i < node.size(); ++i)
+			orphans.emplace_back(node.boxes[i], std::move(node.entries[i]));
+	}
+	else
+	{
+		for (auto& child : node.children)
+			collect(*child, orphans);
+	}
+}
+
+template <class T>
+template <class Function>
+void SpatialIndex<T>::query(const QRectF& rect, Function&& function) const
+{
+	if (count == 0)
+		return;
+
+	auto const box = Box(rect);
+	auto pending = std::vector<const Node*>{ root.get() };
+	while (!pending.empty())
+	{
+		auto const* node = pending.back();
+		pending.pop_back();
+		for (std::size_t i = 0; i < node->size(); ++i)
+		{
+			if (!node->boxes[i].overlaps(box))
+				continue;
+			if (node->level == 0)
+				function(node->entries[i]);
+			else
+				pending.push_back(node->children[i].get());
+		}
+	}
+}
+
+template <class T>
+std::vector<T> SpatialIndex<T>::values(const QRectF& rect) const
+{
+	auto result = std::vector<T>();
+	query(rect, [&result](const T& value) { result.push_back(value); });
+	return result;
+}
+
+template <class T>
+QRectF SpatialIndex<T>::bounds() const
+{
+	if (root->size() == 0)
+		return {};
+	auto const box = root->bounds();
+	return { QPointF{box.left, box.top}, QPointF{box.right, box.bottom} };
+}
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ratio>
+#include <vector>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QLatin1String>
+#include <QSaveFile>
+#include <QString>
+#include <QThread>
+
+
+namespace OpenOrienteering {
+
+namespace Trace {
+
+namespace detail {
+
+std::atomic<bool> recording { false };
+
+}  // namespace detail
+
+
+namespace {
+
+struct Event
+{
+	const char* name;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point end;
+	qint64 value;       ///< The value of a counter event
+	bool is_counter;
+};
+
+/**
+ * The events of a single thread.
+ * 
+ * Only the owning thread writes events. The size is published with release
+ * semantics, so that the events up to the size can be read by another thread.
+ * When a new recording starts, the owning thread resets its buffer on the
+ * next event.
+ */
+struct ThreadBuffer
+{
+	static constexpr std::size_t capacity = 100000;
+	
+	std::unique_ptr<Event[]> events { new Event[capacity] };
+	std::atomic<std::size_t> size { 0 };
+	std::atomic<int> session { 0 };
+	std::atomic<bool> finished { false };  ///< Set when the thread exits.
+	int thread_id = 0;
+	QByteArray thread_name;
+};
+
+struct Registry
+{
+	std::mutex mutex;  // Guards the buffers, and serializes start and stop.
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	std::atomic<int> session { 0 };
+	std::atomic<std::size_t> dropped { 0 };
+	std::chrono::steady_clock::time_point epoch;
+	int next_thread_id = 1;
+};
+
+Registry& registry()
+{
+	// Not destroyed, so that spans may end during static destruction.
+	static auto* instance = new Registry();
+	return *instance;
+}
+
+/**
+ * Marks the thread's buffer as finished when the thread exits.
+ */
+struct ThreadExitGuard
+{
+	ThreadBuffer* buffer = nullptr;
+	bool* exited = nullptr;
+	
+	~ThreadExitGuard()
+	{
+		*exited = true;
+		if (buffer)
+			buffer->finished.store(true, std::memory_order_release);
+	}
+};
+
+/**
+ * Returns the calling thread's buffer, or nullptr after thread-local
+ * destruction.
+ * 
+ * Locks the registry only on the first event of a thread.
+ */
+ThreadBuffer* threadBuffer()
+{
+	// Trivial types, not destroyed on thread exit
+	thread_local ThreadBuffer* buffer = nullptr;
+	thread_local bool exited = false;
+	if (!buffer && !exited)
+	{
+		thread_local ThreadExitGuard guard;
+		guard.exited = &exited;
+		
+		auto new_buffer = std::make_unique<ThreadBuffer>();
+		buffer = new_buffer.get();
+		auto* thread = QThread::currentThread();
+		auto const is_main_thread = QCoreApplication::instance()
+		                            && thread == QCoreApplication::instance()->thread();
+		buffer->thread_name = is_main_thread ? QByteArray("Main") : thread->objectName().toUtf8();
+		
+		auto& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		buffer->thread_id = r.next_thread_id++;
+		if (buffer->thread_name.isEmpty())
+			buffer->thread_name = "Thread " + QByteArray::number(buffer->thread_id);
+		r.buffers.push_back(std::move(new_buffer));
+		guard.buffer = buffer;
+	}
+	return exited ? nullptr : buffer;
+}
+
+void appendEscaped(QByteArray& out, const char* text)
+{
+	for (; *text; ++text)
+	{
+		if (*text == '"' || *text == '\\')
+			out.append('\\');
+		out.append(*text);
+	}
+}
+
+void appendMicroseconds(QByteArray& out, std::chrono::steady_clock::duration duration)
+{
+	auto const us = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count();
+	out.append(QByteArray::number(us, 'f', 3));
+}
+
+}  // namespace
+
+
+
+void startRecording()
+{
+	auto& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	if (detail::recording.load())
+		return;
+	
+	// Forget the buffers of finished threads.
+	r.buffers.erase(std::remove_if(begin(r.buffers), end(r.buffers), [](auto const& buffer) {
+		return buffer->finished.load(std::memory_order_acquire);
+	}), end(r.buffers));
+	
+	r.epoch = std::chrono::steady_clock::now();
+	r.dropped.store(0, std::memory_order_relaxed);
+	r.session.fetch_add(1, std::memory_order_release);
+	detail::recording.store(true);
+}
+
+
+bool stopRecording(const QString& path)
+{
+	auto& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	if (!detail::recording.exchange(false))
+		return false;
+	
+	auto const session = r.session.load(std::memory_order_relaxed);
+	auto const pid = QByteArray::number(QCoreApplication::applicationPid());
+	
+	QByteArray out;
+	out.reserve(1 << 20);
+	out.append("{\"traceEvents\":[\n");
+	auto first = true;
+	for (auto const& buffer : r.buffers)
+	{
+		if (buffer->session.load(std::memory_order_acquire) != session)
+			continue;
+		
+		auto const tid = QByteArray::number(buffer->thread_id);
+		if (!first)
+			out.append(",\n");
+		first = false;
+		out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":\"");
+		appendEscaped(out, buffer->thread_name.constData());
+		out.append("\"}}");
+		
+		auto const size = buffer->size.load(std::memory_order_acquire);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			auto const& event = buffer->events[i];
+			out.append(event.is_counter ? ",\n{\"ph\":\"C\",\"name\":\"" : ",\n{\"ph\":\"X\",\"name\":\"");
+			appendEscaped(out, event.name);
+			out.append("\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":");
+			appendMicroseconds(out, event.start - r.epoch);
+			if (event.is_counter)
+			{
+				out.append(",\"args\":{\"value\":" + QByteArray::number(event.value) + "}}");
+				continue;
+			}
+			out.append(",\"dur\":");
+			appendMicroseconds(out, event.end - event.start);
+			out.append('}');
+		}
+	}
+	out.append("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":");
+	out.append(QByteArray::number(qulonglong(r.dropped.load(std::memory_order_relaxed))));
+	out.append("}}\n");
+	
+	QSaveFile file(path);
+	return file.open(QIODevice::WriteOnly)
+	       && file.write(out) == out.size()
+	       && file.commit();
+}
+
+
+QString defaultFilePath()
+{
+	return QDir::temp().absoluteFilePath(QLatin1String("Mapper-trace.json"));
+}
+
+
+namespace {
+
+void recordEvent(const Event& event)
+{
+	auto& r = registry();
+	auto* const buffer_ptr = threadBuffer();
+	if (!buffer_ptr)
+		return;
+	
+	auto& buffer = *buffer_ptr;
+	auto const session = r.session.load(std::memory_order_acquire);
+	if (buffer.session.load(std::memory_order_relaxed) != session)
+	{
+		buffer.size.store(0, std::memory_order_relaxed);
+		buffer.session.store(session, std::memory_order_release);
+	}
+	
+	auto const size = buffer.size.load(std::memory_order_relaxed);
+	if (size == ThreadBuffer::capacity)
+	{
+		r.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer.events[size] = event;
+	buffer.size.store(size + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+
+// static
+void Span::record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	recordEvent({ name, start, end, 0, false });
+}
+
+
+void detail::recordCounter(const char* name, qint64 value)
+{
+	auto const now = std::chrono::steady_clock::now();
+	recordEvent({ name, now, now, value, true });
+}
+
+
+}  // namespace Trace
+
+}  // namespace OpenOrienteering
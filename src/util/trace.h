@@ -0,0 +1,149 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TRACE_H
+#define OPENORIENTEERING_TRACE_H
+
+#include <atomic>
+#include <chrono>
+
+#include <QtGlobal>
+
+class QString;
+
+
+namespace OpenOrienteering {
+
+/**
+ * Lightweight recording of timed spans for performance analysis.
+ * 
+ * Spans are recorded by MAPPER_TRACE_SCOPE(name), into per-thread buffers
+ * which are written without locking. When recording is stopped, the spans
+ * are saved in the Chrome trace event format, which can be loaded in
+ * chrome://tracing or https://ui.perfetto.dev.
+ * 
+ * When recording is not active, a span costs a single atomic load.
+ * When Mapper is built without MAPPER_ENABLE_TRACING, the macros expand to
+ * nothing.
+ */
+namespace Trace {
+
+namespace detail {
+
+extern std::atomic<bool> recording;
+
+void recordCounter(const char* name, qint64 value);
+
+}  // namespace detail
+
+
+/**
+ * Returns true when spans are recorded.
+ */
+inline bool isRecording() noexcept
+{
+	return detail::recording.load(std::memory_order_relaxed);
+}
+
+/**
+ * Starts recording spans.
+ * 
+ * Spans from a previous recording are discarded.
+ */
+void startRecording();
+
+/**
+ * Stops recording, and saves the spans to the given file.
+ * 
+ * Returns false on error.
+ */
+bool stopRecording(const QString& path);
+
+/**
+ * Returns the file which is used for the application setting.
+ */
+QString defaultFilePath();
+
+
+/**
+ * Records the current value of a counter while recording.
+ * 
+ * The name must be a string literal, or otherwise stay valid until the end
+ * of the program.
+ */
+inline void counter(const char* name, qint64 value)
+{
+	if (isRecording())
+		detail::recordCounter(name, value);
+}
+
+
+/**
+ * Records the time between construction and destruction while recording.
+ * 
+ * The name must be a string literal, or otherwise stay valid until the end
+ * of the program.
+ */
+class Span
+{
+public:
+	explicit Span(const char* name) noexcept
+	: name(isRecording() ? name : nullptr)
+	{
+		if (this->name)
+			start = std::chrono::steady_clock::now();
+	}
+	
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+	
+	~Span()
+	{
+		if (name)
+			record(name, start, std::chrono::steady_clock::now());
+	}
+	
+private:
+	static void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+	
+	const char* name;
+	std::chrono::steady_clock::time_point start;
+};
+
+
+}  // namespace Trace
+
+}  // namespace OpenOrienteering
+
+
+#ifdef MAPPER_ENABLE_TRACING
+#  define MAPPER_TRACE_CONCAT_(a, b) a ## b
+#  define MAPPER_TRACE_CONCAT(a, b) MAPPER_TRACE_CONCAT_(a, b)
+/**
+ * Records a span from this statement to the end of the enclosing scope.
+ */
+#  define MAPPER_TRACE_SCOPE(name) \
+	::OpenOrienteering::Trace::Span MAPPER_TRACE_CONCAT(mapper_trace_span_, __LINE__) { name }
+#else
+#  define MAPPER_TRACE_SCOPE(name) do { } while (false)
+#endif
+
+
+#endif
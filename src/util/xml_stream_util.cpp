@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <exception>
 #include <limits>
 #include <stdexcept>
@@ -170,20 +171,133 @@ bool XmlRecoveryHelper::operator() ()
 
 
 
+namespace {
+
+/**
+ * Maps signed deltas to unsigned values, small magnitudes to small values.
+ */
+constexpr quint64 zigzag(qint64 value)
+{
+	return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+constexpr qint64 unzigzag(quint64 value)
+{
+	return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+void appendVarint(QByteArray& data, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		data.append(char(value | 0x80));
+		value >>= 7;
+	}
+	data.append(char(value));
+}
+
+/**
+ * Encodes coordinates in the compact delta encoding.
+ * 
+ * For each coordinate, the differences to the previous coordinate's native
+ * x and y are written as zigzag varints. The lowest bit of the x value
+ * indicates a following varint for the flags. The resulting bytes are
+ * encoded as base64.
+ */
+QByteArray encodeDeltaCoords(const MapCoordVector& coords)
+{
+	QByteArray data;
+	data.reserve(int(std::min(coords.size(), std::size_t(500000))) * 6);
+	qint64 x = 0;
+	qint64 y = 0;
+	for (auto const& coord : coords)
+	{
+		auto const flags = coord.flags();
+		appendVarint(data, (zigzag(coord.nativeX() - x) << 1) | (flags ? 1 : 0));
+		appendVarint(data, zigzag(coord.nativeY() - y));
+		if (flags)
+			appendVarint(data, quint64(flags));
+		x = coord.nativeX();
+		y = coord.nativeY();
+	}
+	return data.toBase64();
+}
+
+/**
+ * Decodes coordinates in the compact delta encoding.
+ * 
+ * Calls the given function with the native x and y and with the flags of
+ * each coordinate. Throws FileFormatException on broken data.
+ */
+template <class Function>
+void decodeDeltaCoords(const QStringRef& text, Function&& function)
+{
+	auto const data = QByteArray::fromBase64(text.toLatin1());
+	auto const* current = reinterpret_cast<const quint8*>(data.constData());
+	auto const* const end = current + data.size();
+	auto const read_varint = [&current, end]() {
+		quint64 value = 0;
+		for (int shift = 0; shift < 64 && current != end; shift += 7)
+		{
+			auto const byte = *current++;
+			value |= quint64(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+	};
+	
+	quint64 x = 0;
+	quint64 y = 0;
+	while (current != end)
+	{
+		auto const head = read_varint();
+		// Unsigned arithmetic: broken data must not cause overflow.
+		x += quint64(unzigzag(head >> 1));
+		y += quint64(unzigzag(read_varint()));
+		auto const flags = (head & 1) ? MapCoord::Flags::Int(read_varint()) : MapCoord::Flags::Int(0);
+		function(qint64(x), qint64(y), MapCoord::Flags{flags});
+	}
+}
+
+}  // namespace
+
+
+
 //### XmlElementWriter ###
 
 void XmlElementWriter::write(const MapCoordVector& coords)
+{
+	write(coords, XMLFileFormat::active_version);
+}
+
+void XmlElementWriter::write(const MapCoordVector& coords, int format_version)
 {
 	namespace literal = XmlStreamLiteral;
 	
 	writeAttribute(literal::count, coords.size());
 	
-	if (XMLFileFormat::active_version < 6 || xml.autoFormatting())
+	if (format_version < 6 || xml.autoFormatting())
 	{
 		// XMAP files and old format: syntactically rich output
 		for (auto& coord : coords)
 			coord.save(xml);
 	}
+	else if (format_version >= 10)
+	{
+		// Compact delta encoding, base64 needs no escaping
+		writeAttribute(literal::encoding, literal::delta);
+		auto const data = encodeDeltaCoords(coords);
+		if (auto* device = xml.device())
+		{
+			xml.writeCharacters({});  // Finish the start element
+			device->write(data);
+		}
+		else
+		{
+			xml.writeCharacters(QString::fromLatin1(data));
+		}
+	}
 	else if (auto* device = xml.device())
 	{
 		// Default: efficient plain text format
@@ -217,16 +331,99 @@ void OpenOrienteering::XmlElementWriter::write(const KeyValueContainer& tags)
 
 
 
+namespace {
+
+/**
+ * Decodes coordinates from the simple text format, appending to coords.
+ */
+void decodeCoords(QStringRef text, MapCoordVector& coords)
+{
+	try
+	{
+		while (text.length())
+		{
+			coords.emplace_back(text);
+		}
+	}
+	catch (std::exception& e)
+	{
+		Q_UNUSED(e)
+		qDebug("Could not parse the coordinates: %s", e.what());
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+	}
+}
+
+/**
+ * Decodes coordinates from the simple text format or from the compact
+ * delta encoding, appending to coords.
+ */
+void decodeCoords(QStringRef text, MapCoordVector& coords, bool delta_encoded)
+{
+	if (!delta_encoded)
+	{
+		decodeCoords(text, coords);
+		return;
+	}
+	
+	try
+	{
+		decodeDeltaCoords(text, [&coords](qint64 x, qint64 y, MapCoord::Flags flags) {
+			coords.push_back(MapCoord::loadNative64(x, y, flags));
+		});
+	}
+	catch (std::range_error& e)
+	{
+		Q_UNUSED(e)
+		qDebug("Could not parse the coordinates: %s", e.what());
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
+	}
+}
+
+}  // namespace
+
+
+
+//### DeferredCoords ###
+
+void DeferredCoords::decode(MapCoordVector& coords) const
+{
+	coords.reserve(std::min(count, 500000u));
+	decodeCoords(QStringRef(&text), coords, delta_encoded);
+	if (coords.size() != count)
+	{
+		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Expected %1 coordinates, found %2.").arg(count).arg(coords.size()));
+	}
+}
+
+
+
 //### XmlElementReader ###
 
 void XmlElementReader::read(MapCoordVector& coords)
+{
+	read(coords, nullptr);
+}
+
+
+void XmlElementReader::read(MapCoordVector& coords, DeferredCoords* deferred)
 {
 	namespace literal = XmlStreamLiteral;
 	
 	coords.clear();
 	
 	const auto num_coords = attribute<unsigned int>(literal::count);
-	coords.reserve(std::min(num_coords, 500000u));
+	const auto delta_encoded = attribute<QStringRef>(literal::encoding) == literal::delta;
+	QString delta_text;  // The delta encoding must be decoded as a whole.
+	if (deferred)
+	{
+		deferred->text.clear();
+		deferred->count = num_coords;
+		deferred->delta_encoded = delta_encoded;
+	}
+	else
+	{
+		coords.reserve(std::min(num_coords, 500000u));
+	}
 	
 	try
 	{
@@ -239,25 +436,30 @@ void XmlElementReader::read(MapCoordVector& coords)
 			}
 			else if (token == QXmlStreamReader::Characters && !xml.isWhitespace())
 			{
-				QStringRef text = xml.text();
-				try
-				{
-					while (text.length())
-					{
-						coords.emplace_back(text);
-					}
-				}
-				catch (std::exception& e)
-				{
-					Q_UNUSED(e)
-					qDebug("Could not parse the coordinates: %s", e.what());
-					throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
-				}
+				if (deferred)
+					deferred->text.append(xml.text());
+				else if (delta_encoded)
+					delta_text.append(xml.text());
+				else
+					decodeCoords(xml.text(), coords);
 			}
 			else if (token == QXmlStreamReader::StartElement)
 			{
 				if (xml.name() == literal::coord)
 				{
+					if (deferred)
+					{
+						// Rich XML must be read now, so the order requires
+						// decoding the text read so far, too.
+						decodeCoords(QStringRef(&deferred->text), coords, delta_encoded);
+						deferred->text.clear();
+						deferred = nullptr;
+					}
+					else if (!delta_text.isEmpty())
+					{
+						decodeCoords(QStringRef(&delta_text), coords, delta_encoded);
+						delta_text.clear();
+					}
 					coords.emplace_back(MapCoord::load(xml));
 				}
 				else
@@ -273,6 +475,12 @@ void XmlElementReader::read(MapCoordVector& coords)
 		throw FileFormatException(::OpenOrienteering::MapCoord::tr(e.what()));
 	}
 	
+	if (deferred && !deferred->text.isEmpty())
+		return;
+	
+	if (!delta_text.isEmpty())
+		decodeCoords(QStringRef(&delta_text), coords, delta_encoded);
+	
 	if (coords.size() != num_coords)
 	{
 		throw FileFormatException(::OpenOrienteering::ImportExport::tr("Expected %1 coordinates, found %2.").arg(num_coords).arg(coords.size()));
@@ -288,6 +496,8 @@ void XmlElementReader::readForText(MapCoordVector& coords)
 	coords.reserve(2);
 	
 	const auto num_coords = attribute<unsigned int>(literal::count);
+	const auto delta_encoded = attribute<QStringRef>(literal::encoding) == literal::delta;
+	QString delta_text;
 	
 	QScopedValueRollback<MapCoord::BoundsOffset> offset{MapCoord::boundsOffset()};
 	
@@ -300,6 +510,10 @@ void XmlElementReader::readForText(MapCoordVector& coords)
 			{
 				throw FileFormatException(::OpenOrienteering::ImportExport::tr("Could not parse the coordinates."));
 			}
+			else if (token == QXmlStreamReader::Characters && !xml.isWhitespace() && delta_encoded)
+			{
+				delta_text.append(xml.text());
+			}
 			else if (token == QXmlStreamReader::Characters && !xml.isWhitespace())
 			{
 				QStringRef text = xml.text();
@@ -342,6 +556,16 @@ void XmlElementReader::readForText(MapCoordVector& coords)
 			}
 			// otherwise: ignore element
 		}
+		
+		decodeDeltaCoords(QStringRef(&delta_text), [&offset, &coords](qint64 x, qint64 y, MapCoord::Flags flags) {
+			if (coords.size() == 1)
+			{
+				// Don't apply an offset to text box size.
+				offset.commit();
+				MapCoord::boundsOffset().reset(false);
+			}
+			coords.push_back(MapCoord::loadNative64(x, y, flags));
+		});
 	}
 	catch (std::range_error &e)
 	{
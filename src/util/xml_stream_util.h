@@ -244,9 +244,20 @@ public:
 	/**
 	 * Writes the coordinates vector as a simple text format.
 	 * This is much more efficient than saving each coordinate as rich XML.
+	 * 
+	 * From format version 10, the coordinates are written in the compact
+	 * delta encoding, marked by an attribute encoding="delta".
 	 */
 	void write(const MapCoordVector& coords);
 	
+	/**
+	 * Writes the coordinates vector for the given XML file format version.
+	 * 
+	 * Unlike write(const MapCoordVector&), this doesn't access
+	 * XMLFileFormat::active_version, so it may be used on other threads.
+	 */
+	void write(const MapCoordVector& coords, int format_version);
+	
 	/**
 	 * Writes tags.
 	 */
@@ -257,6 +268,31 @@ private:
 };
 
 
+/**
+ * The compact coordinates text of a coordinates element, for decoding
+ * after the element was read.
+ * 
+ * Decoding does not need the XML reader, so it may be done on another thread.
+ * It depends on the MapCoord::boundsOffset() which must not change meanwhile.
+ * 
+ * \see XmlElementReader::read(MapCoordVector&, DeferredCoords*)
+ */
+struct DeferredCoords
+{
+	QString text;                ///< The coordinates text, empty if nothing is deferred.
+	unsigned int count = 0;      ///< The expected number of coordinates.
+	bool delta_encoded = false;  ///< Whether the text uses the compact delta encoding.
+	
+	/**
+	 * Decodes the coordinates text, appending to the given vector.
+	 * 
+	 * Throws FileFormatException on errors, or if the vector doesn't have the
+	 * expected number of coordinates afterwards.
+	 */
+	void decode(MapCoordVector& coords) const;
+};
+
+
 /**
  * The XmlElementReader helps to read a single element in an XML document.
  * 
@@ -342,9 +378,20 @@ public:
 	/**
 	 * Reads the coordinates vector from a simple text format.
 	 * This is much more efficient than loading each coordinate from rich XML.
+	 * 
+	 * The compact delta encoding is supported, too.
 	 */
 	void read(MapCoordVector& coords);
 	
+	/**
+	 * Reads the coordinates vector, deferring the decoding of the simple
+	 * text format if deferred is not nullptr.
+	 * 
+	 * If deferred has non-empty text after reading, deferred.decode(coords)
+	 * must be called to complete the vector.
+	 */
+	void read(MapCoordVector& coords, DeferredCoords* deferred);
+	
 	/**
 	 * Reads the coordinates vector for a text object.
 	 * 
@@ -425,6 +472,8 @@ namespace XmlStreamLiteral
 	static const QLatin1String height("height");
 	
 	static const QLatin1String count("count");
+	static const QLatin1String encoding("encoding");
+	static const QLatin1String delta("delta");
 	
 	static const QLatin1String object("object");
 	static const QLatin1String t("t");
@@ -0,0 +1,49 @@
+#
+#    Copyright 2026 Kai Pastor
+#    
+#    This file is part of OpenOrienteering.
+# 
+#    OpenOrienteering is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+# 
+#    OpenOrienteering is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+# 
+#    You should have received a copy of the GNU General Public License
+#    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+
+# Runs a benchmark and compares its results with a baseline.
+#
+# Parameters (-D):
+#   BENCHMARK  - the benchmark executable
+#   CHECK      - the performance_check executable
+#   RESULTS    - the CSV file to be written with the benchmark results
+#   BASELINE   - the CSV file with the baseline results
+#   TOLERANCE  - the accepted deviation from the baseline, in percent
+
+foreach(var BENCHMARK CHECK RESULTS BASELINE TOLERANCE)
+	if("${${var}}" STREQUAL "")
+		message(FATAL_ERROR "${var} is not set")
+	endif()
+endforeach()
+
+file(REMOVE "${RESULTS}")
+execute_process(
+  COMMAND "${BENCHMARK}" -o "${RESULTS},csv" -o "-,txt"
+  RESULT_VARIABLE benchmark_result
+)
+if(NOT benchmark_result EQUAL 0)
+	message(FATAL_ERROR "Benchmark ${BENCHMARK} failed: ${benchmark_result}")
+endif()
+
+execute_process(
+  COMMAND "${CHECK}" "${RESULTS}" "${BASELINE}" "${TOLERANCE}"
+  RESULT_VARIABLE check_result
+)
+if(NOT check_result EQUAL 0)
+	message(FATAL_ERROR "Performance check failed: ${check_result}")
+endif()
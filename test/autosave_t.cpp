@@ -198,6 +198,30 @@ void AutosaveTest::permanentFailureTest()
 	QTRY_COMPARE_WITH_TIMEOUT((doc.autosaveCount()), 2, 2000);
 }
 
+void AutosaveTest::pendingTest()
+{
+	AutosaveTestDocument doc(Autosave::Pending);
+	
+	// Enable and trigger Autosave
+	doc.setAutosaveNeeded(true);
+	QTest::qWait(msecs(autosave_interval));
+	QTRY_COMPARE_WITH_TIMEOUT((doc.autosaveCount()), 1, 2000);
+	
+	// Verify that Autosave does not trigger again while pending
+	doc.setAutosaveNeeded(true);
+	QTest::qWait(msecs(autosave_interval) + 2000);
+	QCOMPARE(doc.autosaveCount(), 1);
+	
+	// Verify that Autosave does not trigger again too early after finishing
+	doc.autosaveFinished(Autosave::Success);
+	QTest::qWait(msecs(0.8 * autosave_interval));
+	QCOMPARE(doc.autosaveCount(), 1);
+	
+	// Verify that Autosave does trigger again within 2 seconds
+	QTest::qWait(msecs(0.2 * autosave_interval));
+	QTRY_COMPARE_WITH_TIMEOUT((doc.autosaveCount()), 2, 2000);
+}
+
 void AutosaveTest::autosaveStopTest()
 {
 	{
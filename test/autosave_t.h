@@ -92,6 +92,9 @@ private slots:
 	/** @brief Tests permanent failing autosaving. */
 	void permanentFailureTest();
 	
+	/** @brief Tests autosaving which continues in the background. */
+	void pendingTest();
+	
 	/** @brief Tests autosave stopping on normal saving. */
 	void autosaveStopTest();
 	
@@ -0,0 +1,181 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "global.h"
+#include "test_config.h"
+#include "core/map.h"
+#include "fileformats/batch_export.h"
+#include "fileformats/file_format_registry.h"
+#include "fileformats/file_import_export.h"
+
+using namespace OpenOrienteering;
+
+
+namespace {
+
+QString inputPath()
+{
+	return QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("data/text-object.omap"));
+}
+
+bool loadMap(const QString& path, Map& map)
+{
+	auto importer = FileFormats.makeImporter(path, map, nullptr);
+	return importer && importer->doImport();
+}
+
+}  // namespace
+
+
+
+/**
+ * @test Tests the batch conversion and export of map files.
+ */
+class BatchExportTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		doStaticInitializations();
+	}
+	
+	void convertTest_data()
+	{
+		QTest::addColumn<QString>("format");
+		QTest::addColumn<QString>("extension");
+		
+		QTest::newRow("OCD12") << QStringLiteral("OCD12") << QStringLiteral("ocd");
+		QTest::newRow("xmap")  << QStringLiteral("xmap")  << QStringLiteral("omap");
+	}
+	
+	void convertTest()
+	{
+		QFETCH(QString, format);
+		QFETCH(QString, extension);
+		
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		
+		BatchExport batch_export;
+		auto const arguments = QStringList {
+		    QCoreApplication::applicationFilePath(),
+		    QStringLiteral("--export"), format,
+		    QStringLiteral("--output"), dir.path(),
+		    inputPath()
+		};
+		QCOMPARE(batch_export.exec(arguments), 0);
+		
+		auto const output_path = dir.filePath(QFileInfo(inputPath()).completeBaseName() + QLatin1Char('.') + extension);
+		QCOMPARE(batch_export.outputPath(inputPath()), output_path);
+		QVERIFY(QFileInfo::exists(output_path));
+		
+		Map original;
+		QVERIFY(loadMap(inputPath(), original));
+		Map converted;
+		QVERIFY(loadMap(output_path, converted));
+		QVERIFY(original.getNumObjects() > 0);
+		QCOMPARE(converted.getNumObjects(), original.getNumObjects());
+	}
+	
+	void imageExportTest()
+	{
+#ifndef QT_PRINTSUPPORT_LIB
+		QSKIP("Image export is not supported in this build.");
+#endif
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		
+		BatchExport batch_export;
+		auto const arguments = QStringList {
+		    QCoreApplication::applicationFilePath(),
+		    QStringLiteral("--export"), QStringLiteral("png"),
+		    QStringLiteral("--resolution"), QStringLiteral("50"),
+		    QStringLiteral("--output"), dir.path(),
+		    inputPath()
+		};
+		QCOMPARE(batch_export.exec(arguments), 0);
+		
+		QImage image;
+		QVERIFY(image.load(batch_export.outputPath(inputPath())));
+		QVERIFY(!image.isNull());
+		QCOMPARE(image.dotsPerMeterX(), qRound(50 / 25.4 * 1000));
+	}
+	
+	void errorTest_data()
+	{
+		QTest::addColumn<QString>("format");
+		QTest::addColumn<QString>("input");
+		
+		QTest::newRow("unknown format") << QStringLiteral("no-such-format") << inputPath();
+		QTest::newRow("missing input")  << QStringLiteral("OCD12") << QStringLiteral("no-such-file.omap");
+		QTest::newRow("no input")       << QStringLiteral("OCD12") << QString();
+	}
+	
+	void errorTest()
+	{
+		QFETCH(QString, format);
+		QFETCH(QString, input);
+		
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		
+		BatchExport batch_export;
+		auto arguments = QStringList {
+		    QCoreApplication::applicationFilePath(),
+		    QStringLiteral("--export"), format,
+		    QStringLiteral("--output"), dir.path()
+		};
+		if (!input.isEmpty())
+			arguments << QDir(dir.path()).absoluteFilePath(input);
+		QCOMPARE(batch_export.exec(arguments), 1);
+		QVERIFY(QDir(dir.path()).entryList(QDir::Files | QDir::NoDotAndDotDot).isEmpty());
+	}
+	
+};
+
+
+
+/*
+ * We don't need a real GUI window.
+ * 
+ * But we discovered QTBUG-58768 macOS: Crash when using QPrinter
+ * while running with "minimal" platform plugin.
+ */
+#ifndef Q_OS_MACOS
+namespace  {
+	auto Q_DECL_UNUSED qpa_selected = qputenv("QT_QPA_PLATFORM", "offscreen");  // clazy:exclude=non-pod-global-static
+}
+#endif
+
+
+QTEST_MAIN(BatchExportTest)
+#include "batch_export_t.moc"  // IWYU pragma: keep
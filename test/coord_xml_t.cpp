@@ -20,9 +20,11 @@
 #include "coord_xml_t.h"
 
 #include <algorithm>
+#include <limits>
 
 #include <QtTest>
 
+#include "fileformats/file_format.h"
 #include "fileformats/xml_file_format.h"
 #include "util/xml_stream_util.h"
 
@@ -350,13 +352,29 @@ void CoordXmlTest::writeFastImplementation_data()
 }
 
 void CoordXmlTest::writeFastImplementation()
+{
+	writeElementWriter_implementation(6); // Activate fast text format.
+}
+
+
+void CoordXmlTest::writeDeltaImplementation_data()
+{
+	common_data();
+}
+
+void CoordXmlTest::writeDeltaImplementation()
+{
+	writeElementWriter_implementation(10); // Activate delta encoding.
+}
+
+void CoordXmlTest::writeElementWriter_implementation(int version)
 {
 	buffer.open(QBuffer::ReadWrite);
 	QXmlStreamWriter xml(&buffer);
 	xml.setAutoFormatting(false);
 	xml.writeStartDocument();
 	
-	XMLFileFormat::active_version = 6; // Activate fast text format.
+	XMLFileFormat::active_version = version;
 	XmlElementWriter element(xml, QLatin1String("root"));
 	
 	QFETCH(int, num_coords);
@@ -996,6 +1014,22 @@ void CoordXmlTest::readFastImplementation_data()
 }
 
 void CoordXmlTest::readFastImplementation()
+{
+	readElementReader_implementation(6); // Activate fast text format.
+}
+
+
+void CoordXmlTest::readDeltaImplementation_data()
+{
+	common_data();
+}
+
+void CoordXmlTest::readDeltaImplementation()
+{
+	readElementReader_implementation(10); // Activate delta encoding.
+}
+
+void CoordXmlTest::readElementReader_implementation(int version)
 {
 	QFETCH(int, num_coords);
 	MapCoordVector coords(num_coords, proto_coord);
@@ -1009,7 +1043,7 @@ void CoordXmlTest::readFastImplementation()
 		xml.setAutoFormatting(false);
 		xml.writeStartDocument();
 		
-		XMLFileFormat::active_version = 6; // Activate fast text format.
+		XMLFileFormat::active_version = version;
 		
 		xml.writeStartElement(QString::fromLatin1("root"));
 		xml.writeCharacters(QString{}); // flush root start element
@@ -1061,6 +1095,90 @@ void CoordXmlTest::readFastImplementation()
 }
 
 
+
+void CoordXmlTest::deltaEncoding()
+{
+	MapCoordVector coords;
+	coords.push_back(MapCoord::fromNative(0, 0));
+	coords.push_back(MapCoord::fromNative(std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max(), MapCoord::CurveStart));
+	coords.push_back(MapCoord::fromNative(std::numeric_limits<qint32>::max(), std::numeric_limits<qint32>::min()));
+	coords.push_back(MapCoord::fromNative(-1, 1, MapCoord::HolePoint));
+	for (int i = 0; i < 1000; ++i)
+		coords.push_back(MapCoord::fromNative(i * 127 - 50000, -i * i, MapCoord::Flags{MapCoord::Flags::Int(i % 64)}));
+	coords.push_back(MapCoord::fromNative(12345, -6789, MapCoord::ClosePoint));
+	
+	auto const write_coords = [&coords](int version) {
+		XMLFileFormat::active_version = version;
+		QBuffer data;
+		data.open(QBuffer::WriteOnly);
+		QXmlStreamWriter xml(&data);
+		xml.writeStartDocument();
+		{
+			XmlElementWriter element(xml, QLatin1String("coords"));
+			element.write(coords);
+		}
+		xml.writeEndDocument();
+		return data.data();
+	};
+	
+	// Version 9 doesn't use the delta encoding.
+	auto const plain_data = write_coords(9);
+	QVERIFY(!plain_data.contains("encoding="));
+	
+	auto const delta_data = write_coords(10);
+	QVERIFY(delta_data.contains("encoding=\"delta\""));
+	QVERIFY(delta_data.size() < plain_data.size());
+	
+	{
+		QXmlStreamReader xml(delta_data);
+		QVERIFY(xml.readNextStartElement());
+		MapCoordVector actual;
+		XmlElementReader element(xml);
+		element.read(actual);
+		QVERIFY(actual == coords);
+	}
+	
+	{
+		QXmlStreamReader xml(delta_data);
+		QVERIFY(xml.readNextStartElement());
+		MapCoordVector actual;
+		DeferredCoords deferred;
+		XmlElementReader element(xml);
+		element.read(actual, &deferred);
+		QVERIFY(deferred.delta_encoded);
+		QVERIFY(!deferred.text.isEmpty());
+		deferred.decode(actual);
+		QVERIFY(actual == coords);
+	}
+	
+	// Writing without device
+	{
+		XMLFileFormat::active_version = 10;
+		QString text;
+		QXmlStreamWriter xml(&text);
+		{
+			XmlElementWriter element(xml, QLatin1String("coords"));
+			element.write(coords);
+		}
+		QXmlStreamReader reader(text);
+		QVERIFY(reader.readNextStartElement());
+		MapCoordVector actual;
+		XmlElementReader element(reader);
+		element.read(actual);
+		QVERIFY(actual == coords);
+	}
+	
+	// Broken data
+	{
+		QXmlStreamReader xml(QByteArray("<coords count=\"1\" encoding=\"delta\">/w==</coords>"));
+		QVERIFY(xml.readNextStartElement());
+		MapCoordVector actual;
+		XmlElementReader element(xml);
+		QVERIFY_EXCEPTION_THROWN(element.read(actual), FileFormatException);
+	}
+}
+
+
 bool CoordXmlTest::compare_all(MapCoordVector& coords, MapCoord& expected) const
 {
 	return std::all_of(begin(coords), end(coords), [expected](const MapCoord& coord){ return coord == expected; });
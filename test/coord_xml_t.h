@@ -62,6 +62,10 @@ private slots:
 	void writeFastImplementation();
 	void writeFastImplementation_data();
 	
+	/** Calls the actual implementation of the compact delta encoding. */
+	void writeDeltaImplementation();
+	void writeDeltaImplementation_data();
+	
 	/** Reads rich XML. */
 	void readXml();
 	void readXml_data();
@@ -82,6 +86,13 @@ private slots:
 	void readFastImplementation();
 	void readFastImplementation_data();
 	
+	/** Calls the actual implementation of the compact delta encoding. */
+	void readDeltaImplementation();
+	void readDeltaImplementation_data();
+	
+	/** Tests that the compact delta encoding preserves all coordinates. */
+	void deltaEncoding();
+	
 private:
 	/** The common test data setup. */
 	void common_data();
@@ -100,6 +111,12 @@ private:
 	/** The actual implementation of writing dense base64-like text. */
 	void writeCompressed_implementation(MapCoordVector& coords, QXmlStreamWriter& xml);
 	
+	/** Writes coordinates by means of XmlElementWriter for the given format version. */
+	void writeElementWriter_implementation(int version);
+	
+	/** Reads coordinates by means of XmlElementReader for the given format version. */
+	void readElementReader_implementation(int version);
+	
 	/** Compares all coords members to the expected MapCoord.
 	 *  Returns true iff all match, false otherwise. */
 	bool compare_all(MapCoordVector& coords, MapCoord& expected) const;
@@ -0,0 +1,123 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QObject>
+#include <QStandardPaths>
+#include <QString>
+
+#include "util/disk_cache.h"
+
+using namespace OpenOrienteering;
+
+
+/**
+ * @test Tests the disk cache.
+ */
+class DiskCacheTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		QStandardPaths::setTestModeEnabled(true);
+		for (int i = 0; i < DiskCache::numCategories(); ++i)
+			DiskCache::clear(DiskCache::Category(i));
+	}
+	
+	void keyTest()
+	{
+		auto const key = DiskCache::makeKey({ "a", "bc" });
+		QCOMPARE(key.size(), 40);
+		QCOMPARE(DiskCache::makeKey({ "ab", "c" }), key);
+		QVERIFY(DiskCache::makeKey({ "a", "bd" }) != key);
+	}
+	
+	void categoryTest()
+	{
+		for (int i = 0; i < DiskCache::numCategories(); ++i)
+		{
+			auto const category = DiskCache::Category(i);
+			QVERIFY(!DiskCache::displayName(category).isEmpty());
+			QVERIFY(DiskCache::maxSize(category) > 0);
+			for (int j = 0; j < i; ++j)
+				QVERIFY(DiskCache::directory(category) != DiskCache::directory(DiskCache::Category(j)));
+		}
+	}
+	
+	void writeTest()
+	{
+		auto const category = DiskCache::TemplateThumbnails;
+		auto const path = DiskCache::entryPath(category, DiskCache::makeKey({ "writeTest" }), QLatin1String(".bin"));
+		QVERIFY(path.startsWith(DiskCache::directory(category)));
+		QVERIFY(path.endsWith(QLatin1String(".bin")));
+		
+		// A failing writer must not leave an entry.
+		QVERIFY(!DiskCache::write(path, [](QIODevice& device) {
+			device.write("partial");
+			return false;
+		}));
+		QVERIFY(!QFileInfo::exists(path));
+		
+		auto const data = QByteArray(1000, 'x');
+		QVERIFY(DiskCache::write(path, data));
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QCOMPARE(file.readAll(), data);
+		file.close();
+		QCOMPARE(DiskCache::usage(category), qint64(data.size()));
+		
+		// Entries within the size limit are kept.
+		DiskCache::touch(category, path);
+		DiskCache::trim(category);
+		QVERIFY(QFileInfo::exists(path));
+		
+		DiskCache::clear(category);
+		QVERIFY(!QFileInfo::exists(path));
+		QCOMPARE(DiskCache::usage(category), qint64(0));
+	}
+	
+	void directoryEntryTest()
+	{
+		auto const category = DiskCache::ServiceTiles;
+		auto const entry = DiskCache::entryPath(category, DiskCache::makeKey({ "directoryEntryTest" }));
+		auto const tile = entry + QLatin1String("/1/2/3");
+		QVERIFY(DiskCache::write(tile, QByteArray("tile")));
+		QVERIFY(QFileInfo::exists(tile));
+		
+		DiskCache::touch(category, tile);
+		QVERIFY(QFileInfo::exists(tile));
+		QCOMPARE(DiskCache::usage(category), qint64(4));
+		
+		DiskCache::clear(category);
+		QVERIFY(!QDir(entry).exists());
+	}
+	
+};
+
+
+QTEST_GUILESS_MAIN(DiskCacheTest)
+#include "disk_cache_t.moc"  // IWYU pragma: keep
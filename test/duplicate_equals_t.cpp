@@ -140,6 +140,7 @@ void DuplicateEqualsTest::symbols()
 	{
 		const auto original = map.getSymbol(symbol);
 		auto copy = duplicate(*original);
+		QCOMPARE(copy->hash(), original->hash());
 		switch(original->getType())
 		{
 		case Symbol::Area:
@@ -0,0 +1,311 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_format_benchmark_t.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QByteArray>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLatin1Char>
+#include <QString>
+
+#ifdef Q_OS_UNIX
+#  include <sys/resource.h>
+#endif
+
+#include "global.h"
+#include "synthetic_map.h"
+#include "test_config.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "fileformats/file_format.h"
+#include "fileformats/file_format_registry.h"
+#include "fileformats/file_import_export.h"
+#include "fileformats/ocd_point_codec.h"
+#include "fileformats/ocd_types.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+static const auto source_map = "data:/examples/complete map.omap";
+
+/// The number of runs which are averaged for the "repeated" rows.
+constexpr int repetitions = 3;
+
+/// The number of coordinates for the OCD point codec benchmark.
+constexpr std::size_t num_codec_points = 1000000;
+
+
+/**
+ * Adds rows for all formats which can be exported and imported again.
+ */
+void addFormatRows()
+{
+	QTest::addColumn<QByteArray>("format_id");
+	QTest::addColumn<int>("num_objects");
+	QTest::addColumn<bool>("repeated");
+	for (auto const* format : FileFormats.formats())
+	{
+		// Course exports need a course definition.
+		// Vector graphics cannot be imported again.
+		if (format->fileType() == FileFormat::SimpleCourseFile
+		    || format->fileType() == FileFormat::VectorGraphicsFile
+		    || !format->supportsWriting())
+			continue;
+		
+		auto const id = QByteArray(format->id());
+		for (auto num_objects : syntheticMapSizes())
+		{
+			QByteArray const row = id + ", " + QByteArray::number(num_objects);
+			QTest::newRow(QByteArray(row + ", first").constData()) << id << num_objects << false;
+			QTest::newRow(QByteArray(row + ", repeated").constData()) << id << num_objects << true;
+		}
+	}
+}
+
+/**
+ * Returns the seconds per run of the function, according to the current
+ * data row.
+ */
+template <class Function>
+double measure(Function function)
+{
+	QFETCH(bool, repeated);
+	if (repeated && !function())
+		return 0;
+	
+	auto const runs = repeated ? repetitions : 1;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < runs; ++i)
+	{
+		if (!function())
+			return 0;
+	}
+	return timer.nsecsElapsed() / 1e9 / runs;
+}
+
+void reportThroughput(const QString& path, double seconds)
+{
+	auto const bytes = QFileInfo(path).size();
+	QTest::setBenchmarkResult(seconds > 0 ? bytes / seconds : 0, QTest::BytesPerSecond);
+	
+#ifdef Q_OS_UNIX
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef Q_OS_MACOS
+		auto const peak_kib = qint64(usage.ru_maxrss) / 1024;
+#else
+		auto const peak_kib = qint64(usage.ru_maxrss);
+#endif
+		qInfo("%lld bytes, peak RSS %lld KiB", bytes, peak_kib);
+		return;
+	}
+#endif
+	qInfo("%lld bytes", bytes);
+}
+
+QString filePath(const QTemporaryDir& dir, const FileFormat& format, int num_objects)
+{
+	auto const name = QString::fromLatin1(format.id()) + QLatin1Char('-') + QString::number(num_objects);
+	return dir.path() + QLatin1Char('/') + name + QLatin1Char('.') + format.primaryExtension();
+}
+
+
+}  // namespace
+
+
+
+FileFormatBenchmark::FileFormatBenchmark(QObject* parent)
+: QObject(parent)
+{
+	// nothing
+}
+
+FileFormatBenchmark::~FileFormatBenchmark() = default;
+
+
+void FileFormatBenchmark::initTestCase()
+{
+	QDir::addSearchPath(QStringLiteral("data"), QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("..")));
+	doStaticInitializations();
+	
+	QVERIFY(QFileInfo::exists(QString::fromUtf8(source_map)));
+	QVERIFY(dir.isValid());
+}
+
+
+const Map* FileFormatBenchmark::syntheticMap()
+{
+	QFETCH(int, num_objects);
+	if (!map || map_size != num_objects)
+	{
+		map = makeSyntheticMap(QString::fromUtf8(source_map), num_objects);
+		map_size = map ? num_objects : 0;
+	}
+	return map.get();
+}
+
+
+void FileFormatBenchmark::exportMap_data()
+{
+	addFormatRows();
+}
+
+void FileFormatBenchmark::exportMap()
+{
+	QFETCH(QByteArray, format_id);
+	QFETCH(int, num_objects);
+	auto const* format = FileFormats.findFormat(format_id.constData());
+	QVERIFY(format);
+	auto const* source = syntheticMap();
+	QVERIFY(source);
+	
+	auto const path = filePath(dir, *format, num_objects);
+	QFile::remove(path);
+	auto const seconds = measure([format, source, &path]() {
+		auto exporter = format->makeExporter(path, source, nullptr);
+		return exporter && exporter->doExport();
+	});
+	if (seconds <= 0)
+		QSKIP("Export failed");
+	reportThroughput(path, seconds);
+}
+
+
+void FileFormatBenchmark::importMap_data()
+{
+	addFormatRows();
+}
+
+void FileFormatBenchmark::importMap()
+{
+	QFETCH(QByteArray, format_id);
+	QFETCH(int, num_objects);
+	auto const* format = FileFormats.findFormat(format_id.constData());
+	QVERIFY(format);
+	
+	// The file is written by exportMap(), or now.
+	auto const path = filePath(dir, *format, num_objects);
+	if (!QFileInfo::exists(path))
+	{
+		auto const* source = syntheticMap();
+		QVERIFY(source);
+		auto exporter = format->makeExporter(path, source, nullptr);
+		if (!exporter || !exporter->doExport())
+			QSKIP("Export failed");
+	}
+	
+	// Exports to OGR formats are read by the generic OGR import format.
+	auto const* import_format = format->supportsReading()
+	                            ? format
+	                            : FileFormats.findFormatForFilename(path, &FileFormat::supportsReading);
+	if (!import_format)
+		QSKIP("No import format");
+	
+	auto const seconds = measure([import_format, &path]() {
+		Map imported_map;
+		auto importer = import_format->makeImporter(path, &imported_map, nullptr);
+		return importer && importer->doImport();
+	});
+	if (seconds <= 0)
+		QSKIP("Import failed");
+	reportThroughput(path, seconds);
+}
+
+
+void FileFormatBenchmark::ocdPointCodec_data()
+{
+	QTest::addColumn<bool>("encode");
+	QTest::newRow("encode") << true;
+	QTest::newRow("decode") << false;
+}
+
+void FileFormatBenchmark::ocdPointCodec()
+{
+	QFETCH(bool, encode);
+	
+	// A mix of straight segments, curves and dash points
+	std::vector<MapCoord> coords;
+	coords.reserve(num_codec_points);
+	for (std::size_t i = 0; i < num_codec_points; ++i)
+	{
+		auto const x = qint32(i % 10000) * 10;
+		auto const y = qint32(i / 10000) * 10;
+		switch (i % 8)
+		{
+		case 0:
+			coords.push_back(MapCoord::fromNative(x, y, MapCoord::CurveStart));
+			break;
+		case 5:
+			coords.push_back(MapCoord::fromNative(x, y, MapCoord::DashPoint));
+			break;
+		default:
+			coords.push_back(MapCoord::fromNative(x, y));
+		}
+	}
+	
+	QByteArray data(int(coords.size() * sizeof(Ocd::OcdPoint32)), Qt::Uninitialized);
+	Ocd::encodePoints(coords.data(), coords.data() + coords.size(), data.data(), Ocd::OcdPoint32::FlagDash);
+	auto const* points = reinterpret_cast<const Ocd::OcdPoint32*>(data.constData());
+	
+	if (encode)
+	{
+		QBENCHMARK
+		{
+			Ocd::encodePoints(coords.data(), coords.data() + coords.size(), data.data(), Ocd::OcdPoint32::FlagDash);
+		}
+	}
+	else
+	{
+		std::vector<MapCoord> decoded(coords.size());
+		QBENCHMARK
+		{
+			Ocd::decodePoints(points, points + coords.size(), decoded.data());
+		}
+		QCOMPARE(decoded.back().nativeX(), coords.back().nativeX());
+	}
+}
+
+
+/*
+ * We don't need a real GUI window.
+ * 
+ * But we discovered QTBUG-58768 macOS: Crash when using QPrinter
+ * while running with "minimal" platform plugin.
+ */
+#ifndef Q_OS_MACOS
+namespace  {
+	auto Q_DECL_UNUSED qpa_selected = qputenv("QT_QPA_PLATFORM", "offscreen");  // clazy:exclude=non-pod-global-static
+}
+#endif
+
+
+QTEST_MAIN(FileFormatBenchmark)
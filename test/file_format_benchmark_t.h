@@ -0,0 +1,79 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_FILE_FORMAT_BENCHMARK_T_H
+#define OPENORIENTEERING_FILE_FORMAT_BENCHMARK_T_H
+
+#include <memory>
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace OpenOrienteering {
+class Map;
+}
+
+
+/**
+ * @test Benchmarks the export and import throughput of all registered
+ * file formats on large synthetic maps.
+ * 
+ * The maps are built from the "complete map" example, cf. makeSyntheticMap()
+ * and syntheticMapSizes(). The benchmark result is given in bytes per second
+ * of the exported file. The "first" rows measure the first run on a new file,
+ * the "repeated" rows measure the average of further runs, i.e. with a warm
+ * file cache. The peak resident set size is logged where supported.
+ * 
+ * The ocdPointCodec() benchmark measures the conversion of coordinate arrays
+ * between OCD and Mapper in isolation.
+ * 
+ * Machine-readable results are available through the QtTest output
+ * options, e.g. `file_format_benchmark_t -o results.csv,csv`.
+ */
+class FileFormatBenchmark : public QObject
+{
+Q_OBJECT
+public:
+	explicit FileFormatBenchmark(QObject* parent = nullptr);
+	~FileFormatBenchmark() override;
+	
+private slots:
+	void initTestCase();
+	
+	void exportMap_data();
+	void exportMap();
+	
+	void importMap_data();
+	void importMap();
+	
+	void ocdPointCodec_data();
+	void ocdPointCodec();
+	
+private:
+	/**
+	 * Returns the synthetic map for the current data row.
+	 */
+	const OpenOrienteering::Map* syntheticMap();
+	
+	std::unique_ptr<OpenOrienteering::Map> map;
+	int map_size = 0;
+	QTemporaryDir dir;
+};
+
+#endif
@@ -53,6 +53,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QRectF>
+#include <QScopedValueRollback>
 #include <QSize>
 #include <QSizeF>
 #include <QString>
@@ -60,6 +61,7 @@
 #include <QStringRef>
 #include <QTemporaryDir>
 #include <QVariant>
+#include <QXmlStreamReader>
 
 #include "global.h"
 #include "test_config.h"
@@ -75,8 +77,10 @@
 #include "core/objects/text_object.h"
 #include "core/symbols/area_symbol.h"
 #include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
 #include "core/symbols/symbol.h"
 #include "core/symbols/text_symbol.h"
+#include "fileformats/buffered_device.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
@@ -89,12 +93,18 @@
 #include "fileformats/ocd_types_v8.h"
 #include "fileformats/ocd_types_v12.h"
 #include "fileformats/simple_course_export.h"
+#include "fileformats/svg_file_format.h"
 #include "fileformats/xml_file_format.h"
+#include "fileformats/xml_file_format_p.h"
 #include "templates/template.h"
 #include "undo/undo.h"
 #include "undo/undo_manager.h"
 #include "util/backports.h"  // IWYU pragma: keep
 
+#ifdef MAPPER_USE_ZSTD
+#  include "fileformats/zstd_device.h"
+#endif
+
 #ifdef MAPPER_USE_GDAL
 #  include "gdal/gdal_manager.h"
 #endif
@@ -695,6 +705,7 @@ void FileFormatTest::understandsTest_data()
 	quint8 ocd_start_raw[2] = { 0xAD, 0x0C };
 	auto ocd_start   = QByteArray::fromRawData(reinterpret_cast<const char*>(ocd_start_raw), 2).append("random data");
 	auto omap_start  = QByteArray("OMAP plus random data");
+	auto omapb_start = QByteArray("OOMB plus random data");
 	auto xml_start   = QByteArray("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
 	auto xml_legacy  = QByteArray(xml_start + "\r\n<map xmlns=\"http://oorienteering.sourceforge.net/mapper/xml/v2\">");
 	auto xml_regular = QByteArray(xml_start + "\n<map xmlns=\"http://openorienteering.org/apps/mapper/xml/v2\" version=\"7\">");
@@ -714,6 +725,12 @@ void FileFormatTest::understandsTest_data()
 	QTest::newRow("XML < xml other")        << QByteArray("XML") << xml_gpx           << int(FileFormat::NotSupported);
 	QTest::newRow("XML < 'OMAPxxx'")        << QByteArray("XML") << omap_start        << int(FileFormat::FullySupported);
 	QTest::newRow("XML < 0x0CADxxx")        << QByteArray("XML") << ocd_start         << int(FileFormat::NotSupported);
+	QTest::newRow("XML < 'OOMBxxx'")        << QByteArray("XML") << omapb_start       << int(FileFormat::NotSupported);
+	
+	QTest::newRow("OMAPB < 'OOMBxxx'")      << QByteArray("OMAPB") << omapb_start       << int(FileFormat::FullySupported);
+	QTest::newRow("OMAPB < 'OOM'")          << QByteArray("OMAPB") << omapb_start.left(3) << int(FileFormat::Unknown);
+	QTest::newRow("OMAPB < 'OMAPxxx'")      << QByteArray("OMAPB") << omap_start        << int(FileFormat::NotSupported);
+	QTest::newRow("OMAPB < xml start")      << QByteArray("OMAPB") << xml_start         << int(FileFormat::NotSupported);
 	
 	QTest::newRow("OCD < 0x0CADxxx")        << QByteArray("OCD") << ocd_start         << int(FileFormat::FullySupported);
 	QTest::newRow("OCD < 0x0CAD")           << QByteArray("OCD") << ocd_start.left(2) << int(FileFormat::FullySupported);
@@ -735,6 +752,8 @@ void FileFormatTest::understandsTest()
 #ifdef MAPPER_BIG_ENDIAN
 	if (format_id.startsWith("OCD"))
 		QEXPECT_FAIL("", "OCD format not support on big endian systems", Abort);
+	if (format_id == "OMAPB")
+		QEXPECT_FAIL("", "Binary format not supported on big endian systems", Abort);
 #endif
 	QVERIFY(format);
 	QVERIFY(format->supportsReading());
@@ -755,7 +774,7 @@ void FileFormatTest::formatForDataTest()
 	QFETCH(int, support);
 	
 #ifdef MAPPER_BIG_ENDIAN
-	if (format_id.startsWith("OCD"))
+	if (format_id.startsWith("OCD") || format_id == "OMAPB")
 		return;
 #endif
 	
@@ -864,6 +883,7 @@ void FileFormatTest::saveAndLoad_data()
 	static const auto format_ids = {
 	    "XML",
 #ifndef MAPPER_BIG_ENDIAN
+	    "OMAPB",
 	    "OCD",
 #endif
 	};
@@ -1013,6 +1033,218 @@ void FileFormatTest::pristineMapTest()
 
 
 
+void FileFormatTest::xmlSnapshotTest_data()
+{
+	QTest::addColumn<QString>("filepath");
+	
+	for (auto const* raw_path : xml_test_files)
+		QTest::newRow(raw_path) << QString::fromLatin1(raw_path);
+}
+
+void FileFormatTest::xmlSnapshotTest()
+{
+	QFETCH(QString, filepath);
+	
+	Map map;
+	QVERIFY(map.loadFrom(filepath));
+	
+	QBuffer expected;
+	XMLFileExporter exporter({}, &map, nullptr);
+	exporter.setDevice(&expected);
+	QVERIFY(exporter.doExport());
+	
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const snapshot_path = QDir(dir.path()).absoluteFilePath(QStringLiteral("snapshot.omap"));
+	XMLFileSnapshotExporter snapshot_exporter(snapshot_path, &map, nullptr);
+	QVERIFY(snapshot_exporter.takeSnapshot());
+	
+	map.clear();
+	{
+		// A concurrent save in compatibility mode must not affect the snapshot.
+		QScopedValueRollback<int> active_version(XMLFileFormat::active_version, 5);
+		QVERIFY(snapshot_exporter.writeSnapshot());
+	}
+	
+	QFile snapshot(snapshot_path);
+	QVERIFY(snapshot.open(QIODevice::ReadOnly));
+	QCOMPARE(snapshot.readAll(), expected.data());
+}
+
+
+
+void FileFormatTest::xmlCompressionTest_data()
+{
+	xmlSnapshotTest_data();
+}
+
+void FileFormatTest::xmlCompressionTest()
+{
+#ifndef MAPPER_USE_ZSTD
+	QSKIP("Built without zstd support");
+#else
+	QFETCH(QString, filepath);
+	
+	Map map;
+	QVERIFY(map.loadFrom(filepath));
+	
+	QBuffer expected;
+	{
+		XMLFileExporter exporter({}, &map, nullptr);
+		exporter.setOption(QStringLiteral("compressionLevel"), 0);
+		exporter.setDevice(&expected);
+		QVERIFY(exporter.doExport());
+	}
+	
+	QBuffer compressed;
+	{
+		XMLFileExporter exporter({}, &map, nullptr);
+		exporter.setOption(QStringLiteral("compressionLevel"), ZstdCompressionDevice::default_level);
+		exporter.setDevice(&compressed);
+		QVERIFY(exporter.doExport());
+	}
+	QVERIFY(compressed.data().size() < expected.data().size());
+	
+	XMLFileFormat format;
+	QCOMPARE(format.understands(compressed.data().constData(), compressed.data().size()), FileFormat::FullySupported);
+	
+	{
+		QBuffer source;
+		source.setData(compressed.data());
+		QVERIFY(source.open(QIODevice::ReadOnly));
+		ZstdDecompressionDevice decompressor(&source);
+		QVERIFY(decompressor.open(QIODevice::ReadOnly));
+		QCOMPARE(decompressor.readAll(), expected.data());
+		QVERIFY(decompressor.atEnd());
+	}
+	
+	{
+		QBuffer source;
+		source.setData(compressed.data());
+		Map reloaded_map;
+		XMLFileImporter importer({}, &reloaded_map, nullptr);
+		importer.setDevice(&source);
+		QVERIFY(importer.doImport());
+		compareMaps(reloaded_map, map);
+	}
+#endif
+}
+
+
+
+void FileFormatTest::importProgressTest()
+{
+	Map map;
+	auto* symbol = new PointSymbol();
+	map.addSymbol(symbol, 0);
+	for (int i = 0; i < 10000; ++i)
+	{
+		auto* object = new PointObject(symbol);
+		object->setPosition(MapCoord(i, i));
+		map.addObject(object);
+	}
+	
+	QBuffer exported;
+	{
+		XMLFileExporter exporter({}, &map, nullptr);
+		exporter.setOption(QStringLiteral("compressionLevel"), 0);
+		exporter.setDevice(&exported);
+		QVERIFY(exporter.doExport());
+	}
+	
+	{
+		std::vector<int> reported;
+		QBuffer source;
+		source.setData(exported.data());
+		Map reloaded_map;
+		XMLFileImporter importer({}, &reloaded_map, nullptr);
+		importer.setDevice(&source);
+		importer.setProgressHandler([&reported](int percent) {
+			reported.push_back(percent);
+			return true;
+		});
+		QVERIFY(importer.doImport());
+		QVERIFY(!importer.isCanceled());
+		QCOMPARE(reloaded_map.getNumObjects(), map.getNumObjects());
+		QCOMPARE(int(reported.size()), 2);
+		QVERIFY(reported.front() > 0);
+		QVERIFY(reported.front() < reported.back());
+		QVERIFY(reported.back() < 100);
+	}
+	
+	{
+		QBuffer source;
+		source.setData(exported.data());
+		Map reloaded_map;
+		XMLFileImporter importer({}, &reloaded_map, nullptr);
+		importer.setDevice(&source);
+		importer.setProgressHandler([](int) { return false; });
+		QVERIFY(!importer.doImport());
+		QVERIFY(importer.isCanceled());
+		QVERIFY(!importer.warnings().empty());
+	}
+}
+
+
+
+void FileFormatTest::bufferedDeviceTest()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const path = QDir(dir.path()).absoluteFilePath(QStringLiteral("buffered.dat"));
+	
+	QByteArray expected;
+	for (int i = 0; i < 10000; ++i)
+		expected.append(QByteArray::number(i)).append(' ');
+	
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		WriteBehindDevice device(&file, 1000);
+		QVERIFY(device.open(QIODevice::WriteOnly));
+		for (int pos = 0; pos < expected.size(); pos += 7)
+			QCOMPARE(device.write(expected.mid(pos, 7)), qint64(expected.mid(pos, 7).size()));
+		QVERIFY(device.finish());
+	}
+	
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	ReadAheadDevice device(&file, 1000);
+	QVERIFY(device.open(QIODevice::ReadOnly));
+	QCOMPARE(device.size(), qint64(expected.size()));
+	QCOMPARE(device.read(10), expected.left(10));
+	QVERIFY(device.seek(5000));
+	QCOMPARE(device.read(2500), expected.mid(5000, 2500));
+	QVERIFY(device.seek(100));
+	QCOMPARE(device.readAll(), expected.mid(100));
+	QVERIFY(device.atEnd());
+}
+
+
+
+void FileFormatTest::svgExportTest()
+{
+	Map map;
+	QVERIFY(map.loadFrom(QStringLiteral("data:/examples/complete map.omap")));
+	
+	SvgFileExport exporter{{}, &map, nullptr};
+	QBuffer exported;
+	exporter.setDevice(&exported);
+	QVERIFY(exporter.doExport());
+	
+	auto const& data = exported.data();
+	QVERIFY(data.contains("<svg"));
+	QVERIFY(data.contains("<symbol"));
+	QVERIFY(data.contains("<use"));
+	
+	QXmlStreamReader xml(data);
+	while (!xml.atEnd())
+		xml.readNext();
+	QVERIFY2(!xml.hasError(), qPrintable(xml.errorString()));
+}
+
+
+
 void FileFormatTest::ogrExportTest_data()
 {
 	QTest::addColumn<QString>("map_filepath");
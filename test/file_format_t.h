@@ -88,6 +88,37 @@ private slots:
 	 */
 	void pristineMapTest();
 	
+	/**
+	 * Tests that an XML snapshot is written like a regular XML export,
+	 * even when the map is modified after taking the snapshot.
+	 */
+	void xmlSnapshotTest();
+	void xmlSnapshotTest_data();
+	
+	/**
+	 * Tests that a compressed XML export decompresses to the regular XML
+	 * export, and that it can be imported again.
+	 */
+	void xmlCompressionTest();
+	void xmlCompressionTest_data();
+	
+	/**
+	 * Tests progress reports and cancellation of an import.
+	 */
+	void importProgressTest();
+	
+	/**
+	 * Tests that data passes unchanged through the buffered devices,
+	 * including seeking on the read-ahead device.
+	 */
+	void bufferedDeviceTest();
+	
+	/**
+	 * Tests that the SVG export writes well-formed XML, and that it
+	 * reuses repeated shapes.
+	 */
+	void svgExportTest();
+	
 	/**
 	 * Tests export of geospatial vector data via OGR.
 	 */
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <vector>
 
 #include <QtMath>
 #include <QtTest>
@@ -44,6 +45,7 @@
 
 #include "core/crs_template.h"
 #include "core/crs_template_implementation.h"
+#include "core/geographic_approximation.h"
 #include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map_coord.h"
@@ -439,6 +441,78 @@ void GeoreferencingTest::testProjection_data()
 }
 
 
+void GeoreferencingTest::testBatchProjection_data()
+{
+	testProjection_data();
+}
+
+void GeoreferencingTest::testBatchProjection()
+{
+	QFETCH(QString, proj);
+	QFETCH(double, latitude);
+	QFETCH(double, longitude);
+	
+	Georeferencing georef;
+	QVERIFY2(georef.setProjectedCRS(proj, proj), proj.toLatin1());
+	georef.setGeographicRefPoint(LatLon(latitude, longitude));
+	
+	std::vector<LatLon> lat_lon;
+	for (int i = -2; i <= 2; ++i)
+		lat_lon.emplace_back(latitude + i * 0.01, longitude - i * 0.01);
+	
+	bool ok = false;
+	auto const map_coords = georef.toMapCoordF(lat_lon, &ok);
+	QVERIFY(ok);
+	QCOMPARE(map_coords.size(), lat_lon.size());
+	for (std::size_t i = 0; i < lat_lon.size(); ++i)
+	{
+		auto const expected = georef.toMapCoordF(lat_lon[i], &ok);
+		QVERIFY(ok);
+		QVERIFY(std::fabs(map_coords[i].x() - expected.x()) < 0.001);
+		QVERIFY(std::fabs(map_coords[i].y() - expected.y()) < 0.001);
+	}
+	
+	auto const round_trip = georef.toGeographicCoords(map_coords, &ok);
+	QVERIFY(ok);
+	QCOMPARE(round_trip.size(), lat_lon.size());
+	for (std::size_t i = 0; i < lat_lon.size(); ++i)
+	{
+		QVERIFY(std::fabs(round_trip[i].latitude() - lat_lon[i].latitude()) < 0.0000001);
+		QVERIFY(std::fabs(round_trip[i].longitude() - lat_lon[i].longitude()) < 0.0000001);
+	}
+}
+
+
+void GeoreferencingTest::testGeographicApproximation_data()
+{
+	testProjection_data();
+}
+
+void GeoreferencingTest::testGeographicApproximation()
+{
+	QFETCH(QString, proj);
+	QFETCH(double, latitude);
+	QFETCH(double, longitude);
+	
+	Georeferencing georef;
+	QVERIFY2(georef.setProjectedCRS(proj, proj), proj.toLatin1());
+	georef.setGeographicRefPoint(LatLon(latitude, longitude));
+	
+	GeographicApproximation approximation(georef);
+	for (int i = -400; i <= 400; ++i)
+	{
+		auto const map_coords = MapCoordF(i * 0.5, i * 0.3);
+		bool ok = false;
+		auto const expected = georef.toGeographicCoords(map_coords, &ok);
+		QVERIFY(ok);
+		auto const actual = approximation.toGeographicCoords(map_coords, &ok);
+		QVERIFY(ok);
+		QVERIFY(std::fabs(actual.latitude() - expected.latitude()) <= GeographicApproximation::tolerance);
+		QVERIFY(std::fabs(actual.longitude() - expected.longitude()) <= GeographicApproximation::tolerance);
+	}
+}
+
+
 void GeoreferencingTest::testProjection()
 {
 	const double max_dist_error = 2.2; // meter
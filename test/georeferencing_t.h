@@ -74,6 +74,20 @@ private slots:
 	
 	void testProjection_data();
 	
+	/**
+	 * Tests whether the list conversions match the single point conversions.
+	 */
+	void testBatchProjection();
+	
+	void testBatchProjection_data();
+	
+	/**
+	 * Tests whether the approximation matches the exact conversion.
+	 */
+	void testGeographicApproximation();
+	
+	void testGeographicApproximation_data();
+	
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
 	/**
 	 * Tests whether the `proj_context_set_file_finder()` function is working.
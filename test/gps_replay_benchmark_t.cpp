@@ -0,0 +1,343 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replays recorded tracks into the GPS display, the track recorder and the
+ * GPS point drawing tool, at rates from 1 Hz to 50 Hz.
+ *
+ * The latency is measured from the emission of a position by the source
+ * until the map widget has painted the updated marker. The CPU time covers
+ * all processing and painting during the replay, divided by the number of
+ * positions.
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <initializer_list>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QObject>
+#include <QPointer>
+#include <QStaticPlugin>  // IWYU pragma: keep
+#include <QString>
+
+#include "global.h"
+#include "settings.h"
+#include "test_config.h"
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/symbols/point_symbol.h"
+#include "gui/main_window.h"
+#include "gui/map/map_editor.h"
+#include "gui/map/map_widget.h"
+#include "gui/widgets/symbol_widget.h"
+#include "sensors/gps_display.h"
+#include "sensors/gps_track_recorder.h"
+#include "templates/template_track.h"
+#include "tools/draw_point_gps_tool.h"
+
+#ifdef MAPPER_USE_FAKE_POSITION_PLUGIN
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include <QGeoPositionInfoSource>
+#include "sensors/fake_position_plugin.h"
+#include "sensors/fake_position_source.h"
+Q_IMPORT_PLUGIN(FakePositionPlugin)
+#endif
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+static const auto track_files = {
+    "testdata:track/track-0.gpx",
+    "testdata:track/track-1.gpx",
+    "testdata:sensors/nmea.txt",
+};
+
+/// The replay rates, in Hz.
+static const auto replay_rates = { 1, 10, 50 };
+
+/// The duration of each replay, in seconds.
+constexpr int replay_duration = 3;
+
+
+#ifdef MAPPER_USE_FAKE_POSITION_PLUGIN
+
+std::vector<QGeoPositionInfo> readTrack(const QString& path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return {};
+	if (path.endsWith(QLatin1String(".gpx")))
+		return FakePositionSource::readGpx(file);
+	return FakePositionSource::readNmea(file);
+}
+
+/**
+ * Returns a UTM projection for the zone of the given coordinate.
+ */
+QString utmSpec(const QGeoCoordinate& coordinate)
+{
+	auto const zone = std::min(60, int((coordinate.longitude() + 180) / 6) + 1);
+	auto spec = QStringLiteral("+proj=utm +zone=%1 +datum=WGS84 +units=m +no_defs").arg(zone);
+	if (coordinate.latitude() < 0)
+		spec += QLatin1String(" +south");
+	return spec;
+}
+
+#endif  // MAPPER_USE_FAKE_POSITION_PLUGIN
+
+
+}  // namespace
+
+
+
+class GPSReplayBenchmark : public QObject
+{
+	Q_OBJECT
+	
+public:
+	/**
+	 * Completes the measurement of the latency when the map widget
+	 * is painted after the GPS display received a new position.
+	 */
+	bool eventFilter(QObject* watched, QEvent* event) override
+	{
+		if (event->type() == QEvent::Paint && watched == map_widget && marker_pending >= 0)
+		{
+			watched->event(event);
+			latencies.push_back(clock.nsecsElapsed() - marker_pending);
+			marker_pending = -1;
+			return true;
+		}
+		return false;
+	}
+	
+private:
+	struct Result
+	{
+		double latency = 0;   ///< The mean latency, in milliseconds
+		double cpu_time = 0;  ///< The CPU time per position, in std::clock() ticks
+	};
+	
+	void addRows()
+	{
+		QTest::addColumn<QString>("track_file");
+		QTest::addColumn<int>("rate");
+		for (auto raw_path : track_files)
+		{
+			auto const path = QString::fromUtf8(raw_path);
+			auto const name = QFileInfo(path).fileName().toUtf8();
+			for (auto rate : replay_rates)
+			{
+				QByteArray const row = name + ", " + QByteArray::number(rate) + " Hz";
+				QTest::newRow(row.constData()) << path << rate;
+			}
+		}
+	}
+	
+	/**
+	 * Replays the track of the current row, and returns the measurements.
+	 */
+	void replay(Result& result)
+	{
+#ifdef MAPPER_USE_FAKE_POSITION_PLUGIN
+		QFETCH(QString, track_file);
+		QFETCH(int, rate);
+		
+		auto track = readTrack(track_file);
+		QVERIFY(!track.empty());
+		auto const start = track.front().coordinate();
+		FakePositionSource::setReplayTrack(std::move(track));
+		
+		auto* map = new Map();
+		auto* point_symbol = new PointSymbol();
+		map->addSymbol(point_symbol, 0);
+		{
+			Georeferencing georef;
+			QVERIFY(georef.setProjectedCRS({}, utmSpec(start)));
+			georef.setGeographicRefPoint(LatLon(start.latitude(), start.longitude()));
+			map->setGeoreferencing(georef);
+		}
+		// Keep all positions of the track in the view.
+		map->setScaleDenominator(1000000);
+		
+		auto* window = new MainWindow();
+		auto* editor = new MapEditorController(MapEditorController::MapEditor, map);
+		window->setController(editor);
+		window->resize(800, 600);
+		window->show();
+		map_widget = editor->getMainWidget();
+		editor->getSymbolWidget()->selectSingleSymbol(point_symbol);
+		
+		{
+			GPSDisplay gps_display(map_widget, map->getGeoreferencing());
+			auto* source = gps_display.findChild<QGeoPositionInfoSource*>();
+			QVERIFY(qobject_cast<FakePositionSource*>(source));
+			source->setUpdateInterval(1000 / rate);
+			QCOMPARE(source->updateInterval(), 1000 / rate);
+			
+			auto* track_template = new TemplateTrack(QStringLiteral("replay.gpx"), map);
+			track_template->configureForGPSTrack();
+			map->addTemplate(0, std::unique_ptr<Template>{track_template});
+			GPSTrackRecorder recorder(&gps_display, track_template, 500, map_widget);
+			editor->setTool(new DrawPointGPSTool(&gps_display, editor, nullptr));
+			
+			auto num_positions = 0;
+			auto emitted = qint64(-1);
+			latencies.clear();
+			marker_pending = -1;
+			connect(source, &QGeoPositionInfoSource::positionUpdated, this, [&]() {
+				++num_positions;
+				if (emitted < 0)
+					emitted = clock.nsecsElapsed();
+			});
+			connect(&gps_display, &GPSDisplay::mapPositionUpdated, this, [&]() {
+				if (marker_pending < 0)
+					marker_pending = emitted;
+				emitted = -1;
+			});
+			map_widget->installEventFilter(this);
+			
+			auto const expected_positions = rate * replay_duration;
+			clock.start();
+			auto const cpu_start = std::clock();
+			gps_display.setVisible(true);
+			gps_display.startUpdates();
+			QTRY_VERIFY_WITH_TIMEOUT(num_positions >= expected_positions, 2000 * replay_duration + 1000);
+			gps_display.stopUpdates();
+			QTRY_VERIFY_WITH_TIMEOUT(emitted < 0 && marker_pending < 0, 1000);
+			auto const cpu_end = std::clock();
+			
+			map_widget->removeEventFilter(this);
+			disconnect(source, nullptr, this, nullptr);
+			disconnect(&gps_display, nullptr, this, nullptr);
+			
+			QVERIFY(!latencies.empty());
+			QVERIFY(int(track_template->getTrack().segmentPoints().size()) >= expected_positions);
+			auto const total_latency = std::accumulate(begin(latencies), end(latencies), qint64(0));
+			result.latency = total_latency / 1000000.0 / latencies.size();
+			result.cpu_time = double(cpu_end - cpu_start) / num_positions;
+			qDebug("%d positions, %d paints, max. latency %.3f ms",
+			       num_positions, int(latencies.size()),
+			       *std::max_element(begin(latencies), end(latencies)) / 1000000.0);
+			
+			// The tool refers to the GPS display.
+			editor->setTool(nullptr);
+		}
+		
+		FakePositionSource::setReplayTrack({});
+		map_widget = nullptr;
+		// The window may still be referred to by tools which are scheduled for
+		// deleteLater(), so we need to postpone the window deletion, too.
+		window->deleteLater();
+#else
+		Q_UNUSED(result)
+#endif  // MAPPER_USE_FAKE_POSITION_PLUGIN
+	}
+	
+private slots:
+	void initTestCase()
+	{
+#ifndef MAPPER_USE_FAKE_POSITION_PLUGIN
+		QSKIP("The fake position plugin is not available");
+#endif
+		
+		// Use distinct QSettings
+		QCoreApplication::setOrganizationName(QString::fromLatin1("OpenOrienteering.org"));
+		QCoreApplication::setApplicationName(QString::fromLatin1(metaObject()->className()));
+		QVERIFY2(QDir::home().exists(), "The home dir must be writable in order to use QSettings.");
+		
+		Q_INIT_RESOURCE(resources);
+		doStaticInitializations();
+		QDir::addSearchPath(QStringLiteral("testdata"), QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("data")));
+		
+		Settings::getInstance().setPositionSource(QStringLiteral("Fake position"));
+	}
+	
+	void latency_data()
+	{
+		addRows();
+	}
+	
+	/**
+	 * Measures the mean time from the emission of a position
+	 * until the GPS marker is painted.
+	 */
+	void latency()
+	{
+		Result result;
+		replay(result);
+		if (!QTest::currentTestFailed())
+			QTest::setBenchmarkResult(result.latency, QTest::WalltimeMilliseconds);
+	}
+	
+	void cpuTime_data()
+	{
+		addRows();
+	}
+	
+	/**
+	 * Measures the CPU time per position.
+	 */
+	void cpuTime()
+	{
+		Result result;
+		replay(result);
+		if (!QTest::currentTestFailed())
+			QTest::setBenchmarkResult(result.cpu_time, QTest::CPUTicks);
+	}
+	
+private:
+	QPointer<MapWidget> map_widget;
+	QElapsedTimer clock;
+	std::vector<qint64> latencies;
+	qint64 marker_pending = -1;
+	
+};
+
+
+/*
+ * We don't need a real GUI window.
+ */
+namespace  {
+	auto Q_DECL_UNUSED qpa_selected = qputenv("QT_QPA_PLATFORM", "offscreen");  // clazy:exclude=non-pod-global-static
+}
+
+
+QTEST_MAIN(GPSReplayBenchmark)
+#include "gps_replay_benchmark_t.moc"  // IWYU pragma: keep
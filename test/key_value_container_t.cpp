@@ -26,6 +26,7 @@
 
 #include <Qt>
 #include <QtTest>
+#include <QLatin1Char>
 #include <QObject>
 #include <QString>
 
@@ -161,6 +162,27 @@ private slots:
 		QCOMPARE(container.size(), old_size + 2);
 	}
 	
+	void stringPoolTest()
+	{
+		auto pool = StringPool();
+		auto const natural = pool.intern(QSL("natural"));
+		QCOMPARE(pool.size(), 1);
+		QCOMPARE(pool.intern(QSL("natural")).constData(), natural.constData());
+		QCOMPARE(pool.size(), 1);
+		
+		auto container = KeyValueContainer{};
+		container.insert_or_assign(QSL("natural"), QSL("wood"));
+		container.insert_or_assign(QSL("note"), QString(KeyValueContainer::max_interned_value_length + 1, QLatin1Char('x')));
+		container.internStrings(pool);
+		QCOMPARE(container.find(QSL("natural"))->key.constData(), natural.constData());
+		QCOMPARE(pool.intern(QSL("wood")).constData(), container.at(QSL("natural")).constData());
+		QCOMPARE(pool.size(), 3);  // natural, wood, note
+		
+		pool.clear();
+		QCOMPARE(pool.size(), 0);
+		QCOMPARE(container.at(QSL("natural")), QSL("wood"));
+	}
+	
 };
 
 
@@ -45,6 +45,14 @@ private slots:
 		QCOMPARE(MapPrinter::isPrinter(MapPrinter::pdfTarget()), false);
 	}
 	
+	void seriesSheetPathTest()
+	{
+		QCOMPARE(MapPrinter::seriesSheetPath(QStringLiteral("/maps/atlas.pdf"), 3, 60), QStringLiteral("/maps/atlas-03.pdf"));
+		QCOMPARE(MapPrinter::seriesSheetPath(QStringLiteral("/maps/atlas.pdf"), 10, 10), QStringLiteral("/maps/atlas-10.pdf"));
+		QCOMPARE(MapPrinter::seriesSheetPath(QStringLiteral("/maps.d/atlas"), 1, 5), QStringLiteral("/maps.d/atlas-1"));
+		QCOMPARE(MapPrinter::seriesSheetPath(QStringLiteral("/maps/.pdf"), 2, 5), QStringLiteral("/maps/.pdf-2"));
+	}
+	
 };
 
 
@@ -19,9 +19,17 @@
 
 #include "map_t.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
 #include <QtTest>
 #include <QBuffer>
 #include <QMessageBox>
+#include <QRectF>
+#include <QSignalSpy>
 #include <QTextStream>
 
 #include "test_config.h"
@@ -29,12 +37,19 @@
 #include "global.h"
 #include "core/map.h"
 #include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/map_grid.h"
+#include "core/map_part.h"
 #include "core/map_printer.h" // IWYU pragma: keep
+#include "core/map_validator.h"
 #include "core/map_view.h"
 #include "core/objects/object.h"
 #include "core/objects/symbol_rule_set.h"
 #include "core/symbols/symbol.h"
+#include "core/symbols/area_symbol.h"
 #include "core/symbols/point_symbol.h"
+#include "undo/object_undo.h"
+#include "util/util.h"
 
 using namespace OpenOrienteering;
 
@@ -220,6 +235,43 @@ void MapTest::importTest()
 }
 
 
+void MapTest::snapshotTest()
+{
+	Map map;
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap"))));
+	QVERIFY(map.getPart(0)->getNumObjects() > 0);
+	
+	auto snapshot = map.createSnapshot();
+	QVERIFY(snapshot);
+	QCOMPARE(snapshot->getScaleDenominator(), map.getScaleDenominator());
+	QCOMPARE(snapshot->getNumColors(), map.getNumColors());
+	for (int i = 0; i < map.getNumColors(); ++i)
+	{
+		QVERIFY(snapshot->getColor(i) != map.getColor(i));
+		QCOMPARE(snapshot->getColor(i)->getName(), map.getColor(i)->getName());
+	}
+	QCOMPARE(snapshot->getNumSymbols(), map.getNumSymbols());
+	for (int i = 0; i < map.getNumSymbols(); ++i)
+	{
+		QVERIFY(snapshot->getSymbol(i) != map.getSymbol(i));
+		QCOMPARE(snapshot->getSymbol(i)->getNumberAsString(), map.getSymbol(i)->getNumberAsString());
+	}
+	QCOMPARE(snapshot->getNumParts(), map.getNumParts());
+	QCOMPARE(snapshot->getNumObjects(), map.getNumObjects());
+	
+	auto* object = map.getPart(0)->getObject(0);
+	auto const* snapshot_object = snapshot->getPart(0)->getObject(0);
+	QCOMPARE(snapshot_object->getMap(), snapshot.get());
+	QCOMPARE(snapshot->findSymbolIndex(snapshot_object->getSymbol()), map.findSymbolIndex(object->getSymbol()));
+	QCOMPARE(&snapshot_object->getRawCoordinateVector(), &object->getRawCoordinateVector());
+	QVERIFY(snapshot_object->equals(object, false));
+	
+	// Later changes of the map do not affect the snapshot.
+	object->move(1000, 1000);
+	QVERIFY(!snapshot_object->equals(object, false));
+}
+
+
 
 void MapTest::hasAlpha()
 {
@@ -291,6 +343,508 @@ void MapTest::hasAlpha()
 }
 
 
+void MapTest::gridLinesTest()
+{
+	Map map;
+	MapGrid grid;
+	grid.setUnit(MapGrid::MillimetersOnMap);
+	grid.setDisplayMode(MapGrid::VerticalLines);
+	grid.setHorizontalSpacing(10);
+	grid.setVerticalSpacing(10);
+	map.setGrid(grid);
+	
+	auto const rect = QRectF(0.5, 0.5, 100, 100);
+	auto const lines = grid.calculateLines(rect, &map);
+	QCOMPARE(lines.size(), std::size_t(10));
+	
+	auto const thinned = grid.calculateLines(rect, &map, 15);
+	QCOMPARE(thinned.size(), std::size_t(5));
+	for (auto const& line : thinned)
+	{
+		auto const matching = std::count_if(begin(lines), end(lines), [&line](auto const& other) {
+			return qAbs(other.x1() - line.x1()) < 0.001;
+		});
+		QCOMPARE(matching, decltype(matching)(1));
+	}
+	
+	MapGridCache cache;
+	auto const* cached = cache.lines(grid, rect, &map, 15).data();
+	QVERIFY(cached);
+	QCOMPARE(cache.lines(grid, rect.adjusted(10, 10, 10, 10), &map, 15).data(), cached);
+	QVERIFY(cache.lines(grid, rect, &map, 15).size() > thinned.size());
+	
+	grid.setHorizontalSpacing(20);
+	QCOMPARE(cache.lines(grid, rect, &map, 0).size(), std::size_t(10));
+}
+
+
+
+void MapTest::spatialQueryTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	auto const extent = map.calculateExtent(true);
+	auto const bruteForceCount = [part](const QRectF& rect) {
+		int count = 0;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			if (part->getObject(i)->getExtent().intersects(rect))
+				++count;
+		}
+		return count;
+	};
+	
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			auto const rect = QRectF(extent.left() + i * extent.width() / 4,
+			                         extent.top() + j * extent.height() / 4,
+			                         extent.width() / 4, extent.height() / 4);
+			QCOMPARE(part->countObjectsInRect(rect, true), bruteForceCount(rect));
+			
+			std::vector<Object*> found;
+			part->findObjectsAtBox(MapCoordF(rect.topLeft()), MapCoordF(rect.bottomRight()), true, true, found);
+			auto expected = std::vector<Object*>();
+			for (int k = 0; k < part->getNumObjects(); ++k)
+			{
+				auto* object = part->getObject(k);
+				if (rect.intersects(object->getExtent()) && object->intersectsBox(rect))
+					expected.push_back(object);
+			}
+			QVERIFY(found == expected);  // including the order
+		}
+	}
+	
+	// Moved objects must be found at their new position only.
+	auto* object = part->getObject(0);
+	auto const old_center = object->getExtent().center();
+	object->move(MapCoord(extent.width() * 2, 0));
+	object->update();
+	auto const new_extent = object->getExtent();
+	QVERIFY(!new_extent.intersects(extent));
+	QCOMPARE(part->countObjectsInRect(new_extent, true), 1);
+	std::vector<Object*> found;
+	part->findObjectsAtBox(MapCoordF(new_extent.topLeft()), MapCoordF(new_extent.bottomRight()), true, true, found);
+	QVERIFY(found == std::vector<Object*>{object});
+	found.clear();
+	part->findObjectsAtBox(MapCoordF(old_center), MapCoordF(old_center), true, true, found);
+	QVERIFY(std::find(begin(found), end(found), object) == end(found));
+	
+	// Deleted objects must not be found.
+	part->deleteObject(0);
+	QCOMPARE(part->countObjectsInRect(new_extent, true), 0);
+}
+
+void MapTest::updateAllObjectsTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	// Loading uses Map::updateAllObjects().
+	std::vector<QRectF> extents;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto const* object = part->getObject(i);
+		QVERIFY(!object->isOutputDirty());
+		extents.push_back(object->getExtent());
+	}
+	
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto const* object = part->getObject(i);
+		object->forceUpdate();
+		QCOMPARE(object->getExtent(), extents[std::size_t(i)]);
+	}
+	
+	map.updateAllObjects();
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		QCOMPARE(part->getObject(i)->getExtent(), extents[std::size_t(i)]);
+	}
+}
+
+void MapTest::extentTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	auto const bruteForceExtent = [part](bool include_helper_symbols) {
+		QRectF rect;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			auto const* object = part->getObject(i);
+			if (!object->getSymbol()->isHidden()
+			    && (include_helper_symbols || !object->getSymbol()->isHelperSymbol()) )
+			{
+				rectIncludeSafe(rect, object->getExtent());
+			}
+		}
+		return rect;
+	};
+	
+	QCOMPARE(part->calculateExtent(true), bruteForceExtent(true));
+	QCOMPARE(part->calculateExtent(false), bruteForceExtent(false));
+	
+	// Moving an object to the outside grows the extent.
+	auto const extent = part->calculateExtent(true);
+	auto* object = part->getObject(0);
+	object->move(MapCoord(extent.width() * 2, 0));
+	object->update();
+	QCOMPARE(part->calculateExtent(true), bruteForceExtent(true));
+	
+	// Moving it back shrinks the extent.
+	object->move(MapCoord(-extent.width() * 2, 0));
+	object->update();
+	QCOMPARE(part->calculateExtent(true), extent);
+	
+	// Releasing and adding an object, like undo and redo.
+	auto const* right_most = part->getObject(0);
+	for (int i = 1; i < part->getNumObjects(); ++i)
+	{
+		if (part->getObject(i)->getExtent().right() > right_most->getExtent().right())
+			right_most = part->getObject(i);
+	}
+	auto const index = part->findObjectIndex(right_most);
+	object = part->releaseObject(index);
+	QCOMPARE(part->calculateExtent(true), bruteForceExtent(true));
+	part->addObject(object, index);
+	QCOMPARE(part->calculateExtent(true), extent);
+	
+	// Hidden symbols do not contribute.
+	auto* symbol = const_cast<Symbol*>(object->getSymbol());
+	symbol->setHidden(true);
+	QCOMPARE(part->calculateExtent(true), bruteForceExtent(true));
+	symbol->setHidden(false);
+	QCOMPARE(part->calculateExtent(true), extent);
+}
+
+void MapTest::symbolIndexTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	auto const bruteForceCount = [part](const Symbol* symbol) {
+		int count = 0;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			if (part->getObject(i)->getSymbol() == symbol)
+				++count;
+		}
+		return count;
+	};
+	auto const verifyIndex = [&map, part, &bruteForceCount]() {
+		for (int i = 0; i < map.getNumSymbols(); ++i)
+		{
+			auto const* symbol = map.getSymbol(i);
+			auto const count = bruteForceCount(symbol);
+			if (int(part->objectsWithSymbol(symbol).size()) != count
+			    || map.existsObjectWithSymbol(symbol) != (count > 0))
+				return false;
+		}
+		return true;
+	};
+	QVERIFY(verifyIndex());
+	
+	std::vector<bool> symbols_in_use;
+	map.determineSymbolsInUse(symbols_in_use);
+	std::vector<bool> expected_in_use(std::size_t(map.getNumSymbols()), false);
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto const index = map.findSymbolIndex(part->getObject(i)->getSymbol());
+		if (index >= 0)
+			expected_in_use[std::size_t(index)] = true;
+	}
+	map.determineSymbolUseClosure(expected_in_use);
+	QCOMPARE(symbols_in_use, expected_in_use);
+	
+	// Changing the symbol of a single object
+	auto* object = part->getObject(0);
+	auto const* old_symbol = object->getSymbol();
+	auto const other = std::find_if(std::begin(map.symbols), std::end(map.symbols), [object, old_symbol](auto const* symbol) {
+		return symbol != old_symbol && symbol->isTypeCompatibleTo(object);
+	});
+	QVERIFY(other != std::end(map.symbols));
+	QVERIFY(object->setSymbol(*other, false));
+	QVERIFY(verifyIndex());
+	
+	// Copying an object's state
+	auto copy = std::unique_ptr<Object>(object->duplicate());
+	QVERIFY(copy->setSymbol(old_symbol, true));
+	object->copyFrom(*copy);
+	QCOMPARE(object->getSymbol(), old_symbol);
+	QVERIFY(verifyIndex());
+	
+	// Changing and deleting all objects with a symbol
+	auto const count = bruteForceCount(old_symbol);
+	auto const other_count = bruteForceCount(*other);
+	map.changeSymbolForAllObjects(old_symbol, *other);
+	QVERIFY(!map.existsObjectWithSymbol(old_symbol));
+	QCOMPARE(bruteForceCount(*other), count + other_count);
+	QVERIFY(verifyIndex());
+	
+	auto const num_objects = part->getNumObjects();
+	QVERIFY(map.deleteAllObjectsWithSymbol(*other));
+	QCOMPARE(part->getNumObjects(), num_objects - count - other_count);
+	QVERIFY(!map.existsObjectWithSymbol(*other));
+	QVERIFY(verifyIndex());
+}
+
+
+
+void MapTest::selectionTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	std::vector<Object*> objects;
+	part->applyOnAllObjects([&objects](Object* object) { objects.push_back(object); });
+	auto const is_selectable = [](auto const* object) {
+		return !object->getSymbol()->isHidden() && !object->getSymbol()->isProtected();
+	};
+	auto const num_selectable = std::size_t(std::count_if(begin(objects), end(objects), is_selectable));
+	QVERIFY(num_selectable > 0);
+	auto* last_selectable = *std::find_if(objects.rbegin(), objects.rend(), is_selectable);
+	
+	QSignalSpy spy(&map, &Map::objectSelectionChanged);
+	map.clearObjectSelection(false);
+	map.addObjectToSelection(last_selectable, false);
+	QCOMPARE(map.addObjectsToSelection(objects, true), num_selectable - 1);
+	QCOMPARE(spy.count(), 1);
+	QCOMPARE(map.getNumSelectedObjects(), int(num_selectable));
+	QCOMPARE(map.getFirstSelectedObject(), last_selectable);
+	for (auto const* object : objects)
+		QCOMPARE(map.isObjectSelected(object), is_selectable(object));
+	
+	// Nothing to add, no signal
+	QCOMPARE(map.addObjectsToSelection(objects, true), std::size_t(0));
+	QCOMPARE(spy.count(), 1);
+	
+	map.removeObjectFromSelection(last_selectable, false);
+	QVERIFY(!map.isObjectSelected(last_selectable));
+	QCOMPARE(map.getNumSelectedObjects(), int(num_selectable) - 1);
+	
+	map.clearObjectSelection(true);
+	QCOMPARE(spy.count(), 2);
+	QVERIFY(map.selectedObjects().empty());
+	QCOMPARE(map.getFirstSelectedObject(), static_cast<Object*>(nullptr));
+}
+
+
+void MapTest::frozenPartTest()
+{
+	Map map;
+	auto* area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	map.addPart(new MapPart(QStringLiteral("second"), &map), 1);
+	
+	auto const close = MapCoord::Flags(MapCoord::ClosePoint | MapCoord::HolePoint);
+	auto* square = new PathObject(area_symbol, {
+	    { 0.0, 0.0 }, { 10.0, 0.0 }, { 10.0, 10.0 }, { 0.0, 10.0 }, { 0.0, 0.0, close },
+	});
+	map.addObject(square, 0);
+	map.addObjectToSelection(square, false);
+	
+	std::vector<Object*> found;
+	map.findObjectsAtBox({ -1.0, -1.0 }, { 11.0, 11.0 }, false, false, found);
+	QCOMPARE(found.size(), std::size_t(1));
+	QVERIFY(!map.hasFrozenParts());
+	QVERIFY(!map.isObjectFrozen(square));
+	
+	map.setPartFrozen(0, true);
+	QVERIFY(map.hasFrozenParts());
+	QVERIFY(map.getPart(0)->isFrozen());
+	QVERIFY(!map.getPart(1)->isFrozen());
+	QVERIFY(map.isObjectFrozen(square));
+	QCOMPARE(map.getNumSelectedObjects(), 0);
+	
+	found.clear();
+	map.findObjectsAtBox({ -1.0, -1.0 }, { 11.0, 11.0 }, false, false, found);
+	QVERIFY(found.empty());
+	SelectionInfoVector found_at;
+	map.findAllObjectsAt({ 5.0, 5.0 }, 0.1, false, false, false, false, found_at);
+	QVERIFY(found_at.empty());
+	
+	// New objects in a frozen part are frozen, too.
+	auto* copy = square->duplicate();
+	map.addObject(copy, 0);
+	QVERIFY(map.isObjectFrozen(copy));
+	
+	map.setPartFrozen(0, false);
+	QVERIFY(!map.hasFrozenParts());
+	QVERIFY(!map.isObjectFrozen(copy));
+	found.clear();
+	map.findObjectsAtBox({ -1.0, -1.0 }, { 11.0, 11.0 }, false, false, found);
+	QCOMPARE(found.size(), std::size_t(2));
+}
+
+
+void MapTest::transferObjectsTest()
+{
+	Map map;
+	auto* area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	map.addPart(new MapPart(QStringLiteral("second"), &map), 1);
+	
+	auto const close = MapCoord::Flags(MapCoord::ClosePoint | MapCoord::HolePoint);
+	std::vector<Object*> objects;
+	for (int i = 0; i < 5; ++i)
+	{
+		auto const x = 20.0 * i;
+		objects.push_back(new PathObject(area_symbol, {
+		    { x, 0.0 }, { x + 10.0, 0.0 }, { x + 10.0, 10.0 }, { x, 10.0 }, { x, 0.0, close },
+		}));
+	}
+	map.addObjects(objects, 0);
+	auto* part_0 = map.getPart(0);
+	auto* part_1 = map.getPart(1);
+	
+	auto const order = [](const MapPart* part) {
+		std::vector<const Object*> result;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+			result.push_back(part->getObject(i));
+		return result;
+	};
+	
+	std::vector<int> const indices = { 3, 1 };
+	QCOMPARE(map.reassignObjectsToMapPart(begin(indices), end(indices), 0, 1), 0);
+	QCOMPARE(order(part_0), (std::vector<const Object*>{ objects[0], objects[2], objects[4] }));
+	QCOMPARE(order(part_1), (std::vector<const Object*>{ objects[3], objects[1] }));
+	
+	std::vector<Object*> found;
+	part_1->findObjectsAtBox({ 15.0, -1.0 }, { 75.0, 11.0 }, false, false, found);
+	QCOMPARE(found.size(), std::size_t(2));
+	
+	auto undo_step = std::make_unique<SwitchPartUndoStep>(&map, 1, 0);
+	for (auto i : indices)
+		undo_step->addObject(i);
+	std::unique_ptr<UndoStep> redo_step(undo_step->undo());
+	QCOMPARE(order(part_0), (std::vector<const Object*>{ objects.begin(), objects.end() }));
+	QCOMPARE(part_1->getNumObjects(), 0);
+	
+	std::unique_ptr<UndoStep> undo_again(redo_step->undo());
+	QCOMPARE(order(part_0), (std::vector<const Object*>{ objects[0], objects[2], objects[4] }));
+	QCOMPARE(order(part_1), (std::vector<const Object*>{ objects[3], objects[1] }));
+	
+	QCOMPARE(map.mergeParts(1, 0), 3);
+	QCOMPARE(map.getNumParts(), 1);
+	QCOMPARE(order(part_0), (std::vector<const Object*>{ objects[0], objects[2], objects[4], objects[3], objects[1] }));
+	
+	found.clear();
+	map.findObjectsAtBox({ -1.0, -1.0 }, { 91.0, 11.0 }, false, false, found);
+	QCOMPARE(found.size(), std::size_t(5));
+}
+
+
+void MapTest::deferredUpdatesTest()
+{
+	Map map;
+	auto* area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	
+	auto const close = MapCoord::Flags(MapCoord::ClosePoint | MapCoord::HolePoint);
+	std::vector<Object*> objects;
+	for (int i = 0; i < 3; ++i)
+	{
+		auto const x = 20.0 * i;
+		objects.push_back(new PathObject(area_symbol, {
+		    { x, 0.0 }, { x + 10.0, 0.0 }, { x + 10.0, 10.0 }, { x, 10.0 }, { x, 0.0, close },
+		}));
+	}
+	map.addObjects(objects, 0);
+	
+	map.updateAllObjectsDeferred({});
+	QVERIFY(map.hasDeferredObjectUpdates());
+	QVERIFY(objects[0]->isOutputDirty());
+	
+	// The deleted object must be skipped by the pending updates.
+	QVERIFY(map.getPart(0)->deleteObject(objects[1]));
+	map.updateDeferredObjectsInRect({ -100.0, -100.0, 200.0, 200.0 });
+	QVERIFY(!objects[0]->isOutputDirty());
+	QVERIFY(!objects[2]->isOutputDirty());
+	
+	map.getPart(0)->deleteObject(objects[2]);
+	map.finishDeferredObjectUpdates();
+	QVERIFY(!map.hasDeferredObjectUpdates());
+	
+	// updateObjects() finishes pending deferred updates.
+	map.updateAllObjectsDeferred({});
+	QVERIFY(map.hasDeferredObjectUpdates());
+	map.updateObjects();
+	QVERIFY(!map.hasDeferredObjectUpdates());
+	QVERIFY(!objects[0]->isOutputDirty());
+}
+
+
+
+void MapTest::validatorTest()
+{
+	Map map;
+	auto* area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	
+	auto const close = MapCoord::Flags(MapCoord::ClosePoint | MapCoord::HolePoint);
+	auto* square = new PathObject(area_symbol, {
+	    { 0.0, 0.0 }, { 10.0, 0.0 }, { 10.0, 10.0 }, { 0.0, 10.0 }, { 0.0, 0.0, close },
+	});
+	auto* bow_tie = new PathObject(area_symbol, {
+	    { 20.0, 0.0 }, { 30.0, 10.0 }, { 30.0, 0.0 }, { 20.0, 10.0 }, { 20.0, 0.0, close },
+	});
+	auto* zero_length = new PathObject(Map::getCoveringRedLine(), {
+	    { 40.0, 0.0 }, { 45.0, 0.0 }, { 45.0, 0.0 }, { 50.0, 0.0 },
+	});
+	auto* hole_outside = new PathObject(area_symbol, {
+	    { 60.0, 0.0 }, { 70.0, 0.0 }, { 70.0, 10.0 }, { 60.0, 10.0 }, { 60.0, 0.0, close },
+	    { 80.0, 2.0 }, { 82.0, 2.0 }, { 82.0, 4.0 }, { 80.0, 2.0, close },
+	});
+	auto* duplicate = square->duplicate();
+	for (auto* object : { square, bow_tie, zero_length, hole_outside, duplicate })
+		map.addObject(object);
+	
+	MapValidator validator(map);
+	validator.start();
+	QVERIFY(validator.isRunning());
+	QTRY_VERIFY(!validator.isRunning());
+	
+	QCOMPARE(validator.issues(square), MapValidator::Issues(MapValidator::DuplicateObject));
+	QCOMPARE(validator.issues(duplicate), MapValidator::Issues(MapValidator::DuplicateObject));
+	QCOMPARE(validator.issues(bow_tie), MapValidator::Issues(MapValidator::SelfIntersection));
+	QCOMPARE(validator.issues(zero_length), MapValidator::Issues(MapValidator::ZeroLengthSegment));
+	QCOMPARE(validator.issues(hole_outside), MapValidator::Issues(MapValidator::HoleOutsideOutline));
+	QCOMPARE(validator.objectsWithIssues().size(), std::size_t(5));
+	
+	// Edited objects are validated again.
+	duplicate->move(MapCoord(100.0, 0.0));
+	duplicate->update();
+	QVERIFY(validator.isRunning());
+	QTRY_VERIFY(!validator.isRunning());
+	QCOMPARE(validator.issues(duplicate), MapValidator::Issues(MapValidator::NoIssue));
+	
+	// The square's duplicate flag is outdated, but not reported.
+	QCOMPARE(validator.objectsWithIssues().size(), std::size_t(3));
+	QCOMPARE(validator.issues(square), MapValidator::Issues(MapValidator::NoIssue));
+	
+	delete map.getCurrentPart()->releaseObject(bow_tie);
+	QCOMPARE(validator.objectsWithIssues().size(), std::size_t(2));
+}
+
+
 
 void MapTest::crtFileTest()
 {
@@ -403,6 +957,52 @@ void MapTest::matchQuerySymbolNumberTest()
 
 
 
+void MapTest::symbolRuleSetApplyTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), &view));
+	auto* part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	// Each used symbol is replaced by the next compatible symbol.
+	auto r = SymbolRuleSet::forUsedSymbols(map);
+	QVERIFY(r.size() > 2u);
+	for (auto& item : r)
+	{
+		auto const* original = item.query.symbolOperand();
+		auto const first = std::find(std::begin(map.symbols), std::end(map.symbols), original);
+		auto const other = std::find_if(first + 1, std::end(map.symbols), [original](auto const* symbol) {
+			return symbol->getType() == original->getType();
+		});
+		if (other == std::end(map.symbols))
+			continue;
+		item.symbol = *other;
+		item.type = SymbolRule::DefinedAssignment;
+	}
+	// A later, more specific rule takes precedence.
+	auto* object = part->getObject(0);
+	r.push_back({ ObjectQuery(object->getSymbol()), object->getSymbol(), SymbolRule::DefinedAssignment });
+	
+	std::vector<const Symbol*> expected;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto const* current = part->getObject(i);
+		auto const match = std::find_if(r.rbegin(), r.rend(), [current](auto const& item) {
+			return item.type != SymbolRule::NoAssignment && item.symbol && item.query(current);
+		});
+		expected.push_back(match != r.rend() ? match->symbol : current->getSymbol());
+	}
+	QCOMPARE(expected[0], object->getSymbol());
+	
+	r.apply(map, map, {});
+	QCOMPARE(part->getNumObjects(), int(expected.size()));
+	for (int i = 0; i < part->getNumObjects(); ++i)
+		QCOMPARE(part->getObject(i)->getSymbol(), expected[std::size_t(i)]);
+}
+
+
+
 /*
  * We don't need a real GUI window.
  * 
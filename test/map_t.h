@@ -48,9 +48,42 @@ private slots:
 	void importTest_data();
 	void importTest();
 	
+	/** Tests Map::createSnapshot(). */
+	void snapshotTest();
+	
 	/** Tests hasAlpha() functions. */
 	void hasAlpha();
 	
+	/** Tests the calculation, thinning and caching of grid lines. */
+	void gridLinesTest();
+	
+	/** Tests spatial object queries against a brute force search. */
+	void spatialQueryTest();
+	
+	/** Tests that concurrent updates give the same results as serial updates. */
+	void updateAllObjectsTest();
+	
+	/** Tests the maintained map part extent against a brute force calculation. */
+	void extentTest();
+	
+	/** Tests the symbol index of map parts against a brute force search. */
+	void symbolIndexTest();
+	
+	/** Tests adding many objects to the selection at once. */
+	void selectionTest();
+	
+	/** Tests hit testing and rendering state of frozen map parts. */
+	void frozenPartTest();
+	
+	/** Tests moving objects between map parts as a whole, with undo. */
+	void transferObjectsTest();
+	
+	/** Tests deleting objects while deferred updates are pending. */
+	void deferredUpdatesTest();
+	
+	/** Tests the detection of problematic objects. */
+	void validatorTest();
+	
 	/** Basic tests for symbol set replacements. */
 	void crtFileTest();
 	
@@ -58,6 +91,9 @@ private slots:
 	void matchQuerySymbolNumberTest_data();
 	void matchQuerySymbolNumberTest();
 	
+	/** Tests applying symbol rules against the rules' individual evaluation. */
+	void symbolRuleSetApplyTest();
+	
 };
 
 #endif
@@ -0,0 +1,144 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QObject>
+#include <QPainter>
+#include <QRect>
+#include <QRectF>
+#include <QTransform>
+
+#include "gui/map/map_tile_cache.h"
+#include "gui/map/map_tile_store.h"
+
+using namespace OpenOrienteering;
+
+
+namespace {
+
+/// The area which is rendered in the invalidation test, in grid pixels.
+const QRect grid_rect = { 0, 0, MapTileCache::tile_size, MapTileCache::tile_size };
+
+void renderNothing(QPainter& /*painter*/, const QRectF& /*map_rect*/)
+{}
+
+}  // namespace
+
+
+
+/**
+ * @test Tests the sharing of map tile caches between widgets.
+ */
+class MapTileStoreTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void reuseTest()
+	{
+		MapTileStore store;
+		auto const first = store.acquire({ 2, 0, 0, 2, 10.1, 20.2 }, 0, {});
+		QVERIFY(first);
+		QCOMPARE(first->layout().m11(), 2.0);
+		QVERIFY(qAbs(first->layout().dx() - 0.1) < 0.000001);
+		QVERIFY(qAbs(first->layout().dy() - 0.2) < 0.000001);
+		
+		// An integer offset, within 0.25 px
+		QCOMPARE(store.acquire({ 2, 0, 0, 2, 13.1, 20.2 }, 0, {}), first);
+		QCOMPARE(store.acquire({ 2, 0, 0, 2, 13.3, 19.0 }, 0, {}), first);
+		QCOMPARE(store.acquire({ 2, 0, 0, 2, 9.9, 24.4 }, 0, {}), first);
+		
+		// Different fraction of the offset, different scale, different options
+		QVERIFY(store.acquire({ 2, 0, 0, 2, 10.4, 20.2 }, 0, {}) != first);
+		QVERIFY(store.acquire({ 2, 0, 0, 2, 10.1, 19.9 }, 0, {}) != first);
+		QVERIFY(store.acquire({ 3, 0, 0, 3, 10.1, 20.2 }, 0, {}) != first);
+		QVERIFY(store.acquire({ 2, 0, 0, 2, 10.1, 20.2 }, 1, {}) != first);
+	}
+	
+	void sharedTest()
+	{
+		MapTileStore store;
+		auto widget_1 = store.acquire({ 2, 0, 0, 2, 0.5, 0.5 }, 0, {});
+		auto widget_2 = store.acquire({ 2, 0, 0, 2, 0.5, 0.5 }, 0, {});
+		QCOMPARE(widget_2, widget_1);
+		auto const* shared = widget_1.get();
+		
+		// The shared cache keeps its layout for the second widget.
+		widget_1 = store.acquire({ 4, 0, 0, 4, 0.5, 0.5 }, 0, std::move(widget_1));
+		QVERIFY(widget_1.get() != shared);
+		QCOMPARE(widget_2.get(), shared);
+		QCOMPARE(widget_2->layout().m11(), 2.0);
+		QCOMPARE(widget_1->layout().m11(), 4.0);
+	}
+	
+	void unsharedTest()
+	{
+		MapTileStore store;
+		auto widget_1 = store.acquire({ 2, 0, 0, 2, 0.5, 0.5 }, 0, {});
+		auto widget_2 = store.acquire({ 2, 0, 0, 2, 0.5, 0.5 }, 0, {});
+		auto const* cache = widget_1.get();
+		
+		// When the other widget dropped its reference, the cache is no longer
+		// shared, and it gets the new layout and options.
+		widget_2.reset();
+		widget_1 = store.acquire({ 4, 0, 0, 4, 0.5, 0.5 }, 1, std::move(widget_1));
+		QCOMPARE(widget_1.get(), cache);
+		QCOMPARE(widget_1->layout().m11(), 4.0);
+		
+		// It is found by its new layout and options.
+		QCOMPARE(store.acquire({ 4, 0, 0, 4, 1.5, 0.5 }, 1, {}), widget_1);
+		QVERIFY(store.acquire({ 2, 0, 0, 2, 0.5, 0.5 }, 0, {}) != widget_1);
+	}
+	
+	void invalidationTest()
+	{
+		MapTileStore store;
+		auto first = store.acquire({ 2, 0, 0, 2, 0, 0 }, 0, {});
+		auto second = store.acquire({ 2, 0, 0, 2, 0, 0 }, 1, {});
+		auto third = store.acquire({ 1, 0, 0, 1, 0, 0 }, 0, {});
+		auto expired = store.acquire({ 3, 0, 0, 3, 0, 0 }, 0, {});
+		expired.reset();
+		for (auto* cache : { first.get(), second.get(), third.get() })
+		{
+			cache->render(grid_rect, &renderNothing, false);
+			QVERIFY(!cache->pendingArea(grid_rect).isValid());
+		}
+		
+		store.invalidate({ 10, 10, 5, 5 });
+		for (auto* cache : { first.get(), second.get(), third.get() })
+			QVERIFY(cache->pendingArea(grid_rect).isValid());
+		
+		// Outside the rendered area
+		for (auto* cache : { first.get(), second.get(), third.get() })
+			cache->render(grid_rect, &renderNothing, false);
+		store.invalidate({ 1000, 1000, 5, 5 });
+		for (auto* cache : { first.get(), second.get(), third.get() })
+			QVERIFY(!cache->pendingArea(grid_rect).isValid());
+	}
+	
+};
+
+
+QTEST_GUILESS_MAIN(MapTileStoreTest)
+#include "map_tile_store_t.moc"  // IWYU pragma: keep
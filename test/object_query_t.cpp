@@ -1,6 +1,6 @@
 /*
  *    Copyright 2016 Mitchell Krome
- *    Copyright 2017-2022 Kai Pastor
+ *    Copyright 2017-2022, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <algorithm>
+#include <vector>
 
 #include <QtGlobal>
 #include <QtTest>
@@ -30,9 +31,11 @@
 #include <QString>
 
 #include "core/map.h"
+#include "core/map_part.h"
 #include "core/objects/object.h"
 #include "core/objects/text_object.h"
 #include "core/objects/object_query.h"
+#include "core/symbols/area_symbol.h"
 #include "core/symbols/point_symbol.h"
 
 using namespace OpenOrienteering;
@@ -508,6 +511,197 @@ void ObjectQueryTest::testParser()
 	QCOMPARE(p.parse(QStringLiteral("SYMBOL \"\"")), q);
 }
 
+void ObjectQueryTest::testProgram()
+{
+	Map map;
+	auto* symbol_1 = new PointSymbol();
+	symbol_1->setNumberComponent(0, 101);
+	map.addSymbol(symbol_1, 0);
+	auto* symbol_2 = new PointSymbol();
+	symbol_2->setNumberComponent(0, 102);
+	map.addSymbol(symbol_2, 1);
+	
+	for (int i = 0; i < 40; ++i)
+	{
+		auto* object = new PointObject(i % 3 ? symbol_1 : symbol_2);
+		KeyValueContainer tags;
+		tags.insert_or_assign(QStringLiteral("a"), QString::number(i % 4));
+		if (i % 5)
+			tags.insert_or_assign(QStringLiteral("b"), QString::number(i));
+		object->setTags(tags);
+		map.addObject(object);
+	}
+	auto* part = map.getCurrentPart();
+	
+	auto const queries = {
+	    QStringLiteral("a = 1"),
+	    QStringLiteral("a != 1"),
+	    QStringLiteral("b ~= 1"),
+	    QStringLiteral("a = 2 AND b ~= 2"),
+	    QStringLiteral("a = 2 AND NOT b ~= 2"),
+	    QStringLiteral("a = 0 OR b = 13"),
+	    QStringLiteral("a = 0 OR NOT b ~= 1"),
+	    QStringLiteral("SYMBOL 102 AND a = 3"),
+	    QStringLiteral("SYMBOL 101 OR SYMBOL 102"),
+	    QStringLiteral("\"3\""),
+	    QStringLiteral("d = 1"),
+	};
+	auto const verify = [part](const ObjectQuery& query) {
+		auto const program = ObjectQueryProgram(query);
+		std::vector<Object*> expected;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			auto* object = part->getObject(i);
+			if (program(object) != query(object))
+				return false;
+			if (query(object))
+				expected.push_back(object);
+		}
+		return program.findMatchingObjects(*part) == expected;
+	};
+	
+	auto parser = ObjectQueryParser(&map);
+	for (auto const& text : queries)
+	{
+		auto const query = parser.parse(text);
+		QVERIFY2(query, qPrintable(text));
+		QVERIFY2(verify(query), qPrintable(text));
+	}
+	QVERIFY(ObjectQueryProgram().findMatchingObjects(*part).empty());
+	
+	// The tag index follows changes of the objects.
+	auto const query = parser.parse(QStringLiteral("a = 1"));
+	QVERIFY(verify(query));
+	part->getObject(0)->setTag(QStringLiteral("a"), QStringLiteral("1"));
+	QVERIFY(verify(query));
+	part->getObject(5)->removeTag(QStringLiteral("a"));
+	QVERIFY(verify(query));
+	part->deleteObject(1);
+	QVERIFY(verify(query));
+	auto* object = new PointObject(symbol_1);
+	object->setTag(QStringLiteral("a"), QStringLiteral("1"));
+	part->addObject(object, 0);
+	QVERIFY(verify(query));
+}
+
+void ObjectQueryTest::testCandidates()
+{
+	Map map;
+	auto* symbol_1 = new PointSymbol();
+	symbol_1->setNumberComponent(0, 101);
+	map.addSymbol(symbol_1, 0);
+	auto* symbol_2 = new PointSymbol();
+	symbol_2->setNumberComponent(0, 102);
+	map.addSymbol(symbol_2, 1);
+	
+	for (int i = 0; i < 30; ++i)
+	{
+		auto* object = new PointObject(i % 2 ? symbol_1 : symbol_2);
+		object->setTag(QStringLiteral("a"), QString::number(i % 3));
+		map.addObject(object);
+	}
+	auto* part = map.getCurrentPart();
+	auto parser = ObjectQueryParser(&map);
+	
+	auto const restricted = {
+	    QStringLiteral("a = 1"),
+	    QStringLiteral("a ~= 2 AND NOT SYMBOL 101"),
+	    QStringLiteral("SYMBOL 102 OR a = 0"),
+	};
+	for (auto const& text : restricted)
+	{
+		auto const program = ObjectQueryProgram(parser.parse(text));
+		std::vector<Object*> candidates;
+		QVERIFY2(program.findCandidateObjects(*part, candidates), qPrintable(text));
+		QVERIFY2(candidates.size() < std::size_t(part->getNumObjects()), qPrintable(text));
+		auto sorted = candidates;
+		part->sortByObjectOrder(sorted);
+		QVERIFY2(candidates == sorted, qPrintable(text));
+		
+		auto const matches = program.findMatchingObjects(*part);
+		QVERIFY2(std::includes(candidates.begin(), candidates.end(), matches.begin(), matches.end(), [part](const Object* a, const Object* b) {
+			return part->findObjectIndex(a) < part->findObjectIndex(b);
+		}), qPrintable(text));
+	}
+	
+	auto const unrestricted = {
+	    QStringLiteral("a != 1"),
+	    QStringLiteral("NOT SYMBOL 101"),
+	    QStringLiteral("a = 1 OR \"2\""),
+	};
+	for (auto const& text : unrestricted)
+	{
+		std::vector<Object*> candidates;
+		QVERIFY2(!ObjectQueryProgram(parser.parse(text)).findCandidateObjects(*part, candidates), qPrintable(text));
+	}
+}
+
+
+void ObjectQueryTest::testSpatial()
+{
+	Map map;
+	auto* area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	auto* point_symbol = new PointSymbol();
+	map.addSymbol(point_symbol, 1);
+	
+	auto* area = new PathObject(area_symbol, { MapCoord(0.0, 0.0), MapCoord(10.0, 0.0), MapCoord(10.0, 10.0), MapCoord(0.0, 10.0) });
+	area->closeAllParts();
+	map.addObject(area);
+	
+	auto add_point = [&map, point_symbol](double x, double y) {
+		auto* point = new PointObject(point_symbol);
+		point->setPosition(MapCoord(x, y));
+		map.addObject(point);
+		return point;
+	};
+	auto* inside = add_point(5.0, 5.0);
+	auto* near = add_point(11.0, 5.0);
+	auto* far = add_point(20.0, 20.0);
+	auto* crossing = new PathObject(nullptr, { MapCoord(-5.0, 5.0), MapCoord(5.0, 5.0) });
+	map.addObject(crossing);
+	
+	auto* part = map.getCurrentPart();
+	auto const reference = std::vector<const Object*>{ area };
+	auto matches = [part](const ObjectQuery& query, const Object* object) {
+		auto const result = ObjectQueryProgram(query).findMatchingObjects(*part);
+		return std::find(result.begin(), result.end(), object) != result.end();
+	};
+	
+	auto const inside_query = ObjectQuery(ObjectQuery::OperatorInside, reference);
+	QVERIFY(inside_query);
+	QVERIFY(inside_query.spatialOperands());
+	QVERIFY(matches(inside_query, inside));
+	QVERIFY(!matches(inside_query, crossing));
+	QVERIFY(!matches(inside_query, near));
+	QVERIFY(!matches(inside_query, far));
+	
+	auto const intersects_query = ObjectQuery(ObjectQuery::OperatorIntersects, reference);
+	QVERIFY(matches(intersects_query, inside));
+	QVERIFY(matches(intersects_query, crossing));
+	QVERIFY(!matches(intersects_query, near));
+	QVERIFY(!matches(intersects_query, far));
+	
+	auto const near_query = ObjectQuery(ObjectQuery::OperatorWithinDistance, reference, 2.0);
+	QVERIFY(matches(near_query, inside));
+	QVERIFY(matches(near_query, crossing));
+	QVERIFY(matches(near_query, near));
+	QVERIFY(!matches(near_query, far));
+	
+	// Copies share the reference geometry.
+	auto copy = near_query;
+	QCOMPARE(copy, near_query);
+	QVERIFY(copy.spatialOperands()->reference == near_query.spatialOperands()->reference);
+	QVERIFY(!(copy == ObjectQuery(ObjectQuery::OperatorWithinDistance, reference, 3.0)));
+	
+	// Combined with other operators
+	auto const combined = ObjectQuery(ObjectQuery(ObjectQuery::OperatorWithinDistance, reference, 2.0),
+	                                  ObjectQuery::OperatorAnd,
+	                                  ObjectQuery::negation(ObjectQuery(ObjectQuery::OperatorInside, reference)));
+	QVERIFY(!matches(combined, inside));
+	QVERIFY(matches(combined, near));
+}
+
 
 /*
  * We don't need a real GUI window.
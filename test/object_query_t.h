@@ -1,6 +1,6 @@
 /*
  *    Copyright 2016 Mitchell Krome
- *    Copyright 2017-2020 Kai Pastor
+ *    Copyright 2017-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -48,6 +48,9 @@ private slots:
 	void testNegation();
 	void testToString();
 	void testParser();
+	void testProgram();
+	void testCandidates();
+	void testSpatial();
 
 private:
 	const Object* testObject();
@@ -18,6 +18,8 @@
  *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <memory>
+
 #include <QtTest>
 #include <QObject>
 
@@ -180,6 +182,77 @@ private slots:
 		QCOMPARE(to_text.map(to_map.map(anchor_text_2)), anchor_text_2);
 	}
 	
+	
+	void incrementalTextLayoutTest_data()
+	{
+		QTest::addColumn<QString>("old_text");
+		QTest::addColumn<QString>("new_text");
+		QTest::addColumn<int>("v_align");
+		
+		auto const text = QStringLiteral("First line\nSecond\tline\nThird line");
+		QTest::newRow("edit last line")    << text << QStringLiteral("First line\nSecond\tline\nThird lines") << int(TextObject::AlignVCenter);
+		QTest::newRow("edit first line")   << text << QStringLiteral("First\nSecond\tline\nThird line") << int(TextObject::AlignBottom);
+		QTest::newRow("add line")          << text << text + QStringLiteral("\nFourth line") << int(TextObject::AlignVCenter);
+		QTest::newRow("remove line break") << text << QStringLiteral("First line\nSecond\tline Third line") << int(TextObject::AlignTop);
+	}
+	
+	void incrementalTextLayoutTest()
+	{
+		QFETCH(QString, old_text);
+		QFETCH(QString, new_text);
+		QFETCH(int, v_align);
+		
+		TextSymbol text_symbol;
+		TextObject object(&text_symbol);
+		object.setVerticalAlignment(TextObject::VerticalAlignment(v_align));
+		object.setText(old_text);
+		object.prepareLineInfos();
+		object.setText(new_text);
+		object.prepareLineInfos();
+		
+		TextObject reference(&text_symbol);
+		reference.setVerticalAlignment(TextObject::VerticalAlignment(v_align));
+		reference.setText(new_text);
+		reference.prepareLineInfos();
+		
+		QCOMPARE(object.getNumLines(), reference.getNumLines());
+		for (int i = 0; i < reference.getNumLines(); ++i)
+		{
+			auto const* line_info = object.getLineInfo(i);
+			auto const* reference_info = reference.getLineInfo(i);
+			QCOMPARE(line_info->start_index, reference_info->start_index);
+			QCOMPARE(line_info->end_index, reference_info->end_index);
+			QCOMPARE(line_info->line_x, reference_info->line_x);
+			QCOMPARE(line_info->line_y, reference_info->line_y);
+		}
+		QCOMPARE(object.getTextPath().boundingRect(), reference.getTextPath().boundingRect());
+	}
+	
+	
+	void tagsTest()
+	{
+		PathObject object;
+		QVERIFY(object.tags().empty());
+		QCOMPARE(object.getTag(QStringLiteral("name")), QString{});
+		
+		object.setTag(QStringLiteral("name"), QStringLiteral("value"));
+		QCOMPARE(int(object.tags().size()), 1);
+		QCOMPARE(object.getTag(QStringLiteral("name")), QStringLiteral("value"));
+		
+		std::unique_ptr<Object> copy { object.duplicate() };
+		QCOMPARE(copy->tags(), object.tags());
+		QVERIFY(copy->equals(&object, true));
+		
+		copy->removeTag(QStringLiteral("name"));
+		QVERIFY(copy->tags().empty());
+		QVERIFY(!copy->equals(&object, true));
+		QCOMPARE(object.getTag(QStringLiteral("name")), QStringLiteral("value"));
+		
+		object.setTags({});
+		QVERIFY(object.tags().empty());
+		QVERIFY(copy->equals(&object, true));
+	}
+	
 };  // class ObjectTest
 
 /*
@@ -145,6 +145,34 @@ private slots:
 		QVERIFY(reader.atEnd());
 	}
 	
+	
+	void benchmark_data()
+	{
+		QTest::addColumn<QString>("param_string");
+		
+		QTest::newRow("Stringtype: 9 (Color)") << "All printing colours\tn1\tk100\tc100\tm100\ty100\tsProcess Black\tp100\tsPMS471_Brown\tp100\tsPMS136_Yellow\tp100\tsPMS299_Blue\tp100\tsPMS361_Green\tp100\tsPMS428_Grey\tp100\tsPurple\tp100\to0\tt100\tbNormal";
+		QTest::newRow("Stringtype: 1030 (ViewPar)") << "\tx11.120000\ty-2.010000\tz14.301646\tv0\tm100\tt100\tb50\tc50\th0\tk0\tp0\td0\ti0\tl0";
+	}
+	
+	void benchmark()
+	{
+		QFETCH(QString, param_string);
+		
+		auto sum = 0.0;
+		QBENCHMARK
+		{
+			auto reader = OcdParameterStreamReader(param_string);
+			while (reader.readNext())
+			{
+				bool ok;
+				auto const value = reader.value().toDouble(&ok);
+				if (ok)
+					sum += value;
+			}
+		}
+		QVERIFY(sum != 0);
+	}
+	
 };  // class OcdFileImportTest
 
 
@@ -31,6 +31,8 @@
 #include <QObject>
 #include <QString>
 
+#include "core/map_coord.h"
+#include "fileformats/ocd_point_codec.h"
 #include "fileformats/ocd_types.h"
 #include "fileformats/ocd_types_v8.h"
 #include "fileformats/ocd_types_v9.h"
@@ -107,6 +109,45 @@ private slots:
 	
 	
 	
+	/**
+	 * Tests the round trip of coordinates and flags through the OCD point codec.
+	 */
+	void pointCodecTest()
+	{
+		using OpenOrienteering::MapCoord;
+		MapCoord const coords[] = {
+		    MapCoord::fromNative(0, 0),
+		    MapCoord::fromNative(12340, -56780, MapCoord::CurveStart),
+		    MapCoord::fromNative(-1000, 2000),
+		    MapCoord::fromNative(-3000, 4000),
+		    MapCoord::fromNative(5000, 6000, MapCoord::DashPoint),
+		    MapCoord::fromNative(7000, -8000, MapCoord::HolePoint),
+		    MapCoord::fromNative(9000, 10000),
+		};
+		constexpr auto n = std::extent<decltype(coords)>::value;
+		
+		QByteArray data(int(n * sizeof(Ocd::OcdPoint32)), Qt::Uninitialized);
+		Ocd::encodePoints(coords, coords + n, data.data(), Ocd::OcdPoint32::FlagDash);
+		auto const* points = reinterpret_cast<const Ocd::OcdPoint32*>(data.constData());
+		QVERIFY(points[2].x & Ocd::OcdPoint32::FlagCtl1);
+		QVERIFY(points[3].x & Ocd::OcdPoint32::FlagCtl2);
+		QVERIFY(points[4].y & Ocd::OcdPoint32::FlagDash);
+		QVERIFY(points[6].y & Ocd::OcdPoint32::FlagHole);
+		
+		MapCoord decoded[n];
+		Ocd::decodePoints(points, points + n, decoded);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			QCOMPARE(decoded[i].nativeX(), coords[i].nativeX());
+			QCOMPARE(decoded[i].nativeY(), coords[i].nativeY());
+			QCOMPARE(decoded[i].isCurveStart(), coords[i].isCurveStart());
+			QCOMPARE(decoded[i].isDashPoint(), coords[i].isDashPoint());
+		}
+		
+		QCOMPARE(Ocd::decodePosition({ qint32(0x80000000u), 0 }), MapCoord());
+	}
+	
+	
 	/*
 	 * Ocd::PascalString<N> represents a string of N bytes, preceded by a byte
 	 * giving the length. So a trailing zero is not required.
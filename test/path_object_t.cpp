@@ -20,11 +20,17 @@
 
 #include "path_object_t.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
 #include <QtTest>
 
 #include "core/map.h"
 #include "core/objects/object.h"
 #include "core/symbols/line_symbol.h"
+#include "util/util.h"
 
 using namespace OpenOrienteering;
 
@@ -58,6 +64,52 @@ char* toString(const PathObject::Intersections& intersections)
 
 
 
+namespace
+{
+
+// Reference implementations of the PathCoordVector kernels
+
+QRectF referenceExtent(const PathCoordVector& path_coords)
+{
+	auto pc = path_coords.begin();
+	auto extent = QRectF(pc->pos.x(), pc->pos.y(), 0.0001, 0.0001);
+	for (++pc; pc != path_coords.end(); ++pc)
+		rectInclude(extent, pc->pos);
+	return extent;
+}
+
+bool referenceIntersectsBox(const PathCoordVector& path_coords, const QRectF& box)
+{
+	for (auto pc = path_coords.begin() + 1; pc != path_coords.end(); ++pc)
+	{
+		if (lineIntersectsRect(box, (pc-1)->pos, pc->pos))
+			return true;
+	}
+	return false;
+}
+
+bool referenceIsPointInside(const PathCoordVector& path_coords, const MapCoordF& coord)
+{
+	bool inside = false;
+	auto last_pos = path_coords.back().pos;
+	for (const auto& path_coord : path_coords)
+	{
+		auto pos = path_coord.pos;
+		if ( ((pos.y() > coord.y()) != (last_pos.y() > coord.y())) &&
+		     (coord.x() < (last_pos.x() - pos.x()) *
+		      (coord.y() - pos.y()) / (last_pos.y() - pos.y()) + pos.x()) )
+		{
+			inside = !inside;
+		}
+		last_pos = pos;
+	}
+	return inside;
+}
+
+}  // namespace
+
+
+
 namespace  {
 
 bool equalXY(MapCoord const& lhs, MapCoord const& rhs) {
@@ -396,6 +448,31 @@ void PathObjectTest::copyFromTest()
 
 
 
+void PathObjectTest::sharedCoordinatesTest()
+{
+	PathObject proto{Map::getCoveringRedLine()};
+	proto.addCoordinate({0.0, 0.0});
+	proto.addCoordinate({4.0, 0.0});
+	proto.addCoordinate({4.0, 3.0});
+	proto.update();
+	
+	std::unique_ptr<PathObject> copy{proto.duplicate()};
+	QCOMPARE(&copy->getRawCoordinateVector(), &proto.getRawCoordinateVector());
+	
+	// Modifying the copy must not modify the prototype.
+	copy->setCoordinate(2, MapCoord{4.0, 6.0});
+	QVERIFY(&copy->getRawCoordinateVector() != &proto.getRawCoordinateVector());
+	QCOMPARE(proto.getCoordinate(2), MapCoord(4.0, 3.0));
+	QCOMPARE(copy->getCoordinate(2), MapCoord(4.0, 6.0));
+	
+	// The parts must follow the detached coordinates.
+	copy->update();
+	QCOMPARE(copy->parts().front().length(), 10.0);
+	QCOMPARE(proto.parts().front().length(), 7.0);
+}
+
+
+
 void PathObjectTest::changePathBoundsBasicTest_data()
 {
 	QTest::addColumn<int>("dash_point_index");
@@ -1100,6 +1177,152 @@ void PathObjectTest::calcIntersectionsTest()
 		
 		QCOMPARE(calculateIntersections(aib2, aib1), intersections_bia);
 	}
+	
+	{
+		// Many segments
+		PathObject zigzag{Map::getCoveringRedLine()};
+		for (int i = 0; i <= 100; ++i)
+			zigzag.addCoordinate(MapCoord(10 * i, (i % 2) ? 10 : -10));
+		
+		PathObject straight{Map::getCoveringRedLine()};
+		straight.addCoordinate(MapCoord(-5, 0));
+		straight.addCoordinate(MapCoord(1005, 0));
+		
+		auto const intersections = calculateIntersections(straight, zigzag);
+		QCOMPARE(int(intersections.size()), 100);
+		for (int i = 0; i < 100; ++i)
+			QCOMPARE(intersections[std::size_t(i)].length, PathCoord::length_type(10 + 10 * i));
+		
+		QCOMPARE(int(calculateIntersections(zigzag, straight).size()), 100);
+	}
+}
+
+
+
+void PathObjectTest::calcSelfIntersectionsTest()
+{
+	{
+		// A line crossing itself
+		PathObject path{Map::getCoveringRedLine()};
+		path.addCoordinate(MapCoord(0, 0));
+		path.addCoordinate(MapCoord(20, 0));
+		path.addCoordinate(MapCoord(20, 10));
+		path.addCoordinate(MapCoord(10, 10));
+		path.addCoordinate(MapCoord(10, -10));
+		
+		PathObject::Intersection intersection{};
+		intersection.coord = MapCoordF(10, 0);
+		intersection.length = 10;
+		intersection.other_length = 50;
+		
+		PathObject::Intersections expected;
+		expected.push_back(intersection);
+		
+		PathObject::Intersections actual;
+		path.calcSelfIntersections(actual);
+		actual.normalize();
+		QCOMPARE(actual, expected);
+	}
+	
+	{
+		// A closed path, with a zero-length segment
+		PathObject path{Map::getCoveringRedLine()};
+		path.addCoordinate(MapCoord(0, 0));
+		path.addCoordinate(MapCoord(20, 0));
+		path.addCoordinate(MapCoord(20, 0));
+		path.addCoordinate(MapCoord(20, 20));
+		path.addCoordinate(MapCoord(0, 20));
+		path.closeAllParts();
+		
+		PathObject::Intersections actual;
+		path.calcSelfIntersections(actual);
+		QVERIFY(actual.empty());
+	}
+	
+	{
+		// Collinear overlap
+		PathObject path{Map::getCoveringRedLine()};
+		path.addCoordinate(MapCoord(0, 0));
+		path.addCoordinate(MapCoord(30, 0));
+		path.addCoordinate(MapCoord(30, 10));
+		path.addCoordinate(MapCoord(20, 10));
+		path.addCoordinate(MapCoord(20, 0));
+		path.addCoordinate(MapCoord(10, 0));
+		
+		PathObject::Intersections actual;
+		path.calcSelfIntersections(actual);
+		actual.normalize();
+		QCOMPARE(int(actual.size()), 2);
+		QCOMPARE(actual[0].coord, MapCoordF(10, 0));
+		QCOMPARE(actual[0].other_length, 70.0f);
+		QCOMPARE(actual[1].coord, MapCoordF(20, 0));
+		QCOMPARE(actual[1].other_length, 60.0f);
+	}
+}
+
+
+
+void PathObjectTest::simplifyPolygonalTest()
+{
+	{
+		// A noisy line with a dash point, followed by a curve
+		MapCoordVector coords;
+		for (int i = 0; i <= 100; ++i)
+			coords.emplace_back(i * 0.1, (i % 2) * 0.01);
+		coords[50].setDashPoint(true);
+		coords.back().setCurveStart(true);
+		coords.emplace_back(11.0, 1.0);
+		coords.emplace_back(12.0, 1.0);
+		coords.emplace_back(13.0, 0.0);
+		PathObject path{Map::getCoveringRedLine(), coords};
+		
+		QVERIFY(path.simplifyPolygonal(0.1));
+		auto const& result = path.getRawCoordinateVector();
+		QCOMPARE(int(result.size()), 6);
+		QCOMPARE(result[0], coords[0]);
+		QCOMPARE(result[1], coords[50]);
+		QVERIFY(result[1].isDashPoint());
+		QVERIFY(result[2].isCurveStart());
+		QCOMPARE(result.back(), coords.back());
+		QVERIFY(!path.simplifyPolygonal(0.1));
+	}
+	
+	{
+		// A square with a hole, each side with many nodes
+		auto const addSquare = [](MapCoordVector& coords, double offset, double size) {
+			for (int side = 0; side < 4; ++side)
+			{
+				for (int i = 0; i < 20; ++i)
+				{
+					auto const t = size * i / 20;
+					auto const x = side == 0 ? t : side == 1 ? size : side == 2 ? size - t : 0.0;
+					auto const y = side == 0 ? 0.0 : side == 1 ? t : side == 2 ? size : size - t;
+					coords.emplace_back(offset + x, offset + y);
+				}
+			}
+			coords.emplace_back(offset, offset, MapCoord::ClosePoint | MapCoord::HolePoint);
+		};
+		MapCoordVector coords;
+		addSquare(coords, 0, 10);
+		addSquare(coords, 2, 6);
+		PathObject path{Map::getCoveringRedLine(), coords};
+		
+		QVERIFY(path.simplifyPolygonal(0.1));
+		QCOMPARE(int(path.getRawCoordinateVector().size()), 10);
+		QCOMPARE(int(path.parts().size()), 2);
+		QVERIFY(path.parts()[0].isClosed());
+		QVERIFY(path.parts()[1].isClosed());
+	}
+	
+	{
+		// A thin triangle is not reduced to a line.
+		PathObject path{Map::getCoveringRedLine()};
+		path.addCoordinate(MapCoord(0, 0));
+		path.addCoordinate(MapCoord(10, 0.01));
+		path.addCoordinate(MapCoord(20, 0));
+		path.closeAllParts();
+		QVERIFY(!path.simplifyPolygonal(0.1));
+	}
 }
 
 
@@ -1151,6 +1374,106 @@ void PathObjectTest::atypicalPathTest()
 
 
 
+void PathObjectTest::curveFlatteningTest()
+{
+	// A straight curve with uniform parameterization needs a single segment.
+	{
+		MapCoordVector coords = { {0.0, 0.0}, {10.0, 0.0}, {20.0, 0.0}, {30.0, 0.0} };
+		coords[0].setCurveStart(true);
+		
+		PathCoordVector path_coords { coords };
+		path_coords.update(0);
+		QCOMPARE(path_coords.size(), std::size_t(3));
+		QCOMPARE(path_coords.length(), 30.0f);
+	}
+	
+	// A straight curve with non-uniform parameterization needs more segments.
+	{
+		MapCoordVector coords = { {0.0, 0.0}, {1.0, 0.0}, {2.0, 0.0}, {30.0, 0.0} };
+		coords[0].setCurveStart(true);
+		
+		PathCoordVector path_coords { coords };
+		path_coords.update(0);
+		QVERIFY(path_coords.size() > 3);
+		QCOMPARE(path_coords.length(), 30.0f);
+		
+		auto const split = SplitPathCoord::at(path_coords, PathCoord::length_type(15));
+		QVERIFY(split.pos.distanceTo({15.0, 0.0}) < 0.01);
+	}
+	
+	// A quarter circle of 50 mm radius, as for a contour line.
+	{
+		auto const r = 50.0;
+		auto const k = 0.5522847 * r;
+		MapCoordVector coords = { {r, 0.0}, {r, k}, {k, r}, {0.0, r} };
+		coords[0].setCurveStart(true);
+		
+		PathCoordVector path_coords { coords };
+		path_coords.update(0);
+		QVERIFY(path_coords.size() < 50);
+		QVERIFY(qAbs(path_coords.length() - M_PI * r / 2) < 0.01);
+		
+		auto const split = SplitPathCoord::at(path_coords, path_coords.length() / 2);
+		QVERIFY(split.pos.distanceTo({r * M_SQRT1_2, r * M_SQRT1_2}) < 0.01);
+	}
+}
+
+
+
+void PathObjectTest::pathCoordKernelsTest()
+{
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+	auto random = [&]() { return distribution(generator); };
+	
+	// Odd and even sizes, for the remainders of two-element kernels
+	for (auto size = 3; size < 20; ++size)
+	{
+		for (auto i = 0; i < 100; ++i)
+		{
+			MapCoordVector coords;
+			coords.reserve(size);
+			for (auto j = 0; j < size; ++j)
+				coords.emplace_back(random(), random());
+			
+			PathCoordVector path_coords { coords };
+			path_coords.update(0);
+			QCOMPARE(path_coords.size(), std::size_t(size));
+			
+			auto const extent = path_coords.calculateExtent();
+			auto const expected_extent = referenceExtent(path_coords);
+			QCOMPARE(extent.topLeft(), expected_extent.topLeft());
+			QCOMPARE(extent.bottomRight(), expected_extent.bottomRight());
+			
+			auto const box = QRectF(random(), random(), random() / 5, random() / 5);
+			QCOMPARE(path_coords.intersectsBox(box), referenceIntersectsBox(path_coords, box));
+			
+			auto const point = MapCoordF(random() / 2, random() / 2);
+			QCOMPARE(path_coords.isPointInside(point), referenceIsPointInside(path_coords, point));
+		}
+	}
+	
+	// Many edges, for the edge bands
+	for (auto size : { 65, 200, 2001 })
+	{
+		MapCoordVector coords;
+		coords.reserve(size);
+		for (auto j = 0; j < size; ++j)
+			coords.emplace_back(random(), std::round(random()));  // with horizontal edges
+		
+		PathCoordVector path_coords { coords };
+		path_coords.update(0);
+		QVERIFY(path_coords.hasManyEdges());
+		for (auto i = 0; i < 500; ++i)
+		{
+			auto const point = MapCoordF(random(), (i % 5) ? random() : std::round(random()));
+			QCOMPARE(path_coords.isPointInside(point), referenceIsPointInside(path_coords, point));
+		}
+	}
+}
+
+
+
 void PathObjectTest::recalculatePartsTest_data()
 {
 	static MapCoord coords[] = {
@@ -1207,6 +1530,173 @@ void PathObjectTest::recalculatePartsTest()
 }
 
 
+void PathObjectTest::incrementalUpdateTest()
+{
+	auto curve_start = [](MapCoord c) { c.setCurveStart(true); return c; };
+	auto hole_point = [](MapCoord c) { c.setHolePoint(true); return c; };
+	auto close_point = [](MapCoord c) { c.setClosePoint(true); c.setHolePoint(true); return c; };
+	
+	MapCoordVector coords = {
+	    // An open part with curves
+	    curve_start(MapCoord(0, 0)), MapCoord(10, 20), MapCoord(30, 20), MapCoord(40, 0),
+	    MapCoord(50, 0),
+	    curve_start(MapCoord(60, 10)), MapCoord(70, 30), MapCoord(80, -10), MapCoord(90, 0),
+	    hole_point(MapCoord(100, 0)),
+	    // A closed part
+	    MapCoord(0, 50), MapCoord(50, 50),
+	    curve_start(MapCoord(50, 100)), MapCoord(25, 120), MapCoord(10, 110),
+	    close_point(MapCoord(0, 50)),
+	    // Another open part
+	    MapCoord(0, 200), MapCoord(20, 220), MapCoord(40, 200), MapCoord(60, 220),
+	};
+	PathObject path { nullptr, coords, nullptr };
+	QCOMPARE(path.parts().size(), std::size_t(3));
+	
+	auto verify = [](const PathObject& path) {
+		path.updatePathCoords();
+		PathObject reference { nullptr, path.getRawCoordinateVector(), nullptr };
+		reference.updatePathCoords();
+		
+		auto& parts = path.parts();
+		auto& expected_parts = reference.parts();
+		QCOMPARE(parts.size(), expected_parts.size());
+		for (std::size_t i = 0; i < parts.size(); ++i)
+		{
+			QCOMPARE(parts[i].first_index, expected_parts[i].first_index);
+			QCOMPARE(parts[i].last_index, expected_parts[i].last_index);
+			
+			auto& path_coords = parts[i].path_coords;
+			auto& expected_path_coords = expected_parts[i].path_coords;
+			QCOMPARE(path_coords.size(), expected_path_coords.size());
+			for (std::size_t j = 0; j < path_coords.size(); ++j)
+			{
+				QCOMPARE(path_coords[j].pos, expected_path_coords[j].pos);
+				QCOMPARE(path_coords[j].index, expected_path_coords[j].index);
+				QCOMPARE(path_coords[j].param, expected_path_coords[j].param);
+				QCOMPARE(path_coords[j].clen, expected_path_coords[j].clen);
+			}
+			QCOMPARE(path_coords.calculateArea(), expected_path_coords.calculateArea());
+		}
+	};
+	
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<std::size_t> index_dist(0, coords.size() - 1);
+	std::uniform_real_distribution<double> offset_dist(-5.0, 5.0);
+	for (int i = 0; i < 100; ++i)
+	{
+		auto index = index_dist(gen);
+		auto c = path.getCoordinate(index);
+		c.setX(c.x() + offset_dist(gen));
+		c.setY(c.y() + offset_dist(gen));
+		path.setCoordinate(index, c);
+		if (i % 3 == 0)
+		{
+			// Several changes before the next update
+			index = index_dist(gen);
+			c = path.getCoordinate(index);
+			c.setX(c.x() + offset_dist(gen));
+			path.setCoordinate(index, c);
+		}
+		verify(path);
+		if (QTest::currentTestFailed())
+			return;
+	}
+	
+	// Changing the size of the first part
+	path.addCoordinate(4, MapCoord(45, -5));
+	verify(path);
+	path.deleteCoordinate(4, false);
+	verify(path);
+	
+	// Changing the size of the last part
+	path.addCoordinate(path.getCoordinateCount(), MapCoord(80, 200));
+	verify(path);
+}
+
+
+void PathObjectTest::metricsTest()
+{
+	auto hole_point = [](MapCoord c) { c.setHolePoint(true); return c; };
+	auto close_point = [](MapCoord c) { c.setClosePoint(true); c.setHolePoint(true); return c; };
+	
+	// A 20 mm square with a 10 mm square hole
+	MapCoordVector coords = {
+	    MapCoord(0, 0), MapCoord(20, 0), MapCoord(20, 20), MapCoord(0, 20), close_point(MapCoord(0, 0)),
+	    MapCoord(5, 5), MapCoord(15, 5), MapCoord(15, 15), MapCoord(5, 15), close_point(MapCoord(5, 5)),
+	};
+	PathObject area { nullptr, coords, nullptr };
+	area.updatePathCoords();
+	QCOMPARE(area.getPaperLength(), 80.0);
+	QCOMPARE(area.calculatePaperArea(), 300.0);
+	
+	// The cached area follows coordinate changes.
+	area.setCoordinate(2, MapCoord(30, 30));
+	area.setCoordinate(1, MapCoord(30, 0));
+	area.setCoordinate(3, MapCoord(0, 30));
+	area.updatePathCoords();
+	QCOMPARE(area.calculatePaperArea(), 800.0);
+	
+	// Without explicit update of the path coords
+	std::vector<std::unique_ptr<PathObject>> paths;
+	std::vector<const PathObject*> objects;
+	for (int i = 0; i < 200; ++i)
+	{
+		if (i % 2)
+			paths.push_back(std::make_unique<PathObject>(nullptr, MapCoordVector{ MapCoord(0, 0), hole_point(MapCoord(30, 40)) }, nullptr));
+		else
+			paths.push_back(std::make_unique<PathObject>(nullptr, coords, nullptr));
+		objects.push_back(paths.back().get());
+	}
+	
+	auto const metrics = PathObject::calculateMetrics(objects);
+	QCOMPARE(metrics.size(), objects.size());
+	QCOMPARE(metrics[0].paper_length, 80.0);
+	QCOMPARE(metrics[0].paper_area, 300.0);
+	QCOMPARE(metrics[1].paper_length, 50.0);
+	QCOMPARE(metrics[1].paper_area, 0.0);
+	QCOMPARE(metrics[198].paper_area, 300.0);
+	QCOMPARE(metrics[199].paper_length, 50.0);
+}
+
+
+void PathObjectTest::findClosestPointWithinTest()
+{
+	// A zigzag line with enough edges for the edge index
+	PathObject path { Map::getCoveringRedLine() };
+	for (int i = 0; i < 500; ++i)
+		path.addCoordinate(MapCoord(i, (i % 2) ? 1.0 : 0.0));
+	path.updatePathCoords();
+	QVERIFY(path.parts().front().path_coords.hasManyEdges());
+	
+	auto const bound_sq = 0.25;
+	auto verify = [&path, bound_sq](const MapCoordF& pos) {
+		auto const expected = path.findClosestPointTo(pos);
+		auto const actual = path.findClosestPointWithin(pos, bound_sq);
+		if (expected.distance_squared < bound_sq)
+		{
+			QCOMPARE(actual.distance_squared, expected.distance_squared);
+			QCOMPARE(actual.path_coord.pos, expected.path_coord.pos);
+		}
+		else
+		{
+			QVERIFY(actual.distance_squared >= bound_sq);
+		}
+	};
+	
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<double> x_dist(-2.0, 502.0);
+	std::uniform_real_distribution<double> y_dist(-1.0, 2.0);
+	for (int i = 0; i < 200; ++i)
+		verify({ x_dist(gen), y_dist(gen) });
+	
+	// The index must follow changes of the coordinates.
+	path.setCoordinate(250, MapCoord(250.0, 10.0));
+	verify({ 250.0, 9.8 });
+	QVERIFY(path.findClosestPointWithin({ 250.0, 9.8 }, bound_sq).distance_squared < bound_sq);
+	QVERIFY(path.findClosestPointWithin({ 250.0, 1.2 }, 0.01).distance_squared >= 0.01);
+}
+
+
 
 /*
  * We don't need a real GUI window.
@@ -53,6 +53,9 @@ private slots:
 	void copyFromTest();
 	void copyFromTest_data();
 	
+	/** Tests the sharing of coordinates between copies of PathObject. */
+	void sharedCoordinatesTest();
+	
 	/** Basic test for PathObject::changePathBounds(), focus on flags. */
 	void changePathBoundsBasicTest();
 	void changePathBoundsBasicTest_data();
@@ -72,12 +75,33 @@ private slots:
 	/** Tests finding intersections with calcAllIntersectionsWith(). */
 	void calcIntersectionsTest();
 	
+	/** Tests finding self-intersections with calcSelfIntersections(). */
+	void calcSelfIntersectionsTest();
+	
+	/** Tests the Douglas-Peucker simplification with simplifyPolygonal(). */
+	void simplifyPolygonalTest();
+	
 	/** Tests PathCoord and SplitPathCoord for a non-trivial zero-length path. */
 	void atypicalPathTest();
 	
+	/** Tests the approximation of curves by PathCoordVector. */
+	void curveFlatteningTest();
+	
+	/** Tests the extent, box intersection and point-inside kernels of PathCoordVector. */
+	void pathCoordKernelsTest();
+	
 	/** Tests recalculation of path parts from input coords. */
 	void recalculatePartsTest();
 	void recalculatePartsTest_data();
+	
+	/** Tests the incremental update of path coords after changing coordinates. */
+	void incrementalUpdateTest();
+	
+	/** Tests the length and area of paths, and PathObject::calculateMetrics(). */
+	void metricsTest();
+	
+	/** Tests the bounded search for the closest point, with the edge index. */
+	void findClosestPointWithinTest();
 };
 
 #endif
@@ -0,0 +1,196 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares benchmark results with stored baseline results.
+ *
+ * Usage: performance_check RESULTS BASELINE TOLERANCE
+ *
+ * RESULTS and BASELINE are files in the CSV format written by Qt Test's
+ * "-o <file>,csv" option. TOLERANCE is the accepted deviation from the
+ * baseline, in percent. When BASELINE does not exist, it is created from
+ * RESULTS, and the check passes.
+ *
+ * The program returns a non-zero exit code if any result is worse than its
+ * baseline by more than the tolerance, or if the input cannot be read.
+ */
+
+#include <cstdio>
+#include <map>
+
+#include <QtGlobal>
+#include <QtNumeric>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QIODevice>
+#include <QLatin1String>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+#include <QString>
+#include <QTextStream>
+
+
+namespace
+{
+
+struct Result
+{
+	QString metric;
+	double value;
+};
+
+/// Results indexed by "function: data tag"
+using Results = std::map<QString, Result>;
+
+
+bool readResults(const QString& path, Results& results)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		std::fprintf(stderr, "Cannot read %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+		return false;
+	}
+	
+	// "function","[global tag:]tag","metric",value per iteration,total,iterations
+	static const QRegularExpression line_pattern(QStringLiteral(
+	    R"(^"([^"]*)","([^"]*)","([^"]*)",([^,]+),([^,]+),(\d+)$)"));
+	QTextStream stream(&file);
+	while (!stream.atEnd())
+	{
+		auto const line = stream.readLine().trimmed();
+		auto const match = line_pattern.match(line);
+		if (!match.hasMatch())
+			continue;
+		
+		bool ok = false;
+		auto const value = match.captured(4).toDouble(&ok);
+		if (!ok)
+			continue;
+		
+		QString const key = match.captured(1) + QLatin1String(": ") + match.captured(2);
+		results[key] = { match.captured(3), value };
+	}
+	return true;
+}
+
+
+/**
+ * Returns true for metrics where a higher value means a better result.
+ */
+bool higherIsBetter(const QString& metric)
+{
+	return metric == QLatin1String("BytesPerSecond")
+	       || metric == QLatin1String("BitsPerSecond")
+	       || metric == QLatin1String("FramesPerSecond");
+}
+
+
+/**
+ * Returns the factor by which the result is worse than the baseline.
+ *
+ * A factor less than 1 means that the result is better than the baseline.
+ */
+double slowdown(const Result& result, const Result& baseline)
+{
+	if (higherIsBetter(result.metric))
+		return result.value > 0 ? baseline.value / result.value : qInf();
+	return baseline.value > 0 ? result.value / baseline.value : 1.0;
+}
+
+
+}  // namespace
+
+
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4)
+	{
+		std::fprintf(stderr, "Usage: %s RESULTS BASELINE TOLERANCE\n", argv[0]);
+		return 2;
+	}
+	
+	auto const results_path = QString::fromLocal8Bit(argv[1]);
+	auto const baseline_path = QString::fromLocal8Bit(argv[2]);
+	bool ok = false;
+	auto const tolerance = QString::fromLocal8Bit(argv[3]).toDouble(&ok);
+	if (!ok || tolerance < 0)
+	{
+		std::fprintf(stderr, "Invalid tolerance: %s\n", argv[3]);
+		return 2;
+	}
+	
+	Results results;
+	if (!readResults(results_path, results))
+		return 1;
+	if (results.empty())
+	{
+		std::fprintf(stderr, "No benchmark results in %s\n", qPrintable(results_path));
+		return 1;
+	}
+	
+	if (!QFileInfo::exists(baseline_path))
+	{
+		QDir().mkpath(QFileInfo(baseline_path).absolutePath());
+		if (!QFile::copy(results_path, baseline_path))
+		{
+			std::fprintf(stderr, "Cannot create the baseline %s\n", qPrintable(baseline_path));
+			return 1;
+		}
+		std::printf("Recorded %d results as new baseline %s\n", int(results.size()), qPrintable(baseline_path));
+		return 0;
+	}
+	
+	Results baseline;
+	if (!readResults(baseline_path, baseline))
+		return 1;
+	
+	auto const limit = 1 + tolerance / 100;
+	auto regressions = 0;
+	for (auto const& item : results)
+	{
+		auto const& key = item.first;
+		auto const& result = item.second;
+		auto const reference = baseline.find(key);
+		if (reference == baseline.end() || reference->second.metric != result.metric)
+		{
+			std::printf("NEW         %s: %g %s\n", qPrintable(key), result.value, qPrintable(result.metric));
+			continue;
+		}
+		
+		auto const factor = slowdown(result, reference->second);
+		auto const regression = factor > limit;
+		if (regression)
+			++regressions;
+		std::printf("%s %s: %g %s, baseline %g (%+.0f%%)\n",
+		            regression ? "REGRESSION " : "OK         ",
+		            qPrintable(key), result.value, qPrintable(result.metric),
+		            reference->second.value, (factor - 1) * 100);
+	}
+	
+	if (regressions > 0)
+	{
+		std::printf("%d of %d results are more than %g%% worse than the baseline %s\n",
+		            regressions, int(results.size()), tolerance, qPrintable(baseline_path));
+		return 1;
+	}
+	return 0;
+}
@@ -25,6 +25,7 @@
 #include <QRgb>
 
 #include "core/image_transparency_fixup.h"
+#include "core/overprinting_compositor.h"
 
 using namespace OpenOrienteering;
 
@@ -120,6 +121,43 @@ void QPainterTest::darkenComposition()
 	QCOMPARE(result.pixel(0,0), qRgba(0, 0, 0, 0)); // Now correct!
 }
 
+void QPainterTest::overprintingCompositor()
+{
+	const QImage dest = makeRandomImage(37, 5, 1);
+	const QImage source = makeRandomImage(37, 5, 2);
+	const QImage small_source = makeRandomImage(11, 3, 3);
+	
+	{
+		QImage result = dest;
+		composeSourceOver(result, source);
+		QCOMPARE(result, compose(source, dest, QPainter::CompositionMode_SourceOver));
+		
+		result = dest;
+		composeSourceOver(result, small_source, { 29, 1 });
+		QCOMPARE(result, compose(small_source, dest, QPainter::CompositionMode_SourceOver, { 29, 1 }));
+	}
+	
+	{
+		QImage expected = compose(source, dest, QPainter::CompositionMode_Multiply);
+		ImageTransparencyFixup{&expected}();
+		QImage result = dest;
+		composeMultiply(result, source);
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 9) || (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0) && QT_VERSION < QT_VERSION_CHECK(6, 2, 4))
+		QEXPECT_FAIL("", "CompositionMode_Multiply inaccurately composes alpha.", Continue);
+#endif
+		QCOMPARE(result, expected);
+		
+		expected = compose(small_source, dest, QPainter::CompositionMode_Multiply, { -3, 3 });
+		ImageTransparencyFixup{&expected}();
+		result = dest;
+		composeMultiply(result, small_source, { -3, 3 });
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 9) || (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0) && QT_VERSION < QT_VERSION_CHECK(6, 2, 4))
+		QEXPECT_FAIL("", "CompositionMode_Multiply inaccurately composes alpha.", Continue);
+#endif
+		QCOMPARE(result, expected);
+	}
+}
+
 template <typename ColorT>
 QImage QPainterTest::makeImage(ColorT color) const
 {
@@ -128,15 +166,36 @@ QImage QPainterTest::makeImage(ColorT color) const
 	return image;
 }
 
-QImage QPainterTest::compose(const QImage& source, const QImage& dest, QPainter::CompositionMode mode)
+QImage QPainterTest::compose(const QImage& source, const QImage& dest, QPainter::CompositionMode mode, const QPoint& offset)
 {
 	QImage result = dest;
 	QPainter painter(&result);
 	painter.setCompositionMode(mode);
-	painter.drawImage(0, 0, source);
+	painter.drawImage(offset, source);
 	painter.end();
 	return result;
 }
 
+QImage QPainterTest::makeRandomImage(int width, int height, unsigned int seed) const
+{
+	QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+	auto next = [&seed](int max) {
+		seed = seed * 1103515245u + 12345u;
+		return max ? int((seed >> 8) % unsigned(max + 1)) : 0;
+	};
+	for (int y = 0; y < height; ++y)
+	{
+		auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+		for (int x = 0; x < width; ++x)
+		{
+			// Include fully transparent and fully opaque pixels.
+			auto const choice = next(3);
+			auto const alpha = choice == 0 ? 0 : choice == 1 ? 255 : next(255);
+			line[x] = qRgba(next(alpha), next(alpha), next(alpha), alpha);
+		}
+	}
+	return image;
+}
+
 
 QTEST_GUILESS_MAIN(QPainterTest)
@@ -23,6 +23,7 @@
 #include <QImage>
 #include <QObject>
 #include <QPainter>
+#include <QPoint>
 
 
 /**
@@ -67,6 +68,13 @@ private slots:
 	 */
 	void darkenComposition();
 	
+	/**
+	 * The overprinting compositor shall give the same results as QPainter's
+	 * multiply and source-over composition, including the composition of
+	 * images at an offset.
+	 */
+	void overprintingCompositor();
+	
 protected:
 	/** 
 	 * Creates a single pixel image of the given color.
@@ -77,7 +85,12 @@ protected:
 	/**
 	 * Composes two images with the given mode, and returns the result.
 	 */
-	QImage compose(const QImage& source, const QImage& dest, QPainter::CompositionMode mode);
+	QImage compose(const QImage& source, const QImage& dest, QPainter::CompositionMode mode, const QPoint& offset = {});
+	
+	/**
+	 * Creates an image of random premultiplied pixels.
+	 */
+	QImage makeRandomImage(int width, int height, unsigned int seed) const;
 	
 	/** A single-pixel white image. */
 	const QImage white_img;
@@ -0,0 +1,265 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_benchmark_t.h"
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <Qt>
+#include <QtGlobal>
+#include <QtTest>
+#include <QByteArray>
+#include <QColor>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QLatin1Char>
+#include <QPainter>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
+#include <QString>
+
+#include "global.h"
+#include "synthetic_map.h"
+#include "test_config.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/renderables/renderable.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+static const auto source_maps = {
+    "data:/examples/complete map.omap",
+    "data:/examples/forest sample.omap",
+};
+
+/// The size of the rendered image, in pixels.
+constexpr QSize image_size { 1024, 768 };
+
+
+void addMapRows(std::initializer_list<qreal> scalings = {})
+{
+	QTest::addColumn<QString>("map_filename");
+	QTest::addColumn<int>("num_objects");
+	QTest::addColumn<qreal>("scaling");
+	for (auto raw_path : source_maps)
+	{
+		auto const path = QString::fromUtf8(raw_path);
+		auto const name = QFileInfo(path).completeBaseName().toUtf8();
+		for (auto num_objects : syntheticMapSizes())
+		{
+			QByteArray const row = name + ", " + QByteArray::number(num_objects);
+			if (scalings.size() == 0)
+			{
+				QTest::newRow(row.constData()) << path << num_objects << qreal(0);
+				continue;
+			}
+			for (auto scaling : scalings)
+			{
+				QByteArray const zoom_row = row + ", " + QByteArray::number(scaling) + " px/mm";
+				QTest::newRow(zoom_row.constData()) << path << num_objects << scaling;
+			}
+		}
+	}
+}
+
+/**
+ * Renders the center of the map at the given scaling.
+ */
+template <class Function>
+void renderCenter(const Map& map, qreal scaling, QImage& image, Function draw)
+{
+	auto const center = map.calculateExtent().center();
+	auto const size = QSizeF(image.size()) / scaling;
+	auto const bounding_box = QRectF(center - QPointF(size.width(), size.height()) / 2, size);
+	const RenderConfig config = { map, bounding_box, scaling, RenderConfig::Screen, 1.0 };
+	
+	image.fill(Qt::white);
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.translate(image.width() / 2.0, image.height() / 2.0);
+	painter.scale(scaling, scaling);
+	painter.translate(-center);
+	draw(&painter, config);
+}
+
+
+}  // namespace
+
+
+
+RenderBenchmark::RenderBenchmark(QObject* parent)
+: QObject(parent)
+{
+	// nothing
+}
+
+RenderBenchmark::~RenderBenchmark() = default;
+
+
+void RenderBenchmark::initTestCase()
+{
+	QDir::addSearchPath(QStringLiteral("data"), QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("..")));
+	doStaticInitializations();
+	
+	for (auto raw_path : source_maps)
+	{
+		auto path = QString::fromUtf8(raw_path);
+		QVERIFY(QFileInfo::exists(path));
+	}
+}
+
+
+Map* RenderBenchmark::syntheticMap()
+{
+	QFETCH(QString, map_filename);
+	QFETCH(int, num_objects);
+	
+	QString const key = map_filename + QLatin1Char(':') + QString::number(num_objects);
+	if (map && map_key == key)
+		return map.get();
+	
+	map.reset();
+	map_key.clear();
+	auto synthetic_map = makeSyntheticMap(map_filename, num_objects);
+	if (!synthetic_map)
+		return nullptr;
+	
+	map = std::move(synthetic_map);
+	map_key = key;
+	return map.get();
+}
+
+
+void RenderBenchmark::updateAllObjects_data()
+{
+	addMapRows();
+}
+
+void RenderBenchmark::updateAllObjects()
+{
+	auto* synthetic_map = syntheticMap();
+	QVERIFY(synthetic_map);
+	
+	QBENCHMARK
+	{
+		synthetic_map->updateAllObjects();
+	}
+}
+
+
+void RenderBenchmark::draw_data()
+{
+	// Overview, 100%, and close-up on a typical screen
+	addMapRows({ 0.5, 4, 16 });
+}
+
+void RenderBenchmark::draw()
+{
+	QFETCH(qreal, scaling);
+	auto* synthetic_map = syntheticMap();
+	QVERIFY(synthetic_map);
+	
+	QImage image(image_size, QImage::Format_ARGB32_Premultiplied);
+	QBENCHMARK
+	{
+		renderCenter(*synthetic_map, scaling, image, [synthetic_map](QPainter* painter, const RenderConfig& config) {
+			synthetic_map->draw(painter, config);
+		});
+	}
+}
+
+
+void RenderBenchmark::drawOverprintingSimulation_data()
+{
+	addMapRows({ 4 });
+}
+
+void RenderBenchmark::drawOverprintingSimulation()
+{
+	QFETCH(qreal, scaling);
+	auto* synthetic_map = syntheticMap();
+	QVERIFY(synthetic_map);
+	
+	QImage image(image_size, QImage::Format_ARGB32_Premultiplied);
+	QBENCHMARK
+	{
+		renderCenter(*synthetic_map, scaling, image, [synthetic_map](QPainter* painter, const RenderConfig& config) {
+			synthetic_map->drawOverprintingSimulation(painter, config);
+		});
+	}
+}
+
+
+void RenderBenchmark::findObjectsAt_data()
+{
+	addMapRows();
+}
+
+void RenderBenchmark::findObjectsAt()
+{
+	auto* synthetic_map = syntheticMap();
+	QVERIFY(synthetic_map);
+	
+	// A grid of 10 x 10 positions over the whole map
+	auto const extent = synthetic_map->calculateExtent();
+	std::vector<MapCoordF> positions;
+	positions.reserve(100);
+	for (int y = 0; y < 10; ++y)
+	{
+		for (int x = 0; x < 10; ++x)
+			positions.emplace_back(extent.left() + extent.width() * (x + 0.5) / 10,
+			                       extent.top() + extent.height() * (y + 0.5) / 10);
+	}
+	
+	SelectionInfoVector objects;
+	QBENCHMARK
+	{
+		for (auto const& position : positions)
+		{
+			objects.clear();
+			synthetic_map->findObjectsAt(position, 1.0, false, false, false, false, objects);
+		}
+	}
+}
+
+
+/*
+ * We don't need a real GUI window.
+ * 
+ * But we discovered QTBUG-58768 macOS: Crash when using QPrinter
+ * while running with "minimal" platform plugin.
+ */
+#ifndef Q_OS_MACOS
+namespace  {
+	auto Q_DECL_UNUSED qpa_selected = qputenv("QT_QPA_PLATFORM", "offscreen");  // clazy:exclude=non-pod-global-static
+}
+#endif
+
+
+QTEST_MAIN(RenderBenchmark)
@@ -0,0 +1,77 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_RENDER_BENCHMARK_T_H
+#define OPENORIENTEERING_RENDER_BENCHMARK_T_H
+
+#include <memory>
+
+#include <QObject>
+#include <QString>
+
+namespace OpenOrienteering {
+class Map;
+}
+
+
+/**
+ * @test Benchmarks rendering and hit testing on large synthetic maps.
+ * 
+ * The maps are built from the example maps by replicating their objects,
+ * cf. makeSyntheticMap() and syntheticMapSizes().
+ * 
+ * Machine-readable results are available through the QtTest output
+ * options, e.g. `render_benchmark_t -o results.csv,csv`.
+ */
+class RenderBenchmark : public QObject
+{
+Q_OBJECT
+public:
+	explicit RenderBenchmark(QObject* parent = nullptr);
+	~RenderBenchmark() override;
+	
+private slots:
+	void initTestCase();
+	
+	void updateAllObjects_data();
+	void updateAllObjects();
+	
+	void draw_data();
+	void draw();
+	
+	void drawOverprintingSimulation_data();
+	void drawOverprintingSimulation();
+	
+	void findObjectsAt_data();
+	void findObjectsAt();
+	
+private:
+	/**
+	 * Returns the synthetic map for the current data row.
+	 * 
+	 * The last map is kept for the next benchmark, because building a
+	 * large map takes much longer than most of the benchmarks.
+	 */
+	OpenOrienteering::Map* syntheticMap();
+	
+	std::unique_ptr<OpenOrienteering::Map> map;
+	QString map_key;
+};
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2019-2020 Kai Pastor
+ *    Copyright 2019-2020, 2026 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -19,7 +19,9 @@
 
 #include <QtTest>
 #include <QDir>           // IWYU pragma: keep
+#include <QFile>          // IWYU pragma: keep
 #include <QFileInfo>      // IWYU pragma: keep
+#include <QIODevice>      // IWYU pragma: keep
 #include <QObject>
 #include <QSignalSpy>     // IWYU pragma: keep
 #include <QStandardPaths> // IWYU pragma: keep
@@ -40,6 +42,7 @@ using namespace OpenOrienteering;
 
 #ifdef MAPPER_USE_FAKE_POSITION_PLUGIN
 #include <QGeoCoordinate>           // IWYU pragma: keep
+#include <QGeoPositionInfo>         // IWYU pragma: keep
 #include <QNmeaPositionInfoSource>  // IWYU pragma: keep
 #include "sensors/fake_position_plugin.h"
 #include "sensors/fake_position_source.h"
@@ -101,6 +104,40 @@ private slots:
 		source->stopUpdates();
 		delete source;
 	}
+	
+	void fakePositionSourceReplayTest()
+	{
+		QFile gpx_file(QStringLiteral("testdata:track/track-0.gpx"));
+		QVERIFY(gpx_file.open(QIODevice::ReadOnly));
+		auto track = FakePositionSource::readGpx(gpx_file);
+		QCOMPARE(int(track.size()), 4);
+		QCOMPARE(track[1].coordinate(), QGeoCoordinate(50.1, 7.0, 110));
+		QCOMPARE(track[1].attribute(QGeoPositionInfo::HorizontalAccuracy), 28.0);
+		QVERIFY(track[2].timestamp().isValid());
+		
+		QFile nmea_file(QStringLiteral("testdata:sensors/nmea.txt"));
+		QVERIFY(nmea_file.open(QIODevice::ReadOnly));
+		auto const nmea_track = FakePositionSource::readNmea(nmea_file);
+		QVERIFY(!nmea_track.empty());
+		QCOMPARE(int(nmea_track.front().coordinate().latitude()), -30);
+		QCOMPARE(nmea_track.front().coordinate().type(), QGeoCoordinate::Coordinate3D);
+		
+		FakePositionSource::setReplayTrack(track);
+		FakePositionSource source(this);
+		FakePositionSource::setReplayTrack({});
+		QCOMPARE(source.minimumUpdateInterval(), 20);
+		
+		QSignalSpy source_spy(&source, &QGeoPositionInfoSource::positionUpdated);
+		QVERIFY(source_spy.isValid());
+		for (auto const& expected : track)
+		{
+			source.requestUpdate(0);
+			QCOMPARE(source.lastKnownPosition(true).coordinate(), expected.coordinate());
+		}
+		source.requestUpdate(0);
+		QCOMPARE(source.lastKnownPosition(true).coordinate(), track.front().coordinate());
+		QCOMPARE(source_spy.count(), 5);
+	}
 #endif  // MAPPER_USE_FAKE_POSITION_PLUGIN
 	
 	
@@ -138,6 +175,9 @@ private slots:
 		QVERIFY(last.isValid());
 		QCOMPARE(int(last.coordinate().latitude()), -30);
 		QCOMPARE(int(last.coordinate().longitude()), 139);
+		QVERIFY(qAbs(last.coordinate().latitude() - (-30 - 18.94658 / 60)) < 1e-9);
+		QVERIFY(qAbs(last.coordinate().longitude() - (139 + 20.03591 / 60)) < 1e-9);
+		QVERIFY(last.timestamp().time().isValid());
 		
 		source->stopUpdates();
 		
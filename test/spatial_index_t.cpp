@@ -0,0 +1,125 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QObject>
+#include <QRectF>
+
+#include "util/spatial_index.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+QRectF makeRect(int i)
+{
+	// A deterministic scattering of small and large rectangles
+	auto const x = (i * 7919) % 1000;
+	auto const y = (i * 104729) % 1000;
+	auto const size = (i % 17 == 0) ? 200.0 : double(i % 13);
+	return { qreal(x), qreal(y), size, size / 2 };
+}
+
+bool overlaps(const QRectF& a, const QRectF& b)
+{
+	return a.left() <= b.right() && b.left() <= a.right()
+	       && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+}  // namespace
+
+
+
+/**
+ * @test Tests the spatial index.
+ */
+class SpatialIndexTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	void emptyTest()
+	{
+		SpatialIndex<int> index;
+		QVERIFY(index.empty());
+		QVERIFY(index.values({0, 0, 100, 100}).empty());
+		QVERIFY(!index.remove({0, 0, 1, 1}, 1));
+		QVERIFY(index.bounds().isNull());
+	}
+	
+	void degenerateTest()
+	{
+		SpatialIndex<int> index;
+		index.insert({10, 10, 0, 0}, 1);   // a point
+		index.insert({20, 10, 10, 0}, 2);  // a horizontal line
+		QVERIFY(index.values({5, 5, 10, 10}) == std::vector<int>{1});
+		QVERIFY(index.values({25, 5, 1, 10}) == std::vector<int>{2});
+		QVERIFY(index.values({11, 11, 1, 1}).empty());
+	}
+	
+	void queryTest()
+	{
+		auto const num_values = 5000;
+		SpatialIndex<int> index;
+		for (int i = 0; i < num_values; ++i)
+			index.insert(makeRect(i), i);
+		QCOMPARE(index.size(), std::size_t(num_values));
+		
+		// Remove every third value
+		for (int i = 0; i < num_values; i += 3)
+			QVERIFY(index.remove(makeRect(i), i));
+		QVERIFY(!index.remove(makeRect(0), 0));
+		QVERIFY(!index.remove(makeRect(1).translated(1, 0), 1));
+		
+		for (int q = 0; q < 100; ++q)
+		{
+			auto const query = QRectF((q * 37) % 1000, (q * 53) % 1000, q, 100 - q);
+			auto actual = index.values(query);
+			std::sort(begin(actual), end(actual));
+			auto expected = std::vector<int>();
+			for (int i = 0; i < num_values; ++i)
+			{
+				if (i % 3 != 0 && overlaps(makeRect(i), query))
+					expected.push_back(i);
+			}
+			QVERIFY(actual == expected);
+		}
+		
+		for (int i = 0; i < num_values; ++i)
+		{
+			if (i % 3 != 0)
+				QVERIFY(index.remove(makeRect(i), i));
+		}
+		QVERIFY(index.empty());
+	}
+	
+};
+
+
+
+QTEST_GUILESS_MAIN(SpatialIndexTest)
+#include "spatial_index_t.moc"  // IWYU pragma: keep
@@ -358,6 +358,7 @@ private slots:
 		clone->setName(QStringLiteral("a"));
 		QVERIFY(!clone->equals(&l));
 		QVERIFY(clone->equals(&l, Qt::CaseInsensitive));
+		QCOMPARE(clone->hash(), l.hash());
 		
 		clone->setName(QStringLiteral("A"));
 		QVERIFY(clone->equals(&l));
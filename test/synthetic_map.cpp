@@ -0,0 +1,103 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synthetic_map.h"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+#include <QRectF>
+#include <QString>
+
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+
+
+namespace OpenOrienteering {
+
+std::vector<int> syntheticMapSizes()
+{
+	auto sizes = std::vector<int>{ 10000, 100000 };
+	auto const value = qgetenv("MAPPER_BENCHMARK_SIZES");
+	if (!value.isEmpty())
+	{
+		sizes.clear();
+		for (auto const& item : value.split(','))
+		{
+			auto ok = false;
+			auto const size = item.trimmed().toInt(&ok);
+			if (ok && size > 0)
+				sizes.push_back(size);
+		}
+	}
+	return sizes;
+}
+
+
+std::unique_ptr<Map> makeSyntheticMap(const QString& path, int num_objects)
+{
+	auto map = std::make_unique<Map>();
+	if (!map->loadFrom(path))
+		return {};
+	
+	std::vector<std::pair<int, const Object*>> originals;
+	for (int i = 0; i < map->getNumParts(); ++i)
+	{
+		auto const* part = map->getPart(std::size_t(i));
+		for (int j = 0; j < part->getNumObjects(); ++j)
+			originals.emplace_back(i, part->getObject(j));
+	}
+	if (originals.empty())
+		return {};
+	
+	auto const extent = map->calculateExtent();
+	auto const tile_width = qint32(std::ceil(extent.width())) * 1000 + 1000;
+	auto const tile_height = qint32(std::ceil(extent.height())) * 1000 + 1000;
+	auto const num_tiles = (num_objects + int(originals.size()) - 1) / int(originals.size());
+	auto const tiles_per_row = qMax(1, int(std::ceil(std::sqrt(num_tiles))));
+	
+	auto generator = std::mt19937 { 1 };
+	auto jitter = std::uniform_int_distribution<qint32> { -1000, 1000 };
+	auto count = map->getNumObjects();
+	for (int tile = 1; count < num_objects; ++tile)
+	{
+		auto const dx = (tile % tiles_per_row) * tile_width;
+		auto const dy = (tile / tiles_per_row) * tile_height;
+		for (auto const& original : originals)
+		{
+			if (count >= num_objects)
+				break;
+			auto* copy = original.second->duplicate();
+			copy->move(dx + jitter(generator), dy + jitter(generator));
+			map->addObject(copy, original.first);
+			++count;
+		}
+	}
+	map->updateAllObjects();
+	return map;
+}
+
+
+}  // namespace OpenOrienteering
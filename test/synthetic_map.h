@@ -0,0 +1,56 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_SYNTHETIC_MAP_H
+#define OPENORIENTEERING_SYNTHETIC_MAP_H
+
+#include <memory>
+#include <vector>
+
+class QString;
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * Returns the object counts of the synthetic maps used for benchmarks.
+ * 
+ * The default is 10k and 100k objects. Other sizes, e.g. 1M objects,
+ * can be selected by setting MAPPER_BENCHMARK_SIZES to a comma-separated
+ * list of object counts.
+ */
+std::vector<int> syntheticMapSizes();
+
+/**
+ * Loads the map from the given path, and replicates its objects until the
+ * map has the given number of objects.
+ * 
+ * The copies are placed in a square grid of tiles of the original extent,
+ * and moved randomly by up to 1 mm so that they don't overlap exactly.
+ * The jitter is reproducible. Returns nullptr if the map cannot be loaded
+ * or if it has no objects.
+ */
+std::unique_ptr<Map> makeSyntheticMap(const QString& path, int num_objects);
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -19,31 +19,40 @@
 
 
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iosfwd>
+#include <limits>
 #include <memory>
 #include <vector>
 
 #include <Qt>
 #include <QtGlobal>
+#include <QtEndian>
 #include <QtMath>
 #include <QtTest>
 #include <QBuffer>
 #include <QByteArray>
 #include <QColor>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
 #include <QFileDevice>
 #include <QFileInfo>
+#include <QImage>
 #include <QImageWriter>
 #include <QIODevice>
 #include <QLineF>
 #include <QList>
 #include <QMetaObject>
 #include <QObject>
+#include <QPainter>
 #include <QPointF>
 #include <QRectF>
 #include <QSignalSpy>  // IWYU pragma: keep
+#include <QSize>
+#include <QStandardPaths>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryDir>
@@ -61,6 +70,7 @@
 #include "core/map.h"
 #include "core/map_coord.h"
 #include "core/map_view.h"
+#include "core/objects/object.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
@@ -68,13 +78,19 @@
 #include "gdal/ogr_template.h"
 #include "gdal/gdal_manager.h"
 #include "templates/template.h"
+#include "templates/template_file_lookup.h"
 #include "templates/template_image.h"
+#include "templates/template_map.h"
 #include "templates/template_table_model.h"
+#include "templates/template_tile_service.h"
 #include "templates/template_track.h"
 #include "templates/world_file.h"
+#include "util/disk_cache.h"
 
 #ifdef MAPPER_USE_GDAL
+#  include "gdal/gdal_dem.h"
 #  include "gdal/gdal_file.h"
+#  include "gdal/gdal_image_reader.h"
 #endif
 
 using namespace OpenOrienteering;
@@ -82,6 +98,77 @@ using namespace OpenOrienteering;
 namespace
 {
 
+#ifdef MAPPER_USE_GDAL
+
+bool writeFile(const QString& path, const QByteArray& data)
+{
+	QFile file(path);
+	return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+	       && file.write(data) == data.size();
+}
+
+/**
+ * Returns the 100 bytes header of an empty point Shapefile (.shp, .shx).
+ */
+QByteArray shapefileHeader()
+{
+	QByteArray header(100, 0);
+	auto* data = reinterpret_cast<uchar*>(header.data());
+	qToBigEndian<qint32>(9994, data);       // file code
+	qToBigEndian<qint32>(50, data + 24);    // file length in 16-bit words
+	qToLittleEndian<qint32>(1000, data + 28);  // version
+	qToLittleEndian<qint32>(1, data + 32);  // shape type: point
+	return header;
+}
+
+/**
+ * Returns a dBase file with a single character field and no records.
+ */
+QByteArray emptyDbaseFile()
+{
+	QByteArray dbf(65, 0);
+	auto* data = reinterpret_cast<uchar*>(dbf.data());
+	data[0] = 0x03;  // dBase III
+	data[1] = 126;   // last update: 2026-01-01
+	data[2] = 1;
+	data[3] = 1;
+	qToLittleEndian<quint16>(65, data + 8);  // header size
+	qToLittleEndian<quint16>(9, data + 10);  // record size
+	std::memcpy(data + 32, "NAME", 4);
+	data[32 + 11] = 'C';
+	data[32 + 16] = 8;  // field length
+	data[64] = 0x0d;    // end of header
+	dbf.append(char(0x1a));
+	return dbf;
+}
+
+/**
+ * Provides access to the postprocessing functions of GdalImageReader.
+ */
+struct ImageReaderPostprocessing : public GdalImageReader
+{
+	using GdalImageReader::premultiplyARGB32;
+	using GdalImageReader::premultiplyGray8;
+};
+
+/**
+ * Returns an image with raw (not premultiplied) pixel data, with all colors
+ * and alpha values for a width of at least 256 pixels, and 256 lines.
+ */
+QImage unpremultipliedImage(int width)
+{
+	QImage image(width, 256, QImage::Format_ARGB32_Premultiplied);
+	for (int y = 0; y < image.height(); ++y)
+	{
+		auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+		for (int x = 0; x < width; ++x)
+			line[x] = qRgba(x & 255, (255 - x) & 255, (x * 7 + y) & 255, y);
+	}
+	return image;
+}
+
+#endif
+
 QPointF center(const Template* temp)
 {
 	// TemplateTrack intentionally doesn't provide a tight extent
@@ -108,6 +195,9 @@ private slots:
 		QCoreApplication::setApplicationName(QString::fromLatin1(metaObject()->className()));
 		QVERIFY2(QDir::home().exists(), "The home dir must be writable in order to use QSettings.");
 		
+		// Use distinct cache directories
+		QStandardPaths::setTestModeEnabled(true);
+		
 		Q_INIT_RESOURCE(resources);
 		doStaticInitializations();
 		// Static map initializations
@@ -164,6 +254,80 @@ private slots:
 		resolved_path = GdalFile::tryToFindRelativeTemplateFile("../doc.kml_xy", vsizip + "/files/1.jpg");
 		QVERIFY(resolved_path.isEmpty());
 	}
+	
+	void gdalPremultiplyTest_data()
+	{
+		QTest::addColumn<int>("width");
+		
+		// The odd widths leave pixels for the scalar tail.
+		QTest::newRow("1") << 1;
+		QTest::newRow("3") << 3;
+		QTest::newRow("7") << 7;
+		QTest::newRow("257") << 257;
+	}
+	
+	void gdalPremultiplyTest()
+	{
+		QFETCH(int, width);
+		
+		auto const source = unpremultipliedImage(width);
+		auto argb = source;
+		ImageReaderPostprocessing::premultiplyARGB32(argb);
+		auto gray = source;
+		ImageReaderPostprocessing::premultiplyGray8(gray);
+		
+		for (int y = 0; y < source.height(); ++y)
+		{
+			auto const* source_line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+			auto const* argb_line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+			auto const* gray_line = reinterpret_cast<const QRgb*>(gray.constScanLine(y));
+			for (int x = 0; x < width; ++x)
+			{
+				auto const pixel = source_line[x];
+				if (argb_line[x] != qPremultiply(pixel))
+					QFAIL(qPrintable(QString::fromLatin1("ARGB32 at (%1, %2)").arg(x).arg(y)));
+				// Only the red channel is used for gray.
+				auto const value = qRed(pixel);
+				if (gray_line[x] != qPremultiply(qRgba(value, value, value, qAlpha(pixel))))
+					QFAIL(qPrintable(QString::fromLatin1("Gray8 at (%1, %2)").arg(x).arg(y)));
+			}
+		}
+	}
+	
+	void reliefShadingTest()
+	{
+		// A 3x3 image needs a 5x5 grid.
+		auto const nan = std::numeric_limits<float>::quiet_NaN();
+		std::vector<float> flat(25, 100.0f);
+		QImage image(3, 3, QImage::Format_ARGB32_Premultiplied);
+		
+		shadeRelief(image, flat.data(), 1, 1, ReliefShading::Hillshade);
+		QCOMPARE(image.pixel(1, 1), qRgb(180, 180, 180));  // 255 * cos(45°)
+		shadeRelief(image, flat.data(), 1, 1, ReliefShading::Slope);
+		QCOMPARE(image.pixel(1, 1), qRgb(255, 255, 255));
+		
+		// Rising by one unit per cell towards the east, i.e. 45° slope
+		std::vector<float> plane(25);
+		for (std::size_t i = 0; i < plane.size(); ++i)
+			plane[i] = float(i % 5);
+		shadeRelief(image, plane.data(), 1, 1, ReliefShading::Slope);
+		QCOMPARE(image.pixel(0, 0), image.pixel(2, 2));
+		QVERIFY(qAbs(qGray(image.pixel(1, 1)) - 128) <= 1);
+		
+		// With light from the north-west, facing west is brighter than facing east.
+		shadeRelief(image, plane.data(), 1, 1, ReliefShading::Hillshade);
+		auto const facing_west = qGray(image.pixel(1, 1));
+		for (auto& value : plane)
+			value = -value;
+		shadeRelief(image, plane.data(), 1, 1, ReliefShading::Hillshade);
+		QVERIFY(facing_west > qGray(image.pixel(1, 1)));
+		
+		// Missing values are transparent.
+		flat[12] = nan;
+		shadeRelief(image, flat.data(), 1, 1, ReliefShading::Hillshade);
+		QCOMPARE(qAlpha(image.pixel(1, 1)), 0);
+		QCOMPARE(image.pixel(0, 0), qRgb(180, 180, 180));
+	}
 #endif
 	
 	void worldFilePathTest()
@@ -303,6 +467,38 @@ private slots:
 		QCOMPARE(out_buffer.buffer(), original_data);
 	}
 	
+	
+	void templateFileLookupTest()
+	{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)  // for QTemporaryDir::filePath()
+		QTemporaryDir tmp_dir;
+		QVERIFY(tmp_dir.isValid());
+		QVERIFY(QFile::copy(QStringLiteral("testdata:templates/world-file.png"), tmp_dir.filePath(QStringLiteral("world-file.png"))));
+		auto const map_path = tmp_dir.filePath(QStringLiteral("map.omap"));
+		
+		Map map;
+		auto* temp = new TemplateImage(QStringLiteral("/nowhere/world-file.png"), &map);
+		map.addTemplate(-1, std::unique_ptr<Template>(temp));
+		QCOMPARE(TemplateFileLookup::current(), static_cast<TemplateFileLookup*>(nullptr));
+		{
+			TemplateFileLookup lookup;
+			QCOMPARE(TemplateFileLookup::current(), &lookup);
+			lookup.prefetch(map, map_path);
+			QVERIFY(lookup.isFile(tmp_dir.filePath(QStringLiteral("world-file.png"))));
+			QVERIFY(!lookup.isFile(tmp_dir.filePath(QStringLiteral("missing.png"))));
+			
+			// The listing is not updated during the lookup.
+			QVERIFY(QFile::copy(QStringLiteral("testdata:templates/world-file.png"), tmp_dir.filePath(QStringLiteral("missing.png"))));
+			QVERIFY(!lookup.isFile(tmp_dir.filePath(QStringLiteral("missing.png"))));
+			
+			// The template is found by its filename in the map directory.
+			QCOMPARE(temp->tryToFindTemplateFile(map_path), Template::FoundInMapDir);
+			QCOMPARE(temp->getTemplatePath(), tmp_dir.filePath(QStringLiteral("world-file.png")));
+		}
+		QCOMPARE(TemplateFileLookup::current(), static_cast<TemplateFileLookup*>(nullptr));
+#endif
+	}
+	
 	void templateImageDrawableTest()
 	{
 		QVERIFY(!QImageWriter::supportedImageFormats().isEmpty());
@@ -334,8 +530,17 @@ private slots:
 		
 		auto const box = temp->calculateTemplateBoundingBox();
 		MapCoordF map_coords[] = { MapCoordF(box.topLeft()), MapCoordF(box.bottomRight()) };
+		auto const* image_template = static_cast<TemplateImage*>(temp);
+		auto const original = image_template->getImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
 		temp->drawOntoTemplate(map_coords, 2, QColor(Qt::red), box.width()+box.height(), box, {});
 		QVERIFY(temp->hasUnsavedChanges());
+		auto const modified = image_template->getImage().copy();
+		QVERIFY(modified != original);
+		
+		temp->drawOntoTemplateUndo(false);
+		QCOMPARE(image_template->getImage(), original);
+		temp->drawOntoTemplateUndo(true);
+		QCOMPARE(image_template->getImage(), modified);
 		
 #if !defined(MAPPER_BIG_ENDIAN)
 		auto format = FileFormats.findFormatForFilename(QStringLiteral("some.ocd"), &FileFormat::supportsFileSave);
@@ -517,6 +722,75 @@ private slots:
 		QCOMPARE(qRound(latlon.longitude()), 8);
 	}
 	
+	void ogrTemplateFilterTest_data()
+	{
+		QTest::addColumn<bool>("use_area");
+		QTest::addColumn<QString>("attribute_filter");
+		QTest::addColumn<QStringList>("expected_names");
+		
+		QTest::newRow("unfiltered") << false << QString()                  << QStringList{ QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c") };
+		QTest::newRow("area")       << true  << QString()                  << QStringList{ QStringLiteral("a"), QStringLiteral("b") };
+		QTest::newRow("attribute")  << false << QStringLiteral("kind = 'tree'") << QStringList{ QStringLiteral("a"), QStringLiteral("c") };
+		QTest::newRow("both")       << true  << QStringLiteral("kind = 'tree'") << QStringList{ QStringLiteral("a") };
+	}
+	
+	void ogrTemplateFilterTest()
+	{
+		QFETCH(bool, use_area);
+		QFETCH(QString, attribute_filter);
+		QFETCH(QStringList, expected_names);
+		
+		Map map;
+		auto georef = map.getGeoreferencing();
+		georef.setScaleDenominator(10000);
+		QVERIFY(georef.setProjectedCRS(QStringLiteral("UTM"), QStringLiteral("+proj=utm +zone=32 +datum=WGS84 +units=m +no_defs")));
+		georef.setGeographicRefPoint(LatLon(50.0, 8.0));
+		QCOMPARE(georef.getState(), Georeferencing::Geospatial);
+		map.setGeoreferencing(georef);
+		
+		// Feature "a" is at the reference point, "b" is 70 m east of it,
+		// and "c" is more than 1 km away.
+		OgrTemplate temp(QFileInfo(QStringLiteral("testdata:templates/ogr-filter.geojson")).absoluteFilePath(), &map);
+		QVERIFY(temp.preLoadSetup(nullptr));
+		QVERIFY(temp.isTemplateGeoreferenced());
+		if (use_area)
+			temp.setImportArea({ { -20.0, -20.0 }, { 20.0, -20.0 }, { 20.0, 20.0 }, { -20.0, 20.0 } });
+		temp.setAttributeFilter(attribute_filter);
+		QVERIFY(temp.loadTemplateFile());
+		QCOMPARE(temp.getTemplateState(), Template::Loaded);
+		
+		QStringList names;
+		static_cast<const OgrTemplate&>(temp).templateMap()->applyOnAllObjects([&names](const Object* object) {
+			names.push_back(object->getTag(QStringLiteral("name")));
+		});
+		names.sort();
+		QCOMPARE(names, expected_names);
+	}
+	
+	void ogrTemplateCacheKeyTest()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		
+		// An empty point Shapefile, with a .prj sidecar file
+		auto const shp_path = dir.filePath(QStringLiteral("points.shp"));
+		QVERIFY(writeFile(shp_path, shapefileHeader()));
+		QVERIFY(writeFile(dir.filePath(QStringLiteral("points.shx")), shapefileHeader()));
+		QVERIFY(writeFile(dir.filePath(QStringLiteral("points.dbf")), emptyDbaseFile()));
+		auto const prj_path = dir.filePath(QStringLiteral("points.prj"));
+		QVERIFY(writeFile(prj_path, R"(GEOGCS["WGS 84",DATUM["WGS_1984",SPHEROID["WGS 84",6378137,298.257223563]],PRIMEM["Greenwich",0],UNIT["Degree",0.0174532925199433]])"));
+		
+		OgrTemplate::OgrReadOptions options;
+		options.georef = std::make_shared<Georeferencing>();
+		auto const cache_path = OgrTemplate::cachePath(shp_path, options);
+		QVERIFY(!cache_path.isEmpty());
+		QCOMPARE(OgrTemplate::cachePath(shp_path, options), cache_path);
+		
+		// Changing only the sidecar file must change the cache entry.
+		QVERIFY(writeFile(prj_path, R"(PROJCS["WGS_1984_UTM_Zone_32N",GEOGCS["GCS_WGS_1984",DATUM["D_WGS_1984",SPHEROID["WGS_1984",6378137,298.257223563]],PRIMEM["Greenwich",0],UNIT["Degree",0.017453292519943295]],PROJECTION["Transverse_Mercator"],PARAMETER["False_Easting",500000],PARAMETER["False_Northing",0],PARAMETER["Central_Meridian",9],PARAMETER["Scale_Factor",0.9996],PARAMETER["Latitude_Of_Origin",0],UNIT["Meter",1]])"));
+		QVERIFY(OgrTemplate::cachePath(shp_path, options) != cache_path);
+	}
+	
 	void templateTypesConsistentTest_data()
 	{
 		QTest::addColumn<QString>("map_file");
@@ -713,6 +987,135 @@ private slots:
 		QVERIFY(messages.back().isEmpty());
 	}
 	
+	void asyncReaderTest_data()
+	{
+		QTest::addColumn<QString>("source");
+		QTest::addColumn<int>("template_index");
+		
+		// Each of these template types reads the file on a worker thread.
+		QTest::newRow("TemplateImage") << QStringLiteral("testdata:templates/world-file.xmap")     << 0;
+		QTest::newRow("TemplateTrack") << QStringLiteral("testdata:templates/template-track.xmap") << 0;
+		QTest::newRow("TemplateMap")   << QStringLiteral("testdata:text-object.omap")             << -1;
+	}
+	
+	void asyncReaderTest()
+	{
+		QFETCH(QString, source);
+		QFETCH(int, template_index);
+		
+		Map expected_map;
+		MapView expected_view{ &expected_map };
+		auto* expected = addAsyncTestTemplate(expected_map, expected_view, source, template_index);
+		QVERIFY(expected);
+		QVERIFY(expected->loadTemplateFile());
+		
+		Map map;
+		MapView view{ &map };
+		auto* temp = addAsyncTestTemplate(map, view, source, template_index);
+		QVERIFY(temp);
+		QCOMPARE(temp->getTemplateState(), Template::Unloaded);
+		
+		int finished = 0;
+		temp->loadTemplateFileAsync([&finished]() { ++finished; });
+		QVERIFY(temp->isLoadingAsync());
+		QCOMPARE(temp->getTemplateState(), Template::Unloaded);
+		QTRY_COMPARE(finished, 1);
+		QCOMPARE(temp->getTemplateState(), Template::Loaded);
+		QVERIFY(!temp->isLoadingAsync());
+		compareTemplateContents(temp, expected);
+	}
+	
+	void asyncReaderUnloadTest_data()
+	{
+		asyncReaderTest_data();
+	}
+	
+	void asyncReaderUnloadTest()
+	{
+		QFETCH(QString, source);
+		QFETCH(int, template_index);
+		
+		Map map;
+		MapView view{ &map };
+		auto* temp = addAsyncTestTemplate(map, view, source, template_index);
+		QVERIFY(temp);
+		
+		// Loading synchronously takes the worker's data.
+		int finished = 0;
+		temp->loadTemplateFileAsync([&finished]() { ++finished; });
+		QVERIFY(temp->loadTemplateFile());
+		QCOMPARE(temp->getTemplateState(), Template::Loaded);
+		QVERIFY(!temp->releaseTemplateData());
+		
+		// Unloading before the queued completion leads to loading again,
+		// as requested by the asynchronous call.
+		temp->unloadTemplateFile();
+		QCOMPARE(temp->getTemplateState(), Template::Unloaded);
+		QTRY_COMPARE(finished, 1);
+		QCOMPARE(temp->getTemplateState(), Template::Loaded);
+		QVERIFY(!temp->isLoadingAsync());
+		
+		Map expected_map;
+		MapView expected_view{ &expected_map };
+		auto* expected = addAsyncTestTemplate(expected_map, expected_view, source, template_index);
+		QVERIFY(expected);
+		QVERIFY(expected->loadTemplateFile());
+		compareTemplateContents(temp, expected);
+	}
+	
+	void asyncReaderCloseTest_data()
+	{
+		asyncReaderTest_data();
+	}
+	
+	void asyncReaderCloseTest()
+	{
+		QFETCH(QString, source);
+		QFETCH(int, template_index);
+		
+		Map map;
+		MapView view{ &map };
+		auto* temp = addAsyncTestTemplate(map, view, source, template_index);
+		QVERIFY(temp);
+		auto const num_templates = map.getNumTemplates();
+		
+		// A closed template finishes loading.
+		int finished = 0;
+		temp->loadTemplateFileAsync([&finished]() { ++finished; });
+		map.closeTemplate(map.findTemplateIndex(temp));
+		QCOMPARE(map.getNumTemplates(), num_templates - 1);
+		QCOMPARE(map.getNumClosedTemplates(), 1);
+		QTRY_COMPARE(finished, 1);
+		QCOMPARE(map.getClosedTemplate(0), temp);
+		QCOMPARE(temp->getTemplateState(), Template::Loaded);
+		
+	}
+	
+	void asyncReaderDeleteTest_data()
+	{
+		asyncReaderTest_data();
+	}
+	
+	void asyncReaderDeleteTest()
+	{
+		QFETCH(QString, source);
+		QFETCH(int, template_index);
+		
+		Map map;
+		MapView view{ &map };
+		auto* temp = addAsyncTestTemplate(map, view, source, template_index);
+		QVERIFY(temp);
+		auto const num_templates = map.getNumTemplates();
+		
+		// A deleted template waits for its worker, and drops the completion.
+		int finished = 0;
+		temp->loadTemplateFileAsync([&finished]() { ++finished; });
+		map.deleteTemplate(map.findTemplateIndex(temp));
+		QCOMPARE(map.getNumTemplates(), num_templates - 1);
+		QTest::qWait(50);
+		QCOMPARE(finished, 0);
+	}
+	
 	void templateTableModelTest()
 	{
 		Map map;
@@ -746,6 +1149,217 @@ private slots:
 		QCOMPARE(model.insertionRowFromPos(1, false), 0);
 	}
 	
+	void tileServiceUrlTest()
+	{
+		QVERIFY(TemplateTileService::canRead(QStringLiteral("https://tile.example.org/{z}/{x}/{y}.png")));
+		QVERIFY(TemplateTileService::canRead(QStringLiteral("http://tile.example.org/wmts?TileMatrix={TileMatrix}")));
+		QVERIFY(!TemplateTileService::canRead(QStringLiteral("file:///tiles/{z}/{x}/{y}.png")));
+		QVERIFY(!TemplateTileService::canRead(QStringLiteral("https://tile.example.org/tile.png")));
+		
+		Map map;
+		TemplateTileService xyz(QStringLiteral("https://tile.example.org/{z}/{x}/{y}.png"), &map);
+		QCOMPARE(xyz.tileUrl(3, 5, 2), QStringLiteral("https://tile.example.org/3/5/2.png"));
+		QCOMPARE(xyz.getTemplateFilename(), QStringLiteral("tile.example.org"));
+		
+		TemplateTileService tms(QStringLiteral("https://tile.example.org/{z}/{x}/{-y}.png"), &map);
+		QCOMPARE(tms.tileUrl(3, 5, 2), QStringLiteral("https://tile.example.org/3/5/5.png"));
+		QCOMPARE(tms.tileUrl(0, 0, 0), QStringLiteral("https://tile.example.org/0/0/0.png"));
+		
+		TemplateTileService wmts(QStringLiteral("https://tile.example.org/wmts?TileMatrix={TileMatrix}&TileCol={TileCol}&TileRow={TileRow}"), &map);
+		QCOMPARE(wmts.tileUrl(12, 2140, 1389), QStringLiteral("https://tile.example.org/wmts?TileMatrix=12&TileCol=2140&TileRow=1389"));
+	}
+	
+	void tileServiceViewportTest_data()
+	{
+		QTest::addColumn<double>("pixel_per_mm");
+		QTest::addColumn<double>("clip_size");
+		QTest::addColumn<int>("expected_zoom");
+		
+		// At 50° N and 1:10000, zoom level 14 is the first level providing
+		// at least one tile pixel per device pixel at 1 px/mm.
+		QTest::newRow("1 px/mm")   << 1.0 << 100.0  << 14;
+		QTest::newRow("4 px/mm")   << 4.0 << 100.0  << 16;
+		QTest::newRow("max tiles") << 4.0 << 1000.0 << 14;
+	}
+	
+	void tileServiceViewportTest()
+	{
+		QFETCH(double, pixel_per_mm);
+		QFETCH(double, clip_size);
+		QFETCH(int, expected_zoom);
+		
+		Map map;
+		setupTileServiceGeoreferencing(map);
+		TemplateTileService temp(QStringLiteral("https://tile.example.org/{z}/{x}/{y}.png"), &map);
+		QVERIFY(temp.loadTemplateFile());
+		
+		// Off-screen drawing reads only from the disk cache, without network.
+		QImage image(qCeil(clip_size * pixel_per_mm), qCeil(clip_size * pixel_per_mm), QImage::Format_ARGB32_Premultiplied);
+		QPainter painter(&image);
+		painter.scale(pixel_per_mm, pixel_per_mm);
+		painter.translate(clip_size / 2, clip_size / 2);
+		auto const clip_rect = QRectF(-clip_size / 2, -clip_size / 2, clip_size, clip_size);
+		temp.drawTemplate(&painter, clip_rect, pixel_per_mm, false, 1.0);
+		painter.end();
+		
+		QVERIFY(!temp.tiles.isEmpty());
+		QVERIFY(temp.tiles.size() <= 64);
+		for (auto tile = temp.tiles.begin(); tile != temp.tiles.end(); ++tile)
+		{
+			QCOMPARE(int(tile.key() >> 56), expected_zoom);
+			QVERIFY(!tile->pending);
+			QVERIFY(!tile->loaded);
+		}
+		
+		// The tile at the georeferencing reference point
+		int column, row;
+		webMercatorTile(LatLon(50.0, 8.0), expected_zoom, column, row);
+		QVERIFY(temp.tiles.contains(TemplateTileService::keyOf(expected_zoom, column, row)));
+	}
+	
+	void tileServiceDiskCacheTest()
+	{
+		Map map;
+		setupTileServiceGeoreferencing(map);
+		auto const url = QStringLiteral("https://tile.example.org/{z}/{x}/{y}.png");
+		TemplateTileService temp(url, &map);
+		QVERIFY(temp.loadTemplateFile());
+		
+		auto const hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5).toHex();
+		QCOMPARE(temp.cache_dir, DiskCache::entryPath(DiskCache::ServiceTiles, hash));
+		QCOMPARE(temp.cachePath(14, 8556, 5556), temp.cache_dir + QStringLiteral("/14/8556/5556"));
+		
+		TemplateTileService other(QStringLiteral("https://other.example.org/{z}/{x}/{y}.png"), &map);
+		QVERIFY(other.loadTemplateFile());
+		QVERIFY(other.cache_dir != temp.cache_dir);
+		
+		// A tile in the disk cache is used without network access.
+		int column, row;
+		webMercatorTile(LatLon(50.0, 8.0), 14, column, row);
+		QImage tile_image(256, 256, QImage::Format_ARGB32);
+		tile_image.fill(Qt::red);
+		QVERIFY(QDir().mkpath(QFileInfo(temp.cachePath(14, column, row)).absolutePath()));
+		QVERIFY(tile_image.save(temp.cachePath(14, column, row), "PNG"));
+		
+		QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::white);
+		QPainter painter(&image);
+		painter.translate(50, 50);
+		temp.drawTemplate(&painter, QRectF(-50, -50, 100, 100), 1.0, false, 1.0);
+		painter.end();
+		
+		auto const tile = temp.tiles.constFind(TemplateTileService::keyOf(14, column, row));
+		QVERIFY(tile != temp.tiles.constEnd());
+		QVERIFY(tile->loaded);
+		QCOMPARE(tile->image.size(), QSize(256, 256));
+		QCOMPARE(image.pixel(50, 50), qRgb(255, 0, 0));
+		
+		QVERIFY(QDir(temp.cache_dir).removeRecursively());
+	}
+	
+	void tileServiceEvictionTest()
+	{
+		Map map;
+		TemplateTileService temp(QStringLiteral("https://tile.example.org/{z}/{x}/{y}.png"), &map);
+		
+		constexpr int num_tiles = 1000;
+		temp.use_counter = 2 * num_tiles;
+		for (int i = 0; i < num_tiles; ++i)
+			temp.tiles[TemplateTileService::keyOf(10, i, 0)].last_used = quint64(i);
+		auto const pending = TemplateTileService::keyOf(11, 0, 0);
+		temp.tiles[pending].pending = true;
+		auto const current = TemplateTileService::keyOf(12, 0, 0);
+		temp.tiles[current].last_used = temp.use_counter;
+		
+		temp.trim();
+		QVERIFY(temp.tiles.size() < num_tiles);
+		QVERIFY(temp.tiles.contains(pending));
+		QVERIFY(temp.tiles.contains(current));
+		
+		// Only the most recently used tiles are kept.
+		auto const kept = temp.tiles.size() - 2;
+		for (int i = 0; i < num_tiles; ++i)
+			QCOMPARE(temp.tiles.contains(TemplateTileService::keyOf(10, i, 0)), i >= num_tiles - kept);
+		
+		// No eviction when within the limit
+		temp.trim();
+		QCOMPARE(temp.tiles.size(), kept + 2);
+	}
+	
+private:
+	static void setupTileServiceGeoreferencing(Map& map)
+	{
+		auto georef = map.getGeoreferencing();
+		georef.setScaleDenominator(10000);
+		QVERIFY(georef.setProjectedCRS(QStringLiteral("UTM"), QStringLiteral("+proj=utm +zone=32 +datum=WGS84 +units=m +no_defs")));
+		georef.setGeographicRefPoint(LatLon(50.0, 8.0));
+		QCOMPARE(georef.getState(), Georeferencing::Geospatial);
+		map.setGeoreferencing(georef);
+	}
+	
+	/**
+	 * Returns an unloaded template from the given source.
+	 * 
+	 * For a map file with templates, the map is loaded, and the template with
+	 * the given index is returned. Otherwise a new template for the source
+	 * file is added to the map.
+	 */
+	static Template* addAsyncTestTemplate(Map& map, MapView& view, const QString& source, int template_index)
+	{
+#ifdef MAPPER_USE_GDAL
+		// GPX files are for TemplateTrack, not for OgrTemplate.
+		GdalManager().setFormatEnabled(GdalManager::GPX, false);
+#endif
+		if (template_index >= 0)
+		{
+			if (!map.loadFrom(source, &view) || template_index >= map.getNumTemplates())
+				return nullptr;
+			return map.getTemplate(template_index);
+		}
+		
+		auto temp = Template::templateForPath(QFileInfo(source).absoluteFilePath(), &map);
+		if (!temp)
+			return nullptr;
+		temp->setTemplateState(Template::Unloaded);
+		map.addTemplate(map.getNumTemplates(), std::move(temp));
+		return map.getTemplate(map.getNumTemplates() - 1);
+	}
+	
+	static void compareTemplateContents(Template* actual, Template* expected)
+	{
+		QCOMPARE(actual->getTemplateType(), expected->getTemplateType());
+		if (auto* image = qobject_cast<TemplateImage*>(actual))
+		{
+			QVERIFY(!image->getImage().isNull());
+			QCOMPARE(image->getImage(), static_cast<TemplateImage*>(expected)->getImage());
+		}
+		else if (auto* track = qobject_cast<TemplateTrack*>(actual))
+		{
+			QVERIFY(track->getTrack().getNumSegments() > 0);
+			QCOMPARE(track->getTrack().getNumSegments(), static_cast<TemplateTrack*>(expected)->getTrack().getNumSegments());
+			QCOMPARE(track->getTrack().getNumWaypoints(), static_cast<TemplateTrack*>(expected)->getTrack().getNumWaypoints());
+		}
+		else if (auto const* template_map = qobject_cast<const TemplateMap*>(actual))
+		{
+			auto const* expected_map = static_cast<const TemplateMap*>(expected)->templateMap();
+			QVERIFY(template_map->templateMap());
+			QVERIFY(template_map->templateMap()->getNumObjects() > 0);
+			QCOMPARE(template_map->templateMap()->getNumObjects(), expected_map->getNumObjects());
+			QCOMPARE(template_map->templateMap()->getNumSymbols(), expected_map->getNumSymbols());
+		}
+		else
+		{
+			QFAIL("Unexpected template type");
+		}
+	}
+	
+	static void webMercatorTile(const LatLon& latlon, int zoom, int& column, int& row)
+	{
+		auto const n = std::ldexp(1.0, zoom);
+		column = int(std::floor((latlon.longitude() + 180.0) / 360.0 * n));
+		row = int(std::floor((1.0 - std::asinh(std::tan(qDegreesToRadians(latlon.latitude()))) / M_PI) / 2.0 * n));
+	}
+	
 };
 
 
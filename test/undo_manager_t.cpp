@@ -19,13 +19,30 @@
 
 #include "undo_manager_t.h"
 
+#include <memory>
+
 #include <QtTest>
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
+#include "core/symbols/symbol.h"
+#include "undo/lazy_undo_step.h"
+#include "undo/object_undo.h"
 #include "undo/undo.h"
+#include "undo/undo_journal.h"
 #include "undo/undo_manager.h"
 
-namespace OpenOrienteering { class Map; }
-
 using namespace OpenOrienteering;
 
 
@@ -215,6 +232,294 @@ void UndoManagerTest::resetAllChanged()
 	can_redo_changed = false;
 }
 
+// test
+void UndoManagerTest::testJournal()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const path = dir.path() + QLatin1String("/journal.omap");
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		QVERIFY(file.write("<map/>") > 0);
+	}
+	
+	auto const setup = [](Map& map) {
+		auto* symbol = new PointSymbol();
+		map.addSymbol(symbol, 0);
+		auto* object = new PointObject(symbol);
+		object->setPosition(MapCoord(1.0, 1.0));
+		map.addObject(object);
+		map.setHasUnsavedChanges(false);
+	};
+	
+	Map map;
+	setup(map);
+	UndoJournal journal(&map);
+	QVERIFY(journal.start(path));
+	QVERIFY(journal.isRecording());
+	QVERIFY(!UndoJournal::hasChanges(path));
+	map.undoManager().setJournal(&journal);
+	
+	// Add an object
+	auto* added = new PointObject(map.getSymbol(0));
+	added->setPosition(MapCoord(2.0, 2.0));
+	auto* add_step = new DeleteObjectsUndoStep(&map);
+	add_step->addObject(map.addObject(added));
+	map.push(add_step);
+	
+	// Modify an object
+	auto* part = map.getCurrentPart();
+	auto* replace_step = new ReplaceObjectsUndoStep(&map);
+	replace_step->addObject(0, part->getObject(0)->duplicate());
+	static_cast<PointObject*>(part->getObject(0))->setPosition(MapCoord(3.0, 3.0));
+	map.push(replace_step);
+	
+	// Undo and redo the modification
+	QVERIFY(map.undoManager().undo());
+	QVERIFY(map.undoManager().redo());
+	QVERIFY(journal.isRecording());
+	QVERIFY(UndoJournal::hasChanges(path));
+	
+	Map recovered;
+	setup(recovered);
+	UndoJournal recovered_journal(&recovered);
+	QCOMPARE(recovered_journal.resume(path), 4);
+	QVERIFY(recovered_journal.isRecording());
+	QCOMPARE(recovered.getNumObjects(), map.getNumObjects());
+	for (int i = 0; i < map.getNumObjects(); ++i)
+		QVERIFY(recovered.getCurrentPart()->getObject(i)->equals(part->getObject(i), false));
+	
+	// Symbol changes are not recorded.
+	map.setSymbolsDirty();
+	auto* delete_step = new AddObjectsUndoStep(&map);
+	delete_step->addObject(1, part->getObject(1));
+	part->releaseObject(1);
+	map.push(delete_step);
+	QVERIFY(!journal.isRecording());
+	
+	map.undoManager().setJournal(nullptr);
+	journal.discard();
+	QVERIFY(!QFile::exists(UndoJournal::journalPath(path)));
+}
+
+
+
+// test
+void UndoManagerTest::testLazyLoading()
+{
+	Map map;
+	auto* symbol = new PointSymbol();
+	map.addSymbol(symbol, 0);
+	auto* object = new PointObject(symbol);
+	object->setPosition(MapCoord(1.0, 1.0));
+	map.addObject(object);
+	
+	QByteArray data;
+	{
+		auto replace_step = std::make_unique<ReplaceObjectsUndoStep>(&map);
+		replace_step->addObject(0, object->duplicate());
+		QXmlStreamWriter xml(&data);
+		replace_step->save(xml);
+	}
+	object->setPosition(MapCoord(2.0, 2.0));
+	
+	SymbolDictionary symbol_dict;
+	symbol_dict[0] = symbol;
+	auto const context = std::make_shared<LazyUndoContext>(&map, symbol_dict);
+	auto const load = [&map, &data, &context]() {
+		QXmlStreamReader xml(data);
+		xml.readNextStartElement();
+		return std::unique_ptr<UndoStep>(LazyUndoStep::load(xml, &map, context));
+	};
+	
+	auto step = load();
+	auto* lazy_step = dynamic_cast<LazyUndoStep*>(step.get());
+	QVERIFY(lazy_step);
+	QVERIFY(!lazy_step->isMaterialized());
+	QVERIFY(lazy_step->isValid());
+	QCOMPARE(lazy_step->getType(), UndoStep::ReplaceObjectsUndoStepType);
+	
+	// Saving does not need to deserialize the step.
+	QByteArray saved;
+	{
+		QXmlStreamWriter xml(&saved);
+		lazy_step->save(xml);
+	}
+	QVERIFY(!lazy_step->isMaterialized());
+	QVERIFY(saved.contains("<object"));
+	
+	// Undoing deserializes the step.
+	std::unique_ptr<UndoStep> redo_step(lazy_step->undo());
+	QVERIFY(lazy_step->isMaterialized());
+	QVERIFY(redo_step);
+	auto* restored = map.getCurrentPart()->getObject(0)->asPoint();
+	QCOMPARE(restored->getCoord(), MapCoord(1.0, 1.0));
+	QVERIFY(restored->getSymbol() == symbol);
+	
+	// Deleting a referenced symbol invalidates the stored step.
+	auto other_step = load();
+	QVERIFY(other_step->isValid());
+	map.deleteSymbol(0);
+	QVERIFY(!other_step->isValid());
+}
+
+
+// test
+void UndoManagerTest::testCoordsUndoStep()
+{
+	Map map;
+	auto* symbol = new LineSymbol();
+	map.addSymbol(symbol, 0);
+	auto* object = new PathObject(symbol);
+	for (int i = 0; i < 100; ++i)
+		object->addCoordinate(MapCoord(i, i % 2));
+	map.addObject(object);
+	std::unique_ptr<PathObject> original(object->duplicate());
+	
+	// Change the positions of two coordinates
+	std::unique_ptr<PathObject> old_object(object->duplicate());
+	object->setCoordinate(10, MapCoord(10.0, 5.0));
+	object->setCoordinate(80, MapCoord(80.0, 5.0));
+	QVERIFY(ObjectCoordsUndoStep::isApplicable(*old_object, *object));
+	std::unique_ptr<UndoStep> step(new ObjectCoordsUndoStep(&map));
+	static_cast<ObjectCoordsUndoStep*>(step.get())->addObject(0, *old_object);
+	std::unique_ptr<PathObject> moved(object->duplicate());
+	
+	// Save and load
+	QByteArray data;
+	{
+		QXmlStreamWriter xml(&data);
+		step->save(xml);
+	}
+	QVERIFY(!data.contains("<object "));
+	{
+		SymbolDictionary symbol_dict;
+		symbol_dict[0] = symbol;
+		QXmlStreamReader xml(data);
+		xml.readNextStartElement();
+		step.reset(UndoStep::load(xml, &map, symbol_dict));
+	}
+	QCOMPARE(step->getType(), UndoStep::ObjectCoordsUndoStepType);
+	
+	// Undo and redo
+	std::unique_ptr<UndoStep> redo_step(step->undo());
+	QVERIFY(object->equals(original.get(), true));
+	std::unique_ptr<UndoStep> undo_step(redo_step->undo());
+	QVERIFY(object->equals(moved.get(), true));
+	
+	// Insert a coordinate
+	old_object.reset(object->duplicate());
+	object->addCoordinate(50, MapCoord(50.0, 5.0));
+	QCOMPARE(object->getCoordinateCount(), MapCoordVector::size_type(101));
+	step.reset(new ObjectCoordsUndoStep(&map));
+	static_cast<ObjectCoordsUndoStep*>(step.get())->addObject(0, *old_object);
+	redo_step.reset(step->undo());
+	QVERIFY(object->equals(old_object.get(), true));
+	undo_step.reset(redo_step->undo());
+	QCOMPARE(object->getCoordinateCount(), MapCoordVector::size_type(101));
+	QCOMPARE(object->getCoordinate(50), MapCoord(50.0, 5.0));
+	
+	// Other changes need a ReplaceObjectsUndoStep.
+	old_object.reset(object->duplicate());
+	object->setPatternOrigin(MapCoord(1.0, 1.0));
+	QVERIFY(!ObjectCoordsUndoStep::isApplicable(*old_object, *object));
+}
+
+
+// test
+void UndoManagerTest::testMemoryBudget()
+{
+	Map* const map = nullptr;
+	UndoManager undo_manager(map);
+	QCOMPARE(undo_manager.memoryBudget(), std::size_t(0));
+	QCOMPARE(undo_manager.memoryUsage(), std::size_t(0));
+	
+	auto const footprint = NoOpUndoStep(map, true).memoryFootprint();
+	QVERIFY(footprint > 0);
+	
+	for (int i = 0; i < 5; ++i)
+		undo_manager.push(std::unique_ptr<UndoStep>(new NoOpUndoStep(map, true)));
+	QCOMPARE(undo_manager.undoStepCount(), 5);
+	QCOMPARE(undo_manager.memoryUsage(), 5 * footprint);
+	
+	// Setting the budget removes the oldest steps.
+	undo_manager.setMemoryBudget(3 * footprint);
+	QCOMPARE(undo_manager.undoStepCount(), 3);
+	QCOMPARE(undo_manager.memoryUsage(), 3 * footprint);
+	
+	// Redo steps are counted, too.
+	QVERIFY(undo_manager.undo());
+	QCOMPARE(undo_manager.undoStepCount(), 2);
+	QCOMPARE(undo_manager.redoStepCount(), 1);
+	QCOMPARE(undo_manager.memoryUsage(), 3 * footprint);
+	QVERIFY(undo_manager.redo());
+	
+	undo_manager.push(std::unique_ptr<UndoStep>(new NoOpUndoStep(map, true)));
+	QCOMPARE(undo_manager.undoStepCount(), 3);
+	QCOMPARE(undo_manager.memoryUsage(), 3 * footprint);
+	
+	// The latest step is kept even when it exceeds the budget.
+	undo_manager.setMemoryBudget(footprint / 2);
+	QCOMPARE(undo_manager.undoStepCount(), 1);
+	QVERIFY(undo_manager.canUndo());
+	QCOMPARE(undo_manager.memoryUsage(), footprint);
+	
+	// Without budget, only the step count is limited.
+	undo_manager.setMemoryBudget(0);
+	for (int i = 0; i < 5; ++i)
+		undo_manager.push(std::unique_ptr<UndoStep>(new NoOpUndoStep(map, true)));
+	QCOMPARE(undo_manager.undoStepCount(), 6);
+	
+	undo_manager.clear();
+	QCOMPARE(undo_manager.memoryUsage(), std::size_t(0));
+}
+
+
+
+// test
+void UndoManagerTest::testSetIndex()
+{
+	Map map;
+	auto* symbol = new PointSymbol();
+	map.addSymbol(symbol, 0);
+	auto* object = new PointObject(symbol);
+	object->setPosition(MapCoord(0.0, 0.0));
+	map.addObject(object);
+	auto& undo_manager = map.undoManager();
+	
+	// Move the object in three steps
+	auto* part = map.getCurrentPart();
+	for (int i = 1; i <= 3; ++i)
+	{
+		auto* step = new ReplaceObjectsUndoStep(&map);
+		step->addObject(0, part->getObject(0)->duplicate());
+		static_cast<PointObject*>(part->getObject(0))->setPosition(MapCoord(i, i));
+		part->getObject(0)->update();
+		map.push(step);
+	}
+	QCOMPARE(undo_manager.index(), 3);
+	
+	QVERIFY(undo_manager.setIndex(0));
+	QCOMPARE(undo_manager.index(), 0);
+	QVERIFY(!undo_manager.canUndo());
+	QCOMPARE(undo_manager.redoStepCount(), 3);
+	QCOMPARE(static_cast<PointObject*>(part->getObject(0))->getCoord(), MapCoord(0.0, 0.0));
+	QVERIFY(part->getObject(0)->getExtent().isValid());
+	QCOMPARE(map.getNumSelectedObjects(), 1);
+	QVERIFY(map.isObjectSelected(part->getObject(0)));
+	
+	QVERIFY(undo_manager.setIndex(2));
+	QCOMPARE(undo_manager.index(), 2);
+	QCOMPARE(static_cast<PointObject*>(part->getObject(0))->getCoord(), MapCoord(2.0, 2.0));
+	QVERIFY(part->getObject(0)->getExtent().isValid());
+	
+	QVERIFY(undo_manager.setIndex(2));
+	QCOMPARE(undo_manager.index(), 2);
+}
+
+
+
 // slot
 void UndoManagerTest::loadedChanged(bool loaded)
 {
@@ -244,4 +549,4 @@ void UndoManagerTest::canRedoChanged(bool can_redo)
 }
 
 
-QTEST_GUILESS_MAIN(UndoManagerTest)
+QTEST_MAIN(UndoManagerTest)
@@ -36,6 +36,31 @@ private slots:
 	 */
 	void testUndoRedo();
 	
+	/**
+	 * Records changes in a journal, and replays them on another map.
+	 */
+	void testJournal();
+	
+	/**
+	 * Loads undo steps without deserializing their objects.
+	 */
+	void testLazyLoading();
+	
+	/**
+	 * Restores changed coordinates from an ObjectCoordsUndoStep.
+	 */
+	void testCoordsUndoStep();
+	
+	/**
+	 * Removes old undo steps when exceeding the memory budget.
+	 */
+	void testMemoryBudget();
+	
+	/**
+	 * Undoes and redoes several steps in a batch.
+	 */
+	void testSetIndex();
+	
 private:
 	bool clean_changed;
 	bool clean;
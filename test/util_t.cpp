@@ -18,12 +18,15 @@
  */
 
 
+#include <cstddef>
+
 #include <QtTest>
 #include <QObject>
 #include <QPointF>
 #include <QRectF>
 
 #include "core/map_coord.h"
+#include "util/dirty_region.h"
 #include "util/util.h"
 
 using namespace OpenOrienteering;
@@ -41,6 +44,7 @@ private slots:
 	void initTestCase();
 	void rectIncludeTest();
 	void rectIncludeSafeTest();
+	void dirtyRegionTest();
 	void pointsFormCorner_data();
 	void pointsFormCorner();
 };
@@ -125,6 +129,46 @@ void UtilTest::rectIncludeSafeTest()
 }
 
 
+void UtilTest::dirtyRegionTest()
+{
+	DirtyRegion region(2);
+	QVERIFY(region.isEmpty());
+	
+	region.add(QRectF{});
+	QVERIFY(region.isEmpty());
+	
+	// Disjoint rectangles are kept separate.
+	region.add({ 0, 0, 1, 1 });
+	region.add({ 10, 0, 1, 1 });
+	QCOMPARE(region.getRects().size(), std::size_t(2));
+	QCOMPARE(region.boundingRect(), QRectF(0, 0, 11, 1));
+	
+	// Contained rectangles don't change the region.
+	region.add({ 0.25, 0.25, 0.5, 0.5 });
+	QCOMPARE(region.getRects().size(), std::size_t(2));
+	
+	// Intersecting rectangles are merged.
+	region.add({ 0.5, 0.5, 1, 1 });
+	QCOMPARE(region.getRects().size(), std::size_t(2));
+	QCOMPARE(region.getRects().back(), QRectF(0, 0, 1.5, 1.5));
+	
+	// Exceeding the limit merges the cheapest pair.
+	region.add({ 12, 0, 1, 1 });
+	QCOMPARE(region.getRects().size(), std::size_t(2));
+	QCOMPARE(region.getRects().front(), QRectF(0, 0, 1.5, 1.5));
+	QCOMPARE(region.getRects().back(), QRectF(10, 0, 3, 1));
+	
+	// A merged rectangle absorbs rectangles which it intersects.
+	region.add({ 1, 0, 10, 0.5 });
+	QCOMPARE(region.getRects().size(), std::size_t(1));
+	QCOMPARE(region.boundingRect(), QRectF(0, 0, 13, 1.5));
+	
+	auto const rects = region.take();
+	QCOMPARE(rects.size(), std::size_t(1));
+	QVERIFY(region.isEmpty());
+}
+
+
 void UtilTest::pointsFormCorner_data()
 {
 	QTest::addColumn<MapCoord>("first_point");
@@ -0,0 +1,206 @@
+/*
+ *    Copyright 2026 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <Qt>
+#include <QtGlobal>
+#include <QtTest>
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPainter>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QSize>
+#include <QString>
+
+#include "gui/map/viewport_cache.h"
+
+using namespace OpenOrienteering;
+
+
+namespace {
+
+/// The size of the cells of the test pattern, in viewport pixels.
+constexpr int cell_size = 8;
+
+/// The size of the viewport. It is not a multiple of the cell size.
+constexpr QSize viewport_size = { 101, 67 };
+
+
+/// Returns a distinct color for each cell of the test pattern.
+QRgb cellColor(int column, int row)
+{
+	return qRgb((column * 37) & 255, (row * 59) & 255, ((column + row) * 17) & 255);
+}
+
+/// Returns the position of a scene point in its cell, in the range [0, cell_size).
+int cellPosition(int value)
+{
+	auto const result = value % cell_size;
+	return result < 0 ? result + cell_size : result;
+}
+
+/// Returns true if the scene point is next to the edge of its cell.
+bool isNearCellEdge(const QPoint& point)
+{
+	auto const x = cellPosition(point.x());
+	auto const y = cellPosition(point.y());
+	return x == 0 || x == cell_size - 1 || y == 0 || y == cell_size - 1;
+}
+
+/**
+ * Paints the part of the test pattern which is visible in the given part of
+ * the viewport, for the given scene position of the viewport's top left corner.
+ */
+void paintPattern(QPainter& painter, const QRect& part, const QPoint& position)
+{
+	auto const scene = part.translated(position);
+	auto const first_column = (scene.left() - cellPosition(scene.left())) / cell_size;
+	auto const first_row = (scene.top() - cellPosition(scene.top())) / cell_size;
+	for (auto row = first_row; row * cell_size <= scene.bottom(); ++row)
+	{
+		for (auto column = first_column; column * cell_size <= scene.right(); ++column)
+		{
+			auto const cell = QRect(column * cell_size, row * cell_size, cell_size, cell_size);
+			painter.fillRect(cell.translated(-position), QColor(cellColor(column, row)));
+		}
+	}
+}
+
+/// Draws the cache to an image of the viewport size.
+QImage drawn(const ViewportCache& cache)
+{
+	QImage image(viewport_size, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::white);
+	QPainter painter(&image);
+	cache.draw(painter, QRect(QPoint(), viewport_size));
+	return image;
+}
+
+
+}  // namespace
+
+
+
+/**
+ * @test Tests the ring buffer of the viewport cache.
+ */
+class ViewportCacheTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void exposedRegionTest()
+	{
+		ViewportCache cache;
+		auto const viewport = QRect(QPoint(), viewport_size);
+		QCOMPARE(cache.scroll({ 5, 0 }), QRegion(viewport));
+		
+		cache.allocate(viewport_size, 1.0, QImage::Format_ARGB32_Premultiplied);
+		QCOMPARE(cache.size(), viewport_size);
+		QCOMPARE(cache.scroll({ 0, 0 }), QRegion());
+		QCOMPARE(cache.scroll({ 5, 0 }), QRegion(0, 0, 5, viewport_size.height()));
+		QCOMPARE(cache.scroll({ -5, 0 }), QRegion(viewport_size.width() - 5, 0, 5, viewport_size.height()));
+		QCOMPARE(cache.scroll({ 0, 3 }), QRegion(0, 0, viewport_size.width(), 3));
+		QCOMPARE(cache.scroll({ 0, -3 }), QRegion(0, viewport_size.height() - 3, viewport_size.width(), 3));
+		QCOMPARE(cache.scroll({ 2, -3 }), QRegion(0, 0, 2, viewport_size.height())
+		                                  + QRegion(0, viewport_size.height() - 3, viewport_size.width(), 3));
+		QCOMPARE(cache.scroll({ viewport_size.width(), 0 }), QRegion(viewport));
+		QCOMPARE(cache.scroll({ 0, -viewport_size.height() }), QRegion(viewport));
+	}
+	
+	void scrollTest_data()
+	{
+		QTest::addColumn<qreal>("resolution");
+		QTest::addColumn<QList<QPoint>>("offsets");
+		
+		auto const positive = QList<QPoint>{ { 5, 0 }, { 0, 7 }, { 13, 4 }, { 1, 1 } };
+		auto const negative = QList<QPoint>{ { -5, 0 }, { 0, -7 }, { -13, -4 }, { -1, -1 } };
+		// Repeated scrolling moves the origin across the edges of the image.
+		auto const wrapping = QList<QPoint>{ { 60, 0 }, { 60, 0 }, { 0, -40 }, { 0, -40 }, { -90, 50 }, { 45, -60 }, { 100, 66 }, { -7, 3 } };
+		for (auto resolution : { 1.0, 1.25, 2.0 })
+		{
+			QTest::newRow(qPrintable(QString::fromLatin1("positive @%1").arg(resolution))) << resolution << positive;
+			QTest::newRow(qPrintable(QString::fromLatin1("negative @%1").arg(resolution))) << resolution << negative;
+			QTest::newRow(qPrintable(QString::fromLatin1("wrapping @%1").arg(resolution))) << resolution << wrapping;
+		}
+	}
+	
+	void scrollTest()
+	{
+		QFETCH(qreal, resolution);
+		QFETCH(QList<QPoint>, offsets);
+		
+		auto position = QPoint(-20, 30);
+		auto paint_function = [&position](QPainter& painter, const QRect& part) {
+			paintPattern(painter, part, position);
+		};
+		
+		ViewportCache cache;
+		cache.allocate(viewport_size, resolution, QImage::Format_ARGB32_Premultiplied);
+		cache.paint(QRect(QPoint(), viewport_size), paint_function);
+		
+		for (auto const& offset : offsets)
+		{
+			// Scrolling moves the contents, i.e. the viewport moves the other way.
+			position -= offset;
+			for (auto const& rect : cache.scroll(offset).rects())
+				cache.paint(rect, paint_function);
+			
+			ViewportCache fresh;
+			fresh.allocate(viewport_size, resolution, QImage::Format_ARGB32_Premultiplied);
+			fresh.paint(QRect(QPoint(), viewport_size), paint_function);
+			
+			auto const actual = drawn(cache);
+			auto const expected = drawn(fresh);
+			for (int y = 0; y < viewport_size.height(); ++y)
+			{
+				for (int x = 0; x < viewport_size.width(); ++x)
+				{
+					// With fractional resolutions, the cache's pixel grid is
+					// not aligned with the fresh one. Pixels next to the cell
+					// edges may be sampled from a neighbouring cell.
+					if (resolution != qRound(resolution) && isNearCellEdge(QPoint(x, y) + position))
+						continue;
+					if (actual.pixel(x, y) != expected.pixel(x, y))
+					{
+						auto const message = QString::fromLatin1("Offset (%1, %2), pixel (%3, %4)")
+						                     .arg(offset.x()).arg(offset.y()).arg(x).arg(y);
+						QFAIL(qPrintable(message));
+					}
+				}
+			}
+			
+			// The pattern itself is drawn, not just the same garbage.
+			auto const center = QPoint(viewport_size.width() / 2, viewport_size.height() / 2) + position;
+			if (!isNearCellEdge(center))
+			{
+				QCOMPARE(actual.pixel(viewport_size.width() / 2, viewport_size.height() / 2),
+				         cellColor((center.x() - cellPosition(center.x())) / cell_size, (center.y() - cellPosition(center.y())) / cell_size));
+			}
+		}
+	}
+	
+};
+
+
+QTEST_GUILESS_MAIN(ViewportCacheTest)
+#include "viewport_cache_t.moc"  // IWYU pragma: keep